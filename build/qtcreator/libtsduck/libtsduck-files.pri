@@ -14,6 +14,7 @@ HEADERS += \
     ../../../src/libtsduck/tsAbstractLongTable.h \
     ../../../src/libtsduck/tsAbstractSignalization.h \
     ../../../src/libtsduck/tsAbstractTable.h \
+    ../../../src/libtsduck/tsAbstractTablePlugin.h \
     ../../../src/libtsduck/tsAbstractTransportListTable.h \
     ../../../src/libtsduck/tsAC3Attributes.h \
     ../../../src/libtsduck/tsAC3Descriptor.h \
@@ -41,6 +42,7 @@ HEADERS += \
     ../../../src/libtsduck/tsBinaryTable.h \
     ../../../src/libtsduck/tsBitStream.h \
     ../../../src/libtsduck/tsBlockCipher.h \
+    ../../../src/libtsduck/tsBlockOutputStream.h \
     ../../../src/libtsduck/tsBouquetNameDescriptor.h \
     ../../../src/libtsduck/tsByteBlock.h \
     ../../../src/libtsduck/tsCableDeliverySystemDescriptor.h \
@@ -54,12 +56,15 @@ HEADERS += \
     ../../../src/libtsduck/tsCBCTemplate.h \
     ../../../src/libtsduck/tsCerrReport.h \
     ../../../src/libtsduck/tsCipherChaining.h \
+    ../../../src/libtsduck/tsCoarseClock.h \
     ../../../src/libtsduck/tsCOM.h \
     ../../../src/libtsduck/tsComponentDescriptor.h \
     ../../../src/libtsduck/tsCondition.h \
     ../../../src/libtsduck/tsContentDescriptor.h \
     ../../../src/libtsduck/tsCountryAvailabilityDescriptor.h \
     ../../../src/libtsduck/tsCRC32.h \
+    ../../../src/libtsduck/tsCTR.h \
+    ../../../src/libtsduck/tsCTRTemplate.h \
     ../../../src/libtsduck/tsCTS1.h \
     ../../../src/libtsduck/tsCTS1Template.h \
     ../../../src/libtsduck/tsCTS2.h \
@@ -72,6 +77,7 @@ HEADERS += \
     ../../../src/libtsduck/tsCyclingPacketizer.h \
     ../../../src/libtsduck/tsDataBroadcastDescriptor.h \
     ../../../src/libtsduck/tsDataBroadcastIdDescriptor.h \
+    ../../../src/libtsduck/tsDefaultInitAllocator.h \
     ../../../src/libtsduck/tsDektecControl.h \
     ../../../src/libtsduck/tsDektecInputPlugin.h \
     ../../../src/libtsduck/tsDektecOutputPlugin.h \
@@ -99,6 +105,7 @@ HEADERS += \
     ../../../src/libtsduck/tsECMGSCS.h \
     ../../../src/libtsduck/tsEDID.h \
     ../../../src/libtsduck/tsEIT.h \
+    ../../../src/libtsduck/tsEITGenerator.h \
     ../../../src/libtsduck/tsEMMGMUX.h \
     ../../../src/libtsduck/tsEnhancedAC3Descriptor.h \
     ../../../src/libtsduck/tsEnumeration.h \
@@ -116,6 +123,7 @@ HEADERS += \
     ../../../src/libtsduck/tsHash.h \
     ../../../src/libtsduck/tsHDSimulcastLogicalChannelDescriptor.h \
     ../../../src/libtsduck/tsHEVCVideoDescriptor.h \
+    ../../../src/libtsduck/tsInjectionScheduler.h \
     ../../../src/libtsduck/tsInputRedirector.h \
     ../../../src/libtsduck/tsIntegerUtils.h \
     ../../../src/libtsduck/tsIntegerUtilsTemplate.h \
@@ -124,17 +132,25 @@ HEADERS += \
     ../../../src/libtsduck/tsIPUtils.h \
     ../../../src/libtsduck/tsISO639LanguageDescriptor.h \
     ../../../src/libtsduck/tsjson.h \
+    ../../../src/libtsduck/tsjsonWriter.h \
     ../../../src/libtsduck/tsLinkageDescriptor.h \
     ../../../src/libtsduck/tsLNB.h \
     ../../../src/libtsduck/tsLocalTimeOffsetDescriptor.h \
+    ../../../src/libtsduck/tsLockFreeMessageQueue.h \
+    ../../../src/libtsduck/tsLockFreeMessageQueueTemplate.h \
+    ../../../src/libtsduck/tsLogLimiter.h \
     ../../../src/libtsduck/tsLogicalChannelNumberDescriptor.h \
+    ../../../src/libtsduck/tsLZ4.h \
     ../../../src/libtsduck/tsMaximumBitrateDescriptor.h \
     ../../../src/libtsduck/tsMD5.h \
     ../../../src/libtsduck/tsMediaGuardDate.h \
+    ../../../src/libtsduck/tsMemoryMappedFile.h \
     ../../../src/libtsduck/tsMemoryUtils.h \
     ../../../src/libtsduck/tsMessageDescriptor.h \
     ../../../src/libtsduck/tsMessageQueue.h \
     ../../../src/libtsduck/tsMessageQueueTemplate.h \
+    ../../../src/libtsduck/tsMetrics.h \
+    ../../../src/libtsduck/tsMetricsExporter.h \
     ../../../src/libtsduck/tsMJD.h \
     ../../../src/libtsduck/tsModulation.h \
     ../../../src/libtsduck/tsMonotonic.h \
@@ -152,8 +168,10 @@ HEADERS += \
     ../../../src/libtsduck/tsOutputPager.h \
     ../../../src/libtsduck/tsOutputRedirector.h \
     ../../../src/libtsduck/tsPacketizer.h \
+    ../../../src/libtsduck/tsPacketRegulator.h \
     ../../../src/libtsduck/tsParentalRatingDescriptor.h \
     ../../../src/libtsduck/tsPAT.h \
+    ../../../src/libtsduck/tsPcapFile.h \
     ../../../src/libtsduck/tsPCR.h \
     ../../../src/libtsduck/tsPCRAnalyzer.h \
     ../../../src/libtsduck/tsPCSC.h \
@@ -168,6 +186,7 @@ HEADERS += \
     ../../../src/libtsduck/tsPMT.h \
     ../../../src/libtsduck/tsPMTHandlerInterface.h \
     ../../../src/libtsduck/tsPollFiles.h \
+    ../../../src/libtsduck/tsPooledByteBlock.h \
     ../../../src/libtsduck/tsPrivateDataIndicatorDescriptor.h \
     ../../../src/libtsduck/tsPrivateDataSpecifierDescriptor.h \
     ../../../src/libtsduck/tsPSILogger.h \
@@ -192,13 +211,17 @@ HEADERS += \
     ../../../src/libtsduck/tsSafePtrTemplate.h \
     ../../../src/libtsduck/tsSatelliteDeliverySystemDescriptor.h \
     ../../../src/libtsduck/tsScrambling.h \
+    ../../../src/libtsduck/tsScramblingBatch.h \
     ../../../src/libtsduck/tsSDT.h \
     ../../../src/libtsduck/tsSection.h \
     ../../../src/libtsduck/tsSectionDemux.h \
     ../../../src/libtsduck/tsSectionFile.h \
     ../../../src/libtsduck/tsSectionHandlerInterface.h \
     ../../../src/libtsduck/tsSectionProviderInterface.h \
+    ../../../src/libtsduck/tsSectionView.h \
+    ../../../src/libtsduck/tsSectionViewHandlerInterface.h \
     ../../../src/libtsduck/tsService.h \
+    ../../../src/libtsduck/tsServiceChangeHandlerInterface.h \
     ../../../src/libtsduck/tsServiceDescriptor.h \
     ../../../src/libtsduck/tsServiceDiscovery.h \
     ../../../src/libtsduck/tsServiceListDescriptor.h \
@@ -208,8 +231,10 @@ HEADERS += \
     ../../../src/libtsduck/tsSHA512.h \
     ../../../src/libtsduck/tsSharedLibrary.h \
     ../../../src/libtsduck/tsShortEventDescriptor.h \
+    ../../../src/libtsduck/tsSignalMonitor.h \
     ../../../src/libtsduck/tsSimulCryptDate.h \
     ../../../src/libtsduck/tsSingletonManager.h \
+    ../../../src/libtsduck/tsSmartCardService.h \
     ../../../src/libtsduck/tsSocket.h \
     ../../../src/libtsduck/tsSocketAddress.h \
     ../../../src/libtsduck/tsSpliceInfoTable.h \
@@ -223,6 +248,7 @@ HEADERS += \
     ../../../src/libtsduck/tsSubRipGenerator.h \
     ../../../src/libtsduck/tsSubtitlingDescriptor.h \
     ../../../src/libtsduck/tsSupplementaryAudioDescriptor.h \
+    ../../../src/libtsduck/tsSyncReport.h \
     ../../../src/libtsduck/tsSysInfo.h \
     ../../../src/libtsduck/tsSystemMonitor.h \
     ../../../src/libtsduck/tsSystemRandomGenerator.h \
@@ -256,6 +282,7 @@ HEADERS += \
     ../../../src/libtsduck/tsTextParser.h \
     ../../../src/libtsduck/tsThread.h \
     ../../../src/libtsduck/tsThreadAttributes.h \
+    ../../../src/libtsduck/tsThreadPool.h \
     ../../../src/libtsduck/tsTime.h \
     ../../../src/libtsduck/tsTimeShiftedEventDescriptor.h \
     ../../../src/libtsduck/tsTimeShiftedServiceDescriptor.h \
@@ -278,11 +305,19 @@ HEADERS += \
     ../../../src/libtsduck/tsTSAnalyzerOptions.h \
     ../../../src/libtsduck/tsTSAnalyzerReport.h \
     ../../../src/libtsduck/tsTSDT.h \
+    ../../../src/libtsduck/tsTSFileBlockReader.h \
+    ../../../src/libtsduck/tsTSFileBlockWriter.h \
+    ../../../src/libtsduck/tsTSFileIndex.h \
     ../../../src/libtsduck/tsTSFileInput.h \
     ../../../src/libtsduck/tsTSFileInputBuffered.h \
+    ../../../src/libtsduck/tsTSFileInputPlaylist.h \
     ../../../src/libtsduck/tsTSFileOutput.h \
     ../../../src/libtsduck/tsTSFileOutputResync.h \
+    ../../../src/libtsduck/tsTSFileOutputSegmented.h \
     ../../../src/libtsduck/tsTSPacket.h \
+    ../../../src/libtsduck/tsTSPacketFormat.h \
+    ../../../src/libtsduck/tsTSPacketMetadata.h \
+    ../../../src/libtsduck/tsTSPacketView.h \
     ../../../src/libtsduck/tsTSScanner.h \
     ../../../src/libtsduck/tsTuner.h \
     ../../../src/libtsduck/tsTunerArgs.h \
@@ -307,12 +342,14 @@ HEADERS += \
     ../../../src/libtsduck/tsViaccessDate.h \
     ../../../src/libtsduck/tsVideoAttributes.h \
     ../../../src/libtsduck/tsWebRequest.h \
+    ../../../src/libtsduck/tsWebRequestHandlerInterface.h \
     ../../../src/libtsduck/tsxml.h \
     ../../../src/libtsduck/tsxmlAttribute.h \
     ../../../src/libtsduck/tsxmlComment.h \
     ../../../src/libtsduck/tsxmlDeclaration.h \
     ../../../src/libtsduck/tsxmlDocument.h \
     ../../../src/libtsduck/tsxmlElement.h \
+    ../../../src/libtsduck/tsxmlElementHandlerInterface.h \
     ../../../src/libtsduck/tsxmlElementTemplate.h \
     ../../../src/libtsduck/tsxmlNode.h \
     ../../../src/libtsduck/tsxmlText.h \
@@ -333,6 +370,7 @@ SOURCES += \
     ../../../src/libtsduck/tsAbstractDescriptorsTable.cpp \
     ../../../src/libtsduck/tsAbstractSignalization.cpp \
     ../../../src/libtsduck/tsAbstractTable.cpp \
+    ../../../src/libtsduck/tsAbstractTablePlugin.cpp \
     ../../../src/libtsduck/tsAbstractTransportListTable.cpp \
     ../../../src/libtsduck/tsAC3Attributes.cpp \
     ../../../src/libtsduck/tsAC3Descriptor.cpp \
@@ -353,6 +391,8 @@ SOURCES += \
     ../../../src/libtsduck/tsBAT.cpp \
     ../../../src/libtsduck/tsBCD.cpp \
     ../../../src/libtsduck/tsBinaryTable.cpp \
+    ../../../src/libtsduck/tsBlockCipher.cpp \
+    ../../../src/libtsduck/tsBlockOutputStream.cpp \
     ../../../src/libtsduck/tsBouquetNameDescriptor.cpp \
     ../../../src/libtsduck/tsByteBlock.cpp \
     ../../../src/libtsduck/tsCableDeliverySystemDescriptor.cpp \
@@ -364,6 +404,7 @@ SOURCES += \
     ../../../src/libtsduck/tsCAT.cpp \
     ../../../src/libtsduck/tsCerrReport.cpp \
     ../../../src/libtsduck/tsCipherChaining.cpp \
+    ../../../src/libtsduck/tsCoarseClock.cpp \
     ../../../src/libtsduck/tsCOM.cpp \
     ../../../src/libtsduck/tsComponentDescriptor.cpp \
     ../../../src/libtsduck/tsCondition.cpp \
@@ -392,6 +433,7 @@ SOURCES += \
     ../../../src/libtsduck/tsECMGClient.cpp \
     ../../../src/libtsduck/tsECMGSCS.cpp \
     ../../../src/libtsduck/tsEIT.cpp \
+    ../../../src/libtsduck/tsEITGenerator.cpp \
     ../../../src/libtsduck/tsEMMGMUX.cpp \
     ../../../src/libtsduck/tsEnhancedAC3Descriptor.cpp \
     ../../../src/libtsduck/tsEnumeration.cpp \
@@ -407,20 +449,27 @@ SOURCES += \
     ../../../src/libtsduck/tsGuardCondition.cpp \
     ../../../src/libtsduck/tsHDSimulcastLogicalChannelDescriptor.cpp \
     ../../../src/libtsduck/tsHEVCVideoDescriptor.cpp \
+    ../../../src/libtsduck/tsInjectionScheduler.cpp \
     ../../../src/libtsduck/tsInputRedirector.cpp \
     ../../../src/libtsduck/tsIntegerUtils.cpp \
     ../../../src/libtsduck/tsIPAddress.cpp \
     ../../../src/libtsduck/tsIPUtils.cpp \
     ../../../src/libtsduck/tsISO639LanguageDescriptor.cpp \
     ../../../src/libtsduck/tsjson.cpp \
+    ../../../src/libtsduck/tsjsonWriter.cpp \
     ../../../src/libtsduck/tsLinkageDescriptor.cpp \
     ../../../src/libtsduck/tsLNB.cpp \
     ../../../src/libtsduck/tsLocalTimeOffsetDescriptor.cpp \
+    ../../../src/libtsduck/tsLogLimiter.cpp \
     ../../../src/libtsduck/tsLogicalChannelNumberDescriptor.cpp \
+    ../../../src/libtsduck/tsLZ4.cpp \
     ../../../src/libtsduck/tsMaximumBitrateDescriptor.cpp \
     ../../../src/libtsduck/tsMD5.cpp \
+    ../../../src/libtsduck/tsMemoryMappedFile.cpp \
     ../../../src/libtsduck/tsMemoryUtils.cpp \
     ../../../src/libtsduck/tsMessageDescriptor.cpp \
+    ../../../src/libtsduck/tsMetrics.cpp \
+    ../../../src/libtsduck/tsMetricsExporter.cpp \
     ../../../src/libtsduck/tsMJD.cpp \
     ../../../src/libtsduck/tsModulation.cpp \
     ../../../src/libtsduck/tsMonotonic.cpp \
@@ -436,8 +485,10 @@ SOURCES += \
     ../../../src/libtsduck/tsOutputPager.cpp \
     ../../../src/libtsduck/tsOutputRedirector.cpp \
     ../../../src/libtsduck/tsPacketizer.cpp \
+    ../../../src/libtsduck/tsPacketRegulator.cpp \
     ../../../src/libtsduck/tsParentalRatingDescriptor.cpp \
     ../../../src/libtsduck/tsPAT.cpp \
+    ../../../src/libtsduck/tsPcapFile.cpp \
     ../../../src/libtsduck/tsPCR.cpp \
     ../../../src/libtsduck/tsPCRAnalyzer.cpp \
     ../../../src/libtsduck/tsPCSC.cpp \
@@ -449,6 +500,7 @@ SOURCES += \
     ../../../src/libtsduck/tsPluginSharedLibrary.cpp \
     ../../../src/libtsduck/tsPMT.cpp \
     ../../../src/libtsduck/tsPollFiles.cpp \
+    ../../../src/libtsduck/tsPooledByteBlock.cpp \
     ../../../src/libtsduck/tsPrivateDataIndicatorDescriptor.cpp \
     ../../../src/libtsduck/tsPrivateDataSpecifierDescriptor.cpp \
     ../../../src/libtsduck/tsPSILogger.cpp \
@@ -462,6 +514,7 @@ SOURCES += \
     ../../../src/libtsduck/tsS2SatelliteDeliverySystemDescriptor.cpp \
     ../../../src/libtsduck/tsSatelliteDeliverySystemDescriptor.cpp \
     ../../../src/libtsduck/tsScrambling.cpp \
+    ../../../src/libtsduck/tsScramblingBatch.cpp \
     ../../../src/libtsduck/tsSDT.cpp \
     ../../../src/libtsduck/tsSection.cpp \
     ../../../src/libtsduck/tsSectionDemux.cpp \
@@ -475,8 +528,10 @@ SOURCES += \
     ../../../src/libtsduck/tsSHA512.cpp \
     ../../../src/libtsduck/tsSharedLibrary.cpp \
     ../../../src/libtsduck/tsShortEventDescriptor.cpp \
+    ../../../src/libtsduck/tsSignalMonitor.cpp \
     ../../../src/libtsduck/tsSimulCryptDate.cpp \
     ../../../src/libtsduck/tsSingletonManager.cpp \
+    ../../../src/libtsduck/tsSmartCardService.cpp \
     ../../../src/libtsduck/tsSocket.cpp \
     ../../../src/libtsduck/tsSocketAddress.cpp \
     ../../../src/libtsduck/tsSpliceInfoTable.cpp \
@@ -489,6 +544,7 @@ SOURCES += \
     ../../../src/libtsduck/tsSubRipGenerator.cpp \
     ../../../src/libtsduck/tsSubtitlingDescriptor.cpp \
     ../../../src/libtsduck/tsSupplementaryAudioDescriptor.cpp \
+    ../../../src/libtsduck/tsSyncReport.cpp \
     ../../../src/libtsduck/tsSysInfo.cpp \
     ../../../src/libtsduck/tsSystemMonitor.cpp \
     ../../../src/libtsduck/tsSystemRandomGenerator.cpp \
@@ -516,6 +572,7 @@ SOURCES += \
     ../../../src/libtsduck/tsTextParser.cpp \
     ../../../src/libtsduck/tsThread.cpp \
     ../../../src/libtsduck/tsThreadAttributes.cpp \
+    ../../../src/libtsduck/tsThreadPool.cpp \
     ../../../src/libtsduck/tsTime.cpp \
     ../../../src/libtsduck/tsTimeShiftedEventDescriptor.cpp \
     ../../../src/libtsduck/tsTimeShiftedServiceDescriptor.cpp \
@@ -530,11 +587,19 @@ SOURCES += \
     ../../../src/libtsduck/tsTSAnalyzerOptions.cpp \
     ../../../src/libtsduck/tsTSAnalyzerReport.cpp \
     ../../../src/libtsduck/tsTSDT.cpp \
+    ../../../src/libtsduck/tsTSFileBlockReader.cpp \
+    ../../../src/libtsduck/tsTSFileBlockWriter.cpp \
+    ../../../src/libtsduck/tsTSFileIndex.cpp \
     ../../../src/libtsduck/tsTSFileInput.cpp \
     ../../../src/libtsduck/tsTSFileInputBuffered.cpp \
+    ../../../src/libtsduck/tsTSFileInputPlaylist.cpp \
     ../../../src/libtsduck/tsTSFileOutput.cpp \
     ../../../src/libtsduck/tsTSFileOutputResync.cpp \
+    ../../../src/libtsduck/tsTSFileOutputSegmented.cpp \
     ../../../src/libtsduck/tsTSPacket.cpp \
+    ../../../src/libtsduck/tsTSPacketFormat.cpp \
+    ../../../src/libtsduck/tsTSPacketMetadata.cpp \
+    ../../../src/libtsduck/tsTSPacketView.cpp \
     ../../../src/libtsduck/tsTSScanner.cpp \
     ../../../src/libtsduck/tsTunerArgs.cpp \
     ../../../src/libtsduck/tsTunerParameters.cpp \
@@ -0,0 +1,7 @@
+CONFIG += libtsduck
+include(../tsduck.pri)
+TEMPLATE = app
+TARGET = tsbench
+
+SOURCES += \
+    ../../../src/bench/tsbench.cpp
@@ -0,0 +1,3 @@
+CONFIG += tstool
+TARGET = tscasload
+include(../tsduck.pri)
@@ -36,7 +36,9 @@ CONFIG += ordered
 SUBDIRS += \
     libtsduck \
     tsplugin_aes \
+    tsplugin_afpacket \
     tsplugin_analyze \
+    tsplugin_archive \
     tsplugin_bat \
     tsplugin_bitrate_monitor \
     tsplugin_boostpid \
@@ -50,11 +52,15 @@ SUBDIRS += \
     tsplugin_drop \
     tsplugin_dvb \
     tsplugin_eit \
+    tsplugin_eitgen \
+    tsplugin_etr290 \
     tsplugin_file \
     tsplugin_filter \
     tsplugin_fork \
     tsplugin_generic \
     tsplugin_history \
+    tsplugin_hls \
+    tsplugin_http \
     tsplugin_inject \
     tsplugin_ip \
     tsplugin_mux \
@@ -63,6 +69,8 @@ SUBDIRS += \
     tsplugin_null \
     tsplugin_pat \
     tsplugin_pattern \
+    tsplugin_pcap \
+    tsplugin_pcradjust \
     tsplugin_pcrbitrate \
     tsplugin_pcrextract \
     tsplugin_pcrverify \
@@ -77,23 +85,29 @@ SUBDIRS += \
     tsplugin_rmsplice \
     tsplugin_scrambler \
     tsplugin_sdt \
+    tsplugin_shm \
     tsplugin_sifilter \
     tsplugin_skip \
     tsplugin_slice \
     tsplugin_stuffanalyze \
     tsplugin_svremove \
     tsplugin_svrename \
+    tsplugin_synth \
     tsplugin_t2mi \
     tsplugin_tables \
+    tsplugin_tcp \
     tsplugin_teletext \
     tsplugin_time \
     tsplugin_timeref \
+    tsplugin_timeshift \
     tsplugin_tsrename \
     tsplugin_until \
     tsplugin_zap \
     utest \
+    tsbench \
     tsanalyze \
     tsbitrate \
+    tscasload \
     tscmp \
     tsdate \
     tsdektec \
@@ -101,6 +115,7 @@ SUBDIRS += \
     tsfixcc \
     tsftrunc \
     tslsdvb \
+    tsnamescomp \
     tsp \
     tspacketize \
     tspsi \
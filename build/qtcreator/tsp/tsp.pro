@@ -3,17 +3,31 @@ TARGET = tsp
 include(../tsduck.pri)
 
 SOURCES += \
+    ../../../src/tstools/tspBranchExecutor.cpp \
+    ../../../src/tstools/tspControlServer.cpp \
     ../../../src/tstools/tspInputExecutor.cpp \
+    ../../../src/tstools/tspInputSwitch.cpp \
     ../../../src/tstools/tspJointTermination.cpp \
     ../../../src/tstools/tspOptions.cpp \
     ../../../src/tstools/tspOutputExecutor.cpp \
+    ../../../src/tstools/tspPacketBuffer.cpp \
+    ../../../src/tstools/tspPipeline.cpp \
     ../../../src/tstools/tspPluginExecutor.cpp \
-    ../../../src/tstools/tspProcessorExecutor.cpp
+    ../../../src/tstools/tspPluginMonitor.cpp \
+    ../../../src/tstools/tspProcessorExecutor.cpp \
+    ../../../src/tstools/tspSignalizationService.cpp
 
 HEADERS += \
+    ../../../src/tstools/tspBranchExecutor.h \
+    ../../../src/tstools/tspControlServer.h \
     ../../../src/tstools/tspInputExecutor.h \
+    ../../../src/tstools/tspInputSwitch.h \
     ../../../src/tstools/tspJointTermination.h \
     ../../../src/tstools/tspOptions.h \
     ../../../src/tstools/tspOutputExecutor.h \
+    ../../../src/tstools/tspPacketBuffer.h \
+    ../../../src/tstools/tspPipeline.h \
     ../../../src/tstools/tspPluginExecutor.h \
-    ../../../src/tstools/tspProcessorExecutor.h
+    ../../../src/tstools/tspPluginMonitor.h \
+    ../../../src/tstools/tspProcessorExecutor.h \
+    ../../../src/tstools/tspSignalizationService.h
@@ -0,0 +1,3 @@
+CONFIG += tsplugin
+TARGET = tsplugin_eitgen
+include(../tsduck.pri)
@@ -0,0 +1,3 @@
+CONFIG += tsplugin
+TARGET = tsplugin_etr290
+include(../tsduck.pri)
@@ -22,6 +22,7 @@ SOURCES += \
     ../../../src/utest/utestCppUnitTest.cpp \
     ../../../src/utest/utestCrypto.cpp \
     ../../../src/utest/utestDemux.cpp \
+    ../../../src/utest/utestDescriptorList.cpp \
     ../../../src/utest/utestDirectShow.cpp \
     ../../../src/utest/utestDoubleCheckLock.cpp \
     ../../../src/utest/utestDVB.cpp \
@@ -32,7 +33,9 @@ SOURCES += \
     ../../../src/utest/utestGuard.cpp \
     ../../../src/utest/utestInterrupt.cpp \
     ../../../src/utest/utestJSON.cpp \
+    ../../../src/utest/utestLZ4.cpp \
     ../../../src/utest/utestMessageQueue.cpp \
+    ../../../src/utest/utestMetrics.cpp \
     ../../../src/utest/utestMonotonic.cpp \
     ../../../src/utest/utestMutex.cpp \
     ../../../src/utest/utestNames.cpp \
@@ -47,6 +50,7 @@ SOURCES += \
     ../../../src/utest/utestScrambling.cpp \
     ../../../src/utest/utestSection.cpp \
     ../../../src/utest/utestSectionFile.cpp \
+    ../../../src/utest/utestServiceDiscovery.cpp \
     ../../../src/utest/utestSingleton.cpp \
     ../../../src/utest/utestStaticInstance.cpp \
     ../../../src/utest/utestSystemRandomGenerator.cpp \
@@ -54,6 +58,7 @@ SOURCES += \
     ../../../src/utest/utestTablesFactory.cpp \
     ../../../src/utest/utestThread.cpp \
     ../../../src/utest/utestThreadAttributes.cpp \
+    ../../../src/utest/utestThreadPool.cpp \
     ../../../src/utest/utestTime.cpp \
     ../../../src/utest/utestTSPacket.cpp \
     ../../../src/utest/utestUString.cpp \
@@ -0,0 +1,771 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  TSDuck performance benchmarks.
+//  Reproducible micro-benchmarks (CRC32, DVB-CSA, AES, UString) and macro
+//  benchmarks (section demux, transport stream analysis) on a synthetic
+//  stream or on a recorded transport stream file.
+//
+//----------------------------------------------------------------------------
+
+#include "tsArgs.h"
+#include "tsCRC32.h"
+#include "tsSectionDemux.h"
+#include "tsCyclingPacketizer.h"
+#include "tsPAT.h"
+#include "tsPMT.h"
+#include "tsScrambling.h"
+#include "tsAES.h"
+#include "tsCBC.h"
+#include "tsDVS042.h"
+#include "tsTSAnalyzer.h"
+#include "tsTSFileInput.h"
+#include "tsMonotonic.h"
+#include "tsVersionInfo.h"
+#include <atomic>
+#include <new>
+#include <cstdlib>
+#include <iomanip>
+#if defined(TS_LINUX)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+TSDUCK_SOURCE;
+
+#define DEFAULT_PACKETS     100000  // Number of packets in the synthetic stream.
+#define DEFAULT_DURATION    1000    // Minimum duration of each benchmark in milliseconds.
+#define BATCH_SIZE          64      // Number of packets in batch-oriented benchmarks.
+
+
+//----------------------------------------------------------------------------
+// Count all memory allocations in the process, including in the TSDuck
+// library when the platform resolves its operator new to this executable
+// (ELF platforms). On Windows, allocations inside the TSDuck DLL are not seen.
+//----------------------------------------------------------------------------
+
+namespace {
+    std::atomic<uint64_t> allocation_count(0);
+}
+
+void* operator new(size_t size)
+{
+    allocation_count++;
+    void* ptr = std::malloc(size == 0 ? 1 : size);
+    if (ptr == 0) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+
+//----------------------------------------------------------------------------
+// Hardware cache misses of the current thread, on Linux only.
+//----------------------------------------------------------------------------
+
+class CacheMissCounter
+{
+public:
+    CacheMissCounter();
+    ~CacheMissCounter();
+
+    // Check if the counter is available on this system.
+    bool available() const;
+
+    // Start counting.
+    void start();
+
+    // Stop counting and return the number of cache misses, -1 if unavailable.
+    int64_t stop();
+
+private:
+#if defined(TS_LINUX)
+    int _fd;
+#endif
+    CacheMissCounter(const CacheMissCounter&) = delete;
+    CacheMissCounter& operator=(const CacheMissCounter&) = delete;
+};
+
+#if defined(TS_LINUX)
+
+CacheMissCounter::CacheMissCounter() :
+    _fd(-1)
+{
+    ::perf_event_attr attr;
+    TS_ZERO(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    _fd = int(::syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+CacheMissCounter::~CacheMissCounter()
+{
+    if (_fd >= 0) {
+        ::close(_fd);
+    }
+}
+
+bool CacheMissCounter::available() const
+{
+    return _fd >= 0;
+}
+
+void CacheMissCounter::start()
+{
+    if (_fd >= 0) {
+        ::ioctl(_fd, PERF_EVENT_IOC_RESET, 0);
+        ::ioctl(_fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+int64_t CacheMissCounter::stop()
+{
+    uint64_t count = 0;
+    if (_fd < 0) {
+        return -1;
+    }
+    ::ioctl(_fd, PERF_EVENT_IOC_DISABLE, 0);
+    return ::read(_fd, &count, sizeof(count)) == ssize_t(sizeof(count)) ? int64_t(count) : -1;
+}
+
+#else
+
+CacheMissCounter::CacheMissCounter() {}
+CacheMissCounter::~CacheMissCounter() {}
+bool CacheMissCounter::available() const { return false; }
+void CacheMissCounter::start() {}
+int64_t CacheMissCounter::stop() { return -1; }
+
+#endif
+
+
+//----------------------------------------------------------------------------
+// Command line options
+//----------------------------------------------------------------------------
+
+struct Options: public ts::Args
+{
+    Options(int argc, char *argv[]);
+
+    ts::UStringVector names;     // Benchmarks to run (all by default).
+    ts::UString       input;     // Recorded input file, synthetic stream if empty.
+    size_t            packets;   // Number of packets in the stream.
+    ts::MilliSecond   duration;  // Minimum duration of each benchmark.
+    bool              json;      // JSON output.
+    bool              list;      // List benchmarks.
+};
+
+Options::Options(int argc, char *argv[]) :
+    ts::Args(u"Run TSDuck performance benchmarks.", u"[options] [benchmark ...]"),
+    names(),
+    input(),
+    packets(0),
+    duration(0),
+    json(false),
+    list(false)
+{
+    option(u"",          0,  Args::STRING);
+    option(u"duration", 'd', Args::POSITIVE);
+    option(u"input",    'i', Args::STRING);
+    option(u"json",     'j');
+    option(u"list",     'l');
+    option(u"packets",  'p', Args::POSITIVE);
+
+    setHelp(u"Parameters:\n"
+            u"\n"
+            u"  Names of the benchmarks to run. All benchmarks are run by default.\n"
+            u"  Use --list to get the list of available benchmarks.\n"
+            u"\n"
+            u"Options:\n"
+            u"\n"
+            u"  -d value\n"
+            u"  --duration value\n"
+            u"      Minimum duration of each benchmark in milliseconds. Each benchmark is\n"
+            u"      repeated on the complete stream until this duration is reached. The\n"
+            u"      default is " TS_USTRINGIFY(DEFAULT_DURATION) u" ms.\n"
+            u"\n"
+            u"  --help\n"
+            u"      Display this help text.\n"
+            u"\n"
+            u"  -i file-name\n"
+            u"  --input file-name\n"
+            u"      Use the specified recorded transport stream file as input. By default,\n"
+            u"      a synthetic stream is generated. The synthetic stream is always the same\n"
+            u"      to make the results reproducible from one release to another.\n"
+            u"\n"
+            u"  -j\n"
+            u"  --json\n"
+            u"      Report the results in JSON format, for automated tracking.\n"
+            u"\n"
+            u"  -l\n"
+            u"  --list\n"
+            u"      List the available benchmarks and exit.\n"
+            u"\n"
+            u"  -p value\n"
+            u"  --packets value\n"
+            u"      Number of TS packets in the synthetic stream or maximum number of packets\n"
+            u"      to load from the input file. The default is " TS_USTRINGIFY(DEFAULT_PACKETS) u".\n"
+            u"\n"
+            u"  --version\n"
+            u"      Display the version number.\n");
+
+    analyze(argc, argv);
+
+    getValues(names, u"");
+    input = value(u"input");
+    packets = intValue<size_t>(u"packets", DEFAULT_PACKETS);
+    duration = intValue<ts::MilliSecond>(u"duration", DEFAULT_DURATION);
+    json = present(u"json");
+    list = present(u"list");
+
+    exitOnError();
+}
+
+
+//----------------------------------------------------------------------------
+// Test stream, synthetic or recorded.
+//----------------------------------------------------------------------------
+
+namespace {
+
+    // Deterministic pseudo-random generator, for reproducible content.
+    class PseudoRandom
+    {
+    public:
+        PseudoRandom(uint32_t seed = 0x5EED1234) : _state(seed) {}
+        uint8_t next()
+        {
+            _state = _state * 1103515245 + 12345;
+            return uint8_t(_state >> 16);
+        }
+        void fill(uint8_t* data, size_t size)
+        {
+            for (size_t i = 0; i < size; ++i) {
+                data[i] = next();
+            }
+        }
+    private:
+        uint32_t _state;
+    };
+
+    const ts::PID PMT_PID_BASE = 0x0100;
+    const ts::PID ES_PID_BASE  = 0x0200;
+    const ts::PID PRIVATE_PID  = 0x0300;
+    const size_t  SERVICE_COUNT = 4;
+
+    // Build a synthetic stream: PSI, long private sections and PES packets on
+    // several PID's, with the proportions of a typical broadcast multiplex.
+    void BuildSyntheticStream(ts::TSPacketVector& packets, size_t count)
+    {
+        PseudoRandom prng;
+
+        ts::PAT pat(0, true, 1);
+        ts::CyclingPacketizer pzer_psi(ts::PID_PAT);
+        for (size_t srv = 0; srv < SERVICE_COUNT; ++srv) {
+            pat.pmts[uint16_t(srv + 1)] = ts::PID(PMT_PID_BASE + srv);
+        }
+        pzer_psi.addTable(pat);
+
+        std::vector<ts::CyclingPacketizer*> pzer_pmt;
+        for (size_t srv = 0; srv < SERVICE_COUNT; ++srv) {
+            ts::PMT pmt(0, true, uint16_t(srv + 1), ts::PID(ES_PID_BASE + srv));
+            pmt.streams[ts::PID(ES_PID_BASE + srv)].stream_type = 0x1B;
+            pzer_pmt.push_back(new ts::CyclingPacketizer(ts::PID(PMT_PID_BASE + srv)));
+            pzer_pmt.back()->addTable(pmt);
+        }
+
+        ts::CyclingPacketizer pzer_private(PRIVATE_PID);
+        for (uint8_t sec = 0; sec < 8; ++sec) {
+            uint8_t payload[4000];
+            prng.fill(payload, sizeof(payload));
+            pzer_private.addSection(new ts::Section(0x80, true, 0x1234, 0, true, sec, 7, payload, sizeof(payload), PRIVATE_PID));
+        }
+
+        uint8_t cc[SERVICE_COUNT] = {0};
+        packets.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            ts::TSPacket& pkt(packets[i]);
+            if (i % 100 == 0) {
+                pzer_psi.getNextPacket(pkt);
+            }
+            else if (i % 100 <= SERVICE_COUNT) {
+                pzer_pmt[i % 100 - 1]->getNextPacket(pkt);
+            }
+            else if (i % 10 == 5) {
+                pzer_private.getNextPacket(pkt);
+            }
+            else {
+                const size_t srv = i % SERVICE_COUNT;
+                pkt = ts::NullPacket;
+                pkt.setPID(ts::PID(ES_PID_BASE + srv));
+                pkt.setCC(cc[srv]);
+                prng.fill(pkt.b + 4, ts::PKT_SIZE - 4);
+                if (cc[srv] == 0) {
+                    // Start of a video PES packet once every 16 packets.
+                    static const uint8_t pes_header[] = {0x00, 0x00, 0x01, 0xE0, 0x00, 0x00, 0x80, 0x00, 0x00};
+                    pkt.setPUSI();
+                    ::memcpy(pkt.b + 4, pes_header, sizeof(pes_header));  // Flawfinder: ignore: memcpy()
+                }
+                cc[srv] = (cc[srv] + 1) & ts::CC_MASK;
+            }
+        }
+
+        for (size_t srv = 0; srv < pzer_pmt.size(); ++srv) {
+            delete pzer_pmt[srv];
+        }
+    }
+
+    // Load a recorded stream.
+    bool LoadStream(ts::TSPacketVector& packets, const ts::UString& filename, size_t max_count, ts::Report& report)
+    {
+        ts::TSFileInput file;
+        if (!file.open(filename, 0, report)) {
+            return false;
+        }
+        packets.resize(max_count);
+        const size_t count = file.read(packets.data(), max_count, report);
+        packets.resize(count);
+        file.close(report);
+        if (count == 0) {
+            report.error(u"no packet in %s", {filename});
+            return false;
+        }
+        return true;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Benchmark definitions.
+//----------------------------------------------------------------------------
+
+namespace {
+
+    // Abstract base class of a benchmark.
+    class Benchmark
+    {
+    public:
+        Benchmark(const ts::UString& name, const ts::UString& unit, const ts::UString& description) :
+            _name(name),
+            _unit(unit),
+            _description(description)
+        {
+        }
+        virtual ~Benchmark() {}
+
+        const ts::UString& name() const {return _name;}
+        const ts::UString& unit() const {return _unit;}
+        const ts::UString& description() const {return _description;}
+
+        // Prepare the benchmark on a stream.
+        virtual void setup(ts::TSPacketVector& packets) {}
+
+        // Run one pass, return the number of processed units and bytes.
+        virtual void run(ts::TSPacketVector& packets, uint64_t& units, uint64_t& bytes) = 0;
+
+    private:
+        ts::UString _name;
+        ts::UString _unit;
+        ts::UString _description;
+    };
+
+    typedef ts::SafePtr<Benchmark> BenchmarkPtr;
+
+    // CRC32 on complete sections.
+    class CRC32Benchmark: public Benchmark
+    {
+    public:
+        CRC32Benchmark() : Benchmark(u"crc32", u"section", u"MPEG CRC32 on 4 kB sections"), _data(64 * 4096), _result(0) {}
+        virtual void setup(ts::TSPacketVector&) override
+        {
+            PseudoRandom prng;
+            prng.fill(_data.data(), _data.size());
+        }
+        virtual void run(ts::TSPacketVector&, uint64_t& units, uint64_t& bytes) override
+        {
+            uint32_t result = 0;
+            for (size_t i = 0; i < _data.size(); i += 4096) {
+                result ^= ts::CRC32(&_data[i], 4096).value();
+            }
+            _result = result;
+            units = _data.size() / 4096;
+            bytes = _data.size();
+        }
+    private:
+        ts::ByteBlock _data;
+        volatile uint32_t _result;
+    };
+
+    // Section demux on all PSI and private PID's.
+    class DemuxBenchmark: public Benchmark, private ts::TableHandlerInterface
+    {
+    public:
+        DemuxBenchmark() : Benchmark(u"demux", u"packet", u"SectionDemux on all PID's"), _demux(this, 0, ts::AllPIDs), _tables(0) {}
+        virtual void run(ts::TSPacketVector& packets, uint64_t& units, uint64_t& bytes) override
+        {
+            _demux.reset();
+            _demux.setPIDFilter(ts::AllPIDs);
+            for (size_t i = 0; i < packets.size(); ++i) {
+                _demux.feedPacket(packets[i]);
+            }
+            units = packets.size();
+            bytes = packets.size() * ts::PKT_SIZE;
+        }
+    private:
+        ts::SectionDemux _demux;
+        size_t _tables;
+        virtual void handleTable(ts::SectionDemux&, const ts::BinaryTable&) override {_tables++;}
+    };
+
+    // Transport stream analysis.
+    class AnalyzerBenchmark: public Benchmark
+    {
+    public:
+        AnalyzerBenchmark() : Benchmark(u"analyzer", u"packet", u"TSAnalyzer, as in tsanalyze") {}
+        virtual void run(ts::TSPacketVector& packets, uint64_t& units, uint64_t& bytes) override
+        {
+            ts::TSAnalyzer analyzer(20000000);
+            for (size_t i = 0; i < packets.size(); ++i) {
+                analyzer.feedPacket(packets[i]);
+            }
+            units = packets.size();
+            bytes = packets.size() * ts::PKT_SIZE;
+        }
+    };
+
+    // DVB-CSA scrambling, one packet at a time or in batches.
+    class ScramblingBenchmark: public Benchmark
+    {
+    public:
+        ScramblingBenchmark(bool decrypt, bool batch) :
+            Benchmark(ts::UString::Format(u"csa-%s%s", {decrypt ? u"decrypt" : u"encrypt", batch ? u"-batch" : u""}),
+                      u"packet",
+                      ts::UString::Format(u"DVB-CSA %s of TS payloads%s", {decrypt ? u"descrambling" : u"scrambling", batch ? u", in batches" : u""})),
+            _decrypt(decrypt),
+            _batch(batch),
+            _scrambling()
+        {
+            static const uint8_t cw[ts::Scrambling::KEY_SIZE] = {0x01, 0x23, 0x45, 0xAD, 0x89, 0xAB, 0xCD, 0x01};
+            _scrambling.init(cw, ts::Scrambling::FULL_CW);
+        }
+        virtual void run(ts::TSPacketVector& packets, uint64_t& units, uint64_t& bytes) override
+        {
+            uint8_t* data[BATCH_SIZE];
+            size_t sizes[BATCH_SIZE];
+            size_t count = 0;
+            bytes = 0;
+            for (size_t i = 0; i < packets.size(); ++i) {
+                uint8_t* const pl = packets[i].getPayload();
+                const size_t size = packets[i].getPayloadSize();
+                bytes += size;
+                if (!_batch) {
+                    _decrypt ? _scrambling.decrypt(pl, size) : _scrambling.encrypt(pl, size);
+                }
+                else {
+                    data[count] = pl;
+                    sizes[count++] = size;
+                    if (count == BATCH_SIZE || i + 1 == packets.size()) {
+                        _decrypt ? _scrambling.decrypt(data, sizes, count) : _scrambling.encrypt(data, sizes, count);
+                        count = 0;
+                    }
+                }
+            }
+            units = packets.size();
+        }
+    private:
+        bool _decrypt;
+        bool _batch;
+        ts::Scrambling _scrambling;
+    };
+
+    // AES-128 chaining modes on TS payloads.
+    template <class CHAIN>
+    class AESBenchmark: public Benchmark
+    {
+    public:
+        AESBenchmark(const ts::UString& name, bool decrypt, bool batch) :
+            Benchmark(ts::UString::Format(u"%s-%s%s", {name, decrypt ? u"decrypt" : u"encrypt", batch ? u"-batch" : u""}),
+                      u"packet",
+                      ts::UString::Format(u"AES-128 %s %s of TS payloads%s", {name.toUpper(), decrypt ? u"decryption" : u"encryption", batch ? u", in batches" : u""})),
+            _decrypt(decrypt),
+            _batch(batch),
+            _chain()
+        {
+            static const uint8_t key[16] = {0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6, 0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C};
+            static const uint8_t iv[16] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F};
+            _chain.setKey(key, sizeof(key));
+            _chain.setIV(iv, sizeof(iv));
+        }
+        virtual void run(ts::TSPacketVector& packets, uint64_t& units, uint64_t& bytes) override
+        {
+            uint8_t* data[BATCH_SIZE];
+            size_t sizes[BATCH_SIZE];
+            uint8_t tmp[ts::PKT_SIZE];
+            size_t count = 0;
+            bytes = 0;
+            units = 0;
+            for (size_t i = 0; i < packets.size(); ++i) {
+                uint8_t* const pl = packets[i].getPayload();
+                size_t size = packets[i].getPayloadSize();
+                if (!_chain.residueAllowed()) {
+                    size -= size % _chain.blockSize();
+                }
+                if (size >= _chain.minMessageSize()) {
+                    bytes += size;
+                    units++;
+                    if (!_batch) {
+                        _decrypt ? _chain.decrypt(pl, size, tmp, sizeof(tmp)) : _chain.encrypt(pl, size, tmp, sizeof(tmp));
+                        ::memcpy(pl, tmp, size);  // Flawfinder: ignore: memcpy()
+                    }
+                    else {
+                        data[count] = pl;
+                        sizes[count++] = size;
+                    }
+                }
+                if (count > 0 && (count == BATCH_SIZE || i + 1 == packets.size())) {
+                    _decrypt ? _chain.decryptMessages(data, sizes, count) : _chain.encryptMessages(data, sizes, count);
+                    count = 0;
+                }
+            }
+        }
+    private:
+        bool _decrypt;
+        bool _batch;
+        CHAIN _chain;
+    };
+
+    // String formatting.
+    class FormatBenchmark: public Benchmark
+    {
+    public:
+        FormatBenchmark() : Benchmark(u"format", u"call", u"UString::Format with integer and string arguments") {}
+        virtual void run(ts::TSPacketVector& packets, uint64_t& units, uint64_t& bytes) override
+        {
+            static const ts::UString name(u"service");
+            bytes = 0;
+            for (size_t i = 0; i < 10000; ++i) {
+                const ts::UString str(ts::UString::Format(u"PID %d (0x%X), %s #%d: %'d packets", {i & 0x1FFF, i & 0x1FFF, name, i, i * 1000}));
+                bytes += str.size();
+            }
+            units = 10000;
+        }
+    };
+
+    // Result of a benchmark.
+    struct Result
+    {
+        uint64_t        units;         // Total processed units.
+        uint64_t        bytes;         // Total processed bytes.
+        ts::NanoSecond  duration;      // Total duration.
+        uint64_t        allocations;   // Number of memory allocations.
+        int64_t         cache_misses;  // Number of cache misses, -1 if unavailable.
+        size_t          passes;        // Number of passes on the stream.
+    };
+
+    // Format a floating point value with a fixed number of decimals.
+    ts::UString Fixed(double value, int decimals, size_t width = 0)
+    {
+        std::ostringstream str;
+        str << std::fixed << std::setprecision(decimals) << value;
+        return ts::UString::FromUTF8(str.str()).toJustifiedRight(width);
+    }
+
+    // Run a benchmark for a minimum duration.
+    Result RunBenchmark(Benchmark& bench, ts::TSPacketVector& packets, ts::MilliSecond min_duration)
+    {
+        Result result;
+        TS_ZERO(result);
+        CacheMissCounter cache;
+        uint64_t units = 0;
+        uint64_t bytes = 0;
+
+        // Warm-up pass, not measured.
+        bench.setup(packets);
+        bench.run(packets, units, bytes);
+
+        const uint64_t alloc_start = allocation_count;
+        cache.start();
+        ts::Monotonic start;
+        ts::Monotonic now;
+        start.getSystemTime();
+        do {
+            bench.run(packets, units, bytes);
+            result.units += units;
+            result.bytes += bytes;
+            result.passes++;
+            now.getSystemTime();
+        } while (now - start < min_duration * ts::NanoSecPerMilliSec);
+        result.cache_misses = cache.stop();
+        result.allocations = allocation_count - alloc_start;
+        result.duration = now - start;
+        return result;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+//  Program entry point
+//----------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+    TSDuckLibCheckVersion();
+    Options opt(argc, argv);
+
+    // List of all benchmarks.
+    std::vector<BenchmarkPtr> all;
+    all.push_back(new CRC32Benchmark);
+    all.push_back(new DemuxBenchmark);
+    all.push_back(new AnalyzerBenchmark);
+    all.push_back(new ScramblingBenchmark(false, false));
+    all.push_back(new ScramblingBenchmark(false, true));
+    all.push_back(new ScramblingBenchmark(true, false));
+    all.push_back(new ScramblingBenchmark(true, true));
+    all.push_back(new AESBenchmark<ts::CBC<ts::AES>>(u"cbc", false, false));
+    all.push_back(new AESBenchmark<ts::CBC<ts::AES>>(u"cbc", true, false));
+    all.push_back(new AESBenchmark<ts::DVS042<ts::AES>>(u"dvs042", false, false));
+    all.push_back(new AESBenchmark<ts::DVS042<ts::AES>>(u"dvs042", false, true));
+    all.push_back(new AESBenchmark<ts::DVS042<ts::AES>>(u"dvs042", true, false));
+    all.push_back(new AESBenchmark<ts::DVS042<ts::AES>>(u"dvs042", true, true));
+    all.push_back(new FormatBenchmark);
+
+    if (opt.list) {
+        for (size_t i = 0; i < all.size(); ++i) {
+            std::cout << all[i]->name().toJustifiedLeft(24) << all[i]->description() << std::endl;
+        }
+        return EXIT_SUCCESS;
+    }
+
+    // Select benchmarks.
+    std::vector<BenchmarkPtr> selected;
+    for (size_t i = 0; i < all.size(); ++i) {
+        if (opt.names.empty() || std::find(opt.names.begin(), opt.names.end(), all[i]->name()) != opt.names.end()) {
+            selected.push_back(all[i]);
+        }
+    }
+    for (size_t i = 0; i < opt.names.size(); ++i) {
+        bool found = false;
+        for (size_t j = 0; !found && j < all.size(); ++j) {
+            found = all[j]->name() == opt.names[i];
+        }
+        if (!found) {
+            opt.error(u"unknown benchmark %s, use --list", {opt.names[i]});
+        }
+    }
+    opt.exitOnError();
+
+    // Build or load the test stream.
+    ts::TSPacketVector packets;
+    if (opt.input.empty()) {
+        BuildSyntheticStream(packets, opt.packets);
+    }
+    else if (!LoadStream(packets, opt.input, opt.packets, opt)) {
+        return EXIT_FAILURE;
+    }
+
+    // Header.
+    if (opt.json) {
+        std::cout << "{" << std::endl
+                  << "  \"version\": \"" << ts::GetVersion() << "\"," << std::endl
+                  << "  \"input\": \"" << (opt.input.empty() ? ts::UString(u"synthetic") : opt.input).toJSON() << "\"," << std::endl
+                  << "  \"packets\": " << packets.size() << "," << std::endl
+                  << "  \"cache_misses_available\": " << (CacheMissCounter().available() ? "true" : "false") << "," << std::endl
+                  << "  \"results\": [";
+    }
+    else {
+        std::cout << ts::UString::Format(u"TSDuck %s, %s, %'d packets", {ts::GetVersion(), opt.input.empty() ? u"synthetic stream" : opt.input, packets.size()}) << std::endl
+                  << std::endl
+                  << "Benchmark                  units/s     ns/unit      MB/s  allocs/unit  misses/unit" << std::endl
+                  << "----------------------  ----------  ----------  --------  -----------  -----------" << std::endl;
+    }
+
+    // Run all benchmarks. Each benchmark works on a fresh copy of the stream.
+    for (size_t i = 0; i < selected.size(); ++i) {
+        Benchmark& bench(*selected[i]);
+        ts::TSPacketVector work(packets);
+        const Result res(RunBenchmark(bench, work, opt.duration));
+
+        const double seconds = double(res.duration) / double(ts::NanoSecPerSec);
+        const double units_per_sec = res.units == 0 ? 0.0 : double(res.units) / seconds;
+        const double ns_per_unit = res.units == 0 ? 0.0 : double(res.duration) / double(res.units);
+        const double mb_per_sec = double(res.bytes) / seconds / 1000000.0;
+        const double allocs_per_unit = res.units == 0 ? 0.0 : double(res.allocations) / double(res.units);
+        const double misses_per_unit = res.units == 0 || res.cache_misses < 0 ? -1.0 : double(res.cache_misses) / double(res.units);
+
+        if (opt.json) {
+            std::cout << (i == 0 ? "" : ",") << std::endl
+                      << "    {" << std::endl
+                      << "      \"name\": \"" << bench.name() << "\"," << std::endl
+                      << "      \"unit\": \"" << bench.unit() << "\"," << std::endl
+                      << "      \"passes\": " << res.passes << "," << std::endl
+                      << "      \"units\": " << res.units << "," << std::endl
+                      << "      \"bytes\": " << res.bytes << "," << std::endl
+                      << "      \"duration_ns\": " << res.duration << "," << std::endl
+                      << "      \"units_per_second\": " << Fixed(units_per_sec, 1) << "," << std::endl
+                      << "      \"ns_per_unit\": " << Fixed(ns_per_unit, 3) << "," << std::endl
+                      << "      \"allocations\": " << res.allocations << "," << std::endl
+                      << "      \"cache_misses\": " << (res.cache_misses < 0 ? ts::UString(u"null") : ts::UString::Decimal(res.cache_misses, 0, true, ts::UString())) << std::endl
+                      << "    }";
+        }
+        else {
+            std::cout << bench.name().toJustifiedLeft(22) << "  "
+                      << Fixed(units_per_sec, 0, 10) << "  "
+                      << Fixed(ns_per_unit, 1, 10) << "  "
+                      << Fixed(mb_per_sec, 1, 8) << "  "
+                      << Fixed(allocs_per_unit, 3, 11) << "  "
+                      << (misses_per_unit < 0 ? ts::UString(u"n/a").toJustifiedRight(11) : Fixed(misses_per_unit, 3, 11))
+                      << std::endl;
+        }
+    }
+
+    if (opt.json) {
+        std::cout << std::endl << "  ]" << std::endl << "}" << std::endl;
+    }
+    return EXIT_SUCCESS;
+}
@@ -37,9 +37,13 @@
 #include "tsSignalAllocator.h"
 #include "tsNullReport.h"
 #include "tsMemoryUtils.h"
+#include "tsByteBlock.h"
+#include "tsThread.h"
+#include "tsGuardCondition.h"
 TSDUCK_SOURCE;
 
 #define MAX_OVERFLOW  8   // Maximum consecutive overflow
+#define READER_POLL   100 // Polling time in milliseconds for the DVR reader thread
 
 #if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
 const ts::MilliSecond ts::Tuner::DEFAULT_SIGNAL_TIMEOUT;
@@ -95,6 +99,220 @@ namespace {
 }
 
 
+//-----------------------------------------------------------------------------
+// Thread reading the DVR device into a user-space ring buffer.
+//-----------------------------------------------------------------------------
+//
+// The DVR device buffer is the kernel demux buffer. When the application is
+// temporarily slowed down, this buffer overflows and packets are lost. The
+// reader thread only drains the DVR device, using large read operations, into
+// a much larger ring buffer. Tuner::receive() then gets packets from the ring.
+//
+
+class ts::Tuner::DVRReader: private Thread
+{
+public:
+    // Constructor and destructor.
+    DVRReader(int fd, size_t size);
+    virtual ~DVRReader() override;
+
+    // Start and stop the thread.
+    bool start() { return Thread::start(); }
+    void stop();
+
+    // Get complete packets from the ring, wait for at least one packet.
+    // Return the number of bytes or zero on error, end of input or timeout.
+    size_t receive(char* data, size_t max_size, MilliSecond timeout, const AbortInterface* abort, bool& timeout_expired, Report& report);
+
+    // Report statistics.
+    void reportStatistics(const UString& name, Report& report);
+
+private:
+    const int     _fd;            // DVR device file descriptor
+    Mutex         _mutex;         // Protect the following fields
+    Condition     _got_data;      // Signaled when data are written in the ring
+    Condition     _got_space;     // Signaled when data are removed from the ring
+    ByteBlock     _ring;          // User-space ring buffer
+    size_t        _first;         // Index of first byte in ring
+    size_t        _size;          // Number of bytes in ring
+    bool          _terminate;     // Request thread termination
+    bool          _eof;           // End of input on DVR device
+    ErrorCode     _error;         // Read error on DVR device
+    bool          _overflow;      // Too many consecutive overflows on DVR device
+    uint64_t      _full_count;    // Number of times the ring was full
+    uint64_t      _overflow_count;// Number of overflows on DVR device
+    size_t        _max_size;      // Highest ring fill
+
+    // Implementation of Thread.
+    virtual void main() override;
+
+    // Inaccessible operations.
+    DVRReader() = delete;
+    DVRReader(const DVRReader&) = delete;
+    DVRReader& operator=(const DVRReader&) = delete;
+};
+
+ts::Tuner::DVRReader::DVRReader(int fd, size_t size) :
+    Thread(ThreadAttributes().setPriority(ThreadAttributes::GetHighPriority())),
+    _fd(fd),
+    _mutex(),
+    _got_data(),
+    _got_space(),
+    _ring(std::max<size_t>(size, PKT_SIZE)),
+    _first(0),
+    _size(0),
+    _terminate(false),
+    _eof(false),
+    _error(SYS_SUCCESS),
+    _overflow(false),
+    _full_count(0),
+    _overflow_count(0),
+    _max_size(0)
+{
+}
+
+ts::Tuner::DVRReader::~DVRReader()
+{
+    stop();
+}
+
+void ts::Tuner::DVRReader::stop()
+{
+    {
+        GuardCondition lock(_mutex, _got_space);
+        _terminate = true;
+        lock.signal();
+    }
+    waitForTermination();
+}
+
+void ts::Tuner::DVRReader::reportStatistics(const UString& name, Report& report)
+{
+    Guard lock(_mutex);
+    report.verbose(u"%s: user buffer %'d bytes, max fill %'d bytes, %'d times full, %'d DVR overflows",
+                   {name, _ring.size(), _max_size, _full_count, _overflow_count});
+}
+
+// Reader thread.
+void ts::Tuner::DVRReader::main()
+{
+    int overflow_count = 0;
+
+    for (;;) {
+        uint8_t* area = 0;
+        size_t area_size = 0;
+
+        // Get the next free contiguous area in the ring, wait for space when full.
+        {
+            GuardCondition lock(_mutex, _got_space);
+            if (_size >= _ring.size()) {
+                _full_count++;
+                while (!_terminate && _size >= _ring.size()) {
+                    lock.waitCondition();
+                }
+            }
+            if (_terminate) {
+                break;
+            }
+            const size_t next = (_first + _size) % _ring.size();
+            area = &_ring[next];
+            area_size = next < _first ? _first - next : _ring.size() - next;
+        }
+
+        // Wait for data, with a timeout to check termination requests.
+        ::pollfd pfd;
+        TS_ZERO(pfd);
+        pfd.fd = _fd;
+        pfd.events = POLLIN;
+        const int status = ::poll(&pfd, 1, READER_POLL);
+        if (status == 0 || (status < 0 && errno == EINTR)) {
+            continue;
+        }
+
+        // Read as much as possible in the free area.
+        const ssize_t insize = status < 0 ? -1 : ::read(_fd, area, area_size);
+        const ErrorCode err = insize < 0 ? LastErrorCode() : SYS_SUCCESS;
+
+        GuardCondition lock(_mutex, _got_data);
+        if (insize > 0) {
+            overflow_count = 0;
+            _size += size_t(insize);
+            _max_size = std::max(_max_size, _size);
+        }
+        else if (insize == 0) {
+            _eof = true;
+        }
+        else if (err == EOVERFLOW) {
+            _overflow_count++;
+            _overflow = ++overflow_count > MAX_OVERFLOW;
+        }
+        else if (err != EINTR) {
+            _error = err;
+        }
+        lock.signal();
+        if (_eof || _overflow || _error != SYS_SUCCESS) {
+            break;
+        }
+    }
+}
+
+// Get packets from the ring.
+size_t ts::Tuner::DVRReader::receive(char* data, size_t max_size, MilliSecond timeout, const AbortInterface* abort, bool& timeout_expired, Report& report)
+{
+    const Time time_limit(timeout > 0 ? Time::CurrentLocalTime() + timeout : Time::Epoch);
+    size_t first = 0;
+    size_t size = 0;
+
+    timeout_expired = false;
+
+    // Wait for at least one complete packet.
+    {
+        GuardCondition lock(_mutex, _got_data);
+        while (_size < PKT_SIZE) {
+            if (_eof || _overflow || _error != SYS_SUCCESS) {
+                if (_overflow) {
+                    report.error(u"input overflow, possible packet loss");
+                }
+                else if (_error != SYS_SUCCESS) {
+                    report.error(u"receive error: %s", {ErrorCodeMessage(_error)});
+                }
+                return 0;
+            }
+            if (abort != 0 && abort->aborting()) {
+                return 0;
+            }
+            MilliSecond wait = READER_POLL;
+            if (timeout > 0) {
+                const MilliSecond remain = time_limit - Time::CurrentLocalTime();
+                if (remain <= 0) {
+                    timeout_expired = true;
+                    return 0;
+                }
+                wait = std::min(wait, remain);
+            }
+            lock.waitCondition(wait);
+        }
+        first = _first;
+        size = std::min(_size, max_size);
+        size -= size % PKT_SIZE;
+    }
+
+    // Copy the packets outside the lock, the reader thread does not modify this area.
+    const size_t size1 = std::min(size, _ring.size() - first);
+    ::memcpy(data, &_ring[first], size1);
+    if (size1 < size) {
+        ::memcpy(data + size1, &_ring[0], size - size1);
+    }
+
+    // Release the area in the ring.
+    GuardCondition lock(_mutex, _got_space);
+    _first = (_first + size) % _ring.size();
+    _size -= size;
+    lock.signal();
+    return size;
+}
+
+
 //-----------------------------------------------------------------------------
 // Destructor
 //-----------------------------------------------------------------------------
@@ -123,6 +341,7 @@ ts::Tuner::Tuner(const UString& device_name) :
     _signal_timeout_silent(false),
     _receive_timeout(0),
     _delivery_systems(),
+    _pid_filter(AllPIDs),
     _frontend_name(),
     _demux_name(),
     _dvr_name(),
@@ -130,11 +349,14 @@ ts::Tuner::Tuner(const UString& device_name) :
     _demux_fd(-1),
     _dvr_fd(-1),
     _demux_bufsize(DEFAULT_DEMUX_BUFFER_SIZE),
+    _user_bufsize(0),
+    _demux_running(false),
     _fe_info(),
     _signal_poll(DEFAULT_SIGNAL_POLL),
     _rt_signal(-1),
     _rt_timer(0),
-    _rt_timer_valid(false)
+    _rt_timer_valid(false),
+    _dvr_reader(0)
 {
 }
 
@@ -317,10 +539,14 @@ bool ts::Tuner::open(const UString& device_name, bool info_only, Report& report)
 
 bool ts::Tuner::close(Report& report)
 {
+    // Stop the DVR reader thread before closing the DVR device.
+    stopReader(report);
+
     // Stop the demux
     if (_demux_fd >= 0 && ::ioctl(_demux_fd, DMX_STOP) < 0) {
         report.error(u"error stopping demux on %s: %s", {_demux_name, ErrorCodeMessage()});
     }
+    _demux_running = false;
 
     // Close DVB adapter devices
     if (_dvr_fd >= 0) {
@@ -946,27 +1172,9 @@ bool ts::Tuner::start(Report& report)
         return false;
     }
 
-    // Apply a filter to the demux.
-
-    // The Linux DVB API defines two types of filters: sections and PES.
-    // A section filter actually filter sections. On the other hand, a
-    // so-called "PES" filter is based on PID's, not PES headers.
-    // These PID's may contain anything, not limited to PES data.
-    // The magic value 0x2000 is used in the Linux DVB API to say
-    // "all PID's" (remember that the max value for a PID is 0x1FFF).
-    // Specifying a "PES filter" with PID 0x2000, we get the full TS.
-
-    ::dmx_pes_filter_params filter;
-    TS_ZERO(filter);
-
-    filter.pid = 0x2000;                // Means "all PID's"
-    filter.input = DMX_IN_FRONTEND;     // Read from frontend device
-    filter.output = DMX_OUT_TS_TAP;     // Redirect TS packets to DVR device
-    filter.pes_type = DMX_PES_OTHER;    // Any type of PES
-    filter.flags = DMX_IMMEDIATE_START; // Start capture immediately
+    // Apply the PID filter to the demux.
 
-    if (::ioctl(_demux_fd, DMX_SET_PES_FILTER, &filter) < 0) {
-        report.error(u"error setting filter on %s: %s", {_demux_name, ErrorCodeMessage()});
+    if (!startDemuxFilter(report)) {
         return false;
     }
 
@@ -1001,6 +1209,17 @@ bool ts::Tuner::start(Report& report)
         return false;
     }
 
+    // Start the DVR reader thread if a user-space buffer is requested.
+    if (_user_bufsize > 0 && _dvr_reader == 0) {
+        _dvr_reader = new DVRReader(_dvr_fd, _user_bufsize);
+        if (!_dvr_reader->start()) {
+            report.error(u"error starting DVR reader thread on %s", {_dvr_name});
+            delete _dvr_reader;
+            _dvr_reader = 0;
+            return false;
+        }
+    }
+
     return true;
 }
 
@@ -1017,7 +1236,11 @@ bool ts::Tuner::stop(Report& report)
         return false;
     }
 
+    // Stop the DVR reader thread
+    stopReader(report);
+
     // Stop the demux
+    _demux_running = false;
     if (::ioctl(_demux_fd, DMX_STOP) < 0) {
         report.error(u"error stopping demux on %s: %s", {_demux_name, ErrorCodeMessage()});
         return false;
@@ -1027,6 +1250,121 @@ bool ts::Tuner::stop(Report& report)
 }
 
 
+//-----------------------------------------------------------------------------
+// Install the PID filter on the demux and start it.
+//-----------------------------------------------------------------------------
+
+bool ts::Tuner::startDemuxFilter(Report& report)
+{
+    // The Linux DVB API defines two types of filters: sections and PES.
+    // A section filter actually filter sections. On the other hand, a
+    // so-called "PES" filter is based on PID's, not PES headers.
+    // These PID's may contain anything, not limited to PES data.
+    // The magic value 0x2000 is used in the Linux DVB API to say
+    // "all PID's" (remember that the max value for a PID is 0x1FFF).
+    // Specifying a "PES filter" with PID 0x2000, we get the full TS.
+    // Otherwise, the PES filter is set on the first PID and the other
+    // PID's are added to the same filter using DMX_ADD_PID.
+
+    const bool all_pids = _pid_filter.all();
+    PID first_pid = 0;
+    while (!all_pids && !_pid_filter.test(first_pid)) {
+        ++first_pid;
+    }
+
+    ::dmx_pes_filter_params filter;
+    TS_ZERO(filter);
+
+    filter.pid = all_pids ? 0x2000 : first_pid; // 0x2000 means "all PID's"
+    filter.input = DMX_IN_FRONTEND;     // Read from frontend device
+    filter.output = DMX_OUT_TS_TAP;     // Redirect TS packets to DVR device
+    filter.pes_type = DMX_PES_OTHER;    // Any type of PES
+    filter.flags = DMX_IMMEDIATE_START; // Start capture immediately
+
+    if (::ioctl(_demux_fd, DMX_SET_PES_FILTER, &filter) < 0) {
+        report.error(u"error setting filter on %s: %s", {_demux_name, ErrorCodeMessage()});
+        return false;
+    }
+    _demux_running = true;
+
+    for (PID pid = first_pid + 1; !all_pids && pid < PID_MAX; ++pid) {
+        uint16_t arg = pid;
+        if (_pid_filter.test(pid) && ::ioctl(_demux_fd, DMX_ADD_PID, &arg) < 0) {
+            report.error(u"error adding PID 0x%X (%d) to filter on %s: %s", {pid, pid, _demux_name, ErrorCodeMessage()});
+            return false;
+        }
+    }
+
+    report.debug(u"demux filter started on %s, %d PID's", {_demux_name, _pid_filter.count()});
+    return true;
+}
+
+
+//-----------------------------------------------------------------------------
+// Set the PID's to receive.
+//-----------------------------------------------------------------------------
+
+bool ts::Tuner::setPIDFilter(const PIDSet& pids, Report& report)
+{
+    if (pids.none()) {
+        report.error(u"empty PID filter on %s", {_demux_name});
+        return false;
+    }
+
+    const PIDSet previous(_pid_filter);
+    _pid_filter = pids;
+
+    // Before start(), the filter is installed by start().
+    if (!_demux_running || previous == pids) {
+        return true;
+    }
+
+    // Switching between full TS and PID filtering: restart the filter.
+    if (previous.all() || pids.all()) {
+        _demux_running = false;
+        if (::ioctl(_demux_fd, DMX_STOP) < 0) {
+            report.error(u"error stopping demux on %s: %s", {_demux_name, ErrorCodeMessage()});
+            return false;
+        }
+        return startDemuxFilter(report);
+    }
+
+    // Incrementally add new PID's first, then remove old ones, so that
+    // the filter never becomes empty (the demux would stop).
+    for (PID pid = 0; pid < PID_MAX; ++pid) {
+        uint16_t arg = pid;
+        if (pids.test(pid) && !previous.test(pid) && ::ioctl(_demux_fd, DMX_ADD_PID, &arg) < 0) {
+            report.error(u"error adding PID 0x%X (%d) to filter on %s: %s", {pid, pid, _demux_name, ErrorCodeMessage()});
+            return false;
+        }
+    }
+    for (PID pid = 0; pid < PID_MAX; ++pid) {
+        uint16_t arg = pid;
+        if (!pids.test(pid) && previous.test(pid) && ::ioctl(_demux_fd, DMX_REMOVE_PID, &arg) < 0) {
+            report.error(u"error removing PID 0x%X (%d) from filter on %s: %s", {pid, pid, _demux_name, ErrorCodeMessage()});
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+//-----------------------------------------------------------------------------
+// Stop and delete the DVR reader thread, if any.
+//-----------------------------------------------------------------------------
+
+void ts::Tuner::stopReader(Report& report)
+{
+    if (_dvr_reader != 0) {
+        _dvr_reader->stop();
+        _dvr_reader->reportStatistics(_dvr_name, report);
+        delete _dvr_reader;
+        _dvr_reader = 0;
+    }
+}
+
+
 //-----------------------------------------------------------------------------
 // Empty signal handler, simply interrupt system calls and report EINTR.
 //-----------------------------------------------------------------------------
@@ -1138,9 +1476,18 @@ size_t ts::Tuner::receive(TSPacket* buffer, size_t max_packets, const AbortInter
     size_t got_size = 0;
     int overflow_count = 0;
 
+    // With a DVR reader thread, get packets from the user-space buffer.
+    if (_dvr_reader != 0) {
+        bool timeout_expired = false;
+        got_size = _dvr_reader->receive(data, req_size, _receive_timeout, abort, timeout_expired, report);
+        if (timeout_expired) {
+            report.error(u"receive timeout on %s", {_device_name});
+        }
+    }
+
     // Set deadline if receive timeout in effect
     Time time_limit;
-    if (_receive_timeout > 0) {
+    if (_dvr_reader == 0 && _receive_timeout > 0) {
         assert(_rt_timer_valid);
         // Arm the receive timer.
         // Note that _receive_timeout is in milliseconds and ::itimerspec is in nanoseconds.
@@ -1158,7 +1505,7 @@ size_t ts::Tuner::receive(TSPacket* buffer, size_t max_packets, const AbortInter
     }
 
     // Loop on read until we get enough
-    while (got_size < req_size) {
+    while (_dvr_reader == 0 && got_size < req_size) {
 
         // Read some data
         bool got_overflow = false;
@@ -1213,7 +1560,7 @@ size_t ts::Tuner::receive(TSPacket* buffer, size_t max_packets, const AbortInter
     }
 
     // Disarm the receive timer.
-    if (_receive_timeout > 0) {
+    if (_dvr_reader == 0 && _receive_timeout > 0) {
         ::itimerspec timeout;
         timeout.it_value.tv_sec = 0;
         timeout.it_value.tv_nsec = 0;
@@ -66,7 +66,8 @@ ts::Tuner::Tuner(const UString& device_name) :
     _signal_timeout(DEFAULT_SIGNAL_TIMEOUT),
     _signal_timeout_silent(false),
     _receive_timeout(0),
-    _delivery_systems()
+    _delivery_systems(),
+    _pid_filter(AllPIDs)
 {
 }
 
@@ -186,6 +187,17 @@ bool ts::Tuner::start(Report& report)
 }
 
 
+//-----------------------------------------------------------------------------
+// Set the PID's to receive.
+//-----------------------------------------------------------------------------
+
+bool ts::Tuner::setPIDFilter(const PIDSet& pids, Report& report)
+{
+    report.error(NOT_IMPLEMENTED);
+    return false;
+}
+
+
 //-----------------------------------------------------------------------------
 // Stop receiving packets.
 // Return true on success, false on errors
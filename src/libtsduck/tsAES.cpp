@@ -14,8 +14,33 @@
 //----------------------------------------------------------------------------
 
 #include "tsAES.h"
+#include "tsSysInfo.h"
 TSDUCK_SOURCE;
 
+// On x86 processors, the AES-NI instructions are used when available at runtime.
+// On ARM64 processors, the ARMv8 cryptographic extension is used when available.
+// Only compilers which can generate these instructions in a specific function,
+// without global compilation options, are used (except LLVM on ARM64).
+#if !defined(TS_NO_AES_INSTRUCTIONS) && (defined(TS_I386) || defined(TS_X86_64)) && \
+    (defined(TS_MSC) || defined(TS_LLVM) || (defined(TS_GCC_ONLY) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+    #define TS_AES_NI 1
+    #include <immintrin.h>
+    #if defined(TS_MSC)
+        #define TS_TARGET_AES
+    #else
+        #define TS_TARGET_AES __attribute__((target("aes,sse2")))
+    #endif
+#elif !defined(TS_NO_AES_INSTRUCTIONS) && defined(TS_ARM64) && defined(TS_LINUX) && \
+    ((defined(TS_GCC_ONLY) && __GNUC__ >= 8) || (defined(TS_LLVM) && (defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_AES))))
+    #define TS_AES_ARMV8 1
+    #include <arm_neon.h>
+    #if defined(TS_GCC_ONLY)
+        #define TS_TARGET_AES __attribute__((target("+crypto")))
+    #else
+        #define TS_TARGET_AES
+    #endif
+#endif
+
 #define BYTE(x,n) (((x) >> (8 * (n))) & 255)
 
 namespace {
@@ -1009,6 +1034,183 @@ namespace {
                (Te4_1[BYTE (temp, 0)]) ^
                (Te4_0[BYTE (temp, 3)]);
     }
+
+    // Check if the CPU supports the AES instructions. Evaluated once.
+    bool AESInstructions()
+    {
+#if defined(TS_AES_NI) || defined(TS_AES_ARMV8)
+        static const bool supported = ts::SysInfo::Instance()->cpuHasAES();
+#else
+        static const bool supported = false;
+#endif
+        return supported;
+    }
+
+#if defined(TS_AES_NI)
+
+    // Encrypt one block with the scheduled encryption keys, as bytes.
+    TS_TARGET_AES void EncryptInstructions(const uint8_t* rk, int nr, const uint8_t* in, uint8_t* out)
+    {
+        const __m128i* k = reinterpret_cast<const __m128i*>(rk);
+        __m128i s = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in)), _mm_loadu_si128(k));
+        for (int i = 1; i < nr; ++i) {
+            s = _mm_aesenc_si128(s, _mm_loadu_si128(k + i));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_aesenclast_si128(s, _mm_loadu_si128(k + nr)));
+    }
+
+    // Decrypt one block with the scheduled decryption keys (equivalent inverse cipher), as bytes.
+    TS_TARGET_AES void DecryptInstructions(const uint8_t* rk, int nr, const uint8_t* in, uint8_t* out)
+    {
+        const __m128i* k = reinterpret_cast<const __m128i*>(rk);
+        __m128i s = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in)), _mm_loadu_si128(k));
+        for (int i = 1; i < nr; ++i) {
+            s = _mm_aesdec_si128(s, _mm_loadu_si128(k + i));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_aesdeclast_si128(s, _mm_loadu_si128(k + nr)));
+    }
+
+    // Encrypt several blocks, 4 blocks at a time, interleaving the rounds of independent blocks.
+    TS_TARGET_AES void EncryptBlocksInstructions(const uint8_t* rk, int nr, const uint8_t* in, uint8_t* out, size_t count)
+    {
+        const __m128i* k = reinterpret_cast<const __m128i*>(rk);
+        for (; count >= 4; count -= 4, in += 64, out += 64) {
+            const __m128i* src = reinterpret_cast<const __m128i*>(in);
+            __m128i* dst = reinterpret_cast<__m128i*>(out);
+            __m128i key = _mm_loadu_si128(k);
+            __m128i s0 = _mm_xor_si128(_mm_loadu_si128(src), key);
+            __m128i s1 = _mm_xor_si128(_mm_loadu_si128(src + 1), key);
+            __m128i s2 = _mm_xor_si128(_mm_loadu_si128(src + 2), key);
+            __m128i s3 = _mm_xor_si128(_mm_loadu_si128(src + 3), key);
+            for (int i = 1; i < nr; ++i) {
+                key = _mm_loadu_si128(k + i);
+                s0 = _mm_aesenc_si128(s0, key);
+                s1 = _mm_aesenc_si128(s1, key);
+                s2 = _mm_aesenc_si128(s2, key);
+                s3 = _mm_aesenc_si128(s3, key);
+            }
+            key = _mm_loadu_si128(k + nr);
+            _mm_storeu_si128(dst, _mm_aesenclast_si128(s0, key));
+            _mm_storeu_si128(dst + 1, _mm_aesenclast_si128(s1, key));
+            _mm_storeu_si128(dst + 2, _mm_aesenclast_si128(s2, key));
+            _mm_storeu_si128(dst + 3, _mm_aesenclast_si128(s3, key));
+        }
+        for (; count > 0; count--, in += 16, out += 16) {
+            EncryptInstructions(rk, nr, in, out);
+        }
+    }
+
+    // Decrypt several blocks, 4 blocks at a time, interleaving the rounds of independent blocks.
+    TS_TARGET_AES void DecryptBlocksInstructions(const uint8_t* rk, int nr, const uint8_t* in, uint8_t* out, size_t count)
+    {
+        const __m128i* k = reinterpret_cast<const __m128i*>(rk);
+        for (; count >= 4; count -= 4, in += 64, out += 64) {
+            const __m128i* src = reinterpret_cast<const __m128i*>(in);
+            __m128i* dst = reinterpret_cast<__m128i*>(out);
+            __m128i key = _mm_loadu_si128(k);
+            __m128i s0 = _mm_xor_si128(_mm_loadu_si128(src), key);
+            __m128i s1 = _mm_xor_si128(_mm_loadu_si128(src + 1), key);
+            __m128i s2 = _mm_xor_si128(_mm_loadu_si128(src + 2), key);
+            __m128i s3 = _mm_xor_si128(_mm_loadu_si128(src + 3), key);
+            for (int i = 1; i < nr; ++i) {
+                key = _mm_loadu_si128(k + i);
+                s0 = _mm_aesdec_si128(s0, key);
+                s1 = _mm_aesdec_si128(s1, key);
+                s2 = _mm_aesdec_si128(s2, key);
+                s3 = _mm_aesdec_si128(s3, key);
+            }
+            key = _mm_loadu_si128(k + nr);
+            _mm_storeu_si128(dst, _mm_aesdeclast_si128(s0, key));
+            _mm_storeu_si128(dst + 1, _mm_aesdeclast_si128(s1, key));
+            _mm_storeu_si128(dst + 2, _mm_aesdeclast_si128(s2, key));
+            _mm_storeu_si128(dst + 3, _mm_aesdeclast_si128(s3, key));
+        }
+        for (; count > 0; count--, in += 16, out += 16) {
+            DecryptInstructions(rk, nr, in, out);
+        }
+    }
+
+#elif defined(TS_AES_ARMV8)
+
+    // Encrypt one block with the scheduled encryption keys, as bytes.
+    // AESE performs AddRoundKey, SubBytes and ShiftRows, AESMC performs MixColumns.
+    TS_TARGET_AES void EncryptInstructions(const uint8_t* rk, int nr, const uint8_t* in, uint8_t* out)
+    {
+        uint8x16_t s = vld1q_u8(in);
+        for (int i = 0; i < nr - 1; ++i) {
+            s = vaesmcq_u8(vaeseq_u8(s, vld1q_u8(rk + 16 * i)));
+        }
+        s = vaeseq_u8(s, vld1q_u8(rk + 16 * (nr - 1)));
+        vst1q_u8(out, veorq_u8(s, vld1q_u8(rk + 16 * nr)));
+    }
+
+    // Decrypt one block with the scheduled decryption keys (equivalent inverse cipher), as bytes.
+    // AESD performs AddRoundKey, InvSubBytes and InvShiftRows, AESIMC performs InvMixColumns.
+    TS_TARGET_AES void DecryptInstructions(const uint8_t* rk, int nr, const uint8_t* in, uint8_t* out)
+    {
+        uint8x16_t s = vld1q_u8(in);
+        for (int i = 0; i < nr - 1; ++i) {
+            s = vaesimcq_u8(vaesdq_u8(s, vld1q_u8(rk + 16 * i)));
+        }
+        s = vaesdq_u8(s, vld1q_u8(rk + 16 * (nr - 1)));
+        vst1q_u8(out, veorq_u8(s, vld1q_u8(rk + 16 * nr)));
+    }
+
+    // Encrypt several blocks, 4 blocks at a time, interleaving the rounds of independent blocks.
+    TS_TARGET_AES void EncryptBlocksInstructions(const uint8_t* rk, int nr, const uint8_t* in, uint8_t* out, size_t count)
+    {
+        for (; count >= 4; count -= 4, in += 64, out += 64) {
+            uint8x16_t s0 = vld1q_u8(in);
+            uint8x16_t s1 = vld1q_u8(in + 16);
+            uint8x16_t s2 = vld1q_u8(in + 32);
+            uint8x16_t s3 = vld1q_u8(in + 48);
+            for (int i = 0; i < nr - 1; ++i) {
+                const uint8x16_t key = vld1q_u8(rk + 16 * i);
+                s0 = vaesmcq_u8(vaeseq_u8(s0, key));
+                s1 = vaesmcq_u8(vaeseq_u8(s1, key));
+                s2 = vaesmcq_u8(vaeseq_u8(s2, key));
+                s3 = vaesmcq_u8(vaeseq_u8(s3, key));
+            }
+            const uint8x16_t key1 = vld1q_u8(rk + 16 * (nr - 1));
+            const uint8x16_t key2 = vld1q_u8(rk + 16 * nr);
+            vst1q_u8(out, veorq_u8(vaeseq_u8(s0, key1), key2));
+            vst1q_u8(out + 16, veorq_u8(vaeseq_u8(s1, key1), key2));
+            vst1q_u8(out + 32, veorq_u8(vaeseq_u8(s2, key1), key2));
+            vst1q_u8(out + 48, veorq_u8(vaeseq_u8(s3, key1), key2));
+        }
+        for (; count > 0; count--, in += 16, out += 16) {
+            EncryptInstructions(rk, nr, in, out);
+        }
+    }
+
+    // Decrypt several blocks, 4 blocks at a time, interleaving the rounds of independent blocks.
+    TS_TARGET_AES void DecryptBlocksInstructions(const uint8_t* rk, int nr, const uint8_t* in, uint8_t* out, size_t count)
+    {
+        for (; count >= 4; count -= 4, in += 64, out += 64) {
+            uint8x16_t s0 = vld1q_u8(in);
+            uint8x16_t s1 = vld1q_u8(in + 16);
+            uint8x16_t s2 = vld1q_u8(in + 32);
+            uint8x16_t s3 = vld1q_u8(in + 48);
+            for (int i = 0; i < nr - 1; ++i) {
+                const uint8x16_t key = vld1q_u8(rk + 16 * i);
+                s0 = vaesimcq_u8(vaesdq_u8(s0, key));
+                s1 = vaesimcq_u8(vaesdq_u8(s1, key));
+                s2 = vaesimcq_u8(vaesdq_u8(s2, key));
+                s3 = vaesimcq_u8(vaesdq_u8(s3, key));
+            }
+            const uint8x16_t key1 = vld1q_u8(rk + 16 * (nr - 1));
+            const uint8x16_t key2 = vld1q_u8(rk + 16 * nr);
+            vst1q_u8(out, veorq_u8(vaesdq_u8(s0, key1), key2));
+            vst1q_u8(out + 16, veorq_u8(vaesdq_u8(s1, key1), key2));
+            vst1q_u8(out + 32, veorq_u8(vaesdq_u8(s2, key1), key2));
+            vst1q_u8(out + 48, veorq_u8(vaesdq_u8(s3, key1), key2));
+        }
+        for (; count > 0; count--, in += 16, out += 16) {
+            DecryptInstructions(rk, nr, in, out);
+        }
+    }
+
+#endif
 }
 
 
@@ -1165,6 +1367,14 @@ bool ts::AES::setKey(const void* key_, size_t key_length, size_t rounds)
     *rk++ = *rrk++;
     *rk   = *rrk;
 
+    // The AES instructions use the same scheduled keys as byte arrays.
+    if (AESInstructions()) {
+        for (i = 0; i < 4 * (_Nr + 1); i++) {
+            PutUInt32(_eKB + 4 * i, _eK[i]);
+            PutUInt32(_dKB + 4 * i, _dK[i]);
+        }
+    }
+
     return true;
 }
 
@@ -1185,6 +1395,16 @@ bool ts::AES::encrypt(const void* plain, size_t plain_length,
     const uint8_t* pt = reinterpret_cast<const uint8_t*> (plain);
     uint8_t* ct = reinterpret_cast<uint8_t*> (cipher);
 
+#if defined(TS_AES_NI) || defined(TS_AES_ARMV8)
+    if (AESInstructions()) {
+        EncryptInstructions(_eKB, _Nr, pt, ct);
+        if (cipher_length != 0) {
+            *cipher_length = BLOCK_SIZE;
+        }
+        return true;
+    }
+#endif
+
     uint32_t s0, s1, s2, s3, t0, t1, t2, t3, *rk;
     int Nr, r;
 
@@ -1313,6 +1533,16 @@ bool ts::AES::decrypt(const void* cipher, size_t cipher_length,
     const uint8_t* ct = reinterpret_cast<const uint8_t*> (cipher);
     uint8_t* pt = reinterpret_cast<uint8_t*> (plain);
 
+#if defined(TS_AES_NI) || defined(TS_AES_ARMV8)
+    if (AESInstructions()) {
+        DecryptInstructions(_dKB, _Nr, ct, pt);
+        if (plain_length != 0) {
+            *plain_length = BLOCK_SIZE;
+        }
+        return true;
+    }
+#endif
+
     uint32_t s0, s1, s2, s3, t0, t1, t2, t3, *rk;
     int Nr, r;
 
@@ -1426,11 +1656,59 @@ bool ts::AES::decrypt(const void* cipher, size_t cipher_length,
 }
 
 
+//----------------------------------------------------------------------------
+// Multi-block encryption and decryption in ECB mode.
+// With AES instructions, several blocks are processed in parallel.
+//----------------------------------------------------------------------------
+
+bool ts::AES::encryptBlocks(const void* plain, void* cipher, size_t count)
+{
+    const uint8_t* pt = reinterpret_cast<const uint8_t*>(plain);
+    uint8_t* ct = reinterpret_cast<uint8_t*>(cipher);
+
+#if defined(TS_AES_NI) || defined(TS_AES_ARMV8)
+    if (AESInstructions()) {
+        EncryptBlocksInstructions(_eKB, _Nr, pt, ct, count);
+        return true;
+    }
+#endif
+
+    // Avoid a virtual call per block.
+    for (; count > 0; count--, pt += BLOCK_SIZE, ct += BLOCK_SIZE) {
+        AES::encrypt(pt, BLOCK_SIZE, ct, BLOCK_SIZE);
+    }
+    return true;
+}
+
+bool ts::AES::decryptBlocks(const void* cipher, void* plain, size_t count)
+{
+    const uint8_t* ct = reinterpret_cast<const uint8_t*>(cipher);
+    uint8_t* pt = reinterpret_cast<uint8_t*>(plain);
+
+#if defined(TS_AES_NI) || defined(TS_AES_ARMV8)
+    if (AESInstructions()) {
+        DecryptBlocksInstructions(_dKB, _Nr, ct, pt, count);
+        return true;
+    }
+#endif
+
+    // Avoid a virtual call per block.
+    for (; count > 0; count--, ct += BLOCK_SIZE, pt += BLOCK_SIZE) {
+        AES::decrypt(ct, BLOCK_SIZE, pt, BLOCK_SIZE);
+    }
+    return true;
+}
+
+
 //----------------------------------------------------------------------------
 // Constructor
 //----------------------------------------------------------------------------
 
 ts::AES::AES() :
-    _Nr(0)
+    _Nr(0),
+    _eK(),
+    _dK(),
+    _eKB(),
+    _dKB()
 {
 }
@@ -67,10 +67,14 @@ namespace ts {
         virtual bool decrypt(const void* cipher, size_t cipher_length,
                              void* plain, size_t plain_maxsize,
                              size_t* plain_length = 0) override;
+        virtual bool encryptBlocks(const void* plain, void* cipher, size_t count) override;
+        virtual bool decryptBlocks(const void* cipher, void* plain, size_t count) override;
 
     private:
         int      _Nr;     //!< Number of rounds
         uint32_t _eK[60]; //!< Scheduled encryption keys
         uint32_t _dK[60]; //!< Scheduled decryption keys
+        uint8_t  _eKB[(MAX_ROUNDS + 1) * BLOCK_SIZE]; //!< Scheduled encryption keys as bytes, for AES instructions
+        uint8_t  _dKB[(MAX_ROUNDS + 1) * BLOCK_SIZE]; //!< Scheduled decryption keys as bytes, for AES instructions
     };
 }
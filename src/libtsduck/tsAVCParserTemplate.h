@@ -92,13 +92,29 @@ bool ts::AVCParser::expColomb (INT& val)
 {
     // See ISO/IEC 14496-10 section 9.1
     val = 0;
-    int leading_zero_bits = -1;
-    for (uint8_t b = 0; b == 0; leading_zero_bits++) {
+
+    // Count the leading zero bits, a complete byte at a time.
+    size_t leading_zero_bits = 0;
+    for (;;) {
         if (_byte >= _end) {
             return false;
         }
-        b = nextBit();
+        // Remaining bits of the current byte, starting at the MSB.
+        const uint8_t rest = uint8_t(*_byte << _bit);
+        if (rest != 0) {
+            // Skip the zero bits and the following '1' bit.
+            const size_t zeros = CountLeadingZeros(uint64_t(rest) << 56);
+            leading_zero_bits += zeros;
+            _bit += zeros + 1;
+            if (_bit > 7) {
+                nextByte();
+            }
+            break;
+        }
+        leading_zero_bits += 8 - _bit;
+        nextByte();
     }
+
     if (!readBits (val, leading_zero_bits)) {
         return false;
     }
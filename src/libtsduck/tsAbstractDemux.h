@@ -79,6 +79,16 @@ namespace ts {
         //!
         virtual void removePID(PID pid);
 
+        //!
+        //! Check if a PID is filtered.
+        //! @param [in] pid The PID to check.
+        //! @return True if @a pid is filtered.
+        //!
+        bool hasPID(PID pid) const
+        {
+            return _pid_filter.test(pid);
+        }
+
         //!
         //! Get the current number of PID's being filtered.
         //! @return The current number of PID's being filtered.
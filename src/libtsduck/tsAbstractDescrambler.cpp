@@ -33,10 +33,12 @@
 
 #include "tsAbstractDescrambler.h"
 #include "tsGuardCondition.h"
+#include "tsSHA1.h"
 TSDUCK_SOURCE;
 
 #define ECM_THREAD_STACK_OVERHEAD (16  * 1024)  // Stack usage in this module
 #define ECM_THREAD_STACK_USAGE    (128 * 1024)  // Default stack usage for CAS
+#define ECM_CACHE_SIZE            16            // Default size of deciphered ECM cache
 
 
 //----------------------------------------------------------------------------
@@ -56,16 +58,57 @@ ts::AbstractDescrambler::AbstractDescrambler(TSP* tsp_,
     _iv(),
     _service(),
     _stack_usage(ECM_THREAD_STACK_USAGE),
+    _ecm_thread_count(1),
+    _ecm_cache_size(ECM_CACHE_SIZE),
+    _ecm_threads(),
     _demux(this),
     _ecm_streams(),
     _scrambled_streams(),
     _mutex(),
     _ecm_to_do(),
-    _stop_thread(false)
+    _batching(false),
+    _batch(false),
+    _stop_thread(false),
+    _ecm_cache(),
+    _ecm_cache_clock(0)
 {
 }
 
 
+//----------------------------------------------------------------------------
+// Destructor
+//----------------------------------------------------------------------------
+
+ts::AbstractDescrambler::~AbstractDescrambler()
+{
+    // Normally, the threads are already terminated by stop().
+    if (!_ecm_threads.empty()) {
+        stop();
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// ECM deciphering thread.
+//----------------------------------------------------------------------------
+
+ts::AbstractDescrambler::ECMThread::ECMThread(AbstractDescrambler* parent, const ThreadAttributes& attributes) :
+    Thread(attributes),
+    _parent(parent)
+{
+}
+
+ts::AbstractDescrambler::ECMThread::~ECMThread()
+{
+    waitForTermination();
+}
+
+void ts::AbstractDescrambler::ECMThread::main()
+{
+    _parent->processECMLoop();
+}
+
+
 //----------------------------------------------------------------------------
 // Get the ECM stream for a PID, create it if non existent
 //----------------------------------------------------------------------------
@@ -103,20 +146,29 @@ bool ts::AbstractDescrambler::startDescrambler(bool           synchronous,
     _abort = false;
     _ecm_streams.clear();
     _scrambled_streams.clear();
+    _ecm_cache.clear();
+    _ecm_cache_clock = 0;
 
     // Initialize the section demux.
     // If the service is known by name, filter the SDT, otherwise filter the PAT.
     _demux.reset();
     _demux.addPID(PID(_service.hasName() ? PID_SDT : PID_PAT));
 
-    // In asynchronous mode, create a thread for ECM processing
+    // In asynchronous mode, create the threads for ECM processing
     if (!_synchronous) {
         _stop_thread = false;
         ThreadAttributes attr;
-        Thread::getAttributes(attr);
         attr.setStackSize(ECM_THREAD_STACK_OVERHEAD + _stack_usage);
-        Thread::setAttributes(attr);
-        Thread::start();
+        _ecm_threads.clear();
+        for (size_t i = 0; i < _ecm_thread_count; ++i) {
+            ECMThreadPtr thread(new ECMThread(this, attr));
+            _ecm_threads.push_back(thread);
+            if (!thread->start()) {
+                tsp->error(u"cannot start ECM processing thread");
+                stop();
+                return false;
+            }
+        }
     }
 
     return true;
@@ -129,15 +181,19 @@ bool ts::AbstractDescrambler::startDescrambler(bool           synchronous,
 
 bool ts::AbstractDescrambler::stop()
 {
-    // In asynchronous mode, notify the ECM processing thread to terminate
-    // and wait for its actual termination.
-    if (!_synchronous) {
+    // In asynchronous mode, notify the ECM processing threads to terminate
+    // and wait for their actual termination. Each terminating thread wakes
+    // up the next one.
+    if (!_synchronous && !_ecm_threads.empty()) {
         {
             GuardCondition lock(_mutex, _ecm_to_do);
             _stop_thread = true;
             lock.signal();
         }
-        Thread::waitForTermination();
+        for (ECMThreadVector::iterator it = _ecm_threads.begin(); it != _ecm_threads.end(); ++it) {
+            (*it)->waitForTermination();
+        }
+        _ecm_threads.clear();
     }
 
     return true;
@@ -418,6 +474,7 @@ void ts::AbstractDescrambler::processECM(ECMStream& estream)
     assert(estream.ecm_size <= sizeof(ecm));
     ::memcpy(ecm, estream.ecm, estream.ecm_size);  // Flawfinder: ignore: memcpy()
     estream.new_ecm = false;
+    estream.in_progress = true;
 
     // In asynchronous mode, release the mutex.
 
@@ -430,17 +487,34 @@ void ts::AbstractDescrambler::processECM(ECMStream& estream)
     tsp->debug(u"packet %d, decipher ECM, %d bytes: %X %X %X %X %X %X %X %X ...",
                {_packet_count - 1, ecm_size, ecm[0], ecm[1], ecm[2], ecm[3], ecm[4], ecm[5], ecm[6], ecm[7]});
 
-    // Submit the ECM to the CAS (subclass)
+    // Submit the ECM to the CAS (subclass), unless it was recently deciphered.
 
     uint8_t cw_even[CW_BYTES];
     uint8_t cw_odd[CW_BYTES];
-    bool ok = decipherECM(ecm, ecm_size, cw_even, cw_odd);
+    ByteBlock ecm_hash;
+    const bool cached = getCachedECM(ecm, ecm_size, ecm_hash, cw_even, cw_odd);
+    bool ok = cached;
+
+    if (cached) {
+        tsp->debug(u"ECM found in cache of deciphered ECM's");
+    }
+    else {
+        ok = decipherECM(ecm, ecm_size, cw_even, cw_odd);
+    }
+
+    // Precompute the DVB-CSA key schedules outside the protected area.
+    Scrambling key_even;
+    Scrambling key_odd;
 
     if (ok) {
         tsp->debug(u"even CW: %X %X %X %X %X %X %X %X",
                    {cw_even[0], cw_even[1], cw_even[2], cw_even[3], cw_even[4], cw_even[5], cw_even[6], cw_even[7]});
         tsp->debug(u"odd CW:  %X %X %X %X %X %X %X %X",
                    {cw_odd[0], cw_odd[1], cw_odd[2], cw_odd[3], cw_odd[4], cw_odd[5], cw_odd[6], cw_odd[7]});
+        if (!_aes128_dvs042) {
+            key_even.init(cw_even, _cw_mode);
+            key_odd.init(cw_odd, _cw_mode);
+        }
     }
 
     // In asynchronous mode, relock the mutex.
@@ -453,36 +527,137 @@ void ts::AbstractDescrambler::processECM(ECMStream& estream)
     // Normally, only one CW is modified for each new ECM.
     // Compare extracted CW with previous ones to avoid signaling a new
     // CW when it is actually unchanged.
+    //
+    // With DVB-CSA, in synchronous mode, we are in the packet processing
+    // thread and the new key schedule is immediately installed. In asynchronous
+    // mode, the packet processing thread installs the precomputed key schedule
+    // on the next packet with the corresponding parity.
 
     if (ok) {
         if (!estream.cw_valid || ::memcmp(estream.cw_even, cw_even, CW_BYTES) != 0) {
             // Previous even CW was either invalid or different from new one
-            estream.new_cw_even = true;
             ::memcpy(estream.cw_even, cw_even, CW_BYTES);  // Flawfinder: ignore: memcpy()
+            if (_aes128_dvs042) {
+                estream.new_cw_even = true;
+            }
+            else if (_synchronous) {
+                // Pending payloads may still use the previous key.
+                _batch.flush();
+                estream.key_even = key_even;
+            }
+            else {
+                estream.next_even = key_even;
+                estream.new_cw_even = true;
+            }
         }
         if (!estream.cw_valid || ::memcmp(estream.cw_odd, cw_odd, CW_BYTES) != 0) {
             // Previous odd CW was either invalid or different from new one
-            estream.new_cw_odd = true;
             ::memcpy(estream.cw_odd, cw_odd, CW_BYTES);  // Flawfinder: ignore: memcpy()
+            if (_aes128_dvs042) {
+                estream.new_cw_odd = true;
+            }
+            else if (_synchronous) {
+                _batch.flush();
+                estream.key_odd = key_odd;
+            }
+            else {
+                estream.next_odd = key_odd;
+                estream.new_cw_odd = true;
+            }
         }
     }
 
+    if (ok && !cached) {
+        storeCachedECM(ecm_hash, cw_even, cw_odd);
+    }
+
     estream.cw_valid = ok;
+    estream.in_progress = false;
+}
+
+
+//----------------------------------------------------------------------------
+// Look for an ECM in the cache of deciphered ECM's.
+//----------------------------------------------------------------------------
+
+bool ts::AbstractDescrambler::getCachedECM(const uint8_t* ecm, size_t ecm_size, ByteBlock& hash, uint8_t* cw_even, uint8_t* cw_odd)
+{
+    if (_ecm_cache_size == 0) {
+        hash.clear();
+        return false;
+    }
+
+    // Compute the hash of the ECM outside the protected area.
+    SHA1 sha;
+    hash.resize(SHA1::HASH_SIZE);
+    if (!sha.hash(ecm, ecm_size, hash.data(), hash.size())) {
+        hash.clear();
+        return false;
+    }
+
+    // In asynchronous mode, the cache is accessed under mutex protection.
+    if (!_synchronous) {
+        _mutex.acquire();
+    }
+
+    const ECMCache::iterator it = _ecm_cache.find(hash);
+    const bool found = it != _ecm_cache.end();
+    if (found) {
+        ::memcpy(cw_even, it->second.cw_even, CW_BYTES);  // Flawfinder: ignore: memcpy()
+        ::memcpy(cw_odd, it->second.cw_odd, CW_BYTES);    // Flawfinder: ignore: memcpy()
+        it->second.last_use = ++_ecm_cache_clock;
+    }
+
+    if (!_synchronous) {
+        _mutex.release();
+    }
+    return found;
+}
+
+
+//----------------------------------------------------------------------------
+// Store deciphered CW's in the cache.
+//----------------------------------------------------------------------------
+
+void ts::AbstractDescrambler::storeCachedECM(const ByteBlock& hash, const uint8_t* cw_even, const uint8_t* cw_odd)
+{
+    if (_ecm_cache_size == 0 || hash.empty()) {
+        return;
+    }
+
+    // Evict the least recently used entry when the cache is full.
+    if (_ecm_cache.size() >= _ecm_cache_size && _ecm_cache.find(hash) == _ecm_cache.end()) {
+        ECMCache::iterator oldest = _ecm_cache.begin();
+        for (ECMCache::iterator it = _ecm_cache.begin(); it != _ecm_cache.end(); ++it) {
+            if (it->second.last_use < oldest->second.last_use) {
+                oldest = it;
+            }
+        }
+        _ecm_cache.erase(oldest);
+    }
+
+    ECMCacheEntry& entry(_ecm_cache[hash]);
+    ::memcpy(entry.cw_even, cw_even, CW_BYTES);  // Flawfinder: ignore: memcpy()
+    ::memcpy(entry.cw_odd, cw_odd, CW_BYTES);    // Flawfinder: ignore: memcpy()
+    entry.last_use = ++_ecm_cache_clock;
 }
 
 
 //----------------------------------------------------------------------------
-// ECM deciphering thread
+// ECM processing loop, executed by all ECM deciphering threads.
 //----------------------------------------------------------------------------
 
-void ts::AbstractDescrambler::main()
+void ts::AbstractDescrambler::processECMLoop()
 {
     tsp->debug(u"ECM processing thread started");
 
     // ECM processing loop.
     // The loop executes with the mutex held. The mutex is released
     // while deciphering an ECM and while waiting for the condition
-    // variable 'ecm_to_do'.
+    // variable 'ecm_to_do'. An ECM stream which is currently processed
+    // by another thread is skipped, so that the ECM's of one ECM PID
+    // are deciphered in sequence. When that thread completes, it scans
+    // the ECM streams again and finds the new ECM.
 
     GuardCondition lock(_mutex, _ecm_to_do);
 
@@ -503,11 +678,15 @@ void ts::AbstractDescrambler::main()
             // Decipher ECM's on all ECM PID's.
             for (ECMStreamMap::iterator it = _ecm_streams.begin(); !terminate && it != _ecm_streams.end(); ++it) {
                 ECMStreamPtr& estream(it->second);
-                if (estream->new_ecm) {
+                if (estream->new_ecm && !estream->in_progress) {
 
                     // Found an ECM, decipher it. Note that the mutex is
-                    // released while deciphering the ECM.
+                    // released while deciphering the ECM. Wake up another
+                    // thread which may process ECM's from other PID's.
                     got_ecm = true;
+                    if (_ecm_threads.size() > 1) {
+                        lock.signal();
+                    }
                     processECM(*estream);
 
                     // Look for termination request while deciphering
@@ -529,10 +708,28 @@ void ts::AbstractDescrambler::main()
         lock.waitCondition();
     }
 
+    // Wake up the next thread to terminate.
+    lock.signal();
+
     tsp->debug(u"ECM processing thread terminated");
 }
 
 
+//----------------------------------------------------------------------------
+// Batch packet processing method: DVB-CSA payloads are descrambled in
+// parallel, using the bitsliced implementation of the stream cipher.
+//----------------------------------------------------------------------------
+
+size_t ts::AbstractDescrambler::processPacketBatch(const TSPacketView& pkts, TSPacketMetadata* mdata, size_t count, Status* status, bool& flush, bool& bitrate_changed)
+{
+    _batching = true;
+    const size_t result = ProcessorPlugin::processPacketBatch(pkts, mdata, count, status, flush, bitrate_changed);
+    _batch.flush();
+    _batching = false;
+    return result;
+}
+
+
 //----------------------------------------------------------------------------
 // Packet processing method
 //----------------------------------------------------------------------------
@@ -588,7 +785,8 @@ ts::ProcessorPlugin::Status ts::AbstractDescrambler::processPacket(TSPacket& pkt
     // We found a valid CW, check if new CW were deciphered
     if ((scv == SC_EVEN_KEY && pecm->new_cw_even) || (scv == SC_ODD_KEY && pecm->new_cw_odd)) {
 
-        // A new CW was deciphered. Convert it into a DVB-CSA key context.
+        // A new CW was deciphered. Install its precomputed DVB-CSA key context
+        // (asynchronous mode only) or the AES key.
         // In asynchronous mode, the CW are accessed under mutex protection.
 
         if (!_synchronous) {
@@ -613,11 +811,14 @@ ts::ProcessorPlugin::Status ts::AbstractDescrambler::processPacket(TSPacket& pkt
             pecm->new_cw_odd = false;
         }
         else if (scv == SC_EVEN_KEY) {
-            pecm->key_even.init(pecm->cw_even, _cw_mode);
+            // Pending payloads may still use the previous key.
+            _batch.flush();
+            pecm->key_even = pecm->next_even;
             pecm->new_cw_even = false;
         }
         else {
-            pecm->key_odd.init(pecm->cw_odd, _cw_mode);
+            _batch.flush();
+            pecm->key_odd = pecm->next_odd;
             pecm->new_cw_odd = false;
         }
 
@@ -640,7 +841,12 @@ ts::ProcessorPlugin::Status ts::AbstractDescrambler::processPacket(TSPacket& pkt
     }
     else {
         Scrambling& scr(scv == SC_EVEN_KEY ? pecm->key_even : pecm->key_odd);
-        scr.decrypt(pl, pl_size);
+        if (_batching) {
+            _batch.add(scr, pl, pl_size);
+        }
+        else {
+            scr.decrypt(pl, pl_size);
+        }
 
         // Trace CW change in PIDs
         if (scv != ss.last_scv) {
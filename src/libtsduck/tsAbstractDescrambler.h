@@ -37,6 +37,7 @@
 #include "tsSafePtr.h"
 #include "tsService.h"
 #include "tsScrambling.h"
+#include "tsScramblingBatch.h"
 #include "tsSectionDemux.h"
 #include "tsCondition.h"
 #include "tsMutex.h"
@@ -55,8 +56,7 @@ namespace ts {
     //!
     class TSDUCKDLL AbstractDescrambler:
         public ProcessorPlugin,
-        protected TableHandlerInterface,
-        private Thread
+        protected TableHandlerInterface
     {
     public:
         //!
@@ -71,11 +71,17 @@ namespace ts {
                             const UString& syntax = UString(),
                             const UString& help = UString());
 
+        //!
+        //! Destructor.
+        //!
+        virtual ~AbstractDescrambler();
+
         // Implementation of ProcessorPlugin interface.
         // If overridden by descrambler subclass, superclass must be explicitly invoked.
         virtual bool stop() override;
         virtual BitRate getBitrate() override {return 0;}
         virtual Status processPacket(TSPacket&, bool&, bool&) override;
+        virtual size_t processPacketBatch(const TSPacketView&, TSPacketMetadata*, size_t, Status*, bool&, bool&) override;
 
     protected:
         //!
@@ -97,6 +103,24 @@ namespace ts {
         //!
         void setIV(const ByteBlock& iv) {_iv = iv;}
 
+        //!
+        //! Set the number of ECM deciphering threads in asynchronous mode.
+        //! ECM's from distinct ECM PID's are deciphered in parallel. ECM's from
+        //! the same ECM PID are always deciphered in sequence, in their order of arrival.
+        //! Must be invoked before startDescrambler().
+        //! @param [in] count Number of ECM deciphering threads (default: 1).
+        //!
+        void setECMThreads(size_t count) {_ecm_thread_count = count > 0 ? count : 1;}
+
+        //!
+        //! Set the size of the cache of deciphered ECM's.
+        //! When an ECM is found in the cache, decipherECM() is not invoked and
+        //! the control words from the previous deciphering are reused.
+        //! Must be invoked before startDescrambler().
+        //! @param [in] size Maximum number of ECM's in the cache (0 disables the cache).
+        //!
+        void setECMCacheSize(size_t size) {_ecm_cache_size = size;}
+
         //!
         //! Start the abstract descrambler.
         //! Should be invoked from the plugin's start() method.
@@ -137,6 +161,8 @@ namespace ts {
         //!
         //! Decipher an ECM, return the two control words.
         //! Must be implemented by subclasses (concrete descramblers).
+        //! In asynchronous mode with several ECM threads, smartcard-based descramblers
+        //! may share their smartcards between threads using a ts::pcsc::SmartCardService.
         //! @param [in] ecm Address of the CMT section payload, without section header.
         //! @param [in] ecm_size Size in bytes of the CMT section payload, without section header.
         //! @param [out] cw_even Address of output buffer for the even CW. The buffer size must be at least ts::CW_BYTES.
@@ -157,6 +183,31 @@ namespace ts {
         typedef std::map <PID, ScrambledStream> ScrambledStreamMap;
         typedef std::map <PID, ECMStreamPtr> ECMStreamMap;
 
+        // ECM deciphering thread, runs the ECM processing loop of the descrambler.
+        class ECMThread: public Thread
+        {
+        public:
+            ECMThread(AbstractDescrambler* parent, const ThreadAttributes& attributes);
+            virtual ~ECMThread();
+        private:
+            AbstractDescrambler* _parent;
+            virtual void main() override;
+            ECMThread() = delete;
+            ECMThread(const ECMThread&) = delete;
+            ECMThread& operator=(const ECMThread&) = delete;
+        };
+        typedef SafePtr <ECMThread, NullMutex> ECMThreadPtr;
+        typedef std::vector <ECMThreadPtr> ECMThreadVector;
+
+        // Entry in the cache of deciphered ECM's, indexed by SHA-1 hash of the ECM.
+        struct ECMCacheEntry
+        {
+            uint8_t  cw_even[CW_BYTES];  // Even CW
+            uint8_t  cw_odd[CW_BYTES];   // Odd CW
+            uint64_t last_use;           // Value of _ecm_cache_clock at last use
+        };
+        typedef std::map <ByteBlock, ECMCacheEntry> ECMCache;
+
         // Abstract descrambler private data
         Scrambling::EntropyMode _cw_mode;
         PacketCounter      _packet_count;      // Packet counter in TS
@@ -166,13 +217,20 @@ namespace ts {
         ByteBlock          _iv;                // Initialization vector if chained mode (not DVB-CSA)
         Service            _service;           // Service to descramble (by name, id or none)
         size_t             _stack_usage;       // Stack usage for ECM deciphering
+        size_t             _ecm_thread_count;  // Number of ECM deciphering threads
+        size_t             _ecm_cache_size;    // Max number of entries in _ecm_cache
+        ECMThreadVector    _ecm_threads;       // ECM deciphering threads
         SectionDemux       _demux;             // Section demux
         ECMStreamMap       _ecm_streams;       // ECM streams, indexed by PID
         ScrambledStreamMap _scrambled_streams; // ECM streams, indexed by PID
         Mutex              _mutex;             // Exclusive access to protected areas
         Condition          _ecm_to_do;         // Notify thread to process ECM
+        bool               _batching;          // Inside processPacketBatch(), DVB-CSA payloads are batched
+        ScramblingBatch    _batch;             // Pending DVB-CSA payloads to descramble
         // -- start of protected area --
-        bool               _stop_thread;       // Terminate ECM processing thread
+        bool               _stop_thread;       // Terminate ECM processing threads
+        ECMCache           _ecm_cache;         // Recently deciphered ECM's
+        uint64_t           _ecm_cache_clock;   // Incremented at each cache access
 
         // Description of a scrambled stream
         struct ScrambledStream
@@ -196,7 +254,10 @@ namespace ts {
             volatile bool new_cw_even;         // New CW available (even)
             volatile bool new_cw_odd;          // New CW available (odd)
             // -- start of protected area --
+            Scrambling  next_even;             // DVB-CSA preprocessed new CW (even), asynchronous mode
+            Scrambling  next_odd;              // DVB-CSA preprocessed new CW (odd), asynchronous mode
             bool    new_ecm;                   // New ECM available
+            bool    in_progress;               // An ECM from this stream is being deciphered
             size_t  ecm_size;                  // Used size in ECM
             uint8_t ecm[MAX_PSI_SECTION_SIZE]; // Last received ECM
             uint8_t cw_even[CW_BYTES];         // Last valid CW (even)
@@ -211,7 +272,10 @@ namespace ts {
                 cw_valid (false),
                 new_cw_even (false),
                 new_cw_odd (false),
+                next_even (),
+                next_odd (),
                 new_ecm (false),
+                in_progress (false),
                 ecm_size (0)
             {
                 TS_ZERO (ecm);
@@ -228,11 +292,18 @@ namespace ts {
         // releases the mutex while deciphering the ECM and relocks it before exiting.
         void processECM (ECMStream&);
 
+        // Look for an ECM in the cache of deciphered ECM's, compute the ECM hash.
+        // In asynchronous mode, this method must be invoked without the mutex held.
+        bool getCachedECM (const uint8_t* ecm, size_t ecm_size, ByteBlock& hash, uint8_t* cw_even, uint8_t* cw_odd);
+
+        // Store deciphered CW's in the cache. In asynchronous mode, the mutex must be held.
+        void storeCachedECM (const ByteBlock& hash, const uint8_t* cw_even, const uint8_t* cw_odd);
+
         // Analyze a list of descriptors, looking for ECM PID's
         void analyzeCADescriptors (const DescriptorList& dlist, std::set<PID>& ecm_pids);
 
-        // ECM deciphering thread
-        virtual void main() override;
+        // ECM processing loop, executed by all ECM deciphering threads.
+        void processECMLoop ();
 
         // Process specific tables
         void processPAT (const PAT&);
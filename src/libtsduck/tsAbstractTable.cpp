@@ -28,6 +28,7 @@
 //----------------------------------------------------------------------------
 
 #include "tsAbstractTable.h"
+#include "tsBinaryTable.h"
 TSDUCK_SOURCE;
 
 
@@ -40,3 +41,18 @@ ts::AbstractTable::AbstractTable(TID tid, const UChar* xml_name) :
     _table_id(tid)
 {
 }
+
+
+//----------------------------------------------------------------------------
+// Write the table as fields of a compact JSON object.
+//----------------------------------------------------------------------------
+
+bool ts::AbstractTable::toJSON(json::Writer& writer, const DVBCharset* charset) const
+{
+    if (!isValid()) {
+        return false;
+    }
+    BinaryTable bin;
+    serialize(bin, charset);
+    return bin.toJSON(writer);
+}
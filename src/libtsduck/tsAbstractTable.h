@@ -43,6 +43,10 @@ namespace ts {
     class TablesDisplay;
     class DVBCharset;
 
+    namespace json {
+        class Writer;
+    }
+
     //!
     //! Abstract base class for MPEG PSI/SI tables.
     //!
@@ -72,6 +76,17 @@ namespace ts {
         //!
         virtual void deserialize(const BinaryTable& bin, const DVBCharset* charset = 0) = 0;
 
+        //!
+        //! Write the table as fields of a compact JSON object.
+        //! The table is serialized and the binary sections are written in hexadecimal.
+        //! @param [in,out] writer A JSON writer. A JSON object shall be open in the writer.
+        //! The JSON object is not closed, the application may add other fields.
+        //! @param [in] charset If not zero, default character set to use.
+        //! @return True on success, false if the table is not valid.
+        //! @see BinaryTable::toJSON()
+        //!
+        bool toJSON(json::Writer& writer, const DVBCharset* charset = 0) const;
+
         //!
         //! Virtual destructor
         //!
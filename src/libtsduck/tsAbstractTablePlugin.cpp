@@ -0,0 +1,203 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//
+//  Abstract base class for plugins which modify PSI/SI tables.
+//
+//----------------------------------------------------------------------------
+
+#include "tsAbstractTablePlugin.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// Constructor
+//----------------------------------------------------------------------------
+
+ts::AbstractTablePlugin::AbstractTablePlugin(TSP* tsp_, const UString& description, const UString& syntax, const UString& table_name) :
+    ProcessorPlugin(tsp_, description, syntax),
+    _table_name(table_name),
+    _abort(false),
+    _pid(PID_NULL),
+    _incr_version(false),
+    _set_version(false),
+    _new_version(0),
+    _demux(this),
+    _pzer(),
+    _outputs()
+{
+    option(u"increment-version", 'i');
+    option(u"new-version",       'v', INTEGER, 0, 1, 0, 31);
+}
+
+
+//----------------------------------------------------------------------------
+// Start the table processing.
+//----------------------------------------------------------------------------
+
+void ts::AbstractTablePlugin::startTables(PID pid, const PIDSet& pids, bool shared)
+{
+    // Get common option values
+    _incr_version = present(u"increment-version");
+    _set_version = present(u"new-version");
+    _new_version = intValue<uint8_t>(u"new-version", 0);
+
+    // Initialize the demux and packetizer.
+    // Use the shared signalization of tsp when available and allowed.
+    _abort = false;
+    _pid = pid;
+    _outputs.clear();
+    _demux.reset();
+    if (!shared || !tsp->subscribeSignalization(this, pids)) {
+        _demux.setPIDFilter(pids);
+    }
+    _pzer.reset();
+    _pzer.setPID(pid);
+}
+
+
+//----------------------------------------------------------------------------
+// Set the PID of the modified tables, when discovered later.
+//----------------------------------------------------------------------------
+
+void ts::AbstractTablePlugin::setTablePID(PID pid)
+{
+    _pid = pid;
+    _demux.addPID(pid);
+    _pzer.setPID(pid);
+}
+
+
+//----------------------------------------------------------------------------
+// Compute the key which identifies a table instance.
+//----------------------------------------------------------------------------
+
+uint32_t ts::AbstractTablePlugin::TableKey(TID tid, uint16_t tid_ext)
+{
+    // The PAT and CAT are unique in a TS, their table id extension does not identify an instance.
+    return tid == TID_PAT || tid == TID_CAT ? uint32_t(tid) << 16 : (uint32_t(tid) << 16) | tid_ext;
+}
+
+
+//----------------------------------------------------------------------------
+// Remove from the packetizer all sections of a table instance.
+//----------------------------------------------------------------------------
+
+void ts::AbstractTablePlugin::removeTable(uint32_t key)
+{
+    const TID tid = TID(key >> 16);
+    if (tid == TID_PAT || tid == TID_CAT) {
+        _pzer.removeSections(tid);
+    }
+    else {
+        _pzer.removeSections(tid, uint16_t(key & 0xFFFF));
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Invoked by the demux when a complete table is available.
+//----------------------------------------------------------------------------
+
+void ts::AbstractTablePlugin::handleTable(SectionDemux& demux, const BinaryTable& table)
+{
+    if (_pid != PID_NULL && table.sourcePID() == _pid) {
+        processTable(table);
+    }
+    else {
+        handleOtherTable(table);
+    }
+}
+
+void ts::AbstractTablePlugin::handleOtherTable(const BinaryTable& table)
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Process a new table for the modified PID.
+//----------------------------------------------------------------------------
+
+void ts::AbstractTablePlugin::processTable(const BinaryTable& table)
+{
+    if (!table.isValid()) {
+        return;
+    }
+
+    // Let the subclass modify a private copy of the binary sections.
+    BinaryTable out(table, COPY);
+    bool is_target = true;
+    bool reinsert = true;
+    modifyTable(out, is_target, reinsert);
+    if (!reinsert || !out.isValid()) {
+        return;
+    }
+
+    // Apply the common edits directly on the binary sections.
+    if (is_target) {
+        if (_incr_version) {
+            out.setVersion((out.version() + 1) & SVERSION_MASK);
+        }
+        else if (_set_version) {
+            out.setVersion(_new_version);
+        }
+        tsp->verbose(u"%s version %d modified", {_table_name, out.version()});
+    }
+
+    // Replace the previous output of the same input table in the packetizer.
+    const uint32_t in_key = TableKey(table.tableId(), table.tableIdExtension());
+    const uint32_t out_key = TableKey(out.tableId(), out.tableIdExtension());
+    const std::map<uint32_t, uint32_t>::const_iterator prev = _outputs.find(in_key);
+    if (prev != _outputs.end() && prev->second != out_key) {
+        removeTable(prev->second);
+    }
+    removeTable(out_key);
+    _pzer.addTable(out);
+    _outputs[in_key] = out_key;
+}
+
+
+//----------------------------------------------------------------------------
+// Packet processing method
+//----------------------------------------------------------------------------
+
+ts::ProcessorPlugin::Status ts::AbstractTablePlugin::processPacket(TSPacket& pkt, bool& flush, bool& bitrate_changed)
+{
+    // Filter interesting sections
+    _demux.feedPacket(pkt);
+
+    // If a fatal error occured during section analysis, give up.
+    if (_abort) {
+        return TSP_END;
+    }
+
+    // Replace packets using packetizer
+    if (_pid != PID_NULL && pkt.getPID() == _pid) {
+        _pzer.getNextPacket(pkt);
+    }
+    return TSP_OK;
+}
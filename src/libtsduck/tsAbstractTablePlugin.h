@@ -0,0 +1,183 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Abstract base class for plugins which modify PSI/SI tables.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsPlugin.h"
+#include "tsSectionDemux.h"
+#include "tsCyclingPacketizer.h"
+
+namespace ts {
+
+    //!
+    //! Abstract base class for plugins which modify PSI/SI tables (PAT, PMT, SDT, NIT, BAT, CAT).
+    //!
+    //! This class implements the common processing of all table-editing plugins:
+    //! demux the tables, apply the edits, keep the modified sections pre-packetized
+    //! and replace the packets of the table PID.
+    //!
+    //! Each new input table is deep-copied in binary form and passed to modifyTable().
+    //! A subclass deserializes the table only when it has structural edits to apply.
+    //! Simple header edits such as a new table id extension are directly applied on the
+    //! binary sections. The common options --increment-version and --new-version
+    //! are always applied in binary form by this class, after modifyTable().
+    //!
+    //! Since the demux reports a table only when its version changes, the edits are applied
+    //! once per input version. In between, the output packets are generated from the
+    //! pre-packetized modified sections, without any further processing.
+    //!
+    class TSDUCKDLL AbstractTablePlugin:
+        public ProcessorPlugin,
+        protected TableHandlerInterface
+    {
+    public:
+        //!
+        //! Constructor.
+        //! The options --increment-version (-i) and --new-version (-v) are declared here.
+        //! A subclass may redefine the short option names after invoking this constructor.
+        //! @param [in] tsp Object to communicate with the Transport Stream Processor main executable.
+        //! @param [in] description A short one-line description, eg. "Wonderful plugin".
+        //! @param [in] syntax A short one-line syntax summary, eg. "[options] filename ...".
+        //! @param [in] table_name Name of the modified table, eg. "PAT", for messages.
+        //!
+        AbstractTablePlugin(TSP* tsp,
+                            const UString& description,
+                            const UString& syntax,
+                            const UString& table_name);
+
+        // Implementation of ProcessorPlugin interface.
+        // If overridden by a subclass, superclass must be explicitly invoked.
+        virtual Status processPacket(TSPacket&, bool&, bool&) override;
+
+    protected:
+        //!
+        //! Start the table processing.
+        //! Must be invoked from the plugin's start() method.
+        //! @param [in] pid PID of the modified tables or PID_NULL if not yet known (see setPID()).
+        //! @param [in] pids Set of PID's to demux. Tables from other PID's than @a pid
+        //! are passed to handleOtherTable().
+        //! @param [in] shared If true, try to use the shared signalization of tsp.
+        //! Must be false if the set of demuxed PID's is later modified using addDemuxPID()
+        //! or removeDemuxPID().
+        //!
+        void startTables(PID pid, const PIDSet& pids, bool shared);
+
+        //!
+        //! Get the PID of the modified tables.
+        //! @return The PID of the modified tables or PID_NULL if not yet known.
+        //!
+        PID tablePID() const {return _pid;}
+
+        //!
+        //! Set the PID of the modified tables, when discovered later.
+        //! The PID is added in the private demux.
+        //! @param [in] pid PID of the modified tables.
+        //!
+        void setTablePID(PID pid);
+
+        //!
+        //! Add a PID to demux in the private demux.
+        //! @param [in] pid The PID to add.
+        //!
+        void addDemuxPID(PID pid) {_demux.addPID(pid);}
+
+        //!
+        //! Remove a PID from the private demux.
+        //! @param [in] pid The PID to remove.
+        //!
+        void removeDemuxPID(PID pid) {_demux.removePID(pid);}
+
+        //!
+        //! Request the termination of the processing (the next packet returns TSP_END).
+        //!
+        void abortTables() {_abort = true;}
+
+        //!
+        //! Process a new table for the modified PID, as if it was received from the stream.
+        //! A subclass can invoke this method to insert a table which is created from scratch.
+        //! @param [in] table The input table, before modification.
+        //!
+        void processTable(const BinaryTable& table);
+
+        //!
+        //! Replace a packet with the next packet of the modified tables.
+        //! @param [out] pkt The packet to replace.
+        //!
+        void replacePacket(TSPacket& pkt) {_pzer.getNextPacket(pkt);}
+
+        //!
+        //! Modify a table from the PID of the modified tables.
+        //! Must be implemented by subclasses.
+        //! @param [in,out] table The table to modify. This is a private deep copy of the input table.
+        //! The subclass either modifies the binary sections directly or deserializes the table,
+        //! modifies it and serializes it back into @a table.
+        //! @param [in,out] is_target Initially true. Set to false by the subclass if the common
+        //! edits (version) shall not be applied to this table, eg. an SDT Other in the SDT PID.
+        //! @param [in,out] reinsert Initially true. Set to false by the subclass if the table
+        //! shall be ignored. In that case, the previous output for this table, if any, is unchanged.
+        //!
+        virtual void modifyTable(BinaryTable& table, bool& is_target, bool& reinsert) = 0;
+
+        //!
+        //! Process a table from another PID than the PID of the modified tables.
+        //! The default implementation ignores the table.
+        //! @param [in] table The table from another PID, typically used to discover the PID of the modified tables.
+        //!
+        virtual void handleOtherTable(const BinaryTable& table);
+
+        // Implementation of TableHandlerInterface.
+        virtual void handleTable(SectionDemux&, const BinaryTable&) override;
+
+    private:
+        UString           _table_name;    // Name of the modified table
+        bool              _abort;         // Error, abort asap
+        PID               _pid;           // PID of the modified tables
+        bool              _incr_version;  // Increment table version
+        bool              _set_version;   // Set a new table version
+        uint8_t           _new_version;   // New table version
+        SectionDemux      _demux;         // Private section demux
+        CyclingPacketizer _pzer;          // Packetizer for modified tables
+        std::map<uint32_t, uint32_t> _outputs;  // Key of output table, indexed by key of input table
+
+        // Compute the key which identifies a table instance (table id and table id extension).
+        static uint32_t TableKey(TID tid, uint16_t tid_ext);
+
+        // Remove from the packetizer all sections of a table instance.
+        void removeTable(uint32_t key);
+
+        // Inaccessible operations
+        AbstractTablePlugin() = delete;
+        AbstractTablePlugin(const AbstractTablePlugin&) = delete;
+        AbstractTablePlugin& operator=(const AbstractTablePlugin&) = delete;
+    };
+}
@@ -217,38 +217,62 @@ void ts::AbstractTransportListTable::addSection(BinaryTable& table,
 
 //----------------------------------------------------------------------------
 // Select a transport stream for serialization in current section.
-// If found, set ts_id, remove the ts id from the set and return true.
+// If found, set ts_id, remove the ts id from the sets and return true.
 // Otherwise, return false.
 //----------------------------------------------------------------------------
 
 bool ts::AbstractTransportListTable::getNextTransport(TransportStreamIdSet& ts_set,
+                                                      TransportStreamIdSetMap& hinted,
                                                       TransportStreamId& ts_id,
                                                       int section_number) const
 {
-    // Search one TS which should be serialized in current section
-    for (TransportStreamIdSet::const_iterator it = ts_set.begin(); it != ts_set.end(); ++it) {
-        const SectionHintsMap::const_iterator hint(section_hints.find(*it));
-        if (hint != section_hints.end() && hint->second == section_number && transports.find(*it) != transports.end()) {
-            ts_id = *it;
-            ts_set.erase(it);
-            return true;
-        }
+    // The transports with a hint for a previous section can now go in any section.
+    // Move them with the transports without hint.
+    while (!hinted.empty() && hinted.begin()->first < section_number) {
+        ts_set.insert(hinted.begin()->second.begin(), hinted.begin()->second.end());
+        hinted.erase(hinted.begin());
     }
 
-    // No transport for this section.
-    // Search one TS without section hint or with a previous section hint.
-    for (TransportStreamIdSet::const_iterator it = ts_set.begin(); it != ts_set.end(); ++it) {
-        const SectionHintsMap::const_iterator hint (section_hints.find (*it));
-        if ((hint == section_hints.end() || hint->second < section_number) && transports.find (*it) != transports.end()) {
-            ts_id = *it;
-            ts_set.erase (it);
-            return true;
-        }
+    // Search one TS which should be serialized in current section.
+    // Otherwise, use one TS without section hint or with a previous section hint.
+    TransportStreamIdSet* set = 0;
+    if (!hinted.empty() && hinted.begin()->first == section_number) {
+        set = &hinted.begin()->second;
+    }
+    else if (!ts_set.empty()) {
+        set = &ts_set;
+    }
+    else {
+        // No TS found. Either no more TS or all remaining TS have
+        // a section hint for subsequent sections.
+        return false;
     }
 
-    // No TS found. Either no more TS in ts_set or all remaining TS have
-    // a section hint for subsequent sections.
-    return false;
+    // Use the first TS in the selected set, in TS id order.
+    ts_id = *set->begin();
+    set->erase(set->begin());
+    if (set->empty() && set != &ts_set) {
+        hinted.erase(hinted.begin());
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Push back a transport stream which was selected but not serialized.
+//----------------------------------------------------------------------------
+
+void ts::AbstractTransportListTable::pushBackTransport(TransportStreamIdSet& ts_set,
+                                                       TransportStreamIdSetMap& hinted,
+                                                       const TransportStreamId& ts_id) const
+{
+    const SectionHintsMap::const_iterator hint(section_hints.find(ts_id));
+    if (hint == section_hints.end()) {
+        ts_set.insert(ts_id);
+    }
+    else {
+        hinted[hint->second].insert(ts_id);
+    }
 }
 
 
@@ -266,10 +290,13 @@ void ts::AbstractTransportListTable::serialize(BinaryTable& table, const DVBChar
         return;
     }
 
-    // Build a set of TS id to serialize.
+    // Build the sets of TS id to serialize, without and with section hint.
+    // The transports are selected from these sets in constant time, which matters
+    // in large NIT or BAT with thousands of transports.
     TransportStreamIdSet ts_set;
+    TransportStreamIdSetMap hinted;
     for (TransportMap::const_iterator it = transports.begin(); it != transports.end(); ++it) {
-        ts_set.insert(it->first);
+        pushBackTransport(ts_set, hinted, it->first);
     }
 
     // Build the sections
@@ -313,7 +340,7 @@ void ts::AbstractTransportListTable::serialize(BinaryTable& table, const DVBChar
     remain -= 2;
 
     // Add all transports
-    while (!ts_set.empty()) {
+    while (!ts_set.empty() || !hinted.empty()) {
 
         // If we cannot at least add the fixed part of a transport, open a new section
         if (remain < 6) {
@@ -323,7 +350,7 @@ void ts::AbstractTransportListTable::serialize(BinaryTable& table, const DVBChar
 
         // Get a TS to serialize in current section
         TransportStreamId ts_id;
-        while (!getNextTransport (ts_set, ts_id, section_number)) {
+        while (!getNextTransport(ts_set, hinted, ts_id, section_number)) {
             // No transport found for this section, close it and starts a new one.
             addSection (table, section_number, payload, tsll_addr, data, remain);
         }
@@ -339,8 +366,8 @@ void ts::AbstractTransportListTable::serialize(BinaryTable& table, const DVBChar
         // one section, even when starting at the beginning of the transport loop.
         // In that case, the transport description will span two sections later.
         if (data > tsll_addr + 2 && 6 + dlist.binarySize() > remain) {
-            // Push back the transport in the set
-            ts_set.insert (ts_id);
+            // Push back the transport in the sets
+            pushBackTransport(ts_set, hinted, ts_id);
             // Create a new section
             addSection (table, section_number, payload, tsll_addr, data, remain);
             // Loop back since the section number has changed and a new transport may be better
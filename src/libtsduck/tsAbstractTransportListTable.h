@@ -97,6 +97,7 @@ namespace ts {
 
     private:
         typedef std::set <TransportStreamId> TransportStreamIdSet;
+        typedef std::map <int, TransportStreamIdSet> TransportStreamIdSetMap;
 
         // Add a new section to a table being serialized.
         // Session number is incremented. Data and remain are reinitialized.
@@ -115,8 +116,13 @@ namespace ts {
                         size_t& remain) const;
 
         // Select a transport stream for serialization in current section.
-        // If found, set ts_id, remove the ts id from the set and return true.
+        // The transports without hint or with a hint for a previous section are in ts_set.
+        // The transports with a hint for the current or a subsequent section are in hinted, by section.
+        // If found, set ts_id, remove the ts id from the sets and return true.
         // Otherwise, return false.
-        bool getNextTransport(TransportStreamIdSet& ts_set, TransportStreamId& ts_id, int section_number) const;
+        bool getNextTransport(TransportStreamIdSet& ts_set, TransportStreamIdSetMap& hinted, TransportStreamId& ts_id, int section_number) const;
+
+        // Push back a transport stream which was selected but not serialized.
+        void pushBackTransport(TransportStreamIdSet& ts_set, TransportStreamIdSetMap& hinted, const TransportStreamId& ts_id) const;
     };
 }
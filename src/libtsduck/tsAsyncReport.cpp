@@ -28,6 +28,8 @@
 //----------------------------------------------------------------------------
 
 #include "tsAsyncReport.h"
+#include "tsGuardCondition.h"
+#include "tsTime.h"
 TSDUCK_SOURCE;
 
 #if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
@@ -35,6 +37,12 @@ const size_t ts::AsyncReport::MAX_LOG_MESSAGES;
 #endif
 
 
+namespace {
+    // Initial capacity of the message slots, most messages are shorter.
+    const size_t SLOT_CAPACITY = 128;
+}
+
+
 //----------------------------------------------------------------------------
 // Default constructor
 //----------------------------------------------------------------------------
@@ -42,13 +50,29 @@ const size_t ts::AsyncReport::MAX_LOG_MESSAGES;
 ts::AsyncReport::AsyncReport(int max_severity, bool time_stamp, size_t max_messages, bool synchronous) :
     Report(max_severity),
     Thread(ThreadAttributes().setPriority(ThreadAttributes::GetMinimumPriority())),
-    _log_queue(max_messages),
+    _mask(RingMask(max_messages)),
+    _ring(_mask + 1),
+    _enqueue_pos(0),
+    _dequeue_pos(0),
+    _sleeping(false),
+    _terminate(false),
+    _dropped(0),
+    _waiting(0),
+    _mutex(),
+    _not_empty(),
+    _not_full(),
     _default_handler(*this),
     _handler(&_default_handler),
     _time_stamp(time_stamp),
     _synchronous(synchronous),
     _terminated(false)
 {
+    // Preallocate the message slots. Initially, slot N is free for position N.
+    for (size_t i = 0; i < _ring.size(); ++i) {
+        _ring[i].sequence = i;
+        _ring[i].message.reserve(SLOT_CAPACITY);
+    }
+
     // Start the logging thread
     start ();
 }
@@ -64,6 +88,20 @@ ts::AsyncReport::~AsyncReport()
 }
 
 
+//----------------------------------------------------------------------------
+// Compute the ring mask from the maximum number of messages.
+//----------------------------------------------------------------------------
+
+size_t ts::AsyncReport::RingMask(size_t max_messages)
+{
+    size_t size = 2;
+    while (size < max_messages) {
+        size *= 2;
+    }
+    return size - 1;
+}
+
+
 //----------------------------------------------------------------------------
 // Synchronously terminate the report thread.
 //----------------------------------------------------------------------------
@@ -71,9 +109,12 @@ ts::AsyncReport::~AsyncReport()
 void ts::AsyncReport::terminate()
 {
     if (!_terminated) {
-        // Insert an "end of report" message in the queue.
-        // This message will tell the logging thread to terminate.
-        _log_queue.forceEnqueue(new LogMessage(true, 0, UString()));
+        // Tell the logging thread to terminate after the last queued message.
+        {
+            GuardCondition lock(_mutex, _not_empty);
+            _terminate = true;
+            lock.signal();
+        }
 
         // Wait for termination of the logging thread
         waitForTermination();
@@ -82,6 +123,54 @@ void ts::AsyncReport::terminate()
 }
 
 
+//----------------------------------------------------------------------------
+// Try to enqueue a message in the ring. Return false if the ring is full.
+//----------------------------------------------------------------------------
+
+bool ts::AsyncReport::enqueue(int severity, const UString& msg)
+{
+    size_t pos = _enqueue_pos.load(std::memory_order_relaxed);
+    for (;;) {
+        LogMessage& slot(_ring[pos & _mask]);
+        const size_t seq = slot.sequence.load(std::memory_order_acquire);
+        if (seq == pos) {
+            // The slot is free, try to reserve it. On failure, pos is reloaded.
+            if (_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                // Copy the message. The memory of the slot is reused.
+                slot.severity = severity;
+                slot.message.assign(msg);
+                slot.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (seq < pos + 1) {
+            // The slot still contains the message of the previous round, the ring is full.
+            return false;
+        }
+        else {
+            // Another producer got this position.
+            pos = _enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Wake up the logging thread if it is sleeping.
+//----------------------------------------------------------------------------
+
+void ts::AsyncReport::wakeUp()
+{
+    // The fence orders the publication of the message before the check of the sleeping
+    // state. The logging thread sets the sleeping state before checking the ring.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_sleeping) {
+        GuardCondition lock(_mutex, _not_empty);
+        lock.signal();
+    }
+}
+
+
 //----------------------------------------------------------------------------
 // Message logging method.
 //----------------------------------------------------------------------------
@@ -89,9 +178,26 @@ void ts::AsyncReport::terminate()
 void ts::AsyncReport::writeLog(int severity, const UString &msg)
 {
     if (!_terminated) {
-        // Enqueue the message immediately (timeout = 0), drop message on overflow.
-        // On the contrary, in synchronous mode, wait infinitely until the message is queued.
-        _log_queue.enqueue(new LogMessage(false, severity, msg), _synchronous ? Infinite : 0);
+        bool queued = enqueue(severity, msg);
+
+        // In synchronous mode, wait until the message is queued.
+        if (!queued && _synchronous) {
+            wakeUp();
+            GuardCondition lock(_mutex, _not_full);
+            _waiting++;
+            while (!(queued = enqueue(severity, msg)) && !_terminate) {
+                lock.waitCondition();
+            }
+            _waiting--;
+        }
+
+        if (queued) {
+            wakeUp();
+        }
+        else {
+            // Drop message on overflow.
+            _dropped++;
+        }
     }
 }
 
@@ -102,16 +208,51 @@ void ts::AsyncReport::writeLog(int severity, const UString &msg)
 
 void ts::AsyncReport::main()
 {
-    LogMessagePtr msg;
+    uint64_t reported_drops = 0;
 
-    while (_log_queue.dequeue(msg) && !msg->terminate) {
+    for (;;) {
+        LogMessage& slot(_ring[_dequeue_pos & _mask]);
 
-        // Invoke the report handler
-        _handler->handleMessage(msg->severity, msg->message);
+        if (slot.sequence.load(std::memory_order_acquire) == _dequeue_pos + 1) {
+
+            // Invoke the report handler
+            const int severity = slot.severity;
+            _handler->handleMessage(severity, slot.message);
+
+            // Free the slot for the next round.
+            slot.sequence.store(_dequeue_pos + _mask + 1, std::memory_order_release);
+            _dequeue_pos++;
+
+            // Release a producer which waits for a free slot in synchronous mode.
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (_waiting > 0) {
+                GuardCondition lock(_mutex, _not_full);
+                lock.signal();
+            }
+
+            // Abort application on fatal error
+            if (severity == Severity::Fatal) {
+                ::exit(EXIT_FAILURE);
+            }
+        }
+        else {
+            // The ring is empty. Report dropped messages, if any.
+            const uint64_t dropped = _dropped;
+            if (dropped > reported_drops) {
+                _handler->handleMessage(Severity::Warning, UString::Format(u"%'d log messages dropped, queue full", {dropped - reported_drops}));
+                reported_drops = dropped;
+            }
+            if (_terminate) {
+                break;
+            }
 
-        // Abort application on fatal error
-        if (msg->severity == Severity::Fatal) {
-            ::exit(EXIT_FAILURE);
+            // Sleep until a message is queued.
+            GuardCondition lock(_mutex, _not_empty);
+            _sleeping = true;
+            if (slot.sequence.load() != _dequeue_pos + 1 && !_terminate) {
+                lock.waitCondition();
+            }
+            _sleeping = false;
         }
     }
 
@@ -35,9 +35,10 @@
 #pragma once
 #include "tsReport.h"
 #include "tsReportHandler.h"
-#include "tsMessageQueue.h"
-#include "tsNullMutex.h"
 #include "tsThread.h"
+#include "tsMutex.h"
+#include "tsCondition.h"
+#include <atomic>
 
 namespace ts {
     //!
@@ -56,6 +57,13 @@ namespace ts {
     //!
     //! Messages are displayed on the standard error device by default.
     //!
+    //! The messages are stored in a bounded lock-free ring of preallocated message
+    //! slots. Several application threads can log messages concurrently without
+    //! lock. The logging thread is signaled only when it is sleeping on an empty
+    //! ring. When the ring is full, the message is dropped and counted, unless the
+    //! synchronous mode is set. In synchronous mode, the application thread waits
+    //! for a free slot (back-pressure).
+    //!
     class TSDUCKDLL AsyncReport : public Report, private Thread
     {
     public:
@@ -122,6 +130,12 @@ namespace ts {
         //!
         void terminate();
 
+        //!
+        //! Get the number of messages which were dropped because the ring was full.
+        //! @return The number of dropped messages.
+        //!
+        uint64_t droppedMessages() const { return _dropped; }
+
     protected:
         // Report implementation.
         virtual void writeLog(int severity, const UString& msg) override;
@@ -130,19 +144,27 @@ namespace ts {
         // This hook is invoked in the context of the logging thread.
         virtual void main() override;
 
-        // The application threads send that type of message to the logging thread
+        // One preallocated message slot in the ring. The sequence number indicates if
+        // the slot is free for a producer (sequence == position) or contains a message
+        // for the consumer (sequence == position + 1).
         struct LogMessage
         {
-            // Members
-            bool    terminate;  // ask the logging thread to terminate
-            int     severity;
-            UString message;
+            std::atomic<size_t> sequence;
+            int                 severity;
+            UString             message;
 
             // Constructor:
-            LogMessage(bool t, int s, const UString& m) : terminate(t), severity(s), message(m) {}
+            LogMessage() : sequence(0), severity(0), message() {}
         };
-        typedef SafePtr <LogMessage, NullMutex> LogMessagePtr;
-        typedef MessageQueue <LogMessage, NullMutex> LogMessageQueue;
+
+        // Try to enqueue a message in the ring. Return false if the ring is full.
+        bool enqueue(int severity, const UString& msg);
+
+        // Wake up the logging thread if it is sleeping.
+        void wakeUp();
+
+        // Compute the ring mask from the maximum number of messages.
+        static size_t RingMask(size_t max_messages);
 
         // Default report handler:
         class DefaultHandler : public ReportHandler
@@ -155,7 +177,17 @@ namespace ts {
         };
 
         // Private members:
-        LogMessageQueue         _log_queue;
+        const size_t            _mask;          // Ring size minus one, the size is a power of 2.
+        std::vector<LogMessage> _ring;          // Ring of message slots.
+        std::atomic<size_t>     _enqueue_pos;   // Next position to write, shared by producers.
+        size_t                  _dequeue_pos;   // Next position to read, used by the logging thread only.
+        std::atomic<bool>       _sleeping;      // The logging thread is sleeping or about to sleep.
+        std::atomic<bool>       _terminate;     // Request the logging thread to terminate.
+        std::atomic<uint64_t>   _dropped;       // Number of dropped messages.
+        std::atomic<size_t>     _waiting;       // Number of producers waiting for a free slot.
+        Mutex                   _mutex;         // Protect the sleeping state.
+        Condition               _not_empty;     // Signaled when a message is enqueued for a sleeping thread.
+        Condition               _not_full;      // Signaled when a slot is freed in synchronous mode.
         DefaultHandler          _default_handler;
         ReportHandler* volatile _handler;
         volatile bool           _time_stamp;
@@ -36,6 +36,8 @@
 #include "tsAbstractTable.h"
 #include "tsTablesFactory.h"
 #include "tsxmlElement.h"
+#include "tsjsonWriter.h"
+#include "tsNames.h"
 TSDUCK_SOURCE;
 
 
@@ -438,6 +440,38 @@ ts::xml::Element* ts::BinaryTable::toXML(xml::Element* parent, bool forceGeneric
 }
 
 
+//----------------------------------------------------------------------------
+// This method writes the table as fields of a compact JSON object.
+//----------------------------------------------------------------------------
+
+bool ts::BinaryTable::toJSON(json::Writer& writer, CASFamily cas) const
+{
+    // Filter invalid tables.
+    if (!_is_valid || _sections.size() == 0 || _sections[0].isNull()) {
+        return false;
+    }
+
+    writer.field(u"pid", _source_pid);
+    writer.field(u"tid", _tid);
+    writer.field(u"name", names::TID(_tid, cas));
+    if (_sections[0]->isLongSection()) {
+        writer.field(u"tid_ext", _tid_ext);
+        writer.field(u"version", _version);
+        writer.field(u"current", _sections[0]->isCurrent());
+    }
+
+    // Complete binary content of each section, including header and CRC.
+    writer.name(u"sections").beginArray();
+    for (size_t index = 0; index < _sections.size(); ++index) {
+        if (!_sections[index].isNull() && _sections[index]->isValid()) {
+            writer.hexa(_sections[index]->content(), _sections[index]->size());
+        }
+    }
+    writer.endArray();
+    return true;
+}
+
+
 
 
 //----------------------------------------------------------------------------
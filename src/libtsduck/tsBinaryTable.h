@@ -40,6 +40,10 @@
 #include "tsxml.h"
 
 namespace ts {
+
+    namespace json {
+        class Writer;
+    }
     //!
     //! Representation of MPEG PSI/SI tables in binary form (ie. list of sections).
     //!
@@ -286,6 +290,17 @@ namespace ts {
         //!
         bool fromXML(const xml::Element* node, const DVBCharset* charset = 0);
 
+        //!
+        //! This method writes the table as fields of a compact JSON object.
+        //! The binary content of the sections is written in hexadecimal, the
+        //! table is not interpreted. This is a fast and lossless representation.
+        //! @param [in,out] writer A JSON writer. A JSON object shall be open in the writer.
+        //! The JSON object is not closed, the application may add other fields.
+        //! @param [in] cas CAS family, used to name CAS-specific tables.
+        //! @return True on success, false if the table is not valid. Nothing is written when the table is not valid.
+        //!
+        bool toJSON(json::Writer& writer, CASFamily cas = CAS_OTHER) const;
+
     private:
         BinaryTable(const BinaryTable& table) = delete;
 
@@ -34,8 +34,31 @@
 
 #pragma once
 #include "tsPlatform.h"
+#if defined(TS_MSC)
+    #include <intrin.h>
+#endif
 
 namespace ts {
+    //!
+    //! Count the number of leading zero bits in a 64-bit integer.
+    //! @param [in] x An integer value, must not be zero.
+    //! @return The number of most significant zero bits in @a x.
+    //!
+    TSDUCKDLL inline size_t CountLeadingZeros(uint64_t x)
+    {
+        assert(x != 0);
+#if defined(TS_MSC)
+        unsigned long bit = 0;
+        if (_BitScanReverse(&bit, static_cast<unsigned long>(x >> 32))) {
+            return 31 - bit;
+        }
+        _BitScanReverse(&bit, static_cast<unsigned long>(x));
+        return 63 - bit;
+#else
+        return size_t(__builtin_clzll(x));
+#endif
+    }
+
 
     //!
     //! Class to analyze a bit-stream in memory.
@@ -59,6 +82,10 @@ namespace ts {
     //! be associated to a memory area. This association can be performed
     //! in a constructor or using the @c reset() method.
     //!
+    //! Multi-bit values are extracted from a 64-bit look-ahead window which is
+    //! loaded in one operation from the stream, in big-endian order. Only the
+    //! last 7 bytes of the stream are read byte by byte.
+    //!
     class TSDUCKDLL BitStream
     {
     private:
@@ -249,6 +276,12 @@ namespace ts {
             if (_next_bit + n > _end_bit) {
                 return def;
             }
+            uint64_t window = 0;
+            if (n > 0 && n <= MAX_WINDOW_BITS && loadWindow(window)) {
+                // Fast path: extract the n most significant bits of the window.
+                _next_bit += n;
+                return INT(window >> (64 - n));
+            }
             INT val = 0;
             // Read leading bits up to byte boundary
             while (n > 0 && (_next_bit & 0x07) != 0) {
@@ -269,5 +302,97 @@ namespace ts {
             }
             return val;
         }
+
+        //!
+        //! Read the next Exp-Golomb-coded unsigned integer and advance the bitstream pointer.
+        //! See ISO/IEC 14496-10 section 9.1 (ue(v) syntax element).
+        //! @tparam INT An integer type for the result.
+        //! @param [in] def Default value to return if the stream is truncated or
+        //! the value does not fit in 64 bits. The bitstream pointer is then unchanged.
+        //! @return The decoded value.
+        //!
+        template <typename INT, typename std::enable_if<std::is_integral<INT>::value>::type* = nullptr>
+        INT readExpGolomb(INT def = 0)
+        {
+            uint64_t val = 0;
+            return decodeExpGolomb(val) ? INT(val) : def;
+        }
+
+        //!
+        //! Read the next Exp-Golomb-coded signed integer and advance the bitstream pointer.
+        //! See ISO/IEC 14496-10 section 9.1.1 (se(v) syntax element).
+        //! @tparam INT A signed integer type for the result.
+        //! @param [in] def Default value to return if the stream is truncated or
+        //! the value does not fit in 64 bits. The bitstream pointer is then unchanged.
+        //! @return The decoded value.
+        //!
+        template <typename INT, typename std::enable_if<std::is_integral<INT>::value && std::is_signed<INT>::value>::type* = nullptr>
+        INT readSignedExpGolomb(INT def = 0)
+        {
+            uint64_t val = 0;
+            if (!decodeExpGolomb(val)) {
+                return def;
+            }
+            // Odd values are positive, even values are negative: 1, -1, 2, -2, etc.
+            return (val & 1) != 0 ? INT((val + 1) / 2) : -INT(val / 2);
+        }
+
+        //!
+        //! Maximum number of bits which are extracted at once from the look-ahead window.
+        //! The next bit can be anywhere in the first byte of the 64-bit window.
+        //!
+        static const size_t MAX_WINDOW_BITS = 57;
+
+    private:
+        // Load the 64 bits which start at the byte of the next bit, the next bit becomes the MSB.
+        // Return false if less than 8 bytes remain in the stream.
+        bool loadWindow(uint64_t& window) const
+        {
+            const size_t byte = _next_bit >> 3;
+            if (byte + 8 > (_end_bit + 7) >> 3) {
+                return false;
+            }
+            window = GetUInt64(_base + byte) << (_next_bit & 0x07);
+            return true;
+        }
+
+        // Decode an Exp-Golomb-coded value. Return false on error, without moving the pointer.
+        bool decodeExpGolomb(uint64_t& val)
+        {
+            // Fast path: the code word is 2*N+1 bits, N leading zeros, and fits in the window.
+            // Its value, as an unsigned integer, is the decoded value plus one.
+            uint64_t window = 0;
+            if (loadWindow(window) && window != 0) {
+                const size_t size = 2 * CountLeadingZeros(window) + 1;
+                if (size <= MAX_WINDOW_BITS) {
+                    if (_next_bit + size > _end_bit) {
+                        return false;
+                    }
+                    _next_bit += size;
+                    val = (window >> (64 - size)) - 1;
+                    return true;
+                }
+            }
+
+            // Slow path, near the end of stream or large values.
+            const size_t saved_bit = _next_bit;
+            size_t zeros = 0;
+            for (;;) {
+                if (_next_bit >= _end_bit || zeros >= 64) {
+                    _next_bit = saved_bit;
+                    return false;
+                }
+                if (readBit() != 0) {
+                    break;
+                }
+                zeros++;
+            }
+            if (_next_bit + zeros > _end_bit) {
+                _next_bit = saved_bit;
+                return false;
+            }
+            val = (uint64_t(1) << zeros) - 1 + read<uint64_t>(zeros);
+            return true;
+        }
     };
 }
@@ -0,0 +1,413 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+
+#include "tsBlockOutputStream.h"
+TSDUCK_SOURCE;
+
+// Minimum size of the internal buffer.
+#define MIN_BUFFER_SIZE 4096
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::BlockOutputStream::DEFAULT_BLOCK_SIZE;
+#endif
+
+
+//----------------------------------------------------------------------------
+// Constructors and destructor.
+//----------------------------------------------------------------------------
+
+ts::BlockOutputStream::BlockOutputStream(size_t blockSize, Report& report) :
+    std::basic_ostream<char>(this),
+    std::basic_streambuf<char>(),
+    _report(report),
+    _outFile(),
+    _out(&std::cout),
+    _blockSize(blockSize),
+    _buffer()
+{
+    resizeBuffer(std::max<size_t>(2 * _blockSize, MIN_BUFFER_SIZE));
+}
+
+ts::BlockOutputStream::~BlockOutputStream()
+{
+    close();
+}
+
+
+//----------------------------------------------------------------------------
+// Set output to an open text stream.
+//----------------------------------------------------------------------------
+
+ts::BlockOutputStream& ts::BlockOutputStream::setStream(std::ostream& strm)
+{
+    close();
+    _out = &strm;
+    return *this;
+}
+
+
+//----------------------------------------------------------------------------
+// Set output to a text file.
+//----------------------------------------------------------------------------
+
+bool ts::BlockOutputStream::setFile(const UString& fileName)
+{
+    close();
+    _outFile.open(fileName.toUTF8().c_str(), std::ios::out);
+    if (!_outFile) {
+        _report.error(u"cannot create file %s", {fileName});
+        return false;
+    }
+    else {
+        _out = &_outFile;
+        return true;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Close the current output.
+//----------------------------------------------------------------------------
+
+void ts::BlockOutputStream::close()
+{
+    flushBuffer();
+    if (_outFile.is_open()) {
+        _outFile.close();
+    }
+    _out = &std::cout;
+}
+
+
+//----------------------------------------------------------------------------
+// Set the block size.
+//----------------------------------------------------------------------------
+
+void ts::BlockOutputStream::setBlockSize(size_t size)
+{
+    const size_t capacity = std::max<size_t>(2 * size, MIN_BUFFER_SIZE);
+    if (pending() > capacity) {
+        flushBuffer();
+    }
+    _blockSize = size;
+    resizeBuffer(capacity);
+}
+
+
+//----------------------------------------------------------------------------
+// Write all buffered data to the underlying output and flush it.
+//----------------------------------------------------------------------------
+
+bool ts::BlockOutputStream::flushBuffer()
+{
+    const bool ok = writeBuffer(pending());
+    _out->flush();
+    return ok && !_out->fail();
+}
+
+
+//----------------------------------------------------------------------------
+// Reset the buffer to a given capacity, keeping the current content.
+//----------------------------------------------------------------------------
+
+void ts::BlockOutputStream::resizeBuffer(size_t capacity)
+{
+    // The buffer may be reallocated, keep the size of the current content.
+    const size_t size = _buffer.empty() ? 0 : pending();
+    assert(size <= capacity);
+    _buffer.resize(capacity);
+    setp(&_buffer[0], &_buffer[0] + _buffer.size());
+    pbump(int(size));
+}
+
+
+//----------------------------------------------------------------------------
+// Write the first bytes of the buffer, keep the rest.
+//----------------------------------------------------------------------------
+
+bool ts::BlockOutputStream::writeBuffer(size_t size)
+{
+    const size_t total = pending();
+    assert(size <= total);
+
+    if (size > 0) {
+        _out->write(pbase(), std::streamsize(size));
+    }
+
+    // Move the remaining data at the beginning of the buffer.
+    if (size < total) {
+        std::memmove(&_buffer[0], pbase() + size, total - size);
+    }
+    setp(&_buffer[0], &_buffer[0] + _buffer.size());
+    pbump(int(total - size));
+
+    return !_out->fail();
+}
+
+
+//----------------------------------------------------------------------------
+// This is called when the buffer becomes full.
+//----------------------------------------------------------------------------
+
+int ts::BlockOutputStream::overflow(int c)
+{
+    // Write all complete lines, keep the last partial line in the buffer.
+    // If there is no complete line, write everything.
+    const size_t size = pending();
+    size_t count = size;
+    while (count > 0 && pbase()[count - 1] != '\n') {
+        --count;
+    }
+    const bool ok = writeBuffer(count > 0 ? count : size);
+
+    // There is now some free space in the buffer for the character that didn't fit.
+    if (ok && c != traits_type::eof()) {
+        *pptr() = char(c);
+        pbump(1);
+    }
+    return ok ? traits_type::not_eof(c) : traits_type::eof();
+}
+
+
+//----------------------------------------------------------------------------
+// This function is called when the stream is flushed.
+//----------------------------------------------------------------------------
+
+int ts::BlockOutputStream::sync()
+{
+    // Write the buffer only when at least one block is ready.
+    bool ok = true;
+    if (pending() > 0 && pending() >= _blockSize) {
+        ok = writeBuffer(pending());
+        _out->flush();
+        ok = ok && !_out->fail();
+    }
+    return ok ? 0 : -1;
+}
+
+
+//----------------------------------------------------------------------------
+// Make room for at least size bytes at pptr().
+//----------------------------------------------------------------------------
+
+bool ts::BlockOutputStream::reserveBuffer(size_t size)
+{
+    if (size_t(epptr() - pptr()) >= size) {
+        return true;
+    }
+    // Same policy as overflow(): write all complete lines.
+    size_t count = pending();
+    while (count > 0 && pbase()[count - 1] != '\n') {
+        --count;
+    }
+    if (!writeBuffer(count > 0 ? count : pending())) {
+        return false;
+    }
+    if (size_t(epptr() - pptr()) < size) {
+        resizeBuffer(pending() + size);
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Write integers directly in the buffer.
+//----------------------------------------------------------------------------
+
+namespace {
+    // Pre-rendered decimal values 00 to 99.
+    const char Digits2[] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+    // Uppercase hexadecimal digits.
+    const char HexDigits[] = "0123456789ABCDEF";
+}
+
+ts::BlockOutputStream& ts::BlockOutputStream::putUnsigned(uint64_t value, bool negative)
+{
+    // Render from the end of a local buffer, two digits at a time.
+    char buf[24];
+    char* const end = buf + sizeof(buf);
+    char* p = end;
+    while (value >= 100) {
+        const size_t i = size_t(value % 100) * 2;
+        value /= 100;
+        *--p = Digits2[i + 1];
+        *--p = Digits2[i];
+    }
+    if (value >= 10) {
+        const size_t i = size_t(value) * 2;
+        *--p = Digits2[i + 1];
+        *--p = Digits2[i];
+    }
+    else {
+        *--p = char('0' + value);
+    }
+    if (negative) {
+        *--p = '-';
+    }
+    if (reserveBuffer(end - p)) {
+        std::memcpy(pptr(), p, end - p);
+        pbump(int(end - p));
+    }
+    return *this;
+}
+
+ts::BlockOutputStream& ts::BlockOutputStream::putHexa(uint64_t value, size_t width)
+{
+    size_t digits = 1;
+    while (digits < 16 && (value >> (4 * digits)) != 0) {
+        ++digits;
+    }
+    digits = std::max(digits, width);
+    if (reserveBuffer(digits)) {
+        char* const p = pptr();
+        for (size_t i = digits; i > 0; --i) {
+            p[i - 1] = HexDigits[value & 0x0F];
+            value >>= 4;
+        }
+        pbump(int(digits));
+    }
+    return *this;
+}
+
+
+//----------------------------------------------------------------------------
+// Write a hexadecimal dump of binary data directly in the buffer.
+//----------------------------------------------------------------------------
+
+ts::BlockOutputStream& ts::BlockOutputStream::putDump(const void* data, size_t size, uint32_t flags, size_t indent, size_t line_width, size_t init_offset, size_t inner_indent)
+{
+    // Same default as UString::Dump().
+    if ((flags & (UString::HEXA | UString::C_STYLE | UString::BINARY | UString::BIN_NIBBLE | UString::ASCII)) == 0) {
+        flags |= UString::HEXA;
+    }
+
+    // Only hexa, ASCII and offsets are directly rendered.
+    if ((flags & (UString::SINGLE_LINE | UString::COMPACT | UString::C_STYLE | UString::BINARY | UString::BIN_NIBBLE)) != 0) {
+        *this << UString::Dump(data, size, flags, indent, line_width, init_offset, inner_indent);
+        return *this;
+    }
+
+    const bool hexa = (flags & UString::HEXA) != 0;
+    const bool ascii = (flags & UString::ASCII) != 0;
+    const size_t offset_width = (flags & UString::OFFSET) == 0 ? 0 : ((flags & UString::WIDE_OFFSET) == 0 && init_offset + size <= 0x10000 ? 4 : 8);
+
+    // Compute the number of bytes per line, same as UString::Dump().
+    size_t add_width = indent + inner_indent + (offset_width == 0 ? 0 : offset_width + 3) + (hexa && ascii ? 2 : 0);
+    size_t bytes_per_line = 0;
+    if (flags & UString::BPL) {
+        bytes_per_line = line_width;
+    }
+    else if (add_width >= line_width) {
+        bytes_per_line = 8;
+    }
+    else {
+        bytes_per_line = (line_width - add_width) / ((hexa ? 3 : 0) + (ascii ? 1 : 0));
+        if (bytes_per_line > 1) {
+            bytes_per_line = bytes_per_line & ~size_t(1);
+        }
+    }
+    if (bytes_per_line == 0) {
+        bytes_per_line = 8;
+    }
+
+    // Maximum size of a line.
+    const size_t max_line = add_width + 4 * bytes_per_line + 1;
+    const uint8_t* const raw = static_cast<const uint8_t*>(data);
+
+    for (size_t line = 0; line < size; line += bytes_per_line) {
+
+        const size_t line_size = std::min(bytes_per_line, size - line);
+        if (!reserveBuffer(max_line)) {
+            break;
+        }
+        char* const start = pptr();
+        char* p = start;
+
+        // Beginning of line.
+        std::memset(p, ' ', indent);
+        p += indent;
+        if (offset_width > 0) {
+            uint64_t offset = init_offset + line;
+            for (size_t i = offset_width; i > 0; --i) {
+                p[i - 1] = HexDigits[offset & 0x0F];
+                offset >>= 4;
+            }
+            p += offset_width;
+            *p++ = ':';
+            *p++ = ' ';
+            *p++ = ' ';
+        }
+        std::memset(p, ' ', inner_indent);
+        p += inner_indent;
+
+        // Hexa dump.
+        if (hexa) {
+            for (size_t i = 0; i < line_size; ++i) {
+                const uint8_t b = raw[line + i];
+                *p++ = HexDigits[b >> 4];
+                *p++ = HexDigits[b & 0x0F];
+                *p++ = ' ';
+            }
+            if (ascii) {
+                // Pad the last line to align the ASCII dump.
+                const size_t pad = 3 * (bytes_per_line - line_size);
+                std::memset(p, ' ', pad);
+                p += pad;
+                *p++ = ' ';
+            }
+        }
+
+        // ASCII dump.
+        if (ascii) {
+            for (size_t i = 0; i < line_size; ++i) {
+                const uint8_t c = raw[line + i];
+                *p++ = c >= 0x20 && c <= 0x7E ? char(c) : '.';
+            }
+        }
+
+        // Cleanup trailing spaces, add a new-line.
+        while (p > start && p[-1] == ' ') {
+            --p;
+        }
+        *p++ = '\n';
+        pbump(int(p - start));
+    }
+    return *this;
+}
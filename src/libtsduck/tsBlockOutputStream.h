@@ -0,0 +1,225 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Output stream writing to another stream in large blocks.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsNullReport.h"
+#include "tsUString.h"
+
+namespace ts {
+    //!
+    //! Output stream writing to another stream or to a file in large blocks.
+    //!
+    //! This class is a subclass of <code>std::ostream</code> and can be used as any output stream.
+    //! The text is accumulated into an internal reusable buffer and is written to the
+    //! underlying output in large blocks, ending on a line boundary whenever possible.
+    //!
+    //! Flushing the stream, for instance using <code>std::endl</code> at the end of each line,
+    //! does not write the buffer unless it contains at least a block of data. This avoids
+    //! one system call per line when rendering large amounts of text. The method flushBuffer()
+    //! shall be used to explicitly write all buffered data. A zero block size means that the
+    //! data are written each time the stream is flushed, typically when writing to a terminal.
+    //!
+    //! For high-throughput text output, the methods putDecimal(), putHexa() and putDump()
+    //! render integers and hexadecimal dumps directly into the internal buffer, without
+    //! the intermediate strings and locale processing of the standard formatting.
+    //!
+    class TSDUCKDLL BlockOutputStream:
+        public std::basic_ostream<char>,     // Public base
+        private std::basic_streambuf<char>   // Internally use a streambuf
+    {
+    public:
+        //!
+        //! Explicit reference to the public superclass.
+        //!
+        typedef std::basic_ostream<char> SuperClass;
+
+        // These types are declared by std::basic_ostream and are inherited.
+        // But the same names are also declared by the private base class basic_streambuf.
+        // Because of this conflict, they are hidden. We restore here the visibility
+        // of the names which are inherited by the public base class.
+#if !defined(DOXYGEN)
+        typedef SuperClass::char_type char_type;
+        typedef SuperClass::traits_type traits_type;
+        typedef SuperClass::int_type int_type;
+        typedef SuperClass::pos_type pos_type;
+        typedef SuperClass::off_type off_type;
+#endif
+
+        //!
+        //! Default block size in bytes.
+        //!
+        static const size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+        //!
+        //! Constructor.
+        //! The stream is initially directed to @c std::cout.
+        //! @param [in] blockSize Block size in bytes.
+        //! @param [in,out] report Where to report errors.
+        //!
+        explicit BlockOutputStream(size_t blockSize = DEFAULT_BLOCK_SIZE, Report& report = NULLREP);
+
+        //!
+        //! Destructor.
+        //! All buffered data are written.
+        //!
+        virtual ~BlockOutputStream();
+
+        //!
+        //! Set output to an open text stream.
+        //! The buffered data for the previous output are written first.
+        //! @param [in,out] strm The output text stream.
+        //! The referenced stream object must remain valid as long as this object.
+        //! @return A reference to this object.
+        //!
+        BlockOutputStream& setStream(std::ostream& strm);
+
+        //!
+        //! Set output to a text file.
+        //! The buffered data for the previous output are written first.
+        //! @param [in] fileName Output file name.
+        //! @return True on success, false on error.
+        //!
+        bool setFile(const UString& fileName);
+
+        //!
+        //! Check if the output is a file which was created by this object.
+        //! @return True if the output is a file which was created by this object.
+        //!
+        bool isFile() const { return _out == &_outFile; }
+
+        //!
+        //! Close the current output.
+        //! The buffered data are written, the file, if any, is closed
+        //! and the output is reset to @c std::cout.
+        //!
+        void close();
+
+        //!
+        //! Get the block size.
+        //! @return The block size in bytes.
+        //!
+        size_t blockSize() const { return _blockSize; }
+
+        //!
+        //! Set the block size.
+        //! @param [in] size The new block size in bytes. When zero, the data are written
+        //! each time the stream is flushed.
+        //!
+        void setBlockSize(size_t size);
+
+        //!
+        //! Write all buffered data to the underlying output and flush it.
+        //! @return True on success, false on error.
+        //!
+        bool flushBuffer();
+
+        //!
+        //! Write an integer value in decimal, without separator, directly in the buffer.
+        //! @tparam INT An integer type.
+        //! @param [in] value The integer value to write.
+        //! @return A reference to this object.
+        //!
+        template <typename INT, typename std::enable_if<std::is_integral<INT>::value>::type* = nullptr>
+        BlockOutputStream& putDecimal(INT value)
+        {
+            return std::is_signed<INT>::value && value < 0 ?
+                putUnsigned(uint64_t(0) - uint64_t(value), true) :
+                putUnsigned(uint64_t(value), false);
+        }
+
+        //!
+        //! Write an integer value in uppercase hexadecimal, without prefix, directly in the buffer.
+        //! @param [in] value The integer value to write.
+        //! @param [in] width Minimum width, the value is padded with leading zeroes.
+        //! @return A reference to this object.
+        //!
+        BlockOutputStream& putHexa(uint64_t value, size_t width = 0);
+
+        //!
+        //! Write a hexadecimal dump of binary data, directly in the buffer.
+        //! The output is identical to UString::Dump() with the same parameters.
+        //! Dumps with hexadecimal, ASCII and offsets are directly rendered in the buffer.
+        //! Other options use UString::Dump().
+        //! @param [in] data Address of binary data.
+        //! @param [in] size Size of binary data.
+        //! @param [in] flags A combination of UString::HexaFlags.
+        //! @param [in] indent Left margin size.
+        //! @param [in] line_width Maximum width of text lines.
+        //! @param [in] init_offset Initial offset in data, with UString::OFFSET.
+        //! @param [in] inner_indent Indentation after the offset.
+        //! @return A reference to this object.
+        //!
+        BlockOutputStream& putDump(const void* data,
+                                   size_t size,
+                                   uint32_t flags = UString::HEXA,
+                                   size_t indent = 0,
+                                   size_t line_width = UString::DEFAULT_HEXA_LINE_WIDTH,
+                                   size_t init_offset = 0,
+                                   size_t inner_indent = 0);
+
+    private:
+        Report&       _report;     // Where to report errors.
+        std::ofstream _outFile;    // Own stream when output to a file we created.
+        std::ostream* _out;        // Address of current output stream, never null.
+        size_t        _blockSize;  // Minimum size of a write operation.
+        std::string   _buffer;     // Internal buffer for std::streambuf.
+
+        // Inherited from std::basic_streambuf<char>.
+        // This is called when buffer becomes full.
+        virtual int overflow(int c = traits_type::eof()) override;
+
+        // Inherited from std::basic_streambuf<char>.
+        // This is called when the stream is flushed.
+        virtual int sync() override;
+
+        // Write the first bytes of the buffer, keep the rest.
+        bool writeBuffer(size_t size);
+
+        // Reset the buffer to a given capacity, keeping the current content.
+        void resizeBuffer(size_t capacity);
+
+        // Current size of buffered data.
+        size_t pending() const { return pptr() - pbase(); }
+
+        // Make room for at least size bytes at pptr(), return false on output error.
+        bool reserveBuffer(size_t size);
+
+        // Write an unsigned value in decimal, with an optional minus sign.
+        BlockOutputStream& putUnsigned(uint64_t value, bool negative);
+
+        // Unaccessible operations.
+        BlockOutputStream(const BlockOutputStream&) = delete;
+        BlockOutputStream& operator=(const BlockOutputStream&) = delete;
+    };
+}
@@ -43,7 +43,7 @@ TSDUCK_SOURCE;
 //----------------------------------------------------------------------------
 
 ts::ByteBlock::ByteBlock(size_type size) :
-    ByteVector(size)
+    ByteVector(size, 0)
 {
 }
 
@@ -95,7 +95,7 @@ ts::ByteBlock::ByteBlock(std::initializer_list<uint8_t> init) :
 
 void ts::ByteBlock::copy(const void* data_, size_type size_)
 {
-    resize(size_);
+    resizeUninitialized(size_);
     if (size_ > 0) {
         ::memcpy(data(), data_, size_);  // Flawfinder: ignore: memcpy()
     }
@@ -108,8 +108,8 @@ void ts::ByteBlock::copy(const void* data_, size_type size_)
 void* ts::ByteBlock::enlarge(size_type n)
 {
     const size_type oldsize = this->size();
-    resize(oldsize + n);
-    return &(*this)[oldsize];
+    resizeUninitialized(oldsize + n);
+    return data() + oldsize;
 }
 
 //----------------------------------------------------------------------------
@@ -211,7 +211,7 @@ std::istream& ts::ByteBlock::append(std::istream& strm, size_t maxSize)
 
         // Make more space in byte block for reading a chunk.
         const size_t previousSize = size();
-        resize(previousSize + readSize);
+        resizeUninitialized(previousSize + readSize);
 
         // Read a chunk of data.
         strm.read(reinterpret_cast<char*>(data() + previousSize), std::streamsize(readSize));
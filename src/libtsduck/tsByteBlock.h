@@ -35,6 +35,7 @@
 #pragma once
 #include "tsPlatform.h"
 #include "tsSafePtr.h"
+#include "tsDefaultInitAllocator.h"
 
 namespace ts {
 
@@ -44,15 +45,18 @@ namespace ts {
     //!
     //! Definition of a generic block of bytes.
     //!
-    //! This is a subclass of @c std::vector on @c uint8_t.
+    //! This is a subclass of @c std::vector on @c uint8_t. The vector uses a
+    //! ts::DefaultInitAllocator so that the block can grow without zero-filling
+    //! the new bytes, using resizeUninitialized(). The standard resize() still
+    //! zero-fills the new bytes.
     //!
-    class TSDUCKDLL ByteBlock : public std::vector<uint8_t>
+    class TSDUCKDLL ByteBlock : public std::vector<uint8_t, DefaultInitAllocator<uint8_t>>
     {
     public:
         //!
         //! Explicit name of superclass, @c std::vector on @c uint8_t.
         //!
-        typedef std::vector<uint8_t> ByteVector;
+        typedef std::vector<uint8_t, DefaultInitAllocator<uint8_t>> ByteVector;
 
         //!
         //! Default constructor.
@@ -88,6 +92,64 @@ namespace ts {
         //!
         ByteBlock(std::initializer_list<uint8_t> init);
 
+        //!
+        //! Copy constructor.
+        //! @param [in] other Other instance to copy.
+        //!
+        ByteBlock(const ByteBlock& other) = default;
+
+        //!
+        //! Move constructor.
+        //! @param [in,out] other Other instance to move.
+        //!
+        ByteBlock(ByteBlock&& other) = default;
+
+        //!
+        //! Destructor.
+        //! Virtual to allow the deletion of subclass instances through a ByteBlockPtr.
+        //!
+        virtual ~ByteBlock() {}
+
+        //!
+        //! Assignment operator.
+        //! @param [in] other Other instance to copy.
+        //! @return A reference to this object.
+        //!
+        ByteBlock& operator=(const ByteBlock& other) = default;
+
+        //!
+        //! Move assignment operator.
+        //! @param [in,out] other Other instance to move.
+        //! @return A reference to this object.
+        //!
+        ByteBlock& operator=(ByteBlock&& other) = default;
+
+        //!
+        //! Resize the byte block.
+        //! The methods of the superclass remain available. As with a standard
+        //! @c std::vector on @c uint8_t, the new bytes are zero.
+        //!
+        using ByteVector::resize;
+
+        //!
+        //! Resize the byte block, the new bytes are zero.
+        //! @param [in] size New size in bytes of the block.
+        //!
+        void resize(size_type size)
+        {
+            ByteVector::resize(size, 0);
+        }
+
+        //!
+        //! Resize the byte block without initializing the new bytes.
+        //! Use this method when the new bytes are immediately overwritten.
+        //! @param [in] size New size in bytes of the block.
+        //!
+        void resizeUninitialized(size_type size)
+        {
+            ByteVector::resize(size);
+        }
+
         //!
         //! Replace the content of a byte block.
         //! @param [in] data Address of the new area to copy.
@@ -105,6 +167,7 @@ namespace ts {
 
         //!
         //! Increase size return pointer to new area at end of block.
+        //! The new area is not initialized, the caller shall write all its bytes.
         //! @param [in] n Number of bytes to add at the end of the block.
         //! @return Address of the new n-byte area at the end of the block.
         //!
@@ -47,7 +47,14 @@ ts::CASMapper::CASMapper(Report& report) :
     TableHandlerInterface(),
     _report(report),
     _demux(this),
-    _pids()
+    _cas_ids(PID_MAX, 0),
+    _cas_families(PID_MAX, CAS_OTHER),
+    _ecm_pids(),
+    _emm_pids(),
+    _family_ecm_pids(),
+    _family_emm_pids(),
+    _descs(),
+    _generation(0)
 {
     // Specify the PID filters
     _demux.addPID(PID_PAT);
@@ -55,6 +62,28 @@ ts::CASMapper::CASMapper(Report& report) :
 }
 
 
+//----------------------------------------------------------------------------
+// Reset the CAS mapper.
+//----------------------------------------------------------------------------
+
+void ts::CASMapper::reset()
+{
+    _demux.reset();
+    _demux.setPIDFilter(NoPID);
+    _demux.addPID(PID_PAT);
+    _demux.addPID(PID_CAT);
+
+    std::fill(_cas_ids.begin(), _cas_ids.end(), 0);
+    std::fill(_cas_families.begin(), _cas_families.end(), CAS_OTHER);
+    _ecm_pids.reset();
+    _emm_pids.reset();
+    _family_ecm_pids.clear();
+    _family_emm_pids.clear();
+    _descs.clear();
+    _generation++;
+}
+
+
 //----------------------------------------------------------------------------
 // This hook is invoked when a complete table is available.
 //----------------------------------------------------------------------------
@@ -89,7 +118,7 @@ void ts::CASMapper::handleTable(SectionDemux&, const BinaryTable& table)
             const PMT pmt(table);
             if (pmt.isValid()) {
                 // Identify all ECM PID's at program level.
-                analyzeCADescriptors(pmt.descs, false);
+                analyzeCADescriptors(pmt.descs, true);
                 // Identify all ECM PID's at stream level.
                 for (PMT::StreamMap::const_iterator it = pmt.streams.begin(); it != pmt.streams.end(); ++it) {
                     analyzeCADescriptors(it->second.descs, true);
@@ -118,7 +147,7 @@ void ts::CASMapper::analyzeCADescriptors(const DescriptorList& descs, bool is_ec
             const CADescriptorPtr cadesc(new CADescriptor(*desc));
             if (!cadesc.isNull() && cadesc->isValid()) {
                 const std::string cas_name(names::CASId(cadesc->cas_id).toUTF8());
-                _pids[cadesc->ca_pid] = PIDDescription(cadesc->cas_id, is_ecm, cadesc);
+                setPID(cadesc->ca_pid, cadesc->cas_id, is_ecm, cadesc);
                 _report.verbose(u"Found %s PID %d (0x%X) for CAS id 0x%X (%s)",
                                 {is_ecm ? u"ECM" : u"EMM", cadesc->ca_pid, cadesc->ca_pid, cadesc->cas_id, cas_name});
             }
@@ -128,40 +157,72 @@ void ts::CASMapper::analyzeCADescriptors(const DescriptorList& descs, bool is_ec
 
 
 //----------------------------------------------------------------------------
-// Get the characteristics of CA PID's.
+// Record the description of one CA PID.
 //----------------------------------------------------------------------------
 
-uint16_t ts::CASMapper::casId(PID pid) const
+void ts::CASMapper::setPID(PID pid, uint16_t cas_id, bool is_ecm, const CADescriptorPtr& desc)
 {
-    const PIDDescriptionMap::const_iterator it(_pids.find(pid));
-    return it == _pids.end() ? 0 : it->second.cas_id;
-}
+    if (pid >= PID_MAX) {
+        return;
+    }
 
-ts::CASFamily ts::CASMapper::casFamily(PID pid) const
-{
-    return CASFamilyOf(casId(pid));
+    // Always keep the latest descriptor, even when the PID characteristics are unchanged.
+    _descs[pid] = desc;
+
+    // Nothing more to do if the PID is already known with the same characteristics.
+    if (_cas_ids[pid] == cas_id && (is_ecm ? _ecm_pids.test(pid) : _emm_pids.test(pid))) {
+        return;
+    }
+
+    // Remove the PID from the sets of its previous CAS family.
+    const CASFamily old_family = _cas_families[pid];
+    if (_ecm_pids.test(pid)) {
+        _family_ecm_pids[old_family].reset(pid);
+    }
+    if (_emm_pids.test(pid)) {
+        _family_emm_pids[old_family].reset(pid);
+    }
+
+    // Record the new characteristics.
+    const CASFamily family = CASFamilyOf(cas_id);
+    _cas_ids[pid] = cas_id;
+    _cas_families[pid] = family;
+    _ecm_pids.set(pid, is_ecm);
+    _emm_pids.set(pid, !is_ecm);
+    (is_ecm ? _family_ecm_pids : _family_emm_pids)[family].set(pid);
+    _generation++;
 }
 
-bool ts::CASMapper::isECM(PID pid) const
+
+//----------------------------------------------------------------------------
+// Get the sets of CA PID's for a CAS family.
+//----------------------------------------------------------------------------
+
+const ts::PIDSet& ts::CASMapper::ecmPIDs(CASFamily cas) const
 {
-    const PIDDescriptionMap::const_iterator it(_pids.find(pid));
-    return it != _pids.end() && it->second.is_ecm;
+    const FamilyPIDMap::const_iterator it(_family_ecm_pids.find(cas));
+    return it == _family_ecm_pids.end() ? NoPID : it->second;
 }
 
-bool ts::CASMapper::isEMM(PID pid) const
+const ts::PIDSet& ts::CASMapper::emmPIDs(CASFamily cas) const
 {
-    const PIDDescriptionMap::const_iterator it(_pids.find(pid));
-    return it != _pids.end() && !it->second.is_ecm;
+    const FamilyPIDMap::const_iterator it(_family_emm_pids.find(cas));
+    return it == _family_emm_pids.end() ? NoPID : it->second;
 }
 
+
+//----------------------------------------------------------------------------
+// Get the CA descriptor of a CA PID.
+//----------------------------------------------------------------------------
+
 bool ts::CASMapper::getCADescriptor(PID pid, CADescriptorPtr& desc) const
 {
-    const PIDDescriptionMap::const_iterator it(_pids.find(pid));
-    if (it == _pids.end()) {
+    const CADescriptorMap::const_iterator it(_descs.find(pid));
+    if (it == _descs.end()) {
         desc.clear();
     }
     else {
-        desc = it->second.ca_desc;
+        desc = it->second;
     }
     return !desc.isNull();
 }
@@ -61,6 +61,11 @@ namespace ts {
             _demux.feedPacket(pkt);
         }
 
+        //!
+        //! Reset the CAS mapper, forget all known CA PID's.
+        //!
+        void reset();
+
         //!
         //! Check if a PID is a known CA PID.
         //! @param [in] pid A PID to check.
@@ -68,7 +73,7 @@ namespace ts {
         //!
         bool knownPID(PID pid) const
         {
-            return _pids.find(pid) != _pids.end();
+            return pid < PID_MAX && (_ecm_pids.test(pid) || _emm_pids.test(pid));
         }
 
         //!
@@ -76,28 +81,75 @@ namespace ts {
         //! @param [in] pid A PID to check.
         //! @return The CAS family or CAS_OTHER if unknown.
         //!
-        CASFamily casFamily(PID pid) const;
+        CASFamily casFamily(PID pid) const
+        {
+            return pid < PID_MAX ? _cas_families[pid] : CAS_OTHER;
+        }
 
         //!
         //! Get the CAS id of a CA PID (ECM or EMM).
         //! @param [in] pid A PID to check.
         //! @return The CAS id or zero if the PID is not known.
         //!
-        uint16_t casId(PID pid) const;
+        uint16_t casId(PID pid) const
+        {
+            return pid < PID_MAX ? _cas_ids[pid] : 0;
+        }
 
         //!
         //! Check if a PID carries ECM's.
         //! @param [in] pid A PID to check.
         //! @return True if the PID carries ECM's, false otherwise.
         //!
-        bool isECM(PID pid) const;
+        bool isECM(PID pid) const
+        {
+            return pid < PID_MAX && _ecm_pids.test(pid);
+        }
 
         //!
         //! Check if a PID carries EMM's.
         //! @param [in] pid A PID to check.
         //! @return True if the PID carries EMM's, false otherwise.
         //!
-        bool isEMM(PID pid) const;
+        bool isEMM(PID pid) const
+        {
+            return pid < PID_MAX && _emm_pids.test(pid);
+        }
+
+        //!
+        //! Get the set of all known ECM PID's.
+        //! @return A constant reference to the set of ECM PID's.
+        //!
+        const PIDSet& ecmPIDs() const { return _ecm_pids; }
+
+        //!
+        //! Get the set of all known EMM PID's.
+        //! @return A constant reference to the set of EMM PID's.
+        //!
+        const PIDSet& emmPIDs() const { return _emm_pids; }
+
+        //!
+        //! Get the set of known ECM PID's for a given CAS family.
+        //! @param [in] cas CAS family.
+        //! @return A constant reference to the set of ECM PID's of this CAS family.
+        //!
+        const PIDSet& ecmPIDs(CASFamily cas) const;
+
+        //!
+        //! Get the set of known EMM PID's for a given CAS family.
+        //! @param [in] cas CAS family.
+        //! @return A constant reference to the set of EMM PID's of this CAS family.
+        //!
+        const PIDSet& emmPIDs(CASFamily cas) const;
+
+        //!
+        //! Get the generation counter of the CA PID mapping.
+        //! The counter is incremented each time a CA PID is added, removed or modified.
+        //! Applications which cache information derived from this object (PID sets
+        //! for instance) can compare the generation counter to detect a change.
+        //! @return The current generation counter.
+        //!
+        uint32_t generation() const { return _generation; }
 
         //!
         //! Get the CA_descriptor which describes a CA PID (ECM or EMM).
@@ -108,32 +160,31 @@ namespace ts {
         bool getCADescriptor(PID pid, CADescriptorPtr& desc) const;
 
     private:
-        // Description of one CA PID.
-        class PIDDescription
-        {
-        public:
-            uint16_t        cas_id;  //!< CA system id.
-            bool            is_ecm;  //!< True for ECM, false for EMM.
-            CADescriptorPtr ca_desc; //!< Corresponding CA descriptor.
-
-            PIDDescription(uint16_t cas_id_ = 0, bool is_ecm_ = false, const CADescriptorPtr& ca_desc_ = CADescriptorPtr()) :
-                cas_id(cas_id_),
-                is_ecm(is_ecm_),
-                ca_desc(ca_desc_)
-            {
-            }
-        };
-
-        // Map of key=PID to value=PIDDescription.
-        typedef std::map<PID,PIDDescription> PIDDescriptionMap;
+        // Map of key=PID to value=CA descriptor.
+        typedef std::map<PID,CADescriptorPtr> CADescriptorMap;
+
+        // Map of key=CAS family to value=set of PID's.
+        typedef std::map<CASFamily,PIDSet> FamilyPIDMap;
 
         // Explore a descriptor list and record EMM and ECM PID's.
         void analyzeCADescriptors(const DescriptorList& descs, bool is_ecm);
 
+        // Record the description of one CA PID.
+        void setPID(PID pid, uint16_t cas_id, bool is_ecm, const CADescriptorPtr& desc);
+
         // CAMapper private fields.
-        Report&  _report;
-        SectionDemux      _demux;
-        PIDDescriptionMap _pids;
+        // The description of each CA PID is stored in tables which are indexed by PID value.
+        // The PID sets are updated when a CA PID is found, never recomputed in the packet path.
+        Report&                _report;
+        SectionDemux           _demux;
+        std::vector<uint16_t>  _cas_ids;       // CAS id by PID, zero if not a CA PID.
+        std::vector<CASFamily> _cas_families;  // CAS family by PID.
+        PIDSet                 _ecm_pids;      // All known ECM PID's.
+        PIDSet                 _emm_pids;      // All known EMM PID's.
+        FamilyPIDMap           _family_ecm_pids;
+        FamilyPIDMap           _family_emm_pids;
+        CADescriptorMap        _descs;         // CA descriptor by CA PID.
+        uint32_t               _generation;    // Incremented on each change in the CA PID mapping.
 
         // Hooks
         virtual void handleTable(SectionDemux&, const BinaryTable&) override;
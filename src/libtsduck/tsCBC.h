@@ -56,6 +56,8 @@ namespace ts {
         // Implementation of CipherChaining interface.
         virtual size_t minMessageSize() const override {return this->block_size;}
         virtual bool residueAllowed() const override {return false;}
+        virtual bool encryptMessages(uint8_t* const data[], const size_t sizes[], size_t count) override;
+        virtual bool decryptMessages(uint8_t* const data[], const size_t sizes[], size_t count) override;
 
         // Implementation of BlockCipher interface.
         virtual UString name() const override {return this->algo == 0 ? UString() : this->algo->name() + u"-CBC";}
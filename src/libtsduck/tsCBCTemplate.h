@@ -100,26 +100,37 @@ bool ts::CBC<CIPHER>::decrypt(const void* cipher, size_t cipher_length,
         *plain_length = cipher_length;
     }
 
-    const uint8_t* previous = this->iv.data();
     const uint8_t* ct = reinterpret_cast<const uint8_t*> (cipher);
     uint8_t* pt = reinterpret_cast<uint8_t*> (plain);
 
-    while (cipher_length > 0) {
-        // work = decrypt (cipher-text)
-        if (!this->algo->decrypt(ct, this->block_size, this->work.data(), this->block_size)) {
+    // All blocks are independently decrypted, several blocks at a time.
+    return this->decryptCBC(ct, pt, cipher_length / this->block_size) != 0;
+}
+
+
+//----------------------------------------------------------------------------
+// Encryption / decryption of several messages in CBC mode.
+// The independent chains of all messages are interleaved.
+//----------------------------------------------------------------------------
+
+template<class CIPHER>
+bool ts::CBC<CIPHER>::encryptMessages(uint8_t* const data[], const size_t sizes[], size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        if (sizes[i] % this->block_size != 0) {
             return false;
         }
-        // plain-text = previous-cipher XOR work
-        for (size_t i = 0; i < this->block_size; ++i) {
-            pt[i] = previous[i] ^ this->work[i];
-        }
-        // previous-cipher = cipher-text
-        previous = ct;
-        // advance one block
-        ct += this->block_size;
-        pt += this->block_size;
-        cipher_length -= this->block_size;
     }
+    return this->encryptCBCMessages(data, sizes, count, false);
+}
 
-    return true;
+template<class CIPHER>
+bool ts::CBC<CIPHER>::decryptMessages(uint8_t* const data[], const size_t sizes[], size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        if (sizes[i] % this->block_size != 0) {
+            return false;
+        }
+    }
+    return this->decryptCBCMessages(data, sizes, count, false);
 }
@@ -32,8 +32,23 @@
 //----------------------------------------------------------------------------
 
 #include "tsCRC32.h"
+#include "tsSysInfo.h"
 TSDUCK_SOURCE;
 
+// On x86 processors, the carry-less multiplication (PCLMULQDQ) is used when
+// available at runtime. Only compilers which can generate these instructions
+// in a specific function, without global compilation options, are used.
+#if !defined(TS_NO_PCLMUL) && (defined(TS_I386) || defined(TS_X86_64)) && \
+    (defined(TS_MSC) || defined(TS_LLVM) || (defined(TS_GCC_ONLY) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+    #define TS_CRC32_PCLMUL 1
+    #include <immintrin.h>
+    #if defined(TS_MSC)
+        #define TS_TARGET_PCLMUL
+    #else
+        #define TS_TARGET_PCLMUL __attribute__((target("pclmul,ssse3")))
+    #endif
+#endif
+
 
 // The FCS-32 generator polynomial:
 //     x**0 + x**1 + x**2 + x**4 + x**5 +
@@ -109,13 +124,235 @@ namespace {
     };
 }
 
+//----------------------------------------------------------------------------
+// Derived tables, built once from fcstab_32.
+//
+// The MPEG CRC32 is not reflected: the first byte of the data is the most
+// significant part of the polynomial. Processing a message M of n bytes from
+// a state c gives (c * x**8n + M * x**32) mod P. Consequently, the state can
+// be xor'ed into the first four bytes of the data, and any polynomial which
+// is congruent to M modulo P gives the same CRC32 when processed from zero.
+//----------------------------------------------------------------------------
+
+namespace {
+    class CRC32Tables
+    {
+    public:
+        // slice[k][b] = b * x**(32+8k) mod P, slice[0] is fcstab_32.
+        uint32_t slice[8][256];
+
+        // Folding constants for the carry-less multiplication, 128 and 512 bits ahead.
+        uint64_t fold128_lo;  // x**128 mod P
+        uint64_t fold128_hi;  // x**192 mod P
+        uint64_t fold512_lo;  // x**512 mod P
+        uint64_t fold512_hi;  // x**576 mod P
+
+        // The CPU supports PCLMULQDQ and SSSE3.
+        bool pclmul;
+
+        // Get the unique instance, built on first use.
+        static const CRC32Tables& Instance()
+        {
+            static const CRC32Tables tables;
+            return tables;
+        }
+
+    private:
+        CRC32Tables();
+        static uint32_t PowerModP(size_t n);
+    };
+
+    // Compute x**n mod P.
+    uint32_t CRC32Tables::PowerModP(size_t n)
+    {
+        uint32_t r = 1;
+        while (n-- > 0) {
+            r = (r & 0x80000000) != 0 ? (r << 1) ^ 0x04C11DB7 : r << 1;
+        }
+        return r;
+    }
+
+    CRC32Tables::CRC32Tables() :
+        fold128_lo(PowerModP(128)),
+        fold128_hi(PowerModP(192)),
+        fold512_lo(PowerModP(512)),
+        fold512_hi(PowerModP(576)),
+        pclmul(false)
+    {
+        for (size_t b = 0; b < 256; ++b) {
+            slice[0][b] = fcstab_32[b];
+        }
+        for (size_t k = 1; k < 8; ++k) {
+            for (size_t b = 0; b < 256; ++b) {
+                slice[k][b] = (slice[k-1][b] << 8) ^ fcstab_32[slice[k-1][b] >> 24];
+            }
+        }
+
+#if defined(TS_CRC32_PCLMUL)
+        const ts::SysInfo* sys = ts::SysInfo::Instance();
+        pclmul = sys->cpuHasPCLMUL() && sys->cpuHasSSSE3();
+#endif
+    }
+
+    // Table-driven computation, 8 bytes at a time (slicing-by-8), then byte per byte.
+    inline uint32_t Update(uint32_t fcs, const uint8_t* cp, size_t size, const CRC32Tables& t)
+    {
+        while (size >= 8) {
+            fcs ^= ts::GetUInt32(cp);
+            fcs = t.slice[7][fcs >> 24] ^ t.slice[6][(fcs >> 16) & 0xFF] ^ t.slice[5][(fcs >> 8) & 0xFF] ^ t.slice[4][fcs & 0xFF] ^
+                  t.slice[3][cp[4]] ^ t.slice[2][cp[5]] ^ t.slice[1][cp[6]] ^ t.slice[0][cp[7]];
+            cp += 8;
+            size -= 8;
+        }
+        while (size-- > 0) {
+            fcs = (fcs << 8) ^ fcstab_32[((fcs >> 24) ^ (*cp++)) & 0xFF];
+        }
+        return fcs;
+    }
+
+#if defined(TS_CRC32_PCLMUL)
+
+    // Minimum data size to use the carry-less multiplication.
+    const size_t PCLMUL_MIN_SIZE = 64;
+
+    // Load 16 bytes as a 128-bit polynomial, the first byte being the most significant one.
+    TS_TARGET_PCLMUL inline __m128i Load(const uint8_t* cp, __m128i swap)
+    {
+        return _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(cp)), swap);
+    }
+
+    // Multiply a 128-bit polynomial by x**N, modulo P, with the constants x**N and x**(N+64) mod P.
+    // The result is only congruent modulo P, it still fits in 128 bits.
+    TS_TARGET_PCLMUL inline __m128i Fold(__m128i a, __m128i k)
+    {
+        return _mm_xor_si128(_mm_clmulepi64_si128(a, k, 0x00), _mm_clmulepi64_si128(a, k, 0x11));
+    }
+
+    // Process all complete 16-byte blocks, size must be at least PCLMUL_MIN_SIZE.
+    // Return the CRC32 state, update the data pointer and remaining size.
+    TS_TARGET_PCLMUL uint32_t UpdatePCLMUL(uint32_t fcs, const uint8_t*& cp, size_t& size, const CRC32Tables& t)
+    {
+        const __m128i swap = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+        const __m128i k128 = _mm_set_epi64x(int64_t(t.fold128_hi), int64_t(t.fold128_lo));
+        const __m128i k512 = _mm_set_epi64x(int64_t(t.fold512_hi), int64_t(t.fold512_lo));
+
+        // Four parallel accumulators, 64 bytes at a time. The state goes into the first bytes.
+        __m128i a0 = _mm_xor_si128(Load(cp, swap), _mm_set_epi32(int32_t(fcs), 0, 0, 0));
+        __m128i a1 = Load(cp + 16, swap);
+        __m128i a2 = Load(cp + 32, swap);
+        __m128i a3 = Load(cp + 48, swap);
+        cp += 64;
+        size -= 64;
+        while (size >= 64) {
+            a0 = _mm_xor_si128(Fold(a0, k512), Load(cp, swap));
+            a1 = _mm_xor_si128(Fold(a1, k512), Load(cp + 16, swap));
+            a2 = _mm_xor_si128(Fold(a2, k512), Load(cp + 32, swap));
+            a3 = _mm_xor_si128(Fold(a3, k512), Load(cp + 48, swap));
+            cp += 64;
+            size -= 64;
+        }
+
+        // Merge the accumulators, then the remaining 16-byte blocks.
+        a0 = _mm_xor_si128(Fold(a0, k128), a1);
+        a0 = _mm_xor_si128(Fold(a0, k128), a2);
+        a0 = _mm_xor_si128(Fold(a0, k128), a3);
+        while (size >= 16) {
+            a0 = _mm_xor_si128(Fold(a0, k128), Load(cp, swap));
+            cp += 16;
+            size -= 16;
+        }
+
+        // The final 128-bit polynomial is congruent to the processed data.
+        uint8_t last[16];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(last), _mm_shuffle_epi8(a0, swap));
+        return Update(0, last, sizeof(last), t);
+    }
+
+#endif
+}
+
+
+//----------------------------------------------------------------------------
 // Continue the computation of a data area, following a previous CRC32
+//----------------------------------------------------------------------------
+
+void ts::CRC32::add(const void* data, size_t size)
+{
+    const CRC32Tables& tables(CRC32Tables::Instance());
+    const uint8_t* cp = static_cast<const uint8_t*>(data);
+    uint32_t fcs = _fcs;
+
+#if defined(TS_CRC32_PCLMUL)
+    if (tables.pclmul && size >= PCLMUL_MIN_SIZE) {
+        fcs = UpdatePCLMUL(fcs, cp, size, tables);
+    }
+#endif
+
+    _fcs = Update(fcs, cp, size, tables);
+}
+
+
+//----------------------------------------------------------------------------
+// Incremental update of a CRC32 when a field is modified.
+//----------------------------------------------------------------------------
 
-void ts::CRC32::add (const void* data, size_t size)
+ts::CRC32Delta::CRC32Delta(size_t field_size, size_t trailing_size) :
+    _field_size(0),
+    _trailing_size(0),
+    _table()
 {
-    const uint8_t* cp = static_cast <const uint8_t*> (data);
+    setLayout(field_size, trailing_size);
+}
+
+void ts::CRC32Delta::setLayout(size_t field_size, size_t trailing_size)
+{
+    if (field_size == _field_size && trailing_size == _trailing_size && _table.size() == 256 * field_size) {
+        return;
+    }
+    _field_size = field_size;
+    _trailing_size = trailing_size;
+    _table.resize(256 * field_size);
+    if (field_size == 0) {
+        return;
+    }
 
-    while (size-- > 0) {
-        _fcs = (_fcs << 8) ^ fcstab_32 [((_fcs >> 24) ^ (*cp++)) & 0xFF];
+    // Last byte of the field: from a null state, a byte b gives fcstab_32[b], followed
+    // by trailing_size null bytes. Because of linearity, only the 8 bits are computed.
+    uint32_t* last = &_table[256 * (field_size - 1)];
+    uint32_t bits[8];
+    for (size_t k = 0; k < 8; ++k) {
+        uint32_t fcs = fcstab_32[1 << k];
+        for (size_t n = 0; n < trailing_size; ++n) {
+            fcs = (fcs << 8) ^ fcstab_32[fcs >> 24];
+        }
+        bits[k] = fcs;
+    }
+    for (size_t b = 0; b < 256; ++b) {
+        uint32_t fcs = 0;
+        for (size_t k = 0; k < 8; ++k) {
+            if ((b & (1 << k)) != 0) {
+                fcs ^= bits[k];
+            }
+        }
+        last[b] = fcs;
+    }
+
+    // Each previous byte of the field is followed by one more null byte.
+    for (size_t i = field_size - 1; i > 0; --i) {
+        const uint32_t* next = &_table[256 * i];
+        uint32_t* cur = &_table[256 * (i - 1)];
+        for (size_t b = 0; b < 256; ++b) {
+            cur[b] = (next[b] << 8) ^ fcstab_32[next[b] >> 24];
+        }
+    }
+}
+
+uint32_t ts::CRC32Delta::update(uint32_t crc, const void* old_field, const void* new_field) const
+{
+    const uint8_t* op = static_cast<const uint8_t*>(old_field);
+    const uint8_t* np = static_cast<const uint8_t*>(new_field);
+    for (size_t i = 0; i < _field_size; ++i) {
+        crc ^= _table[256 * i + (op[i] ^ np[i])];
     }
+    return crc;
 }
@@ -164,6 +164,64 @@ namespace ts {
         uint32_t _fcs;
     };
 
+    //!
+    //! Incremental update of a CRC32 when a field is modified in a data area.
+    //!
+    //! The CRC32 is linear: when some bytes are modified in a data area of constant size,
+    //! the new CRC32 is the previous one, xor'ed with the CRC32 (from a null state) of the
+    //! difference between the old and new bytes, followed by the unmodified bytes up to
+    //! the end of the area as null bytes.
+    //!
+    //! An instance of this class is built for a given layout: the size of the modified
+    //! field and the number of bytes after the field in the area. The contribution of all
+    //! possible byte values at each position of the field is precomputed. Updating the
+    //! CRC32 then costs one table lookup per byte of the field, regardless of the size
+    //! of the data area.
+    //!
+    class TSDUCKDLL CRC32Delta
+    {
+    public:
+        //!
+        //! Constructor.
+        //! @param [in] field_size Size in bytes of the modified field.
+        //! @param [in] trailing_size Number of bytes after the field in the data area.
+        //!
+        CRC32Delta(size_t field_size = 0, size_t trailing_size = 0);
+
+        //!
+        //! Set a new layout. The precomputed tables are rebuilt only when the layout changes.
+        //! @param [in] field_size Size in bytes of the modified field.
+        //! @param [in] trailing_size Number of bytes after the field in the data area.
+        //!
+        void setLayout(size_t field_size, size_t trailing_size);
+
+        //!
+        //! Get the size of the modified field.
+        //! @return The size in bytes of the modified field.
+        //!
+        size_t fieldSize() const {return _field_size;}
+
+        //!
+        //! Get the number of bytes after the field in the data area.
+        //! @return The number of bytes after the field in the data area.
+        //!
+        size_t trailingSize() const {return _trailing_size;}
+
+        //!
+        //! Compute the CRC32 of a data area after modification of the field.
+        //! @param [in] crc The CRC32 of the data area before modification.
+        //! @param [in] old_field Address of the previous content of the field (fieldSize() bytes).
+        //! @param [in] new_field Address of the new content of the field (fieldSize() bytes).
+        //! @return The CRC32 of the data area with the new content of the field.
+        //!
+        uint32_t update(uint32_t crc, const void* old_field, const void* new_field) const;
+
+    private:
+        size_t _field_size;
+        size_t _trailing_size;
+        std::vector<uint32_t> _table;  // Contribution of byte value b at field position i: _table[256*i+b]
+    };
+
     //!
     //! Comparison operator between a CRC32 instance and a 32-bit integer.
     //! The reversed form of operators is a member function.
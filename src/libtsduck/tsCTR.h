@@ -0,0 +1,145 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Counter (CTR) mode.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsCipherChaining.h"
+
+namespace ts {
+    //!
+    //! Counter (CTR) mode, as defined in NIST SP 800-38A.
+    //!
+    //! The IV is the initial counter block. The successive counter blocks are
+    //! encrypted to produce a keystream which is XOR'ed with the message. Since
+    //! the counter blocks are independent, the keystream is computed several
+    //! blocks at a time, using the parallel implementation of the block cipher
+    //! when there is one (AES-NI for instance).
+    //!
+    //! This is a stream mode: there is no padding and the message size can be
+    //! any number of bytes. Encryption and decryption are identical.
+    //!
+    //! The initial counter block of a message is the IV, incremented by a counter
+    //! offset in blocks (zero by default, see setCounterOffset()). In encryptMessages()
+    //! and decryptMessages(), the messages use consecutive counter blocks: each message
+    //! starts at the counter block which follows the last block of the previous one.
+    //!
+    //! A counter block must never be used twice with the same key, this would reuse
+    //! the keystream and disclose the XOR of the two plain texts. When the messages
+    //! are processed in successive calls, the application must advance the counter
+    //! offset by the number of blocks of the previous messages (see counterBlocks()).
+    //!
+    //! @tparam CIPHER A subclass of ts::BlockCipher, the underlying block cipher.
+    //!
+    template <class CIPHER>
+    class CTR: public CipherChainingTemplate<CIPHER>
+    {
+    public:
+        //!
+        //! Constructor.
+        //! @param [in] counter_bits Number of least significant bits of the counter
+        //! block which are incremented. Zero means the full counter block.
+        //!
+        CTR(size_t counter_bits = 0);
+
+        //!
+        //! Set the size of the counter inside the counter block.
+        //! @param [in] counter_bits Number of least significant bits of the counter
+        //! block which are incremented, the other bits are a fixed nonce. Zero or a
+        //! value larger than the block size means the full counter block.
+        //!
+        void setCounterBits(size_t counter_bits);
+
+        //!
+        //! Get the size of the counter inside the counter block.
+        //! @return Number of least significant bits of the counter block which are incremented.
+        //!
+        size_t counterBits() const;
+
+        //!
+        //! Set the offset of the initial counter block of the next messages from the IV.
+        //! @param [in] offset Number of counter blocks to skip after the IV.
+        //!
+        void setCounterOffset(uint64_t offset) {_offset = offset;}
+
+        //!
+        //! Get the offset of the initial counter block of the next messages from the IV.
+        //! @return Number of counter blocks which are skipped after the IV.
+        //!
+        uint64_t counterOffset() const {return _offset;}
+
+        //!
+        //! Get the number of counter blocks which are used by a message.
+        //! @param [in] size Message size in bytes.
+        //! @return Number of counter blocks which are used by the message.
+        //!
+        size_t counterBlocks(size_t size) const {return (size + this->block_size - 1) / this->block_size;}
+
+        // Implementation of CipherChaining interface.
+        virtual size_t minMessageSize() const override {return 0;}
+        virtual bool residueAllowed() const override {return true;}
+        virtual bool encryptMessages(uint8_t* const data[], const size_t sizes[], size_t count) override;
+        virtual bool decryptMessages(uint8_t* const data[], const size_t sizes[], size_t count) override;
+
+        // Implementation of BlockCipher interface.
+        virtual UString name() const override {return this->algo == 0 ? UString() : this->algo->name() + u"-CTR";}
+        virtual bool encrypt(const void* plain, size_t plain_length,
+                             void* cipher, size_t cipher_maxsize,
+                             size_t* cipher_length = 0) override;
+        virtual bool decrypt(const void* cipher, size_t cipher_length,
+                             void* plain, size_t plain_maxsize,
+                             size_t* plain_length = 0) override;
+
+    private:
+        // Number of keystream blocks which are computed at a time in encrypt().
+        static const size_t KEYSTREAM_BLOCKS = 8;
+
+        size_t    _counter_bits;  // Number of incremented bits in the counter block, zero means all.
+        uint64_t  _offset;        // Offset of the initial counter block from the IV.
+        ByteBlock _keystream;     // Keystream of all messages in encryptMessages().
+
+        // Fill consecutive counter blocks, starting at a counter block which is updated.
+        void fillCounters(uint8_t* blocks, size_t count, uint8_t* counter) const;
+
+        // Increment a counter block.
+        void incrementCounter(uint8_t* counter) const;
+
+        // Set the initial counter block of the next messages in the work area and return its address.
+        uint8_t* initialCounter();
+
+        // Apply the keystream on several messages in place.
+        bool processMessages(uint8_t* const data[], const size_t sizes[], size_t count);
+    };
+}
+
+#include "tsCTRTemplate.h"
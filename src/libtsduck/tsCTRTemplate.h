@@ -0,0 +1,251 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+//
+//  Counter (CTR) mode.
+//  Template class using a BlockCipher subclass as template argument.
+//
+//----------------------------------------------------------------------------
+
+#pragma once
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+template<class CIPHER>
+const size_t ts::CTR<CIPHER>::KEYSTREAM_BLOCKS;
+#endif
+
+
+//----------------------------------------------------------------------------
+// Constructor. The work area contains the keystream blocks, followed by the
+// running counter block.
+//----------------------------------------------------------------------------
+
+template<class CIPHER>
+ts::CTR<CIPHER>::CTR(size_t counter_bits) :
+    CipherChainingTemplate<CIPHER>(1, 1, KEYSTREAM_BLOCKS + 1),
+    _counter_bits(0),
+    _offset(0),
+    _keystream()
+{
+    setCounterBits(counter_bits);
+}
+
+
+//----------------------------------------------------------------------------
+// Size of the counter inside the counter block.
+//----------------------------------------------------------------------------
+
+template<class CIPHER>
+void ts::CTR<CIPHER>::setCounterBits(size_t counter_bits)
+{
+    _counter_bits = counter_bits >= 8 * this->block_size ? 0 : counter_bits;
+}
+
+template<class CIPHER>
+size_t ts::CTR<CIPHER>::counterBits() const
+{
+    return _counter_bits == 0 ? 8 * this->block_size : _counter_bits;
+}
+
+
+//----------------------------------------------------------------------------
+// Increment a counter block, as a big endian integer, in its counter bits.
+//----------------------------------------------------------------------------
+
+template<class CIPHER>
+void ts::CTR<CIPHER>::incrementCounter(uint8_t* counter) const
+{
+    size_t bits = counterBits();
+    for (size_t i = this->block_size; bits > 0 && i-- > 0; ) {
+        if (bits >= 8) {
+            if (++counter[i] != 0) {
+                return; // no carry
+            }
+            bits -= 8;
+        }
+        else {
+            const uint8_t mask = uint8_t((1 << bits) - 1);
+            counter[i] = uint8_t((counter[i] & ~mask) | ((counter[i] + 1) & mask));
+            return;
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Set the initial counter block in the work area: IV + offset, as a big
+// endian integer, in the counter bits.
+//----------------------------------------------------------------------------
+
+template<class CIPHER>
+uint8_t* ts::CTR<CIPHER>::initialCounter()
+{
+    uint8_t* counter = this->work.data() + KEYSTREAM_BLOCKS * this->block_size;
+    ::memcpy(counter, this->iv.data(), this->block_size);
+
+    uint64_t offset = _offset;
+    unsigned int carry = 0;
+    size_t bits = counterBits();
+    for (size_t i = this->block_size; bits > 0 && (offset != 0 || carry != 0) && i-- > 0; ) {
+        const unsigned int sum = counter[i] + unsigned(offset & 0xFF) + carry;
+        offset >>= 8;
+        if (bits >= 8) {
+            counter[i] = uint8_t(sum);
+            carry = sum >> 8;
+            bits -= 8;
+        }
+        else {
+            const uint8_t mask = uint8_t((1 << bits) - 1);
+            counter[i] = uint8_t((counter[i] & ~mask) | (sum & mask));
+            bits = 0;
+        }
+    }
+    return counter;
+}
+
+
+//----------------------------------------------------------------------------
+// Fill consecutive counter blocks.
+//----------------------------------------------------------------------------
+
+template<class CIPHER>
+void ts::CTR<CIPHER>::fillCounters(uint8_t* blocks, size_t count, uint8_t* counter) const
+{
+    for (; count > 0; --count, blocks += this->block_size) {
+        ::memcpy(blocks, counter, this->block_size);
+        incrementCounter(counter);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Encryption in CTR mode.
+//----------------------------------------------------------------------------
+
+template<class CIPHER>
+bool ts::CTR<CIPHER>::encrypt(const void* plain, size_t plain_length,
+                                void* cipher, size_t cipher_maxsize,
+                                size_t* cipher_length)
+{
+    if (this->algo == 0 ||
+        this->iv.size() != this->block_size ||
+        this->work.size() < (KEYSTREAM_BLOCKS + 1) * this->block_size ||
+        cipher_maxsize < plain_length) {
+        return false;
+    }
+    if (cipher_length != 0) {
+        *cipher_length = plain_length;
+    }
+
+    const uint8_t* pt = reinterpret_cast<const uint8_t*>(plain);
+    uint8_t* ct = reinterpret_cast<uint8_t*>(cipher);
+    uint8_t* keystream = this->work.data();
+    uint8_t* counter = initialCounter();
+
+    while (plain_length > 0) {
+        // Encrypt up to KEYSTREAM_BLOCKS counter blocks at a time.
+        const size_t blocks = std::min<size_t>(KEYSTREAM_BLOCKS, (plain_length + this->block_size - 1) / this->block_size);
+        fillCounters(keystream, blocks, counter);
+        if (!this->algo->encryptBlocks(keystream, keystream, blocks)) {
+            return false;
+        }
+        // cipher-text = plain-text XOR keystream, the last block may be partial.
+        const size_t size = std::min(plain_length, blocks * this->block_size);
+        for (size_t i = 0; i < size; ++i) {
+            ct[i] = pt[i] ^ keystream[i];
+        }
+        ct += size;
+        pt += size;
+        plain_length -= size;
+    }
+
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Decryption in CTR mode: same as encryption.
+//----------------------------------------------------------------------------
+
+template<class CIPHER>
+bool ts::CTR<CIPHER>::decrypt(const void* cipher, size_t cipher_length,
+                                void* plain, size_t plain_maxsize,
+                                size_t* plain_length)
+{
+    return encrypt(cipher, cipher_length, plain, plain_maxsize, plain_length);
+}
+
+
+//----------------------------------------------------------------------------
+// Encryption / decryption of several messages in CTR mode.
+// The messages use consecutive counter blocks, never the same keystream.
+// The keystream of all messages is computed in one call to the cipher.
+//----------------------------------------------------------------------------
+
+template<class CIPHER>
+bool ts::CTR<CIPHER>::encryptMessages(uint8_t* const data[], const size_t sizes[], size_t count)
+{
+    return processMessages(data, sizes, count);
+}
+
+template<class CIPHER>
+bool ts::CTR<CIPHER>::decryptMessages(uint8_t* const data[], const size_t sizes[], size_t count)
+{
+    return processMessages(data, sizes, count);
+}
+
+template<class CIPHER>
+bool ts::CTR<CIPHER>::processMessages(uint8_t* const data[], const size_t sizes[], size_t count)
+{
+    if (this->algo == 0 || this->iv.size() != this->block_size || this->work.size() < (KEYSTREAM_BLOCKS + 1) * this->block_size) {
+        return false;
+    }
+
+    // Compute the keystream for all messages, each message starts on a new counter block.
+    size_t blocks = 0;
+    for (size_t i = 0; i < count; ++i) {
+        blocks += counterBlocks(sizes[i]);
+    }
+    _keystream.resize(blocks * this->block_size);
+    fillCounters(_keystream.data(), blocks, initialCounter());
+    if (!this->algo->encryptBlocks(_keystream.data(), _keystream.data(), blocks)) {
+        return false;
+    }
+
+    // Apply the keystream on all messages.
+    const uint8_t* keystream = _keystream.data();
+    for (size_t m = 0; m < count; ++m) {
+        uint8_t* const msg = data[m];
+        for (size_t i = 0; i < sizes[m]; ++i) {
+            msg[i] ^= keystream[i];
+        }
+        keystream += counterBlocks(sizes[m]) * this->block_size;
+    }
+    return true;
+}
@@ -144,26 +144,17 @@ bool ts::CTS1<CIPHER>::decrypt (const void* cipher, size_t cipher_length,
     // Decrypt blocks in CBC mode.
     // Stop before the last two blocks (complete one + possibly-partial one).
 
-    const uint8_t* previous = this->iv.data();
     const uint8_t* ct = reinterpret_cast<const uint8_t*> (cipher);
     uint8_t* pt = reinterpret_cast<uint8_t*> (plain);
 
-    while (cipher_length > 2 * this->block_size) {
-        // work = decrypt (cipher-text)
-        if (!this->algo->decrypt(ct, this->block_size, this->work.data(), this->block_size)) {
-            return false;
-        }
-        // plain-text = previous-cipher XOR work
-        for (size_t i = 0; i < this->block_size; ++i) {
-            pt[i] = previous[i] ^ this->work[i];
-        }
-        // previous-cipher = cipher-text
-        previous = ct;
-        // advance one block
-        ct += this->block_size;
-        pt += this->block_size;
-        cipher_length -= this->block_size;
+    const size_t count = (cipher_length - this->block_size - 1) / this->block_size;
+    const uint8_t* const previous = this->decryptCBC(ct, pt, count);
+    if (previous == 0) {
+        return false;
     }
+    ct += count * this->block_size;
+    pt += count * this->block_size;
+    cipher_length -= count * this->block_size;
 
     // Process final two blocks.
     // The remaining size is exactly one complete block plus a partial one.
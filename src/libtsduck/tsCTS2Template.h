@@ -126,29 +126,20 @@ bool ts::CTS2<CIPHER>::decrypt (const void* cipher, size_t cipher_length,
     // Decrypt blocks in CBC mode. If the last block is partial,
     // stop before the last two blocks (complete one + partial one).
 
-    const uint8_t* previous = this->iv.data();
     const uint8_t* ct = reinterpret_cast<const uint8_t*> (cipher);
     uint8_t* pt = reinterpret_cast<uint8_t*> (plain);
 
     const size_t residue_size = cipher_length % this->block_size;
     const size_t trick_size = residue_size == 0 ? 0 : this->block_size + residue_size;
 
-    while (cipher_length > trick_size) {
-        // work = decrypt (cipher-text)
-        if (!this->algo->decrypt (ct, this->block_size, this->work.data(), this->block_size)) {
-            return false;
-        }
-        // plain-text = previous-cipher XOR work
-        for (size_t i = 0; i < this->block_size; ++i) {
-            pt[i] = previous[i] ^ this->work[i];
-        }
-        // previous-cipher = cipher-text
-        previous = ct;
-        // advance one block
-        ct += this->block_size;
-        pt += this->block_size;
-        cipher_length -= this->block_size;
+    const size_t count = (cipher_length - trick_size) / this->block_size;
+    const uint8_t* const previous = this->decryptCBC(ct, pt, count);
+    if (previous == 0) {
+        return false;
     }
+    ct += count * this->block_size;
+    pt += count * this->block_size;
+    cipher_length -= count * this->block_size;
 
     // Process final two blocks.
 
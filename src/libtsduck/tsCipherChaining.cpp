@@ -41,7 +41,11 @@ ts::CipherChaining::CipherChaining (BlockCipher* cipher, size_t iv_min_blocks, s
     iv(iv_max_blocks * block_size),
     work(work_blocks * block_size),
     _iv_min_size(iv_min_blocks * block_size),
-    _iv_max_size(iv_max_blocks * block_size)
+    _iv_max_size(iv_max_blocks * block_size),
+    _cbc_work((CBC_BLOCKS + 1) * block_size),
+    _msg_in(),
+    _msg_out(),
+    _msg_index()
 {
 }
 
@@ -110,3 +114,221 @@ bool ts::CipherChaining::setIV(const void* iv_data, size_t iv_length)
         return true;
     }
 }
+
+
+//----------------------------------------------------------------------------
+// Decrypt complete blocks in CBC mode, several blocks at a time.
+//----------------------------------------------------------------------------
+
+const uint8_t* ts::CipherChaining::decryptCBC(const uint8_t* cipher, uint8_t* plain, size_t count)
+{
+    if (algo == 0 || iv.size() != block_size || _cbc_work.size() < (CBC_BLOCKS + 1) * block_size) {
+        return 0;
+    }
+
+    uint8_t* const work_data = _cbc_work.data();
+    uint8_t* const previous = work_data + CBC_BLOCKS * block_size;
+    ::memcpy(previous, iv.data(), block_size);  // Flawfinder: ignore: memcpy()
+
+    while (count > 0) {
+        const size_t blocks = count < CBC_BLOCKS ? count : CBC_BLOCKS;
+        const size_t size = blocks * block_size;
+
+        // work = decrypt (cipher-text)
+        if (!algo->decryptBlocks(cipher, work_data, blocks)) {
+            return 0;
+        }
+        // work = work XOR previous-cipher, all cipher blocks are still available
+        for (size_t i = block_size; i < size; ++i) {
+            work_data[i] ^= cipher[i - block_size];
+        }
+        for (size_t i = 0; i < block_size; ++i) {
+            work_data[i] ^= previous[i];
+        }
+        // previous-cipher = last cipher-text, before it is overwritten in case of in-place decryption
+        ::memcpy(previous, cipher + size - block_size, block_size);  // Flawfinder: ignore: memcpy()
+        // plain-text = work
+        ::memcpy(plain, work_data, size);  // Flawfinder: ignore: memcpy()
+
+        cipher += size;
+        plain += size;
+        count -= blocks;
+    }
+    return previous;
+}
+
+
+//----------------------------------------------------------------------------
+// Default encryption / decryption of several messages: one at a time.
+//----------------------------------------------------------------------------
+
+bool ts::CipherChaining::encryptMessages(uint8_t* const data[], const size_t sizes[], size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        _msg_out.resize(sizes[i]);
+        if (!encrypt(data[i], sizes[i], _msg_out.data(), sizes[i])) {
+            return false;
+        }
+        ::memcpy(data[i], _msg_out.data(), sizes[i]);  // Flawfinder: ignore: memcpy()
+    }
+    return true;
+}
+
+bool ts::CipherChaining::decryptMessages(uint8_t* const data[], const size_t sizes[], size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        _msg_out.resize(sizes[i]);
+        if (!decrypt(data[i], sizes[i], _msg_out.data(), sizes[i])) {
+            return false;
+        }
+        ::memcpy(data[i], _msg_out.data(), sizes[i]);  // Flawfinder: ignore: memcpy()
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Encrypt several messages in CBC mode, interleaving the independent chains.
+//----------------------------------------------------------------------------
+
+bool ts::CipherChaining::encryptCBCMessages(uint8_t* const data[], const size_t sizes[], size_t count, bool residue)
+{
+    if (algo == 0 || iv.size() != block_size) {
+        return false;
+    }
+
+    _msg_in.resize(count * block_size);
+    _msg_index.resize(count);
+
+    // Process the blocks with the same index in all messages (including a final partial block).
+    for (size_t offset = 0; ; offset += block_size) {
+
+        // Collect one block per message: previous-cipher XOR plain-text.
+        uint8_t* in = _msg_in.data();
+        size_t blocks = 0;
+        for (size_t msg = 0; msg < count; ++msg) {
+            const uint8_t* const previous = offset == 0 ? iv.data() : data[msg] + offset - block_size;
+            if (offset + block_size <= sizes[msg]) {
+                // Complete block.
+                const uint8_t* const pt = data[msg] + offset;
+                for (size_t i = 0; i < block_size; ++i) {
+                    in[i] = previous[i] ^ pt[i];
+                }
+            }
+            else if (residue && offset > 0 && offset < sizes[msg]) {
+                // Final partial block: encrypt the previous cipher block.
+                ::memcpy(in, previous, block_size);  // Flawfinder: ignore: memcpy()
+            }
+            else {
+                continue;
+            }
+            _msg_index[blocks++] = msg;
+            in += block_size;
+        }
+        if (blocks == 0) {
+            return true;
+        }
+
+        // Encrypt all blocks in parallel.
+        if (!algo->encryptBlocks(_msg_in.data(), _msg_in.data(), blocks)) {
+            return false;
+        }
+
+        // Store cipher blocks in the messages.
+        in = _msg_in.data();
+        for (size_t b = 0; b < blocks; ++b) {
+            const size_t msg = _msg_index[b];
+            uint8_t* const ct = data[msg] + offset;
+            if (offset + block_size <= sizes[msg]) {
+                ::memcpy(ct, in, block_size);  // Flawfinder: ignore: memcpy()
+            }
+            else {
+                for (size_t i = 0; i < sizes[msg] - offset; ++i) {
+                    ct[i] ^= in[i];
+                }
+            }
+            in += block_size;
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Decrypt several messages in CBC mode, all blocks at once.
+//----------------------------------------------------------------------------
+
+bool ts::CipherChaining::decryptCBCMessages(uint8_t* const data[], const size_t sizes[], size_t count, bool residue)
+{
+    if (algo == 0 || iv.size() != block_size) {
+        return false;
+    }
+
+    // Collect all complete cipher blocks. They are kept in _msg_in since
+    // the decrypted blocks must be XOR'ed with the previous cipher block.
+    size_t total = 0;
+    for (size_t msg = 0; msg < count; ++msg) {
+        total += sizes[msg] / block_size;
+    }
+    _msg_in.resize(total * block_size);
+    _msg_out.resize(std::max(total, count) * block_size);
+    uint8_t* in = _msg_in.data();
+    for (size_t msg = 0; msg < count; ++msg) {
+        const size_t size = sizes[msg] - sizes[msg] % block_size;
+        ::memcpy(in, data[msg], size);  // Flawfinder: ignore: memcpy()
+        in += size;
+    }
+
+    // Decrypt all blocks in parallel.
+    if (total > 0 && !algo->decryptBlocks(_msg_in.data(), _msg_out.data(), total)) {
+        return false;
+    }
+
+    // plain-text = decrypted-block XOR previous-cipher
+    in = _msg_in.data();
+    const uint8_t* out = _msg_out.data();
+    for (size_t msg = 0; msg < count; ++msg) {
+        const size_t size = sizes[msg] - sizes[msg] % block_size;
+        uint8_t* const pt = data[msg];
+        for (size_t i = 0; i < size && i < block_size; ++i) {
+            pt[i] = out[i] ^ iv[i];
+        }
+        for (size_t i = block_size; i < size; ++i) {
+            pt[i] = out[i] ^ in[i - block_size];
+        }
+        in += size;
+        out += size;
+    }
+    if (!residue) {
+        return true;
+    }
+
+    // Process final partial blocks: plain-text = cipher-text XOR encrypt (previous-cipher).
+    // The last complete cipher block of each message is still in _msg_in.
+    size_t blocks = 0;
+    in = _msg_in.data();
+    uint8_t* work_data = _msg_out.data();
+    _msg_index.resize(count);
+    for (size_t msg = 0; msg < count; ++msg) {
+        const size_t size = sizes[msg] - sizes[msg] % block_size;
+        in += size;
+        if (size > 0 && size < sizes[msg]) {
+            ::memcpy(work_data, in - block_size, block_size);  // Flawfinder: ignore: memcpy()
+            work_data += block_size;
+            _msg_index[blocks++] = msg;
+        }
+    }
+    if (blocks > 0 && !algo->encryptBlocks(_msg_out.data(), _msg_out.data(), blocks)) {
+        return false;
+    }
+    work_data = _msg_out.data();
+    for (size_t b = 0; b < blocks; ++b) {
+        const size_t msg = _msg_index[b];
+        const size_t size = sizes[msg] - sizes[msg] % block_size;
+        uint8_t* const pt = data[msg] + size;
+        for (size_t i = 0; i < sizes[msg] - size; ++i) {
+            pt[i] ^= work_data[i];
+        }
+        work_data += block_size;
+    }
+    return true;
+}
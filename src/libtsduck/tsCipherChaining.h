@@ -90,6 +90,36 @@ namespace ts {
         //!
         virtual bool residueAllowed() const = 0;
 
+        //!
+        //! Encrypt several independent messages in place.
+        //!
+        //! Each message is encrypted from the current IV, as if encrypt() was invoked
+        //! on each of them. Typically used to encrypt the payloads of many TS packets
+        //! with the same key and IV. Chaining modes where the messages can be interleaved
+        //! (CBC and similar modes) override this method to encrypt blocks from distinct
+        //! messages in one call to BlockCipher::encryptBlocks(), using all parallel lanes
+        //! of the block cipher. The default implementation invokes encrypt() on each message.
+        //!
+        //! @param [in,out] data Array of @a count addresses of messages to encrypt in place.
+        //! @param [in] sizes Array of @a count message sizes in bytes.
+        //! @param [in] count Number of messages.
+        //! @return True on success, false on error. On error, the content of the messages is undefined.
+        //!
+        virtual bool encryptMessages(uint8_t* const data[], const size_t sizes[], size_t count);
+
+        //!
+        //! Decrypt several independent messages in place.
+        //!
+        //! Each message is decrypted from the current IV, as if decrypt() was invoked
+        //! on each of them. See encryptMessages() for details.
+        //!
+        //! @param [in,out] data Array of @a count addresses of messages to decrypt in place.
+        //! @param [in] sizes Array of @a count message sizes in bytes.
+        //! @param [in] count Number of messages.
+        //! @return True on success, false on error. On error, the content of the messages is undefined.
+        //!
+        virtual bool decryptMessages(uint8_t* const data[], const size_t sizes[], size_t count);
+
     protected:
         // Protected fields, for chaining mode subclass implementation.
         BlockCipher* algo;        //!< An instance of the block cipher.
@@ -109,10 +139,54 @@ namespace ts {
                        size_t iv_max_blocks = 1,
                        size_t work_blocks = 1);
 
+        //!
+        //! Decrypt complete blocks in CBC mode, starting with the current IV.
+        //! Several blocks are decrypted at a time using BlockCipher::decryptBlocks().
+        //! @param [in] cipher Address of cipher text, @a count blocks.
+        //! @param [out] plain Address of buffer for plain text, @a count blocks.
+        //! The buffer may be identical to @a cipher (in-place decryption) but shall not partially overlap it.
+        //! @param [in] count Number of blocks.
+        //! @return Address of a copy of the last cipher block (the IV if @a count is zero) or zero on error.
+        //! This block remains valid until the next call to decryptCBC().
+        //!
+        const uint8_t* decryptCBC(const uint8_t* cipher, uint8_t* plain, size_t count);
+
+        //!
+        //! Encrypt several independent messages in place in CBC mode, starting each message with the current IV.
+        //! The messages are processed in parallel: the blocks with the same index in all messages are
+        //! encrypted in one call to BlockCipher::encryptBlocks().
+        //! @param [in,out] data Array of @a count addresses of messages to encrypt in place.
+        //! @param [in] sizes Array of @a count message sizes in bytes.
+        //! @param [in] count Number of messages.
+        //! @param [in] residue If true, a trailing partial block is processed as in DVS 042 mode
+        //! (XOR with the encrypted previous cipher block). If false, it is left unmodified.
+        //! @return True on success, false on error.
+        //!
+        bool encryptCBCMessages(uint8_t* const data[], const size_t sizes[], size_t count, bool residue);
+
+        //!
+        //! Decrypt several independent messages in place in CBC mode, starting each message with the current IV.
+        //! The complete blocks of all messages are decrypted in one call to BlockCipher::decryptBlocks().
+        //! @param [in,out] data Array of @a count addresses of messages to decrypt in place.
+        //! @param [in] sizes Array of @a count message sizes in bytes.
+        //! @param [in] count Number of messages.
+        //! @param [in] residue If true, a trailing partial block is processed as in DVS 042 mode
+        //! (XOR with the encrypted previous cipher block). If false, it is left unmodified.
+        //! @return True on success, false on error.
+        //!
+        bool decryptCBCMessages(uint8_t* const data[], const size_t sizes[], size_t count, bool residue);
+
     private:
+        // Number of blocks which are decrypted at a time in decryptCBC().
+        static const size_t CBC_BLOCKS = 8;
+
         // Private fields
-        size_t _iv_min_size;  // IV min size in bytes
-        size_t _iv_max_size;  // IV max size in bytes
+        size_t    _iv_min_size;  // IV min size in bytes
+        size_t    _iv_max_size;  // IV max size in bytes
+        ByteBlock _cbc_work;     // CBC_BLOCKS decrypted blocks, followed by the previous cipher block
+        ByteBlock _msg_in;       // Blocks from several messages, input of encryptBlocks() / decryptBlocks()
+        ByteBlock _msg_out;      // Blocks from several messages, output of encryptBlocks() / decryptBlocks()
+        std::vector<size_t> _msg_index;  // Message index of each block in _msg_in
 
         // Inaccesible operations
         CipherChaining(const CipherChaining&) = delete;
@@ -0,0 +1,106 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "tsCoarseClock.h"
+TSDUCK_SOURCE;
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const ts::MilliSecond ts::CoarseClock::DEFAULT_RESYNC;
+#endif
+
+
+//----------------------------------------------------------------------------
+// Constructor.
+//----------------------------------------------------------------------------
+
+ts::CoarseClock::CoarseClock(MilliSecond resync) :
+    _resync(resync),
+    _synced(false),
+    _local_synced(false),
+    _coarse_base(0),
+    _utc_base(),
+    _local_base()
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Get the current value of the coarse monotonic clock.
+//----------------------------------------------------------------------------
+
+ts::NanoSecond ts::CoarseClock::CoarseNanoSeconds()
+{
+#if defined(TS_WINDOWS)
+    return NanoSecond(::GetTickCount64()) * NanoSecPerMilliSec;
+#elif defined(TS_MAC)
+    return Time::UnixClockNanoSeconds(CLOCK_REALTIME);
+#elif defined(CLOCK_MONOTONIC_COARSE)
+    return Time::UnixClockNanoSeconds(CLOCK_MONOTONIC_COARSE);
+#else
+    return Time::UnixClockNanoSeconds(CLOCK_MONOTONIC);
+#endif
+}
+
+
+//----------------------------------------------------------------------------
+// Number of milliseconds since last synchronization.
+//----------------------------------------------------------------------------
+
+ts::MilliSecond ts::CoarseClock::elapsed()
+{
+    const NanoSecond now = CoarseNanoSeconds();
+    if (!_synced || now < _coarse_base || now - _coarse_base >= _resync * NanoSecPerMilliSec) {
+        _coarse_base = now;
+        _utc_base = Time::CurrentUTC();
+        _synced = true;
+        _local_synced = false;
+        return 0;
+    }
+    return (now - _coarse_base) / NanoSecPerMilliSec;
+}
+
+
+//----------------------------------------------------------------------------
+// Get the current UTC and local time.
+//----------------------------------------------------------------------------
+
+ts::Time ts::CoarseClock::utc()
+{
+    const MilliSecond ms = elapsed();
+    return _utc_base + ms;
+}
+
+ts::Time ts::CoarseClock::localTime()
+{
+    const MilliSecond ms = elapsed();
+    if (!_local_synced) {
+        _local_base = _utc_base.UTCToLocal();
+        _local_synced = true;
+    }
+    return _local_base + ms;
+}
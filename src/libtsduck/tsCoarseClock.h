@@ -0,0 +1,100 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Coarse-grained and cheap system clock.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsTime.h"
+
+namespace ts {
+    //!
+    //! Coarse-grained and cheap system clock, for time-driven processing in packet loops.
+    //!
+    //! Reading the system time and converting it to local time for each packet is
+    //! expensive. Here, the current time is derived from a coarse monotonic clock
+    //! (a resolution of a few milliseconds, read without system call on most systems)
+    //! plus a cached offset to the system time. The offsets to the UTC and local time
+    //! are resynchronized with the system time periodically, so that adjustments of
+    //! the system clock and daylight saving time changes are taken into account.
+    //!
+    //! An instance of this class is not thread-safe. Each thread or plugin uses its own instance.
+    //!
+    class TSDUCKDLL CoarseClock
+    {
+    public:
+        //!
+        //! Default resynchronization period with the system time: one second.
+        //!
+        static const MilliSecond DEFAULT_RESYNC = 1000;
+
+        //!
+        //! Constructor.
+        //! @param [in] resync Resynchronization period with the system time in milliseconds.
+        //!
+        explicit CoarseClock(MilliSecond resync = DEFAULT_RESYNC);
+
+        //!
+        //! Get the current UTC time.
+        //! @return The current UTC time, with the resolution of the coarse clock.
+        //!
+        Time utc();
+
+        //!
+        //! Get the current local time.
+        //! @return The current local time, with the resolution of the coarse clock.
+        //!
+        Time localTime();
+
+        //!
+        //! Force a resynchronization with the system time at next access.
+        //!
+        void reset() {_synced = _local_synced = false;}
+
+        //!
+        //! Get the current value of the coarse monotonic clock.
+        //! The origin of the clock is unspecified, only differences are significant.
+        //! @return The current value of the coarse monotonic clock in nanoseconds.
+        //!
+        static NanoSecond CoarseNanoSeconds();
+
+    private:
+        MilliSecond _resync;        // Resynchronization period
+        bool        _synced;        // The UTC base is valid
+        bool        _local_synced;  // The local time base is valid
+        NanoSecond  _coarse_base;   // Coarse clock value at last synchronization
+        Time        _utc_base;      // UTC time at last synchronization
+        Time        _local_base;    // Local time at last synchronization
+
+        // Get the number of milliseconds since last synchronization, resynchronize when necessary.
+        MilliSecond elapsed();
+    };
+}
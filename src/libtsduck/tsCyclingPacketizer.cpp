@@ -168,21 +168,10 @@ void ts::CyclingPacketizer::removeSections(SectionDescList& list, TID tid, uint1
 {
     SectionDescList::iterator it(list.begin());
     while (it != list.end()) {
-        const SectionDescPtr& sp(*it);
-        const Section& sect(*sp->section);
+        const Section& sect(*(*it)->section);
         if (sect.tableId() == tid && (!use_tid_ext || sect.tableIdExtension() == tid_ext)) {
             // Section match, remove it
-            assert(_section_count > 0);
-            _section_count--;
-            if (sp->last_cycle != _current_cycle) {
-                assert(_remain_in_cycle > 0);
-                _remain_in_cycle--;
-            }
-            if (scheduled) {
-                assert(_sched_packets >= sect.packetCount());
-                _sched_packets -= sect.packetCount();
-            }
-            it = list.erase(it);
+            it = eraseSection(list, it, scheduled);
         }
         else {
             ++it;
@@ -191,6 +180,154 @@ void ts::CyclingPacketizer::removeSections(SectionDescList& list, TID tid, uint1
 }
 
 
+//----------------------------------------------------------------------------
+// Remove the specified sections, by address.
+//----------------------------------------------------------------------------
+
+void ts::CyclingPacketizer::removeSections(const SectionPtrVector& sections)
+{
+    std::set<const Section*> addresses;
+    for (SectionPtrVector::const_iterator it = sections.begin(); it != sections.end(); ++it) {
+        if (!it->isNull()) {
+            addresses.insert(it->pointer());
+        }
+    }
+    if (!addresses.empty()) {
+        removeSections(_sched_sections, addresses, true);
+        removeSections(_other_sections, addresses, false);
+    }
+}
+
+void ts::CyclingPacketizer::removeSections(SectionDescList& list, const std::set<const Section*>& addresses, bool scheduled)
+{
+    SectionDescList::iterator it(list.begin());
+    while (it != list.end()) {
+        if (addresses.find((*it)->section.pointer()) != addresses.end()) {
+            it = eraseSection(list, it, scheduled);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+
+void ts::CyclingPacketizer::removeSections(SectionDescList& list, const std::set<const SectionDesc*>& descs, bool scheduled)
+{
+    SectionDescList::iterator it(list.begin());
+    while (it != list.end()) {
+        if (descs.find(it->pointer()) != descs.end()) {
+            it = eraseSection(list, it, scheduled);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Replace all sections in the packetizer, preserving the schedule.
+//----------------------------------------------------------------------------
+
+uint32_t ts::CyclingPacketizer::SectionKey(const Section& sect)
+{
+    // Short sections are identified by table id only.
+    return sect.isLongSection() ?
+        (uint32_t(sect.tableId()) << 24) | (uint32_t(sect.tableIdExtension()) << 8) | sect.sectionNumber() :
+        uint32_t(sect.tableId()) << 24;
+}
+
+void ts::CyclingPacketizer::replaceSections(const SectionPtrVector& sects, MilliSecond rep_rate)
+{
+    replaceSections(sects, std::vector<MilliSecond>(sects.size(), rep_rate));
+}
+
+void ts::CyclingPacketizer::replaceSections(const SectionPtrVector& sects, const std::vector<MilliSecond>& rep_rates)
+{
+    // Index all current sections by identification key. Also build the set of
+    // current sections, the ones which are reused are removed from the set.
+    typedef std::multimap<uint32_t, SectionDesc*> SectionDescMap;
+    SectionDescMap current;
+    std::set<const SectionDesc*> obsolete;
+    for (SectionDescList::const_iterator it = _sched_sections.begin(); it != _sched_sections.end(); ++it) {
+        current.insert(std::make_pair(SectionKey(*(*it)->section), it->pointer()));
+        obsolete.insert(it->pointer());
+    }
+    for (SectionDescList::const_iterator it = _other_sections.begin(); it != _other_sections.end(); ++it) {
+        current.insert(std::make_pair(SectionKey(*(*it)->section), it->pointer()));
+        obsolete.insert(it->pointer());
+    }
+
+    for (size_t i = 0; i < sects.size(); ++i) {
+        const SectionPtr& sect(sects[i]);
+        if (sect.isNull() || !sect->isValid()) {
+            continue;
+        }
+        const MilliSecond rep = i < rep_rates.size() ? rep_rates[i] : 0;
+
+        // Look for an identical section first, then for a long section with same tid, tid ext and section number.
+        SectionDesc* match = 0;
+        bool identical = false;
+        const std::pair<SectionDescMap::iterator, SectionDescMap::iterator> range(current.equal_range(SectionKey(*sect)));
+        for (SectionDescMap::iterator it = range.first; !identical && it != range.second; ++it) {
+            SectionDesc* desc = it->second;
+            if (desc->repetition == rep && obsolete.find(desc) != obsolete.end()) {
+                if (*desc->section == *sect) {
+                    match = desc;
+                    identical = true;
+                }
+                else if (match == 0 && sect->isLongSection() && desc->section->isLongSection()) {
+                    match = desc;
+                }
+            }
+        }
+
+        if (match == 0) {
+            // No equivalent section, add a new one.
+            addSection(sect, rep);
+        }
+        else {
+            // Reuse the previous slot in the schedule, replace the section content.
+            obsolete.erase(match);
+            if (rep != 0 && _bitrate != 0) {
+                // This is a scheduled section, the size of the section may have changed.
+                assert(_sched_packets >= match->section->packetCount());
+                _sched_packets = _sched_packets - match->section->packetCount() + sect->packetCount();
+            }
+            match->section = sect;
+        }
+    }
+
+    // Remove the previous sections which have not been replaced.
+    if (!obsolete.empty()) {
+        removeSections(_sched_sections, obsolete, true);
+        removeSections(_other_sections, obsolete, false);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Remove one section from the specified list.
+//----------------------------------------------------------------------------
+
+ts::CyclingPacketizer::SectionDescList::iterator ts::CyclingPacketizer::eraseSection(SectionDescList& list, SectionDescList::iterator it, bool scheduled)
+{
+    const SectionDescPtr& sp(*it);
+    assert(_section_count > 0);
+    _section_count--;
+    if (sp->last_cycle != _current_cycle) {
+        assert(_remain_in_cycle > 0);
+        _remain_in_cycle--;
+    }
+    if (scheduled) {
+        assert(_sched_packets >= sp->section->packetCount());
+        _sched_packets -= sp->section->packetCount();
+    }
+    return list.erase(it);
+}
+
+
 //----------------------------------------------------------------------------
 // Remove all sections in the packetized.
 //----------------------------------------------------------------------------
@@ -319,9 +456,8 @@ void ts::CyclingPacketizer::provideSection(SectionCounter counter, SectionPtr& s
     else if (!_other_sections.empty()) {
         // An unscheduled section is ready
         sp = _other_sections.front();
-        _other_sections.pop_front();
-        // Move section back at end of queue
-        _other_sections.push_back(sp);
+        // Move section back at end of queue (without reallocating a list node)
+        _other_sections.splice(_other_sections.end(), _other_sections, _other_sections.begin());
     }
 
     if (sp.isNull()) {
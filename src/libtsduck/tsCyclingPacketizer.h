@@ -181,12 +181,45 @@ namespace ts {
         //!
         void removeSections(TID tid, uint16_t tid_ext);
 
+        //!
+        //! Remove the specified sections.
+        //! The sections are identified by address, not by content.
+        //! If one such section is currently being packetized, the rest of the section will be packetized.
+        //! @param [in] sections The sections to remove. Sections which are not in the packetizer are ignored.
+        //!
+        void removeSections(const SectionPtrVector& sections);
+
         //!
         //! Remove all sections in the packetizer.
         //! If a section is currently being packetized, the rest of the section will be packetized.
         //!
         void removeAll();
 
+        //!
+        //! Replace all sections in the packetizer with a new set of sections.
+        //! The cycle and the repetition schedule of the sections are preserved as much as possible.
+        //! A new section which is identical to a section in the packetizer, with the same repetition
+        //! rate, keeps the packetization state of the previous section. A long section which has the
+        //! same table id, table id extension and section number as a section in the packetizer, with
+        //! the same repetition rate, replaces the content of the previous section at the same place
+        //! in the schedule. Other new sections are added and previous sections without equivalent
+        //! in the new set are removed.
+        //! If a section is currently being packetized, the rest of the section will be packetized.
+        //! @param [in] sections A vector of smart pointer to the new sections to packetize.
+        //! @param [in] repetition_rate Repetition rate of the sections in milliseconds.
+        //! If zero, simply packetize sections one after the other.
+        //!
+        void replaceSections(const SectionPtrVector& sections, MilliSecond repetition_rate = 0);
+
+        //!
+        //! Replace all sections in the packetizer with a new set of sections with distinct repetition rates.
+        //! Same as the previous method, except that each section has its own repetition rate.
+        //! @param [in] sections A vector of smart pointer to the new sections to packetize.
+        //! @param [in] repetition_rates Repetition rates of the sections in milliseconds, one per section
+        //! in @a sections. Missing values are zero (no specific repetition rate).
+        //!
+        void replaceSections(const SectionPtrVector& sections, const std::vector<MilliSecond>& repetition_rates);
+
         //!
         //! Get the number of stored sections to packetize.
         //! @return The number of stored sections to packetize.
@@ -256,6 +289,18 @@ namespace ts {
         // Remove all sections with the specified tid/tid_ext in the specified list.
         void removeSections(SectionDescList&, TID, uint16_t tid_ext, bool use_tid_ext, bool scheduled);
 
+        // Remove all sections with the specified addresses in the specified list.
+        void removeSections(SectionDescList&, const std::set<const Section*>&, bool scheduled);
+
+        // Remove all sections with the specified descriptors in the specified list.
+        void removeSections(SectionDescList&, const std::set<const SectionDesc*>&, bool scheduled);
+
+        // Identification key of a section in replaceSections().
+        static uint32_t SectionKey(const Section&);
+
+        // Remove one section from the specified list, return an iterator to the next one.
+        SectionDescList::iterator eraseSection(SectionDescList&, SectionDescList::iterator, bool scheduled);
+
         // Inherited from SectionProviderInterface
         virtual void provideSection(SectionCounter, SectionPtr&) override;
         virtual bool doStuffing() override;
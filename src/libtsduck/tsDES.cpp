@@ -16,6 +16,16 @@
 #include "tsDES.h"
 TSDUCK_SOURCE;
 
+// SSE2 is always available on x86_64 and on i386 when the compiler is allowed to use it.
+// NEON is always available on ARM64. No runtime check is needed in both cases.
+#if !defined(TS_NO_VECTOR_INSTRUCTIONS) && (defined(TS_X86_64) || (defined(TS_I386) && (defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))))
+    #define TS_DES_SSE2 1
+    #include <emmintrin.h>
+#elif !defined(TS_NO_VECTOR_INSTRUCTIONS) && defined(TS_ARM64) && (defined(TS_GCC) || defined(TS_LLVM))
+    #define TS_DES_NEON 1
+    #include <arm_neon.h>
+#endif
+
 
 #define C64(x) TS_UCONST64(x)
 #define BYTE(x,n) (((x) >> (8 * (n))) & 255)
@@ -1258,6 +1268,657 @@ namespace {
 }
 
 
+//----------------------------------------------------------------------------
+// Bitsliced implementation, encrypting or decrypting many independent blocks
+// at a time. The state is transposed: each bit of the DES state is stored in
+// one word of type W, with one bit per block (one "lane" per block). Then, the
+// permutations are only a matter of indexing and the S-boxes are evaluated
+// for all blocks at once using Boolean gate circuits. W is a 128-bit vector
+// with SSE2 or NEON (128 blocks at a time) or a uint64_t (64 blocks).
+//----------------------------------------------------------------------------
+
+namespace {
+
+    // Initial and final permutations, as indexes of bits (0 is the most significant bit).
+    static const uint8_t bs_ip[64] = {
+        57, 49, 41, 33, 25, 17,  9,  1, 59, 51, 43, 35, 27, 19, 11,  3,
+        61, 53, 45, 37, 29, 21, 13,  5, 63, 55, 47, 39, 31, 23, 15,  7,
+        56, 48, 40, 32, 24, 16,  8,  0, 58, 50, 42, 34, 26, 18, 10,  2,
+        60, 52, 44, 36, 28, 20, 12,  4, 62, 54, 46, 38, 30, 22, 14,  6
+    };
+
+    static const uint8_t bs_fp[64] = {
+        39,  7, 47, 15, 55, 23, 63, 31, 38,  6, 46, 14, 54, 22, 62, 30,
+        37,  5, 45, 13, 53, 21, 61, 29, 36,  4, 44, 12, 52, 20, 60, 28,
+        35,  3, 43, 11, 51, 19, 59, 27, 34,  2, 42, 10, 50, 18, 58, 26,
+        33,  1, 41,  9, 49, 17, 57, 25, 32,  0, 40,  8, 48, 16, 56, 24
+    };
+
+#if defined(TS_DES_SSE2)
+
+    struct BitsliceWord { __m128i v; };
+    inline BitsliceWord operator&(BitsliceWord a, BitsliceWord b) { BitsliceWord w = {_mm_and_si128(a.v, b.v)}; return w; }
+    inline BitsliceWord operator|(BitsliceWord a, BitsliceWord b) { BitsliceWord w = {_mm_or_si128(a.v, b.v)}; return w; }
+    inline BitsliceWord operator^(BitsliceWord a, BitsliceWord b) { BitsliceWord w = {_mm_xor_si128(a.v, b.v)}; return w; }
+    inline BitsliceWord operator~(BitsliceWord a) { BitsliceWord w = {_mm_xor_si128(a.v, _mm_set1_epi32(-1))}; return w; }
+    inline BitsliceWord& operator^=(BitsliceWord& a, BitsliceWord b) { a.v = _mm_xor_si128(a.v, b.v); return a; }
+    inline BitsliceWord AndNot(BitsliceWord a, BitsliceWord b) { BitsliceWord w = {_mm_andnot_si128(b.v, a.v)}; return w; }
+    inline BitsliceWord BitsliceMask(bool bit) { BitsliceWord w = {_mm_set1_epi32(bit ? -1 : 0)}; return w; }
+    inline void LoadLanes(BitsliceWord& w, const uint64_t t[][64], size_t i)
+    {
+        w.v = _mm_unpacklo_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(&t[0][i])), _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&t[1][i])));
+    }
+    inline void StoreLanes(BitsliceWord w, uint64_t t[][64], size_t i)
+    {
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(&t[0][i]), w.v);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(&t[1][i]), _mm_unpackhi_epi64(w.v, w.v));
+    }
+
+#elif defined(TS_DES_NEON)
+
+    struct BitsliceWord { uint64x2_t v; };
+    inline BitsliceWord operator&(BitsliceWord a, BitsliceWord b) { BitsliceWord w = {vandq_u64(a.v, b.v)}; return w; }
+    inline BitsliceWord operator|(BitsliceWord a, BitsliceWord b) { BitsliceWord w = {vorrq_u64(a.v, b.v)}; return w; }
+    inline BitsliceWord operator^(BitsliceWord a, BitsliceWord b) { BitsliceWord w = {veorq_u64(a.v, b.v)}; return w; }
+    inline BitsliceWord operator~(BitsliceWord a) { BitsliceWord w = {veorq_u64(a.v, vdupq_n_u64(~uint64_t(0)))}; return w; }
+    inline BitsliceWord& operator^=(BitsliceWord& a, BitsliceWord b) { a.v = veorq_u64(a.v, b.v); return a; }
+    inline BitsliceWord AndNot(BitsliceWord a, BitsliceWord b) { BitsliceWord w = {vbicq_u64(a.v, b.v)}; return w; }
+    inline BitsliceWord BitsliceMask(bool bit) { BitsliceWord w = {vdupq_n_u64(bit ? ~uint64_t(0) : 0)}; return w; }
+    inline void LoadLanes(BitsliceWord& w, const uint64_t t[][64], size_t i) { w.v = vcombine_u64(vcreate_u64(t[0][i]), vcreate_u64(t[1][i])); }
+    inline void StoreLanes(BitsliceWord w, uint64_t t[][64], size_t i) { t[0][i] = vgetq_lane_u64(w.v, 0); t[1][i] = vgetq_lane_u64(w.v, 1); }
+
+#else
+
+    typedef uint64_t BitsliceWord;
+    inline uint64_t AndNot(uint64_t a, uint64_t b) { return a & ~b; }
+    inline uint64_t BitsliceMask(bool bit) { return bit ? ~uint64_t(0) : 0; }
+    inline void LoadLanes(uint64_t& w, const uint64_t t[][64], size_t i) { w = t[0][i]; }
+    inline void StoreLanes(uint64_t w, uint64_t t[][64], size_t i) { t[0][i] = w; }
+
+#endif
+
+    // Number of blocks which are processed at a time.
+    static const size_t BS_LANES = 8 * sizeof(BitsliceWord);
+    static const size_t BS_GROUPS = sizeof(BitsliceWord) / 8;
+
+    // Minimum number of blocks in a batch. A partial batch is padded when it
+    // contains at least this number of blocks, otherwise the blocks are processed
+    // one by one.
+    static const size_t BS_MIN_BLOCKS = BS_LANES / 4;
+
+    // Address of the first word in a byte block, aligned on the word size.
+    BitsliceWord* AlignedWords(ts::ByteBlock& bb)
+    {
+        const uintptr_t addr = reinterpret_cast<uintptr_t>(bb.data());
+        return reinterpret_cast<BitsliceWord*>((addr + sizeof(BitsliceWord) - 1) & ~uintptr_t(sizeof(BitsliceWord) - 1));
+    }
+
+    // Transpose a 64x64 bit matrix: bit j of word i becomes bit i of word j (bit 0 is the most significant).
+    void Transpose64(uint64_t* a)
+    {
+        uint64_t m = C64(0x00000000FFFFFFFF);
+        for (size_t j = 32; j != 0; j >>= 1, m ^= m << j) {
+            for (size_t k = 0; k < 64; k = ((k | j) + 1) & ~j) {
+                const uint64_t t = (a[k] ^ (a[k | j] >> j)) & m;
+                a[k] ^= t;
+                a[k | j] ^= t << j;
+            }
+        }
+    }
+
+    // The S-boxes. Each output bit of an S-box is xor'ed with the corresponding
+    // state bit, after the permutation P. The circuits were derived from the
+    // standard S-box tables and checked against them for all input values.
+
+    template <typename W>
+    inline void SBox1(W a1, W a2, W a3, W a4, W a5, W a6, W& out1, W& out2, W& out3, W& out4)
+    {
+        const W x1 = a5 & a6;
+        const W x2 = x1 ^ a4;
+        const W x3 = a5 ^ a6;
+        const W x4 = x3 | x2;
+        const W x5 = x4 & a1;
+        const W x6 = x2 ^ x5;
+        const W x7 = AndNot(a1, x3);
+        const W x8 = x7 ^ x5;
+        const W x9 = x8 | a5;
+        const W x10 = ~x2;
+        const W x11 = x10 ^ x4;
+        const W x12 = AndNot(a5, x2);
+        const W x13 = x12 & a1;
+        const W x14 = x11 ^ x13;
+        const W x15 = x3 ^ x9;
+        const W x16 = x15 | x13;
+        const W x17 = x16 ^ x1;
+        const W x18 = x3 ^ x8;
+        const W x19 = x18 | x12;
+        const W x20 = ~x19;
+        const W x21 = x6 ^ x11;
+        const W x22 = x21 | x17;
+        const W x23 = x22 ^ a5;
+        const W x24 = ~a1;
+        const W x25 = x24 | x8;
+        const W x26 = a6 ^ x10;
+        const W x27 = x26 ^ x17;
+        const W x28 = x3 & x9;
+        const W x29 = x28 ^ x14;
+        const W x30 = AndNot(x11, x28);
+        const W x31 = x30 ^ x17;
+        const W x32 = a6 | x8;
+        const W x33 = x32 ^ x23;
+        const W x34 = a1 & x3;
+        const W x35 = x34 ^ x16;
+        const W x36 = x14 & x32;
+        const W x37 = x36 ^ x21;
+        const W x38 = a1 ^ x26;
+        const W x39 = x38 ^ x31;
+        const W x40 = AndNot(x39, x1);
+        const W x41 = a1 | x39;
+        const W x42 = x41 ^ x13;
+        const W x43 = a4 ^ x20;
+        const W x44 = AndNot(x43, x40);
+        const W x45 = a2 & a3;
+        out1 ^= x20;
+        out1 ^= x23 & a3;
+        out1 ^= x25 & a2;
+        out1 ^= x27 & x45;
+        out2 ^= x29;
+        out2 ^= x31 & a3;
+        out2 ^= x33 & a2;
+        out2 ^= x35 & x45;
+        out3 ^= x37;
+        out3 ^= x40 & a3;
+        out3 ^= x42 & a2;
+        out3 ^= x44 & x45;
+        out4 ^= x6;
+        out4 ^= x9 & a3;
+        out4 ^= x14 & a2;
+        out4 ^= x17 & x45;
+    }
+
+    template <typename W>
+    inline void SBox2(W a1, W a2, W a3, W a4, W a5, W a6, W& out1, W& out2, W& out3, W& out4)
+    {
+        const W x1 = a2 ^ a5;
+        const W x2 = x1 ^ a6;
+        const W x3 = ~x2;
+        const W x4 = x3 ^ a1;
+        const W x5 = ~a5;
+        const W x6 = a1 & a2;
+        const W x7 = x6 | x1;
+        const W x8 = AndNot(x7, a6);
+        const W x9 = x5 ^ x8;
+        const W x10 = x1 | x3;
+        const W x11 = x10 ^ x9;
+        const W x12 = a5 & a6;
+        const W x13 = x4 | x12;
+        const W x14 = AndNot(x13, x6);
+        const W x15 = x14 ^ a6;
+        const W x16 = a2 ^ x9;
+        const W x17 = x16 | a5;
+        const W x18 = x1 & x17;
+        const W x19 = x18 & a1;
+        const W x20 = x17 ^ x19;
+        const W x21 = AndNot(x16, x15);
+        const W x22 = x21 | x18;
+        const W x23 = x22 ^ a2;
+        const W x24 = AndNot(x3, a1);
+        const W x25 = x24 ^ a2;
+        const W x26 = x13 & x17;
+        const W x27 = x26 ^ a2;
+        const W x28 = AndNot(a5, x15);
+        const W x29 = x28 | a2;
+        const W x30 = a1 ^ a6;
+        const W x31 = x30 | x9;
+        const W x32 = x23 & x30;
+        const W x33 = x32 ^ x12;
+        const W x34 = ~x33;
+        const W x35 = x1 & x25;
+        const W x36 = x35 ^ x17;
+        const W x37 = x36 ^ a2;
+        const W x38 = AndNot(x25, x19);
+        const W x39 = AndNot(x31, x38);
+        const W x40 = ~x39;
+        const W x41 = a3 & a4;
+        out1 ^= x27;
+        out1 ^= x29 & a4;
+        out1 ^= x31 & a3;
+        out2 ^= x4;
+        out2 ^= x9 & a4;
+        out2 ^= x11 & a3;
+        out2 ^= x12 & x41;
+        out3 ^= x15;
+        out3 ^= x20 & a4;
+        out3 ^= x23 & a3;
+        out3 ^= x25 & x41;
+        out4 ^= x34;
+        out4 ^= x37 & a4;
+        out4 ^= x40 & a3;
+    }
+
+    template <typename W>
+    inline void SBox3(W a1, W a2, W a3, W a4, W a5, W a6, W& out1, W& out2, W& out3, W& out4)
+    {
+        const W x1 = a3 & a5;
+        const W x2 = x1 ^ a6;
+        const W x3 = x2 ^ a2;
+        const W x4 = ~a5;
+        const W x5 = a3 ^ x2;
+        const W x6 = x5 ^ x4;
+        const W x7 = AndNot(x6, x2);
+        const W x8 = x7 & a2;
+        const W x9 = x6 ^ x8;
+        const W x10 = a2 & a3;
+        const W x11 = AndNot(a6, x10);
+        const W x12 = x11 ^ a5;
+        const W x13 = a2 ^ x5;
+        const W x14 = AndNot(x13, x8);
+        const W x15 = a2 ^ a5;
+        const W x16 = x15 | a6;
+        const W x17 = x16 ^ x10;
+        const W x18 = a3 | x9;
+        const W x19 = x18 | x12;
+        const W x20 = AndNot(x2, x12);
+        const W x21 = x20 | x10;
+        const W x22 = x21 ^ a2;
+        const W x23 = x1 & x16;
+        const W x24 = x23 ^ x6;
+        const W x25 = x24 ^ x3;
+        const W x26 = x15 & x22;
+        const W x27 = x26 ^ x24;
+        const W x28 = ~x27;
+        const W x29 = x10 ^ x13;
+        const W x30 = x29 | x1;
+        const W x31 = x7 ^ x12;
+        const W x32 = x31 ^ x28;
+        const W x33 = a5 | x32;
+        const W x34 = x33 ^ x23;
+        const W x35 = x34 ^ a3;
+        const W x36 = x5 ^ x17;
+        const W x37 = x36 ^ x27;
+        const W x38 = x29 & x33;
+        const W x39 = x38 ^ x9;
+        const W x40 = a1 & a4;
+        out1 ^= x25;
+        out1 ^= x28 & a4;
+        out1 ^= x30 & a1;
+        out1 ^= x27 & x40;
+        out2 ^= x14;
+        out2 ^= x17 & a4;
+        out2 ^= x19 & a1;
+        out2 ^= x22 & x40;
+        out3 ^= x32;
+        out3 ^= x35 & a4;
+        out3 ^= x37 & a1;
+        out3 ^= x39 & x40;
+        out4 ^= x3;
+        out4 ^= x4 & a4;
+        out4 ^= x9 & a1;
+        out4 ^= x12 & x40;
+    }
+
+    template <typename W>
+    inline void SBox4(W a1, W a2, W a3, W a4, W a5, W a6, W& out1, W& out2, W& out3, W& out4)
+    {
+        const W x1 = ~a4;
+        const W x2 = x1 ^ a5;
+        const W x3 = AndNot(a5, a4);
+        const W x4 = x3 ^ a3;
+        const W x5 = AndNot(x4, a2);
+        const W x6 = x2 ^ x5;
+        const W x7 = a5 | x1;
+        const W x8 = AndNot(x7, a3);
+        const W x9 = a3 ^ x2;
+        const W x10 = x9 | a4;
+        const W x11 = AndNot(x10, a2);
+        const W x12 = x8 ^ x11;
+        const W x13 = AndNot(x4, x2);
+        const W x14 = a4 | x11;
+        const W x15 = x13 ^ x14;
+        const W x16 = a5 & x4;
+        const W x17 = x16 | x6;
+        const W x18 = x17 ^ a5;
+        const W x19 = x6 ^ x12;
+        const W x20 = ~x12;
+        const W x21 = x15 ^ x18;
+        const W x22 = a2 ^ x12;
+        const W x23 = x22 & x21;
+        const W x24 = a4 ^ x12;
+        const W x25 = x24 ^ x17;
+        const W x26 = a2 ^ x1;
+        const W x27 = x26 | x18;
+        const W x28 = AndNot(x19, x23);
+        const W x29 = x28 ^ x15;
+        const W x30 = x23 ^ x25;
+        const W x31 = ~x25;
+        const W x32 = x27 ^ x29;
+        const W x33 = a1 & a6;
+        out1 ^= x23;
+        out1 ^= x25 & a6;
+        out1 ^= x27 & a1;
+        out1 ^= x29 & x33;
+        out2 ^= x30;
+        out2 ^= x31 & a6;
+        out2 ^= x32 & a1;
+        out2 ^= x29 & x33;
+        out3 ^= x19;
+        out3 ^= x20 & a6;
+        out3 ^= x21 & a1;
+        out3 ^= x18 & x33;
+        out4 ^= x6;
+        out4 ^= x12 & a6;
+        out4 ^= x15 & a1;
+        out4 ^= x18 & x33;
+    }
+
+    template <typename W>
+    inline void SBox5(W a1, W a2, W a3, W a4, W a5, W a6, W& out1, W& out2, W& out3, W& out4)
+    {
+        const W x1 = a5 ^ a6;
+        const W x2 = a2 ^ a5;
+        const W x3 = AndNot(a6, x2);
+        const W x4 = ~x3;
+        const W x5 = x4 & a3;
+        const W x6 = x1 ^ x5;
+        const W x7 = a2 ^ a3;
+        const W x8 = x7 ^ x5;
+        const W x9 = ~x8;
+        const W x10 = x7 | x9;
+        const W x11 = AndNot(x10, a6);
+        const W x12 = x11 | x3;
+        const W x13 = AndNot(a5, a3);
+        const W x14 = x13 ^ x12;
+        const W x15 = ~x14;
+        const W x16 = a5 & a6;
+        const W x17 = x16 | x6;
+        const W x18 = x17 ^ x7;
+        const W x19 = x2 ^ x17;
+        const W x20 = x19 | x1;
+        const W x21 = a5 & x20;
+        const W x22 = x21 ^ x5;
+        const W x23 = x2 | x6;
+        const W x24 = x23 ^ x22;
+        const W x25 = AndNot(x24, a3);
+        const W x26 = x25 ^ x14;
+        const W x27 = x26 ^ a6;
+        const W x28 = a2 ^ x16;
+        const W x29 = x28 ^ x23;
+        const W x30 = ~x29;
+        const W x31 = AndNot(x22, x18);
+        const W x32 = x31 ^ x4;
+        const W x33 = a6 ^ x30;
+        const W x34 = AndNot(x33, x2);
+        const W x35 = a3 | x33;
+        const W x36 = x35 ^ x22;
+        const W x37 = ~x36;
+        const W x38 = a5 | x37;
+        const W x39 = x38 ^ x7;
+        const W x40 = a3 | x24;
+        const W x41 = x7 ^ x33;
+        const W x42 = x41 & x35;
+        const W x43 = a1 & a4;
+        out1 ^= x18;
+        out1 ^= x20 & a4;
+        out1 ^= x22 & a1;
+        out1 ^= x24 & x43;
+        out2 ^= x6;
+        out2 ^= x9 & a4;
+        out2 ^= x12 & a1;
+        out2 ^= x15 & x43;
+        out3 ^= x27;
+        out3 ^= x30 & a4;
+        out3 ^= x32 & a1;
+        out3 ^= x34 & x43;
+        out4 ^= x37;
+        out4 ^= x39 & a4;
+        out4 ^= x40 & a1;
+        out4 ^= x42 & x43;
+    }
+
+    template <typename W>
+    inline void SBox6(W a1, W a2, W a3, W a4, W a5, W a6, W& out1, W& out2, W& out3, W& out4)
+    {
+        const W x1 = ~a2;
+        const W x2 = x1 ^ a6;
+        const W x3 = a5 | a6;
+        const W x4 = AndNot(x3, a1);
+        const W x5 = x2 ^ x4;
+        const W x6 = a2 | x5;
+        const W x7 = x6 & x3;
+        const W x8 = x7 | a5;
+        const W x9 = a1 | a5;
+        const W x10 = x9 ^ x8;
+        const W x11 = x10 ^ a2;
+        const W x12 = a1 | x5;
+        const W x13 = x12 & x7;
+        const W x14 = x13 ^ x6;
+        const W x15 = a1 & x6;
+        const W x16 = x15 ^ a5;
+        const W x17 = a6 ^ x16;
+        const W x18 = x17 | x14;
+        const W x19 = x18 ^ x1;
+        const W x20 = AndNot(a1, x17);
+        const W x21 = x20 ^ x1;
+        const W x22 = a1 ^ x5;
+        const W x23 = AndNot(x22, a6);
+        const W x24 = a1 ^ a5;
+        const W x25 = x24 ^ x2;
+        const W x26 = x4 ^ x11;
+        const W x27 = x26 | x22;
+        const W x28 = x27 ^ a2;
+        const W x29 = x2 ^ x13;
+        const W x30 = x29 & x16;
+        const W x31 = ~x30;
+        const W x32 = a5 ^ x20;
+        const W x33 = x26 ^ x28;
+        const W x34 = x33 ^ x31;
+        const W x35 = x34 ^ a6;
+        const W x36 = x25 & x32;
+        const W x37 = ~x36;
+        const W x38 = x19 | x30;
+        const W x39 = a3 & a4;
+        out1 ^= x5;
+        out1 ^= x8 & a4;
+        out1 ^= x11 & a3;
+        out1 ^= x14 & x39;
+        out2 ^= x25;
+        out2 ^= x28 & a4;
+        out2 ^= x31 & a3;
+        out2 ^= x32 & x39;
+        out3 ^= x35;
+        out3 ^= x37 & a4;
+        out3 ^= x38 & a3;
+        out4 ^= x16;
+        out4 ^= x19 & a4;
+        out4 ^= x21 & a3;
+        out4 ^= x23 & x39;
+    }
+
+    template <typename W>
+    inline void SBox7(W a1, W a2, W a3, W a4, W a5, W a6, W& out1, W& out2, W& out3, W& out4)
+    {
+        const W x1 = ~a4;
+        const W x2 = x1 ^ a5;
+        const W x3 = a3 ^ x1;
+        const W x4 = x3 & a2;
+        const W x5 = x2 ^ x4;
+        const W x6 = a4 & a5;
+        const W x7 = AndNot(a2, x6);
+        const W x8 = x6 & a3;
+        const W x9 = x7 ^ x8;
+        const W x10 = a3 & x5;
+        const W x11 = AndNot(x3, x10);
+        const W x12 = x11 ^ a2;
+        const W x13 = ~x4;
+        const W x14 = x13 ^ x7;
+        const W x15 = x5 ^ x12;
+        const W x16 = a4 | x14;
+        const W x17 = x16 ^ x8;
+        const W x18 = a3 ^ x14;
+        const W x19 = AndNot(x18, a5);
+        const W x20 = x19 ^ x12;
+        const W x21 = AndNot(a5, a4);
+        const W x22 = x21 ^ x17;
+        const W x23 = x22 ^ a3;
+        const W x24 = x1 | x15;
+        const W x25 = x24 ^ x5;
+        const W x26 = x25 ^ a3;
+        const W x27 = ~a2;
+        const W x28 = x27 | x18;
+        const W x29 = a2 | x20;
+        const W x30 = AndNot(x29, x25);
+        const W x31 = x5 ^ x6;
+        const W x32 = x31 ^ x18;
+        const W x33 = x7 & x16;
+        const W x34 = x33 ^ x26;
+        const W x35 = ~x19;
+        const W x36 = AndNot(x23, x3);
+        const W x37 = x36 | x7;
+        const W x38 = x37 ^ x5;
+        const W x39 = a1 & a6;
+        out1 ^= x15;
+        out1 ^= x17 & a6;
+        out1 ^= x20 & a1;
+        out1 ^= x23 & x39;
+        out2 ^= x5;
+        out2 ^= x9 & a6;
+        out2 ^= x12 & a1;
+        out2 ^= x14 & x39;
+        out3 ^= x32;
+        out3 ^= x34 & a6;
+        out3 ^= x35 & a1;
+        out3 ^= x38 & x39;
+        out4 ^= x26;
+        out4 ^= x28 & a6;
+        out4 ^= a1;
+        out4 ^= x30 & x39;
+    }
+
+    template <typename W>
+    inline void SBox8(W a1, W a2, W a3, W a4, W a5, W a6, W& out1, W& out2, W& out3, W& out4)
+    {
+        const W x1 = AndNot(a5, a3);
+        const W x2 = x1 ^ a4;
+        const W x3 = ~x2;
+        const W x4 = AndNot(x3, a5);
+        const W x5 = x4 ^ a3;
+        const W x6 = x5 & a2;
+        const W x7 = x3 ^ x6;
+        const W x8 = a3 | x2;
+        const W x9 = x8 ^ a5;
+        const W x10 = x2 | x9;
+        const W x11 = x10 & a2;
+        const W x12 = x9 ^ x11;
+        const W x13 = AndNot(a3, a2);
+        const W x14 = AndNot(x2, x13);
+        const W x15 = x3 ^ x12;
+        const W x16 = x15 ^ x13;
+        const W x17 = x16 ^ a3;
+        const W x18 = x8 ^ x16;
+        const W x19 = x18 | x7;
+        const W x20 = x19 ^ a2;
+        const W x21 = x4 | x14;
+        const W x22 = AndNot(x15, a5);
+        const W x23 = AndNot(x21, x22);
+        const W x24 = ~x23;
+        const W x25 = x6 ^ x15;
+        const W x26 = x25 ^ x21;
+        const W x27 = AndNot(a2, x10);
+        const W x28 = x12 ^ x24;
+        const W x29 = AndNot(a5, a2);
+        const W x30 = x29 | x2;
+        const W x31 = AndNot(a4, x20);
+        const W x32 = x31 ^ x25;
+        const W x33 = x10 ^ x12;
+        const W x34 = x33 | x31;
+        const W x35 = x21 ^ x24;
+        const W x36 = a2 & x2;
+        const W x37 = x36 ^ x21;
+        const W x38 = a1 & a6;
+        out1 ^= x17;
+        out1 ^= x20 & a6;
+        out1 ^= x21 & a1;
+        out1 ^= x24 & x38;
+        out2 ^= x7;
+        out2 ^= a6;
+        out2 ^= x12 & a1;
+        out2 ^= x14 & x38;
+        out3 ^= x26;
+        out3 ^= x27 & a6;
+        out3 ^= x28 & a1;
+        out3 ^= x30 & x38;
+        out4 ^= x32;
+        out4 ^= x34 & a6;
+        out4 ^= x35 & a1;
+        out4 ^= x37 & x38;
+    }
+
+    // One DES round, in the bitsliced domain: l ^= f(r, k).
+    template <typename W>
+    inline void BitsliceRound(W* l, const W* r, const W* k)
+    {
+        SBox1(r[31] ^ k[0], r[0] ^ k[1], r[1] ^ k[2], r[2] ^ k[3], r[3] ^ k[4], r[4] ^ k[5],
+              l[8], l[16], l[22], l[30]);
+        SBox2(r[3] ^ k[6], r[4] ^ k[7], r[5] ^ k[8], r[6] ^ k[9], r[7] ^ k[10], r[8] ^ k[11],
+              l[12], l[27], l[1], l[17]);
+        SBox3(r[7] ^ k[12], r[8] ^ k[13], r[9] ^ k[14], r[10] ^ k[15], r[11] ^ k[16], r[12] ^ k[17],
+              l[23], l[15], l[29], l[5]);
+        SBox4(r[11] ^ k[18], r[12] ^ k[19], r[13] ^ k[20], r[14] ^ k[21], r[15] ^ k[22], r[16] ^ k[23],
+              l[25], l[19], l[9], l[0]);
+        SBox5(r[15] ^ k[24], r[16] ^ k[25], r[17] ^ k[26], r[18] ^ k[27], r[19] ^ k[28], r[20] ^ k[29],
+              l[7], l[13], l[24], l[2]);
+        SBox6(r[19] ^ k[30], r[20] ^ k[31], r[21] ^ k[32], r[22] ^ k[33], r[23] ^ k[34], r[24] ^ k[35],
+              l[3], l[28], l[10], l[18]);
+        SBox7(r[23] ^ k[36], r[24] ^ k[37], r[25] ^ k[38], r[26] ^ k[39], r[27] ^ k[40], r[28] ^ k[41],
+              l[31], l[11], l[21], l[6]);
+        SBox8(r[27] ^ k[42], r[28] ^ k[43], r[29] ^ k[44], r[30] ^ k[45], r[31] ^ k[46], r[0] ^ k[47],
+              l[4], l[26], l[14], l[20]);
+    }
+
+    // Process BS_LANES blocks. The key schedule contains one word per bit of each
+    // round key, in encryption order. With reverse, the rounds are executed in
+    // reverse order (decryption). There are 16 rounds per DES operation, the
+    // halves are swapped between two DES operations (triple DES).
+    template <typename W>
+    void BitsliceBlocks(const W* keys, size_t rounds, bool reverse, const uint8_t* in, uint8_t* out)
+    {
+        uint64_t t[BS_GROUPS][64];
+        W l[32], r[32];
+
+        for (size_t g = 0; g < BS_GROUPS; ++g) {
+            for (size_t j = 0; j < 64; ++j) {
+                t[g][j] = ts::GetUInt64(in + 8 * (64 * g + j));
+            }
+            Transpose64(t[g]);
+        }
+        for (size_t i = 0; i < 32; ++i) {
+            LoadLanes(l[i], t, bs_ip[i]);
+            LoadLanes(r[i], t, bs_ip[32 + i]);
+        }
+        for (size_t n = 0; n < rounds; ++n) {
+            const W* k = keys + 48 * (reverse ? rounds - 1 - n : n);
+            if (((n + n / 16) & 1) == 0) {
+                BitsliceRound(l, r, k);
+            }
+            else {
+                BitsliceRound(r, l, k);
+            }
+        }
+        // The output of the last round is R16 L16, before the final permutation.
+        for (size_t i = 0; i < 64; ++i) {
+            const size_t b = bs_fp[i];
+            StoreLanes(b < 32 ? r[b] : l[b - 32], t, i);
+        }
+        for (size_t g = 0; g < BS_GROUPS; ++g) {
+            Transpose64(t[g]);
+            for (size_t j = 0; j < 64; ++j) {
+                ts::PutUInt64(out + 8 * (64 * g + j), t[g][j]);
+            }
+        }
+    }
+}
+
+
 //----------------------------------------------------------------------------
 
 void ts::DES::cookey (const uint32_t* raw1, uint32_t* keyout)
@@ -1339,6 +2000,32 @@ void ts::DES::deskey (const uint8_t* key, uint16_t edf, uint32_t* keyout)
 }
 
 
+//----------------------------------------------------------------------------
+// Compute the 16 round keys of 48 bits, for the bitsliced implementation.
+// The first bit of the round key is the most significant one.
+//----------------------------------------------------------------------------
+
+void ts::DES::roundkeys(const uint8_t* key, uint64_t* rkeys)
+{
+    uint8_t pc1m[56], pcr[56];
+
+    for (size_t j = 0; j < 56; j++) {
+        pc1m[j] = (key[pc1[j] >> 3] & bytebit[pc1[j] & 7]) != 0 ? 1 : 0;
+    }
+    for (size_t i = 0; i < 16; i++) {
+        // Rotate the two halves of 28 bits.
+        for (size_t j = 0; j < 56; j++) {
+            const size_t l = j + totrot[i];
+            pcr[j] = pc1m[l < (j < 28 ? 28 : 56) ? l : l - 28];
+        }
+        rkeys[i] = 0;
+        for (size_t j = 0; j < 48; j++) {
+            rkeys[i] = (rkeys[i] << 1) | pcr[pc2[j]];
+        }
+    }
+}
+
+
 //----------------------------------------------------------------------------
 
 void ts::DES::desfunc (uint32_t* block, const uint32_t* keys)
@@ -1403,6 +2090,54 @@ void ts::DES::desfunc (uint32_t* block, const uint32_t* keys)
 }
 
 
+//----------------------------------------------------------------------------
+// Bitsliced processing of independent blocks, shared with TDES. The round
+// keys are in encryption order, with reverse for decryption. The bitsliced
+// round keys are built in bs_keys on first use (must be cleared when the key
+// changes). Return the number of processed blocks, the remaining blocks must
+// be processed one by one.
+//----------------------------------------------------------------------------
+
+size_t ts::DES::bitslice(const uint64_t* rkeys, size_t rounds, ByteBlock& bs_keys, bool reverse, const uint8_t* in, uint8_t* out, size_t count)
+{
+    if (count < BS_MIN_BLOCKS) {
+        return 0;
+    }
+
+    // One word per bit of each round key, all bits set or all bits cleared.
+    // One more word is allocated to align the words on their size.
+    const size_t nwords = 48 * rounds;
+    if (bs_keys.size() != (nwords + 1) * sizeof(BitsliceWord)) {
+        bs_keys.resize((nwords + 1) * sizeof(BitsliceWord));
+        BitsliceWord* keys = AlignedWords(bs_keys);
+        for (size_t n = 0; n < nwords; ++n) {
+            keys[n] = BitsliceMask(((rkeys[n / 48] >> (47 - n % 48)) & 1) != 0);
+        }
+    }
+    const BitsliceWord* keys = AlignedWords(bs_keys);
+
+    // Complete batches.
+    size_t done = 0;
+    for (; count - done >= BS_LANES; done += BS_LANES) {
+        BitsliceBlocks(keys, rounds, reverse, in + done * BLOCK_SIZE, out + done * BLOCK_SIZE);
+    }
+
+    // Last partial batch, padded, if there are enough remaining blocks.
+    const size_t rest = count - done;
+    if (rest >= BS_MIN_BLOCKS) {
+        uint8_t buffer[BS_LANES * BLOCK_SIZE];
+        // Flawfinder: ignore: memcpy()
+        ::memcpy(buffer, in + done * BLOCK_SIZE, rest * BLOCK_SIZE);
+        ::memset(buffer + rest * BLOCK_SIZE, 0, (BS_LANES - rest) * BLOCK_SIZE);
+        BitsliceBlocks(keys, rounds, reverse, buffer, buffer);
+        // Flawfinder: ignore: memcpy()
+        ::memcpy(out + done * BLOCK_SIZE, buffer, rest * BLOCK_SIZE);
+        done = count;
+    }
+    return done;
+}
+
+
 //----------------------------------------------------------------------------
 // Schedule a new key. If rounds is zero, the default is used.
 // Return true on success, false on error.
@@ -1417,6 +2152,10 @@ bool ts::DES::setKey (const void* key, size_t key_length, size_t rounds)
     deskey (reinterpret_cast<const uint8_t*> (key), EN0, _ek);
     deskey (reinterpret_cast<const uint8_t*> (key), DE1, _dk);
 
+    // The bitsliced round keys are rebuilt on next use.
+    roundkeys (reinterpret_cast<const uint8_t*> (key), _rk);
+    _bs_keys.clear();
+
     return true;
 }
 
@@ -1479,3 +2218,41 @@ bool ts::DES::decrypt (const void* cipher, size_t cipher_length,
 
     return true;
 }
+
+
+//----------------------------------------------------------------------------
+// Multi-block encryption and decryption in ECB mode.
+// The bitsliced implementation processes many blocks in parallel.
+//----------------------------------------------------------------------------
+
+bool ts::DES::encryptBlocks(const void* plain, void* cipher, size_t count)
+{
+    const uint8_t* pt = reinterpret_cast<const uint8_t*>(plain);
+    uint8_t* ct = reinterpret_cast<uint8_t*>(cipher);
+
+    const size_t done = bitslice(_rk, ROUNDS, _bs_keys, false, pt, ct, count);
+    pt += done * BLOCK_SIZE;
+    ct += done * BLOCK_SIZE;
+
+    // Avoid a virtual call per block.
+    for (count -= done; count > 0; count--, pt += BLOCK_SIZE, ct += BLOCK_SIZE) {
+        DES::encrypt(pt, BLOCK_SIZE, ct, BLOCK_SIZE);
+    }
+    return true;
+}
+
+bool ts::DES::decryptBlocks(const void* cipher, void* plain, size_t count)
+{
+    const uint8_t* ct = reinterpret_cast<const uint8_t*>(cipher);
+    uint8_t* pt = reinterpret_cast<uint8_t*>(plain);
+
+    const size_t done = bitslice(_rk, ROUNDS, _bs_keys, true, ct, pt, count);
+    ct += done * BLOCK_SIZE;
+    pt += done * BLOCK_SIZE;
+
+    // Avoid a virtual call per block.
+    for (count -= done; count > 0; count--, ct += BLOCK_SIZE, pt += BLOCK_SIZE) {
+        DES::decrypt(ct, BLOCK_SIZE, pt, BLOCK_SIZE);
+    }
+    return true;
+}
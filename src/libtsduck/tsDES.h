@@ -34,11 +34,16 @@
 
 #pragma once
 #include "tsBlockCipher.h"
+#include "tsByteBlock.h"
 
 namespace ts {
     //!
     //! DES block cipher
     //!
+    //! When many independent blocks are processed at a time, encryptBlocks() and
+    //! decryptBlocks() use a bitsliced implementation which processes 64 blocks
+    //! (or 128 blocks with SSE2 or NEON) in parallel.
+    //!
     class TSDUCKDLL DES: public BlockCipher
     {
     public:
@@ -63,10 +68,14 @@ namespace ts {
         virtual bool decrypt(const void* cipher, size_t cipher_length,
                              void* plain, size_t plain_maxsize,
                              size_t* plain_length = 0) override;
+        virtual bool encryptBlocks(const void* plain, void* cipher, size_t count) override;
+        virtual bool decryptBlocks(const void* cipher, void* plain, size_t count) override;
 
     private:
-        uint32_t _ek[32];  // Encryption keys
-        uint32_t _dk[32];  // Decryption keys
+        uint32_t  _ek[32];       // Encryption keys
+        uint32_t  _dk[32];       // Decryption keys
+        uint64_t  _rk[ROUNDS];   // Round keys (48 bits each), for the bitsliced implementation
+        ByteBlock _bs_keys;      // Bitsliced round keys, built on first use
 
         // Computation static methods, shared with TDES
         friend class TDES;
@@ -75,5 +84,7 @@ namespace ts {
         static void cookey(const uint32_t* raw1, uint32_t* keyout);
         static void deskey(const uint8_t* key, uint16_t edf, uint32_t* keyout);
         static void desfunc(uint32_t* block, const uint32_t* keys);
+        static void roundkeys(const uint8_t* key, uint64_t* rkeys);
+        static size_t bitslice(const uint64_t* rkeys, size_t rounds, ByteBlock& bs_keys, bool reverse, const uint8_t* in, uint8_t* out, size_t count);
     };
 }
@@ -30,11 +30,14 @@
 #include "tsDVBCharset.h"
 #include "tsAlgorithm.h"
 #include "tsSingletonManager.h"
+#include <atomic>
 TSDUCK_SOURCE;
 
 #if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
 const uint8_t  ts::DVBCharset::DVB_SINGLE_BYTE_CRLF;
 const uint16_t ts::DVBCharset::DVB_CODEPOINT_CRLF;
+const size_t ts::DVBCharset::DECODE_CACHE_SIZE;
+const size_t ts::DVBCharset::DECODE_CACHE_MIN_SIZE;
 #endif
 
 
@@ -85,6 +88,66 @@ bool ts::DVBCharset::GetCharCodeTable(uint32_t& code, size_t& codeSize, const ui
 }
 
 
+//----------------------------------------------------------------------------
+// Decode a DVB string using a per-thread cache of decoded strings.
+//----------------------------------------------------------------------------
+
+namespace {
+    // Cache state, shared by all threads, disabled by default.
+    std::atomic<bool> cache_enabled(false);
+
+    // Incremented each time a charset is unregistered, invalidates all entries.
+    std::atomic<uint32_t> cache_generation(0);
+
+    // One entry in the cache of a thread.
+    struct DecodeCacheEntry
+    {
+        DecodeCacheEntry() : charset(0), generation(0), status(false), dvb(), str() {}
+        const ts::DVBCharset* charset;
+        uint32_t    generation;
+        bool        status;
+        std::string dvb;  // Raw DVB string, compared on lookup, collisions are harmless.
+        ts::UString str;  // Decoded string.
+    };
+
+    // Hash of the DVB string. Only the size and the first and last 8 bytes are used,
+    // collisions are resolved when the content is compared. Size is at least DECODE_CACHE_MIN_SIZE.
+    size_t DecodeCacheHash(const ts::DVBCharset* charset, const uint8_t* dvb, size_t size)
+    {
+        uint64_t hash = uint64_t(reinterpret_cast<uintptr_t>(charset)) ^ size;
+        hash = (hash ^ ts::GetUInt64(dvb)) * TS_UCONST64(0x9E3779B97F4A7C15);
+        hash = (hash ^ ts::GetUInt64(dvb + size - 8)) * TS_UCONST64(0x9E3779B97F4A7C15);
+        return size_t(hash >> 32);
+    }
+}
+
+void ts::DVBCharset::EnableDecodeCache(bool enable)
+{
+    cache_enabled = enable;
+}
+
+bool ts::DVBCharset::decodeCached(UString& str, const uint8_t* dvb, size_t dvbSize) const
+{
+    if (dvb == 0 || dvbSize < DECODE_CACHE_MIN_SIZE || !cache_enabled.load(std::memory_order_relaxed)) {
+        return decode(str, dvb, dvbSize);
+    }
+
+    // Direct-mapped cache: a new string replaces the previous one with the same hash index.
+    static thread_local DecodeCacheEntry cache[DECODE_CACHE_SIZE];
+    DecodeCacheEntry& entry(cache[DecodeCacheHash(this, dvb, dvbSize) % DECODE_CACHE_SIZE]);
+    const uint32_t generation = cache_generation.load(std::memory_order_relaxed);
+
+    if (entry.charset != this || entry.generation != generation || entry.dvb.size() != dvbSize || ::memcmp(entry.dvb.data(), dvb, dvbSize) != 0) {
+        entry.charset = this;
+        entry.generation = generation;
+        entry.dvb.assign(reinterpret_cast<const char*>(dvb), dvbSize);
+        entry.status = decode(entry.str, dvb, dvbSize);
+    }
+    str = entry.str;
+    return entry.status;
+}
+
+
 //----------------------------------------------------------------------------
 // Encode the character set table code.
 //----------------------------------------------------------------------------
@@ -175,6 +238,8 @@ void ts::DVBCharset::Unregister(const DVBCharset* charset)
         CharSetRepo* repo = CharSetRepo::Instance();
         repo->byName.erase(charset->name());
         repo->byCode.erase(charset->tableCode());
+        // Decoded strings from this charset are no longer valid.
+        cache_generation++;
     }
 }
 
@@ -126,6 +126,40 @@ namespace ts {
         //!
         virtual bool decode(UString& str, const uint8_t* dvb, size_t dvbSize) const = 0;
 
+        //!
+        //! Decode a DVB string from the specified byte buffer, using a cache of decoded strings.
+        //!
+        //! When enabled, each thread keeps a small cache of the last decoded strings, indexed by
+        //! charset and content. Strings which are repeatedly decoded, such as event names and
+        //! descriptions in EIT's, are decoded only once. Very short strings are not cached.
+        //! With simple charsets, the ASCII fast path of decode() is usually as fast as a cache hit.
+        //! The cache is useful with subclasses having an expensive decode().
+        //!
+        //! @param [out] str Returned decoded string.
+        //! @param [in] dvb Address of a DVB string.
+        //! @param [in] dvbSize Size in bytes of the DVB string.
+        //! @return True on success, false on error (truncated, unsupported format, etc.)
+        //! @see EnableDecodeCache()
+        //!
+        bool decodeCached(UString& str, const uint8_t* dvb, size_t dvbSize) const;
+
+        //!
+        //! Enable or disable the cache of decoded strings in all threads.
+        //! The cache is disabled by default.
+        //! @param [in] enable When false, decodeCached() is identical to decode().
+        //!
+        static void EnableDecodeCache(bool enable);
+
+        //!
+        //! Number of entries in the cache of decoded strings of each thread.
+        //!
+        static const size_t DECODE_CACHE_SIZE = 128;
+
+        //!
+        //! Minimum size in bytes of the DVB strings in the cache of decoded strings.
+        //!
+        static const size_t DECODE_CACHE_MIN_SIZE = 8;
+
         //!
         //! Check if a string can be encoded using the charset (ie all characters can be represented).
         //! @param [in] str The string to encode.
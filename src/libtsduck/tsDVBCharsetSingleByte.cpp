@@ -32,6 +32,16 @@
 #include "tsUString.h"
 TSDUCK_SOURCE;
 
+// SSE2 is always available on x86_64 and on i386 when the compiler is allowed to use it.
+// NEON is always available on ARM64. No runtime check is needed in both cases.
+#if !defined(TS_NO_VECTOR_INSTRUCTIONS) && (defined(TS_X86_64) || (defined(TS_I386) && (defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))))
+    #define TS_ASCII_SSE2 1
+    #include <emmintrin.h>
+#elif !defined(TS_NO_VECTOR_INSTRUCTIONS) && defined(TS_ARM64) && (defined(TS_GCC) || defined(TS_LLVM))
+    #define TS_ASCII_NEON 1
+    #include <arm_neon.h>
+#endif
+
 
 //----------------------------------------------------------------------------
 // Protected constructor.
@@ -72,10 +82,53 @@ ts::DVBCharsetSingleByte::DVBCharsetSingleByte(const UString& name, uint32_t tab
 bool ts::DVBCharsetSingleByte::decode(UString& str, const uint8_t* dvb, size_t dvbSize) const
 {
     str.clear();
-    str.reserve(dvbSize);
+    if (dvb == 0 || dvbSize == 0) {
+        return true;
+    }
+
+    // Decode directly into the string, at most one character per byte.
+    str.resize(dvbSize);
+    UChar* const start = &str[0];
+    UChar* out = start;
+    const uint8_t* const end = dvb + dvbSize;
     bool status = true;
 
-    for (; dvb != 0 && dvbSize > 0; --dvbSize) {
+    while (dvb < end) {
+
+#if defined(TS_ASCII_SSE2)
+        // Fast path for runs of printable ASCII characters (identity), 16 at a time.
+        // In signed 8-bit comparisons, bytes 0x80-0xFF are negative and rejected.
+        while (dvb + 16 <= end && *dvb >= 0x20 && *dvb <= 0x7E) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dvb));
+            const __m128i ok = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(0x1F)), _mm_cmplt_epi8(v, _mm_set1_epi8(0x7F)));
+            if (_mm_movemask_epi8(ok) != 0xFFFF) {
+                break;
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_unpacklo_epi8(v, _mm_setzero_si128()));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8), _mm_unpackhi_epi8(v, _mm_setzero_si128()));
+            out += 16;
+            dvb += 16;
+        }
+        if (dvb >= end) {
+            break;
+        }
+#elif defined(TS_ASCII_NEON)
+        // Fast path for runs of printable ASCII characters (identity), 16 at a time.
+        while (dvb + 16 <= end && *dvb >= 0x20 && *dvb <= 0x7E) {
+            const uint8x16_t v = vld1q_u8(dvb);
+            if (vminvq_u8(vandq_u8(vcgeq_u8(v, vdupq_n_u8(0x20)), vcleq_u8(v, vdupq_n_u8(0x7E)))) != 0xFF) {
+                break;
+            }
+            vst1q_u16(reinterpret_cast<uint16_t*>(out), vmovl_u8(vget_low_u8(v)));
+            vst1q_u16(reinterpret_cast<uint16_t*>(out + 8), vmovl_u8(vget_high_u8(v)));
+            out += 16;
+            dvb += 16;
+        }
+        if (dvb >= end) {
+            break;
+        }
+#endif
+
         // Get next byte
         const uint8_t b = *dvb++;
         // Convert it to a code point
@@ -91,13 +144,15 @@ bool ts::DVBCharsetSingleByte::decode(UString& str, const uint8_t* dvb, size_t d
         }
         // Add in result if no error.
         if (cp != 0) {
-            str.push_back(UChar(cp));
+            *out++ = UChar(cp);
         }
         else {
             // Untranslatable character.
             status = false;
         }
     }
+
+    str.resize(out - start);
     return status;
 }
 
@@ -43,10 +43,13 @@ bool ts::DVBCharsetUTF16::decode(UString& str, const uint8_t* dvb, size_t dvbSiz
 {
     // We simply copy 2 bytes per character.
     str.clear();
-    str.reserve(dvbSize / 2);
-    for (size_t i = 0; dvb != 0 && i + 1 < dvbSize; i += 2) {
-        const uint16_t cp = GetUInt16(dvb + i);
-        str.push_back(cp == DVB_CODEPOINT_CRLF ? ts::LINE_FEED : UChar(cp));
+    if (dvb != 0 && dvbSize >= 2) {
+        str.resize(dvbSize / 2);
+        UChar* out = &str[0];
+        for (size_t i = 0; i + 1 < dvbSize; i += 2) {
+            const uint16_t cp = GetUInt16(dvb + i);
+            *out++ = cp == DVB_CODEPOINT_CRLF ? ts::LINE_FEED : UChar(cp);
+        }
     }
 
     // Truncated string if odd number of bytes.
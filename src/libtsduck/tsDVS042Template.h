@@ -117,26 +117,17 @@ bool ts::DVS042<CIPHER>::decrypt(const void* cipher, size_t cipher_length,
 
     // Decrypt all blocks in CBC mode, except the last one if partial
 
-    const uint8_t* previous = this->iv.data();
     const uint8_t* ct = reinterpret_cast<const uint8_t*>(cipher);
     uint8_t* pt = reinterpret_cast<uint8_t*>(plain);
 
-    while (cipher_length >= this->block_size) {
-        // work = decrypt (cipher-text)
-        if (!this->algo->decrypt(ct, this->block_size, this->work.data(), this->block_size)) {
-            return false;
-        }
-        // plain-text = previous-cipher XOR work
-        for (size_t i = 0; i < this->block_size; ++i) {
-            pt[i] = previous[i] ^ this->work[i];
-        }
-        // previous-cipher = cipher-text
-        previous = ct;
-        // advance one block
-        ct += this->block_size;
-        pt += this->block_size;
-        cipher_length -= this->block_size;
+    const size_t count = cipher_length / this->block_size;
+    const uint8_t* const previous = this->decryptCBC(ct, pt, count);
+    if (previous == 0) {
+        return false;
     }
+    ct += count * this->block_size;
+    pt += count * this->block_size;
+    cipher_length -= count * this->block_size;
 
     // Process final block if incomplete
 
@@ -152,3 +143,31 @@ bool ts::DVS042<CIPHER>::decrypt(const void* cipher, size_t cipher_length,
     }
     return true;
 }
+
+
+//----------------------------------------------------------------------------
+// Encryption / decryption of several messages in DVS 042 mode.
+// The independent chains of all messages are interleaved.
+//----------------------------------------------------------------------------
+
+template<class CIPHER>
+bool ts::DVS042<CIPHER>::encryptMessages(uint8_t* const data[], const size_t sizes[], size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        if (sizes[i] < this->block_size) {
+            return false;
+        }
+    }
+    return this->encryptCBCMessages(data, sizes, count, true);
+}
+
+template<class CIPHER>
+bool ts::DVS042<CIPHER>::decryptMessages(uint8_t* const data[], const size_t sizes[], size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        if (sizes[i] < this->block_size) {
+            return false;
+        }
+    }
+    return this->decryptCBCMessages(data, sizes, count, true);
+}
@@ -0,0 +1,96 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  An allocator which default-initializes the elements of a container.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsPlatform.h"
+
+namespace ts {
+    //!
+    //! An allocator which default-initializes the elements of a container.
+    //!
+    //! A standard container such as @c std::vector value-initializes the new elements
+    //! when it grows using @c resize(n). For integer types, this means zero-filling the
+    //! new memory. When the new elements are immediately overwritten (reading data from
+    //! a file, deserializing a section), this initialization is useless. With this
+    //! allocator, @c resize(n) leaves the new elements of trivial types uninitialized.
+    //! An explicit value, as in @c resize(n,0), is still applied.
+    //!
+    //! @tparam T Type of the elements.
+    //! @tparam A Base allocator, @c std::allocator by default.
+    //!
+    template <typename T, class A = std::allocator<T>>
+    class DefaultInitAllocator: public A
+    {
+    public:
+        //!
+        //! Obtain an allocator for another type.
+        //! @tparam U Another type of elements.
+        //!
+        template <typename U>
+        struct rebind
+        {
+            //! The same allocator type for elements of type @a U.
+            typedef DefaultInitAllocator<U, typename std::allocator_traits<A>::template rebind_alloc<U>> other;
+        };
+
+        //!
+        //! Constructors are inherited from the base allocator.
+        //!
+        using A::A;
+
+        //!
+        //! Construct an element without argument: default-initialization.
+        //! @tparam U Type of the element.
+        //! @param [in] ptr Address of the element.
+        //!
+        template <typename U>
+        void construct(U* ptr) noexcept(std::is_nothrow_default_constructible<U>::value)
+        {
+            ::new(static_cast<void*>(ptr)) U;
+        }
+
+        //!
+        //! Construct an element with arguments, as the base allocator.
+        //! @tparam U Type of the element.
+        //! @tparam ARGS Types of the constructor arguments.
+        //! @param [in] ptr Address of the element.
+        //! @param [in] args Constructor arguments.
+        //!
+        template <typename U, typename... ARGS>
+        void construct(U* ptr, ARGS&&... args)
+        {
+            std::allocator_traits<A>::construct(static_cast<A&>(*this), ptr, std::forward<ARGS>(args)...);
+        }
+    };
+}
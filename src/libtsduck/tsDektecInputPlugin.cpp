@@ -37,7 +37,11 @@
 #include "tsDektecUtils.h"
 #include "tsDektecDevice.h"
 #include "tsDektecVPD.h"
+#include "tsSignalMonitor.h"
 #include "tsIntegerUtils.h"
+#include "tsThread.h"
+#include "tsGuardCondition.h"
+#include "tsTime.h"
 #include "tsFatal.h"
 TSDUCK_SOURCE;
 
@@ -81,6 +85,12 @@ size_t ts::DektecInputPlugin::receive(TSPacket* buffer, size_t max_packets)
     return 0;
 }
 
+size_t ts::DektecInputPlugin::receiveWithMetadata(TSPacket* buffer, TSPacketMetadata* mdata, size_t max_packets)
+{
+    tsp->error(TS_NO_DTAPI_MESSAGE);
+    return 0;
+}
+
 #else
 
 //----------------------------------------------------------------------------
@@ -90,30 +100,189 @@ size_t ts::DektecInputPlugin::receive(TSPacket* buffer, size_t max_packets)
 class ts::DektecInputPlugin::Guts
 {
 public:
+    // Background monitoring of the input channel.
+    class Monitor: public SignalMonitor
+    {
+    public:
+        Monitor(Guts* guts, TSP* tsp);
+        virtual ~Monitor() override;
+    private:
+        Guts*   _guts;
+        TSP*    _tsp;
+        int     _poll_cnt;      // Count the first polls
+        BitRate _cur_bitrate;   // Current input bitrate
+        virtual void pollDevice() override;
+
+        // Inaccessible operations
+        Monitor() = delete;
+        Monitor(const Monitor&) = delete;
+        Monitor& operator=(const Monitor&) = delete;
+    };
+
+    // Reception thread, reads large DMA blocks from the device into the ring of blocks.
+    class Receiver: public Thread
+    {
+    public:
+        Receiver(Guts* guts, TSP* tsp);
+        virtual ~Receiver() override;
+    private:
+        Guts* _guts;
+        TSP*  _tsp;
+        virtual void main() override;
+
+        // Inaccessible operations
+        Receiver() = delete;
+        Receiver(const Receiver&) = delete;
+        Receiver& operator=(const Receiver&) = delete;
+    };
+
     bool                is_started;   // Device started
     int                 dev_index;    // Dektec device index
     int                 chan_index;   // Device input channel index
+    size_t              dma_size;     // Size of DMA transfers in reception thread mode, zero means direct reads
+    size_t              ring_blocks;  // Number of DMA blocks in the ring
+    bool                timestamps;   // Use hardware time stamps
     DektecDevice        device;       // Device characteristics
     Dtapi::DtDevice     dtdev;        // Device descriptor
     Dtapi::DtInpChannel chan;         // Input channel
-    int                 init_cnt;     // Count the first inputs
-    BitRate             cur_bitrate;  // Current input bitrate
-    bool                got_bitrate;  // Got bitrate at least once.
+    SafePtr<Monitor, NullMutex> monitor;   // Monitoring thread of the input channel
+    SafePtr<Receiver, NullMutex> receiver; // Reception thread, null in direct read mode
+    size_t              rec_size;     // Size of a packet record from the device, with or without time stamp
+    int                 clock_freq;   // Frequency of the device reference clock (time stamps)
+    ByteBlock           ring_mem;     // Memory of the ring of DMA blocks, with room for alignment
+    uint8_t*            ring;         // Aligned address of the ring of DMA blocks
+
+    // Ring state, shared between the reception thread and the plugin thread.
+    Mutex               mutex;        // Protect the following fields
+    Condition           got_block;    // Signaled when a block is filled
+    Condition           got_space;    // Signaled when a block is freed
+    size_t              ring_first;   // Index of first filled block
+    size_t              ring_count;   // Number of filled blocks
+    size_t              first_offset; // Offset of next record in first filled block
+    bool                terminate;    // Request termination of the reception thread
+    bool                running;      // The reception thread is running
+    bool                rec_error;    // The reception thread got an error
+    uint64_t            anchor_ticks; // Hardware time stamp of the anchor point
+    NanoSecond          anchor_time;  // Real-time clock at the anchor point, negative if unset
 
     Guts() :                          // Constructor.
         is_started(false),
         dev_index(-1),
         chan_index(-1),
+        dma_size(0),
+        ring_blocks(0),
+        timestamps(false),
         device(),
         dtdev(),
         chan(),
-        init_cnt(0),
-        cur_bitrate(0),
-        got_bitrate(false)
+        monitor(),
+        receiver(),
+        rec_size(PKT_SIZE),
+        clock_freq(0),
+        ring_mem(),
+        ring(0),
+        mutex(),
+        got_block(),
+        got_space(),
+        ring_first(0),
+        ring_count(0),
+        first_offset(0),
+        terminate(false),
+        running(false),
+        rec_error(false),
+        anchor_ticks(0),
+        anchor_time(-1)
     {
     }
+
+    // Start and stop the reception thread.
+    bool startReceiver(TSP* tsp);
+    void stopReceiver();
+
+    // Get packets from the ring of DMA blocks, return zero on error or abort.
+    size_t pullPackets(TSPacket* buffer, TSPacketMetadata* mdata, size_t max_packets, TSP* tsp);
+
+    // Convert a hardware time stamp into nanoseconds on the real-time clock.
+    NanoSecond hardwareTime(uint64_t ticks) const;
+
+    // Current time on the real-time clock, as expected in input time stamps, negative if unavailable.
+    static NanoSecond RealTime();
 };
 
+// Size of the hardware time stamp in front of each packet (DTAPI_RX_TIMESTAMP64).
+#define TIMESTAMP_SIZE 8
+
+// Alignment of DMA blocks in memory.
+#define DMA_ALIGN 4096
+
+// Default values in reception thread mode.
+#define DEFAULT_DMA_SIZE    (PKT_SIZE * 5 * 1024)  // ~940 kB, about 35 ms at full ASI rate
+#define DEFAULT_RING_BLOCKS 32
+
+// Timeout of reads in the reception thread, to check termination requests, and of waits in the plugin thread.
+#define RECEIVE_TIMEOUT 200
+
+
+//----------------------------------------------------------------------------
+// Monitoring thread of the input channel.
+// The status of the channel is read here, not in the input path.
+//----------------------------------------------------------------------------
+
+// Polling interval, short enough to detect FIFO overflows.
+#define MONITOR_POLL_INTERVAL 100
+
+// The first polls are "initialization". If a full input fifo is observed
+// here, ignore it. Later, a full fifo indicates potential packet loss.
+#define MONITOR_INIT_POLLS 5
+
+ts::DektecInputPlugin::Guts::Monitor::Monitor(Guts* guts, TSP* tsp) :
+    SignalMonitor(UString::Format(u"dektec:%d:%d", {guts->dev_index, guts->chan_index}), MONITOR_POLL_INTERVAL),
+    _guts(guts),
+    _tsp(tsp),
+    _poll_cnt(0),
+    _cur_bitrate(0)
+{
+}
+
+ts::DektecInputPlugin::Guts::Monitor::~Monitor()
+{
+    stop();
+}
+
+void ts::DektecInputPlugin::Guts::Monitor::pollDevice()
+{
+    if (_poll_cnt < MONITOR_INIT_POLLS) {
+        _poll_cnt++;
+    }
+
+    int fifo_load = 0;
+    Dtapi::DTAPI_RESULT status = _guts->chan.GetFifoLoad(fifo_load);
+    if (status != DTAPI_OK) {
+        _tsp->error(u"error getting input fifo load: %s", {DektecStrError(status)});
+        setFifoLoad(-1);
+    }
+    else {
+        setFifoLoad(fifo_load);
+        if (fifo_load >= int(DTA_FIFO_SIZE) && _poll_cnt >= MONITOR_INIT_POLLS) {
+            // Input overflow.
+            _tsp->warning(u"input fifo full, possible packet loss");
+        }
+    }
+
+    int bitrate = 0;
+    status = _guts->chan.GetTsRateBps(bitrate);
+    if (status != DTAPI_OK) {
+        _tsp->error(u"error getting Dektec device input bitrate: " + DektecStrError(status));
+    }
+    else {
+        if (_cur_bitrate != 0 && bitrate != int(_cur_bitrate)) {
+            _tsp->verbose(u"new input bitrate: %'d b/s", {bitrate});
+        }
+        _cur_bitrate = BitRate(std::max(0, bitrate));
+        setBitrate(_cur_bitrate);
+    }
+}
+
 
 //----------------------------------------------------------------------------
 // Input constructor
@@ -127,6 +296,9 @@ ts::DektecInputPlugin::DektecInputPlugin(TSP* tsp_) :
 
     option(u"channel", 'c', UNSIGNED);
     option(u"device", 'd', UNSIGNED);
+    option(u"dma-block-size", 0, INTEGER, 0, 1, PKT_SIZE + TIMESTAMP_SIZE, DTA_MAX_IO_SIZE);
+    option(u"ring-blocks", 0, INTEGER, 0, 1, 2, 1024);
+    option(u"timestamp", 't');
 
     setHelp(u"Options:\n"
             u"\n"
@@ -142,9 +314,28 @@ ts::DektecInputPlugin::DektecInputPlugin(TSP* tsp_) :
             u"      complete list of devices in the system. By default, use the first\n"
             u"      input Dektec device.\n"
             u"\n"
+            u"  --dma-block-size value\n"
+            u"      Read the device in a dedicated reception thread, using DMA transfers of\n"
+            u"      the specified size in bytes, into an intermediate ring of blocks. The\n"
+            u"      size is rounded down to a multiple of the packet size. Large transfers\n"
+            u"      are required to sustain high bitrates without input overflow. By default,\n"
+            u"      the packets are directly read in the tsp buffer, using variable-size\n"
+            u"      transfers, unless --ring-blocks or --timestamp is specified, in which\n"
+            u"      case the default DMA block size is 962,560 bytes.\n"
+            u"\n"
             u"  --help\n"
             u"      Display this help text.\n"
             u"\n"
+            u"  --ring-blocks value\n"
+            u"      Number of DMA blocks in the ring of the reception thread. Implies the\n"
+            u"      reception thread mode. The default is 32.\n"
+            u"\n"
+            u"  -t\n"
+            u"  --timestamp\n"
+            u"      Enable the hardware time stamps of the device. The arrival time of each\n"
+            u"      packet, as measured by the device, is used as input time stamp in the\n"
+            u"      packet metadata. Implies the reception thread mode.\n"
+            u"\n"
             u"  --version\n"
             u"      Display the version number.\n");
 }
@@ -164,6 +355,11 @@ bool ts::DektecInputPlugin::start()
     // Get command line argumentsu
     _guts->dev_index = intValue<int>(u"device", -1);
     _guts->chan_index = intValue<int>(u"channel", -1);
+    _guts->timestamps = present(u"timestamp");
+    _guts->ring_blocks = intValue<size_t>(u"ring-blocks", DEFAULT_RING_BLOCKS);
+    _guts->dma_size = intValue<size_t>(u"dma-block-size", _guts->timestamps || present(u"ring-blocks") ? DEFAULT_DMA_SIZE : 0);
+    _guts->rec_size = _guts->timestamps ? PKT_SIZE + TIMESTAMP_SIZE : PKT_SIZE;
+    _guts->dma_size = RoundDown(_guts->dma_size, _guts->rec_size);
 
     // Locate the device
     if (!_guts->device.getDevice(_guts->dev_index, _guts->chan_index, true, *tsp)) {
@@ -194,10 +390,22 @@ bool ts::DektecInputPlugin::start()
         return false;
     }
 
+    // With hardware time stamps, get the frequency of the time stamps clock.
+    if (_guts->timestamps) {
+        status = _guts->dtdev.GetRefClkFreq(_guts->clock_freq);
+        if (status != DTAPI_OK || _guts->clock_freq <= 0) {
+            tsp->error(u"error getting Dektec device reference clock frequency: %s", {DektecStrError(status)});
+            _guts->chan.Detach(0);
+            _guts->dtdev.Detach();
+            return false;
+        }
+    }
+
     // Set the receiving packet size to 188 bytes (the size of the packets
     // which are returned by the board to the application, dropping extra 16
-    // bytes if the transmitted packets are 204-byte).
-    status = _guts->chan.SetRxMode(DTAPI_RXMODE_ST188);
+    // bytes if the transmitted packets are 204-byte). With hardware time
+    // stamps, each packet is preceded by a 64-bit time stamp.
+    status = _guts->chan.SetRxMode(DTAPI_RXMODE_ST188 | (_guts->timestamps ? DTAPI_RX_TIMESTAMP64 : 0));
     if (status != DTAPI_OK) {
         tsp->error(u"device SetRxMode error: %s", {DektecStrError(status)});
         _guts->chan.Detach(0);
@@ -214,10 +422,25 @@ bool ts::DektecInputPlugin::start()
         return false;
     }
 
-    // Consider that the first 5 inputs are "initialization". If a full input
-    // fifo is observed here, ignore it. Later, a full fifo indicates potential
-    // packet loss.
-    _guts->init_cnt = 5;
+    // Start monitoring the input channel (FIFO load, bitrate) in the background.
+    _guts->monitor = new Guts::Monitor(_guts, tsp);
+    if (!_guts->monitor->start()) {
+        tsp->error(u"cannot start Dektec monitoring thread");
+        _guts->monitor.clear();
+        _guts->chan.Detach(0);
+        _guts->dtdev.Detach();
+        return false;
+    }
+
+    // Start the reception thread, if required.
+    if (_guts->dma_size > 0 && !_guts->startReceiver(tsp)) {
+        _guts->monitor->stop();
+        _guts->monitor.clear();
+        _guts->chan.Detach(0);
+        _guts->dtdev.Detach();
+        return false;
+    }
+
     _guts->is_started = true;
     return true;
 }
@@ -230,6 +453,9 @@ bool ts::DektecInputPlugin::start()
 bool ts::DektecInputPlugin::stop()
 {
     if (_guts->is_started) {
+        _guts->stopReceiver();
+        _guts->monitor->stop();
+        _guts->monitor.clear();
         _guts->chan.Detach(0);
         _guts->dtdev.Detach();
         _guts->is_started = false;
@@ -257,68 +483,226 @@ ts::DektecInputPlugin::~DektecInputPlugin()
 //----------------------------------------------------------------------------
 
 ts::BitRate ts::DektecInputPlugin::getBitrate()
+{
+    // The input bitrate is periodically read by the monitoring thread.
+    return _guts->is_started ? _guts->monitor->bitrate() : 0;
+}
+
+
+//----------------------------------------------------------------------------
+// Input method
+//----------------------------------------------------------------------------
+
+size_t ts::DektecInputPlugin::receive(TSPacket* buffer, size_t max_packets)
 {
     if (!_guts->is_started) {
         return 0;
     }
+    else if (!_guts->receiver.isNull()) {
+        return _guts->pullPackets(buffer, 0, max_packets, tsp);
+    }
 
-    int bitrate;
-    Dtapi::DTAPI_RESULT status = _guts->chan.GetTsRateBps(bitrate);
+    // The FIFO load is checked by the monitoring thread, not here.
+    // Do not read more than what a DTA device accepts
+    size_t size = RoundDown(std::min(max_packets * PKT_SIZE, DTA_MAX_IO_SIZE), PKT_SIZE);
 
-    if (status != DTAPI_OK) {
-        tsp->error(u"error getting Dektec device input bitrate: " + DektecStrError(status));
-        return 0;
+    // Receive packets (wait if no input signal)
+    const Dtapi::DTAPI_RESULT status = _guts->chan.Read(reinterpret_cast<char*> (buffer), int(size));
+    if (status == DTAPI_OK) {
+        return size / PKT_SIZE;
     }
-    if (_guts->got_bitrate && bitrate != int(_guts->cur_bitrate)) {
-        tsp->verbose(u"new input bitrate: %'d b/s", {bitrate});
+    else {
+        tsp->error(u"capture error on Dektec device %d: %s", {_guts->dev_index, DektecStrError(status)});
+        return 0;
     }
+}
 
-    _guts->got_bitrate = true;
-    return _guts->cur_bitrate = bitrate;
+size_t ts::DektecInputPlugin::receiveWithMetadata(TSPacket* buffer, TSPacketMetadata* mdata, size_t max_packets)
+{
+    if (_guts->is_started && !_guts->receiver.isNull()) {
+        return _guts->pullPackets(buffer, mdata, max_packets, tsp);
+    }
+    else {
+        return receive(buffer, max_packets);
+    }
 }
 
 
 //----------------------------------------------------------------------------
-// Input method
+// Start and stop the reception thread.
 //----------------------------------------------------------------------------
 
-size_t ts::DektecInputPlugin::receive(TSPacket* buffer, size_t max_packets)
+bool ts::DektecInputPlugin::Guts::startReceiver(TSP* tsp)
 {
-    if (!_guts->is_started) {
-        return 0;
+    // Allocate the ring of DMA blocks, aligned on a page boundary.
+    ring_mem.resize(ring_blocks * dma_size + DMA_ALIGN);
+    ring = ring_mem.data() + (RoundUp(size_t(ring_mem.data()), size_t(DMA_ALIGN)) - size_t(ring_mem.data()));
+    ring_first = ring_count = first_offset = 0;
+    terminate = rec_error = false;
+    running = true;
+    anchor_ticks = 0;
+    anchor_time = -1;
+
+    tsp->debug(u"reception thread mode, DMA block size: %'d bytes, ring: %d blocks, time stamps: %s", {dma_size, ring_blocks, timestamps});
+
+    receiver = new Receiver(this, tsp);
+    if (!receiver->start()) {
+        tsp->error(u"cannot start Dektec reception thread");
+        receiver.clear();
+        running = false;
+        return false;
     }
+    return true;
+}
 
-    Dtapi::DTAPI_RESULT status;
-
-    // After initialization, we check the receive FIFO load before reading it.
-    // If the FIFO is full, we have lost packets.
-    if (_guts->init_cnt > 0) {
-        _guts->init_cnt--;
+void ts::DektecInputPlugin::Guts::stopReceiver()
+{
+    if (!receiver.isNull()) {
+        {
+            GuardCondition lock(mutex, got_space);
+            terminate = true;
+            lock.signal();
+        }
+        // The destructor waits for the termination of the thread.
+        receiver.clear();
     }
-    if (_guts->init_cnt == 0) {
-        int fifo_load;
-        status = _guts->chan.GetFifoLoad(fifo_load);
+    ring_mem.clear();
+    ring = 0;
+}
+
+
+//----------------------------------------------------------------------------
+// Current time and hardware time stamps on the real-time clock.
+//----------------------------------------------------------------------------
+
+ts::NanoSecond ts::DektecInputPlugin::Guts::RealTime()
+{
+#if defined(TS_UNIX)
+    return Time::UnixClockNanoSeconds(CLOCK_REALTIME);
+#else
+    // Input time stamps from plugins are not used on this platform.
+    return -1;
+#endif
+}
+
+ts::NanoSecond ts::DektecInputPlugin::Guts::hardwareTime(uint64_t ticks) const
+{
+    // Compute in two steps to avoid overflows on long durations.
+    const int64_t delta = int64_t(ticks - anchor_ticks);
+    return anchor_time + (delta / clock_freq) * NanoSecPerSec + ((delta % clock_freq) * NanoSecPerSec) / clock_freq;
+}
+
+
+//----------------------------------------------------------------------------
+// Reception thread: read large DMA blocks into the ring.
+//----------------------------------------------------------------------------
+
+ts::DektecInputPlugin::Guts::Receiver::Receiver(Guts* guts, TSP* tsp) :
+    Thread(ThreadAttributes().setPriority(ThreadAttributes::GetHighPriority())),
+    _guts(guts),
+    _tsp(tsp)
+{
+}
+
+ts::DektecInputPlugin::Guts::Receiver::~Receiver()
+{
+    waitForTermination();
+}
+
+void ts::DektecInputPlugin::Guts::Receiver::main()
+{
+    bool ok = true;
+
+    while (ok) {
+
+        // Wait for a free block in the ring.
+        uint8_t* block = 0;
+        {
+            GuardCondition lock(_guts->mutex, _guts->got_space);
+            while (!_guts->terminate && _guts->ring_count >= _guts->ring_blocks) {
+                lock.waitCondition();
+            }
+            if (_guts->terminate) {
+                break;
+            }
+            block = _guts->ring + ((_guts->ring_first + _guts->ring_count) % _guts->ring_blocks) * _guts->dma_size;
+        }
+
+        // Fill the block, outside the lock. The data remain in the device FIFO
+        // until a complete block is available or the timeout expires.
+        const Dtapi::DTAPI_RESULT status = _guts->chan.Read(reinterpret_cast<char*>(block), int(_guts->dma_size), RECEIVE_TIMEOUT);
+        if (status == DTAPI_E_TIMEOUT) {
+            continue; // check termination requests
+        }
+        const NanoSecond now = _guts->timestamps && _guts->anchor_time < 0 ? RealTime() : -1;
+
+        GuardCondition lock(_guts->mutex, _guts->got_block);
         if (status != DTAPI_OK) {
-            tsp->error(u"error getting input fifo load: %s", {DektecStrError(status)});
+            _tsp->error(u"capture error on Dektec device %d: %s", {_guts->dev_index, DektecStrError(status)});
+            ok = false;
         }
-        if (fifo_load >= int(DTA_FIFO_SIZE)) {
-            // Input overflow.
-            tsp->warning(u"input fifo full, possible packet loss");
+        else {
+            // Anchor the hardware clock on the real-time clock, using the last packet of the first block.
+            if (now >= 0) {
+                _guts->anchor_ticks = GetUInt64LE(block + _guts->dma_size - _guts->rec_size);
+                _guts->anchor_time = now;
+            }
+            _guts->ring_count++;
         }
+        lock.signal();
     }
 
-    // Do not read more than what a DTA device accepts
-    size_t size = RoundDown(std::min(max_packets * PKT_SIZE, DTA_MAX_IO_SIZE), PKT_SIZE);
+    GuardCondition lock(_guts->mutex, _guts->got_block);
+    _guts->rec_error = _guts->rec_error || !ok;
+    _guts->running = false;
+    lock.signal();
+}
 
-    // Receive packets (wait if no input signal)
-    status = _guts->chan.Read(reinterpret_cast<char*> (buffer), int(size));
-    if (status == DTAPI_OK) {
-        return size / PKT_SIZE;
+
+//----------------------------------------------------------------------------
+// Get packets from the ring of DMA blocks.
+//----------------------------------------------------------------------------
+
+size_t ts::DektecInputPlugin::Guts::pullPackets(TSPacket* buffer, TSPacketMetadata* mdata, size_t max_packets, TSP* tsp)
+{
+    GuardCondition lock(mutex, got_block);
+
+    // Wait for a filled block, with a timeout to check abort requests.
+    while (ring_count == 0) {
+        if (tsp->aborting() || rec_error || !running) {
+            return 0;
+        }
+        lock.waitCondition(RECEIVE_TIMEOUT);
     }
-    else {
-        tsp->error(u"capture error on Dektec device %d: %s", {_guts->dev_index, DektecStrError(status)});
-        return 0;
+
+    // Copy the packets from the filled blocks.
+    size_t pkt_cnt = 0;
+    while (pkt_cnt < max_packets && ring_count > 0) {
+        const uint8_t* rec = ring + ring_first * dma_size + first_offset;
+        const size_t n = std::min(max_packets - pkt_cnt, (dma_size - first_offset) / rec_size);
+        if (!timestamps) {
+            ::memcpy(buffer[pkt_cnt].b, rec, n * PKT_SIZE);
+        }
+        else {
+            for (size_t i = 0; i < n; ++i) {
+                ::memcpy(buffer[pkt_cnt + i].b, rec + TIMESTAMP_SIZE, PKT_SIZE);
+                if (mdata != 0 && anchor_time >= 0) {
+                    mdata[pkt_cnt + i].setInputTimeStamp(hardwareTime(GetUInt64LE(rec)));
+                }
+                rec += rec_size;
+            }
+        }
+        pkt_cnt += n;
+        first_offset += n * rec_size;
+        if (first_offset >= dma_size) {
+            // The first block is now free.
+            ring_first = (ring_first + 1) % ring_blocks;
+            ring_count--;
+            first_offset = 0;
+            got_space.signal();
+        }
     }
+    return pkt_cnt;
 }
 
 #endif // TS_NO_DTAPI
@@ -57,6 +57,7 @@ namespace ts {
         virtual bool start() override;
         virtual bool stop() override;
         virtual size_t receive(TSPacket*, size_t) override;
+        virtual size_t receiveWithMetadata(TSPacket*, TSPacketMetadata*, size_t) override;
         virtual BitRate getBitrate() override;
         virtual size_t stackUsage() const override {return 512 * 1024;} // 512 kB
 
@@ -44,6 +44,8 @@
 #include "tsTunerParametersATSC.h"
 #include "tsModulation.h"
 #include "tsIntegerUtils.h"
+#include "tsByteBlock.h"
+#include "tsTime.h"
 TSDUCK_SOURCE;
 
 
@@ -87,6 +89,19 @@ bool ts::DektecOutputPlugin::send(const TSPacket* buffer, size_t packet_count)
 
 #else
 
+//----------------------------------------------------------------------------
+// Closed-loop FIFO control parameters.
+//----------------------------------------------------------------------------
+
+namespace {
+    const int             DEFAULT_FIFO_TARGET = 50;           // Default target FIFO load, in percent
+    const size_t          DEFAULT_CHUNK_SIZE = 256 * 1024;    // Default device write size in closed-loop mode
+    const ts::MilliSecond CONTROL_INTERVAL = 500;             // Minimum interval between two FIFO load samples
+    const int             CONVERGENCE_SECONDS = 10;           // Time to absorb the distance to the target load
+    const int64_t         MAX_DEVIATION_PPM = 20000;          // Maximum bitrate offset from reference bitrate
+}
+
+
 //----------------------------------------------------------------------------
 // Class internals.
 //----------------------------------------------------------------------------
@@ -105,6 +120,19 @@ public:
     int                  detach_mode;  // Detach mode
     BitRate              opt_bitrate;  // Bitrate option (0 means unspecified)
     BitRate              cur_bitrate;  // Current output bitrate
+    BitRate              ref_bitrate;  // Reference bitrate (option or input), without closed-loop offset
+    size_t               fifo_size;    // Actual size of the output FIFO in bytes
+    bool                 fifo_control; // Closed-loop control of the FIFO load
+    bool                 adjust_rate;  // Closed-loop adjusts the bitrate (otherwise, insert null packets)
+    int                  fifo_target;  // Target FIFO load in bytes
+    size_t               chunk_size;   // Size of device writes in bytes (0 means same as send())
+    ByteBlock            chunk;        // Pending data, less than chunk_size bytes
+    TSPacketVector       nulls;        // Null packets to insert
+    Time                 last_time;    // Time of last FIFO load sample
+    int                  last_load;    // Last FIFO load sample in bytes
+    int64_t              rate_drift;   // Estimated input bitrate drift from reference in b/s
+    int64_t              rate_offset;  // Current output bitrate offset from reference in b/s
+    PacketCounter        null_count;   // Number of inserted null packets
 
     Guts() :                           // Constructor.
         starting(false),
@@ -117,7 +145,20 @@ public:
         chan(),
         detach_mode(DTAPI_WAIT_UNTIL_SENT),
         opt_bitrate(0),
-        cur_bitrate(0)
+        cur_bitrate(0),
+        ref_bitrate(0),
+        fifo_size(DTA_FIFO_SIZE),
+        fifo_control(false),
+        adjust_rate(false),
+        fifo_target(0),
+        chunk_size(0),
+        chunk(),
+        nulls(),
+        last_time(Time::Epoch),
+        last_load(0),
+        rate_drift(0),
+        rate_offset(0),
+        null_count(0)
     {
     }
 };
@@ -159,6 +200,7 @@ ts::DektecOutputPlugin::DektecOutputPlugin(TSP* tsp_) :
     option(u"bitrate", 'b', POSITIVE);
     option(u"cell-id", 0,  UINT16);
     option(u"channel", 'c', UNSIGNED);
+    option(u"chunk-size", 0, INTEGER, 0, 1, PKT_SIZE, DTA_MAX_IO_SIZE);
     option(u"cmmb-bandwidth", 0, Enumeration({
         {u"2", DTAPI_CMMB_BW_2MHZ},
         {u"8", DTAPI_CMMB_BW_8MHZ},
@@ -220,6 +262,8 @@ ts::DektecOutputPlugin::DektecOutputPlugin(TSP* tsp_) :
         {u"1K-384", DTAPI_DVBT2_FEF_1K_OFDM_384},
     }));
     option(u"fef-type", 0, INTEGER, 0, 1, 0, 15);
+    option(u"fifo-control");
+    option(u"fifo-target", 0, INTEGER, 0, 1, 10, 90);
     option(u"fft-mode", 0, Enumeration({
         {u"1K",  DTAPI_DVBT2_FFT_1K},
         {u"2K",  DTAPI_DVBT2_FFT_2K},
@@ -418,6 +462,12 @@ ts::DektecOutputPlugin::DektecOutputPlugin(TSP* tsp_) :
             u"      Channel index on the output Dektec device. By default, use the\n"
             u"      first output channel on the device.\n"
             u"\n"
+            u"  --chunk-size value\n"
+            u"      Size in bytes of each write operation on the device. Packets are\n"
+            u"      accumulated and written in large chunks, independently of the chunks\n"
+            u"      of packets which are provided by tsp. By default, packets are written\n"
+            u"      as they come, or by chunks of " + UString::Decimal(DEFAULT_CHUNK_SIZE) + u" bytes with --fifo-control.\n"
+            u"\n"
             u"  --cmmb-area-id value\n"
             u"      CMMB modulators: indicate the area id. The valid range is 0 to 127.\n"
             u"      The default is zero.\n"
@@ -508,6 +558,19 @@ ts::DektecOutputPlugin::DektecOutputPlugin(TSP* tsp_) :
             u"      DVB-T2 modulators: indicate the FEF type. The valid range is 0 ... 15.\n"
             u"      The default is 0.\n"
             u"\n"
+            u"  --fifo-control\n"
+            u"      Closed-loop control of the output FIFO load. The FIFO is first loaded\n"
+            u"      up to the target load (see --fifo-target). Then the FIFO load and its\n"
+            u"      trend are periodically checked. With ASI devices and no --bitrate, the\n"
+            u"      output bitrate is slightly adjusted (up to 2%) to maintain the target\n"
+            u"      load when the input bitrate is inaccurate. With a fixed output bitrate\n"
+            u"      (modulators, --bitrate, --symbol-rate), null packets are inserted when\n"
+            u"      the FIFO load decreases below the target, to avoid underflows.\n"
+            u"\n"
+            u"  --fifo-target value\n"
+            u"      With --fifo-control, target load of the output FIFO, in percent of the\n"
+            u"      FIFO size. The valid range is 10 to 90. The default is " + UString::Decimal(DEFAULT_FIFO_TARGET) + u"%.\n"
+            u"\n"
             u"  --fft-mode value\n"
             u"      DVB-T2 modulators: indicate the FFT mode. Must be one of 1K, 2K, 4K, 8K,\n"
             u"      16K or 32K. The default is 32K.\n"
@@ -795,6 +858,15 @@ bool ts::DektecOutputPlugin::start()
     _guts->opt_bitrate = intValue<BitRate>(u"bitrate", 0);
     _guts->detach_mode = present(u"instant-detach") ? DTAPI_INSTANT_DETACH : DTAPI_WAIT_UNTIL_SENT;
     _guts->mute_on_stop = false;
+    _guts->fifo_control = present(u"fifo-control");
+    _guts->chunk_size = RoundDown(intValue<size_t>(u"chunk-size", _guts->fifo_control ? DEFAULT_CHUNK_SIZE : 0), PKT_SIZE);
+    _guts->chunk.clear();
+    _guts->chunk.reserve(_guts->chunk_size);
+    _guts->last_time = Time::Epoch;
+    _guts->last_load = 0;
+    _guts->rate_drift = 0;
+    _guts->rate_offset = 0;
+    _guts->null_count = 0;
 
     // Get initial bitrate
     _guts->cur_bitrate = _guts->opt_bitrate != 0 ? _guts->opt_bitrate : tsp->bitrate();
@@ -888,6 +960,8 @@ bool ts::DektecOutputPlugin::start()
     if (status == DTAPI_OK) {
         tsp->verbose(u"output fifo size: %'d bytes, max: %'d bytes", {fifo_size, max_fifo_size});
     }
+    _guts->fifo_size = fifo_size > 0 ? size_t(fifo_size) : DTA_FIFO_SIZE;
+    _guts->fifo_target = int(RoundDown(_guts->fifo_size * intValue<size_t>(u"fifo-target", DEFAULT_FIFO_TARGET) / 100, PKT_SIZE));
 
     // Set 188/204-byte output packet format and stuffing
     status = _guts->chan.SetTxMode(present(u"204") ? DTAPI_TXMODE_ADD16 : DTAPI_TXMODE_188, present(u"stuffing") ? 1 : 0);
@@ -916,11 +990,20 @@ bool ts::DektecOutputPlugin::start()
     if (status != DTAPI_OK) {
         return startError(u"output device set bitrate error", status);
     }
+    _guts->ref_bitrate = _guts->cur_bitrate;
+
+    // In closed-loop mode, the bitrate can be adjusted only on ASI devices
+    // without imposed bitrate. Otherwise, null packets are inserted.
+    _guts->adjust_rate = _guts->fifo_control && !is_modulator && _guts->opt_bitrate == 0;
+    if (_guts->fifo_control) {
+        tsp->verbose(u"closed-loop FIFO control, target load: %'d bytes, %s", {_guts->fifo_target, _guts->adjust_rate ? u"adjusting bitrate" : u"inserting null packets"});
+    }
 
     // Start the transmission on the output device.
     // With ASI device, we can start transmission right now.
     // With modulator devices, we need to load the FIFO first.
-    _guts->starting = is_modulator;
+    // In closed-loop mode, the FIFO is always loaded up to the target first.
+    _guts->starting = is_modulator || _guts->fifo_control;
     status = _guts->chan.SetTxControl(_guts->starting ? DTAPI_TXCTRL_HOLD : DTAPI_TXCTRL_SEND);
     if (status != DTAPI_OK) {
         return startError(u"output device start send error", status);
@@ -1410,6 +1493,15 @@ bool ts::DektecOutputPlugin::stop()
     if (_guts->is_started) {
         tsp->verbose(u"terminating %s output", {_guts->device.model});
 
+        // Flush pending data.
+        if (!_guts->chunk.empty()) {
+            writeDevice(reinterpret_cast<const char*>(_guts->chunk.data()), _guts->chunk.size());
+            _guts->chunk.clear();
+        }
+        if (_guts->fifo_control) {
+            tsp->verbose(u"closed-loop FIFO control: %'d null packets inserted, final bitrate offset: %'d b/s", {_guts->null_count, _guts->rate_offset});
+        }
+
         // Mute output signal for modulators which support this
         if (_guts->mute_on_stop) {
             Dtapi::DTAPI_RESULT status = _guts->chan.SetRfMode(DTAPI_UPCONV_MUTE);
@@ -1471,24 +1563,72 @@ bool ts::DektecOutputPlugin::send(const TSPacket* buffer, size_t packet_count)
         return false;
     }
 
-    char* data = reinterpret_cast<char*>(const_cast<TSPacket*> (buffer));
-    int remain = int(packet_count * PKT_SIZE);
-    Dtapi::DTAPI_RESULT status;
+    const char* data = reinterpret_cast<const char*>(buffer);
+    size_t remain = packet_count * PKT_SIZE;
 
     // If no bitrate was specified on the command line, adjust the bitrate
     // when input bitrate changes.
     BitRate new_bitrate;
-    if (_guts->opt_bitrate == 0 && _guts->cur_bitrate != (new_bitrate = tsp->bitrate())) {
-        status = _guts->chan.SetTsRateBps(int(new_bitrate));
-        if (status != DTAPI_OK) {
-            tsp->error(u"error setting output bitrate on Dektec device: " + DektecStrError(status));
+    if (_guts->opt_bitrate == 0 && _guts->ref_bitrate != (new_bitrate = tsp->bitrate())) {
+        _guts->ref_bitrate = new_bitrate;
+        applyBitrate(true);
+    }
+
+    // Without chunk size, mirror the tsp chunks of packets.
+    if (_guts->chunk_size == 0) {
+        return writeChunk(data, remain);
+    }
+
+    // Complete the pending chunk first.
+    if (!_guts->chunk.empty()) {
+        const size_t size = std::min(remain, _guts->chunk_size - _guts->chunk.size());
+        _guts->chunk.append(data, size);
+        data += size;
+        remain -= size;
+        if (_guts->chunk.size() < _guts->chunk_size) {
+            return true;
         }
-        else {
-            _guts->cur_bitrate = new_bitrate;
-            tsp->verbose(u"new output bitrate: %'d b/s", {_guts->cur_bitrate});
+        if (!writeChunk(reinterpret_cast<const char*>(_guts->chunk.data()), _guts->chunk.size())) {
+            return false;
         }
+        _guts->chunk.clear();
     }
 
+    // Write complete chunks directly from the tsp buffer.
+    while (remain >= _guts->chunk_size) {
+        if (!writeChunk(data, _guts->chunk_size)) {
+            return false;
+        }
+        data += _guts->chunk_size;
+        remain -= _guts->chunk_size;
+    }
+
+    // Keep the rest for next time.
+    _guts->chunk.append(data, remain);
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Write a chunk of data to the device, control the FIFO load.
+//----------------------------------------------------------------------------
+
+bool ts::DektecOutputPlugin::writeChunk(const char* data, size_t size)
+{
+    return writeDevice(data, size) && (!_guts->fifo_control || controlFifo());
+}
+
+
+//----------------------------------------------------------------------------
+// Write data to the device, loading the FIFO first in the starting phase.
+//----------------------------------------------------------------------------
+
+bool ts::DektecOutputPlugin::writeDevice(const char* buffer, size_t size)
+{
+    char* data = const_cast<char*>(buffer);
+    int remain = int(size);
+    Dtapi::DTAPI_RESULT status;
+
     // Loop on write until everything is gone.
     while (remain > 0) {
 
@@ -1506,8 +1646,8 @@ bool ts::DektecOutputPlugin::send(const TSPacket* buffer, size_t packet_count)
                 return false;
             }
 
-            // We consider the FIFO is loaded when 80% full.
-            const int max_size = (8 * DTA_FIFO_SIZE) / 10;
+            // We consider the FIFO is loaded when 80% full or at target load in closed-loop mode.
+            const int max_size = _guts->fifo_control ? _guts->fifo_target : int((8 * DTA_FIFO_SIZE) / 10);
             if (fifo_load < max_size - int(PKT_SIZE)) {
                 // Remain in starting phase, limit next I/O size
                 max_io_size = max_size - fifo_load;
@@ -1541,4 +1681,90 @@ bool ts::DektecOutputPlugin::send(const TSPacket* buffer, size_t packet_count)
     return true;
 }
 
+
+//----------------------------------------------------------------------------
+// Closed-loop FIFO control.
+//----------------------------------------------------------------------------
+
+bool ts::DektecOutputPlugin::controlFifo()
+{
+    // No control while the FIFO is initially loaded.
+    if (_guts->starting) {
+        return true;
+    }
+
+    // Do not sample the FIFO load too often.
+    const Time now(Time::CurrentUTC());
+    if (_guts->last_time != Time::Epoch && now - _guts->last_time < CONTROL_INTERVAL) {
+        return true;
+    }
+
+    // Get current load in FIFO.
+    int load = 0;
+    const Dtapi::DTAPI_RESULT status = _guts->chan.GetFifoLoad(load);
+    if (status != DTAPI_OK) {
+        tsp->error(u"error getting output fifo load: " + DektecStrError(status));
+        return false;
+    }
+
+    // The first sample is only a reference.
+    if (_guts->last_time == Time::Epoch) {
+        _guts->last_time = now;
+        _guts->last_load = load;
+        return true;
+    }
+
+    // The FIFO load trend, in bytes/second, is the difference between the input
+    // and output bitrates. The FIFO load is always sampled right after a write.
+    const int64_t trend = (int64_t(load - _guts->last_load) * MilliSecPerSec) / (now - _guts->last_time);
+    const int64_t distance = int64_t(load) - int64_t(_guts->fifo_target);
+    _guts->last_time = now;
+    _guts->last_load = load;
+
+    if (_guts->adjust_rate) {
+        // Accumulate half of the observed bitrate difference into the estimated drift
+        // of the input bitrate, to filter out measurement noise. Then absorb the distance
+        // to the target FIFO load in a few seconds. A growing load means a too slow output.
+        const int64_t max_offset = (int64_t(_guts->ref_bitrate) * MAX_DEVIATION_PPM) / 1000000;
+        _guts->rate_drift = std::max(-max_offset, std::min(max_offset, _guts->rate_drift + (8 * trend) / 2));
+        _guts->rate_offset = std::max(-max_offset, std::min(max_offset, _guts->rate_drift + (8 * distance) / CONVERGENCE_SECONDS));
+        tsp->debug(u"FIFO load: %'d bytes, trend: %'d B/s, bitrate offset: %'d b/s", {load, trend, _guts->rate_offset});
+        applyBitrate(false);
+    }
+    else if (distance < 0 && trend <= 0) {
+        // Fixed output bitrate and the FIFO load is below target and not recovering:
+        // insert null packets to fill half of the distance to the target.
+        const size_t count = std::min(size_t(-distance) / (2 * PKT_SIZE), std::max<size_t>(_guts->chunk_size / PKT_SIZE, 1));
+        if (count > 0) {
+            if (_guts->nulls.size() < count) {
+                _guts->nulls.resize(count, NullPacket);
+            }
+            tsp->debug(u"FIFO load: %'d bytes, trend: %'d B/s, inserting %'d null packets", {load, trend, count});
+            _guts->null_count += count;
+            return writeDevice(reinterpret_cast<const char*>(_guts->nulls.data()), count * PKT_SIZE);
+        }
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Set the device bitrate from the reference bitrate and closed-loop offset.
+//----------------------------------------------------------------------------
+
+void ts::DektecOutputPlugin::applyBitrate(bool verbose)
+{
+    const BitRate new_bitrate = _guts->ref_bitrate == 0 ? 0 : BitRate(std::max<int64_t>(1, int64_t(_guts->ref_bitrate) + _guts->rate_offset));
+    if (new_bitrate != _guts->cur_bitrate) {
+        const Dtapi::DTAPI_RESULT status = _guts->chan.SetTsRateBps(int(new_bitrate));
+        if (status != DTAPI_OK) {
+            tsp->error(u"error setting output bitrate on Dektec device: " + DektecStrError(status));
+        }
+        else {
+            _guts->cur_bitrate = new_bitrate;
+            tsp->log(verbose ? Severity::Verbose : Severity::Debug, u"new output bitrate: %'d b/s", {_guts->cur_bitrate});
+        }
+    }
+}
+
 #endif // TS_NO_DTAPI
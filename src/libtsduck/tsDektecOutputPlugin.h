@@ -75,6 +75,18 @@ namespace ts {
 
         // Set modulation parameters (modulators only). Return true on success, false on error.
         bool setModulation(int& modulation_type);
+
+        // Write data to the device, loading the FIFO first in the starting phase.
+        bool writeDevice(const char* data, size_t size);
+
+        // Write a chunk of data to the device and, in closed-loop mode, control the FIFO load.
+        bool writeChunk(const char* data, size_t size);
+
+        // Closed-loop FIFO control: sample the FIFO load, adjust the bitrate or insert null packets.
+        bool controlFifo();
+
+        // Set the device bitrate from the reference bitrate and the closed-loop offset.
+        void applyBitrate(bool verbose);
 #endif
 
         // Inaccessible operations
@@ -39,72 +39,155 @@
 TSDUCK_SOURCE;
 
 
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::Descriptor::INLINE_MAX_SIZE;
+#endif
+
+
 //----------------------------------------------------------------------------
 // Constructors for Descriptor
 // Note that the max size of a descriptor is 257 bytes: 2 (header) + 255
 //----------------------------------------------------------------------------
 
 ts::Descriptor::Descriptor(const void* addr, size_t size) :
-    _data(size >= 2 && size < 258 && (reinterpret_cast<const uint8_t*>(addr))[1] == size - 2 ? new ByteBlock(addr, size) : 0)
+    _inline_size(0),
+    _inline(),
+    _data(0)
 {
+    if (size >= 2 && size < 258 && (reinterpret_cast<const uint8_t*>(addr))[1] == size - 2) {
+        ::memcpy(allocate(size), addr, size);  // Flawfinder: ignore: memcpy()
+    }
 }
 
 ts::Descriptor::Descriptor(const ByteBlock& bb) :
-    _data(bb.size() >= 2 && bb.size() < 258 && bb[1] == bb.size() - 2 ? new ByteBlock(bb) : 0)
+    _inline_size(0),
+    _inline(),
+    _data(0)
 {
+    if (bb.size() >= 2 && bb.size() < 258 && bb[1] == bb.size() - 2) {
+        ::memcpy(allocate(bb.size()), bb.data(), bb.size());  // Flawfinder: ignore: memcpy()
+    }
 }
 
 ts::Descriptor::Descriptor(DID tag, const void* data, size_t size) :
-    _data(size < 256 ? new ByteBlock(size + 2) : 0)
+    _inline_size(0),
+    _inline(),
+    _data(0)
 {
-    if (!_data.isNull()) {
-        (*_data)[0] = tag;
-        (*_data)[1] = uint8_t(size);
-        ::memcpy(_data->data() + 2, data, size);
+    if (size < 256) {
+        uint8_t* const content = allocate(size + 2);
+        content[0] = tag;
+        content[1] = uint8_t(size);
+        ::memcpy(content + 2, data, size);  // Flawfinder: ignore: memcpy()
     }
 }
 
 ts::Descriptor::Descriptor(DID tag, const ByteBlock& data) :
-    _data(data.size() < 256 ? new ByteBlock(2) : 0)
+    _inline_size(0),
+    _inline(),
+    _data(0)
 {
-    if (!_data.isNull()) {
-        (*_data)[0] = tag;
-        (*_data)[1] = uint8_t(data.size());
-        _data->append(data);
+    if (data.size() < 256) {
+        uint8_t* const content = allocate(data.size() + 2);
+        content[0] = tag;
+        content[1] = uint8_t(data.size());
+        ::memcpy(content + 2, data.data(), data.size());  // Flawfinder: ignore: memcpy()
     }
 }
 
 ts::Descriptor::Descriptor(const ByteBlockPtr& bbp, CopyShare mode) :
+    _inline_size(0),
+    _inline(),
     _data(0)
 {
     if (!bbp.isNull() && bbp->size() >= 2 && bbp->size() < 258 && (*bbp)[1] == bbp->size() - 2) {
-        switch (mode) {
-            case SHARE:
-                _data = bbp;
-                break;
-            case COPY:
-                _data = new ByteBlock (*bbp);
-                break;
-            default:
-                // should not get there
-                assert (false);
+        if (mode == SHARE && bbp->size() > INLINE_MAX_SIZE) {
+            _data = bbp;
+        }
+        else {
+            // Explicit copy or short descriptor, always copied.
+            ::memcpy(allocate(bbp->size()), bbp->data(), bbp->size());  // Flawfinder: ignore: memcpy()
         }
     }
 }
 
-ts::Descriptor::Descriptor (const Descriptor& desc, CopyShare mode) :
-    _data (0)
+ts::Descriptor::Descriptor(const Descriptor& desc, CopyShare mode) :
+    _inline_size(0),
+    _inline(),
+    _data(0)
 {
     switch (mode) {
         case SHARE:
-            _data = desc._data;
+            *this = desc;
             break;
         case COPY:
-            _data = new ByteBlock (*desc._data);
+            copy(desc);
             break;
         default:
             // should not get there
-            assert (false);
+            assert(false);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Assignment and duplication.
+//----------------------------------------------------------------------------
+
+ts::Descriptor& ts::Descriptor::operator=(const Descriptor& desc)
+{
+    if (&desc != this) {
+        _inline_size = desc._inline_size;
+        ::memcpy(_inline, desc._inline, desc._inline_size);  // Flawfinder: ignore: memcpy()
+        _data = desc._data;
+    }
+    return *this;
+}
+
+ts::Descriptor& ts::Descriptor::copy(const Descriptor& desc)
+{
+    if (!desc.isValid()) {
+        invalidate();
+    }
+    else if (&desc != this) {
+        ::memcpy(allocate(desc.size()), desc.content(), desc.size());  // Flawfinder: ignore: memcpy()
+    }
+    else if (_inline_size == 0) {
+        _data = new ByteBlock(*_data);
+    }
+    return *this;
+}
+
+
+//----------------------------------------------------------------------------
+// Allocate the storage for a content of the specified size.
+//----------------------------------------------------------------------------
+
+uint8_t* ts::Descriptor::allocate(size_t size)
+{
+    if (size <= INLINE_MAX_SIZE) {
+        _data.clear();
+        _inline_size = uint16_t(size);
+        return _inline;
+    }
+    else {
+        _inline_size = 0;
+        _data = new ByteBlock;
+        _data->resizeUninitialized(size);
+        return _data->data();
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Move the content of a short descriptor into a ByteBlock.
+//----------------------------------------------------------------------------
+
+void ts::Descriptor::moveOutOfLine()
+{
+    if (_inline_size > 0) {
+        _data = new ByteBlock(_inline, _inline_size);
+        _inline_size = 0;
     }
 }
 
@@ -136,23 +219,31 @@ ts::EDID ts::Descriptor::edid(PDS pds) const
 
 //----------------------------------------------------------------------------
 // Replace the payload of the descriptor. The tag is unchanged,
-// the size is adjusted.
+// the size is adjusted. A long descriptor is modified in place,
+// its content remains shared with other descriptors.
 //----------------------------------------------------------------------------
 
-void ts::Descriptor::replacePayload (const void* addr, size_t size)
+void ts::Descriptor::replacePayload(const void* addr, size_t size)
 {
     if (size > 255) {
         // Payload size too long, invalidate descriptor
-        _data.clear();
+        invalidate();
     }
-    else if (!_data.isNull()) {
-        assert (_data->size() >= 2);
+    else if (_inline_size > 0 && size + 2 <= INLINE_MAX_SIZE) {
+        // Short descriptor remains short.
+        ::memmove(_inline + 2, addr, size);
+        _inline[1] = uint8_t(size);
+        _inline_size = uint16_t(size + 2);
+    }
+    else if (isValid()) {
+        moveOutOfLine();
+        assert(_data->size() >= 2);
         // Erase previous payload
-        _data->erase (2, _data->size() - 2);
+        _data->erase(2, _data->size() - 2);
         // Add new payload
-        _data->append (addr, size);
+        _data->append(addr, size);
         // Adjust descriptor size
-        (*_data)[1] = uint8_t (_data->size() - 2);
+        (*_data)[1] = uint8_t(_data->size() - 2);
     }
 }
 
@@ -163,22 +254,27 @@ void ts::Descriptor::replacePayload (const void* addr, size_t size)
 // If the payload is extended, new bytes are zeroes.
 //----------------------------------------------------------------------------
 
-void ts::Descriptor::resizePayload (size_t new_size)
+void ts::Descriptor::resizePayload(size_t new_size)
 {
     if (new_size > 255) {
         // Payload size too long, invalidate descriptor
-        _data.clear();
+        invalidate();
     }
-    else if (!_data.isNull()) {
-        assert (_data->size() >= 2);
-        size_t old_size = _data->size() - 2;
-        _data->resize (new_size + 2);
-        // If payload extended, zero additional bytes
-        if (new_size > old_size) {
-            Zero (_data->data() + 2 + old_size, new_size - old_size);
+    else if (_inline_size > 0 && new_size + 2 <= INLINE_MAX_SIZE) {
+        // Short descriptor remains short. If payload extended, zero additional bytes.
+        if (new_size + 2 > _inline_size) {
+            Zero(_inline + _inline_size, new_size + 2 - _inline_size);
         }
+        _inline[1] = uint8_t(new_size);
+        _inline_size = uint16_t(new_size + 2);
+    }
+    else if (isValid()) {
+        moveOutOfLine();
+        assert(_data->size() >= 2);
+        // If payload extended, the additional bytes are zero.
+        _data->resize(new_size + 2);
         // Adjust descriptor size
-        (*_data)[1] = uint8_t (_data->size() - 2);
+        (*_data)[1] = uint8_t(_data->size() - 2);
     }
 }
 
@@ -187,11 +283,15 @@ void ts::Descriptor::resizePayload (size_t new_size)
 // Comparison
 //----------------------------------------------------------------------------
 
-bool ts::Descriptor::operator== (const Descriptor& desc) const
+bool ts::Descriptor::operator==(const Descriptor& desc) const
 {
-    return _data == desc._data ||
-        (_data.isNull() && desc._data.isNull()) ||
-        (!_data.isNull() && !desc._data.isNull() && *_data == *desc._data);
+    if (!isValid() || !desc.isValid()) {
+        return !isValid() && !desc.isValid();
+    }
+    else {
+        return (_inline_size == 0 && _data == desc._data) ||
+            (size() == desc.size() && ::memcmp(content(), desc.content(), size()) == 0);
+    }
 }
 
 
@@ -276,10 +376,10 @@ bool ts::Descriptor::fromXML(const xml::Element* node, const DVBCharset* charset
             node->getHexaText(payload, 0, 255))
         {
             // Build descriptor.
-            _data = new ByteBlock(2);
-            (*_data)[0] = tag;
-            (*_data)[1] = uint8_t(payload.size());
-            _data->append(payload);
+            uint8_t* const content = allocate(payload.size() + 2);
+            content[0] = tag;
+            content[1] = uint8_t(payload.size());
+            ::memcpy(content + 2, payload.data(), payload.size());  // Flawfinder: ignore: memcpy()
         }
         else {
             node->report().error(u"<%s>, line %d, is not a valid descriptor", {node->name(), node->lineNumber()});
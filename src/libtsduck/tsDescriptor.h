@@ -44,19 +44,29 @@ namespace ts {
     //!
     //! Representation of a MPEG PSI/SI descriptors in binary format.
     //!
+    //! Short descriptors, up to INLINE_MAX_SIZE bytes, are stored inside the object,
+    //! without heap allocation. Their content is never shared with other instances,
+    //! it is always duplicated. Longer descriptors are stored in a ByteBlock which
+    //! can be shared.
+    //!
     class TSDUCKDLL Descriptor
     {
     public:
+        //!
+        //! Maximum size in bytes of the descriptors which are stored inside the object.
+        //!
+        static const size_t INLINE_MAX_SIZE = 38;
+
         //!
         //! Default constructor.
         //!
-        Descriptor() : _data(0) {}
+        Descriptor() : _inline_size(0), _inline(), _data(0) {}
 
         //!
         //! Copy constructor.
         //! @param [in] desc Another instance to copy.
         //! @param [in] mode The descriptors' data are either shared (ts::SHARE) between the
-        //! two descriptors or duplicated (ts::COPY).
+        //! two descriptors or duplicated (ts::COPY). Short descriptors are always duplicated.
         //!
         Descriptor(const Descriptor& desc, CopyShare mode);
 
@@ -97,21 +107,19 @@ namespace ts {
         //! The content is copied into the section if valid.
         //! @param [in] bb Descriptor binary data.
         //! @param [in] mode The data are either shared (ts::SHARE) between the
-        //! descriptor and @a bb or duplicated (ts::COPY).
+        //! descriptor and @a bb or duplicated (ts::COPY). Short descriptors are
+        //! always duplicated.
         //!
         Descriptor(const ByteBlockPtr& bb, CopyShare mode);
 
         //!
         //! Assignment operator.
-        //! The content is referenced, and thus shared between the two objects.
+        //! The content of long descriptors is referenced, and thus shared between the two objects.
+        //! The content of short descriptors is duplicated.
         //! @param [in] desc Another instance to copy.
         //! @return A reference to this object.
         //!
-        Descriptor& operator=(const Descriptor& desc)
-        {
-            _data = desc._data;
-            return *this;
-        }
+        Descriptor& operator=(const Descriptor& desc);
 
         //!
         //! Duplication.
@@ -119,11 +127,7 @@ namespace ts {
         //! @param [in] desc Another instance to copy.
         //! @return A reference to this object.
         //!
-        Descriptor& copy(const Descriptor& desc)
-        {
-            _data = new ByteBlock(*desc._data);
-            return *this;
-        }
+        Descriptor& copy(const Descriptor& desc);
 
         //!
         //! Check if a descriptor has valid content.
@@ -131,7 +135,7 @@ namespace ts {
         //!
         bool isValid() const
         {
-            return !_data.isNull();
+            return _inline_size > 0 || !_data.isNull();
         }
 
         //!
@@ -139,6 +143,7 @@ namespace ts {
         //!
         void invalidate()
         {
+            _inline_size = 0;
             _data.clear();
         }
 
@@ -148,7 +153,7 @@ namespace ts {
         //!
         DID tag() const
         {
-            return _data.isNull() ? 0 : _data->at(0);
+            return isValid() ? content()[0] : 0;
         }
 
         //!
@@ -164,7 +169,7 @@ namespace ts {
         //!
         const uint8_t* content() const
         {
-            return _data->data();
+            return _inline_size > 0 ? _inline : _data->data();
         }
 
         //!
@@ -173,7 +178,7 @@ namespace ts {
         //!
         size_t size() const
         {
-            return _data->size();
+            return _inline_size > 0 ? _inline_size : _data->size();
         }
 
         //!
@@ -182,7 +187,7 @@ namespace ts {
         //!
         const uint8_t* payload() const
         {
-            return _data->data() + 2;
+            return content() + 2;
         }
 
         //!
@@ -191,7 +196,7 @@ namespace ts {
         //!
         uint8_t* payload()
         {
-            return _data->data() + 2;
+            return (_inline_size > 0 ? _inline : _data->data()) + 2;
         }
 
         //!
@@ -200,7 +205,7 @@ namespace ts {
         //!
         size_t payloadSize() const
         {
-            return _data->size() - 2;
+            return size() - 2;
         }
 
         //!
@@ -271,6 +276,14 @@ namespace ts {
         Descriptor(const Descriptor&) = delete;
 
         // Private fields
-        ByteBlockPtr _data; // full binary content of the descriptor
+        uint16_t     _inline_size;              // Size of the inline content, zero when not inline.
+        uint8_t      _inline[INLINE_MAX_SIZE];  // Full binary content of a short descriptor.
+        ByteBlockPtr _data;                     // Full binary content of a long descriptor.
+
+        // Allocate the storage for a content of the specified size, return its address.
+        uint8_t* allocate(size_t size);
+
+        // Move the content of a short descriptor into a ByteBlock.
+        void moveOutOfLine();
     };
 }
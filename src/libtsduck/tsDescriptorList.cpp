@@ -37,6 +37,10 @@
 #include "tsxmlElement.h"
 TSDUCK_SOURCE;
 
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::DescriptorList::INDEX_THRESHOLD;
+#endif
+
 
 //----------------------------------------------------------------------------
 // Comparison
@@ -83,6 +87,7 @@ void ts::DescriptorList::add (const DescriptorPtr& desc)
 
     // Add the descriptor in the list
     _list.push_back (Element (desc, pds));
+    _index_valid = false;
 }
 
 
@@ -180,6 +185,7 @@ size_t ts::DescriptorList::removeInvalidPrivateDescriptors()
     for (size_t n = 0; n < _list.size(); n++) {
         if (_list[n].pds == 0 && !_list[n].desc.isNull() && _list[n].desc->isValid() && _list[n].desc->tag() >= 0x80) {
             _list.erase (_list.begin() + n);
+            _index_valid = false;
             count++;
         }
     }
@@ -206,6 +212,7 @@ bool ts::DescriptorList::removeByIndex (size_t index)
 
     // Remove the specified descriptor
     _list.erase (_list.begin() + index);
+    _index_valid = false;
     return true;
 }
 
@@ -223,6 +230,7 @@ size_t ts::DescriptorList::removeByTag (DID tag, PDS pds)
         const DID itag = it->desc->tag();
         if (itag == tag && (!check_pds || it->pds == pds) && (itag != DID_PRIV_DATA_SPECIF || prepareRemovePDS (it))) {
             it = _list.erase (it);
+            _index_valid = false;
             ++removed_count;
         }
         else {
@@ -306,14 +314,60 @@ size_t ts::DescriptorList::search (DID tag, size_t start_index, PDS pds) const
     bool check_pds = pds != 0 && tag >= 0x80;
     size_t index = start_index;
 
-    while (index < _list.size() && (_list[index].desc->tag() != tag || (check_pds && _list[index].pds != pds))) {
-        index++;
+    // Short lists are searched sequentially.
+    if (_list.size() < INDEX_THRESHOLD || start_index >= _list.size()) {
+        while (index < _list.size() && (_list[index].desc->tag() != tag || (check_pds && _list[index].pds != pds))) {
+            index++;
+        }
+        return index;
+    }
+
+    // Long lists use the index by tag.
+    if (!_index_valid) {
+        buildIndex();
+    }
+
+    // When searching the next descriptor after one with the same tag, which is the
+    // usual iteration pattern, the next index is directly available.
+    if (start_index > 0 && _list[start_index - 1].desc->tag() == tag) {
+        index = _next_by_tag[start_index - 1];
+    }
+    else {
+        index = _first_by_tag[tag];
+        while (index < start_index) {
+            index = _next_by_tag[index];
+        }
+    }
+
+    // Skip descriptors with another private data specifier.
+    while (index < _list.size() && check_pds && _list[index].pds != pds) {
+        index = _next_by_tag[index];
     }
 
     return index;
 }
 
 
+//----------------------------------------------------------------------------
+// Build the index by tag.
+//----------------------------------------------------------------------------
+
+void ts::DescriptorList::buildIndex() const
+{
+    _first_by_tag.assign(256, _list.size());
+    _next_by_tag.assign(_list.size(), _list.size());
+
+    // Build the chains backward, each descriptor is inserted at head of its chain.
+    for (size_t i = _list.size(); i-- > 0; ) {
+        const DID tag = _list[i].desc->tag();
+        _next_by_tag[i] = _first_by_tag[tag];
+        _first_by_tag[tag] = i;
+    }
+
+    _index_valid = true;
+}
+
+
 //----------------------------------------------------------------------------
 // Search a language descriptor for the specified language, starting at
 // the specified index. Return the index of the descriptor in the list
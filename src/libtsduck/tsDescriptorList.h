@@ -39,14 +39,28 @@ namespace ts {
     //!
     //! List of MPEG PSI/SI descriptors.
     //!
+    //! On long lists, search() uses an index of the descriptors by tag. The index is built
+    //! on the first search and invalidated when the list is modified. Consequently, search()
+    //! is not reentrant on long lists: the same instance shall not be searched concurrently
+    //! from distinct threads.
+    //!
     class TSDUCKDLL DescriptorList
     {
     public:
+        //!
+        //! Minimum number of descriptors in a list to use an index by tag in search().
+        //! Shorter lists are searched sequentially, which is faster.
+        //!
+        static const size_t INDEX_THRESHOLD = 16;
+
         //!
         //! Default constructor.
         //!
         DescriptorList() :
-            _list()
+            _list(),
+            _index_valid(false),
+            _first_by_tag(),
+            _next_by_tag()
         {
         }
 
@@ -56,7 +70,10 @@ namespace ts {
         //! @param [in] dl Another instance to copy.
         //!
         DescriptorList(const DescriptorList& dl) :
-            _list(dl._list)
+            _list(dl._list),
+            _index_valid(false),
+            _first_by_tag(),
+            _next_by_tag()
         {
         }
 
@@ -128,6 +145,7 @@ namespace ts {
         void add(const DescriptorList& dl)
         {
             _list.insert(_list.end(), dl._list.begin(), dl._list.end());
+            _index_valid = false;
         }
 
         //!
@@ -191,6 +209,7 @@ namespace ts {
         void clear()
         {
             _list.clear();
+            _index_valid = false;
         }
 
         //!
@@ -336,6 +355,17 @@ namespace ts {
         // Private members
         ElementVector _list;
 
+        // Index by tag, built on demand by search() on long lists.
+        // _first_by_tag[tag] is the index of the first descriptor with this tag.
+        // _next_by_tag[i] is the index of the next descriptor with the same tag as descriptor i.
+        // When there is no such descriptor, the value is the size of the list.
+        mutable bool _index_valid;
+        mutable std::vector<size_t> _first_by_tag;
+        mutable std::vector<size_t> _next_by_tag;
+
+        // Build the index by tag.
+        void buildIndex() const;
+
         // Prepare removal of a private_data_specifier descriptor.
         // Return true if can be removed, false if it cannot (private descriptors ahead).
         // When it can be removed, the current PDS of all subsequent descriptors is updated.
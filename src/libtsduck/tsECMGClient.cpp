@@ -56,6 +56,7 @@ ts::ECMGClient::ECMGClient(size_t extra_handler_stack_size) :
     _connection(ecmgscs::Protocol::Instance(), true, 3),
     _channel_status(),
     _stream_status(),
+    _streams(),
     _mutex(),
     _work_to_do(),
     _async_requests(),
@@ -177,33 +178,87 @@ bool ts::ECMGClient::connect(const SocketAddress& ecmg_address,
     assert(csp != 0);
     channel_status = _channel_status = *csp;
 
+    // Setup the first ECM stream.
+    if (!setupStream(ecm_stream_id, ecm_id, nominal_cp_duration, stream_status)) {
+        return abortConnection();
+    }
+
+    // ECM stream now established
+    {
+        Guard lock(_mutex);
+        _stream_status = stream_status;
+        _streams.clear();
+        _streams[stream_status.stream_id] = stream_status;
+        _state = CONNECTED;
+    }
+
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Send a stream_setup and wait for the stream_status.
+//----------------------------------------------------------------------------
+
+bool ts::ECMGClient::setupStream(uint16_t ecm_stream_id,
+                                 uint16_t ecm_id,
+                                 uint16_t nominal_cp_duration,
+                                 ecmgscs::StreamStatus& stream_status)
+{
     // Send a stream_setup message to ECMG
     ecmgscs::StreamSetup stream_setup;
-    stream_setup.channel_id = ecm_channel_id;
+    stream_setup.channel_id = _channel_status.channel_id;
     stream_setup.stream_id = ecm_stream_id;
     stream_setup.ECM_id = ecm_id;
     stream_setup.nominal_CP_duration = nominal_cp_duration;
     if (!_connection.send(stream_setup, *_report)) {
-        return abortConnection();
+        return false;
     }
 
     // Wait for a stream_status from the ECMG
+    tlv::MessagePtr msg;
     if (!_response_queue.dequeue(msg, RESPONSE_TIMEOUT)) {
-        return abortConnection(u"ECMG stream_setup response timeout");
+        _report->error(u"ECMG stream_setup response timeout");
+        return false;
     }
     if (msg->tag() != ecmgscs::Tags::stream_status) {
-        return abortConnection(u"unexpected response from ECMG (expected stream_status):\n" + msg->dump(4));
+        _report->error(u"unexpected response from ECMG (expected stream_status):\n" + msg->dump(4));
+        return false;
     }
     ecmgscs::StreamStatus* const ssp = dynamic_cast<ecmgscs::StreamStatus*>(msg.pointer());
     assert(ssp != 0);
-    stream_status = _stream_status = *ssp;
+    stream_status = *ssp;
+    return true;
+}
 
-    // ECM stream now established
+
+//----------------------------------------------------------------------------
+// Open an additional ECM stream on the channel of a connected ECMG.
+//----------------------------------------------------------------------------
+
+bool ts::ECMGClient::addStream(uint16_t ecm_stream_id,
+                               uint16_t ecm_id,
+                               uint16_t nominal_cp_duration,
+                               ecmgscs::StreamStatus& stream_status)
+{
     {
         Guard lock(_mutex);
-        _state = CONNECTED;
+        if (_state != CONNECTED) {
+            _report->error(u"ECMG client not connected");
+            return false;
+        }
+        if (_streams.find(ecm_stream_id) != _streams.end()) {
+            _report->error(u"ECM stream %d already open", {ecm_stream_id});
+            return false;
+        }
+    }
+
+    if (!setupStream(ecm_stream_id, ecm_id, nominal_cp_duration, stream_status)) {
+        return false;
     }
 
+    Guard lock(_mutex);
+    _streams[stream_status.stream_id] = stream_status;
     return true;
 }
 
@@ -227,17 +282,18 @@ bool ts::ECMGClient::disconnect()
     // Disconnection sequence
     bool ok = previous_state == CONNECTED;
     if (ok) {
-        // Politely send a stream_close_request
-        ecmgscs::StreamCloseRequest req;
-        req.channel_id = _stream_status.channel_id;
-        req.stream_id = _stream_status.stream_id;
-        tlv::MessagePtr resp;
-        // Politely send a stream_close_request
-        // and wait for a stream_close_response
-        ok = _connection.send(req, *_report) &&
-            _response_queue.dequeue(resp, RESPONSE_TIMEOUT) &&
-            resp->tag() == ecmgscs::Tags::stream_close_response;
-        // If we get a polite reply, send a channel_close
+        // Politely send a stream_close_request on all streams
+        // and wait for a stream_close_response.
+        for (StreamStatusMap::const_iterator it = _streams.begin(); ok && it != _streams.end(); ++it) {
+            ecmgscs::StreamCloseRequest req;
+            req.channel_id = it->second.channel_id;
+            req.stream_id = it->second.stream_id;
+            tlv::MessagePtr resp;
+            ok = _connection.send(req, *_report) &&
+                _response_queue.dequeue(resp, RESPONSE_TIMEOUT) &&
+                resp->tag() == ecmgscs::Tags::stream_close_response;
+        }
+        // If we get polite replies, send a channel_close
         if (ok) {
             ecmgscs::ChannelClose cc;
             cc.channel_id = _channel_status.channel_id;
@@ -251,6 +307,8 @@ bool ts::ECMGClient::disconnect()
         _state = DISCONNECTED;
         ok = _connection.disconnect(*_report) && ok;
         ok = _connection.close(*_report) && ok;
+        _streams.clear();
+        _async_requests.clear();
         lock.signal();
     }
 
@@ -259,23 +317,23 @@ bool ts::ECMGClient::disconnect()
 
 
 //----------------------------------------------------------------------------
-// Synchronously generate an ECM.
+// Build a CW_provision message.
 //----------------------------------------------------------------------------
 
-bool ts::ECMGClient::generateECM(uint16_t cp_number,
-                                 const void* current_cw,
-                                 const void* next_cw,
-                                 const void* ac,
-                                 size_t ac_size,
-                                 uint16_t cp_duration,
-                                 ecmgscs::ECMResponse& ecm_response)
+void ts::ECMGClient::buildCWProvision(ecmgscs::CWProvision& msg,
+                                      uint16_t ecm_stream_id,
+                                      uint16_t cp_number,
+                                      const void* current_cw,
+                                      const void* next_cw,
+                                      const void* ac,
+                                      size_t ac_size,
+                                      uint16_t cp_duration) const
 {
-    // Build a CW_provision message
-    ecmgscs::CWProvision msg;
-    msg.channel_id = _stream_status.channel_id;
-    msg.stream_id = _stream_status.stream_id;
+    msg.channel_id = _channel_status.channel_id;
+    msg.stream_id = ecm_stream_id;
     msg.CP_number = cp_number;
     msg.has_CW_encryption = false;
+    msg.CP_CW_combination.clear();
     msg.CP_CW_combination.push_back(ecmgscs::CPCWCombination(cp_number, current_cw));
     msg.CP_CW_combination.push_back(ecmgscs::CPCWCombination(cp_number + 1, next_cw));
     msg.has_CP_duration = cp_duration != 0;
@@ -284,6 +342,36 @@ bool ts::ECMGClient::generateECM(uint16_t cp_number,
     if (ac != 0) {
         msg.access_criteria.copy(ac, ac_size);
     }
+}
+
+
+//----------------------------------------------------------------------------
+// Synchronously generate an ECM.
+//----------------------------------------------------------------------------
+
+bool ts::ECMGClient::generateECM(uint16_t cp_number,
+                                 const void* current_cw,
+                                 const void* next_cw,
+                                 const void* ac,
+                                 size_t ac_size,
+                                 uint16_t cp_duration,
+                                 ecmgscs::ECMResponse& ecm_response)
+{
+    return generateECM(_stream_status.stream_id, cp_number, current_cw, next_cw, ac, ac_size, cp_duration, ecm_response);
+}
+
+bool ts::ECMGClient::generateECM(uint16_t ecm_stream_id,
+                                 uint16_t cp_number,
+                                 const void* current_cw,
+                                 const void* next_cw,
+                                 const void* ac,
+                                 size_t ac_size,
+                                 uint16_t cp_duration,
+                                 ecmgscs::ECMResponse& ecm_response)
+{
+    // Build a CW_provision message
+    ecmgscs::CWProvision msg;
+    buildCWProvision(msg, ecm_stream_id, cp_number, current_cw, next_cw, ac, ac_size, cp_duration);
 
     // Send the CW_provision message
     if (!_connection.send(msg, *_report)) {
@@ -305,7 +393,7 @@ bool ts::ECMGClient::generateECM(uint16_t cp_number,
         if (resp->tag() == ecmgscs::Tags::ECM_response) {
             ecmgscs::ECMResponse* const ep = dynamic_cast <ecmgscs::ECMResponse*>(resp.pointer());
             assert(ep != 0);
-            if (ep->CP_number == cp_number) {
+            if (ep->CP_number == cp_number && ep->stream_id == ecm_stream_id) {
                 // This is our ECM
                 ecm_response = *ep;
                 return true;
@@ -326,26 +414,33 @@ bool ts::ECMGClient::submitECM(uint16_t cp_number,
                                size_t ac_size,
                                uint16_t cp_duration,
                                ECMGClientHandlerInterface* ecm_handler)
+{
+    return submitECM(_stream_status.stream_id, cp_number, current_cw, next_cw, ac, ac_size, cp_duration, ecm_handler);
+}
+
+bool ts::ECMGClient::submitECM(uint16_t ecm_stream_id,
+                               uint16_t cp_number,
+                               const void* current_cw,
+                               const void* next_cw,
+                               const void* ac,
+                               size_t ac_size,
+                               uint16_t cp_duration,
+                               ECMGClientHandlerInterface* ecm_handler)
 {
     // Build a CW_provision message
     ecmgscs::CWProvision msg;
-    msg.channel_id = _stream_status.channel_id;
-    msg.stream_id = _stream_status.stream_id;
-    msg.CP_number = cp_number;
-    msg.has_CW_encryption = false;
-    msg.CP_CW_combination.push_back(ecmgscs::CPCWCombination(cp_number, current_cw));
-    msg.CP_CW_combination.push_back(ecmgscs::CPCWCombination(cp_number + 1, next_cw));
-    msg.has_CP_duration = cp_duration != 0;
-    msg.CP_duration = cp_duration;
-    msg.has_access_criteria = ac != 0;
-    if (ac != 0) {
-        msg.access_criteria.copy(ac, ac_size);
-    }
+    buildCWProvision(msg, ecm_stream_id, cp_number, current_cw, next_cw, ac, ac_size, cp_duration);
 
-    // Register an asynchronous request
+    // Register an asynchronous request. Several requests may be in flight,
+    // the response is matched using the stream id and CP number.
+    const AsyncRequestKey key(ecm_stream_id, cp_number);
     {
         Guard lock(_mutex);
-        _async_requests.insert(std::make_pair(cp_number, ecm_handler));
+        if (_streams.find(ecm_stream_id) == _streams.end()) {
+            _report->error(u"ECM stream %d not open", {ecm_stream_id});
+            return false;
+        }
+        _async_requests[key] = ecm_handler;
     }
 
     // Send the CW_provision message
@@ -354,13 +449,24 @@ bool ts::ECMGClient::submitECM(uint16_t cp_number,
     // Clear asynchronous request on error
     if (!ok) {
         Guard lock(_mutex);
-        _async_requests.erase(cp_number);
+        _async_requests.erase(key);
     }
 
     return ok;
 }
 
 
+//----------------------------------------------------------------------------
+// Get the number of asynchronous ECM requests which are still in flight.
+//----------------------------------------------------------------------------
+
+size_t ts::ECMGClient::pendingECMCount() const
+{
+    Guard lock(_mutex);
+    return _async_requests.size();
+}
+
+
 //----------------------------------------------------------------------------
 // Receiver thread main code
 //----------------------------------------------------------------------------
@@ -403,8 +509,17 @@ void ts::ECMGClient::main()
                     break;
                 }
                 case ecmgscs::Tags::stream_test: {
-                    // Automatic reply to stream_test
-                    ok = _connection.send(_stream_status, *report);
+                    // Automatic reply to stream_test, using the status of the tested stream.
+                    const tlv::StreamMessage* const test = dynamic_cast<const tlv::StreamMessage*>(msg.pointer());
+                    ecmgscs::StreamStatus status(_stream_status);
+                    if (test != 0) {
+                        Guard lock(_mutex);
+                        StreamStatusMap::const_iterator it = _streams.find(test->stream_id);
+                        if (it != _streams.end()) {
+                            status = it->second;
+                        }
+                    }
+                    ok = _connection.send(status, *report);
                     break;
                 }
                 case ecmgscs::Tags::ECM_response: {
@@ -414,10 +529,10 @@ void ts::ECMGClient::main()
                     ECMGClientHandlerInterface* handler = 0;
                     {
                         Guard lock(_mutex);
-                        AsyncRequests::iterator it = _async_requests.find(resp->CP_number);
+                        AsyncRequests::iterator it = _async_requests.find(AsyncRequestKey(resp->stream_id, resp->CP_number));
                         if (it != _async_requests.end()) {
                             handler = it->second;
-                            _async_requests.erase(resp->CP_number);
+                            _async_requests.erase(it);
                         }
                     }
                     if (handler == 0) {
@@ -449,6 +564,8 @@ void ts::ECMGClient::main()
                 _connection.disconnect(NULLREP);
                 _connection.close(NULLREP);
             }
+            // Pending asynchronous requests will never complete.
+            _async_requests.clear();
         }
     }
 }
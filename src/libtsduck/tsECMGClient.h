@@ -49,6 +49,11 @@ namespace ts {
     //!
     //! Restriction: The target ECMG shall support only current/next control words in ECM,
     //! meaning CW_per_msg = 2 and lead_CW = 1.
+    //!
+    //! Several ECM streams can be opened on the same channel. Asynchronous ECM requests
+    //! are pipelined: any number of CW_provision requests may be in flight at the same
+    //! time. The ECM responses are matched to the requests using the ECM_stream_id and
+    //! CP_number and the completion is notified to the handler of each request.
     //! @see DVB standard ETSI TS 103.197 V1.4.1 for ECMG <=> SCS protocol.
     //!
     class TSDUCKDLL ECMGClient: private Thread
@@ -94,6 +99,22 @@ namespace ts {
                      const AbortInterface* abort,
                      Report* report);
 
+        //!
+        //! Open an additional ECM stream on the channel of a connected ECMG.
+        //! The first ECM stream is opened by connect().
+        //! This method shall not be called concurrently with generateECM().
+        //!
+        //! @param [in] ecm_stream_id ECM_stream_id, see ECMG <=> SCS protocol.
+        //! @param [in] ecm_id ECM_id, see ECMG <=> SCS protocol.
+        //! @param [in] nominal_cp_duration Nominal crypto-period in 100 ms units.
+        //! @param [out] stream_status Initial response to stream_setup
+        //! @return True on success, false on error.
+        //!
+        bool addStream(uint16_t ecm_stream_id,
+                       uint16_t ecm_id,
+                       uint16_t nominal_cp_duration,
+                       ecmgscs::StreamStatus& stream_status);
+
         //!
         //! Synchronously generate an ECM.
         //!
@@ -114,6 +135,28 @@ namespace ts {
                          uint16_t cp_duration,
                          ecmgscs::ECMResponse& response);
 
+        //!
+        //! Synchronously generate an ECM on a given ECM stream.
+        //!
+        //! @param [in] ecm_stream_id ECM_stream_id, as specified in connect() or addStream().
+        //! @param [in] cp_number Current crypto-period number.
+        //! @param [in] current_cw 8-byte control word for current crypto-period.
+        //! @param [in] next_cw 8-byte control word for next crypto-period.
+        //! @param [in] ac Access criteria, unspecified if zero.
+        //! @param [in] ac_size Access criteria size in bytes.
+        //! @param [in] cp_duration Crypto-period in 100 ms units, unspecified if zero.
+        //! @param [out] response Returned ECM.
+        //! @return True on success, false on error.
+        //!
+        bool generateECM(uint16_t ecm_stream_id,
+                         uint16_t cp_number,
+                         const void* current_cw,
+                         const void* next_cw,
+                         const void* ac,
+                         size_t ac_size,
+                         uint16_t cp_duration,
+                         ecmgscs::ECMResponse& response);
+
         //!
         //! Asynchronously generate an ECM.
         //! Submit the ECM request and return immediately.
@@ -136,6 +179,37 @@ namespace ts {
                        uint16_t cp_duration,
                        ECMGClientHandlerInterface* handler);
 
+        //!
+        //! Asynchronously generate an ECM on a given ECM stream.
+        //! Submit the ECM request and return immediately. Several requests may be
+        //! in flight at the same time, on the same or distinct ECM streams.
+        //! The notification of the ECM generation is performed through the specified handler.
+        //!
+        //! @param [in] ecm_stream_id ECM_stream_id, as specified in connect() or addStream().
+        //! @param [in] cp_number Current crypto-period number.
+        //! @param [in] current_cw 8-byte control word for current crypto-period.
+        //! @param [in] next_cw 8-byte control word for next crypto-period.
+        //! @param [in] ac Access criteria, unspecified if zero.
+        //! @param [in] ac_size Access criteria size in bytes.
+        //! @param [in] cp_duration Crypto-period in 100 ms units, unspecified if zero.
+        //! @param [in] handler Object which will be notified of the returned ECM.
+        //! @return True on success, false on error.
+        //!
+        bool submitECM(uint16_t ecm_stream_id,
+                       uint16_t cp_number,
+                       const void* current_cw,
+                       const void* next_cw,
+                       const void* ac,
+                       size_t ac_size,
+                       uint16_t cp_duration,
+                       ECMGClientHandlerInterface* handler);
+
+        //!
+        //! Get the number of asynchronous ECM requests which are still in flight.
+        //! @return The number of submitted ECM requests without response.
+        //!
+        size_t pendingECMCount() const;
+
         //!
         //! Disconnect from remote ECMG.
         //! Close stream and channel.
@@ -169,8 +243,12 @@ namespace ts {
         // Timeout for responses from ECMG (except ECM generation)
         static const MilliSecond RESPONSE_TIMEOUT = 5000;
 
-        // List of asynchronous ECM requests: key=cp_number, value=handler
-        typedef std::map <uint16_t, ECMGClientHandlerInterface*> AsyncRequests;
+        // List of asynchronous ECM requests: key=(stream_id, cp_number), value=handler
+        typedef std::pair <uint16_t, uint16_t> AsyncRequestKey;
+        typedef std::map <AsyncRequestKey, ECMGClientHandlerInterface*> AsyncRequests;
+
+        // List of open ECM streams: key=stream_id, value=stream_status
+        typedef std::map <uint16_t, ecmgscs::StreamStatus> StreamStatusMap;
 
         // Private members
         State                   _state;
@@ -178,8 +256,9 @@ namespace ts {
         Report*        _report;
         tlv::Connection <Mutex> _connection;     // connection with ECMG server
         ecmgscs::ChannelStatus  _channel_status; // initial response to channel_setup
-        ecmgscs::StreamStatus   _stream_status;  // initial response to stream_setup
-        Mutex                   _mutex;          // exclusive access to protected fields
+        ecmgscs::StreamStatus   _stream_status;  // initial response to stream_setup (first stream)
+        StreamStatusMap         _streams;        // all open streams, including first one
+        mutable Mutex           _mutex;          // exclusive access to protected fields
         Condition               _work_to_do;     // notify receiver thread to do some work
         AsyncRequests           _async_requests;
         MessageQueue <tlv::Message, NullMutex> _response_queue;
@@ -190,6 +269,19 @@ namespace ts {
         // Report specified error message if not empty, abort connection and return false
         bool abortConnection(const UString& = UString());
 
+        // Send a stream_setup and wait for the stream_status.
+        bool setupStream(uint16_t ecm_stream_id, uint16_t ecm_id, uint16_t nominal_cp_duration, ecmgscs::StreamStatus& stream_status);
+
+        // Build a CW_provision message.
+        void buildCWProvision(ecmgscs::CWProvision& msg,
+                              uint16_t ecm_stream_id,
+                              uint16_t cp_number,
+                              const void* current_cw,
+                              const void* next_cw,
+                              const void* ac,
+                              size_t ac_size,
+                              uint16_t cp_duration) const;
+
         // Unreachable operations
         ECMGClient(const ECMGClient&) = delete;
         ECMGClient& operator=(const ECMGClient&) = delete;
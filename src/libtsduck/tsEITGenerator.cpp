@@ -0,0 +1,640 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  Generation of EIT present/following and schedule on one PID.
+//
+//----------------------------------------------------------------------------
+
+#include "tsEITGenerator.h"
+#include "tsMJD.h"
+#include "tsBCD.h"
+TSDUCK_SOURCE;
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::EITGenerator::DEFAULT_DAYS;
+const size_t ts::EITGenerator::MAX_DAYS;
+const size_t ts::EITGenerator::SCHED_TABLES;
+#endif
+
+// Repetition profiles from ETSI TS 101 211, section 4.4.
+const ts::EITGenerator::RepetitionProfile ts::EITGenerator::SatelliteCableProfile = {2000, 10000, 10000, 30000, 10000, 30000, 1};
+const ts::EITGenerator::RepetitionProfile ts::EITGenerator::TerrestrialProfile = {2000, 20000, 10000, 30000, 60000, 300000, 1};
+
+namespace {
+    // Duration of an EIT schedule segment and number of segments per day and per table id.
+    const ts::MilliSecond SEGMENT_DURATION = 3 * ts::MilliSecPerHour;
+    const size_t SEGMENTS_PER_DAY = 8;
+    const size_t SEGMENTS_PER_TABLE = 32;
+    const size_t SECTIONS_PER_SEGMENT = 8;
+
+    // Size of the fixed part of an EIT section payload and of an event description.
+    const size_t EIT_PAYLOAD_HEADER_SIZE = 6;
+    const size_t EIT_EVENT_FIXED_SIZE = 12;
+
+    // Running status of events in the EIT p/f (ETSI EN 300 468, table 6).
+    const uint8_t RS_UNDEFINED   = 0;
+    const uint8_t RS_NOT_RUNNING = 1;
+    const uint8_t RS_RUNNING     = 4;
+}
+
+
+//----------------------------------------------------------------------------
+// Internal structures constructors.
+//----------------------------------------------------------------------------
+
+ts::EITGenerator::ServiceId::ServiceId(const EIT& eit) :
+    onetw_id(eit.onetw_id),
+    ts_id(eit.ts_id),
+    service_id(eit.service_id),
+    actual(eit.isActual())
+{
+}
+
+bool ts::EITGenerator::ServiceId::operator<(const ServiceId& other) const
+{
+    if (actual != other.actual) {
+        return actual;
+    }
+    else if (onetw_id != other.onetw_id) {
+        return onetw_id < other.onetw_id;
+    }
+    else if (ts_id != other.ts_id) {
+        return ts_id < other.ts_id;
+    }
+    else {
+        return service_id < other.service_id;
+    }
+}
+
+ts::EITGenerator::SubTable::SubTable() :
+    version(0),
+    built(false),
+    dirty(false),
+    sections()
+{
+}
+
+ts::EITGenerator::Service::Service() :
+    events(),
+    dirty(false),
+    pf(),
+    present_id(-1),
+    following_id(-1),
+    pf_expire(Time::Epoch),
+    sched(),
+    last_index(-1)
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Constructor.
+//----------------------------------------------------------------------------
+
+ts::EITGenerator::EITGenerator(PID pid, Report& report) :
+    _report(report),
+    _pzer(pid, CyclingPacketizer::ALWAYS),
+    _profile(SatelliteCableProfile),
+    _bitrate(0),
+    _max_days(DEFAULT_DAYS),
+    _time_set(false),
+    _now(),
+    _origin(),
+    _segment(0),
+    _required(0),
+    _stretch(1000),
+    _services()
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Reset the content of the generator.
+//----------------------------------------------------------------------------
+
+void ts::EITGenerator::reset()
+{
+    _pzer.reset();
+    _pzer.removeAll();
+    _services.clear();
+    _required = 0;
+    _stretch = 1000;
+}
+
+
+//----------------------------------------------------------------------------
+// Get the number of events in the event database.
+//----------------------------------------------------------------------------
+
+size_t ts::EITGenerator::eventCount() const
+{
+    size_t count = 0;
+    for (ServiceMap::const_iterator it = _services.begin(); it != _services.end(); ++it) {
+        count += it->second.events.size();
+    }
+    return count;
+}
+
+
+//----------------------------------------------------------------------------
+// Set the generation parameters.
+//----------------------------------------------------------------------------
+
+void ts::EITGenerator::setBitRate(BitRate bitrate)
+{
+    _bitrate = bitrate;
+    _pzer.setBitRate(bitrate);
+    adjustStretch();
+}
+
+void ts::EITGenerator::setProfile(const RepetitionProfile& profile)
+{
+    _profile = profile;
+
+    // All sections must be re-added with their new repetition rates.
+    _required = 0;
+    for (ServiceMap::iterator it = _services.begin(); it != _services.end(); ++it) {
+        Service& srv(it->second);
+        for (SectionPtrVector::const_iterator sec = srv.pf.sections.begin(); sec != srv.pf.sections.end(); ++sec) {
+            _required += nominalBitRate(**sec);
+        }
+        for (size_t index = 0; index < SCHED_TABLES; ++index) {
+            for (SectionPtrVector::const_iterator sec = srv.sched[index].sections.begin(); sec != srv.sched[index].sections.end(); ++sec) {
+                _required += nominalBitRate(**sec);
+            }
+        }
+    }
+    _stretch = 0;
+    adjustStretch();
+}
+
+void ts::EITGenerator::setMaxDays(size_t days)
+{
+    days = std::max<size_t>(1, std::min(days, MAX_DAYS));
+    if (days != _max_days) {
+        _max_days = days;
+        for (ServiceMap::iterator it = _services.begin(); it != _services.end(); ++it) {
+            it->second.dirty = true;
+            for (size_t index = 0; index < SCHED_TABLES; ++index) {
+                it->second.sched[index].dirty = true;
+            }
+        }
+        regenerate();
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Get the global 3-hour segment of a time, relative to origin.
+//----------------------------------------------------------------------------
+
+int64_t ts::EITGenerator::segmentOf(const Time& time) const
+{
+    const MilliSecond ms = time - _origin;
+    return ms >= 0 ? int64_t(ms / SEGMENT_DURATION) : -1 - int64_t((-ms - 1) / SEGMENT_DURATION);
+}
+
+
+//----------------------------------------------------------------------------
+// Mark the EIT schedule sub-table containing an event as dirty.
+//----------------------------------------------------------------------------
+
+void ts::EITGenerator::touchEvent(Service& srv, const EIT::Event& event)
+{
+    srv.dirty = true;
+    if (_time_set) {
+        // Events which started before the current segment are sent in the current segment.
+        const int64_t seg = std::max(segmentOf(event.start_time), int64_t(_segment));
+        if (seg < int64_t(_max_days * SEGMENTS_PER_DAY)) {
+            srv.sched[seg / SEGMENTS_PER_TABLE].dirty = true;
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Merge the events of an EIT into the event database.
+//----------------------------------------------------------------------------
+
+size_t ts::EITGenerator::loadEvents(const EIT& eit)
+{
+    if (!eit.isValid()) {
+        return 0;
+    }
+
+    Service& srv(_services[ServiceId(eit)]);
+
+    for (EIT::EventMap::const_iterator it = eit.events.begin(); it != eit.events.end(); ++it) {
+        // If the event already exists, the sub-table of its previous version is modified as well.
+        EIT::EventMap::iterator prev = srv.events.find(it->first);
+        if (prev != srv.events.end()) {
+            touchEvent(srv, prev->second);
+            srv.events.erase(prev);
+        }
+        srv.events.insert(*it);
+        touchEvent(srv, it->second);
+        if (int(it->first) == srv.present_id || int(it->first) == srv.following_id) {
+            srv.pf.dirty = true;
+        }
+    }
+
+    // Force the recomputation of the present and following events.
+    srv.pf_expire = Time::Epoch;
+
+    regenerate();
+    return eit.events.size();
+}
+
+
+//----------------------------------------------------------------------------
+// Set the current UTC time.
+//----------------------------------------------------------------------------
+
+void ts::EITGenerator::setCurrentTime(const Time& utc)
+{
+    const Time day(utc.thisDay());
+    const bool new_day = !_time_set || day != _origin;
+
+    _now = utc;
+    _origin = day;
+    _time_set = true;
+
+    const size_t segment = size_t(segmentOf(utc));
+    const bool new_segment = new_day || segment != _segment;
+    _segment = segment;
+
+    if (new_segment) {
+        // Discard events which completed before the current segment.
+        const Time limit(_origin + MilliSecond(_segment) * SEGMENT_DURATION);
+        for (ServiceMap::iterator it = _services.begin(); it != _services.end(); ++it) {
+            Service& srv(it->second);
+            for (EIT::EventMap::iterator ev = srv.events.begin(); ev != srv.events.end(); ) {
+                if (ev->second.start_time + ev->second.duration * MilliSecPerSec <= limit) {
+                    srv.events.erase(ev++);
+                }
+                else {
+                    ++ev;
+                }
+            }
+            // On a new day, all segments move to a new position. Otherwise, only the first
+            // sub-table is modified: segments before the current one are omitted.
+            srv.dirty = true;
+            srv.sched[0].dirty = true;
+            for (size_t index = 1; new_day && index < SCHED_TABLES; ++index) {
+                srv.sched[index].dirty = true;
+            }
+        }
+    }
+
+    regenerate();
+}
+
+
+//----------------------------------------------------------------------------
+// Rebuild all modified sub-tables.
+//----------------------------------------------------------------------------
+
+void ts::EITGenerator::regenerate()
+{
+    // No EIT can be built without a reference time.
+    if (!_time_set) {
+        return;
+    }
+
+    for (ServiceMap::iterator it = _services.begin(); it != _services.end(); ++it) {
+        const ServiceId& id(it->first);
+        Service& srv(it->second);
+
+        // Check if the present or following event changes.
+        if (_now >= srv.pf_expire || srv.pf.dirty || !srv.pf.built) {
+            buildPF(id, srv);
+        }
+
+        if (srv.dirty) {
+            // When the last table id changes, all sub-tables must be rebuilt.
+            const int last = lastScheduleIndex(srv);
+            if (last != srv.last_index) {
+                for (size_t index = 0; index < SCHED_TABLES; ++index) {
+                    srv.sched[index].dirty = true;
+                }
+                srv.last_index = last;
+            }
+            for (size_t index = 0; index < SCHED_TABLES; ++index) {
+                if (srv.sched[index].dirty) {
+                    buildSchedule(id, srv, index);
+                }
+            }
+            srv.dirty = false;
+        }
+    }
+
+    adjustStretch();
+}
+
+
+//----------------------------------------------------------------------------
+// Compute the last EIT schedule table index of a service, -1 if none.
+//----------------------------------------------------------------------------
+
+int ts::EITGenerator::lastScheduleIndex(const Service& srv) const
+{
+    int64_t last = -1;
+    const int64_t limit = int64_t(_max_days * SEGMENTS_PER_DAY);
+    for (EIT::EventMap::const_iterator it = srv.events.begin(); it != srv.events.end(); ++it) {
+        const int64_t seg = std::max(segmentOf(it->second.start_time), int64_t(_segment));
+        if (seg < limit) {
+            last = std::max(last, seg);
+        }
+    }
+    return last < 0 ? -1 : int(last / SEGMENTS_PER_TABLE);
+}
+
+
+//----------------------------------------------------------------------------
+// Serialize one event at the end of a section payload.
+//----------------------------------------------------------------------------
+
+bool ts::EITGenerator::SerializeEvent(uint16_t event_id, const EIT::Event& event, uint8_t running_status, ByteBlock& payload)
+{
+    const size_t size = EIT_EVENT_FIXED_SIZE + event.descs.binarySize();
+    if (payload.size() + size > MAX_PSI_LONG_SECTION_PAYLOAD_SIZE) {
+        return false;
+    }
+
+    uint8_t* data = reinterpret_cast<uint8_t*>(payload.enlarge(size));
+    size_t remain = size;
+    PutUInt16(data, event_id);
+    EncodeMJD(event.start_time, data + 2, 5);
+    data[7] = EncodeBCD(int(event.duration / 3600));
+    data[8] = EncodeBCD(int((event.duration / 60) % 60));
+    data[9] = EncodeBCD(int(event.duration % 60));
+    data += 10;
+    remain -= 10;
+
+    // The running status and CA flag are inserted in the 4 reserved bits of the descriptor_loop_length.
+    uint8_t* flags = data;
+    event.descs.lengthSerialize(data, remain);
+    flags[0] = (flags[0] & 0x0F) | uint8_t(running_status << 5) | (event.CA_controlled ? 0x10 : 0x00);
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Rebuild the EIT p/f of a service.
+//----------------------------------------------------------------------------
+
+void ts::EITGenerator::buildPF(const ServiceId& id, Service& srv)
+{
+    // Locate the present and following events. The present event is running now.
+    // The following one is the first event after the present one (or after now).
+    EIT::EventMap::const_iterator present = srv.events.end();
+    EIT::EventMap::const_iterator following = srv.events.end();
+    for (EIT::EventMap::const_iterator it = srv.events.begin(); it != srv.events.end(); ++it) {
+        const Time& start(it->second.start_time);
+        if (start <= _now && _now < start + it->second.duration * MilliSecPerSec) {
+            present = it;
+        }
+    }
+    const Time next(present == srv.events.end() ? _now : present->second.start_time + present->second.duration * MilliSecPerSec);
+    for (EIT::EventMap::const_iterator it = srv.events.begin(); it != srv.events.end(); ++it) {
+        if (it != present && it->second.start_time >= next && (following == srv.events.end() || it->second.start_time < following->second.start_time)) {
+            following = it;
+        }
+    }
+
+    // The p/f must be recomputed at the end of the present event or at the start of the following one.
+    srv.pf_expire = Time::Apocalypse;
+    if (present != srv.events.end()) {
+        srv.pf_expire = next;
+    }
+    if (following != srv.events.end()) {
+        srv.pf_expire = std::min(srv.pf_expire, following->second.start_time);
+    }
+
+    const int present_id = present == srv.events.end() ? -1 : int(present->first);
+    const int following_id = following == srv.events.end() ? -1 : int(following->first);
+    if (srv.pf.built && !srv.pf.dirty && present_id == srv.present_id && following_id == srv.following_id) {
+        return;
+    }
+    srv.present_id = present_id;
+    srv.following_id = following_id;
+
+    // Two sections, the first one with the present event, the second one with the following event.
+    const TID tid = EIT::ComputeTableId(id.actual, true);
+    if (srv.pf.built) {
+        srv.pf.version = (srv.pf.version + 1) & SVERSION_MASK;
+    }
+    SectionPtrVector sections;
+    for (uint8_t num = 0; num < 2; ++num) {
+        ByteBlock payload(EIT_PAYLOAD_HEADER_SIZE);
+        PutUInt16(payload.data(), id.ts_id);
+        PutUInt16(payload.data() + 2, id.onetw_id);
+        payload[4] = 1;   // segment_last_section_number
+        payload[5] = tid; // last_table_id
+        const EIT::EventMap::const_iterator ev(num == 0 ? present : following);
+        if (ev != srv.events.end() && !SerializeEvent(ev->first, ev->second, num == 0 ? RS_RUNNING : RS_NOT_RUNNING, payload)) {
+            _report.warning(u"event 0x%X in service 0x%X is too large for EIT p/f", {ev->first, id.service_id});
+        }
+        sections.push_back(new Section(tid, true, id.service_id, srv.pf.version, true, num, 1, payload.data(), payload.size()));
+    }
+    replaceSections(srv.pf, sections);
+}
+
+
+//----------------------------------------------------------------------------
+// Rebuild one EIT schedule sub-table of a service.
+//----------------------------------------------------------------------------
+
+void ts::EITGenerator::buildSchedule(const ServiceId& id, Service& srv, size_t index)
+{
+    SubTable& sub(srv.sched[index]);
+    sub.dirty = false;
+
+    // A sub-table after the last table id is not sent.
+    if (int(index) > srv.last_index) {
+        if (!sub.sections.empty()) {
+            replaceSections(sub, SectionPtrVector());
+        }
+        return;
+    }
+
+    // Collect the events of each segment in this sub-table.
+    typedef std::multimap<Time, EIT::EventMap::const_iterator> EventsByTime;
+    EventsByTime segments[SEGMENTS_PER_TABLE];
+    const int64_t limit = int64_t(_max_days * SEGMENTS_PER_DAY);
+    const size_t first_seg = index == 0 ? _segment : 0;
+    size_t last_seg = first_seg;
+    for (EIT::EventMap::const_iterator it = srv.events.begin(); it != srv.events.end(); ++it) {
+        const int64_t seg = std::max(segmentOf(it->second.start_time), int64_t(_segment));
+        if (seg < limit && size_t(seg / SEGMENTS_PER_TABLE) == index) {
+            const size_t local = size_t(seg % SEGMENTS_PER_TABLE);
+            segments[local].insert(std::make_pair(it->second.start_time, it));
+            last_seg = std::max(last_seg, local);
+        }
+    }
+
+    // Build the payloads of all sections, segment by segment. Each segment has
+    // at least one section, possibly empty, and up to 8 sections.
+    std::vector<ByteBlock> payloads[SEGMENTS_PER_TABLE];
+    for (size_t seg = first_seg; seg <= last_seg; ++seg) {
+        std::vector<ByteBlock>& secs(payloads[seg]);
+        secs.push_back(ByteBlock(EIT_PAYLOAD_HEADER_SIZE));
+        for (EventsByTime::const_iterator it = segments[seg].begin(); it != segments[seg].end(); ++it) {
+            const uint16_t event_id = it->second->first;
+            const EIT::Event& event(it->second->second);
+            if (!SerializeEvent(event_id, event, RS_UNDEFINED, secs.back())) {
+                if (secs.back().size() > EIT_PAYLOAD_HEADER_SIZE && secs.size() < SECTIONS_PER_SEGMENT) {
+                    secs.push_back(ByteBlock(EIT_PAYLOAD_HEADER_SIZE));
+                }
+                if (!SerializeEvent(event_id, event, RS_UNDEFINED, secs.back())) {
+                    _report.warning(u"segment full in EIT schedule, dropped event 0x%X in service 0x%X", {event_id, id.service_id});
+                }
+            }
+        }
+    }
+
+    // Build the sections.
+    const TID tid = EIT::ComputeTableId(id.actual, false, uint8_t(index));
+    const TID last_tid = EIT::ComputeTableId(id.actual, false, uint8_t(srv.last_index));
+    const uint8_t last_section = uint8_t(last_seg * SECTIONS_PER_SEGMENT + payloads[last_seg].size() - 1);
+    if (sub.built) {
+        sub.version = (sub.version + 1) & SVERSION_MASK;
+    }
+    SectionPtrVector sections;
+    for (size_t seg = first_seg; seg <= last_seg; ++seg) {
+        const uint8_t segment_last = uint8_t(seg * SECTIONS_PER_SEGMENT + payloads[seg].size() - 1);
+        for (size_t i = 0; i < payloads[seg].size(); ++i) {
+            ByteBlock& payload(payloads[seg][i]);
+            PutUInt16(payload.data(), id.ts_id);
+            PutUInt16(payload.data() + 2, id.onetw_id);
+            payload[4] = segment_last;
+            payload[5] = last_tid;
+            sections.push_back(new Section(tid, true, id.service_id, sub.version, true, uint8_t(seg * SECTIONS_PER_SEGMENT + i), last_section, payload.data(), payload.size()));
+        }
+    }
+    replaceSections(sub, sections);
+}
+
+
+//----------------------------------------------------------------------------
+// Replace the sections of a sub-table in the packetizer.
+//----------------------------------------------------------------------------
+
+void ts::EITGenerator::replaceSections(SubTable& sub, const SectionPtrVector& sections)
+{
+    for (SectionPtrVector::const_iterator it = sub.sections.begin(); it != sub.sections.end(); ++it) {
+        _required -= nominalBitRate(**it);
+    }
+    _pzer.removeSections(sub.sections);
+
+    sub.sections = sections;
+    sub.built = true;
+    sub.dirty = false;
+
+    for (SectionPtrVector::const_iterator it = sub.sections.begin(); it != sub.sections.end(); ++it) {
+        _required += nominalBitRate(**it);
+    }
+    addSections(sub.sections);
+}
+
+
+//----------------------------------------------------------------------------
+// Nominal repetition rate and bitrate of a section.
+//----------------------------------------------------------------------------
+
+ts::MilliSecond ts::EITGenerator::nominalRate(const Section& section) const
+{
+    const TID tid = section.tableId();
+    if (tid == TID_EIT_PF_ACT) {
+        return _profile.pf_actual;
+    }
+    else if (tid == TID_EIT_PF_OTH) {
+        return _profile.pf_other;
+    }
+    else {
+        const bool actual = tid >= TID_EIT_S_ACT_MIN && tid <= TID_EIT_S_ACT_MAX;
+        const size_t seg = (tid & 0x0F) * SEGMENTS_PER_TABLE + section.sectionNumber() / SECTIONS_PER_SEGMENT;
+        const bool near = seg / SEGMENTS_PER_DAY < _profile.near_days;
+        return actual ? (near ? _profile.sched_actual_near : _profile.sched_actual_far) : (near ? _profile.sched_other_near : _profile.sched_other_far);
+    }
+}
+
+uint64_t ts::EITGenerator::nominalBitRate(const Section& section) const
+{
+    const MilliSecond rate = nominalRate(section);
+    return rate <= 0 ? 0 : uint64_t(section.packetCount() * PKT_SIZE * 8 * MilliSecPerSec / rate);
+}
+
+ts::BitRate ts::EITGenerator::requiredBitRate() const
+{
+    return BitRate(_required);
+}
+
+
+//----------------------------------------------------------------------------
+// Add sections in the packetizer at the current stretched rate.
+//----------------------------------------------------------------------------
+
+void ts::EITGenerator::addSections(const SectionPtrVector& sections)
+{
+    for (SectionPtrVector::const_iterator it = sections.begin(); it != sections.end(); ++it) {
+        _pzer.addSection(*it, nominalRate(**it) * _stretch / 1000);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Recompute the stretch factor of repetition rates.
+//----------------------------------------------------------------------------
+
+void ts::EITGenerator::adjustStretch()
+{
+    // When the profile requires more than the bitrate budget, all repetition
+    // rates are stretched by the same factor.
+    const uint32_t stretch = _bitrate == 0 ? 1000 : uint32_t(std::max<uint64_t>(1000, _required * 1000 / _bitrate));
+
+    // Avoid reorganizing the packetizer on small variations.
+    if (_stretch != 0 && stretch * 10 >= _stretch * 9 && stretch * 10 <= _stretch * 11) {
+        return;
+    }
+    if (_stretch != 0) {
+        _report.debug(u"EIT repetition rates stretch factor: %d.%03d", {stretch / 1000, stretch % 1000});
+    }
+    _stretch = stretch;
+
+    // Re-add all sections with the new repetition rates.
+    _pzer.removeAll();
+    for (ServiceMap::iterator it = _services.begin(); it != _services.end(); ++it) {
+        Service& srv(it->second);
+        addSections(srv.pf.sections);
+        for (size_t index = 0; index < SCHED_TABLES; ++index) {
+            addSections(srv.sched[index].sections);
+        }
+    }
+}
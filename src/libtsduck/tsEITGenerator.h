@@ -0,0 +1,288 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Generation of EIT present/following and schedule on one PID.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsEIT.h"
+#include "tsCyclingPacketizer.h"
+#include "tsNullReport.h"
+
+namespace ts {
+    //!
+    //! Generation of EIT present/following and schedule on one PID.
+    //!
+    //! Events are loaded from EIT tables and merged into a per-service event database.
+    //! The generator builds EIT p/f and EIT schedule sub-tables following the rules of
+    //! ETSI TS 101 211: the schedule starts at midnight UTC of the current day, is split
+    //! into segments of 3 hours with up to 8 sections per segment, and each table id
+    //! covers 4 days. Empty segments are signalled by one empty section.
+    //!
+    //! Only the sub-tables (one service, one table id) which are affected by a change
+    //! are rebuilt. All sections are packetized by one CyclingPacketizer with repetition
+    //! rates from a repetition profile. When the total bitrate which is required by the
+    //! profile exceeds the bitrate budget of the PID, all repetition rates are stretched
+    //! by the same factor.
+    //!
+    class TSDUCKDLL EITGenerator
+    {
+    public:
+        //!
+        //! Repetition rates of EIT sections.
+        //!
+        struct TSDUCKDLL RepetitionProfile
+        {
+            MilliSecond pf_actual;          //!< EIT p/f actual.
+            MilliSecond pf_other;           //!< EIT p/f other.
+            MilliSecond sched_actual_near;  //!< EIT schedule actual, near days.
+            MilliSecond sched_actual_far;   //!< EIT schedule actual, far days.
+            MilliSecond sched_other_near;   //!< EIT schedule other, near days.
+            MilliSecond sched_other_far;    //!< EIT schedule other, far days.
+            size_t      near_days;          //!< Number of "near" days, starting with the current day.
+        };
+
+        //!
+        //! Repetition profile of ETSI TS 101 211 for satellite and cable networks.
+        //!
+        static const RepetitionProfile SatelliteCableProfile;
+
+        //!
+        //! Repetition profile of ETSI TS 101 211 for terrestrial networks.
+        //!
+        static const RepetitionProfile TerrestrialProfile;
+
+        //!
+        //! Default number of days in the EIT schedule.
+        //!
+        static const size_t DEFAULT_DAYS = 8;
+
+        //!
+        //! Maximum number of days in the EIT schedule (16 table ids of 4 days).
+        //!
+        static const size_t MAX_DAYS = 64;
+
+        //!
+        //! Constructor.
+        //! @param [in] pid PID of the generated EIT's.
+        //! @param [in,out] report Where to report errors and warnings.
+        //!
+        EITGenerator(PID pid = PID_EIT, Report& report = NULLREP);
+
+        //!
+        //! Set the PID of the generated EIT's.
+        //! @param [in] pid PID of the generated EIT's.
+        //!
+        void setPID(PID pid)
+        {
+            _pzer.setPID(pid);
+        }
+
+        //!
+        //! Set the bitrate budget of the EIT PID.
+        //! @param [in] bitrate Bitrate of the EIT PID in b/s. When zero, the repetition
+        //! rates are ignored and all sections are sent in sequence.
+        //!
+        void setBitRate(BitRate bitrate);
+
+        //!
+        //! Set the repetition profile.
+        //! @param [in] profile The repetition profile. The default is SatelliteCableProfile.
+        //!
+        void setProfile(const RepetitionProfile& profile);
+
+        //!
+        //! Set the number of days in the EIT schedule.
+        //! @param [in] days Number of days, starting with the current day, up to MAX_DAYS.
+        //! Events after this period are kept but not sent.
+        //!
+        void setMaxDays(size_t days);
+
+        //!
+        //! Set the current UTC time.
+        //! This is the reference for EIT p/f and for the start of the EIT schedule.
+        //! No EIT is generated before the first call. Events which are completed
+        //! before the start of the current segment are discarded.
+        //! @param [in] utc Current UTC time.
+        //!
+        void setCurrentTime(const Time& utc);
+
+        //!
+        //! Merge the events of an EIT into the event database.
+        //! Events with the same event_id in the same service are replaced.
+        //! Only the EIT sub-tables which are affected by the new events are rebuilt.
+        //! @param [in] eit An EIT, either p/f or schedule. The actual/other type of the
+        //! EIT and its service identification are used for the generated EIT's.
+        //! @return The number of loaded events.
+        //!
+        size_t loadEvents(const EIT& eit);
+
+        //!
+        //! Remove all events and all generated sections.
+        //!
+        void reset();
+
+        //!
+        //! Get the number of services in the event database.
+        //! @return The number of services.
+        //!
+        size_t serviceCount() const
+        {
+            return _services.size();
+        }
+
+        //!
+        //! Get the number of events in the event database.
+        //! @return The number of events.
+        //!
+        size_t eventCount() const;
+
+        //!
+        //! Get the number of generated EIT sections.
+        //! @return The number of generated EIT sections.
+        //!
+        size_t sectionCount() const
+        {
+            return _pzer.storedSectionCount();
+        }
+
+        //!
+        //! Get the bitrate which is required by the repetition profile.
+        //! @return The bitrate in b/s which is required to send all sections at their nominal rate.
+        //!
+        BitRate requiredBitRate() const;
+
+        //!
+        //! Build the next TS packet of the EIT PID.
+        //! @param [out] packet The next packet. A null packet when there is no section to send.
+        //!
+        void getNextPacket(TSPacket& packet)
+        {
+            _pzer.getNextPacket(packet);
+        }
+
+    private:
+        // Identification of a service in an EIT.
+        struct ServiceId
+        {
+            uint16_t onetw_id;
+            uint16_t ts_id;
+            uint16_t service_id;
+            bool     actual;
+
+            ServiceId(const EIT& eit);
+            bool operator<(const ServiceId& other) const;
+        };
+
+        // Sections of one sub-table (one service, one table id).
+        struct SubTable
+        {
+            uint8_t          version;   // Version of last generated sections
+            bool             built;     // The sub-table was already generated once
+            bool             dirty;     // Need to be rebuilt
+            SectionPtrVector sections;  // Current sections, in the packetizer
+
+            SubTable();
+        };
+
+        // Number of EIT schedule table ids for actual or other TS.
+        static const size_t SCHED_TABLES = 16;
+
+        // Context of one service.
+        struct Service
+        {
+            EIT::EventMap events;                 // All events, indexed by event id
+            bool          dirty;                  // Some sub-tables need to be checked
+            SubTable      pf;                     // EIT p/f
+            int           present_id;             // Event id in p/f section 0, -1 if none
+            int           following_id;           // Event id in p/f section 1, -1 if none
+            Time          pf_expire;              // Time where p/f shall be recomputed
+            SubTable      sched[SCHED_TABLES];    // EIT schedule, by table index
+            int           last_index;             // Last EIT schedule table index, -1 if none
+
+            Service();
+        };
+
+        typedef std::map<ServiceId, Service> ServiceMap;
+
+        // Private members:
+        Report&           _report;
+        CyclingPacketizer _pzer;
+        RepetitionProfile _profile;
+        BitRate           _bitrate;
+        size_t            _max_days;
+        bool              _time_set;         // setCurrentTime() was called
+        Time              _now;              // Current UTC time
+        Time              _origin;           // Start of schedule, midnight of current day
+        size_t            _segment;          // Index of current 3-hour segment from _origin
+        uint64_t          _required;         // Required bitrate of all sections at nominal rate
+        uint32_t          _stretch;          // Applied stretch factor of repetition rates, in per-mille
+        ServiceMap        _services;
+
+        // Rebuild all modified sub-tables.
+        void regenerate();
+
+        // Rebuild the EIT p/f of a service.
+        void buildPF(const ServiceId& id, Service& srv);
+
+        // Rebuild one EIT schedule sub-table of a service.
+        void buildSchedule(const ServiceId& id, Service& srv, size_t index);
+
+        // Compute the last EIT schedule table index of a service, -1 if none.
+        int lastScheduleIndex(const Service& srv) const;
+
+        // Get the global 3-hour segment of a time, relative to origin, negative if before.
+        int64_t segmentOf(const Time& time) const;
+
+        // Mark the EIT schedule sub-table containing an event as dirty.
+        void touchEvent(Service& srv, const EIT::Event& event);
+
+        // Serialize one event at the end of a section payload, return false if it does not fit.
+        static bool SerializeEvent(uint16_t event_id, const EIT::Event& event, uint8_t running_status, ByteBlock& payload);
+
+        // Replace the sections of a sub-table in the packetizer.
+        void replaceSections(SubTable& sub, const SectionPtrVector& sections);
+
+        // Nominal repetition rate and bitrate of a section.
+        MilliSecond nominalRate(const Section& section) const;
+        uint64_t nominalBitRate(const Section& section) const;
+
+        // Add sections in the packetizer at the current stretched rate.
+        void addSections(const SectionPtrVector& sections);
+
+        // Recompute the stretch factor, re-add all sections if it significantly changed.
+        void adjustStretch();
+
+        // Inaccessible operations
+        EITGenerator(const EITGenerator&) = delete;
+        EITGenerator& operator=(const EITGenerator&) = delete;
+    };
+}
@@ -47,6 +47,8 @@ ts::ForkPipe::ForkPipe() :
     _synchronous(false),
     _ignore_abort(false),
     _broken_pipe(false),
+    _zero_copy(false),
+    _pipe_size(0),
 #if defined(TS_WINDOWS)
     _handle(INVALID_HANDLE_VALUE),
     _process(INVALID_HANDLE_VALUE)
@@ -82,6 +84,7 @@ bool ts::ForkPipe::open(const UString& command, bool synchronous, size_t buffer_
     _in_mode = in_mode;
     _broken_pipe = false;
     _synchronous = synchronous;
+    _pipe_size = 0;
 
     report.debug(u"creating process \"%s\"", {command});
 
@@ -103,6 +106,7 @@ bool ts::ForkPipe::open(const UString& command, bool synchronous, size_t buffer_
             report.error(u"error creating pipe: %s", {ErrorCodeMessage()});
             return false;
         }
+        _pipe_size = size_t(bufsize);
 
         // CreatePipe can only inherit none or both handles. Since we need the
         // read handle to be inherited by the child process, we said "inherit".
@@ -204,6 +208,19 @@ bool ts::ForkPipe::open(const UString& command, bool synchronous, size_t buffer_
         return false;
     }
 
+#if defined(TS_LINUX)
+    // Enlarge the pipe buffer if requested. Never shrink it below the system default.
+    if (_in_mode == USE_PIPE) {
+        const int defsize = ::fcntl(filedes[1], F_GETPIPE_SZ);
+        if (defsize > 0 && buffer_size > size_t(defsize) && ::fcntl(filedes[1], F_SETPIPE_SZ, int(std::min<size_t>(buffer_size, std::numeric_limits<int>::max()))) < 0) {
+            report.warning(u"cannot set pipe buffer size to %'d bytes: %s", {buffer_size, ErrorCodeMessage()});
+        }
+        const int size = ::fcntl(filedes[1], F_GETPIPE_SZ);
+        _pipe_size = size < 0 ? 0 : size_t(size);
+        report.debug(u"pipe buffer size: %'d bytes", {_pipe_size});
+    }
+#endif
+
     // Create the forked process
     if ((_fpid = ::fork()) < 0) {
         report.error(u"fork error: %s", {ErrorCodeMessage()});
@@ -329,6 +346,22 @@ bool ts::ForkPipe::close (Report& report)
 }
 
 
+//----------------------------------------------------------------------------
+// Set "zero copy" mode.
+//----------------------------------------------------------------------------
+
+bool ts::ForkPipe::setZeroCopy(bool on)
+{
+#if defined(TS_LINUX)
+    _zero_copy = on;
+    return true;
+#else
+    _zero_copy = false;
+    return !on;
+#endif
+}
+
+
 //----------------------------------------------------------------------------
 // Write data to the pipe (received at process' standard input).
 // Return true on success, false on error.
@@ -364,7 +397,7 @@ bool ts::ForkPipe::write (const void* addr, size_t size, Report& report)
             // Normal case, some data were written
             assert(outsize <= remain);
             data += outsize;
-            remain -= std::max(remain, outsize);
+            remain -= outsize;
         }
         else {
             // Write error
@@ -382,12 +415,20 @@ bool ts::ForkPipe::write (const void* addr, size_t size, Report& report)
     size_t remain = size;
 
     while (remain > 0 && !error) {
-        ssize_t outsize = ::write (_fd, data, remain);
+#if defined(TS_LINUX)
+        // In zero copy mode, the user pages are mapped into the pipe, not copied.
+        ::iovec iov;
+        iov.iov_base = const_cast<char*>(data);
+        iov.iov_len = remain;
+        ssize_t outsize = _zero_copy ? ::vmsplice(_fd, &iov, 1, 0) : ::write(_fd, data, remain);
+#else
+        ssize_t outsize = ::write(_fd, data, remain);
+#endif
         if (outsize > 0) {
             // Normal case, some data were written
             assert(size_t(outsize) <= remain);
             data += outsize;
-            remain -= std::max(remain, size_t(outsize));
+            remain -= size_t(outsize);
         }
         else if ((error_code = LastErrorCode()) != EINTR) {
             // Actual error (not an interrupt)
@@ -74,7 +74,10 @@ namespace ts {
         //! Create the process, open the optional pipe.
         //! @param [in] command The command to execute.
         //! @param [in] synchronous If true, wait for process termination in close().
-        //! @param [in] buffer_size The pipe buffer size in bytes. Used on Windows only. Zero means default.
+        //! @param [in] buffer_size The pipe buffer size in bytes. Zero means default.
+        //! On Windows, this is the size of the created pipe. On Linux, the pipe is enlarged
+        //! to this size (F_SETPIPE_SZ) when it is larger than the system default. Ignored
+        //! on other systems.
         //! @param [in,out] report Where to report errors.
         //! @param [in] out_mode How to handle stdout and stderr.
         //! @param [in] in_mode How to handle stdin. Use the pipe by default.
@@ -137,6 +140,39 @@ namespace ts {
             return _ignore_abort;
         }
 
+        //!
+        //! Get the actual size of the pipe buffer.
+        //! @return The size in bytes of the pipe buffer or zero if unknown.
+        //!
+        size_t pipeSize() const
+        {
+            return _pipe_size;
+        }
+
+        //!
+        //! Set "zero copy" mode.
+        //! In zero copy mode, write() maps the user pages into the pipe using vmsplice()
+        //! instead of copying the data. This mode is available on Linux only.
+        //!
+        //! Warning: after write() returns, the pipe still references the user memory
+        //! until the data are read by the created process. The caller must not modify
+        //! the written data until at least pipeSize() more bytes have been written
+        //! into the pipe or the pipe is closed.
+        //!
+        //! @param [in] on If true, use zero copy mode in subsequent write() operations.
+        //! @return True on success, false if zero copy mode is not supported on this system.
+        //!
+        bool setZeroCopy(bool on);
+
+        //!
+        //! Get "zero copy" mode.
+        //! @return True if zero copy mode is active.
+        //!
+        bool getZeroCopy() const
+        {
+            return _zero_copy;
+        }
+
         //!
         //! Write data to the pipe (received at process' standard input).
         //! @param [in] addr Address of the data to write.
@@ -152,6 +188,8 @@ namespace ts {
         bool      _synchronous;   // Wait for child process termination in close().
         bool      _ignore_abort;  // Ignore early termination of child process.
         bool      _broken_pipe;   // Pipe is broken, do not attempt to write.
+        bool      _zero_copy;     // Use vmsplice() instead of write() (Linux only).
+        size_t    _pipe_size;     // Actual pipe buffer size, zero if unknown.
 #if defined(TS_WINDOWS)
         ::HANDLE  _handle;        // Pipe output handle.
         ::HANDLE  _process;       // Handle to child process.
@@ -0,0 +1,215 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "tsInjectionScheduler.h"
+TSDUCK_SOURCE;
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::InjectionScheduler::NPOS;
+const size_t ts::InjectionScheduler::DEFAULT_MAX_BURST;
+const uint64_t ts::InjectionScheduler::MAX_PCR_INTERVAL;
+#endif
+
+namespace {
+    // PCR values wrap up after 2^33 x 300.
+    const uint64_t PCR_WRAP = ts::PTS_DTS_SCALE * ts::SYSTEM_CLOCK_SUBFACTOR;
+
+    // Size of a TS packet in bits x SYSTEM_CLOCK_FREQ, the unit of the buckets.
+    const uint64_t PACKET_CREDIT = uint64_t(ts::PKT_SIZE) * 8 * ts::SYSTEM_CLOCK_FREQ;
+}
+
+
+//----------------------------------------------------------------------------
+// Constructor.
+//----------------------------------------------------------------------------
+
+ts::InjectionScheduler::InjectionScheduler(PID pcr_pid) :
+    _pcr_pid(pcr_pid),
+    _use_dts(false),
+    _ts_bitrate(0),
+    _pcr_found(false),
+    _last_pcr(0),
+    _pcr_time(0),
+    _base_time(0),
+    _time(0),
+    _since_pcr(0),
+    _interval_ticks(0),
+    _interval_packets(0),
+    _components()
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Reset the time reference and remove all components.
+//----------------------------------------------------------------------------
+
+void ts::InjectionScheduler::reset()
+{
+    _pcr_found = false;
+    _last_pcr = 0;
+    _pcr_time = 0;
+    _base_time = 0;
+    _time = 0;
+    _since_pcr = 0;
+    _interval_ticks = 0;
+    _interval_packets = 0;
+    _components.clear();
+}
+
+void ts::InjectionScheduler::setPCRPID(PID pcr_pid)
+{
+    if (pcr_pid != _pcr_pid) {
+        // The previous PCR's are meaningless in the new PID.
+        _pcr_pid = pcr_pid;
+        _pcr_found = false;
+    }
+}
+
+void ts::InjectionScheduler::setUseDTS(bool use_dts)
+{
+    if (use_dts != _use_dts) {
+        _use_dts = use_dts;
+        _pcr_found = false;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Manage components.
+//----------------------------------------------------------------------------
+
+size_t ts::InjectionScheduler::addComponent(BitRate bitrate, size_t max_burst)
+{
+    Component comp;
+    comp.bitrate = bitrate;
+    comp.credit = 0;
+    comp.capacity = std::max<size_t>(max_burst, 1) * PACKET_CREDIT;
+    _components.push_back(comp);
+    return _components.size() - 1;
+}
+
+void ts::InjectionScheduler::setBitRate(size_t index, BitRate bitrate)
+{
+    if (index < _components.size()) {
+        _components[index].bitrate = bitrate;
+        if (bitrate == 0) {
+            _components[index].credit = 0;
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Feed the scheduler with the next packet of the main stream.
+//----------------------------------------------------------------------------
+
+void ts::InjectionScheduler::feedPacket(const TSPacket& pkt)
+{
+    const uint64_t previous = _time;
+    _since_pcr++;
+
+    // Interpolated time of this packet, based on the last PCR interval or the TS bitrate.
+    if (_interval_packets != 0) {
+        _time = std::max(_time, _base_time + (_since_pcr * _interval_ticks) / _interval_packets);
+    }
+    else if (_ts_bitrate != 0) {
+        _time += PACKET_CREDIT / _ts_bitrate;
+    }
+
+    // Resynchronize on PCR's (or DTS's) from the reference PID.
+    const bool has_pcr = _use_dts ? pkt.hasDTS() || pkt.hasPTS() : pkt.hasPCR();
+    if (has_pcr && (_pcr_pid == PID_NULL || pkt.getPID() == _pcr_pid)) {
+        const uint64_t pcr = !_use_dts ? pkt.getPCR() : (pkt.hasDTS() ? pkt.getDTS() : pkt.getPTS()) * SYSTEM_CLOCK_SUBFACTOR;
+        _pcr_pid = pkt.getPID();
+        if (_pcr_found && !pkt.getDiscontinuityIndicator()) {
+            const uint64_t delta = (pcr + PCR_WRAP - _last_pcr) % PCR_WRAP;
+            if (delta > 0 && delta <= MAX_PCR_INTERVAL) {
+                // Valid PCR interval. The next PCR is expected after the same interval.
+                // Instead of jumping to the PCR time, the interpolated time converges
+                // to the expected time of the next PCR. This avoids bursts of packets.
+                _pcr_time += delta;
+                _interval_ticks = _pcr_time + delta > _time ? _pcr_time + delta - _time : 0;
+                _interval_packets = _since_pcr;
+            }
+            else {
+                // Discontinuity, restart from the interpolated time.
+                _pcr_time = _time;
+            }
+        }
+        else {
+            _pcr_time = _time;
+        }
+        _pcr_found = true;
+        _last_pcr = pcr;
+        _base_time = _time;
+        _since_pcr = 0;
+    }
+
+    fillBuckets(_time - previous);
+}
+
+
+//----------------------------------------------------------------------------
+// Fill the buckets of all components for a duration.
+//----------------------------------------------------------------------------
+
+void ts::InjectionScheduler::fillBuckets(uint64_t duration)
+{
+    for (std::vector<Component>::iterator it = _components.begin(); it != _components.end(); ++it) {
+        if (it->bitrate != 0) {
+            it->credit = std::min(it->capacity, it->credit + duration * it->bitrate);
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Get the component which should inject a packet.
+//----------------------------------------------------------------------------
+
+size_t ts::InjectionScheduler::nextComponent() const
+{
+    size_t next = NPOS;
+    uint64_t best = PACKET_CREDIT - 1;
+    for (size_t i = 0; i < _components.size(); ++i) {
+        if (_components[i].credit > best) {
+            best = _components[i].credit;
+            next = i;
+        }
+    }
+    return next;
+}
+
+void ts::InjectionScheduler::consume(size_t index)
+{
+    if (index < _components.size()) {
+        Component& comp(_components[index]);
+        comp.credit = comp.credit > PACKET_CREDIT ? comp.credit - PACKET_CREDIT : 0;
+    }
+}
@@ -0,0 +1,195 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//!
+//!  @file
+//!  Time-based scheduling of packets which are injected in a transport stream.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsTSPacket.h"
+
+namespace ts {
+    //!
+    //! Time-based scheduling of packets which are injected in a transport stream.
+    //!
+    //! Injected packets typically replace stuffing packets. Counting packets of
+    //! the main stream to space the injected packets is correct only when the
+    //! main stream has a constant bitrate. This class computes the time of each
+    //! packet of the main stream from the PCR's of a reference PID. The time of
+    //! the packets after a PCR is linearly interpolated, assuming that the next
+    //! PCR comes after the same interval and the same number of packets. The
+    //! interpolated time never decreases and converges to the PCR time without
+    //! jumps. Before two PCR's are found, a fixed transport stream bitrate can be
+    //! used instead. In streams without PCR, typically elementary streams files,
+    //! the DTS (or PTS when there is no DTS) of the reference PID can be used instead.
+    //!
+    //! Several components, typically distinct PID's, share one scheduler. Each
+    //! component is a leaky bucket which is filled at the bitrate of the component.
+    //! When a bucket contains at least one packet, the component is ready to inject
+    //! a packet. The capacity of the bucket (the maximum burst) limits the number
+    //! of packets which are injected in a row after a lack of stuffing, to avoid
+    //! buffer overflows in the receiver. When several components are ready, the
+    //! one with the fullest bucket goes first.
+    //!
+    class TSDUCKDLL InjectionScheduler
+    {
+    public:
+        //!
+        //! Value returned by nextComponent() when no component is ready.
+        //!
+        static const size_t NPOS = size_t(-1);
+
+        //!
+        //! Default maximum burst of a component, in packets.
+        //!
+        static const size_t DEFAULT_MAX_BURST = 2;
+
+        //!
+        //! Maximum interval between two PCR's in the reference PID, in PCR units.
+        //! Beyond this, the two PCR's are considered as discontinuous.
+        //!
+        static const uint64_t MAX_PCR_INTERVAL = SYSTEM_CLOCK_FREQ;
+
+        //!
+        //! Constructor.
+        //! @param [in] pcr_pid The reference PID for PCR's. The default value
+        //! PID_NULL means the first PID which contains PCR's.
+        //!
+        InjectionScheduler(PID pcr_pid = PID_NULL);
+
+        //!
+        //! Reset the time reference and remove all components.
+        //!
+        void reset();
+
+        //!
+        //! Set the reference PID for PCR's.
+        //! @param [in] pcr_pid The reference PID for PCR's. PID_NULL means the first PID which contains PCR's.
+        //!
+        void setPCRPID(PID pcr_pid);
+
+        //!
+        //! Get the reference PID for PCR's.
+        //! @return The reference PID for PCR's or PID_NULL if not yet known.
+        //!
+        PID getPCRPID() const { return _pcr_pid; }
+
+        //!
+        //! Use the DTS of the reference PID instead of PCR's.
+        //! When a PES packet has a PTS but no DTS, the PTS is used.
+        //! @param [in] use_dts If true, use DTS instead of PCR's.
+        //!
+        void setUseDTS(bool use_dts);
+
+        //!
+        //! Set the transport stream bitrate, used when the PCR's cannot be used.
+        //! @param [in] bitrate Transport stream bitrate in bits/second. Zero if unknown.
+        //!
+        void setTSBitRate(BitRate bitrate) { _ts_bitrate = bitrate; }
+
+        //!
+        //! Add a component.
+        //! @param [in] bitrate Target bitrate of the component in bits/second.
+        //! @param [in] max_burst Maximum number of packets of this component in a row.
+        //! @return The index of the new component, starting at zero.
+        //!
+        size_t addComponent(BitRate bitrate, size_t max_burst = DEFAULT_MAX_BURST);
+
+        //!
+        //! Get the number of components.
+        //! @return The number of components.
+        //!
+        size_t componentCount() const { return _components.size(); }
+
+        //!
+        //! Change the bitrate of a component.
+        //! @param [in] index Index of the component.
+        //! @param [in] bitrate New bitrate in bits/second. Zero means that the component
+        //! no longer injects packets.
+        //!
+        void setBitRate(size_t index, BitRate bitrate);
+
+        //!
+        //! Feed the scheduler with the next packet of the main stream.
+        //! The time of the packet is computed and the buckets of all components are filled.
+        //! @param [in] pkt The next packet of the main stream.
+        //!
+        void feedPacket(const TSPacket& pkt);
+
+        //!
+        //! Check if the time of the packets is known, either from PCR's or from the transport stream bitrate.
+        //! @return True if the time of the packets is known.
+        //!
+        bool timeKnown() const { return _interval_packets != 0 || _ts_bitrate != 0; }
+
+        //!
+        //! Get the time of the last packet, relative to the first packet.
+        //! @return The time of the last packet in PCR units (27 MHz).
+        //!
+        uint64_t currentTime() const { return _time; }
+
+        //!
+        //! Get the component which should inject a packet in place of the last packet.
+        //! @return The index of the component with the fullest bucket, if it contains
+        //! at least one packet. NPOS if no component is ready.
+        //!
+        size_t nextComponent() const;
+
+        //!
+        //! Declare that a packet of a component was injected.
+        //! @param [in] index Index of the component.
+        //!
+        void consume(size_t index);
+
+    private:
+        // Description of a component.
+        struct Component
+        {
+            BitRate  bitrate;  // Target bitrate in bits/second.
+            uint64_t credit;   // Content of the bucket in bits x SYSTEM_CLOCK_FREQ.
+            uint64_t capacity; // Capacity of the bucket, same unit.
+        };
+
+        PID           _pcr_pid;          // Reference PID for PCR's.
+        bool          _use_dts;          // Use DTS instead of PCR's.
+        BitRate       _ts_bitrate;       // TS bitrate when PCR's are not usable.
+        bool          _pcr_found;        // At least one PCR found.
+        uint64_t      _last_pcr;         // Last PCR value.
+        uint64_t      _pcr_time;         // Time of last PCR, according to PCR values.
+        uint64_t      _base_time;        // Interpolated time of last PCR packet.
+        uint64_t      _time;             // Interpolated time of last packet, never decreases.
+        PacketCounter _since_pcr;        // Number of packets since last PCR.
+        uint64_t      _interval_ticks;   // Time to elapse after last PCR packet, until expected next PCR.
+        PacketCounter _interval_packets; // Number of packets in the last valid PCR interval.
+        std::vector<Component> _components;
+
+        // Fill the buckets of all components for a duration.
+        void fillBuckets(uint64_t duration);
+    };
+}
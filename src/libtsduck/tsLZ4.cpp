@@ -0,0 +1,259 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+//
+//  LZ4 block compression.
+//
+//----------------------------------------------------------------------------
+
+#include "tsLZ4.h"
+TSDUCK_SOURCE;
+
+// Constants of the LZ4 block format.
+namespace {
+    const size_t   HASH_LOG = 12;               // log2 of hash table size.
+    const size_t   MIN_MATCH = 4;               // Minimum match length.
+    const size_t   LAST_LITERALS = 5;           // Last bytes of a block are always literals.
+    const size_t   MF_LIMIT = 12;               // A match cannot start in the last bytes of a block.
+    const size_t   MAX_OFFSET = 65535;          // Maximum match offset.
+    const size_t   SKIP_TRIGGER = 6;            // Accelerate search in incompressible data.
+    const uint32_t ML_MASK = 0x0F;              // Match length in token.
+    const uint32_t RUN_MASK = 0x0F;             // Literal length in token.
+
+    inline uint32_t Read32(const uint8_t* p)
+    {
+        uint32_t v;
+        ::memcpy(&v, p, sizeof(v));  // unaligned, native byte order, only used for comparisons
+        return v;
+    }
+
+    inline uint32_t Hash(uint32_t seq)
+    {
+        return (seq * 2654435761U) >> (32 - HASH_LOG);
+    }
+
+    // Encode a length extension after a 4-bit field.
+    inline uint8_t* PutLength(uint8_t* op, size_t len)
+    {
+        while (len >= 255) {
+            *op++ = 255;
+            len -= 255;
+        }
+        *op++ = uint8_t(len);
+        return op;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Constructor.
+//----------------------------------------------------------------------------
+
+ts::LZ4::LZ4() :
+    _table(size_t(1) << HASH_LOG, 0)
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Compress a block of data.
+//----------------------------------------------------------------------------
+
+void ts::LZ4::compress(ByteBlock& out, const void* data, size_t size)
+{
+    out.resize(MaxCompressedSize(size));
+
+    const uint8_t* const src = reinterpret_cast<const uint8_t*>(data);
+    const uint8_t* const end = src + size;
+    const uint8_t* anchor = src;   // Start of pending literals.
+    uint8_t* op = out.data();
+
+    if (size >= MF_LIMIT + 1) {
+        const uint8_t* const mflimit = end - MF_LIMIT;
+        const uint8_t* const matchlimit = end - LAST_LITERALS;
+        const uint8_t* ip = src + 1;
+
+        // Positions from a previous block are harmless: all matches are verified.
+        _table[Hash(Read32(src))] = 0;
+
+        while (ip < mflimit) {
+            // Find a match, with a growing step when no match is found for a while.
+            const uint8_t* ref = nullptr;
+            size_t attempts = size_t(1) << SKIP_TRIGGER;
+            for (;;) {
+                const uint32_t seq = Read32(ip);
+                uint32_t& entry(_table[Hash(seq)]);
+                ref = src + entry;
+                entry = uint32_t(ip - src);
+                if (ref < ip && size_t(ip - ref) <= MAX_OFFSET && Read32(ref) == seq) {
+                    break;
+                }
+                ip += attempts++ >> SKIP_TRIGGER;
+                if (ip >= mflimit) {
+                    ref = nullptr;
+                    break;
+                }
+            }
+            if (ref == nullptr) {
+                break;
+            }
+
+            // Extend the match backward over pending literals.
+            while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+                --ip;
+                --ref;
+            }
+
+            // Extend the match forward.
+            size_t mlen = MIN_MATCH;
+            while (ip + mlen < matchlimit && ip[mlen] == ref[mlen]) {
+                ++mlen;
+            }
+
+            // Emit the sequence: token, literals, offset, match length.
+            const size_t lit = ip - anchor;
+            const size_t ml = mlen - MIN_MATCH;
+            uint8_t* const token = op++;
+            *token = uint8_t((std::min<size_t>(lit, RUN_MASK) << 4) | std::min<size_t>(ml, ML_MASK));
+            if (lit >= RUN_MASK) {
+                op = PutLength(op, lit - RUN_MASK);
+            }
+            ::memcpy(op, anchor, lit);
+            op += lit;
+            const size_t offset = ip - ref;
+            *op++ = uint8_t(offset);
+            *op++ = uint8_t(offset >> 8);
+            if (ml >= ML_MASK) {
+                op = PutLength(op, ml - ML_MASK);
+            }
+
+            ip += mlen;
+            anchor = ip;
+            if (ip < mflimit) {
+                _table[Hash(Read32(ip - 2))] = uint32_t(ip - 2 - src);
+            }
+        }
+    }
+
+    // Last literals.
+    const size_t lit = end - anchor;
+    *op++ = uint8_t(std::min<size_t>(lit, RUN_MASK) << 4);
+    if (lit >= RUN_MASK) {
+        op = PutLength(op, lit - RUN_MASK);
+    }
+    if (lit > 0) {
+        ::memcpy(op, anchor, lit);
+        op += lit;
+    }
+
+    out.resize(op - out.data());
+}
+
+
+//----------------------------------------------------------------------------
+// Decompress a block of data.
+//----------------------------------------------------------------------------
+
+bool ts::LZ4::Decompress(ByteBlock& out, const void* data, size_t size, size_t decompressed_size)
+{
+    out.resize(decompressed_size);
+
+    const uint8_t* ip = reinterpret_cast<const uint8_t*>(data);
+    const uint8_t* const iend = ip + size;
+    uint8_t* const dst = out.data();
+    uint8_t* op = dst;
+    uint8_t* const oend = dst + decompressed_size;
+
+    while (ip < iend) {
+        const uint32_t token = *ip++;
+
+        // Literals.
+        size_t lit = token >> 4;
+        if (lit == RUN_MASK) {
+            uint8_t b = 0;
+            do {
+                if (ip >= iend) {
+                    return false;
+                }
+                b = *ip++;
+                lit += b;
+            } while (b == 255);
+        }
+        if (lit > size_t(iend - ip) || lit > size_t(oend - op)) {
+            return false;
+        }
+        if (lit > 0) {
+            ::memcpy(op, ip, lit);
+            op += lit;
+            ip += lit;
+        }
+
+        // The last sequence has no match.
+        if (ip == iend) {
+            break;
+        }
+
+        // Match.
+        if (iend - ip < 2) {
+            return false;
+        }
+        const size_t offset = size_t(ip[0]) | (size_t(ip[1]) << 8);
+        ip += 2;
+        if (offset == 0 || offset > size_t(op - dst)) {
+            return false;
+        }
+        size_t mlen = token & ML_MASK;
+        if (mlen == ML_MASK) {
+            uint8_t b = 0;
+            do {
+                if (ip >= iend) {
+                    return false;
+                }
+                b = *ip++;
+                mlen += b;
+            } while (b == 255);
+        }
+        mlen += MIN_MATCH;
+        if (mlen > size_t(oend - op)) {
+            return false;
+        }
+        // When the match overlaps the output, copy byte by byte.
+        const uint8_t* ref = op - offset;
+        if (offset >= mlen) {
+            ::memcpy(op, ref, mlen);
+            op += mlen;
+        }
+        else {
+            while (mlen-- > 0) {
+                *op++ = *ref++;
+            }
+        }
+    }
+    return op == oend;
+}
@@ -0,0 +1,89 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  LZ4 block compression.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsByteBlock.h"
+
+namespace ts {
+    //!
+    //! LZ4 block compression.
+    //!
+    //! This class implements the LZ4 block format, without the LZ4 frame
+    //! format. The compressed blocks can be decompressed by any LZ4
+    //! implementation which knows the decompressed size. The compressor is
+    //! the fast greedy one, with a 64 kB window and a 4096-entry hash table.
+    //!
+    //! An instance of this class keeps the hash table of the compressor
+    //! between successive calls. Each block is nevertheless compressed
+    //! independently. The decompressor is stateless.
+    //!
+    class TSDUCKDLL LZ4
+    {
+    public:
+        //!
+        //! Default constructor.
+        //!
+        LZ4();
+
+        //!
+        //! Compress a block of data.
+        //! @param [out] out Compressed data. The previous content is replaced.
+        //! @param [in] data Address of data to compress.
+        //! @param [in] size Size in bytes of data to compress.
+        //!
+        void compress(ByteBlock& out, const void* data, size_t size);
+
+        //!
+        //! Decompress a block of data.
+        //! @param [out] out Decompressed data. The previous content is replaced.
+        //! @param [in] data Address of compressed data.
+        //! @param [in] size Size in bytes of compressed data.
+        //! @param [in] decompressed_size Expected size in bytes of the decompressed data.
+        //! @return True on success, false if the compressed data are invalid or
+        //! do not decompress into exactly @a decompressed_size bytes.
+        //!
+        static bool Decompress(ByteBlock& out, const void* data, size_t size, size_t decompressed_size);
+
+        //!
+        //! Get the maximum size of compressed data, for incompressible input.
+        //! @param [in] size Size in bytes of data to compress.
+        //! @return Maximum size in bytes of the compressed data.
+        //!
+        static size_t MaxCompressedSize(size_t size) { return size + size / 255 + 16; }
+
+    private:
+        std::vector<uint32_t> _table;  // Hash table: offsets of 4-byte sequences in input.
+    };
+}
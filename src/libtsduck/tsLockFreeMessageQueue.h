@@ -0,0 +1,171 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//!
+//!  @file
+//!  Bounded lock-free message queues for inter-thread communication
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsPlatform.h"
+#include "tsSafePtr.h"
+#include "tsMutex.h"
+#include "tsCondition.h"
+#include <atomic>
+
+namespace ts {
+
+    //!
+    //! Template bounded lock-free message queue for inter-thread communication.
+    //!
+    //! This class is a lock-free alternative to ts::MessageQueue with the same
+    //! @c enqueue() and @c dequeue() interface. The messages are stored in a
+    //! preallocated ring of slots, there is no memory allocation in the queue
+    //! after construction. The mutex and conditions are used only when a thread
+    //! must wait for the queue to become non-empty (consumer) or non-full (producers).
+    //!
+    //! There must be only one consumer thread. Depending on @a MULTI_PRODUCER,
+    //! there may be one or several producer threads. Use the ts::SPSCMessageQueue
+    //! and ts::MPSCMessageQueue aliases.
+    //!
+    //! Unlike ts::MessageQueue, the queue is always bounded and its capacity is
+    //! fixed at construction. It cannot be exceptionally overflowed.
+    //!
+    //! @tparam MSG The type of the messages to exchange.
+    //! @tparam MULTI_PRODUCER If true, several threads can enqueue messages concurrently.
+    //! @tparam MUTEX The type of mutex for the synchronization of safe pointers (ts::Mutex by default).
+    //!
+    template <typename MSG, bool MULTI_PRODUCER, class MUTEX = Mutex>
+    class LockFreeMessageQueue
+    {
+    public:
+        //!
+        //! Safe pointer to messages.
+        //!
+        typedef SafePtr<MSG, MUTEX> MessagePtr;
+
+        //!
+        //! Default maximum number of messages in the queue.
+        //!
+        static const size_t DEFAULT_MAX_MESSAGES = 64;
+
+        //!
+        //! Constructor.
+        //!
+        //! @param [in] maxMessages Maximum number of messages in the queue.
+        //! The actual capacity is rounded up to the next power of 2.
+        //! When a thread attempts to enqueue a message and the queue is full,
+        //! the thread waits until at least one message is dequeued.
+        //!
+        LockFreeMessageQueue(size_t maxMessages = DEFAULT_MAX_MESSAGES);
+
+        //!
+        //! Get the maximum allowed messages in the queue.
+        //!
+        //! @return The maximum allowed messages in the queue.
+        //!
+        size_t getMaxMessages() const { return _mask + 1; }
+
+        //!
+        //! Insert a message in the queue.
+        //!
+        //! If the queue is full, the calling thread waits until some space becomes
+        //! available in the queue or the timeout expires.
+        //!
+        //! @param [in] msg The message to enqueue.
+        //! @param [in] timeout Maximum time to wait in milliseconds.
+        //! @return True on success, false on error (queue still full after timeout).
+        //!
+        bool enqueue(const MessagePtr& msg, MilliSecond timeout = Infinite);
+
+        //!
+        //! Remove a message from the queue.
+        //!
+        //! Wait until a message is received or the timeout expires.
+        //! Must be called from the consumer thread only.
+        //!
+        //! @param [out] msg Received message.
+        //! @param [in] timeout Maximum time to wait in milliseconds.
+        //! If @a timeout is zero and the queue is empty, return immediately.
+        //! @return True on success, false on error (queue still empty after timeout).
+        //!
+        bool dequeue(MessagePtr& msg, MilliSecond timeout = Infinite);
+
+    private:
+        LockFreeMessageQueue(const LockFreeMessageQueue&) = delete;
+        LockFreeMessageQueue& operator=(const LockFreeMessageQueue&) = delete;
+
+        // One slot in the ring. The sequence number indicates if the slot is free for
+        // a producer (sequence == position) or contains a message for the consumer
+        // (sequence == position + 1).
+        struct Slot
+        {
+            std::atomic<size_t> sequence;
+            MessagePtr          msg;
+
+            // Constructor:
+            Slot() : sequence(0), msg() {}
+        };
+
+        // Try to insert or remove a message without waiting.
+        bool tryEnqueue(const MessagePtr& msg);
+        bool tryDequeue(MessagePtr& msg);
+
+        // Compute the ring mask from the maximum number of messages.
+        static size_t RingMask(size_t maxMessages);
+
+        // Private members.
+        const size_t        _mask;          // Ring size minus one, the size is a power of 2.
+        std::vector<Slot>   _ring;          // Ring of message slots.
+        std::atomic<size_t> _enqueuePos;    // Next position to write, shared by producers.
+        std::atomic<size_t> _dequeuePos;    // Next position to read, written by the consumer only.
+        std::atomic<bool>   _sleeping;      // The consumer is waiting or about to wait on an empty queue.
+        std::atomic<size_t> _waiting;       // Number of producers waiting on a full queue.
+        Mutex               _mutex;         // Protect the waiting states.
+        Condition           _enqueued;      // Signaled when a message is inserted for a waiting consumer.
+        Condition           _dequeued;      // Signaled when a message is removed for waiting producers.
+    };
+
+    //!
+    //! Bounded lock-free message queue with a single producer and a single consumer.
+    //! @tparam MSG The type of the messages to exchange.
+    //! @tparam MUTEX The type of mutex for the synchronization of safe pointers.
+    //!
+    template <typename MSG, class MUTEX = Mutex>
+    using SPSCMessageQueue = LockFreeMessageQueue<MSG, false, MUTEX>;
+
+    //!
+    //! Bounded lock-free message queue with multiple producers and a single consumer.
+    //! @tparam MSG The type of the messages to exchange.
+    //! @tparam MUTEX The type of mutex for the synchronization of safe pointers.
+    //!
+    template <typename MSG, class MUTEX = Mutex>
+    using MPSCMessageQueue = LockFreeMessageQueue<MSG, true, MUTEX>;
+}
+
+#include "tsLockFreeMessageQueueTemplate.h"
@@ -0,0 +1,239 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//
+//  Bounded lock-free message queues for inter-thread communication
+//
+//----------------------------------------------------------------------------
+
+#include "tsGuardCondition.h"
+#include "tsTime.h"
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+template <typename MSG, bool MULTI_PRODUCER, class MUTEX>
+const size_t ts::LockFreeMessageQueue<MSG, MULTI_PRODUCER, MUTEX>::DEFAULT_MAX_MESSAGES;
+#endif
+
+
+//----------------------------------------------------------------------------
+// Constructor.
+//----------------------------------------------------------------------------
+
+template <typename MSG, bool MULTI_PRODUCER, class MUTEX>
+ts::LockFreeMessageQueue<MSG, MULTI_PRODUCER, MUTEX>::LockFreeMessageQueue(size_t maxMessages) :
+    _mask(RingMask(maxMessages)),
+    _ring(_mask + 1),
+    _enqueuePos(0),
+    _dequeuePos(0),
+    _sleeping(false),
+    _waiting(0),
+    _mutex(),
+    _enqueued(),
+    _dequeued()
+{
+    // Initially, slot N is free for position N.
+    for (size_t i = 0; i < _ring.size(); ++i) {
+        _ring[i].sequence = i;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Compute the ring mask from the maximum number of messages.
+//----------------------------------------------------------------------------
+
+template <typename MSG, bool MULTI_PRODUCER, class MUTEX>
+size_t ts::LockFreeMessageQueue<MSG, MULTI_PRODUCER, MUTEX>::RingMask(size_t maxMessages)
+{
+    size_t size = 2;
+    while (size < maxMessages) {
+        size *= 2;
+    }
+    return size - 1;
+}
+
+
+//----------------------------------------------------------------------------
+// Try to insert a message without waiting.
+//----------------------------------------------------------------------------
+
+template <typename MSG, bool MULTI_PRODUCER, class MUTEX>
+bool ts::LockFreeMessageQueue<MSG, MULTI_PRODUCER, MUTEX>::tryEnqueue(const MessagePtr& msg)
+{
+    size_t pos = _enqueuePos.load(std::memory_order_relaxed);
+    for (;;) {
+        Slot& slot(_ring[pos & _mask]);
+        const size_t seq = slot.sequence.load(std::memory_order_acquire);
+        if (seq == pos) {
+            // The slot is free. With a single producer, nobody else can take it.
+            // With multiple producers, try to reserve it. On failure, pos is reloaded.
+            if (!MULTI_PRODUCER) {
+                _enqueuePos.store(pos + 1, std::memory_order_relaxed);
+            }
+            else if (!_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                continue;
+            }
+            slot.msg = msg;
+            slot.sequence.store(pos + 1, std::memory_order_release);
+            break;
+        }
+        else if (seq < pos + 1) {
+            // The slot still contains the message of the previous round, the ring is full.
+            return false;
+        }
+        else {
+            // Another producer got this position.
+            pos = _enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    // Wake up the consumer if it is waiting. The fence orders the publication of
+    // the message before the check of the sleeping state. The consumer sets the
+    // sleeping state before checking the ring.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_sleeping) {
+        GuardCondition lock(_mutex, _enqueued);
+        lock.signal();
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Try to remove a message without waiting.
+//----------------------------------------------------------------------------
+
+template <typename MSG, bool MULTI_PRODUCER, class MUTEX>
+bool ts::LockFreeMessageQueue<MSG, MULTI_PRODUCER, MUTEX>::tryDequeue(MessagePtr& msg)
+{
+    const size_t pos = _dequeuePos.load(std::memory_order_relaxed);
+    Slot& slot(_ring[pos & _mask]);
+    if (slot.sequence.load(std::memory_order_acquire) != pos + 1) {
+        return false; // queue empty
+    }
+
+    // Get the message and free the slot for the next round.
+    msg = slot.msg;
+    slot.msg.clear();
+    slot.sequence.store(pos + _mask + 1, std::memory_order_release);
+    _dequeuePos.store(pos + 1, std::memory_order_relaxed);
+
+    // Wake up a producer which waits for a free slot.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_waiting > 0) {
+        GuardCondition lock(_mutex, _dequeued);
+        lock.signal();
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Insert a message in the queue with a timeout.
+//----------------------------------------------------------------------------
+
+template <typename MSG, bool MULTI_PRODUCER, class MUTEX>
+bool ts::LockFreeMessageQueue<MSG, MULTI_PRODUCER, MUTEX>::enqueue(const MessagePtr& msg, MilliSecond timeout)
+{
+    // Fast path, no lock.
+    if (tryEnqueue(msg)) {
+        return true;
+    }
+    else if (timeout <= 0) {
+        return false;
+    }
+
+    // The queue is full, wait for a message to be dequeued.
+    GuardCondition lock(_mutex, _dequeued);
+    _waiting++;
+    bool done = false;
+    Time start(Time::CurrentUTC());
+    while (!(done = tryEnqueue(msg))) {
+
+        // Reduce timeout
+        if (timeout != Infinite) {
+            const Time now(Time::CurrentUTC());
+            timeout -= now - start;
+            start = now;
+            if (timeout <= 0) {
+                break; // timeout
+            }
+        }
+
+        // Temporarily release mutex and wait for dequeued condition.
+        // Since _waiting is set, the consumer signals after each dequeue.
+        if (!lock.waitCondition(timeout)) {
+            done = tryEnqueue(msg);
+            break; // timeout
+        }
+    }
+    _waiting--;
+    return done;
+}
+
+
+//----------------------------------------------------------------------------
+// Remove a message from the queue.
+//----------------------------------------------------------------------------
+
+template <typename MSG, bool MULTI_PRODUCER, class MUTEX>
+bool ts::LockFreeMessageQueue<MSG, MULTI_PRODUCER, MUTEX>::dequeue(MessagePtr& msg, MilliSecond timeout)
+{
+    // Fast path, no lock.
+    if (tryDequeue(msg)) {
+        return true;
+    }
+    else if (timeout <= 0) {
+        return false;
+    }
+
+    // The queue is empty, wait for a message to be enqueued.
+    GuardCondition lock(_mutex, _enqueued);
+    _sleeping = true;
+    bool done = false;
+    Time start(Time::CurrentUTC());
+    while (!(done = tryDequeue(msg))) {
+
+        // Reduce timeout
+        if (timeout != Infinite) {
+            const Time now(Time::CurrentUTC());
+            timeout -= now - start;
+            start = now;
+            if (timeout <= 0) {
+                break; // timeout
+            }
+        }
+
+        // Temporarily release mutex and wait for enqueued condition.
+        if (!lock.waitCondition(timeout)) {
+            done = tryDequeue(msg);
+            break; // timeout
+        }
+    }
+    _sleeping = false;
+    return done;
+}
@@ -0,0 +1,149 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+
+#include "tsLogLimiter.h"
+#include "tsCoarseClock.h"
+TSDUCK_SOURCE;
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::LogLimiter::DEFAULT_MAX_MESSAGES;
+const ts::MilliSecond ts::LogLimiter::DEFAULT_INTERVAL;
+#endif
+
+
+//----------------------------------------------------------------------------
+// Constructors.
+//----------------------------------------------------------------------------
+
+ts::LogLimiter::LogLimiter(Report& report, const UString& key_name, size_t max_messages, MilliSecond interval) :
+    _report(report),
+    _key_name(key_name),
+    _prefix(),
+    _max_messages(max_messages),
+    _interval(interval * NanoSecPerMilliSec),
+    _suppressed(0),
+    _keys()
+{
+}
+
+ts::LogLimiter::KeyContext::KeyContext() :
+    count(0),
+    start(0),
+    severity(Severity::Info)
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Set the limits of logging.
+//----------------------------------------------------------------------------
+
+void ts::LogLimiter::setLimits(size_t max_messages, MilliSecond interval)
+{
+    _max_messages = max_messages;
+    _interval = interval * NanoSecPerMilliSec;
+}
+
+
+//----------------------------------------------------------------------------
+// Check if a message can be logged.
+//----------------------------------------------------------------------------
+
+bool ts::LogLimiter::allow(uint32_t key, int severity)
+{
+    if (severity > _report.maxSeverity()) {
+        return false;
+    }
+    else if (_max_messages == 0) {
+        return true;
+    }
+
+    // The coarse clock is cheap enough to be read on each message.
+    const NanoSecond now = CoarseClock::CoarseNanoSeconds();
+    KeyContext& kc(_keys[key]);
+
+    if (kc.count == 0) {
+        // First message of a new window.
+        kc.start = now;
+    }
+    else if (now < kc.start || now - kc.start >= _interval) {
+        // End of previous window.
+        summary(key, kc, now);
+    }
+
+    if (++kc.count <= _max_messages) {
+        return true;
+    }
+    else {
+        kc.severity = severity;
+        _suppressed++;
+        return false;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Report the summary of a key and start a new window.
+//----------------------------------------------------------------------------
+
+void ts::LogLimiter::summary(uint32_t key, KeyContext& kc, NanoSecond now)
+{
+    if (kc.count > _max_messages) {
+        const size_t more = kc.count - _max_messages;
+        const MilliSecond ms = (now - kc.start) / NanoSecPerMilliSec;
+        if (_key_name.empty()) {
+            _report.log(kc.severity, u"%s%'d more similar messages in last %'d ms", {_prefix, more, ms});
+        }
+        else {
+            // Keys are typically PID's, displayed as 16-bit values.
+            if (key <= 0xFFFF) {
+                _report.log(kc.severity, u"%s%'d more similar messages for %s 0x%X (%d) in last %'d ms", {_prefix, more, _key_name, uint16_t(key), key, ms});
+            }
+            else {
+                _report.log(kc.severity, u"%s%'d more similar messages for %s 0x%X (%d) in last %'d ms", {_prefix, more, _key_name, key, key, ms});
+            }
+        }
+    }
+    kc.count = 0;
+    kc.start = now;
+}
+
+
+//----------------------------------------------------------------------------
+// Report the summaries of all suppressed messages.
+//----------------------------------------------------------------------------
+
+void ts::LogLimiter::flush()
+{
+    const NanoSecond now = CoarseClock::CoarseNanoSeconds();
+    for (KeyContextMap::iterator it = _keys.begin(); it != _keys.end(); ++it) {
+        summary(it->first, it->second, now);
+    }
+    _keys.clear();
+}
@@ -0,0 +1,192 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Rate-limited logging of repetitive messages.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsReport.h"
+
+namespace ts {
+    //!
+    //! Rate-limited logging of repetitive messages, typically on per-packet error paths.
+    //!
+    //! Messages are grouped by a key, typically a PID or a message site. In each time window,
+    //! the first messages of a key are logged. The next ones are not even formatted, they are
+    //! only counted. The number of suppressed messages in the window is reported when the next
+    //! message with the same key is logged after the end of the window or when flush() is called.
+    //!
+    //! An instance of this class is not thread-safe. Each thread or plugin uses its own instance.
+    //!
+    class TSDUCKDLL LogLimiter
+    {
+    public:
+        //!
+        //! Default maximum number of logged messages per key and per window.
+        //!
+        static const size_t DEFAULT_MAX_MESSAGES = 10;
+
+        //!
+        //! Default duration of a window in milliseconds.
+        //!
+        static const MilliSecond DEFAULT_INTERVAL = 1000;
+
+        //!
+        //! Constructor.
+        //! @param [in] report Where to log the messages.
+        //! @param [in] key_name Name of the key in summary messages, typically "PID".
+        //! When empty, the key is not displayed.
+        //! @param [in] max_messages Maximum number of logged messages per key and per window.
+        //! Zero means no limit.
+        //! @param [in] interval Duration of a window in milliseconds.
+        //!
+        explicit LogLimiter(Report& report,
+                            const UString& key_name = UString(),
+                            size_t max_messages = DEFAULT_MAX_MESSAGES,
+                            MilliSecond interval = DEFAULT_INTERVAL);
+
+        //!
+        //! Destructor.
+        //! The pending summaries are not reported, use flush() first.
+        //!
+        ~LogLimiter() {}
+
+        //!
+        //! Set the limits of logging.
+        //! @param [in] max_messages Maximum number of logged messages per key and per window.
+        //! Zero means no limit.
+        //! @param [in] interval Duration of a window in milliseconds.
+        //!
+        void setLimits(size_t max_messages, MilliSecond interval);
+
+        //!
+        //! Set the prefix of summary messages.
+        //! @param [in] prefix The prefix to prepend to summary messages.
+        //!
+        void setPrefix(const UString& prefix) { _prefix = prefix; }
+
+        //!
+        //! Report a message with a printf-like interface, if the limit of its key is not reached.
+        //! @param [in] key Message key, typically a PID.
+        //! @param [in] severity Message severity.
+        //! @param [in] fmt Format string with embedded '\%' sequences.
+        //! @param [in] args List of arguments to substitute in the format string.
+        //! @see UString::format()
+        //!
+        void log(uint32_t key, int severity, const UChar* fmt, const std::initializer_list<ArgMixIn>& args)
+        {
+            if (severity <= _report.maxSeverity() && allow(key, severity)) {
+                _report.log(severity, fmt, args);
+            }
+        }
+
+        //!
+        //! Report an error message, if the limit of its key is not reached.
+        //! @param [in] key Message key, typically a PID.
+        //! @param [in] fmt Format string with embedded '\%' sequences.
+        //! @param [in] args List of arguments to substitute in the format string.
+        //!
+        void error(uint32_t key, const UChar* fmt, const std::initializer_list<ArgMixIn>& args) { log(key, Severity::Error, fmt, args); }
+
+        //!
+        //! Report a warning message, if the limit of its key is not reached.
+        //! @param [in] key Message key, typically a PID.
+        //! @param [in] fmt Format string with embedded '\%' sequences.
+        //! @param [in] args List of arguments to substitute in the format string.
+        //!
+        void warning(uint32_t key, const UChar* fmt, const std::initializer_list<ArgMixIn>& args) { log(key, Severity::Warning, fmt, args); }
+
+        //!
+        //! Report an informational message, if the limit of its key is not reached.
+        //! @param [in] key Message key, typically a PID.
+        //! @param [in] fmt Format string with embedded '\%' sequences.
+        //! @param [in] args List of arguments to substitute in the format string.
+        //!
+        void info(uint32_t key, const UChar* fmt, const std::initializer_list<ArgMixIn>& args) { log(key, Severity::Info, fmt, args); }
+
+        //!
+        //! Report a debug message, if the limit of its key is not reached.
+        //! @param [in] key Message key, typically a PID.
+        //! @param [in] fmt Format string with embedded '\%' sequences.
+        //! @param [in] args List of arguments to substitute in the format string.
+        //!
+        void debug(uint32_t key, const UChar* fmt, const std::initializer_list<ArgMixIn>& args) { log(key, Severity::Debug, fmt, args); }
+
+        //!
+        //! Check if a message can be logged and count it.
+        //! This is useful when building the message arguments is expensive.
+        //! When the message can be logged, it shall be directly logged on the Report.
+        //! The summary of the previous window of the key is reported first if necessary.
+        //! @param [in] key Message key, typically a PID.
+        //! @param [in] severity Message severity.
+        //! @return True if the message shall be logged, false if it is suppressed or filtered by severity.
+        //!
+        bool allow(uint32_t key, int severity);
+
+        //!
+        //! Report the summaries of all suppressed messages and reset all windows.
+        //!
+        void flush();
+
+        //!
+        //! Get the total number of suppressed messages since the creation of this object.
+        //! @return The total number of suppressed messages.
+        //!
+        uint64_t suppressedCount() const { return _suppressed; }
+
+    private:
+        // Description of a key.
+        struct KeyContext
+        {
+            size_t     count;      // Number of messages in current window, logged or not
+            NanoSecond start;      // Start time of current window
+            int        severity;   // Severity of last suppressed message
+            KeyContext();
+        };
+        typedef std::map<uint32_t, KeyContext> KeyContextMap;
+
+        Report&       _report;
+        UString       _key_name;
+        UString       _prefix;
+        size_t        _max_messages;
+        NanoSecond    _interval;
+        uint64_t      _suppressed;
+        KeyContextMap _keys;
+
+        // Report the summary of a key and start a new window.
+        void summary(uint32_t key, KeyContext& kc, NanoSecond now);
+
+        // Inaccessible operations.
+        LogLimiter() = delete;
+        LogLimiter(const LogLimiter&) = delete;
+        LogLimiter& operator=(const LogLimiter&) = delete;
+    };
+}
@@ -0,0 +1,258 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+
+#include "tsMemoryMappedFile.h"
+#include "tsSysUtils.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// Constructors and destructors.
+//----------------------------------------------------------------------------
+
+ts::MemoryMappedFile::MemoryMappedFile() :
+    _is_open(false),
+    _writable(false),
+    _data(0),
+    _size(0)
+#if defined(TS_WINDOWS)
+    , _file(INVALID_HANDLE_VALUE),
+    _mapping(NULL)
+#endif
+{
+}
+
+ts::MemoryMappedFile::~MemoryMappedFile()
+{
+    close();
+}
+
+
+//----------------------------------------------------------------------------
+// Map a complete file in memory.
+//----------------------------------------------------------------------------
+
+bool ts::MemoryMappedFile::open(const UString& file_name, Report& report, bool writable)
+{
+    close();
+
+    const int64_t size = GetFileSize(file_name);
+    if (size < 0) {
+        report.error(u"cannot open %s", {file_name});
+        return false;
+    }
+    if (uint64_t(size) > uint64_t(std::numeric_limits<size_t>::max())) {
+        report.error(u"file %s is too large to be mapped in memory", {file_name});
+        return false;
+    }
+    if (size == 0) {
+        // Nothing to map in an empty file.
+        _is_open = true;
+        return true;
+    }
+
+#if defined(TS_WINDOWS)
+
+    _file = ::CreateFile(file_name.toUTF8().c_str(), writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (_file == INVALID_HANDLE_VALUE) {
+        const ErrorCode error_code = LastErrorCode();
+        report.error(u"cannot open %s: %s", {file_name, ErrorCodeMessage(error_code)});
+        return false;
+    }
+    _mapping = ::CreateFileMapping(_file, NULL, writable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, NULL);
+    void* const addr = _mapping == NULL ? NULL : ::MapViewOfFile(_mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size_t(size));
+    if (addr == NULL) {
+        const ErrorCode error_code = LastErrorCode();
+        report.error(u"cannot map %s in memory: %s", {file_name, ErrorCodeMessage(error_code)});
+        close();
+        return false;
+    }
+
+#else
+
+    const int fd = ::open(file_name.toUTF8().c_str(), (writable ? O_RDWR : O_RDONLY) | O_LARGEFILE);
+    if (fd < 0) {
+        const ErrorCode error_code = LastErrorCode();
+        report.error(u"cannot open %s: %s", {file_name, ErrorCodeMessage(error_code)});
+        return false;
+    }
+
+    // The mapping remains valid after closing the file descriptor.
+    void* const addr = ::mmap(0, size_t(size), writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    const ErrorCode error_code = LastErrorCode();
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        report.error(u"cannot map %s in memory: %s", {file_name, ErrorCodeMessage(error_code)});
+        return false;
+    }
+
+    // Mapped files are typically accessed at random offsets.
+    ::madvise(addr, size_t(size), MADV_RANDOM);
+
+#endif
+
+    _is_open = true;
+    _writable = writable;
+    _data = reinterpret_cast<const uint8_t*>(addr);
+    _size = size_t(size);
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Create a file with a preallocated size and map it in read-write mode.
+//----------------------------------------------------------------------------
+
+bool ts::MemoryMappedFile::create(const UString& file_name, size_t size, Report& report)
+{
+    close();
+
+    if (size == 0) {
+        report.error(u"cannot map an empty file %s in memory", {file_name});
+        return false;
+    }
+
+#if defined(TS_WINDOWS)
+
+    _file = ::CreateFile(file_name.toUTF8().c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (_file == INVALID_HANDLE_VALUE) {
+        const ErrorCode error_code = LastErrorCode();
+        report.error(u"cannot create %s: %s", {file_name, ErrorCodeMessage(error_code)});
+        return false;
+    }
+    // The file is extended to the size of the mapping.
+    const uint64_t size64 = uint64_t(size);
+    _mapping = ::CreateFileMapping(_file, NULL, PAGE_READWRITE, ::DWORD(size64 >> 32), ::DWORD(size64), NULL);
+    void* const addr = _mapping == NULL ? NULL : ::MapViewOfFile(_mapping, FILE_MAP_WRITE, 0, 0, size);
+    if (addr == NULL) {
+        const ErrorCode error_code = LastErrorCode();
+        report.error(u"cannot map %s in memory: %s", {file_name, ErrorCodeMessage(error_code)});
+        close();
+        return false;
+    }
+
+#else
+
+    const int fd = ::open(file_name.toUTF8().c_str(), O_RDWR | O_CREAT | O_TRUNC | O_LARGEFILE, 0666);
+    if (fd < 0) {
+        const ErrorCode error_code = LastErrorCode();
+        report.error(u"cannot create %s: %s", {file_name, ErrorCodeMessage(error_code)});
+        return false;
+    }
+
+    // Allocate the disk space now, to avoid failures when pages are written back.
+#if defined(TS_LINUX)
+    const int alloc_error = ::posix_fallocate(fd, 0, off_t(size));
+#else
+    const int alloc_error = ::ftruncate(fd, off_t(size)) < 0 ? LastErrorCode() : 0;
+#endif
+    if (alloc_error != 0) {
+        report.error(u"cannot allocate %'d bytes for %s: %s", {size, file_name, ErrorCodeMessage(alloc_error)});
+        ::close(fd);
+        return false;
+    }
+
+    void* const addr = ::mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    const ErrorCode error_code = LastErrorCode();
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        report.error(u"cannot map %s in memory: %s", {file_name, ErrorCodeMessage(error_code)});
+        return false;
+    }
+
+#endif
+
+    _is_open = true;
+    _writable = true;
+    _data = reinterpret_cast<const uint8_t*>(addr);
+    _size = size;
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Advise the system that a range of the file will be accessed soon.
+//----------------------------------------------------------------------------
+
+void ts::MemoryMappedFile::prefetch(size_t offset, size_t size) const
+{
+#if !defined(TS_WINDOWS)
+    if (_data != 0 && offset < _size) {
+        // madvise() requires a page-aligned address.
+        static const size_t page_size = size_t(::sysconf(_SC_PAGESIZE));
+        const size_t start = offset - offset % page_size;
+        size = std::min(size + offset - start, _size - start);
+        ::madvise(const_cast<uint8_t*>(_data) + start, size, MADV_WILLNEED);
+    }
+#endif
+}
+
+
+//----------------------------------------------------------------------------
+// Advise the system that the file will be accessed sequentially.
+//----------------------------------------------------------------------------
+
+void ts::MemoryMappedFile::adviseSequential() const
+{
+#if !defined(TS_WINDOWS)
+    if (_data != 0) {
+        ::madvise(const_cast<uint8_t*>(_data), _size, MADV_SEQUENTIAL);
+    }
+#endif
+}
+
+
+//----------------------------------------------------------------------------
+// Unmap the file.
+//----------------------------------------------------------------------------
+
+void ts::MemoryMappedFile::close()
+{
+#if defined(TS_WINDOWS)
+    if (_data != 0) {
+        ::UnmapViewOfFile(_data);
+    }
+    if (_mapping != NULL) {
+        ::CloseHandle(_mapping);
+        _mapping = NULL;
+    }
+    if (_file != INVALID_HANDLE_VALUE) {
+        ::CloseHandle(_file);
+        _file = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (_data != 0) {
+        ::munmap(const_cast<uint8_t*>(_data), _size);
+    }
+#endif
+    _is_open = false;
+    _writable = false;
+    _data = 0;
+    _size = 0;
+}
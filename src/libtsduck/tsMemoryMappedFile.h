@@ -0,0 +1,152 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Memory-mapped file
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsUString.h"
+#include "tsReport.h"
+
+namespace ts {
+    //!
+    //! A complete file which is mapped in memory.
+    //! Typically used to access large data files at random offsets without reading them.
+    //! An existing file is mapped in read-only mode or in read-write mode to be modified
+    //! in place. A new file can be created with a preallocated size and mapped in read-write mode.
+    //!
+    class TSDUCKDLL MemoryMappedFile
+    {
+    public:
+        //!
+        //! Default constructor.
+        //!
+        MemoryMappedFile();
+
+        //!
+        //! Destructor, unmap the file.
+        //!
+        ~MemoryMappedFile();
+
+        //!
+        //! Map a complete file in memory.
+        //! A previously mapped file is first unmapped.
+        //! @param [in] file_name File name.
+        //! @param [in,out] report Where to report errors.
+        //! @param [in] writable If true, the file is mapped in read-write mode and all
+        //! modifications in memory are written back to the file.
+        //! @return True on success, false on error.
+        //!
+        bool open(const UString& file_name, Report& report, bool writable = false);
+
+        //!
+        //! Create a file with a preallocated size and map it in memory in read-write mode.
+        //! An existing file is overwritten. A previously mapped file is first unmapped.
+        //! The file content is not locked in memory, the system pages it in and out.
+        //! @param [in] file_name File name.
+        //! @param [in] size File size in bytes, must not be zero.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on error.
+        //!
+        bool create(const UString& file_name, size_t size, Report& report);
+
+        //!
+        //! Unmap the file.
+        //!
+        void close();
+
+        //!
+        //! Advise the system that a range of the file will be accessed soon.
+        //! The system may start reading it in advance. This is only a hint.
+        //! @param [in] offset Start offset in the file.
+        //! @param [in] size Size of the range in bytes.
+        //!
+        void prefetch(size_t offset, size_t size) const;
+
+        //!
+        //! Advise the system that the file will be accessed sequentially.
+        //! By default, a mapped file is assumed to be accessed at random offsets.
+        //! With sequential access, the system reads ahead and quickly drops the pages
+        //! which were already accessed. This is only a hint.
+        //!
+        void adviseSequential() const;
+
+        //!
+        //! Check if a file is mapped.
+        //! @return True if a file is mapped, even if it is empty.
+        //!
+        bool isOpen() const
+        {
+            return _is_open;
+        }
+
+        //!
+        //! Get the address of the mapped file content.
+        //! @return The address of the file content or a null pointer if the file is not mapped or empty.
+        //!
+        const uint8_t* data() const
+        {
+            return _data;
+        }
+
+        //!
+        //! Get the address of the mapped file content for modification.
+        //! @return The address of the file content or a null pointer if the file is not mapped or read-only.
+        //!
+        uint8_t* writableData() const
+        {
+            return _writable ? const_cast<uint8_t*>(_data) : 0;
+        }
+
+        //!
+        //! Get the size of the mapped file.
+        //! @return The file size in bytes.
+        //!
+        size_t size() const
+        {
+            return _size;
+        }
+
+    private:
+        bool           _is_open;  //!< A file is mapped.
+        bool           _writable; //!< The file is mapped in read-write mode.
+        const uint8_t* _data;     //!< Address of the file content.
+        size_t         _size;     //!< File size.
+#if defined(TS_WINDOWS)
+        ::HANDLE       _file;     //!< File handle.
+        ::HANDLE       _mapping;  //!< File mapping handle.
+#endif
+
+        // Inaccessible operations.
+        MemoryMappedFile(const MemoryMappedFile&) = delete;
+        MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+    };
+}
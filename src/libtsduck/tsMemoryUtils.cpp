@@ -34,6 +34,19 @@
 #include "tsMemoryUtils.h"
 TSDUCK_SOURCE;
 
+// SSE2 is always available on x86_64 and on i386 when the compiler is allowed to use it.
+// NEON is always available on ARM64. No runtime check is needed in both cases.
+#if !defined(TS_NO_VECTOR_INSTRUCTIONS) && (defined(TS_X86_64) || (defined(TS_I386) && (defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))))
+    #define TS_MEMUTILS_SSE2 1
+    #include <emmintrin.h>
+    #if defined(TS_MSC)
+        #include <intrin.h>
+    #endif
+#elif !defined(TS_NO_VECTOR_INSTRUCTIONS) && defined(TS_ARM64) && (defined(TS_GCC) || defined(TS_LLVM))
+    #define TS_MEMUTILS_NEON 1
+    #include <arm_neon.h>
+#endif
+
 
 //----------------------------------------------------------------------------
 // Check if a memory area starts with the specified prefix
@@ -70,6 +83,165 @@ const void* ts::LocatePattern (const void* area, size_t area_size, const void* p
     return 0; // not found
 }
 
+
+//----------------------------------------------------------------------------
+// Locate a 3-byte pattern 00 00 XX into a memory area. Return 0 if not found
+//----------------------------------------------------------------------------
+
+const void* ts::LocateZeroZero(const void* area, size_t area_size, uint8_t third)
+{
+    const uint8_t* const base = reinterpret_cast<const uint8_t*>(area);
+    size_t i = 0;
+
+#if defined(TS_MEMUTILS_SSE2)
+
+    // Compare 16 positions at a time: byte[i] == 0 and byte[i+1] == 0.
+    const __m128i zero = _mm_setzero_si128();
+    while (i + 18 <= area_size) {
+        const __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(base + i));
+        const __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(base + i + 1));
+        unsigned int mask = unsigned(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(v0, zero), _mm_cmpeq_epi8(v1, zero))));
+        while (mask != 0) {
+    #if defined(TS_MSC)
+            unsigned long bit = 0;
+            _BitScanForward(&bit, mask);
+    #else
+            const unsigned int bit = unsigned(__builtin_ctz(mask));
+    #endif
+            if (base[i + bit + 2] == third) {
+                return base + i + bit;
+            }
+            mask &= mask - 1;
+        }
+        i += 16;
+    }
+
+#elif defined(TS_MEMUTILS_NEON)
+
+    // Skip 16 positions at a time when there is no 00 00 pair.
+    while (i + 18 <= area_size) {
+        const uint8x16_t v0 = vceqzq_u8(vld1q_u8(base + i));
+        const uint8x16_t v1 = vceqzq_u8(vld1q_u8(base + i + 1));
+        if (vmaxvq_u8(vandq_u8(v0, v1)) != 0) {
+            for (size_t end = i + 16; i < end; ++i) {
+                if (base[i] == 0 && base[i + 1] == 0 && base[i + 2] == third) {
+                    return base + i;
+                }
+            }
+        }
+        else {
+            i += 16;
+        }
+    }
+
+#endif
+
+    // Remaining bytes, or whole area without vector instructions.
+    while (i + 3 <= area_size) {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(::memchr(base + i, 0, area_size - i - 2));
+        if (p == 0) {
+            break;
+        }
+        i = p - base;
+        if (p[1] != 0) {
+            i += 2;
+        }
+        else if (p[2] == third) {
+            return p;
+        }
+        else {
+            ++i;
+        }
+    }
+    return 0; // not found
+}
+
+//----------------------------------------------------------------------------
+// Locate a sequence of packets with a periodic sync byte. Return 0 if not found
+//----------------------------------------------------------------------------
+
+const void* ts::LocateSyncBytes(const void* area, size_t area_size, size_t pkt_size, size_t header_size, size_t min_packets, uint8_t sync)
+{
+    if (header_size >= pkt_size || area_size < min_packets * pkt_size) {
+        return 0;
+    }
+    if (min_packets == 0) {
+        return area;
+    }
+
+    // Candidate offsets are all offsets in 0..last, the sync bytes of the
+    // packets of a candidate are at candidate + header_size + k * pkt_size.
+    const uint8_t* const base = reinterpret_cast<const uint8_t*>(area) + header_size;
+    const size_t last = area_size - min_packets * pkt_size;
+
+    // Check candidates by blocks of pkt_size consecutive offsets. In each block,
+    // the sync bytes of all candidates are in the same rows of pkt_size bytes.
+    for (size_t block = 0; block <= last; block += pkt_size) {
+        const size_t width = std::min(pkt_size, last - block + 1);
+        size_t i = 0;
+
+#if defined(TS_MEMUTILS_SSE2)
+
+        // Check 16 candidates at a time, stop as soon as none of them is still valid.
+        const __m128i vsync = _mm_set1_epi8(char(sync));
+        for (; i + 16 <= width; i += 16) {
+            const uint8_t* row = base + block + i;
+            unsigned int mask = 0xFFFF;
+            for (size_t k = 0; mask != 0 && k < min_packets; ++k, row += pkt_size) {
+                mask &= unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row)), vsync)));
+            }
+            if (mask != 0) {
+    #if defined(TS_MSC)
+                unsigned long bit = 0;
+                _BitScanForward(&bit, mask);
+    #else
+                const unsigned int bit = unsigned(__builtin_ctz(mask));
+    #endif
+                return base + block + i + bit - header_size;
+            }
+        }
+
+#elif defined(TS_MEMUTILS_NEON)
+
+        // Check 16 candidates at a time, stop as soon as none of them is still valid.
+        const uint8x16_t vsync = vdupq_n_u8(sync);
+        for (; i + 16 <= width; i += 16) {
+            const uint8_t* row = base + block + i;
+            uint8x16_t valid = vceqq_u8(vld1q_u8(row), vsync);
+            for (size_t k = 1; k < min_packets && vmaxvq_u8(valid) != 0; ++k) {
+                row += pkt_size;
+                valid = vandq_u8(valid, vceqq_u8(vld1q_u8(row), vsync));
+            }
+            if (vmaxvq_u8(valid) != 0) {
+                uint8_t flags[16];
+                vst1q_u8(flags, valid);
+                for (size_t bit = 0; bit < 16; ++bit) {
+                    if (flags[bit] != 0) {
+                        return base + block + i + bit - header_size;
+                    }
+                }
+            }
+        }
+
+#endif
+
+        // Remaining candidates in the block, or whole block without vector instructions.
+        for (; i < width; ++i) {
+            const uint8_t* row = base + block + i;
+            size_t k = 0;
+            while (k < min_packets && *row == sync) {
+                ++k;
+                row += pkt_size;
+            }
+            if (k == min_packets) {
+                return base + block + i - header_size;
+            }
+        }
+    }
+    return 0; // not found
+}
+
+
 //----------------------------------------------------------------------------
 // Check if a memory area contains all identical byte values.
 //----------------------------------------------------------------------------
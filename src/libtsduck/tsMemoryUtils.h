@@ -77,6 +77,36 @@ namespace ts {
     //!
     TSDUCKDLL const void* LocatePattern(const void* area, size_t area_size, const void* pattern, size_t pattern_size);
 
+    //!
+    //! Locate a 3-byte pattern 00 00 @a third into a memory area.
+    //! This is typically used to locate start code prefixes (00 00 01) in video streams.
+    //! This is faster than LocatePattern() since the search for the two leading zeroes
+    //! uses the vector instructions of the processor when available (SSE2 on Intel,
+    //! NEON on ARM64) or memchr() otherwise.
+    //! @param [in] area Address of a memory area to check.
+    //! @param [in] area_size Size in bytes of the memory area.
+    //! @param [in] third Value of the third byte of the pattern.
+    //! @return Address of the first occurence of the pattern in @a area or zero if not found.
+    //!
+    TSDUCKDLL const void* LocateZeroZero(const void* area, size_t area_size, uint8_t third);
+
+    //!
+    //! Locate a sequence of contiguous packets with a periodic sync byte into a memory area.
+    //! The search uses the vector instructions of the processor when available (SSE2 on
+    //! Intel, NEON on ARM64) to check the sync byte periodicity on 16 offsets at a time.
+    //! @param [in] area Address of a memory area to check.
+    //! @param [in] area_size Size in bytes of the memory area.
+    //! @param [in] pkt_size Size in bytes of each packet (e.g. 188, 192, 204).
+    //! @param [in] header_size Offset of the sync byte inside each packet (e.g. 4 in M2TS files).
+    //! Must be lower than @a pkt_size.
+    //! @param [in] min_packets Required number of contiguous packets. The sequence of packets
+    //! must entirely fit in @a area.
+    //! @param [in] sync Value of the sync byte, 0x47 in MPEG transport streams.
+    //! @return Address of the first packet in the first sequence of @a min_packets packets
+    //! with @a sync at offset @a header_size or zero if not found.
+    //!
+    TSDUCKDLL const void* LocateSyncBytes(const void* area, size_t area_size, size_t pkt_size, size_t header_size, size_t min_packets, uint8_t sync = 0x47);
+
     //!
     //! Check if a memory area contains all identical byte values.
     //! @param [in] area Address of a memory area to check.
@@ -0,0 +1,237 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "tsMetrics.h"
+#include "tsGuard.h"
+TSDUCK_SOURCE;
+
+TS_DEFINE_SINGLETON(ts::MetricsRegistry);
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::MetricCounter::SHARDS;
+#endif
+
+
+//----------------------------------------------------------------------------
+// Metric base class.
+//----------------------------------------------------------------------------
+
+ts::Metric::Metric(Type type, const UString& name, const UString& help, const Labels& labels) :
+    _type(type),
+    _name(name),
+    _help(help),
+    _labels(labels)
+{
+}
+
+ts::Metric::~Metric()
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Counters.
+//----------------------------------------------------------------------------
+
+ts::MetricCounter::MetricCounter(const UString& name, const UString& help, const Labels& labels) :
+    Metric(COUNTER, name, help, labels),
+    _shards()
+{
+}
+
+int64_t ts::MetricCounter::value() const
+{
+    uint64_t total = 0;
+    for (size_t i = 0; i < SHARDS; ++i) {
+        total += _shards[i].value.load(std::memory_order_relaxed);
+    }
+    return int64_t(total);
+}
+
+size_t ts::MetricCounter::ShardIndex()
+{
+    // Threads are assigned to shards in a round-robin way, on first use.
+    static std::atomic<size_t> next_shard(0);
+    static thread_local size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+    return shard;
+}
+
+
+//----------------------------------------------------------------------------
+// Gauges.
+//----------------------------------------------------------------------------
+
+ts::MetricGauge::MetricGauge(const UString& name, const UString& help, const Labels& labels) :
+    Metric(GAUGE, name, help, labels),
+    _value(0)
+{
+}
+
+int64_t ts::MetricGauge::value() const
+{
+    return _value.load(std::memory_order_relaxed);
+}
+
+
+//----------------------------------------------------------------------------
+// Registry constructor and destructor.
+//----------------------------------------------------------------------------
+
+ts::MetricsRegistry::MetricsRegistry() :
+    _mutex(),
+    _metrics()
+{
+}
+
+ts::MetricsRegistry::~MetricsRegistry()
+{
+    Guard lock(_mutex);
+    for (MetricMap::iterator it = _metrics.begin(); it != _metrics.end(); ++it) {
+        delete it->second;
+    }
+    _metrics.clear();
+}
+
+
+//----------------------------------------------------------------------------
+// Build the key of a metric: name{label=value,...}
+//----------------------------------------------------------------------------
+
+ts::UString ts::MetricsRegistry::Key(const UString& name, const Metric::Labels& labels)
+{
+    UString key(name);
+    key.append(u'{');
+    for (Metric::Labels::const_iterator it = labels.begin(); it != labels.end(); ++it) {
+        key.append(it->first);
+        key.append(u'=');
+        key.append(it->second);
+        key.append(u',');
+    }
+    key.append(u'}');
+    return key;
+}
+
+
+//----------------------------------------------------------------------------
+// Get or create metrics.
+//----------------------------------------------------------------------------
+
+ts::MetricCounter* ts::MetricsRegistry::counter(const UString& name, const UString& help, const Metric::Labels& labels)
+{
+    Guard lock(_mutex);
+    Metric*& metric(_metrics[Key(name, labels)]);
+    if (metric == 0) {
+        metric = new MetricCounter(name, help, labels);
+    }
+    return metric->type() == Metric::COUNTER ? static_cast<MetricCounter*>(metric) : 0;
+}
+
+ts::MetricGauge* ts::MetricsRegistry::gauge(const UString& name, const UString& help, const Metric::Labels& labels)
+{
+    Guard lock(_mutex);
+    Metric*& metric(_metrics[Key(name, labels)]);
+    if (metric == 0) {
+        metric = new MetricGauge(name, help, labels);
+    }
+    return metric->type() == Metric::GAUGE ? static_cast<MetricGauge*>(metric) : 0;
+}
+
+void ts::MetricsRegistry::getMetrics(std::vector<const Metric*>& metrics) const
+{
+    Guard lock(_mutex);
+    metrics.clear();
+    metrics.reserve(_metrics.size());
+    for (MetricMap::const_iterator it = _metrics.begin(); it != _metrics.end(); ++it) {
+        metrics.push_back(it->second);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Format all metrics in Prometheus text exposition format.
+//----------------------------------------------------------------------------
+
+namespace {
+    // Escape a label value or a help string.
+    ts::UString PrometheusEscape(const ts::UString& str, bool quotes)
+    {
+        ts::UString res;
+        res.reserve(str.size());
+        for (size_t i = 0; i < str.size(); ++i) {
+            const ts::UChar c = str[i];
+            if (c == u'\\') {
+                res.append(u"\\\\");
+            }
+            else if (c == u'\n') {
+                res.append(u"\\n");
+            }
+            else if (c == u'"' && quotes) {
+                res.append(u"\\\"");
+            }
+            else {
+                res.append(c);
+            }
+        }
+        return res;
+    }
+}
+
+std::string ts::MetricsRegistry::formatPrometheus() const
+{
+    std::vector<const Metric*> metrics;
+    getMetrics(metrics);
+
+    // The metrics are sorted by name, HELP and TYPE are issued once per name.
+    UString text;
+    UString line;
+    const UString* previous = 0;
+    for (std::vector<const Metric*>::const_iterator it = metrics.begin(); it != metrics.end(); ++it) {
+        const Metric* metric = *it;
+        if (previous == 0 || *previous != metric->name()) {
+            previous = &metric->name();
+            if (!metric->help().empty()) {
+                line.format(u"# HELP %s %s\n", {metric->name(), PrometheusEscape(metric->help(), false)});
+                text.append(line);
+            }
+            line.format(u"# TYPE %s %s\n", {metric->name(), metric->type() == Metric::COUNTER ? u"counter" : u"gauge"});
+            text.append(line);
+        }
+        text.append(metric->name());
+        const Metric::Labels& labels(metric->labels());
+        for (Metric::Labels::const_iterator lab = labels.begin(); lab != labels.end(); ++lab) {
+            line.format(u"%c%s=\"%s\"", {lab == labels.begin() ? u'{' : u',', lab->first, PrometheusEscape(lab->second, true)});
+            text.append(line);
+        }
+        if (!labels.empty()) {
+            text.append(u'}');
+        }
+        line.format(u" %d\n", {metric->value()});
+        text.append(line);
+    }
+    return text.toUTF8();
+}
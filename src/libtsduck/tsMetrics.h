@@ -0,0 +1,265 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//!
+//!  @file
+//!  Registry of performance counters and gauges.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsSingletonManager.h"
+#include "tsUString.h"
+#include "tsMutex.h"
+#include <atomic>
+
+namespace ts {
+    //!
+    //! Abstract base class of all performance metrics.
+    //!
+    //! A metric is identified by a name and a set of labels. Metrics are created
+    //! and owned by ts::MetricsRegistry. They are never deleted until the end of
+    //! the application. Their addresses can be safely kept by the code which
+    //! updates them.
+    //!
+    class TSDUCKDLL Metric
+    {
+    public:
+        //!
+        //! Type of metric.
+        //!
+        enum Type {
+            COUNTER,  //!< Monotonic counter, only increases.
+            GAUGE,    //!< Value which can go up and down.
+        };
+
+        //!
+        //! Set of labels of a metric, indexed by label name.
+        //!
+        typedef std::map<UString, UString> Labels;
+
+        //!
+        //! Virtual destructor.
+        //!
+        virtual ~Metric();
+
+        //!
+        //! Get the type of the metric.
+        //! @return The type of the metric.
+        //!
+        Type type() const { return _type; }
+
+        //!
+        //! Get the name of the metric.
+        //! @return A constant reference to the name of the metric.
+        //!
+        const UString& name() const { return _name; }
+
+        //!
+        //! Get the description of the metric.
+        //! @return A constant reference to the description of the metric.
+        //!
+        const UString& help() const { return _help; }
+
+        //!
+        //! Get the labels of the metric.
+        //! @return A constant reference to the labels of the metric.
+        //!
+        const Labels& labels() const { return _labels; }
+
+        //!
+        //! Get the current value of the metric.
+        //! This method can be called from any thread, without synchronization.
+        //! @return The current value of the metric.
+        //!
+        virtual int64_t value() const = 0;
+
+    protected:
+        //!
+        //! Constructor for subclasses.
+        //! @param [in] type Type of metric.
+        //! @param [in] name Name of the metric.
+        //! @param [in] help Description of the metric.
+        //! @param [in] labels Labels of the metric.
+        //!
+        Metric(Type type, const UString& name, const UString& help, const Labels& labels);
+
+    private:
+        const Type    _type;
+        const UString _name;
+        const UString _help;
+        const Labels  _labels;
+
+        // Inaccessible operations.
+        Metric() = delete;
+        Metric(const Metric&) = delete;
+        Metric& operator=(const Metric&) = delete;
+    };
+
+    //!
+    //! Performance counter, a metric which only increases.
+    //!
+    //! The counter is split into several shards, each in its own cache line.
+    //! Each thread increments one shard with relaxed atomic operations so that
+    //! threads which update the same counter do not contend on the same cache line.
+    //! Reading the counter sums the shards and never blocks the updating threads.
+    //!
+    class TSDUCKDLL MetricCounter: public Metric
+    {
+    public:
+        //!
+        //! Number of shards in a counter.
+        //!
+        static const size_t SHARDS = 8;
+
+        //!
+        //! Increment the counter.
+        //! @param [in] count Value to add to the counter.
+        //!
+        void add(uint64_t count = 1)
+        {
+            _shards[ShardIndex()].value.fetch_add(count, std::memory_order_relaxed);
+        }
+
+        // Inherited from Metric.
+        virtual int64_t value() const override;
+
+    private:
+        friend class MetricsRegistry;
+
+        // One shard, padded to the size of a cache line.
+        struct Shard
+        {
+            Shard() : value(0) {}
+            std::atomic<uint64_t> value;
+            uint8_t pad[64 - sizeof(std::atomic<uint64_t>)];
+        };
+
+        Shard _shards[SHARDS];
+
+        // Constructor, used by MetricsRegistry only.
+        MetricCounter(const UString& name, const UString& help, const Labels& labels);
+
+        // Index of the shard of the current thread.
+        static size_t ShardIndex();
+    };
+
+    //!
+    //! Performance gauge, a metric which can go up and down.
+    //!
+    class TSDUCKDLL MetricGauge: public Metric
+    {
+    public:
+        //!
+        //! Set the value of the gauge.
+        //! @param [in] value New value of the gauge.
+        //!
+        void set(int64_t value)
+        {
+            _value.store(value, std::memory_order_relaxed);
+        }
+
+        //!
+        //! Add a value to the gauge.
+        //! @param [in] value Value to add to the gauge, can be negative.
+        //!
+        void add(int64_t value)
+        {
+            _value.fetch_add(value, std::memory_order_relaxed);
+        }
+
+        // Inherited from Metric.
+        virtual int64_t value() const override;
+
+    private:
+        friend class MetricsRegistry;
+        std::atomic<int64_t> _value;
+
+        // Constructor, used by MetricsRegistry only.
+        MetricGauge(const UString& name, const UString& help, const Labels& labels);
+    };
+
+    //!
+    //! Registry of all performance metrics of the application.
+    //!
+    //! This class is a singleton. Use static Instance() method to access the single instance.
+    //!
+    //! The registry is used to export the metrics, typically using ts::MetricsExporter.
+    //! Updating a metric does not involve the registry. The registry is only locked
+    //! when a metric is created or when the list of metrics is read.
+    //!
+    class TSDUCKDLL MetricsRegistry
+    {
+        TS_DECLARE_SINGLETON(MetricsRegistry);
+
+    public:
+        //!
+        //! Destructor, delete all metrics.
+        //!
+        ~MetricsRegistry();
+
+        //!
+        //! Get or create a counter.
+        //! @param [in] name Name of the counter. By convention, the name ends with "_total".
+        //! @param [in] help Description of the counter. Ignored when the counter already exists.
+        //! @param [in] labels Labels of the counter.
+        //! @return The address of the counter with these name and labels or zero when
+        //! a gauge already exists with the same name and labels.
+        //!
+        MetricCounter* counter(const UString& name, const UString& help, const Metric::Labels& labels = Metric::Labels());
+
+        //!
+        //! Get or create a gauge.
+        //! @param [in] name Name of the gauge.
+        //! @param [in] help Description of the gauge. Ignored when the gauge already exists.
+        //! @param [in] labels Labels of the gauge.
+        //! @return The address of the gauge with these name and labels or zero when
+        //! a counter already exists with the same name and labels.
+        //!
+        MetricGauge* gauge(const UString& name, const UString& help, const Metric::Labels& labels = Metric::Labels());
+
+        //!
+        //! Get all metrics, sorted by name and labels.
+        //! @param [out] metrics Returned list of metrics.
+        //!
+        void getMetrics(std::vector<const Metric*>& metrics) const;
+
+        //!
+        //! Format all metrics in Prometheus text exposition format.
+        //! @return The metrics in UTF-8 format.
+        //!
+        std::string formatPrometheus() const;
+
+    private:
+        typedef std::map<UString, Metric*> MetricMap;
+        mutable Mutex _mutex;
+        MetricMap     _metrics;  // Indexed by name and labels.
+
+        // Build the key of a metric.
+        static UString Key(const UString& name, const Metric::Labels& labels);
+    };
+}
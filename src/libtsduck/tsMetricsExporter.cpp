@@ -0,0 +1,271 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "tsMetricsExporter.h"
+#include "tsGuardCondition.h"
+#include "tsSysUtils.h"
+TSDUCK_SOURCE;
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::MetricsExporter::MAX_STATSD_DATAGRAM;
+#endif
+
+// Stack size for the exporter thread
+#define EXPORTER_STACK_SIZE (128 * 1024)
+
+// Maximum size of an HTTP request header.
+#define MAX_HTTP_REQUEST 8192
+
+
+//----------------------------------------------------------------------------
+// Constructor and destructor.
+//----------------------------------------------------------------------------
+
+ts::MetricsExporter::MetricsExporter(Report* report) :
+    Thread(ThreadAttributes().setPriority(ThreadAttributes::GetMinimumPriority()).setStackSize(EXPORTER_STACK_SIZE).setName(u"metrics")),
+    _report(report),
+    _mode(NONE),
+    _server(),
+    _udp(),
+    _destination(),
+    _interval(0),
+    _last(),
+    _mutex(),
+    _wake_up(),
+    _terminate(false)
+{
+}
+
+ts::MetricsExporter::~MetricsExporter()
+{
+    stop();
+}
+
+
+//----------------------------------------------------------------------------
+// Start an HTTP server.
+//----------------------------------------------------------------------------
+
+bool ts::MetricsExporter::startHTTP(const SocketAddress& address)
+{
+    if (_mode != NONE) {
+        _report->error(u"metrics exporter already started");
+        return false;
+    }
+    if (!address.hasPort()) {
+        _report->error(u"missing port number for metrics HTTP server");
+        return false;
+    }
+
+    // Writing to a disconnected client shall not kill the application.
+    IgnorePipeSignal();
+
+    if (!_server.open(*_report)) {
+        return false;
+    }
+    if (!_server.reusePort(true, *_report) || !_server.bind(address, *_report) || !_server.listen(5, *_report)) {
+        _server.close(NULLREP);
+        return false;
+    }
+
+    _mode = HTTP;
+    _report->verbose(u"metrics available on http://%s/metrics", {address.toString()});
+    return start();
+}
+
+
+//----------------------------------------------------------------------------
+// Start sending the metrics to a StatsD server.
+//----------------------------------------------------------------------------
+
+bool ts::MetricsExporter::startStatsD(const SocketAddress& server, MilliSecond interval)
+{
+    if (_mode != NONE) {
+        _report->error(u"metrics exporter already started");
+        return false;
+    }
+    if (!server.hasAddress() || !server.hasPort()) {
+        _report->error(u"missing address or port number for StatsD server");
+        return false;
+    }
+    if (!_udp.open(*_report)) {
+        return false;
+    }
+
+    _mode = STATSD;
+    _destination = server;
+    _interval = interval;
+    return start();
+}
+
+
+//----------------------------------------------------------------------------
+// Stop the exporter thread.
+//----------------------------------------------------------------------------
+
+void ts::MetricsExporter::stop()
+{
+    {
+        GuardCondition lock(_mutex, _wake_up);
+        _terminate = true;
+        lock.signal();
+    }
+
+    // Closing the server unblocks the thread in accept().
+    if (_server.isOpen()) {
+        _server.close(NULLREP);
+    }
+    waitForTermination();
+
+    if (_udp.isOpen()) {
+        // Send final counter values.
+        if (_mode == STATSD) {
+            sendStatsD();
+        }
+        _udp.close(NULLREP);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Thread main code. Inherited from Thread
+//----------------------------------------------------------------------------
+
+void ts::MetricsExporter::main()
+{
+    if (_mode == HTTP) {
+        serveHTTP();
+    }
+    else if (_mode == STATSD) {
+        for (;;) {
+            {
+                GuardCondition lock(_mutex, _wake_up);
+                if (!_terminate) {
+                    lock.waitCondition(_interval);
+                }
+                if (_terminate) {
+                    break;
+                }
+            }
+            sendStatsD();
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Serve HTTP clients until the server is closed.
+//----------------------------------------------------------------------------
+
+void ts::MetricsExporter::serveHTTP()
+{
+    std::string request;
+    char buffer[1024];
+
+    for (;;) {
+        TCPConnection client;
+        SocketAddress client_address;
+        if (!_server.accept(client, client_address, *_report)) {
+            break;
+        }
+
+        // Read the request header, up to the empty line.
+        request.clear();
+        size_t size = 0;
+        while (request.find("\r\n\r\n") == std::string::npos && request.size() < MAX_HTTP_REQUEST && client.receive(buffer, sizeof(buffer), size, 0, *_report)) {
+            request.append(buffer, size);
+        }
+
+        // Only "GET /metrics" is supported.
+        std::string response;
+        if (request.compare(0, 13, "GET /metrics ") == 0 || request.compare(0, 13, "GET /metrics?") == 0) {
+            const std::string body(MetricsRegistry::Instance()->formatPrometheus());
+            response = "HTTP/1.0 200 OK\r\n"
+                       "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                       "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                       "Connection: close\r\n\r\n" + body;
+        }
+        else {
+            _report->debug(u"invalid metrics request from %s", {client_address.toString()});
+            response = "HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        }
+        client.send(response.data(), response.size(), *_report);
+        client.close(NULLREP);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Send all metrics to the StatsD server.
+//----------------------------------------------------------------------------
+
+void ts::MetricsExporter::sendStatsD()
+{
+    std::vector<const Metric*> metrics;
+    MetricsRegistry::Instance()->getMetrics(metrics);
+
+    std::string datagram;
+    UString line;
+
+    for (std::vector<const Metric*>::const_iterator it = metrics.begin(); it != metrics.end(); ++it) {
+        const Metric* metric = *it;
+        const int64_t value = metric->value();
+
+        // Format one line: name:value|type|#label:value,...
+        if (metric->type() == Metric::COUNTER) {
+            int64_t& last(_last[metric]);
+            line.format(u"%s:%d|c", {metric->name(), value - last});
+            last = value;
+        }
+        else {
+            line.format(u"%s:%d|g", {metric->name(), value});
+        }
+        const Metric::Labels& labels(metric->labels());
+        for (Metric::Labels::const_iterator lab = labels.begin(); lab != labels.end(); ++lab) {
+            line.append(lab == labels.begin() ? u"|#" : u",");
+            line.append(lab->first);
+            line.append(u':');
+            line.append(lab->second);
+        }
+        const std::string utf8(line.toUTF8());
+
+        // Send the datagram when the line does not fit.
+        if (!datagram.empty() && datagram.size() + 1 + utf8.size() > MAX_STATSD_DATAGRAM) {
+            _udp.send(datagram.data(), datagram.size(), _destination, *_report);
+            datagram.clear();
+        }
+        if (!datagram.empty()) {
+            datagram.append(1, '\n');
+        }
+        datagram.append(utf8);
+    }
+
+    if (!datagram.empty()) {
+        _udp.send(datagram.data(), datagram.size(), _destination, *_report);
+    }
+}
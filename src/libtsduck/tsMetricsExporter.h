@@ -0,0 +1,127 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//!
+//!  @file
+//!  Export of the performance metrics over the network.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsMetrics.h"
+#include "tsThread.h"
+#include "tsCondition.h"
+#include "tsTCPServer.h"
+#include "tsUDPSocket.h"
+#include "tsReport.h"
+
+namespace ts {
+    //!
+    //! Export of the performance metrics of ts::MetricsRegistry over the network.
+    //!
+    //! The exporter runs an internal low-priority thread which uses one of two modes:
+    //!
+    //! - HTTP server: each HTTP GET request on @c /metrics returns all metrics in
+    //!   Prometheus text exposition format. This is the "pull" model of Prometheus.
+    //! - StatsD client: at regular intervals, all metrics are sent in UDP datagrams
+    //!   to a StatsD server. Labels are sent as DogStatsD tags. Counters are sent
+    //!   as increments since the previous interval.
+    //!
+    //! The metrics are read using relaxed atomic loads. The threads which update
+    //! the metrics are never blocked by the exporter.
+    //!
+    class TSDUCKDLL MetricsExporter: private Thread
+    {
+    public:
+        //!
+        //! Constructor.
+        //! @param [in] report Where to report errors.
+        //!
+        MetricsExporter(Report* report);
+
+        //!
+        //! Destructor. Stop the exporter thread.
+        //!
+        virtual ~MetricsExporter() override;
+
+        //!
+        //! Start an HTTP server exporting the metrics in Prometheus format.
+        //! @param [in] address Local socket address of the server.
+        //! The IP address is optional (all local interfaces), the port is mandatory.
+        //! @return True on success, false on error.
+        //!
+        bool startHTTP(const SocketAddress& address);
+
+        //!
+        //! Start sending the metrics to a StatsD server.
+        //! @param [in] server Socket address of the StatsD server.
+        //! @param [in] interval Interval between two transmissions of the metrics.
+        //! @return True on success, false on error.
+        //!
+        bool startStatsD(const SocketAddress& server, MilliSecond interval);
+
+        //!
+        //! Stop the exporter thread and wait for its termination.
+        //! Can be called several times.
+        //!
+        void stop();
+
+        //!
+        //! Maximum size of StatsD datagrams, fits in an Ethernet MTU.
+        //!
+        static const size_t MAX_STATSD_DATAGRAM = 1432;
+
+    private:
+        enum Mode {NONE, HTTP, STATSD};
+        typedef std::map<const Metric*, int64_t> ValueMap;
+
+        Report*       _report;
+        Mode          _mode;
+        TCPServer     _server;       // HTTP server.
+        UDPSocket     _udp;          // StatsD client.
+        SocketAddress _destination;  // StatsD server.
+        MilliSecond   _interval;     // StatsD interval.
+        ValueMap      _last;         // Last counter values sent to StatsD.
+        Mutex         _mutex;
+        Condition     _wake_up;      // accessed under mutex
+        bool          _terminate;    // accessed under mutex
+
+        // Inherited from Thread
+        virtual void main() override;
+
+        // Serve HTTP clients until the server is closed.
+        void serveHTTP();
+
+        // Send all metrics to the StatsD server.
+        void sendStatsD();
+
+        // Inaccessible operations.
+        MetricsExporter() = delete;
+        MetricsExporter(const MetricsExporter&) = delete;
+        MetricsExporter& operator=(const MetricsExporter&) = delete;
+    };
+}
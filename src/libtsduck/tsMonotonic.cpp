@@ -33,6 +33,9 @@
 
 #include "tsMonotonic.h"
 #include "tsSysUtils.h"
+#if defined(TS_LINUX)
+#include <sys/prctl.h>
+#endif
 TSDUCK_SOURCE;
 
 
@@ -191,6 +194,109 @@ void ts::Monotonic::wait()
 }
 
 
+//----------------------------------------------------------------------------
+// Wait until a deadline with a final busy-wait.
+//----------------------------------------------------------------------------
+
+void ts::Monotonic::waitUntil(const Monotonic& deadline, NanoSecond spin_threshold)
+{
+    // Sleep until shortly before the deadline.
+    getSystemTime();
+    const int64_t spin = spin_threshold / NS_PER_TICK;
+    if (deadline._value - _value > spin) {
+        _value = deadline._value - spin;
+        wait();
+        getSystemTime();
+    }
+
+    // Then spin on the clock.
+    while (_value < deadline._value) {
+        CPUPause();
+        getSystemTime();
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Reduce the timer slack of the calling thread to its minimum.
+//----------------------------------------------------------------------------
+
+bool ts::Monotonic::SetMinimumTimerSlack()
+{
+#if defined(TS_LINUX)
+    // The minimum value is 1 nanosecond, zero means "reset to default".
+    return ::prctl(PR_SET_TIMERSLACK, 1UL, 0UL, 0UL, 0UL) == 0;
+#else
+    return true;
+#endif
+}
+
+
+//----------------------------------------------------------------------------
+// CPU timestamp counter.
+//----------------------------------------------------------------------------
+
+uint64_t ts::Monotonic::SystemCPUTicks()
+{
+#if defined(TS_WINDOWS)
+    ::LARGE_INTEGER counter;
+    ::QueryPerformanceCounter(&counter);
+    return uint64_t(counter.QuadPart);
+#elif defined(TS_MAC)
+    return uint64_t(Time::UnixClockNanoSeconds(CLOCK_REALTIME));
+#else
+    return uint64_t(Time::UnixClockNanoSeconds(CLOCK_MONOTONIC));
+#endif
+}
+
+namespace {
+    // Compute the frequency of the CPU timestamp counter.
+    uint64_t CalibrateCPUTicks()
+    {
+#if defined(TS_GCC) && defined(TS_ARM64)
+        // The frequency of the generic timer is given by the system.
+        uint64_t freq;
+        __asm__ __volatile__("mrs %0, cntfrq_el0" : "=r"(freq));
+        return freq;
+#elif (defined(TS_MSC) || defined(TS_GCC)) && (defined(TS_I386) || defined(TS_X86_64))
+        // Measure the TSC against the monotonic clock during a few milliseconds.
+        // Each counter is read next to its clock value, the sleep jitter does not matter.
+        ts::Monotonic start;
+        start.getSystemTime();
+        const uint64_t ticks_start = ts::Monotonic::CPUTicks();
+        ts::Monotonic end(start);
+        end += 20 * ts::NanoSecPerMilliSec;
+        end.wait();
+        const uint64_t ticks_end = ts::Monotonic::CPUTicks();
+        end.getSystemTime();
+        const ts::NanoSecond duration = end - start;
+        return duration <= 0 ? 1 : uint64_t((long double)(ticks_end - ticks_start) * ts::NanoSecPerSec / duration);
+#elif defined(TS_WINDOWS)
+        ::LARGE_INTEGER freq;
+        ::QueryPerformanceFrequency(&freq);
+        return uint64_t(freq.QuadPart);
+#else
+        // Fallback on the monotonic clock in nanoseconds.
+        return uint64_t(ts::NanoSecPerSec);
+#endif
+    }
+}
+
+uint64_t ts::Monotonic::CPUTicksPerSecond()
+{
+    // Thread-safe initialization of local static data in C++11.
+    static const uint64_t freq = CalibrateCPUTicks();
+    return freq;
+}
+
+ts::NanoSecond ts::Monotonic::CPUTicksToNanoSeconds(uint64_t ticks)
+{
+    // Split the computation to avoid overflows.
+    const uint64_t freq = CPUTicksPerSecond();
+    return NanoSecond((ticks / freq) * NanoSecPerSec + ((ticks % freq) * NanoSecPerSec) / freq);
+}
+
+
 //----------------------------------------------------------------------------
 // This static method requests a minimum resolution, in nano-seconds, for the
 // timers. Return the guaranteed value (can be equal to or greater than the
@@ -174,6 +174,20 @@ namespace ts {
         //!
         void wait();
 
+        //!
+        //! Wait until a deadline with a sub-millisecond precision.
+        //!
+        //! The calling thread sleeps until @a spin_threshold nanoseconds before the deadline
+        //! and then spins on the clock until the deadline. The spinning phase absorbs the
+        //! wake-up jitter of the system timer, at the expense of CPU usage. This object is
+        //! used as timer and, on return, it contains the current time, at or after the deadline.
+        //!
+        //! @param [in] deadline The time to wait for.
+        //! @param [in] spin_threshold Duration in nanoseconds of the final busy-wait.
+        //! If zero, this is the same as waiting on @a deadline with wait().
+        //!
+        void waitUntil(const Monotonic& deadline, NanoSecond spin_threshold = 0);
+
         //!
         //! This static method requests a minimum resolution, in nano-seconds, for the timers.
         //! @param [in] precision Requested minimum resolution in nano-seconds.
@@ -182,6 +196,73 @@ namespace ts {
         //!
         static NanoSecond SetPrecision(const NanoSecond& precision);
 
+        //!
+        //! Reduce the timer slack of the calling thread to its minimum.
+        //!
+        //! On Linux, the kernel may delay the expiration of timers of a thread by its
+        //! "timer slack" (50 microseconds by default) to group wake-ups. This is
+        //! not acceptable for precise pacing. On other systems, this is a no-op.
+        //!
+        //! @return True on success, false if the timer slack cannot be changed.
+        //!
+        static bool SetMinimumTimerSlack();
+
+        //!
+        //! Hint the CPU that the calling thread is in a spin-wait loop.
+        //! This reduces the power consumption and the penalty on the other hardware thread of the core.
+        //!
+        static void CPUPause()
+        {
+#if defined(TS_MSC)
+            ::YieldProcessor();
+#elif defined(TS_GCC) && (defined(TS_I386) || defined(TS_X86_64))
+            __builtin_ia32_pause();
+#elif defined(TS_GCC) && (defined(TS_ARM) || defined(TS_ARM64))
+            __asm__ __volatile__("yield");
+#endif
+        }
+
+        //!
+        //! Read the CPU timestamp counter, a cheap timestamp for hot loops.
+        //!
+        //! On x86 processors, this is the TSC, which is assumed to be invariant (constant
+        //! rate and synchronized across cores, which is the case of all recent processors).
+        //! On 64-bit Arm processors, this is the virtual counter of the generic timer.
+        //! On other processors, this is the monotonic clock in nanoseconds.
+        //! Use CPUTicksPerSecond() to convert a number of ticks into a duration.
+        //!
+        //! @return The current value of the CPU timestamp counter.
+        //!
+        static uint64_t CPUTicks()
+        {
+#if defined(TS_MSC) && (defined(TS_I386) || defined(TS_X86_64))
+            return uint64_t(__rdtsc());
+#elif defined(TS_GCC) && (defined(TS_I386) || defined(TS_X86_64))
+            return uint64_t(__builtin_ia32_rdtsc());
+#elif defined(TS_GCC) && defined(TS_ARM64)
+            uint64_t ticks;
+            __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(ticks));
+            return ticks;
+#else
+            return SystemCPUTicks();
+#endif
+        }
+
+        //!
+        //! Get the frequency of the CPU timestamp counter.
+        //! On x86 processors, the frequency is calibrated against the monotonic clock
+        //! during the first call (which takes a few milliseconds).
+        //! @return The number of CPUTicks() per second.
+        //!
+        static uint64_t CPUTicksPerSecond();
+
+        //!
+        //! Convert a number of CPU ticks into nanoseconds.
+        //! @param [in] ticks A difference between two values of CPUTicks().
+        //! @return The corresponding number of nanoseconds.
+        //!
+        static NanoSecond CPUTicksToNanoSeconds(uint64_t ticks);
+
     private:
         // Monotonic clock value in system ticks
         int64_t _value;
@@ -189,6 +270,9 @@ namespace ts {
         // System-specific initialization
         void init();
 
+        // Fallback for CPUTicks(): monotonic clock in nanoseconds.
+        static uint64_t SystemCPUTicks();
+
 #if defined(TS_WINDOWS)
         // Timer handle
         ::HANDLE _handle;
@@ -32,6 +32,9 @@
 #include "tsSysUtils.h"
 #include "tsFatal.h"
 #include "tsCerrReport.h"
+#include "tsNullReport.h"
+#include "tsMemoryUtils.h"
+#include "tsByteBlock.h"
 TSDUCK_SOURCE;
 
 
@@ -290,13 +293,26 @@ ts::UString ts::names::AC3ComponentType(uint8_t type, Flags flags)
 // Constructor (load the configuration file).
 //----------------------------------------------------------------------------
 
-ts::Names::Names(const UString& fileName) :
+ts::Names::Names(const UString& fileName, bool useCompiled) :
     _log(CERR),
     _configFile(SearchConfigurationFile(fileName)),
     _configLines(0),
     _configErrors(0),
-    _sections()
-{
+    _sections(),
+    _compiledFile(),
+    _compiledHeader(0)
+{
+    // Use the compiled file when it is up to date, avoid parsing the text file.
+    if (useCompiled) {
+        const UString compiledFile(SearchConfigurationFile(CompiledFileName(fileName)));
+        if (!compiledFile.empty() && loadCompiled(compiledFile, _configFile.empty() ? -1 : GetFileSize(_configFile))) {
+            if (_configFile.empty()) {
+                _configFile = compiledFile;
+            }
+            return;
+        }
+    }
+
     // Locate the configuration file.
     if (_configFile.empty()) {
         // Cannot load configuration, names will not be available.
@@ -586,22 +602,80 @@ ts::UString ts::Names::Formatted(Value value, const UString& name, names::Flags
 }
 
 
+//----------------------------------------------------------------------------
+// Locate a section and get a name in a section.
+//----------------------------------------------------------------------------
+
+bool ts::Names::findSection(const UString& sectionName, const ConfigSection*& config, const CompiledSection*& compiled, size_t& bits) const
+{
+    // Normalize the section name.
+    const UString name(sectionName.toTrimmed().toLower());
+    config = 0;
+    compiled = 0;
+
+    if (_compiledHeader != 0) {
+        // Hashed lookup in the compiled file.
+        const uint32_t* const hash = reinterpret_cast<const uint32_t*>(_compiledHeader + 1);
+        const CompiledSection* const sections = reinterpret_cast<const CompiledSection*>(_compiledFile.data() + _compiledHeader->sectionsOffset);
+        const UChar* const strings = reinterpret_cast<const UChar*>(_compiledFile.data() + _compiledHeader->stringsOffset);
+        const uint32_t mask = _compiledHeader->hashSize - 1;
+        for (uint32_t h = SectionHash(name.data(), name.size()) & mask; hash[h] != 0; h = (h + 1) & mask) {
+            const CompiledSection* const sec = sections + hash[h] - 1;
+            if (sec->nameLength == name.size() && name.compare(0, name.size(), strings + sec->nameOffset, sec->nameLength) == 0) {
+                compiled = sec;
+                bits = sec->bits;
+                return true;
+            }
+        }
+        return false;
+    }
+    else {
+        const ConfigSectionMap::const_iterator it = _sections.find(name);
+        if (it == _sections.end()) {
+            return false;
+        }
+        config = it->second;
+        bits = config->bits;
+        return true;
+    }
+}
+
+ts::UString ts::Names::getName(const ConfigSection* config, const CompiledSection* compiled, Value value) const
+{
+    if (config != 0) {
+        return config->getName(value);
+    }
+    else if (compiled != 0) {
+        // Binary search of the last range which starts before or at value.
+        const CompiledEntry* const entries = reinterpret_cast<const CompiledEntry*>(_compiledFile.data() + _compiledHeader->entriesOffset);
+        const CompiledEntry* const begin = entries + compiled->firstEntry;
+        const CompiledEntry* const end = begin + compiled->entryCount;
+        const CompiledEntry* it = std::upper_bound(begin, end, value, [](Value v, const CompiledEntry& e) { return v < e.first; });
+        if (it != begin && value <= (--it)->last) {
+            const UChar* const strings = reinterpret_cast<const UChar*>(_compiledFile.data() + _compiledHeader->stringsOffset);
+            return UString(strings + it->nameOffset, it->nameLength);
+        }
+    }
+    return UString();
+}
+
+
 //----------------------------------------------------------------------------
 // Get a name from a specified section.
 //----------------------------------------------------------------------------
 
 ts::UString ts::Names::nameFromSection(const UString& sectionName, Value value, names::Flags flags, size_t bits, Value alternateValue) const
 {
-    // Get the section, normalize the section name.
-    ConfigSectionMap::const_iterator it = _sections.find(sectionName.toTrimmed().toLower());
-    const ConfigSection* section = it == _sections.end() ? 0 : it->second;
+    const ConfigSection* config = 0;
+    const CompiledSection* compiled = 0;
+    size_t sectionBits = 0;
 
-    if (section == 0) {
+    if (!findSection(sectionName, config, compiled, sectionBits)) {
         // Non-existent section, no name.
         return Formatted(value, UString(), flags, bits, alternateValue);
     }
     else {
-        return Formatted(value, section->getName(value), flags, bits != 0 ? bits : section->bits, alternateValue);
+        return Formatted(value, getName(config, compiled, value), flags, bits != 0 ? bits : sectionBits, alternateValue);
     }
 }
 
@@ -612,23 +686,197 @@ ts::UString ts::Names::nameFromSection(const UString& sectionName, Value value,
 
 ts::UString ts::Names::nameFromSectionWithFallback(const UString& sectionName, Value value1, Value value2, names::Flags flags, size_t bits, Value alternateValue) const
 {
-    // Get the section, normalize the section name.
-    ConfigSectionMap::const_iterator it = _sections.find(sectionName.toTrimmed().toLower());
-    const ConfigSection* section = it == _sections.end() ? 0 : it->second;
+    const ConfigSection* config = 0;
+    const CompiledSection* compiled = 0;
+    size_t sectionBits = 0;
 
-    if (section == 0) {
+    if (!findSection(sectionName, config, compiled, sectionBits)) {
         // Non-existent section, no name.
         return Formatted(value1, UString(), flags, bits, alternateValue);
     }
     else {
-        const UString name(section->getName(value1));
+        const UString name(getName(config, compiled, value1));
         if (!name.empty()) {
             // value1 has a name
-            return Formatted(value1, name, flags, bits != 0 ? bits : section->bits, alternateValue);
+            return Formatted(value1, name, flags, bits != 0 ? bits : sectionBits, alternateValue);
         }
         else {
             // value1 has no name, use value2.
-            return Formatted(value2, section->getName(value2), flags, bits != 0 ? bits : section->bits, alternateValue);
+            return Formatted(value2, getName(config, compiled, value2), flags, bits != 0 ? bits : sectionBits, alternateValue);
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Compiled files.
+//----------------------------------------------------------------------------
+
+namespace {
+    const uint8_t  COMPILED_MAGIC[4] = {'T', 'S', 'N', 'C'};
+    const uint32_t COMPILED_VERSION = 1;
+    const uint32_t COMPILED_BYTE_ORDER = 0x01020304;
+
+    // Round a size to the next multiple of 8 bytes.
+    inline size_t Align8(size_t size)
+    {
+        return (size + 7) & ~size_t(7);
+    }
+}
+
+ts::UString ts::Names::CompiledFileName(const UString& fileName)
+{
+    return fileName + TS_COMPILED_NAMES_FILE_SUFFIX;
+}
+
+// FNV-1a hash of the UTF-16 characters.
+uint32_t ts::Names::SectionHash(const UChar* name, size_t length)
+{
+    uint32_t hash = 2166136261;
+    for (size_t i = 0; i < length; ++i) {
+        hash = (hash ^ uint32_t(name[i])) * 16777619;
+    }
+    return hash;
+}
+
+bool ts::Names::loadCompiled(const UString& fileName, int64_t sourceSize)
+{
+    // Errors are silently ignored, the text file is used instead.
+    if (!_compiledFile.open(fileName, NULLREP)) {
+        return false;
+    }
+
+    const uint8_t* const data = _compiledFile.data();
+    const size_t size = _compiledFile.size();
+    const CompiledHeader* const header = reinterpret_cast<const CompiledHeader*>(data);
+
+    // Check the header and the bounds of all arrays.
+    bool valid = size >= sizeof(CompiledHeader) &&
+        ::memcmp(header->magic, COMPILED_MAGIC, sizeof(COMPILED_MAGIC)) == 0 &&
+        header->version == COMPILED_VERSION &&
+        header->byteOrder == COMPILED_BYTE_ORDER &&
+        (sourceSize < 0 || header->sourceSize == uint64_t(sourceSize)) &&
+        header->hashSize > header->sectionCount &&
+        (header->hashSize & (header->hashSize - 1)) == 0 &&
+        sizeof(CompiledHeader) + uint64_t(header->hashSize) * sizeof(uint32_t) <= header->sectionsOffset &&
+        header->sectionsOffset % 8 == 0 &&
+        header->entriesOffset % 8 == 0 &&
+        header->stringsOffset % 8 == 0 &&
+        header->sectionsOffset + uint64_t(header->sectionCount) * sizeof(CompiledSection) <= header->entriesOffset &&
+        header->entriesOffset + uint64_t(header->entryCount) * sizeof(CompiledEntry) <= header->stringsOffset &&
+        header->stringsOffset + uint64_t(header->stringsCount) * sizeof(UChar) <= size;
+
+    // Check all indexes.
+    const uint32_t* const hash = reinterpret_cast<const uint32_t*>(header + 1);
+    for (uint32_t i = 0; valid && i < header->hashSize; ++i) {
+        valid = hash[i] <= header->sectionCount;
+    }
+    const CompiledSection* const sections = reinterpret_cast<const CompiledSection*>(data + header->sectionsOffset);
+    for (uint32_t i = 0; valid && i < header->sectionCount; ++i) {
+        valid = uint64_t(sections[i].nameOffset) + sections[i].nameLength <= header->stringsCount &&
+            uint64_t(sections[i].firstEntry) + sections[i].entryCount <= header->entryCount;
+    }
+    const CompiledEntry* const entries = reinterpret_cast<const CompiledEntry*>(data + header->entriesOffset);
+    for (uint32_t i = 0; valid && i < header->entryCount; ++i) {
+        valid = uint64_t(entries[i].nameOffset) + entries[i].nameLength <= header->stringsCount;
+    }
+
+    if (valid) {
+        _compiledHeader = header;
+    }
+    else {
+        _compiledFile.close();
+    }
+    return valid;
+}
+
+bool ts::Names::saveCompiled(const UString& fileName, Report& report) const
+{
+    if (_compiledHeader != 0) {
+        report.error(u"names were loaded from a compiled file, cannot recompile them");
+        return false;
+    }
+
+    // Build the arrays of sections and entries, and the pool of names.
+    std::vector<CompiledSection> sections;
+    std::vector<CompiledEntry> entries;
+    std::vector<UChar> strings;
+    for (ConfigSectionMap::const_iterator it = _sections.begin(); it != _sections.end(); ++it) {
+        CompiledSection sec;
+        sec.nameOffset = uint32_t(strings.size());
+        sec.nameLength = uint32_t(it->first.size());
+        sec.bits = uint32_t(it->second->bits);
+        sec.firstEntry = uint32_t(entries.size());
+        sec.entryCount = uint32_t(it->second->entries.size());
+        sec.reserved = 0;
+        strings.insert(strings.end(), it->first.begin(), it->first.end());
+        sections.push_back(sec);
+        for (ConfigEntryMap::const_iterator eit = it->second->entries.begin(); eit != it->second->entries.end(); ++eit) {
+            CompiledEntry entry;
+            entry.first = eit->first;
+            entry.last = eit->second->last;
+            entry.nameOffset = uint32_t(strings.size());
+            entry.nameLength = uint32_t(eit->second->name.size());
+            strings.insert(strings.end(), eit->second->name.begin(), eit->second->name.end());
+            entries.push_back(entry);
+        }
+    }
+
+    // Build the hash table, at most half full.
+    uint32_t hashSize = 8;
+    while (hashSize < 2 * sections.size()) {
+        hashSize *= 2;
+    }
+    std::vector<uint32_t> hash(hashSize, 0);
+    for (size_t i = 0; i < sections.size(); ++i) {
+        uint32_t h = SectionHash(&strings[sections[i].nameOffset], sections[i].nameLength) & (hashSize - 1);
+        while (hash[h] != 0) {
+            h = (h + 1) & (hashSize - 1);
         }
+        hash[h] = uint32_t(i + 1);
+    }
+
+    // Build the header.
+    CompiledHeader header;
+    TS_ZERO(header);
+    ::memcpy(header.magic, COMPILED_MAGIC, sizeof(COMPILED_MAGIC));
+    header.version = COMPILED_VERSION;
+    header.byteOrder = COMPILED_BYTE_ORDER;
+    header.sectionCount = uint32_t(sections.size());
+    header.hashSize = hashSize;
+    header.entryCount = uint32_t(entries.size());
+    header.sectionsOffset = uint32_t(Align8(sizeof(header) + hash.size() * sizeof(uint32_t)));
+    header.entriesOffset = uint32_t(Align8(header.sectionsOffset + sections.size() * sizeof(CompiledSection)));
+    header.stringsOffset = uint32_t(Align8(header.entriesOffset + entries.size() * sizeof(CompiledEntry)));
+    header.stringsCount = uint32_t(strings.size());
+    const int64_t sourceSize = GetFileSize(_configFile);
+    header.sourceSize = sourceSize < 0 ? 0 : uint64_t(sourceSize);
+
+    // Build the file content.
+    ByteBlock data(header.stringsOffset + strings.size() * sizeof(UChar), 0);
+    ::memcpy(data.data(), &header, sizeof(header));
+    ::memcpy(data.data() + sizeof(header), hash.data(), hash.size() * sizeof(uint32_t));
+    if (!sections.empty()) {
+        ::memcpy(data.data() + header.sectionsOffset, sections.data(), sections.size() * sizeof(CompiledSection));
     }
+    if (!entries.empty()) {
+        ::memcpy(data.data() + header.entriesOffset, entries.data(), entries.size() * sizeof(CompiledEntry));
+    }
+    if (!strings.empty()) {
+        ::memcpy(data.data() + header.stringsOffset, strings.data(), strings.size() * sizeof(UChar));
+    }
+
+    // Write the file.
+    std::ofstream strm(fileName.toUTF8().c_str(), std::ios::out | std::ios::binary);
+    if (!strm.is_open()) {
+        report.error(u"error creating %s", {fileName});
+        return false;
+    }
+    strm.write(reinterpret_cast<const char*>(data.data()), data.size());
+    strm.close();
+    if (!strm) {
+        report.error(u"error writing %s", {fileName});
+        return false;
+    }
+    return true;
 }
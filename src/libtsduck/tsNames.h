@@ -37,6 +37,12 @@
 #include "tsCASFamily.h"
 #include "tsReport.h"
 #include "tsStaticInstance.h"
+#include "tsMemoryMappedFile.h"
+
+//!
+//! Suffix of compiled names files, appended to the names file name.
+//!
+#define TS_COMPILED_NAMES_FILE_SUFFIX u".bin"
 
 namespace ts {
     //!
@@ -331,14 +337,25 @@ namespace ts {
     //! A repository of names for MPEG/DVB entities.
     //! All names are loaded from configuration files @em tsduck.*.names.
     //!
+    //! A configuration file can be compiled in a binary form, typically at build time.
+    //! The compiled file has the same name with an additional suffix @c .bin.
+    //! When an up-to-date compiled file is found, it is memory-mapped and used
+    //! directly, without parsing the text file. Sections are located using a hash
+    //! table and values using a binary search in sorted ranges. A compiled file is
+    //! up to date when the text file is not found or has the same size as the
+    //! text file which was compiled. Compiled files use the native byte order and
+    //! are ignored on systems with a different byte order.
+    //!
     class TSDUCKDLL Names
     {
     public:
         //!
         //! Constructor.
         //! @param [in] fileName Configuration file name. Typically without directory name.
+        //! @param [in] useCompiled If true, use the compiled form of the configuration file
+        //! when it is found and up to date.
         //!
-        Names(const UString& fileName);
+        Names(const UString& fileName, bool useCompiled = true);
 
         //!
         //! Virtual destructor.
@@ -368,6 +385,30 @@ namespace ts {
             return _configErrors;
         }
 
+        //!
+        //! Check if the names were loaded from a compiled file.
+        //! @return True if the names were loaded from a compiled file.
+        //!
+        bool isCompiled() const
+        {
+            return _compiledHeader != 0;
+        }
+
+        //!
+        //! Save the names in a compiled file.
+        //! @param [in] fileName Compiled file name.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on error.
+        //!
+        bool saveCompiled(const UString& fileName, Report& report) const;
+
+        //!
+        //! Get the name of the compiled form of a configuration file.
+        //! @param [in] fileName Configuration file name.
+        //! @return The corresponding compiled file name.
+        //!
+        static UString CompiledFileName(const UString& fileName);
+
         //!
         //! Get a name from a specified section.
         //! @param [in] sectionName Name of section to search. Not case-sensitive.
@@ -441,6 +482,54 @@ namespace ts {
         // Map of configuration sections, indexed by name.
         typedef std::map<UString, ConfigSection*> ConfigSectionMap;
 
+        // Layout of a compiled file, in native byte order. The header is followed by the hash
+        // table of sections (array of section index + 1, zero when free), the array of sections,
+        // the array of entries and the pool of names in UTF-16. All structures are 8-byte aligned.
+        struct CompiledHeader
+        {
+            uint8_t  magic[4];        // "TSNC"
+            uint32_t version;         // Format version.
+            uint32_t byteOrder;       // 0x01020304 in native byte order.
+            uint32_t sectionCount;    // Number of sections.
+            uint32_t hashSize;        // Size of hash table, a power of 2.
+            uint32_t entryCount;      // Total number of entries.
+            uint32_t sectionsOffset;  // Offset of array of CompiledSection.
+            uint32_t entriesOffset;   // Offset of array of CompiledEntry.
+            uint32_t stringsOffset;   // Offset of pool of names.
+            uint32_t stringsCount;    // Number of UTF-16 characters in pool of names.
+            uint64_t sourceSize;      // Size of the text configuration file.
+        };
+
+        struct CompiledSection
+        {
+            uint32_t nameOffset;      // Section name (lowercase) in pool of names.
+            uint32_t nameLength;      // Section name length.
+            uint32_t bits;            // Number of significant bits in values.
+            uint32_t firstEntry;      // Index of first entry, entries are sorted by first value.
+            uint32_t entryCount;      // Number of entries.
+            uint32_t reserved;        // For alignment.
+        };
+
+        struct CompiledEntry
+        {
+            Value    first;           // First value in the range.
+            Value    last;            // Last value in the range.
+            uint32_t nameOffset;      // Name in pool of names.
+            uint32_t nameLength;      // Name length.
+        };
+
+        // Load a compiled file. Return true on success, false if missing, invalid or obsolete.
+        bool loadCompiled(const UString& fileName, int64_t sourceSize);
+
+        // Hash value of a section name.
+        static uint32_t SectionHash(const UChar* name, size_t length);
+
+        // Locate a section by name. Return false if not found. On success, exactly one of config or compiled is set.
+        bool findSection(const UString& sectionName, const ConfigSection*& config, const CompiledSection*& compiled, size_t& bits) const;
+
+        // Get a name from a value in a section located by findSection(), empty if not found.
+        UString getName(const ConfigSection* config, const CompiledSection* compiled, Value value) const;
+
         // Decode a line as "first[-last] = name". Return true on success, false on error.
         bool decodeDefinition(const UString& line, ConfigSection* section);
 
@@ -452,10 +541,12 @@ namespace ts {
 
         // Names private fields.
         Report&          _log;           // Error logger.
-        const UString    _configFile;    // Configuration file path.
+        UString          _configFile;    // Configuration file path.
         size_t           _configLines;   // Number of lines in configuration file.
         size_t           _configErrors;  // Number of errors in configuration file.
         ConfigSectionMap _sections;      // Configuration sections.
+        MemoryMappedFile _compiledFile;  // Compiled file, when used.
+        const CompiledHeader* _compiledHeader;  // Header of compiled file, null when the text file is used.
 
         // Inaccessible operations.
         Names() = delete;
@@ -32,7 +32,7 @@
 //----------------------------------------------------------------------------
 
 #include "tsPCRAnalyzer.h"
-#include "tsMemoryUtils.h"
+#include "tsPCR.h"
 TSDUCK_SOURCE;
 
 
@@ -52,9 +52,12 @@ ts::PCRAnalyzer::PCRAnalyzer(size_t min_pid, size_t min_pcr) :
     _ts_bitrate_204(0),
     _ts_bitrate_cnt(0),
     _completed_pids(0),
-    _pcr_pids(0)
+    _pcr_pids(0),
+    _pid(PID_MAX),
+    _used_pids(),
+    _clock_pids()
 {
-    TS_ZERO(_pid);
+    // The flat array is value-initialized (all zeroes), same as after reset().
 }
 
 
@@ -68,22 +71,6 @@ ts::PCRAnalyzer::~PCRAnalyzer()
 }
 
 
-//----------------------------------------------------------------------------
-// PIDAnalysis constructor
-//----------------------------------------------------------------------------
-
-ts::PCRAnalyzer::PIDAnalysis::PIDAnalysis() :
-    ts_pkt_cnt(0),
-    cur_continuity(0),
-    last_pcr_value(0),
-    last_pcr_packet(0),
-    ts_bitrate_188(0),
-    ts_bitrate_204(0),
-    ts_bitrate_cnt(0)
-{
-}
-
-
 //----------------------------------------------------------------------------
 // PCRAnalyzez::Status constructors
 //----------------------------------------------------------------------------
@@ -136,12 +123,13 @@ void ts::PCRAnalyzer::reset()
     _completed_pids = 0;
     _pcr_pids = 0;
 
-    for (size_t i = 0; i < PID_MAX; ++i) {
-        if (_pid[i] != 0) {
-            delete _pid[i];
-            _pid[i] = 0;
-        }
+    // Only clear the PID's which were used, reset() is frequently called after each evaluation.
+    const PIDAnalysis zero = PIDAnalysis();
+    for (std::vector<PID>::const_iterator it = _used_pids.begin(); it != _used_pids.end(); ++it) {
+        _pid[*it] = zero;
     }
+    _used_pids.clear();
+    _clock_pids.clear();
 }
 
 
@@ -169,10 +157,8 @@ void ts::PCRAnalyzer::resetAndUseDTS(size_t min_pid, size_t min_dts)
 void ts::PCRAnalyzer::processDiscountinuity()
 {
     // All collected PCR becomes invalid since at least one packet is missing.
-    for (size_t i = 0; i < PID_MAX; ++i) {
-        if (_pid[i] != 0) {
-            _pid[i]->last_pcr_value = 0;
-        }
+    for (std::vector<PID>::const_iterator it = _clock_pids.begin(); it != _clock_pids.end(); ++it) {
+        _pid[*it].last_pcr_value = 0;
     }
 }
 
@@ -200,14 +186,14 @@ ts::BitRate ts::PCRAnalyzer::bitrate204() const
 
 ts::BitRate ts::PCRAnalyzer::bitrate188(PID pid) const
 {
-    return pid >= PID_MAX || _ts_bitrate_cnt == 0 || _ts_pkt_cnt == 0 || _pid[pid] == 0 ? 0 :
-        BitRate((_ts_bitrate_188 * _pid[pid]->ts_pkt_cnt) / (_ts_bitrate_cnt * _ts_pkt_cnt));
+    return pid >= PID_MAX || _ts_bitrate_cnt == 0 || _ts_pkt_cnt == 0 ? 0 :
+        BitRate((_ts_bitrate_188 * _pid[pid].ts_pkt_cnt) / (_ts_bitrate_cnt * _ts_pkt_cnt));
 }
 
 ts::BitRate ts::PCRAnalyzer::bitrate204(PID pid) const
 {
-    return pid >= PID_MAX || _ts_bitrate_cnt == 0 || _ts_pkt_cnt == 0 || _pid[pid] == 0 ? 0 :
-        BitRate((_ts_bitrate_204 * _pid[pid]->ts_pkt_cnt) / (_ts_bitrate_cnt * _ts_pkt_cnt));
+    return pid >= PID_MAX || _ts_bitrate_cnt == 0 || _ts_pkt_cnt == 0 ? 0 :
+        BitRate((_ts_bitrate_204 * _pid[pid].ts_pkt_cnt) / (_ts_bitrate_cnt * _ts_pkt_cnt));
 }
 
 
@@ -217,7 +203,7 @@ ts::BitRate ts::PCRAnalyzer::bitrate204(PID pid) const
 
 ts::PacketCounter ts::PCRAnalyzer::packetCount(PID pid) const
 {
-    return pid >= PID_MAX || _pid[pid] == 0 ? 0 : _pid[pid]->ts_pkt_cnt;
+    return pid >= PID_MAX ? 0 : _pid[pid].ts_pkt_cnt;
 }
 
 
@@ -237,11 +223,11 @@ void ts::PCRAnalyzer::getStatus(Status& stat) const
 
 
 //----------------------------------------------------------------------------
-// Feed the PCR analyzer with a new transport packet.
+// Analyze one packet, common code for feedPacket() and feedPackets().
 // Return true if we have collected enough packet to evaluate TS bitrate.
 //----------------------------------------------------------------------------
 
-bool ts::PCRAnalyzer::feedPacket(const TSPacket& pkt)
+inline bool ts::PCRAnalyzer::analyzePacket(const TSPacket& pkt)
 {
     // Count one more packet in the TS
     _ts_pkt_cnt++;
@@ -252,43 +238,40 @@ bool ts::PCRAnalyzer::feedPacket(const TSPacket& pkt)
         return _bitrate_valid;
     }
 
+    // Decode the header and the adaptation field flags once.
+    // Most packets have no adaptation field and no PCR, they are processed in a few branches.
+    const uint8_t b3 = pkt.b[3];
+    const size_t af_size = (b3 & 0x20) != 0 ? pkt.b[4] : 0;
+    const uint8_t af_flags = af_size > 0 ? pkt.b[5] : 0;
+    const uint8_t continuity_cnt = b3 & 0x0F;
+
     // Find PID context
     const PID pid = pkt.getPID();
     assert(pid < PID_MAX);
-
-    PIDAnalysis* ps = _pid[pid];
-    if (ps == 0) {
-        ps = _pid[pid] = new PIDAnalysis;
-    }
-
-    // Count one more packet in the PID
-    ps->ts_pkt_cnt++;
+    PIDAnalysis& ps(_pid[pid]);
 
     // Process discontinuities. If a discontinuity is discovered,
     // the PCR calculation across this packet is not valid.
     bool broken_rate = false;
-    uint8_t continuity_cnt = pkt.getCC();
 
-    if (ps->ts_pkt_cnt == 1) {
+    if (ps.ts_pkt_cnt++ == 0) {
         // First packet on this PID, initialize continuity
-        ps->cur_continuity = continuity_cnt;
+        _used_pids.push_back(pid);
     }
-    else if (pkt.getDiscontinuityIndicator()) {
+    else if ((af_flags & 0x80) != 0) {
         // Expected discontinuity
         broken_rate = true;
     }
-    else if (pkt.hasPayload()) {
-        // Packet has payload. Compute next continuity counter.
-        uint8_t next_cont((ps->cur_continuity + 1) & 0x0F);
-        // The countinuity counter must be either identical to previous one
-        // (duplicated packet) or adjacent.
-        broken_rate = continuity_cnt != ps->cur_continuity && continuity_cnt != next_cont;
+    else if ((b3 & 0x10) != 0) {
+        // Packet has payload. The countinuity counter must be either identical
+        // to previous one (duplicated packet) or adjacent.
+        broken_rate = continuity_cnt != ps.cur_continuity && continuity_cnt != ((ps.cur_continuity + 1) & 0x0F);
     }
-    else if (continuity_cnt != ps->cur_continuity) {
+    else {
         // Packet has no payload -> should have same counter
-        broken_rate = continuity_cnt != ps->cur_continuity;
+        broken_rate = continuity_cnt != ps.cur_continuity;
     }
-    ps->cur_continuity = continuity_cnt;
+    ps.cur_continuity = continuity_cnt;
 
     // In case of suspected packet loss, reset calculations
     if (broken_rate) {
@@ -296,27 +279,27 @@ bool ts::PCRAnalyzer::feedPacket(const TSPacket& pkt)
     }
 
     // Process PCR (or DTS)
-    if ((_use_dts && pkt.hasDTS()) || (!_use_dts && pkt.hasPCR())) {
+    if (_use_dts ? pkt.hasDTS() : (af_flags & 0x10) != 0) {
 
         // Get PCR value (or converted DTS)
-        const uint64_t pcr = _use_dts ? pkt.getDTS() * SYSTEM_CLOCK_SUBFACTOR : pkt.getPCR();
+        const uint64_t pcr = _use_dts ? pkt.getDTS() * SYSTEM_CLOCK_SUBFACTOR : (af_size >= 7 ? GetPCR(pkt.b + 6) : 0);
 
         // If last PCR valid, compute transport rate between the two
-        if (ps->last_pcr_value != 0 && ps->last_pcr_value < pcr) {
+        if (ps.last_pcr_value != 0 && ps.last_pcr_value < pcr) {
 
             // Compute transport rate in b/s since last PCR
-            uint64_t ts_bitrate_188 =
-                ((_ts_pkt_cnt - ps->last_pcr_packet) * SYSTEM_CLOCK_FREQ * PKT_SIZE * 8) /
-                (pcr - ps->last_pcr_value);
-            uint64_t ts_bitrate_204 =
-                ((_ts_pkt_cnt - ps->last_pcr_packet) * SYSTEM_CLOCK_FREQ * PKT_RS_SIZE * 8) /
-                (pcr - ps->last_pcr_value);
-
-            // Per-PID statistics:
-            ps->ts_bitrate_188 += ts_bitrate_188;
-            ps->ts_bitrate_204 += ts_bitrate_204;
-            ps->ts_bitrate_cnt++;
-            if (ps->ts_bitrate_cnt == 1) {
+            const uint64_t ts_bitrate_188 =
+                ((_ts_pkt_cnt - ps.last_pcr_packet) * SYSTEM_CLOCK_FREQ * PKT_SIZE * 8) /
+                (pcr - ps.last_pcr_value);
+            const uint64_t ts_bitrate_204 =
+                ((_ts_pkt_cnt - ps.last_pcr_packet) * SYSTEM_CLOCK_FREQ * PKT_RS_SIZE * 8) /
+                (pcr - ps.last_pcr_value);
+
+            // Per-PID statistics, only the count of values is needed.
+            if (ps.ts_bitrate_cnt < 0xFFFFFFFF) {
+                ps.ts_bitrate_cnt++;
+            }
+            if (ps.ts_bitrate_cnt == 1) {
                 // First PCR result on this PID
                 _pcr_pids++;
             }
@@ -327,16 +310,93 @@ bool ts::PCRAnalyzer::feedPacket(const TSPacket& pkt)
             _ts_bitrate_cnt++;
 
             // Check if we got enough values for this PID
-            if (ps->ts_bitrate_cnt == _min_pcr) {
+            if (ps.ts_bitrate_cnt == _min_pcr) {
                 _completed_pids++;
                 _bitrate_valid = _completed_pids >= _min_pid;
             }
         }
 
         // Save PCR for next calculation
-        ps->last_pcr_value = pcr;
-        ps->last_pcr_packet = _ts_pkt_cnt;
+        ps.last_pcr_value = pcr;
+        ps.last_pcr_packet = _ts_pkt_cnt;
+        if (!ps.has_clock) {
+            ps.has_clock = true;
+            _clock_pids.push_back(pid);
+        }
     }
 
     return _bitrate_valid;
 }
+
+
+//----------------------------------------------------------------------------
+// Feed the PCR analyzer with a new transport packet.
+// Return true if we have collected enough packet to evaluate TS bitrate.
+//----------------------------------------------------------------------------
+
+bool ts::PCRAnalyzer::feedPacket(const TSPacket& pkt)
+{
+    return analyzePacket(pkt);
+}
+
+
+//----------------------------------------------------------------------------
+// Feed the PCR analyzer with contiguous packets, analyzed in place.
+//----------------------------------------------------------------------------
+
+size_t ts::PCRAnalyzer::feedPackets(const TSPacket* pkt, size_t count, bool stop_when_valid)
+{
+    // Distance in packets of the prefetched header. Each packet header is on a
+    // distinct cache line, the hardware prefetcher does not always follow.
+    static const size_t PREFETCH_STRIDE = 8;
+
+    for (size_t i = 0; i < count; ++i) {
+#if defined(TS_GCC)
+        if (i + PREFETCH_STRIDE < count) {
+            __builtin_prefetch(pkt[i + PREFETCH_STRIDE].b);
+        }
+#endif
+        if (analyzePacket(pkt[i]) && stop_when_valid) {
+            return i + 1;
+        }
+    }
+    return count;
+}
+
+
+//----------------------------------------------------------------------------
+// Feed the PCR analyzer with evenly spaced regions of packets.
+//----------------------------------------------------------------------------
+
+bool ts::PCRAnalyzer::feedRegions(const TSPacket* pkt, size_t count, size_t regions)
+{
+    if (regions <= 1) {
+        feedPackets(pkt, count, true);
+        return _bitrate_valid;
+    }
+
+    // Number of computed bitrates to collect in each region, rounded up.
+    // One more PCR is needed in each region to restart the computation.
+    const uint64_t share = (_min_pid * _min_pcr + regions - 1) / regions;
+
+    for (size_t reg = 0; reg < regions && !_bitrate_valid; ++reg) {
+
+        const size_t first = size_t((uint64_t(count) * reg) / regions);
+        const size_t end = size_t((uint64_t(count) * (reg + 1)) / regions);
+        const uint64_t target = _ts_bitrate_cnt + share;
+
+        // The previous PCR's are not related to this region.
+        processDiscountinuity();
+
+        for (size_t i = first; i < end && _ts_bitrate_cnt < target && !_bitrate_valid; i += 64) {
+            feedPackets(pkt + i, std::min<size_t>(64, end - i), true);
+        }
+    }
+
+    // With several PID's, the PCR's are not evenly distributed in all PID's.
+    // The evaluation is considered as valid when all regions brought their share.
+    if (!_bitrate_valid) {
+        _bitrate_valid = _ts_bitrate_cnt >= share * regions && _pcr_pids >= _min_pid;
+    }
+    return _bitrate_valid;
+}
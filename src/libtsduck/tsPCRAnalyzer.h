@@ -93,6 +93,33 @@ namespace ts {
         //!
         bool feedPacket(const TSPacket& pkt);
 
+        //!
+        //! Feed the analyzer with contiguous TS packets, typically in a memory-mapped file.
+        //! The packets are analyzed in place, only their headers and adaptation fields
+        //! (and PES headers with DTS) are accessed. The headers of the next packets are
+        //! prefetched to hide the memory latency.
+        //! @param [in] pkt Address of the first packet.
+        //! @param [in] count Number of packets.
+        //! @param [in] stop_when_valid If true, stop as soon as enough packets are collected.
+        //! @return The number of analyzed packets.
+        //!
+        size_t feedPackets(const TSPacket* pkt, size_t count, bool stop_when_valid = true);
+
+        //!
+        //! Feed the analyzer with evenly spaced regions of contiguous TS packets.
+        //! Typically used to evaluate the bitrate of a large memory-mapped file in
+        //! almost constant time. The area is split in @a regions parts. The beginning
+        //! of each part is analyzed until it brings its share of the required PCR's.
+        //! The evaluation is valid when all regions brought their share, even if the
+        //! PCR's are unevenly distributed among PID's.
+        //! @param [in] pkt Address of the first packet.
+        //! @param [in] count Number of packets.
+        //! @param [in] regions Number of regions to analyze. With zero or one, the area
+        //! is analyzed from the beginning until enough packets are collected.
+        //! @return True if we have collected enough packet to evaluate TS bitrate.
+        //!
+        bool feedRegions(const TSPacket* pkt, size_t count, size_t regions);
+
         //!
         //! Check if we have collected enough packet to evaluate TS bitrate.
         //! @return True if we have collected enough packet to evaluate TS bitrate.
@@ -171,21 +198,21 @@ namespace ts {
         // Process a discontinuity in the transport stream
         void processDiscountinuity();
 
-        // Analysis of one PID
+        // Analysis of one PID. The structure is kept small (32 bytes, two per cache line)
+        // so that all PID's are stored in one flat array without per-PID allocation.
         struct PIDAnalysis
         {
-            // Constructor:
-            PIDAnalysis();
-            // Members:
             uint64_t ts_pkt_cnt;       // Count of TS packets
+            uint64_t last_pcr_value;   // Last PCR value in this PID, zero if none or invalidated
+            uint64_t last_pcr_packet;  // Packet index containing last PCR
+            uint32_t ts_bitrate_cnt;   // Count of computed TS bitrates (saturated)
             uint8_t  cur_continuity;   // Current continuity counter
-            uint64_t last_pcr_value;   // Last PCR value in this PID
-            uint64_t last_pcr_packet;  // Packet index containing first PCR
-            uint64_t ts_bitrate_188;   // Sum of all computed TS bitrates (188-byte)
-            uint64_t ts_bitrate_204;   // Sum of all computed TS bitrates (204-byte)
-            uint64_t ts_bitrate_cnt;   // Count of computed TS bitrates
+            bool     has_clock;        // Already registered in _clock_pids
         };
 
+        // Analyze one packet, common code for feedPacket() and feedPackets().
+        inline bool analyzePacket(const TSPacket& pkt);
+
         // Private members:
         bool     _use_dts;            // Use DTS instead of PCR
         size_t   _min_pid;            // Min # of PID
@@ -197,6 +224,8 @@ namespace ts {
         uint64_t _ts_bitrate_cnt;     // Count of computed bitrates
         size_t   _completed_pids;     // Number of PIDs with enough PCRs
         size_t   _pcr_pids;           // Number of PIDs with PCRs
-        PIDAnalysis* _pid[PID_MAX];   // Per-PID stats
+        std::vector<PIDAnalysis> _pid;        // Per-PID stats, flat array indexed by PID
+        std::vector<PID>         _used_pids;  // PID's with packets, the only ones to clear on reset
+        std::vector<PID>         _clock_pids; // PID's with PCR's (or DTS's), to invalidate on discontinuity
     };
 }
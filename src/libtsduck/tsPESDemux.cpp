@@ -35,18 +35,21 @@
 #include "tsMemoryUtils.h"
 TSDUCK_SOURCE;
 
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::PESDemux::MIN_PES_SIZE;
+const size_t ts::PESDemux::SAMPLING_STABLE_PES;
+const size_t ts::PESDemux::MAX_FREE_BUFFERS;
+#endif
+
 
 //----------------------------------------------------------------------------
 // Delimiters
 //----------------------------------------------------------------------------
 
 namespace {
-
-    // Start code prefix for ISO 11172-2 (MPEG-1 video) and ISO 13818-2 (MPEG-2 video)
-    const uint8_t StartCodePrefix[] = {0x00, 0x00, 0x01};
-
-    // End of AVC NALunit delimiter
-    const uint8_t Zero3[] = {0x00, 0x00, 0x00};
+    // Size of start code prefix 00 00 01 for ISO 11172-2 (MPEG-1 video), ISO 13818-2 (MPEG-2 video), AVC.
+    // The end of an AVC NALunit is the next start code prefix or a 00 00 00 delimiter.
+    const size_t StartCodePrefixSize = 3;
 }
 
 
@@ -57,7 +60,10 @@ namespace {
 ts::PESDemux::PESDemux(PESHandlerInterface* pes_handler, const PIDSet& pid_filter) :
     SuperClass(pid_filter),
     _pes_handler(pes_handler),
-    _pids()
+    _pids(),
+    _max_pes_size(std::numeric_limits<size_t>::max()),
+    _free_buffers(),
+    _sampling_interval(0)
 {
 }
 
@@ -81,12 +87,18 @@ ts::PESDemux::PIDContext::PIDContext() :
     sync(false),
     first_pkt(0),
     last_pkt(0),
-    ts(new ByteBlock()),
+    pts(INVALID_PTS),
+    ts(),
+    last_size(0),
+    truncated(false),
     audio(),
     video(),
     avc(),
     ac3(),
-    ac3_count(0)
+    ac3_count(0),
+    stable_count(0),
+    suspended(false),
+    sample_pts(0)
 {
 }
 
@@ -98,13 +110,65 @@ ts::PESDemux::PIDContext::PIDContext() :
 void ts::PESDemux::immediateReset()
 {
     SuperClass::immediateReset();
-    _pids.clear();
+    while (!_pids.empty()) {
+        releasePIDContext(_pids.begin());
+    }
 }
 
 void ts::PESDemux::immediateResetPID(PID pid)
 {
     SuperClass::immediateResetPID(pid);
-    _pids.erase(pid);
+    const PIDContextMap::iterator pci(_pids.find(pid));
+    if (pci != _pids.end()) {
+        releasePIDContext(pci);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Release a PID context, recycle its buffer.
+//----------------------------------------------------------------------------
+
+void ts::PESDemux::releasePIDContext(PIDContextMap::iterator pci)
+{
+    ByteBlockPtr& buffer(pci->second.ts);
+    if (!buffer.isNull() && buffer.count() == 1 && _free_buffers.size() < MAX_FREE_BUFFERS) {
+        buffer->clear();
+        _free_buffers.push_back(buffer);
+    }
+    _pids.erase(pci);
+}
+
+
+//----------------------------------------------------------------------------
+// Prepare the buffer of a PID context for a new PES packet.
+//----------------------------------------------------------------------------
+
+void ts::PESDemux::startPESBuffer(PIDContext& pc, const uint8_t* payload, size_t size)
+{
+    // The buffer of the previous PES packet is reused, unless a handler kept
+    // a reference to it (using a shared copy of the PESPacket for instance).
+    if (pc.ts.isNull() || pc.ts.count() > 1) {
+        if (_free_buffers.empty()) {
+            pc.ts = new ByteBlock();
+        }
+        else {
+            pc.ts = _free_buffers.back();
+            _free_buffers.pop_back();
+        }
+    }
+
+    // Right-size the buffer from the PES_packet_length when present (usually in audio PES packets)
+    // or from the size of the previous PES packet on the PID (unbounded video PES packets).
+    const size_t pes_length = size >= 6 ? GetUInt16(payload + 4) : 0;
+    size_t expected = std::min(pes_length > 0 ? 6 + pes_length : pc.last_size, _max_pes_size);
+    if (pc.ts->capacity() < expected) {
+        // A bit more than the previous PES packet, to absorb small variations.
+        pc.ts->reserve(pes_length > 0 ? expected : expected + expected / 8);
+    }
+
+    pc.truncated = size > _max_pes_size;
+    pc.ts->copy(payload, std::min(size, _max_pes_size));
 }
 
 
@@ -202,12 +266,35 @@ void ts::PESDemux::processPacket(const TSPacket& pkt)
         pc_exists = pci != _pids.end();
     }
 
+    // In sampling mode, a suspended PID is only checked for the next sample:
+    // a discontinuity or a PTS which is far enough from the last analyzed one.
+    if (pc_exists && pci->second.suspended) {
+        PIDContext& pc(pci->second);
+        const bool discontinuity = pkt.getDiscontinuityIndicator() || (pkt.getCC() != pc.continuity && pkt.getCC() != (pc.continuity + 1) % CC_MAX);
+        pc.continuity = pkt.getCC();
+        if (discontinuity) {
+            pc.suspended = false;
+            pc.stable_count = 0;
+        }
+        else if (pkt.getPUSI() && pkt.hasPTS()) {
+            // PTS may slightly go backward in video PID's, ignore such differences.
+            const uint64_t diff = (pkt.getPTS() - pc.sample_pts) & PTS_DTS_MASK;
+            if (diff < PTS_DTS_SCALE / 2 && diff >= uint64_t(_sampling_interval) * SYSTEM_CLOCK_SUBFREQ / MilliSecPerSec) {
+                pc.suspended = false;
+                pc.stable_count = 0;
+            }
+        }
+        if (pc.suspended) {
+            return;
+        }
+    }
+
     // If the packet is scrambled, we cannot get PES content.
     // Usually, if the PID becomes scrambled, it will remain scrambled
     // for a while => release context.
     if (pkt.getScrambling() != SC_CLEAR) {
         if (pc_exists) {
-            _pids.erase (pid);
+            releasePIDContext(pci);
         }
         return;
     }
@@ -225,13 +312,14 @@ void ts::PESDemux::processPacket(const TSPacket& pkt)
             PIDContext& pc(_pids[pid]);
             pc.continuity = pkt.getCC();
             pc.sync = true;
-            pc.ts->copy(pl, pl_size);
+            startPESBuffer(pc, pl, pl_size);
             pc.first_pkt = _packet_count;
             pc.last_pkt = _packet_count;
+            pc.pts = pkt.hasPTS() ? pkt.getPTS() : INVALID_PTS;
         }
         else if (pc_exists) {
             // This PID does not contain PES packet, reset context
-            _pids.erase(pid);
+            releasePIDContext(pci);
         }
         // PUSI packet processing done.
         return;
@@ -256,25 +344,17 @@ void ts::PESDemux::processPacket(const TSPacket& pkt)
     }
     pc.continuity = pkt.getCC();
 
-    // Append the TS payload in PID context.
-    size_t capacity = pc.ts->capacity();
-    if (pc.ts->size() + pl_size > capacity) {
-        // Internal reallocation needed in ts buffer.
-        // Do not allow implicit reallocation, do it manually for better performance.
-        // Use two predefined thresholds: 64 kB and 512 kB. Above that, double the size.
-        // Note that 64 kB is OK for audio PIDs. Video PIDs are usually unbounded. The
-        // maximum observed PES rate is 2 PES/s, meaning 512 kB / PES at 8 Mb/s.
-        if (capacity < 64 * 1024) {
-            pc.ts->reserve(64 * 1024);
-        }
-        else if (capacity < 512 * 1024) {
-            pc.ts->reserve(512 * 1024);
-        }
-        else {
-            pc.ts->reserve(2 * capacity);
+    // Append the TS payload in PID context, up to the maximum PES size.
+    // The buffer is right-sized at the start of the PES packet, it grows
+    // geometrically when the PES packet is larger than expected.
+    if (!pc.truncated) {
+        const size_t room = _max_pes_size - pc.ts->size();
+        if (pl_size > room) {
+            pl_size = room;
+            pc.truncated = true;
         }
+        pc.ts->append(pl, pl_size);
     }
-    pc.ts->append(pl, pl_size);
 
     // Last TS packet containing actual data for this PES packet
     pc.last_pkt = _packet_count;
@@ -299,6 +379,9 @@ void ts::PESDemux::handlePESPacket(const PESPacket& packet)
 
 void ts::PESDemux::processPESPacket(PID pid, PIDContext& pc)
 {
+    // Size hint for the next PES packet on this PID.
+    pc.last_size = pc.ts->size();
+
     // Build a PES packet object around the TS buffer
     PESPacket pp(pc.ts, pid);
     if (!pp.isValid()) {
@@ -312,6 +395,10 @@ void ts::PESDemux::processPESPacket(PID pid, PIDContext& pc)
     pp.setFirstTSPacketIndex(pc.first_pkt);
     pp.setLastTSPacketIndex(pc.last_pkt);
 
+    // Attributes status of this PES packet (sampling mode).
+    bool new_attributes = false;
+    bool no_attributes = false;
+
     // Mark that we are in the context of handlers.
     // This is used to prevent the destruction of PID contexts during
     // the execution of a handler.
@@ -330,16 +417,23 @@ void ts::PESDemux::processPESPacket(PID pid, PIDContext& pc)
             // The beginning of the payload is already a start code prefix.
             for (size_t offset = 0; offset < psize; ) {
                 // Look for next start code
-                const void* pnext = LocatePattern (pdata + offset + 1, psize - offset - 1, StartCodePrefix, sizeof(StartCodePrefix));
+                const void* pnext = LocateZeroZero(pdata + offset + 1, psize - offset - 1, 0x01);
                 size_t next = pnext == 0 ? psize : reinterpret_cast <const uint8_t*> (pnext) - pdata;
+                // The last unit of a truncated PES packet is incomplete
+                if (pnext == 0 && pc.truncated) {
+                    break;
+                }
                 // Invoke handler
                 if (_pes_handler != 0) {
                     _pes_handler->handleVideoStartCode (*this, pp, pdata[offset+3], offset, next - offset);
                 }
                 // Accumulate info from video units to extract video attributes.
                 // If new attributes were found, invoke handler.
-                if (pc.video.moreBinaryData (pdata + offset, next - offset) && _pes_handler != 0) {
-                    _pes_handler->handleNewVideoAttributes (*this, pp, pc.video);
+                if (pc.video.moreBinaryData (pdata + offset, next - offset)) {
+                    new_attributes = true;
+                    if (_pes_handler != 0) {
+                        _pes_handler->handleNewVideoAttributes (*this, pp, pc.video);
+                    }
                 }
                 // Move to next start code
                 offset = next;
@@ -350,22 +444,25 @@ void ts::PESDemux::processPESPacket(PID pid, PIDContext& pc)
         else if (pp.isAVC()) {
             for (size_t offset = 0; offset < psize; ) {
                 // Locate next access unit: starts with 00 00 01 (this start code is not part of the NALunit)
-                const uint8_t* p1 = reinterpret_cast <const uint8_t*> (LocatePattern (pdata + offset, psize - offset,
-                                                                                  StartCodePrefix, sizeof(StartCodePrefix)));
+                const uint8_t* p1 = reinterpret_cast<const uint8_t*>(LocateZeroZero(pdata + offset, psize - offset, 0x01));
                 if (p1 == 0) {
                     break;
                 }
-                offset = p1 - pdata + sizeof(StartCodePrefix);
+                offset = p1 - pdata + StartCodePrefixSize;
                 // Locate end of access unit: ends with 00 00 00, 00 00 01 or end of
-                const uint8_t* p2 = reinterpret_cast <const uint8_t*> (LocatePattern (pdata + offset, psize - offset,
-                                                                                  StartCodePrefix, sizeof(StartCodePrefix)));
-                const uint8_t* p3 = reinterpret_cast <const uint8_t*> (LocatePattern (pdata + offset, psize - offset,
-                                                                                  Zero3, sizeof(Zero3)));
+                // A 00 00 00 after the next start code is useless, search it before p2 only.
+                const uint8_t* p2 = reinterpret_cast<const uint8_t*>(LocateZeroZero(pdata + offset, psize - offset, 0x01));
+                const size_t p3_area = p2 == 0 ? psize - offset : p2 - pdata - offset + 2;
+                const uint8_t* p3 = reinterpret_cast<const uint8_t*>(LocateZeroZero(pdata + offset, p3_area, 0x00));
                 size_t nalunit_size;
                 if (p2 == 0 && p3 == 0) {
+                    // The last NALunit of a truncated PES packet is incomplete
+                    if (pc.truncated) {
+                        break;
+                    }
                     nalunit_size = psize - offset;
                 }
-                else if (p2 == 0 || p3 < p2) {
+                else if (p2 == 0 || (p3 != 0 && p3 < p2)) {
                     nalunit_size = p3 - pdata - offset;
                 }
                 else {
@@ -377,8 +474,11 @@ void ts::PESDemux::processPESPacket(PID pid, PIDContext& pc)
                 }
                 // Accumulate info from access units to extract video attributes.
                 // If new attributes were found, invoke handler.
-                if (pc.avc.moreBinaryData (pdata + offset, nalunit_size) && _pes_handler != 0) {
-                    _pes_handler->handleNewAVCAttributes (*this, pp, pc.avc);
+                if (pc.avc.moreBinaryData (pdata + offset, nalunit_size)) {
+                    new_attributes = true;
+                    if (_pes_handler != 0) {
+                        _pes_handler->handleNewAVCAttributes (*this, pp, pc.avc);
+                    }
                 }
                 // Move to next start code
                 offset += nalunit_size;
@@ -391,8 +491,11 @@ void ts::PESDemux::processPESPacket(PID pid, PIDContext& pc)
             pc.ac3_count++;
             // Accumulate info from audio frames to extract audio attributes.
             // If new attributes were found, invoke handler.
-            if (pc.ac3.moreBinaryData (pdata, psize) && _pes_handler != 0) {
-                _pes_handler->handleNewAC3Attributes (*this, pp, pc.ac3);
+            if (pc.ac3.moreBinaryData (pdata, psize)) {
+                new_attributes = true;
+                if (_pes_handler != 0) {
+                    _pes_handler->handleNewAC3Attributes (*this, pp, pc.ac3);
+                }
             }
         }
 
@@ -400,14 +503,37 @@ void ts::PESDemux::processPESPacket(PID pid, PIDContext& pc)
         else if (IsAudioSID (pp.getStreamId())) {
             // Accumulate info from audio frames to extract audio attributes.
             // If new attributes were found, invoke handler.
-            if (pc.audio.moreBinaryData (pdata, psize) && _pes_handler != 0) {
-                _pes_handler->handleNewAudioAttributes (*this, pp, pc.audio);
+            if (pc.audio.moreBinaryData (pdata, psize)) {
+                new_attributes = true;
+                if (_pes_handler != 0) {
+                    _pes_handler->handleNewAudioAttributes (*this, pp, pc.audio);
+                }
             }
         }
+
+        // Other PES packets do not carry any attribute.
+        else {
+            no_attributes = true;
+        }
     }
     catch (...) {
         afterCallingHandler(false);
         throw;
     }
-    afterCallingHandler(true);
+    if (afterCallingHandler(true)) {
+        return;  // the PID of this packet or the complete demux was reset.
+    }
+
+    // In sampling mode, suspend the analysis when the attributes are stable.
+    // The time of the next sample is based on the PTS of this PES packet.
+    if (_sampling_interval > 0 && pc.pts != INVALID_PTS) {
+        if (new_attributes || (!no_attributes && !pc.audio.isValid() && !pc.video.isValid() && !pc.avc.isValid() && !pc.ac3.isValid())) {
+            pc.stable_count = 0;
+        }
+        else if (++pc.stable_count >= SAMPLING_STABLE_PES) {
+            pc.suspended = true;
+            pc.sync = false;
+            pc.sample_pts = pc.pts;
+        }
+    }
 }
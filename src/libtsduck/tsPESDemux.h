@@ -77,6 +77,59 @@ namespace ts {
             _pes_handler = h;
         }
 
+        //!
+        //! Set the maximum number of bytes which are reassembled in each PES packet.
+        //!
+        //! By default, complete PES packets are reassembled. Applications which only inspect
+        //! the PES headers or the first units of each PES packet (the audio and video
+        //! attributes for instance) should set a limit. The rest of each PES packet is then
+        //! skipped without copy and the handlers receive truncated PES packets. The last
+        //! video unit of a truncated PES packet is not reported since it is incomplete.
+        //!
+        //! @param [in] size Maximum size in bytes of the reassembled part of each PES packet,
+        //! zero for complete PES packets. A complete PES header is always reassembled.
+        //!
+        void setMaxPESSize(size_t size)
+        {
+            _max_pes_size = size == 0 ? std::numeric_limits<size_t>::max() : (size < MIN_PES_SIZE ? MIN_PES_SIZE : size);
+        }
+
+        //!
+        //! Get the maximum number of bytes which are reassembled in each PES packet.
+        //! @return Maximum size in bytes of the reassembled part of each PES packet, zero if unlimited.
+        //!
+        size_t getMaxPESSize() const
+        {
+            return _max_pes_size == std::numeric_limits<size_t>::max() ? 0 : _max_pes_size;
+        }
+
+        //!
+        //! Set the sampling mode of the audio and video attributes.
+        //!
+        //! By default, all PES packets are reassembled and analyzed. In sampling mode, the
+        //! analysis of a PID is suspended as soon as its attributes are stable. It is resumed
+        //! for a new sample when the PTS has progressed by the specified interval or after
+        //! a discontinuity. While suspended, PES packets are not reassembled at all and no
+        //! handler is invoked. The sampling mode is consequently suitable for applications
+        //! which only need the audio and video attributes.
+        //!
+        //! @param [in] interval Interval between samples in milliseconds, based on PTS.
+        //! Zero means no sampling, all PES packets are analyzed.
+        //!
+        void setAttributesSampling(MilliSecond interval)
+        {
+            _sampling_interval = interval < 0 ? 0 : interval;
+        }
+
+        //!
+        //! Get the sampling interval of the audio and video attributes.
+        //! @return Interval between samples in milliseconds, zero if all PES packets are analyzed.
+        //!
+        MilliSecond getAttributesSampling() const
+        {
+            return _sampling_interval;
+        }
+
         //!
         //! Get the current audio attributes on the specified PID.
         //! @param [in] pid The PID to check.
@@ -141,18 +194,24 @@ namespace ts {
             bool            sync;        // We are synchronous in this PID
             PacketCounter   first_pkt;   // Index of first TS packet for current PES packet
             PacketCounter   last_pkt;    // Index of last TS packet for current PES packet
+            uint64_t        pts;         // PTS of current PES packet, INVALID_PTS if not found in first TS packet
             ByteBlockPtr    ts;          // TS payload buffer
+            size_t          last_size;   // Size of previous PES packet, hint for the next buffer
+            bool            truncated;   // Current PES packet exceeds the maximum size
             AudioAttributes audio;       // Current audio attributes
             VideoAttributes video;       // Current video attributes (MPEG-1, MPEG-2)
             AVCAttributes   avc;         // Current AVC attributes
             AC3Attributes   ac3;         // Current AC-3 attributes
             PacketCounter   ac3_count;   // Number of PES packets with contents which looks like AC-3
+            size_t          stable_count; // Number of consecutive PES packets without new attributes (sampling mode)
+            bool            suspended;   // Analysis is suspended until next sample (sampling mode)
+            uint64_t        sample_pts;  // PTS of last analyzed PES packet before suspension (sampling mode)
 
             // Default constructor:
             PIDContext();
 
             // Called when packet synchronization is lost on the pid
-            void syncLost() {sync = false; ts->clear();}
+            void syncLost() {sync = false; truncated = false; ts->clear();}
         };
 
         typedef std::map <PID, PIDContext> PIDContextMap;
@@ -163,9 +222,27 @@ namespace ts {
         // Process a complete PES packet
         void processPESPacket(PID, PIDContext&);
 
+        // Prepare the buffer of a PID context for a new PES packet.
+        void startPESBuffer(PIDContext&, const uint8_t* payload, size_t size);
+
+        // Release a PID context, recycle its buffer.
+        void releasePIDContext(PIDContextMap::iterator);
+
+        // A complete PES header is always reassembled.
+        static const size_t MIN_PES_SIZE = 9 + 255;
+
+        // In sampling mode, number of consecutive PES packets without new attributes before suspending the analysis.
+        static const size_t SAMPLING_STABLE_PES = 32;
+
+        // Maximum number of recycled buffers.
+        static const size_t MAX_FREE_BUFFERS = 16;
+
         // Private members:
-        PESHandlerInterface* _pes_handler;
-        PIDContextMap        _pids;
+        PESHandlerInterface*      _pes_handler;
+        PIDContextMap             _pids;
+        size_t                    _max_pes_size;  // Max reassembled size per PES packet
+        std::vector<ByteBlockPtr> _free_buffers;  // Recycled PES buffers
+        MilliSecond               _sampling_interval;  // Attributes sampling interval, zero if none
 
         // Inacessible operations
         PESDemux(const PESDemux&) = delete;
@@ -66,6 +66,9 @@ ts::PSILogger::PSILogger(PSILoggerArgs& opt, TablesDisplay& display, Report& rep
         return;
     }
 
+    // Validation of section CRC32
+    _demux.setCRCValidation(_opt.ignore_crc32 ? CRC32::IGNORE : CRC32::CHECK);
+
     // Specify the PID filters
     if (!_opt.cat_only) {
         _demux.addPID(PID_PAT);
@@ -45,6 +45,7 @@ ts::PSILoggerArgs::PSILoggerArgs() :
     clear(false),
     cat_only(false),
     dump(false),
+    ignore_crc32(false),
     output()
 {
 }
@@ -82,6 +83,10 @@ void ts::PSILoggerArgs::addHelp(Args& args) const
         u"  --help\n"
         u"      Display this help text.\n"
         u"\n"
+        u"  --ignore-crc32\n"
+        u"      Do not check the CRC32 of input sections. This can be used to analyze\n"
+        u"      sections with incorrect CRC32 or to save CPU time on trusted streams.\n"
+        u"\n"
         u"  -o filename\n"
         u"  --output-file filename\n"
         u"      File name for text output.\n"
@@ -107,6 +112,7 @@ void ts::PSILoggerArgs::defineOptions(Args& args) const
     args.option(u"cat-only",      0);
     args.option(u"clear",        'c');
     args.option(u"dump",         'd');
+    args.option(u"ignore-crc32",  0);
     args.option(u"output-file",  'o', Args::STRING);
 }
 
@@ -122,5 +128,6 @@ void ts::PSILoggerArgs::load(Args& args)
     cat_only = args.present(u"cat-only");
     clear = args.present(u"clear");
     dump = args.present(u"dump");
+    ignore_crc32 = args.present(u"ignore-crc32");
     output = args.value(u"output-file");
 }
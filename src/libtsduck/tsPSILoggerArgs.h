@@ -57,6 +57,7 @@ namespace ts {
         bool    clear;          //!< Clear stream, do not wait for a CAT.
         bool    cat_only;       //!< Only CAT, ignore other PSI.
         bool    dump;           //!< Dump all sections.
+        bool    ignore_crc32;   //!< Do not check CRC32 of input sections.
         UString output;         //!< Destination name file.
 
         //!
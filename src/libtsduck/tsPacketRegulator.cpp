@@ -0,0 +1,216 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "tsPacketRegulator.h"
+TSDUCK_SOURCE;
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const ts::PacketCounter ts::PacketRegulator::DEFAULT_BURST;
+const ts::NanoSecond ts::PacketRegulator::MAX_LATENESS;
+#endif
+
+namespace {
+    // Size of a TS packet in bits x SYSTEM_CLOCK_FREQ.
+    const uint64_t PACKET_CREDIT = uint64_t(ts::PKT_SIZE) * 8 * ts::SYSTEM_CLOCK_FREQ;
+
+    // PCR units are converted in nanoseconds as x 1000 / 27. The reference packet
+    // is moved forward every hour, by a multiple of 27, to avoid overflows.
+    const uint64_t NS_MUL = 1000;
+    const uint64_t NS_DIV = 27;
+    const uint64_t REBASE_TICKS = 3600 * uint64_t(ts::SYSTEM_CLOCK_FREQ);
+}
+
+
+//----------------------------------------------------------------------------
+// Constructor.
+//----------------------------------------------------------------------------
+
+ts::PacketRegulator::PacketRegulator() :
+    _fixed_bitrate(0),
+    _pcr_sync(false),
+    _burst(DEFAULT_BURST),
+    _spin(0),
+    _cur_bitrate(0),
+    _started(false),
+    _clock(),
+    _ticks(0),
+    _ticks_rem(0),
+    _base_ticks(0),
+    _base(),
+    _due(),
+    _now(),
+    _burst_pkt_cnt(0),
+    _burst_count(0),
+    _resync_count(0),
+    _jitter_sum(0),
+    _jitter_max(0)
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Configuration and reset.
+//----------------------------------------------------------------------------
+
+void ts::PacketRegulator::setPCRSynchronous(bool on, PID pcr_pid)
+{
+    _pcr_sync = on;
+    _clock.setPCRPID(pcr_pid);
+}
+
+void ts::PacketRegulator::reset()
+{
+    _cur_bitrate = 0;
+    _started = false;
+    _clock.reset();
+    _ticks = 0;
+    _ticks_rem = 0;
+    _base_ticks = 0;
+    _burst_pkt_cnt = 0;
+    _burst_count = 0;
+    _resync_count = 0;
+    _jitter_sum = 0;
+    _jitter_max = 0;
+}
+
+
+//----------------------------------------------------------------------------
+// Compute the time of the next packet, in PCR units.
+//----------------------------------------------------------------------------
+
+bool ts::PacketRegulator::packetTime(const TSPacket& pkt, BitRate bitrate, uint64_t& ticks)
+{
+    const BitRate br = _fixed_bitrate != 0 ? _fixed_bitrate : bitrate;
+    if (br != _cur_bitrate) {
+        _cur_bitrate = br;
+        _ticks_rem = 0;
+    }
+
+    if (_pcr_sync) {
+        // The bitrate is used until two PCR's are found.
+        _clock.setTSBitRate(br);
+        _clock.feedPacket(pkt);
+        ticks = _clock.currentTime();
+        return _clock.timeKnown();
+    }
+    else if (br == 0) {
+        return false;
+    }
+    else {
+        // The packet starts after the previous ones. Keep the remainder to avoid drifting.
+        ticks = _ticks;
+        _ticks += PACKET_CREDIT / br;
+        _ticks_rem += PACKET_CREDIT % br;
+        if (_ticks_rem >= br) {
+            _ticks++;
+            _ticks_rem -= br;
+        }
+        return true;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Wait until the due time of the current burst.
+//----------------------------------------------------------------------------
+
+void ts::PacketRegulator::waitDue()
+{
+    _now.getSystemTime();
+    if (_now >= _due) {
+        // Already late.
+    }
+    else if (_spin == 0) {
+        _due.wait();
+        _now.getSystemTime();
+    }
+    else {
+        // Sleep until shortly before the due time, then spin.
+        if (_due - _now > _spin) {
+            _now = _due;
+            _now -= _spin;
+            _now.wait();
+        }
+        do {
+            _now.getSystemTime();
+        } while (_now < _due);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Regulate one packet.
+//----------------------------------------------------------------------------
+
+bool ts::PacketRegulator::regulate(const TSPacket& pkt, BitRate bitrate, bool& flush)
+{
+    uint64_t ticks = 0;
+    if (!packetTime(pkt, bitrate, ticks)) {
+        // Restart from current time when the time of the packets becomes known again.
+        _started = false;
+        return false;
+    }
+
+    if (!_started) {
+        _started = true;
+        _base.getSystemTime();
+        _base_ticks = ticks;
+        _burst_pkt_cnt = 0;
+    }
+
+    if (_burst_pkt_cnt == 0) {
+        // Start of a new burst, compute the absolute due time of its first packet.
+        if (ticks - _base_ticks >= REBASE_TICKS) {
+            const uint64_t delta = (ticks - _base_ticks) - (ticks - _base_ticks) % NS_DIV;
+            _base += NanoSecond(delta * NS_MUL / NS_DIV);
+            _base_ticks += delta;
+        }
+        _due = _base;
+        _due += NanoSecond((ticks - _base_ticks) * NS_MUL / NS_DIV);
+
+        waitDue();
+
+        const NanoSecond late = _now - _due;
+        if (late > MAX_LATENESS) {
+            // Too late, do not try to catch up, restart from now.
+            _base = _now;
+            _base_ticks = ticks;
+            _resync_count++;
+        }
+        else {
+            _burst_count++;
+            _jitter_sum += late;
+            _jitter_max = std::max(_jitter_max, late);
+        }
+        _burst_pkt_cnt = _burst;
+        flush = true;
+    }
+
+    _burst_pkt_cnt--;
+    return true;
+}
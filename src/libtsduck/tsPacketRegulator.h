@@ -0,0 +1,183 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//!
+//!  @file
+//!  Regulation of a packet flow on a time reference.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsTSPacket.h"
+#include "tsMonotonic.h"
+#include "tsInjectionScheduler.h"
+
+namespace ts {
+    //!
+    //! Regulation of a packet flow on a time reference.
+    //!
+    //! Each packet has a due time, in nanoseconds, relative to the start of the
+    //! regulation. The due time is computed either from a fixed bitrate or from the
+    //! PCR's of the stream, in which case a variable bitrate stream is regulated
+    //! according to its own time line. The packets are released by bursts. At the
+    //! beginning of each burst, the regulator waits until the absolute due time of
+    //! the first packet of the burst. Because the due times are absolute, the
+    //! rounding errors and wake-up latencies do not accumulate.
+    //!
+    //! A system sleep is woken up with some latency. To reduce the jitter, the
+    //! regulator can sleep until a short delay before the due time and then spin
+    //! on the monotonic clock until the due time. This reduces the jitter at the
+    //! expense of some CPU load.
+    //!
+    //! The lateness of the regulator, the difference between the actual release
+    //! time of a burst and its due time, is measured and reported as output jitter.
+    //!
+    class TSDUCKDLL PacketRegulator
+    {
+    public:
+        //!
+        //! Default number of packets in a burst.
+        //!
+        static const PacketCounter DEFAULT_BURST = 16;
+
+        //!
+        //! Maximum lateness, in nanoseconds, before the regulation is resynchronized.
+        //! When the packets arrive too late, typically after an input stall, the
+        //! late packets are not sent as a large burst, the time reference is reset.
+        //!
+        static const NanoSecond MAX_LATENESS = 100 * NanoSecPerMilliSec;
+
+        //!
+        //! Constructor.
+        //!
+        PacketRegulator();
+
+        //!
+        //! Set a fixed bitrate.
+        //! @param [in] bitrate Fixed regulation bitrate in bits/second. Zero means
+        //! that the bitrate which is passed to regulate() is used.
+        //!
+        void setBitRate(BitRate bitrate) { _fixed_bitrate = bitrate; }
+
+        //!
+        //! Use the PCR's of the stream as time reference instead of the bitrate.
+        //! Before two PCR's are found, the bitrate is used.
+        //! @param [in] on If true, regulate on PCR's.
+        //! @param [in] pcr_pid The reference PID for PCR's. PID_NULL means the first PID which contains PCR's.
+        //!
+        void setPCRSynchronous(bool on, PID pcr_pid = PID_NULL);
+
+        //!
+        //! Set the number of packets in a burst.
+        //! @param [in] count Number of packets in a burst. One means that each packet is individually regulated.
+        //!
+        void setBurst(PacketCounter count) { _burst = std::max<PacketCounter>(1, count); }
+
+        //!
+        //! Set the spin threshold.
+        //! @param [in] spin Delay in nanoseconds before the due time, during which the regulator
+        //! spins on the monotonic clock instead of sleeping. Zero means never spin.
+        //!
+        void setSpinThreshold(NanoSecond spin) { _spin = std::max<NanoSecond>(0, spin); }
+
+        //!
+        //! Restart the regulation, reset the time reference and the statistics.
+        //!
+        void reset();
+
+        //!
+        //! Regulate one packet. Wait until the due time of the packet if it starts a burst.
+        //! @param [in] pkt The packet to regulate.
+        //! @param [in] bitrate The current bitrate of the stream, zero if unknown.
+        //! Ignored when a fixed bitrate was set.
+        //! @param [out] flush Set to true when a burst starts, after waiting.
+        //! @return True if the packet is regulated. False if the time of the packet
+        //! is unknown (no bitrate and no PCR) and the packet is not regulated.
+        //!
+        bool regulate(const TSPacket& pkt, BitRate bitrate, bool& flush);
+
+        //!
+        //! Get the current regulation bitrate.
+        //! @return The fixed or last known bitrate, zero if unknown.
+        //!
+        BitRate currentBitRate() const { return _cur_bitrate; }
+
+        //!
+        //! Get the number of bursts which were released on time.
+        //! @return The number of bursts since the start of the regulation.
+        //!
+        PacketCounter burstCount() const { return _burst_count; }
+
+        //!
+        //! Get the number of resynchronizations after excessive lateness.
+        //! @return The number of resynchronizations since the start of the regulation.
+        //!
+        PacketCounter resyncCount() const { return _resync_count; }
+
+        //!
+        //! Get the mean output jitter.
+        //! @return The mean lateness of the bursts in nanoseconds.
+        //!
+        NanoSecond meanJitter() const { return _burst_count == 0 ? 0 : _jitter_sum / NanoSecond(_burst_count); }
+
+        //!
+        //! Get the maximum output jitter.
+        //! @return The maximum lateness of a burst in nanoseconds.
+        //!
+        NanoSecond maxJitter() const { return _jitter_max; }
+
+    private:
+        BitRate            _fixed_bitrate;  // Fixed bitrate, zero means use the stream bitrate.
+        bool               _pcr_sync;       // Regulate on PCR's.
+        PacketCounter      _burst;          // Number of packets per burst.
+        NanoSecond         _spin;           // Spin threshold before due time.
+        BitRate            _cur_bitrate;    // Current bitrate.
+        bool               _started;        // Time reference is set.
+        InjectionScheduler _clock;          // PCR-based packet clock, without component.
+        uint64_t           _ticks;          // Time of current packet in PCR units (bitrate mode).
+        uint64_t           _ticks_rem;      // Remainder of _ticks, in units of 1/bitrate.
+        uint64_t           _base_ticks;     // Time of reference packet in PCR units.
+        Monotonic          _base;           // Due time of reference packet.
+        Monotonic          _due;            // Due time of current burst.
+        Monotonic          _now;            // Current time.
+        PacketCounter      _burst_pkt_cnt;  // Packets before end of current burst.
+        PacketCounter      _burst_count;    // Number of released bursts.
+        PacketCounter      _resync_count;   // Number of resynchronizations.
+        NanoSecond         _jitter_sum;     // Sum of burst lateness.
+        NanoSecond         _jitter_max;     // Max burst lateness.
+
+        // Compute the time of the next packet, in PCR units. Return false if unknown.
+        bool packetTime(const TSPacket& pkt, BitRate bitrate, uint64_t& ticks);
+
+        // Wait until _due, sleeping then spinning. Return with _now set.
+        void waitDue();
+
+        // Inaccessible operations.
+        PacketRegulator(const PacketRegulator&) = delete;
+        PacketRegulator& operator=(const PacketRegulator&) = delete;
+    };
+}
@@ -48,7 +48,10 @@ ts::Packetizer::Packetizer (PID pid, SectionProviderInterface* provider) :
     _next_byte (0),
     _packet_count (0),
     _section_out_count (0),
-    _section_in_count (0)
+    _section_in_count (0),
+    _tight_packing (false),
+    _cache(),
+    _cached(0)
 {
 }
 
@@ -63,6 +66,39 @@ void ts::Packetizer::reset()
 {
     _section.clear();
     _next_byte = 0;
+    _cache.clear();
+    _cached = 0;
+}
+
+
+//----------------------------------------------------------------------------
+// Get or create the cache of a section.
+//----------------------------------------------------------------------------
+
+ts::Packetizer::CachedSection* ts::Packetizer::getCache(const SectionPtr& section)
+{
+    CachedSectionMap::iterator it(_cache.find(section.pointer()));
+
+    if (it == _cache.end()) {
+        // New section. Drop the cache of sections which are no longer used
+        // elsewhere, they will never be provided again.
+        for (CachedSectionMap::iterator del = _cache.begin(); del != _cache.end(); ) {
+            if (del->second.section.count() <= 1) {
+                _cache.erase(del++);
+            }
+            else {
+                ++del;
+            }
+        }
+        it = _cache.insert(std::make_pair(section.pointer(), CachedSection(section, _pid))).first;
+    }
+    else if (it->second.pid != _pid) {
+        // PID has changed, previous packets are unusable.
+        it->second.pid = _pid;
+        it->second.packets.clear();
+        it->second.valid.clear();
+    }
+    return &it->second;
 }
 
 
@@ -84,9 +120,19 @@ void ts::Packetizer::getNextPacket (TSPacket& pkt)
     // If there is still no current section, return a null packet
     if (_section.isNull()) {
         pkt = NullPacket;
+        _cached = 0;
         return;
     }
 
+    // Packets of a section which starts at the beginning of a packet can be cached.
+    // The first packet contains a pointer field, the next ones are full of section data.
+
+    if (_next_byte == 0) {
+        _cached = getCache(_section);
+    }
+    CachedSection* const cache = _cached;
+    const size_t pkt_index = _next_byte == 0 ? 0 : (_next_byte + 1) / (PKT_SIZE - 4);
+
     // Various values to build the MPEG header.
 
     uint16_t pusi = 0x0000;         // payload_unit_start_indicator (set: 0x4000)
@@ -99,9 +145,10 @@ void ts::Packetizer::getNextPacket (TSPacket& pkt)
     // of the packet. We check that after adding the remaining of the
     // current section, there is room for a pointer field (5 = 4-byte TS header
     // + 1-byte pointer field) and at least a short section header.
-    // Remember that we are kind enough not to break a section header across packets.
+    // Remember that we are kind enough not to break a section header across packets,
+    // unless in tight packing mode where one byte of the next section is enough.
 
-    if (remain_in_section <= PKT_SIZE - 5 - SHORT_SECTION_HEADER_SIZE) {
+    if (remain_in_section <= PKT_SIZE - 5 - minStartSize(SHORT_SECTION_HEADER_SIZE)) {
         // Check if next section requires stuffing before it.
         do_stuffing = _provider == 0 ? true : _provider->doStuffing();
         if (!do_stuffing) {
@@ -114,11 +161,32 @@ void ts::Packetizer::getNextPacket (TSPacket& pkt)
             else {
                 // Now that we know the actual header size of the next section,
                 // recheck if it fits in packet
-                do_stuffing = remain_in_section > PKT_SIZE - 5 - next_section->headerSize();
+                do_stuffing = remain_in_section > PKT_SIZE - 5 - minStartSize(next_section->headerSize());
             }
         }
     }
 
+    // If there is stuffing after the current section, the packet contains only this
+    // section and can be reused from the cache, with a new continuity counter.
+
+    if (do_stuffing && cache != 0 && cache->pid == _pid && pkt_index < cache->valid.size() && cache->valid[pkt_index]) {
+        pkt = cache->packets[pkt_index];
+        pkt.setCC(_continuity);
+        _continuity = (_continuity + 1) & 0x0F;
+        const size_t length = _next_byte == 0 ? PKT_SIZE - 5 : PKT_SIZE - 4;
+        if (remain_in_section <= length) {
+            // End of current section.
+            _section_out_count++;
+            _section = next_section;
+            _next_byte = 0;
+            _cached = 0;
+        }
+        else {
+            _next_byte += length;
+        }
+        return;
+    }
+
     // Do we need to insert a pointer_field?
 
     if (_next_byte == 0) {
@@ -172,6 +240,7 @@ void ts::Packetizer::getNextPacket (TSPacket& pkt)
             // Remember next section if known
             _section = next_section;
             _next_byte = 0;
+            _cached = 0;
             next_section.clear();
             // If stuffing required at the end of packet, don't use next section
             if (do_stuffing) {
@@ -192,7 +261,7 @@ void ts::Packetizer::getNextPacket (TSPacket& pkt)
             // We no longer know about stuffing after current section
             do_stuffing = false;
             // If no room for new section header, stuff the end of packet
-            if (remain_in_packet < _section->headerSize()) {
+            if (remain_in_packet < minStartSize(_section->headerSize())) {
                 break;
             }
             // Get characteristcs of new section.
@@ -202,6 +271,16 @@ void ts::Packetizer::getNextPacket (TSPacket& pkt)
 
     // Do packet stuffing if necessary.
     ::memset (data, 0xFF, remain_in_packet);
+
+    // Keep packets which contain only the current section for next time.
+    if (do_stuffing && cache != 0 && cache->pid == _pid) {
+        if (pkt_index >= cache->valid.size()) {
+            cache->packets.resize(pkt_index + 1);
+            cache->valid.resize(pkt_index + 1, false);
+        }
+        cache->packets[pkt_index] = pkt;
+        cache->valid[pkt_index] = true;
+    }
 }
 
 
@@ -219,5 +298,6 @@ std::ostream& ts::Packetizer::display(std::ostream& strm) const
         << std::endl
         << UString::Format(u"  Output packets: %'d", {_packet_count}) << std::endl
         << UString::Format(u"  Output sections: %'d", {_section_out_count}) << std::endl
-        << UString::Format(u"  Provided sections: %'d", {_section_in_count}) << std::endl;
+        << UString::Format(u"  Provided sections: %'d", {_section_in_count}) << std::endl
+        << "  Tight packing: " << UString::YesNo(_tight_packing) << std::endl;
 }
@@ -43,6 +43,12 @@ namespace ts {
     //!
     //! Sections are provided by an object implementing SectionProviderInterface.
     //!
+    //! The packets of a section which starts at a packet boundary and which are not
+    //! shared with another section are kept in a cache. When the same section object
+    //! is provided again, these packets are reused with only a new continuity counter.
+    //! Consequently, the content of a section shall not be modified once it has been
+    //! provided to a packetizer. Provide a new section object instead.
+    //!
     class TSDUCKDLL Packetizer
     {
     public:
@@ -116,6 +122,32 @@ namespace ts {
             return _continuity;
         }
 
+        //!
+        //! Set the tight packing mode.
+        //!
+        //! By default, when a section ends in the middle of a packet, the next section starts
+        //! in the same packet only if its complete header fits in the packet. Otherwise, the
+        //! rest of the packet is stuffed. In tight packing mode, the next section starts as soon
+        //! as one byte remains after the pointer_field and its header may span two packets.
+        //! This is allowed by MPEG but some old receivers may not support it.
+        //! Tight packing does not apply when the section provider requests stuffing.
+        //!
+        //! @param [in] tight True to enable the tight packing mode.
+        //!
+        void setTightPacking(bool tight)
+        {
+            _tight_packing = tight;
+        }
+
+        //!
+        //! Check if the tight packing mode is enabled.
+        //! @return True if the tight packing mode is enabled.
+        //!
+        bool tightPacking() const
+        {
+            return _tight_packing;
+        }
+
         //!
         //! Check if the packet stream is exactly at a section boundary.
         //! @return True if the last returned packet contained
@@ -175,6 +207,34 @@ namespace ts {
         PacketCounter  _packet_count;      // Number of generated packets
         SectionCounter _section_out_count; // Number of output (packetized) sections
         SectionCounter _section_in_count;  // Number of input (provided) sections
+        bool           _tight_packing;     // Section headers may span two packets
+
+        // Packetized form of a section which starts at a packet boundary. A packet which
+        // contains only this section is identical in each repetition, except the CC.
+        // The cache keeps a reference to the section to make sure that the address of
+        // the section is not reused by another one.
+        struct CachedSection
+        {
+            SectionPtr        section;  // Cached section
+            PID               pid;      // PID of cached packets
+            TSPacketVector    packets;  // Packets of the section, in sequence
+            std::vector<bool> valid;    // Which packets are actually cached
+
+            CachedSection(const SectionPtr& sect, PID p) : section(sect), pid(p), packets(), valid() {}
+        };
+        typedef std::map<const Section*, CachedSection> CachedSectionMap;
+
+        CachedSectionMap _cache;        // Cached sections, indexed by section address
+        CachedSection*   _cached;       // Cache of current section, null if it did not start at a packet boundary
+
+        // Get or create the cache of a section.
+        CachedSection* getCache(const SectionPtr& section);
+
+        // Minimum size of the beginning of a section in a packet, after another section.
+        size_t minStartSize(size_t header_size) const
+        {
+            return _tight_packing ? 1 : header_size;
+        }
 
         // Inaccessible operations
         Packetizer(const Packetizer&) = delete;
@@ -0,0 +1,451 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+
+#include "tsPcapFile.h"
+TSDUCK_SOURCE;
+
+namespace {
+    // File magic numbers.
+    const uint32_t PCAP_MAGIC_US  = 0xA1B2C3D4;  // pcap, microsecond time stamps
+    const uint32_t PCAP_MAGIC_NS  = 0xA1B23C4D;  // pcap, nanosecond time stamps
+    const uint32_t PCAPNG_SHB     = 0x0A0D0D0A;  // pcapng, Section Header Block type
+    const uint32_t PCAPNG_BOM     = 0x1A2B3C4D;  // pcapng, byte order magic
+
+    // Sizes of file headers.
+    const size_t PCAP_HEADER_SIZE = 24;
+    const size_t PCAP_RECORD_SIZE = 16;
+
+    // pcapng block types.
+    const uint32_t PCAPNG_IDB = 0x00000001;  // Interface Description Block
+    const uint32_t PCAPNG_OPB = 0x00000002;  // Obsolete Packet Block
+    const uint32_t PCAPNG_SPB = 0x00000003;  // Simple Packet Block
+    const uint32_t PCAPNG_EPB = 0x00000006;  // Enhanced Packet Block
+
+    // pcapng option code for time stamp resolution.
+    const uint16_t PCAPNG_IF_TSRESOL = 9;
+
+    // Link types.
+    const uint16_t LINKTYPE_NULL      = 0;    // BSD loopback
+    const uint16_t LINKTYPE_ETHERNET  = 1;    // Ethernet
+    const uint16_t LINKTYPE_RAW       = 101;  // Raw IPv4 or IPv6
+    const uint16_t LINKTYPE_LINUX_SLL = 113;  // Linux "cooked" capture
+    const uint16_t LINKTYPE_IPV4      = 228;  // Raw IPv4
+    const uint16_t LINKTYPE_LINUX_SLL2 = 276; // Linux "cooked" capture v2
+
+    // Ether types.
+    const uint16_t ETHERTYPE_IPV4 = 0x0800;
+    const uint16_t ETHERTYPE_VLAN = 0x8100;
+    const uint16_t ETHERTYPE_QINQ = 0x88A8;
+
+    // IPv4 header fields.
+    const size_t  IPV4_MIN_HEADER_SIZE = 20;
+    const uint8_t IPV4_PROTO_UDP = 17;
+    const size_t  UDP_HEADER_SIZE = 8;
+}
+
+
+//----------------------------------------------------------------------------
+// Constructor.
+//----------------------------------------------------------------------------
+
+ts::PcapFile::PcapFile() :
+    _file(),
+    _name(),
+    _ng(false),
+    _be(false),
+    _first(0),
+    _offset(0),
+    _interfaces(),
+    _packet_count(0),
+    _fragment_count(0)
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Open and map a capture file.
+//----------------------------------------------------------------------------
+
+bool ts::PcapFile::open(const UString& file_name, Report& report)
+{
+    close();
+    if (!_file.open(file_name, report)) {
+        return false;
+    }
+    _name = file_name;
+
+    const uint8_t* const data = _file.data();
+    const size_t size = _file.size();
+    const uint32_t magic_be = size < 4 ? 0 : GetUInt32BE(data);
+    const uint32_t magic_le = size < 4 ? 0 : GetUInt32LE(data);
+
+    if (magic_be == PCAPNG_SHB) {
+        // The byte order is defined in each section header.
+        _ng = true;
+        _first = 0;
+        if (!readSectionHeader(report)) {
+            close();
+            return false;
+        }
+    }
+    else if (size >= PCAP_HEADER_SIZE && (magic_be == PCAP_MAGIC_US || magic_be == PCAP_MAGIC_NS || magic_le == PCAP_MAGIC_US || magic_le == PCAP_MAGIC_NS)) {
+        _ng = false;
+        _be = magic_be == PCAP_MAGIC_US || magic_be == PCAP_MAGIC_NS;
+        const uint32_t magic = _be ? magic_be : magic_le;
+        // The link type is in the 16 lower bits, the upper bits may contain FCS information.
+        _interfaces.push_back(Interface(uint16_t(get32(data + 20) & 0xFFFF), magic == PCAP_MAGIC_NS ? 9 : 6));
+        _first = PCAP_HEADER_SIZE;
+    }
+    else {
+        report.error(u"%s is not a pcap or pcapng file", {file_name});
+        close();
+        return false;
+    }
+
+    // The file is read sequentially, from the beginning.
+    _file.adviseSequential();
+    rewind();
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Close the capture file.
+//----------------------------------------------------------------------------
+
+void ts::PcapFile::close()
+{
+    _file.close();
+    _name.clear();
+    _ng = _be = false;
+    _first = _offset = 0;
+    _interfaces.clear();
+    _packet_count = _fragment_count = 0;
+}
+
+
+//----------------------------------------------------------------------------
+// Restart reading at the beginning of the file.
+//----------------------------------------------------------------------------
+
+void ts::PcapFile::rewind()
+{
+    _offset = _first;
+    if (_ng) {
+        // The interfaces are redefined in each section.
+        _interfaces.clear();
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Analyze a pcapng Section Header Block at current offset.
+//----------------------------------------------------------------------------
+
+bool ts::PcapFile::readSectionHeader(Report& report)
+{
+    const uint8_t* const block = _file.data() + _offset;
+    const size_t remain = _file.size() - _offset;
+
+    if (remain < 28) {
+        report.error(u"truncated pcapng section header in %s", {_name});
+        return false;
+    }
+    if (GetUInt32BE(block + 8) == PCAPNG_BOM) {
+        _be = true;
+    }
+    else if (GetUInt32LE(block + 8) == PCAPNG_BOM) {
+        _be = false;
+    }
+    else {
+        report.error(u"invalid pcapng byte order magic in %s", {_name});
+        return false;
+    }
+    if (get16(block + 12) != 1) {
+        report.error(u"unsupported pcapng major version %d in %s", {get16(block + 12), _name});
+        return false;
+    }
+
+    // The interfaces of the previous section no longer apply.
+    _interfaces.clear();
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Analyze a pcapng Interface Description Block.
+//----------------------------------------------------------------------------
+
+void ts::PcapFile::readInterface(const uint8_t* body, size_t size)
+{
+    Interface itf(size < 2 ? 0 : get16(body));
+
+    // Look for a time stamp resolution in the options, after the 8-byte fixed part.
+    size_t index = 8;
+    while (index + 4 <= size) {
+        const uint16_t code = get16(body + index);
+        const size_t length = get16(body + index + 2);
+        if (code == 0 || index + 4 + length > size) {
+            break;  // end of options or truncated option
+        }
+        if (code == PCAPNG_IF_TSRESOL && length >= 1) {
+            itf.ts_resol = body[index + 4];
+        }
+        // Options are padded to 32 bits.
+        index += 4 + ((length + 3) & ~size_t(3));
+    }
+    _interfaces.push_back(itf);
+}
+
+
+//----------------------------------------------------------------------------
+// Convert a time stamp to nanoseconds.
+//----------------------------------------------------------------------------
+
+ts::NanoSecond ts::PcapFile::ToNanoSecond(uint64_t value, uint8_t ts_resol)
+{
+    const uint8_t exp = ts_resol & 0x7F;
+    if ((ts_resol & 0x80) != 0) {
+        // Negative power of 2.
+        if (exp >= 64) {
+            return 0;
+        }
+        const uint64_t mask = (uint64_t(1) << exp) - 1;
+        return NanoSecond((value >> exp) * NanoSecPerSec + (((value & mask) * NanoSecPerSec) >> exp));
+    }
+    else {
+        // Negative power of 10.
+        uint64_t factor = 1;
+        for (uint8_t i = std::min<uint8_t>(exp, 9); i < 9; ++i) {
+            factor *= 10;
+        }
+        uint64_t divider = 1;
+        for (uint8_t i = 9; i < exp && i < 28; ++i) {
+            divider *= 10;
+        }
+        return NanoSecond(value * factor / divider);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Read the next captured packet.
+//----------------------------------------------------------------------------
+
+bool ts::PcapFile::readPacket(const uint8_t*& data, size_t& size, uint16_t& link_type, NanoSecond& timestamp, Report& report)
+{
+    const uint8_t* const base = _file.data();
+    const size_t file_size = _file.size();
+
+    if (!_ng) {
+        // Original pcap format: sequence of packet records.
+        if (_offset + PCAP_RECORD_SIZE > file_size) {
+            return false;
+        }
+        const uint8_t* const rec = base + _offset;
+        const size_t caplen = get32(rec + 8);
+        if (caplen > file_size - _offset - PCAP_RECORD_SIZE) {
+            report.error(u"truncated packet record at offset %'d in %s", {_offset, _name});
+            _offset = file_size;
+            return false;
+        }
+        data = rec + PCAP_RECORD_SIZE;
+        size = caplen;
+        link_type = _interfaces[0].link_type;
+        timestamp = NanoSecond(get32(rec)) * NanoSecPerSec + ToNanoSecond(get32(rec + 4), _interfaces[0].ts_resol);
+        _offset += PCAP_RECORD_SIZE + caplen;
+        _packet_count++;
+        return true;
+    }
+
+    // pcapng format: sequence of blocks, skip blocks without packets.
+    while (_offset + 12 <= file_size) {
+        const uint8_t* const block = base + _offset;
+        const uint32_t type = GetUInt32BE(block) == PCAPNG_SHB ? PCAPNG_SHB : get32(block);
+        if (type == PCAPNG_SHB && !readSectionHeader(report)) {
+            _offset = file_size;
+            return false;
+        }
+        const size_t length = get32(block + 4);
+        if (length < 12 || length % 4 != 0 || length > file_size - _offset) {
+            report.error(u"invalid pcapng block length %'d at offset %'d in %s", {length, _offset, _name});
+            _offset = file_size;
+            return false;
+        }
+        const uint8_t* const body = block + 8;
+        const size_t body_size = length - 12;
+        _offset += length;
+
+        if (type == PCAPNG_IDB) {
+            readInterface(body, body_size);
+        }
+        else if (type == PCAPNG_EPB && body_size >= 20) {
+            const size_t itf = get32(body);
+            const size_t caplen = get32(body + 12);
+            if (itf < _interfaces.size() && caplen <= body_size - 20) {
+                data = body + 20;
+                size = caplen;
+                link_type = _interfaces[itf].link_type;
+                timestamp = ToNanoSecond((uint64_t(get32(body + 4)) << 32) | get32(body + 8), _interfaces[itf].ts_resol);
+                _packet_count++;
+                return true;
+            }
+        }
+        else if (type == PCAPNG_OPB && body_size >= 20) {
+            const size_t itf = get16(body);
+            const size_t caplen = get32(body + 12);
+            if (itf < _interfaces.size() && caplen <= body_size - 20) {
+                data = body + 20;
+                size = caplen;
+                link_type = _interfaces[itf].link_type;
+                timestamp = ToNanoSecond((uint64_t(get32(body + 4)) << 32) | get32(body + 8), _interfaces[itf].ts_resol);
+                _packet_count++;
+                return true;
+            }
+        }
+        else if (type == PCAPNG_SPB && body_size >= 4 && !_interfaces.empty()) {
+            // No time stamp, the captured size is the minimum of the original size and the block size.
+            data = body + 4;
+            size = std::min<size_t>(get32(body), body_size - 4);
+            link_type = _interfaces[0].link_type;
+            timestamp = -1;
+            _packet_count++;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+//----------------------------------------------------------------------------
+// Locate the IPv4 packet inside a link-layer frame.
+//----------------------------------------------------------------------------
+
+bool ts::PcapFile::LocateIPv4(uint16_t link_type, const uint8_t*& data, size_t& size)
+{
+    size_t header_size = 0;
+    uint16_t ether_type = ETHERTYPE_IPV4;
+
+    switch (link_type) {
+        case LINKTYPE_NULL:
+            // 4-byte address family in the byte order of the capturing host, AF_INET is 2 everywhere.
+            if (size < 4 || (GetUInt32LE(data) != 2 && GetUInt32BE(data) != 2)) {
+                return false;
+            }
+            header_size = 4;
+            break;
+        case LINKTYPE_ETHERNET:
+            // Destination and source MAC addresses, then optional VLAN tags, then ether type.
+            header_size = 12;
+            while (size >= header_size + 2 && (GetUInt16(data + header_size) == ETHERTYPE_VLAN || GetUInt16(data + header_size) == ETHERTYPE_QINQ)) {
+                header_size += 4;
+            }
+            if (size < header_size + 2) {
+                return false;
+            }
+            ether_type = GetUInt16(data + header_size);
+            header_size += 2;
+            break;
+        case LINKTYPE_LINUX_SLL:
+            if (size < 16) {
+                return false;
+            }
+            ether_type = GetUInt16(data + 14);
+            header_size = 16;
+            break;
+        case LINKTYPE_LINUX_SLL2:
+            if (size < 20) {
+                return false;
+            }
+            ether_type = GetUInt16(data);
+            header_size = 20;
+            break;
+        case LINKTYPE_RAW:
+        case LINKTYPE_IPV4:
+            break;
+        default:
+            return false;
+    }
+
+    if (ether_type != ETHERTYPE_IPV4 || size < header_size + IPV4_MIN_HEADER_SIZE || (data[header_size] >> 4) != 4) {
+        return false;
+    }
+    data += header_size;
+    size -= header_size;
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Read the next IPv4 UDP datagram.
+//----------------------------------------------------------------------------
+
+bool ts::PcapFile::readUDP(SocketAddress& source, SocketAddress& destination, const uint8_t*& data, size_t& size, NanoSecond& timestamp, Report& report)
+{
+    const uint8_t* ip = 0;
+    size_t ip_size = 0;
+    uint16_t link_type = 0;
+
+    while (readPacket(ip, ip_size, link_type, timestamp, report)) {
+
+        // Check IPv4 header.
+        if (!LocateIPv4(link_type, ip, ip_size)) {
+            continue;
+        }
+        const size_t header_size = 4 * size_t(ip[0] & 0x0F);
+        const size_t total_size = GetUInt16(ip + 2);
+        if (header_size < IPV4_MIN_HEADER_SIZE || total_size < header_size || ip[9] != IPV4_PROTO_UDP) {
+            continue;
+        }
+        // Some captures are truncated (snap length), some frames are padded.
+        ip_size = std::min(ip_size, total_size);
+        if (ip_size < header_size + UDP_HEADER_SIZE) {
+            continue;
+        }
+
+        // Fragmented datagrams are not reassembled: more fragments flag or non-zero fragment offset.
+        if ((GetUInt16(ip + 6) & 0x3FFF) != 0) {
+            _fragment_count++;
+            continue;
+        }
+
+        // UDP header.
+        const uint8_t* const udp = ip + header_size;
+        const size_t udp_size = std::min<size_t>(GetUInt16(udp + 4), ip_size - header_size);
+        if (udp_size < UDP_HEADER_SIZE) {
+            continue;
+        }
+        source = SocketAddress(GetUInt32(ip + 12), GetUInt16(udp));
+        destination = SocketAddress(GetUInt32(ip + 16), GetUInt16(udp + 2));
+        data = udp + UDP_HEADER_SIZE;
+        size = udp_size - UDP_HEADER_SIZE;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,172 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Read UDP datagrams from a pcap or pcapng capture file.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsMemoryMappedFile.h"
+#include "tsSocketAddress.h"
+#include "tsMPEG.h"
+
+namespace ts {
+    //!
+    //! Read IPv4 UDP datagrams from a pcap or pcapng capture file.
+    //!
+    //! The capture file is mapped in memory and the datagrams are returned in place,
+    //! without copy. Supported link types are Ethernet (with optional VLAN tags),
+    //! raw IP, BSD loopback and Linux "cooked" captures (SLL and SLL2). Other packets,
+    //! including IPv6, non-UDP and fragmented IPv4 packets, are skipped.
+    //!
+    //! @see https://www.tcpdump.org/manpages/pcap-savefile.5.txt
+    //! @see https://github.com/pcapng/pcapng
+    //!
+    class TSDUCKDLL PcapFile
+    {
+    public:
+        //!
+        //! Default constructor.
+        //!
+        PcapFile();
+
+        //!
+        //! Open and map a capture file.
+        //! A previously open file is first closed.
+        //! @param [in] file_name File name.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on error.
+        //!
+        bool open(const UString& file_name, Report& report);
+
+        //!
+        //! Close the capture file.
+        //!
+        void close();
+
+        //!
+        //! Check if a file is open.
+        //! @return True if a file is open.
+        //!
+        bool isOpen() const
+        {
+            return _file.isOpen();
+        }
+
+        //!
+        //! Check if the file uses the pcapng format.
+        //! @return True if the file uses the pcapng format, false for the original pcap format.
+        //!
+        bool isPcapNG() const
+        {
+            return _ng;
+        }
+
+        //!
+        //! Restart reading at the beginning of the file.
+        //!
+        void rewind();
+
+        //!
+        //! Read the next IPv4 UDP datagram.
+        //! @param [out] source Source socket address of the datagram.
+        //! @param [out] destination Destination socket address of the datagram.
+        //! @param [out] data Address of the UDP payload, inside the mapped file.
+        //! The address remains valid until the file is closed.
+        //! @param [out] size Size in bytes of the UDP payload.
+        //! @param [out] timestamp Capture time stamp in nanoseconds since the Unix epoch,
+        //! negative if the capture has no time stamp.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false at end of file or on error.
+        //!
+        bool readUDP(SocketAddress& source, SocketAddress& destination, const uint8_t*& data, size_t& size, NanoSecond& timestamp, Report& report);
+
+        //!
+        //! Get the number of captured packets which were read so far, UDP or not.
+        //! @return The number of captured packets.
+        //!
+        PacketCounter packetCount() const
+        {
+            return _packet_count;
+        }
+
+        //!
+        //! Get the number of IPv4 fragments which were skipped so far.
+        //! @return The number of skipped IPv4 fragments.
+        //!
+        PacketCounter fragmentCount() const
+        {
+            return _fragment_count;
+        }
+
+    private:
+        // Description of a capture interface in a pcapng file.
+        struct Interface
+        {
+            uint16_t link_type;  // Link type of the interface
+            uint8_t  ts_resol;   // Time stamp resolution, same format as pcapng if_tsresol option
+            Interface(uint16_t lt = 0, uint8_t res = 6) : link_type(lt), ts_resol(res) {}
+        };
+        typedef std::vector<Interface> InterfaceVector;
+
+        MemoryMappedFile _file;            // Mapped capture file
+        UString          _name;            // File name, for messages
+        bool             _ng;              // File format is pcapng
+        bool             _be;              // File is big endian
+        size_t           _first;           // Offset of first packet or block
+        size_t           _offset;          // Offset of next packet or block
+        InterfaceVector  _interfaces;      // pcap: one interface, pcapng: interfaces of current section
+        PacketCounter    _packet_count;    // Number of captured packets
+        PacketCounter    _fragment_count;  // Number of skipped IPv4 fragments
+
+        // Read integers in the byte order of the file.
+        uint16_t get16(const uint8_t* p) const { return _be ? GetUInt16BE(p) : GetUInt16LE(p); }
+        uint32_t get32(const uint8_t* p) const { return _be ? GetUInt32BE(p) : GetUInt32LE(p); }
+
+        // Read the next captured packet. Return false at end of file or on error.
+        bool readPacket(const uint8_t*& data, size_t& size, uint16_t& link_type, NanoSecond& timestamp, Report& report);
+
+        // Analyze a pcapng Section Header Block at current offset. Return false on error.
+        bool readSectionHeader(Report& report);
+
+        // Analyze a pcapng Interface Description Block.
+        void readInterface(const uint8_t* body, size_t size);
+
+        // Convert a time stamp to nanoseconds.
+        static NanoSecond ToNanoSecond(uint64_t value, uint8_t ts_resol);
+
+        // Locate the IPv4 packet inside a link-layer frame. Return false if not an IPv4 packet.
+        static bool LocateIPv4(uint16_t link_type, const uint8_t*& data, size_t& size);
+
+        // Inaccessible operations.
+        PcapFile(const PcapFile&) = delete;
+        PcapFile& operator=(const PcapFile&) = delete;
+    };
+}
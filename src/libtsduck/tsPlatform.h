@@ -296,6 +296,10 @@
     //!
     #define TS_ARM
     //!
+    //! Defined when the target processor architecture is the 64-bit ARM architecture, also known as AArch64.
+    //!
+    #define TS_ARM64
+    //!
     //! Defined when the target processor architecture is STxP70.
     //!
     #define TS_STXP70
@@ -341,6 +345,13 @@
     #if !defined(TS_ADDRESS_BITS)
         #define TS_ADDRESS_BITS 64
     #endif
+#elif defined(__aarch64__)
+    #if !defined(TS_ARM64)
+        #define TS_ARM64 1
+    #endif
+    #if !defined(TS_ADDRESS_BITS)
+        #define TS_ADDRESS_BITS 64
+    #endif
 #elif defined(__arm__)
     #if !defined(TS_ARM)
         #define TS_ARM 1
@@ -409,7 +420,7 @@
     #define TS_BIG_ENDIAN 1
 #endif
 
-#if defined (TS_ARM)
+#if defined(TS_ARM) || defined(TS_ARM64)
     #if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
         #define TS_LITTLE_ENDIAN 1
     #elif defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
@@ -580,11 +591,13 @@
 #include <sys/time.h>
 #include <sys/wait.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netdb.h>
 #include <net/if.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <unistd.h>
+#include <poll.h>
 #include <time.h>
 #include <glob.h>
 #include <pthread.h>
@@ -38,7 +38,8 @@ TSDUCK_SOURCE;
 ts::TSP::TSP(int max_severity) :
     Report(max_severity),
     _tsp_bitrate(0),
-    _tsp_aborting(false)
+    _tsp_aborting(false),
+    _tsp_offline(false)
 {
 }
 
@@ -76,6 +77,80 @@ ts::ProcessorPlugin::ProcessorPlugin(TSP* tsp_,
 }
 
 
+//----------------------------------------------------------------------------
+// Default packet reception with metadata: metadata are not modified.
+//----------------------------------------------------------------------------
+
+size_t ts::InputPlugin::receiveWithMetadata(TSPacket* buffer, TSPacketMetadata* mdata, size_t max_packets)
+{
+    return receive(buffer, max_packets);
+}
+
+
+//----------------------------------------------------------------------------
+// Default two-segment packet reception: first segment only.
+//----------------------------------------------------------------------------
+
+size_t ts::InputPlugin::receivev(TSPacket* buffer1, TSPacketMetadata* mdata1, size_t max_packets1,
+                                 TSPacket* buffer2, TSPacketMetadata* mdata2, size_t max_packets2)
+{
+    return receiveWithMetadata(buffer1, mdata1, max_packets1);
+}
+
+
+//----------------------------------------------------------------------------
+// Default packet output with metadata: metadata are ignored.
+//----------------------------------------------------------------------------
+
+bool ts::OutputPlugin::sendWithMetadata(const TSPacket* buffer, const TSPacketMetadata* mdata, size_t packet_count)
+{
+    return send(buffer, packet_count);
+}
+
+
+//----------------------------------------------------------------------------
+// Default scatter/gather packet output: one call to sendWithMetadata() per run.
+//----------------------------------------------------------------------------
+
+bool ts::OutputPlugin::sendv(const TSPacketRunVector& runs)
+{
+    for (size_t i = 0; i < runs.size(); ++i) {
+        if (runs[i].count > 0 && !sendWithMetadata(runs[i].packets, runs[i].metadata, runs[i].count)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Default batch packet processing: one call to processPacket() per packet.
+//----------------------------------------------------------------------------
+
+size_t ts::ProcessorPlugin::processPacketBatch(const TSPacketView& pkts, TSPacketMetadata* mdata, size_t count, Status* status, bool& flush, bool& bitrate_changed)
+{
+    for (size_t i = 0; i < count; ++i) {
+        if (pkts[i].b[0] == 0) {
+            // Packet already dropped by a previous processor.
+            status[i] = TSP_DROP;
+        }
+        else {
+            bool pkt_flush = false;
+            bool pkt_bitrate_changed = false;
+            status[i] = processPacket(pkts[i], pkt_flush, pkt_bitrate_changed);
+            flush = flush || pkt_flush;
+            bitrate_changed = bitrate_changed || pkt_bitrate_changed;
+            // Return immediately on end of processing or flush request, the
+            // processed packets shall be passed to the next processor now.
+            if (status[i] == TSP_END || pkt_flush) {
+                return i + 1;
+            }
+        }
+    }
+    return count;
+}
+
+
 //----------------------------------------------------------------------------
 // Report implementation.
 //----------------------------------------------------------------------------
@@ -84,4 +159,9 @@ void ts::Plugin::writeLog(int severity, const UString& message)
 {
     // Force message to go through tsp
     tsp->log(severity, message);
+
+    // As in Args, an error invalidates the last analysis of the command line.
+    if (severity <= Severity::Error) {
+        invalidate();
+    }
 }
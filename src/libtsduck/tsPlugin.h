@@ -37,6 +37,9 @@
 #include "tsAbortInterface.h"
 #include "tsReport.h"
 #include "tsTSPacket.h"
+#include "tsTSPacketMetadata.h"
+#include "tsTSPacketView.h"
+#include "tsTableHandlerInterface.h"
 
 namespace ts {
 
@@ -73,6 +76,19 @@ namespace ts {
     //! When the plugin has completed its work, it reports this using
     //! jointTerminate().
     //!
+    //! Shared signalization
+    //! --------------------
+    //!
+    //! Packet processor plugins which demux PSI/SI tables on fixed PID's
+    //! (PAT, CAT, NIT, SDT, BAT, etc.) can subscribe to the shared signalization
+    //! of tsp instead of using their own section demux. The tables are demuxed
+    //! once, at the position of the first subscriber in the chain, and delivered
+    //! to each subscriber in its own thread, just before the packet which
+    //! completes the table is passed to the plugin, exactly as with a private
+    //! demux. When a plugin between two subscribers modifies, drops or inserts
+    //! packets in the PID's of the second subscriber, this subscriber switches
+    //! to a private demux.
+    //!
     class TSDUCKDLL TSP: public Report, public AbortInterface
     {
     public:
@@ -84,7 +100,7 @@ namespace ts {
         //! @c int data named @c tspInterfaceVersion which contains the current
         //! interface version at the time the library is built.
         //!
-        static const int API_VERSION = 5;
+        static const int API_VERSION = 12;
 
         //!
         //! Get the current input bitrate in bits/seconds.
@@ -101,6 +117,17 @@ namespace ts {
         //!
         virtual bool aborting() const override {return _tsp_aborting;}
 
+        //!
+        //! Check if tsp runs in offline mode.
+        //!
+        //! In offline mode, typically when processing files, the packets are processed
+        //! as fast as possible and the wall clock is meaningless for the stream. Plugins
+        //! shall not pace the packets on the real time, time-related processing should
+        //! rely on the stream content (PCR's, bitrate) instead.
+        //! @return True if tsp runs in offline mode.
+        //!
+        bool offline() const {return _tsp_offline;}
+
         //!
         //! Activates or deactivates "joint termination".
         //!
@@ -132,9 +159,72 @@ namespace ts {
         //!
         virtual bool thisJointTerminated() const = 0;
 
+        //!
+        //! Subscribe to the shared signalization of tsp.
+        //! This method should be invoked during the plugin's start().
+        //! Only packet processor plugins can subscribe.
+        //! @param [in] handler The object to invoke for each new table in @a pids.
+        //! The SectionDemux which is passed to the handler shall not be modified.
+        //! @param [in] pids The set of PID's to demux.
+        //! @return True on success. False if the shared signalization is not available,
+        //! in which case the plugin should use its own section demux.
+        //!
+        virtual bool subscribeSignalization(TableHandlerInterface* handler, const PIDSet& pids) = 0;
+
+        //!
+        //! Get the current time in the time reference of the input time stamps of the packets.
+        //! A plugin compares it with the input time stamps in the packet metadata to get the
+        //! time which elapsed since the reception of a packet.
+        //! @return The current time in nanoseconds, relative to the same arbitrary origin as
+        //! the input time stamps of the packets (see ts::TSPacketMetadata::getInputTimeStamp()).
+        //!
+        virtual NanoSecond currentTimeStamp() const = 0;
+
+        //!
+        //! Declare a packet lookahead for the calling packet processor plugin.
+        //!
+        //! With a lookahead of @a count packets, tsp invokes the plugin on a batch
+        //! of packets only when at least @a count subsequent packets were already
+        //! processed by the previous plugins. These packets can be read, without
+        //! copy, using lookaheadPacket(). Consequently, tsp holds the packets
+        //! in the plugin until the lookahead is available or the end of input
+        //! is reached. This method should be invoked during the plugin's start().
+        //! It is ignored for input and output plugins.
+        //!
+        //! The lookahead is limited to half the size of the tsp packet buffer.
+        //! A plugin which declares a lookahead is never processed in parallel
+        //! on distinct chunks of packets (see ProcessorPlugin::isPacketParallel()).
+        //!
+        //! @param [in] count Number of packets to lookahead after the current batch.
+        //! Zero means no lookahead, the default.
+        //!
+        virtual void setLookahead(size_t count) = 0;
+
+        //!
+        //! Get a packet after the batch which is currently processed by the plugin.
+        //!
+        //! This method can be invoked only from ProcessorPlugin::processPacketBatch()
+        //! or ProcessorPlugin::processPacket(). The packets are directly read in the
+        //! tsp packet buffer and shall not be modified. They are valid until the end
+        //! of the current invocation of the plugin. The packets which were dropped by
+        //! a previous plugin are returned as well and start with a zero byte instead of 0x47.
+        //!
+        //! Note that @a index is relative to the end of the current batch, not to the
+        //! packet which is currently processed. Therefore, a plugin with a lookahead
+        //! should override ProcessorPlugin::processPacketBatch().
+        //!
+        //! @param [in] index Index of the packet after the current batch, starting at zero.
+        //! @param [out] mdata When not zero, receive the address of the metadata of the packet.
+        //! @return Address of the packet or zero if the packet is not yet available or if
+        //! the end of input is reached. All packets before the declared lookahead (see
+        //! setLookahead()) are always available, unless at the end of input.
+        //!
+        virtual const TSPacket* lookaheadPacket(size_t index, const TSPacketMetadata** mdata = 0) const = 0;
+
     protected:
         BitRate       _tsp_bitrate;   //!< TSP input bitrate.
         volatile bool _tsp_aborting;  //!< TSP is currently aborting.
+        bool          _tsp_offline;   //!< TSP runs in offline mode, no real-time pacing.
 
         //!
         //! Constructor for subclasses.
@@ -190,6 +280,21 @@ namespace ts {
         //!
         virtual bool stop() {return true;}
 
+        //!
+        //! The main application invokes reconfigure() when new command line arguments
+        //! are received while the plugin is running (tsp option -\-control-port).
+        //!
+        //! The new arguments are already analyzed and can be fetched using the Args
+        //! methods, as in start(). The method is invoked in the thread of the plugin,
+        //! at a packet boundary. The default implementation restarts the plugin,
+        //! using stop() and start(). A plugin which can apply new arguments without
+        //! losing its state may override it.
+        //!
+        //! @return True on success, false on error. On error, the main application
+        //! restores the previous arguments and invokes reconfigure() again.
+        //!
+        virtual bool reconfigure() {return stop() && start();}
+
         //!
         //! Get the plugin bitrate.
         //!
@@ -267,6 +372,52 @@ namespace ts {
         //!
         virtual size_t receive(TSPacket* buffer, size_t max_packets) = 0;
 
+        //!
+        //! Packet reception interface with metadata.
+        //!
+        //! The main application invokes this method to get input packets. The default
+        //! implementation invokes receive() and leaves the metadata unchanged. Input plugins
+        //! which know the actual reception time of the packets (kernel time stamps for instance)
+        //! override this method and set the input time stamps in the metadata.
+        //!
+        //! When this method is invoked, the metadata of all packets are reset (no input time
+        //! stamp). The input time stamps which are set by the plugin are expressed in nanoseconds
+        //! since the UNIX epoch (1970-01-01 00:00:00 UTC), on the system real-time clock. They
+        //! are converted by tsp into the time reference of its buffer. Packets without input
+        //! time stamp get the time of return of this method.
+        //!
+        //! @param [out] buffer Address of the buffer for incoming packets.
+        //! @param [in,out] mdata Address of the metadata of the incoming packets.
+        //! @param [in] max_packets Size of @a buffer and @a mdata in number of packets.
+        //! @return The number of actually received packets (in the range
+        //! 1 to @a max_packets). Returning zero means error or end of input.
+        //!
+        virtual size_t receiveWithMetadata(TSPacket* buffer, TSPacketMetadata* mdata, size_t max_packets);
+
+        //!
+        //! Two-segment packet reception interface.
+        //!
+        //! When the free space in the tsp buffer wraps over the end of the circular buffer,
+        //! the main application invokes this method with the two parts of the free space.
+        //! The packets are received in the first segment and continue in the second one.
+        //! The default implementation invokes receiveWithMetadata() on the first segment only.
+        //! Input plugins which have more data at hand than the first segment can hold (several
+        //! UDP datagrams in a batch for instance) override this method to fill the second
+        //! segment without waiting and without keeping the leftovers for the next call.
+        //!
+        //! @param [out] buffer1 Address of the first segment for incoming packets.
+        //! @param [in,out] mdata1 Address of the metadata of the first segment.
+        //! @param [in] max_packets1 Size of @a buffer1 and @a mdata1 in number of packets.
+        //! @param [out] buffer2 Address of the second segment for incoming packets.
+        //! @param [in,out] mdata2 Address of the metadata of the second segment.
+        //! @param [in] max_packets2 Size of @a buffer2 and @a mdata2 in number of packets.
+        //! @return The total number of actually received packets (in the range 1 to
+        //! @a max_packets1 + @a max_packets2). The second segment is used only when the
+        //! first one is full. Returning zero means error or end of input.
+        //!
+        virtual size_t receivev(TSPacket* buffer1, TSPacketMetadata* mdata1, size_t max_packets1,
+                                TSPacket* buffer2, TSPacketMetadata* mdata2, size_t max_packets2);
+
         //!
         //! Constructor.
         //!
@@ -326,6 +477,36 @@ namespace ts {
         //!
         virtual bool send(const TSPacket* buffer, size_t packet_count) = 0;
 
+        //!
+        //! Packet output interface with metadata.
+        //!
+        //! The main application invokes this method to output packets. The default
+        //! implementation invokes send() and ignores the metadata. Output plugins which
+        //! use the input time stamps of the packets (to send them at a constant delay
+        //! after their reception for instance) override this method.
+        //!
+        //! @param [in] buffer Address of outgoing packets.
+        //! @param [in] mdata Address of the metadata of the outgoing packets.
+        //! @param [in] packet_count Number of packets to send from @a buffer.
+        //! @return True on success, false on error.
+        //! @see TSP::currentTimeStamp()
+        //!
+        virtual bool sendWithMetadata(const TSPacket* buffer, const TSPacketMetadata* mdata, size_t packet_count);
+
+        //!
+        //! Scatter/gather packet output interface.
+        //!
+        //! The main application invokes this method once per buffer window, with the
+        //! list of contiguous runs of non-dropped packets in the window. The default
+        //! implementation invokes sendWithMetadata() once per run. Output plugins which
+        //! can group packets from several runs in one output operation (full UDP datagrams,
+        //! vectored write) override this method.
+        //!
+        //! @param [in] runs List of runs of packets to send, in order.
+        //! @return True on success, false on error.
+        //!
+        virtual bool sendv(const TSPacketRunVector& runs);
+
         //!
         //! Constructor.
         //!
@@ -408,6 +589,62 @@ namespace ts {
         //!
         virtual Status processPacket(TSPacket& pkt, bool& flush, bool& bitrate_changed) = 0;
 
+        //!
+        //! Batch packet processing interface.
+        //!
+        //! The main application invokes processPacketBatch() to let the shared
+        //! library process a contiguous slice of TS packets from the packet buffer.
+        //! Depending on the layout of the packet buffer, the packets are either
+        //! adjacent or separated by a padded stride. They must be accessed through
+        //! the view @a pkts, never as a plain array of ts::TSPacket.
+        //! The default implementation invokes processPacket() on each packet.
+        //! Plugins with a very simple per-packet processing may override this
+        //! method to avoid one virtual call per packet.
+        //!
+        //! Packets which were previously dropped by another packet processor start
+        //! with a zero byte instead of 0x47. They must not be processed or modified.
+        //! Their status in @a status is ignored by the main application.
+        //!
+        //! Processing stops after the first packet with status TSP_END.
+        //! The statuses of the remaining packets are undefined. The default
+        //! implementation also stops after the first packet which sets @a flush.
+        //! The remaining packets are passed again in a subsequent invocation.
+        //!
+        //! The metadata of the packets are in a parallel array. The plugin may
+        //! read and update them (input time stamps, labels) but shall not modify
+        //! the drop and null flags which are managed by the main application
+        //! according to the returned statuses.
+        //!
+        //! @param [in,out] pkts View on the first TS packet to process.
+        //! @param [in,out] mdata Address of the metadata of the first TS packet.
+        //! @param [in] count Number of packets to process.
+        //! @param [out] status Address of an array of @a count statuses, one per packet.
+        //! @param [in,out] flush Initially set to false. If the method sets @a flush to true,
+        //! the processed packets should be passed to the next processor as soon as possible.
+        //! @param [in,out] bitrate_changed Initially set to false. If the method sets
+        //! @a bitrate_changed to true, tsp should call the getBitrate() callback as soon as possible.
+        //! @return The number of processed packets, including the one with status TSP_END, if any.
+        //! When less than @a count without TSP_END, the remaining packets are processed later.
+        //!
+        virtual size_t processPacketBatch(const TSPacketView& pkts, TSPacketMetadata* mdata, size_t count, Status* status, bool& flush, bool& bitrate_changed);
+
+        //!
+        //! Check if the plugin can process packets in parallel.
+        //!
+        //! A "packet-parallel" plugin processes each packet independently of all
+        //! other packets. When requested on the tsp command line, the main application
+        //! may split the slices of packets into several chunks and invoke processPacketBatch()
+        //! concurrently on each chunk, in distinct threads. The processed packets are
+        //! always passed to the next processor in their original order.
+        //!
+        //! A plugin shall return true only if its processPacketBatch() is thread-safe
+        //! when invoked concurrently on distinct packets. The default implementation
+        //! returns false.
+        //!
+        //! @return True if the plugin is packet-parallel.
+        //!
+        virtual bool isPacketParallel() const {return false;}
+
         //!
         //! Constructor.
         //!
@@ -42,13 +42,74 @@ TS_DEFINE_SINGLETON(ts::PluginRepository);
 
 ts::PluginRepository::PluginRepository() :
     _sharedLibraryAllowed(true),
+    _filesScanned(false),
     _inputPlugins(),
     _processorPlugins(),
-    _outputPlugins()
+    _outputPlugins(),
+    _pluginFiles()
 {
 }
 
 
+//----------------------------------------------------------------------------
+// Scan the plugin search path once.
+//----------------------------------------------------------------------------
+
+const ts::PluginRepository::FileMap& ts::PluginRepository::pluginFiles()
+{
+    if (!_filesScanned) {
+        _filesScanned = true;
+
+        // Get list of shared library files, in search order.
+        UStringVector files;
+        ApplicationSharedLibrary::GetPluginList(files, u"tsplugin_", TS_PLUGINS_PATH);
+
+        // Keep the first file for each plugin name, same as the search rules.
+        // The plugin name is built the same way as ApplicationSharedLibrary::moduleName().
+        const UString prefix(u"tsplugin_");
+        for (size_t i = 0; i < files.size(); ++i) {
+            const UString name(PathPrefix(BaseName(files[i])));
+            if (name.find(prefix) == 0) {
+                _pluginFiles.insert(std::make_pair(name.substr(prefix.size()), files[i]));
+            }
+        }
+    }
+    return _pluginFiles;
+}
+
+
+//----------------------------------------------------------------------------
+// Get the shared library file to load for a plugin name.
+//----------------------------------------------------------------------------
+
+ts::UString ts::PluginRepository::pluginFile(const UString& name)
+{
+    // Plain plugin names are searched in the cached scan of the search path.
+    // File names with a directory or names which are not found in the search
+    // path are passed unchanged to the standard search rules.
+    if (BaseName(name) == name) {
+        const FileMap& files(pluginFiles());
+        const FileMap::const_iterator it = files.find(name);
+        if (it != files.end()) {
+            return it->second;
+        }
+    }
+    return name;
+}
+
+
+//----------------------------------------------------------------------------
+// Check if a plugin name is registered with any capability.
+//----------------------------------------------------------------------------
+
+bool ts::PluginRepository::isRegistered(const UString& name) const
+{
+    return _inputPlugins.find(name) != _inputPlugins.end() ||
+        _processorPlugins.find(name) != _processorPlugins.end() ||
+        _outputPlugins.find(name) != _outputPlugins.end();
+}
+
+
 //----------------------------------------------------------------------------
 // Plugin registration.
 //----------------------------------------------------------------------------
@@ -110,7 +171,7 @@ ts::NewInputProfile ts::PluginRepository::getInput(const UString& name, Report&
     }
 
     // Try to load a shareable library.
-    PluginSharedLibrary shlib(name, report);
+    PluginSharedLibrary shlib(pluginFile(name), report);
     if (!shlib.isLoaded()) {
         // Error message already displayed.
         return 0;
@@ -141,7 +202,7 @@ ts::NewProcessorProfile ts::PluginRepository::getProcessor(const UString& name,
     }
 
     // Try to load a shareable library.
-    PluginSharedLibrary shlib(name, report);
+    PluginSharedLibrary shlib(pluginFile(name), report);
     if (!shlib.isLoaded()) {
         // Error message already displayed.
         return 0;
@@ -172,7 +233,7 @@ ts::NewOutputProfile ts::PluginRepository::getOutput(const UString& name, Report
     }
 
     // Try to load a shareable library.
-    PluginSharedLibrary shlib(name, report);
+    PluginSharedLibrary shlib(pluginFile(name), report);
     if (!shlib.isLoaded()) {
         // Error message already displayed.
         return 0;
@@ -199,13 +260,14 @@ void ts::PluginRepository::loadAllPlugins(Report& report)
         return;
     }
 
-    // Get list of shared library files
-    UStringVector files;
-    ApplicationSharedLibrary::GetPluginList(files, u"tsplugin_", TS_PLUGINS_PATH);
-
     // Load all plugins and register allocator functions (when not zero).
-    for (size_t i = 0; i < files.size(); ++i) {
-        PluginSharedLibrary shlib(files[i], report);
+    // Plugins which are already registered, typically statically linked, are not loaded again.
+    const FileMap& files(pluginFiles());
+    for (FileMap::const_iterator it = files.begin(); it != files.end(); ++it) {
+        if (isRegistered(it->first)) {
+            continue;
+        }
+        PluginSharedLibrary shlib(it->second, report);
         if (shlib.isLoaded()) {
             const UString name(shlib.moduleName());
             registerInput(name, shlib.new_input);
@@ -269,6 +331,40 @@ ts::UString ts::PluginRepository::listPlugins(bool loadAll, Report& report)
 }
 
 
+//----------------------------------------------------------------------------
+// List the names of all tsp plugins, without loading them.
+//----------------------------------------------------------------------------
+
+ts::UString ts::PluginRepository::listPluginNames(Report& report)
+{
+    // Merge registered plugins and plugins from the search path.
+    std::set<UString> names;
+    for (InputMap::const_iterator it = _inputPlugins.begin(); it != _inputPlugins.end(); ++it) {
+        names.insert(it->first);
+    }
+    for (ProcessorMap::const_iterator it = _processorPlugins.begin(); it != _processorPlugins.end(); ++it) {
+        names.insert(it->first);
+    }
+    for (OutputMap::const_iterator it = _outputPlugins.begin(); it != _outputPlugins.end(); ++it) {
+        names.insert(it->first);
+    }
+    if (_sharedLibraryAllowed) {
+        const FileMap& files(pluginFiles());
+        for (FileMap::const_iterator it = files.begin(); it != files.end(); ++it) {
+            names.insert(it->first);
+        }
+    }
+
+    UString out(u"\nList of tsp plugins:\n\n");
+    for (std::set<UString>::const_iterator it = names.begin(); it != names.end(); ++it) {
+        out += u"  ";
+        out += *it;
+        out += u"\n";
+    }
+    return out;
+}
+
+
 //----------------------------------------------------------------------------
 // List one plugin.
 //----------------------------------------------------------------------------
@@ -43,6 +43,12 @@ namespace ts {
     //!
     //! This class is a singleton. Use static Instance() method to access the single instance.
     //!
+    //! Plugins which are linked into the application or into the TSDuck library are
+    //! registered at initialization time and are never searched in shared libraries.
+    //! Other plugins are located in shared libraries. The directories of the plugin
+    //! search path are scanned only once and the result is cached. When a plugin is
+    //! requested, its shared library is directly loaded from the cached location.
+    //!
     class TSDUCKDLL PluginRepository
     {
         TS_DECLARE_SINGLETON(PluginRepository);
@@ -139,6 +145,16 @@ namespace ts {
         //!
         UString listPlugins(bool loadAll, Report& report);
 
+        //!
+        //! List the names of all tsp plugins, without loading any shared library.
+        //! The list includes the registered plugins and the plugins which are found
+        //! in shared libraries in the plugin search path. Since the shared libraries
+        //! are not loaded, the capabilities and descriptions of the plugins are not listed.
+        //! @param [in,out] report Where to report errors.
+        //! @return The text to display.
+        //!
+        UString listPluginNames(Report& report);
+
         //!
         //! A class to register plugins.
         //!
@@ -180,11 +196,23 @@ namespace ts {
         typedef std::map<UString, NewInputProfile>     InputMap;
         typedef std::map<UString, NewProcessorProfile> ProcessorMap;
         typedef std::map<UString, NewOutputProfile>    OutputMap;
+        typedef std::map<UString, UString>             FileMap;
 
         bool         _sharedLibraryAllowed;
+        bool         _filesScanned;      // The plugin search path was scanned.
         InputMap     _inputPlugins;
         ProcessorMap _processorPlugins;
         OutputMap    _outputPlugins;
+        FileMap      _pluginFiles;       // Plugin name => shared library file, in search path.
+
+        // Scan the plugin search path once, return the map of plugin shared library files.
+        const FileMap& pluginFiles();
+
+        // Get the shared library file to load for a plugin name.
+        UString pluginFile(const UString& name);
+
+        // Check if a plugin name is registered with any capability.
+        bool isRegistered(const UString& name) const;
 
         // List one plugin.
         static void ListOnePlugin(UString& out, const UString& name, Plugin* plugin, size_t name_width);
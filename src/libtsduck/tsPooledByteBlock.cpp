@@ -0,0 +1,180 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  A byte block with recycled memory.
+//
+//----------------------------------------------------------------------------
+
+#include "tsPooledByteBlock.h"
+#include "tsGuard.h"
+#include "tsMutex.h"
+TSDUCK_SOURCE;
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::PooledByteBlock::MIN_CAPACITY;
+const size_t ts::PooledByteBlock::MAX_FREE;
+#endif
+
+
+//----------------------------------------------------------------------------
+// The process-wide pool.
+//----------------------------------------------------------------------------
+
+namespace {
+    class BlockPool
+    {
+    public:
+        ts::Mutex mutex;                              // Protect the pool
+        std::vector<ts::ByteBlock::ByteVector> storages; // Free storages, empty with a capacity
+        std::vector<void*> objects;                   // Free memory for PooledByteBlock objects
+
+        BlockPool() :
+            mutex(),
+            storages(),
+            objects()
+        {
+            // Never reallocate the free lists.
+            storages.reserve(ts::PooledByteBlock::MAX_FREE);
+            objects.reserve(ts::PooledByteBlock::MAX_FREE);
+        }
+
+        // The pool is never deleted: pooled blocks may be released by static
+        // destructors, after the destruction of any other static object.
+        static BlockPool& Instance()
+        {
+            static BlockPool* const pool = new BlockPool;
+            return *pool;
+        }
+
+    private:
+        BlockPool(const BlockPool&) = delete;
+        BlockPool& operator=(const BlockPool&) = delete;
+    };
+}
+
+
+//----------------------------------------------------------------------------
+// Constructors and destructor.
+//----------------------------------------------------------------------------
+
+ts::PooledByteBlock::PooledByteBlock(const void* data, size_type size) :
+    ByteBlock()
+{
+    BlockPool& pool(BlockPool::Instance());
+    {
+        Guard lock(pool.mutex);
+        if (!pool.storages.empty()) {
+            swap(pool.storages.back());
+            pool.storages.pop_back();
+        }
+    }
+    if (capacity() < size) {
+        reserve(std::max(size, MIN_CAPACITY));
+    }
+    const uint8_t* const p = static_cast<const uint8_t*>(data);
+    assign(p, p + size);
+}
+
+ts::PooledByteBlock::~PooledByteBlock()
+{
+    // Keep only storages of usual size, not the ones which grew much larger.
+    if (capacity() >= MIN_CAPACITY && capacity() <= 2 * MIN_CAPACITY) {
+        BlockPool& pool(BlockPool::Instance());
+        Guard lock(pool.mutex);
+        if (pool.storages.size() < MAX_FREE) {
+            clear();
+            pool.storages.push_back(std::move(static_cast<ByteVector&>(*this)));
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Memory of the objects.
+//----------------------------------------------------------------------------
+
+void* ts::PooledByteBlock::operator new(size_t size)
+{
+    // Subclasses of another size use the heap.
+    if (size == sizeof(PooledByteBlock)) {
+        BlockPool& pool(BlockPool::Instance());
+        Guard lock(pool.mutex);
+        if (!pool.objects.empty()) {
+            void* const ptr = pool.objects.back();
+            pool.objects.pop_back();
+            return ptr;
+        }
+    }
+    return ::operator new(size);
+}
+
+void ts::PooledByteBlock::operator delete(void* ptr, size_t size)
+{
+    if (ptr != 0 && size == sizeof(PooledByteBlock)) {
+        BlockPool& pool(BlockPool::Instance());
+        Guard lock(pool.mutex);
+        if (pool.objects.size() < MAX_FREE) {
+            pool.objects.push_back(ptr);
+            return;
+        }
+    }
+    ::operator delete(ptr);
+}
+
+
+//----------------------------------------------------------------------------
+// Get the number of free storages in the pool.
+//----------------------------------------------------------------------------
+
+size_t ts::PooledByteBlock::FreeCount()
+{
+    BlockPool& pool(BlockPool::Instance());
+    Guard lock(pool.mutex);
+    return pool.storages.size();
+}
+
+
+//----------------------------------------------------------------------------
+// Pre-allocate storages and objects in the pool.
+//----------------------------------------------------------------------------
+
+void ts::PooledByteBlock::Reserve(size_t count)
+{
+    count = std::min(count, MAX_FREE);
+    BlockPool& pool(BlockPool::Instance());
+    Guard lock(pool.mutex);
+    while (pool.storages.size() < count) {
+        ByteVector storage(MIN_CAPACITY, 0);
+        storage.clear();
+        pool.storages.push_back(std::move(storage));
+    }
+    while (pool.objects.size() < count) {
+        pool.objects.push_back(::operator new(sizeof(PooledByteBlock)));
+    }
+}
@@ -0,0 +1,112 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  A byte block with recycled memory.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsByteBlock.h"
+#include "tsMPEG.h"
+
+namespace ts {
+    //!
+    //! A byte block with recycled memory.
+    //!
+    //! This is a ByteBlock for short-lived buffers which are allocated at a high rate,
+    //! typically the sections which are extracted by a demux. When an instance is
+    //! deleted, its storage and the memory of the object itself are returned to a
+    //! process-wide pool and are reused by the next instances. In a steady state,
+    //! the allocation of a PooledByteBlock does not use the heap.
+    //!
+    //! Instances must be allocated using the operator @c new, typically to be managed
+    //! by a ByteBlockPtr. Instances can be created and deleted in different threads.
+    //!
+    class TSDUCKDLL PooledByteBlock: public ByteBlock
+    {
+    public:
+        //!
+        //! Minimum capacity in bytes of the pooled storages, large enough for any section.
+        //!
+        static const size_t MIN_CAPACITY = MAX_PRIVATE_SECTION_SIZE;
+
+        //!
+        //! Maximum number of free storages and objects which are kept in the pool.
+        //!
+        static const size_t MAX_FREE = 1024;
+
+        //!
+        //! Constructor from a data block.
+        //! @param [in] data Address of area to copy.
+        //! @param [in] size Initial size of the block.
+        //!
+        PooledByteBlock(const void* data, size_type size);
+
+        //!
+        //! Destructor.
+        //! The storage is returned to the pool.
+        //!
+        virtual ~PooledByteBlock();
+
+        //!
+        //! Allocate the memory of an instance, preferably from the pool.
+        //! @param [in] size Size in bytes of the object.
+        //! @return Address of the allocated memory.
+        //!
+        static void* operator new(size_t size);
+
+        //!
+        //! Return the memory of an instance to the pool.
+        //! @param [in] ptr Address of the memory.
+        //! @param [in] size Size in bytes of the object.
+        //!
+        static void operator delete(void* ptr, size_t size);
+
+        //!
+        //! Get the number of free storages in the pool.
+        //! @return The number of free storages in the pool.
+        //!
+        static size_t FreeCount();
+
+        //!
+        //! Pre-allocate storages and objects in the pool.
+        //! The memory of the new storages is touched so that it is actually mapped.
+        //! @param [in] count Requested number of free storages and objects in the pool.
+        //! Limited to MAX_FREE.
+        //!
+        static void Reserve(size_t count);
+
+    private:
+        // Inaccessible operations
+        PooledByteBlock() = delete;
+        PooledByteBlock(const PooledByteBlock&) = delete;
+        PooledByteBlock& operator=(const PooledByteBlock&) = delete;
+    };
+}
@@ -118,16 +118,36 @@ void ts::Report::log(int severity, const UString& msg)
     }
 }
 
-void ts::Report::log(int severity, const UChar* fmt, const std::initializer_list<ArgMixIn>& args)
-{
-    if (severity <= _max_severity) {
-        log(severity, UString::Format(fmt, args));
-    }
+
+//----------------------------------------------------------------------------
+// Format a message in a thread-local buffer and log it.
+//----------------------------------------------------------------------------
+
+namespace {
+    // A subclass may log a formatted message from its writeLog(), typically to
+    // add a prefix. Each nesting level needs its own formatting buffer.
+    const size_t FORMAT_LEVELS = 4;
+
+    // Larger buffers are released after use.
+    const size_t FORMAT_MAX_CAPACITY = 16384;
+
+    thread_local ts::UString format_buffers[FORMAT_LEVELS];
+    thread_local size_t format_depth = 0;
 }
 
-void ts::Report::log(int severity, const UString& fmt, const std::initializer_list<ArgMixIn>& args)
+void ts::Report::logFormat(int severity, const UChar* fmt, const std::initializer_list<ArgMixIn>& args)
 {
-    if (severity <= _max_severity) {
+    if (format_depth >= FORMAT_LEVELS) {
+        // Too many nested levels, use a temporary string.
         log(severity, UString::Format(fmt, args));
     }
+    else {
+        UString& buffer(format_buffers[format_depth++]);
+        buffer.format(fmt, args);
+        log(severity, buffer);
+        if (buffer.capacity() > FORMAT_MAX_CAPACITY) {
+            UString().swap(buffer);
+        }
+        format_depth--;
+    }
 }
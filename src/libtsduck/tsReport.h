@@ -126,6 +126,19 @@ namespace ts {
         //!
         virtual void log(int severity, const UString& msg);
 
+        //!
+        //! Report a message with an explicit severity.
+        //! The message string is built only if @a severity passes the severity filter.
+        //! @param [in] severity Message severity.
+        //! @param [in] msg Message text.
+        //!
+        void log(int severity, const UChar* msg)
+        {
+            if (severity <= _max_severity) {
+                log(severity, UString(msg));
+            }
+        }
+
         //!
         //! Report a message with an explicit severity and a printf-like interface.
         //! @param [in] severity Message severity.
@@ -133,7 +146,16 @@ namespace ts {
         //! @param [in] args List of arguments to substitute in the format string.
         //! @see UString::format()
         //!
-        virtual void log(int severity, const UChar* fmt, const std::initializer_list<ArgMixIn>& args);
+        //! The severity is checked inline: when the message is filtered, the message
+        //! is not formatted at all. Otherwise, the message is formatted in a
+        //! thread-local buffer, without heap allocation in most cases.
+        //!
+        void log(int severity, const UChar* fmt, const std::initializer_list<ArgMixIn>& args)
+        {
+            if (severity <= _max_severity) {
+                logFormat(severity, fmt, args);
+            }
+        }
 
         //!
         //! Report a message with an explicit severity and a printf-like interface.
@@ -142,7 +164,12 @@ namespace ts {
         //! @param [in] args List of arguments to substitute in the format string.
         //! @see UString::format()
         //!
-        virtual void log(int severity, const UString& fmt, const std::initializer_list<ArgMixIn>& args);
+        void log(int severity, const UString& fmt, const std::initializer_list<ArgMixIn>& args)
+        {
+            if (severity <= _max_severity) {
+                logFormat(severity, fmt.c_str(), args);
+            }
+        }
 
         //!
         //! Report a fatal error message.
@@ -150,6 +177,13 @@ namespace ts {
         //!
         void fatal(const UString& msg) { log(Severity::Fatal, msg); }
 
+        //!
+        //! Report a fatal error message.
+        //! The message string is built only if the message passes the severity filter.
+        //! @param [in] msg Message text.
+        //!
+        void fatal(const UChar* msg) { log(Severity::Fatal, msg); }
+
         //!
         //! Report a fatal error message with a printf-like interface.
         //! @param [in] fmt Format string with embedded '\%' sequences.
@@ -172,6 +206,13 @@ namespace ts {
         //!
         void severe(const UString& msg) { log(Severity::Severe, msg); }
 
+        //!
+        //! Report a severe error message.
+        //! The message string is built only if the message passes the severity filter.
+        //! @param [in] msg Message text.
+        //!
+        void severe(const UChar* msg) { log(Severity::Severe, msg); }
+
         //!
         //! Report a severe error message with a printf-like interface.
         //! @param [in] fmt Format string with embedded '\%' sequences.
@@ -194,6 +235,13 @@ namespace ts {
         //!
         void error(const UString& msg) { log(Severity::Error, msg); }
 
+        //!
+        //! Report an error message.
+        //! The message string is built only if the message passes the severity filter.
+        //! @param [in] msg Message text.
+        //!
+        void error(const UChar* msg) { log(Severity::Error, msg); }
+
         //!
         //! Report an error message with a printf-like interface.
         //! @param [in] fmt Format string with embedded '\%' sequences.
@@ -216,6 +264,13 @@ namespace ts {
         //!
         void warning(const UString& msg) { log(Severity::Warning, msg); }
 
+        //!
+        //! Report a warning message.
+        //! The message string is built only if the message passes the severity filter.
+        //! @param [in] msg Message text.
+        //!
+        void warning(const UChar* msg) { log(Severity::Warning, msg); }
+
         //!
         //! Report a warning message with a printf-like interface.
         //! @param [in] fmt Format string with embedded '\%' sequences.
@@ -238,6 +293,13 @@ namespace ts {
         //!
         void info(const UString& msg) { log(Severity::Info, msg); }
 
+        //!
+        //! Report an informational message.
+        //! The message string is built only if the message passes the severity filter.
+        //! @param [in] msg Message text.
+        //!
+        void info(const UChar* msg) { log(Severity::Info, msg); }
+
         //!
         //! Report an informational message with a printf-like interface.
         //! @param [in] fmt Format string with embedded '\%' sequences.
@@ -260,6 +322,13 @@ namespace ts {
         //!
         void verbose(const UString& msg) { log(Severity::Verbose, msg); }
 
+        //!
+        //! Report a verbose message.
+        //! The message string is built only if the message passes the severity filter.
+        //! @param [in] msg Message text.
+        //!
+        void verbose(const UChar* msg) { log(Severity::Verbose, msg); }
+
         //!
         //! Report a verbose message with a printf-like interface.
         //! @param [in] fmt Format string with embedded '\%' sequences.
@@ -282,6 +351,13 @@ namespace ts {
         //!
         void debug(const UString& msg) { log(Severity::Debug, msg); }
 
+        //!
+        //! Report a debug message.
+        //! The message string is built only if the message passes the severity filter.
+        //! @param [in] msg Message text.
+        //!
+        void debug(const UChar* msg) { log(Severity::Debug, msg); }
+
         //!
         //! Report a debug message with a printf-like interface.
         //! @param [in] fmt Format string with embedded '\%' sequences.
@@ -315,5 +391,9 @@ namespace ts {
         //! @param [in] msg Message text.
         //!
         virtual void writeLog(int severity, const UString& msg) = 0;
+
+    private:
+        // Format a message in a thread-local buffer and log it.
+        void logFormat(int severity, const UChar* fmt, const std::initializer_list<ArgMixIn>& args);
     };
 }
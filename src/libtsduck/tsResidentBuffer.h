@@ -44,13 +44,31 @@ namespace ts {
     class ResidentBuffer
     {
     public:
+        //!
+        //! Type of memory pages which are used by the buffer.
+        //!
+        enum PageMode {
+            NORMAL_PAGES,            //!< Normal memory pages.
+            HUGETLB_PAGES,           //!< Explicit huge pages (Linux MAP_HUGETLB).
+            TRANSPARENT_HUGE_PAGES,  //!< Transparent huge pages (Linux madvise MADV_HUGEPAGE).
+        };
+
         //!
         //! Constructor, based on required amount of elements.
         //! Abort application if memory allocation fails.
         //! Do not abort if memory locking fails.
+        //!
+        //! When huge pages are requested, the buffer is first allocated using explicit
+        //! huge pages. If no huge page is available, transparent huge pages are used.
+        //! If neither is available, the buffer falls back to normal pages. Use pageMode()
+        //! to check which type of pages is actually used. Huge pages are available on
+        //! Linux only. On other systems, normal pages are always used.
+        //!
         //! @param [in] elem_count Number of @a T elements.
+        //! @param [in] huge_page_size If non-zero, try to back the buffer with huge pages
+        //! of this size in bytes (typically 2 MB or 1 GB). Must be a power of 2.
         //!
-        ResidentBuffer(size_t elem_count);
+        ResidentBuffer(size_t elem_count, size_t huge_page_size = 0);
 
         //!
         //! Destructor.
@@ -75,6 +93,15 @@ namespace ts {
             return _error_code;
         }
 
+        //!
+        //! Get the type of memory pages which are used by the buffer.
+        //! @return The type of memory pages.
+        //!
+        PageMode pageMode() const
+        {
+            return _page_mode;
+        }
+
         //!
         //! Return base address of the buffer.
         //! @return The address of the first @a T element in the buffer.
@@ -107,7 +134,12 @@ namespace ts {
         size_t    _locked_size;      // Locked size (mlock, multiple of page size)
         size_t    _elem_count;       // Element count in locked region
         bool      _is_locked;        // False if mlock failed.
+        bool      _is_mapped;        // Allocated using mmap (huge pages), not new.
+        PageMode  _page_mode;        // Type of memory pages.
         ErrorCode _error_code;       // Lock error code
+
+        // Try to allocate the buffer using huge pages (Linux only).
+        bool allocateHugePages(size_t requested_size, size_t huge_page_size);
     };
 
 }
@@ -46,7 +46,7 @@
 //----------------------------------------------------------------------------
 
 template <typename T>
-ts::ResidentBuffer<T>::ResidentBuffer(size_t elem_count) :
+ts::ResidentBuffer<T>::ResidentBuffer(size_t elem_count, size_t huge_page_size) :
     _allocated_base(0),
     _locked_base(0),
     _base(0),
@@ -54,28 +54,33 @@ ts::ResidentBuffer<T>::ResidentBuffer(size_t elem_count) :
     _locked_size(0),
     _elem_count(elem_count),
     _is_locked(false),
+    _is_mapped(false),
+    _page_mode(NORMAL_PAGES),
     _error_code(SYS_SUCCESS)
 {
     const size_t requested_size = elem_count * sizeof(T);
     const size_t page_size = SysInfo::Instance()->memoryPageSize();
 
-    // Allocate enough space to include memory pages around the requested size
+    if (huge_page_size == 0 || !allocateHugePages(requested_size, huge_page_size)) {
 
-    _allocated_size = requested_size + 2 * page_size;
-    _allocated_base = new char[_allocated_size];
+        // Allocate enough space to include memory pages around the requested size
 
-    // Locked space starts at next page boundary after allocated base:
-    // Its size is the next multiple of page size after requested_size:
+        _allocated_size = requested_size + 2 * page_size;
+        _allocated_base = new char[_allocated_size];
 
-    _locked_base = (char*)(RoundUp(uint64_t(_allocated_base), uint64_t(page_size)));
-    _locked_size = RoundUp(requested_size, page_size);
+        // Locked space starts at next page boundary after allocated base:
+        // Its size is the next multiple of page size after requested_size:
+
+        _locked_base = (char*)(RoundUp(uint64_t(_allocated_base), uint64_t(page_size)));
+        _locked_size = RoundUp(requested_size, page_size);
+    }
 
     _base = new (_locked_base) T[elem_count];
 
     // Integrity checks
 
     assert(_allocated_base <= _locked_base);
-    assert(_locked_base < _allocated_base + page_size);
+    assert(_locked_base < _allocated_base + std::max(page_size, huge_page_size));
     assert(_locked_base + _locked_size <= _allocated_base + _allocated_size);
     assert(requested_size <= _locked_size);
     assert(_locked_size <= _allocated_size);
@@ -137,7 +142,15 @@ ts::ResidentBuffer<T>::~ResidentBuffer()
 
     // Free memory
     if (_allocated_base != 0) {
-        delete[] _allocated_base;
+#if defined(TS_LINUX)
+        if (_is_mapped) {
+            ::munmap(_allocated_base, _allocated_size);
+        }
+        else
+#endif
+        {
+            delete[] _allocated_base;
+        }
     }
 
     // Reset state (it explicit call of destructor)
@@ -148,4 +161,59 @@ ts::ResidentBuffer<T>::~ResidentBuffer()
     _locked_size = 0;
     _elem_count = 0;
     _is_locked = false;
+    _is_mapped = false;
+}
+
+
+//----------------------------------------------------------------------------
+// Try to allocate the buffer using huge pages (Linux only).
+// Return false if no huge page can be used.
+//----------------------------------------------------------------------------
+
+template <typename T>
+bool ts::ResidentBuffer<T>::allocateHugePages(size_t requested_size, size_t huge_page_size)
+{
+#if defined(TS_LINUX)
+
+    const size_t size = RoundUp(requested_size, huge_page_size);
+
+    // First, try explicit huge pages from the huge pages pool of the system.
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+#if defined(MAP_HUGE_SHIFT)
+    // Specify the huge page size as a power of 2.
+    int log2 = 0;
+    while ((size_t(1) << (log2 + 1)) <= huge_page_size) {
+        log2++;
+    }
+    flags |= log2 << MAP_HUGE_SHIFT;
+#endif
+    void* addr = ::mmap(0, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (addr != MAP_FAILED) {
+        _allocated_base = _locked_base = reinterpret_cast<char*>(addr);
+        _allocated_size = _locked_size = size;
+        _is_mapped = true;
+        _page_mode = HUGETLB_PAGES;
+        return true;
+    }
+
+    // Then, try transparent huge pages. Allocate an anonymous mapping with
+    // an additional huge page to align the buffer on a huge page boundary.
+    addr = ::mmap(0, size + huge_page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+    _allocated_base = reinterpret_cast<char*>(addr);
+    _allocated_size = size + huge_page_size;
+    _locked_base = reinterpret_cast<char*>(RoundUp(uint64_t(_allocated_base), uint64_t(huge_page_size)));
+    _locked_size = size;
+    _is_mapped = true;
+    if (::madvise(_locked_base, _locked_size, MADV_HUGEPAGE) == 0) {
+        _page_mode = TRANSPARENT_HUGE_PAGES;
+    }
+    return true;
+
+#else
+    // Huge pages not supported on this system.
+    return false;
+#endif
 }
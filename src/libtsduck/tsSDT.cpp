@@ -340,24 +340,38 @@ bool ts::SDT::Service::locateServiceDescriptor(ServiceDescriptor& desc, const DV
 //----------------------------------------------------------------------------
 // Return the service type, service name and provider name (all found from
 // the first DVB "service descriptor", if there is one in the list).
+// Only the requested field is decoded from the binary descriptor, the other
+// name is not converted from its DVB character set.
 //----------------------------------------------------------------------------
 
 uint8_t ts::SDT::Service::serviceType() const
 {
-    ServiceDescriptor sd;
-    return locateServiceDescriptor(sd) ? sd.service_type : 0; // 0 is a "reserved" service_type value
+    const size_t index = descs.search(DID_SERVICE);
+    uint8_t type = 0; // 0 is a "reserved" service_type value
+    if (index < descs.count()) {
+        ServiceDescriptor::DecodeFields(*descs[index], &type, 0, 0);
+    }
+    return type;
 }
 
 ts::UString ts::SDT::Service::providerName(const DVBCharset* charset) const
 {
-    ServiceDescriptor sd;
-    return locateServiceDescriptor(sd, charset) ? sd.provider_name : UString();
+    const size_t index = descs.search(DID_SERVICE);
+    UString provider;
+    if (index < descs.count()) {
+        ServiceDescriptor::DecodeFields(*descs[index], 0, &provider, 0, charset);
+    }
+    return provider;
 }
 
 ts::UString ts::SDT::Service::serviceName(const DVBCharset* charset) const
 {
-    ServiceDescriptor sd;
-    return locateServiceDescriptor(sd, charset) ? sd.service_name : UString();
+    const size_t index = descs.search(DID_SERVICE);
+    UString name;
+    if (index < descs.count()) {
+        ServiceDescriptor::DecodeFields(*descs[index], 0, 0, &name, charset);
+    }
+    return name;
 }
 
 
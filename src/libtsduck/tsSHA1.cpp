@@ -14,6 +14,7 @@
 //----------------------------------------------------------------------------
 
 #include "tsSHA1.h"
+#include "tsSysInfo.h"
 TSDUCK_SOURCE;
 
 #define F0(x,y,z)  (z ^ (x & (y ^ z)))
@@ -21,6 +22,159 @@ TSDUCK_SOURCE;
 #define F2(x,y,z)  ((x & y) | (z & (x | y)))
 #define F3(x,y,z)  (x ^ y ^ z)
 
+// On x86 processors, the SHA extensions (SHA-NI) are used when available at runtime.
+// On ARM64 processors, the ARMv8 SHA1 instructions are used when available.
+#if !defined(TS_NO_SHA_INSTRUCTIONS) && (defined(TS_I386) || defined(TS_X86_64)) && \
+    (defined(TS_MSC) || defined(TS_LLVM) || (defined(TS_GCC_ONLY) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+    #define TS_SHA_NI 1
+    #include <immintrin.h>
+    #if defined(TS_MSC)
+        #define TS_TARGET_SHA
+    #else
+        #define TS_TARGET_SHA __attribute__((target("sha,sse4.1")))
+    #endif
+#elif !defined(TS_NO_SHA_INSTRUCTIONS) && defined(TS_ARM64) && defined(TS_LINUX) && \
+    ((defined(TS_GCC_ONLY) && __GNUC__ >= 8) || (defined(TS_LLVM) && (defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_SHA2))))
+    #define TS_SHA_ARMV8 1
+    #include <arm_neon.h>
+    #if defined(TS_GCC_ONLY)
+        #define TS_TARGET_SHA __attribute__((target("+crypto")))
+    #else
+        #define TS_TARGET_SHA
+    #endif
+#endif
+
+namespace {
+
+    // Check if the CPU supports the SHA-1 instructions. Evaluated once.
+    bool CheckSHAInstructions()
+    {
+#if defined(TS_SHA_NI)
+        // The SHA-NI code also uses SSSE3 and SSE4.1 instructions.
+        const ts::SysInfo* sys = ts::SysInfo::Instance();
+        return sys->cpuHasSHA1() && sys->cpuHasSSSE3() && sys->cpuHasSSE41();
+#elif defined(TS_SHA_ARMV8)
+        return ts::SysInfo::Instance()->cpuHasSHA1();
+#else
+        return false;
+#endif
+    }
+
+    bool SHAInstructions()
+    {
+        static const bool supported = CheckSHAInstructions();
+        return supported;
+    }
+
+#if defined(TS_SHA_NI)
+
+    // Compress blocks using the SHA-NI instructions.
+    // The 80 rounds are processed as 20 quad-rounds. The message schedule
+    // for the quad-round i+4 is computed in the quad-rounds i+1 to i+3.
+    TS_TARGET_SHA void CompressInstructions(uint32_t* state, const uint8_t* data, size_t count)
+    {
+        const __m128i mask = _mm_set_epi64x(0x0001020304050607LL, 0x08090A0B0C0D0E0FLL);
+        __m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0x1B);
+        __m128i e0 = _mm_set_epi32(int(state[4]), 0, 0, 0);
+        __m128i e1;
+        __m128i W[4];
+
+        #define QUAD(i, f, ea, eb)                                                             \
+            if ((i) == 0) {                                                                    \
+                ea = _mm_add_epi32(ea, W[0]);                                                  \
+            }                                                                                  \
+            else {                                                                             \
+                ea = _mm_sha1nexte_epu32(ea, W[(i) % 4]);                                      \
+            }                                                                                  \
+            eb = abcd;                                                                         \
+            abcd = _mm_sha1rnds4_epu32(abcd, ea, f);                                           \
+            if ((i) >= 1 && (i) <= 16) {                                                       \
+                W[((i) + 3) % 4] = _mm_sha1msg1_epu32(W[((i) + 3) % 4], W[(i) % 4]);           \
+            }                                                                                  \
+            if ((i) >= 2 && (i) <= 17) {                                                       \
+                W[((i) + 2) % 4] = _mm_xor_si128(W[((i) + 2) % 4], W[(i) % 4]);               \
+            }                                                                                  \
+            if ((i) >= 3 && (i) <= 18) {                                                       \
+                W[((i) + 1) % 4] = _mm_sha1msg2_epu32(W[((i) + 1) % 4], W[(i) % 4]);           \
+            }
+
+        for (; count > 0; --count, data += ts::SHA1::BLOCK_SIZE) {
+            const __m128i abcd_save = abcd;
+            const __m128i e0_save = e0;
+
+            for (size_t i = 0; i < 4; ++i) {
+                W[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16 * i)), mask);
+            }
+
+            QUAD( 0, 0, e0, e1) QUAD( 1, 0, e1, e0) QUAD( 2, 0, e0, e1) QUAD( 3, 0, e1, e0) QUAD( 4, 0, e0, e1)
+            QUAD( 5, 1, e1, e0) QUAD( 6, 1, e0, e1) QUAD( 7, 1, e1, e0) QUAD( 8, 1, e0, e1) QUAD( 9, 1, e1, e0)
+            QUAD(10, 2, e0, e1) QUAD(11, 2, e1, e0) QUAD(12, 2, e0, e1) QUAD(13, 2, e1, e0) QUAD(14, 2, e0, e1)
+            QUAD(15, 3, e1, e0) QUAD(16, 3, e0, e1) QUAD(17, 3, e1, e0) QUAD(18, 3, e0, e1) QUAD(19, 3, e1, e0)
+
+            e0 = _mm_sha1nexte_epu32(e0, e0_save);
+            abcd = _mm_add_epi32(abcd, abcd_save);
+        }
+
+        #undef QUAD
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(state), _mm_shuffle_epi32(abcd, 0x1B));
+        state[4] = uint32_t(_mm_extract_epi32(e0, 3));
+    }
+
+#elif defined(TS_SHA_ARMV8)
+
+    // Compress blocks using the ARMv8 SHA1 instructions, one quad-round at a time.
+    TS_TARGET_SHA void CompressInstructions(uint32_t* state, const uint8_t* data, size_t count)
+    {
+        const uint32x4_t k0 = vdupq_n_u32(0x5A827999);
+        const uint32x4_t k1 = vdupq_n_u32(0x6ED9EBA1);
+        const uint32x4_t k2 = vdupq_n_u32(0x8F1BBCDC);
+        const uint32x4_t k3 = vdupq_n_u32(0xCA62C1D6);
+        uint32x4_t abcd = vld1q_u32(state);
+        uint32_t e0 = state[4];
+        uint32_t e1;
+        uint32x4_t W[4];
+
+        #define QUAD(i, op, k, ea, eb)                                                         \
+            {                                                                                  \
+                const uint32x4_t wk = vaddq_u32(W[(i) % 4], k);                                \
+                eb = vsha1h_u32(vgetq_lane_u32(abcd, 0));                                      \
+                abcd = op(abcd, ea, wk);                                                       \
+                if ((i) < 16) {                                                                \
+                    W[(i) % 4] = vsha1su1q_u32(vsha1su0q_u32(W[(i) % 4], W[((i) + 1) % 4], W[((i) + 2) % 4]), W[((i) + 3) % 4]); \
+                }                                                                              \
+            }
+
+        for (; count > 0; --count, data += ts::SHA1::BLOCK_SIZE) {
+            const uint32x4_t abcd_save = abcd;
+            const uint32_t e0_save = e0;
+
+            for (size_t i = 0; i < 4; ++i) {
+                W[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 16 * i)));
+            }
+
+            QUAD( 0, vsha1cq_u32, k0, e0, e1) QUAD( 1, vsha1cq_u32, k0, e1, e0) QUAD( 2, vsha1cq_u32, k0, e0, e1)
+            QUAD( 3, vsha1cq_u32, k0, e1, e0) QUAD( 4, vsha1cq_u32, k0, e0, e1)
+            QUAD( 5, vsha1pq_u32, k1, e1, e0) QUAD( 6, vsha1pq_u32, k1, e0, e1) QUAD( 7, vsha1pq_u32, k1, e1, e0)
+            QUAD( 8, vsha1pq_u32, k1, e0, e1) QUAD( 9, vsha1pq_u32, k1, e1, e0)
+            QUAD(10, vsha1mq_u32, k2, e0, e1) QUAD(11, vsha1mq_u32, k2, e1, e0) QUAD(12, vsha1mq_u32, k2, e0, e1)
+            QUAD(13, vsha1mq_u32, k2, e1, e0) QUAD(14, vsha1mq_u32, k2, e0, e1)
+            QUAD(15, vsha1pq_u32, k3, e1, e0) QUAD(16, vsha1pq_u32, k3, e0, e1) QUAD(17, vsha1pq_u32, k3, e1, e0)
+            QUAD(18, vsha1pq_u32, k3, e0, e1) QUAD(19, vsha1pq_u32, k3, e1, e0)
+
+            abcd = vaddq_u32(abcd, abcd_save);
+            e0 += e0_save;
+        }
+
+        #undef QUAD
+
+        vst1q_u32(state, abcd);
+        state[4] = e0;
+    }
+
+#endif
+}
+
 
 //----------------------------------------------------------------------------
 // Constructor
@@ -58,6 +212,13 @@ bool ts::SHA1::init()
 
 void ts::SHA1::compress(const uint8_t* buf)
 {
+#if defined(TS_SHA_NI) || defined(TS_SHA_ARMV8)
+    if (SHAInstructions()) {
+        CompressInstructions(_state, buf, 1);
+        return;
+    }
+#endif
+
     uint32_t a,b,c,d,e,W[80],i;
 
     // Copy the state into 512-bits into W[0..15]
@@ -133,6 +294,25 @@ void ts::SHA1::compress(const uint8_t* buf)
 }
 
 
+//----------------------------------------------------------------------------
+// Compress several contiguous blocks of message
+//----------------------------------------------------------------------------
+
+void ts::SHA1::compressBlocks(const uint8_t* buf, size_t count)
+{
+#if defined(TS_SHA_NI) || defined(TS_SHA_ARMV8)
+    if (SHAInstructions()) {
+        CompressInstructions(_state, buf, count);
+        return;
+    }
+#endif
+
+    for (; count > 0; --count, buf += BLOCK_SIZE) {
+        compress(buf);
+    }
+}
+
+
 //----------------------------------------------------------------------------
 // Add some part of the message to hash. Can be called several times.
 // Return true on success, false on error.
@@ -148,10 +328,11 @@ bool ts::SHA1::add(const void* data, size_t size)
     }
     while (size > 0) {
         if (_curlen == 0 && size >= BLOCK_SIZE) {
-            compress (in);
-            _length += BLOCK_SIZE * 8;
-            in += BLOCK_SIZE;
-            size -= BLOCK_SIZE;
+            n = size / BLOCK_SIZE;
+            compressBlocks(in, n);
+            _length += n * BLOCK_SIZE * 8;
+            in += n * BLOCK_SIZE;
+            size -= n * BLOCK_SIZE;
         }
         else {
             n = std::min(size, (BLOCK_SIZE - _curlen));
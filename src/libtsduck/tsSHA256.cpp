@@ -14,6 +14,7 @@
 //----------------------------------------------------------------------------
 
 #include "tsSHA256.h"
+#include "tsSysInfo.h"
 TSDUCK_SOURCE;
 
 #define Ch(x,y,z)  (z ^ (x & (y ^ z)))
@@ -25,6 +26,161 @@ TSDUCK_SOURCE;
 #define Gamma0(x)  (S(x, 7) ^ S(x, 18) ^ R(x, 3))
 #define Gamma1(x)  (S(x, 17) ^ S(x, 19) ^ R(x, 10))
 
+// On x86 processors, the SHA extensions (SHA-NI) are used when available at runtime.
+// On ARM64 processors, the ARMv8 SHA2 instructions are used when available.
+#if !defined(TS_NO_SHA_INSTRUCTIONS) && (defined(TS_I386) || defined(TS_X86_64)) && \
+    (defined(TS_MSC) || defined(TS_LLVM) || (defined(TS_GCC_ONLY) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+    #define TS_SHA_NI 1
+    #include <immintrin.h>
+    #if defined(TS_MSC)
+        #define TS_TARGET_SHA
+    #else
+        #define TS_TARGET_SHA __attribute__((target("sha,sse4.1")))
+    #endif
+#elif !defined(TS_NO_SHA_INSTRUCTIONS) && defined(TS_ARM64) && defined(TS_LINUX) && \
+    ((defined(TS_GCC_ONLY) && __GNUC__ >= 8) || (defined(TS_LLVM) && (defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_SHA2))))
+    #define TS_SHA_ARMV8 1
+    #include <arm_neon.h>
+    #if defined(TS_GCC_ONLY)
+        #define TS_TARGET_SHA __attribute__((target("+crypto")))
+    #else
+        #define TS_TARGET_SHA
+    #endif
+#endif
+
+#if defined(TS_SHA_NI) || defined(TS_SHA_ARMV8)
+namespace {
+
+    // Round constants, as used by the SHA instructions (same values as in compress()).
+    const uint32_t K[64] = {
+        0x428A2F98UL, 0x71374491UL, 0xB5C0FBCFUL, 0xE9B5DBA5UL,
+        0x3956C25BUL, 0x59F111F1UL, 0x923F82A4UL, 0xAB1C5ED5UL,
+        0xD807AA98UL, 0x12835B01UL, 0x243185BEUL, 0x550C7DC3UL,
+        0x72BE5D74UL, 0x80DEB1FEUL, 0x9BDC06A7UL, 0xC19BF174UL,
+        0xE49B69C1UL, 0xEFBE4786UL, 0x0FC19DC6UL, 0x240CA1CCUL,
+        0x2DE92C6FUL, 0x4A7484AAUL, 0x5CB0A9DCUL, 0x76F988DAUL,
+        0x983E5152UL, 0xA831C66DUL, 0xB00327C8UL, 0xBF597FC7UL,
+        0xC6E00BF3UL, 0xD5A79147UL, 0x06CA6351UL, 0x14292967UL,
+        0x27B70A85UL, 0x2E1B2138UL, 0x4D2C6DFCUL, 0x53380D13UL,
+        0x650A7354UL, 0x766A0ABBUL, 0x81C2C92EUL, 0x92722C85UL,
+        0xA2BFE8A1UL, 0xA81A664BUL, 0xC24B8B70UL, 0xC76C51A3UL,
+        0xD192E819UL, 0xD6990624UL, 0xF40E3585UL, 0x106AA070UL,
+        0x19A4C116UL, 0x1E376C08UL, 0x2748774CUL, 0x34B0BCB5UL,
+        0x391C0CB3UL, 0x4ED8AA4AUL, 0x5B9CCA4FUL, 0x682E6FF3UL,
+        0x748F82EEUL, 0x78A5636FUL, 0x84C87814UL, 0x8CC70208UL,
+        0x90BEFFFAUL, 0xA4506CEBUL, 0xBEF9A3F7UL, 0xC67178F2UL,
+    };
+
+    // Check if the CPU supports the SHA-256 instructions. Evaluated once.
+    bool CheckSHAInstructions()
+    {
+#if defined(TS_SHA_NI)
+        // The SHA-NI code also uses SSSE3 and SSE4.1 instructions.
+        const ts::SysInfo* sys = ts::SysInfo::Instance();
+        return sys->cpuHasSHA256() && sys->cpuHasSSSE3() && sys->cpuHasSSE41();
+#else
+        return ts::SysInfo::Instance()->cpuHasSHA256();
+#endif
+    }
+
+    bool SHAInstructions()
+    {
+        static const bool supported = CheckSHAInstructions();
+        return supported;
+    }
+
+#if defined(TS_SHA_NI)
+
+    // Compress blocks using the SHA-NI instructions.
+    // The state is kept as two vectors ABEF and CDGH, as required by sha256rnds2.
+    TS_TARGET_SHA void CompressInstructions(uint32_t* state, const uint8_t* data, size_t count)
+    {
+        const __m128i mask = _mm_set_epi64x(0x0C0D0E0F08090A0BLL, 0x0405060700010203LL);
+        __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0xB1);   // CDAB
+        __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4)), 0x1B); // EFGH
+        __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);    // ABEF
+        state1 = _mm_blend_epi16(state1, tmp, 0xF0);         // CDGH
+        __m128i msg;
+        __m128i W[4];
+
+        // One quad-round. The message schedule for the quad-round i+4
+        // is computed in the quad-rounds i+1 (msg1) and i+3 (msg2).
+        #define QUAD(i)                                                                              \
+            msg = _mm_add_epi32(W[(i) % 4], _mm_loadu_si128(reinterpret_cast<const __m128i*>(K + 4 * (i)))); \
+            state1 = _mm_sha256rnds2_epu32(state1, state0, msg);                                     \
+            if ((i) >= 3 && (i) <= 14) {                                                             \
+                tmp = _mm_alignr_epi8(W[(i) % 4], W[((i) + 3) % 4], 4);                              \
+                W[((i) + 1) % 4] = _mm_sha256msg2_epu32(_mm_add_epi32(W[((i) + 1) % 4], tmp), W[(i) % 4]); \
+            }                                                                                        \
+            state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(msg, 0x0E));           \
+            if ((i) >= 1 && (i) <= 12) {                                                             \
+                W[((i) + 3) % 4] = _mm_sha256msg1_epu32(W[((i) + 3) % 4], W[(i) % 4]);              \
+            }
+
+        for (; count > 0; --count, data += ts::SHA256::BLOCK_SIZE) {
+            const __m128i abef_save = state0;
+            const __m128i cdgh_save = state1;
+
+            for (size_t i = 0; i < 4; ++i) {
+                W[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16 * i)), mask);
+            }
+
+            QUAD(0)  QUAD(1)  QUAD(2)  QUAD(3)  QUAD(4)  QUAD(5)  QUAD(6)  QUAD(7)
+            QUAD(8)  QUAD(9)  QUAD(10) QUAD(11) QUAD(12) QUAD(13) QUAD(14) QUAD(15)
+
+            state0 = _mm_add_epi32(state0, abef_save);
+            state1 = _mm_add_epi32(state1, cdgh_save);
+        }
+
+        #undef QUAD
+
+        tmp = _mm_shuffle_epi32(state0, 0x1B);         // FEBA
+        state1 = _mm_shuffle_epi32(state1, 0xB1);      // DCHG
+        state0 = _mm_blend_epi16(tmp, state1, 0xF0);   // DCBA
+        state1 = _mm_alignr_epi8(state1, tmp, 8);      // HGFE
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(state), state0);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4), state1);
+    }
+
+#else
+
+    // Compress blocks using the ARMv8 SHA2 instructions.
+    TS_TARGET_SHA void CompressInstructions(uint32_t* state, const uint8_t* data, size_t count)
+    {
+        uint32x4_t state0 = vld1q_u32(state);
+        uint32x4_t state1 = vld1q_u32(state + 4);
+        uint32x4_t W[4];
+
+        for (; count > 0; --count, data += ts::SHA256::BLOCK_SIZE) {
+            const uint32x4_t abcd_save = state0;
+            const uint32x4_t efgh_save = state1;
+
+            for (size_t i = 0; i < 4; ++i) {
+                W[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 16 * i)));
+            }
+
+            for (size_t i = 0; i < 16; ++i) {
+                const uint32x4_t wk = vaddq_u32(W[i % 4], vld1q_u32(K + 4 * i));
+                const uint32x4_t abcd = state0;
+                state0 = vsha256hq_u32(state0, state1, wk);
+                state1 = vsha256h2q_u32(state1, abcd, wk);
+                if (i < 12) {
+                    W[i % 4] = vsha256su1q_u32(vsha256su0q_u32(W[i % 4], W[(i + 1) % 4]), W[(i + 2) % 4], W[(i + 3) % 4]);
+                }
+            }
+
+            state0 = vaddq_u32(state0, abcd_save);
+            state1 = vaddq_u32(state1, efgh_save);
+        }
+
+        vst1q_u32(state, state0);
+        vst1q_u32(state + 4, state1);
+    }
+
+#endif
+}
+#endif
+
 
 //----------------------------------------------------------------------------
 // Constructor
@@ -65,6 +221,13 @@ bool ts::SHA256::init()
 
 void ts::SHA256::compress (const uint8_t* buf)
 {
+#if defined(TS_SHA_NI) || defined(TS_SHA_ARMV8)
+    if (SHAInstructions()) {
+        CompressInstructions(_state, buf, 1);
+        return;
+    }
+#endif
+
     uint32_t S[8], W[64], t0, t1;
 
     /* copy state into S */
@@ -163,6 +326,25 @@ void ts::SHA256::compress (const uint8_t* buf)
 }
 
 
+//----------------------------------------------------------------------------
+// Compress several contiguous blocks of message
+//----------------------------------------------------------------------------
+
+void ts::SHA256::compressBlocks (const uint8_t* buf, size_t count)
+{
+#if defined(TS_SHA_NI) || defined(TS_SHA_ARMV8)
+    if (SHAInstructions()) {
+        CompressInstructions(_state, buf, count);
+        return;
+    }
+#endif
+
+    for (; count > 0; --count, buf += BLOCK_SIZE) {
+        compress (buf);
+    }
+}
+
+
 //----------------------------------------------------------------------------
 // Add some part of the message to hash. Can be called several times.
 // Return true on success, false on error.
@@ -178,10 +360,11 @@ bool ts::SHA256::add (const void* data, size_t size)
     }
     while (size > 0) {
         if (_curlen == 0 && size >= BLOCK_SIZE) {
-            compress (in);
-            _length += BLOCK_SIZE * 8;
-            in += BLOCK_SIZE;
-            size -= BLOCK_SIZE;
+            n = size / BLOCK_SIZE;
+            compressBlocks (in, n);
+            _length += n * BLOCK_SIZE * 8;
+            in += n * BLOCK_SIZE;
+            size -= n * BLOCK_SIZE;
         }
         else {
             n = std::min (size, (BLOCK_SIZE - _curlen));
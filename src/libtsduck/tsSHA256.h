@@ -59,6 +59,7 @@ namespace ts {
 
     private:
         void compress(const uint8_t* buf);
+        void compressBlocks(const uint8_t* buf, size_t count);
         uint64_t _length;
         uint32_t _state[8];
         size_t   _curlen;
@@ -38,8 +38,33 @@
 #include "tsGuard.h"
 #include "tsMutex.h"
 #include "tsNullMutex.h"
+#include <atomic>
 
 namespace ts {
+    //!
+    //! Type of the internal counters and pointers of a ts::SafePtr.
+    //!
+    //! With an actual mutex, the reference counter and the pointer are atomic
+    //! so that copying, destroying and dereferencing a safe pointer does not
+    //! need to lock the mutex. With ts::NullMutex, there is no synchronization.
+    //!
+    //! @tparam T The type of the value.
+    //! @tparam MUTEX The type of mutex of the safe pointer.
+    //!
+    template <typename T, class MUTEX>
+    struct SafePtrAtomic
+    {
+        typedef std::atomic<T> type;  //!< Atomic type for thread-safe safe pointers.
+    };
+
+    //! @cond nodoxygen
+    template <typename T>
+    struct SafePtrAtomic<T, NullMutex>
+    {
+        typedef T type;
+    };
+    //! @endcond
+
     //!
     //!  Template safe pointer (reference-counted, auto-delete, thread-safe).
     //!
@@ -79,7 +104,14 @@ namespace ts {
     //!  ts::NullMutex is used. The default implementation is consequently
     //!  not thread-safe but there is no synchronization overhead. To use
     //!  safe pointers in a multi-thread environment, specify an actual
-    //!  mutex implementation for the target environment.
+    //!  mutex implementation for the target environment. The mutex is used only
+    //!  to modify the pointed object (reset, release, casts). The reference counter
+    //!  and the pointer are atomic: copying, destroying and dereferencing a safe
+    //!  pointer never locks the mutex.
+    //!
+    //!  Safe pointers can be moved. Moving a safe pointer transfers its reference
+    //!  without touching the reference counter. The moved-from safe pointer becomes
+    //!  a null pointer.
     //!
     //!  @tparam T The type of the pointed object. Cannot be an array type.
     //!  @tparam MUTEX A subclass of ts::MutexInterface which is used to
@@ -127,10 +159,24 @@ namespace ts {
         //! @param [in] sp Another safe pointer instance.
         //!
         SafePtr(const SafePtr<T,MUTEX> &sp) :
-            _shared(sp._shared->attach())
+            _shared(sp._shared == 0 ? 0 : sp._shared->attach())
         {
         }
 
+        //!
+        //! Move constructor.
+        //!
+        //! This object takes over the reference of @a sp, the reference counter is unchanged.
+        //! After the move, @a sp is a null pointer.
+        //!
+        //! @param [in,out] sp Another safe pointer instance.
+        //!
+        SafePtr(SafePtr<T,MUTEX>&& sp) noexcept :
+            _shared(sp._shared)
+        {
+            sp._shared = 0;
+        }
+
         //!
         //! Destructor.
         //!
@@ -154,6 +200,21 @@ namespace ts {
         //!
         SafePtr<T,MUTEX>& operator=(const SafePtr<T,MUTEX>& sp);
 
+        //!
+        //! Move assignment between safe pointers.
+        //!
+        //! After the assignment, this object references the same @a T object
+        //! as @a sp did, without modification of the reference counter, and
+        //! @a sp is a null pointer. If this object was previously not the null
+        //! pointer, the reference counter of the previously referenced @a T object
+        //! is decremented. If the reference counter reaches zero, the previously
+        //! pointed object is automatically deleted.
+        //!
+        //! @param [in,out] sp The value to move.
+        //! @return A reference to this object.
+        //!
+        SafePtr<T,MUTEX>& operator=(SafePtr<T,MUTEX>&& sp) noexcept;
+
         //!
         //! Assignment from a standard pointer @c T*.
         //!
@@ -244,7 +305,7 @@ namespace ts {
         //!
         T* operator->() const
         {
-            return _shared->pointer();
+            return pointer();
         }
 
         //!
@@ -267,7 +328,7 @@ namespace ts {
         //!
         T& operator*() const
         {
-            return *_shared->pointer();
+            return *pointer();
         }
 
         //!
@@ -286,7 +347,7 @@ namespace ts {
         //!
         T* release()
         {
-            return _shared->release();
+            return _shared == 0 ? 0 : _shared->release();
         }
 
         //!
@@ -303,10 +364,7 @@ namespace ts {
         //!
         //! @param [in] p A pointer to an object of class @a T.
         //!
-        void reset(T *p = 0)
-        {
-            _shared->reset(p);
-        }
+        void reset(T *p = 0);
 
         //!
         //! Clear this instance of the safe pointer.
@@ -320,7 +378,9 @@ namespace ts {
         //!
         void clear()
         {
-            _shared->detach();
+            if (_shared != 0) {
+                _shared->detach();
+            }
             _shared = new SafePtrShared(0);
         }
 
@@ -332,7 +392,7 @@ namespace ts {
         //!
         bool isNull() const
         {
-            return _shared->isNull();
+            return _shared == 0 || _shared->isNull();
         }
 
         //!
@@ -354,7 +414,7 @@ namespace ts {
         template <typename ST>
         SafePtr<ST,MUTEX> upcast()
         {
-            return _shared->template upcast<ST>();
+            return _shared == 0 ? SafePtr<ST,MUTEX>() : _shared->template upcast<ST>();
         }
 
         //!
@@ -383,7 +443,7 @@ namespace ts {
         template <typename ST>
         SafePtr<ST,MUTEX> downcast()
         {
-            return _shared->template downcast<ST>();
+            return _shared == 0 ? SafePtr<ST,MUTEX>() : _shared->template downcast<ST>();
         }
 
         //!
@@ -404,7 +464,7 @@ namespace ts {
         template <typename NEWMUTEX>
         SafePtr<T,NEWMUTEX> changeMutex()
         {
-            return _shared->template changeMutex<NEWMUTEX>();
+            return _shared == 0 ? SafePtr<T,NEWMUTEX>() : _shared->template changeMutex<NEWMUTEX>();
         }
 
         //!
@@ -420,7 +480,7 @@ namespace ts {
         //!
         T* pointer() const
         {
-            return _shared->pointer();
+            return _shared == 0 ? 0 : _shared->pointer();
         }
 
         //!
@@ -431,18 +491,19 @@ namespace ts {
         //! actually used.
         //!
         //! @return The number of safe pointer objects which reference
-        //! the same pointed object.
+        //! the same pointed object. Zero on a moved-from safe pointer.
         //!
         int count() const
         {
-            return _shared->count();
+            return _shared == 0 ? 0 : _shared->count();
         }
 
     private:
         //! @cond nodoxygen
 
         // All safe pointer objects which reference the same @c T object share
-        // one single @c SafePtrShared object.
+        // one single @c SafePtrShared object. A moved-from safe pointer has none
+        // and is a null pointer.
         class SafePtrShared;
         // cppcheck-suppress unsafeClassCanLeak // pointer is managed through its detach() method
         SafePtrShared* _shared;
@@ -451,9 +512,9 @@ namespace ts {
         {
         private:
             // Private members:
-            T*    _ptr;        // pointer to actual object
-            int   _ref_count;  // reference counter
-            MUTEX _mutex;      // protect the SafePtrShared
+            typename SafePtrAtomic<T*,MUTEX>::type  _ptr;        // pointer to actual object
+            typename SafePtrAtomic<int,MUTEX>::type _ref_count;  // reference counter
+            MUTEX _mutex;  // serialize modifications of the pointer
 
             // Inaccessible operators
             SafePtrShared(const SafePtrShared&) = delete;
@@ -492,7 +553,7 @@ namespace ts {
             template <typename ST> SafePtr<ST,MUTEX> downcast()
             {
                 Guard lock(_mutex);
-                ST* sp = dynamic_cast<ST*>(_ptr);
+                ST* sp = dynamic_cast<ST*>(static_cast<T*>(_ptr));
                 if (sp != 0) {
                     // Successful downcast, the original safe pointer must be released.
                     _ptr = 0;
@@ -504,7 +565,7 @@ namespace ts {
             template <typename ST> SafePtr<ST,MUTEX> upcast()
             {
                 Guard lock(_mutex);
-                ST* sp = _ptr;
+                ST* sp = static_cast<T*>(_ptr);
                 _ptr = 0;
                 return SafePtr<ST,MUTEX>(sp);
             }
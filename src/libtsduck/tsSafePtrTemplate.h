@@ -51,13 +51,49 @@ template <typename T, class MUTEX>
 ts::SafePtr<T,MUTEX>& ts::SafePtr<T,MUTEX>::operator= (const SafePtr<T,MUTEX>& sp)
 {
     if (_shared != sp._shared) {
-        _shared->detach ();
-        _shared = sp._shared->attach ();
+        if (_shared != 0) {
+            _shared->detach ();
+        }
+        _shared = sp._shared == 0 ? 0 : sp._shared->attach ();
     }
     return *this;
 }
 
 
+//----------------------------------------------------------------------------
+// Move assignment between safe pointers.
+//----------------------------------------------------------------------------
+
+template <typename T, class MUTEX>
+ts::SafePtr<T,MUTEX>& ts::SafePtr<T,MUTEX>::operator=(SafePtr<T,MUTEX>&& sp) noexcept
+{
+    if (this != &sp) {
+        if (_shared != 0) {
+            _shared->detach();
+        }
+        _shared = sp._shared;
+        sp._shared = 0;
+    }
+    return *this;
+}
+
+
+//----------------------------------------------------------------------------
+// Deallocate the previous pointed object and set the pointer to the new object.
+//----------------------------------------------------------------------------
+
+template <typename T, class MUTEX>
+void ts::SafePtr<T,MUTEX>::reset(T* p)
+{
+    if (_shared == 0) {
+        _shared = new SafePtrShared(p);
+    }
+    else {
+        _shared->reset(p);
+    }
+}
+
+
 //----------------------------------------------------------------------------
 // Assignment from a standard pointer T*.
 //----------------------------------------------------------------------------
@@ -65,7 +101,9 @@ ts::SafePtr<T,MUTEX>& ts::SafePtr<T,MUTEX>::operator= (const SafePtr<T,MUTEX>& s
 template <typename T, class MUTEX>
 ts::SafePtr<T,MUTEX>& ts::SafePtr<T,MUTEX>::operator=(T* p)
 {
-    _shared->detach ();
+    if (_shared != 0) {
+        _shared->detach ();
+    }
     _shared = new SafePtrShared (p);
     return *this;
 }
@@ -78,8 +116,9 @@ ts::SafePtr<T,MUTEX>& ts::SafePtr<T,MUTEX>::operator=(T* p)
 template <typename T, class MUTEX>
 ts::SafePtr<T,MUTEX>::SafePtrShared::~SafePtrShared()
 {
-    if (_ptr != 0) {
-        delete _ptr;
+    T* const ptr = _ptr;
+    if (ptr != 0) {
+        delete ptr;
         _ptr = 0;
     }
 }
@@ -94,7 +133,7 @@ template <typename T, class MUTEX>
 T* ts::SafePtr<T,MUTEX>::SafePtrShared::release()
 {
     Guard lock (_mutex);
-    T* previous (_ptr);
+    T* previous = _ptr;
     _ptr = 0;
     return previous;
 }
@@ -108,21 +147,21 @@ template <typename T, class MUTEX>
 void ts::SafePtr<T,MUTEX>::SafePtrShared::reset (T* p)
 {
     Guard lock (_mutex);
-    if (_ptr != 0) {
-        delete _ptr;
-    }
+    T* const previous = _ptr;
     _ptr = p;
+    if (previous != 0) {
+        delete previous;
+    }
 }
 
 
 //----------------------------------------------------------------------------
-// Get the pointer value.
+// Get the pointer value. The pointer is atomic, no need to lock.
 //----------------------------------------------------------------------------
 
 template <typename T, class MUTEX>
 T* ts::SafePtr<T,MUTEX>::SafePtrShared::pointer()
 {
-    Guard lock (_mutex);
     return _ptr;
 }
 
@@ -134,7 +173,6 @@ T* ts::SafePtr<T,MUTEX>::SafePtrShared::pointer()
 template <typename T, class MUTEX>
 int ts::SafePtr<T,MUTEX>::SafePtrShared::count()
 {
-    Guard lock (_mutex);
     return _ref_count;
 }
 
@@ -146,19 +184,18 @@ int ts::SafePtr<T,MUTEX>::SafePtrShared::count()
 template <typename T, class MUTEX>
 bool ts::SafePtr<T,MUTEX>::SafePtrShared::isNull()
 {
-    Guard lock (_mutex);
-    return _ptr == 0;
+    return pointer() == 0;
 }
 
 
 //----------------------------------------------------------------------------
 // Increment reference count and return this.
+// The reference count is atomic, no need to lock.
 //----------------------------------------------------------------------------
 
 template <typename T, class MUTEX>
 typename ts::SafePtr<T,MUTEX>::SafePtrShared* ts::SafePtr<T,MUTEX>::SafePtrShared::attach()
 {
-    Guard lock (_mutex);
     _ref_count++;
     return this;
 }
@@ -172,12 +209,7 @@ typename ts::SafePtr<T,MUTEX>::SafePtrShared* ts::SafePtr<T,MUTEX>::SafePtrShare
 template <typename T, class MUTEX>
 bool ts::SafePtr<T,MUTEX>::SafePtrShared::detach()
 {
-    int refcount;
-    {
-        Guard lock (_mutex);
-        refcount = --_ref_count;
-    }
-    if (refcount == 0) {
+    if (--_ref_count == 0) {
         delete this;
         return true;
     }
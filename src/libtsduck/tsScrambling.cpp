@@ -10,8 +10,14 @@
 //----------------------------------------------------------------------------
 
 #include "tsScrambling.h"
+#include "tsMemoryUtils.h"
 TSDUCK_SOURCE;
 
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::Scrambling::BATCH_SIZE;
+const size_t ts::Scrambling::MIN_BATCH_SIZE;
+#endif
+
 // Operations on 64-bit areas.
 
 #define clear_8(x)        (*(uint64_t*)(x) = 0);
@@ -478,93 +484,92 @@ void ts::Scrambling::BlockCipher::init (const uint8_t *key)
 }
 
 
+// The 56 rounds of the block cipher are unrolled by groups of 8. In each round,
+// the 8 registers R[1]..R[8] rotate by one position. Instead of moving the values,
+// the macros are invoked with rotated register names.
+
+#define DECIPHER_ROUND(i,r1,r2,r3,r4,r5,r6,r7,r8) \
+    sbox_out = block_sbox[_kk[i] ^ r7];           \
+    r8 ^= sbox_out;                               \
+    r2 ^= r8;                                     \
+    r3 ^= r8;                                     \
+    r4 ^= r8;                                     \
+    r6 ^= block_perm[sbox_out];
+
 void ts::Scrambling::BlockCipher::decipher (const uint8_t *ib, uint8_t *bd)
 {
-    int i;
-    int sbox_in;
     int sbox_out;
-    int perm_out;
-    int R[9];
-    int next_R8;
-
-    R[1] = ib[0];
-    R[2] = ib[1];
-    R[3] = ib[2];
-    R[4] = ib[3];
-    R[5] = ib[4];
-    R[6] = ib[5];
-    R[7] = ib[6];
-    R[8] = ib[7];
+    int R1 = ib[0];
+    int R2 = ib[1];
+    int R3 = ib[2];
+    int R4 = ib[3];
+    int R5 = ib[4];
+    int R6 = ib[5];
+    int R7 = ib[6];
+    int R8 = ib[7];
 
     // loop over kk[56]..kk[1]
-    for (i = 56; i > 0; i--) {
-        sbox_in  = _kk[i] ^ R[7];
-        sbox_out = block_sbox[sbox_in];
-        perm_out = block_perm[sbox_out];
-        next_R8 = R[7];
-        R[7] = R[6] ^ perm_out;
-        R[6] = R[5];
-        R[5] = R[4] ^ R[8] ^ sbox_out;
-        R[4] = R[3] ^ R[8] ^ sbox_out;
-        R[3] = R[2] ^ R[8] ^ sbox_out;
-        R[2] = R[1];
-        R[1] = R[8] ^ sbox_out;
-        R[8] = next_R8;
+    for (int i = 56; i > 0; i -= 8) {
+        DECIPHER_ROUND(i,   R1, R2, R3, R4, R5, R6, R7, R8)
+        DECIPHER_ROUND(i-1, R8, R1, R2, R3, R4, R5, R6, R7)
+        DECIPHER_ROUND(i-2, R7, R8, R1, R2, R3, R4, R5, R6)
+        DECIPHER_ROUND(i-3, R6, R7, R8, R1, R2, R3, R4, R5)
+        DECIPHER_ROUND(i-4, R5, R6, R7, R8, R1, R2, R3, R4)
+        DECIPHER_ROUND(i-5, R4, R5, R6, R7, R8, R1, R2, R3)
+        DECIPHER_ROUND(i-6, R3, R4, R5, R6, R7, R8, R1, R2)
+        DECIPHER_ROUND(i-7, R2, R3, R4, R5, R6, R7, R8, R1)
     }
 
-    bd[0] = R[1];
-    bd[1] = R[2];
-    bd[2] = R[3];
-    bd[3] = R[4];
-    bd[4] = R[5];
-    bd[5] = R[6];
-    bd[6] = R[7];
-    bd[7] = R[8];
+    bd[0] = R1;
+    bd[1] = R2;
+    bd[2] = R3;
+    bd[3] = R4;
+    bd[4] = R5;
+    bd[5] = R6;
+    bd[6] = R7;
+    bd[7] = R8;
 }
 
+#define ENCIPHER_ROUND(i,r1,r2,r3,r4,r5,r6,r7,r8) \
+    sbox_out = block_sbox[_kk[i] ^ r8];           \
+    r3 ^= r1;                                     \
+    r4 ^= r1;                                     \
+    r5 ^= r1;                                     \
+    r7 ^= block_perm[sbox_out];                   \
+    r1 ^= sbox_out;
 
 void ts::Scrambling::BlockCipher::encipher (const uint8_t *bd, uint8_t *ib)
 {
-    int i;
-    int sbox_in;
     int sbox_out;
-    int perm_out;
-    int R[9];
-    int next_R1;
-
-    R[1] = bd[0];
-    R[2] = bd[1];
-    R[3] = bd[2];
-    R[4] = bd[3];
-    R[5] = bd[4];
-    R[6] = bd[5];
-    R[7] = bd[6];
-    R[8] = bd[7];
+    int R1 = bd[0];
+    int R2 = bd[1];
+    int R3 = bd[2];
+    int R4 = bd[3];
+    int R5 = bd[4];
+    int R6 = bd[5];
+    int R7 = bd[6];
+    int R8 = bd[7];
 
     // loop over kk[1]..kk[56]
-    for (i = 1; i <= 56; i++) {
-        sbox_in  = _kk[i] ^ R[8];
-        sbox_out = block_sbox[sbox_in];
-        perm_out = block_perm[sbox_out];
-        next_R1 = R[2];
-        R[2] = R[3] ^ R[1];
-        R[3] = R[4] ^ R[1];
-        R[4] = R[5] ^ R[1];
-        R[5] = R[6];
-        R[6] = R[7] ^ perm_out;
-        R[7] = R[8];
-        R[8] = R[1] ^ sbox_out;
-        R[1] = next_R1;
+    for (int i = 1; i <= 56; i += 8) {
+        ENCIPHER_ROUND(i,   R1, R2, R3, R4, R5, R6, R7, R8)
+        ENCIPHER_ROUND(i+1, R2, R3, R4, R5, R6, R7, R8, R1)
+        ENCIPHER_ROUND(i+2, R3, R4, R5, R6, R7, R8, R1, R2)
+        ENCIPHER_ROUND(i+3, R4, R5, R6, R7, R8, R1, R2, R3)
+        ENCIPHER_ROUND(i+4, R5, R6, R7, R8, R1, R2, R3, R4)
+        ENCIPHER_ROUND(i+5, R6, R7, R8, R1, R2, R3, R4, R5)
+        ENCIPHER_ROUND(i+6, R7, R8, R1, R2, R3, R4, R5, R6)
+        ENCIPHER_ROUND(i+7, R8, R1, R2, R3, R4, R5, R6, R7)
     }
 
-    ib[0] = R[1];
-    ib[1] = R[2];
-    ib[2] = R[3];
-    ib[3] = R[4];
-    ib[4] = R[5];
-    ib[5] = R[6];
-    ib[6] = R[7];
-    ib[7] = R[8];
+    ib[0] = R1;
+    ib[1] = R2;
+    ib[2] = R3;
+    ib[3] = R4;
+    ib[4] = R5;
+    ib[5] = R6;
+    ib[6] = R7;
+    ib[7] = R8;
 }
 
 
@@ -707,3 +712,509 @@ void ts::Scrambling::decrypt (uint8_t* data, size_t size)
         }
     }
 }
+
+
+//----------------------------------------------------------------------------
+// Bitsliced stream cipher, used in batch operations.
+//----------------------------------------------------------------------------
+//
+// In a bitsliced implementation, each bit of the cipher state is represented
+// by a 64-bit word, one bit per data block in the batch. All data blocks are
+// processed at the same time using logical operations only. The data blocks
+// are converted to and from bit planes using a 64x64 bit matrix transposition.
+//
+// All data blocks of a batch use the same control word and consequently start
+// with the same state. The stream cipher state diverges during initialization
+// with the first 8 bytes of each data block.
+//
+//----------------------------------------------------------------------------
+
+namespace {
+
+    // One bit per data block in the batch.
+    typedef uint64_t Word;
+
+    // The S-boxes of the stream cipher in algebraic normal form.
+    // Input bits are x4 (most significant) to x0. Output bits are hi and lo.
+
+    inline void StreamSBox1(Word& hi, Word& lo, Word x4, Word x3, Word x2, Word x1, Word x0)
+    {
+        const Word x01 = x0 & x1;
+        const Word x02 = x0 & x2;
+        const Word x12 = x1 & x2;
+        const Word x03 = x0 & x3;
+        const Word x13 = x1 & x3;
+        const Word x23 = x2 & x3;
+        const Word x04 = x0 & x4;
+        const Word x24 = x2 & x4;
+        const Word x34 = x3 & x4;
+        const Word x013 = x01 & x3;
+        const Word x023 = x02 & x3;
+        const Word x123 = x12 & x3;
+        const Word x014 = x01 & x4;
+        const Word x124 = x12 & x4;
+        const Word x134 = x13 & x4;
+        const Word x234 = x23 & x4;
+        const Word x0134 = x013 & x4;
+        const Word x0234 = x023 & x4;
+        const Word x1234 = x123 & x4;
+        hi = ~(x0 ^ x1 ^ x01 ^ x02 ^ x12 ^ x03 ^ x13 ^ x23 ^ x023 ^ x123 ^ x4 ^ x014 ^ x24 ^ x124 ^ x34 ^ x134 ^ x0134 ^ x234 ^ x1234);
+        lo = x1 ^ x02 ^ x3 ^ x03 ^ x013 ^ x04 ^ x34 ^ x134 ^ x234 ^ x0234;
+    }
+
+    inline void StreamSBox2(Word& hi, Word& lo, Word x4, Word x3, Word x2, Word x1, Word x0)
+    {
+        const Word x01 = x0 & x1;
+        const Word x02 = x0 & x2;
+        const Word x12 = x1 & x2;
+        const Word x03 = x0 & x3;
+        const Word x13 = x1 & x3;
+        const Word x23 = x2 & x3;
+        const Word x24 = x2 & x4;
+        const Word x34 = x3 & x4;
+        const Word x012 = x01 & x2;
+        const Word x013 = x01 & x3;
+        const Word x023 = x02 & x3;
+        const Word x014 = x01 & x4;
+        const Word x124 = x12 & x4;
+        const Word x034 = x03 & x4;
+        const Word x134 = x13 & x4;
+        const Word x234 = x23 & x4;
+        const Word x0134 = x013 & x4;
+        const Word x0234 = x023 & x4;
+        hi = ~(x0 ^ x1 ^ x02 ^ x12 ^ x012 ^ x3 ^ x124 ^ x034 ^ x134 ^ x0134 ^ x234);
+        lo = ~(x1 ^ x2 ^ x02 ^ x013 ^ x023 ^ x014 ^ x24 ^ x34 ^ x0134 ^ x0234);
+    }
+
+    inline void StreamSBox3(Word& hi, Word& lo, Word x4, Word x3, Word x2, Word x1, Word x0)
+    {
+        const Word x01 = x0 & x1;
+        const Word x02 = x0 & x2;
+        const Word x12 = x1 & x2;
+        const Word x03 = x0 & x3;
+        const Word x13 = x1 & x3;
+        const Word x23 = x2 & x3;
+        const Word x14 = x1 & x4;
+        const Word x24 = x2 & x4;
+        const Word x012 = x01 & x2;
+        const Word x013 = x01 & x3;
+        const Word x123 = x12 & x3;
+        const Word x014 = x01 & x4;
+        const Word x024 = x02 & x4;
+        const Word x124 = x12 & x4;
+        const Word x034 = x03 & x4;
+        const Word x234 = x23 & x4;
+        const Word x0124 = x012 & x4;
+        const Word x1234 = x123 & x4;
+        hi = ~(x0 ^ x1 ^ x02 ^ x12 ^ x012 ^ x3 ^ x03 ^ x13 ^ x013 ^ x23 ^ x123 ^ x4 ^ x14 ^ x014 ^ x24 ^ x024 ^ x124 ^ x0124 ^ x034 ^ x234 ^ x1234);
+        lo = x1 ^ x01 ^ x02 ^ x3 ^ x4;
+    }
+
+    inline void StreamSBox4(Word& hi, Word& lo, Word x4, Word x3, Word x2, Word x1, Word x0)
+    {
+        const Word x01 = x0 & x1;
+        const Word x12 = x1 & x2;
+        const Word x03 = x0 & x3;
+        const Word x23 = x2 & x3;
+        const Word x04 = x0 & x4;
+        const Word x14 = x1 & x4;
+        const Word x34 = x3 & x4;
+        const Word x012 = x01 & x2;
+        const Word x013 = x01 & x3;
+        const Word x123 = x12 & x3;
+        const Word x034 = x03 & x4;
+        const Word x234 = x23 & x4;
+        const Word x0124 = x012 & x4;
+        const Word x0134 = x013 & x4;
+        const Word x1234 = x123 & x4;
+        hi = ~(x0 ^ x01 ^ x2 ^ x012 ^ x3 ^ x123 ^ x4 ^ x04 ^ x14 ^ x0124 ^ x34 ^ x034 ^ x0134 ^ x234 ^ x1234);
+        lo = ~(x1 ^ x01 ^ x2 ^ x03 ^ x013 ^ x23 ^ x04 ^ x14 ^ x0124 ^ x34 ^ x034 ^ x0134 ^ x234 ^ x1234);
+    }
+
+    inline void StreamSBox5(Word& hi, Word& lo, Word x4, Word x3, Word x2, Word x1, Word x0)
+    {
+        const Word x01 = x0 & x1;
+        const Word x02 = x0 & x2;
+        const Word x12 = x1 & x2;
+        const Word x03 = x0 & x3;
+        const Word x13 = x1 & x3;
+        const Word x04 = x0 & x4;
+        const Word x14 = x1 & x4;
+        const Word x24 = x2 & x4;
+        const Word x34 = x3 & x4;
+        const Word x012 = x01 & x2;
+        const Word x013 = x01 & x3;
+        const Word x023 = x02 & x3;
+        const Word x123 = x12 & x3;
+        const Word x024 = x02 & x4;
+        const Word x124 = x12 & x4;
+        const Word x034 = x03 & x4;
+        const Word x134 = x13 & x4;
+        const Word x0124 = x012 & x4;
+        const Word x0134 = x013 & x4;
+        const Word x0234 = x023 & x4;
+        const Word x1234 = x123 & x4;
+        hi = ~(x0 ^ x1 ^ x01 ^ x02 ^ x12 ^ x012 ^ x3 ^ x03 ^ x013 ^ x023 ^ x123 ^ x04 ^ x14 ^ x24 ^ x124 ^ x0124 ^ x034 ^ x134 ^ x0234 ^ x1234);
+        lo = x01 ^ x2 ^ x02 ^ x012 ^ x03 ^ x13 ^ x023 ^ x04 ^ x24 ^ x024 ^ x124 ^ x0124 ^ x34 ^ x034 ^ x134 ^ x0134;
+    }
+
+    inline void StreamSBox6(Word& hi, Word& lo, Word x4, Word x3, Word x2, Word x1, Word x0)
+    {
+        const Word x01 = x0 & x1;
+        const Word x02 = x0 & x2;
+        const Word x12 = x1 & x2;
+        const Word x03 = x0 & x3;
+        const Word x13 = x1 & x3;
+        const Word x23 = x2 & x3;
+        const Word x012 = x01 & x2;
+        const Word x013 = x01 & x3;
+        const Word x023 = x02 & x3;
+        const Word x123 = x12 & x3;
+        const Word x014 = x01 & x4;
+        const Word x124 = x12 & x4;
+        const Word x034 = x03 & x4;
+        const Word x0124 = x012 & x4;
+        const Word x0134 = x013 & x4;
+        const Word x1234 = x123 & x4;
+        hi = x1 ^ x02 ^ x013 ^ x23 ^ x023 ^ x4 ^ x014 ^ x034;
+        lo = x0 ^ x2 ^ x12 ^ x012 ^ x13 ^ x23 ^ x123 ^ x014 ^ x124 ^ x0124 ^ x0134 ^ x1234;
+    }
+
+    inline void StreamSBox7(Word& hi, Word& lo, Word x4, Word x3, Word x2, Word x1, Word x0)
+    {
+        const Word x01 = x0 & x1;
+        const Word x12 = x1 & x2;
+        const Word x13 = x1 & x3;
+        const Word x23 = x2 & x3;
+        const Word x04 = x0 & x4;
+        const Word x24 = x2 & x4;
+        const Word x012 = x01 & x2;
+        const Word x013 = x01 & x3;
+        const Word x123 = x12 & x3;
+        const Word x014 = x01 & x4;
+        const Word x124 = x12 & x4;
+        const Word x134 = x13 & x4;
+        const Word x0124 = x012 & x4;
+        const Word x0134 = x013 & x4;
+        const Word x1234 = x123 & x4;
+        hi = x0 ^ x1 ^ x01 ^ x2 ^ x3 ^ x013 ^ x04 ^ x014 ^ x24 ^ x124 ^ x0124 ^ x0134 ^ x1234;
+        lo = x0 ^ x01 ^ x2 ^ x12 ^ x012 ^ x3 ^ x23 ^ x4 ^ x134 ^ x0134;
+    }
+
+    // Transpose a 64x64 bit matrix, rows are words, column 0 is the most significant bit.
+    // The operation is its own inverse. The data blocks, as big endian 64-bit integers,
+    // are transformed into bit planes. Bit plane N contains bit 7-N%8 of byte N/8.
+    void Transpose64(Word m[64])
+    {
+        Word mask = TS_UCONST64(0x00000000FFFFFFFF);
+        for (size_t j = 32; j != 0; j >>= 1, mask ^= mask << j) {
+            for (size_t k = 0; k < 64; k = ((k | j) + 1) & ~j) {
+                const Word t = (m[k] ^ (m[k | j] >> j)) & mask;
+                m[k] ^= t;
+                m[k | j] ^= t << j;
+            }
+        }
+    }
+
+    // Bitsliced state of the stream cipher. Same structure as class Scrambling::StreamCipher.
+    // Each register has 4 bits (nibble), bit 0 is the least significant one.
+    // The shift registers A and B slide downward in a larger array during the 32 steps of
+    // a 8-byte block, avoiding the copy of the 10 nibbles at each step.
+    class SlicedStreamCipher
+    {
+    public:
+        // Constructor, same control word for all data blocks.
+        SlicedStreamCipher(const uint8_t *key);
+
+        // Process a 8-byte block. With input bit planes, initialize the cipher. Without input
+        // bit planes, generate 8 bytes of key stream in the output bit planes.
+        void cipher(const Word* in, Word* out);
+
+    private:
+        static const size_t STEPS = 32;  // Steps per 8-byte block, 2 bits per step.
+        Word   _a[STEPS + 10][4];
+        Word   _b[STEPS + 10][4];
+        size_t _base;                    // Index of A[1] and B[1] in _a and _b.
+        Word   X[4];
+        Word   Y[4];
+        Word   Z[4];
+        Word   D[4];
+        Word   E[4];
+        Word   F[4];
+        Word   p;
+        Word   q;
+        Word   r;
+    };
+}
+
+SlicedStreamCipher::SlicedStreamCipher(const uint8_t *key) :
+    _a(),
+    _b(),
+    _base(STEPS),
+    X(),
+    Y(),
+    Z(),
+    D(),
+    E(),
+    F(),
+    p(0),
+    q(0),
+    r(0)
+{
+    // Load first 32 bits of key into A[1]..A[8], last 32 bits of key into B[1]..B[8].
+    for (size_t i = 0; i < 8; i++) {
+        const int nibble_a = (key[i / 2] >> (i % 2 == 0 ? 4 : 0)) & 0x0F;
+        const int nibble_b = (key[4 + i / 2] >> (i % 2 == 0 ? 4 : 0)) & 0x0F;
+        for (size_t bit = 0; bit < 4; bit++) {
+            _a[_base + i][bit] = ((nibble_a >> bit) & 1) != 0 ? ~Word(0) : 0;
+            _b[_base + i][bit] = ((nibble_b >> bit) & 1) != 0 ? ~Word(0) : 0;
+        }
+    }
+}
+
+void SlicedStreamCipher::cipher(const Word* in, Word* out)
+{
+    const bool init = in != 0;
+
+    // Move the shift registers back to the top of the arrays.
+    if (_base != STEPS) {
+        ::memmove(_a + STEPS, _a + _base, 10 * sizeof(_a[0]));  // Flawfinder: ignore: memmove()
+        ::memmove(_b + STEPS, _b + _base, 10 * sizeof(_b[0]));  // Flawfinder: ignore: memmove()
+        _base = STEPS;
+    }
+
+    // 8 bytes per operation, 2 bits per step.
+    for (size_t i = 0; i < 8; i++) {
+        for (size_t j = 0; j < 4; j++) {
+
+            // A[1]..A[10], B[1]..B[10] are the current content of the shift registers.
+            // A[0], B[0] are the locations of the next A[1], B[1].
+            Word (*const A)[4] = _a + _base - 1;
+            Word (*const B)[4] = _b + _base - 1;
+
+            // From A[1]..A[10], 35 bits are selected as inputs to 7 s-boxes.
+            Word s1h, s1l, s2h, s2l, s3h, s3l, s4h, s4l, s5h, s5l, s6h, s6l, s7h, s7l;
+            StreamSBox1(s1h, s1l, A[4][0], A[1][2], A[6][1], A[7][3], A[9][0]);
+            StreamSBox2(s2h, s2l, A[2][1], A[3][2], A[6][3], A[7][0], A[9][1]);
+            StreamSBox3(s3h, s3l, A[1][3], A[2][0], A[5][1], A[5][3], A[6][2]);
+            StreamSBox4(s4h, s4l, A[3][3], A[1][1], A[2][3], A[4][2], A[8][0]);
+            StreamSBox5(s5h, s5l, A[5][2], A[4][3], A[6][0], A[8][1], A[9][2]);
+            StreamSBox6(s6h, s6l, A[3][1], A[4][1], A[5][0], A[7][2], A[9][3]);
+            StreamSBox7(s7h, s7l, A[2][2], A[3][0], A[7][1], A[8][2], A[8][3]);
+
+            // Use 4x4 xor to produce extra nibble for T3.
+            const Word extra_B[4] = {
+                B[9][2] ^ B[6][3] ^ B[3][1] ^ B[8][0],
+                B[5][3] ^ B[8][2] ^ B[4][0] ^ B[5][1],
+                B[6][0] ^ B[8][1] ^ B[3][3] ^ B[4][2],
+                B[3][0] ^ B[6][1] ^ B[7][2] ^ B[9][3]
+            };
+
+            // Input nibbles during initialization: in1 is the most significant nibble of input byte.
+            // Input bit plane 8*i+n contains bit 7-n of input byte i.
+            Word in1[4] = {0, 0, 0, 0};
+            Word in2[4] = {0, 0, 0, 0};
+            if (init) {
+                for (size_t bit = 0; bit < 4; bit++) {
+                    in1[bit] = in[8 * i + 3 - bit];
+                    in2[bit] = in[8 * i + 7 - bit];
+                }
+            }
+
+            Word next_B1[4];
+            for (size_t bit = 0; bit < 4; bit++) {
+                // T1 = xor all inputs, in1, in2, D are only used during initialisation.
+                A[0][bit] = A[10][bit] ^ X[bit];
+                // T2 = xor all inputs, in1, in2 are only used during initialisation.
+                next_B1[bit] = B[7][bit] ^ B[10][bit] ^ Y[bit];
+                if (init) {
+                    A[0][bit] ^= D[bit] ^ ((j % 2) ? in2[bit] : in1[bit]);
+                    next_B1[bit] ^= (j % 2) ? in1[bit] : in2[bit];
+                }
+            }
+
+            // If p=1, rotate left.
+            B[0][0] = next_B1[0] ^ (p & (next_B1[0] ^ next_B1[3]));
+            B[0][1] = next_B1[1] ^ (p & (next_B1[1] ^ next_B1[0]));
+            B[0][2] = next_B1[2] ^ (p & (next_B1[2] ^ next_B1[1]));
+            B[0][3] = next_B1[3] ^ (p & (next_B1[3] ^ next_B1[2]));
+
+            // T3 = xor all inputs.
+            // T4 = sum, carry of Z + E + r if q=1, E otherwise.
+            Word carry = r;
+            for (size_t bit = 0; bit < 4; bit++) {
+                D[bit] = E[bit] ^ Z[bit] ^ extra_B[bit];
+                const Word sum = Z[bit] ^ E[bit];
+                const Word next_F = E[bit] ^ (q & (sum ^ carry ^ E[bit]));
+                carry = (Z[bit] & E[bit]) | (carry & sum);
+                E[bit] = F[bit];
+                F[bit] = next_F;
+            }
+            r ^= q & (carry ^ r);
+
+            // Shift registers A and B.
+            --_base;
+
+            X[3] = s4l; X[2] = s3l; X[1] = s2h; X[0] = s1h;
+            Y[3] = s6l; Y[2] = s5l; Y[1] = s4h; Y[0] = s3h;
+            Z[3] = s2l; Z[2] = s1l; Z[1] = s6h; Z[0] = s5h;
+            p = s7h;
+            q = s7l;
+
+            // 2 output bits are a function of the 4 bits of D, xor 2 by 2.
+            if (!init) {
+                out[8 * i + 2 * j] = D[2] ^ D[3];
+                out[8 * i + 2 * j + 1] = D[0] ^ D[1];
+            }
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Batch operations: stream cipher on all data blocks of a batch.
+// All data blocks are at least 8 bytes long.
+//----------------------------------------------------------------------------
+
+void ts::Scrambling::streamBatch(uint8_t* const data[], const size_t sizes[], size_t count)
+{
+    assert(count <= BATCH_SIZE);
+
+    // One 64-bit row per data block, unused rows are zero.
+    Word rows[64];
+    size_t max_size = 0;
+    for (size_t k = 0; k < 64; k++) {
+        if (k < count) {
+            rows[k] = GetUInt64(data[k]);
+            max_size = std::max(max_size, sizes[k]);
+        }
+        else {
+            rows[k] = 0;
+        }
+    }
+
+    // The first block is scrambled using the block cipher only.
+    // Its scrambled value is used to initialize the stream cipher.
+    SlicedStreamCipher stream(_key);
+    Transpose64(rows);
+    stream.cipher(rows, 0);
+
+    // Apply the stream cipher on all subsequent blocks and residues.
+    for (size_t offset = 8; offset < max_size; offset += 8) {
+        stream.cipher(0, rows);
+        Transpose64(rows);
+        for (size_t k = 0; k < count; k++) {
+            uint8_t* const p = data[k] + offset;
+            if (offset + 8 <= sizes[k]) {
+                PutUInt64(p, GetUInt64(p) ^ rows[k]);
+            }
+            else {
+                // Residue, if any.
+                for (size_t i = 0; offset + i < sizes[k]; i++) {
+                    p[i] ^= uint8_t(rows[k] >> (56 - 8 * i));
+                }
+            }
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Batch operations: block cipher on one data block, in reverse CBC mode.
+//----------------------------------------------------------------------------
+
+void ts::Scrambling::encipherChain(uint8_t* data, size_t size)
+{
+    // After last block is initialization vector (zero in DVB-CSA).
+    // The scrambled blocks replace the plain blocks, the stream cipher is applied later.
+    uint8_t iblock[8];
+    const uint8_t zero[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    const uint8_t* next = zero;
+    for (size_t i = size / 8; i-- > 0; ) {
+        uint8_t* const block = data + 8 * i;
+        xor_8(iblock, block, next);
+        _block.encipher(iblock, block);
+        next = block;
+    }
+}
+
+void ts::Scrambling::decipherChain(uint8_t* data, size_t size)
+{
+    // The stream cipher was already removed from all blocks except the first one.
+    const size_t nblocks = size / 8;
+    uint8_t ib[8];
+    uint8_t oblock[8];
+    memcpy_8(ib, data);
+    for (size_t i = 1; i < nblocks; i++) {
+        uint8_t* const block = data + 8 * i;
+        _block.decipher(ib, oblock);
+        memcpy_8(ib, block);
+        xor_8(block - 8, ib, oblock);
+    }
+
+    // Last block, xor with zero IV is a null operation.
+    _block.decipher(ib, data + 8 * (nblocks - 1));
+}
+
+
+//----------------------------------------------------------------------------
+// Encrypt / decrypt several data blocks with the same control word.
+//----------------------------------------------------------------------------
+
+void ts::Scrambling::encrypt(uint8_t* const data[], const size_t sizes[], size_t count)
+{
+    batch(data, sizes, count, true);
+}
+
+void ts::Scrambling::decrypt(uint8_t* const data[], const size_t sizes[], size_t count)
+{
+    batch(data, sizes, count, false);
+}
+
+void ts::Scrambling::batch(uint8_t* const data[], const size_t sizes[], size_t count, bool encrypt)
+{
+    assert(_init);
+
+    uint8_t* bdata[BATCH_SIZE];
+    size_t bsizes[BATCH_SIZE];
+
+    while (count > 0) {
+
+        // Collect up to BATCH_SIZE data blocks. Data blocks smaller than 8 bytes are left unscrambled.
+        size_t bcount = 0;
+        for (; count > 0 && bcount < BATCH_SIZE; ++data, ++sizes, --count) {
+            assert(*sizes / 8 <= MAX_NBLOCKS);
+            if (*sizes >= 8) {
+                bdata[bcount] = *data;
+                bsizes[bcount] = *sizes;
+                bcount++;
+            }
+        }
+
+        if (bcount < MIN_BATCH_SIZE) {
+            // Not enough data blocks to benefit from the bitsliced stream cipher.
+            for (size_t k = 0; k < bcount; k++) {
+                if (encrypt) {
+                    this->encrypt(bdata[k], bsizes[k]);
+                }
+                else {
+                    this->decrypt(bdata[k], bsizes[k]);
+                }
+            }
+        }
+        else if (encrypt) {
+            // Block cipher first, then stream cipher, as in encrypt().
+            for (size_t k = 0; k < bcount; k++) {
+                encipherChain(bdata[k], bsizes[k]);
+            }
+            streamBatch(bdata, bsizes, bcount);
+        }
+        else {
+            // Stream cipher first, then block cipher, as in decrypt().
+            streamBatch(bdata, bsizes, bcount);
+            for (size_t k = 0; k < bcount; k++) {
+                decipherChain(bdata[k], bsizes[k]);
+            }
+        }
+    }
+}
@@ -45,6 +45,17 @@ namespace ts {
         static const size_t KEY_BITS = 64;             //!< DVB-CSA control words size in bits.
         static const size_t KEY_SIZE = KEY_BITS / 8;   //!< DVB-CSA control words size in bytes.
 
+        //!
+        //! Maximum number of data blocks which are processed in parallel in batch operations.
+        //!
+        static const size_t BATCH_SIZE = 64;
+
+        //!
+        //! Minimum number of data blocks in a batch to use the bitsliced implementation.
+        //! With less data blocks, the data blocks are processed one by one.
+        //!
+        static const size_t MIN_BATCH_SIZE = 4;
+
         //!
         //! Control word entropy reduction.
         //! This is a way to reduce the 'entropy' of control words to 48 bits, according to DVB regulations.
@@ -94,6 +105,26 @@ namespace ts {
         //!
         void decrypt(uint8_t* data, size_t size);
 
+        //!
+        //! Encrypt several data blocks (typically the payloads of TS packets) with the same control word.
+        //! Up to @link BATCH_SIZE @endlink data blocks are processed in parallel, using a bitsliced
+        //! implementation of the stream cipher. The result is identical to encrypt() on each data block.
+        //! @param [in] data Array of @a count addresses of buffers to encrypt in place.
+        //! @param [in] sizes Array of @a count buffer sizes.
+        //! @param [in] count Number of data blocks.
+        //!
+        void encrypt(uint8_t* const data[], const size_t sizes[], size_t count);
+
+        //!
+        //! Decrypt several data blocks (typically the payloads of TS packets) with the same control word.
+        //! Up to @link BATCH_SIZE @endlink data blocks are processed in parallel, using a bitsliced
+        //! implementation of the stream cipher. The result is identical to decrypt() on each data block.
+        //! @param [in] data Array of @a count addresses of buffers to decrypt in place.
+        //! @param [in] sizes Array of @a count buffer sizes.
+        //! @param [in] count Number of data blocks.
+        //!
+        void decrypt(uint8_t* const data[], const size_t sizes[], size_t count);
+
         //!
         //! Manually perform the entropy reduction on a control word.
         //! Not needed with ts::Scrambling class, preferably use @link REDUCE_ENTROPY @endlink mode.
@@ -145,5 +176,11 @@ namespace ts {
         uint8_t      _key[KEY_SIZE];
         BlockCipher  _block;
         StreamCipher _stream;
+
+        // Batch operations.
+        void batch(uint8_t* const data[], const size_t sizes[], size_t count, bool encrypt);
+        void streamBatch(uint8_t* const data[], const size_t sizes[], size_t count);
+        void encipherChain(uint8_t* data, size_t size);
+        void decipherChain(uint8_t* data, size_t size);
     };
 }
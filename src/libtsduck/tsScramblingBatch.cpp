@@ -0,0 +1,83 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+
+#include "tsScramblingBatch.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// Constructor.
+//----------------------------------------------------------------------------
+
+ts::ScramblingBatch::ScramblingBatch(bool encrypt) :
+    _encrypt(encrypt),
+    _key(nullptr),
+    _count(0),
+    _data(),
+    _sizes()
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Add a data block in the batch.
+//----------------------------------------------------------------------------
+
+void ts::ScramblingBatch::add(Scrambling& key, uint8_t* data, size_t size)
+{
+    // All data blocks in a batch use the same key.
+    if (_count > 0 && _key != &key) {
+        flush();
+    }
+    _key = &key;
+    _data[_count] = data;
+    _sizes[_count] = size;
+    if (++_count >= Scrambling::BATCH_SIZE) {
+        flush();
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Encrypt or decrypt all pending data blocks.
+//----------------------------------------------------------------------------
+
+void ts::ScramblingBatch::flush()
+{
+    if (_count > 0) {
+        assert(_key != nullptr);
+        if (_encrypt) {
+            _key->encrypt(_data, _sizes, _count);
+        }
+        else {
+            _key->decrypt(_data, _sizes, _count);
+        }
+        _count = 0;
+    }
+}
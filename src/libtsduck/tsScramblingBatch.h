@@ -0,0 +1,88 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Accumulate data blocks for DVB-CSA batch scrambling.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsScrambling.h"
+
+namespace ts {
+    //!
+    //! Accumulate data blocks (typically TS packet payloads) for DVB-CSA batch scrambling.
+    //!
+    //! Data blocks are not encrypted or decrypted when they are added. They are processed
+    //! in place when the batch is full, when a data block with another key is added or
+    //! when flush() is explicitly called. The data blocks and the Scrambling object
+    //! must remain valid and unmodified until the batch is flushed. Typically, a packet
+    //! processor plugin flushes the batch at the end of each processPacketBatch() and
+    //! before reinitializing a Scrambling object with a new control word.
+    //!
+    class TSDUCKDLL ScramblingBatch
+    {
+    public:
+        //!
+        //! Constructor.
+        //! @param [in] encrypt If true, encrypt the data blocks. Otherwise, decrypt them.
+        //!
+        explicit ScramblingBatch(bool encrypt = false);
+
+        //!
+        //! Add a data block in the batch.
+        //! @param [in,out] key DVB-CSA key to use for this data block.
+        //! @param [in,out] data Address of the buffer to encrypt or decrypt in place.
+        //! @param [in] size Buffer size.
+        //!
+        void add(Scrambling& key, uint8_t* data, size_t size);
+
+        //!
+        //! Encrypt or decrypt all pending data blocks.
+        //!
+        void flush();
+
+        //!
+        //! Check if there is no pending data block.
+        //! @return True if there is no pending data block.
+        //!
+        bool empty() const { return _count == 0; }
+
+    private:
+        bool        _encrypt;
+        Scrambling* _key;
+        size_t      _count;
+        uint8_t*    _data[Scrambling::BATCH_SIZE];
+        size_t      _sizes[Scrambling::BATCH_SIZE];
+
+        // Inaccessible operations.
+        ScramblingBatch(const ScramblingBatch&) = delete;
+        ScramblingBatch& operator=(const ScramblingBatch&) = delete;
+    };
+}
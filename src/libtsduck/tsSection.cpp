@@ -36,6 +36,7 @@
 #include "tsNames.h"
 #include "tsMemoryUtils.h"
 #include "tsReportWithPrefix.h"
+#include "tsjsonWriter.h"
 TSDUCK_SOURCE;
 
 
@@ -484,6 +485,34 @@ std::istream& ts::Section::read(std::istream& strm, CRC32::Validation crc_op, Re
 }
 
 
+//----------------------------------------------------------------------------
+// Write the section as fields of a compact JSON object.
+//----------------------------------------------------------------------------
+
+bool ts::Section::toJSON(json::Writer& writer, CASFamily cas) const
+{
+    if (!_is_valid) {
+        return false;
+    }
+
+    const TID tid = tableId();
+    writer.field(u"pid", _source_pid);
+    writer.field(u"tid", tid);
+    writer.field(u"name", names::TID(tid, cas));
+    if (isLongSection()) {
+        writer.field(u"tid_ext", tableIdExtension());
+        writer.field(u"version", version());
+        writer.field(u"current", isCurrent());
+        writer.field(u"section_number", sectionNumber());
+        writer.field(u"last_section_number", lastSectionNumber());
+    }
+
+    // Complete binary content of the section, including header and CRC.
+    writer.name(u"section").hexa(content(), size());
+    return true;
+}
+
+
 //----------------------------------------------------------------------------
 // Dump the section on an output stream
 //----------------------------------------------------------------------------
@@ -43,6 +43,11 @@
 #include "tsTLVSyntax.h"
 
 namespace ts {
+
+    namespace json {
+        class Writer;
+    }
+
     //!
     //! Representation of MPEG PSI/SI sections.
     //!
@@ -586,6 +591,16 @@ namespace ts {
         //!
         std::ostream& dump(std::ostream& strm, int indent = 0, CASFamily cas = CAS_OTHER, bool no_header = false) const;
 
+        //!
+        //! Write the section as fields of a compact JSON object.
+        //! The binary content of the section is written in hexadecimal, without interpretation.
+        //! @param [in,out] writer A JSON writer. A JSON object shall be open in the writer.
+        //! The JSON object is not closed, the application may add other fields.
+        //! @param [in] cas CAS family, used to name CAS-specific tables.
+        //! @return True on success, false if the section is not valid. Nothing is written when the section is not valid.
+        //!
+        bool toJSON(json::Writer& writer, CASFamily cas = CAS_OTHER) const;
+
     private:
         // Private fields
         bool          _is_valid;    // Content of *_data is a valid section
@@ -32,6 +32,7 @@
 //----------------------------------------------------------------------------
 
 #include "tsSectionDemux.h"
+#include "tsPooledByteBlock.h"
 TSDUCK_SOURCE;
 
 
@@ -131,6 +132,45 @@ std::ostream& ts::SectionDemux::Status::display(std::ostream& strm, int indent,
 }
 
 
+//----------------------------------------------------------------------------
+// Header-level filter of sections.
+//----------------------------------------------------------------------------
+
+ts::SectionDemux::HeaderFilter::HeaderFilter() :
+    tids(),
+    tid_exts(),
+    negate_tid_ext(false),
+    sections(),
+    versions()
+{
+    reset();
+}
+
+void ts::SectionDemux::HeaderFilter::reset()
+{
+    tids.set();
+    tid_exts.clear();
+    negate_tid_ext = false;
+    sections.set();
+    versions.set();
+}
+
+bool ts::SectionDemux::HeaderFilter::match(const uint8_t* section, bool long_header) const
+{
+    if (!tids.test(section[0])) {
+        return false;
+    }
+    else if (!long_header) {
+        return true;
+    }
+    else {
+        return (tid_exts.empty() || (tid_exts.find(GetUInt16(section + 3)) != tid_exts.end()) != negate_tid_ext) &&
+            versions.test((section[5] >> 1) & 0x1F) &&
+            sections.test(section[6]);
+    }
+}
+
+
 //----------------------------------------------------------------------------
 // SectionDemux constructor.
 //----------------------------------------------------------------------------
@@ -141,8 +181,12 @@ ts::SectionDemux::SectionDemux(TableHandlerInterface* table_handler,
     SuperClass(pid_filter),
     _table_handler(table_handler),
     _section_handler(section_handler),
-    _pids(),
-    _status()
+    _view_handler(0),
+    _pids(PID_MAX, 0),
+    _status(),
+    _change_only(false),
+    _crc_op(CRC32::CHECK),
+    _filter()
 {
 }
 
@@ -153,6 +197,9 @@ ts::SectionDemux::SectionDemux(TableHandlerInterface* table_handler,
 
 ts::SectionDemux::~SectionDemux ()
 {
+    for (PID pid = 0; pid < PID_MAX; ++pid) {
+        deletePIDContext(pid);
+    }
 }
 
 
@@ -163,13 +210,23 @@ ts::SectionDemux::~SectionDemux ()
 void ts::SectionDemux::immediateReset()
 {
     SuperClass::immediateReset();
-    _pids.clear();
+    for (PID pid = 0; pid < PID_MAX; ++pid) {
+        deletePIDContext(pid);
+    }
 }
 
 void ts::SectionDemux::immediateResetPID(PID pid)
 {
     SuperClass::immediateResetPID(pid);
-    _pids.erase(pid);
+    deletePIDContext(pid);
+}
+
+void ts::SectionDemux::deletePIDContext(PID pid)
+{
+    if (pid < PID_MAX && _pids[pid] != 0) {
+        delete _pids[pid];
+        _pids[pid] = 0;
+    }
 }
 
 
@@ -198,7 +255,10 @@ void ts::SectionDemux::processPacket(const TSPacket& pkt)
     // The PID context is created if did not exist.
 
     PID pid = pkt.getPID();
-    PIDContext& pc(_pids[pid]);
+    if (_pids[pid] == 0) {
+        _pids[pid] = new PIDContext;
+    }
+    PIDContext& pc(*_pids[pid]);
 
     // If TS packet is scrambled, we cannot decode it and we loose
     // synchronization on this PID (usually, PID's carrying sections
@@ -294,6 +354,26 @@ void ts::SectionDemux::processPacket(const TSPacket& pkt)
         pc.sync = true;
     }
 
+    // Skip the rest of a filtered-out section without copying it.
+
+    if (pc.skip > 0) {
+        if (pkt.getPUSI() && pointer_field < pc.skip) {
+            // The filtered-out section is truncated, resynchronize on the new section.
+            pc.skip = pointer_field;
+        }
+        const size_t count = std::min(pc.skip, payload_size);
+        payload += count;
+        payload_size -= count;
+        pc.skip -= count;
+        if (pkt.getPUSI()) {
+            pointer_field -= uint8_t(count);
+        }
+        // Nothing left or the rest of the packet is stuffing.
+        if (payload_size == 0 || payload[0] == 0xFF) {
+            return;
+        }
+    }
+
     // Copy TS packet payload in PID context
 
     pc.ts.append (payload, payload_size);
@@ -303,6 +383,10 @@ void ts::SectionDemux::processPacket(const TSPacket& pkt)
     const uint8_t* ts_start = pc.ts.data();
     size_t ts_size = pc.ts.size();
 
+    // Sections starting at or after this address are entirely in the current packet.
+
+    const uint8_t* const pkt_start = ts_start + ts_size - payload_size;
+
     // If current packet has a PUSI, locate start of this new section
     // inside the TS buffer. This is not useful to locate the section but
     // it is used to check that the previous section was not truncated
@@ -340,6 +424,24 @@ void ts::SectionDemux::processPacket(const TSPacket& pkt)
             return;
         }
 
+        // Filter the section as soon as its header is available. Sections with the
+        // 'next' indicator are ignored anyway. When the rest of a rejected section
+        // is not yet in the buffer, the next TS packets skip it without copy.
+
+        if (ts_size >= (long_header ? LONG_SECTION_HEADER_SIZE : SHORT_SECTION_HEADER_SIZE) &&
+            ((long_header && (ts_start[5] & 0x01) == 0) || !_filter.match(ts_start, long_header)))
+        {
+            section_ok = false;
+            if (pusi_section != 0 && ts_start < pusi_section && ts_start + section_length > pusi_section) {
+                section_length = uint16_t(pusi_section - ts_start);
+            }
+            if (ts_size < section_length) {
+                pc.skip = section_length - ts_size;
+                ts_size = 0;
+                break;
+            }
+        }
+
         // Exit when end of section is missing. Wait for next TS packets.
 
         if (ts_size < section_length) {
@@ -380,6 +482,53 @@ void ts::SectionDemux::processPacket(const TSPacket& pkt)
             section_ok = false;
         }
 
+        // In "change only" mode, ignore identical repetitions of a section.
+        // Long sections carry their own CRC32, short sections are checksummed.
+        // Some short sections also end with a CRC32 (TOT for instance) and, the
+        // CRC32 being linear, the CRC32 of such complete sections is always zero.
+        // The last four bytes are therefore added to the CRC32 of the rest.
+
+        uint32_t crc = 0;
+
+        if (section_ok && _change_only) {
+            if (long_header) {
+                crc = GetUInt32(ts_start + section_length - 4);
+            }
+            else if (section_length >= MIN_SHORT_SECTION_SIZE + 4) {
+                crc = CRC32(ts_start, section_length - 4).value() + GetUInt32(ts_start + section_length - 4);
+            }
+            else {
+                crc = CRC32(ts_start, section_length).value();
+            }
+            const std::map<ETID, ETIDContext>::const_iterator tit(pc.tids.find(etid));
+            if (tit != pc.tids.end() && tit->second.sameCRC(section_number, crc)) {
+                section_ok = false;
+            }
+        }
+
+        // Deliver a view on sections which are entirely contained in the current packet.
+        // The CRC32 of long sections is checked here since no Section object is built.
+
+        if (section_ok && _view_handler != 0 && ts_start >= pkt_start) {
+            if (long_header && _crc_op == CRC32::CHECK && CRC32(ts_start, section_length - SECTION_CRC32_SIZE) != GetUInt32(ts_start + section_length - SECTION_CRC32_SIZE)) {
+                _status.wrong_crc++;
+                section_ok = false;
+            }
+            else {
+                beforeCallingHandler(pid);
+                try {
+                    _view_handler->handleSectionView(*this, SectionView(ts_start, section_length, pid, _packet_count));
+                }
+                catch (...) {
+                    afterCallingHandler(false);
+                    throw;
+                }
+                if (afterCallingHandler(true)) {
+                    return;  // the PID of this packet or the complete demux was reset.
+                }
+            }
+        }
+
         if (section_ok) {
 
             // Get reference to the ETID context for this PID.
@@ -399,12 +548,14 @@ void ts::SectionDemux::processPacket(const TSPacket& pkt)
 
                 tc.version = version;
                 tc.sect_expected = size_t (last_section_number) + 1;
-                tc.sect_received = 0;
-                tc.sects.resize (tc.sect_expected);
-                // Mark all section entries as unused
-                for (size_t si = 0; si < tc.sect_expected; si++) {
-                    tc.sects[si].reset();
+                // Mark all section entries as unused, only the previously received ones need a reset.
+                for (size_t si = 0; si < tc.sects.size(); si++) {
+                    if (tc.received.test(si)) {
+                        tc.sects[si].reset();
+                    }
                 }
+                tc.received.reset();
+                tc.sects.resize (tc.sect_expected);
             }
 
             // Check that the total number of sections in the table
@@ -415,19 +566,32 @@ void ts::SectionDemux::processPacket(const TSPacket& pkt)
                 section_ok = false;
             }
 
+            // Repetitions of an already received section are dropped here when
+            // no section handler needs them, before allocating anything.
+
+            const bool is_new = section_ok && !tc.received.test(section_number);
+            if (section_ok && !is_new && _section_handler == 0) {
+                section_ok = false;
+            }
+
             // Create a new Section object if necessary (ie. if a section
             // hendler is registered or if this is a new section).
 
             SectionPtr sect_ptr;
 
-            if (section_ok && (_section_handler != 0 || tc.sects[section_number].isNull())) {
-                sect_ptr = new Section (ts_start, section_length, pid, CRC32::CHECK);
+            if (section_ok) {
+                // The section content uses recycled memory, released when the
+                // section is no longer referenced by the demux or the handlers.
+                sect_ptr = new Section(ByteBlockPtr(new PooledByteBlock(ts_start, section_length)), pid, _crc_op);
                 sect_ptr->setFirstTSPacketIndex (pusi_pkt_index);
                 sect_ptr->setLastTSPacketIndex (_packet_count);
                 if (!sect_ptr->isValid()) {
                     _status.wrong_crc++;  // only possible error (hum?)
                     section_ok = false;
                 }
+                else if (_change_only) {
+                    tc.setCRC(section_number, crc);
+                }
             }
 
             // Mark that we are in the context of a table or section handler.
@@ -441,14 +605,14 @@ void ts::SectionDemux::processPacket(const TSPacket& pkt)
                 }
 
                 // Save the section in the TID context if this is a new one.
-                if (section_ok && tc.sects[section_number].isNull()) {
+                if (section_ok && is_new) {
 
                     // Save the section
                     tc.sects[section_number] = sect_ptr;
-                    tc.sect_received++;
+                    tc.received.set(section_number);
 
                     // If the table is completed and a handler is present, build the table.
-                    if (tc.sect_received == tc.sect_expected && _table_handler != 0) {
+                    if (_table_handler != 0 && tc.complete()) {
 
                         // Build the table
                         BinaryTable table;
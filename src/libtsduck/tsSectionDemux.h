@@ -37,6 +37,8 @@
 #include "tsETID.h"
 #include "tsTableHandlerInterface.h"
 #include "tsSectionHandlerInterface.h"
+#include "tsSectionViewHandlerInterface.h"
+#include "tsCRC32.h"
 
 namespace ts {
     //!
@@ -46,6 +48,12 @@ namespace ts {
     //!
     //! Sections with the @e next indicator are ignored. Only sections with the @e current indicator are reported.
     //!
+    //! An optional header filter selects sections on their table id, table id extension,
+    //! section number and version. Sections which are rejected by the filter, as well as
+    //! sections with the @e next indicator, are detected as soon as their header is
+    //! received. The rest of these sections is skipped at TS packet level, without copy
+    //! or CRC32 computation.
+    //!
     class TSDUCKDLL SectionDemux: public AbstractDemux
     {
     public:
@@ -90,6 +98,117 @@ namespace ts {
             _section_handler = h;
         }
 
+        //!
+        //! Replace the section view handler.
+        //! The section view handler is invoked without copy or memory allocation
+        //! for each valid section which is entirely contained in one TS packet.
+        //! @param [in] h The new handler.
+        //!
+        void setSectionViewHandler(SectionViewHandlerInterface* h)
+        {
+            _view_handler = h;
+        }
+
+        //!
+        //! Set the "change only" mode.
+        //! In this mode, a section which is identical to the previous occurrence of the
+        //! same section (same PID, TID, TIDext and section number, same CRC32) is ignored
+        //! before any Section object is built. Neither the section handler nor the table
+        //! handler are notified of such repetitions. Without this mode, short sections
+        //! and the section handler get all repetitions.
+        //! @param [in] on True to enable the "change only" mode, false to disable it.
+        //!
+        void setChangeOnly(bool on)
+        {
+            _change_only = on;
+        }
+
+        //!
+        //! Check if the "change only" mode is set.
+        //! @return True if the "change only" mode is set.
+        //!
+        bool getChangeOnly() const
+        {
+            return _change_only;
+        }
+
+        //!
+        //! Set the validation of the CRC32 of long sections.
+        //! By default, the CRC32 of all long sections is checked and sections with an invalid
+        //! CRC32 are dropped. When the integrity of the input is guaranteed otherwise (archived
+        //! streams, transport with its own link-layer checksum), CRC32::IGNORE saves the
+        //! computation of the CRC32 on each section.
+        //! @param [in] crc_op How to process the CRC32 of long sections.
+        //!
+        void setCRCValidation(CRC32::Validation crc_op)
+        {
+            _crc_op = crc_op;
+        }
+
+        //!
+        //! Get the validation of the CRC32 of long sections.
+        //! @return How the CRC32 of long sections is processed.
+        //!
+        CRC32::Validation getCRCValidation() const
+        {
+            return _crc_op;
+        }
+
+        //!
+        //! Header-level filter of sections.
+        //! By default, all sections are accepted.
+        //!
+        struct TSDUCKDLL HeaderFilter
+        {
+            // Members:
+            std::bitset<256>   tids;            //!< Accepted table ids.
+            std::set<uint16_t> tid_exts;        //!< Accepted table id extensions of long sections, all if empty.
+            bool               negate_tid_ext;  //!< Reject instead of accept the table id extensions in @a tid_exts.
+            std::bitset<256>   sections;        //!< Accepted section numbers of long sections.
+            std::bitset<32>    versions;        //!< Accepted versions of long sections.
+
+            //!
+            //! Default constructor, accept all sections.
+            //!
+            HeaderFilter();
+
+            //!
+            //! Reset the filter to accept all sections.
+            //!
+            void reset();
+
+            //!
+            //! Check if a section header matches the filter.
+            //! @param [in] section Address of the section header. It must contain at least
+            //! LONG_SECTION_HEADER_SIZE bytes for long sections and SHORT_SECTION_HEADER_SIZE
+            //! bytes for short sections.
+            //! @param [in] long_header True if this is a long section.
+            //! @return True if the section is accepted by the filter.
+            //!
+            bool match(const uint8_t* section, bool long_header) const;
+        };
+
+        //!
+        //! Set the header-level filter of sections.
+        //! Rejected sections are never reported to any handler. Note that a table is complete
+        //! only when all its sections are accepted. Filtering on section numbers or versions
+        //! is consequently useful with section handlers only.
+        //! @param [in] filter The new filter.
+        //!
+        void setHeaderFilter(const HeaderFilter& filter)
+        {
+            _filter = filter;
+        }
+
+        //!
+        //! Get the header-level filter of sections.
+        //! @return A constant reference to the header-level filter.
+        //!
+        const HeaderFilter& getHeaderFilter() const
+        {
+            return _filter;
+        }
+
         //!
         //! Demux status information.
         //! It contains error counters.
@@ -163,21 +282,44 @@ namespace ts {
         // Feed the depacketizer with a TS packet (PID already filtered).
         void processPacket(const TSPacket&);
 
+        // Delete the analysis context of a PID.
+        void deletePIDContext(PID pid);
+
         // This internal structure contains the analysis context for one TID/TIDext into one PID.
         struct ETIDContext
         {
-            uint8_t  version;        // Version of this table
-            size_t   sect_expected;  // Number of expected sections in table
-            size_t   sect_received;  // Number of received sections in table
-            SectionPtrVector sects;  // Array of sections
+            uint8_t  version;          // Version of this table
+            size_t   sect_expected;    // Number of expected sections in table
+            std::bitset<256> received; // Received sections in current version, indexed by section number
+            SectionPtrVector sects;    // Array of sections
+            std::bitset<256> has_crc;  // Section numbers with a known CRC32 ("change only" mode)
+            std::vector<uint32_t> crcs; // CRC32 of last delivered section, by section number ("change only" mode, allocated on first use)
 
             // Default constructor:
             ETIDContext() :
                 version(0),
                 sect_expected(0),
-                sect_received(0),
-                sects()
+                received(),
+                sects(),
+                has_crc(),
+                crcs()
+            {
+            }
+
+            // Check if all sections of the table are received.
+            bool complete() const { return sect_expected > 0 && received.count() == sect_expected; }
+
+            // Check if a section with the same CRC32 was already delivered ("change only" mode).
+            bool sameCRC(uint8_t section_number, uint32_t crc) const { return has_crc.test(section_number) && crcs[section_number] == crc; }
+
+            // Record the CRC32 of a delivered section ("change only" mode).
+            void setCRC(uint8_t section_number, uint32_t crc)
             {
+                if (crcs.empty()) {
+                    crcs.resize(256);
+                }
+                crcs[section_number] = crc;
+                has_crc.set(section_number);
             }
         };
 
@@ -189,6 +331,7 @@ namespace ts {
             ByteBlock ts;                      // TS payload buffer
             std::map <ETID, ETIDContext> tids; // TID analysis contexts
             PacketCounter pusi_pkt_index;      // Index of last PUSI packet in this PID
+            size_t skip;                       // Remaining size of a filtered-out section
 
             // Default constructor:
             PIDContext() :
@@ -196,7 +339,8 @@ namespace ts {
                 sync(false),
                 ts(),
                 tids(),
-                pusi_pkt_index(0)
+                pusi_pkt_index(0),
+                skip(0)
             {
             }
 
@@ -205,14 +349,19 @@ namespace ts {
             {
                 sync = false;
                 ts.clear();
+                skip = 0;
             }
         };
 
         // Private members:
         TableHandlerInterface*   _table_handler;
         SectionHandlerInterface* _section_handler;
-        std::map<PID,PIDContext> _pids;
+        SectionViewHandlerInterface* _view_handler;
+        std::vector<PIDContext*> _pids;  // PID-indexed, allocated on first packet of each PID
         Status                   _status;
+        bool                     _change_only;
+        CRC32::Validation        _crc_op;
+        HeaderFilter             _filter;
 
         // Inacessible operations
         SectionDemux(const SectionDemux&) = delete;
@@ -32,12 +32,15 @@
 //----------------------------------------------------------------------------
 
 #include "tsSectionFile.h"
+#include "tsxmlElementHandlerInterface.h"
 #include "tsAbstractTable.h"
 #include "tsAbstractDescriptor.h"
 #include "tsBinaryTable.h"
 #include "tsTablesDisplay.h"
 #include "tsTablesFactory.h"
 #include "tsSysUtils.h"
+#include "tsNullReport.h"
+#include "tsMemoryMappedFile.h"
 TSDUCK_SOURCE;
 
 
@@ -238,6 +241,257 @@ bool ts::SectionFile::loadBinary(std::istream& strm, Report& report, CRC32::Vali
 }
 
 
+//----------------------------------------------------------------------------
+// Table selectors.
+//----------------------------------------------------------------------------
+
+ts::SectionFile::TableSelector::TableSelector(TID tid_) :
+    tid(tid_),
+    has_tid_ext(false),
+    tid_ext(0),
+    has_version(false),
+    version(0)
+{
+}
+
+ts::SectionFile::TableSelector::TableSelector(TID tid_, uint16_t tid_ext_) :
+    tid(tid_),
+    has_tid_ext(true),
+    tid_ext(tid_ext_),
+    has_version(false),
+    version(0)
+{
+}
+
+ts::SectionFile::TableSelector::TableSelector(TID tid_, uint16_t tid_ext_, uint8_t version_) :
+    tid(tid_),
+    has_tid_ext(true),
+    tid_ext(tid_ext_),
+    has_version(true),
+    version(version_)
+{
+}
+
+bool ts::SectionFile::TableSelector::decode(const UString& str)
+{
+    UStringVector fields;
+    str.split(fields, u'/', true, false);
+
+    uint32_t t = 0;
+    uint32_t ext = 0;
+    uint32_t vers = 0;
+    if (fields.empty() || fields.size() > 3 ||
+        !fields[0].toInteger(t) || t > 0xFF ||
+        (fields.size() > 1 && (!fields[1].toInteger(ext) || ext > 0xFFFF)) ||
+        (fields.size() > 2 && (!fields[2].toInteger(vers) || vers > 31)))
+    {
+        return false;
+    }
+
+    tid = TID(t);
+    has_tid_ext = fields.size() > 1;
+    tid_ext = uint16_t(ext);
+    has_version = fields.size() > 2;
+    version = uint8_t(vers);
+    return true;
+}
+
+bool ts::SectionFile::TableSelector::match(TID stid, bool is_long, uint16_t stid_ext, uint8_t sversion) const
+{
+    return stid == tid &&
+        (is_long || (!has_tid_ext && !has_version)) &&
+        (!has_tid_ext || stid_ext == tid_ext) &&
+        (!has_version || sversion == version);
+}
+
+
+//----------------------------------------------------------------------------
+// Index files.
+//----------------------------------------------------------------------------
+
+namespace {
+    const uint8_t  INDEX_MAGIC[4] = {'T', 'S', 'I', 'X'};
+    const uint32_t INDEX_VERSION = 1;
+    const size_t   INDEX_HEADER_SIZE = 24;
+    const size_t   INDEX_ENTRY_SIZE = 16;
+}
+
+ts::UString ts::SectionFile::IndexFileName(const UString& file_name)
+{
+    return file_name + TS_DEFAULT_SECTION_INDEX_FILE_SUFFIX;
+}
+
+bool ts::SectionFile::ScanSections(IndexEntryVector& index, const uint8_t* data, size_t size, Report& report)
+{
+    index.clear();
+
+    // Only the section headers are read, the sections are neither copied nor checked.
+    size_t offset = 0;
+    while (offset < size) {
+        if (size - offset < MIN_SHORT_SECTION_SIZE) {
+            report.error(u"truncated section header at offset %'d", {offset});
+            return false;
+        }
+        const uint8_t* const sect = data + offset;
+        const size_t sect_size = 3 + (GetUInt16(sect + 1) & 0x0FFF);
+        const bool is_long = (sect[1] & 0x80) != 0;
+        if (sect_size > size - offset || sect_size > MAX_PRIVATE_SECTION_SIZE || (is_long && sect_size < MIN_LONG_SECTION_SIZE)) {
+            report.error(u"invalid or truncated section at offset %'d", {offset});
+            return false;
+        }
+        IndexEntry entry;
+        entry.offset = offset;
+        entry.size = uint16_t(sect_size);
+        entry.tid = sect[0];
+        entry.is_long = is_long;
+        entry.tid_ext = is_long ? GetUInt16(sect + 3) : 0;
+        entry.version = is_long ? (sect[5] >> 1) & 0x1F : 0;
+        entry.section_number = is_long ? sect[6] : 0;
+        index.push_back(entry);
+        offset += sect_size;
+    }
+    return true;
+}
+
+bool ts::SectionFile::LoadIndex(IndexEntryVector& index, const UString& index_name, uint64_t data_size)
+{
+    index.clear();
+
+    std::ifstream strm(index_name.toUTF8().c_str(), std::ios::in | std::ios::binary);
+    uint8_t header[INDEX_HEADER_SIZE];
+    if (!strm.read(reinterpret_cast<char*>(header), sizeof(header)) ||
+        ::memcmp(header, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0 ||
+        GetUInt32(header + 4) != INDEX_VERSION ||
+        GetUInt64(header + 8) != data_size)
+    {
+        return false;
+    }
+
+    // Read all entries in one operation.
+    const uint64_t count = GetUInt64(header + 16);
+    if (count > data_size / MIN_SHORT_SECTION_SIZE) {
+        return false;
+    }
+    ByteBlock data(size_t(count) * INDEX_ENTRY_SIZE);
+    if (!data.empty() && !strm.read(reinterpret_cast<char*>(data.data()), data.size())) {
+        return false;
+    }
+
+    index.resize(size_t(count));
+    for (size_t i = 0; i < index.size(); ++i) {
+        const uint8_t* const e = data.data() + i * INDEX_ENTRY_SIZE;
+        IndexEntry& entry(index[i]);
+        entry.offset = GetUInt64(e);
+        entry.size = GetUInt16(e + 8);
+        entry.tid = e[10];
+        entry.is_long = (e[11] & 0x01) != 0;
+        entry.tid_ext = GetUInt16(e + 12);
+        entry.version = e[14];
+        entry.section_number = e[15];
+        if (entry.offset > data_size || entry.size > data_size - entry.offset) {
+            index.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ts::SectionFile::SaveIndex(const IndexEntryVector& index, const UString& index_name, uint64_t data_size, Report& report)
+{
+    ByteBlock data(INDEX_HEADER_SIZE + index.size() * INDEX_ENTRY_SIZE);
+    ::memcpy(data.data(), INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    PutUInt32(data.data() + 4, INDEX_VERSION);
+    PutUInt64(data.data() + 8, data_size);
+    PutUInt64(data.data() + 16, uint64_t(index.size()));
+    for (size_t i = 0; i < index.size(); ++i) {
+        const IndexEntry& entry(index[i]);
+        uint8_t* const e = data.data() + INDEX_HEADER_SIZE + i * INDEX_ENTRY_SIZE;
+        PutUInt64(e, entry.offset);
+        PutUInt16(e + 8, entry.size);
+        e[10] = entry.tid;
+        e[11] = entry.is_long ? 0x01 : 0x00;
+        PutUInt16(e + 12, entry.tid_ext);
+        e[14] = entry.version;
+        e[15] = entry.section_number;
+    }
+
+    std::ofstream strm(index_name.toUTF8().c_str(), std::ios::out | std::ios::binary);
+    if (!strm.is_open()) {
+        report.error(u"error creating %s", {index_name});
+        return false;
+    }
+    strm.write(reinterpret_cast<const char*>(data.data()), data.size());
+    strm.close();
+    if (!strm) {
+        report.error(u"error writing %s", {index_name});
+        return false;
+    }
+    return true;
+}
+
+bool ts::SectionFile::BuildIndex(const UString& file_name, Report& report)
+{
+    MemoryMappedFile file;
+    IndexEntryVector index;
+    ReportWithPrefix report_internal(report, file_name + u": ");
+    return file.open(file_name, report) &&
+        ScanSections(index, file.data(), file.size(), report_internal) &&
+        SaveIndex(index, IndexFileName(file_name), file.size(), report);
+}
+
+
+//----------------------------------------------------------------------------
+// Load selected tables from an indexed binary section file.
+//----------------------------------------------------------------------------
+
+bool ts::SectionFile::loadBinary(const UString& file_name, const TableSelectorVector& selectors, Report& report, CRC32::Validation crc_op)
+{
+    clear();
+
+    MemoryMappedFile file;
+    if (!file.open(file_name, report)) {
+        return false;
+    }
+    ReportWithPrefix report_internal(report, file_name + u": ");
+
+    // Use the index file when it exists and matches the binary file.
+    // Otherwise, rebuild it. Failing to save the new index is not an error.
+    const UString index_name(IndexFileName(file_name));
+    IndexEntryVector index;
+    if (!LoadIndex(index, index_name, file.size())) {
+        report.debug(u"building index file %s", {index_name});
+        if (!ScanSections(index, file.data(), file.size(), report_internal)) {
+            return false;
+        }
+        SaveIndex(index, index_name, file.size(), NULLREP);
+    }
+
+    // Load the selected sections, in file order, so that contiguous sections form tables.
+    for (IndexEntryVector::const_iterator it = index.begin(); it != index.end(); ++it) {
+        bool selected = selectors.empty();
+        for (size_t i = 0; !selected && i < selectors.size(); ++i) {
+            selected = selectors[i].match(it->tid, it->is_long, it->tid_ext, it->version);
+        }
+        if (!selected) {
+            continue;
+        }
+        // Check that the index is still consistent with the section header.
+        const uint8_t* const sect = file.data() + it->offset;
+        if (sect[0] != it->tid || 3 + size_t(GetUInt16(sect + 1) & 0x0FFF) != it->size) {
+            report_internal.error(u"section at offset %'d does not match index file %s", {it->offset, index_name});
+            return false;
+        }
+        SectionPtr sp(new Section(sect, it->size, PID_NULL, crc_op));
+        if (!sp->isValid()) {
+            report_internal.error(u"invalid section at offset %'d", {it->offset});
+            return false;
+        }
+        add(sp);
+    }
+    return true;
+}
+
+
 //----------------------------------------------------------------------------
 // Save a binary section file.
 //----------------------------------------------------------------------------
@@ -274,75 +528,164 @@ bool ts::SectionFile::saveBinary(std::ostream& strm, Report& report) const
 // Load / parse an XML file.
 //----------------------------------------------------------------------------
 
+namespace {
+    // Build tables from the XML document while it is parsed.
+    // Each table is validated and built as soon as its element is complete.
+    class XMLTableLoader: public ts::xml::ElementHandlerInterface
+    {
+    public:
+        XMLTableLoader(ts::SectionFile& file, ts::xml::Document& doc);
+        bool loadModel();
+        bool complete() const;
+        virtual bool handleElement(const ts::xml::Element* element) override;
+    private:
+        ts::SectionFile&   _file;
+        ts::xml::Document& _doc;
+        ts::xml::Document  _model;
+        XMLTableLoader() = delete;
+        XMLTableLoader(const XMLTableLoader&) = delete;
+        XMLTableLoader& operator=(const XMLTableLoader&) = delete;
+    };
+
+    XMLTableLoader::XMLTableLoader(ts::SectionFile& file, ts::xml::Document& doc) :
+        _file(file),
+        _doc(doc),
+        _model(doc.report())
+    {
+        _doc.setElementHandler(this);
+    }
+
+    // Load the XML model for TSDuck files. Search it in TSDuck directory.
+    bool XMLTableLoader::loadModel()
+    {
+        if (!_model.load(u"tsduck.xml", true)) {
+            _doc.report().error(u"Model for TSDuck XML files not found");
+            return false;
+        }
+        return true;
+    }
+
+    // After parsing, validate the root. All its children were already processed.
+    bool XMLTableLoader::complete() const
+    {
+        return _doc.validate(_model);
+    }
+
+    // Invoked when a table element is complete.
+    bool XMLTableLoader::handleElement(const ts::xml::Element* element)
+    {
+        if (!_doc.validateChild(_model, element)) {
+            return false;
+        }
+        ts::BinaryTablePtr bin(new ts::BinaryTable);
+        ts::CheckNonNull(bin.pointer());
+        if (bin->fromXML(element) && bin->isValid()) {
+            _file.add(bin);
+            return true;
+        }
+        else {
+            _doc.report().error(u"Error in table <%s> at line %d", {element->name(), element->lineNumber()});
+            return false;
+        }
+    }
+}
+
 bool ts::SectionFile::loadXML(const UString& file_name, Report& report, const DVBCharset* charset)
 {
     clear();
     xml::Document doc(report);
-    return doc.load(file_name, false) && parseDocument(doc, charset);
+    XMLTableLoader loader(*this, doc);
+    return loader.loadModel() && doc.load(file_name, false) && loader.complete();
 }
 
 bool ts::SectionFile::loadXML(std::istream& strm, Report& report, const DVBCharset* charset)
 {
     clear();
     xml::Document doc(report);
-    return doc.load(strm) && parseDocument(doc, charset);
+    XMLTableLoader loader(*this, doc);
+    return loader.loadModel() && doc.load(strm) && loader.complete();
 }
 
 bool ts::SectionFile::parseXML(const UString& xml_content, Report& report, const DVBCharset* charset)
 {
     clear();
     xml::Document doc(report);
-    return doc.parse(xml_content) && parseDocument(doc, charset);
+    XMLTableLoader loader(*this, doc);
+    return loader.loadModel() && doc.parse(xml_content) && loader.complete();
 }
 
-bool ts::SectionFile::parseDocument(const xml::Document& doc, const DVBCharset* charset)
-{
-    // Load the XML model for TSDuck files. Search it in TSDuck directory.
-    xml::Document model(doc.report());
-    if (!model.load(u"tsduck.xml", true)) {
-        doc.report().error(u"Model for TSDuck XML files not found");
-        return false;
-    }
-
-    // Validate the input document according to the model.
-    if (!doc.validate(model)) {
-        return false;
-    }
 
-    // Get the root in the document. Should be ok since we validated the document.
-    const xml::Element* root = doc.rootElement();
-    bool success = true;
+//----------------------------------------------------------------------------
+// Create XML file or text.
+//----------------------------------------------------------------------------
 
-    // Analyze all tables in the document.
-    for (const xml::Element* node = root == 0 ? 0 : root->firstChildElement(); node != 0; node = node->nextSiblingElement()) {
-        BinaryTablePtr bin(new BinaryTable);
-        CheckNonNull(bin.pointer());
-        if (bin->fromXML(node) && bin->isValid()) {
-            add(bin);
-        }
-        else {
-            doc.report().error(u"Error in table <%s> at line %d", {node->name(), node->lineNumber()});
-            success = false;
-        }
+bool ts::SectionFile::saveXML(const UString& file_name, Report& report, const DVBCharset* charset) const
+{
+    TextFormatter out(report);
+    if (!out.setFile(file_name)) {
+        return false;
     }
+    const bool success = printXML(out, report, charset);
+    out.close();
     return success;
 }
 
+ts::UString ts::SectionFile::toXML(Report& report, const DVBCharset* charset) const
+{
+    TextFormatter out(report);
+    out.setString();
+    UString str;
+    return printXML(out, report, charset) && out.getString(str) ? str : UString();
+}
+
 
 //----------------------------------------------------------------------------
-// Create XML file or text.
+// Print the XML text of the file, one table at a time.
 //----------------------------------------------------------------------------
 
-bool ts::SectionFile::saveXML(const UString& file_name, Report& report, const DVBCharset* charset) const
+bool ts::SectionFile::printXML(TextFormatter& output, Report& report, const DVBCharset* charset) const
 {
+    // The document contains only the root element and the table which is currently printed.
     xml::Document doc(report);
-    return generateDocument(doc, charset) && doc.save(file_name);
-}
+    xml::Element* root = doc.initialize(u"tsduck");
+    if (root == 0) {
+        return false;
+    }
 
-ts::UString ts::SectionFile::toXML(Report& report, const DVBCharset* charset) const
-{
-    xml::Document doc(report);
-    return generateDocument(doc, charset) ? doc.toString() : UString();
+    bool open = false;
+    for (BinaryTablePtrVector::const_iterator it = _tables.begin(); it != _tables.end(); ++it) {
+        const BinaryTablePtr& table(*it);
+        xml::Element* elem = table.isNull() ? 0 : table->toXML(root, false, charset);
+        if (elem != 0) {
+            if (open) {
+                output << ts::margin;
+                elem->print(output, false);
+                output << std::endl;
+            }
+            else {
+                // With the first table, print the document header and keep the root open.
+                open = true;
+                doc.print(output, true);
+            }
+            // Deallocating the element removes it from the document.
+            delete elem;
+        }
+    }
+
+    // Close the root element or print an empty document.
+    if (open) {
+        doc.printClose(output);
+    }
+    else {
+        doc.print(output);
+    }
+
+    // Issue a warning if incomplete tables were not saved.
+    if (!_orphanSections.empty()) {
+        report.warning(u"%d orphan sections not saved in XML document (%d tables saved)", {_orphanSections.size(), _tables.size()});
+    }
+
+    return true;
 }
 
 
@@ -50,6 +50,10 @@
 //! Default suffix of XML section file names.
 //!
 #define TS_DEFAULT_XML_SECTION_FILE_SUFFIX u".xml"
+//!
+//! Default suffix of section index files, appended to the binary section file name.
+//!
+#define TS_DEFAULT_SECTION_INDEX_FILE_SUFFIX u".idx"
 
 namespace ts {
     //!
@@ -82,6 +86,24 @@ namespace ts {
     //! To get a valid table with long sections, all sections forming this table
     //! must be stored contiguously in the order of their section number.
     //!
+    //! ### Section index files
+    //!
+    //! A binary section file may have an optional index file with the same name
+    //! plus the suffix <code>.idx</code> (for instance <code>tables.bin.idx</code>).
+    //! The index lists the table id, table id extension, version, section number,
+    //! offset and size of all sections in the binary file. It is used to load
+    //! selected tables only: the binary file is memory-mapped and only the indexed
+    //! sections which match the selection are actually read. The binary file
+    //! itself is unchanged and remains readable by any application.
+    //!
+    //! The index file starts with a 24-byte header: the 4-byte magic number
+    //! <code>"TSIX"</code>, a 32-bit format version, the 64-bit size of the
+    //! binary file and the 64-bit number of entries. Each entry uses 16 bytes:
+    //! 64-bit offset, 16-bit size, table id, flags (bit 0 set for long sections),
+    //! 16-bit table id extension, version, section number. All integers are in
+    //! big endian format. An index which does not match the size of the binary
+    //! file is considered as obsolete and rebuilt.
+    //!
     //! ### XML section file format
     //!
     //! The format of XML section files is documented in the TSDuck user's guide.
@@ -214,6 +236,28 @@ namespace ts {
         //!
         UString toXML(Report& report = CERR, const DVBCharset* charset = 0) const;
 
+        //!
+        //! Print the XML text of the file on a text formatter.
+        //! The tables are converted and printed one by one. The memory which is used
+        //! does not depend on the number of tables in the file, no complete XML
+        //! document is built.
+        //! @param [in,out] output Where to print the XML text.
+        //! @param [in,out] report Where to report errors.
+        //! @param [in] charset If not zero, character set to use without explicit table code.
+        //! @return True on success, false on error.
+        //!
+        bool printXML(TextFormatter& output, Report& report = CERR, const DVBCharset* charset = 0) const;
+
+        //!
+        //! Generate a complete XML document.
+        //! Use this method only when the XML structure is needed. To save or serialize
+        //! the file as XML text, saveXML(), toXML() and printXML() are more efficient.
+        //! @param [in,out] doc XML document.
+        //! @param [in] charset If not zero, character set to use without explicit table code.
+        //! @return True on success, false on error.
+        //!
+        bool generateDocument(xml::Document& doc, const DVBCharset* charset = 0) const;
+
         //!
         //! Load a binary section file from a stream.
         //! @param [in,out] strm A standard stream in input mode (binary mode).
@@ -232,6 +276,93 @@ namespace ts {
         //!
         bool loadBinary(const UString& file_name, Report& report = CERR, CRC32::Validation crc_op = CRC32::IGNORE);
 
+        //!
+        //! Selection of tables in a binary section file.
+        //! A selector always specifies a table id. The table id extension and
+        //! the version are optional. A short section matches a selector only
+        //! when neither the table id extension nor the version is specified.
+        //!
+        class TSDUCKDLL TableSelector
+        {
+        public:
+            TID      tid;          //!< Table id.
+            bool     has_tid_ext;  //!< The table id extension is specified.
+            uint16_t tid_ext;      //!< Table id extension, when @a has_tid_ext is true.
+            bool     has_version;  //!< The version is specified.
+            uint8_t  version;      //!< Version, when @a has_version is true.
+
+            //!
+            //! Constructor.
+            //! @param [in] tid Table id.
+            //!
+            TableSelector(TID tid = TID_NULL);
+
+            //!
+            //! Constructor.
+            //! @param [in] tid Table id.
+            //! @param [in] tid_ext Table id extension.
+            //!
+            TableSelector(TID tid, uint16_t tid_ext);
+
+            //!
+            //! Constructor.
+            //! @param [in] tid Table id.
+            //! @param [in] tid_ext Table id extension.
+            //! @param [in] version Version.
+            //!
+            TableSelector(TID tid, uint16_t tid_ext, uint8_t version);
+
+            //!
+            //! Decode a string in the form "tid[/tid_ext[/version]]".
+            //! @param [in] str String to decode. Values are decimal or hexadecimal with a "0x" prefix.
+            //! @return True on success, false on invalid string. On error, the selector is unchanged.
+            //!
+            bool decode(const UString& str);
+
+            //!
+            //! Check if a section header matches the selector.
+            //! @param [in] stid Table id of the section.
+            //! @param [in] is_long True if this is a long section.
+            //! @param [in] stid_ext Table id extension of the section (long section only).
+            //! @param [in] sversion Version of the section (long section only).
+            //! @return True if the section matches.
+            //!
+            bool match(TID stid, bool is_long, uint16_t stid_ext, uint8_t sversion) const;
+        };
+
+        //!
+        //! Vector of table selectors.
+        //!
+        typedef std::vector<TableSelector> TableSelectorVector;
+
+        //!
+        //! Load selected tables from a binary section file, using its index file.
+        //! The binary file is memory-mapped and only the sections which match at least
+        //! one selector are read. If the index file is missing or obsolete, it is rebuilt
+        //! from the section headers and saved when possible.
+        //! @param [in] file_name Binary file name.
+        //! @param [in] selectors List of selectors. Empty means all sections.
+        //! @param [in,out] report Where to report errors.
+        //! @param [in] crc_op How to process the CRC32 of the input sections.
+        //! @return True on success, false on error.
+        //!
+        bool loadBinary(const UString& file_name, const TableSelectorVector& selectors, Report& report = CERR, CRC32::Validation crc_op = CRC32::IGNORE);
+
+        //!
+        //! Get the name of the index file of a binary section file.
+        //! @param [in] file_name Binary file name.
+        //! @return The name of the corresponding index file.
+        //!
+        static UString IndexFileName(const UString& file_name);
+
+        //!
+        //! Build or rebuild the index file of a binary section file.
+        //! @param [in] file_name Binary file name.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on error.
+        //!
+        static bool BuildIndex(const UString& file_name, Report& report = CERR);
+
         //!
         //! Save a binary section file.
         //! @param [in,out] strm A standard stream in output mode (binary mode).
@@ -340,20 +471,48 @@ namespace ts {
         SectionPtrVector     _orphanSections;  //!< Sections which do not belong to any table.
 
         //!
-        //! Parse an XML document.
-        //! @param [in] doc Document to load.
-        //! @param [in] charset If not zero, default character set to encode strings.
-        //! @return True on success, false on error.
+        //! Description of a section in an index file.
         //!
-        bool parseDocument(const xml::Document& doc, const DVBCharset* charset);
+        struct IndexEntry
+        {
+            uint64_t offset;          //!< Offset of the section in the binary file.
+            uint16_t size;            //!< Section size in bytes.
+            TID      tid;             //!< Table id.
+            bool     is_long;         //!< Long section.
+            uint16_t tid_ext;         //!< Table id extension (long section only).
+            uint8_t  version;         //!< Version (long section only).
+            uint8_t  section_number;  //!< Section number (long section only).
+        };
+        typedef std::vector<IndexEntry> IndexEntryVector;  //!< Content of an index file.
 
         //!
-        //! Generate an XML document.
-        //! @param [in,out] doc XML document.
-        //! @param [in] charset If not zero, character set to use without explicit table code.
+        //! Build an index from the content of a binary section file.
+        //! @param [out] index Index of all valid sections.
+        //! @param [in] data Address of the file content.
+        //! @param [in] size Size of the file content.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on truncated or invalid section.
+        //!
+        static bool ScanSections(IndexEntryVector& index, const uint8_t* data, size_t size, Report& report);
+
+        //!
+        //! Load an index file.
+        //! @param [out] index Index content.
+        //! @param [in] index_name Index file name.
+        //! @param [in] data_size Size of the binary section file.
+        //! @return True on success, false if the index file is missing, invalid or obsolete.
+        //!
+        static bool LoadIndex(IndexEntryVector& index, const UString& index_name, uint64_t data_size);
+
+        //!
+        //! Save an index file.
+        //! @param [in] index Index content.
+        //! @param [in] index_name Index file name.
+        //! @param [in] data_size Size of the binary section file.
+        //! @param [in,out] report Where to report errors.
         //! @return True on success, false on error.
         //!
-        bool generateDocument(xml::Document& doc, const DVBCharset* charset) const;
+        static bool SaveIndex(const IndexEntryVector& index, const UString& index_name, uint64_t data_size, Report& report);
 
         //!
         //! Check it a table can be formed using the last sections in _orphanSections.
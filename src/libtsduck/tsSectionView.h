@@ -0,0 +1,205 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Lightweight read-only view on a binary MPEG section.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsETID.h"
+
+namespace ts {
+    //!
+    //! Lightweight read-only view on a binary MPEG section.
+    //!
+    //! A SectionView is only a pointer and a length on a complete section which
+    //! is stored somewhere else. It is typically delivered by a SectionDemux to
+    //! a SectionViewHandlerInterface without copying the section content and
+    //! without any memory allocation. The viewed memory is owned by its provider
+    //! and is valid only as long as the provider says so. For a SectionDemux,
+    //! this is during the handler call only. Use a Section to keep a copy.
+    //!
+    //! The section header is not checked by the view itself, the provider is
+    //! responsible for delivering views on valid sections only.
+    //!
+    class TSDUCKDLL SectionView
+    {
+    public:
+        //!
+        //! Constructor.
+        //! @param [in] data Address of the binary section data.
+        //! @param [in] size Size in bytes of the section.
+        //! @param [in] source_pid PID from which the section was read.
+        //! @param [in] packet_index Index of the TS packet containing the section.
+        //!
+        SectionView(const uint8_t* data, size_t size, PID source_pid = PID_NULL, PacketCounter packet_index = 0) :
+            _data(data),
+            _size(size),
+            _source_pid(source_pid),
+            _packet_index(packet_index)
+        {
+        }
+
+        //!
+        //! Access to the full binary content of the section.
+        //! @return Address of the full binary content of the section.
+        //!
+        const uint8_t* content() const
+        {
+            return _data;
+        }
+
+        //!
+        //! Size of the binary content of the section.
+        //! @return Size of the binary content of the section.
+        //!
+        size_t size() const
+        {
+            return _size;
+        }
+
+        //!
+        //! Get the source PID.
+        //! @return The source PID.
+        //!
+        PID sourcePID() const
+        {
+            return _source_pid;
+        }
+
+        //!
+        //! Get the index of the TS packet containing the section.
+        //! @return The index of the TS packet containing the section.
+        //!
+        PacketCounter packetIndex() const
+        {
+            return _packet_index;
+        }
+
+        //!
+        //! Get the table id.
+        //! @return The table id.
+        //!
+        TID tableId() const
+        {
+            return _data[0];
+        }
+
+        //!
+        //! Check if the section is a long one.
+        //! @return True if the section is a long one.
+        //!
+        bool isLongSection() const
+        {
+            return (_data[1] & 0x80) != 0;
+        }
+
+        //!
+        //! Check if the section is a short one.
+        //! @return True if the section is a short one.
+        //!
+        bool isShortSection() const
+        {
+            return (_data[1] & 0x80) == 0;
+        }
+
+        //!
+        //! Get the table id extension (long section only).
+        //! @return The table id extension.
+        //!
+        uint16_t tableIdExtension() const
+        {
+            return isLongSection() ? GetUInt16(_data + 3) : 0;
+        }
+
+        //!
+        //! Get the section version number (long section only).
+        //! @return The section version number.
+        //!
+        uint8_t version() const
+        {
+            return isLongSection() ? ((_data[5] >> 1) & 0x1F) : 0;
+        }
+
+        //!
+        //! Get the section number in the table (long section only).
+        //! @return The section number in the table.
+        //!
+        uint8_t sectionNumber() const
+        {
+            return isLongSection() ? _data[6] : 0;
+        }
+
+        //!
+        //! Get the number of the last section in the table (long section only).
+        //! @return The number of the last section in the table.
+        //!
+        uint8_t lastSectionNumber() const
+        {
+            return isLongSection() ? _data[7] : 0;
+        }
+
+        //!
+        //! Get the table id and id extension (long section only).
+        //! @return The table id and id extension as an ETID.
+        //!
+        ETID etid() const
+        {
+            return isLongSection() ? ETID(tableId(), tableIdExtension()) : ETID(tableId());
+        }
+
+        //!
+        //! Access to the payload of the section.
+        //! For long sections, the payload starts after the last_section_number
+        //! field and ends before the CRC32 field.
+        //! @return Address of the payload of the section.
+        //!
+        const uint8_t* payload() const
+        {
+            return _data + (isLongSection() ? LONG_SECTION_HEADER_SIZE : SHORT_SECTION_HEADER_SIZE);
+        }
+
+        //!
+        //! Get the size of the payload of the section.
+        //! For long sections, the payload ends before the CRC32 field.
+        //! @return Size in bytes of the payload of the section.
+        //!
+        size_t payloadSize() const
+        {
+            return _size - (isLongSection() ? LONG_SECTION_HEADER_SIZE + SECTION_CRC32_SIZE : SHORT_SECTION_HEADER_SIZE);
+        }
+
+    private:
+        const uint8_t* _data;
+        size_t         _size;
+        PID            _source_pid;
+        PacketCounter  _packet_index;
+    };
+}
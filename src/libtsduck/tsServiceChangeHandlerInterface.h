@@ -0,0 +1,109 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Interface to receive incremental changes from a ServiceDiscovery.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsPMT.h"
+
+namespace ts {
+
+    class ServiceDiscovery;
+
+    //!
+    //! Interface to receive incremental changes from a ServiceDiscovery.
+    //!
+    //! Instead of processing the complete PMT each time a new version is received,
+    //! an application may receive the differences only. All notifications are invoked
+    //! before the PMT handler of the ServiceDiscovery, if any. All methods have an
+    //! empty default implementation, the application overrides the ones it needs.
+    //!
+    class TSDUCKDLL ServiceChangeHandlerInterface
+    {
+    public:
+        //!
+        //! This hook is invoked when the service is located in the PAT.
+        //! The service id and PMT PID are known but the PMT is not yet received.
+        //! @param [in,out] service The ServiceDiscovery which notifies the change.
+        //!
+        virtual void handleServiceAdded(ServiceDiscovery& service) {}
+
+        //!
+        //! This hook is invoked when a previously located service disappears.
+        //! All elementary streams of the service are implicitly removed, no
+        //! individual notification is sent for them.
+        //! @param [in,out] service The ServiceDiscovery which notifies the change.
+        //!
+        virtual void handleServiceRemoved(ServiceDiscovery& service) {}
+
+        //!
+        //! This hook is invoked when the name of the service changes in the SDT.
+        //! It is not invoked for the first name which is received. A service which
+        //! is searched by name is not renamed, it is no longer found in the SDT.
+        //! @param [in,out] service The ServiceDiscovery which notifies the change.
+        //! @param [in] old_name Previous name of the service.
+        //! @param [in] new_name New name of the service.
+        //!
+        virtual void handleServiceNameChanged(ServiceDiscovery& service, const UString& old_name, const UString& new_name) {}
+
+        //!
+        //! This hook is invoked when an elementary stream appears in the PMT.
+        //! @param [in,out] service The ServiceDiscovery which notifies the change.
+        //! @param [in] pid PID of the elementary stream.
+        //! @param [in] stream Description of the elementary stream.
+        //!
+        virtual void handleStreamAdded(ServiceDiscovery& service, PID pid, const PMT::Stream& stream) {}
+
+        //!
+        //! This hook is invoked when an elementary stream disappears from the PMT.
+        //! @param [in,out] service The ServiceDiscovery which notifies the change.
+        //! @param [in] pid PID of the elementary stream.
+        //! @param [in] stream Last description of the elementary stream.
+        //!
+        virtual void handleStreamRemoved(ServiceDiscovery& service, PID pid, const PMT::Stream& stream) {}
+
+        //!
+        //! This hook is invoked when the stream type or the descriptors of an
+        //! elementary stream change in the PMT, on the same PID.
+        //! @param [in,out] service The ServiceDiscovery which notifies the change.
+        //! @param [in] pid PID of the elementary stream.
+        //! @param [in] old_stream Previous description of the elementary stream.
+        //! @param [in] new_stream New description of the elementary stream.
+        //!
+        virtual void handleStreamChanged(ServiceDiscovery& service, PID pid, const PMT::Stream& old_stream, const PMT::Stream& new_stream) {}
+
+        //!
+        //! Virtual destructor.
+        //!
+        virtual ~ServiceChangeHandlerInterface() {}
+    };
+}
@@ -94,17 +94,43 @@ void ts::ServiceDescriptor::serialize(Descriptor& desc, const DVBCharset* charse
 
 void ts::ServiceDescriptor::deserialize(const Descriptor& desc, const DVBCharset* charset)
 {
-    _is_valid = desc.isValid() && desc.tag() == _tag && desc.payloadSize() >= 3;
-
-    if (_is_valid) {
-        const uint8_t* data = desc.payload();
-        size_t size = desc.payloadSize();
-        service_type = data[0];
-        data++; size--;
-        provider_name.assign(UString::FromDVBWithByteLength(data, size, charset));
-        service_name.assign(UString::FromDVBWithByteLength(data, size, charset));
-        _is_valid = size == 0;
+    _is_valid = DecodeFields(desc, &service_type, &provider_name, &service_name, charset);
+}
+
+
+//----------------------------------------------------------------------------
+// Decode selected fields of a binary service_descriptor.
+//----------------------------------------------------------------------------
+
+bool ts::ServiceDescriptor::DecodeFields(const Descriptor& desc, uint8_t* type, UString* provider, UString* name, const DVBCharset* charset)
+{
+    if (!desc.isValid() || desc.tag() != MY_DID || desc.payloadSize() < 3) {
+        return false;
+    }
+
+    // Check the layout: service_type, provider name and service name, each name with its length.
+    const uint8_t* data = desc.payload();
+    const size_t size = desc.payloadSize();
+    const size_t provider_size = data[1];
+    if (2 + provider_size >= size) {
+        return false;
+    }
+    const size_t name_size = data[2 + provider_size];
+    if (3 + provider_size + name_size != size) {
+        return false;
+    }
+
+    // Decode the requested fields only.
+    if (type != 0) {
+        *type = data[0];
+    }
+    if (provider != 0) {
+        provider->assign(UString::FromDVB(data + 2, provider_size, charset));
+    }
+    if (name != 0) {
+        name->assign(UString::FromDVB(data + 3 + provider_size, name_size, charset));
     }
+    return true;
 }
 
 
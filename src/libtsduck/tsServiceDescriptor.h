@@ -64,6 +64,20 @@ namespace ts {
         //!
         ServiceDescriptor(const Descriptor& bin, const DVBCharset* charset = 0);
 
+        //!
+        //! Decode selected fields of a binary service_descriptor.
+        //! The layout of the descriptor is checked using the length fields only and
+        //! only the requested names are decoded from their DVB character set.
+        //! @param [in] bin A binary descriptor to decode.
+        //! @param [out] type If not zero, receive the service type.
+        //! @param [out] provider If not zero, receive the provider name.
+        //! @param [out] name If not zero, receive the service name.
+        //! @param [in] charset If not zero, character set to use without explicit table code.
+        //! @return True if @a bin is a valid service_descriptor, false otherwise.
+        //! When false is returned, the output fields are unchanged.
+        //!
+        static bool DecodeFields(const Descriptor& bin, uint8_t* type, UString* provider, UString* name, const DVBCharset* charset = 0);
+
         // Inherited methods
         virtual void serialize(Descriptor&, const DVBCharset* = 0) const override;
         virtual void deserialize(const Descriptor&, const DVBCharset* = 0) override;
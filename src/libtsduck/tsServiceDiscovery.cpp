@@ -41,7 +41,10 @@ ts::ServiceDiscovery::ServiceDiscovery(PMTHandlerInterface* pmtHandler, Report&
     _notFound(false),
     _charset(charset),
     _pmtHandler(pmtHandler),
+    _changeHandler(0),
+    _byName(false),
     _pmt(),
+    _streams(),
     _demux(this)
 {
     _pmt.invalidate();
@@ -67,6 +70,7 @@ void ts::ServiceDiscovery::set(const UString& desc)
 {
     // Clear and set superclass.
     Service::set(desc);
+    _byName = hasName();
 
     // Start to intercept tables.
     if (hasName()) {
@@ -94,6 +98,8 @@ void ts::ServiceDiscovery::clear()
 {
     _demux.reset();
     _pmt.invalidate();
+    _streams.clear();
+    _byName = false;
     Service::clear();
 }
 
@@ -147,8 +153,8 @@ void ts::ServiceDiscovery::processSDT(const SDT& sdt)
     uint16_t service_id = 0;
     SDT::ServiceMap::const_iterator srv = sdt.services.end();
 
-    if (!hasName()) {
-        // Service is known by id only.
+    if (!_byName) {
+        // Service is known by id.
         assert(hasId());
         service_id = getId();
         srv = sdt.services.find(service_id);
@@ -180,6 +186,7 @@ void ts::ServiceDiscovery::processSDT(const SDT& sdt)
             // We need to rescan the service map. The PMT is reset.
             if (hasPMTPID()) {
                 _demux.removePID(getPMTPID());
+                removeService();
             }
             _pmt.invalidate();
         }
@@ -203,8 +210,18 @@ void ts::ServiceDiscovery::processSDT(const SDT& sdt)
     setEITsPresent(srv->second.EITs_present);
     setRunningStatus(srv->second.running_status);
     setType(srv->second.serviceType());
-    setName(srv->second.serviceName(_charset));
     setProvider(srv->second.providerName(_charset));
+
+    // The first name which is received is not a name change.
+    const UString name(srv->second.serviceName(_charset));
+    if (!_byName && hasName() && _changeHandler != 0 && name != getName()) {
+        const UString old_name(getName());
+        setName(name);
+        _changeHandler->handleServiceNameChanged(*this, old_name, name);
+    }
+    else {
+        setName(name);
+    }
 }
 
 
@@ -220,6 +237,13 @@ void ts::ServiceDiscovery::processPAT(const PAT& pat)
         // A service id was known, locate the service in the PAT.
         it = pat.pmts.find(getId());
         if (it == pat.pmts.end()) {
+            if (hasPMTPID()) {
+                // The service was previously found, it has been removed.
+                _demux.removePID(getPMTPID());
+                clearPMTPID();
+                _pmt.invalidate();
+                removeService();
+            }
             _report.error(u"service id 0x%X (%d) not found in PAT", {getId(), getId()});
             _notFound = true;
             return;
@@ -243,6 +267,7 @@ void ts::ServiceDiscovery::processPAT(const PAT& pat)
     // If the PMT PID was known but was different, we need to rescan the PMT.
     if (!hasPMTPID(it->second)) {
         // Store new PMT PID.
+        const bool added = !hasPMTPID();
         setPMTPID(it->second);
 
         // (Re)scan the PMT.
@@ -253,6 +278,10 @@ void ts::ServiceDiscovery::processPAT(const PAT& pat)
         _pmt.invalidate();
 
         _report.verbose(u"found service id 0x%X (%d), PMT PID is 0x%X (%d)", {getId(), getId(), getPMTPID(), getPMTPID()});
+
+        if (added && _changeHandler != 0) {
+            _changeHandler->handleServiceAdded(*this);
+        }
     }
 }
 
@@ -266,8 +295,46 @@ void ts::ServiceDiscovery::processPMT(const PMT& pmt)
     // Store the new PMT.
     _pmt = pmt;
 
+    // Notify the individual changes in the elementary streams.
+    // Both stream maps are sorted by PID, merge them in one pass.
+    if (_changeHandler != 0) {
+        PMT::StreamMap::const_iterator old_it = _streams.begin();
+        PMT::StreamMap::const_iterator new_it = _pmt.streams.begin();
+        while (old_it != _streams.end() || new_it != _pmt.streams.end()) {
+            if (new_it == _pmt.streams.end() || (old_it != _streams.end() && old_it->first < new_it->first)) {
+                _changeHandler->handleStreamRemoved(*this, old_it->first, old_it->second);
+                ++old_it;
+            }
+            else if (old_it == _streams.end() || new_it->first < old_it->first) {
+                _changeHandler->handleStreamAdded(*this, new_it->first, new_it->second);
+                ++new_it;
+            }
+            else {
+                if (old_it->second.stream_type != new_it->second.stream_type || old_it->second.descs != new_it->second.descs) {
+                    _changeHandler->handleStreamChanged(*this, new_it->first, old_it->second, new_it->second);
+                }
+                ++old_it;
+                ++new_it;
+            }
+        }
+        _streams = _pmt.streams;
+    }
+
     // Notify the application.
     if (_pmtHandler != 0) {
         _pmtHandler->handlePMT(_pmt);
     }
 }
+
+
+//----------------------------------------------------------------------------
+// Notify the change handler that the service is no longer present.
+//----------------------------------------------------------------------------
+
+void ts::ServiceDiscovery::removeService()
+{
+    _streams.clear();
+    if (_changeHandler != 0) {
+        _changeHandler->handleServiceRemoved(*this);
+    }
+}
@@ -37,6 +37,7 @@
 #include "tsSectionDemux.h"
 #include "tsNullReport.h"
 #include "tsPMTHandlerInterface.h"
+#include "tsServiceChangeHandlerInterface.h"
 #include "tsPAT.h"
 #include "tsSDT.h"
 
@@ -47,6 +48,10 @@ namespace ts {
     //! This subclass of Service automatically detects the properties of the
     //! service based on TS packets from the transport stream.
     //!
+    //! The application may receive the complete PMT of the service each time
+    //! it changes (PMTHandlerInterface) or the individual changes only
+    //! (ServiceChangeHandlerInterface), or both.
+    //!
     class TSDUCKDLL ServiceDiscovery : public Service, private TableHandlerInterface
     {
     public:
@@ -87,6 +92,12 @@ namespace ts {
         //!
         void setPMTHandler(PMTHandlerInterface* h) { _pmtHandler = h; }
 
+        //!
+        //! Replace the service change handler.
+        //! @param [in] h The new handler, zero to remove it.
+        //!
+        void setServiceChangeHandler(ServiceChangeHandlerInterface* h) { _changeHandler = h; }
+
         //!
         //! Check if the PMT of the service is known.
         //! @return True if the PMT is present.
@@ -111,7 +122,10 @@ namespace ts {
         bool                 _notFound;    // Set when service does not exist.
         const DVBCharset*    _charset;     // Default DVB charset.
         PMTHandlerInterface* _pmtHandler;  // Handler to call for each new PMT.
+        ServiceChangeHandlerInterface* _changeHandler;  // Handler to call for each individual change.
+        bool                 _byName;      // The service is searched by name in the SDT.
         PMT                  _pmt;         // Last valid PMT for the service.
+        PMT::StreamMap       _streams;     // Elementary streams, as last notified to the change handler.
         SectionDemux         _demux;       // PSI demux for service discovery.
 
         // Invoked by the demux when a complete table is available.
@@ -122,6 +136,9 @@ namespace ts {
         void processPMT(const PMT&);
         void processSDT(const SDT&);
 
+        // Notify the change handler that the service is no longer present.
+        void removeService();
+
         // Unaccessible operations.
         ServiceDiscovery(const ServiceDiscovery&) = delete;
         ServiceDiscovery& operator=(const ServiceDiscovery&) = delete;
@@ -0,0 +1,135 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "tsSignalMonitor.h"
+#include "tsGuardCondition.h"
+TSDUCK_SOURCE;
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const ts::MilliSecond ts::SignalMonitor::DEFAULT_POLL_INTERVAL;
+#endif
+
+// Stack size for the monitoring thread
+#define MONITOR_STACK_SIZE (128 * 1024)
+
+
+//----------------------------------------------------------------------------
+// Constructor and destructor.
+//----------------------------------------------------------------------------
+
+ts::SignalMonitor::SignalMonitor(const UString& device, MilliSecond interval) :
+    Thread(ThreadAttributes().setPriority(ThreadAttributes::GetMinimumPriority()).setStackSize(MONITOR_STACK_SIZE).setName(u"monitor")),
+    _device(device),
+    _interval(interval),
+    _locked(-1),
+    _strength(-1),
+    _quality(-1),
+    _fifo_load(-1),
+    _bitrate(-1),
+    _locked_gauge(0),
+    _strength_gauge(0),
+    _quality_gauge(0),
+    _fifo_gauge(0),
+    _bitrate_gauge(0),
+    _mutex(),
+    _wake_up(),
+    _terminate(false)
+{
+}
+
+ts::SignalMonitor::~SignalMonitor()
+{
+    stop();
+}
+
+
+//----------------------------------------------------------------------------
+// Start and stop the monitoring thread.
+//----------------------------------------------------------------------------
+
+bool ts::SignalMonitor::start()
+{
+    {
+        GuardCondition lock(_mutex, _wake_up);
+        _terminate = false;
+    }
+    pollDevice();
+    return Thread::start();
+}
+
+void ts::SignalMonitor::stop()
+{
+    {
+        GuardCondition lock(_mutex, _wake_up);
+        _terminate = true;
+        lock.signal();
+    }
+    waitForTermination();
+}
+
+
+//----------------------------------------------------------------------------
+// Thread main code. Inherited from Thread
+//----------------------------------------------------------------------------
+
+void ts::SignalMonitor::main()
+{
+    for (;;) {
+        {
+            GuardCondition lock(_mutex, _wake_up);
+            if (!_terminate) {
+                lock.waitCondition(_interval);
+            }
+            if (_terminate) {
+                break;
+            }
+        }
+        pollDevice();
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Publish a value in an atomic variable and a gauge.
+//----------------------------------------------------------------------------
+
+void ts::SignalMonitor::publish(std::atomic<int64_t>& var, MetricGauge*& gauge, const UString& name, const UString& help, int64_t value)
+{
+    var.store(value, std::memory_order_relaxed);
+
+    // Unknown values are not published in the metrics registry. The gauge
+    // is created the first time the value is known and keeps its last value.
+    if (value >= 0) {
+        if (gauge == 0) {
+            Metric::Labels labels;
+            labels[u"device"] = _device;
+            gauge = MetricsRegistry::Instance()->gauge(name, help, labels);
+        }
+        gauge->set(value);
+    }
+}
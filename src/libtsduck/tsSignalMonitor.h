@@ -0,0 +1,186 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Background monitoring of the signal and status of an input device.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsMetrics.h"
+#include "tsThread.h"
+#include "tsCondition.h"
+#include "tsMPEG.h"
+
+namespace ts {
+    //!
+    //! Background monitoring of the signal and status of an input device.
+    //!
+    //! Reading the signal state or the status of a device may be slow on some
+    //! drivers. Input plugins shall not do this in their receive() or getBitrate()
+    //! methods. Instead, a subclass of SignalMonitor polls the device at regular
+    //! intervals in an internal low-priority thread and publishes the values
+    //! through atomic variables. The input plugin reads the last values without
+    //! blocking. All published values are also available as gauges in the
+    //! ts::MetricsRegistry, with a label @c device.
+    //!
+    //! Unknown values, which are never set by the subclass, are not published
+    //! in the metrics registry.
+    //!
+    class TSDUCKDLL SignalMonitor: private Thread
+    {
+    public:
+        //!
+        //! Default polling interval.
+        //!
+        static const MilliSecond DEFAULT_POLL_INTERVAL = 1000;
+
+        //!
+        //! Constructor.
+        //! @param [in] device Device name, used as label in the metrics.
+        //! @param [in] interval Polling interval.
+        //!
+        explicit SignalMonitor(const UString& device, MilliSecond interval = DEFAULT_POLL_INTERVAL);
+
+        //!
+        //! Destructor. The subclass must invoke stop() in its own destructor.
+        //!
+        virtual ~SignalMonitor() override;
+
+        //!
+        //! Start the monitoring.
+        //! The device is synchronously polled once, so that the values are
+        //! valid on return, and then the monitoring thread is started.
+        //! @return True on success, false on error.
+        //!
+        bool start();
+
+        //!
+        //! Stop the monitoring thread and wait for its termination.
+        //! Can be called several times.
+        //!
+        void stop();
+
+        //!
+        //! Check if the input signal is locked.
+        //! @return True if the signal is locked, false if not locked or unknown.
+        //!
+        bool signalLocked() const { return _locked.load(std::memory_order_relaxed) > 0; }
+
+        //!
+        //! Get the signal strength.
+        //! @return Signal strength in percent (0=bad, 100=good), negative if unknown.
+        //!
+        int signalStrength() const { return int(_strength.load(std::memory_order_relaxed)); }
+
+        //!
+        //! Get the signal quality.
+        //! @return Signal quality in percent (0=bad, 100=good), negative if unknown.
+        //!
+        int signalQuality() const { return int(_quality.load(std::memory_order_relaxed)); }
+
+        //!
+        //! Get the load of the input FIFO of the device.
+        //! @return Number of bytes in the input FIFO, negative if unknown.
+        //!
+        int64_t fifoLoad() const { return _fifo_load.load(std::memory_order_relaxed); }
+
+        //!
+        //! Get the input bitrate, as reported by the device.
+        //! @return The input bitrate in bits/second, zero if unknown.
+        //!
+        BitRate bitrate() const { return BitRate(std::max<int64_t>(0, _bitrate.load(std::memory_order_relaxed))); }
+
+    protected:
+        //!
+        //! Poll the device and publish the values.
+        //! Invoked in the context of the monitoring thread (and once in start()).
+        //! Must be implemented by subclasses, using the setXXX() methods.
+        //!
+        virtual void pollDevice() = 0;
+
+        //!
+        //! Publish the lock state of the input signal.
+        //! @param [in] locked True if the signal is locked.
+        //!
+        void setSignalLocked(bool locked) { publish(_locked, _locked_gauge, u"tsp_input_signal_locked", u"Input signal is locked (1) or not (0)", locked ? 1 : 0); }
+
+        //!
+        //! Publish the signal strength.
+        //! @param [in] strength Signal strength in percent, negative if unknown.
+        //!
+        void setSignalStrength(int strength) { publish(_strength, _strength_gauge, u"tsp_input_signal_strength_percent", u"Input signal strength in percent", strength); }
+
+        //!
+        //! Publish the signal quality.
+        //! @param [in] quality Signal quality in percent, negative if unknown.
+        //!
+        void setSignalQuality(int quality) { publish(_quality, _quality_gauge, u"tsp_input_signal_quality_percent", u"Input signal quality in percent", quality); }
+
+        //!
+        //! Publish the load of the input FIFO.
+        //! @param [in] load Number of bytes in the input FIFO, negative if unknown.
+        //!
+        void setFifoLoad(int64_t load) { publish(_fifo_load, _fifo_gauge, u"tsp_input_fifo_load_bytes", u"Number of bytes in the input FIFO of the device", load); }
+
+        //!
+        //! Publish the input bitrate.
+        //! @param [in] bitrate Input bitrate in bits/second, zero if unknown.
+        //!
+        void setBitrate(BitRate bitrate) { publish(_bitrate, _bitrate_gauge, u"tsp_input_bitrate_bps", u"Input bitrate as reported by the device", bitrate > 0 ? int64_t(bitrate) : -1); }
+
+    private:
+        const UString        _device;
+        const MilliSecond    _interval;
+        std::atomic<int64_t> _locked;     // Negative if unknown
+        std::atomic<int64_t> _strength;
+        std::atomic<int64_t> _quality;
+        std::atomic<int64_t> _fifo_load;
+        std::atomic<int64_t> _bitrate;
+        MetricGauge*         _locked_gauge;   // Gauges, created when the value is first known.
+        MetricGauge*         _strength_gauge;
+        MetricGauge*         _quality_gauge;
+        MetricGauge*         _fifo_gauge;
+        MetricGauge*         _bitrate_gauge;
+        Mutex                _mutex;
+        Condition            _wake_up;    // accessed under mutex
+        bool                 _terminate;  // accessed under mutex
+
+        // Inherited from Thread
+        virtual void main() override;
+
+        // Publish a value in an atomic variable and a gauge. Negative values are unknown.
+        void publish(std::atomic<int64_t>& var, MetricGauge*& gauge, const UString& name, const UString& help, int64_t value);
+
+        // Inaccessible operations.
+        SignalMonitor() = delete;
+        SignalMonitor(const SignalMonitor&) = delete;
+        SignalMonitor& operator=(const SignalMonitor&) = delete;
+    };
+}
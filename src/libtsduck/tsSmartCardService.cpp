@@ -0,0 +1,349 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  Asynchronous PC/SC smartcard service.
+//
+//----------------------------------------------------------------------------
+
+#include "tsSmartCardService.h"
+#include "tsGuard.h"
+#include "tsGuardCondition.h"
+TSDUCK_SOURCE;
+
+#if !defined(TS_NO_PCSC)
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::pcsc::APDURequest::NPOS;
+const size_t ts::pcsc::SmartCardService::NPOS;
+const int ts::pcsc::SmartCardService::PRIORITY_HIGH;
+const int ts::pcsc::SmartCardService::PRIORITY_NORMAL;
+const int ts::pcsc::SmartCardService::PRIORITY_LOW;
+const size_t ts::pcsc::SmartCardService::MAX_RESPONSE_SIZE;
+#endif
+
+
+//----------------------------------------------------------------------------
+// APDU request.
+//----------------------------------------------------------------------------
+
+ts::pcsc::APDURequest::APDURequest(const ByteBlock& cmd, int prio, APDUHandlerInterface* hdl, size_t crd) :
+    command(cmd),
+    priority(prio),
+    handler(hdl),
+    card(crd),
+    status(SCARD_S_SUCCESS),
+    sw(0),
+    response(),
+    executed_by(NPOS),
+    _mutex(),
+    _completion(),
+    _completed(false),
+    _pending(false)
+{
+}
+
+bool ts::pcsc::APDURequest::completed() const
+{
+    Guard lock(_mutex);
+    return _completed;
+}
+
+void ts::pcsc::APDURequest::complete()
+{
+    GuardCondition lock(_mutex, _completion);
+    _pending = false;
+    _completed = true;
+    lock.signal();
+}
+
+bool ts::pcsc::APDURequest::waitCompletion(MilliSecond timeout)
+{
+    GuardCondition lock(_mutex, _completion);
+    while (!_completed && lock.waitCondition(timeout)) {
+    }
+    return _completed;
+}
+
+
+//----------------------------------------------------------------------------
+// Smartcard thread.
+//----------------------------------------------------------------------------
+
+ts::pcsc::SmartCardService::CardThread::CardThread(SmartCardService* service, size_t index, ::SCARDHANDLE handle, uint32_t protocol, const ThreadAttributes& attributes) :
+    Thread(attributes),
+    work_to_do(),
+    _service(service),
+    _index(index),
+    _handle(handle),
+    _protocol(protocol)
+{
+}
+
+ts::pcsc::SmartCardService::CardThread::~CardThread()
+{
+    waitForTermination();
+}
+
+void ts::pcsc::SmartCardService::CardThread::main()
+{
+    // Response buffer, allocated once for the life of the thread.
+    ByteBlock resp(MAX_RESPONSE_SIZE);
+
+    // Loop on requests until the service is stopped. The service mutex
+    // is not held while the APDU is transmitted to the smartcard.
+    APDURequestPtr req;
+    while (!(req = _service->nextRequest(_index, work_to_do)).isNull()) {
+        size_t resp_length = 0;
+        req->status = Transmit(_handle, _protocol, req->command.data(), req->command.size(), resp.data(), resp.size(), req->sw, resp_length);
+        req->response.copy(resp.data(), resp_length);
+        req->executed_by = _index;
+        if (req->status != SCARD_S_SUCCESS) {
+            _service->_report.debug(u"smartcard %d: PC/SC error 0x%X: %s", {_index, req->status, StrError(req->status)});
+        }
+        _service->completeRequest(req);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Smartcard service constructor and destructor.
+//----------------------------------------------------------------------------
+
+ts::pcsc::SmartCardService::SmartCardService(Report& report, const ThreadAttributes& attributes) :
+    _report(report),
+    _attributes(attributes),
+    _mutex(),
+    _stopped(false),
+    _queue(),
+    _threads()
+{
+}
+
+ts::pcsc::SmartCardService::~SmartCardService()
+{
+    stop();
+}
+
+
+//----------------------------------------------------------------------------
+// Add a smartcard to the service and start its thread.
+//----------------------------------------------------------------------------
+
+size_t ts::pcsc::SmartCardService::addCard(::SCARDHANDLE handle, uint32_t protocol)
+{
+    Guard lock(_mutex);
+
+    if (_stopped) {
+        _report.error(u"smartcard service is stopped");
+        return NPOS;
+    }
+
+    const size_t index = _threads.size();
+    CardThreadPtr thread(new CardThread(this, index, handle, protocol, _attributes));
+    if (!thread->start()) {
+        _report.error(u"cannot start smartcard thread");
+        return NPOS;
+    }
+
+    // The new thread checks the queue before waiting, already queued
+    // requests for any card may be executed by the new card.
+    _threads.push_back(thread);
+    return index;
+}
+
+
+//----------------------------------------------------------------------------
+// Get the number of smartcards and queued requests.
+//----------------------------------------------------------------------------
+
+size_t ts::pcsc::SmartCardService::cardCount() const
+{
+    Guard lock(_mutex);
+    return _threads.size();
+}
+
+size_t ts::pcsc::SmartCardService::pendingCount() const
+{
+    Guard lock(_mutex);
+    return _queue.size();
+}
+
+
+//----------------------------------------------------------------------------
+// Submit an APDU request.
+//----------------------------------------------------------------------------
+
+bool ts::pcsc::SmartCardService::submit(const APDURequestPtr& request)
+{
+    if (request.isNull() || request->command.empty()) {
+        _report.error(u"invalid empty APDU request");
+        return false;
+    }
+
+    Guard lock(_mutex);
+
+    if (_stopped) {
+        _report.error(u"smartcard service is stopped");
+        return false;
+    }
+    if (request->card != NPOS && request->card >= _threads.size()) {
+        _report.error(u"invalid smartcard index %d, only %d cards", {request->card, _threads.size()});
+        return false;
+    }
+
+    // Reset the request state. A request cannot be queued twice.
+    {
+        Guard rlock(request->_mutex);
+        if (request->_pending) {
+            _report.error(u"APDU request already submitted");
+            return false;
+        }
+        request->_pending = true;
+        request->_completed = false;
+    }
+    request->status = SCARD_S_SUCCESS;
+    request->sw = 0;
+    request->response.clear();
+    request->executed_by = NPOS;
+
+    _queue.insert(std::make_pair(request->priority, request));
+
+    // Wake up the target card or all cards when any card may serve the request.
+    // Busy threads will find the request when they come back to the queue.
+    if (request->card != NPOS) {
+        _threads[request->card]->work_to_do.signal();
+    }
+    else {
+        for (CardThreadVector::const_iterator it = _threads.begin(); it != _threads.end(); ++it) {
+            (*it)->work_to_do.signal();
+        }
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Wait for the next request for a card.
+//----------------------------------------------------------------------------
+
+ts::pcsc::APDURequestPtr ts::pcsc::SmartCardService::nextRequest(size_t card, Condition& work_to_do)
+{
+    GuardCondition lock(_mutex, work_to_do);
+
+    for (;;) {
+        if (_stopped) {
+            return APDURequestPtr();
+        }
+        // The queue is sorted by decreasing priority, the first matching request is the next one.
+        for (RequestQueue::iterator it = _queue.begin(); it != _queue.end(); ++it) {
+            if (it->second->card == NPOS || it->second->card == card) {
+                const APDURequestPtr req(it->second);
+                _queue.erase(it);
+                return req;
+            }
+        }
+        lock.waitCondition();
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Complete a request and notify its handler.
+//----------------------------------------------------------------------------
+
+void ts::pcsc::SmartCardService::completeRequest(const APDURequestPtr& request)
+{
+    // Notify the handler first so that a thread waiting for completion
+    // can safely delete the handler as soon as it is awaken.
+    if (request->handler != 0) {
+        request->handler->handleAPDUResponse(*this, request);
+    }
+    request->complete();
+}
+
+
+//----------------------------------------------------------------------------
+// Transmit an APDU and wait for the response.
+//----------------------------------------------------------------------------
+
+::LONG ts::pcsc::SmartCardService::transmit(const ByteBlock& command, ByteBlock& response, uint16_t& sw, int priority, size_t card)
+{
+    APDURequestPtr req(new APDURequest(command, priority, 0, card));
+    response.clear();
+    sw = 0;
+
+    if (!submit(req)) {
+        return SCARD_E_INVALID_PARAMETER;
+    }
+
+    req->waitCompletion();
+    response = req->response;
+    sw = req->sw;
+    return req->status;
+}
+
+
+//----------------------------------------------------------------------------
+// Stop the service.
+//----------------------------------------------------------------------------
+
+void ts::pcsc::SmartCardService::stop()
+{
+    // Notify all threads to terminate.
+    {
+        Guard lock(_mutex);
+        if (_stopped) {
+            return;
+        }
+        _stopped = true;
+        for (CardThreadVector::const_iterator it = _threads.begin(); it != _threads.end(); ++it) {
+            (*it)->work_to_do.signal();
+        }
+    }
+
+    // Wait for all threads to terminate. Requests being transmitted are completed.
+    for (CardThreadVector::const_iterator it = _threads.begin(); it != _threads.end(); ++it) {
+        (*it)->waitForTermination();
+    }
+
+    // Cancel all pending requests. The queue is swapped under the mutex
+    // so that the handlers are invoked without the mutex held.
+    RequestQueue pending;
+    {
+        Guard lock(_mutex);
+        pending.swap(_queue);
+        _threads.clear();
+    }
+    for (RequestQueue::const_iterator it = pending.begin(); it != pending.end(); ++it) {
+        it->second->status = SCARD_E_CANCELLED;
+        completeRequest(it->second);
+    }
+}
+
+#endif // TS_NO_PCSC
@@ -0,0 +1,308 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Asynchronous PC/SC smartcard service with prioritized APDU queue.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsPCSC.h"
+#include "tsThread.h"
+#include "tsMutex.h"
+#include "tsCondition.h"
+#include "tsSafePtr.h"
+
+#if !defined(TS_NO_PCSC)
+
+namespace ts {
+    namespace pcsc {
+
+        class SmartCardService;
+        class APDURequest;
+
+        //!
+        //! Safe pointer to an APDU request (thread-safe).
+        //!
+        typedef SafePtr<APDURequest, Mutex> APDURequestPtr;
+
+        //!
+        //! Abstract interface to receive the completion of asynchronous APDU requests.
+        //!
+        class TSDUCKDLL APDUHandlerInterface
+        {
+        public:
+            //!
+            //! This hook is invoked when an APDU request is completed.
+            //! It is invoked in the context of the smartcard thread which executed
+            //! the request (or the thread which stopped the service if the request
+            //! was cancelled). The handler shall return quickly to keep the card busy.
+            //! @param [in,out] service The smartcard service which completed the request.
+            //! @param [in] request The completed request.
+            //!
+            virtual void handleAPDUResponse(SmartCardService& service, const APDURequestPtr& request) = 0;
+
+            //!
+            //! Virtual destructor.
+            //!
+            virtual ~APDUHandlerInterface() {}
+        };
+
+        //!
+        //! An APDU request for an asynchronous smartcard service.
+        //!
+        //! The public input fields must be set before submitting the request.
+        //! The public output fields may be read only after completion, either
+        //! from APDUHandlerInterface::handleAPDUResponse() or after waitCompletion().
+        //!
+        class TSDUCKDLL APDURequest
+        {
+        public:
+            //!
+            //! Value of card index meaning "any card" or "no card".
+            //!
+            static const size_t NPOS = size_t(-1);
+
+            //!
+            //! Constructor.
+            //! @param [in] command APDU to send to the smartcard.
+            //! @param [in] priority Request priority, higher values are served first.
+            //! @param [in] handler Optional handler to notify at completion.
+            //! @param [in] card Index of the card to use or NPOS for any card in the service.
+            //!
+            APDURequest(const ByteBlock& command = ByteBlock(),
+                        int priority = 0,
+                        APDUHandlerInterface* handler = 0,
+                        size_t card = NPOS);
+
+            // Input fields.
+            ByteBlock             command;    //!< APDU to send to the smartcard.
+            int                   priority;   //!< Request priority, higher values are served first.
+            APDUHandlerInterface* handler;    //!< Optional handler to notify at completion.
+            size_t                card;       //!< Index of the card to use or NPOS for any card.
+
+            // Output fields.
+            ::LONG                status;     //!< PC/SC status of the transmission.
+            uint16_t              sw;         //!< Returned status word (SW).
+            ByteBlock             response;   //!< APDU response, without status word.
+            size_t                executed_by; //!< Index of the card which executed the request (NPOS if cancelled).
+
+            //!
+            //! Check if the request is completed (successfully or not).
+            //! @return True if the request is completed.
+            //!
+            bool completed() const;
+
+            //!
+            //! Check if the request was successfully executed by a smartcard.
+            //! @return True if the request is completed with PC/SC success status.
+            //! The status word @a sw shall still be checked by the application.
+            //!
+            bool success() const { return completed() && status == SCARD_S_SUCCESS; }
+
+            //!
+            //! Wait for the completion of the request.
+            //! Only one thread should wait for a given request.
+            //! @param [in] timeout Maximum number of milliseconds to wait.
+            //! @return True if the request is completed, false on timeout.
+            //!
+            bool waitCompletion(MilliSecond timeout = Infinite);
+
+        private:
+            friend class SmartCardService;
+            mutable Mutex _mutex;      // Protect completion flag.
+            Condition     _completion; // Signaled on completion.
+            bool          _completed;  // Request completed.
+            bool          _pending;    // Request is submitted and not yet completed.
+
+            // Mark the request as completed and wake up the waiting thread.
+            void complete();
+
+            // Inaccessible operations.
+            APDURequest(const APDURequest&) = delete;
+            APDURequest& operator=(const APDURequest&) = delete;
+        };
+
+        //!
+        //! Asynchronous PC/SC smartcard service.
+        //!
+        //! The service manages one or more smartcards, typically in distinct readers.
+        //! Each smartcard is served by a dedicated thread. APDU requests are queued
+        //! with a priority: requests with a higher priority are always transmitted
+        //! first, requests with the same priority are transmitted in their order
+        //! of submission. A request may be bound to a specific card or executed
+        //! by the first available card.
+        //!
+        //! A descrambler using setECMThreads() with several threads can submit its
+        //! ECM's from decipherECM() and wait for completion. Using a higher priority
+        //! for ECM's of the current crypto-period keeps the ECM-to-CW latency low,
+        //! even when the same cards serve many services.
+        //!
+        //! The PC/SC connections to the smartcards (SCardConnect()) are managed by the
+        //! application. They must remain valid until the service is stopped.
+        //!
+        class TSDUCKDLL SmartCardService
+        {
+        public:
+            //!
+            //! Value of card index meaning "any card" or "no card".
+            //!
+            static const size_t NPOS = APDURequest::NPOS;
+
+            //!
+            //! Priority of a request for the current crypto-period.
+            //!
+            static const int PRIORITY_HIGH = 100;
+            //!
+            //! Default priority of a request.
+            //!
+            static const int PRIORITY_NORMAL = 0;
+            //!
+            //! Priority of a background request (next crypto-period, EMM, etc.)
+            //!
+            static const int PRIORITY_LOW = -100;
+
+            //!
+            //! Maximum size of an APDU response (extended APDU, including status word).
+            //!
+            static const size_t MAX_RESPONSE_SIZE = 65538;
+
+            //!
+            //! Constructor.
+            //! @param [in,out] report Where to report errors.
+            //! @param [in] attributes Attributes of the smartcard threads.
+            //!
+            explicit SmartCardService(Report& report = CERR, const ThreadAttributes& attributes = ThreadAttributes());
+
+            //!
+            //! Destructor.
+            //! The service is stopped, pending requests are cancelled.
+            //!
+            ~SmartCardService();
+
+            //!
+            //! Add a smartcard to the service and start its thread.
+            //! @param [in] handle PC/SC handle, as returned by SCardConnect().
+            //! @param [in] protocol Protocol id, as returned by SCardConnect().
+            //! @return Index of the card in the service or NPOS on error.
+            //!
+            size_t addCard(::SCARDHANDLE handle, uint32_t protocol);
+
+            //!
+            //! Get the number of smartcards in the service.
+            //! @return The number of smartcards in the service.
+            //!
+            size_t cardCount() const;
+
+            //!
+            //! Get the number of requests which are queued and not yet executed.
+            //! @return The number of queued requests.
+            //!
+            size_t pendingCount() const;
+
+            //!
+            //! Submit an APDU request.
+            //! The request is executed asynchronously. The application is notified through the
+            //! handler of the request, if there is one, or by waiting with APDURequest::waitCompletion().
+            //! @param [in] request The request to submit. It must not be already queued.
+            //! @return True on success, false if the request is invalid or the service is stopped.
+            //!
+            bool submit(const APDURequestPtr& request);
+
+            //!
+            //! Transmit an APDU and wait for the response (synchronous convenience method).
+            //! @param [in] command APDU to send to the smartcard.
+            //! @param [out] response APDU response, without status word.
+            //! @param [out] sw Returned status word (SW).
+            //! @param [in] priority Request priority, higher values are served first.
+            //! @param [in] card Index of the card to use or NPOS for any card.
+            //! @return A PC/SC status.
+            //!
+            ::LONG transmit(const ByteBlock& command,
+                            ByteBlock& response,
+                            uint16_t& sw,
+                            int priority = PRIORITY_NORMAL,
+                            size_t card = NPOS);
+
+            //!
+            //! Stop the service.
+            //! Pending requests are completed with status SCARD_E_CANCELLED.
+            //! Requests which are being transmitted are completed normally.
+            //! All smartcard threads are terminated. The service cannot be restarted.
+            //!
+            void stop();
+
+        private:
+            // Thread serving one smartcard.
+            class CardThread: public Thread
+            {
+            public:
+                CardThread(SmartCardService* service, size_t index, ::SCARDHANDLE handle, uint32_t protocol, const ThreadAttributes& attributes);
+                virtual ~CardThread();
+                Condition work_to_do;  // Signaled when a request is queued for this card or the service is stopped.
+            private:
+                SmartCardService* _service;
+                size_t            _index;
+                ::SCARDHANDLE     _handle;
+                uint32_t          _protocol;
+                virtual void main() override;
+
+                // Inaccessible operations.
+                CardThread() = delete;
+                CardThread(const CardThread&) = delete;
+                CardThread& operator=(const CardThread&) = delete;
+            };
+            typedef SafePtr<CardThread, NullMutex> CardThreadPtr;
+            typedef std::vector<CardThreadPtr> CardThreadVector;
+
+            // Queue of requests, highest priority first. In a multimap, elements
+            // with identical keys are kept in their order of insertion.
+            typedef std::multimap<int, APDURequestPtr, std::greater<int>> RequestQueue;
+
+            Report&          _report;      // Where to report errors.
+            ThreadAttributes _attributes;  // Attributes of card threads.
+            mutable Mutex    _mutex;       // Exclusive access to the service state.
+            bool             _stopped;     // The service is stopped.
+            RequestQueue     _queue;       // Pending requests.
+            CardThreadVector _threads;     // One thread per smartcard.
+
+            // Complete a request and notify its handler. Must be called without the mutex held.
+            void completeRequest(const APDURequestPtr& request);
+
+            // Wait for the next request for a card. Return a null pointer when the service is stopped.
+            APDURequestPtr nextRequest(size_t card, Condition& work_to_do);
+
+            // Inaccessible operations.
+            SmartCardService(const SmartCardService&) = delete;
+            SmartCardService& operator=(const SmartCardService&) = delete;
+        };
+    }
+}
+
+#endif // TS_NO_PCSC
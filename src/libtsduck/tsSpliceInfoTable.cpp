@@ -158,43 +158,59 @@ void ts::SpliceInfoTable::DisplaySection(TablesDisplay& display, const ts::Secti
 
 
 //----------------------------------------------------------------------------
-// A static method to extract a SpliceInsert command from a section.
+// Locate the splice command in a binary section.
 //----------------------------------------------------------------------------
 
-bool ts::SpliceInfoTable::ExtractSpliceInsert(SpliceInsert& command, const Section& section)
+bool ts::SpliceInfoTable::LocateCommand(uint8_t& cmd_type, const uint8_t*& cmd, size_t& cmd_length, uint64_t& pts_adjustment, const uint8_t* section, size_t size)
 {
-    // Payload layout: fixed part (11 bytes), variable part, CRC2 (4 bytes).
-    const uint8_t* data = section.payload();
-    size_t size = section.payloadSize();
-
-    if (!section.isValid() || section.tableId() != MY_TID || size < 15) {
+    // Section layout: header (3 bytes), fixed part (11 bytes), variable part, CRC32 (4 bytes).
+    if (section == 0 || size < 18 || section[0] != MY_TID || size != 3 + size_t(GetUInt16(section + 1) & 0x0FFF)) {
         // Not a valid section.
         return false;
     }
 
     // Check CRC32.
-    if (CRC32(section.content(), section.size() - 4) != GetUInt32(data + size - 4)) {
+    if (CRC32(section, size - 4) != GetUInt32(section + size - 4)) {
         // Invalid CRC in section.
         return false;
     }
-    size -= 4;
 
     // Fixed part
+    const uint8_t* data = section + 3;
     if ((data[1] & 0x80) != 0) {
         // Encrypted command, cannot get it.
         return false;
     }
 
     // PTS adjustment for all time fields.
-    const uint64_t pts_adjustment = (uint64_t(data[1] & 0x01) << 32) | uint64_t(GetUInt32(data + 2));
+    pts_adjustment = (uint64_t(data[1] & 0x01) << 32) | uint64_t(GetUInt32(data + 2));
 
     // Locate splice command.
-    size_t cmd_length = GetUInt16(data + 8) & 0x0FFF;
-    const uint8_t cmd_type = data[10];
-    data += 11; size -= 11;
+    cmd_length = GetUInt16(data + 8) & 0x0FFF;
+    cmd_type = data[10];
+    cmd = data + 11;
+    return cmd_length <= size - 18;
+}
+
+
+//----------------------------------------------------------------------------
+// A static method to extract a SpliceInsert command from a section.
+//----------------------------------------------------------------------------
+
+bool ts::SpliceInfoTable::ExtractSpliceInsert(SpliceInsert& command, const Section& section)
+{
+    return section.isValid() && ExtractSpliceInsert(command, section.content(), section.size());
+}
+
+bool ts::SpliceInfoTable::ExtractSpliceInsert(SpliceInsert& command, const uint8_t* section, size_t size)
+{
+    uint8_t cmd_type = 0;
+    const uint8_t* cmd = 0;
+    size_t cmd_length = 0;
+    uint64_t pts_adjustment = 0;
 
-    if (cmd_length > size || cmd_type != SPLICE_INSERT || command.deserialize(data, cmd_length) < 0) {
-        // Invalid length or not a valid SpliceInsert
+    if (!LocateCommand(cmd_type, cmd, cmd_length, pts_adjustment, section, size) || cmd_type != SPLICE_INSERT || command.deserialize(cmd, cmd_length) < 0) {
+        // Invalid section or not a valid SpliceInsert
         return false;
     }
 
@@ -202,3 +218,27 @@ bool ts::SpliceInfoTable::ExtractSpliceInsert(SpliceInsert& command, const Secti
     command.adjustPTS(pts_adjustment);
     return true;
 }
+
+
+//----------------------------------------------------------------------------
+// A static method to extract the time of a time_signal command.
+//----------------------------------------------------------------------------
+
+bool ts::SpliceInfoTable::ExtractTimeSignal(uint64_t& pts, const uint8_t* section, size_t size)
+{
+    uint8_t cmd_type = 0;
+    const uint8_t* cmd = 0;
+    size_t cmd_length = 0;
+    uint64_t pts_adjustment = 0;
+
+    if (!LocateCommand(cmd_type, cmd, cmd_length, pts_adjustment, section, size) || cmd_type != SPLICE_TIME_SIGNAL || !SpliceInsert::GetSpliceTime(pts, cmd, cmd_length)) {
+        // Invalid section or not a valid time_signal
+        return false;
+    }
+
+    // Apply the PTS adjustment on a specified time.
+    if (pts <= PTS_DTS_MASK) {
+        pts = (pts + pts_adjustment) & PTS_DTS_MASK;
+    }
+    return true;
+}
@@ -62,5 +62,32 @@ namespace ts {
         //! @return True on success, false on error.
         //!
         static bool ExtractSpliceInsert(SpliceInsert& command, const Section& section);
+
+        //!
+        //! A static method to extract a SpliceInsert command from the binary content of a section.
+        //! This is a fast path for sections which are received as a SectionView,
+        //! without building a Section object or a table.
+        //! @param [out] command Extracted SpliceInsert commmand. The PTS time are adjusted when
+        //! necessary using the pts_adjustment field of the section.
+        //! @param [in] section Address of the complete binary section.
+        //! @param [in] size Size in bytes of the section.
+        //! @return True on success, false on error.
+        //!
+        static bool ExtractSpliceInsert(SpliceInsert& command, const uint8_t* section, size_t size);
+
+        //!
+        //! A static method to extract the time of a time_signal command from the binary content of a section.
+        //! The splice descriptors, which describe the meaning of the signal, are not analyzed.
+        //! @param [out] pts The PTS value of the time signal, adjusted using the pts_adjustment field
+        //! of the section. INVALID_PTS when the time signal has no time, meaning "immediate".
+        //! @param [in] section Address of the complete binary section.
+        //! @param [in] size Size in bytes of the section.
+        //! @return True on success, false on error or if the command is not a time_signal.
+        //!
+        static bool ExtractTimeSignal(uint64_t& pts, const uint8_t* section, size_t size);
+
+    private:
+        // Locate the splice command in a binary section, after checking the CRC32 and encryption.
+        static bool LocateCommand(uint8_t& cmd_type, const uint8_t*& cmd, size_t& cmd_length, uint64_t& pts_adjustment, const uint8_t* section, size_t size);
     };
 }
@@ -102,8 +102,13 @@ namespace ts {
         //!
         void serialize(ByteBlock& data) const;
 
-    private:
-        // Get a splice_time structure, skip the data area.
+        //!
+        //! Decode a splice_time structure.
+        //! @param [out] pts The PTS value or INVALID_PTS when no time is specified.
+        //! @param [in,out] data Address of the splice_time structure. Updated after it.
+        //! @param [in,out] size Remaining size in bytes at @a data. Updated after the splice_time.
+        //! @return True on success, false if the structure is invalid or truncated.
+        //!
         static bool GetSpliceTime(uint64_t& pts, const uint8_t*& data, size_t& size);
     };
 }
@@ -0,0 +1,70 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  An encapsulation of Report which serializes messages from several threads.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsReport.h"
+#include "tsMutex.h"
+
+namespace ts {
+    //!
+    //! An encapsulation of Report which serializes messages from several threads.
+    //!
+    //! This class encapsulates another instance of Report which is not thread-safe
+    //! (typically an Args instance). All messages are passed to the encapsulated
+    //! report under the protection of a mutex. Unlike AsyncReport, the messages
+    //! are synchronously delivered and never dropped.
+    //!
+    class TSDUCKDLL SyncReport : public Report
+    {
+    public:
+        //!
+        //! Constructor.
+        //! @param [in] report The actual object which is used to report.
+        //!
+        explicit SyncReport(Report& report);
+
+    protected:
+        // Inherited methods.
+        virtual void writeLog(int severity, const UString& msg) override;
+
+    private:
+        Report& _report;  //!< The actual object which is used to report
+        Mutex   _mutex;   //!< Serialize access to the report
+
+        // Inaccessible methods.
+        SyncReport() = delete;
+        SyncReport(const SyncReport&) = delete;
+        SyncReport& operator=(const SyncReport&) = delete;
+    };
+}
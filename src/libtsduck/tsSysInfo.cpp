@@ -35,6 +35,17 @@
 #include <sys/param.h>
 #include <sys/sysctl.h>
 #endif
+#if (defined(TS_I386) || defined(TS_X86_64)) && defined(TS_MSC)
+#include <intrin.h>
+#include <immintrin.h>
+#define TS_CPUID 1
+#elif (defined(TS_I386) || defined(TS_X86_64)) && defined(TS_GCC)
+#include <cpuid.h>
+#define TS_CPUID 1
+#elif (defined(TS_ARM) || defined(TS_ARM64)) && defined(TS_LINUX)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
 TSDUCK_SOURCE;
 
 // Define singleton instance
@@ -78,7 +89,17 @@ ts::SysInfo::SysInfo() :
     _systemVersion(),
     _systemName(),
     _hostName(),
-    _memoryPageSize(0)
+    _memoryPageSize(0),
+    _cpuSSSE3(false),
+    _cpuSSE41(false),
+    _cpuSSE42(false),
+    _cpuAVX2(false),
+    _cpuAVX512(false),
+    _cpuPCLMUL(false),
+    _cpuAES(false),
+    _cpuSHA1(false),
+    _cpuSHA256(false),
+    _cpuNEON(false)
 {
     //
     // Get operating system name and version.
@@ -228,4 +249,139 @@ ts::SysInfo::SysInfo() :
     }
 
 #endif
+
+    //
+    // Get CPU features.
+    //
+    detectCPUFeatures();
+}
+
+
+//----------------------------------------------------------------------------
+// Detect the CPU features.
+//----------------------------------------------------------------------------
+
+void ts::SysInfo::detectCPUFeatures()
+{
+#if defined(TS_CPUID)
+
+    // Get CPUID leaves 1 and 7 and the extended control register XCR0.
+    uint32_t ecx1 = 0, ebx7 = 0;
+    uint64_t xcr0 = 0;
+#if defined(TS_MSC)
+    int regs[4];
+    ::__cpuid(regs, 0);
+    const int maxLeaf = regs[0];
+    ::__cpuid(regs, 1);
+    ecx1 = uint32_t(regs[2]);
+    if (maxLeaf >= 7) {
+        ::__cpuidex(regs, 7, 0);
+        ebx7 = uint32_t(regs[1]);
+    }
+    if ((ecx1 & (1UL << 27)) != 0) {
+        xcr0 = uint64_t(::_xgetbv(0));
+    }
+#else
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    const unsigned int maxLeaf = ::__get_cpuid_max(0, 0);
+    if (maxLeaf >= 1) {
+        ::__get_cpuid(1, &eax, &ebx, &ecx, &edx);
+        ecx1 = ecx;
+    }
+    if (maxLeaf >= 7) {
+        __cpuid_count(7, 0, eax, ebx, ecx, edx);
+        ebx7 = ebx;
+    }
+    if ((ecx1 & (1UL << 27)) != 0) {
+        // XGETBV is allowed only when the OS has enabled it (OSXSAVE).
+        uint32_t lo = 0, hi = 0;
+        __asm__ __volatile__ ("xgetbv" : "=a" (lo), "=d" (hi) : "c" (0));
+        xcr0 = (uint64_t(hi) << 32) | lo;
+    }
+#endif
+
+    // Leaf 1, ECX: bit 1 = PCLMULQDQ, bit 9 = SSSE3, bit 19 = SSE4.1, bit 20 = SSE4.2, bit 25 = AES, bit 28 = AVX.
+    // Leaf 7, EBX: bit 5 = AVX2, bit 16 = AVX-512F, bit 29 = SHA, bit 30 = AVX-512BW.
+    // XCR0: bits 1-2 = SSE and AVX states, bits 5-7 = AVX-512 states, must be saved by the OS.
+    const bool avxState = (ecx1 & (1UL << 28)) != 0 && (xcr0 & 0x06) == 0x06;
+    const bool avx512State = avxState && (xcr0 & 0xE0) == 0xE0;
+    _cpuPCLMUL = (ecx1 & (1UL << 1)) != 0;
+    _cpuSSSE3 = (ecx1 & (1UL << 9)) != 0;
+    _cpuSSE41 = (ecx1 & (1UL << 19)) != 0;
+    _cpuSSE42 = (ecx1 & (1UL << 20)) != 0;
+    _cpuAES = (ecx1 & (1UL << 25)) != 0;
+    _cpuAVX2 = avxState && (ebx7 & (1UL << 5)) != 0;
+    _cpuAVX512 = avx512State && (ebx7 & (1UL << 16)) != 0 && (ebx7 & (1UL << 30)) != 0;
+    _cpuSHA1 = _cpuSHA256 = (ebx7 & (1UL << 29)) != 0;
+
+#elif defined(TS_ARM64) && defined(TS_LINUX)
+
+    const unsigned long hwcap = ::getauxval(AT_HWCAP);
+    _cpuNEON = (hwcap & HWCAP_ASIMD) != 0;
+    _cpuPCLMUL = (hwcap & HWCAP_PMULL) != 0;
+    _cpuAES = (hwcap & HWCAP_AES) != 0;
+    _cpuSHA1 = (hwcap & HWCAP_SHA1) != 0;
+    _cpuSHA256 = (hwcap & HWCAP_SHA2) != 0;
+
+#elif defined(TS_ARM) && defined(TS_LINUX)
+
+    // On 32-bit ARM, the crypto extensions are reported in the second set of capabilities.
+    const unsigned long hwcap = ::getauxval(AT_HWCAP);
+    _cpuNEON = (hwcap & HWCAP_NEON) != 0;
+#if defined(AT_HWCAP2) && defined(HWCAP2_AES)
+    const unsigned long hwcap2 = ::getauxval(AT_HWCAP2);
+    _cpuPCLMUL = (hwcap2 & HWCAP2_PMULL) != 0;
+    _cpuAES = (hwcap2 & HWCAP2_AES) != 0;
+    _cpuSHA1 = (hwcap2 & HWCAP2_SHA1) != 0;
+    _cpuSHA256 = (hwcap2 & HWCAP2_SHA2) != 0;
+#endif
+
+#elif defined(TS_ARM64)
+
+    // NEON is mandatory on ARM64, the other features cannot be checked here.
+    _cpuNEON = true;
+
+#endif
+}
+
+
+//----------------------------------------------------------------------------
+// Get the CPU features.
+//----------------------------------------------------------------------------
+
+void ts::SysInfo::getCPUFeatures(std::map<UString, bool>& features) const
+{
+    features.clear();
+#if defined(TS_I386) || defined(TS_X86_64)
+    features[u"ssse3"] = _cpuSSSE3;
+    features[u"sse4.1"] = _cpuSSE41;
+    features[u"sse4.2"] = _cpuSSE42;
+    features[u"avx2"] = _cpuAVX2;
+    features[u"avx512"] = _cpuAVX512;
+    features[u"pclmul"] = _cpuPCLMUL;
+    features[u"aes"] = _cpuAES;
+    features[u"sha"] = _cpuSHA1 && _cpuSHA256;
+#elif defined(TS_ARM) || defined(TS_ARM64)
+    features[u"neon"] = _cpuNEON;
+    features[u"pmull"] = _cpuPCLMUL;
+    features[u"aes"] = _cpuAES;
+    features[u"sha1"] = _cpuSHA1;
+    features[u"sha2"] = _cpuSHA256;
+#endif
+}
+
+ts::UString ts::SysInfo::cpuFeatures() const
+{
+    std::map<UString, bool> features;
+    getCPUFeatures(features);
+    UString list;
+    for (std::map<UString, bool>::const_iterator it = features.begin(); it != features.end(); ++it) {
+        if (it->second) {
+            if (!list.empty()) {
+                list.append(u' ');
+            }
+            list.append(it->first);
+        }
+    }
+    return list;
 }
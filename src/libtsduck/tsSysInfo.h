@@ -112,6 +112,76 @@ namespace ts {
         //!
         size_t memoryPageSize() const { return _memoryPageSize; }
 
+        //!
+        //! Check if the CPU supports the SSSE3 instructions (Intel).
+        //! @return True if the CPU supports SSSE3.
+        //!
+        bool cpuHasSSSE3() const { return _cpuSSSE3; }
+        //!
+        //! Check if the CPU supports the SSE 4.1 instructions (Intel).
+        //! @return True if the CPU supports SSE 4.1.
+        //!
+        bool cpuHasSSE41() const { return _cpuSSE41; }
+        //!
+        //! Check if the CPU supports the SSE 4.2 instructions (Intel).
+        //! @return True if the CPU supports SSE 4.2.
+        //!
+        bool cpuHasSSE42() const { return _cpuSSE42; }
+        //!
+        //! Check if the CPU supports the AVX2 instructions and the operating system saves the AVX state (Intel).
+        //! @return True if AVX2 can be used.
+        //!
+        bool cpuHasAVX2() const { return _cpuAVX2; }
+        //!
+        //! Check if the CPU supports the AVX-512 F and BW instructions and the operating system saves the AVX-512 state (Intel).
+        //! @return True if AVX-512 F and BW can be used.
+        //!
+        bool cpuHasAVX512() const { return _cpuAVX512; }
+        //!
+        //! Check if the CPU supports the carry-less multiplication instructions.
+        //! This is PCLMULQDQ on Intel and the 64-bit PMULL on ARM.
+        //! @return True if the CPU supports carry-less multiplication.
+        //!
+        bool cpuHasPCLMUL() const { return _cpuPCLMUL; }
+        //!
+        //! Check if the CPU supports the AES instructions (AES-NI on Intel, ARMv8 crypto extension on ARM).
+        //! @return True if the CPU supports the AES instructions.
+        //!
+        bool cpuHasAES() const { return _cpuAES; }
+        //!
+        //! Check if the CPU supports the SHA-1 instructions (SHA extensions on Intel, ARMv8 crypto extension on ARM).
+        //! @return True if the CPU supports the SHA-1 instructions.
+        //!
+        bool cpuHasSHA1() const { return _cpuSHA1; }
+        //!
+        //! Check if the CPU supports the SHA-256 instructions (SHA extensions on Intel, ARMv8 crypto extension on ARM).
+        //! @return True if the CPU supports the SHA-256 instructions.
+        //!
+        bool cpuHasSHA256() const { return _cpuSHA256; }
+        //!
+        //! Check if the CPU supports the NEON (Advanced SIMD) instructions (ARM).
+        //! @return True if the CPU supports NEON.
+        //!
+        bool cpuHasNEON() const { return _cpuNEON; }
+        //!
+        //! Check if the CPU supports the PMULL instructions (ARM).
+        //! Same as cpuHasPCLMUL(), provided for readability in ARM-specific code.
+        //! @return True if the CPU supports PMULL.
+        //!
+        bool cpuHasPMULL() const { return _cpuPCLMUL; }
+        //!
+        //! Get the list of CPU features which were detected on the current system.
+        //! @return A space-separated list of feature names, in lower case, for instance "aes avx2 pclmul sse4.2".
+        //! Only the features which are checked by this class are listed.
+        //!
+        UString cpuFeatures() const;
+        //!
+        //! Get the support status of all CPU features which are checked on the current architecture.
+        //! @param [out] features A map of all feature names which are relevant to this
+        //! CPU architecture, indexed by name, with their support status as value.
+        //!
+        void getCPUFeatures(std::map<UString, bool>& features) const;
+
     private:
         bool    _isLinux;
         bool    _isFedora;
@@ -126,5 +196,76 @@ namespace ts {
         UString _systemName;
         UString _hostName;
         size_t  _memoryPageSize;
+        bool    _cpuSSSE3;
+        bool    _cpuSSE41;
+        bool    _cpuSSE42;
+        bool    _cpuAVX2;
+        bool    _cpuAVX512;
+        bool    _cpuPCLMUL;
+        bool    _cpuAES;
+        bool    _cpuSHA1;
+        bool    _cpuSHA256;
+        bool    _cpuNEON;
+
+        // Detect the CPU features, called from the constructor.
+        void detectCPUFeatures();
+    };
+
+    //!
+    //! Selection of an implementation among CPU-specific variants of a function.
+    //!
+    //! A CPUDispatch instance starts with a generic implementation and successively
+    //! considers CPU-specific variants, in order of preference. The first variant
+    //! which is supported by the CPU is selected. The intended usage is a static
+    //! function pointer which is resolved once, on first use:
+    //! @code
+    //! typedef void (*ScanFunc)(const uint8_t*, size_t);
+    //! static const ScanFunc scan = ts::CPUDispatch<ScanFunc>(ScanGeneric)
+    //!     .prefer(&ts::SysInfo::cpuHasAVX2, ScanAVX2)
+    //!     .prefer(&ts::SysInfo::cpuHasSSE42, ScanSSE42);
+    //! @endcode
+    //! @tparam FUNC A function pointer type (or any copyable callable type).
+    //!
+    template <typename FUNC>
+    class CPUDispatch
+    {
+    public:
+        //!
+        //! Pointer to a SysInfo method which checks a CPU feature.
+        //!
+        typedef bool (SysInfo::*Feature)() const;
+        //!
+        //! Constructor.
+        //! @param [in] generic Generic implementation, used when no CPU-specific variant is supported.
+        //!
+        explicit CPUDispatch(FUNC generic) : _func(generic), _selected(false) {}
+        //!
+        //! Consider a CPU-specific variant.
+        //! Ignored if a previous variant was already selected.
+        //! @param [in] feature SysInfo method checking the required CPU feature.
+        //! @param [in] func The CPU-specific variant, used when @a feature is supported.
+        //! @return A reference to this object.
+        //!
+        CPUDispatch& prefer(Feature feature, FUNC func)
+        {
+            if (!_selected && (SysInfo::Instance()->*feature)()) {
+                _func = func;
+                _selected = true;
+            }
+            return *this;
+        }
+        //!
+        //! Get the selected implementation.
+        //! @return The selected implementation.
+        //!
+        FUNC function() const { return _func; }
+        //!
+        //! Conversion to the selected implementation.
+        //! @return The selected implementation.
+        //!
+        operator FUNC() const { return _func; }
+    private:
+        FUNC _func;
+        bool _selected;
     };
 }
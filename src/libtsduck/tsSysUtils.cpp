@@ -323,6 +323,20 @@ bool ts::IsPrivilegedUser()
 }
 
 
+//----------------------------------------------------------------------------
+// Lock all current and future memory pages of the process.
+//----------------------------------------------------------------------------
+
+ts::ErrorCode ts::LockProcessMemory()
+{
+#if defined(TS_WINDOWS)
+    return ERROR_CALL_NOT_IMPLEMENTED;
+#else
+    return ::mlockall(MCL_CURRENT | MCL_FUTURE) < 0 ? LastErrorCode() : SYS_SUCCESS;
+#endif
+}
+
+
 //----------------------------------------------------------------------------
 // Create a directory
 //----------------------------------------------------------------------------
@@ -220,6 +220,17 @@ namespace ts {
     //!
     TSDUCKDLL bool IsPrivilegedUser();
 
+    //!
+    //! Lock all current and future memory pages of the process in physical memory.
+    //! The memory which is later allocated or mapped is also locked and is physically
+    //! allocated when mapped. This avoids page faults in time-critical processing.
+    //! On UNIX systems, this may require privileges (root or @c CAP_IPC_LOCK on Linux)
+    //! or a large enough @c RLIMIT_MEMLOCK resource limit. On Windows, this operation
+    //! is not supported and an error is returned.
+    //! @return A system-specific error code (SYS_SUCCESS on success).
+    //!
+    TSDUCKDLL ErrorCode LockProcessMemory();
+
     //!
     //! Create a directory
     //! @param [in] path A directory path.
@@ -36,6 +36,12 @@
 #include "tsIntegerUtils.h"
 #include "tsSysUtils.h"
 #include "tsTime.h"
+#if defined(TS_LINUX)
+#include <dirent.h>
+#include <unistd.h>
+#include <fstream>
+#include <sstream>
+#endif
 TSDUCK_SOURCE;
 
 // Stack size for the monitor thread
@@ -83,9 +89,10 @@ ts::UString ts::SystemMonitor::MonPrefix(const ts::Time& date)
 // Constructor
 //----------------------------------------------------------------------------
 
-ts::SystemMonitor::SystemMonitor(Report* report) :
-    Thread(ThreadAttributes().setPriority(ThreadAttributes::GetMinimumPriority()).setStackSize(MONITOR_STACK_SIZE)),
+ts::SystemMonitor::SystemMonitor(Report* report, int thread_cpu_threshold) :
+    Thread(ThreadAttributes().setPriority(ThreadAttributes::GetMinimumPriority()).setStackSize(MONITOR_STACK_SIZE).setName(u"monitor")),
     _report(report),
+    _cpu_threshold(thread_cpu_threshold),
     _mutex(),
     _wake_up(),
     _terminate(false)
@@ -110,6 +117,110 @@ ts::SystemMonitor::~SystemMonitor()
 }
 
 
+//----------------------------------------------------------------------------
+// Get the CPU time of all threads in the process.
+//----------------------------------------------------------------------------
+
+bool ts::SystemMonitor::GetThreadMetrics(ThreadMetricsMap& threads)
+{
+    threads.clear();
+
+#if defined(TS_LINUX)
+
+    // Each thread is described in /proc/self/task/<tid>/stat.
+    ::DIR* dir = ::opendir("/proc/self/task");
+    if (dir == 0) {
+        return false;
+    }
+
+    // Clock ticks per second, the unit of utime and stime.
+    static const long ticks_per_sec = ::sysconf(_SC_CLK_TCK);
+
+    for (const ::dirent* entry = 0; (entry = ::readdir(dir)) != 0; ) {
+        const int tid = ::atoi(entry->d_name);
+        if (tid <= 0) {
+            continue;
+        }
+        std::ifstream file(std::string("/proc/self/task/") + entry->d_name + "/stat");
+        std::string line;
+        if (!std::getline(file, line)) {
+            continue;  // thread has terminated
+        }
+
+        // The thread name is between the first '(' and the last ')', it may contain spaces.
+        const size_t open = line.find('(');
+        const size_t close = line.rfind(')');
+        if (open == std::string::npos || close == std::string::npos || close < open) {
+            continue;
+        }
+
+        // After the name, utime and stime are the 12th and 13th fields (fields 14 and 15 of the line).
+        std::istringstream fields(line.substr(close + 1));
+        std::string field;
+        unsigned long long utime = 0;
+        unsigned long long stime = 0;
+        for (int i = 0; i < 11; ++i) {
+            fields >> field;
+        }
+        if (!(fields >> utime >> stime)) {
+            continue;
+        }
+
+        ThreadMetrics& th(threads[tid]);
+        th.name = UString::FromUTF8(line.substr(open + 1, close - open - 1));
+        th.cpu_time = ticks_per_sec <= 0 ? 0 : MilliSecond((utime + stime) * MilliSecPerSec / ticks_per_sec);
+    }
+
+    ::closedir(dir);
+    return true;
+
+#else
+    // Per-thread accounting not implemented on this system.
+    return false;
+#endif
+}
+
+
+//----------------------------------------------------------------------------
+// Report the CPU load of all threads during an interval.
+//----------------------------------------------------------------------------
+
+void ts::SystemMonitor::reportThreads(const ThreadMetricsMap& previous, const ThreadMetricsMap& current, MilliSecond duration, const UString& prefix)
+{
+    // Count name occurences to distinguish threads with the same name.
+    std::map<UString, int> name_count;
+    for (ThreadMetricsMap::const_iterator it = current.begin(); it != current.end(); ++it) {
+        name_count[it->second.name]++;
+    }
+
+    // Collect the threads which used some CPU during the interval, sorted by decreasing CPU time.
+    std::multimap<MilliSecond, UString, std::greater<MilliSecond>> loads;
+    for (ThreadMetricsMap::const_iterator it = current.begin(); it != current.end(); ++it) {
+        const ThreadMetricsMap::const_iterator prev(previous.find(it->first));
+        const MilliSecond cpu = it->second.cpu_time - (prev == previous.end() ? 0 : prev->second.cpu_time);
+        if (cpu > 0) {
+            UString name(it->second.name);
+            if (name_count[name] > 1) {
+                name += UString::Format(u"/%d", {it->first});
+            }
+            loads.insert(std::make_pair(cpu, name));
+        }
+    }
+    if (loads.empty() || duration <= 0) {
+        return;
+    }
+
+    UString message(prefix + u"threads:");
+    for (auto it = loads.begin(); it != loads.end(); ++it) {
+        message += UString::Format(u" %s:%s", {it->second, UString::Percentage(it->first, duration)});
+        if (it->first * 100 > duration * _cpu_threshold) {
+            _report->warning(u"%sthread %s uses %s of one CPU", {prefix, it->second, UString::Percentage(it->first, duration)});
+        }
+    }
+    _report->info(message);
+}
+
+
 //----------------------------------------------------------------------------
 // Thread main code. Inherited from Thread
 //----------------------------------------------------------------------------
@@ -124,6 +235,8 @@ void ts::SystemMonitor::main()
     Time last_time(start_time);                 // Last report time
     Time vsize_uptime(start_time);              // Time of last vsize increase
     size_t vsize_max(start_metrics.vmem_size);  // Maximum vsize
+    ThreadMetricsMap last_threads;              // Last per-thread metrics
+    const bool thread_metrics = GetThreadMetrics(last_threads);
 
     _report->info(u"%sresource monitoring started", {MonPrefix(Time::CurrentLocalTime())});
 
@@ -188,6 +301,15 @@ void ts::SystemMonitor::main()
 
         _report->info(message);
 
+        // Display CPU load per thread.
+
+        if (thread_metrics) {
+            ThreadMetricsMap threads;
+            GetThreadMetrics(threads);
+            reportThreads(last_threads, threads, current_time - last_time, MonPrefix(current_time));
+            last_threads.swap(threads);
+        }
+
         last_time = current_time;
         last_metrics = metrics;
     }
@@ -58,14 +58,20 @@ namespace ts {
     //! - Up to start + 1 hour, log every 5 minutes
     //! - After start + 1 hour, log every 30 minutes
     //!
+    //! On Linux, the CPU load of each thread in the process is also reported,
+    //! using the thread names (see ThreadAttributes::setName()). A warning is
+    //! reported when a thread uses more than a given percentage of one CPU.
+    //!
     class TSDUCKDLL SystemMonitor: public Thread
     {
     public:
         //!
         //! Constructor.
         //! @param [in] report Where to report log data.
+        //! @param [in] thread_cpu_threshold Percentage of one CPU above which
+        //! a warning is reported for a thread.
         //!
-        SystemMonitor(Report* report);
+        SystemMonitor(Report* report, int thread_cpu_threshold = 90);
 
         //!
         //! Destructor.
@@ -75,10 +81,25 @@ namespace ts {
     private:
         // Private members
         Report*   _report;
+        int       _cpu_threshold;  // percentage of one CPU per thread
         Mutex     _mutex;
         Condition _wake_up;    // accessed under mutex
         bool      _terminate;  // accessed under mutex
 
+        // CPU time of one thread, indexed by thread id.
+        struct ThreadMetrics
+        {
+            UString     name;      // Thread name.
+            MilliSecond cpu_time;  // CPU time (user + kernel) in milliseconds.
+        };
+        typedef std::map<int, ThreadMetrics> ThreadMetricsMap;
+
+        // Get the CPU time of all threads in the process. Return false if not supported.
+        static bool GetThreadMetrics(ThreadMetricsMap& threads);
+
+        // Format the CPU load of all threads during an interval.
+        void reportThreads(const ThreadMetricsMap& previous, const ThreadMetricsMap& current, MilliSecond duration, const UString& prefix);
+
         // Inherited from Thread
         virtual void main() override;
 
@@ -41,7 +41,7 @@ TSDUCK_SOURCE;
 ts::T2MIDemux::PLPContext::PLPContext() :
     first_packet(true),
     ts(),
-    ts_next(0)
+    ts_size(0)
 {
 }
 
@@ -156,8 +156,7 @@ void ts::T2MIDemux::feedPacket(const TSPacket& pkt)
 
     // Accumulate packet data and process T2-MI packets.
     if (pc->sync) {
-        pc->t2mi.append(data, size);
-        processT2MI(pid, *pc);
+        processT2MI(pid, *pc, data, size);
     }
 }
 
@@ -168,57 +167,74 @@ void ts::T2MIDemux::feedPacket(const TSPacket& pkt)
 
 void ts::T2MIDemux::PIDContext::lostSync()
 {
-    t2mi.clear();   // accumulated T2-MI packet buffer.
+    if (!t2mi.isNull()) {
+        t2mi->clear();  // accumulated T2-MI packet buffer.
+    }
     plps.clear();   // we also lose partially demuxed PLP's.
     sync = false;
 }
 
 
 //----------------------------------------------------------------------------
-// Process and remove complete T2-MI packets from the buffer.
+// Accumulate T2-MI data and process complete T2-MI packets.
 //----------------------------------------------------------------------------
 
-void ts::T2MIDemux::processT2MI(PID pid, PIDContext& pc)
+void ts::T2MIDemux::processT2MI(PID pid, PIDContext& pc, const uint8_t* data, size_t size)
 {
-    // Start index in buffer of T2-MI packet header.
-    size_t start = 0;
-
     // Protect sequence which may call application-defined handlers.
     beforeCallingHandler(pid);
     try {
 
-        // Loop on all complete T2-MI packets.
-        while (start + T2MI_HEADER_SIZE < pc.t2mi.size()) {
+        // The data of each T2-MI packet are accumulated in their own buffer, which is
+        // directly referenced by the T2MIPacket object, without intermediate copy.
+        while (size > 0) {
 
-            // Extract T2-MI packet size in bytes.
-            const uint16_t payload_bits = GetUInt16(&pc.t2mi[start + 4]);
-            const uint16_t payload_bytes = (payload_bits + 7) / 8;
-            const size_t packet_size = T2MI_HEADER_SIZE + payload_bytes + SECTION_CRC32_SIZE;
+            if (pc.t2mi.isNull()) {
+                pc.t2mi = new ByteBlock;
+                CheckNonNull(pc.t2mi.pointer());
+            }
+            ByteBlock& buf(*pc.t2mi);
 
-            if (start + packet_size > pc.t2mi.size()) {
-                // Current T2-MI packet not completely present in buffer, stop here.
-                break;
+            // Expected size: the header first, then the complete T2-MI packet.
+            size_t packet_size = T2MI_HEADER_SIZE;
+            if (buf.size() >= T2MI_HEADER_SIZE) {
+                packet_size += (GetUInt16(&buf[4]) + 7) / 8 + SECTION_CRC32_SIZE;
             }
 
-            // Build a T2-MI packet.
-            T2MIPacket pkt(pc.t2mi.data() + start, packet_size, pid);
-            if (pkt.isValid()) {
+            // Accumulate data up to the expected size.
+            const size_t chunk = std::min(size, packet_size - buf.size());
+            buf.append(data, chunk);
+            data += chunk;
+            size -= chunk;
 
-                // Notify the application.
-                if (_handler != 0) {
-                    _handler->handleT2MIPacket(*this, pkt);
+            if (buf.size() == T2MI_HEADER_SIZE) {
+                // Header complete, now wait for the complete T2-MI packet.
+                buf.reserve(T2MI_HEADER_SIZE + (GetUInt16(&buf[4]) + 7) / 8 + SECTION_CRC32_SIZE);
+            }
+            else if (buf.size() == packet_size) {
+                {
+                    // Build a T2-MI packet, sharing the buffer.
+                    const T2MIPacket pkt(pc.t2mi, pid);
+                    if (pkt.isValid()) {
+
+                        // Notify the application.
+                        if (_handler != 0) {
+                            _handler->handleT2MIPacket(*this, pkt);
+                        }
+
+                        // Demux TS packets from the T2-MI packet.
+                        demuxTS(pc, pkt);
+                    }
+                }
+                // Reuse the buffer for the next T2-MI packet, unless the application kept a reference to it.
+                if (pc.t2mi.count() == 1) {
+                    pc.t2mi->clear();
+                }
+                else {
+                    pc.t2mi.clear();
                 }
-
-                // Demux TS packets from the T2-MI packet.
-                demuxTS(pid, pc, pkt);
             }
-
-            // Point to next T2-MI packet.
-            start += T2MI_HEADER_SIZE + payload_bytes + SECTION_CRC32_SIZE;
         }
-
-        // Remove processed T2-MI packets.
-        pc.t2mi.erase(0, start);
     }
     catch (...) {
         afterCallingHandler(false);
@@ -232,7 +248,7 @@ void ts::T2MIDemux::processT2MI(PID pid, PIDContext& pc)
 // Demux all encapsulated TS packets from a T2-MI packet.
 //----------------------------------------------------------------------------
 
-void ts::T2MIDemux::demuxTS(PID pid, PIDContext& pc, const T2MIPacket& pkt)
+void ts::T2MIDemux::demuxTS(PIDContext& pc, const T2MIPacket& pkt)
 {
     // Keep only baseband frames.
     const uint8_t* data = pkt.basebandFrame();
@@ -275,72 +291,81 @@ void ts::T2MIDemux::demuxTS(PID pid, PIDContext& pc, const T2MIPacket& pkt)
     }
 
     // Get / create PLP context.
-    const uint8_t plp = pkt.plp();
-    PLPContextPtr& plpp(pc.plps[plp]);
+    PLPContextPtr& plpp(pc.plps[pkt.plp()]);
     if (plpp.isNull()) {
         plpp = new PLPContext;
         CheckNonNull(plpp.pointer());
     }
+    PLPContext& plp(*plpp);
 
     if (syncd == 0xFFFF) {
         // No user packet in data field
-        plpp->ts.append(data, dfl);
+        appendTS(plp, pkt, data, dfl);
     }
     else {
         // Synchronization distance in bytes, bounded by data field size.
         syncd = std::min(syncd / 8, dfl);
 
         // Process end of previous packet.
-        if (!plpp->first_packet && syncd > 0) {
-            if (plpp->ts.size() % PKT_SIZE == 0) {
-                plpp->ts.append(SYNC_BYTE);
+        if (!plp.first_packet && syncd > 0) {
+            if (plp.ts_size == 0) {
+                appendTS(plp, pkt, &SYNC_BYTE, 1);
             }
-            plpp->ts.append(data, syncd - npd);
+            appendTS(plp, pkt, data, syncd - npd);
         }
-        plpp->first_packet = false;
+        plp.first_packet = false;
         data += syncd;
         dfl -= syncd;
 
         // Process subsequent complete packets.
         while (dfl >= PKT_SIZE - 1) {
-            plpp->ts.append(SYNC_BYTE);
-            plpp->ts.append(data, PKT_SIZE - 1);
+            if (plp.ts_size == 0) {
+                // Usual case: build the TS packet directly from the baseband frame.
+                plp.ts.b[0] = SYNC_BYTE;
+                ::memcpy(plp.ts.b + 1, data, PKT_SIZE - 1);  // Flawfinder: ignore: memcpy()
+                // Notify the application. Note that we are already in a protected section.
+                if (_handler != 0) {
+                    _handler->handleTSPacket(*this, pkt, plp.ts);
+                }
+            }
+            else {
+                appendTS(plp, pkt, &SYNC_BYTE, 1);
+                appendTS(plp, pkt, data, PKT_SIZE - 1);
+            }
             data += PKT_SIZE - 1;
             dfl -= PKT_SIZE - 1;
         }
 
         // Process optional trailing truncated packet.
         if (dfl > 0) {
-            plpp->ts.append(SYNC_BYTE);
-            plpp->ts.append(data, dfl);
+            appendTS(plp, pkt, &SYNC_BYTE, 1);
+            appendTS(plp, pkt, data, dfl);
         }
     }
+}
 
-    // Now process each complete TS packet.
-    while (plpp->ts_next + PKT_SIZE <= plpp->ts.size()) {
 
-        // Build the TS packet.
-        TSPacket tsPkt;
-        ::memcpy(tsPkt.b, &plpp->ts[plpp->ts_next], PKT_SIZE);
-        plpp->ts_next += PKT_SIZE;
+//----------------------------------------------------------------------------
+// Append user packet data to the partial TS packet of a PLP.
+//----------------------------------------------------------------------------
 
-        // Notify the application. Note that we are already in a protected section.
-        if (_handler != 0) {
-            _handler->handleTSPacket(*this, pkt, tsPkt);
+void ts::T2MIDemux::appendTS(PLPContext& plp, const T2MIPacket& pkt, const uint8_t* data, size_t size)
+{
+    while (size > 0) {
+        const size_t chunk = std::min(size, PKT_SIZE - plp.ts_size);
+        ::memcpy(plp.ts.b + plp.ts_size, data, chunk);  // Flawfinder: ignore: memcpy()
+        plp.ts_size += chunk;
+        data += chunk;
+        size -= chunk;
+
+        // Notify the application with each complete TS packet.
+        if (plp.ts_size == PKT_SIZE) {
+            plp.ts_size = 0;
+            if (_handler != 0) {
+                _handler->handleTSPacket(*this, pkt, plp.ts);
+            }
         }
     }
-
-    // Compress or cleanup the TS buffer.
-    if (plpp->ts_next >= plpp->ts.size()) {
-        // No more packet to output, cleanup.
-        plpp->ts.clear();
-        plpp->ts_next = 0;
-    }
-    else if (plpp->ts_next >= 100 * PKT_SIZE) {
-        // TS buffer has many unused packets, compress it.
-        plpp->ts.erase(0, plpp->ts_next);
-        plpp->ts_next = 0;
-    }
 }
 
 
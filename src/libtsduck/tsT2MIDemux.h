@@ -50,6 +50,10 @@ namespace ts {
     //! The application decides which T2-MI PID's should be demuxed. These PID's can
     //! be selected from the beginning or in response to the discovery of T2-MI PID's.
     //!
+    //! All PLP's of a T2-MI PID are demuxed at the same time. The TS packets are
+    //! extracted directly from the baseband frames of the T2-MI packets. Only user
+    //! packets which are split across two baseband frames are accumulated.
+    //!
     class TSDUCKDLL T2MIDemux:
         public AbstractDemux,
         private TableHandlerInterface
@@ -93,9 +97,9 @@ namespace ts {
         // Analysis context for one PLP inside one T2-MI stream.
         struct PLPContext
         {
-            bool      first_packet;  // First T2-MI packet not yet processed
-            ByteBlock ts;            // Buffer to accumulate extracted TS packets.
-            size_t    ts_next;       // Next packet to output.
+            bool     first_packet;  // First T2-MI packet not yet processed
+            TSPacket ts;            // Partially extracted TS packet.
+            size_t   ts_size;       // Number of bytes in partial TS packet.
 
             // Default constructor
             PLPContext();
@@ -110,7 +114,7 @@ namespace ts {
         {
             uint8_t       continuity;  // Last continuity counter
             bool          sync;        // We are synchronous in this PID
-            ByteBlock     t2mi;        // Buffer containing the T2-MI data.
+            ByteBlockPtr  t2mi;        // Buffer containing the current T2-MI packet.
             PLPContextMap plps;        // Map of PLP context per PID.
 
             // Default constructor
@@ -127,11 +131,14 @@ namespace ts {
         // Inherited methods from TableHandlerInterface.
         virtual void handleTable(SectionDemux&, const BinaryTable&) override;
 
-        // Process and remove complete T2-MI packets from the buffer.
-        void processT2MI(PID pid, PIDContext& pc);
+        // Accumulate T2-MI data and process complete T2-MI packets.
+        void processT2MI(PID pid, PIDContext& pc, const uint8_t* data, size_t size);
 
         // Demux all encapsulated TS packets from a T2-MI packet.
-        void demuxTS(PID pid, PIDContext& pc, const T2MIPacket& pkt);
+        void demuxTS(PIDContext& pc, const T2MIPacket& pkt);
+
+        // Append user packet data to the partial TS packet of a PLP, notify complete packets.
+        void appendTS(PLPContext& plp, const T2MIPacket& pkt, const uint8_t* data, size_t size);
 
         // Process a PMT.
         void processPMT(const PMT& pmt);
@@ -39,6 +39,14 @@ bool ts::TDES::setKey (const void* key, size_t key_length, size_t rounds)
     DES::deskey (k+8,  DES::EN0, _dk[1]);
     DES::deskey (k+16, DES::DE1, _dk[0]);
 
+    // The second stage is a DES decryption, its round keys are reversed.
+    // The bitsliced round keys are rebuilt on next use.
+    DES::roundkeys (k,    _rk);
+    DES::roundkeys (k+8,  _rk + ROUNDS);
+    DES::roundkeys (k+16, _rk + 2 * ROUNDS);
+    std::reverse (_rk + ROUNDS, _rk + 2 * ROUNDS);
+    _bs_keys.clear();
+
     return true;
 }
 
@@ -105,3 +113,41 @@ bool ts::TDES::decrypt (const void* cipher, size_t cipher_length,
 
     return true;
 }
+
+
+//----------------------------------------------------------------------------
+// Multi-block encryption and decryption in ECB mode.
+// The bitsliced implementation processes many blocks in parallel.
+//----------------------------------------------------------------------------
+
+bool ts::TDES::encryptBlocks(const void* plain, void* cipher, size_t count)
+{
+    const uint8_t* pt = reinterpret_cast<const uint8_t*>(plain);
+    uint8_t* ct = reinterpret_cast<uint8_t*>(cipher);
+
+    const size_t done = DES::bitslice(_rk, 3 * ROUNDS, _bs_keys, false, pt, ct, count);
+    pt += done * BLOCK_SIZE;
+    ct += done * BLOCK_SIZE;
+
+    // Avoid a virtual call per block.
+    for (count -= done; count > 0; count--, pt += BLOCK_SIZE, ct += BLOCK_SIZE) {
+        TDES::encrypt(pt, BLOCK_SIZE, ct, BLOCK_SIZE);
+    }
+    return true;
+}
+
+bool ts::TDES::decryptBlocks(const void* cipher, void* plain, size_t count)
+{
+    const uint8_t* ct = reinterpret_cast<const uint8_t*>(cipher);
+    uint8_t* pt = reinterpret_cast<uint8_t*>(plain);
+
+    const size_t done = DES::bitslice(_rk, 3 * ROUNDS, _bs_keys, true, ct, pt, count);
+    ct += done * BLOCK_SIZE;
+    pt += done * BLOCK_SIZE;
+
+    // Avoid a virtual call per block.
+    for (count -= done; count > 0; count--, ct += BLOCK_SIZE, pt += BLOCK_SIZE) {
+        TDES::decrypt(ct, BLOCK_SIZE, pt, BLOCK_SIZE);
+    }
+    return true;
+}
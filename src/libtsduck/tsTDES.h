@@ -34,11 +34,15 @@
 
 #pragma once
 #include "tsBlockCipher.h"
+#include "tsByteBlock.h"
 
 namespace ts {
     //!
     //! Triple-DES block cipher
     //!
+    //! When many independent blocks are processed at a time, encryptBlocks() and
+    //! decryptBlocks() use the bitsliced implementation of DES.
+    //!
     class TSDUCKDLL TDES: public BlockCipher
     {
     public:
@@ -63,9 +67,13 @@ namespace ts {
         virtual bool decrypt(const void* cipher, size_t cipher_length,
                              void* plain, size_t plain_maxsize,
                              size_t* plain_length = 0) override;
+        virtual bool encryptBlocks(const void* plain, void* cipher, size_t count) override;
+        virtual bool decryptBlocks(const void* cipher, void* plain, size_t count) override;
 
     private:
-        uint32_t _ek[3][32];  // Encryption keys
-        uint32_t _dk[3][32];  // Decryption keys
+        uint32_t  _ek[3][32];      // Encryption keys
+        uint32_t  _dk[3][32];      // Decryption keys
+        uint64_t  _rk[3 * ROUNDS]; // Round keys of the 3 DES stages, in encryption order, for the bitsliced implementation
+        ByteBlock _bs_keys;        // Bitsliced round keys, built on first use
     };
 }
@@ -90,9 +90,32 @@ ts::TSAnalyzer::TSAnalyzer(BitRate bitrate_hint) :
     _max_consecutive_suspects(1),
     _demux(this, this),
     _pes_demux(this),
-    _t2mi_demux(this)
+    _t2mi_demux(this),
+    _preceding(false),
+    _full_recompute(false),
+    _scrambled_pkt_cnt(0),
+    _unexp_discont(0),
+    _duplicated(0),
+    _pid_list(),
+    _modified_pids(),
+    _pid_index(),
+    _max_etid_per_pid(0)
 {
+    // Only the beginning of PES packets is needed to get the audio and video attributes.
+    _pes_demux.setMaxPESSize(PES_ANALYSIS_SIZE);
+    _pes_demux.setAttributesSampling(PES_SAMPLING_INTERVAL);
+
     // Specify the PID filters to collect PSI tables.
+    addGlobalPIDs();
+}
+
+
+//----------------------------------------------------------------------------
+// Add the PID filters to collect PSI tables.
+//----------------------------------------------------------------------------
+
+void ts::TSAnalyzer::addGlobalPIDs()
+{
     _demux.addPID(PID_PAT);
     _demux.addPID(PID_CAT);
     _demux.addPID(PID_TSDT);
@@ -155,18 +178,23 @@ void ts::TSAnalyzer::reset()
     _tid_present.reset();
     _pids.clear();
     _services.clear();
+    _full_recompute = false;
+    _scrambled_pkt_cnt = 0;
+    _unexp_discont = 0;
+    _duplicated = 0;
+    _pid_list.clear();
+    _modified_pids.clear();
+    std::fill(_pid_index, _pid_index + PID_MAX, static_cast<PIDContext*>(0));
     _ts_bitrate_sum = 0;
     _ts_bitrate_cnt = 0;
     _preceding_errors = 0;
     _preceding_suspects = 0;
     _demux.reset();
     _pes_demux.reset();
+    _t2mi_demux.reset();
 
     // Specify the PID filters to collect PSI tables.
-    _demux.addPID(PID_PAT);
-    _demux.addPID(PID_CAT);
-    _demux.addPID(PID_SDT);  // also BAT
-    _demux.addPID(PID_TDT);  // also TOT
+    addGlobalPIDs();
 }
 
 
@@ -176,6 +204,41 @@ void ts::TSAnalyzer::reset()
 
 ts::TSAnalyzer::PIDContext::PIDContext(PID pid_, const UString& description_) :
     pid(pid_),
+    modified(false),
+    cur_continuity(0),
+    cur_ts_sc(0),
+    scrambled(false),
+    same_stream_id(false),
+    pes_stream_id(0),
+    ts_pkt_cnt(0),
+    ts_af_cnt(0),
+    unit_start_cnt(0),
+    pl_start_cnt(0),
+    ts_sc_cnt(0),
+    inv_ts_sc_cnt(0),
+    exp_discont(0),
+    unexp_discont(0),
+    duplicated(0),
+    inv_pes_start(0),
+    pcr_cnt(0),
+    last_pcr(0),
+    last_pcr_pkt(0),
+    ts_bitrate_sum(0),
+    ts_bitrate_cnt(0),
+    cur_ts_sc_pkt(0),
+    cryptop_cnt(0),
+    cryptop_ts_cnt(0),
+    first_pkt(0),
+    first_cc(0),
+    first_ts_sc(0),
+    first_discont(false),
+    first_payload(false),
+    discont_before_pcr(false),
+    first_pcr(0),
+    first_pcr_pkt(0),
+    first_cryptop_ts(0),
+    idle_pkt_cnt(0),
+    idle_cnt(0),
     description(description_),
     comment(),
     attributes(),
@@ -191,23 +254,9 @@ ts::TSAnalyzer::PIDContext::PIDContext(PID pid_, const UString& description_) :
     carry_audio(false),
     carry_video(false),
     carry_t2mi(false),
-    scrambled(false),
-    same_stream_id(false),
-    pes_stream_id(0),
-    ts_pkt_cnt(0),
-    ts_af_cnt(0),
-    unit_start_cnt(0),
-    pl_start_cnt(0),
     pmt_cnt(0),
     crypto_period(0),
-    unexp_discont(0),
-    exp_discont(0),
-    duplicated(0),
-    ts_sc_cnt(0),
-    inv_ts_sc_cnt(0),
-    inv_pes_start(0),
     t2mi_cnt(0),
-    pcr_cnt(0),
     ts_pcr_bitrate(0),
     bitrate(0),
     language(),
@@ -216,15 +265,8 @@ ts::TSAnalyzer::PIDContext::PIDContext(PID pid_, const UString& description_) :
     sections(),
     ssu_oui(),
     t2mi_plp_ts(),
-    cur_continuity(0),
-    cur_ts_sc(0),
-    cur_ts_sc_pkt(0),
-    cryptop_cnt(0),
-    cryptop_ts_cnt(0),
-    last_pcr(0),
-    last_pcr_pkt(0),
-    ts_bitrate_sum(0),
-    ts_bitrate_cnt(0)
+    stats_pkt_cnt(0),
+    service_contexts()
 {
     // Guess the initial description, based on the PID
     // Global PID's (PAT, CAT, etc) are marked as "referenced" since they
@@ -344,7 +386,10 @@ ts::TSAnalyzer::ETIDContext::ETIDContext(const ETID& etid_) :
     last_version(0),
     versions(),
     first_pkt(0),
-    last_pkt(0)
+    last_pkt(0),
+    last_section_pkt(0),
+    idle_section_cnt(0),
+    idle_cnt(0)
 {
 }
 
@@ -403,6 +448,9 @@ ts::UString ts::TSAnalyzer::ServiceContext::getName() const
     if (!name.empty()) {
         return name;
     }
+    else if (carry_t2mi) {
+        return u"(T2-MI)";
+    }
     else if (carry_ssu) {
         return u"(System Software Update)";
     }
@@ -427,6 +475,16 @@ ts::TSAnalyzer::ETIDContextPtr ts::TSAnalyzer::getETID(const Section& section)
         return it->second;
     }
     else {
+        // With a maximum number of tables per PID, drop the least recently seen one.
+        if (_max_etid_per_pid > 0 && pc->sections.size() >= _max_etid_per_pid) {
+            ETIDContextMap::iterator oldest(pc->sections.begin());
+            for (ETIDContextMap::iterator et = pc->sections.begin(); et != pc->sections.end(); ++et) {
+                if (et->second->last_section_pkt < oldest->second->last_section_pkt) {
+                    oldest = et;
+                }
+            }
+            pc->sections.erase(oldest);
+        }
         ETIDContextPtr result(new ETIDContext(etid));
         pc->sections [etid] = result;
         result->first_version = section.version();
@@ -444,7 +502,13 @@ ts::TSAnalyzer::PIDContextPtr ts::TSAnalyzer::getPID(PID pid, const UString& des
     const PIDContextPtr p(_pids[pid]);
     if (p.isNull()) {
         // The PID was not yet used, map entry just created.
-        return _pids[pid] = new PIDContext(pid, description);
+        PIDContext* const pc = new PIDContext(pid, description);
+        if (pid < PID_MAX) {
+            _pid_index[pid] = pc;
+        }
+        _pid_list.push_back(pc);
+        _full_recompute = true;
+        return _pids[pid] = pc;
     }
     else {
         return p;
@@ -461,6 +525,7 @@ ts::TSAnalyzer::ServiceContextPtr ts::TSAnalyzer::getService(uint16_t service_id
     ServiceContextPtr p(_services[service_id]);
     if (p.isNull()) {
         // The service was not yet used, map entry just created.
+        _full_recompute = true;
         return _services[service_id] = new ServiceContext(service_id);
     }
     else {
@@ -469,6 +534,79 @@ ts::TSAnalyzer::ServiceContextPtr ts::TSAnalyzer::getService(uint16_t service_id
 }
 
 
+//----------------------------------------------------------------------------
+// Drop the analysis contexts which became inactive.
+//----------------------------------------------------------------------------
+
+void ts::TSAnalyzer::pruneIdleContexts(size_t max_idle)
+{
+    if (max_idle == 0) {
+        return;
+    }
+
+    bool removed = false;
+    std::set<uint16_t> active_services;
+
+    for (PIDContextMap::iterator pci = _pids.begin(); pci != _pids.end(); ) {
+        PIDContext& pc(*pci->second);
+
+        // Age out the tables of this PID.
+        for (ETIDContextMap::iterator et = pc.sections.begin(); et != pc.sections.end(); ) {
+            ETIDContext& etc(*et->second);
+            if (etc.section_count != etc.idle_section_cnt) {
+                etc.idle_section_cnt = etc.section_count;
+                etc.idle_cnt = 0;
+                ++et;
+            }
+            else if (++etc.idle_cnt >= max_idle) {
+                et = pc.sections.erase(et);
+            }
+            else {
+                ++et;
+            }
+        }
+
+        // Age out the PID, except reserved PID's.
+        if (pc.ts_pkt_cnt != pc.idle_pkt_cnt) {
+            pc.idle_pkt_cnt = pc.ts_pkt_cnt;
+            pc.idle_cnt = 0;
+        }
+        else if (pc.pid >= 0x0020 && pc.pid != PID_NULL && ++pc.idle_cnt >= max_idle) {
+            if (pc.scrambled) {
+                _scrambled_pid_cnt--;
+            }
+            if (pc.pid < PID_MAX) {
+                _pid_index[pc.pid] = 0;
+            }
+            _pid_list.erase(std::find(_pid_list.begin(), _pid_list.end(), &pc));
+            const std::vector<PIDContext*>::iterator mod(std::find(_modified_pids.begin(), _modified_pids.end(), &pc));
+            if (mod != _modified_pids.end()) {
+                _modified_pids.erase(mod);
+            }
+            pci = _pids.erase(pci);
+            removed = true;
+            continue;
+        }
+        active_services.insert(pc.services.begin(), pc.services.end());
+        ++pci;
+    }
+
+    // Drop the services which no longer have any PID.
+    if (removed) {
+        for (ServiceContextMap::iterator sci = _services.begin(); sci != _services.end(); ) {
+            if (active_services.find(sci->first) == active_services.end()) {
+                sci = _services.erase(sci);
+            }
+            else {
+                ++sci;
+            }
+        }
+        _modified = true;
+        _full_recompute = true;
+    }
+}
+
+
 //----------------------------------------------------------------------------
 //  Register a service into a PID description. The PID may belong to several
 //  services, we add the service into this list, if not already in.
@@ -487,6 +625,238 @@ void ts::TSAnalyzer::PIDContext::addService(uint16_t service_id)
 }
 
 
+//----------------------------------------------------------------------------
+// Merge the context of the same service in the next part of the stream.
+//----------------------------------------------------------------------------
+
+void ts::TSAnalyzer::ServiceContext::merge(const ServiceContext& next)
+{
+    // The next part of the stream has the most recent PSI/SI.
+    if (next.orig_netw_id != 0 || next.service_type != 0) {
+        orig_netw_id = next.orig_netw_id;
+        service_type = next.service_type;
+    }
+    if (!next.name.empty()) {
+        name = next.name;
+    }
+    if (!next.provider.empty()) {
+        provider = next.provider;
+    }
+    if (next.pmt_pid != 0) {
+        pmt_pid = next.pmt_pid;
+    }
+    if (next.pcr_pid != 0) {
+        pcr_pid = next.pcr_pid;
+    }
+    carry_ssu = carry_ssu || next.carry_ssu;
+    carry_t2mi = carry_t2mi || next.carry_t2mi;
+}
+
+
+//----------------------------------------------------------------------------
+// Merge the context of the same table in the next part of the stream.
+//----------------------------------------------------------------------------
+
+void ts::TSAnalyzer::ETIDContext::merge(const ETIDContext& next, uint64_t packet_offset)
+{
+    if (section_count == 0) {
+        first_version = next.first_version;
+    }
+    if (next.section_count > 0) {
+        last_section_pkt = next.last_section_pkt + packet_offset;
+    }
+    section_count += next.section_count;
+    versions |= next.versions;
+
+    if (next.table_count == 0) {
+        return;
+    }
+    else if (table_count == 0) {
+        first_pkt = next.first_pkt + packet_offset;
+        first_version = next.first_version;
+        min_repetition_ts = next.min_repetition_ts;
+        max_repetition_ts = next.max_repetition_ts;
+    }
+    else {
+        // Repetition interval across the boundary of the two parts.
+        const uint64_t rep = next.first_pkt + packet_offset - last_pkt;
+        if (table_count == 1 || rep < min_repetition_ts) {
+            min_repetition_ts = rep;
+        }
+        if (table_count == 1 || rep > max_repetition_ts) {
+            max_repetition_ts = rep;
+        }
+        if (next.table_count > 1) {
+            min_repetition_ts = std::min(min_repetition_ts, next.min_repetition_ts);
+            max_repetition_ts = std::max(max_repetition_ts, next.max_repetition_ts);
+        }
+    }
+    table_count += next.table_count;
+    last_pkt = next.last_pkt + packet_offset;
+    last_version = next.last_version;
+    if (table_count > 1) {
+        repetition_ts = (last_pkt - first_pkt + (table_count - 1) / 2) / (table_count - 1);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Merge the context of the same PID in the next part of the stream.
+//----------------------------------------------------------------------------
+
+void ts::TSAnalyzer::PIDContext::merge(const PIDContext& next, uint64_t packet_offset)
+{
+    // PSI/SI information. The next part of the stream has the most recent one.
+    if (next.referenced) {
+        description = next.description;
+    }
+    if (!next.comment.empty()) {
+        comment = next.comment;
+    }
+    if (!next.language.empty()) {
+        language = next.language;
+    }
+    if (next.cas_id != 0) {
+        cas_id = next.cas_id;
+    }
+    for (UStringVector::const_iterator it = next.attributes.begin(); it != next.attributes.end(); ++it) {
+        AppendUnique(attributes, *it);
+    }
+    services.insert(next.services.begin(), next.services.end());
+    cas_operators.insert(next.cas_operators.begin(), next.cas_operators.end());
+    ssu_oui.insert(next.ssu_oui.begin(), next.ssu_oui.end());
+    is_pmt_pid = is_pmt_pid || next.is_pmt_pid;
+    is_pcr_pid = is_pcr_pid || next.is_pcr_pid;
+    referenced = referenced || next.referenced;
+    optional = optional && next.optional;
+    carry_t2mi = carry_t2mi || next.carry_t2mi;
+    carry_pes = carry_pes || next.carry_pes;
+    carry_section = (carry_section || next.carry_section) && !carry_t2mi;
+    carry_ecm = carry_ecm || next.carry_ecm;
+    carry_emm = carry_emm || next.carry_emm;
+    carry_audio = carry_audio || next.carry_audio;
+    carry_video = carry_video || next.carry_video;
+    pmt_cnt += next.pmt_cnt;
+    t2mi_cnt += next.t2mi_cnt;
+    for (std::map<uint8_t,uint64_t>::const_iterator it = next.t2mi_plp_ts.begin(); it != next.t2mi_plp_ts.end(); ++it) {
+        t2mi_plp_ts[it->first] += it->second;
+    }
+    for (ETIDContextMap::const_iterator it = next.sections.begin(); it != next.sections.end(); ++it) {
+        ETIDContextPtr& etc(sections[it->first]);
+        if (etc.isNull()) {
+            etc = new ETIDContext(it->first);
+        }
+        etc->merge(*it->second, packet_offset);
+    }
+
+    // Packet analysis, continued across the boundary of the two parts.
+    if (next.ts_pkt_cnt == 0) {
+        return;
+    }
+    const uint64_t first = next.first_pkt + packet_offset;
+    if (ts_pkt_cnt == 0) {
+        first_pkt = first;
+        first_cc = next.first_cc;
+        first_ts_sc = next.first_ts_sc;
+        first_discont = next.first_discont;
+        first_payload = next.first_payload;
+    }
+
+    // Process the first packet of the next part as a continuation of this part, same as feedPacket().
+    bool broken_rate = false;
+    if (pid != PID_NULL && ts_pkt_cnt > 0) {
+        if (next.first_discont) {
+            exp_discont++;
+            broken_rate = true;
+        }
+        else if (next.first_payload) {
+            if (next.first_cc == cur_continuity) {
+                duplicated++;
+            }
+            else if (next.first_cc != (cur_continuity + 1) % CC_MAX) {
+                unexp_discont++;
+                broken_rate = true;
+            }
+        }
+        else if (next.first_cc != cur_continuity) {
+            unexp_discont++;
+            broken_rate = true;
+        }
+    }
+    cur_continuity = next.cur_continuity;
+
+    // Crypto-periods. When the scrambling control of the first packet of the next part is the same
+    // as the current one, the first crypto-period of the next part started in this part.
+    const bool continued = next.first_ts_sc == cur_ts_sc && cur_ts_sc != SC_CLEAR;
+    const uint64_t cur_length = first - cur_ts_sc_pkt;
+    if (next.first_ts_sc != cur_ts_sc && cur_ts_sc != SC_CLEAR) {
+        addCryptoPeriod(cur_length);
+    }
+    if (next.cryptop_cnt > 0) {
+        addCryptoPeriod(continued ? cur_length + next.first_cryptop_ts : next.first_cryptop_ts);
+        cryptop_cnt += next.cryptop_cnt - 1;
+        cryptop_ts_cnt += next.cryptop_ts_cnt;
+    }
+    if (next.cur_ts_sc_pkt == 0) {
+        // No scrambling control change in the next part, the first packet is clear.
+        if (cur_ts_sc != SC_CLEAR) {
+            cur_ts_sc_pkt = first;
+        }
+    }
+    else if (!continued || next.cryptop_cnt > 0) {
+        cur_ts_sc_pkt = next.cur_ts_sc_pkt + packet_offset;
+    }
+    cur_ts_sc = next.cur_ts_sc;
+
+    // PCR's. Compute the transport rate between the last PCR of this part and the first PCR of the next part.
+    broken_rate = broken_rate || next.discont_before_pcr;
+    if (broken_rate) {
+        last_pcr = 0;
+        if (pcr_cnt == 0) {
+            discont_before_pcr = true;
+        }
+    }
+    if (next.pcr_cnt > 0) {
+        if (last_pcr != 0 && last_pcr < next.first_pcr) {
+            const uint64_t ts_bitrate =
+                (uint64_t(next.first_pcr_pkt + packet_offset - last_pcr_pkt) * SYSTEM_CLOCK_FREQ * PKT_SIZE * 8) /
+                (next.first_pcr - last_pcr);
+            ts_bitrate_sum += ts_bitrate;
+            ts_bitrate_cnt++;
+        }
+        if (pcr_cnt == 0) {
+            first_pcr = next.first_pcr;
+            first_pcr_pkt = next.first_pcr_pkt + packet_offset;
+        }
+        last_pcr = next.last_pcr;
+        last_pcr_pkt = next.last_pcr_pkt + packet_offset;
+    }
+
+    // Other packet counters.
+    scrambled = scrambled || next.scrambled;
+    if (pes_stream_id == 0) {
+        pes_stream_id = next.pes_stream_id;
+        same_stream_id = next.same_stream_id;
+    }
+    else if (next.pes_stream_id != 0) {
+        same_stream_id = same_stream_id && next.same_stream_id && pes_stream_id == next.pes_stream_id;
+    }
+    ts_pkt_cnt += next.ts_pkt_cnt;
+    ts_af_cnt += next.ts_af_cnt;
+    unit_start_cnt += next.unit_start_cnt;
+    pl_start_cnt += next.pl_start_cnt;
+    ts_sc_cnt += next.ts_sc_cnt;
+    inv_ts_sc_cnt += next.inv_ts_sc_cnt;
+    exp_discont += next.exp_discont;
+    unexp_discont += next.unexp_discont;
+    duplicated += next.duplicated;
+    inv_pes_start += next.inv_pes_start;
+    pcr_cnt += next.pcr_cnt;
+    ts_bitrate_sum += next.ts_bitrate_sum;
+    ts_bitrate_cnt += next.ts_bitrate_cnt;
+}
+
+
 //----------------------------------------------------------------------------
 // This hook is invoked when a complete section is available.
 // Implementation of SectionHandlerInterface
@@ -494,11 +864,17 @@ void ts::TSAnalyzer::PIDContext::addService(uint16_t service_id)
 
 void ts::TSAnalyzer::handleSection(SectionDemux&, const Section& section)
 {
+    // Sections which are complete before the analyzed part of the stream are not counted.
+    if (_preceding) {
+        return;
+    }
+
     ETIDContextPtr etc(getETID(section));
     const uint8_t version = section.version();
 
     // Count one section
     etc->section_count++;
+    etc->last_section_pkt = _ts_pkt_cnt;
 
     // Section# 0 is used to track tables
     if (section.sectionNumber() == 0) {
@@ -548,6 +924,9 @@ void ts::TSAnalyzer::handleTable(SectionDemux&, const BinaryTable& table)
     // Trace all table ids to identify missing tables
     _tid_present.set(tid);
 
+    // A new version of a table may change the structure of the stream (but not TDT and TOT)
+    _full_recompute = _full_recompute || (tid != TID_TDT && tid != TID_TOT);
+
     // Process specific tables
     switch (tid) {
         case TID_PAT: {
@@ -647,7 +1026,9 @@ void ts::TSAnalyzer::analyzePMT(PID pid, const PMT& pmt)
 {
     // Count the number of PMT's on this PID
     PIDContextPtr ps(getPID(pid));
-    ps->pmt_cnt++;
+    if (!_preceding) {
+        ps->pmt_cnt++;
+    }
 
     // Get service description
     ServiceContextPtr svp(getService(pmt.service_id));
@@ -1142,11 +1523,8 @@ void ts::TSAnalyzer::handleNewAVCAttributes(PESDemux&, const PESPacket& pkt, con
 void ts::TSAnalyzer::handleT2MINewPID(T2MIDemux& demux, const PMT& pmt, PID pid, const T2MIDescriptor& desc)
 {
     // Identify this service as T2-MI, if not yet identified.
-    ServiceContextPtr svp(getService(pmt.service_id));
-    svp->carry_t2mi = true;
-    if (svp->name.empty()) {
-        svp->name = u"(T2-MI)";
-    }
+    getService(pmt.service_id)->carry_t2mi = true;
+    _full_recompute = true;
 
     // Identify this PID as T2-MI, if not yet identified.
     PIDContextPtr pc(getPID(pid));
@@ -1169,7 +1547,9 @@ void ts::TSAnalyzer::handleT2MIPacket(T2MIDemux& demux, const T2MIPacket& pkt)
     PIDContextPtr pc(getPID(pkt.getSourcePID(), u"T2-MI"));
 
     // Count T2-MI packets.
-    pc->t2mi_cnt++;
+    if (!_preceding) {
+        pc->t2mi_cnt++;
+    }
 
     // Process PLP (only in baseband frame).
     if (pkt.plpValid()) {
@@ -1192,7 +1572,10 @@ void ts::TSAnalyzer::handleTSPacket(T2MIDemux& demux, const T2MIPacket& t2mi, co
     PIDContextPtr pc(getPID(t2mi.getSourcePID(), u"T2-MI"));
 
     // Count demux'ed TS packets from this PLP.
-    pc->t2mi_plp_ts[t2mi.plp()]++;
+    uint64_t& count(pc->t2mi_plp_ts[t2mi.plp()]);
+    if (!_preceding) {
+        count++;
+    }
 }
 
 
@@ -1254,8 +1637,20 @@ void ts::TSAnalyzer::feedPacket(const TSPacket& pkt)
     _t2mi_demux.feedPacket(pkt);
 
     // Get PID context
-    PIDContextPtr ps(getPID(pkt.getPID()));
-    ps->ts_pkt_cnt++;
+    PIDContext* const ps = getPIDContext(pkt.getPID());
+    if (!ps->modified) {
+        ps->modified = true;
+        _modified_pids.push_back(ps);
+    }
+    if (ps->ts_pkt_cnt++ == 0) {
+        _full_recompute = true;
+        // First packet in this PID, keep its characteristics to merge analyses.
+        ps->first_pkt = packet_index;
+        ps->first_cc = pkt.getCC();
+        ps->first_ts_sc = pkt.getScrambling();
+        ps->first_discont = pkt.getDiscontinuityIndicator();
+        ps->first_payload = pkt.hasPayload();
+    }
 
     // Accumulate stat from packet
     if (pkt.hasAF()) {
@@ -1272,25 +1667,20 @@ void ts::TSAnalyzer::feedPacket(const TSPacket& pkt)
     if (pkt.getScrambling() != SC_CLEAR && !ps->scrambled) {
         ps->scrambled = true;
         _scrambled_pid_cnt++;
+        _full_recompute = true;
     }
     if (pkt.getScrambling() == SC_DVB_RESERVED) {
         ps->inv_ts_sc_cnt++;
     }
     else if (pkt.getScrambling() != SC_CLEAR) {
         ps->ts_sc_cnt++;
+        _scrambled_pkt_cnt++;
     }
     if (pkt.getScrambling() != ps->cur_ts_sc) {
         // Change of crypto-period
         if (ps->cur_ts_sc != SC_CLEAR) {
             // End of a crypto-period, not a clear/scramble transition.
-            // Count number of crypto-periods:
-            ps->cryptop_cnt++;
-            // Count number of TS packets in all crypto-periods.
-            // Ignore first crypto-period since it is truncated and
-            // not significant for evaluation of duration.
-            if (ps->cryptop_cnt > 1) {
-                ps->cryptop_ts_cnt += packet_index - ps->cur_ts_sc_pkt;
-            }
+            ps->addCryptoPeriod(packet_index - ps->cur_ts_sc_pkt);
         }
         ps->cur_ts_sc = pkt.getScrambling();
         ps->cur_ts_sc_pkt = packet_index;
@@ -1313,16 +1703,19 @@ void ts::TSAnalyzer::feedPacket(const TSPacket& pkt)
             if (pkt.getCC() == ps->cur_continuity) {
                 // Same counter means duplicated packet.
                 ps->duplicated++;
+                _duplicated++;
             }
             else if (pkt.getCC() != (ps->cur_continuity + 1) % CC_MAX) {
                 // Counter not following previous -> discountinuity
                 ps->unexp_discont++;
+                _unexp_discont++;
                 broken_rate = true;
             }
         }
         else if (pkt.getCC() != ps->cur_continuity) {
             // Packet has no payload -> should have same counter
             ps->unexp_discont++;
+            _unexp_discont++;
             broken_rate = true;
         }
         ps->cur_continuity = pkt.getCC();
@@ -1332,12 +1725,18 @@ void ts::TSAnalyzer::feedPacket(const TSPacket& pkt)
     if (broken_rate) {
         // Suspected packet loss, forget last PCR.
         ps->last_pcr = 0;
+        if (ps->pcr_cnt == 0) {
+            ps->discont_before_pcr = true;
+        }
     }
     if (pkt.hasPCR()) {
         uint64_t pcr(pkt.getPCR());
         // Count PID's with PCR
-        if (ps->pcr_cnt++ == 0)
+        if (ps->pcr_cnt++ == 0) {
             _pcr_pid_cnt++;
+            ps->first_pcr = pcr;
+            ps->first_pcr_pkt = packet_index;
+        }
         // If last PCR valid, compute transport rate between the two
         if (ps->last_pcr != 0 && ps->last_pcr < pcr) {
             // Compute transport rate in b/s since last PCR
@@ -1402,6 +1801,160 @@ void ts::TSAnalyzer::feedPacket(const TSPacket& pkt)
 }
 
 
+//----------------------------------------------------------------------------
+// Feed the analyzer with a TS packet which precedes the analyzed part.
+//----------------------------------------------------------------------------
+
+void ts::TSAnalyzer::feedPrecedingPacket(const TSPacket& pkt)
+{
+    // Keep track of errors for suspect packet detection.
+    if (!pkt.hasValidSync() || pkt.getTEI()) {
+        _preceding_errors++;
+        _preceding_suspects = 0;
+        return;
+    }
+    _preceding_errors = 0;
+    _preceding_suspects = 0;
+
+    // Make sure the PID is known, it is not suspect in the analyzed part.
+    getPIDContext(pkt.getPID());
+
+    // Feed packets into the various demux, the handlers do not count anything.
+    _preceding = true;
+    _demux.feedPacket(pkt);
+    _pes_demux.feedPacket(pkt);
+    _t2mi_demux.feedPacket(pkt);
+    _preceding = false;
+}
+
+
+//----------------------------------------------------------------------------
+// Merge the analysis of the next part of the stream.
+//----------------------------------------------------------------------------
+
+void ts::TSAnalyzer::merge(const TSAnalyzer& next)
+{
+    // Packet indexes in the next analyzer are relative to the start of the next part.
+    const uint64_t packet_offset = _ts_pkt_cnt;
+
+    _modified = true;
+    _full_recompute = true;
+    _ts_pkt_cnt += next._ts_pkt_cnt;
+    _invalid_sync += next._invalid_sync;
+    _transport_errors += next._transport_errors;
+    _suspect_ignored += next._suspect_ignored;
+    _ts_bitrate_sum += next._ts_bitrate_sum;
+    _ts_bitrate_cnt += next._ts_bitrate_cnt;
+    _scrambled_pkt_cnt += next._scrambled_pkt_cnt;
+    _unexp_discont += next._unexp_discont;
+    _duplicated += next._duplicated;
+    _preceding_errors = next._preceding_errors;
+    _preceding_suspects = next._preceding_suspects;
+    _tid_present |= next._tid_present;
+
+    if (next._ts_id_valid) {
+        _ts_id = next._ts_id;
+        _ts_id_valid = true;
+    }
+    if (_first_utc == Time::Epoch) {
+        _first_utc = next._first_utc;
+        _first_local = next._first_local;
+    }
+    if (_first_tdt == Time::Epoch) {
+        _first_tdt = next._first_tdt;
+    }
+    if (next._last_tdt != Time::Epoch) {
+        _last_tdt = next._last_tdt;
+    }
+    if (_first_tot == Time::Epoch) {
+        _first_tot = next._first_tot;
+        _country_code = next._country_code;
+    }
+    if (next._last_tot != Time::Epoch) {
+        _last_tot = next._last_tot;
+    }
+
+    for (ServiceContextMap::const_iterator it = next._services.begin(); it != next._services.end(); ++it) {
+        getService(it->first)->merge(*it->second);
+    }
+
+    for (PIDContextMap::const_iterator it = next._pids.begin(); it != next._pids.end(); ++it) {
+        const PIDContext& npc(*it->second);
+        const PIDContextPtr pc(getPID(it->first, npc.description));
+        const bool scrambled = pc->scrambled;
+        const bool has_pcr = pc->pcr_cnt > 0;
+        const uint64_t bitrate_sum = pc->ts_bitrate_sum + npc.ts_bitrate_sum;
+        const uint64_t bitrate_cnt = pc->ts_bitrate_cnt + npc.ts_bitrate_cnt;
+        const uint64_t unexp_discont = pc->unexp_discont + npc.unexp_discont;
+        const uint64_t duplicated = pc->duplicated + npc.duplicated;
+
+        pc->merge(npc, packet_offset);
+
+        // Events which are detected across the boundary of the two parts are also global events.
+        _ts_bitrate_sum += pc->ts_bitrate_sum - bitrate_sum;
+        _ts_bitrate_cnt += pc->ts_bitrate_cnt - bitrate_cnt;
+        _unexp_discont += pc->unexp_discont - unexp_discont;
+        _duplicated += pc->duplicated - duplicated;
+        if (!scrambled && pc->scrambled) {
+            _scrambled_pid_cnt++;
+        }
+        if (!has_pcr && pc->pcr_cnt > 0) {
+            _pcr_pid_cnt++;
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Snapshot of the global counters.
+//----------------------------------------------------------------------------
+
+ts::TSAnalyzer::Snapshot::Snapshot() :
+    ts_pkt_cnt(0),
+    invalid_sync(0),
+    transport_errors(0),
+    suspect_ignored(0),
+    scrambled_pkt_cnt(0),
+    unexp_discont(0),
+    duplicated(0),
+    ts_bitrate_sum(0),
+    ts_bitrate_cnt(0)
+{
+}
+
+ts::TSAnalyzer::Snapshot& ts::TSAnalyzer::Snapshot::operator-=(const Snapshot& older)
+{
+    ts_pkt_cnt -= older.ts_pkt_cnt;
+    invalid_sync -= older.invalid_sync;
+    transport_errors -= older.transport_errors;
+    suspect_ignored -= older.suspect_ignored;
+    scrambled_pkt_cnt -= older.scrambled_pkt_cnt;
+    unexp_discont -= older.unexp_discont;
+    duplicated -= older.duplicated;
+    ts_bitrate_sum -= older.ts_bitrate_sum;
+    ts_bitrate_cnt -= older.ts_bitrate_cnt;
+    return *this;
+}
+
+ts::BitRate ts::TSAnalyzer::Snapshot::pcrBitrate() const
+{
+    return ts_bitrate_cnt == 0 ? 0 : BitRate(ts_bitrate_sum / ts_bitrate_cnt);
+}
+
+void ts::TSAnalyzer::getSnapshot(Snapshot& snapshot) const
+{
+    snapshot.ts_pkt_cnt = _ts_pkt_cnt;
+    snapshot.invalid_sync = _invalid_sync;
+    snapshot.transport_errors = _transport_errors;
+    snapshot.suspect_ignored = _suspect_ignored;
+    snapshot.scrambled_pkt_cnt = _scrambled_pkt_cnt;
+    snapshot.unexp_discont = _unexp_discont;
+    snapshot.duplicated = _duplicated;
+    snapshot.ts_bitrate_sum = _ts_bitrate_sum;
+    snapshot.ts_bitrate_cnt = _ts_bitrate_cnt;
+}
+
+
 //----------------------------------------------------------------------------
 // Specify a "bitrate hint" for the analysis. It is the user-specified
 // bitrate in bits/seconds, based on 188-byte packets. The bitrate is
@@ -1436,76 +1989,119 @@ void ts::TSAnalyzer::recomputeStatistics()
     _ts_bitrate = _ts_user_bitrate != 0 ? _ts_user_bitrate : _ts_pcr_bitrate_188;
     _duration = _ts_bitrate == 0 ? 0 : (8000 * PKT_SIZE * uint64_t(_ts_pkt_cnt)) / _ts_bitrate;
 
-    // Reinitialize all service information that will be updated PID by PID
-    for (ServiceContextMap::iterator it = _services.begin(); it != _services.end(); ++it) {
-        it->second->pid_cnt = 0;
-        it->second->ts_pkt_cnt = 0;
-        it->second->scrambled_pid_cnt = 0;
-    }
+    if (_full_recompute) {
+        // The structure of the stream has changed, recompute all services and global information.
 
-    // Complete all PID information
+        // Reinitialize all service information that will be updated PID by PID
+        for (ServiceContextMap::iterator it = _services.begin(); it != _services.end(); ++it) {
+            it->second->pid_cnt = 0;
+            it->second->ts_pkt_cnt = 0;
+            it->second->scrambled_pid_cnt = 0;
+        }
 
-    _pid_cnt = 0;
-    _global_pid_cnt = 0;
-    _global_pkt_cnt = 0;
-    _global_scr_pids = 0;
-    _unref_pid_cnt = 0;
-    _unref_pkt_cnt = 0;
-    _unref_scr_pids = 0;
+        _pid_cnt = 0;
+        _global_pid_cnt = 0;
+        _global_pkt_cnt = 0;
+        _global_scr_pids = 0;
+        _unref_pid_cnt = 0;
+        _unref_pkt_cnt = 0;
+        _unref_scr_pids = 0;
+
+        for (PIDContextMap::iterator pci = _pids.begin(); pci != _pids.end(); ++pci) {
+            PIDContext& pc(*pci->second);
+
+            // If the PID belongs to some services, update services info.
+            pc.service_contexts.clear();
+            for (ServiceIdSet::iterator it = pc.services.begin(); it != pc.services.end(); ++it) {
+                ServiceContext* const scp = getService(*it).pointer();
+                pc.service_contexts.push_back(scp);
+                scp->pid_cnt++;
+                scp->ts_pkt_cnt += pc.ts_pkt_cnt;
+                if (pc.scrambled) {
+                    scp->scrambled_pid_cnt++;
+                }
+            }
+            pc.stats_pkt_cnt = pc.ts_pkt_cnt;
 
-    for (PIDContextMap::iterator pci = _pids.begin(); pci != _pids.end(); ++pci) {
-        PIDContext& pc(*pci->second);
+            // Enforce PES when carrying audio or video
+            pc.carry_pes = pc.carry_pes || pc.carry_audio || pc.carry_video;
 
-        // Compute TS bitrate from the PCR's of this PID
-        if (pc.ts_bitrate_cnt != 0) {
-            pc.ts_pcr_bitrate = uint32_t(pc.ts_bitrate_sum / pc.ts_bitrate_cnt);
-        }
+            // Count non-empty PID's
+            if (pc.ts_pkt_cnt != 0) {
+                _pid_cnt++;
+            }
+
+            // Count unreferenced PID's
+            if (!pc.referenced && pc.ts_pkt_cnt != 0) {
+                _unref_pid_cnt++;
+                _unref_pkt_cnt += pc.ts_pkt_cnt;
+                if (pc.scrambled) {
+                    _unref_scr_pids++;
+                }
+            }
 
-        // Compute average PID bitrate
-        if (_ts_pkt_cnt != 0) {
-            pc.bitrate = uint32_t((uint64_t(_ts_bitrate) * uint64_t(pc.ts_pkt_cnt)) / uint64_t(_ts_pkt_cnt));
+            // Count global PID's
+            if (pc.referenced && pc.services.size() == 0 && pc.ts_pkt_cnt != 0) {
+                _global_pid_cnt++;
+                _global_pkt_cnt += pc.ts_pkt_cnt;
+                if (pc.scrambled) {
+                    _global_scr_pids++;
+                }
+            }
         }
 
-        // Compute average crypto-period for this PID
-        // Remember that first crypto-period was ignored.
-        if (pc.cryptop_cnt > 1) {
-            pc.crypto_period = pc.cryptop_ts_cnt / (pc.cryptop_cnt - 1);
+        // Count scrambled services
+        _scrambled_services_cnt = 0;
+        for (ServiceContextMap::iterator sci = _services.begin(); sci != _services.end(); ++sci) {
+            if (sci->second->scrambled_pid_cnt > 0) {
+                _scrambled_services_cnt++;
+            }
         }
 
-        // If the PID belongs to some services, update services info.
-        for (ServiceIdSet::iterator it = pc.services.begin(); it != pc.services.end(); ++it) {
-            ServiceContextPtr scp(getService(*it));
-            scp->pid_cnt++;
-            scp->ts_pkt_cnt += pc.ts_pkt_cnt;
-            if (pc.scrambled) {
-                scp->scrambled_pid_cnt++;
+        // All PID's need to be recomputed.
+        _modified_pids.assign(_pid_list.begin(), _pid_list.end());
+        _full_recompute = false;
+    }
+    else {
+        // Same structure, only accumulate the new packets of the modified PID's.
+        for (std::vector<PIDContext*>::const_iterator pci = _modified_pids.begin(); pci != _modified_pids.end(); ++pci) {
+            PIDContext& pc(**pci);
+            const uint64_t count = pc.ts_pkt_cnt - pc.stats_pkt_cnt;
+            pc.stats_pkt_cnt = pc.ts_pkt_cnt;
+            for (std::vector<ServiceContext*>::const_iterator it = pc.service_contexts.begin(); it != pc.service_contexts.end(); ++it) {
+                (*it)->ts_pkt_cnt += count;
+            }
+            if (!pc.referenced) {
+                _unref_pkt_cnt += count;
+            }
+            else if (pc.services.empty()) {
+                _global_pkt_cnt += count;
             }
         }
+    }
 
-        // Enforce PES when carrying audio or video
-        pc.carry_pes = pc.carry_pes || pc.carry_audio || pc.carry_video;
+    // Compute PID statistics which depend on the packets of this PID.
+    for (std::vector<PIDContext*>::const_iterator pci = _modified_pids.begin(); pci != _modified_pids.end(); ++pci) {
+        PIDContext& pc(**pci);
+        pc.modified = false;
 
-        // Count non-empty PID's
-        if (pc.ts_pkt_cnt != 0) {
-            _pid_cnt++;
+        // Compute TS bitrate from the PCR's of this PID
+        if (pc.ts_bitrate_cnt != 0) {
+            pc.ts_pcr_bitrate = uint32_t(pc.ts_bitrate_sum / pc.ts_bitrate_cnt);
         }
 
-        // Count unreferenced PID's
-        if (!pc.referenced && pc.ts_pkt_cnt != 0) {
-            _unref_pid_cnt++;
-            _unref_pkt_cnt += pc.ts_pkt_cnt;
-            if (pc.scrambled) {
-                _unref_scr_pids++;
-            }
+        // Compute average crypto-period for this PID
+        // Remember that first crypto-period was ignored.
+        if (pc.cryptop_cnt > 1) {
+            pc.crypto_period = pc.cryptop_ts_cnt / (pc.cryptop_cnt - 1);
         }
+    }
+    _modified_pids.clear();
 
-        // Count global PID's
-        if (pc.referenced && pc.services.size() == 0 && pc.ts_pkt_cnt != 0) {
-            _global_pid_cnt++;
-            _global_pkt_cnt += pc.ts_pkt_cnt;
-            if (pc.scrambled) {
-                _global_scr_pids++;
-            }
+    // Compute average PID bitrates, they depend on the global bitrate.
+    if (_ts_pkt_cnt != 0) {
+        for (std::vector<PIDContext*>::const_iterator pci = _pid_list.begin(); pci != _pid_list.end(); ++pci) {
+            (*pci)->bitrate = uint32_t((uint64_t(_ts_bitrate) * uint64_t((*pci)->ts_pkt_cnt)) / uint64_t(_ts_pkt_cnt));
         }
     }
 
@@ -1516,15 +2112,8 @@ void ts::TSAnalyzer::recomputeStatistics()
     }
 
     // Complete all service information
-    _scrambled_services_cnt = 0;
-
     for (ServiceContextMap::iterator sci = _services.begin(); sci != _services.end(); ++sci) {
 
-        // Count scrambled services
-        if (sci->second->scrambled_pid_cnt > 0) {
-            _scrambled_services_cnt++;
-        }
-
         // Compute average service bitrate
         if (_ts_pkt_cnt == 0) {
             sci->second->bitrate = 0;
@@ -80,6 +80,35 @@ namespace ts {
         //!
         void feedPacket(const TSPacket& packet);
 
+        //!
+        //! Feed the analyzer with a TS packet which precedes the analyzed part of the stream.
+        //!
+        //! When a large stream is split into contiguous parts which are analyzed in parallel
+        //! by distinct analyzers, the last packets of the previous part are passed to this
+        //! method before the first packet of the part is passed to feedPacket(). These
+        //! packets are processed by the section and PES demuxes only. They are not counted
+        //! but they provide the PSI/SI structure of the stream and the beginning of the
+        //! sections and PES packets which overlap the two parts.
+        //!
+        //! @param [in] packet One TS packet from the stream, before the analyzed part.
+        //! @see merge()
+        //!
+        void feedPrecedingPacket(const TSPacket& packet);
+
+        //!
+        //! Merge the analysis of the next part of the stream.
+        //!
+        //! The packets of the stream which were analyzed by @a next immediately follow the
+        //! packets which were analyzed by this object. Packet counters are summed, PSI/SI
+        //! information is combined and the continuity counters, PCR's and crypto-periods
+        //! are checked across the boundary of the two parts, as if all packets had been
+        //! passed to this object.
+        //!
+        //! @param [in] next Analyzer of the next part of the stream.
+        //! @see feedPrecedingPacket()
+        //!
+        void merge(const TSAnalyzer& next);
+
         //!
         //! Reset the analysis context.
         //!
@@ -117,6 +146,44 @@ namespace ts {
             _max_consecutive_suspects = count;
         }
 
+        //!
+        //! Set the validation of the CRC32 of the analyzed sections.
+        //! @param [in] crc_op How to process the CRC32 of long sections.
+        //! Initially set to CRC32::CHECK.
+        //!
+        void setCRCValidation(CRC32::Validation crc_op)
+        {
+            _demux.setCRCValidation(crc_op);
+        }
+
+        //!
+        //! Set the maximum number of tables which are individually analyzed in each PID.
+        //! When a new table (TID and TID-extension) appears in a PID which already has this
+        //! number of tables, the table which did not receive any section for the longest time
+        //! is dropped from the analysis. This keeps the memory usage bounded in long-running
+        //! analyses of streams with a high churn of tables such as EIT schedule.
+        //! @param [in] count Maximum number of tables per PID. Zero means unlimited (the default).
+        //!
+        void setMaxTablesPerPID(size_t count)
+        {
+            _max_etid_per_pid = count;
+        }
+
+        //!
+        //! Drop the analysis contexts which became inactive.
+        //!
+        //! This method is designed to be called at regular intervals in long-running analyses
+        //! which are never reset. The PID's which received no packet and the tables which received
+        //! no section during the last @a max_idle calls are removed from the analysis, as well as
+        //! the services which no longer have any PID. The reserved PID's (PSI/SI and null PID)
+        //! are never removed. The packets of the removed PID's remain accounted in the global
+        //! TS counters.
+        //!
+        //! @param [in] max_idle Number of consecutive calls without activity after which a context
+        //! is removed. Zero means that contexts are never removed.
+        //!
+        void pruneIdleContexts(size_t max_idle);
+
         //!
         //! Get the list of service ids.
         //! @param [out] list The returned list of service ids.
@@ -155,6 +222,52 @@ namespace ts {
         //!
         void getPIDsWithPES(std::vector<PID>& list);
 
+        //!
+        //! Snapshot of the global counters of the analysis.
+        //!
+        //! Getting a snapshot has a constant cost, regardless of the number of PID's and services.
+        //! The difference between two snapshots gives the statistics over the interval between them.
+        //! Keeping the last snapshots gives the statistics over a sliding window.
+        //!
+        class TSDUCKDLL Snapshot
+        {
+        public:
+            PacketCounter ts_pkt_cnt;         //!< Number of TS packets.
+            PacketCounter invalid_sync;       //!< Number of packets with invalid sync byte (not 0x47).
+            PacketCounter transport_errors;   //!< Number of packets with transport error.
+            PacketCounter suspect_ignored;    //!< Number of suspect packets, ignored.
+            PacketCounter scrambled_pkt_cnt;  //!< Number of scrambled packets.
+            PacketCounter unexp_discont;      //!< Number of unexpected discontinuities in all PID's.
+            PacketCounter duplicated;         //!< Number of duplicated packets in all PID's.
+            uint64_t      ts_bitrate_sum;     //!< Sum of all TS bitrates computed from PCR's.
+            uint64_t      ts_bitrate_cnt;     //!< Number of TS bitrates computed from PCR's.
+
+            //!
+            //! Default constructor.
+            //!
+            Snapshot();
+
+            //!
+            //! Subtract an older snapshot.
+            //! @param [in] older An older snapshot of the same analyzer.
+            //! @return A reference to this object, which now contains the statistics
+            //! over the interval between the two snapshots.
+            //!
+            Snapshot& operator-=(const Snapshot& older);
+
+            //!
+            //! Average transport stream bitrate, computed from PCR's.
+            //! @return The average bitrate in b/s or zero if unknown.
+            //!
+            BitRate pcrBitrate() const;
+        };
+
+        //!
+        //! Get a snapshot of the global counters of the analysis.
+        //! @param [out] snapshot Returned snapshot.
+        //!
+        void getSnapshot(Snapshot& snapshot) const;
+
     protected:
 
         // -------------------
@@ -204,6 +317,12 @@ namespace ts {
             //! @return A displayable provider name.
             //!
             UString getProvider() const;
+
+            //!
+            //! Merge the context of the same service in the next part of the stream.
+            //! @param [in] next Service context from the analysis of the next part of the stream.
+            //!
+            void merge(const ServiceContext& next);
         };
 
         //!
@@ -247,6 +366,11 @@ namespace ts {
             // Public members - Analysis data: Repetition interval evaluation:
             uint64_t   first_pkt;                 //!< Last packet index of first section# 0.
             uint64_t   last_pkt;                  //!< Last packet index of last section# 0.
+            uint64_t   last_section_pkt;          //!< Last packet index of last section, any section number.
+
+            // Public members - Analysis data: Pruning of inactive tables, see TSAnalyzer::pruneIdleContexts().
+            uint64_t   idle_section_cnt;          //!< Value of section_count at last pruning.
+            size_t     idle_cnt;                  //!< Number of consecutive prunings without new section.
 
             //!
             //! Default constructor.
@@ -258,6 +382,13 @@ namespace ts {
             //! Destructor.
             //!
             ~ETIDContext();
+
+            //!
+            //! Merge the context of the same table in the next part of the stream.
+            //! @param [in] next ETID context from the analysis of the next part of the stream.
+            //! @param [in] packet_offset Number of packets before the next part of the stream.
+            //!
+            void merge(const ETIDContext& next, uint64_t packet_offset);
         };
 
         //!
@@ -282,8 +413,51 @@ namespace ts {
         class TSDUCKDLL PIDContext
         {
         public:
-            // Public members - Synthetic data (do not modify outside PIDContext methods)
+            // Public members - Data which are updated by feedPacket() for each packet.
+            // They are grouped at the beginning of the structure so that they share the same few cache lines.
             const PID     pid;             //!< PID value.
+            bool          modified;        //!< Modified since last recomputeStatistics().
+            uint8_t       cur_continuity;  //!< Current continuity count (analysis data).
+            uint8_t       cur_ts_sc;       //!< Current scrambling control in TS header (analysis data).
+            bool          scrambled;       //!< Contains some scrambled packets.
+            bool          same_stream_id;  //!< All PES packets have same stream_id.
+            uint8_t       pes_stream_id;   //!< Stream_id in PES packets on this PID.
+            uint64_t      ts_pkt_cnt;      //!< Number of TS packets.
+            uint64_t      ts_af_cnt;       //!< Number of TS packets with adaptation field.
+            uint64_t      unit_start_cnt;  //!< Number of unit_start in packets.
+            uint64_t      pl_start_cnt;    //!< Number of unit_start & has_payload in packets.
+            uint64_t      ts_sc_cnt;       //!< Number of scrambled packets.
+            uint64_t      inv_ts_sc_cnt;   //!< Number of invalid scrambling control in TS headers.
+            uint64_t      exp_discont;     //!< Number of expected discontinuities.
+            uint64_t      unexp_discont;   //!< Number of unexpected discontinuities.
+            uint64_t      duplicated;      //!< Number of duplicated packets.
+            uint64_t      inv_pes_start;   //!< Number of invalid PES start code.
+            uint64_t      pcr_cnt;         //!< Number of PCR's.
+
+            // Public members - Analysis data: Bitrate evaluation
+            uint64_t      last_pcr;        //!< Last PCR value.
+            uint64_t      last_pcr_pkt;    //!< Index of packet with last PCR.
+            uint64_t      ts_bitrate_sum;  //!< Sum of all computed TS bitrates.
+            uint64_t      ts_bitrate_cnt;  //!< Number of computed TS bitrates.
+            // Public members - Analysis data: Crypto-period evaluation:
+            uint64_t      cur_ts_sc_pkt;   //!< First packet index of current crypto-period.
+            uint64_t      cryptop_cnt;     //!< Number of crypto-periods.
+            uint64_t      cryptop_ts_cnt;  //!< Number of TS packets in all crypto-periods.
+            // Public members - Analysis data: Merging of analyses, see TSAnalyzer::merge().
+            uint64_t      first_pkt;       //!< Packet index of first packet.
+            uint8_t       first_cc;        //!< Continuity counter in first packet.
+            uint8_t       first_ts_sc;     //!< Scrambling control in first packet.
+            bool          first_discont;   //!< First packet has a discontinuity indicator.
+            bool          first_payload;   //!< First packet has a payload.
+            bool          discont_before_pcr; //!< A discontinuity was found before the first PCR.
+            uint64_t      first_pcr;       //!< First PCR value.
+            uint64_t      first_pcr_pkt;   //!< Index of packet with first PCR.
+            uint64_t      first_cryptop_ts; //!< Number of TS packets in first crypto-period (not in cryptop_ts_cnt).
+            // Public members - Analysis data: Pruning of inactive PID's, see TSAnalyzer::pruneIdleContexts().
+            uint64_t      idle_pkt_cnt;    //!< Value of ts_pkt_cnt at last pruning.
+            size_t        idle_cnt;        //!< Number of consecutive prunings without new packet.
+
+            // Public members - Synthetic data (do not modify outside PIDContext methods)
             UString       description;     //!< Readable description string (ie "MPEG-2 Audio").
             UString       comment;         //!< Additional description (ie language).
             UStringVector attributes;      //!< Audio or video attributes (several lines if attributes changed).
@@ -299,23 +473,9 @@ namespace ts {
             bool          carry_audio;     //!< This PID carries audio data.
             bool          carry_video;     //!< This PID carries video data.
             bool          carry_t2mi;      //!< Carry T2-MI encasulated data.
-            bool          scrambled;       //!< Contains some scrambled packets.
-            bool          same_stream_id;  //!< All PES packets have same stream_id.
-            uint8_t       pes_stream_id;   //!< Stream_id in PES packets on this PID.
-            uint64_t      ts_pkt_cnt;      //!< Number of TS packets.
-            uint64_t      ts_af_cnt;       //!< Number of TS packets with adaptation field.
-            uint64_t      unit_start_cnt;  //!< Number of unit_start in packets.
-            uint64_t      pl_start_cnt;    //!< Number of unit_start & has_payload in packets.
             uint64_t      pmt_cnt;         //!< Number of PMT (for PMT PID's).
             uint64_t      crypto_period;   //!< Average number of TS packets per crypto-period.
-            uint64_t      unexp_discont;   //!< Number of unexpected discontinuities.
-            uint64_t      exp_discont;     //!< Number of expected discontinuities.
-            uint64_t      duplicated;      //!< Number of duplicated packets.
-            uint64_t      ts_sc_cnt;       //!< Number of scrambled packets.
-            uint64_t      inv_ts_sc_cnt;   //!< Number of invalid scrambling control in TS headers.
-            uint64_t      inv_pes_start;   //!< Number of invalid PES start code.
             uint64_t      t2mi_cnt;        //!< Number of T2-MI packets.
-            uint64_t      pcr_cnt;         //!< Number of PCR's.
             uint32_t      ts_pcr_bitrate;  //!< Average TS bitrate in b/s (eval from PCR).
             uint32_t      bitrate;         //!< Average PID bitrate in b/s.
             UString       language;        //!< For audio or subtitles (3 chars).
@@ -325,18 +485,9 @@ namespace ts {
             std::set<uint32_t>         ssu_oui;       //!< Set of applicable OUI's for SSU.
             std::map<uint8_t,uint64_t> t2mi_plp_ts;   //!< For T2-MI streams, map key = PLP (Physical Layer Pipe) to value = number of embedded TS packets.
 
-            // Public members - Analysis data:
-            uint8_t        cur_continuity;  //!< Current continuity count.
-            // Public members - Analysis data: Crypto-period evaluation:
-            uint8_t        cur_ts_sc;       //!< Current scrambling control in TS header.
-            uint64_t       cur_ts_sc_pkt;   //!< First packet index of current crypto-period.
-            uint64_t       cryptop_cnt;     //!< Number of crypto-periods.
-            uint64_t       cryptop_ts_cnt;  //!< Number of TS packets in all crypto-periods.
-            // Public members - Analysis data: Bitrate evaluation
-            uint64_t       last_pcr;        //!< Last PCR value.
-            uint64_t       last_pcr_pkt;    //!< Index of packet with last PCR.
-            uint64_t       ts_bitrate_sum;  //!< Sum of all computed TS bitrates.
-            uint64_t       ts_bitrate_cnt;  //!< Number of computed TS bitrates.
+            // Public members - Statistics data, see TSAnalyzer::recomputeStatistics().
+            uint64_t      stats_pkt_cnt;   //!< Number of TS packets which are accounted in services and global statistics.
+            std::vector<ServiceContext*> service_contexts; //!< Contexts of the services the PID belongs to.
 
             //!
             //! Default constructor.
@@ -363,6 +514,29 @@ namespace ts {
             //!
             UString fullDescription(bool include_attributes) const;
 
+            //!
+            //! Account for the end of a crypto-period.
+            //! The first crypto-period is truncated and not significant, it is not accumulated.
+            //! @param [in] length Number of TS packets in the crypto-period.
+            //!
+            void addCryptoPeriod(uint64_t length)
+            {
+                if (cryptop_cnt++ == 0) {
+                    first_cryptop_ts = length;
+                }
+                else {
+                    cryptop_ts_cnt += length;
+                }
+            }
+
+            //!
+            //! Merge the context of the same PID in the next part of the stream.
+            //! The packet analysis is continued across the boundary of the two parts.
+            //! @param [in] next PID context from the analysis of the next part of the stream.
+            //! @param [in] packet_offset Number of packets before the next part of the stream.
+            //!
+            void merge(const PIDContext& next, uint64_t packet_offset);
+
         private:
             // Unreachable constructor:
             PIDContext();
@@ -375,6 +549,7 @@ namespace ts {
 
         //!
         //! Map of PIDContext, indexed by PID.
+        //! Used for reporting. During the analysis, the PID contexts are accessed through a flat array.
         //!
         typedef std::map <PID, PIDContextPtr> PIDContextMap;
 
@@ -386,6 +561,9 @@ namespace ts {
 
         //!
         //! Update the global statistics value if internal data were modified.
+        //! A complete recomputation is performed only when the PSI/SI structure of the
+        //! stream has changed. Otherwise, only the PID's which received packets since
+        //! the previous call are accumulated in the services and global statistics.
         //!
         void recomputeStatistics();
 
@@ -432,18 +610,34 @@ namespace ts {
         // Constant string "Unreferenced"
         static const UString UNREFERENCED;
 
+        // The audio and video attributes are found in the first bytes of the PES packets.
+        static const size_t PES_ANALYSIS_SIZE = 8192;
+
+        // The audio and video attributes are sampled, milliseconds between samples.
+        static const MilliSecond PES_SAMPLING_INTERVAL = 5000;
+
         // Check if a PID context exists.
-        bool pidExists(PID pid) const {return _pids.find(pid) != _pids.end();}
+        bool pidExists(PID pid) const {return _pid_index[pid & (PID_MAX - 1)] != 0;}
 
         // Return a PID context. Allocate a new entry if PID not found.
         PIDContextPtr getPID(PID pid, const UString& description = UNREFERENCED);
 
+        // Same as getPID() without safe pointer copy, for per-packet processing.
+        PIDContext* getPIDContext(PID pid)
+        {
+            PIDContext* pc = _pid_index[pid & (PID_MAX - 1)];
+            return pc != 0 ? pc : getPID(pid).pointer();
+        }
+
         // Return an ETID context. Allocate a new entry if ETID not found.
         ETIDContextPtr getETID(const Section&);
 
         // Return a service context. Allocate a new entry if service not found.
         ServiceContextPtr getService(uint16_t service_id);
 
+        // Add the PID filters to collect PSI tables.
+        void addGlobalPIDs();
+
         // Analyze the various PSI tables
         void analyzePAT(const PAT&);
         void analyzeCAT(const CAT&);
@@ -491,5 +685,14 @@ namespace ts {
         SectionDemux _demux;                     // PSI tables analysis
         PESDemux     _pes_demux;                 // Audio/video analysis
         T2MIDemux    _t2mi_demux;                // T2-MI analysis
+        bool         _preceding;                 // Processing packets before the analyzed part, see feedPrecedingPacket()
+        bool         _full_recompute;            // PID's or services structure modified, need a complete recomputeStatistics
+        uint64_t     _scrambled_pkt_cnt;         // Number of scrambled packets
+        uint64_t     _unexp_discont;             // Number of unexpected discontinuities in all PID's
+        uint64_t     _duplicated;                // Number of duplicated packets in all PID's
+        std::vector<PIDContext*> _pid_list;      // All PID contexts, owned by _pids
+        std::vector<PIDContext*> _modified_pids; // PID contexts which were modified since last recomputeStatistics
+        PIDContext*  _pid_index[PID_MAX];        // Flat index of PID contexts, owned by _pids
+        size_t       _max_etid_per_pid;          // Max number of ETID contexts per PID, zero means unlimited
     };
 }
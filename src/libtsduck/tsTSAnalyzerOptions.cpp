@@ -46,6 +46,11 @@ void ts::TSAnalyzerOptions::setHelp(const UString& help)
         u"\n"
         u"Controlling analysis:\n"
         u"\n"
+        u"  --ignore-crc32\n"
+        u"      Do not check the CRC32 of the PSI/SI sections. Sections with an incorrect\n"
+        u"      CRC32 are analyzed as if they were correct. This also saves CPU time when\n"
+        u"      the integrity of the input stream is otherwise guaranteed.\n"
+        u"\n"
         u"  --suspect-max-consecutive value\n"
         u"      Specifies the maximum number of consecutive \"suspect\" packets.\n"
         u"      The default value is 1. If set to zero, the suspect packet detection\n"
@@ -159,7 +164,8 @@ ts::TSAnalyzerOptions::TSAnalyzerOptions(const UString& description, const UStri
     prefix(),
     title(),
     suspect_min_error_count(1),
-    suspect_max_consecutive(1)
+    suspect_max_consecutive(1),
+    ignore_crc32(false)
 {
     setHelp(help);
 
@@ -179,6 +185,7 @@ ts::TSAnalyzerOptions::TSAnalyzerOptions(const UString& description, const UStri
     option(u"title", 0, STRING);
     option(u"suspect-min-error-count", 0, UNSIGNED);
     option(u"suspect-max-consecutive", 0, UNSIGNED);
+    option(u"ignore-crc32");
 }
 
 
@@ -206,6 +213,7 @@ void ts::TSAnalyzerOptions::getOptions (const Args& args)
     title = args.value(u"title");
     suspect_min_error_count = args.intValue<uint64_t>(u"suspect-min-error-count", 1);
     suspect_max_consecutive = args.intValue<uint64_t>(u"suspect-max-consecutive", 1);
+    ignore_crc32 = args.present(u"ignore-crc32");
 
     // Default: --ts-analysis --service-analysis --pid-analysis
     if (!ts_analysis &&
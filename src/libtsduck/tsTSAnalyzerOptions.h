@@ -84,6 +84,9 @@ namespace ts {
         uint64_t suspect_min_error_count;  //!< Option -\-suspect-min-error-count
         uint64_t suspect_max_consecutive;  //!< Option -\-suspect-max-consecutive
 
+        // Sections processing
+        bool ignore_crc32;           //!< Option -\-ignore-crc32
+
         // Overriden methods.
         virtual void setHelp(const UString& help) override;
         virtual bool analyze(int argc, char* argv[]) override;
@@ -44,6 +44,7 @@ void ts::TSAnalyzerReport::setAnalysisOptions(const TSAnalyzerOptions& opt)
 {
     setMinErrorCountBeforeSuspect(opt.suspect_min_error_count);
     setMaxConsecutiveSuspectCount(opt.suspect_max_consecutive);
+    setCRCValidation(opt.ignore_crc32 ? CRC32::IGNORE : CRC32::CHECK);
 }
 
 
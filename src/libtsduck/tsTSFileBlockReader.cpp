@@ -0,0 +1,111 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  Block-buffered packet reader over a transport stream file.
+//
+//----------------------------------------------------------------------------
+
+#include "tsTSFileBlockReader.h"
+TSDUCK_SOURCE;
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::TSFileBlockReader::DEFAULT_BLOCK_PACKETS;
+#endif
+
+
+//----------------------------------------------------------------------------
+// Constructor
+//----------------------------------------------------------------------------
+
+ts::TSFileBlockReader::TSFileBlockReader(TSFileInput& file, size_t block_packets) :
+    _file(file),
+    _buffer(std::max<size_t>(block_packets, 1)),
+    _next(0),
+    _count(0),
+    _eof(false),
+    _total(0)
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Make sure that the next packets are available in the internal buffer.
+//----------------------------------------------------------------------------
+
+size_t ts::TSFileBlockReader::peek(size_t count, Report& report)
+{
+    count = std::min(count, _buffer.size());
+
+    if (_count - _next < count && !_eof) {
+
+        // Move the remaining packets at the beginning of the buffer.
+        if (_next > 0) {
+            std::copy(_buffer.begin() + _next, _buffer.begin() + _count, _buffer.begin());
+            _count -= _next;
+            _next = 0;
+        }
+
+        // Fill the rest of the buffer in one large read operation.
+        // TSFileInput::read() returns less than requested only at end of file or on error.
+        const size_t size = _file.read(&_buffer[_count], _buffer.size() - _count, report);
+        _count += size;
+        _eof = _count < _buffer.size();
+    }
+
+    return _count - _next;
+}
+
+
+//----------------------------------------------------------------------------
+// Skip packets.
+//----------------------------------------------------------------------------
+
+void ts::TSFileBlockReader::skip(size_t count)
+{
+    count = std::min(count, _count - _next);
+    _next += count;
+    _total += count;
+}
+
+
+//----------------------------------------------------------------------------
+// Copy the next packets into a user buffer.
+//----------------------------------------------------------------------------
+
+size_t ts::TSFileBlockReader::read(TSPacket* buffer, size_t max_packets, Report& report)
+{
+    size_t done = 0;
+    while (done < max_packets && peek(max_packets - done, report) > 0) {
+        const size_t count = std::min(max_packets - done, available());
+        std::copy(_buffer.begin() + _next, _buffer.begin() + _next + count, buffer + done);
+        skip(count);
+        done += count;
+    }
+    return done;
+}
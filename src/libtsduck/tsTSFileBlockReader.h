@@ -0,0 +1,166 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Block-buffered packet reader over a transport stream file.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsTSFileInput.h"
+
+namespace ts {
+    //!
+    //! Block-buffered packet reader over a transport stream file.
+    //!
+    //! The packets are read from the TSFileInput object in large blocks and
+    //! the application gets direct access to the next packets in the internal
+    //! buffer, without copy. This avoids one I/O operation per packet in
+    //! applications which process the packets one by one.
+    //!
+    //! The TSFileInput object must be opened and closed by the application.
+    //! It must not be read directly while the reader is in use.
+    //!
+    class TSDUCKDLL TSFileBlockReader
+    {
+    public:
+        //!
+        //! Default size of the internal buffer in packets (around 2 MB).
+        //!
+        static const size_t DEFAULT_BLOCK_PACKETS = (2 * 1024 * 1024) / PKT_SIZE;
+
+        //!
+        //! Constructor.
+        //! @param [in,out] file The file to read. It must remain valid during the lifetime of this object.
+        //! @param [in] block_packets Size of the internal buffer in packets. This is also the size of
+        //! each read operation and the maximum number of packets which can be accessed at a time.
+        //!
+        explicit TSFileBlockReader(TSFileInput& file, size_t block_packets = DEFAULT_BLOCK_PACKETS);
+
+        //!
+        //! Get the associated file.
+        //! @return A reference to the associated file.
+        //!
+        TSFileInput& file() const
+        {
+            return _file;
+        }
+
+        //!
+        //! Get the size of the internal buffer.
+        //! @return The size of the internal buffer in packets.
+        //!
+        size_t getBlockSize() const
+        {
+            return _buffer.size();
+        }
+
+        //!
+        //! Make sure that the next packets are available in the internal buffer.
+        //! A new block is read from the file when necessary.
+        //! @param [in] count Requested number of packets. Reduced to the size of the internal buffer.
+        //! @param [in,out] report Where to report errors.
+        //! @return The number of packets which are available in the internal buffer, starting at packets().
+        //! This is less than @a count only at end of file or on error. It can be more than @a count.
+        //!
+        size_t peek(size_t count, Report& report);
+
+        //!
+        //! Get the number of packets which are already available in the internal buffer.
+        //! @return The number of available packets, starting at packets().
+        //!
+        size_t available() const
+        {
+            return _count - _next;
+        }
+
+        //!
+        //! Direct access to the next packets in the internal buffer.
+        //! @return The address of the next packet to read. The pointer is invalidated by the next
+        //! call to peek(), next() or read(). Only available() packets can be accessed.
+        //!
+        const TSPacket* packets() const
+        {
+            return &_buffer[_next];
+        }
+
+        //!
+        //! Skip packets which were accessed using peek() and packets().
+        //! @param [in] count Number of packets to skip. Reduced to the number of available packets.
+        //!
+        void skip(size_t count);
+
+        //!
+        //! Get direct access to the next packet and skip it.
+        //! @param [in,out] report Where to report errors.
+        //! @return The address of the next packet in the internal buffer or zero at end of file
+        //! or on error. The pointer is invalidated by the next call to peek(), next() or read().
+        //!
+        const TSPacket* next(Report& report)
+        {
+            if (_next >= _count && peek(1, report) == 0) {
+                return 0;
+            }
+            _total++;
+            return &_buffer[_next++];
+        }
+
+        //!
+        //! Copy the next packets into a user buffer.
+        //! @param [out] buffer Address of the reception packet buffer.
+        //! @param [in] max_packets Size of @a buffer in packets.
+        //! @param [in,out] report Where to report errors.
+        //! @return The actual number of read packets. Zero on error or end of file.
+        //!
+        size_t read(TSPacket* buffer, size_t max_packets, Report& report);
+
+        //!
+        //! Get the number of packets which were read by the application.
+        //! This does not include the packets which are still in the internal buffer.
+        //! @return The number of packets which were skipped or returned by next() or read().
+        //!
+        PacketCounter getPacketCount() const
+        {
+            return _total;
+        }
+
+    private:
+        TSFileInput&   _file;    // Input file.
+        TSPacketVector _buffer;  // Internal buffer.
+        size_t         _next;    // Index of next packet to read in _buffer.
+        size_t         _count;   // Number of valid packets in _buffer.
+        bool           _eof;     // End of file or error, no more read.
+        PacketCounter  _total;   // Number of packets read by the application.
+
+        // Inaccessible operations
+        TSFileBlockReader() = delete;
+        TSFileBlockReader(const TSFileBlockReader&) = delete;
+        TSFileBlockReader& operator=(const TSFileBlockReader&) = delete;
+    };
+}
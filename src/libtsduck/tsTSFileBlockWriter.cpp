@@ -0,0 +1,140 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  Block-buffered packet writer over a transport stream file.
+//
+//----------------------------------------------------------------------------
+
+#include "tsTSFileBlockWriter.h"
+TSDUCK_SOURCE;
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::TSFileBlockWriter::DEFAULT_BLOCK_PACKETS;
+#endif
+
+
+//----------------------------------------------------------------------------
+// Constructor
+//----------------------------------------------------------------------------
+
+ts::TSFileBlockWriter::TSFileBlockWriter(TSFileOutput& file, size_t block_packets) :
+    _file(file),
+    _buffer(std::max<size_t>(block_packets, 1)),
+    _count(0),
+    _total(0)
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Get direct access to free packets in the internal buffer.
+//----------------------------------------------------------------------------
+
+ts::TSPacket* ts::TSFileBlockWriter::reserve(size_t count, Report& report)
+{
+    count = std::min(count, _buffer.size());
+    if (_buffer.size() - _count < count && !flush(report)) {
+        return 0;
+    }
+    return &_buffer[_count];
+}
+
+
+//----------------------------------------------------------------------------
+// Validate packets which were built in the area returned by reserve().
+//----------------------------------------------------------------------------
+
+void ts::TSFileBlockWriter::commit(size_t count)
+{
+    count = std::min(count, _buffer.size() - _count);
+    _count += count;
+    _total += count;
+}
+
+
+//----------------------------------------------------------------------------
+// Write packets.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileBlockWriter::write(const TSPacket* buffer, size_t count, Report& report)
+{
+    // Large sets of packets are directly written when the buffer is empty.
+    if (_count == 0 && count >= _buffer.size()) {
+        if (!_file.write(buffer, count, report)) {
+            return false;
+        }
+        _total += count;
+        return true;
+    }
+
+    while (count > 0) {
+        if (_count >= _buffer.size() && !flush(report)) {
+            return false;
+        }
+        const size_t n = std::min(count, _buffer.size() - _count);
+        std::copy(buffer, buffer + n, _buffer.begin() + _count);
+        _count += n;
+        _total += n;
+        buffer += n;
+        count -= n;
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Write the same packet several times.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileBlockWriter::fill(const TSPacket& pkt, PacketCounter count, Report& report)
+{
+    while (count > 0) {
+        if (_count >= _buffer.size() && !flush(report)) {
+            return false;
+        }
+        const size_t n = size_t(std::min<PacketCounter>(count, _buffer.size() - _count));
+        std::fill(_buffer.begin() + _count, _buffer.begin() + _count + n, pkt);
+        _count += n;
+        _total += n;
+        count -= n;
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Write all buffered packets to the file.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileBlockWriter::flush(Report& report)
+{
+    const bool ok = _count == 0 || _file.write(&_buffer[0], _count, report);
+    _count = 0;
+    return ok;
+}
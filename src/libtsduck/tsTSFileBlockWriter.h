@@ -0,0 +1,163 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Block-buffered packet writer over a transport stream file.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsTSFileOutput.h"
+
+namespace ts {
+    //!
+    //! Block-buffered packet writer over a transport stream file.
+    //!
+    //! The packets are accumulated in an internal buffer and written to the
+    //! TSFileOutput object in large blocks. The application can also build the
+    //! packets directly in the internal buffer, without copy.
+    //!
+    //! The TSFileOutput object must be opened and closed by the application.
+    //! The buffered packets are not written by the destructor, flush() must be
+    //! called before closing the file.
+    //!
+    class TSDUCKDLL TSFileBlockWriter
+    {
+    public:
+        //!
+        //! Default size of the internal buffer in packets (around 2 MB).
+        //!
+        static const size_t DEFAULT_BLOCK_PACKETS = (2 * 1024 * 1024) / PKT_SIZE;
+
+        //!
+        //! Constructor.
+        //! @param [in,out] file The file to write. It must remain valid during the lifetime of this object.
+        //! @param [in] block_packets Size of the internal buffer in packets. This is also the size
+        //! of each write operation.
+        //!
+        explicit TSFileBlockWriter(TSFileOutput& file, size_t block_packets = DEFAULT_BLOCK_PACKETS);
+
+        //!
+        //! Get the associated file.
+        //! @return A reference to the associated file.
+        //!
+        TSFileOutput& file() const
+        {
+            return _file;
+        }
+
+        //!
+        //! Get the size of the internal buffer.
+        //! @return The size of the internal buffer in packets.
+        //!
+        size_t getBlockSize() const
+        {
+            return _buffer.size();
+        }
+
+        //!
+        //! Get direct access to free packets in the internal buffer.
+        //! The buffer is flushed first if there is not enough free space.
+        //! The packets are written later, after a call to commit().
+        //! @param [in] count Requested number of packets. Reduced to the size of the internal buffer.
+        //! @param [in,out] report Where to report errors.
+        //! @return The address of @a count free packets in the internal buffer or zero on write error.
+        //! The pointer is invalidated by the next call to any other method.
+        //!
+        TSPacket* reserve(size_t count, Report& report);
+
+        //!
+        //! Validate packets which were built in the area returned by reserve().
+        //! @param [in] count Number of packets to validate, at most the value used in reserve().
+        //!
+        void commit(size_t count);
+
+        //!
+        //! Write packets.
+        //! @param [in] buffer Address of first packet to write.
+        //! @param [in] count Number of packets to write.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on error.
+        //!
+        bool write(const TSPacket* buffer, size_t count, Report& report);
+
+        //!
+        //! Write one packet.
+        //! @param [in] pkt The packet to write.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on error.
+        //!
+        bool write(const TSPacket& pkt, Report& report)
+        {
+            if (_count >= _buffer.size() && !flush(report)) {
+                return false;
+            }
+            _buffer[_count++] = pkt;
+            _total++;
+            return true;
+        }
+
+        //!
+        //! Write the same packet several times (typically null packets).
+        //! @param [in] pkt The packet to write.
+        //! @param [in] count Number of times to write @a pkt.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on error.
+        //!
+        bool fill(const TSPacket& pkt, PacketCounter count, Report& report);
+
+        //!
+        //! Write all buffered packets to the file.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on error.
+        //!
+        bool flush(Report& report);
+
+        //!
+        //! Get the number of packets which were written by the application.
+        //! This includes the packets which are still in the internal buffer.
+        //! @return The number of written packets.
+        //!
+        PacketCounter getPacketCount() const
+        {
+            return _total;
+        }
+
+    private:
+        TSFileOutput&  _file;    // Output file.
+        TSPacketVector _buffer;  // Internal buffer.
+        size_t         _count;   // Number of packets in _buffer.
+        PacketCounter  _total;   // Number of packets written by the application.
+
+        // Inaccessible operations
+        TSFileBlockWriter() = delete;
+        TSFileBlockWriter(const TSFileBlockWriter&) = delete;
+        TSFileBlockWriter& operator=(const TSFileBlockWriter&) = delete;
+    };
+}
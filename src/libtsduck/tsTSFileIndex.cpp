@@ -0,0 +1,455 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "tsTSFileIndex.h"
+#include "tsTSFileInput.h"
+#include "tsByteBlock.h"
+#include "tsSysUtils.h"
+TSDUCK_SOURCE;
+
+const ts::UChar* const ts::TSFileIndex::DEFAULT_SUFFIX = u".tsidx";
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const ts::MilliSecond ts::TSFileIndex::DEFAULT_SAMPLE_INTERVAL;
+#endif
+
+namespace {
+
+    // Index file format: magic number and version.
+    const uint8_t INDEX_MAGIC[4] = {'T', 'S', 'I', 'X'};
+    const uint8_t INDEX_VERSION = 1;
+
+    // Wrap-up values of PCR and PTS.
+    const uint64_t PCR_WRAP = ts::PTS_DTS_SCALE * ts::SYSTEM_CLOCK_SUBFACTOR;
+    const uint64_t PTS_WRAP = ts::PTS_DTS_SCALE;
+
+    // Larger steps between two consecutive values are discontinuities (10 seconds).
+    const uint64_t PCR_MAX_JUMP = 10 * uint64_t(ts::SYSTEM_CLOCK_FREQ);
+    const uint64_t PTS_MAX_JUMP = 10 * uint64_t(ts::SYSTEM_CLOCK_SUBFREQ);
+
+    // Number of packets which are read at a time when building the index.
+    const size_t BUILD_PACKETS = 1024;
+
+    // Sampling state of PCR or PTS in one PID, while building the index.
+    struct SamplingState
+    {
+        bool     valid;        // A previous value exists.
+        uint64_t last;         // Last value.
+        uint64_t elapsed;      // Elapsed units since first value.
+        uint64_t next_sample;  // Elapsed units of next sample.
+        SamplingState() : valid(false), last(0), elapsed(0), next_sample(0) {}
+    };
+
+    // Accumulate a PCR or PTS value, add a sample when the interval is reached.
+    void AddValue(ts::TSFileIndex::SampleVector& samples, SamplingState& state, ts::PacketCounter packet, uint64_t value, uint64_t wrap, uint64_t max_jump, uint64_t interval)
+    {
+        if (state.valid) {
+            const uint64_t delta = (value + wrap - state.last) % wrap;
+            if (delta <= max_jump) {
+                // Normal progression.
+                state.elapsed += delta;
+                state.last = value;
+            }
+            else if (wrap - delta <= max_jump) {
+                // Slightly backward (PTS of reordered pictures for instance), ignored.
+                return;
+            }
+            else {
+                // Discontinuity, the elapsed time is unchanged.
+                state.last = value;
+            }
+        }
+        else {
+            state.valid = true;
+            state.last = value;
+        }
+        if (state.elapsed >= state.next_sample) {
+            samples.push_back(ts::TSFileIndex::Sample(packet, value, state.elapsed));
+            state.next_sample = state.elapsed + interval;
+        }
+    }
+
+    // Variable-length encoding of unsigned integers, 7 bits per byte, low-order bits first.
+    void AppendVarInt(ts::ByteBlock& bb, uint64_t value)
+    {
+        while (value >= 0x80) {
+            bb.appendUInt8(uint8_t(value & 0x7F) | 0x80);
+            value >>= 7;
+        }
+        bb.appendUInt8(uint8_t(value));
+    }
+
+    bool GetVarInt(const ts::ByteBlock& bb, size_t& index, uint64_t& value)
+    {
+        value = 0;
+        for (size_t shift = 0; index < bb.size() && shift < 64; shift += 7) {
+            const uint8_t b = bb[index++];
+            value |= uint64_t(b & 0x7F) << shift;
+            if ((b & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Serialization of sample vectors and packet index vectors.
+    void AppendSamples(ts::ByteBlock& bb, const ts::TSFileIndex::SampleVector& samples)
+    {
+        AppendVarInt(bb, samples.size());
+        ts::PacketCounter packet = 0;
+        uint64_t elapsed = 0;
+        for (ts::TSFileIndex::SampleVector::const_iterator it = samples.begin(); it != samples.end(); ++it) {
+            AppendVarInt(bb, it->packet - packet);
+            AppendVarInt(bb, it->value);
+            AppendVarInt(bb, it->elapsed - elapsed);
+            packet = it->packet;
+            elapsed = it->elapsed;
+        }
+    }
+
+    void AppendPackets(ts::ByteBlock& bb, const ts::TSFileIndex::PacketIndexVector& packets)
+    {
+        AppendVarInt(bb, packets.size());
+        ts::PacketCounter packet = 0;
+        for (ts::TSFileIndex::PacketIndexVector::const_iterator it = packets.begin(); it != packets.end(); ++it) {
+            AppendVarInt(bb, *it - packet);
+            packet = *it;
+        }
+    }
+
+    bool GetSamples(const ts::ByteBlock& bb, size_t& index, ts::TSFileIndex::SampleVector& samples)
+    {
+        uint64_t count = 0;
+        if (!GetVarInt(bb, index, count) || count > bb.size() - index) {
+            return false;
+        }
+        samples.resize(size_t(count));
+        ts::PacketCounter packet = 0;
+        uint64_t elapsed = 0;
+        for (size_t i = 0; i < samples.size(); ++i) {
+            uint64_t dpacket = 0, value = 0, delapsed = 0;
+            if (!GetVarInt(bb, index, dpacket) || !GetVarInt(bb, index, value) || !GetVarInt(bb, index, delapsed)) {
+                return false;
+            }
+            packet += dpacket;
+            elapsed += delapsed;
+            samples[i] = ts::TSFileIndex::Sample(packet, value, elapsed);
+        }
+        return true;
+    }
+
+    bool GetPackets(const ts::ByteBlock& bb, size_t& index, ts::TSFileIndex::PacketIndexVector& packets)
+    {
+        uint64_t count = 0;
+        if (!GetVarInt(bb, index, count) || count > bb.size() - index) {
+            return false;
+        }
+        packets.resize(size_t(count));
+        ts::PacketCounter packet = 0;
+        for (size_t i = 0; i < packets.size(); ++i) {
+            uint64_t dpacket = 0;
+            if (!GetVarInt(bb, index, dpacket)) {
+                return false;
+            }
+            packet += dpacket;
+            packets[i] = packet;
+        }
+        return true;
+    }
+
+    // Compare samples by elapsed units.
+    bool LessElapsed(const ts::TSFileIndex::Sample& s, uint64_t elapsed)
+    {
+        return s.elapsed < elapsed;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Constructor.
+//----------------------------------------------------------------------------
+
+ts::TSFileIndex::TSFileIndex() :
+    _file_size(0),
+    _file_time(Time::Epoch),
+    _packet_count(0),
+    _pcr_pid(PID_NULL),
+    _pids()
+{
+}
+
+void ts::TSFileIndex::clear()
+{
+    _file_size = 0;
+    _file_time = Time::Epoch;
+    _packet_count = 0;
+    _pcr_pid = PID_NULL;
+    _pids.clear();
+}
+
+
+//----------------------------------------------------------------------------
+// Index file names.
+//----------------------------------------------------------------------------
+
+ts::UString ts::TSFileIndex::IndexFileName(const UString& filename)
+{
+    return filename + DEFAULT_SUFFIX;
+}
+
+bool ts::TSFileIndex::isUpToDate(const UString& filename) const
+{
+    return GetFileSize(filename) == _file_size && GetFileModificationTimeUTC(filename) == _file_time;
+}
+
+
+//----------------------------------------------------------------------------
+// Build the index by scanning a transport stream file.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileIndex::build(const UString& filename, Report& report, MilliSecond interval)
+{
+    clear();
+
+    // Get file characteristics before reading it.
+    _file_size = GetFileSize(filename);
+    _file_time = GetFileModificationTimeUTC(filename);
+
+    TSFileInput file;
+    if (!file.open(filename, 1, 0, report)) {
+        return false;
+    }
+
+    const uint64_t pcr_interval = uint64_t(interval) * (SYSTEM_CLOCK_FREQ / MilliSecPerSec);
+    const uint64_t pts_interval = uint64_t(interval) * (SYSTEM_CLOCK_SUBFREQ / MilliSecPerSec);
+    std::vector<SamplingState> pcr_states(PID_MAX);
+    std::vector<SamplingState> pts_states(PID_MAX);
+    TSPacketVector buffer(BUILD_PACKETS);
+    size_t count = 0;
+
+    while ((count = file.read(&buffer[0], buffer.size(), report)) > 0) {
+        for (size_t i = 0; i < count; ++i) {
+            const TSPacket& pkt(buffer[i]);
+            const PacketCounter packet = _packet_count++;
+            const bool pcr = pkt.hasPCR();
+            const bool rap = pkt.getRandomAccessIndicator();
+            const bool pusi = pkt.getPUSI();
+            if (!pcr && !rap && !pusi) {
+                continue;
+            }
+            const PID pid = pkt.getPID();
+            PIDIndex& index(_pids[pid]);
+            if (pcr) {
+                if (_pcr_pid == PID_NULL) {
+                    _pcr_pid = pid;
+                }
+                AddValue(index.pcrs, pcr_states[pid], packet, pkt.getPCR(), PCR_WRAP, PCR_MAX_JUMP, pcr_interval);
+            }
+            if (rap) {
+                index.raps.push_back(packet);
+            }
+            if (pusi) {
+                index.pusis.push_back(packet);
+                if (pkt.hasPTS()) {
+                    AddValue(index.ptss, pts_states[pid], packet, pkt.getPTS(), PTS_WRAP, PTS_MAX_JUMP, pts_interval);
+                }
+            }
+        }
+    }
+
+    report.debug(u"indexed %'d packets, %d PID's in %s", {_packet_count, _pids.size(), filename});
+    return file.close(report);
+}
+
+
+//----------------------------------------------------------------------------
+// Save the index in a binary file.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileIndex::save(const UString& filename, Report& report) const
+{
+    ByteBlock bb;
+    bb.append(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    bb.appendUInt8(INDEX_VERSION);
+    bb.appendUInt64(uint64_t(_file_size));
+    bb.appendUInt64(uint64_t(_file_time - Time::Epoch));
+    bb.appendUInt64(_packet_count);
+    bb.appendUInt16(_pcr_pid);
+    bb.appendUInt16(uint16_t(_pids.size()));
+
+    for (PIDIndexMap::const_iterator it = _pids.begin(); it != _pids.end(); ++it) {
+        bb.appendUInt16(it->first);
+        AppendSamples(bb, it->second.pcrs);
+        AppendSamples(bb, it->second.ptss);
+        AppendPackets(bb, it->second.raps);
+        AppendPackets(bb, it->second.pusis);
+    }
+
+    return bb.saveToFile(filename, &report);
+}
+
+
+//----------------------------------------------------------------------------
+// Load the index from a binary file.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileIndex::load(const UString& filename, Report& report)
+{
+    clear();
+
+    ByteBlock bb;
+    if (!bb.loadFromFile(filename, std::numeric_limits<size_t>::max(), &report)) {
+        return false;
+    }
+
+    const size_t header_size = sizeof(INDEX_MAGIC) + 1 + 3 * 8 + 2 * 2;
+    bool ok = bb.size() >= header_size && ::memcmp(bb.data(), INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0 && bb[4] == INDEX_VERSION;
+    if (ok) {
+        _file_size = int64_t(GetUInt64(&bb[5]));
+        _file_time = Time::Epoch + MilliSecond(GetUInt64(&bb[13]));
+        _packet_count = GetUInt64(&bb[21]);
+        _pcr_pid = GetUInt16(&bb[29]);
+        size_t pid_count = GetUInt16(&bb[31]);
+        size_t index = header_size;
+        while (ok && pid_count-- > 0) {
+            ok = index + 2 <= bb.size();
+            if (ok) {
+                PIDIndex& pidx(_pids[GetUInt16(&bb[index])]);
+                index += 2;
+                ok = GetSamples(bb, index, pidx.pcrs) && GetSamples(bb, index, pidx.ptss) && GetPackets(bb, index, pidx.raps) && GetPackets(bb, index, pidx.pusis);
+            }
+        }
+    }
+
+    if (!ok) {
+        report.error(u"invalid index file %s", {filename});
+        clear();
+    }
+    return ok;
+}
+
+
+//----------------------------------------------------------------------------
+// Load the index of a transport stream file from its sidecar file or build it.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileIndex::loadOrBuild(const UString& filename, Report& report, const UString& index_filename)
+{
+    const UString index_name(index_filename.empty() ? IndexFileName(filename) : index_filename);
+
+    if (FileExists(index_name) && load(index_name, report) && isUpToDate(filename)) {
+        report.debug(u"using index file %s", {index_name});
+        return true;
+    }
+
+    report.verbose(u"building index file %s", {index_name});
+    if (!build(filename, report)) {
+        return false;
+    }
+    if (!save(index_name, report)) {
+        report.warning(u"cannot save index file %s", {index_name});
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Find the packet at a given time from the beginning of the file.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileIndex::findTime(MilliSecond time, PacketCounter& packet, PID pid) const
+{
+    const PIDIndexMap::const_iterator it = _pids.find(pid == PID_NULL ? _pcr_pid : pid);
+    if (it == _pids.end() || it->second.pcrs.empty() || time < 0) {
+        return false;
+    }
+
+    // The elapsed units are monotonic: find the last sample at or before the time.
+    const SampleVector& pcrs(it->second.pcrs);
+    const uint64_t elapsed = pcrs.front().elapsed + uint64_t(time) * (SYSTEM_CLOCK_FREQ / MilliSecPerSec);
+    SampleVector::const_iterator s = std::lower_bound(pcrs.begin(), pcrs.end(), elapsed + 1, LessElapsed);
+    if (s != pcrs.begin()) {
+        --s;
+    }
+    packet = s->packet;
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Find the packet with a given PCR or PTS value.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileIndex::findPCR(uint64_t pcr, PacketCounter& packet, PID pid) const
+{
+    const PIDIndexMap::const_iterator it = _pids.find(pid == PID_NULL ? _pcr_pid : pid);
+    return it != _pids.end() && FindValue(it->second.pcrs, pcr, PCR_WRAP, PCR_MAX_JUMP, packet);
+}
+
+bool ts::TSFileIndex::findPTS(uint64_t pts, PacketCounter& packet, PID pid) const
+{
+    const PIDIndexMap::const_iterator it = _pids.find(pid);
+    return it != _pids.end() && FindValue(it->second.ptss, pts, PTS_WRAP, PTS_MAX_JUMP, packet);
+}
+
+bool ts::TSFileIndex::FindValue(const SampleVector& samples, uint64_t value, uint64_t wrap, uint64_t max_jump, PacketCounter& packet)
+{
+    // The values may wrap up or have discontinuities. Find the first sample which
+    // is at or shortly before the value and such that the next one is after it.
+    value %= wrap;
+    for (size_t i = 0; i < samples.size(); ++i) {
+        if ((value + wrap - samples[i].value) % wrap <= max_jump &&
+            (i + 1 >= samples.size() || (value + wrap - samples[i + 1].value) % wrap > max_jump))
+        {
+            packet = samples[i].packet;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+//----------------------------------------------------------------------------
+// Find the next random access point.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileIndex::findRandomAccess(PacketCounter from, PacketCounter& packet, PID pid) const
+{
+    bool found = false;
+    for (PIDIndexMap::const_iterator it = _pids.begin(); it != _pids.end(); ++it) {
+        if (pid == PID_NULL || it->first == pid) {
+            const PacketIndexVector& raps(it->second.raps);
+            const PacketIndexVector::const_iterator r = std::lower_bound(raps.begin(), raps.end(), from);
+            if (r != raps.end() && (!found || *r < packet)) {
+                packet = *r;
+                found = true;
+            }
+        }
+    }
+    return found;
+}
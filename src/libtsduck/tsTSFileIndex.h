@@ -0,0 +1,249 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//!
+//!  @file
+//!  Index of a transport stream file, for random access.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsTSPacket.h"
+#include "tsTime.h"
+#include "tsReport.h"
+
+namespace ts {
+    //!
+    //! Index of a transport stream file, for fast random access.
+    //!
+    //! The index is built once by scanning the file and is saved in a compact binary
+    //! "sidecar" file, next to the transport stream file. The index contains, for each PID:
+    //! - Periodic PCR samples, with the elapsed time since the first PCR.
+    //! - Periodic PTS samples.
+    //! - The random access points (packets with a random_access_indicator).
+    //! - The positions of all packets with a payload_unit_start_indicator.
+    //!
+    //! All positions are packet indexes in the file. The index is used to locate
+    //! a packet from a time, a PCR or a PTS value and then seek directly there.
+    //!
+    class TSDUCKDLL TSFileIndex
+    {
+    public:
+        //!
+        //! Default suffix of index file names, appended to the transport stream file name.
+        //!
+        static const UChar* const DEFAULT_SUFFIX;
+
+        //!
+        //! Default interval in milliseconds between PCR or PTS samples in the same PID.
+        //!
+        static const MilliSecond DEFAULT_SAMPLE_INTERVAL = 100;
+
+        //!
+        //! A PCR or PTS sample.
+        //!
+        struct TSDUCKDLL Sample
+        {
+            PacketCounter packet;   //!< Packet index in the file.
+            uint64_t      value;    //!< PCR or PTS value in this packet.
+            uint64_t      elapsed;  //!< Elapsed PCR or PTS units since the first sample, ignoring discontinuities.
+            //!
+            //! Constructor.
+            //! @param [in] p Packet index in the file.
+            //! @param [in] v PCR or PTS value.
+            //! @param [in] e Elapsed PCR or PTS units since the first sample.
+            //!
+            Sample(PacketCounter p = 0, uint64_t v = 0, uint64_t e = 0) : packet(p), value(v), elapsed(e) {}
+        };
+
+        //!
+        //! Vector of samples, in increasing order of packet index.
+        //!
+        typedef std::vector<Sample> SampleVector;
+
+        //!
+        //! Vector of packet indexes, in increasing order.
+        //!
+        typedef std::vector<PacketCounter> PacketIndexVector;
+
+        //!
+        //! Index of one PID.
+        //!
+        struct TSDUCKDLL PIDIndex
+        {
+            SampleVector      pcrs;   //!< Periodic PCR samples.
+            SampleVector      ptss;   //!< Periodic PTS samples.
+            PacketIndexVector raps;   //!< Random access points.
+            PacketIndexVector pusis;  //!< Packets with a payload_unit_start_indicator.
+            //!
+            //! Constructor.
+            //!
+            PIDIndex() : pcrs(), ptss(), raps(), pusis() {}
+        };
+
+        //!
+        //! Map of PID indexes.
+        //!
+        typedef std::map<PID, PIDIndex> PIDIndexMap;
+
+        //!
+        //! Default constructor.
+        //!
+        TSFileIndex();
+
+        //!
+        //! Clear the content of the index.
+        //!
+        void clear();
+
+        //!
+        //! Build the index by scanning a transport stream file.
+        //! @param [in] filename Name of the transport stream file.
+        //! @param [in,out] report Where to report errors.
+        //! @param [in] interval Interval in milliseconds between PCR or PTS samples in the same PID.
+        //! @return True on success, false on error.
+        //!
+        bool build(const UString& filename, Report& report, MilliSecond interval = DEFAULT_SAMPLE_INTERVAL);
+
+        //!
+        //! Save the index in a binary file.
+        //! @param [in] filename Name of the index file.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on error.
+        //!
+        bool save(const UString& filename, Report& report) const;
+
+        //!
+        //! Load the index from a binary file.
+        //! @param [in] filename Name of the index file.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on error.
+        //!
+        bool load(const UString& filename, Report& report);
+
+        //!
+        //! Load the index of a transport stream file from its sidecar file or build it.
+        //! If the index file does not exist or does not match the current size and modification
+        //! time of the transport stream file, the index is rebuilt and saved in the index file.
+        //! @param [in] filename Name of the transport stream file.
+        //! @param [in,out] report Where to report errors.
+        //! @param [in] index_filename Name of the index file. If empty, use IndexFileName().
+        //! @return True on success, false on error. Failing to save the index file is not an error.
+        //!
+        bool loadOrBuild(const UString& filename, Report& report, const UString& index_filename = UString());
+
+        //!
+        //! Build the default name of the index file of a transport stream file.
+        //! @param [in] filename Name of the transport stream file.
+        //! @return The name of the index file.
+        //!
+        static UString IndexFileName(const UString& filename);
+
+        //!
+        //! Check if the index matches the current state of a transport stream file.
+        //! @param [in] filename Name of the transport stream file.
+        //! @return True if the size and modification time of the file are those of the indexed file.
+        //!
+        bool isUpToDate(const UString& filename) const;
+
+        //!
+        //! Get the total number of packets in the indexed file.
+        //! @return The total number of packets in the indexed file.
+        //!
+        PacketCounter packetCount() const
+        {
+            return _packet_count;
+        }
+
+        //!
+        //! Get the indexes of all PID's.
+        //! @return A constant reference to the map of PID indexes.
+        //!
+        const PIDIndexMap& pids() const
+        {
+            return _pids;
+        }
+
+        //!
+        //! Get the reference PCR PID, the first PID carrying PCR's in the file.
+        //! @return The reference PCR PID or PID_NULL if there is no PCR in the file.
+        //!
+        PID pcrPID() const
+        {
+            return _pcr_pid;
+        }
+
+        //!
+        //! Find the packet at a given time from the beginning of the file.
+        //! The time is based on the PCR's of a PID.
+        //! @param [in] time Time in milliseconds from the first PCR in the PID.
+        //! @param [out] packet Index of the last sampled packet at or before @a time.
+        //! @param [in] pid The PCR PID to use. If PID_NULL, use the reference PCR PID.
+        //! @return True on success, false if there is no PCR in the PID.
+        //!
+        bool findTime(MilliSecond time, PacketCounter& packet, PID pid = PID_NULL) const;
+
+        //!
+        //! Find the packet with a given PCR value.
+        //! @param [in] pcr PCR value to search.
+        //! @param [out] packet Index of the last sampled packet with a PCR before or equal to @a pcr,
+        //! in its first occurrence in the file.
+        //! @param [in] pid The PCR PID to use. If PID_NULL, use the reference PCR PID.
+        //! @return True on success, false if @a pcr is not found.
+        //!
+        bool findPCR(uint64_t pcr, PacketCounter& packet, PID pid = PID_NULL) const;
+
+        //!
+        //! Find the packet with a given PTS value.
+        //! @param [in] pts PTS value to search.
+        //! @param [out] packet Index of the last sampled packet with a PTS before or equal to @a pts,
+        //! in its first occurrence in the file.
+        //! @param [in] pid The PID to search.
+        //! @return True on success, false if @a pts is not found.
+        //!
+        bool findPTS(uint64_t pts, PacketCounter& packet, PID pid) const;
+
+        //!
+        //! Find the next random access point.
+        //! @param [in] from Index of the first packet to consider.
+        //! @param [out] packet Index of the first random access point at or after @a from.
+        //! @param [in] pid The PID to search. If PID_NULL, search all PID's.
+        //! @return True on success, false if there is no random access point after @a from.
+        //!
+        bool findRandomAccess(PacketCounter from, PacketCounter& packet, PID pid = PID_NULL) const;
+
+    private:
+        int64_t       _file_size;      // Size of the indexed file.
+        Time          _file_time;      // Modification time (UTC) of the indexed file.
+        PacketCounter _packet_count;   // Number of packets in the indexed file.
+        PID           _pcr_pid;        // Reference PCR PID.
+        PIDIndexMap   _pids;           // Indexes of all PID's.
+
+        // Find a value in a vector of samples, in its first occurrence.
+        static bool FindValue(const SampleVector& samples, uint64_t value, uint64_t wrap, uint64_t max_jump, PacketCounter& packet);
+    };
+}
@@ -36,6 +36,11 @@
 #include "tsSysUtils.h"
 TSDUCK_SOURCE;
 
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::TSFileInput::DEFAULT_READ_SIZE;
+const size_t ts::TSFileInput::DEFAULT_CACHE_SIZE;
+#endif
+
 
 //----------------------------------------------------------------------------
 // Default constructor.
@@ -51,15 +56,45 @@ ts::TSFileInput::TSFileInput() :
     _severity(Severity::Error),
     _at_eof(false),
     _rewindable(false),
+    _read_mode(READ_NORMAL),
+    _read_size(DEFAULT_READ_SIZE),
+    _format(TS_FORMAT_TS),
+    _pkt_size(PKT_SIZE),
+    _raw_buffer(),
+    _cache_max(0),
+    _cache(),
+    _cache_ats(),
+    _cache_next(0),
+    _cache_filling(false),
+    _cache_complete(false),
+    _cache_serving(false),
 #if defined(TS_WINDOWS)
     _handle(INVALID_HANDLE_VALUE)
 #else
-    _fd(-1)
+    _fd(-1),
+    _file_size(0),
+    _next_offset(0),
+    _release_offset(0),
+    _chunk_base(0),
+    _chunk_size(0),
+    _chunk_offset(0),
+    _direct_buffer()
 #endif
 {
 }
 
 
+//----------------------------------------------------------------------------
+// Set the read mode.
+//----------------------------------------------------------------------------
+
+void ts::TSFileInput::setReadMode(ReadMode mode, size_t read_size)
+{
+    _read_mode = mode;
+    _read_size = read_size == 0 ? DEFAULT_READ_SIZE : read_size;
+}
+
+
 //----------------------------------------------------------------------------
 // Destructor
 //----------------------------------------------------------------------------
@@ -169,19 +204,36 @@ bool ts::TSFileInput::openInternal (Report& report)
 
     // UNIX implementation
 
+    // With direct I/O, if the file system does not support O_DIRECT, use
+    // normal reads with the same aligned chunks.
+    const int flags = O_RDONLY | O_LARGEFILE;
+#if defined(O_DIRECT)
+    const int direct_flags = _read_mode == READ_DIRECT ? O_DIRECT : 0;
+#else
+    const int direct_flags = 0;
+#endif
+
     if (_filename.empty()) {
         _fd = STDIN_FILENO;
     }
-    else if ((_fd = ::open(_filename.toUTF8().c_str(), O_RDONLY | O_LARGEFILE)) < 0) {
+    else if ((_fd = ::open(_filename.toUTF8().c_str(), flags | direct_flags)) < 0 &&
+             (direct_flags == 0 || (_fd = ::open(_filename.toUTF8().c_str(), flags)) < 0)) {
         ErrorCode error_code = LastErrorCode();
         report.log(_severity, u"cannot open file %s: %s", {_filename, ErrorCodeMessage(error_code)});
         return false;
     }
 
-    // If a repeat count or initial offset is specified, the input file
-    // must be a regular file
+#if defined(F_NOCACHE)
+    // On macOS, there is no O_DIRECT, the system cache is disabled on the open file.
+    if (_read_mode == READ_DIRECT) {
+        ::fcntl(_fd, F_NOCACHE, 1);
+    }
+#endif
 
-    if (_repeat != 1 || _start_offset != 0) {
+    // If a repeat count or initial offset is specified, or with memory-mapped
+    // and direct I/O, the input file must be a regular file
+
+    if (_repeat != 1 || _start_offset != 0 || _read_mode != READ_NORMAL) {
         struct stat st;
         if (::fstat(_fd, &st) < 0) {
             ErrorCode error_code = LastErrorCode ();
@@ -192,17 +244,33 @@ bool ts::TSFileInput::openInternal (Report& report)
             return false;
         }
         if (!S_ISREG(st.st_mode)) {
-            report.log(_severity, u"input file %s is not a regular file, cannot %s", {_filename, _repeat != 1 ? u"repeat" : u"specify start offset"});
+            report.log(_severity, u"input file %s is not a regular file, cannot %s", {_filename, _repeat != 1 ? u"repeat" : (_start_offset != 0 ? u"specify start offset" : u"use memory mapping or direct I/O")});
             if (!_filename.empty()) {
                 ::close(_fd);
             }
             return false;
         }
+        _file_size = uint64_t(st.st_size);
+    }
+
+    // With memory-mapped and direct I/O, the file is read by chunks of pages.
+    // The read buffer for direct I/O is aligned on a page boundary.
+
+    const size_t page_size = size_t(::sysconf(_SC_PAGESIZE));
+    _read_size = ((_read_size + page_size - 1) / page_size) * page_size;
+    _next_offset = _start_offset;
+    _release_offset = _start_offset - _start_offset % page_size;
+    _chunk_base = 0;
+    _chunk_size = 0;
+    _chunk_offset = 0;
+    if (_read_mode == READ_DIRECT) {
+        _direct_buffer.resize(_read_size + page_size);
+        _chunk_base = _direct_buffer.data() + (page_size - size_t(reinterpret_cast<uintptr_t>(_direct_buffer.data()) % page_size)) % page_size;
     }
 
     // If an initial offset is specified, move here
 
-    if (_start_offset != 0 && ::lseek (_fd, off_t (_start_offset), SEEK_SET) == off_t (-1)) {
+    if (_read_mode == READ_NORMAL && _start_offset != 0 && ::lseek (_fd, off_t (_start_offset), SEEK_SET) == off_t (-1)) {
         ErrorCode error_code = LastErrorCode ();
         report.log (_severity, u"error seeking input file %s: %s", {_filename, ErrorCodeMessage(error_code)});
         if (!_filename.empty()) {
@@ -213,18 +281,108 @@ bool ts::TSFileInput::openInternal (Report& report)
 
 #endif
 
+    // Size of packets in the file.
+    _pkt_size = PacketFormatSize(_format);
+
+    // The cache is used only when the file is repeated.
+    _cache.clear();
+    _cache_ats.clear();
+    _cache_next = 0;
+    _cache_filling = _cache_max > 0 && _repeat != 1 && !_rewindable;
+    _cache_complete = false;
+    _cache_serving = false;
+
     _is_open = true;
     _total_packets = 0;
     return true;
 }
 
 
+//----------------------------------------------------------------------------
+// Start a new iteration from the cache. Reposition the file after the
+// cached packets when the file does not entirely fit in the cache.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileInput::rewindToCache(Report& report)
+{
+    _cache_filling = false;
+    _cache_next = 0;
+
+    if (_cache_complete) {
+        _at_eof = false;
+        _cache_serving = !_cache.empty();
+        return _cache_serving || seekInternal(0, report);
+    }
+
+    const uint64_t cached = uint64_t(_cache.size()) * _pkt_size;
+    if (!seekInternal(cached, report)) {
+        return false;
+    }
+    _cache_serving = !_cache.empty();
+
+#if defined(POSIX_FADV_WILLNEED)
+    // While the cache is served, let the system read ahead what comes next in the file.
+    if (_read_mode != READ_DIRECT) {
+        ::posix_fadvise(_fd, off_t(_start_offset + cached), off_t(cached), POSIX_FADV_WILLNEED);
+    }
+#endif
+
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Serve packets from the cache.
+//----------------------------------------------------------------------------
+
+size_t ts::TSFileInput::readCache(TSPacket* buffer, size_t max_packets, TSPacketMetadata* mdata)
+{
+    const size_t count = std::min(max_packets, _cache.size() - _cache_next);
+    ::memcpy(buffer->b, _cache[_cache_next].b, count * PKT_SIZE);
+    if (mdata != 0 && !_cache_ats.empty()) {
+        for (size_t i = 0; i < count; ++i) {
+            mdata[i].setArrivalTimeStamp(_cache_ats[_cache_next + i]);
+        }
+    }
+    _cache_next += count;
+
+    // At end of cache, either continue from the file or start the next iteration.
+    if (_cache_next >= _cache.size()) {
+        _cache_serving = false;
+        if (_cache_complete) {
+            if (_repeat == 0 || ++_counter < _repeat) {
+                _cache_serving = true;
+                _cache_next = 0;
+            }
+            else {
+                _at_eof = true;
+            }
+        }
+    }
+
+    _total_packets += count;
+    return count;
+}
+
+
 //----------------------------------------------------------------------------
 // Internal seek. Rewind to specified start offset plus specified index.
 //----------------------------------------------------------------------------
 
 bool ts::TSFileInput::seekInternal(uint64_t index, Report& report)
 {
+#if !defined(TS_WINDOWS)
+    if (_read_mode != READ_NORMAL) {
+        // Memory-mapped and direct I/O use explicit file offsets.
+        // The current chunk remains valid if the new offset is inside.
+        releasePages();
+        _next_offset = _start_offset + index;
+        _release_offset = std::min(_release_offset, _next_offset - _next_offset % uint64_t(::sysconf(_SC_PAGESIZE)));
+        _at_eof = false;
+        return true;
+    }
+#endif
+
 #if defined (TS_WINDOWS)
     // In Win32, LARGE_INTEGER is a 64-bit structure, not an integer type
     uint64_t where = _start_offset + index;
@@ -260,7 +418,7 @@ bool ts::TSFileInput::seek(PacketCounter packet_index, Report& report)
         return false;
     }
     else {
-        return seekInternal(packet_index * PKT_SIZE, report);
+        return seekInternal(packet_index * _pkt_size, report);
     }
 }
 
@@ -276,6 +434,14 @@ bool ts::TSFileInput::close(Report& report)
         return false;
     }
 
+#if !defined(TS_WINDOWS)
+    if (_read_mode != READ_NORMAL) {
+        releasePages();
+        unloadChunk();
+        _direct_buffer.clear();
+    }
+#endif
+
     if (!_filename.empty()) {
 #if defined (TS_WINDOWS)
         ::CloseHandle(_handle);
@@ -287,6 +453,12 @@ bool ts::TSFileInput::close(Report& report)
     _is_open = false;
     _total_packets = 0;
     _filename.clear();
+    _cache.clear();
+    _cache.shrink_to_fit();
+    _cache_ats.clear();
+    _cache_ats.shrink_to_fit();
+    _raw_buffer.clear();
+    _cache_serving = _cache_filling = _cache_complete = false;
 
     return true;
 }
@@ -297,7 +469,7 @@ bool ts::TSFileInput::close(Report& report)
 // Returning zero means error or end of file repetition.
 //----------------------------------------------------------------------------
 
-size_t ts::TSFileInput::read(TSPacket* buffer, size_t max_packets, Report& report)
+size_t ts::TSFileInput::read(TSPacket* buffer, size_t max_packets, Report& report, TSPacketMetadata* mdata)
 {
     if (!_is_open) {
         report.log(_severity, u"not open");
@@ -308,14 +480,24 @@ size_t ts::TSFileInput::read(TSPacket* buffer, size_t max_packets, Report& repor
         return 0;
     }
 
-    char* data = reinterpret_cast <char*> (buffer);
-    const size_t req_size = max_packets * PKT_SIZE;
+    if (_cache_serving) {
+        return readCache(buffer, max_packets, mdata);
+    }
+
+    // With other formats than TS, read the complete packets in an intermediate buffer.
+    if (_format != TS_FORMAT_TS) {
+        _raw_buffer.resize(max_packets * _pkt_size);
+    }
+
+    char* data = reinterpret_cast<char*>(_format == TS_FORMAT_TS ? buffer->b : _raw_buffer.data());
+    const size_t req_size = max_packets * _pkt_size;
     size_t got_size = 0;
     bool got_error = false;
+    bool cache_rewind = false;
     ErrorCode error_code = 0;
 
     // Loop on read until we get enough
-    while (got_size < req_size && !_at_eof && !got_error) {
+    while (got_size < req_size && !_at_eof && !got_error && !cache_rewind) {
 
 #if defined (TS_WINDOWS)
         // Windows implementation
@@ -333,8 +515,20 @@ size_t ts::TSFileInput::read(TSPacket* buffer, size_t max_packets, Report& repor
         }
 #else
         // UNIX implementation
-        ssize_t insize = ::read (_fd, data + got_size, req_size - got_size);
-        if (insize > 0) {
+        ssize_t insize = 0;
+        if (_read_mode != READ_NORMAL) {
+            // Memory-mapped or direct I/O: copy from the current chunk, load the next chunk when exhausted.
+            if (_next_offset >= _chunk_offset && _next_offset < _chunk_offset + _chunk_size) {
+                const size_t size = size_t(std::min<uint64_t>(req_size - got_size, _chunk_offset + _chunk_size - _next_offset));
+                ::memcpy(data + got_size, _chunk_base + (_next_offset - _chunk_offset), size);
+                got_size += size;
+                _next_offset += size;
+            }
+            else if (!loadChunk(error_code)) {
+                got_error = true;
+            }
+        }
+        else if ((insize = ::read (_fd, data + got_size, req_size - got_size)) > 0) {
             // Normal case: some data were read
             got_size += insize;
             assert (got_size <= req_size);
@@ -350,24 +544,169 @@ size_t ts::TSFileInput::read(TSPacket* buffer, size_t max_packets, Report& repor
 
         // At end-of-file, truncate partial packet.
         if (_at_eof) {
-            got_size -= got_size % PKT_SIZE;
+            got_size -= got_size % _pkt_size;
         }
 
         // At end of file, if the file must be repeated a finite number of times,
         // check if this was the last time. If the file must be repeated again,
-        // rewind to original start offset.
-        if (_at_eof && (_repeat == 0 || ++_counter < _repeat) && !seekInternal (0, report)) {
-            return 0; // rewind error
+        // rewind to original start offset. With a cache, the next iteration
+        // starts from the cache, after returning the packets of this iteration.
+        if (_at_eof && (_repeat == 0 || ++_counter < _repeat)) {
+            if (_cache_max > 0 && !_rewindable) {
+                cache_rewind = true;
+            }
+            else if (!seekInternal(0, report)) {
+                return 0; // rewind error
+            }
         }
     }
 
+#if !defined(TS_WINDOWS)
+    if (_read_mode != READ_NORMAL) {
+        releasePages();
+    }
+#endif
+
     if (got_error) {
         report.log(_severity, u"error reading file %s: %s (%d)", {_filename, ErrorCodeMessage(error_code), error_code});
         return 0;
     }
 
     // Return the number of input packets.
-    const size_t count = got_size / PKT_SIZE;
+    const size_t count = got_size / _pkt_size;
+
+    // Strip the extra bytes of other formats than TS.
+    if (_format != TS_FORMAT_TS) {
+        const size_t header_size = PacketFormatHeaderSize(_format);
+        const uint8_t* raw = _raw_buffer.data();
+        for (size_t i = 0; i < count; ++i, raw += _pkt_size) {
+            ::memcpy(buffer[i].b, raw + header_size, PKT_SIZE);
+            if (_format == TS_FORMAT_M2TS && mdata != 0) {
+                mdata[i].setArrivalTimeStamp(GetUInt32(raw));
+            }
+        }
+    }
+
+    // During the first iteration, keep the packets in the cache while it is not full.
+    if (_cache_filling) {
+        const size_t cached = std::min(count, _cache_max - _cache.size());
+        _cache.insert(_cache.end(), buffer, buffer + cached);
+        if (_format == TS_FORMAT_M2TS) {
+            const uint8_t* raw = _raw_buffer.data();
+            for (size_t i = 0; i < cached; ++i, raw += _pkt_size) {
+                _cache_ats.push_back(GetUInt32(raw) & M2TS_ARRIVAL_TIME_MASK);
+            }
+        }
+        _cache_filling = cached == count;
+        _cache_complete = _cache_filling && cache_rewind;
+    }
+    if (cache_rewind && !rewindToCache(report)) {
+        return 0; // rewind error
+    }
     _total_packets += count;
     return count;
 }
+
+
+#if !defined(TS_WINDOWS)
+
+//----------------------------------------------------------------------------
+// Load the chunk of file which contains the next byte to read, with
+// memory-mapped or direct I/O. Set _at_eof at end of file.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileInput::loadChunk(ErrorCode& error_code)
+{
+    // Chunks start on a page boundary.
+    const uint64_t page_size = uint64_t(::sysconf(_SC_PAGESIZE));
+    const uint64_t base = _next_offset - _next_offset % page_size;
+
+    if (_read_mode == READ_MMAP) {
+        unloadChunk();
+
+        // At end of file, check if the file has grown since the last time (file being recorded).
+        if (_next_offset >= _file_size) {
+            struct stat st;
+            if (::fstat(_fd, &st) < 0) {
+                error_code = LastErrorCode();
+                return false;
+            }
+            _file_size = uint64_t(st.st_size);
+            if (_next_offset >= _file_size) {
+                _at_eof = true;
+                return true;
+            }
+        }
+
+        // Map the next window of the file.
+        const size_t size = size_t(std::min<uint64_t>(_read_size, _file_size - base));
+        void* const addr = ::mmap(0, size, PROT_READ, MAP_SHARED, _fd, off_t(base));
+        if (addr == MAP_FAILED) {
+            error_code = LastErrorCode();
+            return false;
+        }
+        ::madvise(addr, size, MADV_SEQUENTIAL);
+        _chunk_base = reinterpret_cast<uint8_t*>(addr);
+        _chunk_size = size;
+        _chunk_offset = base;
+    }
+    else {
+        // Direct I/O: read a complete chunk in the aligned buffer.
+        // A short read means end of file.
+        _chunk_size = 0;
+        _chunk_offset = base;
+        ssize_t insize;
+        while ((insize = ::pread(_fd, _chunk_base, _read_size, off_t(base))) < 0) {
+            if ((error_code = LastErrorCode()) != EINTR) {
+                return false;
+            }
+        }
+        _chunk_size = size_t(insize);
+        _at_eof = base + _chunk_size <= _next_offset;
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Unmap the current window of a memory-mapped file.
+//----------------------------------------------------------------------------
+
+void ts::TSFileInput::unloadChunk()
+{
+    if (_read_mode == READ_MMAP && _chunk_base != 0) {
+        ::munmap(_chunk_base, _chunk_size);
+    }
+    if (_read_mode == READ_MMAP) {
+        _chunk_base = 0;
+    }
+    _chunk_size = 0;
+}
+
+
+//----------------------------------------------------------------------------
+// Release the pages of a memory-mapped file which are behind the read
+// cursor, to avoid filling the system cache with large files.
+//----------------------------------------------------------------------------
+
+void ts::TSFileInput::releasePages()
+{
+    const uint64_t page_size = uint64_t(::sysconf(_SC_PAGESIZE));
+    const uint64_t end = _next_offset - _next_offset % page_size;
+
+    // With direct I/O, nothing goes to the system cache. Release by large ranges only.
+    if (_read_mode == READ_MMAP && end >= _release_offset + _read_size / 4) {
+        // Release the part of the current window which was read.
+        const uint64_t start = std::max(_release_offset, _chunk_offset);
+        if (_chunk_base != 0 && end > start && start < _chunk_offset + _chunk_size) {
+            ::madvise(_chunk_base + (start - _chunk_offset), size_t(std::min<uint64_t>(end, _chunk_offset + _chunk_size) - start), MADV_DONTNEED);
+        }
+#if defined(POSIX_FADV_DONTNEED)
+        // Drop the pages of the file from the system cache.
+        ::posix_fadvise(_fd, off_t(_release_offset), off_t(end - _release_offset), POSIX_FADV_DONTNEED);
+#endif
+        _release_offset = end;
+    }
+}
+
+#endif
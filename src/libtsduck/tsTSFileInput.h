@@ -34,6 +34,9 @@
 
 #pragma once
 #include "tsTSPacket.h"
+#include "tsTSPacketMetadata.h"
+#include "tsTSPacketFormat.h"
+#include "tsByteBlock.h"
 #include "tsReport.h"
 
 namespace ts {
@@ -43,6 +46,27 @@ namespace ts {
     class TSDUCKDLL TSFileInput
     {
     public:
+        //!
+        //! Methods to read the file.
+        //! The file must be a regular file, not a pipe, with read modes other than READ_NORMAL.
+        //! On Windows, the read mode is ignored and READ_NORMAL is always used.
+        //!
+        enum ReadMode {
+            READ_NORMAL,  //!< Read the file using buffered read operations.
+            READ_MMAP,    //!< Map the file in memory, sequential access, release the pages after reading.
+            READ_DIRECT,  //!< Use direct I/O, bypassing the system cache, with large aligned reads.
+        };
+
+        //!
+        //! Default size in bytes of the memory-mapped window or direct read operations.
+        //!
+        static const size_t DEFAULT_READ_SIZE = 4 * 1024 * 1024;
+
+        //!
+        //! Default maximum size in bytes of the in-memory cache of repeated files.
+        //!
+        static const size_t DEFAULT_CACHE_SIZE = 128 * 1024 * 1024;
+
         //!
         //! Default constructor.
         //!
@@ -108,6 +132,70 @@ namespace ts {
             _severity = level;
         }
 
+        //!
+        //! Get the read mode.
+        //! @return The read mode.
+        //!
+        ReadMode getReadMode() const
+        {
+            return _read_mode;
+        }
+
+        //!
+        //! Set the read mode.
+        //! Must be called before open(), applies to the next open() operations.
+        //! @param [in] mode The read mode. The default is READ_NORMAL.
+        //! @param [in] read_size Size in bytes of the memory-mapped window with READ_MMAP
+        //! or of each read operation with READ_DIRECT. It is rounded up to the system page size.
+        //! If zero, use DEFAULT_READ_SIZE.
+        //!
+        void setReadMode(ReadMode mode, size_t read_size = 0);
+
+        //!
+        //! Set the in-memory cache of repeated files.
+        //! When the file is opened with a @a repeat_count different from 1, the packets are
+        //! kept in memory during the first iteration, up to the specified size. If the file
+        //! fits in the cache, the next iterations are entirely served from memory, without
+        //! any I/O. Otherwise, the cached beginning of the file is served from memory and the
+        //! rest is read from the file, with a read-ahead hint while the cache is served.
+        //! Must be called before open(), applies to the next open() operations.
+        //! @param [in] max_packets Maximum number of packets to cache. Zero means no cache (the default).
+        //!
+        void setCacheSize(size_t max_packets)
+        {
+            _cache_max = max_packets;
+        }
+
+        //!
+        //! Get the maximum size of the in-memory cache of repeated files.
+        //! @return The maximum number of cached packets, zero if there is no cache.
+        //!
+        size_t getCacheSize() const
+        {
+            return _cache_max;
+        }
+
+        //!
+        //! Set the format of the packets in the file.
+        //! With M2TS and 204-byte formats, the extra bytes are stripped while reading the
+        //! packets. The arrival time stamps of M2TS packets are returned in the metadata.
+        //! Must be called before open(), applies to the next open() operations.
+        //! @param [in] format The packet format. The default is TS_FORMAT_TS.
+        //!
+        void setPacketFormat(TSPacketFormat format)
+        {
+            _format = format;
+        }
+
+        //!
+        //! Get the format of the packets in the file.
+        //! @return The packet format.
+        //!
+        TSPacketFormat getPacketFormat() const
+        {
+            return _format;
+        }
+
         //!
         //! Get the file name.
         //! @return The file name.
@@ -131,10 +219,12 @@ namespace ts {
         //! @param [out] buffer Address of reception packet buffer.
         //! @param [in] max_packets Size of @a buffer in packets.
         //! @param [in,out] report Where to report errors.
+        //! @param [in,out] mdata Optional address of the metadata of the packets, in parallel
+        //! with @a buffer. With the M2TS format, the arrival time stamps are set in the metadata.
         //! @return The actual number of read packets. Returning zero means
         //! error or end of file repetition.
         //!
-        size_t read(TSPacket* buffer, size_t max_packets, Report& report);
+        size_t read(TSPacket* buffer, size_t max_packets, Report& report, TSPacketMetadata* mdata = 0);
 
         //!
         //! Rewind the file.
@@ -153,7 +243,8 @@ namespace ts {
         //! Seek the file at a specified packet index.
         //! The file must have been opened in rewindable mode.
         //! @param [in] packet_index Seek the file to this specified packet index
-        //! (plus the previously specified @a start_offset).
+        //! (plus the previously specified @a start_offset). The size of the packets
+        //! in the file depends on the packet format.
         //! @param [in,out] report Where to report errors.
         //! @return True on success, false on error.
         //!
@@ -180,10 +271,29 @@ namespace ts {
         int      _severity;      //!< Severity level for error reporting
         bool     _at_eof;        //!< End of file has been reached
         bool     _rewindable;    //!< Opened in rewindable mode
+        ReadMode _read_mode;     //!< Read mode
+        size_t   _read_size;     //!< Size of memory-mapped window or direct read operations
+        TSPacketFormat _format;  //!< Packet format in the file
+        size_t   _pkt_size;      //!< Size of packets in the file, depends on the format
+        ByteBlock _raw_buffer;   //!< Read buffer for non-TS packet formats
+        size_t   _cache_max;     //!< Maximum number of cached packets, zero if no cache
+        TSPacketVector _cache;   //!< Cached packets from the beginning of the file
+        std::vector<uint32_t> _cache_ats; //!< Arrival time stamps of cached packets, with M2TS format
+        size_t   _cache_next;    //!< Index of next packet to serve from the cache
+        bool     _cache_filling; //!< The cache is filled during the first iteration
+        bool     _cache_complete;//!< The whole file (from start offset) is in the cache
+        bool     _cache_serving; //!< The packets are currently served from the cache
 #if defined(TS_WINDOWS)
         ::HANDLE _handle;        //!< File handle
 #else
-        int      _fd;            //!< File descriptor
+        int       _fd;             //!< File descriptor
+        uint64_t  _file_size;      //!< File size, with READ_MMAP
+        uint64_t  _next_offset;    //!< File offset of next byte to read, with READ_MMAP or READ_DIRECT
+        uint64_t  _release_offset; //!< File offset up to which the pages were released
+        uint8_t*  _chunk_base;     //!< Address of the mapped window or aligned direct read buffer
+        size_t    _chunk_size;     //!< Size of data in _chunk_base
+        uint64_t  _chunk_offset;   //!< File offset of _chunk_base
+        ByteBlock _direct_buffer;  //!< Buffer for direct reads, contains the aligned buffer
 #endif
 
         // Inaccessible operations
@@ -193,5 +303,12 @@ namespace ts {
         // Internal methods
         bool openInternal(Report& report);
         bool seekInternal(uint64_t, Report& report);
+        bool rewindToCache(Report& report);
+        size_t readCache(TSPacket* buffer, size_t max_packets, TSPacketMetadata* mdata);
+#if !defined(TS_WINDOWS)
+        bool loadChunk(ErrorCode& error_code);
+        void unloadChunk();
+        void releasePages();
+#endif
     };
 }
@@ -0,0 +1,426 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  Transport stream file input from a playlist of files.
+//
+//----------------------------------------------------------------------------
+
+#include "tsTSFileInputPlaylist.h"
+#include "tsGuardCondition.h"
+#include "tsNullReport.h"
+TSDUCK_SOURCE;
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::TSFileInputPlaylist::DEFAULT_PREFETCH_SIZE;
+#endif
+
+
+//----------------------------------------------------------------------------
+// Constructor and destructor.
+//----------------------------------------------------------------------------
+
+ts::TSFileInputPlaylist::TSFileInputPlaylist() :
+    Thread(),
+    _format(TS_FORMAT_TS),
+    _read_mode(TSFileInput::READ_NORMAL),
+    _read_size(0),
+    _prefetch_max(DEFAULT_PREFETCH_SIZE / PKT_SIZE),
+    _fix_cc(false),
+    _mark_disc(false),
+    _is_open(false),
+    _files(),
+    _repeat(1),
+    _position(0),
+    _report(0),
+    _inputs(),
+    _current(0),
+    _at_end(false),
+    _transitions(0),
+    _stalls(0),
+    _total_packets(0),
+    _pf_packets(),
+    _pf_mdata(),
+    _pf_count(0),
+    _pf_next(0),
+    _mutex(),
+    _pf_request(),
+    _pf_done(),
+    _pf_state(PF_IDLE),
+    _pf_fetched(0),
+    _terminate(false),
+    _boundary(false)
+{
+}
+
+ts::TSFileInputPlaylist::~TSFileInputPlaylist()
+{
+    if (_is_open) {
+        close(NULLREP);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Configuration, before open().
+//----------------------------------------------------------------------------
+
+void ts::TSFileInputPlaylist::setPacketFormat(TSPacketFormat format)
+{
+    _format = format;
+}
+
+void ts::TSFileInputPlaylist::setReadMode(TSFileInput::ReadMode mode, size_t read_size)
+{
+    _read_mode = mode;
+    _read_size = read_size;
+}
+
+void ts::TSFileInputPlaylist::setPrefetchSize(size_t size)
+{
+    _prefetch_max = std::max<size_t>(1, size / PKT_SIZE);
+}
+
+void ts::TSFileInputPlaylist::setContinuity(bool fix_cc, bool mark_discontinuity)
+{
+    _fix_cc = fix_cc;
+    _mark_disc = mark_discontinuity;
+}
+
+
+//----------------------------------------------------------------------------
+// Open the playlist.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileInputPlaylist::open(const UStringVector& files, size_t repeat_count, Report& report)
+{
+    if (_is_open) {
+        report.error(u"playlist already open");
+        return false;
+    }
+    if (files.empty()) {
+        report.error(u"empty playlist");
+        return false;
+    }
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (files[i].empty()) {
+            report.error(u"the standard input cannot be used in a playlist");
+            return false;
+        }
+    }
+
+    _files = files;
+    _repeat = repeat_count;
+    _position = 0;
+    _report = &report;
+    _current = 0;
+    _at_end = false;
+    _transitions = 0;
+    _stalls = 0;
+    _total_packets = 0;
+
+    for (size_t i = 0; i < 2; ++i) {
+        _inputs[i].setPacketFormat(_format);
+        _inputs[i].setReadMode(_read_mode, _read_size);
+    }
+    if (!_inputs[0].open(_files[0], 1, 0, report)) {
+        return false;
+    }
+
+    for (size_t pid = 0; pid < PID_MAX; ++pid) {
+        _last_cc[pid] = 0xFF;
+        _cc_delta[pid] = 0;
+        _seen[pid] = false;
+        _pcr_marked[pid] = false;
+    }
+    _boundary = false;
+
+    for (size_t i = 0; i < 2; ++i) {
+        _pf_packets[i].resize(_prefetch_max);
+        _pf_mdata[i].resize(_prefetch_max);
+    }
+    _pf_count = _pf_next = _pf_fetched = 0;
+    _pf_state = PF_IDLE;
+    _terminate = false;
+
+    if (!Thread::start()) {
+        report.error(u"cannot start prefetch thread for playlist");
+        _inputs[0].close(report);
+        return false;
+    }
+
+    // Immediately prefetch the second file.
+    _is_open = true;
+    requestPrefetch();
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Close the playlist.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileInputPlaylist::close(Report& report)
+{
+    if (!_is_open) {
+        report.error(u"playlist not open");
+        return false;
+    }
+
+    // Stop the prefetch thread first, it may use the next file.
+    {
+        Guard lock(_mutex);
+        _terminate = true;
+        _pf_request.signal();
+    }
+    Thread::waitForTermination();
+
+    bool success = true;
+    for (size_t i = 0; i < 2; ++i) {
+        if (_inputs[i].isOpen()) {
+            success = _inputs[i].close(report) && success;
+        }
+    }
+    report.debug(u"playlist: %'d packets, %'d transitions, %'d waited for the prefetch", {_total_packets, _transitions, _stalls});
+
+    for (size_t i = 0; i < 2; ++i) {
+        _pf_packets[i].clear();
+        _pf_mdata[i].clear();
+    }
+    _pf_count = _pf_next = 0;
+    _report = 0;
+    _is_open = false;
+    return success;
+}
+
+
+//----------------------------------------------------------------------------
+// Get the name of the file which is currently read.
+//----------------------------------------------------------------------------
+
+ts::UString ts::TSFileInputPlaylist::currentFileName() const
+{
+    return _files.empty() ? UString() : _files[_position % _files.size()];
+}
+
+
+//----------------------------------------------------------------------------
+// Request the prefetch of the next file, if there is one.
+//----------------------------------------------------------------------------
+
+void ts::TSFileInputPlaylist::requestPrefetch()
+{
+    if (hasNextFile()) {
+        Guard lock(_mutex);
+        if (_pf_state == PF_IDLE) {
+            _pf_state = PF_REQUESTED;
+            _pf_request.signal();
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Prefetch thread.
+//----------------------------------------------------------------------------
+
+void ts::TSFileInputPlaylist::main()
+{
+    for (;;) {
+        // Wait for a prefetch request.
+        size_t index = 0;
+        UString name;
+        {
+            GuardCondition lock(_mutex, _pf_request);
+            while (_pf_state != PF_REQUESTED && !_terminate) {
+                lock.waitCondition();
+            }
+            if (_terminate) {
+                break;
+            }
+            index = 1 - _current;
+            name = _files[(_position + 1) % _files.size()];
+        }
+
+        // Open the next file and read its first packets outside the critical section.
+        TSFileInput& input(_inputs[index]);
+        TSPacketVector& packets(_pf_packets[index]);
+        std::vector<TSPacketMetadata>& mdata(_pf_mdata[index]);
+        TSPacketMetadata::Reset(&mdata[0], mdata.size());
+        const bool success = input.open(name, 1, 0, *_report);
+        size_t count = 0;
+        while (success && count < packets.size()) {
+            const size_t n = input.read(&packets[count], packets.size() - count, *_report, &mdata[count]);
+            if (n == 0) {
+                break;
+            }
+            count += n;
+        }
+
+        // Notify read().
+        GuardCondition lock(_mutex, _pf_done);
+        _pf_fetched = count;
+        _pf_state = success ? PF_READY : PF_FAILED;
+        lock.signal();
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Switch to the next file.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileInputPlaylist::nextFile(Report& report)
+{
+    _inputs[_current].close(report);
+    if (!hasNextFile()) {
+        return false;
+    }
+
+    // Get the prefetched file, waiting for the prefetch thread if necessary.
+    bool success = false;
+    {
+        GuardCondition lock(_mutex, _pf_done);
+        if (_pf_state == PF_REQUESTED) {
+            _stalls++;
+            while (_pf_state == PF_REQUESTED) {
+                lock.waitCondition();
+            }
+        }
+        success = _pf_state == PF_READY;
+        _pf_state = PF_IDLE;
+        _pf_count = success ? _pf_fetched : 0;
+        _pf_next = 0;
+    }
+    if (!success) {
+        return false;
+    }
+
+    // The next file becomes the current one, its first packets are in the prefetch area.
+    _current = 1 - _current;
+    _position++;
+    _transitions++;
+    report.verbose(u"playing %s", {currentFileName()});
+
+    // The file after it is prefetched while the new file is played.
+    requestPrefetch();
+
+    // Restart the continuity processing for the new file.
+    for (size_t pid = 0; pid < PID_MAX; ++pid) {
+        _seen[pid] = false;
+        _pcr_marked[pid] = false;
+    }
+    _boundary = true;
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Read TS packets.
+//----------------------------------------------------------------------------
+
+size_t ts::TSFileInputPlaylist::read(TSPacket* buffer, size_t max_packets, Report& report, TSPacketMetadata* mdata)
+{
+    if (!_is_open || _at_end) {
+        return 0;
+    }
+
+    size_t count = 0;
+    while (count < max_packets && !_at_end) {
+        size_t n = 0;
+        if (_pf_next < _pf_count) {
+            // Serve the prefetched packets first.
+            n = std::min(max_packets - count, _pf_count - _pf_next);
+            ::memcpy(buffer[count].b, _pf_packets[_current][_pf_next].b, n * PKT_SIZE);
+            if (mdata != 0) {
+                const TSPacketMetadata* const pf_mdata = &_pf_mdata[_current][_pf_next];
+                for (size_t i = 0; i < n; ++i) {
+                    if (pf_mdata[i].hasArrivalTimeStamp()) {
+                        mdata[count + i].setArrivalTimeStamp(pf_mdata[i].getArrivalTimeStamp());
+                    }
+                }
+            }
+            _pf_next += n;
+        }
+        else if ((n = _inputs[_current].read(buffer + count, max_packets - count, report, mdata == 0 ? 0 : mdata + count)) == 0 && !nextFile(report)) {
+            // End of current file and no next file.
+            _at_end = true;
+        }
+        if (n > 0) {
+            processContinuity(buffer + count, n);
+            count += n;
+        }
+    }
+
+    _total_packets += count;
+    return count;
+}
+
+
+//----------------------------------------------------------------------------
+// Process continuity at boundaries on read packets.
+//----------------------------------------------------------------------------
+
+void ts::TSFileInputPlaylist::processContinuity(TSPacket* buffer, size_t count)
+{
+    if (!_fix_cc && !_mark_disc) {
+        return;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        TSPacket& pkt(buffer[i]);
+        const PID pid = pkt.getPID();
+        if (pid == PID_NULL) {
+            continue;
+        }
+
+        // First packet of a PID in a new file: continue the counters of the previous files.
+        if (_boundary && !_seen[pid]) {
+            _seen[pid] = true;
+            _cc_delta[pid] = 0;
+            if (_fix_cc && _last_cc[pid] < 16) {
+                const uint8_t expected = pkt.hasPayload() ? ((_last_cc[pid] + 1) & CC_MASK) : _last_cc[pid];
+                _cc_delta[pid] = (expected - pkt.getCC()) & CC_MASK;
+            }
+        }
+
+        // Renumber the continuity counters with a constant delta per PID and file.
+        // Duplicate packets and packets without payload remain valid.
+        if (_fix_cc) {
+            if (_cc_delta[pid] != 0) {
+                pkt.setCC((pkt.getCC() + _cc_delta[pid]) & CC_MASK);
+            }
+            _last_cc[pid] = pkt.getCC();
+        }
+
+        // Signal the time base discontinuity in the first PCR of the PID in the new file.
+        if (_mark_disc && _boundary && !_pcr_marked[pid] && pkt.hasPCR()) {
+            pkt.b[5] |= 0x80;
+            _pcr_marked[pid] = true;
+        }
+    }
+}
@@ -0,0 +1,252 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Transport stream file input from a playlist of files.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsTSFileInput.h"
+#include "tsThread.h"
+#include "tsMutex.h"
+#include "tsCondition.h"
+
+namespace ts {
+    //!
+    //! Transport stream file input from a playlist of files.
+    //!
+    //! The files are read in sequence, as one single stream. While a file is read,
+    //! the next one is opened and its first packets are prefetched by a background
+    //! thread. The transition between two files is consequently immediate.
+    //!
+    //! At the boundary between two files, the continuity counters of the new file
+    //! can be renumbered to continue the counters of the previous file and the
+    //! discontinuity_indicator can be set in the first packet with a PCR of each PID.
+    //!
+    class TSDUCKDLL TSFileInputPlaylist: private Thread
+    {
+    public:
+        //!
+        //! Default size in bytes of the prefetched area at the beginning of each file.
+        //!
+        static const size_t DEFAULT_PREFETCH_SIZE = 4 * 1024 * 1024;
+
+        //!
+        //! Default constructor.
+        //!
+        TSFileInputPlaylist();
+
+        //!
+        //! Destructor.
+        //!
+        virtual ~TSFileInputPlaylist() override;
+
+        //!
+        //! Set the format of the packets in the files.
+        //! Must be called before open().
+        //! @param [in] format The packet format. The default is TS_FORMAT_TS.
+        //!
+        void setPacketFormat(TSPacketFormat format);
+
+        //!
+        //! Set the read mode of the files.
+        //! Must be called before open().
+        //! @param [in] mode The read mode. The default is READ_NORMAL.
+        //! @param [in] read_size Size in bytes of the memory-mapped window with READ_MMAP
+        //! or of each read operation with READ_DIRECT.
+        //! @see TSFileInput::setReadMode()
+        //!
+        void setReadMode(TSFileInput::ReadMode mode, size_t read_size = 0);
+
+        //!
+        //! Set the size of the prefetched area at the beginning of each file.
+        //! Must be called before open().
+        //! @param [in] size Size in bytes of the prefetched area.
+        //! The default is DEFAULT_PREFETCH_SIZE.
+        //!
+        void setPrefetchSize(size_t size);
+
+        //!
+        //! Set the continuity processing at the boundary between two files.
+        //! Must be called before open().
+        //! @param [in] fix_cc If true, the continuity counters of each file are renumbered
+        //! to continue the counters of the same PID's in the previous files.
+        //! @param [in] mark_discontinuity If true, the discontinuity_indicator is set in the
+        //! first packet with a PCR of each PID in each file, except the first one.
+        //!
+        void setContinuity(bool fix_cc, bool mark_discontinuity);
+
+        //!
+        //! Open the playlist.
+        //! The first file is opened and the prefetch thread is started.
+        //! @param [in] files Names of the files to read in sequence. They must be regular files.
+        //! @param [in] repeat_count Number of times the complete playlist is read. If zero, infinitely repeat.
+        //! @param [in,out] report Where to report errors. Since the next files are opened
+        //! by the prefetch thread, this object must be thread-safe and remain valid until close().
+        //! @return True on success, false on error.
+        //!
+        bool open(const UStringVector& files, size_t repeat_count, Report& report);
+
+        //!
+        //! Check if the playlist is open.
+        //! @return True if the playlist is open.
+        //!
+        bool isOpen() const
+        {
+            return _is_open;
+        }
+
+        //!
+        //! Close the playlist.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on error.
+        //!
+        bool close(Report& report);
+
+        //!
+        //! Read TS packets.
+        //! The transition between two files is transparent.
+        //! @param [out] buffer Address of reception packet buffer.
+        //! @param [in] max_packets Size of @a buffer in packets.
+        //! @param [in,out] report Where to report errors.
+        //! @param [out] mdata Optional packet metadata. The metadata of packets without arrival
+        //! time stamp in the file are left unchanged.
+        //! @return The actual number of read packets. Returning zero means end of playlist or error.
+        //!
+        size_t read(TSPacket* buffer, size_t max_packets, Report& report, TSPacketMetadata* mdata = 0);
+
+        //!
+        //! Get the name of the file which is currently read.
+        //! @return The name of the current file.
+        //!
+        UString currentFileName() const;
+
+        //!
+        //! Get the number of transitions between files so far.
+        //! @return The number of transitions between files.
+        //!
+        size_t transitionCount() const
+        {
+            return _transitions;
+        }
+
+        //!
+        //! Get the number of transitions where the next file was not completely prefetched.
+        //! @return The number of transitions which waited for the prefetch thread.
+        //!
+        size_t stallCount() const
+        {
+            return _stalls;
+        }
+
+        //!
+        //! Get the number of read packets.
+        //! @return The number of read packets.
+        //!
+        PacketCounter getPacketCount() const
+        {
+            return _total_packets;
+        }
+
+    private:
+        // State of the prefetch of the next file.
+        enum PrefetchState {
+            PF_IDLE,       // Nothing to do.
+            PF_REQUESTED,  // The prefetch thread shall open and prefetch the next file.
+            PF_READY,      // The next file is open and prefetched.
+            PF_FAILED      // The next file cannot be opened.
+        };
+
+        // Configuration.
+        TSPacketFormat    _format;         // Packet format in the files
+        TSFileInput::ReadMode _read_mode;  // Read mode of the files
+        size_t            _read_size;      // Size of memory-mapped window or direct read operations
+        size_t            _prefetch_max;   // Size in packets of the prefetch area
+        bool              _fix_cc;         // Renumber continuity counters at boundaries
+        bool              _mark_disc;      // Set discontinuity_indicator at boundaries
+
+        // Playlist.
+        bool              _is_open;        // The playlist is open
+        UStringVector     _files;          // Names of the files
+        size_t            _repeat;         // Number of iterations of the playlist (0 means infinite)
+        PacketCounter     _position;       // Position of the current file, over all iterations
+        Report*           _report;         // Where to report errors from the prefetch thread
+        TSFileInput       _inputs[2];      // Current file and next file
+        size_t            _current;        // Index of current file in _inputs
+        bool              _at_end;         // End of playlist or error
+        size_t            _transitions;    // Number of transitions
+        size_t            _stalls;         // Number of transitions which waited for the prefetch
+        PacketCounter     _total_packets;  // Total read packets
+
+        // Prefetch areas, one per file in _inputs. The area of the next file is owned by the
+        // prefetch thread in state PF_REQUESTED. The area of the current file is served by read().
+        TSPacketVector    _pf_packets[2];  // Prefetched packets at the beginning of the files
+        std::vector<TSPacketMetadata> _pf_mdata[2]; // Metadata of the prefetched packets
+        size_t            _pf_count;       // Number of packets to serve from the area of the current file
+        size_t            _pf_next;        // Index of next packet to serve from the area of the current file
+
+        // Synchronization with the prefetch thread.
+        Mutex             _mutex;          // Protect the following fields
+        Condition         _pf_request;     // Signaled when a prefetch is requested or at termination
+        Condition         _pf_done;        // Signaled when a prefetch is completed
+        PrefetchState     _pf_state;       // State of the prefetch area
+        size_t            _pf_fetched;     // Number of prefetched packets in the next file
+        bool              _terminate;      // Request termination of prefetch thread
+
+        // Continuity processing at boundaries.
+        uint8_t           _last_cc[PID_MAX];    // Last continuity counter per PID, 0xFF if none
+        uint8_t           _cc_delta[PID_MAX];   // Delta to apply to the continuity counters of the current file
+        bool              _seen[PID_MAX];       // PID already seen in the current file
+        bool              _pcr_marked[PID_MAX]; // Discontinuity already processed in the current file
+        bool              _boundary;            // At least one boundary was crossed
+
+        // Check if there is a file after the current one.
+        bool hasNextFile() const
+        {
+            return _repeat == 0 || _position + 1 < _files.size() * _repeat;
+        }
+
+        // Request the prefetch of the next file, if there is one.
+        void requestPrefetch();
+
+        // Switch to the next file. Return false at end of playlist or on error.
+        bool nextFile(Report& report);
+
+        // Process continuity at boundaries on read packets.
+        void processContinuity(TSPacket* buffer, size_t count);
+
+        // Prefetch thread.
+        virtual void main() override;
+
+        // Inaccessible operations
+        TSFileInputPlaylist(const TSFileInputPlaylist&) = delete;
+        TSFileInputPlaylist& operator=(const TSFileInputPlaylist&) = delete;
+    };
+}
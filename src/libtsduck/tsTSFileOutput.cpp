@@ -34,27 +34,68 @@
 #include "tsTSFileOutput.h"
 #include "tsNullReport.h"
 #include "tsSysUtils.h"
+#include "tsGuardCondition.h"
+#include "tsMonotonic.h"
 TSDUCK_SOURCE;
 
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::TSFileOutput::DEFAULT_MAX_QUEUED;
+const size_t ts::TSFileOutput::DEFAULT_WRITE_SIZE;
+#endif
+
 
 //----------------------------------------------------------------------------
 // Default constructor.
 //----------------------------------------------------------------------------
 
 ts::TSFileOutput::TSFileOutput() :
+    Thread(),
     _filename(),
     _is_open(false),
     _severity(Severity::Error),
     _total_packets(0),
+    _prealloc(0),
+    _prealloc_end(0),
+    _format(TS_FORMAT_TS),
+    _pkt_size(PKT_SIZE),
+    _raw_buffer(),
 #if defined(TS_WINDOWS)
-    _handle(INVALID_HANDLE_VALUE)
+    _handle(INVALID_HANDLE_VALUE),
 #else
-    _fd(-1)
+    _fd(-1),
+    _iovec(),
 #endif
+    _async(false),
+    _max_queued(DEFAULT_MAX_QUEUED),
+    _write_size(DEFAULT_WRITE_SIZE),
+    _chunks(),
+    _mutex(),
+    _work_to_do(),
+    _work_done(),
+    _chunk_fill(0),
+    _chunk_count(0),
+    _max_count(0),
+    _terminate(false),
+    _write_error(false),
+    _error_code(SYS_SUCCESS),
+    _stall_count(0),
+    _stall_time(0)
 {
 }
 
 
+//----------------------------------------------------------------------------
+// Set the asynchronous write mode.
+//----------------------------------------------------------------------------
+
+void ts::TSFileOutput::setAsynchronous(bool async, size_t max_queued, size_t write_size)
+{
+    _async = async;
+    _max_queued = max_queued == 0 ? DEFAULT_MAX_QUEUED : max_queued;
+    _write_size = write_size == 0 ? DEFAULT_WRITE_SIZE : write_size;
+}
+
+
 //----------------------------------------------------------------------------
 // Open method
 //----------------------------------------------------------------------------
@@ -133,7 +174,42 @@ bool ts::TSFileOutput::open(const UString& filename, bool append, bool keep, Rep
         report.log(_severity, u"cannot create output file %s: %s", {_filename, ErrorCodeMessage(error_code)});
     }
 
+    // Reserve disk space for the expected content of the file.
+    _prealloc_end = 0;
+    if (!got_error && _prealloc > 0 && !_filename.empty()) {
+        preallocate(report);
+    }
+
+    // In asynchronous mode, allocate the ring of chunks and start the writer thread.
+    // The number of chunks is the maximum queued size, divided by the write size.
+    if (!got_error && _async) {
+        _chunks.resize(std::max<size_t>(2, _max_queued / _write_size));
+        for (size_t i = 0; i < _chunks.size(); ++i) {
+            _chunks[i].reserve(_write_size);
+            _chunks[i].clear();
+        }
+        _chunk_fill = _chunk_count = _max_count = 0;
+        _terminate = _write_error = false;
+        _error_code = SYS_SUCCESS;
+        _stall_count = 0;
+        _stall_time = 0;
+        if (!Thread::start()) {
+            report.log(_severity, u"cannot start writer thread for output file %s", {_filename});
+            got_error = true;
+#if defined (TS_WINDOWS)
+            if (!_filename.empty()) {
+                ::CloseHandle(_handle);
+            }
+#else
+            if (!_filename.empty()) {
+                ::close(_fd);
+            }
+#endif
+        }
+    }
+
     _total_packets = 0;
+    _pkt_size = PacketFormatSize(_format);
     return _is_open = !got_error;
 }
 
@@ -149,16 +225,98 @@ bool ts::TSFileOutput::close(Report& report)
         return false;
     }
 
+    bool success = true;
+
+    // In asynchronous mode, queue the last partial chunk and wait for the writer thread to complete.
+    if (_async) {
+        if (!_chunks[_chunk_fill].empty()) {
+            queueChunk(false);
+        }
+        {
+            Guard lock(_mutex);
+            _terminate = true;
+            _work_to_do.signal();
+        }
+        Thread::waitForTermination();
+        if (_write_error && _error_code != SYS_SUCCESS) {
+            report.log(_severity, u"error writing output file %s: %s (%d)", {_filename, ErrorCodeMessage(_error_code), _error_code});
+        }
+        success = !_write_error;
+        report.verbose(u"asynchronous output to %s: max queue depth: %'d bytes (%d chunks of %'d bytes), %'d stalls, stall time: %'d ms",
+                       {_filename.empty() ? u"standard output" : _filename, _max_count * _write_size, _max_count, _write_size, _stall_count, _stall_time / NanoSecPerMilliSec});
+        _chunks.clear();
+    }
+
     if (!_filename.empty()) {
 #if defined (TS_WINDOWS)
+        // The file system releases the unused preallocated space.
         ::CloseHandle(_handle);
 #else
+#if defined(TS_LINUX)
+        // Space which was reserved beyond the end of file remains allocated after close.
+        // Truncating the file to its current size gives the unused part back to the file system.
+        struct ::stat st;
+        if (_prealloc_end > 0 && ::fstat(_fd, &st) == 0 && uint64_t(st.st_size) < _prealloc_end && ::ftruncate(_fd, st.st_size) < 0) {
+            report.debug(u"cannot release preallocated space in %s: %s", {_filename, ErrorCodeMessage()});
+        }
+#endif
         ::close(_fd);
 #endif
     }
 
+    _prealloc_end = 0;
     _is_open = false;
-    return true;
+    return success;
+}
+
+
+//----------------------------------------------------------------------------
+// Preallocate disk space after opening the file.
+//----------------------------------------------------------------------------
+
+void ts::TSFileOutput::preallocate(Report& report)
+{
+#if defined(TS_WINDOWS)
+
+    // The file system releases the unused allocation when the file is closed.
+    ::LARGE_INTEGER size;
+    ::FILE_ALLOCATION_INFO info;
+    if (::GetFileSizeEx(_handle, &size) == 0) {
+        report.verbose(u"cannot get size of %s: %s", {_filename, ErrorCodeMessage()});
+        return;
+    }
+    info.AllocationSize.QuadPart = size.QuadPart + ::LONGLONG(_prealloc);
+    if (::SetFileInformationByHandle(_handle, ::FileAllocationInfo, &info, sizeof(info)) == 0) {
+        report.verbose(u"cannot preallocate %'d bytes in %s: %s", {_prealloc, _filename, ErrorCodeMessage()});
+        return;
+    }
+    _prealloc_end = uint64_t(info.AllocationSize.QuadPart);
+    report.debug(u"preallocated %'d bytes in %s", {_prealloc, _filename});
+
+#elif defined(TS_LINUX)
+
+    // Reserve space after the current end of file (not zero in append mode).
+    // With FALLOC_FL_KEEP_SIZE, the apparent size of the file is unchanged.
+    struct ::stat st;
+    if (::fstat(_fd, &st) < 0) {
+        report.verbose(u"cannot get size of %s: %s", {_filename, ErrorCodeMessage()});
+        return;
+    }
+    if (!S_ISREG(st.st_mode)) {
+        return; // not a regular file (named pipe, device, etc.)
+    }
+    if (::fallocate(_fd, FALLOC_FL_KEEP_SIZE, ::off_t(st.st_size), ::off_t(_prealloc)) < 0) {
+        report.verbose(u"cannot preallocate %'d bytes in %s: %s", {_prealloc, _filename, ErrorCodeMessage()});
+        return;
+    }
+    _prealloc_end = uint64_t(st.st_size) + _prealloc;
+    report.debug(u"preallocated %'d bytes in %s", {_prealloc, _filename});
+
+#else
+
+    report.debug(u"file preallocation not supported on this platform, ignored for %s", {_filename});
+
+#endif
 }
 
 
@@ -178,33 +336,227 @@ ts::TSFileOutput::~TSFileOutput()
 // Write method
 //----------------------------------------------------------------------------
 
-bool ts::TSFileOutput::write(const TSPacket* buffer, size_t packet_count, Report& report)
+bool ts::TSFileOutput::write(const TSPacket* buffer, size_t packet_count, Report& report, const TSPacketMetadata* mdata)
 {
     if (!_is_open) {
         report.log(_severity, u"not open");
         return false;
     }
 
-    // Loop on write until everything is gone
+    const char* data = reinterpret_cast<const char*>(buffer);
+    size_t remain = packet_count * _pkt_size;
+
+    // With other formats than TS, build the complete packets in an intermediate buffer.
+    if (_format != TS_FORMAT_TS) {
+        _raw_buffer.resize(remain);
+        uint8_t* raw = _raw_buffer.data();
+        for (size_t i = 0; i < packet_count; ++i) {
+            if (_format == TS_FORMAT_M2TS) {
+                // Arrival time stamp in 27 MHz units.
+                uint32_t ats = 0;
+                if (mdata != 0 && mdata[i].hasArrivalTimeStamp()) {
+                    ats = mdata[i].getArrivalTimeStamp();
+                }
+                else if (mdata != 0 && mdata[i].hasInputTimeStamp()) {
+                    ats = uint32_t((mdata[i].getInputTimeStamp() * (SYSTEM_CLOCK_FREQ / 1000000)) / 1000) & M2TS_ARRIVAL_TIME_MASK;
+                }
+                PutUInt32(raw, ats);
+                ::memcpy(raw + M2TS_HEADER_SIZE, buffer[i].b, PKT_SIZE);
+            }
+            else {
+                ::memcpy(raw, buffer[i].b, PKT_SIZE);
+                ::memset(raw + PKT_SIZE, 0, RS_SIZE);
+            }
+            raw += _pkt_size;
+        }
+        data = reinterpret_cast<const char*>(_raw_buffer.data());
+    }
 
-    bool got_error = false;
+    if (_async) {
+        // Asynchronous mode: copy the packets in the chunks and queue them when full.
+        bool success = true;
+        {
+            Guard lock(_mutex);
+            success = !_write_error;
+        }
+        while (success && remain > 0) {
+            ByteBlock& chunk(_chunks[_chunk_fill]);
+            const size_t size = std::min(remain, _write_size - chunk.size());
+            chunk.append(data, size);
+            data += size;
+            remain -= size;
+            if (chunk.size() >= _write_size) {
+                success = queueChunk(true);
+            }
+        }
+        if (!success) {
+            // The error code is reported once, in close().
+            report.debug(u"write error on %s in writer thread, error_code=%d", {_filename, _error_code});
+            return false;
+        }
+        _total_packets += packet_count;
+        return true;
+    }
+
+    // Synchronous mode: loop on write until everything is gone.
+    size_t written = 0;
+    ErrorCode error_code = SYS_SUCCESS;
+    const bool success = writeData(data, remain, written, error_code);
+
+    if (!success) {
+        report.debug(u"write error on %s, error_code=%d", {_filename, error_code});
+    }
+    if (!success && error_code != SYS_SUCCESS) {
+        report.log(_severity, u"error writing output file %s: %s (%d)", {_filename, ErrorCodeMessage(error_code), error_code});
+    }
+
+    _total_packets += written / _pkt_size;
+    return success;
+}
+
+
+//----------------------------------------------------------------------------
+// Write several runs of packets to the file.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileOutput::write(const TSPacketRunVector& runs, Report& report)
+{
+    if (!_is_open) {
+        report.log(_severity, u"not open");
+        return false;
+    }
+
+    // Vectored writes are used only in synchronous mode with plain TS packets.
+    // Otherwise, the packets are copied or reformatted anyway, write runs one by one.
+    if (_async || _format != TS_FORMAT_TS || runs.size() < 2) {
+        for (size_t i = 0; i < runs.size(); ++i) {
+            if (runs[i].count > 0 && !write(runs[i].packets, runs[i].count, report, runs[i].metadata)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    size_t written = 0;
     ErrorCode error_code = SYS_SUCCESS;
-    const char* const data_buffer = reinterpret_cast <const char*> (buffer);
-    const char* data = data_buffer;
+    const bool success = writeRuns(runs, written, error_code);
+
+    if (!success) {
+        report.debug(u"write error on %s, error_code=%d", {_filename, error_code});
+    }
+    if (!success && error_code != SYS_SUCCESS) {
+        report.log(_severity, u"error writing output file %s: %s (%d)", {_filename, ErrorCodeMessage(error_code), error_code});
+    }
+
+    _total_packets += written / _pkt_size;
+    return success;
+}
+
+
+//----------------------------------------------------------------------------
+// Write several runs of packets using vectored writes, return false on error.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileOutput::writeRuns(const TSPacketRunVector& runs, size_t& written, ErrorCode& error_code)
+{
+    written = 0;
+    error_code = SYS_SUCCESS;
+
+#if defined (TS_WINDOWS)
+
+    // Windows implementation: no vectored write on files, write runs one by one.
+
+    for (size_t i = 0; i < runs.size(); ++i) {
+        size_t size = 0;
+        const bool success = writeData(reinterpret_cast<const char*>(runs[i].packets), runs[i].count * PKT_SIZE, size, error_code);
+        written += size;
+        if (!success) {
+            return false;
+        }
+    }
+    return true;
+
+#else
+
+    // UNIX implementation: all runs in one I/O vector, loop on writev until everything is gone.
+
+#if defined(IOV_MAX)
+    const size_t max_iov = IOV_MAX;
+#else
+    const size_t max_iov = 1024;
+#endif
+
+    _iovec.clear();
+    for (size_t i = 0; i < runs.size(); ++i) {
+        if (runs[i].count > 0) {
+            ::iovec iov;
+            iov.iov_base = const_cast<TSPacket*>(runs[i].packets);
+            iov.iov_len = runs[i].count * PKT_SIZE;
+            _iovec.push_back(iov);
+        }
+    }
+
+    bool got_error = false;
+    size_t index = 0;
+
+    while (index < _iovec.size() && !got_error) {
+        const ssize_t outsize = ::writev(_fd, &_iovec[index], int(std::min(_iovec.size() - index, max_iov)));
+        if (outsize > 0) {
+            // Normal case, some data were written. Skip the completely written
+            // buffers and adjust the partially written one.
+            written += size_t(outsize);
+            size_t remain = size_t(outsize);
+            while (remain > 0 && index < _iovec.size()) {
+                if (remain >= _iovec[index].iov_len) {
+                    remain -= _iovec[index].iov_len;
+                    index++;
+                }
+                else {
+                    _iovec[index].iov_base = reinterpret_cast<char*>(_iovec[index].iov_base) + remain;
+                    _iovec[index].iov_len -= remain;
+                    remain = 0;
+                }
+            }
+        }
+        else if ((error_code = LastErrorCode()) != EINTR) {
+            // Actual error (not an interrupt)
+            got_error = true;
+            if (error_code == EPIPE) {
+                // Broken pipe: keep the error state but don't report error.
+                error_code = SYS_SUCCESS;
+            }
+        }
+    }
+
+    return !got_error;
+
+#endif
+}
+
+
+//----------------------------------------------------------------------------
+// Write data in the file, return false on error.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileOutput::writeData(const char* data, size_t size, size_t& written, ErrorCode& error_code)
+{
+    bool got_error = false;
+    written = 0;
+    error_code = SYS_SUCCESS;
 
 #if defined (TS_WINDOWS)
 
     // Windows implementation
 
-    ::DWORD remain = ::DWORD (packet_count) * PKT_SIZE;
+    ::DWORD remain = ::DWORD(size);
     ::DWORD outsize;
 
     while (remain > 0 && !got_error) {
-        if (::WriteFile (_handle, data, remain, &outsize, NULL) != 0)  {
+        if (::WriteFile(_handle, data + written, remain, &outsize, NULL) != 0)  {
             // Normal case, some data were written
-            outsize = std::min (outsize, remain);
-            data += outsize;
-            remain -= std::max (remain, outsize);
+            outsize = std::min(outsize, remain);
+            written += outsize;
+            remain -= outsize;
         }
         else if ((error_code = LastErrorCode()) == ERROR_BROKEN_PIPE || error_code == ERROR_NO_DATA) {
             // Broken pipe: error state but don't report error.
@@ -224,20 +576,19 @@ bool ts::TSFileOutput::write(const TSPacket* buffer, size_t packet_count, Report
 
     // UNIX implementation
 
-    size_t remain = packet_count * PKT_SIZE;
+    size_t remain = size;
     ssize_t outsize;
 
     while (remain > 0 && !got_error) {
-        outsize = ::write (_fd, data, remain);
+        outsize = ::write(_fd, data + written, remain);
         if (outsize > 0) {
             // Normal case, some data were written
-            assert (size_t (outsize) <= remain);
-            data += outsize;
-            remain -= std::max (remain, size_t (outsize));
+            assert(size_t(outsize) <= remain);
+            written += outsize;
+            remain -= size_t(outsize);
         }
         else if ((error_code = LastErrorCode()) != EINTR) {
             // Actual error (not an interrupt)
-            report.debug(u"write error on %s, fd=%d, error_code=%d", {_filename, _fd, error_code});
             got_error = true;
             if (error_code == EPIPE) {
                 // Broken pipe: keep the error state but don't report error.
@@ -248,10 +599,79 @@ bool ts::TSFileOutput::write(const TSPacket* buffer, size_t packet_count, Report
 
 #endif
 
-    if (got_error && error_code != SYS_SUCCESS) {
-        report.log(_severity, u"error writing output file %s: %s (%d)", {_filename, ErrorCodeMessage(error_code), error_code});
+    return !got_error;
+}
+
+
+//----------------------------------------------------------------------------
+// Queue the current chunk, in asynchronous mode. If wait is true, wait for
+// the next chunk to be free.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileOutput::queueChunk(bool wait)
+{
+    GuardCondition lock(_mutex, _work_done);
+
+    // Pass the current chunk to the writer thread.
+    _chunk_count++;
+    _max_count = std::max(_max_count, _chunk_count);
+    _chunk_fill = (_chunk_fill + 1) % _chunks.size();
+    _work_to_do.signal();
+
+    // If all chunks are queued, the next chunk to fill is the oldest one in the queue.
+    // Wait for the writer thread to write it. This is a stall, the disk is too slow.
+    if (wait && _chunk_count >= _chunks.size() && !_write_error) {
+        Monotonic start;
+        start.getSystemTime();
+        while (_chunk_count >= _chunks.size() && !_write_error) {
+            lock.waitCondition();
+        }
+        Monotonic end;
+        end.getSystemTime();
+        _stall_count++;
+        _stall_time += end - start;
     }
 
-    _total_packets += (data - data_buffer) / PKT_SIZE;
-    return !got_error;
+    // The next chunk to fill is free, unless the writer thread failed.
+    if (_chunk_count < _chunks.size()) {
+        _chunks[_chunk_fill].clear();
+    }
+    return !_write_error;
+}
+
+
+//----------------------------------------------------------------------------
+// Writer thread in asynchronous mode.
+//----------------------------------------------------------------------------
+
+void ts::TSFileOutput::main()
+{
+    for (;;) {
+        // Wait for a queued chunk. Terminate only when the queue is empty.
+        ByteBlock* chunk = 0;
+        {
+            GuardCondition lock(_mutex, _work_to_do);
+            while (_chunk_count == 0 && !_terminate) {
+                lock.waitCondition();
+            }
+            if (_chunk_count == 0 || _write_error) {
+                break;
+            }
+            chunk = &_chunks[(_chunk_fill + _chunks.size() - _chunk_count) % _chunks.size()];
+        }
+
+        // Write the chunk outside the critical section.
+        size_t written = 0;
+        ErrorCode error_code = SYS_SUCCESS;
+        const bool success = writeData(reinterpret_cast<const char*>(chunk->data()), chunk->size(), written, error_code);
+
+        // Release the chunk.
+        Guard lock(_mutex);
+        _chunk_count--;
+        if (!success) {
+            _write_error = true;
+            _error_code = error_code;
+        }
+        _work_done.signal();
+    }
 }
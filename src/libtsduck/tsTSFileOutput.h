@@ -34,15 +34,31 @@
 
 #pragma once
 #include "tsTSPacket.h"
+#include "tsTSPacketMetadata.h"
+#include "tsTSPacketFormat.h"
 #include "tsReport.h"
+#include "tsByteBlock.h"
+#include "tsThread.h"
+#include "tsMutex.h"
+#include "tsCondition.h"
 
 namespace ts {
     //!
     //! Transport Stream file output.
     //!
-    class TSDUCKDLL TSFileOutput
+    class TSDUCKDLL TSFileOutput: private Thread
     {
     public:
+        //!
+        //! Default maximum size in bytes of queued data in asynchronous mode.
+        //!
+        static const size_t DEFAULT_MAX_QUEUED = 64 * 1024 * 1024;
+
+        //!
+        //! Default size in bytes of write operations in asynchronous mode.
+        //!
+        static const size_t DEFAULT_WRITE_SIZE = 1024 * 1024;
+
         //!
         //! Default constructor.
         //!
@@ -75,9 +91,22 @@ namespace ts {
         //! @param [in] buffer Address of first packet to write.
         //! @param [in] packet_count Number of packets to write.
         //! @param [in,out] report Where to report errors.
+        //! @param [in] mdata Optional address of the metadata of the packets, in parallel with
+        //! @a buffer. With the M2TS format, the arrival time stamps are taken from the metadata.
         //! @return True on success, false on error.
         //!
-        bool write(const TSPacket* buffer, size_t packet_count, Report& report);
+        bool write(const TSPacket* buffer, size_t packet_count, Report& report, const TSPacketMetadata* mdata = 0);
+
+        //!
+        //! Write several runs of TS packets to the file.
+        //! In synchronous mode with the TS format, all runs are written using vectored
+        //! write operations (one system call for all runs on UNIX systems). Otherwise,
+        //! the runs are written one by one.
+        //! @param [in] runs List of runs of packets to write, in order.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on error.
+        //!
+        bool write(const TSPacketRunVector& runs, Report& report);
 
         //!
         //! Check if the file is open.
@@ -103,6 +132,74 @@ namespace ts {
             _severity = level;
         }
 
+        //!
+        //! Set the asynchronous write mode.
+        //! In asynchronous mode, the packets are copied in a queue of large chunks and
+        //! write() returns immediately. A writer thread writes the chunks in the file.
+        //! The caller of write() is blocked only when the queue is full.
+        //! Must be called before open(), applies to the next open() operations.
+        //! @param [in] async When true, use the asynchronous mode. The default is false.
+        //! @param [in] max_queued Maximum size in bytes of queued data. If zero, use DEFAULT_MAX_QUEUED.
+        //! @param [in] write_size Size in bytes of each write operation. If zero, use DEFAULT_WRITE_SIZE.
+        //!
+        void setAsynchronous(bool async, size_t max_queued = 0, size_t write_size = 0);
+
+        //!
+        //! Check if the asynchronous write mode is used.
+        //! @return True in asynchronous mode.
+        //!
+        bool isAsynchronous() const
+        {
+            return _async;
+        }
+
+        //!
+        //! Set the preallocation size of the file.
+        //! When non-zero, disk space is reserved for the specified number of bytes when the
+        //! file is opened, without changing the apparent size of the file. This reduces the
+        //! fragmentation and the allocation overhead of long recordings. The reserved space
+        //! which remains unused is released when the file is closed. This is only a hint, the
+        //! file is written even if the preallocation fails. Currently implemented on Linux
+        //! and Windows only. Must be called before open(), applies to the next open() operations.
+        //! @param [in] size Number of bytes to reserve. Zero means no preallocation (the default).
+        //!
+        void setPreallocation(uint64_t size)
+        {
+            _prealloc = size;
+        }
+
+        //!
+        //! Get the preallocation size of the file.
+        //! @return The number of bytes to reserve when a file is opened.
+        //!
+        uint64_t getPreallocation() const
+        {
+            return _prealloc;
+        }
+
+        //!
+        //! Set the format of the packets in the file.
+        //! With the M2TS format, the 4-byte header of each packet contains the arrival time
+        //! stamp from the metadata of the packet. When the packet has no arrival time stamp,
+        //! it is computed from the input time stamp. With the 204-byte format, a dummy
+        //! 16-byte trailer with zeroes replaces the Reed-Solomon outer FEC.
+        //! Must be called before open(), applies to the next open() operations.
+        //! @param [in] format The packet format. The default is TS_FORMAT_TS.
+        //!
+        void setPacketFormat(TSPacketFormat format)
+        {
+            _format = format;
+        }
+
+        //!
+        //! Get the format of the packets in the file.
+        //! @return The packet format.
+        //!
+        TSPacketFormat getPacketFormat() const
+        {
+            return _format;
+        }
+
         //!
         //! Get the file name.
         //! @return The file name.
@@ -126,11 +223,51 @@ namespace ts {
         bool          _is_open;       // Check if file is actually open
         int           _severity;      // Severity level for error reporting
         PacketCounter _total_packets; // Total written packets
+        uint64_t      _prealloc;      // Preallocation size
+        uint64_t      _prealloc_end;  // End offset of preallocated space in file, zero if none
+        TSPacketFormat _format;       // Packet format in the file
+        size_t        _pkt_size;      // Size of packets in the file, depends on the format
+        ByteBlock     _raw_buffer;    // Output buffer for non-TS packet formats
 #if defined(TS_WINDOWS)
         ::HANDLE      _handle;        // File handle
 #else
         int           _fd;            // File descriptor
+        std::vector<::iovec> _iovec;  // I/O vector for vectored writes
 #endif
+
+        // Asynchronous mode. The chunks are used in a ring. The chunk which is
+        // filled by write() is never in the queue.
+        bool          _async;         // Asynchronous write mode
+        size_t        _max_queued;    // Maximum size of queued data
+        size_t        _write_size;    // Size of each write operation
+        std::vector<ByteBlock> _chunks; // Ring of chunks
+        Mutex         _mutex;         // Protect the following fields
+        Condition     _work_to_do;    // Signaled when a chunk is queued or at termination
+        Condition     _work_done;     // Signaled when a chunk is written
+        size_t        _chunk_fill;    // Index of chunk which is filled by write()
+        size_t        _chunk_count;   // Number of queued chunks, the oldest is before _chunk_fill
+        size_t        _max_count;     // Maximum number of queued chunks
+        bool          _terminate;     // Request termination of writer thread
+        bool          _write_error;   // Write error in writer thread
+        ErrorCode     _error_code;    // Error code of write error
+        size_t        _stall_count;   // Number of times write() waited for a free chunk
+        NanoSecond    _stall_time;    // Total waiting time in write()
+
+        // Preallocate disk space after opening the file.
+        void preallocate(Report& report);
+
+        // Write data in the file, return false on error (error_code is SYS_SUCCESS on broken pipe).
+        bool writeData(const char* data, size_t size, size_t& written, ErrorCode& error_code);
+
+        // Write several runs of packets in the file using vectored writes, same conventions as writeData().
+        bool writeRuns(const TSPacketRunVector& runs, size_t& written, ErrorCode& error_code);
+
+        // Queue the current chunk and wait for the next one to be free, in asynchronous mode.
+        bool queueChunk(bool wait);
+
+        // Writer thread in asynchronous mode.
+        virtual void main() override;
+
         // Inaccessible operations
         TSFileOutput(const TSFileOutput&) = delete;
         TSFileOutput& operator=(const TSFileOutput&) = delete;
@@ -0,0 +1,399 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  Transport stream file output, rotating segments by size or duration.
+//
+//----------------------------------------------------------------------------
+
+#include "tsTSFileOutputSegmented.h"
+#include "tsPCR.h"
+#include "tsNullReport.h"
+#include "tsSysUtils.h"
+#include "tsGuardCondition.h"
+#include "tsMonotonic.h"
+TSDUCK_SOURCE;
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::TSFileOutputSegmented::SLOT_COUNT;
+#endif
+
+namespace {
+    // A PCR is a 33-bit base in 90 kHz units with a 27 MHz extension, it wraps up at 2**33 * 300.
+    const uint64_t PCR_WRAP = (ts::PTS_DTS_MASK + 1) * ts::SYSTEM_CLOCK_SUBFACTOR;
+
+    // Larger gaps between two consecutive PCR's are considered as discontinuities.
+    const uint64_t MAX_PCR_GAP = ts::SYSTEM_CLOCK_FREQ;
+}
+
+
+//----------------------------------------------------------------------------
+// Constructors and destructor.
+//----------------------------------------------------------------------------
+
+ts::TSFileOutputSegmented::TSFileOutputSegmented() :
+    Thread(),
+    _filename(),
+    _keep(false),
+    _max_size(0),
+    _max_pcr(0),
+    _max_files(0),
+    _prealloc(0),
+    _async(false),
+    _max_queued(0),
+    _write_size(0),
+    _is_open(false),
+    _report(0),
+    _files(),
+    _segment(0),
+    _seg_size(0),
+    _seg_pcr(0),
+    _pcr_pid(PID_NULL),
+    _last_pcr(INVALID_PCR),
+    _stall_count(0),
+    _stall_time(0),
+    _mutex(),
+    _cond(),
+    _request(false),
+    _terminate(false),
+    _next_ready(false),
+    _next_error(false),
+    _close_slot(SLOT_COUNT),
+    _open_segment(0),
+    _open_prealloc(0)
+{
+}
+
+ts::TSFileOutputSegmented::~TSFileOutputSegmented()
+{
+    if (_is_open) {
+        close(NULLREP);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Configuration.
+//----------------------------------------------------------------------------
+
+void ts::TSFileOutputSegmented::setSegmentation(uint64_t max_size, MilliSecond max_duration, size_t max_files)
+{
+    // Always keep at least one full packet per segment.
+    _max_size = max_size == 0 ? 0 : std::max<uint64_t>(PKT_SIZE, max_size - max_size % PKT_SIZE);
+    _max_pcr = max_duration <= 0 ? 0 : uint64_t(max_duration) * (SYSTEM_CLOCK_FREQ / MilliSecPerSec);
+    _max_files = max_files;
+}
+
+void ts::TSFileOutputSegmented::setAsynchronous(bool async, size_t max_queued, size_t write_size)
+{
+    _async = async;
+    _max_queued = max_queued;
+    _write_size = write_size;
+}
+
+
+//----------------------------------------------------------------------------
+// Build the file name of a segment.
+//----------------------------------------------------------------------------
+
+ts::UString ts::TSFileOutputSegmented::SegmentFileName(const UString& filename, size_t index)
+{
+    return PathPrefix(filename) + UString::Format(u"-%06d", {index}) + PathSuffix(filename);
+}
+
+
+//----------------------------------------------------------------------------
+// Create the first segment.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileOutputSegmented::open(const UString& filename, bool keep, Report& report)
+{
+    if (_is_open) {
+        report.error(u"already open");
+        return false;
+    }
+    if (filename.empty()) {
+        report.error(u"a file name is required for segmented output");
+        return false;
+    }
+
+    _filename = filename;
+    _keep = keep;
+    _report = &report;
+    _segment = 0;
+    _seg_size = 0;
+    _seg_pcr = 0;
+    _pcr_pid = PID_NULL;
+    _last_pcr = INVALID_PCR;
+    _stall_count = 0;
+    _stall_time = 0;
+    _request = _terminate = _next_ready = _next_error = false;
+
+    for (size_t slot = 0; slot < SLOT_COUNT; ++slot) {
+        _files[slot].setAsynchronous(_async, _max_queued, _write_size);
+    }
+
+    // The first segment is synchronously created, the next one is opened in the background.
+    const uint64_t prealloc = _prealloc > 0 ? _prealloc : _max_size;
+    if (!openSegment(0, 0, prealloc, report)) {
+        return false;
+    }
+    if (!Thread::start()) {
+        report.error(u"cannot start segmentation thread for %s", {_filename});
+        _files[0].close(report);
+        return false;
+    }
+    postRequest(SLOT_COUNT, prealloc);
+    return _is_open = true;
+}
+
+
+//----------------------------------------------------------------------------
+// Open a new segment in a slot.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileOutputSegmented::openSegment(size_t slot, size_t index, uint64_t prealloc, Report& report)
+{
+    _files[slot].setPreallocation(prealloc);
+    return _files[slot].open(SegmentFileName(_filename, index), false, _keep, report);
+}
+
+
+//----------------------------------------------------------------------------
+// Close the output.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileOutputSegmented::close(Report& report)
+{
+    if (!_is_open) {
+        report.error(u"not open");
+        return false;
+    }
+
+    // Let the background thread complete its pending request.
+    {
+        Guard lock(_mutex);
+        _terminate = true;
+        _cond.signal();
+    }
+    Thread::waitForTermination();
+
+    // Close the current segment.
+    const bool success = _files[_segment % SLOT_COUNT].close(report);
+
+    // The next segment was created in advance and is still empty, delete it.
+    TSFileOutput& next(_files[(_segment + 1) % SLOT_COUNT]);
+    if (_next_ready && next.isOpen()) {
+        next.close(report);
+        DeleteFile(next.getFileName());
+    }
+
+    report.verbose(u"segmented output to %s: %d segments, %'d stalls, stall time: %'d ms",
+                   {_filename, _segment + 1, _stall_count, _stall_time / NanoSecPerMilliSec});
+
+    _is_open = false;
+    _report = 0;
+    return success;
+}
+
+
+//----------------------------------------------------------------------------
+// Write TS packets, switching to the next segments when necessary.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileOutputSegmented::write(const TSPacket* buffer, size_t packet_count, Report& report)
+{
+    if (!_is_open) {
+        report.error(u"not open");
+        return false;
+    }
+
+    while (packet_count > 0) {
+
+        // Count packets which fit in the current segment.
+        size_t count = 0;
+        bool next = false;
+        while (count < packet_count && !next) {
+            const TSPacket& pkt(buffer[count]);
+            const uint64_t size = _seg_size + count * PKT_SIZE;
+
+            // Limit by size.
+            next = _max_size > 0 && size > 0 && size + PKT_SIZE > _max_size;
+
+            // Limit by duration, using PCR's from the first PID which carries them.
+            if (!next && _max_pcr > 0 && pkt.hasPCR()) {
+                if (_pcr_pid == PID_NULL) {
+                    _pcr_pid = pkt.getPID();
+                }
+                if (pkt.getPID() == _pcr_pid) {
+                    const uint64_t pcr = pkt.getPCR();
+                    if (_last_pcr != INVALID_PCR && !pkt.getDiscontinuityIndicator()) {
+                        const uint64_t gap = (pcr + PCR_WRAP - _last_pcr) % PCR_WRAP;
+                        if (gap <= MAX_PCR_GAP) {
+                            _seg_pcr += gap;
+                        }
+                    }
+                    _last_pcr = pcr;
+                    // The packet is rechecked after the switch, with a null gap.
+                    next = size > 0 && _seg_pcr >= _max_pcr;
+                }
+            }
+
+            if (!next) {
+                count++;
+            }
+        }
+
+        // Write them.
+        if (count > 0 && !_files[_segment % SLOT_COUNT].write(buffer, count, report)) {
+            return false;
+        }
+        _seg_size += count * PKT_SIZE;
+        buffer += count;
+        packet_count -= count;
+
+        if (next && !switchSegment(report)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Switch to the next segment.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileOutputSegmented::switchSegment(Report& report)
+{
+    {
+        GuardCondition lock(_mutex, _cond);
+
+        // Normally, the next segment was open long ago. Otherwise, this is a stall.
+        if (!_next_ready && !_next_error) {
+            Monotonic start;
+            start.getSystemTime();
+            while (!_next_ready && !_next_error) {
+                lock.waitCondition();
+            }
+            Monotonic end;
+            end.getSystemTime();
+            _stall_count++;
+            _stall_time += end - start;
+        }
+
+        // The error was reported by the background thread.
+        if (_next_error) {
+            return false;
+        }
+        _next_ready = false;
+    }
+
+    // Without explicit size, preallocate the size of the completed segment.
+    const uint64_t prealloc = _prealloc > 0 ? _prealloc : (_max_size > 0 ? _max_size : _seg_size);
+
+    const size_t previous = _segment % SLOT_COUNT;
+    _segment++;
+    _seg_size = 0;
+    _seg_pcr = 0;
+    report.verbose(u"starting segment %s", {_files[_segment % SLOT_COUNT].getFileName()});
+
+    postRequest(previous, prealloc);
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Post a request to the background thread.
+//----------------------------------------------------------------------------
+
+void ts::TSFileOutputSegmented::postRequest(size_t close_slot, uint64_t prealloc)
+{
+    GuardCondition lock(_mutex, _cond);
+    _request = true;
+    _close_slot = close_slot;
+    _open_segment = _segment + 1;
+    _open_prealloc = prealloc;
+    lock.signal();
+}
+
+
+//----------------------------------------------------------------------------
+// Background thread: close the previous segment, delete the oldest ones
+// and open the next one.
+//----------------------------------------------------------------------------
+
+void ts::TSFileOutputSegmented::main()
+{
+    for (;;) {
+        size_t close_slot = SLOT_COUNT;
+        size_t index = 0;
+        uint64_t prealloc = 0;
+
+        // Wait for a request. Terminate only when no request is pending.
+        {
+            GuardCondition lock(_mutex, _cond);
+            while (!_request && !_terminate) {
+                lock.waitCondition();
+            }
+            if (!_request) {
+                break;
+            }
+            _request = false;
+            close_slot = _close_slot;
+            index = _open_segment;
+            prealloc = _open_prealloc;
+        }
+
+        // Close the previous segment. In asynchronous mode, this flushes its queue.
+        if (close_slot < SLOT_COUNT) {
+            _files[close_slot].close(*_report);
+        }
+
+        // Delete the oldest segment when the maximum number of files is reached.
+        // The current segment is index - 1.
+        if (_max_files > 0 && index > _max_files) {
+            const UString name(SegmentFileName(_filename, index - 1 - _max_files));
+            const ErrorCode err = DeleteFile(name);
+            if (err != SYS_SUCCESS) {
+                _report->warning(u"error deleting %s: %s", {name, ErrorCodeMessage(err)});
+            }
+            else {
+                _report->debug(u"deleted %s", {name});
+            }
+        }
+
+        // Open the next segment.
+        const bool success = openSegment(index % SLOT_COUNT, index, prealloc, *_report);
+
+        GuardCondition lock(_mutex, _cond);
+        _next_ready = success;
+        _next_error = !success;
+        lock.signal();
+    }
+}
@@ -0,0 +1,206 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Transport stream file output, rotating segments by size or duration.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsTSFileOutput.h"
+
+namespace ts {
+    //!
+    //! Transport stream file output, rotating segments by size or duration.
+    //!
+    //! The output is a sequence of segment files. The name of each segment is built
+    //! from the base file name and the segment index ("dir/foo.ts" => "dir/foo-000000.ts",
+    //! "dir/foo-000001.ts", etc.) A new segment is started when the current one reaches
+    //! a maximum size or a maximum duration. The duration is computed from the PCR's
+    //! of the first PID which carries PCR's.
+    //!
+    //! The next segment is opened (and its disk space preallocated) by a background
+    //! thread, before the switch occurs. The previous segment is closed by the same
+    //! background thread and, optionally, the oldest segments are deleted. The thread
+    //! calling write() is blocked only when the next segment is not ready yet.
+    //!
+    class TSDUCKDLL TSFileOutputSegmented: private Thread
+    {
+    public:
+        //!
+        //! Default constructor.
+        //!
+        TSFileOutputSegmented();
+
+        //!
+        //! Destructor.
+        //!
+        virtual ~TSFileOutputSegmented();
+
+        //!
+        //! Set the segmentation parameters.
+        //! Must be called before open().
+        //! @param [in] max_size Maximum size in bytes of each segment. Zero means unlimited.
+        //! The size is rounded down to a whole number of packets.
+        //! @param [in] max_duration Maximum duration in milliseconds of each segment. Zero means unlimited.
+        //! @param [in] max_files Maximum number of segment files to keep. When a new segment
+        //! is started, the oldest ones are deleted. Zero means unlimited.
+        //!
+        void setSegmentation(uint64_t max_size, MilliSecond max_duration, size_t max_files = 0);
+
+        //!
+        //! Set the preallocation size of each segment.
+        //! Must be called before open().
+        //! @param [in] size Number of bytes to reserve in each segment. When zero (the default),
+        //! use the maximum size of the segments, if specified, or the size of the previous segment.
+        //! @see TSFileOutput::setPreallocation()
+        //!
+        void setPreallocation(uint64_t size)
+        {
+            _prealloc = size;
+        }
+
+        //!
+        //! Set the asynchronous write mode of each segment.
+        //! Must be called before open().
+        //! @param [in] async When true, use the asynchronous mode. The default is false.
+        //! @param [in] max_queued Maximum size in bytes of queued data. If zero, use the default.
+        //! @param [in] write_size Size in bytes of each write operation. If zero, use the default.
+        //! @see TSFileOutput::setAsynchronous()
+        //!
+        void setAsynchronous(bool async, size_t max_queued = 0, size_t write_size = 0);
+
+        //!
+        //! Create the first segment.
+        //! @param [in] filename Base file name. Cannot be empty.
+        //! @param [in] keep Keep previous files with same names. Fail if one of them already exists.
+        //! @param [in,out] report Where to report errors. Also used by the background thread
+        //! until close() is called, must be thread-safe.
+        //! @return True on success, false on error.
+        //!
+        bool open(const UString& filename, bool keep, Report& report);
+
+        //!
+        //! Close the current segment.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on error.
+        //!
+        bool close(Report& report);
+
+        //!
+        //! Write TS packets, switching to the next segments when necessary.
+        //! @param [in] buffer Address of first packet to write.
+        //! @param [in] packet_count Number of packets to write.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on error.
+        //!
+        bool write(const TSPacket* buffer, size_t packet_count, Report& report);
+
+        //!
+        //! Check if the output is open.
+        //! @return True if the output is open.
+        //!
+        bool isOpen() const
+        {
+            return _is_open;
+        }
+
+        //!
+        //! Get the number of segments which were started since open().
+        //! @return The number of segments.
+        //!
+        size_t getSegmentCount() const
+        {
+            return _is_open ? _segment + 1 : _segment;
+        }
+
+        //!
+        //! Build the file name of a segment.
+        //! @param [in] filename Base file name.
+        //! @param [in] index Segment index.
+        //! @return The segment file name ("dir/foo.ts", 12 => "dir/foo-000012.ts").
+        //!
+        static UString SegmentFileName(const UString& filename, size_t index);
+
+    private:
+        // Number of segment files for rotation: current one, next one (opened
+        // in advance) and previous one (closing in the background).
+        static const size_t SLOT_COUNT = 3;
+
+        // Configuration.
+        UString       _filename;       // Base file name
+        bool          _keep;           // Keep existing files
+        uint64_t      _max_size;       // Maximum segment size, zero if unlimited
+        uint64_t      _max_pcr;        // Maximum segment duration in PCR units, zero if unlimited
+        size_t        _max_files;      // Maximum number of kept segments, zero if unlimited
+        uint64_t      _prealloc;       // Preallocation size
+        bool          _async;          // Asynchronous write mode
+        size_t        _max_queued;     // Maximum size of queued data in asynchronous mode
+        size_t        _write_size;     // Size of each write operation in asynchronous mode
+
+        // State of the writer side.
+        bool          _is_open;        // Output is open
+        Report*       _report;         // Where to report errors in the background thread
+        TSFileOutput  _files[SLOT_COUNT]; // Rotating segment files, segment N uses slot N % SLOT_COUNT
+        size_t        _segment;        // Index of current segment
+        uint64_t      _seg_size;       // Size in bytes of current segment
+        uint64_t      _seg_pcr;        // Duration of current segment in PCR units
+        PID           _pcr_pid;        // Reference PID for duration, PID_NULL if none yet
+        uint64_t      _last_pcr;       // Last PCR value in reference PID, INVALID_PCR if none
+        size_t        _stall_count;    // Number of times write() waited for the next segment
+        NanoSecond    _stall_time;     // Total waiting time in write()
+
+        // Communication with the background thread, protected by the mutex.
+        Mutex         _mutex;          // Protect the following fields
+        Condition     _cond;           // Signaled when a request is posted or completed
+        bool          _request;        // A request is pending for the background thread
+        bool          _terminate;      // Request termination of the background thread
+        bool          _next_ready;     // The next segment is open
+        bool          _next_error;     // The next segment could not be open
+        size_t        _close_slot;     // Slot to close in the request, SLOT_COUNT if none
+        size_t        _open_segment;   // Index of segment to open in the request
+        uint64_t      _open_prealloc;  // Size to preallocate in the next segment
+
+        // Post a request to close a slot and open the next segment in the background.
+        void postRequest(size_t close_slot, uint64_t prealloc);
+
+        // Switch to the next segment.
+        bool switchSegment(Report& report);
+
+        // Open a new segment in a slot.
+        bool openSegment(size_t slot, size_t index, uint64_t prealloc, Report& report);
+
+        // Background thread.
+        virtual void main() override;
+
+        // Inaccessible operations
+        TSFileOutputSegmented(const TSFileOutputSegmented&) = delete;
+        TSFileOutputSegmented& operator=(const TSFileOutputSegmented&) = delete;
+    };
+}
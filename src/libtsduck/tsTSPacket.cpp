@@ -32,8 +32,11 @@
 //----------------------------------------------------------------------------
 
 #include "tsTSPacket.h"
+#include "tsTSPacketView.h"
 #include "tsPCR.h"
 #include "tsNames.h"
+#include "tsBlockOutputStream.h"
+#include "tsMemoryUtils.h"
 TSDUCK_SOURCE;
 
 
@@ -114,6 +117,53 @@ void ts::TSPacket::SanityCheck ()
     assert (reinterpret_cast<char*> (&(pa[1])) == reinterpret_cast<char*> (&(pa[0])) + PKT_SIZE);
 }
 
+//----------------------------------------------------------------------------
+// Locate contiguous TS packets into a buffer.
+//----------------------------------------------------------------------------
+
+bool ts::TSPacket::Locate(const uint8_t* buffer, size_t buffer_size, size_t& start, size_t& count)
+{
+    start = count = 0;
+
+    // To face a header before the first TS packet, we look backward from the
+    // end of the buffer, looking for a 0x47 sync byte every 188 bytes, going
+    // backward.
+
+    const uint8_t* p;
+    for (p = buffer + buffer_size; p >= buffer + PKT_SIZE && p[-int(PKT_SIZE)] == SYNC_BYTE; p -= PKT_SIZE) {}
+
+    if (p < buffer + buffer_size) {
+        // Some packets were found
+        start = p - buffer;
+        count = (buffer + buffer_size - p) / PKT_SIZE;
+        return true;
+    }
+
+    // If no TS packet is found using the first method, we restart from
+    // the beginning of the buffer, looking for a 0x47 sync byte every
+    // 188 bytes, going forward. If we find this pattern, followed by
+    // less than 188 bytes, then we have found a sequence of TS packets.
+
+    // The number of packets after a candidate start depends on the candidate.
+    // The candidates with the same number of packets are checked together.
+
+    for (size_t remain = buffer_size / PKT_SIZE; remain > 0; --remain) {
+        const size_t first = buffer_size < (remain + 1) * PKT_SIZE ? 0 : buffer_size - (remain + 1) * PKT_SIZE + 1;
+        const size_t size = buffer_size - first;
+        p = reinterpret_cast<const uint8_t*>(LocateSyncBytes(buffer + first, size, PKT_SIZE, 0, remain, SYNC_BYTE));
+        if (p != 0) {
+            // Less than 188 bytes after last packet. Consider we are OK
+            start = p - buffer;
+            count = remain;
+            return true;
+        }
+    }
+
+    // No TS packet found.
+    return false;
+}
+
+
 //----------------------------------------------------------------------------
 // Check if the packet contains the start of a clear PES header.
 //----------------------------------------------------------------------------
@@ -451,9 +501,181 @@ std::ostream& ts::TSPacket::display(std::ostream& strm, uint32_t flags, int inde
             size = payload_size;
             strm << margin << "---- TS Packet Payload (" << size << " bytes) ----" << std::endl;
         }
-        // The 16 LSB contains flags for Hexa.
-        strm << UString::Dump(data, size, flags & 0x0000FFFF, indent);
+        // The 16 LSB contains flags for Hexa. Block output streams render the dump directly.
+        BlockOutputStream* const bout = dynamic_cast<BlockOutputStream*>(&strm);
+        if (bout != 0) {
+            bout->putDump(data, size, flags & 0x0000FFFF, indent);
+        }
+        else {
+            strm << UString::Dump(data, size, flags & 0x0000FFFF, indent);
+        }
     }
 
     return strm;
 }
+
+
+//----------------------------------------------------------------------------
+// Batch operations on arrays of packets. The 4-byte header is loaded as one
+// 32-bit value: sync byte, PID and CC are extracted with shifts and masks.
+//----------------------------------------------------------------------------
+
+namespace {
+    const uint32_t HEADER_SYNC_MASK = 0xFF000000;
+    const uint32_t HEADER_SYNC      = uint32_t(ts::SYNC_BYTE) << 24;
+    const uint32_t HEADER_NULL_MASK = 0xFF1FFF00;
+    const uint32_t HEADER_NULL      = HEADER_SYNC | (uint32_t(ts::PID_NULL) << 8);
+
+    inline ts::PID HeaderPID(uint32_t header) {return ts::PID((header >> 8) & 0x1FFF);}
+
+    // The implementations are common to dense arrays of packets and views with any stride.
+    template <class PKTS>
+    void GetPIDsT(const PKTS& pkts, size_t count, ts::PID* pids)
+    {
+        for (size_t i = 0; i < count; ++i) {
+            pids[i] = HeaderPID(ts::GetUInt32(pkts[i].b));
+        }
+    }
+
+    template <class PKTS>
+    size_t CountPIDsT(const PKTS& pkts, size_t count, ts::PacketCounter* counters)
+    {
+        size_t counted = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const uint32_t header = ts::GetUInt32(pkts[i].b);
+            if ((header & HEADER_SYNC_MASK) == HEADER_SYNC) {
+                counters[HeaderPID(header)]++;
+                counted++;
+            }
+        }
+        return counted;
+    }
+
+    template <class PKTS>
+    size_t CountValidSyncT(const PKTS& pkts, size_t count)
+    {
+        size_t counted = 0;
+        for (size_t i = 0; i < count; ++i) {
+            counted += pkts[i].b[0] == ts::SYNC_BYTE;
+        }
+        return counted;
+    }
+
+    template <class PKTS>
+    size_t FindInvalidSyncT(const PKTS& pkts, size_t count)
+    {
+        size_t i = 0;
+        while (i < count && pkts[i].b[0] == ts::SYNC_BYTE) {
+            ++i;
+        }
+        return i;
+    }
+
+    template <class PKTS>
+    size_t CountNullPacketsT(const PKTS& pkts, size_t count)
+    {
+        size_t counted = 0;
+        for (size_t i = 0; i < count; ++i) {
+            counted += (ts::GetUInt32(pkts[i].b) & HEADER_NULL_MASK) == HEADER_NULL;
+        }
+        return counted;
+    }
+
+    template <class PKTS>
+    size_t FindNullPacketT(const PKTS& pkts, size_t count)
+    {
+        size_t i = 0;
+        while (i < count && (ts::GetUInt32(pkts[i].b) & HEADER_NULL_MASK) != HEADER_NULL) {
+            ++i;
+        }
+        return i;
+    }
+
+    template <class PKTS>
+    size_t CheckContinuityT(const PKTS& pkts, size_t count, uint8_t* last_cc)
+    {
+        for (size_t i = 0; i < count; ++i) {
+            const uint32_t header = ts::GetUInt32(pkts[i].b);
+            const ts::PID pid = HeaderPID(header);
+            if ((header & HEADER_SYNC_MASK) == HEADER_SYNC && pid != ts::PID_NULL) {
+                const uint8_t cc = uint8_t(header & 0x0F);
+                const uint8_t last = last_cc[pid];
+                if (last < 16 && last != cc && ((last + 1) & 0x0F) != cc) {
+                    return i;
+                }
+                last_cc[pid] = cc;
+            }
+        }
+        return count;
+    }
+}
+
+void ts::TSPacket::GetPIDs(const TSPacket* pkts, size_t count, PID* pids)
+{
+    GetPIDsT(pkts, count, pids);
+}
+
+void ts::TSPacket::GetPIDs(const TSPacketView& pkts, size_t count, PID* pids)
+{
+    GetPIDsT(pkts, count, pids);
+}
+
+size_t ts::TSPacket::CountPIDs(const TSPacket* pkts, size_t count, PacketCounter* counters)
+{
+    return CountPIDsT(pkts, count, counters);
+}
+
+size_t ts::TSPacket::CountPIDs(const TSPacketView& pkts, size_t count, PacketCounter* counters)
+{
+    return CountPIDsT(pkts, count, counters);
+}
+
+size_t ts::TSPacket::CountValidSync(const TSPacket* pkts, size_t count)
+{
+    return CountValidSyncT(pkts, count);
+}
+
+size_t ts::TSPacket::CountValidSync(const TSPacketView& pkts, size_t count)
+{
+    return CountValidSyncT(pkts, count);
+}
+
+size_t ts::TSPacket::FindInvalidSync(const TSPacket* pkts, size_t count)
+{
+    return FindInvalidSyncT(pkts, count);
+}
+
+size_t ts::TSPacket::FindInvalidSync(const TSPacketView& pkts, size_t count)
+{
+    return FindInvalidSyncT(pkts, count);
+}
+
+size_t ts::TSPacket::CountNullPackets(const TSPacket* pkts, size_t count)
+{
+    return CountNullPacketsT(pkts, count);
+}
+
+size_t ts::TSPacket::CountNullPackets(const TSPacketView& pkts, size_t count)
+{
+    return CountNullPacketsT(pkts, count);
+}
+
+size_t ts::TSPacket::FindNullPacket(const TSPacket* pkts, size_t count)
+{
+    return FindNullPacketT(pkts, count);
+}
+
+size_t ts::TSPacket::FindNullPacket(const TSPacketView& pkts, size_t count)
+{
+    return FindNullPacketT(pkts, count);
+}
+
+size_t ts::TSPacket::CheckContinuity(const TSPacket* pkts, size_t count, uint8_t* last_cc)
+{
+    return CheckContinuityT(pkts, count, last_cc);
+}
+
+size_t ts::TSPacket::CheckContinuity(const TSPacketView& pkts, size_t count, uint8_t* last_cc)
+{
+    return CheckContinuityT(pkts, count, last_cc);
+}
@@ -38,6 +38,9 @@
 #include "tsException.h"
 
 namespace ts {
+
+    class TSPacketView;
+
     //!
     //! Basic definition of an MPEG-2 transport packet.
     //!
@@ -496,6 +499,165 @@ namespace ts {
         //!
         static void SanityCheck();
 
+        //!
+        //! Locate contiguous TS packets into a buffer.
+        //!
+        //! The buffer is typically a UDP message. Basically, it is expected to contain
+        //! only TS packets. However, there may be a header before the first TS packet
+        //! (RTP for instance) and a truncated packet at the end of the buffer.
+        //!
+        //! @param [in] buffer Address of the buffer.
+        //! @param [in] buffer_size Buffer size in bytes.
+        //! @param [out] start Index in @a buffer of the first TS packet.
+        //! @param [out] count Number of contiguous TS packets, starting at @a start.
+        //! @return True if at least one TS packet was found, false otherwise.
+        //!
+        static bool Locate(const uint8_t* buffer, size_t buffer_size, size_t& start, size_t& count);
+
+        //!
+        //! @name Batch operations on arrays of packets.
+        //!
+        //! These functions process contiguous arrays of packets in one tight loop, without
+        //! per-packet function call. They only access the 4-byte header of the packets.
+        //! Except GetPIDs(), they ignore the packets which do not start with a sync byte,
+        //! typically the packets which were dropped by a previous plugin in @c tsp.
+        //!
+        //! @{
+
+        //!
+        //! Extract the PID's of an array of packets.
+        //! @param [in] pkts Address of the first packet.
+        //! @param [in] count Number of packets.
+        //! @param [out] pids Address of an array of @a count PID values.
+        //!
+        static void GetPIDs(const TSPacket* pkts, size_t count, PID* pids);
+
+        //!
+        //! Count the packets per PID in an array of packets.
+        //! @param [in] pkts Address of the first packet.
+        //! @param [in] count Number of packets.
+        //! @param [in,out] counters Array of PID_MAX counters, indexed by PID. The counters are
+        //! incremented, they are not reset first.
+        //! @return The number of counted packets (with a sync byte).
+        //!
+        static size_t CountPIDs(const TSPacket* pkts, size_t count, PacketCounter* counters);
+
+        //!
+        //! Count the packets with a sync byte in an array of packets.
+        //! @param [in] pkts Address of the first packet.
+        //! @param [in] count Number of packets.
+        //! @return The number of packets which start with a sync byte.
+        //!
+        static size_t CountValidSync(const TSPacket* pkts, size_t count);
+
+        //!
+        //! Find the first packet without sync byte in an array of packets.
+        //! @param [in] pkts Address of the first packet.
+        //! @param [in] count Number of packets.
+        //! @return The index of the first packet which does not start with a sync byte
+        //! or @a count if all packets are valid.
+        //!
+        static size_t FindInvalidSync(const TSPacket* pkts, size_t count);
+
+        //!
+        //! Count the null packets in an array of packets.
+        //! @param [in] pkts Address of the first packet.
+        //! @param [in] count Number of packets.
+        //! @return The number of null packets.
+        //!
+        static size_t CountNullPackets(const TSPacket* pkts, size_t count);
+
+        //!
+        //! Find the first null packet in an array of packets.
+        //! @param [in] pkts Address of the first packet.
+        //! @param [in] count Number of packets.
+        //! @return The index of the first null packet or @a count if there is none.
+        //!
+        static size_t FindNullPacket(const TSPacket* pkts, size_t count);
+
+        //!
+        //! Check the continuity counters in an array of packets.
+        //!
+        //! A continuity error is a packet in a non-null PID with a CC which is neither the
+        //! previous CC on the PID (duplicated packet) nor its successor. The first packet
+        //! in a PID, when its last CC is greater than 15, is never an error.
+        //!
+        //! The checking stops on the first error. The last CC of the PID of the faulty packet
+        //! is not updated so that the caller can evaluate the number of missing packets.
+        //! To continue the checking, update @a last_cc and restart after the faulty packet.
+        //!
+        //! @param [in] pkts Address of the first packet.
+        //! @param [in] count Number of packets.
+        //! @param [in,out] last_cc Array of PID_MAX last continuity counters, indexed by PID.
+        //! Initially set to a value greater than 15 in all PID's. Updated with each checked packet.
+        //! @return The index of the first packet with a continuity error or @a count if there is none.
+        //!
+        static size_t CheckContinuity(const TSPacket* pkts, size_t count, uint8_t* last_cc);
+
+        //!
+        //! Extract the PID's of packets with any stride.
+        //! @param [in] pkts View on the first packet.
+        //! @param [in] count Number of packets.
+        //! @param [out] pids Address of an array of @a count PID values.
+        //! @see GetPIDs(const TSPacket*, size_t, PID*)
+        //!
+        static void GetPIDs(const TSPacketView& pkts, size_t count, PID* pids);
+
+        //!
+        //! Count the packets per PID in packets with any stride.
+        //! @param [in] pkts View on the first packet.
+        //! @param [in] count Number of packets.
+        //! @param [in,out] counters Array of PID_MAX counters, indexed by PID.
+        //! @return The number of counted packets (with a sync byte).
+        //! @see CountPIDs(const TSPacket*, size_t, PacketCounter*)
+        //!
+        static size_t CountPIDs(const TSPacketView& pkts, size_t count, PacketCounter* counters);
+
+        //!
+        //! Count the packets with a sync byte in packets with any stride.
+        //! @param [in] pkts View on the first packet.
+        //! @param [in] count Number of packets.
+        //! @return The number of packets which start with a sync byte.
+        //!
+        static size_t CountValidSync(const TSPacketView& pkts, size_t count);
+
+        //!
+        //! Find the first packet without sync byte in packets with any stride.
+        //! @param [in] pkts View on the first packet.
+        //! @param [in] count Number of packets.
+        //! @return The index of the first packet which does not start with a sync byte
+        //! or @a count if all packets are valid.
+        //!
+        static size_t FindInvalidSync(const TSPacketView& pkts, size_t count);
+
+        //!
+        //! Count the null packets in packets with any stride.
+        //! @param [in] pkts View on the first packet.
+        //! @param [in] count Number of packets.
+        //! @return The number of null packets.
+        //!
+        static size_t CountNullPackets(const TSPacketView& pkts, size_t count);
+
+        //!
+        //! Find the first null packet in packets with any stride.
+        //! @param [in] pkts View on the first packet.
+        //! @param [in] count Number of packets.
+        //! @return The index of the first null packet or @a count if there is none.
+        //!
+        static size_t FindNullPacket(const TSPacketView& pkts, size_t count);
+
+        //!
+        //! Check the continuity counters in packets with any stride.
+        //! @param [in] pkts View on the first packet.
+        //! @param [in] count Number of packets.
+        //! @param [in,out] last_cc Array of PID_MAX last continuity counters, indexed by PID.
+        //! @return The index of the first packet with a continuity error or @a count if there is none.
+        //! @see CheckContinuity(const TSPacket*, size_t, uint8_t*)
+        //!
+        static size_t CheckContinuity(const TSPacketView& pkts, size_t count, uint8_t* last_cc);
+
+        //! @}
+
     private:
         // These private methods compute the offset of PCR, OPCR, PTS, DTS.
         // Return 0 if there is none.
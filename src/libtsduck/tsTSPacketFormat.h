@@ -0,0 +1,80 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Format of TS packets in files (plain, M2TS, Reed-Solomon).
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsEnumeration.h"
+#include "tsMPEG.h"
+
+namespace ts {
+    //!
+    //! Format of TS packets in files.
+    //!
+    enum TSPacketFormat {
+        TS_FORMAT_TS,     //!< Plain 188-byte TS packets.
+        TS_FORMAT_M2TS,   //!< 192-byte packets with a leading 4-byte arrival time stamp (M2TS format, Blu-ray discs).
+        TS_FORMAT_RS204,  //!< 204-byte packets with a trailing 16-byte Reed-Solomon outer FEC.
+    };
+
+    //!
+    //! Enumeration description of ts::TSPacketFormat, for command line options.
+    //!
+    TSDUCKDLL extern const Enumeration TSPacketFormatEnum;
+
+    //!
+    //! Get the size in bytes of a packet in a file, in a given format.
+    //! @param [in] format Packet format.
+    //! @return The size in bytes of a packet, including the leading or trailing extra bytes.
+    //!
+    TSDUCKDLL inline size_t PacketFormatSize(TSPacketFormat format)
+    {
+        return format == TS_FORMAT_M2TS ? PKT_M2TS_SIZE : (format == TS_FORMAT_RS204 ? PKT_RS_SIZE : PKT_SIZE);
+    }
+
+    //!
+    //! Get the size in bytes of the leading extra bytes before each TS packet in a file.
+    //! @param [in] format Packet format.
+    //! @return The offset of the 188-byte TS packet in a packet of the file.
+    //!
+    TSDUCKDLL inline size_t PacketFormatHeaderSize(TSPacketFormat format)
+    {
+        return format == TS_FORMAT_M2TS ? M2TS_HEADER_SIZE : 0;
+    }
+
+    //!
+    //! Mask of the 30-bit arrival time stamp in the 4-byte header of M2TS packets.
+    //! The two most significant bits are the copy permission indicator.
+    //! The arrival time stamp is expressed in units of the 27 MHz system clock.
+    //!
+    const uint32_t M2TS_ARRIVAL_TIME_MASK = 0x3FFFFFFF;
+}
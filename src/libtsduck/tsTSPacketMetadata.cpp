@@ -0,0 +1,84 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  Metadata of a TS packet.
+//
+//----------------------------------------------------------------------------
+
+#include "tsTSPacketMetadata.h"
+TSDUCK_SOURCE;
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::TSPacketMetadata::LABEL_COUNT;
+const ts::NanoSecond ts::TSPacketMetadata::NO_TIME_STAMP;
+const uint16_t ts::TSPacketMetadata::NO_SOURCE;
+#endif
+
+
+//----------------------------------------------------------------------------
+// Set or clear a label on the packet.
+//----------------------------------------------------------------------------
+
+void ts::TSPacketMetadata::setLabel(size_t label, bool on)
+{
+    if (label < LABEL_COUNT) {
+        const uint32_t mask = uint32_t(1) << label;
+        _labels = on ? (_labels | mask) : (_labels & ~mask);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Operations on arrays of metadata.
+//----------------------------------------------------------------------------
+
+void ts::TSPacketMetadata::Reset(TSPacketMetadata* mdata, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        mdata[i].reset();
+    }
+}
+
+size_t ts::TSPacketMetadata::CountDropped(const TSPacketMetadata* mdata, size_t count)
+{
+    size_t n = 0;
+    while (n < count && (mdata[n]._flags & DROPPED) != 0) {
+        ++n;
+    }
+    return n;
+}
+
+size_t ts::TSPacketMetadata::CountNotDropped(const TSPacketMetadata* mdata, size_t count)
+{
+    size_t n = 0;
+    while (n < count && (mdata[n]._flags & DROPPED) == 0) {
+        ++n;
+    }
+    return n;
+}
@@ -0,0 +1,332 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Metadata of a TS packet, in parallel with the packet buffer in tsp.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsPlatform.h"
+
+namespace ts {
+    //!
+    //! Metadata of a TS packet.
+    //!
+    //! In the tsp packet buffer, there is one instance of this class per TS packet,
+    //! in a separate array which is indexed like the packet buffer. The metadata
+    //! contain information which is attached to the packet but which is not part
+    //! of the packet content (input time stamp, input source, drop and null flags,
+    //! labels, arrival time stamp from M2TS files).
+    //!
+    //! For performance reason, this class is kept small and the metadata of all
+    //! packets are stored in a dense array. Scanning the metadata is cheaper than
+    //! scanning the 188-byte packets.
+    //!
+    class TSDUCKDLL TSPacketMetadata
+    {
+    public:
+        //!
+        //! Number of labels which can be attached to a packet.
+        //! Labels are identified by an index in the range 0 to LABEL_COUNT-1.
+        //!
+        static const size_t LABEL_COUNT = 32;
+
+        //!
+        //! Value of the input time stamp when it is not set.
+        //!
+        static const NanoSecond NO_TIME_STAMP = -1;
+
+        //!
+        //! Value of the input source index when it is not set.
+        //!
+        static const uint16_t NO_SOURCE = 0xFFFF;
+
+        //!
+        //! Default constructor.
+        //!
+        TSPacketMetadata() :
+            _input_time(NO_TIME_STAMP),
+            _labels(0),
+            _arrival_time(0),
+            _source(NO_SOURCE),
+            _flags(0)
+        {
+        }
+
+        //!
+        //! Reset the content of the metadata, as for a new packet.
+        //!
+        void reset()
+        {
+            _input_time = NO_TIME_STAMP;
+            _labels = 0;
+            _arrival_time = 0;
+            _source = NO_SOURCE;
+            _flags = 0;
+        }
+
+        //!
+        //! Check if the packet has been dropped by a packet processor.
+        //! @return True if the packet has been dropped.
+        //!
+        bool getDropped() const
+        {
+            return (_flags & DROPPED) != 0;
+        }
+
+        //!
+        //! Mark the packet as dropped or not dropped.
+        //! @param [in] on True to mark the packet as dropped.
+        //!
+        void setDropped(bool on)
+        {
+            setFlag(DROPPED, on);
+        }
+
+        //!
+        //! Check if the packet has been nullified by a packet processor.
+        //! @return True if the packet has been replaced by a null packet.
+        //!
+        bool getNullified() const
+        {
+            return (_flags & NULLIFIED) != 0;
+        }
+
+        //!
+        //! Mark the packet as nullified or not.
+        //! @param [in] on True to mark the packet as nullified.
+        //!
+        void setNullified(bool on)
+        {
+            setFlag(NULLIFIED, on);
+        }
+
+        //!
+        //! Check if the packet has an input time stamp.
+        //! @return True if the packet has an input time stamp.
+        //!
+        bool hasInputTimeStamp() const
+        {
+            return _input_time >= 0;
+        }
+
+        //!
+        //! Get the input time stamp of the packet.
+        //! @return The input time stamp in nanoseconds, relative to an arbitrary origin
+        //! which is the same for all packets of the stream. Return NO_TIME_STAMP if unset.
+        //!
+        NanoSecond getInputTimeStamp() const
+        {
+            return _input_time;
+        }
+
+        //!
+        //! Set the input time stamp of the packet.
+        //! @param [in] time The input time stamp in nanoseconds, relative to an arbitrary
+        //! origin which is the same for all packets of the stream.
+        //!
+        void setInputTimeStamp(NanoSecond time)
+        {
+            _input_time = time < 0 ? NO_TIME_STAMP : time;
+        }
+
+        //!
+        //! Check if the packet has an input source index.
+        //! @return True if the packet has an input source index.
+        //!
+        bool hasInputSource() const
+        {
+            return _source != NO_SOURCE;
+        }
+
+        //!
+        //! Get the input source index of the packet.
+        //! When an input plugin receives packets from several sources (several
+        //! UDP streams for instance), the source index identifies the origin of
+        //! the packet. The meaning of the index is defined by the input plugin.
+        //! @return The input source index or NO_SOURCE if unset.
+        //!
+        uint16_t getInputSource() const
+        {
+            return _source;
+        }
+
+        //!
+        //! Set the input source index of the packet.
+        //! @param [in] source The input source index.
+        //!
+        void setInputSource(uint16_t source)
+        {
+            _source = source;
+        }
+
+        //!
+        //! Check if the packet has an arrival time stamp.
+        //! @return True if the packet has an arrival time stamp.
+        //!
+        bool hasArrivalTimeStamp() const
+        {
+            return (_flags & ARRIVAL_TIME) != 0;
+        }
+
+        //!
+        //! Get the arrival time stamp of the packet.
+        //! The arrival time stamp comes from the 4-byte header of a packet in an M2TS file.
+        //! @return The 30-bit arrival time stamp in units of the 27 MHz system clock.
+        //! Zero if unset.
+        //!
+        uint32_t getArrivalTimeStamp() const
+        {
+            return _arrival_time;
+        }
+
+        //!
+        //! Set the arrival time stamp of the packet.
+        //! @param [in] time The 30-bit arrival time stamp in units of the 27 MHz system
+        //! clock. The upper bits are ignored.
+        //!
+        void setArrivalTimeStamp(uint32_t time)
+        {
+            _arrival_time = time & 0x3FFFFFFF;
+            _flags |= ARRIVAL_TIME;
+        }
+
+        //!
+        //! Check if the packet has a given label.
+        //! @param [in] label The label to check, from 0 to LABEL_COUNT-1.
+        //! @return True if the packet has this label.
+        //!
+        bool hasLabel(size_t label) const
+        {
+            return label < LABEL_COUNT && (_labels & (uint32_t(1) << label)) != 0;
+        }
+
+        //!
+        //! Set or clear a label on the packet.
+        //! @param [in] label The label to set or clear, from 0 to LABEL_COUNT-1.
+        //! @param [in] on True to set the label, false to clear it.
+        //!
+        void setLabel(size_t label, bool on = true);
+
+        //!
+        //! Get all labels of the packet as a bit mask.
+        //! @return A bit mask of labels, bit N is set when label N is set.
+        //!
+        uint32_t labels() const
+        {
+            return _labels;
+        }
+
+        //!
+        //! Set all labels of the packet as a bit mask.
+        //! @param [in] mask A bit mask of labels, bit N is set when label N is set.
+        //!
+        void setLabels(uint32_t mask)
+        {
+            _labels = mask;
+        }
+
+        //!
+        //! Reset the metadata of a contiguous array of packets.
+        //! @param [in,out] mdata Address of the first metadata.
+        //! @param [in] count Number of metadata to reset.
+        //!
+        static void Reset(TSPacketMetadata* mdata, size_t count);
+
+        //!
+        //! Count the number of consecutive dropped packets in an array of metadata.
+        //! @param [in] mdata Address of the first metadata.
+        //! @param [in] count Number of metadata in the array.
+        //! @return The number of consecutive dropped packets, starting at @a mdata.
+        //!
+        static size_t CountDropped(const TSPacketMetadata* mdata, size_t count);
+
+        //!
+        //! Count the number of consecutive non-dropped packets in an array of metadata.
+        //! @param [in] mdata Address of the first metadata.
+        //! @param [in] count Number of metadata in the array.
+        //! @return The number of consecutive non-dropped packets, starting at @a mdata.
+        //!
+        static size_t CountNotDropped(const TSPacketMetadata* mdata, size_t count);
+
+    private:
+        // Bit masks in _flags.
+        enum : uint8_t {
+            DROPPED      = 0x01,
+            NULLIFIED    = 0x02,
+            ARRIVAL_TIME = 0x04,
+        };
+
+        NanoSecond _input_time;  // Input time stamp in nanoseconds, negative if unset.
+        uint32_t   _labels;      // Bit mask of labels.
+        uint32_t   _arrival_time; // M2TS arrival time stamp, valid if ARRIVAL_TIME is set.
+        uint16_t   _source;      // Input source index, NO_SOURCE if unset.
+        uint8_t    _flags;       // Bit mask of flags.
+
+        // Set or clear a flag.
+        void setFlag(uint8_t mask, bool on)
+        {
+            _flags = on ? (_flags | mask) : (_flags & ~mask);
+        }
+    };
+
+    struct TSPacket;
+
+    //!
+    //! Description of a contiguous run of TS packets and their metadata.
+    //!
+    //! A list of runs describes non-contiguous packets which are output in one single
+    //! scatter/gather operation, typically the non-dropped packets of a tsp buffer window.
+    //!
+    struct TSDUCKDLL TSPacketRun
+    {
+        const TSPacket*         packets;   //!< Address of the first packet of the run.
+        const TSPacketMetadata* metadata;  //!< Address of the metadata of the first packet, in parallel with @a packets, can be null.
+        size_t                  count;     //!< Number of packets in the run.
+
+        //!
+        //! Constructor.
+        //! @param [in] pkt Address of the first packet of the run.
+        //! @param [in] mdata Address of the metadata of the first packet, can be null.
+        //! @param [in] cnt Number of packets in the run.
+        //!
+        TSPacketRun(const TSPacket* pkt = 0, const TSPacketMetadata* mdata = 0, size_t cnt = 0) :
+            packets(pkt),
+            metadata(mdata),
+            count(cnt)
+        {
+        }
+    };
+
+    //!
+    //! Vector of runs of TS packets, for scatter/gather output operations.
+    //!
+    typedef std::vector<TSPacketRun> TSPacketRunVector;
+}
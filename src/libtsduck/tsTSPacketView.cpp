@@ -0,0 +1,68 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  View on an array of TS packets with a possibly padded stride.
+//
+//----------------------------------------------------------------------------
+
+#include "tsTSPacketView.h"
+TSDUCK_SOURCE;
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::TSPacketView::ALIGNMENT;
+#endif
+
+
+//----------------------------------------------------------------------------
+// Conversions with dense arrays of packets.
+//----------------------------------------------------------------------------
+
+void ts::TSPacketView::copyFrom(const TSPacket* pkts, size_t count) const
+{
+    if (isDense()) {
+        ::memcpy(_base, pkts, count * PKT_SIZE);  // Flawfinder: ignore: memcpy()
+    }
+    else {
+        for (size_t i = 0; i < count; ++i) {
+            ::memcpy(_base + i * _stride, pkts + i, PKT_SIZE);  // Flawfinder: ignore: memcpy()
+        }
+    }
+}
+
+void ts::TSPacketView::copyTo(TSPacket* pkts, size_t count) const
+{
+    if (isDense()) {
+        ::memcpy(pkts, _base, count * PKT_SIZE);  // Flawfinder: ignore: memcpy()
+    }
+    else {
+        for (size_t i = 0; i < count; ++i) {
+            ::memcpy(pkts + i, _base + i * _stride, PKT_SIZE);  // Flawfinder: ignore: memcpy()
+        }
+    }
+}
@@ -0,0 +1,177 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  View on an array of TS packets with a possibly padded stride.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsTSPacket.h"
+
+namespace ts {
+    //!
+    //! View on an array of TS packets with a possibly padded stride.
+    //!
+    //! In a dense array of ts::TSPacket, the packets are 188 bytes apart and most
+    //! of them start at arbitrary alignments and straddle cache lines. In an array
+    //! with a padded stride, typically 192 or 256 bytes, all packets are aligned on
+    //! cache lines when the array itself is aligned. This is more efficient for
+    //! processing which uses vector instructions on packets.
+    //!
+    //! A TSPacketView behaves like a pointer to a packet inside such an array. It does
+    //! not own the packets. Dense arrays of packets are still used in I/O operations.
+    //! The methods copyFrom() and copyTo() convert between the two layouts.
+    //!
+    class TSDUCKDLL TSPacketView
+    {
+    public:
+        //!
+        //! Alignment of the packets in arrays with a padded stride, the size of a cache line.
+        //!
+        static const size_t ALIGNMENT = 64;
+
+        //!
+        //! Constructor from a dense array of packets.
+        //! @param [in] pkts Address of the first packet of the array.
+        //!
+        TSPacketView(TSPacket* pkts = 0) :
+            _base(reinterpret_cast<uint8_t*>(pkts)),
+            _stride(PKT_SIZE)
+        {
+        }
+
+        //!
+        //! Constructor from an array of packets with any stride.
+        //! @param [in] base Address of the first packet of the array.
+        //! @param [in] stride Distance in bytes between two packets in the array.
+        //! Must be PKT_SIZE or larger.
+        //!
+        TSPacketView(void* base, size_t stride) :
+            _base(reinterpret_cast<uint8_t*>(base)),
+            _stride(std::max(stride, PKT_SIZE))
+        {
+        }
+
+        //!
+        //! Get the distance in bytes between two packets in the array.
+        //! @return The distance in bytes between two packets.
+        //!
+        size_t stride() const
+        {
+            return _stride;
+        }
+
+        //!
+        //! Check if the packets are contiguous, as in an array of ts::TSPacket.
+        //! @return True if the stride is PKT_SIZE.
+        //!
+        bool isDense() const
+        {
+            return _stride == PKT_SIZE;
+        }
+
+        //!
+        //! Get the address of the first packet, as an array of ts::TSPacket.
+        //! @return The address of the first packet. The next packets
+        //! are at the corresponding index only if isDense() is true.
+        //!
+        TSPacket* get() const
+        {
+            return reinterpret_cast<TSPacket*>(_base);
+        }
+
+        //!
+        //! Access a packet in the array.
+        //! @param [in] index Index of the packet, relative to this view.
+        //! @return A reference to the packet.
+        //!
+        TSPacket& operator[](size_t index) const
+        {
+            return *reinterpret_cast<TSPacket*>(_base + index * _stride);
+        }
+
+        //!
+        //! Access the first packet of the view.
+        //! @return A reference to the first packet.
+        //!
+        TSPacket& operator*() const
+        {
+            return *get();
+        }
+
+        //!
+        //! Access the first packet of the view.
+        //! @return The address of the first packet.
+        //!
+        TSPacket* operator->() const
+        {
+            return get();
+        }
+
+        //!
+        //! Get a view which starts a number of packets later in the same array.
+        //! @param [in] count Number of packets to skip.
+        //! @return A view which starts @a count packets after this one.
+        //!
+        TSPacketView operator+(size_t count) const
+        {
+            return TSPacketView(_base + count * _stride, _stride);
+        }
+
+        //!
+        //! Move this view a number of packets later in the same array.
+        //! @param [in] count Number of packets to skip.
+        //! @return A reference to this object.
+        //!
+        TSPacketView& operator+=(size_t count)
+        {
+            _base += count * _stride;
+            return *this;
+        }
+
+        //!
+        //! Copy packets from a dense array into the packets of this view.
+        //! @param [in] pkts Address of a dense array of packets.
+        //! @param [in] count Number of packets to copy.
+        //!
+        void copyFrom(const TSPacket* pkts, size_t count) const;
+
+        //!
+        //! Copy the packets of this view into a dense array.
+        //! @param [out] pkts Address of a dense array of packets.
+        //! @param [in] count Number of packets to copy.
+        //!
+        void copyTo(TSPacket* pkts, size_t count) const;
+
+    private:
+        uint8_t* _base;    // Address of the first packet.
+        size_t   _stride;  // Distance in bytes between two packets.
+    };
+}
@@ -35,6 +35,7 @@
 #include "tsTablesFactory.h"
 #include "tsNames.h"
 #include "tsIntegerUtils.h"
+#include "tsSysUtils.h"
 TSDUCK_SOURCE;
 
 
@@ -45,9 +46,20 @@ TSDUCK_SOURCE;
 ts::TablesDisplay::TablesDisplay(const TablesDisplayArgs& options, Report& report) :
     _opt(options),
     _report(report),
-    _outfile(),
-    _use_outfile(false)
+    _out(BlockOutputStream::DEFAULT_BLOCK_SIZE, report)
 {
+    adjustBlockSize();
+}
+
+
+//----------------------------------------------------------------------------
+// Adjust the block size of the output, depending on the output type.
+//----------------------------------------------------------------------------
+
+void ts::TablesDisplay::adjustBlockSize()
+{
+    // On a terminal, each line is displayed immediately.
+    _out.setBlockSize(!_out.isFile() && StdOutIsTerminal() ? 0 : BlockOutputStream::DEFAULT_BLOCK_SIZE);
 }
 
 
@@ -79,7 +91,7 @@ ts::PDS ts::TablesDisplay::actualPDS(PDS pds) const
 
 std::ostream& ts::TablesDisplay::out()
 {
-    return _use_outfile ? _outfile : std::cout;
+    return _out;
 }
 
 
@@ -89,12 +101,12 @@ std::ostream& ts::TablesDisplay::out()
 
 void ts::TablesDisplay::flush()
 {
-    // Flush the output.
-    out().flush();
+    // Flush the output, including all pending text.
+    _out.flushBuffer();
 
     // On Windows, we must force the lower-level standard output.
 #if !defined(TS_WINDOWS)
-    if (!_use_outfile) {
+    if (!_out.isFile()) {
         ::fflush(stdout);
         ::fsync(STDOUT_FILENO);
     }
@@ -108,25 +120,18 @@ void ts::TablesDisplay::flush()
 
 bool ts::TablesDisplay::redirect(const UString& file_name)
 {
-    // Close previous file, if any.
-    if (_use_outfile) {
-        _outfile.close();
-        _use_outfile = false;
-    }
+    // Close previous file, if any, and reset to standard output.
+    _out.close();
 
     // Open new file if any.
+    bool ok = true;
     if (!file_name.empty()) {
         _report.verbose(u"creating " + file_name);
-        const std::string nameUTF8(file_name.toUTF8());
-        _outfile.open(nameUTF8.c_str(), std::ios::out);
-        if (!_outfile) {
-            _report.error(u"cannot create " + file_name);
-            return false;
-        }
-        _use_outfile = true;
+        ok = _out.setFile(file_name);
     }
 
-    return true;
+    adjustBlockSize();
+    return ok;
 }
 
 
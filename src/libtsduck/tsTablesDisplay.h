@@ -38,6 +38,7 @@
 #include "tsSection.h"
 #include "tsDescriptor.h"
 #include "tsDescriptorList.h"
+#include "tsBlockOutputStream.h"
 
 namespace ts {
     //!
@@ -216,6 +217,8 @@ namespace ts {
 
         //!
         //! Get the current output stream.
+        //! The text is written to the actual output in large blocks, except when
+        //! the output is a terminal. Use flush() to write all pending text.
         //! @return A reference to the output stream.
         //!
         std::ostream& out();
@@ -303,8 +306,10 @@ namespace ts {
     private:
         const TablesDisplayArgs& _opt;
         Report&                  _report;
-        std::ofstream            _outfile;
-        bool                     _use_outfile;
+        BlockOutputStream        _out;
+
+        // Adjust the block size of the output, depending on the output type.
+        void adjustBlockSize();
 
         // Inaccessible operations.
         TablesDisplay() = delete;
@@ -37,18 +37,36 @@ TSDUCK_SOURCE;
 TS_DEFINE_SINGLETON(ts::TablesFactory);
 
 
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::TablesFactory::STD_DID_MAX;
+#endif
+
+
 //----------------------------------------------------------------------------
 // Constructor.
 //----------------------------------------------------------------------------
 
 ts::TablesFactory::TablesFactory() :
-    _tableIds(),
     _descriptorIds(),
     _tableNames(),
     _descriptorNames(),
-    _sectionDisplays(),
     _descriptorDisplays()
 {
+    // The arrays are filled by the registrations, first one wins, as with maps.
+    ::memset(_tableIds, 0, sizeof(_tableIds));
+    ::memset(_stdDescriptorIds, 0, sizeof(_stdDescriptorIds));
+    ::memset(_sectionDisplays, 0, sizeof(_sectionDisplays));
+    ::memset(_stdDescriptorDisplays, 0, sizeof(_stdDescriptorDisplays));
+}
+
+
+//----------------------------------------------------------------------------
+// Index of a standard descriptor in the arrays.
+//----------------------------------------------------------------------------
+
+size_t ts::TablesFactory::StandardIndex(const EDID& edid)
+{
+    return edid.did() < STD_DID_MAX && edid == EDID(edid.did()) ? edid.did() : STD_DID_MAX;
 }
 
 
@@ -58,19 +76,32 @@ ts::TablesFactory::TablesFactory() :
 
 ts::TablesFactory::Register::Register(TID id, TableFactory factory)
 {
-    TablesFactory::Instance()->_tableIds.insert(std::pair<TID,TableFactory>(id, factory));
+    TableFactory& entry(TablesFactory::Instance()->_tableIds[id]);
+    if (entry == 0) {
+        entry = factory;
+    }
 }
 
 ts::TablesFactory::Register::Register(TID minId, TID maxId, TableFactory factory)
 {
-    for (TID id = minId; id <= maxId; ++id) {
-        TablesFactory::Instance()->_tableIds.insert(std::pair<TID, TableFactory>(id, factory));
+    for (size_t id = minId; id <= maxId; ++id) {
+        TableFactory& entry(TablesFactory::Instance()->_tableIds[id]);
+        if (entry == 0) {
+            entry = factory;
+        }
     }
 }
 
 ts::TablesFactory::Register::Register(const EDID& id, DescriptorFactory factory)
 {
-    TablesFactory::Instance()->_descriptorIds.insert(std::pair<EDID,DescriptorFactory>(id, factory));
+    TablesFactory* const fact = TablesFactory::Instance();
+    const size_t index = StandardIndex(id);
+    if (index >= STD_DID_MAX) {
+        fact->_descriptorIds.insert(std::pair<EDID,DescriptorFactory>(id, factory));
+    }
+    else if (fact->_stdDescriptorIds[index] == 0) {
+        fact->_stdDescriptorIds[index] = factory;
+    }
 }
 
 ts::TablesFactory::Register::Register(const UString& node_name, TableFactory factory)
@@ -85,19 +116,32 @@ ts::TablesFactory::Register::Register(const UString& node_name, DescriptorFactor
 
 ts::TablesFactory::Register::Register(TID id, DisplaySectionFunction func)
 {
-    TablesFactory::Instance()->_sectionDisplays.insert(std::pair<TID,DisplaySectionFunction>(id, func));
+    DisplaySectionFunction& entry(TablesFactory::Instance()->_sectionDisplays[id]);
+    if (entry == 0) {
+        entry = func;
+    }
 }
 
 ts::TablesFactory::Register::Register(TID minId, TID maxId, DisplaySectionFunction func)
 {
-    for (TID id = minId; id <= maxId; ++id) {
-        TablesFactory::Instance()->_sectionDisplays.insert(std::pair<TID, DisplaySectionFunction>(id, func));
+    for (size_t id = minId; id <= maxId; ++id) {
+        DisplaySectionFunction& entry(TablesFactory::Instance()->_sectionDisplays[id]);
+        if (entry == 0) {
+            entry = func;
+        }
     }
 }
 
 ts::TablesFactory::Register::Register(const EDID& edid, DisplayDescriptorFunction func)
 {
-    TablesFactory::Instance()->_descriptorDisplays.insert(std::pair<EDID,DisplayDescriptorFunction>(edid, func));
+    TablesFactory* const fact = TablesFactory::Instance();
+    const size_t index = StandardIndex(edid);
+    if (index >= STD_DID_MAX) {
+        fact->_descriptorDisplays.insert(std::pair<EDID,DisplayDescriptorFunction>(edid, func));
+    }
+    else if (fact->_stdDescriptorDisplays[index] == 0) {
+        fact->_stdDescriptorDisplays[index] = func;
+    }
 }
 
 
@@ -107,12 +151,15 @@ ts::TablesFactory::Register::Register(const EDID& edid, DisplayDescriptorFunctio
 
 ts::TablesFactory::TableFactory ts::TablesFactory::getTableFactory(TID id) const
 {
-    std::map<TID,TableFactory>::const_iterator it = _tableIds.find(id);
-    return it != _tableIds.end() ? it->second : 0;
+    return _tableIds[id];
 }
 
 ts::TablesFactory::DescriptorFactory ts::TablesFactory::getDescriptorFactory(const EDID& id) const
 {
+    const size_t index = StandardIndex(id);
+    if (index < STD_DID_MAX) {
+        return _stdDescriptorIds[index];
+    }
     std::map<EDID, DescriptorFactory>::const_iterator it = _descriptorIds.find(id);
     return it != _descriptorIds.end() ? it->second : 0;
 }
@@ -131,12 +178,15 @@ ts::TablesFactory::DescriptorFactory ts::TablesFactory::getDescriptorFactory(con
 
 ts::TablesFactory::DisplaySectionFunction ts::TablesFactory::getSectionDisplay(TID id) const
 {
-    std::map<TID,DisplaySectionFunction>::const_iterator it = _sectionDisplays.find(id);
-    return it != _sectionDisplays.end() ? it->second : 0;
+    return _sectionDisplays[id];
 }
 
 ts::TablesFactory::DisplayDescriptorFunction ts::TablesFactory::getDescriptorDisplay(const EDID& edid) const
 {
+    const size_t index = StandardIndex(edid);
+    if (index < STD_DID_MAX) {
+        return _stdDescriptorDisplays[index];
+    }
     std::map<EDID,DisplayDescriptorFunction>::const_iterator it = _descriptorDisplays.find(edid);
     return it != _descriptorDisplays.end() ? it->second : 0;
 }
@@ -144,8 +194,10 @@ ts::TablesFactory::DisplayDescriptorFunction ts::TablesFactory::getDescriptorDis
 void ts::TablesFactory::getRegisteredTableIds(std::vector<TID>& ids) const
 {
     ids.clear();
-    for (std::map<TID,TableFactory>::const_iterator it = _tableIds.begin(); it != _tableIds.end(); ++it) {
-        ids.push_back(it->first);
+    for (size_t id = 0; id < TID_MAX; ++id) {
+        if (_tableIds[id] != 0) {
+            ids.push_back(TID(id));
+        }
     }
 }
 
@@ -155,6 +207,12 @@ void ts::TablesFactory::getRegisteredDescriptorIds(std::vector<EDID>& ids) const
     for (std::map<EDID,DescriptorFactory>::const_iterator it = _descriptorIds.begin(); it != _descriptorIds.end(); ++it) {
         ids.push_back(it->first);
     }
+    for (size_t did = 0; did < STD_DID_MAX; ++did) {
+        if (_stdDescriptorIds[did] != 0) {
+            ids.push_back(EDID(DID(did)));
+        }
+    }
+    std::sort(ids.begin(), ids.end());
 }
 
 void ts::TablesFactory::getRegisteredTableNames(UStringList& names) const
@@ -249,11 +249,20 @@ namespace ts {
         };
 
     private:
-        std::map<TID, TableFactory>               _tableIds;
+        // Table ids and standard descriptor ids (neither private nor extension descriptors)
+        // are directly indexed in arrays. Other descriptors are found in maps.
+        static const size_t STD_DID_MAX = DID_EXTENSION;
+
+        // Get the index of a standard descriptor in the arrays, STD_DID_MAX if not a standard one.
+        static size_t StandardIndex(const EDID& edid);
+
+        TableFactory                              _tableIds[TID_MAX];
+        DescriptorFactory                         _stdDescriptorIds[STD_DID_MAX];
         std::map<EDID, DescriptorFactory>         _descriptorIds;
         std::map<UString, TableFactory>           _tableNames;
         std::map<UString, DescriptorFactory>      _descriptorNames;
-        std::map<TID, DisplaySectionFunction>     _sectionDisplays;
+        DisplaySectionFunction                    _sectionDisplays[TID_MAX];
+        DisplayDescriptorFunction                 _stdDescriptorDisplays[STD_DID_MAX];
         std::map<EDID, DisplayDescriptorFunction> _descriptorDisplays;
     };
 }
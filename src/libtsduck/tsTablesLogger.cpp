@@ -36,10 +36,15 @@
 #include "tstlv.h"
 #include "tsTime.h"
 #include "tsSimulCryptDate.h"
+#include "tsSectionFile.h"
 #include "tsxmlComment.h"
 #include "tsxmlElement.h"
 TSDUCK_SOURCE;
 
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::TablesLogger::MAX_QUEUED;
+#endif
+
 
 //----------------------------------------------------------------------------
 // Constructor
@@ -60,9 +65,13 @@ ts::TablesLogger::TablesLogger(const TablesLoggerArgs& opt, TablesDisplay& displ
     _xmlOut(report),
     _xmlDoc(report),
     _xmlOpen(false),
+    _jsonOut(BlockOutputStream::DEFAULT_BLOCK_SIZE, report),
+    _json(),
     _binfile(),
     _sock(false, report),
-    _shortSections()
+    _shortSections(opt.no_duplicate ? PID_MAX : 0),
+    _outputs(),
+    _text_count(0)
 {
     // Set either a table or section handler, depending on --all-sections
     if (_opt.all_sections) {
@@ -71,6 +80,28 @@ ts::TablesLogger::TablesLogger(const TablesLoggerArgs& opt, TablesDisplay& displ
     else {
         _demux.setTableHandler(this);
     }
+    _demux.setChangeOnly(_opt.change_only);
+    _demux.setCRCValidation(_opt.ignore_crc32 ? CRC32::IGNORE : CRC32::CHECK);
+
+    // Push the TID and TIDext filters down to the demux, unwanted sections are then
+    // skipped without reassembly. With --add-pmt-pids, the PAT is always needed.
+    SectionDemux::HeaderFilter filter;
+    if (!_opt.tid.empty()) {
+        if (!_opt.negate_tid) {
+            filter.tids.reset();
+        }
+        for (std::set<uint8_t>::const_iterator it = _opt.tid.begin(); it != _opt.tid.end(); ++it) {
+            filter.tids.set(*it, !_opt.negate_tid);
+        }
+        if (_opt.add_pmt_pids) {
+            filter.tids.set(TID_PAT);
+        }
+    }
+    if (!_opt.add_pmt_pids) {
+        filter.tid_exts = _opt.tidext;
+        filter.negate_tid_ext = _opt.negate_tidext;
+    }
+    _demux.setHeaderFilter(filter);
 
     // Open/create the text output.
     if (_opt.use_text && !_display.redirect(_opt.text_destination)) {
@@ -92,6 +123,15 @@ ts::TablesLogger::TablesLogger(const TablesLoggerArgs& opt, TablesDisplay& displ
         _xmlDoc.initialize(u"tsduck");
     }
 
+    // Open/create the JSON output.
+    if (_opt.use_json && !_opt.json_destination.empty()) {
+        _report.verbose(u"creating %s", {_opt.json_destination});
+        if (!_jsonOut.setFile(_opt.json_destination)) {
+            _abort = true;
+            return;
+        }
+    }
+
     // Open/create the binary output.
     if (_opt.use_binary) {
         if (!_opt.multi_files) {
@@ -116,23 +156,113 @@ ts::TablesLogger::TablesLogger(const TablesLoggerArgs& opt, TablesDisplay& displ
             (_opt.udp_ttl > 0 && !_sock.setTTL(_opt.udp_ttl, _report));
         if (_abort) {
             _sock.close();
+            return;
         }
     }
+
+    // Start one asynchronous thread per output.
+    if (_opt.use_text) {
+        startOutput(&TablesLogger::logText);
+    }
+    if (_opt.use_xml && !_opt.all_sections) {
+        startOutput(&TablesLogger::logXML);
+    }
+    if (_opt.use_json || (_opt.use_udp && _opt.udp_json)) {
+        startOutput(&TablesLogger::logJSON);
+    }
+    if (_opt.use_binary) {
+        startOutput(&TablesLogger::logBinary);
+    }
+    if (_opt.use_udp && !_opt.udp_json) {
+        startOutput(&TablesLogger::logUDP);
+    }
 }
 
 
 //----------------------------------------------------------------------------
-// Destructor
+// Asynchronous outputs.
 //----------------------------------------------------------------------------
 
-ts::TablesLogger::~TablesLogger()
+ts::TablesLogger::Output::Output(TablesLogger* logger, LogMethod method) :
+    Thread(),
+    queue(MAX_QUEUED),
+    _logger(logger),
+    _method(method)
 {
+}
+
+ts::TablesLogger::Output::~Output()
+{
+    waitForTermination();
+}
+
+void ts::TablesLogger::Output::main()
+{
+    LogMessagePtr msg;
+    while (queue.dequeue(msg) && !msg.isNull()) {
+        (_logger->*_method)(*msg);
+        // Release the message in this thread, not in the next dequeue.
+        msg.clear();
+    }
+}
+
+void ts::TablesLogger::startOutput(LogMethod method)
+{
+    OutputPtr out(new Output(this, method));
+    if (out->start()) {
+        _outputs.push_back(out);
+    }
+    else {
+        _report.error(u"cannot start output thread");
+        _abort = true;
+    }
+}
+
+void ts::TablesLogger::logMessage(const LogMessagePtr& msg)
+{
+    for (size_t i = 0; i < _outputs.size(); ++i) {
+        _outputs[i]->queue.enqueue(msg);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Wait for all outputs to complete and close them.
+//----------------------------------------------------------------------------
+
+void ts::TablesLogger::close()
+{
+    // Terminate all output threads, after their last queued message.
+    for (size_t i = 0; i < _outputs.size(); ++i) {
+        _outputs[i]->queue.forceEnqueue(LogMessagePtr());
+    }
+    for (size_t i = 0; i < _outputs.size(); ++i) {
+        _outputs[i]->waitForTermination();
+    }
+    _outputs.clear();
+
     // Close the XML document if needed.
     if (_xmlOpen) {
         _xmlDoc.printClose(_xmlOut);
         _xmlOpen = false;
     }
 
+    // Close the binary file and build its index if required.
+    if (_opt.use_binary && _opt.bin_index && !_opt.multi_files && _binfile.is_open()) {
+        _binfile.close();
+        SectionFile::BuildIndex(_opt.bin_destination, _report);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Destructor
+//----------------------------------------------------------------------------
+
+ts::TablesLogger::~TablesLogger()
+{
+    close();
+
     // Other files and sockets are automatically closed by their destructors.
 }
 
@@ -193,80 +323,10 @@ void ts::TablesLogger::handleTable(SectionDemux&, const BinaryTable& table)
         }
     }
 
-    // Filtering done, now save data.
-    if (_opt.use_text) {
-        preDisplay(table.getFirstTSPacketIndex(), table.getLastTSPacketIndex());
-        if (_opt.logger) {
-            // Short log message
-            logSection(*table.sectionAt(0));
-        }
-        else {
-            // Full table formatting
-            _display.displayTable(table, 0, _cas_mapper.casFamily(pid)) << std::endl;
-        }
-        postDisplay();
-    }
-
-    if (_opt.use_xml) {
-        // Convert the table into an XML structure.
-        xml::Element* elem = table.toXML(_xmlDoc.rootElement(), false, _display.dvbCharset());
-        if (elem != 0) {
-            // Add an XML comment as first child of the table.
-            UString comment(UString::Format(u" PID 0x%X (%d)", {pid, pid}));
-            if (_opt.time_stamp) {
-                comment += u", at " + UString(Time::CurrentLocalTime());
-            }
-            if (_opt.packet_index) {
-                comment += UString::Format(u", first TS packet: %'d, last: %'d", {table.getFirstTSPacketIndex(), table.getLastTSPacketIndex()});
-            }
-            new xml::Comment(elem, comment + u" ", false); // first position
-
-            // Print the new table.
-            if (_xmlOpen) {
-                _xmlOut << ts::margin;
-                elem->print(_xmlOut, false);
-                _xmlOut << std::endl;
-            }
-            else {
-                // If this is the first table, print the document header with it.
-                _xmlOpen = true;
-                _xmlDoc.print(_xmlOut, true);
-            }
-
-            // Now remove the table from the document. Keeping them would eat up memory for no use.
-            // Deallocating the element forces the removal from the document through the destructor.
-            delete elem;
-        }
-    }
-
-    if (_opt.use_binary) {
-        // Save each section in binary format
-        for (size_t i = 0; i < table.sectionCount(); ++i) {
-            saveSection(*table.sectionAt(i));
-        }
-    }
-
-    if (_opt.use_udp) {
-        ByteBlock bb;
-        // Minimize allocation by reserving over size
-        bb.reserve(table.totalSize() + 32 + 4 * table.sectionCount());
-        if (_opt.udp_raw) {
-            // Add raw content of each section the message
-            for (size_t i = 0; i < table.sectionCount(); ++i) {
-                const Section& sect(*table.sectionAt(i));
-                bb.append(sect.content(), sect.size());
-            }
-        }
-        else {
-            // Build a TLV message. Each section is a separate PRM_SECTION parameter.
-            startMessage(bb, tlv::MSG_LOG_TABLE, pid);
-            for (size_t i = 0; i < table.sectionCount(); ++i) {
-                addSection(bb, *table.sectionAt(i));
-            }
-        }
-        // Send TLV message over UDP
-        _sock.send(bb.data(), bb.size(), _report);
-    }
+    // Filtering done, pass a private copy of the table to the outputs.
+    LogMessagePtr msg(new LogMessage(_cas_mapper.casFamily(pid)));
+    msg->table.copy(table);
+    logMessage(msg);
 
     // Check max table count
     _table_count++;
@@ -293,49 +353,176 @@ void ts::TablesLogger::handleSection(SectionDemux&, const Section& sect)
         return;
     }
 
-    // Filtering done, now save data.
+    // Filtering done, pass a private copy of the section to the outputs.
     // Note that no XML can be produced since valid XML structures contain complete tables only.
+    LogMessagePtr msg(new LogMessage(_cas_mapper.casFamily(sect.sourcePID())));
+    msg->section.copy(sect);
+    logMessage(msg);
 
-    if (_opt.use_text) {
-        preDisplay(sect.getFirstTSPacketIndex(), sect.getLastTSPacketIndex());
+    // Check max table count (actually count sections with --all-sections)
+    _table_count++;
+    if (_opt.max_tables > 0 && _table_count >= _opt.max_tables) {
+        _exit = true;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Text output, invoked in the output thread.
+//----------------------------------------------------------------------------
+
+void ts::TablesLogger::logText(const LogMessage& msg)
+{
+    if (msg.table.isValid()) {
+        preDisplay(msg.table.getFirstTSPacketIndex(), msg.table.getLastTSPacketIndex(), msg.time);
         if (_opt.logger) {
             // Short log message
-            logSection(sect);
+            logSection(*msg.table.sectionAt(0), msg.time, msg.cas);
+        }
+        else {
+            // Full table formatting
+            _display.displayTable(msg.table, 0, msg.cas) << std::endl;
+        }
+    }
+    else {
+        preDisplay(msg.section.getFirstTSPacketIndex(), msg.section.getLastTSPacketIndex(), msg.time);
+        if (_opt.logger) {
+            // Short log message
+            logSection(msg.section, msg.time, msg.cas);
         }
         else {
             // Full section formatting.
-            _display.displaySection(sect, 0, _cas_mapper.casFamily(sect.sourcePID())) << std::endl;
+            _display.displaySection(msg.section, 0, msg.cas) << std::endl;
         }
-        postDisplay();
     }
+    postDisplay();
+    _text_count++;
+}
 
-    if (_opt.use_udp) {
-        // Save section in binary format
-        saveSection(sect);
+
+//----------------------------------------------------------------------------
+// XML output, invoked in the output thread. Complete tables only.
+//----------------------------------------------------------------------------
+
+void ts::TablesLogger::logXML(const LogMessage& msg)
+{
+    // Convert the table into an XML structure.
+    const BinaryTable& table(msg.table);
+    xml::Element* elem = table.toXML(_xmlDoc.rootElement(), false, _display.dvbCharset());
+    if (elem != 0) {
+        // Add an XML comment as first child of the table.
+        const PID pid = table.sourcePID();
+        UString comment(UString::Format(u" PID 0x%X (%d)", {pid, pid}));
+        if (_opt.time_stamp) {
+            comment += u", at " + UString(msg.time);
+        }
+        if (_opt.packet_index) {
+            comment += UString::Format(u", first TS packet: %'d, last: %'d", {table.getFirstTSPacketIndex(), table.getLastTSPacketIndex()});
+        }
+        new xml::Comment(elem, comment + u" ", false); // first position
+
+        // Print the new table.
+        if (_xmlOpen) {
+            _xmlOut << ts::margin;
+            elem->print(_xmlOut, false);
+            _xmlOut << std::endl;
+        }
+        else {
+            // If this is the first table, print the document header with it.
+            _xmlOpen = true;
+            _xmlDoc.print(_xmlOut, true);
+        }
+
+        // Now remove the table from the document. Keeping them would eat up memory for no use.
+        // Deallocating the element forces the removal from the document through the destructor.
+        delete elem;
     }
+}
 
-    if (_opt.use_udp) {
+
+//----------------------------------------------------------------------------
+// JSON output (file and UDP), invoked in the output thread.
+//----------------------------------------------------------------------------
+
+void ts::TablesLogger::logJSON(const LogMessage& msg)
+{
+    // Format the table or section as one compact JSON object.
+    if (msg.table.isValid()) {
+        startJSON(msg.table.getFirstTSPacketIndex(), msg.table.getLastTSPacketIndex(), msg.time);
+        msg.table.toJSON(_json, msg.cas);
+    }
+    else {
+        startJSON(msg.section.getFirstTSPacketIndex(), msg.section.getLastTSPacketIndex(), msg.time);
+        msg.section.toJSON(_json, msg.cas);
+    }
+    endJSON();
+}
+
+
+//----------------------------------------------------------------------------
+// Binary output, invoked in the output thread.
+//----------------------------------------------------------------------------
+
+void ts::TablesLogger::logBinary(const LogMessage& msg)
+{
+    if (msg.table.isValid()) {
+        // Save each section in binary format
+        for (size_t i = 0; i < msg.table.sectionCount(); ++i) {
+            saveSection(*msg.table.sectionAt(i));
+        }
+    }
+    else {
+        saveSection(msg.section);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// UDP output (raw sections or TLV messages), invoked in the output thread.
+//----------------------------------------------------------------------------
+
+void ts::TablesLogger::logUDP(const LogMessage& msg)
+{
+    const BinaryTable& table(msg.table);
+    ByteBlock bb;
+
+    if (!table.isValid()) {
+        // One single section.
+        const Section& sect(msg.section);
         if (_opt.udp_raw) {
             // Send raw content of section as one single UDP message
             _sock.send(sect.content(), sect.size(), _report);
         }
         else {
-            ByteBlock bb;
             // Minimize allocation by reserving over size
             bb.reserve(sect.size() + 32);
             // Build a TLV message with one PRM_SECTION parameter.
-            startMessage(bb, tlv::MSG_LOG_SECTION, sect.sourcePID());
+            startMessage(bb, tlv::MSG_LOG_SECTION, sect.sourcePID(), msg.time);
             addSection(bb, sect);
             // Send TLV message over UDP
             _sock.send(bb.data(), bb.size(), _report);
         }
+        return;
     }
 
-    // Check max table count (actually count sections with --all-sections)
-    _table_count++;
-    if (_opt.max_tables > 0 && _table_count >= _opt.max_tables) {
-        _exit = true;
+    // Minimize allocation by reserving over size
+    bb.reserve(table.totalSize() + 32 + 4 * table.sectionCount());
+    if (_opt.udp_raw) {
+        // Add raw content of each section the message
+        for (size_t i = 0; i < table.sectionCount(); ++i) {
+            const Section& sect(*table.sectionAt(i));
+            bb.append(sect.content(), sect.size());
+        }
     }
+    else {
+        // Build a TLV message. Each section is a separate PRM_SECTION parameter.
+        startMessage(bb, tlv::MSG_LOG_TABLE, table.sourcePID(), msg.time);
+        for (size_t i = 0; i < table.sectionCount(); ++i) {
+            addSection(bb, *table.sectionAt(i));
+        }
+    }
+    // Send TLV message over UDP
+    _sock.send(bb.data(), bb.size(), _report);
 }
 
 
@@ -376,17 +563,61 @@ void ts::TablesLogger::saveSection(const Section& sect)
 }
 
 
+//----------------------------------------------------------------------------
+//  Start the JSON object of a table or section.
+//----------------------------------------------------------------------------
+
+void ts::TablesLogger::startJSON(PacketCounter first, PacketCounter last, const Time& time)
+{
+    // The JSON buffer is reused from one table to another.
+    _json.clear();
+    _json.beginObject();
+    if (_opt.time_stamp) {
+        _json.field(u"time", UString(time));
+    }
+    if (_opt.packet_index) {
+        _json.field(u"first_packet", first);
+        _json.field(u"last_packet", last);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+//  Complete the JSON object of a table or section and send it.
+//----------------------------------------------------------------------------
+
+void ts::TablesLogger::endJSON()
+{
+    _json.endObject();
+    const std::string& text(_json.text());
+
+    // One JSON object per line in the JSON output.
+    if (_opt.use_json) {
+        _jsonOut.write(text.data(), std::streamsize(text.size()));
+        _jsonOut << std::endl;
+        if (_opt.flush) {
+            _jsonOut.flushBuffer();
+        }
+    }
+
+    // One JSON object per UDP message.
+    if (_opt.use_udp && _opt.udp_json) {
+        _sock.send(text.data(), text.size(), _report);
+    }
+}
+
+
 //----------------------------------------------------------------------------
 //  Log a table (option --log)
 //----------------------------------------------------------------------------
 
-void ts::TablesLogger::logSection(const Section& sect)
+void ts::TablesLogger::logSection(const Section& sect, const Time& time, CASFamily cas)
 {
     UString header;
 
     // Display time stamp if required.
     if (_opt.time_stamp) {
-        header += UString(Time::CurrentLocalTime());
+        header += UString(time);
         header += u": ";
     }
 
@@ -403,7 +634,7 @@ void ts::TablesLogger::logSection(const Section& sect)
     header += u": ";
 
     // Output the line through the display object.
-    _display.logSectionData(sect, header, _opt.log_size, _cas_mapper.casFamily(sect.sourcePID()));
+    _display.logSectionData(sect, header, _opt.log_size, cas);
 }
 
 
@@ -430,12 +661,12 @@ bool ts::TablesLogger::isFiltered(const Section& sect, CASFamily cas) const
 //  Display header information, before a table
 //----------------------------------------------------------------------------
 
-void ts::TablesLogger::preDisplay(PacketCounter first, PacketCounter last)
+void ts::TablesLogger::preDisplay(PacketCounter first, PacketCounter last, const Time& time)
 {
     std::ostream& strm(_display.out());
 
     // Initial spacing
-    if (_table_count == 0 && !_opt.logger) {
+    if (_text_count == 0 && !_opt.logger) {
         strm << std::endl;
     }
 
@@ -443,7 +674,7 @@ void ts::TablesLogger::preDisplay(PacketCounter first, PacketCounter last)
     if ((_opt.time_stamp || _opt.packet_index) && !_opt.logger) {
         strm << "* ";
         if (_opt.time_stamp) {
-            strm << "At " << Time::CurrentLocalTime();
+            strm << "At " << time;
         }
         if (_opt.packet_index && _opt.time_stamp) {
             strm << ", ";
@@ -473,7 +704,7 @@ void ts::TablesLogger::postDisplay()
 //  Build header of a TLV message
 //----------------------------------------------------------------------------
 
-void ts::TablesLogger::startMessage(ByteBlock& bb, uint16_t message_type, PID pid)
+void ts::TablesLogger::startMessage(ByteBlock& bb, uint16_t message_type, PID pid, const Time& time)
 {
     bb.clear();
     // Protocol version
@@ -486,7 +717,7 @@ void ts::TablesLogger::startMessage(ByteBlock& bb, uint16_t message_type, PID pi
     bb.appendUInt16(2);
     bb.appendUInt16(pid);
     // Timestamp parameter
-    SimulCryptDate now(Time::CurrentLocalTime());
+    SimulCryptDate now(time);
     bb.appendUInt16(tlv::PRM_TIMESTAMP);
     bb.appendUInt16(SimulCryptDate::SIZE);
     now.putBinary(bb.enlarge(SimulCryptDate::SIZE));
@@ -42,11 +42,20 @@
 #include "tsUDPSocket.h"
 #include "tsCASMapper.h"
 #include "tsxmlDocument.h"
+#include "tsjsonWriter.h"
+#include "tsBlockOutputStream.h"
+#include "tsMessageQueue.h"
+#include "tsThread.h"
+#include "tsTime.h"
 
 namespace ts {
     //!
     //! This class logs sections and tables.
     //!
+    //! Each output (text, XML, JSON, binary, UDP) runs in its own thread with a bounded
+    //! queue of tables or sections. A slow output does not block the demux of the input
+    //! packets, unless its queue is full.
+    //!
     class TSDUCKDLL TablesLogger :
         protected TableHandlerInterface,
         protected SectionHandlerInterface
@@ -65,6 +74,18 @@ namespace ts {
         //!
         virtual ~TablesLogger();
 
+        //!
+        //! Maximum number of tables or sections which are queued for each output.
+        //!
+        static const size_t MAX_QUEUED = 256;
+
+        //!
+        //! Wait for all outputs to complete and close them.
+        //! This method is automatically invoked by the destructor. It must be called
+        //! explicitly before checking the final status with hasErrors().
+        //!
+        void close();
+
         //!
         //! The following method feeds the logger with a TS packet.
         //! @param [in] pkt A new transport stream packet.
@@ -102,9 +123,12 @@ namespace ts {
 
         //!
         //! Log a section (option @c --log).
+        //! This method is invoked in the thread of the text output.
         //! @param [in] section The section to log.
+        //! @param [in] time Reception time of the section.
+        //! @param [in] cas The CAS family for this section.
         //!
-        virtual void logSection(const Section& section);
+        virtual void logSection(const Section& section, const Time& time, CASFamily cas);
 
         //!
         //! Check if a specific section must be filtered and displayed.
@@ -116,10 +140,40 @@ namespace ts {
         virtual bool isFiltered(const Section& section, CASFamily cas) const;
 
     private:
+        // A table or section to log. With --all-sections, the table is empty.
+        // The data are copied from the demux and read-only for the outputs.
+        class LogMessage
+        {
+        public:
+            BinaryTable table;    // Table to log.
+            Section     section;  // Section to log with --all-sections.
+            CASFamily   cas;      // CAS family of the PID.
+            Time        time;     // Reception time.
+            LogMessage(CASFamily cas_) : table(), section(), cas(cas_), time(Time::CurrentLocalTime()) {}
+        };
+        typedef MessageQueue<LogMessage, Mutex> LogQueue;
+        typedef LogQueue::MessagePtr LogMessagePtr;
+
+        // An asynchronous output: a thread which logs the messages from its queue.
+        // A null message terminates the thread.
+        typedef void (TablesLogger::*LogMethod)(const LogMessage&);
+        class Output : public Thread
+        {
+        public:
+            Output(TablesLogger* logger, LogMethod method);
+            virtual ~Output();
+            LogQueue queue;
+        private:
+            TablesLogger* _logger;
+            LogMethod     _method;
+            virtual void main() override;
+        };
+        typedef SafePtr<Output, NullMutex> OutputPtr;
+
         const TablesLoggerArgs&  _opt;
         TablesDisplay&           _display;
         Report&                  _report;
-        bool                     _abort;
+        volatile bool            _abort;
         bool                     _exit;
         uint32_t                 _table_count;
         PacketCounter            _packet_count;
@@ -128,19 +182,40 @@ namespace ts {
         TextFormatter            _xmlOut;          // XML output formatter.
         xml::Document            _xmlDoc;          // XML root document.
         bool                     _xmlOpen;         // The XML root element is open.
+        BlockOutputStream        _jsonOut;         // JSON output stream.
+        json::Writer             _json;            // JSON text of current table or section.
         std::ofstream            _binfile;         // Binary output file.
         UDPSocket                _sock;            // Output socket.
-        std::map<PID,SectionPtr> _shortSections;   // Tracking duplicate short sections by PID.
+        std::vector<SectionPtr>  _shortSections;   // Tracking duplicate short sections, indexed by PID.
+        std::vector<OutputPtr>   _outputs;         // Asynchronous outputs.
+        uint32_t                 _text_count;      // Number of displayed tables, in text output thread.
+
+        // Start an asynchronous output.
+        void startOutput(LogMethod method);
+
+        // Pass a table or section to all outputs.
+        void logMessage(const LogMessagePtr&);
+
+        // Log a table or section in each output, invoked in the output threads.
+        void logText(const LogMessage&);
+        void logXML(const LogMessage&);
+        void logJSON(const LogMessage&);
+        void logBinary(const LogMessage&);
+        void logUDP(const LogMessage&);
 
         // Save a section in a binary file
         void saveSection(const Section&);
 
         // Pre/post-display of a table or section
-        void preDisplay(PacketCounter first, PacketCounter last);
+        void preDisplay(PacketCounter first, PacketCounter last, const Time& time);
         void postDisplay();
 
+        // Start and complete the JSON object of a table or section.
+        void startJSON(PacketCounter first, PacketCounter last, const Time& time);
+        void endJSON();
+
         // Build header of a TLV message
-        void startMessage(ByteBlock&, uint16_t message_type, PID pid);
+        void startMessage(ByteBlock&, uint16_t message_type, PID pid, const Time& time);
 
         // Add a section into a TLV message
         void addSection(ByteBlock&, const Section&);
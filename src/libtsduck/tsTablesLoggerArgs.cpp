@@ -47,17 +47,21 @@ const size_t ts::TablesLoggerArgs::DEFAULT_LOG_SIZE;
 ts::TablesLoggerArgs::TablesLoggerArgs() :
     use_text(false),
     use_xml(false),
+    use_json(false),
     use_binary(false),
     use_udp(false),
     text_destination(),
     xml_destination(),
+    json_destination(),
     bin_destination(),
     udp_destination(),
     multi_files(false),
+    bin_index(false),
     flush(false),
     udp_local(),
     udp_ttl(0),
     udp_raw(false),
+    udp_json(false),
     all_sections(false),
     max_tables(0),
     time_stamp(false),
@@ -70,6 +74,8 @@ ts::TablesLoggerArgs::TablesLoggerArgs() :
     pid(),
     add_pmt_pids(false),
     no_duplicate(false),
+    change_only(false),
+    ignore_crc32(false),
     tid(),
     tidext()
 {
@@ -103,6 +109,13 @@ void ts::TablesLoggerArgs::addHelp(Args& args) const
         u"      Save sections in the specified binary output file.\n"
         u"      See also option -m, --multiple-files.\n"
         u"\n"
+        u"  --change-only\n"
+        u"      Ignore all repetitions of a section which is identical to the previous\n"
+        u"      occurrence of the same section (same PID, table id, table id extension,\n"
+        u"      section number and CRC32). Identical sections are dropped before being\n"
+        u"      analyzed. By default, all sections are reported with --all-sections and\n"
+        u"      all tables with a short section are reported.\n"
+        u"\n"
         u"  -d\n"
         u"  --diversified-payload\n"
         u"      Select only sections with \"diversified\" payload. This means that\n"
@@ -117,6 +130,17 @@ void ts::TablesLoggerArgs::addHelp(Args& args) const
         u"  --help\n"
         u"      Display this help text.\n"
         u"\n"
+        u"  --ignore-crc32\n"
+        u"      Do not check the CRC32 of input sections. This can be used to analyze\n"
+        u"      sections with incorrect CRC32 or to save CPU time on trusted streams.\n"
+        u"\n"
+        u"  --index-binary\n"
+        u"      With --binary-output, create an index file for the binary output file.\n"
+        u"      The name of the index file is the name of the binary file with an\n"
+        u"      additional '.idx' suffix. The index file is used by tstabdump --select\n"
+        u"      to quickly extract selected tables from large binary files. Ignored\n"
+        u"      with --multiple-files.\n"
+        u"\n"
         u"  -i address:port\n"
         u"  --ip-udp address:port\n"
         u"      Send binary tables over UDP/IP to the specified destination.\n"
@@ -129,6 +153,21 @@ void ts::TablesLoggerArgs::addHelp(Args& args) const
         u"      the IP address of the outgoing local interface. It can be also a host\n"
         u"      name that translates to a local address.\n"
         u"\n"
+        u"  --json-output filename\n"
+        u"      Save the tables or sections in compact JSON format in the specified file.\n"
+        u"      Each table (or section with --all-sections) is written as one single-line\n"
+        u"      JSON object, containing the PID, the table id and name, the table id\n"
+        u"      extension and version for long sections and the binary content of all\n"
+        u"      sections in hexadecimal. With --time-stamp and --packet-index, the fields\n"
+        u"      \"time\", \"first_packet\" and \"last_packet\" are added. To output the\n"
+        u"      JSON text on the standard output, explicitly specify this option with \"-\"\n"
+        u"      as output file name.\n"
+        u"\n"
+        u"  --json-udp\n"
+        u"      With --ip-udp, send the tables or sections as compact JSON objects, one\n"
+        u"      per UDP message, using the same format as --json-output. By default, the\n"
+        u"      tables are formatted into TLV messages.\n"
+        u"\n"
         u"  --log\n"
         u"      Short one-line log of each table instead of full table display.\n"
         u"\n"
@@ -249,9 +288,14 @@ void ts::TablesLoggerArgs::defineOptions(Args& args) const
 {
     args.option(u"all-sections",        'a');
     args.option(u"binary-output",       'b', Args::STRING);
+    args.option(u"change-only",          0);
     args.option(u"diversified-payload", 'd');
     args.option(u"flush",               'f');
+    args.option(u"ignore-crc32",         0);
+    args.option(u"index-binary",         0);
     args.option(u"ip-udp",              'i', Args::STRING);
+    args.option(u"json-output",          0,  Args::STRING);
+    args.option(u"json-udp",             0);
     args.option(u"local-udp",            0,  Args::STRING);
     args.option(u"log",                  0);
     args.option(u"log-size",             0,  Args::UNSIGNED);
@@ -284,9 +328,10 @@ void ts::TablesLoggerArgs::load(Args& args)
 {
     // Type of output, text is the default.
     use_xml = args.present(u"xml-output");
+    use_json = args.present(u"json-output");
     use_binary = args.present(u"binary-output");
     use_udp = args.present(u"ip-udp");
-    use_text = args.present(u"output-file") || args.present(u"text-output") || ( !use_xml && !use_binary && !use_udp);
+    use_text = args.present(u"output-file") || args.present(u"text-output") || (!use_xml && !use_json && !use_binary && !use_udp);
 
     // --output-file and --text-output are synonyms.
     if (args.present(u"output-file") && args.present(u"text-output")) {
@@ -295,6 +340,7 @@ void ts::TablesLoggerArgs::load(Args& args)
 
     // Output destinations.
     xml_destination = args.value(u"xml-output");
+    json_destination = args.value(u"json-output");
     bin_destination = args.value(u"binary-output");
     udp_destination = args.value(u"ip-udp");
     text_destination = args.value(u"output-file", args.value(u"text-output").c_str());
@@ -306,8 +352,12 @@ void ts::TablesLoggerArgs::load(Args& args)
     if (xml_destination == u"-") {
         xml_destination.clear();
     }
+    if (json_destination == u"-") {
+        json_destination.clear();
+    }
 
     multi_files = args.present(u"multiple-files");
+    bin_index = args.present(u"index-binary");
     flush = args.present(u"flush");
     udp_local = args.value(u"local-udp");
     udp_ttl = args.intValue(u"ttl", 0);
@@ -321,7 +371,10 @@ void ts::TablesLoggerArgs::load(Args& args)
     negate_tid = args.present(u"negate-tid");
     negate_tidext = args.present(u"negate-tid-ext");
     no_duplicate = args.present(u"no-duplicate");
+    change_only = args.present(u"change-only");
+    ignore_crc32 = args.present(u"ignore-crc32");
     udp_raw = args.present(u"no-encapsulation");
+    udp_json = args.present(u"json-udp");
     add_pmt_pids = args.present(u"psi-si");
 
     if (add_pmt_pids || args.present(u"pid")) {
@@ -342,4 +395,8 @@ void ts::TablesLoggerArgs::load(Args& args)
 
     args.getIntValues(tid, u"tid");
     args.getIntValues(tidext, u"tid-ext");
+
+    if (udp_raw && udp_json) {
+        args.error(u"--no-encapsulation and --json-udp are mutually exclusive");
+    }
 }
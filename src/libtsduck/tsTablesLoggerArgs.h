@@ -56,17 +56,21 @@ namespace ts {
         // Public fields, by options.
         bool     use_text;          //!< Produce formatted human-readable tables.
         bool     use_xml;           //!< Produce XML tables.
+        bool     use_json;          //!< Produce compact JSON tables.
         bool     use_binary;        //!< Save binary sections.
         bool     use_udp;           //!< Send sections using UDP/IP.
         UString  text_destination;  //!< Text output file name.
         UString  xml_destination;   //!< XML output file name.
+        UString  json_destination;  //!< JSON output file name.
         UString  bin_destination;   //!< Binary output file name.
         UString  udp_destination;   //!< UDP/IP destination address:port.
         bool     multi_files;       //!< Multiple binary output files (one per section).
+        bool     bin_index;         //!< Build an index file for the binary output file.
         bool     flush;             //!< Flush output file.
         UString  udp_local;         //!< Name of outgoing local address (empty if unspecified).
         int      udp_ttl;           //!< Time-to-live socket option.
         bool     udp_raw;           //!< UDP messages contain raw sections, not structured messages.
+        bool     udp_json;          //!< UDP messages contain compact JSON objects, not structured messages.
         bool     all_sections;      //!< Collect all sections, as they appear.
         uint32_t max_tables;        //!< Max number of tables to dump.
         bool     time_stamp;        //!< Display time stamps with each table.
@@ -79,6 +83,8 @@ namespace ts {
         PIDSet   pid;               //!< PID values to filter.
         bool     add_pmt_pids;      //!< Add PMT PID's when one is found.
         bool     no_duplicate;      //!< Exclude duplicated short sections on a PID.
+        bool     change_only;       //!< Ignore identical section repetitions in the demux.
+        bool     ignore_crc32;      //!< Do not check CRC32 of input sections.
         std::set<uint8_t>  tid;     //!< TID values to filter.
         std::set<uint16_t> tidext;  //!< TID-ext values to filter.
 
@@ -262,9 +262,13 @@ void ts::TeletextDemux::handlePESPacket(const PESPacket& packet)
         plSize -= 2;
         pl += 2;
 
+        // Stop on truncated data unit.
+        if (unitSize > plSize) {
+            break;
+        }
+
         // Filter Teletext packets.
-        if (unitSize <= plSize &&
-            unitSize == TELETEXT_PACKET_SIZE &&
+        if (unitSize == TELETEXT_PACKET_SIZE &&
             (unitId == TELETEXT_DATA_UNIT_ID_NON_SUBTITLE || unitId == TELETEXT_DATA_UNIT_ID_SUBTITLE))
         {
             // Reverse bitwise endianess of each data byte via lookup table, ETS 300 706, chapter 7.1.
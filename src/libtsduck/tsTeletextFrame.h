@@ -63,7 +63,7 @@ namespace ts {
         //! Get the text lines. May contain embedded HTML tags.
         //! @return The text lines.
         //!
-        UStringList lines() const
+        const UStringList& lines() const
         {
             return _lines;
         }
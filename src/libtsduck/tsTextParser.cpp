@@ -38,7 +38,9 @@ TSDUCK_SOURCE;
 ts::TextParser::TextParser(Report& report) :
     _report(report),
     _lines(),
-    _pos(_lines)
+    _pos(_lines),
+    _file(),
+    _input(0)
 {
 }
 
@@ -69,6 +71,10 @@ ts::TextParser::Position::Position(const UStringList& textLines) :
 
 void ts::TextParser::clear()
 {
+    _input = 0;
+    if (_file.is_open()) {
+        _file.close();
+    }
     _lines.clear();
     _pos = Position(_lines);
 }
@@ -80,18 +86,21 @@ void ts::TextParser::clear()
 
 void ts::TextParser::loadDocument(const UStringList& lines)
 {
-    _lines.clear();
+    clear();
     _pos = Position(lines);
 }
 
 void ts::TextParser::loadDocument(const UString& text)
 {
+    clear();
     text.toSubstituted(u"\r", UString()).split(_lines, u'\n', false);
     _pos = Position(_lines);
 }
 
 bool ts::TextParser::loadFile(const UString& fileName)
 {
+    clear();
+
     // Load the file into the internal lines buffer.
     const bool ok = UString::Load(_lines, fileName);
     if (!ok) {
@@ -105,6 +114,8 @@ bool ts::TextParser::loadFile(const UString& fileName)
 
 bool ts::TextParser::loadStream(std::istream& strm)
 {
+    clear();
+
     // Load the file into the internal lines buffer.
     const bool ok = UString::Load(_lines, strm);
     if (!ok) {
@@ -117,6 +128,65 @@ bool ts::TextParser::loadStream(std::istream& strm)
 }
 
 
+//----------------------------------------------------------------------------
+// Read the document to parse progressively.
+//----------------------------------------------------------------------------
+
+bool ts::TextParser::openFile(const UString& fileName)
+{
+    clear();
+    _file.open(fileName.toUTF8().c_str());
+    if (!_file) {
+        _report.error(u"error reading file %s", {fileName});
+        return false;
+    }
+    return openStream(_file);
+}
+
+bool ts::TextParser::openStream(std::istream& strm)
+{
+    if (&strm != &_file) {
+        clear();
+    }
+
+    // Read the first line, the next ones are read on demand.
+    _input = &strm;
+    const bool ok = readLine() || strm.eof();
+    _pos = Position(_lines);
+    return ok;
+}
+
+bool ts::TextParser::readLine()
+{
+    if (_input == 0) {
+        return false;
+    }
+    UString line;
+    if (line.getLine(*_input)) {
+        _lines.push_back(line);
+        return true;
+    }
+
+    // End of input, the document is complete.
+    if (!_input->eof()) {
+        _report.error(u"error reading input document");
+    }
+    _input = 0;
+    if (_file.is_open()) {
+        _file.close();
+    }
+    return false;
+}
+
+void ts::TextParser::discardConsumedLines()
+{
+    // Lines can be discarded in the internal list only.
+    if (_pos._lines == &_lines) {
+        _lines.erase(_lines.begin(), _pos._curLine);
+    }
+}
+
+
 //----------------------------------------------------------------------------
 // Save the document to parse to a text file.
 //----------------------------------------------------------------------------
@@ -166,7 +236,23 @@ bool ts::TextParser::eol() const
 
 void ts::TextParser::rewind()
 {
-    _pos = Position(_lines);
+    _pos = Position(*_pos._lines);
+}
+
+
+//----------------------------------------------------------------------------
+// Move to the beginning of the next line.
+//----------------------------------------------------------------------------
+
+void ts::TextParser::nextLine()
+{
+    // When the document is read progressively, get the next line before moving to it.
+    if (_input != 0 && std::next(_pos._curLine) == _pos._lines->end()) {
+        readLine();
+    }
+    _pos._curLine++;
+    _pos._curLineNumber++;
+    _pos._curIndex = 0;
 }
 
 
@@ -186,9 +272,7 @@ bool ts::TextParser::skipWhiteSpace()
             return true;
         }
         // Move to next line.
-        _pos._curLine++;
-        _pos._curLineNumber++;
-        _pos._curIndex = 0;
+        nextLine();
     }
     return true;
 }
@@ -201,9 +285,7 @@ bool ts::TextParser::skipWhiteSpace()
 bool ts::TextParser::skipLine()
 {
     while (_pos._curLine != _pos._lines->end()) {
-        _pos._curLine++;
-        _pos._curLineNumber++;
-        _pos._curIndex = 0;
+        nextLine();
     }
     return true;
 }
@@ -465,9 +547,7 @@ bool ts::TextParser::parseText(UString& result, const UString endToken, bool ski
             // End token not found, include the complete end of line.
             result.append(*_pos._curLine, _pos._curIndex);
             result.append(LINE_FEED);
-            _pos._curLine++;
-            _pos._curLineNumber++;
-            _pos._curIndex = 0;
+            nextLine();
         }
         else {
             // Found end token, stop here.
@@ -101,6 +101,34 @@ namespace ts {
         //!
         bool loadStream(std::istream& strm);
 
+        //!
+        //! Open a text file and read the document to parse progressively.
+        //! Lines are read from the file only when the parser reaches them.
+        //! Use discardConsumedLines() to free the lines which are already parsed.
+        //! @param [in] fileName Name of the file to open.
+        //! @return True on success, false on failure.
+        //!
+        bool openFile(const UString& fileName);
+
+        //!
+        //! Read the document to parse progressively from a text stream.
+        //! Lines are read from the stream only when the parser reaches them.
+        //! Use discardConsumedLines() to free the lines which are already parsed.
+        //! @param [in,out] strm A standard text stream in input mode. The lifetime of
+        //! the stream must equals or exceeds the parsing of the document.
+        //! @return True on success, false on error.
+        //!
+        bool openStream(std::istream& strm);
+
+        //!
+        //! Free all lines before the current line in the document.
+        //! This is useful with large documents which are read progressively, when the
+        //! application knows that it will no longer return to a previous position.
+        //! All previously saved positions become invalid. This is a no-op when the
+        //! document is an external list of lines.
+        //!
+        void discardConsumedLines();
+
         //!
         //! Save the document to parse to a text file.
         //! @param [in] fileName Name of the file to save.
@@ -129,6 +157,7 @@ namespace ts {
 
         //!
         //! Rewind to start of document.
+        //! When the document is read progressively, rewind to the first line which was not discarded.
         //!
         void rewind();
 
@@ -269,9 +298,17 @@ namespace ts {
         virtual bool parseJSONStringLiteral(UString& str);
 
     private:
-        Report&     _report;
-        UStringList _lines;
-        Position    _pos;
+        Report&       _report;
+        UStringList   _lines;
+        Position      _pos;
+        std::ifstream _file;   // Input file when the document is read progressively.
+        std::istream* _input;  // Input stream when the document is read progressively, null otherwise.
+
+        // Read the next line from the input stream, if any, at end of document.
+        bool readLine();
+
+        // Move to the beginning of the next line.
+        void nextLine();
 
         // Unaccessible operations.
         TextParser() = delete;
@@ -34,6 +34,10 @@
 #include "tsIntegerUtils.h"
 TSDUCK_SOURCE;
 
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::Thread::PREFAULT_MARGIN;
+#endif
+
 
 //----------------------------------------------------------------------------
 // Default constructor (all attributes have their default values).
@@ -157,6 +161,104 @@ bool ts::Thread::isCurrentThreadUnchecked() const
 }
 
 
+//----------------------------------------------------------------------------
+// System-specific representations of a set of CPU's.
+//----------------------------------------------------------------------------
+
+namespace {
+#if defined(TS_WINDOWS)
+    ::DWORD_PTR Win32AffinityMask(const ts::CPUSet& cpus)
+    {
+        ::DWORD_PTR mask = 0;
+        for (ts::CPUSet::const_iterator it = cpus.begin(); it != cpus.end(); ++it) {
+            if (*it < 8 * sizeof(mask)) {
+                mask |= ::DWORD_PTR(1) << *it;
+            }
+        }
+        return mask;
+    }
+#elif defined(TS_LINUX)
+    void LinuxCPUSet(::cpu_set_t& set, const ts::CPUSet& cpus)
+    {
+        CPU_ZERO(&set);
+        for (ts::CPUSet::const_iterator it = cpus.begin(); it != cpus.end(); ++it) {
+            if (*it < CPU_SETSIZE) {
+                CPU_SET(*it, &set);
+            }
+        }
+    }
+#endif
+}
+
+
+//----------------------------------------------------------------------------
+// Set the CPU affinity of the current thread.
+//----------------------------------------------------------------------------
+
+bool ts::Thread::SetCurrentThreadAffinity(const CPUSet& cpus, CPUSet* previous)
+{
+#if defined(TS_WINDOWS)
+    if (cpus.empty()) {
+        return true;
+    }
+    const ::DWORD_PTR mask = ::SetThreadAffinityMask(::GetCurrentThread(), Win32AffinityMask(cpus));
+    if (mask == 0) {
+        return false;
+    }
+    if (previous != 0) {
+        previous->clear();
+        for (size_t cpu = 0; cpu < 8 * sizeof(mask); ++cpu) {
+            if ((mask & (::DWORD_PTR(1) << cpu)) != 0) {
+                previous->insert(cpu);
+            }
+        }
+    }
+    return true;
+#elif defined(TS_LINUX)
+    if (cpus.empty()) {
+        return true;
+    }
+    ::cpu_set_t set;
+    if (previous != 0) {
+        if (::pthread_getaffinity_np(::pthread_self(), sizeof(set), &set) != 0) {
+            return false;
+        }
+        previous->clear();
+        for (size_t cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) {
+                previous->insert(cpu);
+            }
+        }
+    }
+    LinuxCPUSet(set, cpus);
+    return ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set) == 0;
+#else
+    // CPU affinity not supported on this system.
+    return cpus.empty();
+#endif
+}
+
+
+//----------------------------------------------------------------------------
+// Set the name of the current thread in the operating system.
+//----------------------------------------------------------------------------
+
+bool ts::Thread::SetCurrentThreadName(const UString& name)
+{
+#if defined(TS_LINUX)
+    // The kernel limits the name to 16 bytes, including the trailing nul.
+    std::string utf8(name.toUTF8());
+    utf8.resize(std::min<size_t>(utf8.size(), 15));
+    return ::pthread_setname_np(::pthread_self(), utf8.c_str()) == 0;
+#elif defined(TS_MAC)
+    return ::pthread_setname_np(name.toUTF8().c_str()) == 0;
+#else
+    // Thread names not supported on this system.
+    return false;
+#endif
+}
+
+
 //----------------------------------------------------------------------------
 // Start the thread.
 //----------------------------------------------------------------------------
@@ -180,13 +282,27 @@ bool ts::Thread::start()
         return false;
     }
 
-    // Set the thread priority
-    ::BOOL status = ::SetThreadPriority(_handle, ThreadAttributes::Win32Priority(_attributes._priority));
+    // Set the thread priority. There is no per-thread scheduling policy on Windows,
+    // real-time policies use the time-critical priority.
+    int priority = ThreadAttributes::Win32Priority(_attributes._priority);
+    if (_attributes._schedPolicy == ThreadAttributes::SCHEDULING_FIFO || _attributes._schedPolicy == ThreadAttributes::SCHEDULING_RR) {
+        priority = THREAD_PRIORITY_TIME_CRITICAL;
+    }
+    else if (_attributes._schedPolicy == ThreadAttributes::SCHEDULING_OTHER) {
+        priority = THREAD_PRIORITY_NORMAL;
+    }
+    ::BOOL status = ::SetThreadPriority(_handle, priority);
     if (status == 0) {
         ::CloseHandle(_handle);
         return false;
     }
 
+    // Set the CPU affinity
+    if (!_attributes._cpuAffinity.empty() && ::SetThreadAffinityMask(_handle, Win32AffinityMask(_attributes._cpuAffinity)) == 0) {
+        ::CloseHandle(_handle);
+        return false;
+    }
+
     // Release the thread
     if (::ResumeThread(_handle) == ::DWORD(-1)) {
         ::CloseHandle(_handle);
@@ -233,6 +349,17 @@ bool ts::Thread::start()
         ::pthread_attr_destroy(&attr);
         return false;
     }
+#if defined(TS_LINUX)
+    // Set CPU affinity.
+    if (!_attributes._cpuAffinity.empty()) {
+        ::cpu_set_t cpus;
+        LinuxCPUSet(cpus, _attributes._cpuAffinity);
+        if (::pthread_attr_setaffinity_np(&attr, sizeof(cpus), &cpus) != 0) {
+            ::pthread_attr_destroy(&attr);
+            return false;
+        }
+    }
+#endif
     // Create the thread
     if (::pthread_create(&_pthread, &attr, Thread::ThreadProc, this) != 0) {
         ::pthread_attr_destroy(&attr);
@@ -240,6 +367,15 @@ bool ts::Thread::start()
     }
     // Destroy thread attributes
     ::pthread_attr_destroy(&attr);
+    // Apply an explicit scheduling policy. Real-time policies require privileges.
+    // On failure, the thread keeps the default scheduling of the process.
+    int policy = 0;
+    if (ThreadAttributes::PthreadExplicitScheduling(_attributes._schedPolicy, _attributes._schedPriority, policy, sparam.sched_priority) &&
+        ::pthread_setschedparam(_pthread, policy, &sparam) != 0)
+    {
+        _attributes._schedPolicy = ThreadAttributes::SCHEDULING_DEFAULT;
+        _attributes._schedPriority = 0;
+    }
 
 #endif
 
@@ -304,6 +440,32 @@ bool ts::Thread::waitForTermination()
 }
 
 
+//----------------------------------------------------------------------------
+// Touch the stack of the current thread, if required by the attributes.
+//----------------------------------------------------------------------------
+
+namespace {
+    // Touch the stack downward by chunks, one stack frame per chunk. The write
+    // after the recursive call prevents the tail call optimization.
+    void TouchStack(size_t size)
+    {
+        volatile uint8_t chunk[2048];
+        chunk[0] = 0;
+        if (size > sizeof(chunk)) {
+            TouchStack(size - sizeof(chunk));
+        }
+        chunk[sizeof(chunk) - 1] = 0;
+    }
+}
+
+void ts::Thread::prefaultStack() const
+{
+    if (_attributes._prefaultStack && _attributes._stackSize > PREFAULT_MARGIN) {
+        TouchStack(_attributes._stackSize - PREFAULT_MARGIN);
+    }
+}
+
+
 //----------------------------------------------------------------------------
 // Static method. Actual starting point of threads. Parameter is "this".
 //----------------------------------------------------------------------------
@@ -314,6 +476,10 @@ bool ts::Thread::waitForTermination()
 {
     // Execute thread code.
     Thread* thread(reinterpret_cast<Thread*>(parameter));
+    if (!thread->_attributes._name.empty()) {
+        SetCurrentThreadName(thread->_attributes._name);
+    }
+    thread->prefaultStack();
     thread->main();
 
     // Perform auto-deallocation
@@ -332,6 +498,10 @@ void* ts::Thread::ThreadProc(void* parameter)
 {
     // Execute thread code.
     Thread* thread(reinterpret_cast<Thread*>(parameter));
+    if (!thread->_attributes._name.empty()) {
+        SetCurrentThreadName(thread->_attributes._name);
+    }
+    thread->prefaultStack();
     thread->main();
 
     // Perform auto-deallocation
@@ -196,6 +196,35 @@ namespace ts {
         //!
         static void Yield();
 
+        //!
+        //! Set the CPU affinity of the current thread.
+        //!
+        //! This is typically used to make sure that memory which is allocated and
+        //! first accessed by the current thread is located on the NUMA node of
+        //! the specified CPU's.
+        //!
+        //! @param [in] cpus Set of CPU indexes. If empty, do nothing.
+        //! @param [out] previous When not zero, receive the previous CPU affinity of
+        //! the current thread, to be restored later. Unchanged if @a cpus is empty.
+        //! @return True on success, false on error or if CPU affinity is not
+        //! supported on this system.
+        //! @see ThreadAttributes::setCPUAffinity()
+        //!
+        static bool SetCurrentThreadAffinity(const CPUSet& cpus, CPUSet* previous = 0);
+
+        //!
+        //! Set the name of the current thread in the operating system.
+        //!
+        //! This is automatically done when a thread is started with a name
+        //! in its attributes. This method is useful to name the main thread.
+        //!
+        //! @param [in] name Name of the thread. On Linux, it is truncated to 15 bytes.
+        //! @return True on success, false on error or if thread names are not
+        //! supported on this system.
+        //! @see ThreadAttributes::setName()
+        //!
+        static bool SetCurrentThreadName(const UString& name);
+
     private:
         // Forbidden operations
         Thread(const Thread&) = delete;
@@ -210,6 +239,13 @@ namespace ts {
         // Internal version of isCurrentThread(), bypass checks
         bool isCurrentThreadUnchecked() const;
 
+        // Stack size which is left untouched when prefaulting the stack,
+        // for the frames of the thread startup and the system data.
+        static const size_t PREFAULT_MARGIN = 16 * 1024;
+
+        // Touch the stack of the current thread, if required by the attributes.
+        void prefaultStack() const;
+
 #if defined(TS_WINDOWS)
         ::HANDLE _handle;
         ::DWORD _thread_id;
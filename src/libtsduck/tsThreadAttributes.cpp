@@ -111,6 +111,34 @@ int ts::ThreadAttributes::PthreadSchedulingPolicy()
     return ::sched_getscheduler(0);
 #endif
 }
+
+
+//----------------------------------------------------------------------------
+// This static method is used by the implementation of ts::Thread on Unix
+// to obtain the pthread policy and priority of an explicit scheduling policy.
+//----------------------------------------------------------------------------
+
+bool ts::ThreadAttributes::PthreadExplicitScheduling(SchedulingPolicy policy, int requested, int& pthread_policy, int& priority)
+{
+    switch (policy) {
+        case SCHEDULING_OTHER:
+            pthread_policy = SCHED_OTHER;
+            break;
+        case SCHEDULING_FIFO:
+            pthread_policy = SCHED_FIFO;
+            break;
+        case SCHEDULING_RR:
+            pthread_policy = SCHED_RR;
+            break;
+        case SCHEDULING_DEFAULT:
+        default:
+            return false;
+    }
+    const int prioMin = std::max(0, ::sched_get_priority_min(pthread_policy));
+    const int prioMax = std::max(prioMin, ::sched_get_priority_max(pthread_policy));
+    priority = requested == 0 ? (prioMin + prioMax) / 2 : std::max(prioMin, std::min(prioMax, requested));
+    return true;
+}
 #endif
 
 
@@ -152,7 +180,12 @@ int ts::ThreadAttributes::Win32Priority(int priority)
 ts::ThreadAttributes::ThreadAttributes() :
     _stackSize(0),
     _deleteWhenTerminated(false),
-    _priority(0)
+    _prefaultStack(false),
+    _priority(0),
+    _cpuAffinity(),
+    _name(),
+    _schedPolicy(SCHEDULING_DEFAULT),
+    _schedPriority(0)
 {
     if (!_priorityInitialized) {
         InitializePriorities();
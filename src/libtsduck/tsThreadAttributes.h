@@ -34,8 +34,13 @@
 
 #pragma once
 #include "tsPlatform.h"
+#include "tsUString.h"
 
 namespace ts {
+    //!
+    //! A set of CPU indexes, used to define the CPU affinity of a thread.
+    //!
+    typedef std::set<size_t> CPUSet;
 
     //!
     //! Set of attributes for a thread object (ts::Thread).
@@ -117,6 +122,89 @@ namespace ts {
             return _deleteWhenTerminated;
         }
 
+        //!
+        //! Set the CPU affinity for the thread.
+        //!
+        //! The thread will be allowed to run on the specified CPU's only.
+        //! CPU's are identified by their index, starting at zero, as seen by
+        //! the operating system. An empty set (the default) means that the
+        //! thread can run on any CPU.
+        //!
+        //! On Linux and Windows, the CPU affinity is applied when the thread is
+        //! started. On other systems, the CPU affinity is ignored. On Windows,
+        //! only the first 64 CPU's can be specified.
+        //!
+        //! @param [in] cpus Set of CPU indexes.
+        //! @return A reference to this object.
+        //!
+        ThreadAttributes& setCPUAffinity(const CPUSet& cpus)
+        {
+            _cpuAffinity = cpus;
+            return *this;
+        }
+
+        //!
+        //! Get the CPU affinity for the thread.
+        //! @return A constant reference to the set of CPU indexes.
+        //! An empty set means that the thread can run on any CPU.
+        //!
+        const CPUSet& getCPUAffinity() const
+        {
+            return _cpuAffinity;
+        }
+
+        //!
+        //! Set the name of the thread.
+        //!
+        //! The name is given to the operating system when the thread is started.
+        //! On Linux, it is truncated to 15 bytes and visible in tools such as
+        //! <code>top -H</code> or <code>ps -L</code>. It is also used by
+        //! ts::SystemMonitor to identify the threads. By default, a thread has
+        //! no specific name and inherits the name of the process.
+        //!
+        //! @param [in] name Name of the thread.
+        //! @return A reference to this object.
+        //!
+        ThreadAttributes& setName(const UString& name)
+        {
+            _name = name;
+            return *this;
+        }
+
+        //!
+        //! Get the name of the thread.
+        //! @return A constant reference to the name of the thread.
+        //!
+        const UString& getName() const
+        {
+            return _name;
+        }
+
+        //!
+        //! Set the <i>prefault stack flag</i> for the thread.
+        //! When this flag is set and a stack size is specified, the memory pages of the
+        //! stack are touched when the thread starts, before invoking ts::Thread::main().
+        //! This prevents page faults later in time-critical processing.
+        //! The default value for this flag is @c false.
+        //! @param [in] prefault Prefault stack flag for the thread.
+        //! @return A reference to this object.
+        //!
+        ThreadAttributes& setPrefaultStack(bool prefault)
+        {
+            _prefaultStack = prefault;
+            return *this;
+        }
+
+        //!
+        //! Get the <i>prefault stack flag</i> for the thread.
+        //! @return The prefault stack flag for the thread.
+        //! @see setPrefaultStack()
+        //!
+        bool getPrefaultStack() const
+        {
+            return _prefaultStack;
+        }
+
         //!
         //! Set the priority for the thread.
         //!
@@ -184,6 +272,66 @@ namespace ts {
             return _priority;
         }
 
+        //!
+        //! Scheduling policy of a thread.
+        //!
+        enum SchedulingPolicy {
+            SCHEDULING_DEFAULT,  //!< Same scheduling policy as the process, using the priority from setPriority().
+            SCHEDULING_OTHER,    //!< Standard time-sharing policy.
+            SCHEDULING_FIFO,     //!< Real-time policy, first in, first out.
+            SCHEDULING_RR,       //!< Real-time policy, round robin.
+        };
+
+        //!
+        //! Set an explicit scheduling policy for the thread.
+        //!
+        //! By default, a thread uses the scheduling policy of the process and the priority
+        //! from setPriority() is interpreted in the range of this policy. With an explicit
+        //! real-time policy, a time-critical thread (input, output, pacing) is no longer
+        //! preempted by the time-sharing threads of the system.
+        //!
+        //! On Linux and other UNIX systems, real-time policies require privileges (root or
+        //! @c CAP_SYS_NICE on Linux). The thread is always started. If the policy cannot be
+        //! applied, the thread keeps the default scheduling and its attributes, as returned by
+        //! ts::Thread::getAttributes(), are reset to @link SCHEDULING_DEFAULT @endlink.
+        //! On Windows, there is no per-thread scheduling policy and the real-time policies
+        //! simply use the time-critical thread priority.
+        //!
+        //! @param [in] policy The scheduling policy.
+        //! @param [in] priority The priority for the thread, in the range of the operating
+        //! system priorities for this policy (1 to 99 for real-time policies on Linux).
+        //! Out of range values are forced within the range. Zero means the middle of the range.
+        //! This priority is unrelated to the priority from setPriority() which is used
+        //! with @link SCHEDULING_DEFAULT @endlink only.
+        //! @return A reference to this object.
+        //!
+        ThreadAttributes& setSchedulingPolicy(SchedulingPolicy policy, int priority = 0)
+        {
+            _schedPolicy = policy;
+            _schedPriority = priority;
+            return *this;
+        }
+
+        //!
+        //! Get the explicit scheduling policy for the thread.
+        //! @return The scheduling policy for the thread.
+        //! @see setSchedulingPolicy()
+        //!
+        SchedulingPolicy getSchedulingPolicy() const
+        {
+            return _schedPolicy;
+        }
+
+        //!
+        //! Get the priority in the explicit scheduling policy for the thread.
+        //! @return The priority in the explicit scheduling policy, zero for the middle of the range.
+        //! @see setSchedulingPolicy()
+        //!
+        int getSchedulingPriority() const
+        {
+            return _schedPriority;
+        }
+
         //!
         //! Get the minimum priority for a thread in this context of the operating system.
         //! @return The minimum priority for a thread.
@@ -240,7 +388,12 @@ namespace ts {
     private:
         size_t _stackSize;
         bool _deleteWhenTerminated;
+        bool _prefaultStack;
         int _priority;
+        CPUSet _cpuAffinity;
+        UString _name;
+        SchedulingPolicy _schedPolicy;
+        int _schedPriority;
 
         //
         // These fields describe the operating system priority range.
@@ -283,6 +436,10 @@ namespace ts {
         // This static method is used by the implementation of ts::Thread on Unix
         // to obtain the scheduling policy to use for this process.
         static int PthreadSchedulingPolicy();
+
+        // Get the pthread scheduling policy and priority for an explicit scheduling policy.
+        // Return false if the policy is SCHEDULING_DEFAULT.
+        static bool PthreadExplicitScheduling(SchedulingPolicy policy, int requested, int& pthread_policy, int& priority);
 #endif
     };
 }
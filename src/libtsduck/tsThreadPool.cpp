@@ -0,0 +1,362 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "tsThreadPool.h"
+#include "tsGuard.h"
+#include "tsGuardCondition.h"
+#include <thread>
+TSDUCK_SOURCE;
+
+namespace {
+    // Pool and index of the worker which runs in the current thread, if any.
+    thread_local const ts::ThreadPool* current_pool = 0;
+    thread_local size_t current_index = 0;
+}
+
+
+//----------------------------------------------------------------------------
+// Constructor and destructor.
+//----------------------------------------------------------------------------
+
+ts::ThreadPool::ThreadPool(size_t threads, const ThreadAttributes& attributes) :
+    _workers(),
+    _pending(0),
+    _idle(0),
+    _next_queue(0),
+    _terminate(false),
+    _cancelled(false),
+    _mutex(),
+    _available()
+{
+    if (threads == 0) {
+        threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+
+    // The workers are deleted by the pool.
+    ThreadAttributes attr(attributes);
+    attr.setDeleteWhenTerminated(false);
+
+    // Create all workers before starting them, the workers access the queues of each other.
+    _workers.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        _workers.push_back(new Worker(*this, i, attr));
+    }
+    for (size_t i = 0; i < threads; ++i) {
+        _workers[i]->start();
+    }
+}
+
+ts::ThreadPool::~ThreadPool()
+{
+    terminate();
+}
+
+
+//----------------------------------------------------------------------------
+// Worker threads.
+//----------------------------------------------------------------------------
+
+ts::ThreadPool::Worker::Worker(ThreadPool& pool, size_t index, const ThreadAttributes& attributes) :
+    Thread(attributes),
+    mutex(),
+    queue(),
+    _pool(pool),
+    _index(index)
+{
+}
+
+ts::ThreadPool::Worker::~Worker()
+{
+    waitForTermination();
+}
+
+void ts::ThreadPool::Worker::main()
+{
+    _pool.run(_index);
+}
+
+void ts::ThreadPool::run(size_t index)
+{
+    current_pool = this;
+    current_index = index;
+
+    Task task;
+    while (nextTask(index, task, true)) {
+        task();
+        // Release the resources of the task before waiting for the next one.
+        task = nullptr;
+    }
+}
+
+bool ts::ThreadPool::inWorkerThread() const
+{
+    return current_pool == this;
+}
+
+
+//----------------------------------------------------------------------------
+// Push a task in a queue.
+//----------------------------------------------------------------------------
+
+bool ts::ThreadPool::push(const Task& task)
+{
+    if (_terminate || _cancelled || _workers.empty()) {
+        return false;
+    }
+
+    // Tasks from a worker go to its own queue, other tasks are distributed.
+    Worker* const worker = _workers[current_pool == this ? current_index : _next_queue++ % _workers.size()];
+    {
+        Guard lock(worker->mutex);
+        worker->queue.push_back(task);
+        _pending++;
+    }
+
+    // Wake up one idle worker, if any. A worker increments the idle count before
+    // checking the pending count. Both are sequentially consistent atomics.
+    if (_idle > 0) {
+        GuardCondition lock(_mutex, _available);
+        lock.signal();
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Get the next task to execute.
+//----------------------------------------------------------------------------
+
+bool ts::ThreadPool::nextTask(size_t index, Task& task, bool wait)
+{
+    const size_t count = _workers.size();
+
+    while (!_cancelled && count > 0) {
+
+        // First, get the most recent task in our own queue.
+        if (index < count) {
+            Worker* const worker = _workers[index];
+            Guard lock(worker->mutex);
+            if (!worker->queue.empty()) {
+                task.swap(worker->queue.back());
+                worker->queue.pop_back();
+                _pending--;
+                return true;
+            }
+        }
+
+        // Then, steal the oldest task of another worker.
+        for (size_t i = 1; i <= count; ++i) {
+            Worker* const worker = _workers[(index + i) % count];
+            Guard lock(worker->mutex);
+            if (!worker->queue.empty()) {
+                task.swap(worker->queue.front());
+                worker->queue.pop_front();
+                _pending--;
+                return true;
+            }
+        }
+
+        if (!wait) {
+            break;
+        }
+
+        // Wait for new tasks.
+        GuardCondition lock(_mutex, _available);
+        _idle++;
+        while (_pending == 0 && !_terminate && !_cancelled) {
+            lock.waitCondition();
+        }
+        _idle--;
+        if (_pending == 0 && _terminate) {
+            break;
+        }
+    }
+    return false;
+}
+
+
+//----------------------------------------------------------------------------
+// Cancel all pending tasks.
+//----------------------------------------------------------------------------
+
+void ts::ThreadPool::cancel()
+{
+    _cancelled = true;
+
+    // Drop all pending tasks. They are destroyed outside the locks since the
+    // destruction of a task may release resources of the application.
+    for (size_t i = 0; i < _workers.size(); ++i) {
+        std::deque<Task> dropped;
+        {
+            Guard lock(_workers[i]->mutex);
+            dropped.swap(_workers[i]->queue);
+            _pending -= dropped.size();
+        }
+    }
+
+    // Wake up all idle workers, they will terminate.
+    GuardCondition lock(_mutex, _available);
+    for (size_t i = 0; i < _workers.size(); ++i) {
+        lock.signal();
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Terminate the pool.
+//----------------------------------------------------------------------------
+
+void ts::ThreadPool::terminate()
+{
+    // Cannot wait for ourselves.
+    if (current_pool == this) {
+        return;
+    }
+
+    // Wake up all idle workers, they will terminate when no more task is pending.
+    {
+        GuardCondition lock(_mutex, _available);
+        _terminate = true;
+        for (size_t i = 0; i < _workers.size(); ++i) {
+            lock.signal();
+        }
+    }
+
+    // Wait for the termination of all workers before deleting them since a worker
+    // may steal tasks from the others. Tasks which were queued after the termination
+    // of the workers are abandoned.
+    for (size_t i = 0; i < _workers.size(); ++i) {
+        _workers[i]->waitForTermination();
+    }
+    for (size_t i = 0; i < _workers.size(); ++i) {
+        delete _workers[i];
+    }
+    _workers.clear();
+    _pending = 0;
+}
+
+
+//----------------------------------------------------------------------------
+// Execute a function on all indexes in a range, in parallel.
+//----------------------------------------------------------------------------
+
+namespace {
+    // State of a parallelFor() loop, shared between all its chunks.
+    struct LoopState
+    {
+        std::atomic<size_t> remaining;   // Number of chunks which are not yet executed or dropped.
+        std::atomic<size_t> completed;   // Number of chunks which were fully executed.
+        std::atomic<bool>   aborted;     // The loop is aborted.
+        std::exception_ptr  error;       // First exception in the loop body.
+        ts::Mutex           mutex;       // Protect error and done.
+        ts::Condition       done;        // Signaled when remaining becomes zero.
+
+        LoopState(size_t chunks) : remaining(chunks), completed(0), aborted(false), error(), mutex(), done() {}
+    };
+
+    // A token which is shared by all copies of a chunk task. When the task is
+    // destroyed, after execution or because it was dropped, the chunk is done.
+    struct ChunkToken
+    {
+        std::shared_ptr<LoopState> state;
+
+        ChunkToken(const std::shared_ptr<LoopState>& st) : state(st) {}
+        ~ChunkToken()
+        {
+            if (--state->remaining == 0) {
+                ts::GuardCondition lock(state->mutex, state->done);
+                lock.signal();
+            }
+        }
+    };
+}
+
+bool ts::ThreadPool::parallelFor(size_t first, size_t last, const std::function<void(size_t)>& body, size_t chunk, const AbortInterface* abort)
+{
+    if (first >= last) {
+        return true;
+    }
+
+    // Split the range in chunks.
+    if (chunk == 0) {
+        const size_t parts = 4 * std::max<size_t>(1, _workers.size());
+        chunk = std::max<size_t>(1, (last - first + parts - 1) / parts);
+    }
+    const size_t chunks = (last - first + chunk - 1) / chunk;
+    std::shared_ptr<LoopState> state(new LoopState(chunks));
+
+    // Queue all chunks. A rejected task is immediately destroyed, the chunk is done without execution.
+    for (size_t start = first; start < last; start += chunk) {
+        const size_t end = std::min(last, start + chunk);
+        std::shared_ptr<ChunkToken> token(new ChunkToken(state));
+        push([token, start, end, &body, abort]() {
+            LoopState& st(*token->state);
+            try {
+                for (size_t i = start; i < end && !st.aborted; ++i) {
+                    if (abort != 0 && abort->aborting()) {
+                        st.aborted = true;
+                    }
+                    else {
+                        body(i);
+                    }
+                }
+            }
+            catch (...) {
+                Guard lock(st.mutex);
+                if (!st.error) {
+                    st.error = std::current_exception();
+                }
+                st.aborted = true;
+            }
+            if (!st.aborted) {
+                st.completed++;
+            }
+        });
+    }
+
+    // Execute pending tasks while the loop is not completed.
+    const size_t index = current_pool == this ? current_index : _workers.size();
+    while (state->remaining > 0) {
+        Task task;
+        if (nextTask(index, task, false)) {
+            task();
+        }
+        else {
+            // Nothing to execute, wait for the chunks in progress.
+            GuardCondition lock(state->mutex, state->done);
+            if (state->remaining > 0) {
+                lock.waitCondition();
+            }
+        }
+    }
+
+    if (state->error) {
+        std::rethrow_exception(state->error);
+    }
+    return state->completed == chunks;
+}
@@ -0,0 +1,189 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//!
+//!  @file
+//!  Pool of worker threads executing tasks.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsThread.h"
+#include "tsThreadAttributes.h"
+#include "tsAbortInterface.h"
+#include "tsMutex.h"
+#include "tsCondition.h"
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <future>
+
+namespace ts {
+    //!
+    //! Pool of worker threads executing tasks.
+    //!
+    //! The pool starts a fixed number of worker threads with the same ts::ThreadAttributes
+    //! (priority, stack size, CPU affinity). Each worker has its own queue of tasks.
+    //! A worker executes its own tasks first, most recent first, and steals the oldest
+    //! tasks of the other workers when its queue is empty. Tasks which are submitted
+    //! from a worker thread are queued on the queue of this worker. Tasks which are
+    //! submitted from other threads are distributed over all queues.
+    //!
+    //! A task must not wait for the future of another task of the same pool since all
+    //! workers could be blocked this way. Nested parallelism shall use parallelFor()
+    //! where the calling thread executes pending tasks while waiting.
+    //!
+    //! On termination, all pending tasks are executed, unless cancel() was called.
+    //! The method cancel() can be called from any thread, including an InterruptHandler
+    //! when the user interrupts the application. The futures of cancelled tasks are
+    //! abandoned and throw @c std::future_error with code @c broken_promise.
+    //!
+    class TSDUCKDLL ThreadPool
+    {
+    public:
+        //!
+        //! Constructor. The worker threads are immediately started.
+        //! @param [in] threads Number of worker threads. If zero, use the number of CPU's in the system.
+        //! @param [in] attributes Attributes of all worker threads. The attribute "delete when terminated"
+        //! is ignored, the workers are deleted by the pool.
+        //!
+        ThreadPool(size_t threads = 0, const ThreadAttributes& attributes = ThreadAttributes());
+
+        //!
+        //! Destructor. Wait for the termination of all tasks.
+        //!
+        ~ThreadPool();
+
+        //!
+        //! Get the number of worker threads.
+        //! @return The number of worker threads.
+        //!
+        size_t threadCount() const { return _workers.size(); }
+
+        //!
+        //! Get the number of tasks which are queued and not yet started.
+        //! @return The number of pending tasks.
+        //!
+        size_t pendingTasks() const { return _pending; }
+
+        //!
+        //! Submit a task for execution.
+        //! @param [in] task A function or function object without parameter.
+        //! @return A future for the result of the task. If the pool is terminated,
+        //! the task is not executed and the future is abandoned.
+        //!
+        template <typename FUNC>
+        std::future<typename std::result_of<FUNC()>::type> submit(FUNC task)
+        {
+            typedef typename std::result_of<FUNC()>::type ResultType;
+            std::shared_ptr<std::packaged_task<ResultType()>> pt(new std::packaged_task<ResultType()>(task));
+            std::future<ResultType> result(pt->get_future());
+            push([pt]() { (*pt)(); });
+            return result;
+        }
+
+        //!
+        //! Execute a function on all indexes in a range, in parallel.
+        //!
+        //! The range is split in chunks which are executed as tasks of the pool.
+        //! The calling thread also executes tasks of the pool until all chunks
+        //! are completed. This method can be called from a task of the pool.
+        //!
+        //! @param [in] first First index in the range.
+        //! @param [in] last Index after the last one in the range.
+        //! @param [in] body Function which is called for each index.
+        //! @param [in] chunk Number of consecutive indexes per task. If zero, the range
+        //! is split in four chunks per worker thread.
+        //! @param [in] abort If not zero, the remaining indexes are skipped when
+        //! @a abort indicates that the application is aborting.
+        //! @return True if all indexes were processed, false if the loop was aborted
+        //! or cancelled.
+        //!
+        bool parallelFor(size_t first, size_t last, const std::function<void(size_t)>& body, size_t chunk = 0, const AbortInterface* abort = 0);
+
+        //!
+        //! Cancel all pending tasks.
+        //! The tasks which are currently executing are not interrupted.
+        //! New tasks are rejected. Can be called from any thread.
+        //!
+        void cancel();
+
+        //!
+        //! Terminate the pool.
+        //! Wait for the completion of all pending tasks (unless cancelled)
+        //! and the termination of all worker threads. Automatically performed
+        //! in the destructor. New tasks are rejected after termination.
+        //!
+        void terminate();
+
+        //!
+        //! Check if the current thread is a worker thread of this pool.
+        //! @return True if the current thread is a worker thread of this pool.
+        //!
+        bool inWorkerThread() const;
+
+    private:
+        typedef std::function<void()> Task;
+
+        // One worker thread with its queue of tasks.
+        class Worker: public Thread
+        {
+        public:
+            Worker(ThreadPool& pool, size_t index, const ThreadAttributes& attributes);
+            virtual ~Worker() override;
+            Mutex            mutex;   // Protect the queue.
+            std::deque<Task> queue;   // Queue of tasks, the owner uses the back, thieves use the front.
+        private:
+            ThreadPool& _pool;
+            size_t      _index;
+            virtual void main() override;
+        };
+
+        // Push a task in a queue. Return false if the pool is terminated or cancelled.
+        bool push(const Task& task);
+
+        // Get the next task to execute for a worker (or any index out of range for another thread).
+        // When wait is true, wait for a task until the pool is terminated.
+        bool nextTask(size_t index, Task& task, bool wait);
+
+        // Main code of a worker thread.
+        void run(size_t index);
+
+        std::vector<Worker*> _workers;     // Worker threads.
+        std::atomic<size_t>  _pending;     // Number of queued tasks.
+        std::atomic<size_t>  _idle;        // Number of workers waiting for a task.
+        std::atomic<size_t>  _next_queue;  // Next queue for tasks from other threads (round robin).
+        std::atomic<bool>    _terminate;   // Terminate the workers when no more task is pending.
+        std::atomic<bool>    _cancelled;   // Pending tasks are dropped, new tasks are rejected.
+        Mutex                _mutex;       // Protect the idle state of workers.
+        Condition            _available;   // Signaled when a task is queued or the pool terminates.
+
+        // Inaccessible operations.
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+    };
+}
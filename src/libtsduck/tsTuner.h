@@ -316,6 +316,28 @@ namespace ts {
             return _receive_timeout;
         }
 
+        //!
+        //! Set the PID's to receive, using hardware demux filters.
+        //! By default, all PID's are received (full transport stream). With a smaller
+        //! set of PID's, the other PID's are dropped by the adapter and never cross the
+        //! bus to the system. May be invoked before start() or during the reception.
+        //! During the reception, the filters of the demux are incrementally updated.
+        //! Currently, hardware PID filtering is implemented on Linux only.
+        //! @param [in] pids The PID's to receive. Must not be empty.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on error.
+        //!
+        bool setPIDFilter(const PIDSet& pids, Report& report);
+
+        //!
+        //! Get the PID's which are currently received.
+        //! @return A constant reference to the set of PID's to receive.
+        //!
+        const PIDSet& pidFilter() const
+        {
+            return _pid_filter;
+        }
+
 #if defined(TS_LINUX) || defined(DOXYGEN) // Linux-specific operations
 
         //!
@@ -348,6 +370,20 @@ namespace ts {
             _demux_bufsize = s;
         }
 
+        //!
+        //! Set the size in bytes of the user-space buffer for the DVR device (Linux-specific).
+        //! When non-zero, a dedicated thread reads the DVR device with large read operations
+        //! into a user-space ring buffer of that size and receive() gets the packets from this
+        //! buffer. Short delays in the application no longer overflow the DVR device buffer.
+        //! Must be set before start().
+        //! @param [in] s The user-space buffer size in bytes. Zero, the default, means no
+        //! dedicated thread, receive() reads the DVR device.
+        //!
+        void setUserBufferSize(size_t s)
+        {
+            _user_bufsize = s;
+        }
+
         //!
         //! Perform a tune operation (Linux-specific).
         //! @param [in,out] props DTV properties.
@@ -398,6 +434,7 @@ namespace ts {
         bool              _signal_timeout_silent;
         MilliSecond       _receive_timeout;
         DeliverySystemSet _delivery_systems;
+        PIDSet            _pid_filter;     // PID's to receive, AllPIDs for full TS
 
 #if defined(TS_LINUX) // Linux properties
 
@@ -408,12 +445,24 @@ namespace ts {
         int                 _demux_fd;         // Demux device file descriptor
         int                 _dvr_fd;           // DVR device file descriptor
         unsigned long       _demux_bufsize;    // Demux device buffer size
+        size_t              _user_bufsize;     // User-space DVR buffer size, zero if none
+        bool                _demux_running;    // The demux filter is started
         ::dvb_frontend_info _fe_info;          // Front-end characteristics
         MilliSecond         _signal_poll;
         int                 _rt_signal;        // Receive timeout signal number
         ::timer_t           _rt_timer;         // Receive timeout timer
         bool                _rt_timer_valid;   // Receive timeout timer was created
 
+        // Thread reading the DVR device into a user-space ring buffer.
+        class DVRReader;
+        DVRReader*          _dvr_reader;       // Active reader thread, if any
+
+        // Stop and delete the DVR reader thread, if any.
+        void stopReader(Report&);
+
+        // Install the PID filter on the demux and start it.
+        bool startDemuxFilter(Report&);
+
         // Get current tuning parameters for specific tuners, return system error code
         ErrorCode getCurrentTuningDVBS(TunerParametersDVBS&);
         ErrorCode getCurrentTuningDVBC(TunerParametersDVBC&);
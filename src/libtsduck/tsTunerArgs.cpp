@@ -50,6 +50,7 @@ ts::TunerArgs::TunerArgs(bool info_only, bool allow_short_options) :
     receive_timeout(0),
 #if defined(TS_LINUX)
     demux_buffer_size(Tuner::DEFAULT_DEMUX_BUFFER_SIZE),
+    user_buffer_size(0),
 #elif defined(TS_WINDOWS)
     demux_queue_size(Tuner::DEFAULT_SINK_QUEUE_SIZE),
 #endif
@@ -91,6 +92,7 @@ void ts::TunerArgs::reset()
     receive_timeout = 0;
 #if defined(TS_LINUX)
     demux_buffer_size = Tuner::DEFAULT_DEMUX_BUFFER_SIZE;
+    user_buffer_size = 0;
 #elif defined(TS_WINDOWS)
     demux_queue_size = Tuner::DEFAULT_SINK_QUEUE_SIZE;
 #endif
@@ -135,15 +137,7 @@ void ts::TunerArgs::load(Args& args)
         device_name = args.value(u"device-name");
     }
     else if (args.present(u"adapter")) {
-        const int adapter = args.intValue(u"adapter", 0);
-#if defined(TS_LINUX)
-        device_name = UString::Format(u"/dev/dvb/adapter%d", {adapter});
-#elif defined(TS_WINDOWS)
-        device_name = UString::Format(u":%d", {adapter});
-#else
-        // Does not mean anything, just for error messages.
-        device_name = UString::Format(u"DVB adapter %d", {adapter});
-#endif
+        device_name = AdapterDeviceName(args.intValue(u"adapter", 0));
     }
 
     // Tuning options.
@@ -155,6 +149,7 @@ void ts::TunerArgs::load(Args& args)
         receive_timeout = args.intValue<MilliSecond>(u"receive-timeout", 0);
 #if defined(TS_LINUX)
         demux_buffer_size = args.intValue<size_t>(u"demux-buffer-size", Tuner::DEFAULT_DEMUX_BUFFER_SIZE);
+        user_buffer_size = args.intValue<size_t>(u"user-buffer-size", 0);
 #elif defined(TS_WINDOWS)
         demux_queue_size = args.intValue<size_t>(u"demux-queue-size", Tuner::DEFAULT_SINK_QUEUE_SIZE);
 #endif
@@ -291,6 +286,7 @@ void ts::TunerArgs::defineOptions(Args& args) const
         args.option(u"signal-timeout", 0, Args::UNSIGNED);
 #if defined(TS_LINUX)
         args.option(u"demux-buffer-size", 0, Args::UNSIGNED);
+        args.option(u"user-buffer-size", 0, Args::UNSIGNED);
 #elif defined(TS_WINDOWS)
         args.option(u"demux-queue-size", 0, Args::UNSIGNED);
 #endif
@@ -383,6 +379,15 @@ void ts::TunerArgs::addHelp(Args& args) const
             u"      is detected after this timeout, the command aborts. To disable the\n"
             u"      timeout and wait indefinitely for the signal, specify zero. The default\n"
             u"      is " + UString::Decimal(Tuner::DEFAULT_SIGNAL_TIMEOUT / 1000) + u" seconds.\n"
+#if defined (TS_LINUX)
+            u"\n"
+            u"  --user-buffer-size value\n"
+            u"      Specify the size, in bytes, of a user-space buffer for the DVR device.\n"
+            u"      A dedicated thread reads the DVR device into this buffer, using large\n"
+            u"      read operations. Short slowdowns of the application no longer overflow\n"
+            u"      the DVR device. Overflow statistics are reported in verbose mode. By\n"
+            u"      default, there is no user-space buffer.\n"
+#endif
             u"\n"
             u"Tuning:\n"
             u"\n"
@@ -598,6 +603,7 @@ bool ts::TunerArgs::configureTuner(Tuner& tuner, Report& report) const
 #if defined(TS_LINUX)
     tuner.setSignalPoll(Tuner::DEFAULT_SIGNAL_POLL);
     tuner.setDemuxBufferSize(demux_buffer_size);
+    tuner.setUserBufferSize(user_buffer_size);
 #elif defined(TS_WINDOWS)
     tuner.setSinkQueueSize(demux_queue_size);
 #endif
@@ -635,6 +641,23 @@ bool ts::TunerArgs::tune(Tuner& tuner, TunerParametersPtr& params, Report& repor
 }
 
 
+//----------------------------------------------------------------------------
+// Device name of a tuner from its adapter number.
+//----------------------------------------------------------------------------
+
+ts::UString ts::TunerArgs::AdapterDeviceName(int adapter)
+{
+#if defined(TS_LINUX)
+    return UString::Format(u"/dev/dvb/adapter%d", {adapter});
+#elif defined(TS_WINDOWS)
+    return UString::Format(u":%d", {adapter});
+#else
+    // Does not mean anything, just for error messages.
+    return UString::Format(u"DVB adapter %d", {adapter});
+#endif
+}
+
+
 //----------------------------------------------------------------------------
 // Default zap file name for a given tuner type
 //----------------------------------------------------------------------------
@@ -58,6 +58,7 @@ namespace ts {
         MilliSecond                 receive_timeout;    //!< Packet received timeout in milliseconds.
 #if defined(TS_LINUX) || defined(DOXYGEN)
         size_t                      demux_buffer_size;  //!< Demux buffer size in bytes (Linux-specific).
+        size_t                      user_buffer_size;   //!< User-space DVR buffer size in bytes, zero if none (Linux-specific).
 #endif
 #if defined(TS_WINDOWS) || defined(DOXYGEN)
         size_t                      demux_queue_size;   //!< Max number of queued media samples (Windows-specific).
@@ -148,6 +149,13 @@ namespace ts {
         //!
         static UString DefaultZapFile(TunerType type);
 
+        //!
+        //! Device name of a tuner from its adapter number, as specified with option --adapter.
+        //! @param [in] adapter Adapter number.
+        //! @return The corresponding device name.
+        //!
+        static UString AdapterDeviceName(int adapter);
+
     private:
         const bool _info_only;
         const bool _allow_short_options;
@@ -1726,6 +1726,10 @@ bool ts::IsUpper(UChar c)
 
 ts::UChar ts::ToLower(UChar c)
 {
+    // Fast path for ASCII, the most common case (names in XML, command lines, etc.)
+    if (c < 0x80) {
+        return c >= u'A' && c <= u'Z' ? UChar(c + (u'a' - u'A')) : c;
+    }
     const UChar result = UChar(std::towlower(wint_t(c)));
     if (result != c) {
         // The standard function has found a translation.
@@ -1741,6 +1745,10 @@ ts::UChar ts::ToLower(UChar c)
 
 ts::UChar ts::ToUpper(UChar c)
 {
+    // Fast path for ASCII.
+    if (c < 0x80) {
+        return c >= u'a' && c <= u'z' ? UChar(c - (u'a' - u'A')) : c;
+    }
     const UChar result = UChar(std::towupper(wint_t(c)));
     if (result != c) {
         // The standard function has found a translation.
@@ -35,11 +35,22 @@
 #include "tsNullReport.h"
 TSDUCK_SOURCE;
 
+#if defined(TS_LINUX)
+    #include <netinet/udp.h>
+#endif
+
 // Furiously idiotic Windows feature, see comment in receiveOne()
 #if defined(TS_WINDOWS)
 volatile ::LPFN_WSARECVMSG ts::UDPSocket::_wsaRevcMsg = 0;
 #endif
 
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS) && defined(TS_LINUX)
+const size_t ts::UDPSocket::ANCILLARY_DATA_SIZE;
+const size_t ts::UDPSocket::MAX_SEND_MESSAGES;
+const size_t ts::UDPSocket::MAX_GSO_SEGMENTS;
+const size_t ts::UDPSocket::MAX_GSO_SIZE;
+#endif
+
 
 //----------------------------------------------------------------------------
 // Constructor
@@ -49,7 +60,17 @@ ts::UDPSocket::UDPSocket(bool auto_open, Report& report) :
     Socket(),
     _local_address(),
     _default_destination(),
-    _mcast()
+    _mcast(),
+    _gso(false)
+#if defined(TS_LINUX)
+    , _mmsg()
+    , _mmsg_iov()
+    , _mmsg_names()
+    , _mmsg_ancil()
+    , _send_mmsg()
+    , _send_iov()
+    , _send_ancil()
+#endif
 {
     if (auto_open) {
         // Returned value ignored on purpose, the socket is marked as closed in the object on error.
@@ -212,6 +233,62 @@ bool ts::UDPSocket::setTTL (int ttl, bool multicast, Report& report)
 }
 
 
+//----------------------------------------------------------------------------
+// Enable or disable the UDP generic segmentation offload.
+//----------------------------------------------------------------------------
+
+bool ts::UDPSocket::setSegmentationOffload(bool on, Report& report)
+{
+    _gso = false;
+    if (!on) {
+        return true;
+    }
+
+#if defined(TS_LINUX) && defined(UDP_SEGMENT)
+    // The segment size is specified with each message. Setting a zero
+    // segment size on the socket only checks that the kernel supports it.
+    int size = 0;
+    if (::setsockopt(getSocket(), SOL_UDP, UDP_SEGMENT, TS_SOCKOPT_T(&size), sizeof(size)) != 0) {
+        report.error(u"socket option UDP segmentation offload: " + SocketErrorCodeMessage());
+        return false;
+    }
+    _gso = true;
+    return true;
+#else
+    report.error(u"UDP segmentation offload is not supported on this system");
+    return false;
+#endif
+}
+
+
+//----------------------------------------------------------------------------
+// Request the kernel reception time stamps of the incoming messages.
+//----------------------------------------------------------------------------
+
+bool ts::UDPSocket::setReceiveTimestamps(bool on, Report& report)
+{
+#if defined(SO_TIMESTAMPNS) || defined(SO_TIMESTAMP)
+#if defined(SO_TIMESTAMPNS)
+    const int option = SO_TIMESTAMPNS;
+#else
+    const int option = SO_TIMESTAMP;
+#endif
+    int value = on;
+    if (::setsockopt(getSocket(), SOL_SOCKET, option, TS_SOCKOPT_T(&value), sizeof(value)) != 0) {
+        report.error(u"socket option receive time stamps: " + SocketErrorCodeMessage());
+        return false;
+    }
+    return true;
+#else
+    if (on) {
+        report.error(u"kernel receive time stamps are not supported on this system");
+        return false;
+    }
+    return true;
+#endif
+}
+
+
 //----------------------------------------------------------------------------
 // Join one multicast group on one local interface.
 // Return true on success, false on error.
@@ -307,6 +384,99 @@ bool ts::UDPSocket::send(const void* data, size_t size, const SocketAddress& des
 }
 
 
+//----------------------------------------------------------------------------
+// Send a contiguous sequence of messages of the same size.
+// Return true on success, false on error.
+//----------------------------------------------------------------------------
+
+bool ts::UDPSocket::sendSegments(const void* data, size_t size, size_t segment_size, const SocketAddress& dest, Report& report)
+{
+    if (segment_size == 0) {
+        report.error(u"invalid UDP segment size 0");
+        return false;
+    }
+
+    const uint8_t* pdata = reinterpret_cast<const uint8_t*>(data);
+
+#if defined(TS_LINUX)
+
+    ::sockaddr addr;
+    dest.copy(addr);
+
+    // Size of each message in the system call: one datagram or several ones with GSO.
+    const size_t gso_segments = _gso ? std::max<size_t>(1, std::min(MAX_GSO_SEGMENTS, MAX_GSO_SIZE / segment_size)) : 1;
+    const size_t msg_max_size = gso_segments * segment_size;
+
+    // Allocate the work areas for sendmmsg.
+    if (_send_mmsg.empty()) {
+        _send_mmsg.resize(MAX_SEND_MESSAGES);
+        _send_iov.resize(MAX_SEND_MESSAGES);
+        _send_ancil.resize(MAX_SEND_MESSAGES * ANCILLARY_DATA_SIZE);
+    }
+
+    while (size > 0) {
+
+        // Build a batch of message headers.
+        size_t msg_count = 0;
+        while (size > 0 && msg_count < MAX_SEND_MESSAGES) {
+            const size_t msg_size = std::min(size, msg_max_size);
+            TS_ZERO(_send_mmsg[msg_count]);
+            _send_iov[msg_count].iov_base = const_cast<uint8_t*>(pdata);
+            _send_iov[msg_count].iov_len = msg_size;
+            ::msghdr& hdr(_send_mmsg[msg_count].msg_hdr);
+            hdr.msg_name = &addr;
+            hdr.msg_namelen = sizeof(addr);
+            hdr.msg_iov = &_send_iov[msg_count];
+            hdr.msg_iovlen = 1;
+#if defined(UDP_SEGMENT)
+            if (msg_size > segment_size) {
+                // Let the kernel split the message into datagrams of the segment size.
+                hdr.msg_control = &_send_ancil[msg_count * ANCILLARY_DATA_SIZE];
+                hdr.msg_controllen = CMSG_SPACE(sizeof(uint16_t));
+                ::memset(hdr.msg_control, 0, hdr.msg_controllen);
+                ::cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr);
+                cmsg->cmsg_level = SOL_UDP;
+                cmsg->cmsg_type = UDP_SEGMENT;
+                cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+                const uint16_t gso_size = uint16_t(segment_size);
+                ::memcpy(CMSG_DATA(cmsg), &gso_size, sizeof(gso_size));
+            }
+#endif
+            pdata += msg_size;
+            size -= msg_size;
+            msg_count++;
+        }
+
+        // Send all messages of the batch, possibly in several system calls.
+        size_t sent = 0;
+        while (sent < msg_count) {
+            const int count = ::sendmmsg(getSocket(), &_send_mmsg[sent], static_cast<unsigned int>(msg_count - sent), 0);
+            if (count < 0) {
+                report.error(u"error sending UDP message: " + SocketErrorCodeMessage());
+                return false;
+            }
+            sent += size_t(count);
+        }
+    }
+    return true;
+
+#else
+
+    // Other systems: send each message individually.
+    while (size > 0) {
+        const size_t msg_size = std::min(size, segment_size);
+        if (!send(pdata, msg_size, dest, report)) {
+            return false;
+        }
+        pdata += msg_size;
+        size -= msg_size;
+    }
+    return true;
+
+#endif
+}
+
+
 //----------------------------------------------------------------------------
 // Receive a message.
 // If abort interface is non-zero, invoke it when I/O is interrupted
@@ -326,7 +496,8 @@ bool ts::UDPSocket::receive(void* data,
     for (;;) {
 
         // Wait for a message.
-        const SocketErrorCode err = receiveOne(data, max_size, ret_size, sender, destination, report);
+        NanoSecond kernel_time = -1;
+        const SocketErrorCode err = receiveOne(data, max_size, ret_size, sender, destination, kernel_time, report);
 
         if (err == SYS_SUCCESS) {
             return true;
@@ -354,12 +525,13 @@ bool ts::UDPSocket::receive(void* data,
 // Perform one receive operation. Hide the system mud.
 //----------------------------------------------------------------------------
 
-ts::SocketErrorCode ts::UDPSocket::receiveOne(void* data, size_t max_size, size_t& ret_size, SocketAddress& sender, SocketAddress& destination, Report& report)
+ts::SocketErrorCode ts::UDPSocket::receiveOne(void* data, size_t max_size, size_t& ret_size, SocketAddress& sender, SocketAddress& destination, NanoSecond& kernel_time, Report& report)
 {
     // Clear returned values
     ret_size = 0;
     sender.clear();
     destination.clear();
+    kernel_time = -1;
 
     // Reserve a socket address to receive the sender address.
     ::sockaddr sender_sock;
@@ -460,19 +632,181 @@ ts::SocketErrorCode ts::UDPSocket::receiveOne(void* data, size_t max_size, size_
     }
 
     // Browse returned ancillary data.
+    analyzeAncillaryData(hdr, destination, kernel_time, report);
+
+#endif // Windows vs. UNIX
+
+    // Successfully received a message
+    ret_size = size_t(insize);
+    sender = SocketAddress(sender_sock);
+
+    return SYS_SUCCESS;
+}
+
+
+//----------------------------------------------------------------------------
+// Analyze the ancillary data of a received message (UNIX systems).
+//----------------------------------------------------------------------------
+
+#if !defined(TS_WINDOWS)
+void ts::UDPSocket::analyzeAncillaryData(::msghdr& hdr, SocketAddress& destination, NanoSecond& kernel_time, Report& report)
+{
     for (::cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr); cmsg != 0; cmsg = CMSG_NXTHDR(&hdr, cmsg)) {
         report.debug(u"UDP recvmsg, ancillary message %d, level %d, %d bytes", {cmsg->cmsg_type, cmsg->cmsg_level, cmsg->cmsg_len});
         if (cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_PKTINFO && cmsg->cmsg_len >= sizeof(::in_pktinfo)) {
             const ::in_pktinfo* info = reinterpret_cast<const ::in_pktinfo*>(CMSG_DATA(cmsg));
             destination = SocketAddress(info->ipi_addr, _local_address.port());
         }
+#if defined(SCM_TIMESTAMPNS)
+        else if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS && cmsg->cmsg_len >= CMSG_LEN(sizeof(::timespec))) {
+            ::timespec ts;
+            ::memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+            kernel_time = NanoSecond(ts.tv_sec) * NanoSecPerSec + NanoSecond(ts.tv_nsec);
+        }
+#elif defined(SCM_TIMESTAMP)
+        else if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMP && cmsg->cmsg_len >= CMSG_LEN(sizeof(::timeval))) {
+            ::timeval tv;
+            ::memcpy(&tv, CMSG_DATA(cmsg), sizeof(tv));
+            kernel_time = NanoSecond(tv.tv_sec) * NanoSecPerSec + NanoSecond(tv.tv_usec) * NanoSecPerMicroSec;
+        }
+#endif
     }
+}
 
-#endif // Windows vs. UNIX
+// Convert a kernel time stamp in nanoseconds since the UNIX epoch into a UTC time.
+ts::Time ts::UDPSocket::KernelTimeToUTC(NanoSecond kernel_time)
+{
+    return Time::UnixTimeToUTC(uint32_t(kernel_time / NanoSecPerSec)) + (kernel_time % NanoSecPerSec) / NanoSecPerMilliSec;
+}
+#endif
 
-    // Successfully received a message
-    ret_size = size_t(insize);
-    sender = SocketAddress(sender_sock);
 
+//----------------------------------------------------------------------------
+// Description of one message in a multiple reception.
+//----------------------------------------------------------------------------
+
+ts::UDPSocket::ReceiveSlot::ReceiveSlot(void* data_, size_t max_size_) :
+    data(data_),
+    max_size(max_size_),
+    ret_size(0),
+    sender(),
+    destination(),
+    timestamp(Time::Epoch),
+    kernel_time(-1)
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Receive several messages in one operation.
+//----------------------------------------------------------------------------
+
+bool ts::UDPSocket::receive(ReceiveSlotVector& slots,
+                            size_t& count,
+                            const AbortInterface* abort,
+                            Report& report)
+{
+    count = 0;
+    if (slots.empty()) {
+        return true;
+    }
+
+    // Loop on unsollicited interrupts
+    for (;;) {
+
+        // Wait for at least one message.
+        const SocketErrorCode err = receiveMultiple(slots, count, report);
+
+        if (err == SYS_SUCCESS) {
+            return true;
+        }
+        else if (abort != 0 && abort->aborting()) {
+            // User-interrupt, end of processing but no error message
+            return false;
+        }
+#if !defined(TS_WINDOWS)
+        else if (err == EINTR) {
+            // Got a signal, not a user interrupt, will ignore it
+            report.debug(u"signal, not user interrupt");
+        }
+#endif
+        else {
+            // Abort on non-interrupt errors.
+            report.error(u"error receiving from UDP socket: %s", {SocketErrorCodeMessage(err)});
+            return false;
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Perform one multiple receive operation.
+//----------------------------------------------------------------------------
+
+ts::SocketErrorCode ts::UDPSocket::receiveMultiple(ReceiveSlotVector& slots, size_t& count, Report& report)
+{
+    count = 0;
+
+#if defined(TS_LINUX)
+
+    // Allocate the work areas for recvmmsg.
+    const size_t max_count = slots.size();
+    if (_mmsg.size() < max_count) {
+        _mmsg.resize(max_count);
+        _mmsg_iov.resize(max_count);
+        _mmsg_names.resize(max_count);
+        _mmsg_ancil.resize(max_count * ANCILLARY_DATA_SIZE);
+    }
+
+    // Build the message headers.
+    for (size_t i = 0; i < max_count; ++i) {
+        TS_ZERO(_mmsg[i]);
+        TS_ZERO(_mmsg_names[i]);
+        _mmsg_iov[i].iov_base = slots[i].data;
+        _mmsg_iov[i].iov_len = slots[i].max_size;
+        ::msghdr& hdr(_mmsg[i].msg_hdr);
+        hdr.msg_name = &_mmsg_names[i];
+        hdr.msg_namelen = sizeof(::sockaddr);
+        hdr.msg_iov = &_mmsg_iov[i];
+        hdr.msg_iovlen = 1;
+        hdr.msg_control = &_mmsg_ancil[i * ANCILLARY_DATA_SIZE];
+        hdr.msg_controllen = ANCILLARY_DATA_SIZE;
+    }
+
+    // Wait for the first message, then get all messages which are already available.
+    const int insize = ::recvmmsg(getSocket(), &_mmsg[0], ::ssize_t(max_count), MSG_WAITFORONE, 0);
+    if (insize < 0) {
+        return LastSocketErrorCode();
+    }
+
+    // Get the description of all received messages.
+    const Time now(Time::CurrentUTC());
+    count = size_t(insize);
+    for (size_t i = 0; i < count; ++i) {
+        ReceiveSlot& slot(slots[i]);
+        slot.ret_size = _mmsg[i].msg_len;
+        slot.sender = SocketAddress(_mmsg_names[i]);
+        slot.destination.clear();
+        slot.kernel_time = -1;
+        analyzeAncillaryData(_mmsg[i].msg_hdr, slot.destination, slot.kernel_time, report);
+        slot.timestamp = slot.kernel_time < 0 ? now : KernelTimeToUTC(slot.kernel_time);
+    }
     return SYS_SUCCESS;
+
+#else
+
+    // Other systems: receive one message at a time.
+    ReceiveSlot& slot(slots[0]);
+    const SocketErrorCode err = receiveOne(slot.data, slot.max_size, slot.ret_size, slot.sender, slot.destination, slot.kernel_time, report);
+    if (err == SYS_SUCCESS) {
+#if defined(TS_WINDOWS)
+        slot.timestamp = Time::CurrentUTC();
+#else
+        slot.timestamp = slot.kernel_time < 0 ? Time::CurrentUTC() : KernelTimeToUTC(slot.kernel_time);
+#endif
+        count = 1;
+    }
+    return err;
+
+#endif
 }
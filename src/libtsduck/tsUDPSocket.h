@@ -38,6 +38,8 @@
 #include "tsAbortInterface.h"
 #include "tsReport.h"
 #include "tsMemoryUtils.h"
+#include "tsByteBlock.h"
+#include "tsTime.h"
 
 namespace ts {
     //!
@@ -169,6 +171,34 @@ namespace ts {
             return setTTL(ttl, _default_destination.isMulticast(), report);
         }
 
+        //!
+        //! Enable or disable the UDP generic segmentation offload (GSO) in sendSegments().
+        //!
+        //! With segmentation offload, several datagrams of the same size are passed to the
+        //! kernel as one single large message. The kernel or the network interface splits
+        //! it into individual datagrams. This is supported on Linux only (kernel 4.18 and higher).
+        //!
+        //! @param [in] on If true, enable segmentation offload. If false, disable it.
+        //! @param [in,out] report Where to report error.
+        //! @return True on success, false on error or when the system does not support it.
+        //! On error, segmentation offload is disabled.
+        //!
+        bool setSegmentationOffload(bool on, Report& report = CERR);
+
+        //!
+        //! Request the kernel reception time stamps of the incoming messages.
+        //!
+        //! When set, the reception time of each message, as recorded by the kernel, is returned
+        //! by the multiple receive() method. This time stamp does not depend on the scheduling
+        //! of the application. This is supported on UNIX systems only (SO_TIMESTAMPNS on Linux,
+        //! SO_TIMESTAMP on other systems).
+        //!
+        //! @param [in] on If true, request kernel time stamps. If false, do not request them.
+        //! @param [in,out] report Where to report error.
+        //! @return True on success, false on error or when the system does not support it.
+        //!
+        bool setReceiveTimestamps(bool on, Report& report = CERR);
+
         //!
         //! Join a multicast group.
         //!
@@ -233,6 +263,38 @@ namespace ts {
             return send(data, size, _default_destination, report);
         }
 
+        //!
+        //! Send a contiguous sequence of messages of the same size to a destination address and port.
+        //!
+        //! The data are split into consecutive messages of @a segment_size bytes each.
+        //! The last message may be shorter. On Linux, the messages are sent using as few
+        //! system calls as possible (sendmmsg, optionally with segmentation offload, see
+        //! setSegmentationOffload()). On other systems, each message is sent individually.
+        //! The resulting datagrams on the network are identical in all cases.
+        //!
+        //! @param [in] data Address of the data to send.
+        //! @param [in] size Total size in bytes of the data to send.
+        //! @param [in] segment_size Size in bytes of each message.
+        //! @param [in] destination Socket address of the destination.
+        //! @param [in,out] report Where to report error.
+        //! @return True on success, false on error.
+        //!
+        bool sendSegments(const void* data, size_t size, size_t segment_size, const SocketAddress& destination, Report& report = CERR);
+
+        //!
+        //! Send a contiguous sequence of messages of the same size to the default destination.
+        //! @param [in] data Address of the data to send.
+        //! @param [in] size Total size in bytes of the data to send.
+        //! @param [in] segment_size Size in bytes of each message.
+        //! @param [in,out] report Where to report error.
+        //! @return True on success, false on error.
+        //! @see sendSegments(const void*, size_t, size_t, const SocketAddress&, Report&)
+        //!
+        bool sendSegments(const void* data, size_t size, size_t segment_size, Report& report = CERR)
+        {
+            return sendSegments(data, size, segment_size, _default_destination, report);
+        }
+
         //!
         //! Receive a message.
         //!
@@ -256,6 +318,54 @@ namespace ts {
                      const AbortInterface* abort = 0,
                      Report& report = CERR);
 
+        //!
+        //! Description of one message in a multiple reception.
+        //!
+        struct TSDUCKDLL ReceiveSlot
+        {
+            void*         data;         //!< [in] Address of the buffer for the received message.
+            size_t        max_size;     //!< [in] Size in bytes of the reception buffer.
+            size_t        ret_size;     //!< [out] Size in bytes of the received message, never larger than @a max_size.
+            SocketAddress sender;       //!< [out] Socket address of the sender.
+            SocketAddress destination;  //!< [out] Socket address of the packet destination.
+            Time          timestamp;    //!< [out] UTC time of reception of the message, from the kernel when available.
+            NanoSecond    kernel_time;  //!< [out] Kernel reception time in nanoseconds since the UNIX epoch (1970), negative if unavailable.
+
+            //!
+            //! Constructor.
+            //! @param [in] data Address of the buffer for the received message.
+            //! @param [in] max_size Size in bytes of the reception buffer.
+            //!
+            ReceiveSlot(void* data = 0, size_t max_size = 0);
+        };
+
+        //!
+        //! A vector of message descriptions for multiple receptions.
+        //!
+        typedef std::vector<ReceiveSlot> ReceiveSlotVector;
+
+        //!
+        //! Receive several messages in one operation.
+        //!
+        //! The method waits for at least one message, then returns all messages which
+        //! are already available, within the limit of the number of slots. On Linux,
+        //! all messages are received using one single system call (recvmmsg). On other
+        //! systems, one single message is received at a time. The kernel reception time
+        //! of each message is returned when requested by setReceiveTimestamps().
+        //!
+        //! @param [in,out] slots Description of the reception buffers. The output fields
+        //! of the first @a count elements are updated.
+        //! @param [out] count Number of received messages.
+        //! @param [in] abort If non-zero, invoked when I/O is interrupted
+        //! (in case of user-interrupt, return, otherwise retry).
+        //! @param [in,out] report Where to report error.
+        //! @return True on success, false on error.
+        //!
+        bool receive(ReceiveSlotVector& slots,
+                     size_t& count,
+                     const AbortInterface* abort = 0,
+                     Report& report = CERR);
+
         // Implementation of Socket interface.
         virtual bool open(Report& report = CERR) override;
         virtual bool close(Report& report = CERR) override;
@@ -292,9 +402,42 @@ namespace ts {
         SocketAddress _local_address;
         SocketAddress _default_destination;
         MReqSet       _mcast; // Current list of multicast memberships
+        bool          _gso;   // Use UDP generic segmentation offload in sendSegments()
 
         // Perform one receive operation. Hide the system mud.
-        SocketErrorCode receiveOne(void* data, size_t max_size, size_t& ret_size, SocketAddress& sender, SocketAddress& destination, Report& report);
+        SocketErrorCode receiveOne(void* data, size_t max_size, size_t& ret_size, SocketAddress& sender, SocketAddress& destination, NanoSecond& kernel_time, Report& report);
+
+        // Perform one multiple receive operation.
+        SocketErrorCode receiveMultiple(ReceiveSlotVector& slots, size_t& count, Report& report);
+
+#if !defined(TS_WINDOWS)
+        // Convert a kernel time stamp in nanoseconds since the UNIX epoch into a UTC time.
+        static Time KernelTimeToUTC(NanoSecond kernel_time);
+
+        // Analyze the ancillary data of a received message.
+        void analyzeAncillaryData(::msghdr& hdr, SocketAddress& destination, NanoSecond& kernel_time, Report& report);
+#endif
+
+#if defined(TS_LINUX)
+        // Size of the ancillary data area for each message in a multiple reception.
+        static const size_t ANCILLARY_DATA_SIZE = 256;
+
+        // Work areas for multiple receptions with recvmmsg, reused from one call to the next.
+        std::vector<::mmsghdr>  _mmsg;
+        std::vector<::iovec>    _mmsg_iov;
+        std::vector<::sockaddr> _mmsg_names;
+        ByteBlock               _mmsg_ancil;
+
+        // Limits of multiple transmissions: messages per sendmmsg, segments per GSO message, bytes per GSO message.
+        static const size_t MAX_SEND_MESSAGES = 256;
+        static const size_t MAX_GSO_SEGMENTS = 64;
+        static const size_t MAX_GSO_SIZE = 65000;
+
+        // Work areas for multiple transmissions with sendmmsg, reused from one call to the next.
+        std::vector<::mmsghdr>  _send_mmsg;
+        std::vector<::iovec>    _send_iov;
+        ByteBlock               _send_ancil;
+#endif
 
         // Furiously idiotic Windows feature, see comment in receiveOne()
 #if defined(TS_WINDOWS)
@@ -157,11 +157,11 @@ std::ostream& operator<<(std::ostream& strm, const ts::UChar c)
     }
     else if (c < 0x0800) {
         // 2 bytes encoding.
-        return strm << char(0x80 | (c & 0x3F)) << char(0xC0 | (c & 0x1F));
+        return strm << char(0xC0 | (c >> 6)) << char(0x80 | (c & 0x3F));
     }
     else {
         // 3 bytes encoding.
-        return strm << char(0x80 | (c & 0x3F)) << char(0x80 | (c & 0x3F)) << char(0xE0 | (c & 0x0F));
+        return strm << char(0xE0 | (c >> 12)) << char(0x80 | ((c >> 6) & 0x3F)) << char(0x80 | (c & 0x3F));
     }
 }
 
@@ -176,6 +176,18 @@ void ts::UString::ConvertUTF8ToUTF16(const char*& inStart, const char* inEnd, UC
 
     while (inStart < inEnd && outStart < outEnd) {
 
+        // Fast path for runs of ASCII characters, 8 bytes at a time.
+        while (inStart + 8 <= inEnd && outStart + 8 <= outEnd && (GetUInt64(inStart) & TS_UCONST64(0x8080808080808080)) == 0) {
+            for (size_t i = 0; i < 8; ++i) {
+                outStart[i] = UChar(inStart[i]);
+            }
+            inStart += 8;
+            outStart += 8;
+        }
+        if (inStart >= inEnd || outStart >= outEnd) {
+            break;
+        }
+
         // Get current code point at 8-bit value.
         code = *inStart++ & 0xFF;
 
@@ -326,8 +338,9 @@ ts::UString& ts::UString::assignFromUTF8(const char* utf8, size_type count)
 
 void ts::UString::toUTF8(std::string& utf8) const
 {
-    // The maximum number of UTF-8 bytes is 1.5 times the number of UTF-16 codes.
-    utf8.resize(2 * size());
+    // The maximum number of UTF-8 bytes is 3 times the number of UTF-16 codes
+    // (3 bytes for one code in the BMP, 4 bytes for a surrogate pair).
+    utf8.resize(3 * size());
 
     const UChar* inStart = data();
     char* outStart = const_cast<char*>(utf8.data());
@@ -348,18 +361,32 @@ std::string ts::UString::toUTF8() const
 // Output operator for ts::UString on standard text streams with UTF-8 conv.
 //----------------------------------------------------------------------------
 
+namespace {
+    // Write a UTF-16 string on a stream in UTF-8, using a local buffer, without heap allocation.
+    std::ostream& WriteUTF8(std::ostream& strm, const ts::UChar* inStart, const ts::UChar* inEnd)
+    {
+        char buffer[1024];
+        while (inStart < inEnd && strm) {
+            char* outStart = buffer;
+            ts::UString::ConvertUTF16ToUTF8(inStart, inEnd, outStart, buffer + sizeof(buffer));
+            if (outStart == buffer) {
+                // Truncated surrogate pair, nothing more to convert.
+                break;
+            }
+            strm.write(buffer, outStart - buffer);
+        }
+        return strm;
+    }
+}
+
 std::ostream& operator<<(std::ostream& strm, const ts::UString& str)
 {
-    std::string utf8;
-    str.toUTF8(utf8);
-    return strm << utf8;
+    return WriteUTF8(strm, str.data(), str.data() + str.size());
 }
 
 std::ostream& operator<<(std::ostream& strm, const ts::UChar* str)
 {
-    std::string utf8;
-    ts::UString(str).toUTF8(utf8);
-    return strm << utf8;
+    return str == 0 ? strm : WriteUTF8(strm, str, str + std::char_traits<ts::UChar>::length(str));
 }
 
 
@@ -1028,7 +1055,7 @@ bool ts::UString::similar(const UString& other) const
         if (ai >= alen && bi >= blen) {
             return true;
         }
-        if (ai >= alen || bi >= blen || ToLower(at(ai)) != ToLower(other.at(bi))) {
+        if (ai >= alen || bi >= blen || (at(ai) != other.at(bi) && ToLower(at(ai)) != ToLower(other.at(bi)))) {
             return false;
         }
         ai++;
@@ -1393,7 +1420,7 @@ ts::UString ts::UString::FromDVB(const uint8_t* dvb, size_type dvbSize, const DV
     else {
         // Convert the DVB string using the character set.
         UString str;
-        charset->decode(str, dvb, dvbSize);
+        charset->decodeCached(str, dvb, dvbSize);
         return str;
     }
 }
@@ -1575,6 +1602,13 @@ ts::UString ts::UString::Format(const UChar* fmt, const std::initializer_list<ts
     return result;
 }
 
+void ts::UString::format(const UChar* fmt, std::initializer_list<ArgMixIn> args)
+{
+    // Reuse the memory of this string.
+    clear();
+    ArgMixInContext ctx(*this, fmt, args);
+}
+
 
 //----------------------------------------------------------------------------
 // Scan this string for integer or character values.
@@ -1631,6 +1665,77 @@ void ts::UString::ArgMixContext::debug(const UString& message, UChar cmd) const
 // Analysis context of a Format string.
 //----------------------------------------------------------------------------
 
+namespace {
+    // Maximum number of digits in the allocation-free hexadecimal formatting.
+    const size_t MAX_FAST_HEXA = 32;
+}
+
+// Append a nul-terminated UTF-8 string, without temporary string.
+void ts::UString::ArgMixInContext::AppendUTF8(UString& result, const char* utf8)
+{
+    if (utf8 != 0) {
+        // The number of UTF-16 codes is always less than the number of UTF-8 bytes.
+        const size_t count = ::strlen(utf8);  // Flawfinder: ignore: strlen()
+        const size_t previous = result.size();
+        result.resize(previous + count);
+        UChar* const start = const_cast<UChar*>(result.data()) + previous;
+        UChar* out = start;
+        ConvertUTF8ToUTF16(utf8, utf8 + count, out, start + count);
+        result.resize(previous + (out - start));
+    }
+}
+
+// Append an integer in decimal, same format as Decimal(), without temporary string.
+void ts::UString::ArgMixInContext::AppendDecimal(UString& result, uint64_t value, bool negative, size_t minWidth, bool rightJustified, const UString& separator, bool forceSign, UChar pad)
+{
+    // Build the string in reverse order: 20 digits, 6 separators, one sign.
+    UChar buffer[32];
+    UChar* const end = buffer + sizeof(buffer) / sizeof(buffer[0]);
+    UChar* cur = end;
+    int count = 0;
+    do {
+        *--cur = u'0' + UChar(value % 10);
+        value /= 10;
+        if (++count % 3 == 0 && value != 0 && !separator.empty()) {
+            *--cur = separator[0];
+        }
+    } while (value != 0);
+    if (negative) {
+        *--cur = u'-';
+    }
+    else if (forceSign) {
+        *--cur = u'+';
+    }
+
+    // Adjust width.
+    const size_t size = end - cur;
+    if (size < minWidth && rightJustified) {
+        result.append(minWidth - size, pad);
+    }
+    result.append(cur, size);
+    if (size < minWidth && !rightJustified) {
+        result.append(minWidth - size, pad);
+    }
+}
+
+// Append an integer in hexadecimal, same format as Hexa(), without temporary string.
+void ts::UString::ArgMixInContext::AppendHexa(UString& result, uint64_t value, size_t width, const UString& separator, bool useUpper)
+{
+    // Build the string in reverse order: all digits and one separator every 4 digits.
+    UChar buffer[MAX_FAST_HEXA + MAX_FAST_HEXA / 4];
+    UChar* const end = buffer + sizeof(buffer) / sizeof(buffer[0]);
+    UChar* cur = end;
+    for (size_t count = 1; count <= width; ++count) {
+        const int nibble = int(value & 0xF);
+        value >>= 4;
+        *--cur = nibble < 10 ? u'0' + UChar(nibble) : (useUpper ? u'A' : u'a') + UChar(nibble - 10);
+        if (count % 4 == 0 && count < width && !separator.empty()) {
+            *--cur = separator[0];
+        }
+    }
+    result.append(cur, end - cur);
+}
+
 ts::UString::ArgMixInContext::ArgMixInContext(UString& result, const UChar* fmt, const std::initializer_list<ArgMixIn>& args) :
     ArgMixContext(fmt, true),
     _result(result),
@@ -1757,6 +1862,17 @@ void ts::UString::ArgMixInContext::processArg()
         if (cmd != u's' && debugActive()) {
             debug(u"type mismatch, got a string", cmd);
         }
+        // Without width constraint, directly append the string parameter.
+        if (minWidth == 0 && maxWidth == std::numeric_limits<size_t>::max()) {
+            if (_arg->isAnyString8()) {
+                AppendUTF8(_result, _arg->toCharPtr());
+            }
+            else if (_arg->isAnyString16()) {
+                _result.append(_arg->toUCharPtr());
+            }
+            ++_arg;
+            return;
+        }
         // Get the string parameter.
         UString value;
         if (_arg->isAnyString8()) {
@@ -1801,7 +1917,10 @@ void ts::UString::ArgMixInContext::processArg()
         if (minWidth == 0) {
             minWidth = 2 * _arg->size(); // number of hexa digits
         }
-        if (_arg->size() <= 4) {
+        if (separator.size() <= 1 && minWidth <= MAX_FAST_HEXA) {
+            AppendHexa(_result, _arg->size() <= 4 ? _arg->toUInt32() : _arg->toUInt64(), minWidth, separator, cmd == u'X');
+        }
+        else if (_arg->size() <= 4) {
             _result.append(Hexa(_arg->toUInt32(), minWidth, separator, false, cmd == u'X'));
         }
         else {
@@ -1813,7 +1932,14 @@ void ts::UString::ArgMixInContext::processArg()
         if (cmd != u'd' && debugActive()) {
             debug(u"type mismatch, got an integer", cmd);
         }
-        if (_arg->size() > 4) {
+        if (separator.size() <= 1) {
+            // Common case, format the absolute value without temporary string.
+            const int64_t svalue = _arg->size() > 4 ? _arg->toInt64() : _arg->toInt32();
+            const bool negative = _arg->isSigned() && svalue < 0;
+            const uint64_t value = negative ? uint64_t(-(svalue + 1)) + 1 : (_arg->size() > 4 ? _arg->toUInt64() : _arg->toUInt32());
+            AppendDecimal(_result, value, negative, minWidth, !leftJustified, separator, forceSign, pad);
+        }
+        else if (_arg->size() > 4) {
             // Stored as 64-bit integer.
             if (_arg->isSigned()) {
                 _result.append(Decimal(_arg->toInt64(), minWidth, !leftJustified, separator, forceSign, pad));
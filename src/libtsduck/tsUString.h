@@ -1461,6 +1461,33 @@ namespace ts {
             return Format(fmt.c_str(), args);
         }
 
+        //!
+        //! Format this string using a template and arguments.
+        //!
+        //! The previous content of this string is replaced. Unlike Format(), the memory
+        //! of this string is reused. When the same string is repeatedly used as formatting
+        //! buffer, there is no heap allocation once its capacity is large enough. Integers
+        //! and strings without width constraints are directly formatted into this string.
+        //!
+        //! The format string and the arguments must not reference this string.
+        //!
+        //! @param [in] fmt Format string with embedded '\%' sequences.
+        //! @param [in] args List of arguments to substitute in the format string.
+        //! @see Format()
+        //!
+        void format(const UChar* fmt, std::initializer_list<ArgMixIn> args);
+
+        //!
+        //! Format this string using a template and arguments.
+        //! @param [in] fmt Format string with embedded '\%' sequences.
+        //! @param [in] args List of arguments to substitute in the format string.
+        //! @see format()
+        //!
+        void format(const UString& fmt, std::initializer_list<ArgMixIn> args)
+        {
+            format(fmt.c_str(), args);
+        }
+
         //!
         //! Scan this string for integer or character values using a template and arguments.
         //!
@@ -1925,6 +1952,36 @@ namespace ts {
             //!
             void getFormatSize(size_t& size);
 
+            //!
+            //! Append a nul-terminated UTF-8 string without temporary string.
+            //! @param [in,out] result Result string.
+            //! @param [in] utf8 UTF-8 string, can be null.
+            //!
+            static void AppendUTF8(UString& result, const char* utf8);
+
+            //!
+            //! Append an integer in decimal without temporary string, same format as Decimal().
+            //! @param [in,out] result Result string.
+            //! @param [in] value Absolute value of the integer.
+            //! @param [in] negative True if the integer is negative.
+            //! @param [in] minWidth Minimum width of the formatted integer.
+            //! @param [in] rightJustified If true, pad on the left.
+            //! @param [in] separator Separator for groups of thousands, at most one character.
+            //! @param [in] forceSign If true, force a '+' sign for positive values.
+            //! @param [in] pad Padding character.
+            //!
+            static void AppendDecimal(UString& result, uint64_t value, bool negative, size_t minWidth, bool rightJustified, const UString& separator, bool forceSign, UChar pad);
+
+            //!
+            //! Append an integer in hexadecimal without temporary string, same format as Hexa().
+            //! @param [in,out] result Result string.
+            //! @param [in] value Integer value.
+            //! @param [in] width Exact number of hexadecimal digits, at most 32.
+            //! @param [in] separator Separator for groups of 4 digits, at most one character.
+            //! @param [in] useUpper If true, use uppercase hexadecimal digits.
+            //!
+            static void AppendHexa(UString& result, uint64_t value, size_t width, const UString& separator, bool useUpper);
+
             // Inaccessible operations.
             ArgMixInContext() = delete;
             ArgMixInContext(const ArgMixInContext&) = delete;
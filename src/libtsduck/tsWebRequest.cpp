@@ -51,6 +51,8 @@ ts::WebRequest::WebRequest(Report& report) :
     _report(report),
     _userAgent(u"tsduck"),
     _autoRedirect(true),
+    _connectionTimeout(0),
+    _receiveTimeout(0),
     _originalURL(),
     _finalURL(),
     _proxyHost(),
@@ -63,6 +65,8 @@ ts::WebRequest::WebRequest(Report& report) :
     _headerContentSize(0),
     _dlData(0),
     _dlFile(),
+    _dlHandler(0),
+    _interrupted(false),
     _guts(0)
 {
     allocateGuts();
@@ -230,6 +234,15 @@ bool ts::WebRequest::copyData(const void* addr, size_t size)
         }
     }
 
+    // Pass data to the application if there is a handler.
+    if (_dlHandler != 0 &&
+        ((_contentSize == 0 && !_dlHandler->handleWebStart(*this, _headerContentSize)) || !_dlHandler->handleWebData(*this, addr, size)))
+    {
+        _report.debug(u"Web transfer interrupted by application");
+        _interrupted = true;
+        return false;
+    }
+
     _contentSize += size;
     return true;
 }
@@ -290,6 +303,7 @@ bool ts::WebRequest::clearTransferResults()
     _httpStatus = 0;
     _contentSize = 0;
     _headerContentSize = 0;
+    _interrupted = false;
     _finalURL = _originalURL;
 
     // Close spurious file (should not happen).
@@ -358,3 +372,33 @@ bool ts::WebRequest::downloadFile(const UString& fileName)
     _dlFile.close();
     return ok;
 }
+
+
+//----------------------------------------------------------------------------
+// Download the content of the URL and pass data to the application.
+//----------------------------------------------------------------------------
+
+bool ts::WebRequest::downloadToApplication(WebRequestHandlerInterface* handler)
+{
+    if (handler == 0) {
+        _report.error(u"no application handler for Web transfer");
+        return false;
+    }
+
+    // Transfer initialization.
+    bool ok = clearTransferResults() && downloadInitialize();
+
+    // Actual transfer. An interruption by the application is not an error.
+    if (ok) {
+        try {
+            _dlHandler = handler;
+            ok = download() || _interrupted;
+        }
+        catch (...) {
+            ok = false;
+        }
+        _dlHandler = 0;
+    }
+
+    return ok;
+}
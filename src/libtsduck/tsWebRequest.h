@@ -36,6 +36,7 @@
 #include "tsReport.h"
 #include "tsByteBlock.h"
 #include "tsUString.h"
+#include "tsWebRequestHandlerInterface.h"
 
 namespace ts {
     //!
@@ -51,6 +52,11 @@ namespace ts {
     //!
     //! The response headers are available after a successful download operation.
     //!
+    //! The content of the URL can be entirely downloaded in memory or in a file.
+    //! It can also be passed to the application, chunk by chunk, as it arrives,
+    //! using downloadToApplication(). This is the only option for endless
+    //! content such as live streams.
+    //!
     class TSDUCKDLL WebRequest
     {
     public:
@@ -143,6 +149,26 @@ namespace ts {
             _autoRedirect = on;
         }
 
+        //!
+        //! Set the connection timeout for this request.
+        //! @param [in] timeout Maximum time to establish the connection, in milliseconds.
+        //! Zero means the default system timeout.
+        //!
+        void setConnectionTimeout(MilliSecond timeout)
+        {
+            _connectionTimeout = timeout;
+        }
+
+        //!
+        //! Set the reception timeout for this request.
+        //! @param [in] timeout Maximum time without receiving any data, in milliseconds.
+        //! The transfer fails after this time. Zero means no timeout.
+        //!
+        void setReceiveTimeout(MilliSecond timeout)
+        {
+            _receiveTimeout = timeout;
+        }
+
         //!
         //! Download the content of the URL as binary data.
         //! @param [out] data The content of the URL.
@@ -167,6 +193,16 @@ namespace ts {
         //!
         bool downloadFile(const UString& fileName);
 
+        //!
+        //! Download the content of the URL and pass data to the application on the fly.
+        //! The data are passed to the handler, chunk by chunk, as they are received.
+        //! Nothing is buffered in this object. The handler can interrupt the transfer
+        //! at any time. In that case, the download is not considered as an error.
+        //! @param [in] handler The application handler which receives the data.
+        //! @return True on success, false on error.
+        //!
+        bool downloadToApplication(WebRequestHandlerInterface* handler);
+
         //!
         //! Representation of reponse headers.
         //! The keys of the map are the header names.
@@ -219,6 +255,8 @@ namespace ts {
         Report&       _report;
         UString       _userAgent;
         bool          _autoRedirect;
+        MilliSecond   _connectionTimeout;
+        MilliSecond   _receiveTimeout;
         UString       _originalURL;
         UString       _finalURL;
         UString       _proxyHost;
@@ -231,6 +269,8 @@ namespace ts {
         size_t        _headerContentSize;  // content size, as announced in response header
         ByteBlock*    _dlData;             // download data buffer
         std::ofstream _dlFile;             // download file
+        WebRequestHandlerInterface* _dlHandler;  // download handler
+        bool          _interrupted;        // transfer interrupted by download handler
         SystemGuts*   _guts;               // system-specific data
 
         static UString  _defaultProxyHost;
@@ -0,0 +1,77 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Web request handler interface.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsPlatform.h"
+
+namespace ts {
+
+    class WebRequest;
+
+    //!
+    //! Web request handler interface.
+    //!
+    //! This abstract interface must be implemented by classes which need to
+    //! receive the content of a Web request on the fly, chunk by chunk, as it
+    //! is downloaded, without buffering the complete response.
+    //!
+    //! @see WebRequest::downloadToApplication()
+    //!
+    class TSDUCKDLL WebRequestHandlerInterface
+    {
+    public:
+        //!
+        //! This hook is invoked before the first chunk of data is received.
+        //! The response headers and the HTTP status are available in the request.
+        //! @param [in] request The Web request.
+        //! @param [in] size Announced size of the content, in bytes, zero if unknown.
+        //! @return True to continue the transfer, false to interrupt it.
+        //!
+        virtual bool handleWebStart(const WebRequest& request, size_t size) = 0;
+
+        //!
+        //! This hook is invoked each time a chunk of data is received.
+        //! @param [in] request The Web request.
+        //! @param [in] data Address of the received data.
+        //! @param [in] size Size in bytes of the received data.
+        //! @return True to continue the transfer, false to interrupt it.
+        //!
+        virtual bool handleWebData(const WebRequest& request, const void* data, size_t size) = 0;
+
+        //!
+        //! Virtual destructor.
+        //!
+        virtual ~WebRequestHandlerInterface() {}
+    };
+}
@@ -43,6 +43,7 @@
 #include "tsAbstractLongTable.h"
 #include "tsAbstractSignalization.h"
 #include "tsAbstractTable.h"
+#include "tsAbstractTablePlugin.h"
 #include "tsAbstractTransportListTable.h"
 #include "tsAC3Attributes.h"
 #include "tsAC3Descriptor.h"
@@ -66,6 +67,7 @@
 #include "tsBinaryTable.h"
 #include "tsBitStream.h"
 #include "tsBlockCipher.h"
+#include "tsBlockOutputStream.h"
 #include "tsBouquetNameDescriptor.h"
 #include "tsByteBlock.h"
 #include "tsCableDeliverySystemDescriptor.h"
@@ -78,12 +80,14 @@
 #include "tsCBC.h"
 #include "tsCerrReport.h"
 #include "tsCipherChaining.h"
+#include "tsCoarseClock.h"
 #include "tsCOM.h"
 #include "tsComponentDescriptor.h"
 #include "tsCondition.h"
 #include "tsContentDescriptor.h"
 #include "tsCountryAvailabilityDescriptor.h"
 #include "tsCRC32.h"
+#include "tsCTR.h"
 #include "tsCTS1.h"
 #include "tsCTS2.h"
 #include "tsCTS3.h"
@@ -92,6 +96,7 @@
 #include "tsCyclingPacketizer.h"
 #include "tsDataBroadcastDescriptor.h"
 #include "tsDataBroadcastIdDescriptor.h"
+#include "tsDefaultInitAllocator.h"
 #include "tsDektecControl.h"
 #include "tsDektecInputPlugin.h"
 #include "tsDektecOutputPlugin.h"
@@ -116,6 +121,7 @@
 #include "tsECMGSCS.h"
 #include "tsEDID.h"
 #include "tsEIT.h"
+#include "tsEITGenerator.h"
 #include "tsEMMGMUX.h"
 #include "tsEnhancedAC3Descriptor.h"
 #include "tsEnumeration.h"
@@ -133,6 +139,7 @@
 #include "tsHash.h"
 #include "tsHDSimulcastLogicalChannelDescriptor.h"
 #include "tsHEVCVideoDescriptor.h"
+#include "tsInjectionScheduler.h"
 #include "tsInputRedirector.h"
 #include "tsIntegerUtils.h"
 #include "tsInterruptHandler.h"
@@ -140,16 +147,23 @@
 #include "tsIPUtils.h"
 #include "tsISO639LanguageDescriptor.h"
 #include "tsjson.h"
+#include "tsjsonWriter.h"
 #include "tsLinkageDescriptor.h"
 #include "tsLNB.h"
 #include "tsLocalTimeOffsetDescriptor.h"
+#include "tsLockFreeMessageQueue.h"
 #include "tsLogicalChannelNumberDescriptor.h"
+#include "tsLogLimiter.h"
+#include "tsLZ4.h"
 #include "tsMaximumBitrateDescriptor.h"
 #include "tsMD5.h"
 #include "tsMediaGuardDate.h"
+#include "tsMemoryMappedFile.h"
 #include "tsMemoryUtils.h"
 #include "tsMessageDescriptor.h"
 #include "tsMessageQueue.h"
+#include "tsMetrics.h"
+#include "tsMetricsExporter.h"
 #include "tsMJD.h"
 #include "tsModulation.h"
 #include "tsMonotonic.h"
@@ -167,8 +181,10 @@
 #include "tsOutputPager.h"
 #include "tsOutputRedirector.h"
 #include "tsPacketizer.h"
+#include "tsPacketRegulator.h"
 #include "tsParentalRatingDescriptor.h"
 #include "tsPAT.h"
+#include "tsPcapFile.h"
 #include "tsPCR.h"
 #include "tsPCRAnalyzer.h"
 #include "tsPCSC.h"
@@ -183,6 +199,7 @@
 #include "tsPMT.h"
 #include "tsPMTHandlerInterface.h"
 #include "tsPollFiles.h"
+#include "tsPooledByteBlock.h"
 #include "tsPrivateDataIndicatorDescriptor.h"
 #include "tsPrivateDataSpecifierDescriptor.h"
 #include "tsPSILogger.h"
@@ -203,13 +220,17 @@
 #include "tsSafePtr.h"
 #include "tsSatelliteDeliverySystemDescriptor.h"
 #include "tsScrambling.h"
+#include "tsScramblingBatch.h"
 #include "tsSDT.h"
 #include "tsSection.h"
 #include "tsSectionDemux.h"
 #include "tsSectionFile.h"
 #include "tsSectionHandlerInterface.h"
 #include "tsSectionProviderInterface.h"
+#include "tsSectionView.h"
+#include "tsSectionViewHandlerInterface.h"
 #include "tsService.h"
+#include "tsServiceChangeHandlerInterface.h"
 #include "tsServiceDescriptor.h"
 #include "tsServiceDiscovery.h"
 #include "tsServiceListDescriptor.h"
@@ -218,8 +239,10 @@
 #include "tsSHA512.h"
 #include "tsSharedLibrary.h"
 #include "tsShortEventDescriptor.h"
+#include "tsSignalMonitor.h"
 #include "tsSimulCryptDate.h"
 #include "tsSingletonManager.h"
+#include "tsSmartCardService.h"
 #include "tsSocket.h"
 #include "tsSocketAddress.h"
 #include "tsSpliceInfoTable.h"
@@ -233,6 +256,7 @@
 #include "tsSubRipGenerator.h"
 #include "tsSubtitlingDescriptor.h"
 #include "tsSupplementaryAudioDescriptor.h"
+#include "tsSyncReport.h"
 #include "tsSysInfo.h"
 #include "tsSystemMonitor.h"
 #include "tsSystemRandomGenerator.h"
@@ -265,6 +289,7 @@
 #include "tsTextParser.h"
 #include "tsThread.h"
 #include "tsThreadAttributes.h"
+#include "tsThreadPool.h"
 #include "tsTime.h"
 #include "tsTimeShiftedEventDescriptor.h"
 #include "tsTimeShiftedServiceDescriptor.h"
@@ -285,11 +310,19 @@
 #include "tsTSAnalyzerOptions.h"
 #include "tsTSAnalyzerReport.h"
 #include "tsTSDT.h"
+#include "tsTSFileBlockReader.h"
+#include "tsTSFileBlockWriter.h"
+#include "tsTSFileIndex.h"
 #include "tsTSFileInput.h"
 #include "tsTSFileInputBuffered.h"
+#include "tsTSFileInputPlaylist.h"
 #include "tsTSFileOutput.h"
 #include "tsTSFileOutputResync.h"
+#include "tsTSFileOutputSegmented.h"
 #include "tsTSPacket.h"
+#include "tsTSPacketFormat.h"
+#include "tsTSPacketMetadata.h"
+#include "tsTSPacketView.h"
 #include "tsTSScanner.h"
 #include "tsTuner.h"
 #include "tsTunerArgs.h"
@@ -313,12 +346,14 @@
 #include "tsViaccessDate.h"
 #include "tsVideoAttributes.h"
 #include "tsWebRequest.h"
+#include "tsWebRequestHandlerInterface.h"
 #include "tsxml.h"
 #include "tsxmlAttribute.h"
 #include "tsxmlComment.h"
 #include "tsxmlDeclaration.h"
 #include "tsxmlDocument.h"
 #include "tsxmlElement.h"
+#include "tsxmlElementHandlerInterface.h"
 #include "tsxmlNode.h"
 #include "tsxmlText.h"
 #include "tsxmlUnknown.h"
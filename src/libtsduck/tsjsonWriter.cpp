@@ -0,0 +1,224 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "tsjsonWriter.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// Constructor.
+//----------------------------------------------------------------------------
+
+ts::json::Writer::Writer() :
+    _text(),
+    _first(),
+    _named(false)
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Clear the buffer and restart a new JSON text.
+//----------------------------------------------------------------------------
+
+void ts::json::Writer::clear()
+{
+    _text.clear();
+    _first.clear();
+    _named = false;
+}
+
+
+//----------------------------------------------------------------------------
+// Insert the separator before a value, if required.
+//----------------------------------------------------------------------------
+
+void ts::json::Writer::separator()
+{
+    if (_named) {
+        // Value of a field, the separator was inserted before the name.
+        _named = false;
+    }
+    else if (!_first.empty()) {
+        if (_first.back()) {
+            _first.back() = false;
+        }
+        else {
+            _text.push_back(',');
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Objects and arrays.
+//----------------------------------------------------------------------------
+
+ts::json::Writer& ts::json::Writer::beginObject()
+{
+    separator();
+    _text.push_back('{');
+    _first.push_back(true);
+    return *this;
+}
+
+ts::json::Writer& ts::json::Writer::endObject()
+{
+    _text.push_back('}');
+    if (!_first.empty()) {
+        _first.pop_back();
+    }
+    return *this;
+}
+
+ts::json::Writer& ts::json::Writer::beginArray()
+{
+    separator();
+    _text.push_back('[');
+    _first.push_back(true);
+    return *this;
+}
+
+ts::json::Writer& ts::json::Writer::endArray()
+{
+    _text.push_back(']');
+    if (!_first.empty()) {
+        _first.pop_back();
+    }
+    return *this;
+}
+
+
+//----------------------------------------------------------------------------
+// Fields and values.
+//----------------------------------------------------------------------------
+
+ts::json::Writer& ts::json::Writer::name(const UString& name)
+{
+    separator();
+    appendString(name.data(), name.size());
+    _text.push_back(':');
+    _named = true;
+    return *this;
+}
+
+ts::json::Writer& ts::json::Writer::string(const UChar* str, size_t size)
+{
+    separator();
+    appendString(str, size);
+    return *this;
+}
+
+ts::json::Writer& ts::json::Writer::value(bool value)
+{
+    separator();
+    _text.append(value ? "true" : "false");
+    return *this;
+}
+
+ts::json::Writer& ts::json::Writer::null()
+{
+    separator();
+    _text.append("null");
+    return *this;
+}
+
+ts::json::Writer& ts::json::Writer::integer(int64_t value)
+{
+    separator();
+
+    // Format the absolute value backward in a local buffer, without heap allocation.
+    char buf[24];
+    char* const end = buf + sizeof(buf);
+    char* cur = end;
+    uint64_t uval = value < 0 ? uint64_t(0) - uint64_t(value) : uint64_t(value);
+    do {
+        *--cur = char('0' + uval % 10);
+        uval /= 10;
+    } while (uval != 0);
+    if (value < 0) {
+        *--cur = '-';
+    }
+    _text.append(cur, end - cur);
+    return *this;
+}
+
+ts::json::Writer& ts::json::Writer::hexa(const void* data, size_t size)
+{
+    static const char digits[] = "0123456789ABCDEF";
+
+    separator();
+    _text.reserve(_text.size() + 2 * size + 2);
+    _text.push_back('"');
+    for (const uint8_t* p = reinterpret_cast<const uint8_t*>(data); size > 0; ++p, --size) {
+        _text.push_back(digits[*p >> 4]);
+        _text.push_back(digits[*p & 0x0F]);
+    }
+    _text.push_back('"');
+    return *this;
+}
+
+
+//----------------------------------------------------------------------------
+// Append a string literal, with JSON escape sequences.
+// Use the same escape sequences as UString::toJSON().
+//----------------------------------------------------------------------------
+
+void ts::json::Writer::appendString(const UChar* str, size_t size)
+{
+    static const char digits[] = "0123456789ABCDEF";
+
+    _text.push_back('"');
+    for (const UChar* const end = str + size; str < end; ++str) {
+        const UChar c = *str;
+        switch (c) {
+            case QUOTATION_MARK: _text.append("\\\""); break;
+            case REVERSE_SOLIDUS: _text.append("\\\\"); break;
+            case BACKSPACE: _text.append("\\b"); break;
+            case FORM_FEED: _text.append("\\f"); break;
+            case LINE_FEED: _text.append("\\n"); break;
+            case CARRIAGE_RETURN: _text.append("\\r"); break;
+            case HORIZONTAL_TABULATION: _text.append("\\t"); break;
+            default:
+                if (c >= 0x0020 && c <= 0x007E) {
+                    // Unmodified character
+                    _text.push_back(char(c));
+                }
+                else {
+                    // Other Unicode character, use hex code.
+                    _text.append("\\u");
+                    _text.push_back(digits[(c >> 12) & 0x0F]);
+                    _text.push_back(digits[(c >> 8) & 0x0F]);
+                    _text.push_back(digits[(c >> 4) & 0x0F]);
+                    _text.push_back(digits[c & 0x0F]);
+                }
+                break;
+        }
+    }
+    _text.push_back('"');
+}
@@ -0,0 +1,197 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Streaming writer of compact JSON text.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsjson.h"
+
+namespace ts {
+    namespace json {
+        //!
+        //! Streaming writer of compact JSON text.
+        //!
+        //! Unlike the ts::json::Value hierarchy, this class does not build any intermediate
+        //! structure. The JSON text is directly appended into a reusable internal buffer,
+        //! without any white space. All non-ASCII characters are escaped, the generated
+        //! text is pure ASCII and consequently valid UTF-8.
+        //!
+        //! Separators between fields and elements are automatically inserted.
+        //! The application is responsible for the correct nesting of objects and arrays.
+        //!
+        class TSDUCKDLL Writer
+        {
+        public:
+            //!
+            //! Constructor.
+            //!
+            Writer();
+
+            //!
+            //! Clear the buffer and restart a new JSON text.
+            //! The buffer memory is kept for reuse.
+            //!
+            void clear();
+
+            //!
+            //! Get the current JSON text.
+            //! @return A constant reference to the JSON text in the internal buffer.
+            //!
+            const std::string& text() const { return _text; }
+
+            //!
+            //! Open a JSON object, as a value.
+            //! @return A reference to this object.
+            //!
+            Writer& beginObject();
+
+            //!
+            //! Close the current JSON object.
+            //! @return A reference to this object.
+            //!
+            Writer& endObject();
+
+            //!
+            //! Open a JSON array, as a value.
+            //! @return A reference to this object.
+            //!
+            Writer& beginArray();
+
+            //!
+            //! Close the current JSON array.
+            //! @return A reference to this object.
+            //!
+            Writer& endArray();
+
+            //!
+            //! Start a new field in the current object.
+            //! The next operation shall write the value of the field.
+            //! @param [in] name Field name.
+            //! @return A reference to this object.
+            //!
+            Writer& name(const UString& name);
+
+            //!
+            //! Write a string value.
+            //! @param [in] value String value.
+            //! @return A reference to this object.
+            //!
+            Writer& value(const UString& value) { return string(value.data(), value.size()); }
+
+            //!
+            //! Write a string value.
+            //! @param [in] value Nul-terminated string value.
+            //! @return A reference to this object.
+            //!
+            Writer& value(const UChar* value) { return string(value, std::char_traits<UChar>::length(value)); }
+
+            //!
+            //! Write an integer value.
+            //! @tparam INT An integer type.
+            //! @param [in] value Integer value.
+            //! @return A reference to this object.
+            //!
+            template <typename INT, typename std::enable_if<std::is_integral<INT>::value>::type* = nullptr>
+            Writer& value(INT value) { return integer(int64_t(value)); }
+
+            //!
+            //! Write a boolean value, a JSON true or false literal.
+            //! @param [in] value Boolean value.
+            //! @return A reference to this object.
+            //!
+            Writer& value(bool value);
+
+            //!
+            //! Write a JSON null literal.
+            //! @return A reference to this object.
+            //!
+            Writer& null();
+
+            //!
+            //! Write binary data as a string value containing hexadecimal digits.
+            //! @param [in] data Address of binary data.
+            //! @param [in] size Size in bytes of binary data.
+            //! @return A reference to this object.
+            //!
+            Writer& hexa(const void* data, size_t size);
+
+            //!
+            //! Write a field with a string value in the current object.
+            //! @param [in] fieldName Field name.
+            //! @param [in] fieldValue String value.
+            //! @return A reference to this object.
+            //!
+            Writer& field(const UString& fieldName, const UString& fieldValue) { return name(fieldName).value(fieldValue); }
+
+            //!
+            //! Write a field with a string value in the current object.
+            //! @param [in] fieldName Field name.
+            //! @param [in] fieldValue Nul-terminated string value.
+            //! @return A reference to this object.
+            //!
+            Writer& field(const UString& fieldName, const UChar* fieldValue) { return name(fieldName).value(fieldValue); }
+
+            //!
+            //! Write a field with an integer value in the current object.
+            //! @tparam INT An integer type.
+            //! @param [in] fieldName Field name.
+            //! @param [in] fieldValue Integer value.
+            //! @return A reference to this object.
+            //!
+            template <typename INT, typename std::enable_if<std::is_integral<INT>::value>::type* = nullptr>
+            Writer& field(const UString& fieldName, INT fieldValue) { return name(fieldName).value(fieldValue); }
+
+            //!
+            //! Write a field with a boolean value in the current object.
+            //! @param [in] fieldName Field name.
+            //! @param [in] fieldValue Boolean value.
+            //! @return A reference to this object.
+            //!
+            Writer& field(const UString& fieldName, bool fieldValue) { return name(fieldName).value(fieldValue); }
+
+        private:
+            std::string       _text;   // JSON text buffer.
+            std::vector<bool> _first;  // Stack of "first element in object or array" flags.
+            bool              _named;  // A field name was just written, the value follows.
+
+            // Insert the separator before a value, if required.
+            void separator();
+
+            // Write a string value or an integer value.
+            Writer& string(const UChar* str, size_t size);
+            Writer& integer(int64_t value);
+
+            // Append a string literal, with JSON escape sequences.
+            void appendString(const UChar* str, size_t size);
+        };
+    }
+}
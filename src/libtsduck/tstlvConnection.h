@@ -37,6 +37,7 @@
 #include "tstlvProtocol.h"
 #include "tsMutex.h"
 #include "tstlvMessage.h"
+#include "tstlvMessageFactory.h"
 
 namespace ts {
     namespace tlv {
@@ -72,6 +73,7 @@ namespace ts {
 
             //!
             //! Serialize and send a TLV message.
+            //! The message is serialized in a send buffer which is reused from one message to the next.
             //! @param [in] msg The message to send.
             //! @param [in,out] report Where to report errors.
             //! @return True on success, false on error.
@@ -82,6 +84,7 @@ namespace ts {
             //! Receive a TLV message.
             //! Wait for the message, deserialize it and validate it.
             //! Process invalid messages and loop until a valid message is received.
+            //! The message is received in a buffer which is reused from one message to the next.
             //! @param [out] msg A safe pointer to the received message.
             //! @param [in] abort If non-zero, invoked when I/O is interrupted
             //! (in case of user-interrupt, return, otherwise retry).
@@ -90,6 +93,23 @@ namespace ts {
             //!
             bool receive(MessagePtr& msg, const AbortInterface* abort, Report& report);
 
+            //!
+            //! Receive a TLV message without rebuilding a message object.
+            //! Wait for the message and validate it. Process invalid messages and loop
+            //! until a valid message is received. The parameters of the message are
+            //! analyzed in place in the reception buffer. This avoids copying large
+            //! parameters such as data provision datagrams into intermediate objects.
+            //! @param [in,out] buffer Reception buffer. Its memory is reused from one call to the next.
+            //! @param [out] factory A safe pointer to a message factory on the received message.
+            //! Use MessageFactory::get() to access parameters in place or MessageFactory::factory()
+            //! to rebuild the message. The factory is valid as long as @a buffer is not modified.
+            //! @param [in] abort If non-zero, invoked when I/O is interrupted
+            //! (in case of user-interrupt, return, otherwise retry).
+            //! @param [in,out] report Where to report errors.
+            //! @return True on success, false on error.
+            //!
+            bool receive(ByteBlock& buffer, MessageFactoryPtr& factory, const AbortInterface* abort, Report& report);
+
             //!
             //! Get invalid incoming messages processing.
             //! @return True if, when an invalid message is received, the corresponding
@@ -132,7 +152,16 @@ namespace ts {
             size_t          _invalid_msg_count;
             MUTEX           _send_mutex;
             MUTEX           _receive_mutex;
+            ByteBlockPtr    _send_buffer;     // Reused serialization buffer, protected by _send_mutex.
+            ByteBlock       _receive_buffer;  // Reused reception buffer, protected by _receive_mutex.
+
+            // Receive one raw TLV message in a buffer, without analysis.
+            bool receiveRaw(ByteBlock& bb, const AbortInterface* abort, Report& report);
+
+            // Process an invalid message. Return false if the connection shall be broken.
+            bool processInvalidMessage(const MessageFactory& mf, Report& report);
 
+            // Inaccessible operations.
             Connection(const Connection&) = delete;
             Connection& operator=(const Connection&) = delete;
         };
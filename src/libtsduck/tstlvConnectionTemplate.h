@@ -46,7 +46,9 @@ ts::tlv::Connection<MUTEX>::Connection(const Protocol* protocol, bool auto_error
     _max_invalid_msg(max_invalid_msg),
     _invalid_msg_count(0),
     _send_mutex(),
-    _receive_mutex()
+    _receive_mutex(),
+    _send_buffer(new ByteBlock),
+    _receive_buffer()
 {
 }
 
@@ -85,12 +87,12 @@ bool ts::tlv::Connection<MUTEX>::send (const Message& msg, Report& report)
         report.debug(u"sending message to %s\n%s", {peerName(), msg.dump(4)});
     }
 
-    ByteBlockPtr bbp (new ByteBlock);
-    Serializer serial (bbp);
-    msg.serialize (serial);
-
-    Guard lock (_send_mutex);
-    return SuperClass::send (bbp->data(), bbp->size(), report);
+    // Serialize in the send buffer. Its memory is reused from one message to the next.
+    Guard lock(_send_mutex);
+    _send_buffer->clear();
+    Serializer serial(_send_buffer);
+    msg.serialize(serial);
+    return SuperClass::send(_send_buffer->data(), _send_buffer->size(), report);
 }
 
 
@@ -99,61 +101,109 @@ bool ts::tlv::Connection<MUTEX>::send (const Message& msg, Report& report)
 //----------------------------------------------------------------------------
 
 template <class MUTEX>
-bool ts::tlv::Connection<MUTEX>::receive (MessagePtr& msg, const AbortInterface* abort, Report& report)
+bool ts::tlv::Connection<MUTEX>::receive(MessagePtr& msg, const AbortInterface* abort, Report& report)
 {
-    const bool has_version (_protocol->hasVersion());
-    const size_t header_size (has_version ? 5 : 4);
-    const size_t length_offset (has_version ? 3 : 2);
+    // The reception buffer is reused, keep it locked until the message is rebuilt.
+    Guard lock(_receive_mutex);
 
-    // Loop until a valid message is received
+    // Loop until a valid message is received.
     for (;;) {
-        ByteBlock bb (header_size);
-
-        // Receive complete message
-        {
-            Guard lock (_receive_mutex);
-
-            // Read message header
-            if (!SuperClass::receive (bb.data(), header_size, abort, report)) {
-                return false;
-            }
-
-            // Get message length and read message payload
-            const size_t length (GetUInt16 (bb.data() + length_offset));
-            bb.resize (header_size + length);
-            if (!SuperClass::receive (bb.data() + header_size, length, abort, report)) {
-                return false;
-            }
+        if (!receiveRaw(_receive_buffer, abort, report)) {
+            return false;
         }
 
-        // Analyze the message
-        MessageFactory mf (bb.data(), bb.size(), _protocol);
+        // Analyze the message in place, in the reception buffer.
+        const MessageFactory mf(_receive_buffer, _protocol);
         if (mf.errorStatus() == tlv::OK) {
             _invalid_msg_count = 0;
-            mf.factory (msg);
+            mf.factory(msg);
             if (report.debug() && !msg.isNull()) {
                 report.debug(u"received message from %s\n%s", {peerName(), msg->dump(4)});
             }
             return true;
         }
+        if (!processInvalidMessage(mf, report)) {
+            return false;
+        }
+    }
+}
 
-        // Received an invalid message
-        _invalid_msg_count++;
 
-        // Send back an error message if necessary
-        if (_auto_error_response) {
-            MessagePtr resp;
-            mf.buildErrorResponse (resp);
-            if (!send (*resp, report)) {
-                return false;
-            }
+//----------------------------------------------------------------------------
+// Receive a TLV message and analyze it in place (wait for the message and validate it)
+//----------------------------------------------------------------------------
+
+template <class MUTEX>
+bool ts::tlv::Connection<MUTEX>::receive(ByteBlock& bb, MessageFactoryPtr& mf, const AbortInterface* abort, Report& report)
+{
+    // Loop until a valid message is received.
+    for (;;) {
+        if (!receiveRaw(bb, abort, report)) {
+            return false;
+        }
+        mf = new MessageFactory(bb, _protocol);
+        if (mf->errorStatus() == tlv::OK) {
+            _invalid_msg_count = 0;
+            return true;
+        }
+        if (!processInvalidMessage(*mf, report)) {
+            return false;
         }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Receive one raw TLV message in a buffer, without analysis.
+//----------------------------------------------------------------------------
+
+template <class MUTEX>
+bool ts::tlv::Connection<MUTEX>::receiveRaw(ByteBlock& bb, const AbortInterface* abort, Report& report)
+{
+    const bool has_version = _protocol->hasVersion();
+    const size_t header_size = has_version ? 5 : 4;
+    const size_t length_offset = has_version ? 3 : 2;
+
+    // The resize() operations do not reallocate when the buffer is reused.
+    Guard lock(_receive_mutex);
+    bb.resize(header_size);
 
-        // If invalid message max has been reached, break the connection
-        if (_max_invalid_msg > 0 && _invalid_msg_count >= _max_invalid_msg) {
-            report.error(u"too many invalid messages from %s, disconnecting", {peerName()});
-            disconnect (report);
+    // Read message header
+    if (!SuperClass::receive(bb.data(), header_size, abort, report)) {
+        return false;
+    }
+
+    // Get message length and read message payload
+    const size_t length = GetUInt16(bb.data() + length_offset);
+    bb.resize(header_size + length);
+    return SuperClass::receive(bb.data() + header_size, length, abort, report);
+}
+
+
+//----------------------------------------------------------------------------
+// Process an invalid message.
+//----------------------------------------------------------------------------
+
+template <class MUTEX>
+bool ts::tlv::Connection<MUTEX>::processInvalidMessage(const MessageFactory& mf, Report& report)
+{
+    // Received an invalid message
+    _invalid_msg_count++;
+
+    // Send back an error message if necessary
+    if (_auto_error_response) {
+        MessagePtr resp;
+        mf.buildErrorResponse(resp);
+        if (!send(*resp, report)) {
             return false;
         }
     }
+
+    // If invalid message max has been reached, break the connection
+    if (_max_invalid_msg > 0 && _invalid_msg_count >= _max_invalid_msg) {
+        report.error(u"too many invalid messages from %s, disconnecting", {peerName()});
+        disconnect(report);
+        return false;
+    }
+    return true;
 }
@@ -363,6 +363,11 @@ namespace ts {
         template<> inline bool MessageFactory::get<bool>(TAG tag) const {return get<uint8_t>(tag) != 0;}
         template<> inline size_t MessageFactory::dataSize<bool>() const {return 1;}
         //! @endcond
+
+        //!
+        //! Safe pointer to a MessageFactory (not thread-safe).
+        //!
+        typedef SafePtr<MessageFactory, NullMutex> MessageFactoryPtr;
     }
 }
 
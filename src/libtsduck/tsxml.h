@@ -63,6 +63,7 @@ namespace ts {
         class Declaration;
         class Document;
         class Element;
+        class ElementHandlerInterface;
         class Node;
         class Text;
         class Unknown;
@@ -55,8 +55,10 @@ bool ts::xml::Document::parse(const UString& text)
 
 bool ts::xml::Document::load(std::istream& strm)
 {
+    // With an element handler, the document is read progressively.
     TextParser parser(_report);
-    return parser.loadStream(strm) && parseNode(parser, 0);
+    const bool ok = _elementHandler == 0 ? parser.loadStream(strm) : parser.openStream(strm);
+    return ok && parseNode(parser, 0);
 }
 
 bool ts::xml::Document::load(const UString& fileName, bool search)
@@ -70,9 +72,10 @@ bool ts::xml::Document::load(const UString& fileName, bool search)
         return false;
     }
 
-    // Parse the document from the file.
+    // Parse the document from the file. With an element handler, the file is read progressively.
     TextParser parser(_report);
-    return parser.loadFile(actualFileName) && parseNode(parser, 0);
+    const bool ok = _elementHandler == 0 ? parser.loadFile(actualFileName) : parser.openFile(actualFileName);
+    return ok && parseNode(parser, 0);
 }
 
 
@@ -177,6 +180,30 @@ bool ts::xml::Document::validate(const Document& model) const
     }
 }
 
+// Validate one child element of the root of the XML document.
+bool ts::xml::Document::validateChild(const Document& model, const Element* element) const
+{
+    const Element* modelRoot = model.rootElement();
+
+    if (modelRoot == 0) {
+        _report.error(u"invalid XML model, no root element");
+        return false;
+    }
+    else if (element == 0) {
+        _report.error(u"invalid XML document");
+        return false;
+    }
+
+    const Element* modelChild = findModelElement(modelRoot, element->name());
+    if (modelChild == 0) {
+        _report.error(u"unexpected node <%s> in <%s>, line %d", {element->name(), modelRoot->name(), element->lineNumber()});
+        return false;
+    }
+    else {
+        return validateElement(modelChild, element);
+    }
+}
+
 // Validate an XML tree of elements, used by validate().
 bool ts::xml::Document::validateElement(const Element* model, const Element* doc) const
 {
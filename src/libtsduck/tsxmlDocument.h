@@ -48,7 +48,32 @@ namespace ts {
             //! Constructor.
             //! @param [in,out] report Where to report errors.
             //!
-            explicit Document(Report& report = NULLREP) : Node(report, 1) {}
+            explicit Document(Report& report = NULLREP) : Node(report, 1), _elementHandler(0) {}
+
+            //!
+            //! Set the element handler for progressive parsing.
+            //!
+            //! When an element handler is set, each child element of the root is passed to the
+            //! handler as soon as it is parsed and is then deleted. After parsing, the root
+            //! element remains in the document but has no child. This reduces the memory which
+            //! is required to process large documents. Additionally, when the document is loaded
+            //! from a file or a stream, the text is read progressively.
+            //!
+            //! @param [in] handler The element handler. Zero to build the complete document.
+            //!
+            void setElementHandler(ElementHandlerInterface* handler)
+            {
+                _elementHandler = handler;
+            }
+
+            //!
+            //! Get the element handler for progressive parsing.
+            //! @return The element handler or zero if there is none.
+            //!
+            ElementHandlerInterface* elementHandler() const
+            {
+                return _elementHandler;
+            }
 
             //!
             //! Parse an XML document.
@@ -99,6 +124,18 @@ namespace ts {
             //!
             bool validate(const Document& model) const;
 
+            //!
+            //! Validate one child element of the root of the XML document.
+            //!
+            //! This is used with an element handler to validate each child of the root before
+            //! it is deleted. The root itself is validated using validate() after parsing.
+            //!
+            //! @param [in] model The model document, see validate().
+            //! @param [in] element A child element of the root of this document.
+            //! @return True if @a element matches the corresponding element in @a model, false if it does not.
+            //!
+            bool validateChild(const Document& model, const Element* element) const;
+
             //!
             //! Save an XML file.
             //! @param [in] fileName Name of the XML file to save.
@@ -146,6 +183,8 @@ namespace ts {
             virtual bool parseNode(TextParser& parser, const Node* parent) override;
 
         private:
+            ElementHandlerInterface* _elementHandler;  //!< Element handler for progressive parsing.
+
             //!
             //! Validate an XML tree of elements, used by validate().
             //! @param [in] model The model element.
@@ -28,6 +28,8 @@
 //----------------------------------------------------------------------------
 
 #include "tsxmlElement.h"
+#include "tsxmlDocument.h"
+#include "tsxmlElementHandlerInterface.h"
 #include "tsxmlText.h"
 #include "tsFatal.h"
 TSDUCK_SOURCE;
@@ -40,14 +42,14 @@ TSDUCK_SOURCE;
 ts::xml::Element::Element(Report& report, size_t line, CaseSensitivity attributeCase) :
     Node(report, line),
     _attributeCase(attributeCase),
-    _attributes()
+    _attributes(AttributeKeyLess(attributeCase))
 {
 }
 
 ts::xml::Element::Element(Node* parent, const UString& name, CaseSensitivity attributeCase) :
     Node(parent, name), // the "value" of an element node is its name.
     _attributeCase(attributeCase),
-    _attributes()
+    _attributes(AttributeKeyLess(attributeCase))
 {
 }
 
@@ -300,19 +302,35 @@ ts::xml::Text* ts::xml::Element::addHexaText(const void* data, size_t size)
 // Attribute map management.
 //----------------------------------------------------------------------------
 
-ts::UString ts::xml::Element::attributeKey(const UString& attributeName) const
+bool ts::xml::Element::AttributeKeyLess::operator()(const UString& a, const UString& b) const
 {
-    return _attributeCase == CASE_SENSITIVE ? attributeName : attributeName.toLower();
+    if (_case == CASE_SENSITIVE) {
+        return a < b;
+    }
+    // Same order as comparing the lowercase versions of the names.
+    const size_t len = std::min(a.length(), b.length());
+    for (size_t i = 0; i < len; ++i) {
+        const UChar ca = a[i];
+        const UChar cb = b[i];
+        if (ca != cb) {
+            const UChar la = ToLower(ca);
+            const UChar lb = ToLower(cb);
+            if (la != lb) {
+                return la < lb;
+            }
+        }
+    }
+    return a.length() < b.length();
 }
 
 ts::xml::Element::AttributeMap::const_iterator ts::xml::Element::findAttribute(const UString& attributeName) const
 {
-    return _attributes.find(attributeKey(attributeName));
+    return _attributes.find(attributeName);
 }
 
 void ts::xml::Element::setAttribute(const UString& name, const UString& value)
 {
-    _attributes[attributeKey(name)] = Attribute(name, value);
+    _attributes[name] = Attribute(name, value);
 }
 
 bool ts::xml::Element::hasAttribute(const UString& name) const
@@ -322,8 +340,8 @@ bool ts::xml::Element::hasAttribute(const UString& name) const
 
 ts::xml::Attribute& ts::xml::Element::refAttribute(const UString& name)
 {
-    const AttributeMap::iterator it(_attributes.find(attributeKey(name)));
-    return it == _attributes.end() ? (_attributes[attributeKey(name)] = Attribute(name, u"")) : it->second;
+    const AttributeMap::iterator it(_attributes.find(name));
+    return it == _attributes.end() ? (_attributes[name] = Attribute(name, u"")) : it->second;
 }
 
 
@@ -536,7 +554,7 @@ void ts::xml::Element::print(TextFormatter& output, bool keepNodeOpen) const
         }
         else {
             // If both quotes are present, translate those in the value as HTML entities.
-            output << attr.value().toHTML(UString(1, quote));
+            PrintHTML(output, attr.value(), UString(1, quote));
         }
         output << quote;
     }
@@ -648,13 +666,10 @@ bool ts::xml::Element::parseNode(TextParser& parser, const Node* parent)
             if (!ok) {
                 _report.error(u"line %d: error parsing attribute '%s' in tag <%s>", {line, name, _value});
             }
-            else if (hasAttribute(name)) {
+            else if (!_attributes.insert(std::make_pair(name, Attribute(name, value, line))).second) {
                 _report.error(u"line %d: duplicate attribute '%s' in tag <%s>", {line, name, _value});
                 ok = false;
             }
-            else {
-                _attributes[attributeKey(name)] = Attribute(name, value, line);
-            }
         }
         else {
             _report.error(u"line %d: parsing error, tag <%s>", {lineNumber(), _value});
@@ -670,8 +685,11 @@ bool ts::xml::Element::parseNode(TextParser& parser, const Node* parent)
         return false;
     }
 
-    // End of tag, swallow all children.
-    if (!parseChildren(parser)) {
+    // End of tag, swallow all children. When this is the root of a document
+    // with an element handler, the children are passed to the handler instead.
+    const Document* doc = dynamic_cast<const Document*>(parent);
+    ElementHandlerInterface* handler = doc == 0 ? 0 : doc->elementHandler();
+    if (!(handler == 0 ? parseChildren(parser) : parseStreamedChildren(parser, *handler))) {
         return false;
     }
 
@@ -49,8 +49,18 @@ namespace ts {
         class TSDUCKDLL Element: public Node
         {
         private:
+            // Comparison of attribute names, case-(in)sensitive, without building lowercase copies.
+            class AttributeKeyLess
+            {
+            public:
+                explicit AttributeKeyLess(CaseSensitivity attributeCase = CASE_INSENSITIVE) : _case(attributeCase) {}
+                bool operator()(const UString& a, const UString& b) const;
+            private:
+                CaseSensitivity _case;
+            };
+
             // Attributes are stored indexed by case-(in)sensitive name.
-            typedef std::map<UString, Attribute> AttributeMap;
+            typedef std::map<UString, Attribute, AttributeKeyLess> AttributeMap;
 
         public:
             //!
@@ -445,9 +455,6 @@ namespace ts {
             CaseSensitivity _attributeCase;  //!< For attribute names.
             AttributeMap    _attributes;     //!< Map of attributes.
 
-            // Compute the key in the attribute map.
-            UString attributeKey(const UString& attributeName) const;
-
             // Find a key in the attribute map.
             AttributeMap::const_iterator findAttribute(const UString& attributeName) const;
 
@@ -0,0 +1,65 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  XML element handler interface.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsxml.h"
+
+namespace ts {
+    namespace xml {
+        //!
+        //! XML element handler interface.
+        //!
+        //! This abstract interface must be implemented by classes which need to process
+        //! large XML documents progressively. When an element handler is set in a Document,
+        //! each child element of the root is passed to the handler as soon as it is completely
+        //! parsed. The element and its subtree are then deleted and do not remain in the document.
+        //!
+        class TSDUCKDLL ElementHandlerInterface
+        {
+        public:
+            //!
+            //! This hook is invoked when a child element of the root is completely parsed.
+            //! @param [in] element The parsed element. It is deleted when the handler returns.
+            //! @return True on success, false on error. On error, the parsing continues
+            //! but the parsing of the document reports a failure.
+            //!
+            virtual bool handleElement(const Element* element) = 0;
+
+            //!
+            //! Virtual destructor.
+            //!
+            virtual ~ElementHandlerInterface() {}
+        };
+    }
+}
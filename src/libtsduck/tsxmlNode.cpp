@@ -32,6 +32,7 @@
 #include "tsxmlDeclaration.h"
 #include "tsxmlDocument.h"
 #include "tsxmlElement.h"
+#include "tsxmlElementHandlerInterface.h"
 #include "tsxmlText.h"
 #include "tsxmlUnknown.h"
 #include "tsTextFormatter.h"
@@ -245,6 +246,38 @@ bool ts::xml::Node::parseChildren(TextParser& parser)
 }
 
 
+//----------------------------------------------------------------------------
+// Parse children nodes and pass them to an element handler.
+//----------------------------------------------------------------------------
+
+bool ts::xml::Node::parseStreamedChildren(TextParser& parser, ElementHandlerInterface& handler)
+{
+    bool result = true;
+    Node* node;
+
+    while ((node = identifyNextNode(parser)) != 0) {
+
+        // Read the complete node. Only elements are passed to the handler.
+        if (node->parseNode(parser, this)) {
+            node->reparent(this);
+            const Element* elem = dynamic_cast<const Element*>(node);
+            if (elem != 0 && !handler.handleElement(elem)) {
+                result = false;
+            }
+        }
+        else {
+            result = false;
+        }
+
+        // Drop the node and the text it came from.
+        delete node;
+        parser.discardConsumedLines();
+    }
+
+    return result;
+}
+
+
 //----------------------------------------------------------------------------
 // Build a debug string for the node.
 //----------------------------------------------------------------------------
@@ -295,3 +328,28 @@ ts::xml::Node* ts::xml::Node::identifyNextNode(TextParser& parser)
         return new Text(_report, parser.lineNumber(), false);
     }
 }
+
+
+//----------------------------------------------------------------------------
+// Print a string with some characters converted to HTML entities.
+//----------------------------------------------------------------------------
+
+void ts::xml::Node::PrintHTML(TextFormatter& output, const UString& str, const UString& convert)
+{
+    UString::size_type start = 0;
+    UString::size_type pos = str.find_first_of(convert);
+
+    if (pos == UString::NPOS) {
+        // Nothing to convert.
+        output << str;
+    }
+    else {
+        // Print the unmodified parts and the converted characters one by one.
+        do {
+            output << str.substr(start, pos - start) << UString(1, str[pos]).toHTML(convert);
+            start = pos + 1;
+            pos = str.find_first_of(convert, start);
+        } while (pos != UString::NPOS);
+        output << str.substr(start);
+    }
+}
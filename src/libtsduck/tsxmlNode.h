@@ -309,6 +309,28 @@ namespace ts {
             //!
             virtual bool parseChildren(TextParser& parser);
 
+            //!
+            //! Parse children nodes and pass them to an element handler.
+            //! Each child is deleted as soon as it is parsed, child elements are
+            //! first passed to the handler. Parsed lines are discarded in the parser.
+            //! Stop either at end of document or before a "</" sequence.
+            //! @param [in,out] parser The document parser.
+            //! @param [in,out] handler The handler which receives the child elements.
+            //! @return True on success, false on error.
+            //!
+            bool parseStreamedChildren(TextParser& parser, ElementHandlerInterface& handler);
+
+            //!
+            //! Print a string with some characters converted to HTML entities.
+            //! Strings without character to convert, the most frequent case, are printed
+            //! directly. Otherwise, the string is printed piece by piece, without building
+            //! a converted copy of the complete string.
+            //! @param [in,out] output Where to print the string.
+            //! @param [in] str The string to print.
+            //! @param [in] convert The characters to convert.
+            //!
+            static void PrintHTML(TextFormatter& output, const UString& str, const UString& convert);
+
             mutable ReportWithPrefix _report;       //!< Where to report errors.
             UString                  _value;        //!< Value of the node, depend on the node type.
 
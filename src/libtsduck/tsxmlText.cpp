@@ -60,7 +60,7 @@ void ts::xml::Text::print(TextFormatter& output, bool keepNodeOpen) const
         output << "<![CDATA[" << _value << "]]>";
     }
     else {
-        output << _value.toHTML(u"<>");
+        PrintHTML(output, _value, u"<>");
     }
 }
 
@@ -52,7 +52,9 @@ ts::xml::Unknown::Unknown(Node* parent, const UString& text) :
 
 void ts::xml::Unknown::print(TextFormatter& output, bool keepNodeOpen) const
 {
-    output << "<!" << _value.toHTML(u"<>") << ">";
+    output << "<!";
+    PrintHTML(output, _value, u"<>");
+    output << ">";
 }
 
 
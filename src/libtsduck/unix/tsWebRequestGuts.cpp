@@ -221,6 +221,17 @@ bool ts::WebRequest::SystemGuts::init()
         status = ::curl_easy_setopt(_curl, CURLOPT_NOPROGRESS, 0L);
     }
 
+    // Set the timeouts. The reception timeout is implemented as "less than one byte per second" during that time.
+    if (status == ::CURLE_OK && _request._connectionTimeout > 0) {
+        status = ::curl_easy_setopt(_curl, CURLOPT_CONNECTTIMEOUT_MS, long(_request._connectionTimeout));
+    }
+    if (status == ::CURLE_OK && _request._receiveTimeout > 0) {
+        status = ::curl_easy_setopt(_curl, CURLOPT_LOW_SPEED_LIMIT, 1L);
+        if (status == ::CURLE_OK) {
+            status = ::curl_easy_setopt(_curl, CURLOPT_LOW_SPEED_TIME, long((_request._receiveTimeout + MilliSecPerSec - 1) / MilliSecPerSec));
+        }
+    }
+
     // Always follow redirections.
     if (status == ::CURLE_OK) {
         status = ::curl_easy_setopt(_curl, CURLOPT_FOLLOWLOCATION, _request._autoRedirect ? 1L : 0L);
@@ -283,7 +294,8 @@ bool ts::WebRequest::SystemGuts::start()
     const ::CURLcode status = ::curl_easy_perform(_curl);
     const bool ok = status == ::CURLE_OK;
 
-    if (!ok) {
+    // An interruption by the application is not an error.
+    if (!ok && !_request._interrupted) {
         _request._report.error(message(u"download error", status));
     }
 
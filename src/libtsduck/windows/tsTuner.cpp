@@ -74,6 +74,7 @@ ts::Tuner::Tuner(const UString& device_name) :
     _signal_timeout_silent(false),
     _receive_timeout(0),
     _delivery_systems(),
+    _pid_filter(AllPIDs),
     _sink_queue_size(DEFAULT_SINK_QUEUE_SIZE),
     _graph(),
     _sink_filter(),
@@ -590,6 +591,22 @@ bool ts::Tuner::start(Report& report)
 }
 
 
+//-----------------------------------------------------------------------------
+// Set the PID's to receive.
+//-----------------------------------------------------------------------------
+
+bool ts::Tuner::setPIDFilter(const PIDSet& pids, Report& report)
+{
+    // The DirectShow graph always delivers the full transport stream.
+    if (!pids.all()) {
+        report.error(u"hardware PID filtering is not supported on Windows tuners");
+        return false;
+    }
+    _pid_filter = pids;
+    return true;
+}
+
+
 //-----------------------------------------------------------------------------
 // Stop receiving packets.
 // Return true on success, false on errors
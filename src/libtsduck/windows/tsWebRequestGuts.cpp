@@ -181,6 +181,20 @@ bool ts::WebRequest::SystemGuts::init()
         return false;
     }
 
+    // Specify the timeouts, if provided.
+    ::DWORD timeout = ::DWORD(_request._connectionTimeout);
+    if (timeout > 0 && !::InternetSetOptionW(_inet, INTERNET_OPTION_CONNECT_TIMEOUT, &timeout, ::DWORD(sizeof(timeout)))) {
+        error(u"error setting connection timeout");
+        clear();
+        return false;
+    }
+    timeout = ::DWORD(_request._receiveTimeout);
+    if (timeout > 0 && !::InternetSetOptionW(_inet, INTERNET_OPTION_RECEIVE_TIMEOUT, &timeout, ::DWORD(sizeof(timeout)))) {
+        error(u"error setting receive timeout");
+        clear();
+        return false;
+    }
+
     // Specify the proxy authentication, if provided.
     if (useProxy) {
         UString user(_request.proxyUser());
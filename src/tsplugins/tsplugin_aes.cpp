@@ -48,6 +48,7 @@
 #include "tsCTS2.h"
 #include "tsCTS3.h"
 #include "tsCTS4.h"
+#include "tsCTR.h"
 #include "tsDVS042.h"
 TSDUCK_SOURCE;
 
@@ -64,6 +65,7 @@ namespace ts {
         AESPlugin(TSP*);
         virtual bool start() override;
         virtual Status processPacket(TSPacket&, bool&, bool&) override;
+        virtual size_t processPacketBatch(const TSPacketView&, TSPacketMetadata*, size_t, Status*, bool&, bool&) override;
 
     private:
         // Private data
@@ -79,7 +81,12 @@ namespace ts {
         CTS3<AES>       _cts3;            // AES cipher in ECB-CTS mode
         CTS4<AES>       _cts4;            // AES cipher in ECB-CTS mode (ST version)
         DVS042<AES>     _dvs042;          // AES cipher in DVS 042 mode
+        CTR<AES>        _ctr;             // AES cipher in CTR mode
         CipherChaining* _chain;           // Selected cipher chaining mode
+        uint64_t        _ctr_offset;      // CTR mode: counter offset of the next payload from the IV
+        bool            _batching;        // Inside processPacketBatch(), payloads are batched
+        std::vector<uint8_t*> _batch_data;  // Batched payloads
+        std::vector<size_t>   _batch_sizes; // Batched payload sizes
 
         // Invoked by the demux when a complete table is available.
         virtual void handleTable(SectionDemux&, const BinaryTable&) override;
@@ -118,10 +125,17 @@ ts::AESPlugin::AESPlugin(TSP* tsp_) :
     _cts3(),
     _cts4(),
     _dvs042(),
-    _chain(0)
+    _ctr(),
+    _chain(0),
+    _ctr_offset(0),
+    _batching(false),
+    _batch_data(),
+    _batch_sizes()
 {
     option(u"",            0,  STRING, 0, 1);
     option(u"cbc",         0);
+    option(u"counter-bits", 0, INTEGER, 0, 1, 1, 128);
+    option(u"ctr",         0);
     option(u"cts1",        0);
     option(u"cts2",        0);
     option(u"cts3",        0);
@@ -146,6 +160,22 @@ ts::AESPlugin::AESPlugin(TSP* tsp_) :
             u"      Use Cipher Block Chaining (CBC) mode without padding. The residue (last\n"
             u"      part of the packet payload, shorter than 16 bytes) is left clear.\n"
             u"\n"
+            u"  --counter-bits value\n"
+            u"      With --ctr, specifies the number of least significant bits of the counter\n"
+            u"      block which are incremented. The other bits are a fixed nonce. By default,\n"
+            u"      the full 128-bit counter block is incremented. The counter must be large\n"
+            u"      enough to never wrap during the stream (12 blocks per TS packet), the\n"
+            u"      keystream would be reused otherwise.\n"
+            u"\n"
+            u"  --ctr\n"
+            u"      Use Counter (CTR) mode, as defined in NIST SP 800-38A. The IV is the\n"
+            u"      initial counter block. The complete payload is scrambled, including the\n"
+            u"      residue. The counter continues from one packet to the next: a payload\n"
+            u"      starts at the counter block which follows the last block of the previous\n"
+            u"      scrambled payload. Therefore, the descrambler must receive the complete\n"
+            u"      sequence of scrambled packets, from the beginning and without loss. The\n"
+            u"      IV is a nonce: the same key and IV must never be used for two streams.\n"
+            u"\n"
             u"  --cts1\n"
             u"      Use Cipher Text Stealing (CTS) mode, as defined by Bruce Schneier in its\n"
             u"      \"Applied Cryptography\" and by RFC 2040 as RC5-CTS. TS packets with a\n"
@@ -215,8 +245,12 @@ bool ts::AESPlugin::start()
     }
 
     // Get chaining mode.
-    if (present(u"ecb") + present(u"cbc") + present(u"cts1") + present(u"cts2") + present(u"cts3") + present(u"cts4") + present(u"dvs042") > 1) {
-        tsp->error(u"options --cbc, --cts1, --cts2, --cts3, --cts4, --dvs042 and --ecb are mutually exclusive");
+    if (present(u"ecb") + present(u"cbc") + present(u"cts1") + present(u"cts2") + present(u"cts3") + present(u"cts4") + present(u"dvs042") + present(u"ctr") > 1) {
+        tsp->error(u"options --cbc, --ctr, --cts1, --cts2, --cts3, --cts4, --dvs042 and --ecb are mutually exclusive");
+        return false;
+    }
+    if (present(u"counter-bits") && !present(u"ctr")) {
+        tsp->error(u"option --counter-bits is valid with --ctr only");
         return false;
     }
     if (present(u"cbc")) {
@@ -237,6 +271,10 @@ bool ts::AESPlugin::start()
     else if (present(u"dvs042")) {
         _chain = &_dvs042;
     }
+    else if (present(u"ctr")) {
+        _ctr.setCounterBits(intValue<size_t>(u"counter-bits", 0));
+        _chain = &_ctr;
+    }
     else {
         _chain = &_ecb;
     }
@@ -284,6 +322,7 @@ bool ts::AESPlugin::start()
 
     // Reset other states
     _abort = false;
+    _ctr_offset = 0;
 
     return true;
 }
@@ -448,6 +487,20 @@ ts::ProcessorPlugin::Status ts::AESPlugin::processPacket (TSPacket& pkt, bool& f
         return TSP_OK;
     }
 
+    // In batch mode, the payload is (de)scrambled later with all other payloads of the batch.
+    if (_batching) {
+        _batch_data.push_back(pl);
+        _batch_sizes.push_back(pl_size);
+        pkt.setScrambling(uint8_t(_descramble ? SC_CLEAR : SC_EVEN_KEY));
+        return TSP_OK;
+    }
+
+    // In CTR mode, each payload uses its own counter blocks, following the previous payload.
+    if (_chain == &_ctr) {
+        _ctr.setCounterOffset(_ctr_offset);
+        _ctr_offset += _ctr.counterBlocks(pl_size);
+    }
+
     // Now (de)scramble the packet
     uint8_t tmp[PKT_SIZE];
     assert (pl_size < sizeof(tmp));
@@ -470,3 +523,38 @@ ts::ProcessorPlugin::Status ts::AESPlugin::processPacket (TSPacket& pkt, bool& f
 
     return TSP_OK;
 }
+
+
+//----------------------------------------------------------------------------
+// Batch packet processing method: all payloads of the batch are (de)scrambled
+// at once, interleaving the independent cipher chains of the packets.
+//----------------------------------------------------------------------------
+
+size_t ts::AESPlugin::processPacketBatch(const TSPacketView& pkts, TSPacketMetadata* mdata, size_t count, Status* status, bool& flush, bool& bitrate_changed)
+{
+    _batching = true;
+    _batch_data.clear();
+    _batch_sizes.clear();
+    size_t result = ProcessorPlugin::processPacketBatch(pkts, mdata, count, status, flush, bitrate_changed);
+    _batching = false;
+
+    if (!_batch_data.empty()) {
+        // In CTR mode, the payloads of the batch use consecutive counter blocks, following the previous payload.
+        if (_chain == &_ctr) {
+            _ctr.setCounterOffset(_ctr_offset);
+            for (size_t i = 0; i < _batch_sizes.size(); ++i) {
+                _ctr_offset += _ctr.counterBlocks(_batch_sizes[i]);
+            }
+        }
+        const bool ok = _descramble ?
+            _chain->decryptMessages(_batch_data.data(), _batch_sizes.data(), _batch_data.size()) :
+            _chain->encryptMessages(_batch_data.data(), _batch_sizes.data(), _batch_data.size());
+        if (!ok) {
+            tsp->error(u"AES %s error", {_descramble ? u"decrypt" : u"encrypt"});
+            // Packets are left in an undefined state, stop at the first one.
+            status[0] = TSP_END;
+            result = 1;
+        }
+    }
+    return result;
+}
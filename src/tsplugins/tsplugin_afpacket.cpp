@@ -0,0 +1,967 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  Transport stream processor shared library:
+//  Capture UDP/IP datagrams from a memory-mapped packet ring (Linux only).
+//
+//----------------------------------------------------------------------------
+
+#include "tsPlugin.h"
+#include "tsPluginRepository.h"
+#include "tsIPUtils.h"
+#include "tsUDPSocket.h"
+#include "tsThread.h"
+#include "tsGuardCondition.h"
+#include "tsSysUtils.h"
+#include "tsSysInfo.h"
+#include "tsNullReport.h"
+#if defined(TS_LINUX)
+#include <linux/if_packet.h>
+#include <linux/if_ether.h>
+#include <linux/filter.h>
+#endif
+TSDUCK_SOURCE;
+
+// Memory-mapped reception ring
+
+#define DEF_BLOCK_SIZE   (1024 * 1024)  // Size in bytes of a ring block
+#define DEF_BLOCK_COUNT     64          // Number of blocks in a ring
+#define RING_FRAME_SIZE   2048          // Nominal frame size, frames have a variable size in TPACKET_V3
+#define BLOCK_TIMEOUT       10          // Milliseconds before a partially filled block is returned
+#define POLL_TIMEOUT       100          // Poll timeout in milliseconds, to check abort requests
+
+// Destinations and fanout
+
+#define MAX_DESTINATIONS   512          // Maximum number of destination address:port
+#define MAX_FANOUT          64          // Maximum number of capture threads
+#define QUEUE_PACKETS    65536          // Number of TS packets in the queue of the capture threads
+
+// Protocol headers
+
+#define IPv4_MIN_HEADER_SIZE  20
+#define UDP_HEADER_SIZE        8
+#define IP_PROTO_UDP          17
+
+
+//----------------------------------------------------------------------------
+// Plugin definition
+//----------------------------------------------------------------------------
+
+namespace ts {
+    class AFPacketInput: public InputPlugin
+    {
+    public:
+        // Implementation of plugin API
+        AFPacketInput(TSP*);
+        virtual ~AFPacketInput();
+        virtual bool start() override;
+        virtual bool stop() override;
+        virtual size_t receive(TSPacket*, size_t) override;
+        virtual size_t receiveWithMetadata(TSPacket*, TSPacketMetadata*, size_t) override;
+
+#if defined(TS_LINUX)
+    private:
+        // One packet socket with its memory-mapped reception ring.
+        class Ring
+        {
+        public:
+            // Constructor and destructor.
+            Ring(AFPacketInput* plugin);
+            ~Ring();
+
+            // Open the socket and map the ring.
+            bool open(int ifindex, int fanout_id);
+
+            // Close the socket and unmap the ring.
+            void close();
+
+            // Get the next TS packets from the ring. The packets remain valid until the next call.
+            // If wait is true, wait at most POLL_TIMEOUT milliseconds. Count is zero when no
+            // packet is available. Return false on error.
+            bool next(const uint8_t*& data, size_t& count, NanoSecond& time, uint16_t& source, bool wait);
+
+            // Add the kernel packet and drop counts since last call and the number of spurious datagrams.
+            void getStatistics(PacketCounter& packets, PacketCounter& drops, PacketCounter& spurious);
+
+        private:
+            AFPacketInput* _plugin;        // Parent plugin
+            int            _fd;            // Packet socket
+            uint8_t*       _map;           // Memory-mapped ring
+            size_t         _block_index;   // Index of the current block
+            ::tpacket_block_desc* _block;  // Current block, owned by the application, if not null
+            uint32_t       _frame_remain;  // Number of remaining frames in current block
+            uint8_t*       _frame;         // Next frame in current block
+            PacketCounter  _spurious;      // Datagrams without TS packets
+
+            // Inaccessible operations
+            Ring() = delete;
+            Ring(const Ring&) = delete;
+            Ring& operator=(const Ring&) = delete;
+        };
+        typedef SafePtr<Ring, NullMutex> RingPtr;
+        typedef std::vector<RingPtr> RingVector;
+
+        // Capture thread, one per ring in fanout mode.
+        class Reader: public Thread
+        {
+        public:
+            Reader(AFPacketInput* plugin, Ring* ring);
+            virtual ~Reader() override;
+        private:
+            AFPacketInput* _plugin;
+            Ring*          _ring;
+            virtual void main() override;
+
+            // Inaccessible operations
+            Reader() = delete;
+            Reader(const Reader&) = delete;
+            Reader& operator=(const Reader&) = delete;
+        };
+        typedef SafePtr<Reader, NullMutex> ReaderPtr;
+        typedef std::vector<ReaderPtr> ReaderVector;
+
+        // Expected destinations: index of a destination, indexed by address and port.
+        typedef std::map<uint64_t, uint16_t> DestinationMap;
+
+        // Command line options.
+        UString        _interface;       // Capture interface name, empty means all
+        size_t         _block_size;      // Size of a ring block
+        size_t         _block_count;     // Number of blocks in a ring
+        size_t         _fanout;          // Number of rings and capture threads, zero means no thread
+        bool           _promiscuous;     // Set interface in promiscuous mode
+        bool           _no_join;         // Do not join multicast groups
+
+        // Working data.
+        std::vector<SocketAddress> _destinations;  // Expected destinations address:port
+        DestinationMap _dest_map;        // Expected destinations, for analysis
+        std::vector< ::sock_filter> _filter;  // BPF filter program
+        UDPSocket      _join_sock;       // Socket which joins multicast groups
+        RingVector     _rings;           // All capture rings
+        ReaderVector   _readers;         // Capture threads in fanout mode
+        PacketCounter  _kernel_packets;  // Packets which were captured by the kernel
+        PacketCounter  _kernel_drops;    // Packets which were dropped by the kernel, ring full
+        PacketCounter  _spurious;        // Datagrams from the ring without TS packets
+
+        // Current datagram, without capture thread.
+        const uint8_t* _inbuf_next;      // Address of next TS packet to return
+        size_t         _inbuf_count;     // Remaining TS packets in current datagram
+        NanoSecond     _inbuf_time;      // Kernel capture time of current datagram
+        uint16_t       _inbuf_source;    // Index of the destination of current datagram
+
+        // Packet queue, filled by the capture threads.
+        Mutex          _mutex;           // Protect the following fields
+        Condition      _got_packets;     // Signaled when packets are added in the queue
+        Condition      _got_space;       // Signaled when packets are removed from the queue
+        TSPacketVector _queue;           // Queued TS packets
+        std::vector<NanoSecond> _queue_time;    // Capture time of queued packets
+        std::vector<uint16_t>   _queue_source;  // Destination index of queued packets
+        size_t         _queue_first;     // Index of first queued packet
+        size_t         _queue_count;     // Number of queued packets
+        size_t         _running;         // Number of running capture threads
+        bool           _terminate;       // Request termination of capture threads
+        bool           _queue_error;     // A capture thread got an error
+
+        // Build the BPF filter program.
+        void buildFilter();
+
+        // Analyze an IP datagram from the ring, return false if there is no TS packet to return.
+        bool analyzeDatagram(const uint8_t* ip, size_t size, const uint8_t*& data, size_t& count, uint16_t& source) const;
+
+        // Add TS packets in the queue, from a capture thread. Return false on termination.
+        bool pushPackets(const uint8_t* data, size_t count, NanoSecond time, uint16_t source);
+
+        // Get TS packets from the queue, return zero on error or abort.
+        size_t pullPackets(TSPacket* buffer, TSPacketMetadata* mdata, size_t max_packets);
+
+        // Stop all capture threads and close all rings.
+        void closeRings();
+
+        // Destination map key.
+        static uint64_t DestinationKey(uint32_t addr, uint16_t port) { return (uint64_t(addr) << 16) | port; }
+#endif
+
+    private:
+        // Inaccessible operations
+        AFPacketInput() = delete;
+        AFPacketInput(const AFPacketInput&) = delete;
+        AFPacketInput& operator=(const AFPacketInput&) = delete;
+    };
+}
+
+TSPLUGIN_DECLARE_VERSION
+TSPLUGIN_DECLARE_INPUT(afpacket, ts::AFPacketInput)
+
+
+//----------------------------------------------------------------------------
+// Constructor
+//----------------------------------------------------------------------------
+
+ts::AFPacketInput::AFPacketInput(TSP* tsp_) :
+    InputPlugin(tsp_, u"Capture TS packets in UDP/IP datagrams from a memory-mapped packet ring (Linux only).", u"[options] [address:]port ...")
+#if defined(TS_LINUX)
+    ,
+    _interface(),
+    _block_size(DEF_BLOCK_SIZE),
+    _block_count(DEF_BLOCK_COUNT),
+    _fanout(0),
+    _promiscuous(false),
+    _no_join(false),
+    _destinations(),
+    _dest_map(),
+    _filter(),
+    _join_sock(false, *tsp_),
+    _rings(),
+    _readers(),
+    _kernel_packets(0),
+    _kernel_drops(0),
+    _spurious(0),
+    _inbuf_next(0),
+    _inbuf_count(0),
+    _inbuf_time(-1),
+    _inbuf_source(0),
+    _mutex(),
+    _got_packets(),
+    _got_space(),
+    _queue(),
+    _queue_time(),
+    _queue_source(),
+    _queue_first(0),
+    _queue_count(0),
+    _running(0),
+    _terminate(false),
+    _queue_error(false)
+#endif
+{
+    option(u"",               0,  STRING, 1, MAX_DESTINATIONS);
+    option(u"block-count",    0,  INTEGER, 0, 1, 2, 65536);
+    option(u"block-size",     0,  INTEGER, 0, 1, 4096, 256 * 1024 * 1024);
+    option(u"fanout",         0,  INTEGER, 0, 1, 1, MAX_FANOUT);
+    option(u"interface",     'i', STRING);
+    option(u"local-address", 'l', STRING);
+    option(u"no-join",        0);
+    option(u"promiscuous",   'p');
+
+    setHelp(u"Parameters:\n"
+            u"  Each parameter [address:]port describes the destination of UDP datagrams\n"
+            u"  to capture. The 'port' part is mandatory. The optional 'address' part is\n"
+            u"  a destination IP address, usually multicast. Without address, all UDP\n"
+            u"  datagrams to that port are captured. Up to " TS_USTRINGIFY(MAX_DESTINATIONS) u" destinations can be\n"
+            u"  specified. Each packet is tagged in its metadata with the index of its\n"
+            u"  destination, starting at zero in the order of the parameters.\n"
+            u"\n"
+            u"  The datagrams are captured by the kernel into a memory-mapped ring, using\n"
+            u"  AF_PACKET sockets (TPACKET_V3) and a kernel filter on the destinations.\n"
+            u"  They do not go through the UDP socket layer. This plugin needs the\n"
+            u"  CAP_NET_RAW capability and is available on Linux only. IP fragments are\n"
+            u"  ignored.\n"
+            u"\n"
+            u"Options:\n"
+            u"\n"
+            u"  --block-count value\n"
+            u"      Number of blocks in the capture ring. The default is " TS_USTRINGIFY(DEF_BLOCK_COUNT) u".\n"
+            u"\n"
+            u"  --block-size value\n"
+            u"      Size in bytes of each block in the capture ring. It is rounded up to a\n"
+            u"      multiple of the memory page size. The default is " + UString::Decimal(DEF_BLOCK_SIZE) + u" bytes.\n"
+            u"\n"
+            u"  --fanout value\n"
+            u"      Capture using several rings, each of them with its own thread. The\n"
+            u"      kernel distributes the datagrams over the rings according to their\n"
+            u"      flow, the packets of each UDP stream remain in sequence. The value is\n"
+            u"      the number of rings and threads, up to " TS_USTRINGIFY(MAX_FANOUT) u". By default, there is one\n"
+            u"      single ring which is read by the input plugin thread.\n"
+            u"\n"
+            u"  --help\n"
+            u"      Display this help text.\n"
+            u"\n"
+            u"  -i name\n"
+            u"  --interface name\n"
+            u"      Name of the network interface to capture from. By default, capture from\n"
+            u"      all interfaces.\n"
+            u"\n"
+            u"  -l address\n"
+            u"  --local-address address\n"
+            u"      Specify the IP address of the local interface on which multicast groups\n"
+            u"      are joined. By default, the system selects the interface.\n"
+            u"\n"
+            u"  --no-join\n"
+            u"      Do not join the multicast groups. This is typically used on monitoring\n"
+            u"      ports where the traffic is mirrored by a switch. By default, multicast\n"
+            u"      destinations are joined.\n"
+            u"\n"
+            u"  -p\n"
+            u"  --promiscuous\n"
+            u"      Set the interface in promiscuous mode, during the capture only. Requires\n"
+            u"      --interface.\n"
+            u"\n"
+            u"  --version\n"
+            u"      Display the version number.\n");
+}
+
+
+//----------------------------------------------------------------------------
+// Destructor
+//----------------------------------------------------------------------------
+
+ts::AFPacketInput::~AFPacketInput()
+{
+#if defined(TS_LINUX)
+    closeRings();
+#endif
+}
+
+
+//----------------------------------------------------------------------------
+// Input method, without metadata
+//----------------------------------------------------------------------------
+
+size_t ts::AFPacketInput::receive(TSPacket* buffer, size_t max_packets)
+{
+    return receiveWithMetadata(buffer, 0, max_packets);
+}
+
+
+#if !defined(TS_LINUX)
+
+//----------------------------------------------------------------------------
+// Stubs on unsupported platforms.
+//----------------------------------------------------------------------------
+
+bool ts::AFPacketInput::start()
+{
+    tsp->error(u"the afpacket plugin is available on Linux only");
+    return false;
+}
+
+bool ts::AFPacketInput::stop()
+{
+    return true;
+}
+
+size_t ts::AFPacketInput::receiveWithMetadata(TSPacket* buffer, TSPacketMetadata* mdata, size_t max_packets)
+{
+    return 0;
+}
+
+#else
+
+//----------------------------------------------------------------------------
+// Start method
+//----------------------------------------------------------------------------
+
+bool ts::AFPacketInput::start()
+{
+    // Get command line arguments
+    UStringVector destinations;
+    getValues(destinations, u"");
+    getValue(_interface, u"interface");
+    const UString local(value(u"local-address"));
+    _block_count = intValue<size_t>(u"block-count", DEF_BLOCK_COUNT);
+    _block_size = intValue<size_t>(u"block-size", DEF_BLOCK_SIZE);
+    _fanout = intValue<size_t>(u"fanout", 0);
+    _promiscuous = present(u"promiscuous");
+    _no_join = present(u"no-join");
+
+    if (_promiscuous && _interface.empty()) {
+        tsp->error(u"--promiscuous requires --interface");
+        return false;
+    }
+
+    // The ring block size must be a multiple of the page size.
+    const size_t page = SysInfo::Instance()->memoryPageSize();
+    _block_size = page * ((_block_size + page - 1) / page);
+
+    // Analyze the destinations.
+    _destinations.clear();
+    _dest_map.clear();
+    for (size_t i = 0; i < destinations.size(); ++i) {
+        SocketAddress dest;
+        if (!dest.resolve(destinations[i], *tsp)) {
+            return false;
+        }
+        if (!dest.hasPort()) {
+            tsp->error(u"no UDP port specified in %s", {destinations[i]});
+            return false;
+        }
+        const uint64_t key = DestinationKey(dest.hasAddress() ? dest.address() : 0, dest.port());
+        if (_dest_map.find(key) != _dest_map.end()) {
+            tsp->error(u"duplicate destination %s", {destinations[i]});
+            return false;
+        }
+        _dest_map[key] = uint16_t(i);
+        _destinations.push_back(dest);
+    }
+
+    // Interface index, zero means all interfaces.
+    int ifindex = 0;
+    if (!_interface.empty() && (ifindex = int(::if_nametoindex(_interface.toUTF8().c_str()))) == 0) {
+        tsp->error(u"unknown interface %s", {_interface});
+        return false;
+    }
+
+    // Join multicast groups on a UDP socket which is bound to an ephemeral port.
+    // The socket receives no datagram, the joined groups make the traffic reach the interface.
+    if (!_no_join) {
+        IPAddress local_ip;
+        if (!local.empty() && !local_ip.resolve(local, *tsp)) {
+            return false;
+        }
+        bool joined = false;
+        for (size_t i = 0; i < _destinations.size(); ++i) {
+            if (_destinations[i].hasAddress() && _destinations[i].isMulticast()) {
+                if (!joined && (!_join_sock.open(*tsp) || !_join_sock.bind(SocketAddress(), *tsp))) {
+                    _join_sock.close(NULLREP);
+                    return false;
+                }
+                joined = true;
+                if (!_join_sock.addMembership(_destinations[i], local_ip, *tsp)) {
+                    _join_sock.close(NULLREP);
+                    return false;
+                }
+            }
+        }
+    }
+
+    // Build the kernel filter and open all rings.
+    buildFilter();
+    const int fanout_id = int(::getpid() & 0xFFFF);
+    _kernel_packets = _kernel_drops = _spurious = 0;
+    for (size_t i = 0; i < std::max<size_t>(_fanout, 1); ++i) {
+        _rings.push_back(RingPtr(new Ring(this)));
+        if (!_rings.back()->open(ifindex, _fanout > 0 ? fanout_id : -1)) {
+            closeRings();
+            return false;
+        }
+    }
+
+    // Start the capture threads in fanout mode.
+    _inbuf_next = 0;
+    _inbuf_count = 0;
+    _inbuf_time = -1;
+    _inbuf_source = 0;
+    _queue.resize(_fanout > 0 ? QUEUE_PACKETS : 0);
+    _queue_time.resize(_queue.size());
+    _queue_source.resize(_queue.size());
+    _queue_first = _queue_count = 0;
+    _running = 0;
+    _terminate = _queue_error = false;
+    for (size_t i = 0; i < _fanout; ++i) {
+        _readers.push_back(ReaderPtr(new Reader(this, _rings[i].pointer())));
+        Guard lock(_mutex);
+        if (!_readers.back()->start()) {
+            tsp->error(u"error starting capture thread");
+            _readers.pop_back();
+            _terminate = true;
+            break;
+        }
+        _running++;
+    }
+    if (_terminate) {
+        closeRings();
+        return false;
+    }
+
+    tsp->verbose(u"capturing from %s, %d ring(s) of %'d bytes", {_interface.empty() ? u"all interfaces" : _interface, _rings.size(), _block_size * _block_count});
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Stop method
+//----------------------------------------------------------------------------
+
+bool ts::AFPacketInput::stop()
+{
+    closeRings();
+    _join_sock.close(NULLREP);
+    tsp->verbose(u"kernel captured %'d datagrams, dropped %'d, %'d without TS packets", {_kernel_packets, _kernel_drops, _spurious});
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Stop all capture threads and close all rings.
+//----------------------------------------------------------------------------
+
+void ts::AFPacketInput::closeRings()
+{
+    {
+        GuardCondition lock(_mutex, _got_space);
+        _terminate = true;
+        lock.signal();
+    }
+    for (size_t i = 0; i < _readers.size(); ++i) {
+        _readers[i]->waitForTermination();
+    }
+    _readers.clear();
+    for (size_t i = 0; i < _rings.size(); ++i) {
+        _rings[i]->getStatistics(_kernel_packets, _kernel_drops, _spurious);
+        _rings[i]->close();
+    }
+    _rings.clear();
+}
+
+
+//----------------------------------------------------------------------------
+// Build the BPF filter program.
+//----------------------------------------------------------------------------
+
+void ts::AFPacketInput::buildFilter()
+{
+    // The packet sockets are SOCK_DGRAM, the filter sees the packet from the IP header.
+    // All jumps are local, the offsets must fit in 8 bits.
+    _filter.clear();
+
+    // Ignore outgoing packets, they are seen twice on the loopback interface.
+    _filter.push_back(BPF_STMT(BPF_LD | BPF_W | BPF_ABS, uint32_t(SKF_AD_OFF + SKF_AD_PKTTYPE)));
+    _filter.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, PACKET_OUTGOING, 0, 1));
+    _filter.push_back(BPF_STMT(BPF_RET | BPF_K, 0));
+
+    // Only UDP, no fragment (offset or more fragment flag).
+    _filter.push_back(BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 9));
+    _filter.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IP_PROTO_UDP, 1, 0));
+    _filter.push_back(BPF_STMT(BPF_RET | BPF_K, 0));
+    _filter.push_back(BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 6));
+    _filter.push_back(BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, 0x3FFF, 0, 1));
+    _filter.push_back(BPF_STMT(BPF_RET | BPF_K, 0));
+
+    // X = IP header size.
+    _filter.push_back(BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, 0));
+
+    // One block per destination, accept on match.
+    for (size_t i = 0; i < _destinations.size(); ++i) {
+        const SocketAddress& dest(_destinations[i]);
+        if (dest.hasAddress()) {
+            _filter.push_back(BPF_STMT(BPF_LD | BPF_W | BPF_ABS, 16));
+            _filter.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, dest.address(), 0, 3));
+        }
+        _filter.push_back(BPF_STMT(BPF_LD | BPF_H | BPF_IND, 2));
+        _filter.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, dest.port(), 0, 1));
+        _filter.push_back(BPF_STMT(BPF_RET | BPF_K, 0xFFFFFFFF));
+    }
+
+    // No match, drop.
+    _filter.push_back(BPF_STMT(BPF_RET | BPF_K, 0));
+}
+
+
+//----------------------------------------------------------------------------
+// Analyze an IP datagram from the ring.
+//----------------------------------------------------------------------------
+
+bool ts::AFPacketInput::analyzeDatagram(const uint8_t* ip, size_t size, const uint8_t*& data, size_t& count, uint16_t& source) const
+{
+    // The kernel filter already checked the protocol and the destination.
+    // Check the header sizes and find the destination index.
+    const size_t ip_header_size = size < IPv4_MIN_HEADER_SIZE ? 0 : 4 * size_t(ip[0] & 0x0F);
+    if (ip_header_size < IPv4_MIN_HEADER_SIZE || size < ip_header_size + UDP_HEADER_SIZE) {
+        return false;
+    }
+    size = std::min<size_t>(size, GetUInt16(ip + 2));
+    const uint32_t addr = GetUInt32(ip + 16);
+    const uint16_t port = GetUInt16(ip + ip_header_size + 2);
+
+    DestinationMap::const_iterator it(_dest_map.find(DestinationKey(addr, port)));
+    if (it == _dest_map.end()) {
+        it = _dest_map.find(DestinationKey(0, port));
+    }
+    if (it == _dest_map.end()) {
+        return false;
+    }
+
+    // Locate the TS packets in the UDP payload.
+    const uint8_t* const payload = ip + ip_header_size + UDP_HEADER_SIZE;
+    size_t start = 0;
+    if (size < ip_header_size + UDP_HEADER_SIZE || !TSPacket::Locate(payload, size - ip_header_size - UDP_HEADER_SIZE, start, count)) {
+        return false;
+    }
+    data = payload + start;
+    source = it->second;
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Input method
+//----------------------------------------------------------------------------
+
+size_t ts::AFPacketInput::receiveWithMetadata(TSPacket* buffer, TSPacketMetadata* mdata, size_t max_packets)
+{
+    // In fanout mode, get packets from the queue of the capture threads.
+    if (_fanout > 0) {
+        return pullPackets(buffer, mdata, max_packets);
+    }
+
+    // Without capture thread, get packets directly from the ring.
+    size_t pkt_cnt = 0;
+    while (pkt_cnt < max_packets) {
+        if (_inbuf_count > 0) {
+            // Return packets from the current datagram.
+            const size_t count = std::min(_inbuf_count, max_packets - pkt_cnt);
+            ::memcpy(buffer[pkt_cnt].b, _inbuf_next, count * PKT_SIZE);
+            if (mdata != 0) {
+                for (size_t i = 0; i < count; ++i) {
+                    mdata[pkt_cnt + i].setInputTimeStamp(_inbuf_time);
+                    mdata[pkt_cnt + i].setInputSource(_inbuf_source);
+                }
+            }
+            pkt_cnt += count;
+            _inbuf_count -= count;
+            _inbuf_next += count * PKT_SIZE;
+        }
+        else if (!_rings[0]->next(_inbuf_next, _inbuf_count, _inbuf_time, _inbuf_source, pkt_cnt == 0)) {
+            // Capture error.
+            return 0;
+        }
+        else if (_inbuf_count == 0 && (pkt_cnt > 0 || tsp->aborting())) {
+            // Nothing more is immediately available or abort requested.
+            break;
+        }
+    }
+    return pkt_cnt;
+}
+
+
+//----------------------------------------------------------------------------
+// Add TS packets in the queue, from a capture thread.
+//----------------------------------------------------------------------------
+
+bool ts::AFPacketInput::pushPackets(const uint8_t* data, size_t count, NanoSecond time, uint16_t source)
+{
+    GuardCondition lock(_mutex, _got_space);
+    while (count > 0) {
+        // Wait for free space in the queue.
+        while (!_terminate && _queue_count >= _queue.size()) {
+            lock.waitCondition();
+        }
+        if (_terminate) {
+            return false;
+        }
+        // Copy as many packets as possible in the free contiguous area.
+        const size_t next = (_queue_first + _queue_count) % _queue.size();
+        const size_t n = std::min(count, std::min(_queue.size() - _queue_count, _queue.size() - next));
+        ::memcpy(_queue[next].b, data, n * PKT_SIZE);
+        for (size_t i = 0; i < n; ++i) {
+            _queue_time[next + i] = time;
+            _queue_source[next + i] = source;
+        }
+        _queue_count += n;
+        data += n * PKT_SIZE;
+        count -= n;
+        _got_packets.signal();
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Get TS packets from the queue.
+//----------------------------------------------------------------------------
+
+size_t ts::AFPacketInput::pullPackets(TSPacket* buffer, TSPacketMetadata* mdata, size_t max_packets)
+{
+    GuardCondition lock(_mutex, _got_packets);
+
+    // Wait for packets, with a timeout to check abort requests.
+    while (_queue_count == 0) {
+        if (tsp->aborting() || _queue_error || _running == 0) {
+            return 0;
+        }
+        lock.waitCondition(POLL_TIMEOUT);
+    }
+
+    // Copy the packets, in two parts when the queue wraps around.
+    size_t pkt_cnt = 0;
+    while (pkt_cnt < max_packets && _queue_count > 0) {
+        const size_t n = std::min(max_packets - pkt_cnt, std::min(_queue_count, _queue.size() - _queue_first));
+        ::memcpy(buffer[pkt_cnt].b, _queue[_queue_first].b, n * PKT_SIZE);
+        if (mdata != 0) {
+            for (size_t i = 0; i < n; ++i) {
+                mdata[pkt_cnt + i].setInputTimeStamp(_queue_time[_queue_first + i]);
+                mdata[pkt_cnt + i].setInputSource(_queue_source[_queue_first + i]);
+            }
+        }
+        pkt_cnt += n;
+        _queue_first = (_queue_first + n) % _queue.size();
+        _queue_count -= n;
+    }
+    _got_space.signal();
+    return pkt_cnt;
+}
+
+
+//----------------------------------------------------------------------------
+// Capture thread.
+//----------------------------------------------------------------------------
+
+ts::AFPacketInput::Reader::Reader(AFPacketInput* plugin, Ring* ring) :
+    Thread(ThreadAttributes().setPriority(ThreadAttributes::GetHighPriority())),
+    _plugin(plugin),
+    _ring(ring)
+{
+}
+
+ts::AFPacketInput::Reader::~Reader()
+{
+    waitForTermination();
+}
+
+void ts::AFPacketInput::Reader::main()
+{
+    const uint8_t* data = 0;
+    size_t count = 0;
+    NanoSecond time = 0;
+    uint16_t source = 0;
+    bool ok = true;
+
+    // Loop until termination or error.
+    while ((ok = _ring->next(data, count, time, source, true)) && (count == 0 || _plugin->pushPackets(data, count, time, source))) {
+        if (count == 0) {
+            Guard lock(_plugin->_mutex);
+            if (_plugin->_terminate) {
+                break;
+            }
+        }
+    }
+
+    GuardCondition lock(_plugin->_mutex, _plugin->_got_packets);
+    _plugin->_queue_error = _plugin->_queue_error || !ok;
+    _plugin->_running--;
+    lock.signal();
+}
+
+
+//----------------------------------------------------------------------------
+// Packet ring.
+//----------------------------------------------------------------------------
+
+ts::AFPacketInput::Ring::Ring(AFPacketInput* plugin) :
+    _plugin(plugin),
+    _fd(-1),
+    _map(0),
+    _block_index(0),
+    _block(0),
+    _frame_remain(0),
+    _frame(0),
+    _spurious(0)
+{
+}
+
+ts::AFPacketInput::Ring::~Ring()
+{
+    close();
+}
+
+// Open the socket and map the ring.
+bool ts::AFPacketInput::Ring::open(int ifindex, int fanout_id)
+{
+    Report& report(*_plugin->tsp);
+    const size_t block_size = _plugin->_block_size;
+    const size_t block_count = _plugin->_block_count;
+
+    // Protocol zero: no packet is received before the ring and the filter are ready.
+    if ((_fd = ::socket(AF_PACKET, SOCK_DGRAM, 0)) < 0) {
+        report.error(u"error creating packet socket: %s", {ErrorCodeMessage()});
+        return false;
+    }
+
+    int version = TPACKET_V3;
+    if (::setsockopt(_fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0) {
+        report.error(u"error setting TPACKET_V3 on packet socket: %s", {ErrorCodeMessage()});
+        close();
+        return false;
+    }
+
+    ::sock_fprog prog;
+    TS_ZERO(prog);
+    prog.len = (unsigned short)(_plugin->_filter.size());
+    prog.filter = &_plugin->_filter[0];
+    if (::setsockopt(_fd, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof(prog)) < 0) {
+        report.error(u"error setting packet filter: %s", {ErrorCodeMessage()});
+        close();
+        return false;
+    }
+
+    ::tpacket_req3 req;
+    TS_ZERO(req);
+    req.tp_block_size = (unsigned int)(block_size);
+    req.tp_block_nr = (unsigned int)(block_count);
+    req.tp_frame_size = RING_FRAME_SIZE;
+    req.tp_frame_nr = (unsigned int)((block_size / RING_FRAME_SIZE) * block_count);
+    req.tp_retire_blk_tov = BLOCK_TIMEOUT;
+    if (::setsockopt(_fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) < 0) {
+        report.error(u"error creating packet ring: %s", {ErrorCodeMessage()});
+        close();
+        return false;
+    }
+
+    void* map = ::mmap(0, block_size * block_count, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_LOCKED, _fd, 0);
+    if (map == MAP_FAILED) {
+        // Locking the ring in memory may exceed the limits, retry without lock.
+        map = ::mmap(0, block_size * block_count, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+    }
+    if (map == MAP_FAILED) {
+        report.error(u"error mapping packet ring: %s", {ErrorCodeMessage()});
+        close();
+        return false;
+    }
+    _map = reinterpret_cast<uint8_t*>(map);
+    _block_index = 0;
+    _block = 0;
+    _frame_remain = 0;
+    _frame = 0;
+
+    // Now start the capture of IP packets.
+    ::sockaddr_ll addr;
+    TS_ZERO(addr);
+    addr.sll_family = AF_PACKET;
+    addr.sll_protocol = htons(ETH_P_IP);
+    addr.sll_ifindex = ifindex;
+    if (::bind(_fd, reinterpret_cast<::sockaddr*>(&addr), sizeof(addr)) < 0) {
+        report.error(u"error binding packet socket: %s", {ErrorCodeMessage()});
+        close();
+        return false;
+    }
+
+    if (_plugin->_promiscuous) {
+        ::packet_mreq mreq;
+        TS_ZERO(mreq);
+        mreq.mr_ifindex = ifindex;
+        mreq.mr_type = PACKET_MR_PROMISC;
+        if (::setsockopt(_fd, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+            report.error(u"error setting promiscuous mode on %s: %s", {_plugin->_interface, ErrorCodeMessage()});
+            close();
+            return false;
+        }
+    }
+
+    // Join the fanout group, the datagrams of a flow always go to the same ring.
+    if (fanout_id >= 0) {
+        int fanout = fanout_id | ((PACKET_FANOUT_HASH | PACKET_FANOUT_FLAG_DEFRAG) << 16);
+        if (::setsockopt(_fd, SOL_PACKET, PACKET_FANOUT, &fanout, sizeof(fanout)) < 0) {
+            report.error(u"error joining packet fanout group: %s", {ErrorCodeMessage()});
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+// Close the socket and unmap the ring.
+void ts::AFPacketInput::Ring::close()
+{
+    if (_map != 0) {
+        ::munmap(_map, _plugin->_block_size * _plugin->_block_count);
+        _map = 0;
+    }
+    if (_fd >= 0) {
+        ::close(_fd);
+        _fd = -1;
+    }
+    _block = 0;
+    _frame_remain = 0;
+    _frame = 0;
+}
+
+// Add the kernel packet and drop counts since last call.
+void ts::AFPacketInput::Ring::getStatistics(PacketCounter& packets, PacketCounter& drops, PacketCounter& spurious)
+{
+    spurious += _spurious;
+    _spurious = 0;
+
+    ::tpacket_stats_v3 stats;
+    ::socklen_t len = sizeof(stats);
+    TS_ZERO(stats);
+    if (_fd >= 0 && ::getsockopt(_fd, SOL_PACKET, PACKET_STATISTICS, &stats, &len) == 0) {
+        // The kernel counts the dropped packets in tp_packets.
+        packets += stats.tp_packets;
+        drops += stats.tp_drops;
+    }
+}
+
+// Get the next TS packets from the ring.
+bool ts::AFPacketInput::Ring::next(const uint8_t*& data, size_t& count, NanoSecond& time, uint16_t& source, bool wait)
+{
+    count = 0;
+
+    for (;;) {
+        // Analyze the remaining frames in the current block.
+        while (_block != 0 && _frame_remain > 0) {
+            const ::tpacket3_hdr* const frame = reinterpret_cast<const ::tpacket3_hdr*>(_frame);
+            _frame += frame->tp_next_offset;
+            _frame_remain--;
+            const uint8_t* const ip = reinterpret_cast<const uint8_t*>(frame) + frame->tp_net;
+            const size_t size = frame->tp_snaplen - (frame->tp_net - frame->tp_mac);
+            if (_plugin->analyzeDatagram(ip, size, data, count, source)) {
+                time = NanoSecond(frame->tp_sec) * NanoSecPerSec + frame->tp_nsec;
+                return true;
+            }
+            _spurious++;
+        }
+
+        // Return the current block to the kernel.
+        if (_block != 0) {
+            MemoryBarrier();
+            _block->hdr.bh1.block_status = TP_STATUS_KERNEL;
+            _block = 0;
+            _block_index = (_block_index + 1) % _plugin->_block_count;
+        }
+
+        // Check if the next block is available.
+        ::tpacket_block_desc* const block = reinterpret_cast<::tpacket_block_desc*>(_map + _block_index * _plugin->_block_size);
+        if ((block->hdr.bh1.block_status & TP_STATUS_USER) != 0) {
+            MemoryBarrier();
+            _block = block;
+            _frame_remain = block->hdr.bh1.num_pkts;
+            _frame = reinterpret_cast<uint8_t*>(block) + block->hdr.bh1.offset_to_first_pkt;
+            continue;
+        }
+        if (!wait) {
+            return true;
+        }
+
+        // Wait for the next block, with a timeout to check abort requests.
+        ::pollfd pfd;
+        TS_ZERO(pfd);
+        pfd.fd = _fd;
+        pfd.events = POLLIN | POLLERR;
+        const int status = ::poll(&pfd, 1, POLL_TIMEOUT);
+        if (status < 0 && errno != EINTR) {
+            _plugin->tsp->error(u"error waiting for packet ring: %s", {ErrorCodeMessage()});
+            return false;
+        }
+        if (status <= 0) {
+            // Timeout, let the caller check termination.
+            return true;
+        }
+        wait = false;
+    }
+}
+
+#endif // TS_LINUX
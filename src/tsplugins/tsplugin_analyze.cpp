@@ -59,6 +59,8 @@ namespace ts {
         std::ostream*     _output;
         MilliSecond       _output_interval;
         bool              _multiple_output;
+        bool              _cumulative;
+        size_t            _prune_idle;
         PacketCounter     _current_packet;
         Time              _next_report_time;
         PacketCounter     _next_report_packet;
@@ -92,20 +94,32 @@ ts::AnalyzePlugin::AnalyzePlugin(TSP* tsp_) :
     _output(),
     _output_interval(0),
     _multiple_output(false),
+    _cumulative(false),
+    _prune_idle(0),
     _current_packet(0),
     _next_report_time(Time::Epoch),
     _next_report_packet(0),
     _analyzer(),
     _analyzer_options()
 {
-    option(u"interval",       'i', POSITIVE);
-    option(u"multiple-files", 'm');
-    option(u"output-file",    'o', STRING);
+    option(u"cumulative",         'c');
+    option(u"interval",           'i', POSITIVE);
+    option(u"max-tables-per-pid",  0,  POSITIVE);
+    option(u"multiple-files",     'm');
+    option(u"output-file",        'o', STRING);
+    option(u"prune-idle",          0,  POSITIVE);
     copyOptions(_analyzer_options);
 
     _analyzer_options.setHelp(
         u"Options:\n"
         u"\n"
+        u"  -c\n"
+        u"  --cumulative\n"
+        u"      With --interval, do not reset the analysis context after each report.\n"
+        u"      Each report contains the analysis since the beginning of the stream.\n"
+        u"      For long-running monitoring, use --prune-idle and --max-tables-per-pid\n"
+        u"      to keep the memory usage bounded.\n"
+        u"\n"
         u"  --help\n"
         u"      Display this help text.\n"
         u"\n"
@@ -115,6 +129,13 @@ ts::AnalyzePlugin::AnalyzePlugin(TSP* tsp_) :
         u"      the analysis context is reset, ie. each output file contains a fully\n"
         u"      independent analysis.\n"
         u"\n"
+        u"  --max-tables-per-pid count\n"
+        u"      Maximum number of tables (table id and table id extension) which are\n"
+        u"      individually analyzed in each PID. When a new table appears in a PID\n"
+        u"      which already has that number of tables, the table which was not seen\n"
+        u"      for the longest time is dropped from the analysis. This is useful with\n"
+        u"      EIT schedule tables in long-running analyses. Unlimited by default.\n"
+        u"\n"
         u"  -m\n"
         u"  --multiple-files\n"
         u"      When used with --interval and --output-file, create a new file for each\n"
@@ -127,6 +148,11 @@ ts::AnalyzePlugin::AnalyzePlugin(TSP* tsp_) :
         u"      Specify the output text file for the analysis result.\n"
         u"      By default, use the standard output.\n"
         u"\n"
+        u"  --prune-idle count\n"
+        u"      With --interval and --cumulative, drop the PID's, tables and services\n"
+        u"      which were not seen during the specified number of intervals. The\n"
+        u"      reserved PID's (PSI/SI and null PID) are never dropped.\n"
+        u"\n"
         u"  --version\n"
         u"      Display the version number.\n");
 
@@ -143,9 +169,12 @@ bool ts::AnalyzePlugin::start()
     _output_name = value(u"output-file");
     _output_interval = MilliSecPerSec * intValue<MilliSecond>(u"interval", 0);
     _multiple_output = present(u"multiple-files");
+    _cumulative = present(u"cumulative");
+    _prune_idle = intValue<size_t>(u"prune-idle", 0);
     _output = _output_name.empty() ? &std::cout : &_output_stream;
     _analyzer_options.getOptions (*this);
     _analyzer.setAnalysisOptions (_analyzer_options);
+    _analyzer.setMaxTablesPerPID(intValue<size_t>(u"max-tables-per-pid", 0));
     _current_packet = 0;
 
     // Create the output file. Note that this file is used only in the stop
@@ -287,8 +316,13 @@ ts::ProcessorPlugin::Status ts::AnalyzePlugin::processPacket (TSPacket& pkt, boo
                 if (!produceReport()) {
                     return TSP_END;
                 }
-                // Reset analysis context
-                _analyzer.reset();
+                // Reset analysis context or age out inactive contexts.
+                if (_cumulative) {
+                    _analyzer.pruneIdleContexts(_prune_idle);
+                }
+                else {
+                    _analyzer.reset();
+                }
                 computeNextReportTime (current_utc, _output_interval);
             }
         }
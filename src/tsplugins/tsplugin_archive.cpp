@@ -0,0 +1,669 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+//
+//  Transport stream processor shared library:
+//  Compressed archive files of TS packets.
+//
+//----------------------------------------------------------------------------
+
+#include "tsPlugin.h"
+#include "tsPluginRepository.h"
+#include "tsMessageQueue.h"
+#include "tsThread.h"
+#include "tsLZ4.h"
+#include "tsCRC32.h"
+TSDUCK_SOURCE;
+
+#define DEF_BLOCK_PACKETS   8192   // Default number of TS packets per block
+#define DEF_MAX_QUEUED        16   // Default number of blocks waiting for compression
+#define CACHE_SIZE             4   // Number of recent distinct packets per PID
+#define ARCHIVE_MAGIC "TSDKARC1"   // Magic string at start of file, 8 characters
+#define MAGIC_SIZE             8
+#define BLOCK_HEADER_SIZE     16
+
+// Format of an archive file:
+//
+// - Magic string ARCHIVE_MAGIC.
+// - Sequence of independent blocks. Each block starts with a header of four
+//   32-bit big-endian integers: packet count, size of the coded packets,
+//   stored size, CRC32 of the coded packets. When the stored size is smaller
+//   than the size of the coded packets, the block is LZ4-compressed.
+//
+// The coded packets are a sequence of tokens:
+//
+// - TK_NULLS, followed by a variable-length integer N (7 bits per byte, low
+//   bits first): N times the last null packet.
+// - TK_LITERAL, followed by a complete TS packet.
+// - TK_REPEAT | slot << 4 | cc, followed by a 16-bit big-endian PID: the
+//   packet in the given slot of the cache of the PID, with a new continuity
+//   counter. This is typically a repetition of a PSI/SI packet.
+//
+// Null packets are never cached. Other literal packets are cached in their PID,
+// in the next slot, round robin. The coder state is reset on each block.
+
+namespace {
+    const uint8_t TK_NULLS   = 0x00;
+    const uint8_t TK_LITERAL = 0x01;
+    const uint8_t TK_REPEAT  = 0x40;
+    const uint8_t TK_REPEAT_MASK = 0xC0;
+}
+
+
+//----------------------------------------------------------------------------
+// Plugin definition
+//----------------------------------------------------------------------------
+
+namespace ts {
+
+    // Coding of TS packets in a block, common to input and output.
+    class ArchiveCoder
+    {
+    public:
+        ArchiveCoder();
+
+        // Reset the coder state at the start of a block.
+        void reset();
+
+        // Encode packets at the end of a block.
+        void encode(ByteBlock& block, const TSPacket* pkts, size_t count);
+
+        // Terminate the encoding of a block.
+        void flush(ByteBlock& block);
+
+        // Decode a complete block. Return false on invalid data.
+        bool decode(std::vector<TSPacket>& pkts, const uint8_t* data, size_t size);
+
+    private:
+        // Recent distinct packets of one PID.
+        struct PIDCache
+        {
+            size_t   count;
+            size_t   next;
+            TSPacket pkts[CACHE_SIZE];
+        };
+
+        static const uint16_t NO_CACHE = 0xFFFF;
+
+        std::vector<uint16_t> _index;      // Index in _caches by PID, NO_CACHE if none.
+        std::vector<PIDCache> _caches;     // Caches of PID's in the current block.
+        TSPacket              _null;       // Last null packet.
+        bool                  _null_valid; // _null is set.
+        size_t                _null_run;   // Number of pending repetitions of _null (encoder).
+
+        // Get the cache of a PID, create it if necessary.
+        PIDCache& cache(PID pid);
+
+        // Insert a packet in the cache of its PID.
+        void insert(const TSPacket& pkt);
+
+        // Compare two packets, ignoring the continuity counter.
+        static bool SameButCC(const TSPacket& p1, const TSPacket& p2)
+        {
+            return ::memcmp(p1.b, p2.b, 3) == 0 && ((p1.b[3] ^ p2.b[3]) & 0xF0) == 0 && ::memcmp(p1.b + 4, p2.b + 4, PKT_SIZE - 4) == 0;
+        }
+    };
+
+    // Input plugin
+    class ArchiveInput: public InputPlugin
+    {
+    public:
+        // Implementation of plugin API
+        ArchiveInput(TSP*);
+        virtual bool start() override;
+        virtual bool stop() override;
+        virtual size_t receive(TSPacket*, size_t) override;
+
+    private:
+        UString               _name;     // File name.
+        std::ifstream         _file;     // Input file.
+        uint64_t              _offset;   // Offset of next block in file.
+        ArchiveCoder          _coder;    // Packet decoder.
+        ByteBlock             _stored;   // Block as stored in file.
+        ByteBlock             _raw;      // Decompressed block.
+        std::vector<TSPacket> _packets;  // Decoded packets of current block.
+        size_t                _next;     // Index of next packet to return in _packets.
+
+        // Read and decode next block. Return false at end of file or on fatal error.
+        bool readBlock();
+
+        // Inaccessible operations
+        ArchiveInput() = delete;
+        ArchiveInput(const ArchiveInput&) = delete;
+        ArchiveInput& operator=(const ArchiveInput&) = delete;
+    };
+
+    // Output plugin
+    class ArchiveOutput: public OutputPlugin, private Thread
+    {
+    public:
+        // Implementation of plugin API
+        ArchiveOutput(TSP*);
+        virtual ~ArchiveOutput();
+        virtual bool start() override;
+        virtual bool stop() override;
+        virtual bool send(const TSPacket*, size_t) override;
+
+    private:
+        // A block of coded packets, passed to the compression thread.
+        struct Block
+        {
+            size_t    packets;
+            ByteBlock data;
+            Block() : packets(0), data() {}
+        };
+        typedef MessageQueue<Block, Mutex> BlockQueue;
+
+        UString              _name;           // File name.
+        size_t               _block_packets;  // Number of packets per block.
+        bool                 _compress;       // Compress blocks.
+        std::ofstream        _file;           // Output file, written by the thread only after start().
+        ArchiveCoder         _coder;          // Packet encoder.
+        BlockQueue::MessagePtr _block;        // Block being encoded.
+        BlockQueue           _queue;          // Blocks waiting for compression.
+        LZ4                  _lz4;            // Compressor, used by the thread.
+        volatile bool        _write_error;    // Error in the compression thread.
+        uint64_t             _packet_count;   // Total number of archived packets.
+        uint64_t             _file_size;      // Total size of file.
+
+        // Pass current block to the compression thread.
+        bool flushBlock();
+
+        // Compression thread.
+        virtual void main() override;
+
+        // Inaccessible operations
+        ArchiveOutput() = delete;
+        ArchiveOutput(const ArchiveOutput&) = delete;
+        ArchiveOutput& operator=(const ArchiveOutput&) = delete;
+    };
+}
+
+TSPLUGIN_DECLARE_VERSION
+TSPLUGIN_DECLARE_INPUT(archive, ts::ArchiveInput)
+TSPLUGIN_DECLARE_OUTPUT(archive, ts::ArchiveOutput)
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const uint16_t ts::ArchiveCoder::NO_CACHE;
+#endif
+
+
+//----------------------------------------------------------------------------
+// Packet coder.
+//----------------------------------------------------------------------------
+
+ts::ArchiveCoder::ArchiveCoder() :
+    _index(PID_MAX, NO_CACHE),
+    _caches(),
+    _null(),
+    _null_valid(false),
+    _null_run(0)
+{
+}
+
+void ts::ArchiveCoder::reset()
+{
+    for (size_t i = 0; i < _caches.size(); ++i) {
+        _index[_caches[i].pkts[0].getPID()] = NO_CACHE;
+    }
+    _caches.clear();
+    _null_valid = false;
+    _null_run = 0;
+}
+
+ts::ArchiveCoder::PIDCache& ts::ArchiveCoder::cache(PID pid)
+{
+    if (_index[pid] == NO_CACHE) {
+        _index[pid] = uint16_t(_caches.size());
+        _caches.resize(_caches.size() + 1);
+        _caches.back().count = 0;
+        _caches.back().next = 0;
+    }
+    return _caches[_index[pid]];
+}
+
+void ts::ArchiveCoder::insert(const TSPacket& pkt)
+{
+    PIDCache& pc(cache(pkt.getPID()));
+    pc.pkts[pc.next] = pkt;
+    pc.next = (pc.next + 1) % CACHE_SIZE;
+    pc.count = std::min<size_t>(pc.count + 1, CACHE_SIZE);
+}
+
+void ts::ArchiveCoder::flush(ByteBlock& block)
+{
+    if (_null_run > 0) {
+        block.push_back(TK_NULLS);
+        while (_null_run >= 0x80) {
+            block.push_back(uint8_t(0x80 | (_null_run & 0x7F)));
+            _null_run >>= 7;
+        }
+        block.push_back(uint8_t(_null_run));
+        _null_run = 0;
+    }
+}
+
+void ts::ArchiveCoder::encode(ByteBlock& block, const TSPacket* pkts, size_t count)
+{
+    for (const TSPacket* pkt = pkts; pkt < pkts + count; ++pkt) {
+        const PID pid = pkt->getPID();
+
+        // Null packets: run-length encoding of identical packets.
+        if (pid == PID_NULL) {
+            if (_null_valid && ::memcmp(pkt->b, _null.b, PKT_SIZE) == 0) {
+                _null_run++;
+            }
+            else {
+                flush(block);
+                block.push_back(TK_LITERAL);
+                block.append(pkt->b, PKT_SIZE);
+                _null = *pkt;
+                _null_valid = true;
+            }
+            continue;
+        }
+        flush(block);
+
+        // Other packets: look for a recent identical packet in the same PID.
+        if (_index[pid] != NO_CACHE) {
+            const PIDCache& pc(_caches[_index[pid]]);
+            size_t slot = 0;
+            while (slot < pc.count && !SameButCC(*pkt, pc.pkts[slot])) {
+                ++slot;
+            }
+            if (slot < pc.count) {
+                block.push_back(uint8_t(TK_REPEAT | (slot << 4) | pkt->getCC()));
+                block.push_back(uint8_t(pid >> 8));
+                block.push_back(uint8_t(pid));
+                continue;
+            }
+        }
+        block.push_back(TK_LITERAL);
+        block.append(pkt->b, PKT_SIZE);
+        insert(*pkt);
+    }
+}
+
+bool ts::ArchiveCoder::decode(std::vector<TSPacket>& pkts, const uint8_t* data, size_t size)
+{
+    const uint8_t* const end = data + size;
+    reset();
+    pkts.clear();
+
+    while (data < end) {
+        const uint8_t tag = *data++;
+        if (tag == TK_NULLS) {
+            size_t run = 0;
+            size_t shift = 0;
+            uint8_t b = 0;
+            do {
+                if (data >= end || shift > 28) {
+                    return false;
+                }
+                b = *data++;
+                run |= size_t(b & 0x7F) << shift;
+                shift += 7;
+            } while ((b & 0x80) != 0);
+            if (!_null_valid) {
+                return false;
+            }
+            pkts.insert(pkts.end(), run, _null);
+        }
+        else if (tag == TK_LITERAL) {
+            if (size_t(end - data) < PKT_SIZE) {
+                return false;
+            }
+            pkts.resize(pkts.size() + 1);
+            TSPacket& pkt(pkts.back());
+            ::memcpy(pkt.b, data, PKT_SIZE);
+            data += PKT_SIZE;
+            if (pkt.getPID() == PID_NULL) {
+                _null = pkt;
+                _null_valid = true;
+            }
+            else {
+                insert(pkt);
+            }
+        }
+        else if ((tag & TK_REPEAT_MASK) == TK_REPEAT) {
+            if (end - data < 2) {
+                return false;
+            }
+            const PID pid = PID(GetUInt16(data));
+            data += 2;
+            const size_t slot = (tag >> 4) & 0x03;
+            if (pid >= PID_MAX || _index[pid] == NO_CACHE || slot >= _caches[_index[pid]].count) {
+                return false;
+            }
+            pkts.push_back(_caches[_index[pid]].pkts[slot]);
+            pkts.back().setCC(tag & 0x0F);
+        }
+        else {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Input plugin constructor
+//----------------------------------------------------------------------------
+
+ts::ArchiveInput::ArchiveInput(TSP* tsp_) :
+    InputPlugin(tsp_, u"Read TS packets from a compressed archive file.", u"[options] file-name"),
+    _name(),
+    _file(),
+    _offset(0),
+    _coder(),
+    _stored(),
+    _raw(),
+    _packets(),
+    _next(0)
+{
+    option(u"", 0, STRING, 1, 1);
+
+    setHelp(u"Parameter:\n"
+            u"  Name of an archive file, as created by the archive output plugin. The\n"
+            u"  original transport stream is restored, bit-exact. A corrupted block is\n"
+            u"  reported and skipped.\n"
+            u"\n"
+            u"Options:\n"
+            u"\n"
+            u"  --help\n"
+            u"      Display this help text.\n"
+            u"\n"
+            u"  --version\n"
+            u"      Display the version number.\n");
+}
+
+
+//----------------------------------------------------------------------------
+// Input plugin methods
+//----------------------------------------------------------------------------
+
+bool ts::ArchiveInput::start()
+{
+    _name = value(u"");
+    _packets.clear();
+    _next = 0;
+
+    _file.open(_name.toUTF8().c_str(), std::ios::in | std::ios::binary);
+    if (!_file) {
+        tsp->error(u"cannot open %s", {_name});
+        return false;
+    }
+    char magic[MAGIC_SIZE];
+    if (!_file.read(magic, MAGIC_SIZE) || ::memcmp(magic, ARCHIVE_MAGIC, MAGIC_SIZE) != 0) {
+        tsp->error(u"%s is not a TSDuck archive file", {_name});
+        _file.close();
+        return false;
+    }
+    _offset = MAGIC_SIZE;
+    return true;
+}
+
+bool ts::ArchiveInput::stop()
+{
+    _file.close();
+    _packets.clear();
+    return true;
+}
+
+size_t ts::ArchiveInput::receive(TSPacket* buffer, size_t max_packets)
+{
+    while (_next >= _packets.size()) {
+        if (!readBlock()) {
+            return 0;
+        }
+    }
+    const size_t count = std::min(max_packets, _packets.size() - _next);
+    ::memcpy(buffer->b, _packets[_next].b, count * PKT_SIZE);
+    _next += count;
+    return count;
+}
+
+bool ts::ArchiveInput::readBlock()
+{
+    _packets.clear();
+    _next = 0;
+
+    // Read block header. Nothing at all means end of file.
+    uint8_t header[BLOCK_HEADER_SIZE];
+    _file.read(reinterpret_cast<char*>(header), sizeof(header));
+    if (_file.gcount() == 0) {
+        return false;
+    }
+    if (_file.gcount() != sizeof(header)) {
+        tsp->error(u"truncated block header at offset %'d in %s", {_offset, _name});
+        return false;
+    }
+    const size_t count = GetUInt32(header);
+    const size_t raw_size = GetUInt32(header + 4);
+    const size_t stored_size = GetUInt32(header + 8);
+    const uint32_t crc = GetUInt32(header + 12);
+    if (raw_size > count * (PKT_SIZE + 1) || stored_size > raw_size) {
+        tsp->error(u"invalid block header at offset %'d in %s", {_offset, _name});
+        return false;
+    }
+
+    // Read block content.
+    _stored.resize(stored_size);
+    _file.read(reinterpret_cast<char*>(_stored.data()), std::streamsize(stored_size));
+    if (size_t(_file.gcount()) != stored_size) {
+        tsp->error(u"truncated block at offset %'d in %s", {_offset, _name});
+        return false;
+    }
+    const uint64_t offset = _offset;
+    _offset += BLOCK_HEADER_SIZE + stored_size;
+
+    // Decompress and decode the block.
+    const ByteBlock* raw = &_stored;
+    bool valid = true;
+    if (stored_size < raw_size) {
+        valid = LZ4::Decompress(_raw, _stored.data(), _stored.size(), raw_size);
+        raw = &_raw;
+    }
+    valid = valid && CRC32(raw->data(), raw->size()).value() == crc && _coder.decode(_packets, raw->data(), raw->size()) && _packets.size() == count;
+    if (!valid) {
+        tsp->error(u"corrupted block at offset %'d in %s, %'d packets lost", {offset, _name, count});
+        _packets.clear();
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Output plugin constructor
+//----------------------------------------------------------------------------
+
+ts::ArchiveOutput::ArchiveOutput(TSP* tsp_) :
+    OutputPlugin(tsp_, u"Write TS packets to a compressed archive file.", u"[options] file-name"),
+    Thread(),
+    _name(),
+    _block_packets(0),
+    _compress(true),
+    _file(),
+    _coder(),
+    _block(),
+    _queue(),
+    _lz4(),
+    _write_error(false),
+    _packet_count(0),
+    _file_size(0)
+{
+    option(u"",               0,  STRING, 1, 1);
+    option(u"block-packets", 'b', INTEGER, 0, 1, 64, 1024 * 1024);
+    option(u"max-queued",    'm', POSITIVE);
+    option(u"no-compression", 0);
+
+    setHelp(u"Parameter:\n"
+            u"  Name of the archive file to create. Use the archive input plugin to restore\n"
+            u"  the original transport stream, bit-exact.\n"
+            u"\n"
+            u"  The archive is a sequence of independent blocks. In each block, runs of\n"
+            u"  identical null packets are replaced by a count and the packets which are\n"
+            u"  identical to a recent packet in the same PID, except the continuity counter,\n"
+            u"  are replaced by a reference. This is typically the case of repeated PSI/SI.\n"
+            u"  The blocks are then compressed using LZ4 in a separate thread.\n"
+            u"\n"
+            u"Options:\n"
+            u"\n"
+            u"  -b value\n"
+            u"  --block-packets value\n"
+            u"      Number of TS packets per block. The default is " TS_USTRINGIFY(DEF_BLOCK_PACKETS) u" packets.\n"
+            u"\n"
+            u"  --help\n"
+            u"      Display this help text.\n"
+            u"\n"
+            u"  -m value\n"
+            u"  --max-queued value\n"
+            u"      Maximum number of blocks waiting for compression. When the compression\n"
+            u"      thread is too slow, tsp waits. The default is " TS_USTRINGIFY(DEF_MAX_QUEUED) u" blocks.\n"
+            u"\n"
+            u"  --no-compression\n"
+            u"      Do not compress the blocks with LZ4. Only null packets and repeated\n"
+            u"      packets are reduced.\n"
+            u"\n"
+            u"  --version\n"
+            u"      Display the version number.\n");
+}
+
+ts::ArchiveOutput::~ArchiveOutput()
+{
+    // Make sure the thread is terminated, even if stop() was not called.
+    if (_file.is_open()) {
+        _queue.forceEnqueue(BlockQueue::MessagePtr());
+        waitForTermination();
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Output plugin methods
+//----------------------------------------------------------------------------
+
+bool ts::ArchiveOutput::start()
+{
+    _name = value(u"");
+    _block_packets = intValue<size_t>(u"block-packets", DEF_BLOCK_PACKETS);
+    _compress = !present(u"no-compression");
+    _queue.setMaxMessages(intValue<size_t>(u"max-queued", DEF_MAX_QUEUED));
+    _write_error = false;
+    _packet_count = 0;
+    _file_size = MAGIC_SIZE;
+
+    _file.open(_name.toUTF8().c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!_file || !_file.write(ARCHIVE_MAGIC, MAGIC_SIZE)) {
+        tsp->error(u"cannot create %s", {_name});
+        _file.close();
+        return false;
+    }
+
+    _coder.reset();
+    _block = new Block;
+    return Thread::start();
+}
+
+bool ts::ArchiveOutput::stop()
+{
+    if (_file.is_open()) {
+        // Flush the last block and terminate the compression thread.
+        if (_block->packets > 0) {
+            flushBlock();
+        }
+        _queue.forceEnqueue(BlockQueue::MessagePtr());
+        waitForTermination();
+        _file.close();
+        const uint64_t ts_size = _packet_count * PKT_SIZE;
+        tsp->verbose(u"%'d packets archived, %'d bytes, %d%% of TS size", {_packet_count, _file_size, ts_size == 0 ? 0 : (100 * _file_size) / ts_size});
+    }
+    return !_write_error;
+}
+
+bool ts::ArchiveOutput::send(const TSPacket* buffer, size_t packet_count)
+{
+    while (packet_count > 0 && !_write_error) {
+        const size_t count = std::min(packet_count, _block_packets - _block->packets);
+        _coder.encode(_block->data, buffer, count);
+        _block->packets += count;
+        buffer += count;
+        packet_count -= count;
+        if (_block->packets >= _block_packets && !flushBlock()) {
+            return false;
+        }
+    }
+    return !_write_error;
+}
+
+bool ts::ArchiveOutput::flushBlock()
+{
+    _coder.flush(_block->data);
+    _coder.reset();
+    _packet_count += _block->packets;
+    const bool ok = _queue.enqueue(_block);
+    _block = new Block;
+    return ok;
+}
+
+
+//----------------------------------------------------------------------------
+// Compression thread.
+//----------------------------------------------------------------------------
+
+void ts::ArchiveOutput::main()
+{
+    ByteBlock compressed;
+    BlockQueue::MessagePtr block;
+
+    while (_queue.dequeue(block) && !block.isNull()) {
+        if (_write_error) {
+            continue;  // drain the queue after an error
+        }
+        const ByteBlock* stored = &block->data;
+        if (_compress) {
+            _lz4.compress(compressed, block->data.data(), block->data.size());
+            if (compressed.size() < block->data.size()) {
+                stored = &compressed;
+            }
+        }
+        uint8_t header[BLOCK_HEADER_SIZE];
+        PutUInt32(header, uint32_t(block->packets));
+        PutUInt32(header + 4, uint32_t(block->data.size()));
+        PutUInt32(header + 8, uint32_t(stored->size()));
+        PutUInt32(header + 12, CRC32(block->data.data(), block->data.size()).value());
+        if (!_file.write(reinterpret_cast<const char*>(header), sizeof(header)) ||
+            !_file.write(reinterpret_cast<const char*>(stored->data()), std::streamsize(stored->size())))
+        {
+            tsp->error(u"error writing %s", {_name});
+            _write_error = true;
+        }
+        _file_size += sizeof(header) + stored->size();
+    }
+}
@@ -32,10 +32,8 @@
 //
 //----------------------------------------------------------------------------
 
-#include "tsPlugin.h"
+#include "tsAbstractTablePlugin.h"
 #include "tsPluginRepository.h"
-#include "tsSectionDemux.h"
-#include "tsCyclingPacketizer.h"
 #include "tsServiceDescriptor.h"
 #include "tsService.h"
 #include "tsBAT.h"
@@ -47,31 +45,24 @@ TSDUCK_SOURCE;
 //----------------------------------------------------------------------------
 
 namespace ts {
-    class BATPlugin: public ProcessorPlugin, private TableHandlerInterface
+    class BATPlugin: public AbstractTablePlugin
     {
     public:
         // Implementation of plugin API
         BATPlugin(TSP*);
         virtual bool start() override;
-        virtual Status processPacket(TSPacket&, bool&, bool&) override;
 
     private:
-        bool               _abort;             // Error (service not found, etc)
         bool               _single_bat;        // Modify one single BAT only
         uint16_t           _bouquet_id;        // Bouquet id of the BAT to modify (if _single_bat)
-        bool               _incr_version;      // Increment table version
-        bool               _set_version;       // Set a new table version
-        uint8_t            _new_version;       // New table version
         std::set<uint16_t> _remove_serv;       // Set of services to remove
         std::set<uint16_t> _remove_ts;         // Set of transport streams to remove
         std::vector<DID>   _removed_desc;      // Set of descriptor tags to remove
         PDS                _pds;               // Private data specifier for removed descriptors
         bool               _cleanup_priv_desc; // Remove private desc without preceding PDS desc
-        SectionDemux       _demux;             // Section demux
-        CyclingPacketizer  _pzer;              // Packetizer for modified SDT/BAT
 
-        // Invoked by the demux when a complete table is available.
-        virtual void handleTable (SectionDemux&, const BinaryTable&) override;
+        // Implementation of AbstractTablePlugin.
+        virtual void modifyTable(BinaryTable&, bool&, bool&) override;
         void processBAT (BAT&);
         void processDescriptorList (DescriptorList&);
 
@@ -91,25 +82,17 @@ TSPLUGIN_DECLARE_PROCESSOR(bat, ts::BATPlugin)
 //----------------------------------------------------------------------------
 
 ts::BATPlugin::BATPlugin (TSP* tsp_) :
-   ProcessorPlugin(tsp_, u"Perform various transformations on the BAT.", u"[options]"),
-   _abort(false),
+   AbstractTablePlugin(tsp_, u"Perform various transformations on the BAT.", u"[options]", u"BAT"),
    _single_bat(false),
    _bouquet_id(0),
-   _incr_version(false),
-   _set_version(false),
-   _new_version(0),
    _remove_serv(),
    _remove_ts(),
    _removed_desc(),
    _pds(0),
-   _cleanup_priv_desc(false),
-   _demux(this),
-   _pzer()
+   _cleanup_priv_desc(false)
 {
     option(u"bouquet-id",                 'b', UINT16);
     option(u"cleanup-private-descriptors", 0);
-    option(u"increment-version",          'i');
-    option(u"new-version",                'v', INTEGER, 0, 1, 0, 31);
     option(u"pds",                         0,  UINT32);
     option(u"remove-descriptor",           0,  UINT8,  0, UNLIMITED_COUNT);
     option(u"remove-service",             'r', UINT16, 0, UNLIMITED_COUNT);
@@ -173,57 +156,42 @@ bool ts::BATPlugin::start()
     _bouquet_id = intValue<uint16_t>(u"bouquet-id", 0);
     _pds = intValue<PDS>(u"pds", 0);
     _cleanup_priv_desc = present(u"cleanup-private-descriptors");
-    _incr_version = present(u"increment-version");
-    _set_version = present(u"new-version");
-    _new_version = intValue<uint8_t>(u"new-version", 0);
     getIntValues(_remove_serv, u"remove-service");
     getIntValues(_remove_ts, u"remove-ts");
     getIntValues(_removed_desc, u"remove-descriptor");
 
-    // Initialize the demux and packetizer
-    _demux.reset();
-    _demux.addPID (PID_BAT);
-    _pzer.reset();
-    _pzer.setPID (PID_BAT);
-
-    _abort = false;
+    // Initialize the table processing.
+    // Use the shared signalization of tsp when available.
+    PIDSet pids;
+    pids.set(PID_BAT);
+    startTables(PID_BAT, pids, true);
     return true;
 }
 
 
 //----------------------------------------------------------------------------
-// Invoked by the demux when a complete table is available.
+// Modify a table from the BAT/SDT PID.
 //----------------------------------------------------------------------------
 
-void ts::BATPlugin::handleTable (SectionDemux& demux, const BinaryTable& table)
+void ts::BATPlugin::modifyTable(BinaryTable& table, bool& is_target, bool& reinsert)
 {
-    switch (table.tableId()) {
-
-        case TID_BAT: {
-            if (table.sourcePID() == PID_BAT) {
-                BAT bat (table);
-                if (bat.isValid()) {
-                    _pzer.removeSections (TID_BAT, table.tableIdExtension());
-                    if (!_single_bat || table.tableIdExtension() == _bouquet_id) {
-                        processBAT (bat);
-                    }
-                    _pzer.addTable (bat);
-                }
-            }
-            break;
-        }
-
-        case TID_SDT_ACT:
-        case TID_SDT_OTH: {
-            if (table.sourcePID() == PID_BAT) {
-                // Do not modify SDT (same PID as BAT)
-                _pzer.removeSections (table.tableId(), table.tableIdExtension());
-                _pzer.addTable (table);
-            }
+    if (table.tableId() != TID_BAT) {
+        // Do not modify SDT (same PID as BAT)
+        is_target = false;
+        reinsert = table.tableId() == TID_SDT_ACT || table.tableId() == TID_SDT_OTH;
+    }
+    else if (_single_bat && table.tableIdExtension() != _bouquet_id) {
+        // Not the BAT to modify, pass it unmodified
+        is_target = false;
+    }
+    else if (!_remove_serv.empty() || !_remove_ts.empty() || !_removed_desc.empty() || _cleanup_priv_desc) {
+        BAT bat(table);
+        if (bat.isValid()) {
+            processBAT(bat);
+            bat.serialize(table);
         }
-
-        default: {
-            break;
+        else {
+            reinsert = false;
         }
     }
 }
@@ -237,14 +205,6 @@ void ts::BATPlugin::processBAT (BAT& bat)
 {
     tsp->debug(u"got a BAT, version %d, bouquet id: %d (0x%X)", {bat.version, bat.bouquet_id, bat.bouquet_id});
 
-    // Update BAT version
-    if (_incr_version) {
-        bat.version = (bat.version + 1) & 0x1F;
-    }
-    else if (_set_version) {
-        bat.version = _new_version;
-    }
-
     // Remove the specified transport streams
     bool found;
     do {
@@ -343,26 +303,3 @@ void ts::BATPlugin::processDescriptorList (DescriptorList& dlist)
         dlist[i]->resizePayload (new_data - base);
     }
 }
-
-
-//----------------------------------------------------------------------------
-// Packet processing method
-//----------------------------------------------------------------------------
-
-ts::ProcessorPlugin::Status ts::BATPlugin::processPacket (TSPacket& pkt, bool& flush, bool& bitrate_changed)
-{
-    // Filter interesting sections
-    _demux.feedPacket (pkt);
-
-    // If a fatal error occured during section analysis, give up.
-    if (_abort) {
-        return TSP_END;
-    }
-
-    // Replace packets using packetizer
-    if (pkt.getPID() == PID_BAT) {
-        _pzer.getNextPacket (pkt);
-    }
-
-    return TSP_OK;
-}
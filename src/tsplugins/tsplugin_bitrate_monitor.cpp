@@ -34,6 +34,11 @@
 
 #include "tsPlugin.h"
 #include "tsPluginRepository.h"
+#include "tsServiceDiscovery.h"
+#include "tsjsonWriter.h"
+#include "tsTime.h"
+#include "tsMemoryUtils.h"
+#include "tsSafePtr.h"
 TSDUCK_SOURCE;
 
 
@@ -42,12 +47,13 @@ TSDUCK_SOURCE;
 //----------------------------------------------------------------------------
 
 namespace ts {
-    class BitrateMonitorPlugin: public ProcessorPlugin
+    class BitrateMonitorPlugin: public ProcessorPlugin, private PMTHandlerInterface
     {
     public:
         // Implementation of plugin API
         BitrateMonitorPlugin(TSP*);
         virtual bool start() override;
+        virtual bool stop() override;
         virtual Status processPacket(TSPacket&, bool&, bool&) override;
 
     private:
@@ -60,23 +66,53 @@ namespace ts {
         // Type indicating status of current bitrate, regarding allowed range
         enum RangeStatus {LOWER, IN_RANGE, GREATER};
 
-        PID         _pid;                  // Monitored PID
-        BitRate     _min_bitrate;          // Minimum allowed bitrate
-        BitRate     _max_bitrate;          // Maximum allowed bitrate
-        RangeStatus _last_bitrate_status;  // Status of the last bitrate, regarding allowed range
-        UString     _alarm_command;        // Alarm command name
-        time_t      _last_second;          // Last second number
-        size_t      _window_size;          // Size (in seconds) of the time window, used to compute bitrate.
-        bool        _startup;              // Measurement in progress.
-        size_t      _pkt_count_index;      // Index for packet number array.
-        std::vector<PacketCounter> _pkt_count; // Array with the number of packets received during the last time window.
-                                               // Numbers are stored second per second.
+        // Description of a monitored PID or service.
+        class Item
+        {
+        public:
+            UString     name;           // Displayed name of the item.
+            PID         pid;            // Monitored PID, PID_NULL for a service.
+            SafePtr<ServiceDiscovery, NullMutex> service; // Monitored service, null for a PID.
+            PIDSet      pids;           // Components of the service.
+            BitRate     min_bitrate;    // Minimum allowed bitrate.
+            BitRate     max_bitrate;    // Maximum allowed bitrate.
+            BitRate     bitrate;        // Last computed bitrate.
+            RangeStatus status;         // Status of the last bitrate, regarding allowed range.
+            std::vector<PacketCounter> pkt_count; // Number of packets per second in the time window.
+
+            // Constructor.
+            Item(const UString& name_, PID pid_, size_t window_size);
+        };
+        typedef SafePtr<Item, NullMutex> ItemPtr;
+
+        UString       _alarm_command;     // Alarm command name
+        time_t        _last_second;       // Last second number
+        size_t        _window_size;       // Size (in seconds) of the time window, used to compute bitrate.
+        bool          _startup;           // Measurement in progress.
+        size_t        _pkt_count_index;   // Index for packet number arrays.
+        size_t        _periodic;          // Interval in seconds between bitrate reports, zero if none.
+        size_t        _periodic_countdown; // Seconds before next periodic report.
+        bool          _json;              // Structured output in JSON lines.
+        std::ofstream _outfile;           // User-specified output file.
+        std::vector<ItemPtr> _items;      // Monitored PID's and services.
+        json::Writer  _writer;            // JSON line builder.
+        PacketCounter _pid_count[PID_MAX]; // Packets per PID in current second.
 
         // Run the alarm command.
         void runAlarmCommand(const ts::UString& parameter);
 
-        // Compute bitrate. Report any alarm.
-        void computeBitrate();
+        // Compute bitrates of all items at end of a second. Report any alarm.
+        void computeBitrates();
+        void computeBitrate(Item& item);
+
+        // Periodic report of all bitrates.
+        void reportBitrates();
+
+        // Output a line on the report file or the log.
+        void output(const UString& line, bool alarm);
+
+        // Invoked when the PMT of a service is found.
+        virtual void handlePMT(const PMT&) override;
 
         // Inaccessible operations
         BitrateMonitorPlugin() = delete;
@@ -96,30 +132,48 @@ const size_t ts::BitrateMonitorPlugin::DEFAULT_TIME_WINDOW_SIZE;
 
 
 //----------------------------------------------------------------------------
-// Constructor
+// Constructors
 //----------------------------------------------------------------------------
 
+ts::BitrateMonitorPlugin::Item::Item(const UString& name_, PID pid_, size_t window_size) :
+    name(name_),
+    pid(pid_),
+    service(),
+    pids(),
+    min_bitrate(0),
+    max_bitrate(0),
+    bitrate(0),
+    status(IN_RANGE),
+    pkt_count(window_size, 0)
+{
+}
+
 ts::BitrateMonitorPlugin::BitrateMonitorPlugin(TSP* tsp_) :
-    ProcessorPlugin(tsp_, u"Monitor bitrate for a given pid.", u"[options] pid"),
-    _pid(PID_NULL),
-    _min_bitrate(0),
-    _max_bitrate(0),
-    _last_bitrate_status(LOWER),
+    ProcessorPlugin(tsp_, u"Monitor bitrate for PID's or services.", u"[options] [pid ...]"),
     _alarm_command(),
     _last_second(0),
     _window_size(0),
     _startup(false),
     _pkt_count_index(0),
-    _pkt_count()
+    _periodic(0),
+    _periodic_countdown(0),
+    _json(false),
+    _outfile(),
+    _items(),
+    _writer()
 {
-    option(u""             ,  0,  PIDVAL, 1, 1);   // PID nb is a required parameter
-    option(u"alarm_command", 'a', STRING);
-    option(u"time_interval", 't', UINT16);
-    option(u"min"          ,  0,  UINT32);
-    option(u"max"          ,  0,  UINT32);
+    option(u""               ,  0,  PIDVAL, 0, UNLIMITED_COUNT);
+    option(u"alarm_command"  , 'a', STRING);
+    option(u"json"           ,  0);
+    option(u"max"            ,  0,  UINT32, 0, UNLIMITED_COUNT);
+    option(u"min"            ,  0,  UINT32, 0, UNLIMITED_COUNT);
+    option(u"output-file"    , 'o', STRING);
+    option(u"periodic-bitrate", 'p', POSITIVE);
+    option(u"service"        , 's', STRING, 0, UNLIMITED_COUNT);
+    option(u"time_interval"  , 't', UINT16);
 
     setHelp(u"PID:\n"
-            u"      Specifies the PID to monitor.\n"
+            u"      Specifies the PID's to monitor. Several PID's can be specified.\n"
             u"\n"
             u"Options:\n"
             u"\n"
@@ -127,6 +181,9 @@ ts::BitrateMonitorPlugin::BitrateMonitorPlugin(TSP* tsp_) :
             u"  --alarm_command command\n"
             u"      Command to be run when an alarm is detected (bitrate out of range).\n"
             u"\n"
+            u"  --json\n"
+            u"      Report alarms and bitrates as JSON lines, one JSON object per line.\n"
+            u"\n"
             u"  --min value\n"
             u"      Set minimum allowed value for bitrate (bits/s).\n"
             u"      Default: " + UString::Decimal(DEFAULT_BITRATE_MIN) + u" b/s.\n"
@@ -135,6 +192,28 @@ ts::BitrateMonitorPlugin::BitrateMonitorPlugin(TSP* tsp_) :
             u"      Set maximum allowed value for bitrate (bits/s).\n"
             u"      Default: " + UString::Decimal(DEFAULT_BITRATE_MAX) + u" b/s.\n"
             u"\n"
+            u"      The options --min and --max can be specified several times, once per\n"
+            u"      monitored PID or service, in this order: the PID's, then the services.\n"
+            u"      The last value applies to all remaining PID's and services.\n"
+            u"\n"
+            u"  -o filename\n"
+            u"  --output-file filename\n"
+            u"      Write alarms and bitrate reports to the specified file instead of\n"
+            u"      the log.\n"
+            u"\n"
+            u"  -p value\n"
+            u"  --periodic-bitrate value\n"
+            u"      Report the bitrate of all PID's and services every specified number\n"
+            u"      of seconds. By default, only the alarms are reported.\n"
+            u"\n"
+            u"  -s value\n"
+            u"  --service value\n"
+            u"      Monitor the global bitrate of all components of a service, including\n"
+            u"      its PMT. If the argument is an integer value (either decimal or\n"
+            u"      hexadecimal), it is interpreted as a service id. Otherwise, it is\n"
+            u"      interpreted as a service name, as specified in the SDT. Several\n"
+            u"      services can be specified.\n"
+            u"\n"
             u"  -t value\n"
             u"  --time_interval value\n"
             u"      Time interval (in seconds) used to compute the bitrate.\n"
@@ -156,25 +235,56 @@ bool ts::BitrateMonitorPlugin::start()
 {
     // Get command line arguments
     _alarm_command = value(u"alarm_command");
-    _pid = intValue<PID>(u"", PID_NULL);
-    _window_size = intValue(u"time_interval", DEFAULT_TIME_WINDOW_SIZE);
-    _min_bitrate = intValue(u"min", DEFAULT_BITRATE_MIN);
-    _max_bitrate = intValue(u"max", DEFAULT_BITRATE_MAX);
-
-    if (_min_bitrate > _max_bitrate) {
-        tsp->error(u"bad parameters, bitrate min (%'d) > max (%'d), exiting", {_min_bitrate, _max_bitrate});
+    _window_size = std::max<size_t>(1, intValue(u"time_interval", DEFAULT_TIME_WINDOW_SIZE));
+    _periodic = intValue<size_t>(u"periodic-bitrate", 0);
+    _json = present(u"json");
+
+    const size_t pid_count = count(u"");
+    const size_t srv_count = count(u"service");
+    if (pid_count + srv_count == 0) {
+        tsp->error(u"specify at least one PID or service");
         return false;
     }
 
-    // Initialize array wick packets count.
-    _pkt_count.resize(_window_size);
-    _pkt_count_index = 0;
+    // Build the list of monitored items. Thresholds are per item, the last one applies to the rest.
+    _items.clear();
+    const size_t min_count = count(u"min");
+    const size_t max_count = count(u"max");
+    for (size_t i = 0; i < pid_count + srv_count; ++i) {
+        ItemPtr item;
+        if (i < pid_count) {
+            const PID pid = intValue<PID>(u"", PID_NULL, i);
+            item = new Item(UString::Format(u"pid %d (0x%X)", {pid, pid}), pid, _window_size);
+        }
+        else {
+            const UString desc(value(u"service", u"", i - pid_count));
+            item = new Item(u"service " + desc, PID_NULL, _window_size);
+            item->service = new ServiceDiscovery(desc, this, *tsp);
+        }
+        item->min_bitrate = min_count == 0 ? DEFAULT_BITRATE_MIN : intValue<BitRate>(u"min", DEFAULT_BITRATE_MIN, std::min(i, min_count - 1));
+        item->max_bitrate = max_count == 0 ? DEFAULT_BITRATE_MAX : intValue<BitRate>(u"max", DEFAULT_BITRATE_MAX, std::min(i, max_count - 1));
+        if (item->min_bitrate > item->max_bitrate) {
+            tsp->error(u"bad parameters for %s, bitrate min (%'d) > max (%'d), exiting", {item->name, item->min_bitrate, item->max_bitrate});
+            return false;
+        }
+        _items.push_back(item);
+    }
 
-    for (uint16_t i = 0; i < _pkt_count.size(); i++) {
-        _pkt_count[i] = 0;
+    // Create the output file.
+    if (present(u"output-file")) {
+        const UString name(value(u"output-file"));
+        tsp->verbose(u"creating %s", {name});
+        _outfile.open(name.toUTF8().c_str(), std::ios::out);
+        if (!_outfile) {
+            tsp->error(u"cannot create %s", {name});
+            return false;
+        }
     }
 
-    _last_bitrate_status = IN_RANGE;
+    // Reset packet counters.
+    TS_ZERO(_pid_count);
+    _pkt_count_index = 0;
+    _periodic_countdown = _periodic;
     _last_second = time(NULL);
     _startup = true;
 
@@ -182,6 +292,43 @@ bool ts::BitrateMonitorPlugin::start()
 }
 
 
+//----------------------------------------------------------------------------
+// Stop method
+//----------------------------------------------------------------------------
+
+bool ts::BitrateMonitorPlugin::stop()
+{
+    if (_outfile.is_open()) {
+        _outfile.close();
+    }
+    _items.clear();
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Invoked when the PMT of a service is found: update the components.
+//----------------------------------------------------------------------------
+
+void ts::BitrateMonitorPlugin::handlePMT(const PMT& pmt)
+{
+    for (size_t i = 0; i < _items.size(); ++i) {
+        Item& item(*_items[i]);
+        if (!item.service.isNull() && item.service->hasId(pmt.service_id)) {
+            item.pids.reset();
+            item.pids.set(item.service->getPMTPID());
+            if (pmt.pcr_pid != PID_NULL) {
+                item.pids.set(pmt.pcr_pid);
+            }
+            for (PMT::StreamMap::const_iterator it = pmt.streams.begin(); it != pmt.streams.end(); ++it) {
+                item.pids.set(it->first);
+            }
+            tsp->verbose(u"%s has %d PID's", {item.name, item.pids.count()});
+        }
+    }
+}
+
+
 //----------------------------------------------------------------------------
 // Run the alarm command, if one was specified as the plugin option.
 // The given string parameter describes the alarm.
@@ -201,29 +348,86 @@ void ts::BitrateMonitorPlugin::runAlarmCommand(const ts::UString& parameter)
 
 
 //----------------------------------------------------------------------------
-// Compute bitrate for the monitored PID. Report an alarm if the bitrate
+// Output a line on the report file or the log.
+//----------------------------------------------------------------------------
+
+void ts::BitrateMonitorPlugin::output(const UString& line, bool alarm)
+{
+    if (_outfile.is_open()) {
+        _outfile << line << std::endl;
+    }
+    else if (alarm) {
+        tsp->warning(line);
+    }
+    else {
+        tsp->info(line);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Compute bitrates for all monitored items at the end of a second.
+//----------------------------------------------------------------------------
+
+void ts::BitrateMonitorPlugin::computeBitrates()
+{
+    for (size_t i = 0; i < _items.size(); ++i) {
+        Item& item(*_items[i]);
+
+        // Collect the packets of the last second.
+        PacketCounter count = 0;
+        if (item.service.isNull()) {
+            count = _pid_count[item.pid];
+        }
+        else if (item.pids.any()) {
+            for (PID pid = 0; pid < PID_MAX; ++pid) {
+                if (item.pids.test(pid)) {
+                    count += _pid_count[pid];
+                }
+            }
+        }
+        item.pkt_count[_pkt_count_index] = count;
+
+        // Bitrate computation is done only when the packet counter
+        // arrays are fully filled (to avoid bad values at startup).
+        if (!_startup) {
+            computeBitrate(item);
+        }
+    }
+    TS_ZERO(_pid_count);
+
+    // Periodic report of all bitrates.
+    if (!_startup && _periodic > 0 && --_periodic_countdown == 0) {
+        reportBitrates();
+        _periodic_countdown = _periodic;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Compute bitrate for one monitored item. Report an alarm if the bitrate
 // is out of allowed range, or back in it.
 //----------------------------------------------------------------------------
 
-void ts::BitrateMonitorPlugin::computeBitrate()
+void ts::BitrateMonitorPlugin::computeBitrate(Item& item)
 {
     // Bitrate is computed with the following formula :
     // (Sum of packets received during the last time window) * (packet size) /
     // (time window)
 
     PacketCounter total_pkt_count = 0;
-    for (uint16_t i = 0; i < _pkt_count.size(); i++) {
-        total_pkt_count  += _pkt_count[i];
+    for (size_t i = 0; i < item.pkt_count.size(); i++) {
+        total_pkt_count += item.pkt_count[i];
     }
 
-    const BitRate bitrate = BitRate(total_pkt_count * PKT_SIZE * 8 / _pkt_count.size());
+    item.bitrate = BitRate(total_pkt_count * PKT_SIZE * 8 / item.pkt_count.size());
 
     // Check the bitrate value, regarding the allowed range.
     RangeStatus new_bitrate_status;
-    if (bitrate < _min_bitrate) {
+    if (item.bitrate < item.min_bitrate) {
         new_bitrate_status = LOWER;
     }
-    else if (bitrate > _max_bitrate) {
+    else if (item.bitrate > item.max_bitrate) {
         new_bitrate_status = GREATER;
     }
     else {
@@ -231,29 +435,82 @@ void ts::BitrateMonitorPlugin::computeBitrate()
     }
 
     // Report an error, if the bitrate status has changed.
-    if (new_bitrate_status != _last_bitrate_status) {
-        ts::UString alarmMessage(UString::Format(u"pid %d (0x%X) - bitrate (%'d bits/s)", {_pid, _pid, bitrate}));
+    if (new_bitrate_status != item.status) {
+        ts::UString alarmMessage(UString::Format(u"%s - bitrate (%'d bits/s)", {item.name, item.bitrate}));
+        const UChar* status = u"";
         switch (new_bitrate_status) {
             case LOWER:
-                alarmMessage += UString::Format(u" is lower than allowed minimum (%'d bits/s)", {_min_bitrate});
+                alarmMessage += UString::Format(u" is lower than allowed minimum (%'d bits/s)", {item.min_bitrate});
+                status = u"lower";
                 break;
             case IN_RANGE:
-                alarmMessage += UString::Format(u" is back in allowed range (%'d-%'d bits/s)", {_min_bitrate, _max_bitrate});
+                alarmMessage += UString::Format(u" is back in allowed range (%'d-%'d bits/s)", {item.min_bitrate, item.max_bitrate});
+                status = u"in-range";
                 break;
             case GREATER:
-                alarmMessage = UString::Format(u" is greater than allowed maximum (%'d bits/s)", {_max_bitrate});
+                alarmMessage += UString::Format(u" is greater than allowed maximum (%'d bits/s)", {item.max_bitrate});
+                status = u"greater";
                 break;
             default:
                 assert(false); // should not get there
         }
 
-        tsp->warning(alarmMessage);
+        if (_json) {
+            _writer.clear();
+            _writer.beginObject();
+            _writer.field(u"time", Time::CurrentLocalTime().format(Time::DATE | Time::HOUR | Time::MINUTE | Time::SECOND));
+            _writer.field(u"type", u"alarm");
+            _writer.field(u"item", item.name);
+            _writer.field(u"status", status);
+            _writer.field(u"bitrate", item.bitrate);
+            _writer.field(u"min", item.min_bitrate);
+            _writer.field(u"max", item.max_bitrate);
+            _writer.endObject();
+            output(UString::FromUTF8(_writer.text()), true);
+        }
+        else {
+            output(alarmMessage, true);
+        }
 
         // Call alarm script if defined, and pass the alarm message as parameter.
         runAlarmCommand(alarmMessage);
 
         // Update status
-        _last_bitrate_status = new_bitrate_status;
+        item.status = new_bitrate_status;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Periodic report of all bitrates, in one single output.
+//----------------------------------------------------------------------------
+
+void ts::BitrateMonitorPlugin::reportBitrates()
+{
+    if (_json) {
+        _writer.clear();
+        _writer.beginObject();
+        _writer.field(u"time", Time::CurrentLocalTime().format(Time::DATE | Time::HOUR | Time::MINUTE | Time::SECOND));
+        _writer.field(u"type", u"bitrates");
+        _writer.name(u"items").beginArray();
+        for (size_t i = 0; i < _items.size(); ++i) {
+            const Item& item(*_items[i]);
+            _writer.beginObject();
+            _writer.field(u"item", item.name);
+            _writer.field(u"bitrate", item.bitrate);
+            _writer.field(u"in-range", item.status == IN_RANGE);
+            _writer.endObject();
+        }
+        _writer.endArray();
+        _writer.endObject();
+        output(UString::FromUTF8(_writer.text()), false);
+    }
+    else {
+        UString line(u"bitrates:");
+        for (size_t i = 0; i < _items.size(); ++i) {
+            line += UString::Format(u"%s %s: %'d b/s", {i == 0 ? u"" : u",", _items[i]->name, _items[i]->bitrate});
+        }
+        output(line, false);
     }
 }
 
@@ -269,18 +526,13 @@ ts::ProcessorPlugin::Status ts::BitrateMonitorPlugin::processPacket(TSPacket& pk
     // NOTE : the computation method used here is meaningful only if at least
     // one packet is received per second (whatever its PID).
 
-    // New second : compute the bitrate for the last time window
+    // New second : compute the bitrates for the last time window
     if (now > _last_second) {
 
-        // Bitrate computation is done only when the packet counter
-        // array if fully filled (to avoid bad values at startup).
-        if (!_startup) {
-            computeBitrate();
-        }
+        computeBitrates();
 
         // update index, and reset packet count.
-        _pkt_count_index = (_pkt_count_index + 1) % _pkt_count.size();
-        _pkt_count[_pkt_count_index] = 0;
+        _pkt_count_index = (_pkt_count_index + 1) % _window_size;
 
         // We are no more at startup if the index cycles.
         if (_startup) {
@@ -290,9 +542,14 @@ ts::ProcessorPlugin::Status ts::BitrateMonitorPlugin::processPacket(TSPacket& pk
         _last_second = now;
     }
 
-    // If packet's PID matches, increment the number of packets received during the current second.
-    if (pkt.getPID() == _pid) {
-        _pkt_count[_pkt_count_index]++;
+    // Count packets of all PID's, the monitored items collect them at the end of each second.
+    _pid_count[pkt.getPID()]++;
+
+    // Feed service discovery, if any.
+    for (size_t i = 0; i < _items.size(); ++i) {
+        if (!_items[i]->service.isNull()) {
+            _items[i]->service->feedPacket(pkt);
+        }
     }
 
     // Pass all packets
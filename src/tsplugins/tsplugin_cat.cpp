@@ -32,10 +32,8 @@
 //
 //----------------------------------------------------------------------------
 
-#include "tsPlugin.h"
+#include "tsAbstractTablePlugin.h"
 #include "tsPluginRepository.h"
-#include "tsSectionDemux.h"
-#include "tsCyclingPacketizer.h"
 #include "tsCADescriptor.h"
 #include "tsCAT.h"
 TSDUCK_SOURCE;
@@ -48,7 +46,7 @@ TSDUCK_SOURCE;
 //----------------------------------------------------------------------------
 
 namespace ts {
-    class CATPlugin: public ProcessorPlugin, private TableHandlerInterface
+    class CATPlugin: public AbstractTablePlugin
     {
     public:
         // Implementation of plugin API
@@ -65,18 +63,13 @@ namespace ts {
         BitRate               _cat_bitrate;       // CAT PID's bitrate (if no previous CAT)
         PacketCounter         _cat_inter_pkt;     // Packet interval between two CAT packets
         bool                  _cleanup_priv_desc; // Remove private desc without preceding PDS desc
-        bool                  _incr_version;      // Increment table version
-        bool                  _set_version;       // Set a new table version
-        uint8_t               _new_version;       // New table version
         std::vector<uint16_t> _remove_casid;      // Set of CAS id to remove
         std::vector<uint16_t> _remove_pid;        // Set of EMM PID to remove
         DescriptorList        _add_descs;         // List of descriptors to add
-        SectionDemux          _demux;             // Section demux
-        CyclingPacketizer     _pzer;              // Packetizer for modified CAT
 
-        // Invoked by the demux when a complete table is available.
-        virtual void handleTable(SectionDemux&, const BinaryTable&) override;
-        void handleCAT(CAT&);
+        // Implementation of AbstractTablePlugin.
+        virtual void modifyTable(BinaryTable&, bool&, bool&) override;
+        void processCAT(CAT&);
 
         // Inaccessible operations
         CATPlugin() = delete;
@@ -94,7 +87,7 @@ TSPLUGIN_DECLARE_PROCESSOR(cat, ts::CATPlugin)
 //----------------------------------------------------------------------------
 
 ts::CATPlugin::CATPlugin (TSP* tsp_) :
-    ProcessorPlugin(tsp_, u"Perform various transformations on the CAT", u"[options]"),
+    AbstractTablePlugin(tsp_, u"Perform various transformations on the CAT", u"[options]", u"CAT"),
     _cat_found(false),
     _pkt_current(0),
     _pkt_create_cat(0),
@@ -103,25 +96,18 @@ ts::CATPlugin::CATPlugin (TSP* tsp_) :
     _cat_bitrate(0),
     _cat_inter_pkt(0),
     _cleanup_priv_desc(false),
-    _incr_version(false),
-    _set_version(false),
-    _new_version(0),
     _remove_casid(),
     _remove_pid(),
-    _add_descs(),
-    _demux(this),
-    _pzer()
+    _add_descs()
 {
     option(u"add-ca-descriptor",          'a', STRING, 0, UNLIMITED_COUNT);
     option(u"bitrate",                    'b', POSITIVE);
     option(u"cleanup-private-descriptors", 0);
     option(u"create",                     'c');
     option(u"create-after",                0,  POSITIVE);
-    option(u"increment-version",          'i');
     option(u"inter-packet",                0,  POSITIVE);
     option(u"remove-casid",               'r', UINT16, 0, UNLIMITED_COUNT);
     option(u"remove-pid",                  0,  UINT16, 0, UNLIMITED_COUNT);
-    option(u"new-version",                'v', INTEGER, 0, 1, 0, 31);
 
     setHelp(u"Options:\n"
             u"\n"
@@ -192,13 +178,10 @@ ts::CATPlugin::CATPlugin (TSP* tsp_) :
 bool ts::CATPlugin::start()
 {
     // Get option values
-    _incr_version = present(u"increment-version");
     _create_after_ms = present(u"create") ? 1000 : intValue<MilliSecond>(u"create-after", 0);
     _cat_bitrate = intValue<BitRate>(u"bitrate", DEFAULT_CAT_BITRATE);
     _cat_inter_pkt = intValue<PacketCounter>(u"inter-packet", 0);
     _cleanup_priv_desc = present(u"cleanup-private-descriptors");
-    _set_version = present(u"new-version");
-    _new_version = intValue<uint8_t>(u"new-version", 0);
     getIntValues(_remove_casid, u"remove-casid");
     getIntValues(_remove_pid, u"remove-pid");
 
@@ -210,11 +193,11 @@ bool ts::CATPlugin::start()
         return false;
     }
 
-    // Initialize the demux and packetizer
-    _demux.reset();
-    _demux.addPID (PID_CAT);
-    _pzer.reset();
-    _pzer.setPID (PID_CAT);
+    // Initialize the table processing.
+    // Use the shared signalization of tsp when available.
+    PIDSet pids;
+    pids.set(PID_CAT);
+    startTables(PID_CAT, pids, true);
 
     // Reset other states
     _cat_found = false;
@@ -227,40 +210,40 @@ bool ts::CATPlugin::start()
 
 
 //----------------------------------------------------------------------------
-// Invoked by the demux when a complete table is available.
+// Modify a CAT, either from the TS or created from scratch.
 //----------------------------------------------------------------------------
 
-void ts::CATPlugin::handleTable (SectionDemux& demux, const BinaryTable& table)
+void ts::CATPlugin::modifyTable(BinaryTable& table, bool& is_target, bool& reinsert)
 {
-    if (table.tableId() == TID_CAT && table.sourcePID() == PID_CAT) {
-        CAT cat (table);
+    if (table.tableId() != TID_CAT) {
+        reinsert = false;
+        return;
+    }
+
+    // CAT is found, no longer try to create or insert a new one
+    _cat_found = true;
+    _pkt_insert_cat = 0;
+
+    // Modifications of the descriptor list need to deserialize the CAT.
+    if (!_remove_casid.empty() || !_remove_pid.empty() || _cleanup_priv_desc || _add_descs.count() > 0) {
+        CAT cat(table);
         if (cat.isValid()) {
-            // Process this CAT
-            handleCAT (cat);
-            // No longer try to insert new CAT packets
-            _pkt_insert_cat = 0;
+            processCAT(cat);
+            cat.serialize(table);
+        }
+        else {
+            reinsert = false;
         }
     }
 }
 
 
 //----------------------------------------------------------------------------
-// Process a new CAT
+// Apply the modifications on the descriptor list of a CAT.
 //----------------------------------------------------------------------------
 
-void ts::CATPlugin::handleCAT(CAT& cat)
+void ts::CATPlugin::processCAT(CAT& cat)
 {
-    // CAT is found, no longer try to create a new one
-    _cat_found = true;
-
-    // Modify CAT version
-    if (_incr_version) {
-        cat.version = (cat.version + 1) & 0x1F;
-    }
-    else if (_set_version) {
-        cat.version = _new_version;
-    }
-
     // Remove descriptors
     for (size_t index = cat.descs.search(DID_CA); index < cat.descs.count(); index = cat.descs.search(DID_CA, index)) {
         bool remove_it = false;
@@ -288,11 +271,6 @@ void ts::CATPlugin::handleCAT(CAT& cat)
 
     // Add descriptors
     cat.descs.add(_add_descs);
-
-    // Place modified CAT in the packetizer
-    tsp->verbose(u"CAT version %d modified", {cat.version});
-    _pzer.removeSections(TID_CAT);
-    _pzer.addTable(cat);
 }
 
 
@@ -307,8 +285,8 @@ ts::ProcessorPlugin::Status ts::CATPlugin::processPacket(TSPacket& pkt, bool& fl
     // Count packets
     _pkt_current++;
 
-    // Filter incoming sections
-    _demux.feedPacket(pkt);
+    // Filter incoming sections and replace existing CAT packets
+    const Status status = AbstractTablePlugin::processPacket(pkt, flush, bitrate_changed);
 
     // Determine when a new CAT shall be created. Executed only once, when the bitrate is known
     if (_create_after_ms > 0 && _pkt_create_cat == 0) {
@@ -318,8 +296,9 @@ ts::ProcessorPlugin::Status ts::CATPlugin::processPacket(TSPacket& pkt, bool& fl
     // Create a new CAT when necessary
     if (!_cat_found && _pkt_create_cat > 0 && _pkt_current >= _pkt_create_cat) {
         // Create a new empty CAT and process it as if it comes from the TS
-        CAT cat;
-        handleCAT(cat);
+        BinaryTable table;
+        CAT().serialize(table);
+        processTable(table);
         // Insert first CAT packet as soon as possible
         _pkt_insert_cat = _pkt_current;
     }
@@ -327,7 +306,7 @@ ts::ProcessorPlugin::Status ts::CATPlugin::processPacket(TSPacket& pkt, bool& fl
     // Insertion of CAT packets
     if (pid == PID_NULL && _pkt_insert_cat > 0 && _pkt_current >= _pkt_insert_cat) {
         // It is time to replace stuffing by a created CAT packet
-        _pzer.getNextPacket (pkt);
+        replacePacket(pkt);
         // Next CAT insertion point
         if (_cat_inter_pkt != 0) {
             // CAT packet interval was explicitly specified
@@ -343,10 +322,6 @@ ts::ProcessorPlugin::Status ts::CATPlugin::processPacket(TSPacket& pkt, bool& fl
             _pkt_insert_cat += ts_bitrate / _cat_bitrate;
         }
     }
-    else if (pid == PID_CAT) {
-        // Replace an existing CAT packet
-        _pzer.getNextPacket(pkt);
-    }
 
-    return TSP_OK;
+    return status;
 }
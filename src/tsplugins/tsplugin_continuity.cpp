@@ -34,6 +34,8 @@
 
 #include "tsPlugin.h"
 #include "tsPluginRepository.h"
+#include "tsMemoryUtils.h"
+#include "tsLogLimiter.h"
 TSDUCK_SOURCE;
 
 
@@ -48,12 +50,33 @@ namespace ts {
         // Implementation of plugin API
         ContinuityPlugin(TSP*);
         virtual bool start() override;
+        virtual bool stop() override;
         virtual Status processPacket(TSPacket&, bool&, bool&) override;
+        virtual size_t processPacketBatch(const TSPacketView&, TSPacketMetadata*, size_t, Status*, bool&, bool&) override;
 
     private:
-        UString       _tag;            // Message tag
-        PacketCounter _packet_count;   // TS packet count
-        uint8_t       _cc[PID_MAX];    // Continuity counter by PID
+        UString       _tag;                   // Message tag
+        PacketCounter _packet_count;          // TS packet count
+        PacketCounter _report_interval;       // If non-zero, report a summary of errors at this packet interval
+        PacketCounter _next_report;           // Packet count of next summary report
+        PacketCounter _errors;                // Number of discontinuities in current interval
+        PacketCounter _missing;               // Number of missing packets in current interval
+        uint8_t       _cc[PID_MAX];           // Continuity counter by PID
+        uint32_t      _pid_errors[PID_MAX];   // Number of discontinuities by PID in current interval
+        uint32_t      _pid_missing[PID_MAX];  // Number of missing packets by PID in current interval
+        LogLimiter    _log;                   // Rate-limited reporting of individual discontinuities
+
+        // Process a continuity error in the current packet.
+        void processError(PID pid, uint8_t cc);
+
+        // Report the summary of errors of an interval when its end is reached.
+        void checkInterval()
+        {
+            if (_report_interval > 0 && _packet_count >= _next_report) {
+                reportInterval();
+            }
+        }
+        void reportInterval();
 
         // Inaccessible operations
         ContinuityPlugin() = delete;
@@ -73,15 +96,33 @@ TSPLUGIN_DECLARE_PROCESSOR(continuity, ts::ContinuityPlugin)
 ts::ContinuityPlugin::ContinuityPlugin(TSP* tsp_) :
     ProcessorPlugin(tsp_, u"Check continuity counters on TS packets.", u"[options]"),
     _tag(),
-    _packet_count(0)
+    _packet_count(0),
+    _report_interval(0),
+    _next_report(0),
+    _errors(0),
+    _missing(0),
+    _cc(),
+    _pid_errors(),
+    _pid_missing(),
+    _log(*tsp_, u"PID")
 {
-    option(u"tag", 't', STRING);
+    option(u"interval", 'i', POSITIVE);
+    option(u"tag",      't', STRING);
 
     setHelp(u"Options:\n"
             u"\n"
             u"  --help\n"
             u"      Display this help text.\n"
             u"\n"
+            u"  -i value\n"
+            u"  --interval value\n"
+            u"      Do not report each discontinuity. Instead, report a summary of the\n"
+            u"      discontinuities and missing packets at regular intervals. The specified\n"
+            u"      value is a number of packets. In verbose mode, the summary is detailed\n"
+            u"      per PID. Nothing is reported for intervals without discontinuity.\n"
+            u"      Without --interval, discontinuities are individually reported, up to\n"
+            u"      10 messages per second and per PID. Additional ones are summarized.\n"
+            u"\n"
             u"  -t 'string'\n"
             u"  --tag 'string'\n"
             u"      Message tag to be displayed when packets are missing. Useful when\n"
@@ -103,10 +144,34 @@ bool ts::ContinuityPlugin::start()
     if (!_tag.empty()) {
         _tag += u": ";
     }
+    _report_interval = intValue<PacketCounter>(u"interval", 0);
+    _log.setPrefix(_tag);
 
     // Preset continuity counters to invalid values
     ::memset(_cc, 0xFF, sizeof(_cc));
 
+    // Reset interval summary
+    _packet_count = 0;
+    _next_report = _report_interval;
+    _errors = _missing = 0;
+    TS_ZERO(_pid_errors);
+    TS_ZERO(_pid_missing);
+
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Stop method
+//----------------------------------------------------------------------------
+
+bool ts::ContinuityPlugin::stop()
+{
+    // Report the last incomplete interval.
+    if (_report_interval > 0) {
+        reportInterval();
+    }
+    _log.flush();
     return true;
 }
 
@@ -130,11 +195,85 @@ ts::ProcessorPlugin::Status ts::ContinuityPlugin::processPacket (TSPacket& pkt,
         _cc[pid] != cc &&               // not a duplicated packet
         ((_cc[pid] + 1) & 0x0F) != cc)  // wrong CC
     {
-        tsp->info(u"%sTS: %'d, PID: 0x%X, missing: %d", {_tag, _packet_count, pid, (cc < _cc[pid] ? 16 : 0) + cc - _cc[pid] - 1});
+        processError(pid, cc);
     }
 
     _packet_count++;
     _cc[pid] = cc;
+    checkInterval();
 
     return TSP_OK;
 }
+
+
+//----------------------------------------------------------------------------
+// Batch packet processing method
+//----------------------------------------------------------------------------
+
+size_t ts::ContinuityPlugin::processPacketBatch(const TSPacketView& pkts, TSPacketMetadata* mdata, size_t count, Status* status, bool& flush, bool& bitrate_changed)
+{
+    // Check the whole slice at once, stopping only on continuity errors.
+    // Dropped packets (without sync byte) are ignored by the batch functions.
+    size_t start = 0;
+    while (start < count) {
+        const size_t error = start + TSPacket::CheckContinuity(pkts + start, count - start, _cc);
+        _packet_count += TSPacket::CountValidSync(pkts + start, error - start);
+        if (error < count) {
+            const PID pid = pkts[error].getPID();
+            const uint8_t cc = pkts[error].getCC();
+            processError(pid, cc);
+            _packet_count++;
+            _cc[pid] = cc;
+        }
+        start = error + 1;
+    }
+    checkInterval();
+    std::fill(status, status + count, TSP_OK);
+    return count;
+}
+
+
+//----------------------------------------------------------------------------
+// Process a continuity error in the current packet.
+//----------------------------------------------------------------------------
+
+void ts::ContinuityPlugin::processError(PID pid, uint8_t cc)
+{
+    const int missing = (cc < _cc[pid] ? 16 : 0) + cc - _cc[pid] - 1;
+
+    if (_report_interval == 0) {
+        _log.info(pid, u"%sTS: %'d, PID: 0x%X, missing: %d", {_tag, _packet_count, pid, missing});
+    }
+    else {
+        // Close the previous interval first if the error is beyond its end.
+        checkInterval();
+        _errors++;
+        _missing += missing;
+        _pid_errors[pid]++;
+        _pid_missing[pid] += missing;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Report the summary of errors of the current interval.
+//----------------------------------------------------------------------------
+
+void ts::ContinuityPlugin::reportInterval()
+{
+    if (_errors > 0) {
+        // The end of the interval may have been passed inside a batch of packets.
+        tsp->info(u"%sTS: %'d, discontinuities: %'d, missing: %'d", {_tag, std::min(_packet_count, _next_report), _errors, _missing});
+        if (tsp->verbose()) {
+            for (PID pid = 0; pid < PID_MAX; ++pid) {
+                if (_pid_errors[pid] > 0) {
+                    tsp->verbose(u"%s  PID: 0x%X, discontinuities: %'d, missing: %'d", {_tag, pid, _pid_errors[pid], _pid_missing[pid]});
+                }
+            }
+        }
+        _errors = _missing = 0;
+        TS_ZERO(_pid_errors);
+        TS_ZERO(_pid_missing);
+    }
+    _next_report = (_packet_count / _report_interval + 1) * _report_interval;
+}
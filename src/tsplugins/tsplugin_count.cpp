@@ -52,6 +52,7 @@ namespace ts {
         virtual bool start() override;
         virtual bool stop() override;
         virtual Status processPacket(TSPacket&, bool&, bool&) override;
+        virtual size_t processPacketBatch(const TSPacketView&, TSPacketMetadata*, size_t, Status*, bool&, bool&) override;
 
     private:
         // This structure is used at each --interval.
@@ -327,3 +328,35 @@ ts::ProcessorPlugin::Status ts::CountPlugin::processPacket(TSPacket& pkt, bool&
     _current_pkt++;
     return TSP_OK;
 }
+
+
+//----------------------------------------------------------------------------
+// Batch packet processing method
+//----------------------------------------------------------------------------
+
+size_t ts::CountPlugin::processPacketBatch(const TSPacketView& pkts, TSPacketMetadata* mdata, size_t count, Status* status, bool& flush, bool& bitrate_changed)
+{
+    // Periodic and per-packet reports need the packet-by-packet processing.
+    if (_report_all || _report_interval > 0) {
+        return ProcessorPlugin::processPacketBatch(pkts, mdata, count, status, flush, bitrate_changed);
+    }
+
+    // Otherwise, simply count packets on the whole slice.
+    // When all PID's are selected, build the PID histogram in one pass.
+    if (_negate ? _pids.none() : _pids.all()) {
+        _current_pkt += TSPacket::CountPIDs(pkts, count, _counters);
+    }
+    else {
+        for (size_t i = 0; i < count; ++i) {
+            if (pkts[i].b[0] != 0) {
+                const PID pid = pkts[i].getPID();
+                if (_pids[pid] != _negate) {
+                    _counters[pid]++;
+                }
+                _current_pkt++;
+            }
+        }
+    }
+    std::fill(status, status + count, TSP_OK);
+    return count;
+}
@@ -38,14 +38,17 @@
 #include "tsEMMGMUX.h"
 #include "tstlvConnection.h"
 #include "tsTCPServer.h"
-#include "tsMessageQueue.h"
+#include "tsUDPSocket.h"
 #include "tsDoubleCheckLock.h"
+#include "tsGuard.h"
 #include "tsThread.h"
 TSDUCK_SOURCE;
 
 #define DEFAULT_PACKET_QUEUE_SIZE 100  // Maximum number of TS packets in queue
 #define SERVER_BACKLOG            1    // One connection at a time
 #define SERVER_THREAD_STACK_SIZE  (128 * 1024)
+#define UDP_MAX_MESSAGE_SIZE      65536 // Maximum size of a UDP data_provision message
+#define UDP_RECEIVE_SLOTS         16    // Number of UDP messages received at a time
 
 
 //----------------------------------------------------------------------------
@@ -63,8 +66,19 @@ namespace ts {
         virtual Status processPacket(TSPacket&, bool&, bool&) override;
 
     private:
-        typedef MessageQueue<TSPacket, Mutex> TSPacketQueue;
-        typedef TSPacketQueue::MessagePtr TSPacketPtr;
+        // Thread receiving data_provision messages over UDP.
+        class UDPThread: public Thread
+        {
+        public:
+            UDPThread(DataInjectPlugin* parent);
+            virtual ~UDPThread();
+        private:
+            DataInjectPlugin* const _parent;
+            virtual void main() override;
+            UDPThread() = delete;
+            UDPThread(const UDPThread&) = delete;
+            UDPThread& operator=(const UDPThread&) = delete;
+        };
 
         // Plugin private data
         PacketCounter   _pkt_current;      // Current TS packet index
@@ -76,25 +90,46 @@ namespace ts {
         BitRate         _req_bitrate_prot; // Protected reference version of _req_bitrate
                                            // (reader: plugin thread, writer: server thread)
         DoubleCheckLock _req_bitrate_lock; // Lock for _req_bitrate_prot
-        size_t          _lost_packets;     // Lost packets (queue full, used by server thread only)
-        TSPacketQueue   _queue;            // Queue of incoming TS packets
         TCPServer       _server;           // EMMG/PDG <=> MUX TCP server
         tlv::Connection<Mutex> _client;    // Connection with EMMG/PDG client
+        bool            _use_udp;          // Also receive data_provision messages over UDP
+        SocketAddress   _udp_address;      // Local UDP address for data_provision messages
+        UDPSocket       _udp_server;       // UDP socket for data_provision messages
+        UDPThread       _udp_thread;       // Thread receiving UDP messages
+        volatile bool   _udp_terminate;    // Request termination of UDP thread
+
+        // Queue of incoming TS packets: a circular buffer which is allocated once.
+        // The mutex also protects the state of the EMMG/PDG stream since
+        // data_provision messages can be received by the TCP and UDP threads.
+        Mutex           _mutex;            // Protect all fields below.
+        TSPacketVector  _queue;            // Circular buffer of packets
+        size_t          _queue_first;      // Index of first packet in _queue
+        size_t          _queue_count;      // Number of packets in _queue
+        size_t          _lost_packets;     // Lost packets (queue full)
+        bool            _stream_ok;        // The EMMG/PDG stream is setup
+        bool            _section_mode;     // Data provisions contain sections, not TS packets
 
         // Invoked in the context of the server thread.
         virtual void main() override;
 
+        // Invoked in the context of the UDP thread.
+        void udpMain();
+
+        // Set the stream state. Invoked in the server thread.
+        void setStreamState(bool stream_ok, bool section_mode);
+
         // Process bandwidth request. Invoked in the server thread.
         // Return true on success, false on error.
         bool processBandwidthRequest(const emmgmux::StreamBWRequest&);
 
-        // Process data provision. Invoked in the server thread.
+        // Process data provision. The datagrams are analyzed in place in the message.
+        // Invoked in the server thread or the UDP thread.
         // Return true on success, false on error.
-        bool processDataProvision(const emmgmux::DataProvision&, bool section_mode);
+        bool processDataProvision(const tlv::MessageFactory&);
 
-        // Enqueue a TS packet. Invoked in the server thread.
+        // Enqueue TS packets. Invoked in the server thread or the UDP thread.
         // Return true on success, false on error.
-        bool enqueuePacket(const TSPacketPtr&);
+        bool enqueuePackets(const TSPacket* pkts, size_t count);
 
         // Inaccessible operations
         DataInjectPlugin() = delete;
@@ -122,10 +157,20 @@ ts::DataInjectPlugin::DataInjectPlugin (TSP* tsp_) :
     _req_bitrate(0),
     _req_bitrate_prot(0),
     _req_bitrate_lock(),
-    _lost_packets(0),
-    _queue(),
     _server(),
-    _client(emmgmux::Protocol::Instance(), true, 3)
+    _client(emmgmux::Protocol::Instance(), true, 3),
+    _use_udp(false),
+    _udp_address(),
+    _udp_server(),
+    _udp_thread(this),
+    _udp_terminate(false),
+    _mutex(),
+    _queue(),
+    _queue_first(0),
+    _queue_count(0),
+    _lost_packets(0),
+    _stream_ok(false),
+    _section_mode(false)
 {
     option(u"bitrate-max",      'b', POSITIVE);
     option(u"emmg-mux-version", 'v', INTEGER, 0, 1, 2, 3);
@@ -133,6 +178,7 @@ ts::DataInjectPlugin::DataInjectPlugin (TSP* tsp_) :
     option(u"queue-size",       'q', UINT32);
     option(u"reuse-port",       'r');
     option(u"server",           's', STRING, 1, 1);
+    option(u"udp",              'u', STRING);
 
     setHelp(u"Options:\n"
             u"\n"
@@ -173,6 +219,14 @@ ts::DataInjectPlugin::DataInjectPlugin (TSP* tsp_) :
             u"      interface). This plugin behaves as a MUX, ie. a TCP server, and accepts\n"
             u"      only one EMMG/PDG connection at a time.\n"
             u"\n"
+            u"  -u [address:]port\n"
+            u"  --udp [address:]port\n"
+            u"      Specifies the local UDP port on which the plugin receives data_provision\n"
+            u"      messages, in addition to the TCP connection. The DVB SimulCrypt standard\n"
+            u"      allows the EMMG/PDG to send data_provision messages over UDP. The channel\n"
+            u"      and stream must still be setup on the TCP connection. When present, the\n"
+            u"      optional address shall specify a local IP address or host name.\n"
+            u"\n"
             u"  --version\n"
             u"      Display the version number.\n");
 }
@@ -187,7 +241,15 @@ bool ts::DataInjectPlugin::start()
     // Command line options
     _max_bitrate = intValue<BitRate>(u"bitrate-max", 0);
     _data_pid = intValue<PID>(u"pid");
-    _queue.setMaxMessages(intValue<size_t>(u"queue-size", DEFAULT_PACKET_QUEUE_SIZE));
+    _use_udp = present(u"udp");
+
+    // Allocate the packet queue once.
+    _queue.resize(std::max<size_t>(1, intValue<size_t>(u"queue-size", DEFAULT_PACKET_QUEUE_SIZE)));
+    _queue_first = 0;
+    _queue_count = 0;
+    _lost_packets = 0;
+    _stream_ok = false;
+    _section_mode = false;
 
     // Specify which EMMG/PDG <=> MUX version to use.
     emmgmux::Protocol::Instance()->setVersion(intValue<tlv::VERSION>(u"emmg-mux-version", 2));
@@ -205,6 +267,19 @@ bool ts::DataInjectPlugin::start()
         return false;
     }
 
+    // Initialize the UDP server
+    if (_use_udp) {
+        if (!_udp_address.resolve(value(u"udp"), *tsp) || !_udp_server.open(*tsp)) {
+            _server.close(*tsp);
+            return false;
+        }
+        if (!_udp_server.reusePort(present(u"reuse-port"), *tsp) || !_udp_server.bind(_udp_address, *tsp)) {
+            _udp_server.close(*tsp);
+            _server.close(*tsp);
+            return false;
+        }
+    }
+
     // Initial bandwidth allocation (zero means unlimited)
     _req_bitrate = _max_bitrate;
     _req_bitrate_prot = _max_bitrate;
@@ -212,12 +287,15 @@ bool ts::DataInjectPlugin::start()
 
     // TS processing state
     _data_cc = 0;
-    _lost_packets = 0;
     _pkt_current = 0;
     _pkt_next_data = 0;
 
-    // Start the internal thread.
+    // Start the internal threads.
     Thread::start();
+    if (_use_udp) {
+        _udp_terminate = false;
+        _udp_thread.start();
+    }
 
     return true;
 }
@@ -238,6 +316,16 @@ bool ts::DataInjectPlugin::stop()
     // Wait for actual thread termination
     Thread::waitForTermination();
 
+    // The UDP thread is blocked in a reception, send it an empty message to wake it up.
+    if (_use_udp) {
+        _udp_terminate = true;
+        UDPSocket sock(true, NULLREP);
+        const SocketAddress dest(_udp_address.hasAddress() ? IPAddress(_udp_address) : IPAddress::LocalHost, _udp_address.port());
+        sock.send("", 0, dest, NULLREP);
+        _udp_thread.waitForTermination();
+        _udp_server.close(NULLREP);
+    }
+
     return true;
 }
 
@@ -275,10 +363,17 @@ ts::ProcessorPlugin::Status ts::DataInjectPlugin::processPacket (TSPacket& pkt,
     // Try to insert data
     if (_pkt_next_data <= _pkt_current) {
         // Time to insert data packet, if any is available immediately.
-        TSPacketPtr pp;
-        if (_queue.dequeue(pp, 0)) {
-            // Update data packet
-            pkt = *pp;
+        bool available = false;
+        {
+            Guard lock(_mutex);
+            if (_queue_count > 0) {
+                available = true;
+                pkt = _queue[_queue_first];
+                _queue_first = (_queue_first + 1) % _queue.size();
+                _queue_count--;
+            }
+        }
+        if (available) {
             // Update PID and continuity counter.
             pkt.setPID(_data_pid);
             pkt.setCC(_data_cc);
@@ -316,10 +411,29 @@ void ts::DataInjectPlugin::main()
         bool ok = true;
         bool channel_ok = false;
         bool stream_ok = false;
+        ByteBlock buffer;
+        tlv::MessageFactoryPtr mf;
         tlv::MessagePtr msg;
 
         // Loop on message reception from the client
-        while (ok && _client.receive(msg, tsp, *tsp)) {
+        while (ok && _client.receive(buffer, mf, tsp, *tsp)) {
+
+            // The data_provision messages are directly processed in the reception buffer.
+            // All other messages are rebuilt.
+            if (mf->commandTag() == emmgmux::Tags::data_provision) {
+                if (!stream_ok) {
+                    tsp->error(u"unexpected data_provision, stream not setup");
+                    ok = false;
+                }
+                else {
+                    ok = processDataProvision(*mf);
+                }
+                continue;
+            }
+            mf->factory(msg);
+            if (tsp->debug()) {
+                tsp->debug(u"received message from %s\n%s", {_client.peerName(), msg->dump(4)});
+            }
 
             // Message handling.
             // We do not send errors back to client, we just disconnect
@@ -359,6 +473,7 @@ void ts::DataInjectPlugin::main()
                 case emmgmux::Tags::channel_close: {
                     channel_ok = false;
                     stream_ok = false;
+                    setStreamState(false, false);
                     break;
                 }
 
@@ -382,6 +497,7 @@ void ts::DataInjectPlugin::main()
                         stream_status.data_type = m->data_type;
                         ok = _client.send (stream_status, *tsp);
                         stream_ok = true;
+                        setStreamState(true, channel_status.section_TSpkt_flag == 0);
                     }
                     break;
                 }
@@ -413,6 +529,7 @@ void ts::DataInjectPlugin::main()
                         resp.client_id = m->client_id;
                         ok = _client.send (resp, *tsp);
                         stream_ok = false;
+                        setStreamState(false, false);
                     }
                     break;
                 }
@@ -430,19 +547,6 @@ void ts::DataInjectPlugin::main()
                     break;
                 }
 
-                case emmgmux::Tags::data_provision: {
-                    if (!stream_ok) {
-                        tsp->error(u"unexpected data_provision, stream not setup");
-                        ok = false;
-                    }
-                    else {
-                        emmgmux::DataProvision* m = dynamic_cast <emmgmux::DataProvision*> (msg.pointer());
-                        assert(m != 0);
-                        ok = processDataProvision(*m, channel_status.section_TSpkt_flag == 0);
-                    }
-                    break;
-                }
-
                 default: {
                     break;
                 }
@@ -450,6 +554,7 @@ void ts::DataInjectPlugin::main()
         }
 
         // Error while receiving messages during a client session, most likely a disconnection
+        setStreamState(false, false);
         _client.disconnect(NULLREP);
         _client.close(NULLREP);
     }
@@ -486,51 +591,127 @@ bool ts::DataInjectPlugin::processBandwidthRequest(const emmgmux::StreamBWReques
 
 
 //----------------------------------------------------------------------------
-// Process data provision. Invoked in the server thread.
+// Set the stream state. Invoked in the server thread.
+//----------------------------------------------------------------------------
+
+void ts::DataInjectPlugin::setStreamState(bool stream_ok, bool section_mode)
+{
+    Guard lock(_mutex);
+    _stream_ok = stream_ok;
+    _section_mode = section_mode;
+}
+
+
+//----------------------------------------------------------------------------
+// Invoked in the context of the UDP thread.
+//----------------------------------------------------------------------------
+
+ts::DataInjectPlugin::UDPThread::UDPThread(DataInjectPlugin* parent) :
+    Thread(ThreadAttributes().setStackSize(SERVER_THREAD_STACK_SIZE)),
+    _parent(parent)
+{
+}
+
+ts::DataInjectPlugin::UDPThread::~UDPThread()
+{
+    waitForTermination();
+}
+
+void ts::DataInjectPlugin::UDPThread::main()
+{
+    _parent->udpMain();
+}
+
+void ts::DataInjectPlugin::udpMain()
+{
+    tsp->debug(u"UDP server thread started");
+
+    // Reception buffers, several messages are received at a time.
+    ByteBlock buffer(UDP_RECEIVE_SLOTS * UDP_MAX_MESSAGE_SIZE);
+    UDPSocket::ReceiveSlotVector slots;
+    for (size_t i = 0; i < UDP_RECEIVE_SLOTS; ++i) {
+        slots.push_back(UDPSocket::ReceiveSlot(&buffer[i * UDP_MAX_MESSAGE_SIZE], UDP_MAX_MESSAGE_SIZE));
+    }
+
+    size_t count = 0;
+    while (!_udp_terminate && _udp_server.receive(slots, count, tsp, *tsp)) {
+        for (size_t i = 0; !_udp_terminate && i < count; ++i) {
+            // Analyze the message in place, only data_provision messages are allowed on UDP.
+            tlv::MessageFactory mf(slots[i].data, slots[i].ret_size, emmgmux::Protocol::Instance());
+            bool stream_ok = false;
+            {
+                Guard lock(_mutex);
+                stream_ok = _stream_ok;
+            }
+            if (mf.errorStatus() != tlv::OK) {
+                tsp->error(u"received invalid message from %s (%d bytes)", {slots[i].sender.toString(), slots[i].ret_size});
+            }
+            else if (mf.commandTag() != emmgmux::Tags::data_provision) {
+                tsp->error(u"unexpected message tag 0x%X over UDP from %s", {mf.commandTag(), slots[i].sender.toString()});
+            }
+            else if (!stream_ok) {
+                tsp->error(u"unexpected data_provision, stream not setup");
+            }
+            else {
+                processDataProvision(mf);
+            }
+        }
+    }
+
+    tsp->debug(u"UDP server thread completed");
+}
+
+
+//----------------------------------------------------------------------------
+// Process data provision. Invoked in the server thread or the UDP thread.
 // Return true on success, false on error.
 //----------------------------------------------------------------------------
 
-bool ts::DataInjectPlugin::processDataProvision (const emmgmux::DataProvision& msg, bool section_mode)
+bool ts::DataInjectPlugin::processDataProvision(const tlv::MessageFactory& mf)
 {
     bool ok = true;
+    bool section_mode = false;
+    {
+        Guard lock(_mutex);
+        section_mode = _section_mode;
+    }
+
+    // Locate the datagrams in the message.
+    std::vector<tlv::MessageFactory::Parameter> datagrams;
+    mf.get(emmgmux::Tags::datagram, datagrams);
 
     if (section_mode) {
         // Feed a packetizer with all section (one section per datagram parameter)
         OneShotPacketizer pzer;
-        for (size_t i = 0; i < msg.datagram.size(); ++i) {
-            SectionPtr sp (new Section (msg.datagram[i]));
+        for (size_t i = 0; i < datagrams.size(); ++i) {
+            SectionPtr sp(new Section(datagrams[i].addr, datagrams[i].length));
             if (sp->isValid()) {
-                pzer.addSection (sp);
+                pzer.addSection(sp);
             }
             else {
-                tsp->error(u"received an invalid section (%d bytes)", {msg.datagram[i]->size()});
+                tsp->error(u"received an invalid section (%d bytes)", {datagrams[i].length});
             }
         }
         // Extract all packets and enqueue them
         TSPacketVector pv;
-        pzer.getPackets (pv);
-        for (size_t i = 0; i < pv.size(); ++i) {
-            ok = enqueuePacket (new TSPacket (pv[i])) && ok;
-        }
+        pzer.getPackets(pv);
+        ok = enqueuePackets(pv.data(), pv.size());
     }
     else {
-        // Packet mode, locate packets and enqueue them
-        for (size_t i = 0; i < msg.datagram.size(); ++i) {
-            const uint8_t* data = msg.datagram[i]->data();
-            size_t size = msg.datagram[i]->size();
-            while (size >= PKT_SIZE) {
-                if (*data != SYNC_BYTE) {
-                    tsp->error(u"invalid TS packet");
-                }
-                else {
-                    TSPacketPtr p (new TSPacket());
-                    ::memcpy (p->b, data, PKT_SIZE);
-                    ok = enqueuePacket (p) && ok;
-                    data += PKT_SIZE;
-                    size -= PKT_SIZE;
-                }
+        // Packet mode, locate packets and enqueue them directly from the message.
+        for (size_t i = 0; i < datagrams.size(); ++i) {
+            const uint8_t* data = reinterpret_cast<const uint8_t*>(datagrams[i].addr);
+            size_t size = datagrams[i].length;
+            size_t count = 0;
+            while (count * PKT_SIZE + PKT_SIZE <= size && data[count * PKT_SIZE] == SYNC_BYTE) {
+                count++;
             }
-            if (size != 0) {
+            ok = enqueuePackets(reinterpret_cast<const TSPacket*>(data), count) && ok;
+            size -= count * PKT_SIZE;
+            if (size >= PKT_SIZE) {
+                tsp->error(u"invalid TS packet");
+            }
+            else if (size != 0) {
                 tsp->error(u"extraneous %d bytes in datagram", {size});
             }
         }
@@ -541,22 +722,46 @@ bool ts::DataInjectPlugin::processDataProvision (const emmgmux::DataProvision& m
 
 
 //----------------------------------------------------------------------------
-// Enqueue a TS packet. Invoked in the server thread.
+// Enqueue TS packets. Invoked in the server thread or the UDP thread.
 // Return true on success, false on error.
 //----------------------------------------------------------------------------
 
-bool ts::DataInjectPlugin::enqueuePacket (const TSPacketPtr& pkt)
+bool ts::DataInjectPlugin::enqueuePackets(const TSPacket* pkts, size_t count)
 {
-    // Enqueue packet immediately or fail.
-    const bool ok = _queue.enqueue(pkt, 0);
+    size_t enqueued = 0;
+    size_t recovered = 0;
+    bool first_loss = false;
+    {
+        Guard lock(_mutex);
+
+        // Enqueue packets immediately or drop them, in at most two contiguous chunks.
+        const size_t size = _queue.size();
+        enqueued = std::min(count, size - _queue_count);
+        size_t next = (_queue_first + _queue_count) % size;
+        for (size_t done = 0; done < enqueued; ) {
+            const size_t chunk = std::min(enqueued - done, size - next);
+            std::copy(pkts + done, pkts + done + chunk, &_queue[next]);
+            next = (next + chunk) % size;
+            done += chunk;
+        }
+        _queue_count += enqueued;
 
-    if (!ok && _lost_packets++ == 0) {
-        tsp->warning(u"internal queue overflow, losing packets, consider using --queue-size");
-    }
-    else if (ok && _lost_packets != 0) {
-        tsp->info(u"retransmitting after %'d lost packets", {_lost_packets});
-        _lost_packets = 0;
+        // Track lost packets.
+        if (enqueued > 0 && _lost_packets != 0) {
+            recovered = _lost_packets;
+            _lost_packets = 0;
+        }
+        if (enqueued < count) {
+            first_loss = _lost_packets == 0;
+            _lost_packets += count - enqueued;
+        }
     }
 
-    return ok;
+    if (recovered != 0) {
+        tsp->info(u"retransmitting after %'d lost packets", {recovered});
+    }
+    if (first_loss) {
+        tsp->warning(u"internal queue overflow, losing packets, consider using --queue-size");
+    }
+    return enqueued == count;
 }
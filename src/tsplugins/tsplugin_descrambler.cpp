@@ -36,6 +36,7 @@
 #include "tsPluginRepository.h"
 #include "tsScrambling.h"
 #include "tsByteBlock.h"
+#include "tsLogLimiter.h"
 TSDUCK_SOURCE;
 
 
@@ -50,6 +51,7 @@ namespace ts {
         // Implementation of plugin API
         DescramblerPlugin (TSP*);
         virtual bool start() override;
+        virtual bool stop() override;
         virtual Status processPacket (TSPacket&, bool&, bool&) override;
 
     private:
@@ -59,6 +61,7 @@ namespace ts {
         Scrambling                     _key;      // Preprocessed current control word
         uint8_t                        _last_scv; // Scrambling_control_value in last packet
         PIDSet                         _pids;     // List of PID's to descramble
+        LogLimiter                     _log;      // Rate-limited reporting of invalid packets
 
         // Inaccessible operations
         DescramblerPlugin() = delete;
@@ -82,7 +85,8 @@ ts::DescramblerPlugin::DescramblerPlugin(TSP* tsp_) :
     _next_cw(),
     _key(),
     _last_scv(0),
-    _pids()
+    _pids(),
+    _log(*tsp_, u"PID")
 {
     option(u"cw",                   'c', STRING);
     option(u"cw-file",              'f', STRING);
@@ -173,6 +177,17 @@ bool ts::DescramblerPlugin::start()
 }
 
 
+//----------------------------------------------------------------------------
+// Stop method
+//----------------------------------------------------------------------------
+
+bool ts::DescramblerPlugin::stop()
+{
+    _log.flush();
+    return true;
+}
+
+
 //----------------------------------------------------------------------------
 // Packet processing method
 //----------------------------------------------------------------------------
@@ -191,7 +206,7 @@ ts::ProcessorPlugin::Status ts::DescramblerPlugin::processPacket(TSPacket& pkt,
     // Do not modify packet if not scrambled
     if (scv != SC_EVEN_KEY && scv != SC_ODD_KEY) {
         if (scv != SC_CLEAR) {
-            tsp->debug(u"invalid scrambling_control_value %d in PID 0x%X", {scv, pkt.getPID()});
+            _log.debug(pkt.getPID(), u"invalid scrambling_control_value %d in PID 0x%X", {scv, pkt.getPID()});
         }
         return TSP_OK;
     }
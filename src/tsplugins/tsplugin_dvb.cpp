@@ -37,6 +37,8 @@
 #include "tsTuner.h"
 #include "tsTunerArgs.h"
 #include "tsTunerParameters.h"
+#include "tsServiceDiscovery.h"
+#include "tsSignalMonitor.h"
 #include "tsSysUtils.h"
 #include "tsCOM.h"
 TSDUCK_SOURCE;
@@ -47,7 +49,7 @@ TSDUCK_SOURCE;
 //----------------------------------------------------------------------------
 
 namespace ts {
-    class DVBInput: public InputPlugin
+    class DVBInput: public InputPlugin, private PMTHandlerInterface
     {
     public:
         // Implementation of plugin API
@@ -61,11 +63,40 @@ namespace ts {
         virtual size_t stackUsage() const override {return 512 * 1024;} // 512 kB
 
     private:
+        // Background monitoring of the tuner signal and current tuning parameters.
+        class TunerMonitor: public SignalMonitor
+        {
+        public:
+            TunerMonitor(DVBInput* plugin);
+            virtual ~TunerMonitor() override;
+        private:
+            DVBInput*          _plugin;
+            TunerParametersPtr _params;            // Current tuning parameters, as reported by the tuner
+            BitRate            _previous_bitrate;  // Previous theoretical bitrate
+            virtual void pollDevice() override;
+
+            // Inaccessible operations
+            TunerMonitor() = delete;
+            TunerMonitor(const TunerMonitor&) = delete;
+            TunerMonitor& operator=(const TunerMonitor&) = delete;
+        };
+        typedef SafePtr<TunerMonitor, NullMutex> TunerMonitorPtr;
+
         COM                _com;              // COM initialization helper
         Tuner              _tuner;            // DVB tuner device
         TunerArgs          _tuner_args;       // Command-line tuning arguments
         TunerParametersPtr _tuner_params;     // Tuning parameters
-        BitRate            _previous_bitrate; // Previous value from getBitrate()
+        TunerMonitorPtr    _monitor;          // Signal monitoring thread, during reception
+        bool               _pid_filtering;    // Hardware PID filtering is used
+        PIDSet             _fixed_pids;       // PID's to always receive (--pid and PSI of --service)
+        PIDSet             _service_pids;     // PID's of the selected service, from its PMT
+        ServiceDiscovery   _service;          // Service to receive (--service)
+
+        // Implementation of PMTHandlerInterface.
+        virtual void handlePMT(const PMT&) override;
+
+        // Update the hardware PID filter of the tuner if the set of PID's to receive has changed.
+        bool updatePIDFilter();
 
         // Inaccessible operations
         DVBInput() = delete;
@@ -88,13 +119,35 @@ ts::DVBInput::DVBInput(TSP* tsp_) :
     _tuner(),
     _tuner_args(false, true),
     _tuner_params(),
-    _previous_bitrate(0)
+    _monitor(),
+    _pid_filtering(false),
+    _fixed_pids(),
+    _service_pids(),
+    _service(this, *tsp)
 {
+    option(u"pid", 0, PIDVAL, 0, UNLIMITED_COUNT);
+    option(u"service", 0, STRING);
+
     setHelp(u"Options:\n"
             u"\n"
             u"  --help\n"
             u"      Display this help text.\n"
             u"\n"
+            u"  --pid value\n"
+            u"      Receive only the specified PID's. Several --pid options may be specified.\n"
+            u"      The other PID's are dropped by the demux filters of the DVB adapter and\n"
+            u"      do not cross the bus. By default, the full transport stream is received.\n"
+            u"      Hardware PID filtering is currently implemented on Linux only.\n"
+            u"\n"
+            u"  --service name-or-id\n"
+            u"      Receive only the PID's of the specified service: PAT, PMT, PCR, all\n"
+            u"      components and ECM's, plus the SDT if the service is specified by name.\n"
+            u"      The PID filter is updated when the PMT changes. If the argument is an\n"
+            u"      integer value (either decimal or hexadecimal), it is interpreted as a\n"
+            u"      service id. Otherwise, it is interpreted as a service name, as specified\n"
+            u"      in the SDT. The name is not case sensitive and blanks are ignored. Can be\n"
+            u"      combined with --pid.\n"
+            u"\n"
             u"  --version\n"
             u"      Display the version number.\n");
 
@@ -127,8 +180,17 @@ bool ts::DVBInput::start()
         return false;
     }
 
-    // Reinitialize other states
-    _previous_bitrate = 0;
+    // Get PID filtering options.
+    getPIDSet(_fixed_pids, u"pid");
+    _service.set(value(u"service"));
+    _service_pids.reset();
+    if (_service.hasName()) {
+        _fixed_pids.set(PID_SDT);
+    }
+    if (_service.hasName() || _service.hasId()) {
+        _fixed_pids.set(PID_PAT);
+    }
+    _pid_filtering = _fixed_pids.any();
 
     // Open DVB tuner
     if (!_tuner_args.configureTuner(_tuner, *tsp)) {
@@ -143,6 +205,12 @@ bool ts::DVBInput::start()
     }
     tsp->verbose(u"tuned to transponder %s", {_tuner_params->toPluginOptions()});
 
+    // Set the initial hardware PID filter.
+    if (!_tuner.setPIDFilter(_pid_filtering ? _fixed_pids : AllPIDs, *tsp)) {
+        stop();
+        return false;
+    }
+
     // Start receiving packets
     tsp->debug(u"starting tuner reception");
     if (!_tuner.start(*tsp)) {
@@ -151,6 +219,15 @@ bool ts::DVBInput::start()
     }
     tsp->debug(u"tuner reception started");
 
+    // Start monitoring the signal in the background. The input path never
+    // waits for the frontend, which may be slow on some drivers.
+    _monitor = new TunerMonitor(this);
+    if (!_monitor->start()) {
+        tsp->error(u"cannot start tuner monitoring thread");
+        stop();
+        return false;
+    }
+
     return true;
 }
 
@@ -161,6 +238,10 @@ bool ts::DVBInput::start()
 
 bool ts::DVBInput::stop()
 {
+    if (!_monitor.isNull()) {
+        _monitor->stop();
+        _monitor.clear();
+    }
     _tuner.stop(*tsp);
     _tuner.close(*tsp);
     return true;
@@ -175,27 +256,65 @@ ts::BitRate ts::DVBInput::getBitrate()
 {
     // The bitrate is entirely based on the transponder characteristics
     // such as symbol rate, number of bits per symbol (modulation),
-    // number of used bits vs. transported bits (FEC), etc.
+    // number of used bits vs. transported bits (FEC), etc. It is
+    // periodically computed by the monitoring thread.
+    // With PID filtering, the transponder bitrate is meaningless,
+    // let tsp evaluate it from the PCR's.
 
-    // Get current tuning information
-    if (!_tuner.getCurrentTuning (*_tuner_params, false, *tsp)) {
-        return 0; // error
-    }
+    return _pid_filtering || _monitor.isNull() ? 0 : _monitor->bitrate();
+}
+
+
+//----------------------------------------------------------------------------
+// Tuner monitoring thread.
+//----------------------------------------------------------------------------
+
+ts::DVBInput::TunerMonitor::TunerMonitor(DVBInput* plugin) :
+    SignalMonitor(plugin->_tuner.deviceName()),
+    _plugin(plugin),
+    _params(TunerParameters::Factory(plugin->_tuner_params->tunerType())),
+    _previous_bitrate(0)
+{
+    _params->copy(*plugin->_tuner_params);
+}
 
-    // Let the TunerParameters subclass compute the bitrate
-    BitRate bitrate = _tuner_params->theoreticalBitrate();
+ts::DVBInput::TunerMonitor::~TunerMonitor()
+{
+    stop();
+}
+
+void ts::DVBInput::TunerMonitor::pollDevice()
+{
+#if defined(TS_WINDOWS)
+    // The DirectShow interfaces of the tuner are used from this thread.
+    COM com(*_plugin->tsp);
+#endif
+
+    Tuner& tuner(_plugin->_tuner);
+    TSP* const tsp = _plugin->tsp;
+
+    setSignalLocked(tuner.signalLocked(NULLREP));
+    setSignalStrength(tuner.signalStrength(NULLREP));
+    setSignalQuality(tuner.signalQuality(NULLREP));
+
+    // Get current tuning information and let the TunerParameters subclass compute the bitrate.
+    if (!tuner.getCurrentTuning(*_params, false, *tsp)) {
+        return;
+    }
+    const BitRate bitrate = _params->theoreticalBitrate();
 
     // When bitrate changes, the modulation parameters have changed
     if (bitrate != _previous_bitrate && tsp->verbose()) {
         // Store the new parameters in a global repository (may be used by other plugins)
-        TunerParameters* new_params(TunerParameters::Factory(_tuner_params->tunerType()));
-        new_params->copy(*_tuner_params);
+        TunerParameters* new_params(TunerParameters::Factory(_params->tunerType()));
+        new_params->copy(*_params);
         Object::StoreInRepository(u"tsp.dvb.params", ObjectPtr(new_params));
         // Display new tuning info
         tsp->verbose(u"actual tuning options: " + new_params->toPluginOptions());
     }
 
-    return _previous_bitrate = bitrate;
+    _previous_bitrate = bitrate;
+    setBitrate(bitrate);
 }
 
 
@@ -203,7 +322,62 @@ ts::BitRate ts::DVBInput::getBitrate()
 // Input method
 //----------------------------------------------------------------------------
 
-size_t ts::DVBInput::receive (TSPacket* buffer, size_t max_packets)
+size_t ts::DVBInput::receive(TSPacket* buffer, size_t max_packets)
+{
+    const size_t count = _tuner.receive(buffer, max_packets, tsp, *tsp);
+
+    // When a service is selected, analyze its PSI and adjust the PID filter.
+    if (_service.hasName() || _service.hasId()) {
+        for (size_t i = 0; i < count; ++i) {
+            _service.feedPacket(buffer[i]);
+        }
+        if (!updatePIDFilter()) {
+            return 0;
+        }
+    }
+    return count;
+}
+
+
+//----------------------------------------------------------------------------
+// Invoked when the PMT of the service is available.
+//----------------------------------------------------------------------------
+
+void ts::DVBInput::handlePMT(const PMT& pmt)
+{
+    // Collect all PID's of the service. The PMT PID itself is added in updatePIDFilter().
+    _service_pids.reset();
+    if (pmt.pcr_pid != PID_NULL) {
+        _service_pids.set(pmt.pcr_pid);
+    }
+
+    // Collect ECM PID's from the CA descriptors at program and component level.
+    std::vector<const DescriptorList*> dlists(1, &pmt.descs);
+    for (PMT::StreamMap::const_iterator it = pmt.streams.begin(); it != pmt.streams.end(); ++it) {
+        _service_pids.set(it->first);
+        dlists.push_back(&it->second.descs);
+    }
+    for (std::vector<const DescriptorList*>::const_iterator dl = dlists.begin(); dl != dlists.end(); ++dl) {
+        const DescriptorList& descs(**dl);
+        for (size_t index = descs.search(DID_CA); index < descs.count(); index = descs.search(DID_CA, index + 1)) {
+            if (descs[index]->payloadSize() >= 4) {
+                _service_pids.set(GetUInt16(descs[index]->payload() + 2) & 0x1FFF);
+            }
+        }
+    }
+    tsp->verbose(u"service 0x%X (%d): receiving %d PID's", {pmt.service_id, pmt.service_id, _service_pids.count()});
+}
+
+
+//----------------------------------------------------------------------------
+// Update the hardware PID filter of the tuner.
+//----------------------------------------------------------------------------
+
+bool ts::DVBInput::updatePIDFilter()
 {
-    return _tuner.receive (buffer, max_packets, tsp, *tsp);
+    PIDSet pids(_fixed_pids | _service_pids);
+    if (_service.hasPMTPID()) {
+        pids.set(_service.getPMTPID());
+    }
+    return pids == _tuner.pidFilter() || _tuner.setPIDFilter(pids, *tsp);
 }
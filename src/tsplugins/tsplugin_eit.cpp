@@ -39,6 +39,7 @@
 #include "tsTables.h"
 #include "tsTime.h"
 #include "tsMJD.h"
+#include "tsNames.h"
 TSDUCK_SOURCE;
 
 
@@ -65,11 +66,15 @@ namespace ts {
             ServiceDesc();
 
             // Public fields
-            SectionCounter eitpf_count;
-            SectionCounter eits_count;
-            MilliSecond    max_time;    // Max time ahead of current time for EIT
+            SectionCounter     eitpf_count;
+            SectionCounter     eits_count;
+            MilliSecond        max_time;    // Max time ahead of current time for EIT
+            std::set<uint16_t> events;      // Event ids in all EIT's of the service
         };
 
+        // Number of occurrences of each descriptor tag in the event loops.
+        typedef std::map<DID, uint64_t> DescriptorCountMap;
+
         // Combination of TS id / service id into one 32-bit index
         static uint32_t MakeIndex(uint16_t ts_id, uint16_t service_id) { return (uint32_t(ts_id) << 16) | service_id; }
         static uint16_t GetTSId(uint32_t index) { return (index >> 16) & 0xFFFF; }
@@ -79,6 +84,7 @@ namespace ts {
         typedef std::map <uint32_t, ServiceDesc> ServiceMap;
 
         // EITPlugin private members
+        bool               _desc_stats;       // Report descriptor tags in event loops
         std::ofstream      _outfile;          // Specified output file
         Time               _last_utc;         // Last UTC time seen in TDT
         SectionCounter     _eitpf_act_count;
@@ -88,10 +94,14 @@ namespace ts {
         SectionDemux       _demux;            // Section filter
         ServiceMap         _services;         // Description of services
         Variable<uint16_t> _ts_id;            // Current TS id
+        DescriptorCountMap _desc_count;       // Descriptor tags in event loops
 
         // Return a reference to a service description
         ServiceDesc& getServiceDesc(uint16_t ts_id, uint16_t service_id);
 
+        // Analyze the event loop of an EIT section, directly in the binary data.
+        void analyzeEvents(ServiceDesc& serv, bool pf, const uint8_t* data, size_t size);
+
         // Hooks
         virtual void handleTable(SectionDemux&, const BinaryTable&) override;
         virtual void handleSection(SectionDemux&, const Section&) override;
@@ -116,6 +126,7 @@ TSPLUGIN_DECLARE_PROCESSOR(eit, ts::EITPlugin)
 
 ts::EITPlugin::EITPlugin(TSP* tsp_) :
     ProcessorPlugin(tsp_, u"Analyze EIT sections.", u"[options]"),
+    _desc_stats(false),
     _outfile(),
     _last_utc(),
     _eitpf_act_count(0),
@@ -124,11 +135,22 @@ ts::EITPlugin::EITPlugin(TSP* tsp_) :
     _eits_oth_count(0),
     _demux(this, this),
     _services(),
-    _ts_id()
+    _ts_id(),
+    _desc_count()
 {
+    option(u"descriptor-stats", 'd');
     option(u"output-file", 'o', STRING);
 
-    setHelp(u"Options:\n"
+    setHelp(u"The EIT sections are analyzed in their binary form. Only the event ids,\n"
+            u"start times and, when requested, descriptor tags are extracted from the\n"
+            u"event loops. The events and their descriptors are never fully decoded.\n"
+            u"\n"
+            u"Options:\n"
+            u"\n"
+            u"  -d\n"
+            u"  --descriptor-stats\n"
+            u"      Report the number of occurrences of each descriptor tag in the event\n"
+            u"      loops of all EIT's.\n"
             u"\n"
             u"  --help\n"
             u"      Display this help text.\n"
@@ -150,7 +172,8 @@ ts::EITPlugin::ServiceDesc::ServiceDesc() :
     Service(),
     eitpf_count(0),
     eits_count(0),
-    max_time(0)
+    max_time(0),
+    events()
 {
 }
 
@@ -185,6 +208,8 @@ ts::EITPlugin::ServiceDesc& ts::EITPlugin::getServiceDesc(uint16_t ts_id, uint16
 
 bool ts::EITPlugin::start()
 {
+    _desc_stats = present(u"descriptor-stats");
+
     // Create output file
     if (present(u"output-file")) {
         const UString name(value(u"output-file"));
@@ -204,6 +229,7 @@ bool ts::EITPlugin::start()
     _eits_oth_count = 0;
     _services.clear();
     _ts_id.reset();
+    _desc_count.clear();
     _demux.reset();
     _demux.addPID(PID_PAT);
     _demux.addPID(PID_SDT);
@@ -282,21 +308,32 @@ bool ts::EITPlugin::stop()
     // Summary by service
     const UString h_name(u"Name");
     name_width = std::max(name_width, h_name.length());
-    out << UString::Format(u"A/O  TS Id   Srv Id  %-*s  EITp/f  EITs  EPG days", {name_width, u"Name"}) << std::endl
-        << UString::Format(u"---  ------  ------  %s  ------  ----  --------", {UString(name_width, u'-')}) << std::endl;
+    out << UString::Format(u"A/O  TS Id   Srv Id  %-*s  EITp/f  EITs  Events  EPG days", {name_width, u"Name"}) << std::endl
+        << UString::Format(u"---  ------  ------  %s  ------  ----  ------  --------", {UString(name_width, u'-')}) << std::endl;
     for (ServiceMap::const_iterator it = _services.begin(); it != _services.end(); ++it) {
         const ServiceDesc& serv(it->second);
         const bool actual = _ts_id.set() && serv.hasTSId(_ts_id.value());
-        out << UString::Format(u"%s  0x%04X  0x%04X  %-*s  %-6s  %-4s  %8d",
+        out << UString::Format(u"%s  0x%04X  0x%04X  %-*s  %-6s  %-4s  %6d  %8d",
                                {actual ? u"Act" : u"Oth",
                                 serv.getTSId(), serv.getId(),
                                 name_width, serv.getName(),
                                 UString::YesNo(serv.eitpf_count != 0),
                                 UString::YesNo(serv.eits_count != 0),
+                                serv.events.size(),
                                 Days(serv.max_time)})
             << std::endl;
     }
 
+    // Descriptors in event loops
+    if (_desc_stats) {
+        out << std::endl
+            << "Tag   Count       Descriptor" << std::endl
+            << "----  ----------  ----------" << std::endl;
+        for (DescriptorCountMap::const_iterator it = _desc_count.begin(); it != _desc_count.end(); ++it) {
+            out << UString::Format(u"0x%02X  %10'd  %s", {it->first, it->second, names::DID(it->first)}) << std::endl;
+        }
+    }
+
     // Close output file
     if (_outfile.is_open()) {
         _outfile.close();
@@ -433,17 +470,42 @@ void ts::EITPlugin::handleSection (SectionDemux& demux, const Section& sect)
         }
     }
 
-    // Loop on all events in EIT schedule, compute time offset in the future
-    if (!pf && _last_utc != Time::Epoch) {
-        while (size >= 12) {
+    analyzeEvents(serv, pf, data, size);
+}
+
+
+//----------------------------------------------------------------------------
+// Analyze the event loop of an EIT section, directly in the binary data.
+//----------------------------------------------------------------------------
+
+void ts::EITPlugin::analyzeEvents(ServiceDesc& serv, bool pf, const uint8_t* data, size_t size)
+{
+    // Compute the time offset in the future in EIT schedule only.
+    const bool check_time = !pf && _last_utc != Time::Epoch;
+
+    // Each event: event_id (2), start_time (5), duration (3), flags and descriptors_loop_length (2).
+    while (size >= 12) {
+        serv.events.insert(GetUInt16(data));
+        if (check_time) {
             Time start_time;
             DecodeMJD(data + 2, 5, start_time);
             serv.max_time = std::max(serv.max_time, start_time - _last_utc);
-            size_t loop_length = GetUInt16(data + 10) & 0x0FFF;
-            data += 12; size -= 12;
-            loop_length = std::min(loop_length, size);
-            data += loop_length; size -= loop_length;
         }
+        size_t loop_length = GetUInt16(data + 10) & 0x0FFF;
+        data += 12; size -= 12;
+        loop_length = std::min(loop_length, size);
+
+        // Only the descriptor tags are read, the descriptors themselves are skipped.
+        if (_desc_stats) {
+            const uint8_t* desc = data;
+            size_t desc_size = loop_length;
+            while (desc_size >= 2) {
+                _desc_count[desc[0]]++;
+                const size_t len = std::min<size_t>(2 + desc[1], desc_size);
+                desc += len; desc_size -= len;
+            }
+        }
+        data += loop_length; size -= loop_length;
     }
 }
 
@@ -0,0 +1,368 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  Transport stream processor shared library:
+//  Generate EIT present/following and schedule from event files.
+//
+//----------------------------------------------------------------------------
+
+#include "tsPlugin.h"
+#include "tsPluginRepository.h"
+#include "tsEITGenerator.h"
+#include "tsSectionDemux.h"
+#include "tsSectionFile.h"
+#include "tsTDT.h"
+#include "tsTOT.h"
+#include "tsSysUtils.h"
+TSDUCK_SOURCE;
+
+#define DEF_POLL_FILE_MS  1000   // In milliseconds
+
+
+//----------------------------------------------------------------------------
+// Plugin definition
+//----------------------------------------------------------------------------
+
+namespace ts {
+    class EITGenPlugin: public ProcessorPlugin, private TableHandlerInterface
+    {
+    public:
+        // Implementation of plugin API
+        EITGenPlugin(TSP*);
+        virtual bool start() override;
+        virtual Status processPacket(TSPacket&, bool&, bool&) override;
+
+    private:
+        UStringVector         _infiles;         // Input file names
+        std::vector<Time>     _infiles_date;    // Last modification time of input files
+        SectionFile::FileType _inType;          // Input files type
+        PID                   _eit_pid;         // Output PID
+        BitRate               _eit_bitrate;     // Bitrate budget of the output PID
+        bool                  _use_system_time; // Use the system clock instead of TDT/TOT
+        bool                  _poll_files;      // Poll the modification date of input files
+        Time                  _poll_file_next;  // Next UTC time of poll file
+        PacketCounter         _eit_inter_pkt;   // # TS packets between 2 EIT packets
+        PacketCounter         _packet_count;    // TS packet counter
+        PacketCounter         _eit_next_pkt;    // Next time to insert a packet
+        Time                  _ref_time;        // Last TDT or TOT, Epoch if none
+        PacketCounter         _ref_packet;      // Packet index of the last TDT or TOT
+        Time                  _last_time;       // Last time set in the generator
+        SectionDemux          _demux;           // Demux for TDT and TOT
+        EITGenerator          _eit_gen;         // EIT generator
+
+        // Invoked by the demux when a complete table is available.
+        virtual void handleTable(SectionDemux&, const BinaryTable&) override;
+
+        // Load the events from one input file.
+        bool loadFile(size_t index);
+
+        // Compute the current UTC time, Epoch if unknown.
+        Time currentTime() const;
+
+        // Inaccessible operations
+        EITGenPlugin() = delete;
+        EITGenPlugin(const EITGenPlugin&) = delete;
+        EITGenPlugin& operator=(const EITGenPlugin&) = delete;
+    };
+}
+
+TSPLUGIN_DECLARE_VERSION
+TSPLUGIN_DECLARE_PROCESSOR(eitgen, ts::EITGenPlugin)
+
+
+//----------------------------------------------------------------------------
+// Constructor
+//----------------------------------------------------------------------------
+
+ts::EITGenPlugin::EITGenPlugin(TSP* tsp_) :
+    ProcessorPlugin(tsp_, u"Generate EIT p/f and schedule within a bitrate budget.", u"[options] input-file ..."),
+    _infiles(),
+    _infiles_date(),
+    _inType(SectionFile::UNSPECIFIED),
+    _eit_pid(PID_EIT),
+    _eit_bitrate(0),
+    _use_system_time(false),
+    _poll_files(false),
+    _poll_file_next(),
+    _eit_inter_pkt(0),
+    _packet_count(0),
+    _eit_next_pkt(0),
+    _ref_time(Time::Epoch),
+    _ref_packet(0),
+    _last_time(Time::Epoch),
+    _demux(this),
+    _eit_gen(PID_EIT, *tsp)
+{
+    option(u"",            0,  STRING, 1, UNLIMITED_COUNT);
+    option(u"binary",      0);
+    option(u"bitrate",    'b', POSITIVE, 1, 1);
+    option(u"days",       'd', INTEGER, 0, 1, 1, EITGenerator::MAX_DAYS);
+    option(u"pid",        'p', PIDVAL);
+    option(u"poll-files",  0);
+    option(u"system-time", 0);
+    option(u"terrestrial", 0);
+    option(u"xml",         0);
+
+    setHelp(u"Input files:\n"
+            u"\n"
+            u"  Binary or XML files containing EIT's (p/f or schedule, actual or other).\n"
+            u"  All events are merged into a database of events, per service. Other\n"
+            u"  tables are ignored. By default, files ending in .xml are XML and files\n"
+            u"  ending in .bin are binary. For other file names, explicitly specify\n"
+            u"  --binary or --xml.\n"
+            u"\n"
+            u"  The EIT p/f and EIT schedule are generated from the events, following the\n"
+            u"  rules of ETSI TS 101 211: the schedule starts at midnight UTC of the current\n"
+            u"  day and is split into segments of 3 hours. Only the EIT sub-tables which\n"
+            u"  are modified by new events or by the passing time are rebuilt.\n"
+            u"\n"
+            u"Options:\n"
+            u"\n"
+            u"  --binary\n"
+            u"      Specify that all input files are binary, regardless of their file name.\n"
+            u"\n"
+            u"  -b value\n"
+            u"  --bitrate value\n"
+            u"      Bitrate budget of the EIT PID, in bits/second. This is a required\n"
+            u"      parameter. The EIT packets replace null packets at this rate. When the\n"
+            u"      repetition rates of ETSI TS 101 211 require more than this bitrate, all\n"
+            u"      repetition rates are proportionally increased.\n"
+            u"\n"
+            u"  -d value\n"
+            u"  --days value\n"
+            u"      Number of days in the EIT schedule, starting with the current day.\n"
+            u"      The default is 8 days, the maximum is 64 days.\n"
+            u"\n"
+            u"  --help\n"
+            u"      Display this help text.\n"
+            u"\n"
+            u"  -p value\n"
+            u"  --pid value\n"
+            u"      PID of the generated EIT's. The default is 0x12. Input packets in this\n"
+            u"      PID are replaced by null packets.\n"
+            u"\n"
+            u"  --poll-files\n"
+            u"      Poll the modification date of the input files. When a file is modified,\n"
+            u"      its events are merged into the events database.\n"
+            u"\n"
+            u"  --system-time\n"
+            u"      Use the system UTC time as current time. By default, the current time\n"
+            u"      is the last TDT or TOT in the transport stream, extrapolated using the\n"
+            u"      transport stream bitrate. No EIT is generated before the first TDT or TOT.\n"
+            u"\n"
+            u"  --terrestrial\n"
+            u"      Use the repetition rates of ETSI TS 101 211 for terrestrial networks.\n"
+            u"      By default, use the repetition rates for satellite and cable networks.\n"
+            u"\n"
+            u"  --version\n"
+            u"      Display the version number.\n"
+            u"\n"
+            u"  --xml\n"
+            u"      Specify that all input files are XML, regardless of their file name.\n");
+}
+
+
+//----------------------------------------------------------------------------
+// Start method
+//----------------------------------------------------------------------------
+
+bool ts::EITGenPlugin::start()
+{
+    // Get command line arguments
+    getValues(_infiles, u"");
+    _eit_pid = intValue<PID>(u"pid", PID_EIT);
+    _eit_bitrate = intValue<BitRate>(u"bitrate", 0);
+    _use_system_time = present(u"system-time");
+    _poll_files = present(u"poll-files");
+    if (present(u"xml")) {
+        _inType = SectionFile::XML;
+    }
+    else if (present(u"binary")) {
+        _inType = SectionFile::BINARY;
+    }
+    else {
+        _inType = SectionFile::UNSPECIFIED;
+    }
+
+    // Initialize the EIT generator.
+    _eit_gen.reset();
+    _eit_gen.setPID(_eit_pid);
+    _eit_gen.setBitRate(_eit_bitrate);
+    _eit_gen.setProfile(present(u"terrestrial") ? EITGenerator::TerrestrialProfile : EITGenerator::SatelliteCableProfile);
+    _eit_gen.setMaxDays(intValue<size_t>(u"days", EITGenerator::DEFAULT_DAYS));
+
+    // Load all input files.
+    _infiles_date.assign(_infiles.size(), Time::Epoch);
+    for (size_t i = 0; i < _infiles.size(); ++i) {
+        if (!loadFile(i)) {
+            return false;
+        }
+    }
+    if (_poll_files) {
+        _poll_file_next = Time::CurrentUTC() + DEF_POLL_FILE_MS;
+    }
+
+    // Get the time from TDT and TOT.
+    _demux.reset();
+    if (!_use_system_time) {
+        _demux.addPID(PID_TDT);
+    }
+
+    _eit_inter_pkt = 0;
+    _packet_count = 0;
+    _eit_next_pkt = 0;
+    _ref_time = Time::Epoch;
+    _ref_packet = 0;
+    _last_time = Time::Epoch;
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Load the events from one input file.
+//----------------------------------------------------------------------------
+
+bool ts::EITGenPlugin::loadFile(size_t index)
+{
+    const UString& name(_infiles[index]);
+    _infiles_date[index] = GetFileModificationTimeUTC(name);
+
+    SectionFile file;
+    if (!file.load(name, *tsp, _inType, CRC32::CHECK)) {
+        return false;
+    }
+
+    size_t count = 0;
+    for (BinaryTablePtrVector::const_iterator it = file.tables().begin(); it != file.tables().end(); ++it) {
+        const TID tid = (*it)->tableId();
+        if (tid >= TID_EIT_MIN && tid <= TID_EIT_MAX) {
+            const EIT eit(**it);
+            count += _eit_gen.loadEvents(eit);
+        }
+    }
+    tsp->verbose(u"loaded %d events from %s, %d events in %d services", {count, name, _eit_gen.eventCount(), _eit_gen.serviceCount()});
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Invoked by the demux when a complete table is available.
+//----------------------------------------------------------------------------
+
+void ts::EITGenPlugin::handleTable(SectionDemux& demux, const BinaryTable& table)
+{
+    if (table.tableId() == TID_TDT) {
+        const TDT tdt(table);
+        if (tdt.isValid()) {
+            _ref_time = tdt.utc_time;
+            _ref_packet = _packet_count;
+        }
+    }
+    else if (table.tableId() == TID_TOT) {
+        const TOT tot(table);
+        if (tot.isValid()) {
+            _ref_time = tot.utc_time;
+            _ref_packet = _packet_count;
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Compute the current UTC time.
+//----------------------------------------------------------------------------
+
+ts::Time ts::EITGenPlugin::currentTime() const
+{
+    if (_use_system_time) {
+        return Time::CurrentUTC();
+    }
+    else if (_ref_time == Time::Epoch) {
+        return Time::Epoch;
+    }
+    else {
+        // Extrapolate the last TDT or TOT using the TS bitrate.
+        return _ref_time + PacketInterval(tsp->bitrate(), _packet_count - _ref_packet);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Packet processing method
+//----------------------------------------------------------------------------
+
+ts::ProcessorPlugin::Status ts::EITGenPlugin::processPacket(TSPacket& pkt, bool& flush, bool& bitrate_changed)
+{
+    const PID pid = pkt.getPID();
+
+    // The interval between two EIT packets is computed from the TS bitrate.
+    if (_packet_count == 0) {
+        const BitRate ts_bitrate = tsp->bitrate();
+        if (ts_bitrate < _eit_bitrate) {
+            tsp->error(u"input bitrate unknown or too low, cannot insert EIT at %'d b/s", {_eit_bitrate});
+            return TSP_END;
+        }
+        _eit_inter_pkt = ts_bitrate / _eit_bitrate;
+        tsp->verbose(u"transport bitrate: %'d b/s, packet interval: %'d", {ts_bitrate, _eit_inter_pkt});
+    }
+
+    _demux.feedPacket(pkt);
+
+    // Update the current time in the generator, with a granularity of one second.
+    const Time now(currentTime());
+    if (now != Time::Epoch && (_last_time == Time::Epoch || now < _last_time || now - _last_time >= MilliSecPerSec)) {
+        _eit_gen.setCurrentTime(now);
+        _last_time = now;
+    }
+
+    // Poll files when necessary.
+    if (_poll_files && Time::CurrentUTC() >= _poll_file_next) {
+        for (size_t i = 0; i < _infiles.size(); ++i) {
+            if (FileExists(_infiles[i]) && GetFileModificationTimeUTC(_infiles[i]) != _infiles_date[i]) {
+                loadFile(i);
+            }
+        }
+        _poll_file_next = Time::CurrentUTC() + DEF_POLL_FILE_MS;
+    }
+
+    _packet_count++;
+
+    // Replace the previous content of the EIT PID with stuffing.
+    if (pid == _eit_pid) {
+        return TSP_NULL;
+    }
+
+    // Steal null packets at the packet interval of the EIT PID.
+    if (pid == PID_NULL && _packet_count >= _eit_next_pkt) {
+        _eit_gen.getNextPacket(pkt);
+        _eit_next_pkt += _eit_inter_pkt;
+    }
+
+    return TSP_OK;
+}
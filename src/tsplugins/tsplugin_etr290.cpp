@@ -0,0 +1,1015 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//
+//  Transport stream processor shared library:
+//  Continuous monitoring of ETSI TR 101 290 indicators
+//
+//----------------------------------------------------------------------------
+
+#include "tsPlugin.h"
+#include "tsPluginRepository.h"
+#include "tsSectionDemux.h"
+#include "tsPCRAnalyzer.h"
+#include "tsTables.h"
+#include "tsLogLimiter.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// Plugin definition
+//----------------------------------------------------------------------------
+
+namespace ts {
+    class ETR290Plugin: public ProcessorPlugin, private TableHandlerInterface, private SectionHandlerInterface
+    {
+    public:
+        // Implementation of plugin API
+        ETR290Plugin(TSP*);
+        virtual bool start() override;
+        virtual bool stop() override;
+        virtual Status processPacket(TSPacket&, bool&, bool&) override;
+
+    private:
+        // ETR 290 indicators, by order of priority.
+        enum Indicator {
+            // Priority 1
+            TS_SYNC_LOSS,
+            SYNC_BYTE_ERROR,
+            PAT_ERROR,
+            CC_ERROR,
+            PMT_ERROR,
+            PID_ERROR,
+            // Priority 2
+            TRANSPORT_ERROR,
+            CRC_ERROR,
+            PCR_REPETITION_ERROR,
+            PCR_DISCONTINUITY_ERROR,
+            PCR_ACCURACY_ERROR,
+            PTS_ERROR,
+            CAT_ERROR,
+            // Priority 3
+            NIT_ERROR,
+            UNREFERENCED_PID,
+            SDT_ERROR,
+            EIT_ERROR,
+            TDT_ERROR,
+            INDICATOR_COUNT
+        };
+
+        // Numbers and names of indicators, as in ETR 290.
+        static const UChar* const IndicatorNames[INDICATOR_COUNT];
+
+        // Priority of an indicator.
+        static int Priority(Indicator ind) { return ind < TRANSPORT_ERROR ? 1 : (ind < NIT_ERROR ? 2 : 3); }
+
+        // References to a PID in the PSI, in PIDState.
+        enum : uint8_t {
+            REF_PMT     = 0x01,    // PID carries a PMT which is referenced in the PAT.
+            REF_ES      = 0x02,    // PID is a component of a service.
+            REF_PCR     = 0x04,    // PID is the PCR PID of a service.
+            REF_ANY     = 0x08,    // PID is referenced in the PSI (PMT, component, PCR, ECM, EMM).
+        };
+
+        // Flags in PIDState.
+        enum : uint16_t {
+            PF_DEMUX    = 0x0001,  // PID is filtered by the section demux.
+            PF_SEEN     = 0x0002,  // At least one packet was found in the PID.
+            PF_HAS_PCR  = 0x0004,  // At least one PCR was found in the PID.
+            PF_HAS_PTS  = 0x0008,  // At least one PTS was found in the PID.
+            PF_LATE_PMT = 0x0010,  // PMT_error already reported for the current gap.
+            PF_LATE_PID = 0x0020,  // PID_error already reported for the current gap.
+            PF_LATE_PCR = 0x0040,  // PCR_repetition_error already reported for the current gap.
+            PF_LATE_PTS = 0x0080,  // PTS_error already reported for the current gap.
+            PF_UNREF    = 0x0100,  // Unreferenced PID already reported.
+        };
+
+        // State of one PID. All states are in one flat array, indexed by PID.
+        // Packet indexes are used as time base, the thresholds are converted in packets.
+        struct PIDState
+        {
+            PacketCounter last_pkt;       // Index of last packet (or of first reference in PSI).
+            PacketCounter last_pcr_pkt;   // Index of last packet with a PCR.
+            PacketCounter last_pts_pkt;   // Index of last packet with a PTS.
+            PacketCounter last_pmt_pkt;   // Index of last PMT section.
+            uint64_t      last_pcr;       // Last PCR value.
+            uint16_t      flags;          // Combination of PF_xxx.
+            uint8_t       refs;           // Combination of REF_xxx.
+            uint8_t       old_refs;       // Previous references, during a PSI update.
+            uint8_t       cc;             // Last continuity counter, 0xFF if none.
+            uint8_t       dup;            // Number of consecutive duplicated packets.
+        };
+
+        // State of a table which must be regularly repeated on a fixed PID.
+        struct TableState
+        {
+            PacketCounter last_pkt;  // Index of last section.
+            bool          late;      // Error already reported for the current gap.
+        };
+
+        // PID's which are referenced by a service.
+        struct ServiceRefs
+        {
+            PID              pmt_pid;
+            bool             pmt_ok;   // PMT was received.
+            PID              pcr_pid;
+            std::vector<PID> es_pids;
+            std::vector<PID> ca_pids;  // ECM PID's.
+        };
+        typedef std::map<uint16_t, ServiceRefs> ServiceRefsMap;
+
+        // Command line options.
+        UString       _tag;              // Message tag.
+        int           _priority;         // Max priority of checked indicators.
+        bool          _no_events;        // Do not report individual events.
+        BitRate       _user_bitrate;     // User-specified bitrate.
+        MilliSecond   _pid_timeout;      // Max interval for PID_error.
+        int64_t       _pcr_accuracy;     // Max PCR inaccuracy in nanoseconds.
+        MilliSecond   _interval;         // Interval between counter reports, zero if none.
+
+        // Working data.
+        PacketCounter _packet_count;     // TS packet count.
+        BitRate       _bitrate;          // Current TS bitrate, zero if unknown.
+        bool          _use_analyzer;     // Evaluate the bitrate from PCR's.
+        PCRAnalyzer   _pcr_analyzer;     // Bitrate evaluation when unknown from tsp.
+        SectionDemux  _demux;            // PSI/SI demux.
+        uint64_t      _wrong_crc;        // Last known number of CRC errors in the demux.
+        int           _bad_sync;         // Number of consecutive packets with bad sync byte.
+        int           _good_sync;        // Number of consecutive packets with good sync byte after a loss.
+        bool          _sync_lost;        // Currently in TS_sync_loss state.
+        bool          _pat_ok;           // A PAT was received.
+        bool          _cat_ok;           // A CAT was received.
+        bool          _cat_reported;     // Missing CAT was reported.
+        bool          _psi_complete;     // PAT and all PMT's are received.
+        PacketCounter _psi_complete_pkt; // Packet index when the PSI was complete.
+        PacketCounter _next_check;       // Packet index of next periodic check.
+        PacketCounter _next_report;      // Packet index of next counter report.
+        TableState    _pat;              // PAT on PID 0x0000.
+        TableState    _nit;              // NIT actual on PID 0x0010.
+        TableState    _sdt;              // SDT actual on PID 0x0011.
+        TableState    _eit;              // EIT p/f actual on PID 0x0012.
+        TableState    _tdt;              // TDT on PID 0x0014.
+        ServiceRefsMap   _services;      // PSI references, by service id.
+        std::vector<PID> _emm_pids;      // EMM PID's from the CAT.
+        std::vector<PID> _ref_pids;      // All PID's with reference flags.
+        std::vector<PID> _seen_pids;     // All PID's with packets.
+        std::vector<PID> _pts_pids;      // All PID's with PTS.
+        PacketCounter _counters[INDICATOR_COUNT];  // Total error counts.
+        PacketCounter _reported[INDICATOR_COUNT];  // Error counts at last periodic report.
+        PIDState      _pids[PID_MAX];    // State of all PID's.
+        LogLimiter    _log;              // Rate-limited reporting of events, by indicator and PID.
+
+        // Thresholds in packets at current bitrate, zero when the bitrate is unknown.
+        PacketCounter _check_pkts;       // Interval between periodic checks.
+        PacketCounter _max_pat_pkts;
+        PacketCounter _max_pmt_pkts;
+        PacketCounter _max_pid_pkts;
+        PacketCounter _max_pcr_pkts;
+        PacketCounter _max_pts_pkts;
+        PacketCounter _max_nit_pkts;
+        PacketCounter _max_sdt_pkts;
+        PacketCounter _max_eit_pkts;
+        PacketCounter _max_tdt_pkts;
+        PacketCounter _max_unref_pkts;
+
+        // ETR 290 limits.
+        static const MilliSecond MAX_PAT_INTERVAL   = 500;
+        static const MilliSecond MAX_PMT_INTERVAL   = 500;
+        static const MilliSecond MAX_PCR_INTERVAL   = 100;
+        static const MilliSecond MAX_PTS_INTERVAL   = 700;
+        static const MilliSecond MAX_NIT_INTERVAL   = 10000;
+        static const MilliSecond MAX_SDT_INTERVAL   = 2000;
+        static const MilliSecond MAX_EIT_INTERVAL   = 2000;
+        static const MilliSecond MAX_TDT_INTERVAL   = 30000;
+        static const MilliSecond MAX_UNREF_INTERVAL = 500;
+        static const MilliSecond CHECK_INTERVAL     = 10;
+        static const MilliSecond DEFAULT_PID_TIMEOUT = 5000;
+        static const int64_t DEFAULT_PCR_ACCURACY = 500;
+        static const uint64_t MAX_PCR_DIFF = (SYSTEM_CLOCK_FREQ * MAX_PCR_INTERVAL) / MilliSecPerSec;
+        static const PacketCounter NO_BITRATE_CHECK_PACKETS = 1000;
+
+        // Process errors.
+        void error(Indicator ind, PID pid, const UChar* fmt, std::initializer_list<ArgMixIn> args);
+        void reportCounters(const UString& title, bool total);
+
+        // Check if an item arrives too late and update its state.
+        bool tooLate(PacketCounter last, PacketCounter max) const { return max > 0 && _packet_count - last > max; }
+        void arrival(Indicator ind, PID pid, const UChar* name, PacketCounter& last, PacketCounter max, bool late);
+        void checkTable(Indicator ind, PID pid, const UChar* name, TableState& table, PacketCounter max);
+
+        // Periodic checks.
+        void updateBitrate();
+        void periodicCheck();
+
+        // Process PSI.
+        virtual void handleTable(SectionDemux&, const BinaryTable&) override;
+        virtual void handleSection(SectionDemux&, const Section&) override;
+        void rebuildReferences();
+        void reference(PID pid, uint8_t ref);
+        void filterPID(PID pid);
+        static void GetCAPIDs(std::vector<PID>& pids, const DescriptorList& descs);
+
+        // Inaccessible operations
+        ETR290Plugin() = delete;
+        ETR290Plugin(const ETR290Plugin&) = delete;
+        ETR290Plugin& operator=(const ETR290Plugin&) = delete;
+    };
+}
+
+TSPLUGIN_DECLARE_VERSION
+TSPLUGIN_DECLARE_PROCESSOR(etr290, ts::ETR290Plugin)
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const ts::MilliSecond ts::ETR290Plugin::MAX_PAT_INTERVAL;
+const ts::MilliSecond ts::ETR290Plugin::MAX_PMT_INTERVAL;
+const ts::MilliSecond ts::ETR290Plugin::MAX_PCR_INTERVAL;
+const ts::MilliSecond ts::ETR290Plugin::MAX_PTS_INTERVAL;
+const ts::MilliSecond ts::ETR290Plugin::MAX_NIT_INTERVAL;
+const ts::MilliSecond ts::ETR290Plugin::MAX_SDT_INTERVAL;
+const ts::MilliSecond ts::ETR290Plugin::MAX_EIT_INTERVAL;
+const ts::MilliSecond ts::ETR290Plugin::MAX_TDT_INTERVAL;
+const ts::MilliSecond ts::ETR290Plugin::MAX_UNREF_INTERVAL;
+const ts::MilliSecond ts::ETR290Plugin::CHECK_INTERVAL;
+const ts::MilliSecond ts::ETR290Plugin::DEFAULT_PID_TIMEOUT;
+const int64_t ts::ETR290Plugin::DEFAULT_PCR_ACCURACY;
+const uint64_t ts::ETR290Plugin::MAX_PCR_DIFF;
+const ts::PacketCounter ts::ETR290Plugin::NO_BITRATE_CHECK_PACKETS;
+#endif
+
+const ts::UChar* const ts::ETR290Plugin::IndicatorNames[INDICATOR_COUNT] = {
+    u"1.1 TS_sync_loss",
+    u"1.2 Sync_byte_error",
+    u"1.3 PAT_error",
+    u"1.4 Continuity_count_error",
+    u"1.5 PMT_error",
+    u"1.6 PID_error",
+    u"2.1 Transport_error",
+    u"2.2 CRC_error",
+    u"2.3a PCR_repetition_error",
+    u"2.3b PCR_discontinuity_indicator_error",
+    u"2.4 PCR_accuracy_error",
+    u"2.5 PTS_error",
+    u"2.6 CAT_error",
+    u"3.1 NIT_error",
+    u"3.4 Unreferenced_PID",
+    u"3.5 SDT_error",
+    u"3.6 EIT_error",
+    u"3.8 TDT_error",
+};
+
+
+//----------------------------------------------------------------------------
+// Constructor
+//----------------------------------------------------------------------------
+
+ts::ETR290Plugin::ETR290Plugin(TSP* tsp_) :
+    ProcessorPlugin(tsp_, u"Monitor ETSI TR 101 290 priority 1, 2 and 3 indicators.", u"[options]"),
+    _tag(),
+    _priority(3),
+    _no_events(false),
+    _user_bitrate(0),
+    _pid_timeout(DEFAULT_PID_TIMEOUT),
+    _pcr_accuracy(DEFAULT_PCR_ACCURACY),
+    _interval(0),
+    _packet_count(0),
+    _bitrate(0),
+    _use_analyzer(false),
+    _pcr_analyzer(),
+    _demux(this, this),
+    _wrong_crc(0),
+    _bad_sync(0),
+    _good_sync(0),
+    _sync_lost(false),
+    _pat_ok(false),
+    _cat_ok(false),
+    _cat_reported(false),
+    _psi_complete(false),
+    _psi_complete_pkt(0),
+    _next_check(0),
+    _next_report(0),
+    _pat(),
+    _nit(),
+    _sdt(),
+    _eit(),
+    _tdt(),
+    _services(),
+    _emm_pids(),
+    _ref_pids(),
+    _seen_pids(),
+    _pts_pids(),
+    _counters(),
+    _reported(),
+    _pids(),
+    _log(*tsp_),
+    _check_pkts(0),
+    _max_pat_pkts(0),
+    _max_pmt_pkts(0),
+    _max_pid_pkts(0),
+    _max_pcr_pkts(0),
+    _max_pts_pkts(0),
+    _max_nit_pkts(0),
+    _max_sdt_pkts(0),
+    _max_eit_pkts(0),
+    _max_tdt_pkts(0),
+    _max_unref_pkts(0)
+{
+    option(u"bitrate",      'b', POSITIVE);
+    option(u"interval",     'i', POSITIVE);
+    option(u"no-events",    'n');
+    option(u"pcr-accuracy",  0,  POSITIVE);
+    option(u"pid-timeout",   0,  POSITIVE);
+    option(u"priority",     'p', INTEGER, 0, 1, 1, 3);
+    option(u"tag",          't', STRING);
+
+    setHelp(u"Options:\n"
+            u"\n"
+            u"  -b value\n"
+            u"  --bitrate value\n"
+            u"      Transport stream bitrate in bits/second. All timing indicators are\n"
+            u"      evaluated using packet positions at this bitrate. By default, use the\n"
+            u"      input bitrate as reported by the input device or, when unknown, the\n"
+            u"      bitrate which is evaluated from the PCR's. The PCR accuracy check is\n"
+            u"      only meaningful with the exact bitrate of a constant bitrate stream.\n"
+            u"\n"
+            u"  --help\n"
+            u"      Display this help text.\n"
+            u"\n"
+            u"  -i seconds\n"
+            u"  --interval seconds\n"
+            u"      Periodically report the error counters of each indicator, for the last\n"
+            u"      interval. The interval is measured in stream time. By default, the\n"
+            u"      error counters are reported only once, at the end of the stream.\n"
+            u"\n"
+            u"  -n\n"
+            u"  --no-events\n"
+            u"      Do not report individual errors, only the error counters. By default,\n"
+            u"      individual errors are reported up to 10 messages per second for each\n"
+            u"      indicator and PID. Additional errors are summarized.\n"
+            u"\n"
+            u"  --pcr-accuracy nanoseconds\n"
+            u"      Maximum PCR inaccuracy for PCR_accuracy_error. The default is " + UString::Decimal(DEFAULT_PCR_ACCURACY) + u" ns.\n"
+            u"\n"
+            u"  --pid-timeout milliseconds\n"
+            u"      Maximum interval between two packets of a PID which is referenced in a\n"
+            u"      PMT, for PID_error. The default is " + UString::Decimal(DEFAULT_PID_TIMEOUT) + u" ms.\n"
+            u"\n"
+            u"  -p value\n"
+            u"  --priority value\n"
+            u"      Highest priority of the checked indicators, from 1 to 3. The default is 3,\n"
+            u"      all indicators are checked. Use --priority 2 on non-DVB streams, without\n"
+            u"      NIT, SDT, EIT or TDT.\n"
+            u"\n"
+            u"  -t 'string'\n"
+            u"  --tag 'string'\n"
+            u"      Message tag to be displayed with errors and counters. Useful when the\n"
+            u"      plugin is used several times in the same process.\n"
+            u"\n"
+            u"  --version\n"
+            u"      Display the version number.\n");
+}
+
+
+//----------------------------------------------------------------------------
+// Start method
+//----------------------------------------------------------------------------
+
+bool ts::ETR290Plugin::start()
+{
+    // Command line arguments
+    _tag = value(u"tag");
+    if (!_tag.empty()) {
+        _tag += u": ";
+    }
+    _priority = intValue<int>(u"priority", 3);
+    _no_events = present(u"no-events");
+    _log.setPrefix(_tag);
+    _user_bitrate = intValue<BitRate>(u"bitrate", 0);
+    _pid_timeout = intValue<MilliSecond>(u"pid-timeout", DEFAULT_PID_TIMEOUT);
+    _pcr_accuracy = intValue<int64_t>(u"pcr-accuracy", DEFAULT_PCR_ACCURACY);
+    _interval = intValue<MilliSecond>(u"interval", 0) * MilliSecPerSec;
+
+    // Reset the state.
+    _packet_count = 0;
+    _bitrate = 0;
+    _pcr_analyzer.reset();
+    _bad_sync = _good_sync = 0;
+    _sync_lost = _pat_ok = _cat_ok = _cat_reported = _psi_complete = false;
+    _psi_complete_pkt = _next_check = _next_report = 0;
+    _pat.last_pkt = _nit.last_pkt = _sdt.last_pkt = _eit.last_pkt = _tdt.last_pkt = 0;
+    _pat.late = _nit.late = _sdt.late = _eit.late = _tdt.late = false;
+    _services.clear();
+    _emm_pids.clear();
+    _ref_pids.clear();
+    _seen_pids.clear();
+    _pts_pids.clear();
+    for (size_t i = 0; i < INDICATOR_COUNT; ++i) {
+        _counters[i] = _reported[i] = 0;
+    }
+    ::memset(_pids, 0, sizeof(_pids));
+    for (PID pid = 0; pid < PID_MAX; ++pid) {
+        _pids[pid].cc = 0xFF;
+    }
+
+    // Filter PSI/SI on predefined PID's.
+    _demux.reset();
+    _wrong_crc = 0;
+    filterPID(PID_PAT);
+    filterPID(PID_CAT);
+    if (_priority >= 3) {
+        filterPID(PID_NIT);
+        filterPID(PID_SDT);
+        filterPID(PID_EIT);
+        filterPID(PID_TDT);
+    }
+
+    updateBitrate();
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Stop method
+//----------------------------------------------------------------------------
+
+bool ts::ETR290Plugin::stop()
+{
+    _log.flush();
+    reportCounters(UString::Format(u"total after %'d packets", {_packet_count}), true);
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Report an error.
+//----------------------------------------------------------------------------
+
+void ts::ETR290Plugin::error(Indicator ind, PID pid, const UChar* fmt, std::initializer_list<ArgMixIn> args)
+{
+    _counters[ind]++;
+    // Formatting the message is expensive, suppressed messages are only counted.
+    if (!_no_events && _log.allow((uint32_t(ind) << 16) | pid, Severity::Info)) {
+        const UString pid_name(pid < PID_MAX ? UString::Format(u", PID 0x%X (%d)", {pid, pid}) : UString());
+        tsp->info(u"%s%s, packet %'d%s: %s", {_tag, IndicatorNames[ind], _packet_count, pid_name, UString::Format(fmt, args)});
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Report the error counters, total or since last report.
+//----------------------------------------------------------------------------
+
+void ts::ETR290Plugin::reportCounters(const UString& title, bool total)
+{
+    tsp->info(u"%sETR 290 counters, %s", {_tag, title});
+    for (int prio = 1; prio <= _priority; ++prio) {
+        UString line;
+        for (size_t i = 0; i < INDICATOR_COUNT; ++i) {
+            const Indicator ind = Indicator(i);
+            if (Priority(ind) == prio) {
+                line.append(UString::Format(u"%s%s: %'d", {line.empty() ? u"" : u", ", IndicatorNames[ind], total ? _counters[ind] : _counters[ind] - _reported[ind]}));
+                _reported[ind] = _counters[ind];
+            }
+        }
+        tsp->info(u"%spriority %d: %s", {_tag, prio, line});
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Process the arrival of a regularly repeated item.
+//----------------------------------------------------------------------------
+
+void ts::ETR290Plugin::arrival(Indicator ind, PID pid, const UChar* name, PacketCounter& last, PacketCounter max, bool late)
+{
+    // If the gap was already reported by the periodic check, do not report it twice.
+    if (!late && tooLate(last, max)) {
+        error(ind, pid, u"interval between %s is %'d ms", {name, PacketInterval(_bitrate, _packet_count - last)});
+    }
+    last = _packet_count;
+}
+
+void ts::ETR290Plugin::checkTable(Indicator ind, PID pid, const UChar* name, TableState& table, PacketCounter max)
+{
+    if (!table.late && tooLate(table.last_pkt, max)) {
+        table.late = true;
+        error(ind, pid, u"no %s for %'d ms", {name, PacketInterval(_bitrate, _packet_count - table.last_pkt)});
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Update the bitrate and all thresholds.
+//----------------------------------------------------------------------------
+
+void ts::ETR290Plugin::updateBitrate()
+{
+    BitRate bitrate = _user_bitrate;
+    if (bitrate == 0) {
+        bitrate = tsp->bitrate();
+    }
+    _use_analyzer = bitrate == 0;
+    if (bitrate == 0 && _pcr_analyzer.bitrateIsValid()) {
+        bitrate = _pcr_analyzer.bitrate188();
+    }
+
+    if (bitrate != _bitrate) {
+        _bitrate = bitrate;
+        _check_pkts = bitrate == 0 ? NO_BITRATE_CHECK_PACKETS : std::max<PacketCounter>(1, PacketDistance(bitrate, CHECK_INTERVAL));
+        _max_pat_pkts = PacketDistance(bitrate, MAX_PAT_INTERVAL);
+        _max_pmt_pkts = PacketDistance(bitrate, MAX_PMT_INTERVAL);
+        _max_pid_pkts = PacketDistance(bitrate, _pid_timeout);
+        _max_pcr_pkts = PacketDistance(bitrate, MAX_PCR_INTERVAL);
+        _max_pts_pkts = PacketDistance(bitrate, MAX_PTS_INTERVAL);
+        _max_nit_pkts = PacketDistance(bitrate, MAX_NIT_INTERVAL);
+        _max_sdt_pkts = PacketDistance(bitrate, MAX_SDT_INTERVAL);
+        _max_eit_pkts = PacketDistance(bitrate, MAX_EIT_INTERVAL);
+        _max_tdt_pkts = PacketDistance(bitrate, MAX_TDT_INTERVAL);
+        _max_unref_pkts = PacketDistance(bitrate, MAX_UNREF_INTERVAL);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Periodic check of all missing items.
+//----------------------------------------------------------------------------
+
+void ts::ETR290Plugin::periodicCheck()
+{
+    updateBitrate();
+    _next_check = _packet_count + _check_pkts;
+
+    // Report counters at the end of an interval.
+    if (_interval > 0 && _bitrate > 0) {
+        if (_next_report == 0) {
+            _next_report = _packet_count + PacketDistance(_bitrate, _interval);
+        }
+        else if (_packet_count >= _next_report) {
+            _next_report = _packet_count + PacketDistance(_bitrate, _interval);
+            reportCounters(UString::Format(u"last %'d seconds, at packet %'d", {_interval / MilliSecPerSec, _packet_count}), false);
+        }
+    }
+
+    // Nothing to check without timing reference.
+    if (_bitrate == 0) {
+        return;
+    }
+
+    // Tables on fixed PID's.
+    checkTable(PAT_ERROR, PID_PAT, u"PAT", _pat, _max_pat_pkts);
+    if (_priority >= 3) {
+        checkTable(NIT_ERROR, PID_NIT, u"NIT actual", _nit, _max_nit_pkts);
+        checkTable(SDT_ERROR, PID_SDT, u"SDT actual", _sdt, _max_sdt_pkts);
+        checkTable(EIT_ERROR, PID_EIT, u"EIT p/f actual", _eit, _max_eit_pkts);
+        checkTable(TDT_ERROR, PID_TDT, u"TDT", _tdt, _max_tdt_pkts);
+    }
+
+    // PID's which are referenced in the PSI.
+    for (auto it = _ref_pids.begin(); it != _ref_pids.end(); ++it) {
+        const PID pid = *it;
+        PIDState& st(_pids[pid]);
+        if ((st.refs & REF_PMT) != 0 && (st.flags & PF_LATE_PMT) == 0 && tooLate(st.last_pmt_pkt, _max_pmt_pkts)) {
+            st.flags |= PF_LATE_PMT;
+            error(PMT_ERROR, pid, u"no PMT for %'d ms", {PacketInterval(_bitrate, _packet_count - st.last_pmt_pkt)});
+        }
+        if ((st.refs & REF_ES) != 0 && (st.flags & PF_LATE_PID) == 0 && tooLate(st.last_pkt, _max_pid_pkts)) {
+            st.flags |= PF_LATE_PID;
+            error(PID_ERROR, pid, u"no packet for %'d ms", {PacketInterval(_bitrate, _packet_count - st.last_pkt)});
+        }
+        if (_priority >= 2 && (st.refs & REF_PCR) != 0 && (st.flags & PF_LATE_PCR) == 0 && tooLate(st.last_pcr_pkt, _max_pcr_pkts)) {
+            st.flags |= PF_LATE_PCR;
+            error(PCR_REPETITION_ERROR, pid, u"no PCR for %'d ms", {PacketInterval(_bitrate, _packet_count - st.last_pcr_pkt)});
+        }
+    }
+
+    // PID's with PTS.
+    for (auto it = _pts_pids.begin(); it != _pts_pids.end(); ++it) {
+        const PID pid = *it;
+        PIDState& st(_pids[pid]);
+        if ((st.flags & PF_LATE_PTS) == 0 && tooLate(st.last_pts_pkt, _max_pts_pkts)) {
+            st.flags |= PF_LATE_PTS;
+            error(PTS_ERROR, pid, u"no PTS for %'d ms", {PacketInterval(_bitrate, _packet_count - st.last_pts_pkt)});
+        }
+    }
+
+    // Unreferenced PID's, once all PMT's are known.
+    if (_priority >= 3 && _psi_complete && tooLate(_psi_complete_pkt, _max_unref_pkts)) {
+        for (auto it = _seen_pids.begin(); it != _seen_pids.end(); ++it) {
+            const PID pid = *it;
+            PIDState& st(_pids[pid]);
+            if (pid >= 0x0020 && pid != PID_NULL && st.refs == 0 && (st.flags & PF_UNREF) == 0) {
+                st.flags |= PF_UNREF;
+                error(UNREFERENCED_PID, pid, u"PID not referenced in PSI", {});
+            }
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Packet processing method
+//----------------------------------------------------------------------------
+
+ts::ProcessorPlugin::Status ts::ETR290Plugin::processPacket(TSPacket& pkt, bool& flush, bool& bitrate_changed)
+{
+    // Periodic checks use packet positions as time base.
+    if (_packet_count >= _next_check) {
+        periodicCheck();
+    }
+
+    // Synchronization: sync loss after two consecutive corrupted sync bytes,
+    // sync acquired after five consecutive correct sync bytes.
+    if (!pkt.hasValidSync()) {
+        error(SYNC_BYTE_ERROR, PID_MAX, u"sync byte is 0x%X", {pkt.b[0]});
+        _good_sync = 0;
+        if (++_bad_sync >= 2 && !_sync_lost) {
+            _sync_lost = true;
+            error(TS_SYNC_LOSS, PID_MAX, u"synchronization lost", {});
+        }
+        _packet_count++;
+        return TSP_OK;
+    }
+    _bad_sync = 0;
+    if (_sync_lost && ++_good_sync >= 5) {
+        _sync_lost = false;
+    }
+
+    const PID pid = pkt.getPID();
+    PIDState& st(_pids[pid]);
+
+    if ((st.flags & PF_SEEN) == 0) {
+        st.flags |= PF_SEEN;
+        _seen_pids.push_back(pid);
+    }
+    st.last_pkt = _packet_count;
+    if ((st.flags & PF_LATE_PID) != 0) {
+        st.flags &= ~PF_LATE_PID;
+    }
+
+    // Continuity counters: adjacent identical CC are allowed once (duplicated packet),
+    // CC are not incremented on packets without payload.
+    const uint8_t cc = pkt.getCC();
+    if (pid != PID_NULL) {
+        if (st.cc < 16 && !pkt.getDiscontinuityIndicator()) {
+            const bool payload = pkt.hasPayload();
+            if (payload && cc == st.cc) {
+                if (++st.dup > 1) {
+                    error(CC_ERROR, pid, u"packet repeated %d times", {st.dup + 1});
+                }
+            }
+            else if (cc != (payload ? (st.cc + 1) & 0x0F : st.cc)) {
+                error(CC_ERROR, pid, u"incorrect continuity counter %d, expected %d", {cc, payload ? (st.cc + 1) & 0x0F : st.cc});
+                st.dup = 0;
+            }
+            else {
+                st.dup = 0;
+            }
+        }
+        st.cc = cc;
+    }
+
+    // Scrambling of PSI.
+    if (pkt.isScrambled()) {
+        if (pid == PID_PAT) {
+            error(PAT_ERROR, pid, u"scrambled PAT packet", {});
+        }
+        else if ((st.refs & REF_PMT) != 0) {
+            error(PMT_ERROR, pid, u"scrambled PMT packet", {});
+        }
+        else if (_priority >= 2 && !_cat_ok && !_cat_reported) {
+            _cat_reported = true;
+            error(CAT_ERROR, pid, u"scrambled packet without CAT", {});
+        }
+    }
+
+    // Priority 2 indicators on packets.
+    if (_priority >= 2) {
+        if (pkt.getTEI()) {
+            error(TRANSPORT_ERROR, pid, u"transport error indicator set", {});
+        }
+        if (pkt.hasPCR()) {
+            const uint64_t pcr = pkt.getPCR();
+            if ((st.flags & PF_HAS_PCR) != 0) {
+                const PacketCounter previous = st.last_pcr_pkt;
+                arrival(PCR_REPETITION_ERROR, pid, u"PCR's", st.last_pcr_pkt, _max_pcr_pkts, (st.flags & PF_LATE_PCR) != 0);
+                if (!pkt.getDiscontinuityIndicator()) {
+                    // PCR difference, including wrap-around.
+                    const uint64_t diff = (pcr + PCR_SCALE - st.last_pcr) % PCR_SCALE;
+                    if (diff > PCR_SCALE / 2) {
+                        error(PCR_DISCONTINUITY_ERROR, pid, u"PCR goes backward by %'d ms", {((PCR_SCALE - diff) * MilliSecPerSec) / SYSTEM_CLOCK_FREQ});
+                    }
+                    else if (diff > MAX_PCR_DIFF) {
+                        error(PCR_DISCONTINUITY_ERROR, pid, u"PCR jump of %'d ms", {(diff * MilliSecPerSec) / SYSTEM_CLOCK_FREQ});
+                    }
+                    else if (_bitrate > 0) {
+                        // PCR inaccuracy: difference between the PCR value and the position in the TS.
+                        const int64_t expected = int64_t(((_packet_count - previous) * PKT_SIZE * 8 * SYSTEM_CLOCK_FREQ) / _bitrate);
+                        const int64_t jitter = ((int64_t(diff) - expected) * 1000) / int64_t(SYSTEM_CLOCK_FREQ / 1000000);
+                        if (jitter > _pcr_accuracy || jitter < -_pcr_accuracy) {
+                            error(PCR_ACCURACY_ERROR, pid, u"PCR inaccuracy %'d ns", {jitter});
+                        }
+                    }
+                }
+            }
+            else {
+                st.flags |= PF_HAS_PCR;
+            }
+            st.flags &= ~PF_LATE_PCR;
+            st.last_pcr = pcr;
+            st.last_pcr_pkt = _packet_count;
+        }
+        if (pkt.getPUSI() && pkt.hasPTS()) {
+            if ((st.flags & PF_HAS_PTS) != 0) {
+                arrival(PTS_ERROR, pid, u"PTS's", st.last_pts_pkt, _max_pts_pkts, (st.flags & PF_LATE_PTS) != 0);
+                st.flags &= ~PF_LATE_PTS;
+            }
+            else {
+                st.flags |= PF_HAS_PTS;
+                _pts_pids.push_back(pid);
+                st.last_pts_pkt = _packet_count;
+            }
+        }
+    }
+
+    // Sections on PSI/SI PID's, including CRC errors.
+    if ((st.flags & PF_DEMUX) != 0) {
+        _demux.feedPacket(pkt);
+        if (_priority >= 2) {
+            SectionDemux::Status status;
+            _demux.getStatus(status);
+            if (status.wrong_crc > _wrong_crc) {
+                error(CRC_ERROR, pid, u"%d sections with wrong CRC32", {status.wrong_crc - _wrong_crc});
+                _wrong_crc = status.wrong_crc;
+            }
+        }
+    }
+
+    // Bitrate evaluation when not provided by tsp.
+    if (_use_analyzer) {
+        _pcr_analyzer.feedPacket(pkt);
+    }
+
+    _packet_count++;
+    return TSP_OK;
+}
+
+
+//----------------------------------------------------------------------------
+// Invoked by the demux for each section: check table repetitions.
+//----------------------------------------------------------------------------
+
+void ts::ETR290Plugin::handleSection(SectionDemux& demux, const Section& section)
+{
+    const PID pid = section.sourcePID();
+    const TID tid = section.tableId();
+
+    switch (pid) {
+        case PID_PAT:
+            if (tid == TID_PAT) {
+                arrival(PAT_ERROR, pid, u"PAT sections", _pat.last_pkt, _max_pat_pkts, _pat.late);
+                _pat.late = false;
+            }
+            else {
+                error(PAT_ERROR, pid, u"table id 0x%X on PAT PID", {tid});
+            }
+            break;
+        case PID_CAT:
+            if (tid != TID_CAT && _priority >= 2) {
+                error(CAT_ERROR, pid, u"table id 0x%X on CAT PID", {tid});
+            }
+            break;
+        case PID_NIT:
+            if (tid == TID_NIT_ACT) {
+                arrival(NIT_ERROR, pid, u"NIT actual sections", _nit.last_pkt, _max_nit_pkts, _nit.late);
+                _nit.late = false;
+            }
+            else if (tid != TID_NIT_OTH && tid != TID_ST) {
+                error(NIT_ERROR, pid, u"table id 0x%X on NIT PID", {tid});
+            }
+            break;
+        case PID_SDT:
+            if (tid == TID_SDT_ACT) {
+                arrival(SDT_ERROR, pid, u"SDT actual sections", _sdt.last_pkt, _max_sdt_pkts, _sdt.late);
+                _sdt.late = false;
+            }
+            else if (tid != TID_SDT_OTH && tid != TID_BAT && tid != TID_ST) {
+                error(SDT_ERROR, pid, u"table id 0x%X on SDT PID", {tid});
+            }
+            break;
+        case PID_EIT:
+            if (tid == TID_EIT_PF_ACT) {
+                arrival(EIT_ERROR, pid, u"EIT p/f actual sections", _eit.last_pkt, _max_eit_pkts, _eit.late);
+                _eit.late = false;
+            }
+            else if ((tid < TID_EIT_MIN || tid > TID_EIT_MAX) && tid != TID_ST) {
+                error(EIT_ERROR, pid, u"table id 0x%X on EIT PID", {tid});
+            }
+            break;
+        case PID_TDT:
+            if (tid == TID_TDT) {
+                arrival(TDT_ERROR, pid, u"TDT sections", _tdt.last_pkt, _max_tdt_pkts, _tdt.late);
+                _tdt.late = false;
+            }
+            else if (tid != TID_TOT && tid != TID_ST) {
+                error(TDT_ERROR, pid, u"table id 0x%X on TDT PID", {tid});
+            }
+            break;
+        default:
+            break;
+    }
+
+    // PMT repetition on all PMT PID's.
+    PIDState& st(_pids[pid]);
+    if (tid == TID_PMT && (st.refs & REF_PMT) != 0) {
+        arrival(PMT_ERROR, pid, u"PMT sections", st.last_pmt_pkt, _max_pmt_pkts, (st.flags & PF_LATE_PMT) != 0);
+        st.flags &= ~PF_LATE_PMT;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Invoked by the demux for each new PSI table: collect PID references.
+//----------------------------------------------------------------------------
+
+void ts::ETR290Plugin::handleTable(SectionDemux& demux, const BinaryTable& table)
+{
+    switch (table.tableId()) {
+        case TID_PAT: {
+            PAT pat(table);
+            if (pat.isValid() && table.sourcePID() == PID_PAT) {
+                _pat_ok = true;
+                ServiceRefsMap services;
+                for (PAT::ServiceMap::const_iterator it = pat.pmts.begin(); it != pat.pmts.end(); ++it) {
+                    const ServiceRefsMap::const_iterator old(_services.find(it->first));
+                    if (old != _services.end() && old->second.pmt_pid == it->second) {
+                        services[it->first] = old->second;
+                    }
+                    else {
+                        ServiceRefs& srv(services[it->first]);
+                        srv.pmt_pid = it->second;
+                        srv.pmt_ok = false;
+                        srv.pcr_pid = PID_NULL;
+                        filterPID(it->second);
+                    }
+                }
+                _services.swap(services);
+                rebuildReferences();
+            }
+            break;
+        }
+        case TID_CAT: {
+            CAT cat(table);
+            if (cat.isValid() && table.sourcePID() == PID_CAT) {
+                _cat_ok = true;
+                _emm_pids.clear();
+                GetCAPIDs(_emm_pids, cat.descs);
+                rebuildReferences();
+            }
+            break;
+        }
+        case TID_PMT: {
+            PMT pmt(table);
+            const ServiceRefsMap::iterator it(_services.find(pmt.service_id));
+            if (pmt.isValid() && it != _services.end() && it->second.pmt_pid == table.sourcePID()) {
+                ServiceRefs& srv(it->second);
+                srv.pmt_ok = true;
+                srv.pcr_pid = pmt.pcr_pid;
+                srv.es_pids.clear();
+                srv.ca_pids.clear();
+                GetCAPIDs(srv.ca_pids, pmt.descs);
+                for (PMT::StreamMap::const_iterator sit = pmt.streams.begin(); sit != pmt.streams.end(); ++sit) {
+                    srv.es_pids.push_back(sit->first);
+                    GetCAPIDs(srv.ca_pids, sit->second.descs);
+                }
+                rebuildReferences();
+            }
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Collect the CA PID's from CA descriptors.
+//----------------------------------------------------------------------------
+
+void ts::ETR290Plugin::GetCAPIDs(std::vector<PID>& pids, const DescriptorList& descs)
+{
+    for (size_t index = descs.search(DID_CA); index < descs.count(); index = descs.search(DID_CA, index + 1)) {
+        const CADescriptor ca(*descs[index]);
+        if (ca.isValid()) {
+            pids.push_back(ca.ca_pid);
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Add a PID in the section demux.
+//----------------------------------------------------------------------------
+
+void ts::ETR290Plugin::filterPID(PID pid)
+{
+    if ((_pids[pid].flags & PF_DEMUX) == 0) {
+        _pids[pid].flags |= PF_DEMUX;
+        _demux.addPID(pid);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Rebuild all PID references after a PSI update.
+//----------------------------------------------------------------------------
+
+void ts::ETR290Plugin::rebuildReferences()
+{
+    // Keep previous references to detect new ones.
+    for (auto pit = _ref_pids.begin(); pit != _ref_pids.end(); ++pit) {
+        PIDState& st(_pids[*pit]);
+        st.old_refs = st.refs;
+        st.refs = 0;
+    }
+    std::vector<PID> old_pids;
+    old_pids.swap(_ref_pids);
+
+    // Set new references.
+    bool complete = _pat_ok;
+    for (ServiceRefsMap::const_iterator it = _services.begin(); it != _services.end(); ++it) {
+        const ServiceRefs& srv(it->second);
+        complete = complete && srv.pmt_ok;
+        reference(srv.pmt_pid, REF_PMT);
+        if (srv.pcr_pid < PID_NULL) {
+            reference(srv.pcr_pid, REF_PCR);
+        }
+        for (auto pit = srv.es_pids.begin(); pit != srv.es_pids.end(); ++pit) {
+            reference(*pit, REF_ES);
+        }
+        for (auto pit = srv.ca_pids.begin(); pit != srv.ca_pids.end(); ++pit) {
+            reference(*pit, REF_ANY);
+        }
+    }
+    for (auto pit = _emm_pids.begin(); pit != _emm_pids.end(); ++pit) {
+        reference(*pit, REF_ANY);
+    }
+
+    // Newly referenced items start their timers now.
+    for (auto pit = _ref_pids.begin(); pit != _ref_pids.end(); ++pit) {
+        PIDState& st(_pids[*pit]);
+        const uint8_t added = st.refs & ~st.old_refs;
+        if ((added & REF_PMT) != 0) {
+            st.last_pmt_pkt = _packet_count;
+            st.flags &= ~PF_LATE_PMT;
+        }
+        if ((added & REF_ES) != 0) {
+            st.last_pkt = _packet_count;
+            st.flags &= ~PF_LATE_PID;
+        }
+        if ((added & REF_PCR) != 0 && (st.flags & PF_HAS_PCR) == 0) {
+            st.last_pcr_pkt = _packet_count;
+            st.flags &= ~PF_LATE_PCR;
+        }
+    }
+    for (auto pit = old_pids.begin(); pit != old_pids.end(); ++pit) {
+        _pids[*pit].old_refs = 0;
+    }
+
+    if (complete && !_psi_complete) {
+        _psi_complete_pkt = _packet_count;
+    }
+    _psi_complete = complete;
+}
+
+void ts::ETR290Plugin::reference(PID pid, uint8_t ref)
+{
+    PIDState& st(_pids[pid]);
+    if (st.refs == 0) {
+        _ref_pids.push_back(pid);
+    }
+    st.refs |= ref | REF_ANY;
+}
@@ -35,7 +35,12 @@
 #include "tsPlugin.h"
 #include "tsPluginRepository.h"
 #include "tsTSFileOutput.h"
+#include "tsTSFileOutputSegmented.h"
 #include "tsTSFileInput.h"
+#include "tsTSFileInputPlaylist.h"
+#include "tsTSFileIndex.h"
+#include "tsMemoryMappedFile.h"
+#include "tsPCRAnalyzer.h"
 TSDUCK_SOURCE;
 
 
@@ -54,8 +59,22 @@ namespace ts {
         virtual bool start() override;
         virtual bool stop() override;
         virtual size_t receive(TSPacket*, size_t) override;
+        virtual size_t receiveWithMetadata(TSPacket*, TSPacketMetadata*, size_t) override;
+        virtual BitRate getBitrate() override;
     private:
         TSFileInput _file;
+        TSFileInputPlaylist _playlist;
+        bool        _use_playlist;  // Read a playlist of files instead of one file
+        BitRate     _bitrate;  // Bitrate from sampled regions, zero if unknown
+
+        // Start reading a playlist. Return false on error.
+        bool startPlaylist(const UStringVector& files, TSFileInput::ReadMode read_mode);
+
+        // Compute the start offset using the file index. Return false on error.
+        bool getIndexedOffset(const UString& filename, uint64_t& offset);
+
+        // Evaluate the bitrate by sampling regions of the file.
+        void evaluateBitrate(const UString& filename, size_t regions);
 
         // Inaccessible operations
         FileInput() = delete;
@@ -72,8 +91,12 @@ namespace ts {
         virtual bool start() override;
         virtual bool stop() override;
         virtual bool send(const TSPacket*, size_t) override;
+        virtual bool sendWithMetadata(const TSPacket*, const TSPacketMetadata*, size_t) override;
+        virtual bool sendv(const TSPacketRunVector&) override;
     private:
-        TSFileOutput _file;
+        bool                  _segmented;  // Use rotating segments
+        TSFileOutput          _file;       // Single output file
+        TSFileOutputSegmented _segments;   // Segmented output
 
         // Inaccessible operations
         FileOutput() = delete;
@@ -111,18 +134,45 @@ TSPLUGIN_DECLARE_PROCESSOR(file, ts::FileProcessor)
 //----------------------------------------------------------------------------
 
 ts::FileInput::FileInput(TSP* tsp_) :
-    InputPlugin(tsp_, u"Read packets from a file.", u"[options] [file-name]"),
-    _file()
+    InputPlugin(tsp_, u"Read packets from a file.", u"[options] [file-name ...]"),
+    _file(),
+    _playlist(),
+    _use_playlist(false),
+    _bitrate(0)
 {
-    option(u"",               0,  STRING, 0, 1);
+    option(u"",               0,  STRING, 0, UNLIMITED_COUNT);
+    option(u"bitrate-regions", 0, POSITIVE);
     option(u"byte-offset",   'b', UNSIGNED);
+    option(u"cache",          0);
+    option(u"cache-mb",       0,  POSITIVE);
+    option(u"direct",         0);
+    option(u"fix-cc",         0);
+    option(u"format",         0,  TSPacketFormatEnum);
+    option(u"index-file",     0,  STRING);
     option(u"infinite",      'i');
+    option(u"mark-discontinuity", 0);
+    option(u"mmap",           0);
     option(u"packet-offset", 'p', UNSIGNED);
+    option(u"playlist",       0,  STRING);
+    option(u"prefetch-mb",    0,  POSITIVE);
+    option(u"random-access",  0);
+    option(u"read-size",      0,  POSITIVE);
     option(u"repeat",        'r', POSITIVE);
+    option(u"seek-pcr",       0,  UNSIGNED);
+    option(u"start-time",     0,  UNSIGNED);
 
     setHelp(u"File-name:\n"
             u"  Name of the input file. Use standard input by default.\n"
             u"\n"
+            u"  When several file names are specified, the files are played in sequence,\n"
+            u"  as one single stream. While a file is played, the next one is opened and\n"
+            u"  its first packets are prefetched in a background thread, so that the\n"
+            u"  transition is immediate. With --repeat or --infinite, the complete\n"
+            u"  sequence of files is repeated. See also options --playlist, --fix-cc and\n"
+            u"  --mark-discontinuity. The options which select a start position or use\n"
+            u"  the file index, --bitrate-regions and --cache cannot be used with several\n"
+            u"  files.\n"
+            u"\n"
             u"Options:\n"
             u"\n"
             u"  -b value\n"
@@ -130,6 +180,46 @@ ts::FileInput::FileInput(TSP* tsp_) :
             u"      Start reading the file at the specified byte offset (default: 0).\n"
             u"      This option is allowed only if the input file is a regular file.\n"
             u"\n"
+            u"  --bitrate-regions count\n"
+            u"      Evaluate the bitrate of the file at start, from the PCR's in the specified\n"
+            u"      number of evenly spaced regions of the file. The file is mapped in memory\n"
+            u"      and only the sampled packet headers are accessed. By default, the bitrate\n"
+            u"      is evaluated by tsp from the first input packets. This option is allowed\n"
+            u"      only if the input file is a regular file.\n"
+            u"\n"
+            u"  --cache\n"
+            u"      With --repeat or --infinite, keep the packets in memory during the first\n"
+            u"      iteration. When the file fits in the cache, the next iterations are served\n"
+            u"      from memory, without any I/O. Otherwise, only the beginning of the file\n"
+            u"      is served from memory and the rest is read from the file. The maximum\n"
+            u"      cache size is " + UString::Decimal(TSFileInput::DEFAULT_CACHE_SIZE / (1024 * 1024)) + u" MB by default. See option --cache-mb.\n"
+            u"\n"
+            u"  --cache-mb value\n"
+            u"      Specify the maximum size in megabytes of the in-memory cache of the file.\n"
+            u"      This option implies --cache.\n"
+            u"\n"
+            u"  --direct\n"
+            u"      Read the file using direct I/O, bypassing the system cache, with large\n"
+            u"      aligned read operations (see option --read-size). This avoids filling\n"
+            u"      the system cache when reading very large files. This option is allowed\n"
+            u"      only if the input file is a regular file. Ignored on Windows.\n"
+            u"\n"
+            u"  --fix-cc\n"
+            u"      With several files, renumber the continuity counters of each file so\n"
+            u"      that each PID continues the counters of the same PID in the previous\n"
+            u"      files. This avoids continuity errors at the transition between files.\n"
+            u"\n"
+            u"  --format name\n"
+            u"      Specify the format of the packets in the input file. Must be one of\n"
+            u"      \"ts\" (188-byte TS packets, the default), \"m2ts\" (192-byte packets with\n"
+            u"      a leading 4-byte arrival time stamp, Blu-ray discs) or \"rs204\" (204-byte\n"
+            u"      packets with a trailing 16-byte Reed-Solomon outer FEC). The extra bytes\n"
+            u"      are removed while reading the file. The M2TS arrival time stamps are kept\n"
+            u"      in the metadata of the packets and can be reused by the file output plugin.\n"
+            u"      With other formats than \"ts\", --packet-offset counts complete packets in\n"
+            u"      the file and the options which use the file index or --bitrate-regions\n"
+            u"      cannot be used.\n"
+            u"\n"
             u"  --help\n"
             u"      Display this help text.\n"
             u"\n"
@@ -138,17 +228,63 @@ ts::FileInput::FileInput(TSP* tsp_) :
             u"      Repeat the playout of the file infinitely (default: only once).\n"
             u"      This option is allowed only if the input file is a regular file.\n"
             u"\n"
+            u"  --index-file filename\n"
+            u"      With --start-time, --seek-pcr or --random-access, specify the name of the\n"
+            u"      index file of the input file. The default is the input file name with an\n"
+            u"      additional \"" + UString(TSFileIndex::DEFAULT_SUFFIX) + u"\" suffix. When the index file does not exist or\n"
+            u"      does not match the input file, the input file is scanned once and the\n"
+            u"      index file is created.\n"
+            u"\n"
+            u"  --mark-discontinuity\n"
+            u"      With several files, set the discontinuity_indicator in the first packet\n"
+            u"      with a PCR of each PID in each file, except the first one. This signals\n"
+            u"      the change of time base to the receivers.\n"
+            u"\n"
+            u"  --mmap\n"
+            u"      Map the file in memory instead of reading it. The file is sequentially\n"
+            u"      mapped by windows (see option --read-size) and the pages are released\n"
+            u"      from the system cache after reading. This option is allowed only if the\n"
+            u"      input file is a regular file. Ignored on Windows.\n"
+            u"\n"
             u"  -p value\n"
             u"  --packet-offset value\n"
             u"      Start reading the file at the specified TS packet (default: 0).\n"
             u"      This option is allowed only if the input file is a regular file.\n"
             u"\n"
+            u"  --playlist filename\n"
+            u"      Text file containing the names of the files to play in sequence, one\n"
+            u"      per line. Empty lines and lines starting with '#' are ignored. The files\n"
+            u"      from the playlist are played after the files from the command line.\n"
+            u"\n"
+            u"  --prefetch-mb value\n"
+            u"      With several files, specify the size in megabytes of the prefetched\n"
+            u"      area at the beginning of each file. The default is " + UString::Decimal(TSFileInputPlaylist::DEFAULT_PREFETCH_SIZE / (1024 * 1024)) + u" MB.\n"
+            u"\n"
+            u"  --random-access\n"
+            u"      Start reading the file at the first random access point (a packet with\n"
+            u"      a random_access_indicator), after the position which is specified by\n"
+            u"      --start-time or --seek-pcr, if any. The file index is used.\n"
+            u"\n"
+            u"  --read-size value\n"
+            u"      With --mmap or --direct, specify the size in bytes of the memory-mapped\n"
+            u"      windows or of the read operations. The default is " + UString::Decimal(TSFileInput::DEFAULT_READ_SIZE) + u" bytes.\n"
+            u"\n"
             u"  -r count\n"
             u"  --repeat count\n"
             u"      Repeat the playout of the file the specified number of times\n"
             u"      (default: only once). This option is allowed only if the\n"
             u"      input file is a regular file.\n"
             u"\n"
+            u"  --seek-pcr value\n"
+            u"      Start reading the file at the specified PCR value in the first PID\n"
+            u"      carrying PCR's. The file index is used to seek directly to the last\n"
+            u"      indexed PCR before this value (PCR's are indexed every " + UString::Decimal(TSFileIndex::DEFAULT_SAMPLE_INTERVAL) + u" ms).\n"
+            u"\n"
+            u"  --start-time milliseconds\n"
+            u"      Start reading the file at the specified time, in milliseconds from the\n"
+            u"      first PCR in the first PID carrying PCR's. The file index is used to seek\n"
+            u"      directly to the last indexed PCR before this time.\n"
+            u"\n"
             u"  --version\n"
             u"      Display the version number.\n");
 }
@@ -160,11 +296,20 @@ ts::FileInput::FileInput(TSP* tsp_) :
 
 ts::FileOutput::FileOutput(TSP* tsp_) :
     OutputPlugin(tsp_, u"Write packets to a file.", u"[options] [file-name]"),
-    _file()
+    _segmented(false),
+    _file(),
+    _segments()
 {
-    option(u"",        0,  STRING, 0, 1);
-    option(u"append", 'a');
-    option(u"keep",   'k');
+    option(u"",              0,  STRING, 0, 1);
+    option(u"append",       'a');
+    option(u"async",         0);
+    option(u"format",        0,  TSPacketFormatEnum);
+    option(u"keep",         'k');
+    option(u"max-duration",  0,  POSITIVE);
+    option(u"max-files",     0,  POSITIVE);
+    option(u"max-queued-mb", 0,  POSITIVE);
+    option(u"max-size",      0,  INTEGER, 0, 1, PKT_SIZE, Args::UNLIMITED_VALUE);
+    option(u"preallocate",   0,  POSITIVE);
 
     setHelp(u"File-name:\n"
             u"  Name of the created output file. Use standard output by default.\n"
@@ -176,6 +321,21 @@ ts::FileOutput::FileOutput(TSP* tsp_) :
             u"      If the file already exists, append to the end of the file.\n"
             u"      By default, existing files are overwritten.\n"
             u"\n"
+            u"  --async\n"
+            u"      Write the file asynchronously. The packets are queued in large chunks\n"
+            u"      which are written by a separate thread. A slow or temporarily stalled\n"
+            u"      disk does not block the processing chain, as long as the queue is not\n"
+            u"      full. See option --max-queued-mb.\n"
+            u"\n"
+            u"  --format name\n"
+            u"      Specify the format of the packets in the output file. Must be one of\n"
+            u"      \"ts\" (188-byte TS packets, the default), \"m2ts\" (192-byte packets with\n"
+            u"      a leading 4-byte arrival time stamp, Blu-ray discs) or \"rs204\" (204-byte\n"
+            u"      packets with a dummy 16-byte trailer in place of the Reed-Solomon FEC).\n"
+            u"      With \"m2ts\", the arrival time stamps of packets from an M2TS input file\n"
+            u"      are reused. Otherwise, they are computed from the input time stamps.\n"
+            u"      Other formats than \"ts\" cannot be used with segmented output.\n"
+            u"\n"
             u"  --help\n"
             u"      Display this help text.\n"
             u"\n"
@@ -184,6 +344,35 @@ ts::FileOutput::FileOutput(TSP* tsp_) :
             u"      Keep existing file (abort if the specified file already exists).\n"
             u"      By default, existing files are overwritten.\n"
             u"\n"
+            u"  --max-duration seconds\n"
+            u"      Split the output in segments of the specified maximum duration. The\n"
+            u"      duration is computed from the PCR's of the first PID which carries PCR's.\n"
+            u"      The segment files are named from the file name and the segment index\n"
+            u"      (\"foo.ts\" => \"foo-000000.ts\", \"foo-000001.ts\", etc.) The next segment\n"
+            u"      is created in the background before switching to it.\n"
+            u"\n"
+            u"  --max-files count\n"
+            u"      With --max-duration or --max-size, keep only the specified number of most\n"
+            u"      recent segments. The oldest segments are deleted in the background.\n"
+            u"\n"
+            u"  --max-queued-mb value\n"
+            u"      Specify the maximum size in megabytes of the queued data in asynchronous\n"
+            u"      mode. The default is " + UString::Decimal(TSFileOutput::DEFAULT_MAX_QUEUED / (1024 * 1024)) + u" MB. The queue depth and the time spent\n"
+            u"      waiting for the disk when the queue is full are reported in verbose mode.\n"
+            u"      This option implies --async.\n"
+            u"\n"
+            u"  --max-size bytes\n"
+            u"      Split the output in segments of the specified maximum size in bytes.\n"
+            u"      See --max-duration for the naming and the creation of segments.\n"
+            u"\n"
+            u"  --preallocate bytes\n"
+            u"      Reserve disk space for the specified number of bytes when creating the\n"
+            u"      file or each segment. This reduces the fragmentation and the allocation\n"
+            u"      overhead of long recordings. The unused space is released when the file\n"
+            u"      is closed. With --max-size, the default is to preallocate the maximum\n"
+            u"      segment size. With --max-duration only, the default is to preallocate the\n"
+            u"      size of the previous segment. Currently implemented on Linux and Windows.\n"
+            u"\n"
             u"  --version\n"
             u"      Display the version number.\n");
 }
@@ -230,20 +419,165 @@ ts::FileProcessor::FileProcessor(TSP* tsp_) :
 
 bool ts::FileInput::start()
 {
-    return _file.open (value(u""),
+    if (present(u"mmap") && present(u"direct")) {
+        tsp->error(u"options --mmap and --direct are mutually exclusive");
+        return false;
+    }
+    const TSPacketFormat format = enumValue<TSPacketFormat>(u"format", TS_FORMAT_TS);
+    if (format != TS_FORMAT_TS && (present(u"start-time") || present(u"seek-pcr") || present(u"random-access") || present(u"bitrate-regions"))) {
+        tsp->error(u"--start-time, --seek-pcr, --random-access and --bitrate-regions require the ts format");
+        return false;
+    }
+    const TSFileInput::ReadMode read_mode = present(u"mmap") ? TSFileInput::READ_MMAP : (present(u"direct") ? TSFileInput::READ_DIRECT : TSFileInput::READ_NORMAL);
+
+    // Several files are read as a playlist.
+    UStringVector files;
+    getValues(files, u"");
+    if (present(u"playlist")) {
+        UStringVector lines;
+        if (!UString::Load(lines, value(u"playlist"))) {
+            tsp->error(u"error reading playlist %s", {value(u"playlist")});
+            return false;
+        }
+        for (size_t i = 0; i < lines.size(); ++i) {
+            lines[i].trim();
+            if (!lines[i].empty() && !lines[i].startWith(u"#")) {
+                files.push_back(lines[i]);
+            }
+        }
+        if (files.empty()) {
+            tsp->error(u"empty playlist %s", {value(u"playlist")});
+            return false;
+        }
+    }
+    _use_playlist = files.size() > 1 || present(u"playlist");
+    _bitrate = 0;
+    if (_use_playlist) {
+        return startPlaylist(files, read_mode);
+    }
+    else if (present(u"fix-cc") || present(u"mark-discontinuity") || present(u"prefetch-mb")) {
+        tsp->error(u"--fix-cc, --mark-discontinuity and --prefetch-mb require several input files");
+        return false;
+    }
+
+    _file.setPacketFormat(format);
+    _file.setReadMode(read_mode, intValue<size_t>(u"read-size", 0));
+    if (present(u"cache") || present(u"cache-mb")) {
+        _file.setCacheSize((present(u"cache-mb") ? intValue<size_t>(u"cache-mb", 0) * 1024 * 1024 : TSFileInput::DEFAULT_CACHE_SIZE) / PKT_SIZE);
+    }
+
+    const UString filename(value(u""));
+    if (present(u"bitrate-regions")) {
+        if (filename.empty()) {
+            tsp->error(u"--bitrate-regions requires a regular input file");
+            return false;
+        }
+        evaluateBitrate(filename, intValue<size_t>(u"bitrate-regions"));
+    }
+
+    uint64_t offset = intValue<uint64_t>(u"byte-offset", intValue<uint64_t>(u"packet-offset", 0) * PacketFormatSize(format));
+    if ((present(u"start-time") || present(u"seek-pcr") || present(u"random-access")) && !getIndexedOffset(filename, offset)) {
+        return false;
+    }
+
+    return _file.open (filename,
                        present(u"infinite") ? 0 : intValue<size_t>(u"repeat", 1),
-                       intValue<uint64_t>(u"byte-offset", intValue<uint64_t>(u"packet-offset", 0) * PKT_SIZE),
+                       offset,
                        *tsp);
 }
 
+bool ts::FileInput::startPlaylist(const UStringVector& files, TSFileInput::ReadMode read_mode)
+{
+    if (present(u"byte-offset") || present(u"packet-offset") || present(u"start-time") || present(u"seek-pcr") ||
+        present(u"random-access") || present(u"bitrate-regions") || present(u"cache") || present(u"cache-mb"))
+    {
+        tsp->error(u"start position, file index, --bitrate-regions and --cache cannot be used with several input files");
+        return false;
+    }
+    _playlist.setPacketFormat(enumValue<TSPacketFormat>(u"format", TS_FORMAT_TS));
+    _playlist.setReadMode(read_mode, intValue<size_t>(u"read-size", 0));
+    _playlist.setPrefetchSize(intValue<size_t>(u"prefetch-mb", TSFileInputPlaylist::DEFAULT_PREFETCH_SIZE / (1024 * 1024)) * 1024 * 1024);
+    _playlist.setContinuity(present(u"fix-cc"), present(u"mark-discontinuity"));
+    if (!_playlist.open(files, present(u"infinite") ? 0 : intValue<size_t>(u"repeat", 1), *tsp)) {
+        return false;
+    }
+    tsp->verbose(u"playing %d files, starting with %s", {files.size(), _playlist.currentFileName()});
+    return true;
+}
+
+bool ts::FileInput::getIndexedOffset(const UString& filename, uint64_t& offset)
+{
+    if (filename.empty()) {
+        tsp->error(u"--start-time, --seek-pcr and --random-access require a regular input file");
+        return false;
+    }
+    if (present(u"byte-offset") || present(u"packet-offset") || (present(u"start-time") && present(u"seek-pcr"))) {
+        tsp->error(u"--start-time, --seek-pcr, --byte-offset and --packet-offset are mutually exclusive");
+        return false;
+    }
+
+    // Load the index file or build it.
+    TSFileIndex index;
+    if (!index.loadOrBuild(filename, *tsp, value(u"index-file"))) {
+        return false;
+    }
+
+    PacketCounter packet = 0;
+    if (present(u"start-time") && !index.findTime(intValue<MilliSecond>(u"start-time"), packet)) {
+        tsp->error(u"no PCR found in %s", {filename});
+        return false;
+    }
+    if (present(u"seek-pcr") && !index.findPCR(intValue<uint64_t>(u"seek-pcr"), packet)) {
+        tsp->error(u"PCR %'d not found in %s", {intValue<uint64_t>(u"seek-pcr"), filename});
+        return false;
+    }
+    if (present(u"random-access") && !index.findRandomAccess(packet, packet)) {
+        tsp->error(u"no random access point found in %s after packet %'d", {filename, packet});
+        return false;
+    }
+
+    tsp->verbose(u"starting at packet %'d in %s", {packet, filename});
+    offset = packet * PKT_SIZE;
+    return true;
+}
+
+void ts::FileInput::evaluateBitrate(const UString& filename, size_t regions)
+{
+    MemoryMappedFile file;
+    PCRAnalyzer zer(1, 32);
+    if (file.open(filename, *tsp) &&
+        zer.feedRegions(reinterpret_cast<const TSPacket*>(file.data()), file.size() / PKT_SIZE, regions))
+    {
+        _bitrate = zer.bitrate188();
+        tsp->verbose(u"bitrate from %d regions of %s: %'d b/s", {regions, filename, _bitrate});
+    }
+    else {
+        tsp->warning(u"cannot evaluate bitrate from %d regions of %s", {regions, filename});
+    }
+}
+
+ts::BitRate ts::FileInput::getBitrate()
+{
+    return _bitrate;
+}
+
 bool ts::FileInput::stop()
 {
+    if (_use_playlist) {
+        tsp->verbose(u"%'d transitions between files, %'d waited for the prefetch of the next file", {_playlist.transitionCount(), _playlist.stallCount()});
+        return _playlist.close(*tsp);
+    }
     return _file.close (*tsp);
 }
 
 size_t ts::FileInput::receive (TSPacket* buffer, size_t max_packets)
 {
-    return _file.read (buffer, max_packets, *tsp);
+    return receiveWithMetadata(buffer, 0, max_packets);
+}
+
+size_t ts::FileInput::receiveWithMetadata(TSPacket* buffer, TSPacketMetadata* mdata, size_t max_packets)
+{
+    return _use_playlist ? _playlist.read(buffer, max_packets, *tsp, mdata) : _file.read(buffer, max_packets, *tsp, mdata);
 }
 
 
@@ -253,17 +587,61 @@ size_t ts::FileInput::receive (TSPacket* buffer, size_t max_packets)
 
 bool ts::FileOutput::start()
 {
-    return _file.open (value(u""), present(u"append"), present(u"keep"), *tsp);
+    const bool async = present(u"async") || present(u"max-queued-mb");
+    const size_t max_queued = intValue<size_t>(u"max-queued-mb", 0) * 1024 * 1024;
+    const uint64_t prealloc = intValue<uint64_t>(u"preallocate", 0);
+
+    const TSPacketFormat format = enumValue<TSPacketFormat>(u"format", TS_FORMAT_TS);
+    _segmented = present(u"max-duration") || present(u"max-size");
+
+    if (!_segmented) {
+        if (present(u"max-files")) {
+            tsp->error(u"--max-files requires --max-duration or --max-size");
+            return false;
+        }
+        _file.setAsynchronous(async, max_queued);
+        _file.setPreallocation(prealloc);
+        _file.setPacketFormat(format);
+        return _file.open(value(u""), present(u"append"), present(u"keep"), *tsp);
+    }
+
+    if (present(u"append")) {
+        tsp->error(u"--append cannot be used with segmented output");
+        return false;
+    }
+    if (format != TS_FORMAT_TS) {
+        tsp->error(u"--format cannot be used with segmented output");
+        return false;
+    }
+    if (value(u"").empty()) {
+        tsp->error(u"segmented output requires a file name");
+        return false;
+    }
+    _segments.setSegmentation(intValue<uint64_t>(u"max-size", 0), intValue<MilliSecond>(u"max-duration", 0) * MilliSecPerSec, intValue<size_t>(u"max-files", 0));
+    _segments.setAsynchronous(async, max_queued);
+    _segments.setPreallocation(prealloc);
+    return _segments.open(value(u""), present(u"keep"), *tsp);
 }
 
 bool ts::FileOutput::stop()
 {
-    return _file.close (*tsp);
+    return _segmented ? _segments.close(*tsp) : _file.close(*tsp);
 }
 
 bool ts::FileOutput::send (const TSPacket* buffer, size_t packet_count)
 {
-    return _file.write (buffer, packet_count, *tsp);
+    return _segmented ? _segments.write(buffer, packet_count, *tsp) : _file.write(buffer, packet_count, *tsp);
+}
+
+bool ts::FileOutput::sendWithMetadata(const TSPacket* buffer, const TSPacketMetadata* mdata, size_t packet_count)
+{
+    return _segmented ? _segments.write(buffer, packet_count, *tsp) : _file.write(buffer, packet_count, *tsp, mdata);
+}
+
+bool ts::FileOutput::sendv(const TSPacketRunVector& runs)
+{
+    // Segmented files are written run by run since a run may be split between two files.
+    return _segmented ? OutputPlugin::sendv(runs) : _file.write(runs, *tsp);
 }
 
 
@@ -34,6 +34,7 @@
 
 #include "tsPlugin.h"
 #include "tsPluginRepository.h"
+#include "tsMemoryUtils.h"
 TSDUCK_SOURCE;
 
 
@@ -49,8 +50,20 @@ namespace ts {
         FilterPlugin (TSP*);
         virtual bool start() override;
         virtual Status processPacket(TSPacket&, bool&, bool&) override;
+        virtual size_t processPacketBatch(const TSPacketView&, TSPacketMetadata*, size_t, Status*, bool&, bool&) override;
+        virtual bool isPacketParallel() const override {return true;}
 
     private:
+        // Criteria on the TS header are compiled at start into mask/value terms on
+        // the first 4 bytes of the packet, as a big endian 32-bit value. A packet
+        // matches a term when (header & mask) == value.
+        struct HeaderTerm
+        {
+            uint32_t mask;
+            uint32_t value;
+        };
+        static const size_t MAX_TERMS = 5;
+
         int    scrambling_ctrl;  // Scrambling control value (<0: no filter)
         bool   with_payload;     // Packets with payload
         bool   with_af;          // Packets with adaptation field
@@ -66,6 +79,23 @@ namespace ts {
         int    max_af;           // Maximum adaptation field size (<0: no filter)
         PIDSet pid;              // PID values to filter
 
+        // Compiled criteria.
+        uint8_t    pid_select[PID_MAX];  // Non-zero for selected PID's
+        HeaderTerm terms[MAX_TERMS];     // Criteria on the TS header
+        size_t     term_count;           // Number of header terms
+        bool       deep;                 // Some criteria need more than the TS header
+        Status     status_match;         // Status of packets which match the criteria
+        Status     status_no_match;      // Status of packets which don't match the criteria
+
+        // Add a header term.
+        void addTerm(uint32_t mask, uint32_t value);
+
+        // Check criteria which need more than the TS header.
+        bool matchDeep(const TSPacket&) const;
+
+        // Get the processing status of a packet.
+        Status filter(const TSPacket& pkt) const;
+
         // Inaccessible operations
         FilterPlugin() = delete;
         FilterPlugin(const FilterPlugin&) = delete;
@@ -96,8 +126,14 @@ ts::FilterPlugin::FilterPlugin(TSP* tsp_) :
     max_payload(0),
     min_af(0),
     max_af(0),
-    pid()
+    pid(),
+    term_count(0),
+    deep(false),
+    status_match(TSP_OK),
+    status_no_match(TSP_DROP)
 {
+    TS_ZERO(pid_select);
+    TS_ZERO(terms);
     option(u"adaptation-field",          0);
     option(u"clear",                    'c');
     option(u"max-adaptation-field-size", 0,  INTEGER, 0, 1, 0, 184);
@@ -204,26 +240,49 @@ bool ts::FilterPlugin::start()
     max_af = intValue<int>(u"max-adaptation-field-size", -1);
     getPIDSet(pid, u"pid");
 
+    // Compile the criteria.
+    for (PID p = 0; p < PID_MAX; ++p) {
+        pid_select[p] = pid.test(p) ? 1 : 0;
+    }
+    term_count = 0;
+    if (with_payload) {
+        addTerm(0x00000010, 0x00000010);
+    }
+    if (with_af) {
+        addTerm(0x00000020, 0x00000020);
+    }
+    if (unit_start) {
+        addTerm(0x00400000, 0x00400000);
+    }
+    if (valid) {
+        addTerm(0xFF800000, uint32_t(SYNC_BYTE) << 24);
+    }
+    if (scrambling_ctrl >= 0) {
+        addTerm(0x000000C0, uint32_t(scrambling_ctrl) << 6);
+    }
+    deep = has_pcr || with_pes || min_payload >= 0 || max_payload >= 0 || min_af >= 0 || max_af >= 0;
+    status_match = negate ? (stuffing ? TSP_NULL : TSP_DROP) : TSP_OK;
+    status_no_match = negate ? TSP_OK : (stuffing ? TSP_NULL : TSP_DROP);
+
     return true;
 }
 
+void ts::FilterPlugin::addTerm(uint32_t mask, uint32_t value)
+{
+    assert(term_count < MAX_TERMS);
+    terms[term_count].mask = mask;
+    terms[term_count].value = value;
+    term_count++;
+}
+
 
 //----------------------------------------------------------------------------
-// Packet processing method
+// Check criteria which need more than the TS header.
 //----------------------------------------------------------------------------
 
-ts::ProcessorPlugin::Status ts::FilterPlugin::processPacket (TSPacket& pkt, bool& flush, bool& bitrate_changed)
+bool ts::FilterPlugin::matchDeep(const TSPacket& pkt) const
 {
-
-    // Check if the packet matches one of the selected criteria.
-
-    bool ok = pid[pkt.getPID()] ||
-        (with_payload && pkt.hasPayload()) ||
-        (with_af && pkt.hasAF()) ||
-        (unit_start && pkt.getPUSI()) ||
-        (valid && pkt.hasValidSync() && !pkt.getTEI()) ||
-        (scrambling_ctrl == pkt.getScrambling()) ||
-        (has_pcr && (pkt.hasPCR() || pkt.hasOPCR())) ||
+    return (has_pcr && (pkt.hasPCR() || pkt.hasOPCR())) ||
         (min_payload >= 0 && int (pkt.getPayloadSize()) >= min_payload) ||
         (int (pkt.getPayloadSize()) <= max_payload) ||
         (min_af >= 0 && int (pkt.getAFSize()) >= min_af) ||
@@ -244,18 +303,44 @@ ts::ProcessorPlugin::Status ts::FilterPlugin::processPacket (TSPacket& pkt, bool
 
         (with_pes && pkt.hasValidSync() && !pkt.getTEI() && pkt.getPayloadSize() >= 3 &&
          (GetUInt32 (pkt.b + pkt.getHeaderSize() - 1) & 0x00FFFFFF) == 0x000001);
+}
 
-    if (negate) {
-        ok = !ok;
-    }
 
-    if (ok) {
-        return TSP_OK;
+//----------------------------------------------------------------------------
+// Get the processing status of a packet.
+//----------------------------------------------------------------------------
+
+ts::ProcessorPlugin::Status ts::FilterPlugin::filter(const TSPacket& pkt) const
+{
+    // Check if the packet matches one of the selected criteria.
+    // The PID and the TS header are checked first, using the compiled criteria.
+    const uint32_t header = GetUInt32(pkt.b);
+    if (pid_select[(header >> 8) & 0x1FFF] != 0) {
+        return status_match;
     }
-    else if (stuffing) {
-        return TSP_NULL;
+    for (size_t i = 0; i < term_count; ++i) {
+        if ((header & terms[i].mask) == terms[i].value) {
+            return status_match;
+        }
     }
-    else {
-        return TSP_DROP;
+    return deep && matchDeep(pkt) ? status_match : status_no_match;
+}
+
+
+//----------------------------------------------------------------------------
+// Packet processing methods
+//----------------------------------------------------------------------------
+
+ts::ProcessorPlugin::Status ts::FilterPlugin::processPacket(TSPacket& pkt, bool& flush, bool& bitrate_changed)
+{
+    return filter(pkt);
+}
+
+size_t ts::FilterPlugin::processPacketBatch(const TSPacketView& pkts, TSPacketMetadata* mdata, size_t count, Status* status, bool& flush, bool& bitrate_changed)
+{
+    for (size_t i = 0; i < count; ++i) {
+        // Packets which were dropped by a previous processor start with a zero byte.
+        status[i] = pkts[i].b[0] == 0 ? TSP_DROP : filter(pkts[i]);
     }
+    return count;
 }
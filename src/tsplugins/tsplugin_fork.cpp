@@ -35,6 +35,7 @@
 #include "tsPlugin.h"
 #include "tsPluginRepository.h"
 #include "tsForkPipe.h"
+#include "tsNullReport.h"
 TSDUCK_SOURCE;
 
 
@@ -55,9 +56,18 @@ namespace ts {
 
     private:
         ForkPipe  _pipe;
+        bool      _zero_copy;     // Map the packet buffer into the pipe (Linux only)
         size_t    _buffer_size;   // Max number of packets in buffer
         size_t    _buffer_count;  // Number of packets currently in buffer
-        TSPacket* _buffer;        // Packet buffer
+        size_t    _ring_count;    // Number of buffers in zero copy mode, 1 otherwise
+        size_t    _ring_index;    // Index of current buffer in zero copy mode
+        TSPacket* _buffer;        // Packet buffers (_ring_count buffers of _buffer_size packets)
+
+        // Default number of buffered packets in zero copy mode.
+        static const size_t DEFAULT_ZERO_COPY_PACKETS = 512;
+
+        // Send the current buffer through the pipe and switch to next buffer.
+        bool flushBuffer();
 
         // Inaccessible operations
         ForkPlugin() = delete;
@@ -77,14 +87,18 @@ TSPLUGIN_DECLARE_PROCESSOR(fork, ts::ForkPlugin)
 ts::ForkPlugin::ForkPlugin(TSP* tsp_) :
     ProcessorPlugin(tsp_, u"Fork a process and send TS packets to its standard input.", u"[options] 'command'"),
     _pipe(),
+    _zero_copy(false),
     _buffer_size(0),
     _buffer_count(0),
+    _ring_count(0),
+    _ring_index(0),
     _buffer(0)
 {
     option(u"",                  0,  STRING, 1, 1);
     option(u"buffered-packets", 'b', POSITIVE);
     option(u"ignore-abort",     'i');
     option(u"nowait",           'n');
+    option(u"zero-copy",        'z');
 
     setHelp(u"Command:\n"
             u"  Specifies the command line to execute in the created process.\n"
@@ -95,7 +109,8 @@ ts::ForkPlugin::ForkPlugin(TSP* tsp_) :
             u"  --buffered-packets value\n"
             u"      Specifies the number of TS packets to buffer before sending them\n"
             u"      through the pipe to the forked process. By default, the packets are\n"
-            u"      not buffered and sent one by one.\n"
+            u"      not buffered and sent one by one. On Linux, the pipe buffer is enlarged\n"
+            u"      to hold at least that number of packets.\n"
             u"\n"
             u"  --help\n"
             u"      Display this help text.\n"
@@ -110,9 +125,20 @@ ts::ForkPlugin::ForkPlugin(TSP* tsp_) :
             u"      Do not wait for child process termination at end of input.\n"
             u"\n"
             u"  --version\n"
-            u"      Display the version number.\n");
+            u"      Display the version number.\n"
+            u"\n"
+            u"  -z\n"
+            u"  --zero-copy\n"
+            u"      Linux only: map the packet buffers into the pipe using vmsplice() instead\n"
+            u"      of copying them. The forked process must read its standard input (not\n"
+            u"      splice or tee it). The packets are always buffered in this mode, using\n"
+            u"      " + UString::Decimal(DEFAULT_ZERO_COPY_PACKETS) + u" packets by default (see --buffered-packets).\n");
 }
 
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::ForkPlugin::DEFAULT_ZERO_COPY_PACKETS;
+#endif
+
 
 //----------------------------------------------------------------------------
 // Destructor
@@ -136,19 +162,46 @@ bool ts::ForkPlugin::start()
     // Get command line arguments
     UString command(value());
     bool synchronous = !present(u"nowait");
-    _buffer_size = intValue<size_t>(u"buffered-packets", 0);
+    _zero_copy = present(u"zero-copy");
+    _buffer_size = intValue<size_t>(u"buffered-packets", _zero_copy ? DEFAULT_ZERO_COPY_PACKETS : 0);
     _pipe.setIgnoreAbort(present(u"ignore-abort"));
 
-    // If packet buffering is requested, allocate the buffer
+    if (!_pipe.setZeroCopy(_zero_copy)) {
+        tsp->error(u"--zero-copy is not supported on this system");
+        return false;
+    }
+
+    // Create pipe & process
     _buffer = 0;
     _buffer_count = 0;
-    if (_buffer_size > 0 && (_buffer = new TSPacket[_buffer_size]) == 0) {
-        tsp->error(u"cannot allocate packet buffer, reduce --buffered-packets value");
+    _ring_count = 1;
+    _ring_index = 0;
+    if (!_pipe.open(command, synchronous, PKT_SIZE * _buffer_size, *tsp)) {
         return false;
     }
 
-    // Create pipe & process
-    return _pipe.open(command, synchronous, PKT_SIZE * _buffer_size, *tsp);
+    // In zero copy mode, a buffer remains referenced by the pipe until the forked
+    // process reads it. Since the pipe cannot hold more than pipeSize() bytes, a
+    // ring of buffers which is larger than the pipe by one buffer is never overwritten
+    // before being consumed.
+    if (_zero_copy && _pipe.pipeSize() == 0) {
+        tsp->error(u"cannot get pipe buffer size, --zero-copy is not usable");
+        _pipe.close(NULLREP);
+        return false;
+    }
+    else if (_zero_copy) {
+        const size_t bufbytes = PKT_SIZE * _buffer_size;
+        _ring_count = (std::max<size_t>(_pipe.pipeSize(), bufbytes) + bufbytes - 1) / bufbytes + 1;
+        tsp->debug(u"zero copy mode, %d buffers of %d packets", {_ring_count, _buffer_size});
+    }
+
+    // If packet buffering is requested, allocate the buffer
+    if (_buffer_size > 0 && (_buffer = new TSPacket[_ring_count * _buffer_size]) == 0) {
+        tsp->error(u"cannot allocate packet buffer, reduce --buffered-packets value");
+        _pipe.close(NULLREP);
+        return false;
+    }
+    return true;
 }
 
 
@@ -160,7 +213,7 @@ bool ts::ForkPlugin::stop()
 {
     // Flush buffered packets
     if (_buffer_count > 0) {
-        _pipe.write(_buffer, PKT_SIZE * _buffer_count, *tsp);
+        flushBuffer();
     }
 
     // Free packet buffer, if there is one
@@ -187,13 +240,25 @@ ts::ProcessorPlugin::Status ts::ForkPlugin::processPacket (TSPacket& pkt, bool&
 
     // Add the packet to the buffer
     assert (_buffer_count < _buffer_size);
-    _buffer [_buffer_count++] = pkt;
+    _buffer [_ring_index * _buffer_size + _buffer_count++] = pkt;
 
     // Flush the buffer when full
     if (_buffer_count == _buffer_size) {
-        _buffer_count = 0;
-        return _pipe.write (_buffer, PKT_SIZE * _buffer_size, *tsp) ? TSP_OK : TSP_END;
+        return flushBuffer() ? TSP_OK : TSP_END;
     }
 
     return TSP_OK;
 }
+
+
+//----------------------------------------------------------------------------
+// Send the current buffer through the pipe and switch to next buffer.
+//----------------------------------------------------------------------------
+
+bool ts::ForkPlugin::flushBuffer()
+{
+    const bool ok = _pipe.write(_buffer + _ring_index * _buffer_size, PKT_SIZE * _buffer_count, *tsp);
+    _buffer_count = 0;
+    _ring_index = (_ring_index + 1) % _ring_count;
+    return ok;
+}
@@ -35,10 +35,13 @@
 #include "tsPlugin.h"
 #include "tsPluginRepository.h"
 #include "tsSectionDemux.h"
+#include "tsMessageQueue.h"
+#include "tsThread.h"
 #include "tsNames.h"
-#include "tsVariable.h"
+#include "tsMJD.h"
 #include "tsTime.h"
 #include "tsTables.h"
+#include "tsBlockOutputStream.h"
 TSDUCK_SOURCE;
 
 
@@ -47,46 +50,75 @@ TSDUCK_SOURCE;
 //----------------------------------------------------------------------------
 
 namespace ts {
-    class HistoryPlugin: public ProcessorPlugin, private TableHandlerInterface
+    class HistoryPlugin: public ProcessorPlugin, private TableHandlerInterface, private Thread
     {
     public:
         // Implementation of plugin API
         HistoryPlugin(TSP*);
+        virtual ~HistoryPlugin();
         virtual bool start() override;
         virtual bool stop() override;
         virtual Status processPacket(TSPacket&, bool&, bool&) override;
+        virtual size_t processPacketBatch(const TSPacketView&, TSPacketMetadata*, size_t, Status*, bool&, bool&) override;
 
     private:
-        // Description of one PID
+        // Maximum number of history lines waiting for the output thread.
+        static const size_t MAX_QUEUED = 1024;
+
+        // Description of one PID. The contexts are stored in a flat array, indexed by PID.
         struct PIDContext
         {
             PIDContext();                   // Constructor
-            PacketCounter     pkt_count;    // Number of packets on this PID
-            PacketCounter     first_pkt;    // First packet in TS
-            PacketCounter     last_pkt;     // Last packet in TS
-            uint16_t          service_id;   // One service the PID belongs to
-            uint8_t           scrambling;   // Last scrambling control value
-            TID               last_tid;     // Last table on this PID
-            Variable<uint8_t> pes_strid;    // PES stream id
+            PacketCounter last_pkt;         // Last packet in TS
+            uint16_t      service_id;       // One service the PID belongs to
+            uint8_t       scrambling;       // Last scrambling control value
+            uint8_t       pes_strid;        // PES stream id, if has_strid is true
+            TID           last_tid;         // Last table on this PID
+            bool          present;          // At least one packet was found on this PID
+            bool          has_strid;        // A PES stream id was found on this PID
+            bool          demux;            // The PID is filtered by the section demux
         };
 
+        // A history line, passed to the output thread.
+        struct Line
+        {
+            PacketCounter pkt;
+            UString       text;
+            Line(PacketCounter p, const UString& t) : pkt(p), text(t) {}
+        };
+        typedef MessageQueue<Line, Mutex> LineQueue;
+
         // Private members
-        std::ofstream _outfile;           // User-specified output file
-        PacketCounter _current_pkt;       // Current TS packet number
-        bool          _report_eit;        // Report EIT
-        bool          _report_cas;        // Report CAS events
-        bool          _time_all;          // Report all TDT/TOT
-        bool          _ignore_stream_id;  // Ignore stream_id modifications
-        PacketCounter _suspend_after;     // Number of missing packets after which a PID is considered as suspended
-        TDT           _last_tdt;          // Last received TDT
-        PacketCounter _last_tdt_pkt;      // Packet# of last TDT
-        bool          _last_tdt_reported; // Last TDT already reported
-        SectionDemux  _demux;             // Section filter
-        PIDContext    _cpids[PID_MAX];    // Description of each PID
+        BlockOutputStream _outfile;           // User-specified output file, written by the output thread.
+        LineQueue         _queue;             // History lines waiting for the output thread.
+        PacketCounter     _current_pkt;       // Current TS packet number
+        bool              _report_eit;        // Report EIT
+        bool              _report_cas;        // Report CAS events
+        bool              _time_all;          // Report all TDT/TOT
+        bool              _ignore_stream_id;  // Ignore stream_id modifications
+        PacketCounter     _suspend_after;     // Number of missing packets after which a PID is considered as suspended
+        Time              _last_tdt;          // Last received TDT
+        bool              _last_tdt_valid;    // _last_tdt is valid
+        PacketCounter     _last_tdt_pkt;      // Packet# of last TDT
+        bool              _last_tdt_reported; // Last TDT already reported
+        SectionDemux      _demux;             // Section filter
+        PIDContext        _cpids[PID_MAX];    // Description of each PID
 
         // Invoked by the demux when a complete table is available.
         virtual void handleTable(SectionDemux&, const BinaryTable&) override;
 
+        // Output thread.
+        virtual void main() override;
+
+        // Filter the sections of a PID.
+        void addPID(PID pid);
+
+        // Analyze a packet. Return false when the processing must stop.
+        bool analyzePacket(const TSPacket& pkt);
+
+        // Report the events on a PID. Invoked only when something changed on the PID.
+        void analyzePID(PIDContext& cpid, const TSPacket& pkt, uint8_t scrambling);
+
         // Analyze a list of descriptors, looking for ECM PID's
         void analyzeCADescriptors(const DescriptorList& dlist, uint16_t service_id);
 
@@ -104,6 +136,10 @@ namespace ts {
 TSPLUGIN_DECLARE_VERSION
 TSPLUGIN_DECLARE_PROCESSOR(history, ts::HistoryPlugin)
 
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::HistoryPlugin::MAX_QUEUED;
+#endif
+
 
 //----------------------------------------------------------------------------
 // Constructor
@@ -111,7 +147,9 @@ TSPLUGIN_DECLARE_PROCESSOR(history, ts::HistoryPlugin)
 
 ts::HistoryPlugin::HistoryPlugin(TSP* tsp_) :
     ProcessorPlugin(tsp_, u"Report a history of major events on the transport stream.", u"[options]"),
-    _outfile(),
+    Thread(),
+    _outfile(BlockOutputStream::DEFAULT_BLOCK_SIZE, *tsp),
+    _queue(MAX_QUEUED),
     _current_pkt(0),
     _report_eit(false),
     _report_cas(false),
@@ -119,6 +157,7 @@ ts::HistoryPlugin::HistoryPlugin(TSP* tsp_) :
     _ignore_stream_id(false),
     _suspend_after(0),
     _last_tdt(Time::Epoch),
+    _last_tdt_valid(false),
     _last_tdt_pkt(0),
     _last_tdt_reported(false),
     _demux(this),
@@ -180,19 +219,29 @@ ts::HistoryPlugin::HistoryPlugin(TSP* tsp_) :
             u"  sort -n output-file-name\n");
 }
 
+ts::HistoryPlugin::~HistoryPlugin()
+{
+    // Make sure the output thread is terminated, even if stop() was not called.
+    if (_outfile.isFile()) {
+        _queue.forceEnqueue(LineQueue::MessagePtr());
+        waitForTermination();
+    }
+}
+
 
 //----------------------------------------------------------------------------
 // Description of one PID : Constructor.
 //----------------------------------------------------------------------------
 
 ts::HistoryPlugin::PIDContext::PIDContext() :
-    pkt_count(0),
-    first_pkt(0),
     last_pkt(0),
     service_id(0),
     scrambling(0),
-    last_tid(0),
-    pes_strid()
+    pes_strid(0),
+    last_tid(TID_NULL),
+    present(false),
+    has_strid(false),
+    demux(false)
 {
 }
 
@@ -210,13 +259,16 @@ bool ts::HistoryPlugin::start()
     _ignore_stream_id = present(u"ignore-stream-id-change");
     _suspend_after = intValue<PacketCounter>(u"suspend-packet-threshold");
 
-    // Create output file
+    // Create output file, written in a separate thread.
     if (present(u"output-file")) {
         const UString name(value(u"output-file"));
         tsp->verbose(u"creating %s", {name});
-        _outfile.open(name.toUTF8().c_str(), std::ios::out);
-        if (!_outfile) {
-            tsp->error(u"cannot create %s", {name});
+        if (!_outfile.setFile(name)) {
+            return false;
+        }
+        if (!Thread::start()) {
+            tsp->error(u"cannot start output thread");
+            _outfile.close();
             return false;
         }
     }
@@ -224,27 +276,26 @@ bool ts::HistoryPlugin::start()
     // Reinitialize state
     _current_pkt = 0;
     _last_tdt_pkt = 0;
+    _last_tdt_valid = false;
     _last_tdt_reported = false;
-    _last_tdt.invalidate();
     for (PIDContext* p = _cpids; p < _cpids + PID_MAX; ++p) {
-        p->pkt_count = p->first_pkt = p->last_pkt = 0;
-        p->service_id = 0;
-        p->scrambling = 0;
-        p->last_tid = TID_NULL;
+        *p = PIDContext();
     }
 
-    // Reinitialize the demux
+    // Reinitialize the demux. Identical repetitions of a section are
+    // ignored from their header and CRC32 only, before building anything.
     _demux.reset();
-    _demux.addPID (PID_PAT);
-    _demux.addPID (PID_CAT);
-    _demux.addPID (PID_TSDT);
-    _demux.addPID (PID_NIT);
-    _demux.addPID (PID_SDT);
-    _demux.addPID (PID_BAT);
-    _demux.addPID (PID_TDT);
-    _demux.addPID (PID_TOT);
+    _demux.setChangeOnly(true);
+    addPID(PID_PAT);
+    addPID(PID_CAT);
+    addPID(PID_TSDT);
+    addPID(PID_NIT);
+    addPID(PID_SDT);
+    addPID(PID_BAT);
+    addPID(PID_TDT);
+    addPID(PID_TOT);
     if (_report_eit) {
-        _demux.addPID (PID_EIT);
+        addPID(PID_EIT);
     }
 
     return true;
@@ -259,13 +310,15 @@ bool ts::HistoryPlugin::stop()
 {
     // Report last packet of each PID
     for (PIDContext* p = _cpids; p < _cpids + PID_MAX; ++p) {
-        if (p->pkt_count > 0) {
+        if (p->present) {
             report(p->last_pkt, u"PID %d (0x%04X) last packet, %s", {p - _cpids, p - _cpids, p->scrambling ? u"scrambled" : u"clear"});
         }
     }
 
-    // Close output file
-    if (_outfile.is_open()) {
+    // Terminate the output thread after the last line and close the output file.
+    if (_outfile.isFile()) {
+        _queue.forceEnqueue(LineQueue::MessagePtr());
+        waitForTermination();
         _outfile.close();
     }
 
@@ -273,8 +326,22 @@ bool ts::HistoryPlugin::stop()
 }
 
 
+//----------------------------------------------------------------------------
+// Filter the sections of a PID.
+//----------------------------------------------------------------------------
+
+void ts::HistoryPlugin::addPID(PID pid)
+{
+    if (!_cpids[pid].demux) {
+        _cpids[pid].demux = true;
+        _demux.addPID(pid);
+    }
+}
+
+
 //----------------------------------------------------------------------------
 // Invoked by the demux when a complete table is available.
+// Only the tables which are needed to find new PID's are deserialized.
 //----------------------------------------------------------------------------
 
 void ts::HistoryPlugin::handleTable(SectionDemux& demux, const BinaryTable& table)
@@ -292,7 +359,7 @@ void ts::HistoryPlugin::handleTable(SectionDemux& demux, const BinaryTable& tabl
                     // Filter all PMT PIDs
                     for (PAT::ServiceMap::const_iterator it = pat.pmts.begin(); it != pat.pmts.end(); ++it) {
                         assert(it->second < PID_MAX);
-                        _demux.addPID(it->second);
+                        addPID(it->second);
                         _cpids[it->second].service_id = it->first;
                     }
                 }
@@ -301,14 +368,14 @@ void ts::HistoryPlugin::handleTable(SectionDemux& demux, const BinaryTable& tabl
         }
 
         case TID_TDT: {
-            if (table.sourcePID() == PID_TDT) {
-                // Save last TDT in context
-                _last_tdt.deserialize(table);
+            // Directly decode the UTC time from the section, save last TDT in context.
+            if (table.sourcePID() == PID_TDT && table.sectionCount() == 1 && table.sectionAt(0)->payloadSize() >= MJD_SIZE) {
+                _last_tdt_valid = DecodeMJD(table.sectionAt(0)->payload(), MJD_SIZE, _last_tdt);
                 _last_tdt_pkt = _current_pkt;
                 _last_tdt_reported = false;
                 // Report TDT only if --time-all
-                if (_time_all && _last_tdt.isValid()) {
-                    report(u"TDT: %s UTC", {_last_tdt.utc_time.format(Time::DATE | Time::TIME)});
+                if (_time_all && _last_tdt_valid) {
+                    report(u"TDT: %s UTC", {_last_tdt.format(Time::DATE | Time::TIME)});
                 }
             }
             break;
@@ -430,7 +497,7 @@ void ts::HistoryPlugin::analyzeCADescriptors (const DescriptorList& dlist, uint1
         // Record state of main CA pid for this descriptor
         _cpids[pid].service_id = service_id;
         if (_report_cas) {
-            _demux.addPID(pid);
+            addPID(pid);
         }
 
         // Normally, no PID should be referenced in the private part of
@@ -445,7 +512,7 @@ void ts::HistoryPlugin::analyzeCADescriptors (const DescriptorList& dlist, uint1
                 // Record state of secondary pid
                 _cpids[pid].service_id = service_id;
                 if (_report_cas) {
-                    _demux.addPID(pid);
+                    addPID(pid);
                 }
             }
         }
@@ -454,10 +521,39 @@ void ts::HistoryPlugin::analyzeCADescriptors (const DescriptorList& dlist, uint1
 
 
 //----------------------------------------------------------------------------
-// Packet processing method
+// Packet processing methods
 //----------------------------------------------------------------------------
 
-ts::ProcessorPlugin::Status ts::HistoryPlugin::processPacket (TSPacket& pkt, bool& flush, bool& bitrate_changed)
+ts::ProcessorPlugin::Status ts::HistoryPlugin::processPacket(TSPacket& pkt, bool& flush, bool& bitrate_changed)
+{
+    return analyzePacket(pkt) ? TSP_OK : TSP_END;
+}
+
+size_t ts::HistoryPlugin::processPacketBatch(const TSPacketView& pkts, TSPacketMetadata* mdata, size_t count, Status* status, bool& flush, bool& bitrate_changed)
+{
+    for (size_t i = 0; i < count; ++i) {
+        if (pkts[i].b[0] == 0) {
+            // Packet already dropped by a previous processor.
+            status[i] = TSP_DROP;
+        }
+        else if (analyzePacket(pkts[i])) {
+            status[i] = TSP_OK;
+        }
+        else {
+            status[i] = TSP_END;
+            return i + 1;
+        }
+    }
+    return count;
+}
+
+
+//----------------------------------------------------------------------------
+// Analyze a packet. The common case, a packet without PES start on a PID
+// without change, only updates the PID context.
+//----------------------------------------------------------------------------
+
+bool ts::HistoryPlugin::analyzePacket(const TSPacket& pkt)
 {
     // Make sure we know how long to wait for suspended PID
     if (_suspend_after == 0) {
@@ -465,60 +561,75 @@ ts::ProcessorPlugin::Status ts::HistoryPlugin::processPacket (TSPacket& pkt, boo
         _suspend_after = (PacketCounter(tsp->bitrate()) * 60) / (PKT_SIZE * 8);
         if (_suspend_after == 0) {
             tsp->warning(u"bitrate unknown or too low, use option --suspend-packet-threshold");
-            return TSP_END;
+            return false;
         }
     }
 
-    // Record information about current PID
-    PID pid = pkt.getPID();
-    PIDContext* cpid = _cpids + pid;
-    uint8_t scrambling = pkt.getScrambling();
-    bool has_pes_start = pkt.getPUSI() && pkt.getPayloadSize() >= 4 && (GetUInt32(pkt.getPayload()) >> 8) == PES_START;
-    uint8_t pes_stream_id = has_pes_start ? pkt.b[pkt.getHeaderSize() + 3] : 0;
+    const PID pid = pkt.getPID();
+    PIDContext& cpid(_cpids[pid]);
+    const uint8_t scrambling = pkt.b[3] >> 6;
+
+    if (!cpid.present || cpid.scrambling != scrambling || cpid.last_pkt + _suspend_after < _current_pkt || pkt.getPUSI()) {
+        analyzePID(cpid, pkt, scrambling);
+    }
+    cpid.last_pkt = _current_pkt;
+
+    // Filter interesting sections
+    if (cpid.demux) {
+        _demux.feedPacket(pkt);
+    }
 
-    if (cpid->pkt_count == 0) {
+    // Count TS packets
+    _current_pkt++;
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Report the events on a PID.
+//----------------------------------------------------------------------------
+
+void ts::HistoryPlugin::analyzePID(PIDContext& cpid, const TSPacket& pkt, uint8_t scrambling)
+{
+    const PID pid = pkt.getPID();
+    const bool has_pes_start = pkt.getPUSI() && pkt.getPayloadSize() >= 4 && (GetUInt32(pkt.getPayload()) >> 8) == PES_START;
+    const uint8_t pes_stream_id = has_pes_start ? pkt.b[pkt.getHeaderSize() + 3] : 0;
+
+    if (!cpid.present) {
         // First packet in a PID
-        cpid->first_pkt = _current_pkt;
+        cpid.present = true;
         report(u"PID %d (0x%X) first packet, %s", {pid, pid, scrambling ? u"scrambled" : u"clear"});
     }
-    else if (cpid->last_pkt + _suspend_after < _current_pkt) {
+    else if (cpid.last_pkt + _suspend_after < _current_pkt) {
         // Last packet in the PID is so old that we consider the PID as suspended, and now restarted
-        report(cpid->last_pkt, u"PID %d (0x%X) suspended, %s, service 0x%X", {pid, pid, cpid->scrambling ? u"scrambled" : u"clear", _cpids[pid].service_id});
-        report(u"PID %d (0x%X) restarted, %s, service 0x%04X", {pid, pid, scrambling ? u"scrambled" : u"clear", _cpids[pid].service_id});
+        report(cpid.last_pkt, u"PID %d (0x%X) suspended, %s, service 0x%X", {pid, pid, cpid.scrambling ? u"scrambled" : u"clear", cpid.service_id});
+        report(u"PID %d (0x%X) restarted, %s, service 0x%04X", {pid, pid, scrambling ? u"scrambled" : u"clear", cpid.service_id});
     }
-    else if (cpid->scrambling == 0 && scrambling != 0) {
+    else if (cpid.scrambling == 0 && scrambling != 0) {
         // Clear to scrambled transition
-        report(u"PID %d (0x%X), clear to scrambled transition, %s key, service 0x%X", {pid, pid, names::ScramblingControl(scrambling), _cpids[pid].service_id});
+        report(u"PID %d (0x%X), clear to scrambled transition, %s key, service 0x%X", {pid, pid, names::ScramblingControl(scrambling), cpid.service_id});
     }
-    else if (cpid->scrambling != 0 && scrambling == 0) {
+    else if (cpid.scrambling != 0 && scrambling == 0) {
         // Scrambled to clear transition
-        report(u"PID %d (0x%X), scrambled to clear transition, service 0x%X", {pid, pid, _cpids[pid].service_id});
+        report(u"PID %d (0x%X), scrambled to clear transition, service 0x%X", {pid, pid, cpid.service_id});
     }
-    else if (_report_cas && cpid->scrambling != scrambling) {
+    else if (_report_cas && cpid.scrambling != scrambling) {
         // New crypto-period
-        report(u"PID %d (0x%X), new crypto-period, %s key, service 0x%X", {pid, pid, names::ScramblingControl(scrambling), _cpids[pid].service_id});
+        report(u"PID %d (0x%X), new crypto-period, %s key, service 0x%X", {pid, pid, names::ScramblingControl(scrambling), cpid.service_id});
     }
     if (has_pes_start) {
-        if (!cpid->pes_strid.set()) {
+        if (!cpid.has_strid) {
             // Found first PES stream id in the PID.
             report(u"PID %d (0x%X), PES stream_id is %s", {pid, pid, names::StreamId(pes_stream_id, names::FIRST)});
         }
-        else if (cpid->pes_strid != pes_stream_id && !_ignore_stream_id) {
+        else if (cpid.pes_strid != pes_stream_id && !_ignore_stream_id) {
             // PES stream id has changed in the PID.
-            report(u"PID %d (0x%X), PES stream_id modified from 0x%X to %s", {pid, pid, cpid->pes_strid.value(), names::StreamId(pes_stream_id, names::FIRST)});
+            report(u"PID %d (0x%X), PES stream_id modified from 0x%X to %s", {pid, pid, cpid.pes_strid, names::StreamId(pes_stream_id, names::FIRST)});
         }
-        cpid->pes_strid = pes_stream_id;
+        cpid.has_strid = true;
+        cpid.pes_strid = pes_stream_id;
     }
-    cpid->scrambling = scrambling;
-    cpid->last_pkt = _current_pkt;
-    cpid->pkt_count++;
-
-    // Filter interesting sections
-    _demux.feedPacket(pkt);
-
-    // Count TS packets
-    _current_pkt++;
-    return TSP_OK;
+    cpid.scrambling = scrambling;
 }
 
 
@@ -534,16 +645,29 @@ void ts::HistoryPlugin::report(const UChar* fmt, const std::initializer_list<Arg
 void ts::HistoryPlugin::report(PacketCounter pkt, const UChar* fmt, const std::initializer_list<ArgMixIn> args)
 {
     // Reports the last TDT if required
-    if (!_time_all && _last_tdt.isValid() && !_last_tdt_reported) {
+    if (!_time_all && _last_tdt_valid && !_last_tdt_reported) {
         _last_tdt_reported = true;
-        report(_last_tdt_pkt, u"TDT: %s UTC", {_last_tdt.utc_time.format(Time::DATE | Time::TIME)});
+        report(_last_tdt_pkt, u"TDT: %s UTC", {_last_tdt.format(Time::DATE | Time::TIME)});
     }
 
-    // Then report the message.
-    if (_outfile.is_open()) {
-        _outfile << UString::Format(u"%d: ", {pkt}) << UString::Format(fmt, args) << std::endl;
+    // Then report the message. The output file is written in the output thread.
+    if (_outfile.isFile()) {
+        _queue.enqueue(LineQueue::MessagePtr(new Line(pkt, UString::Format(fmt, args))));
     }
     else {
         tsp->info(u"%d: %s", {pkt, UString::Format(fmt, args)});
     }
 }
+
+
+//----------------------------------------------------------------------------
+// Output thread: write the history lines in the output file.
+//----------------------------------------------------------------------------
+
+void ts::HistoryPlugin::main()
+{
+    LineQueue::MessagePtr line;
+    while (_queue.dequeue(line) && !line.isNull()) {
+        _outfile.putDecimal(line->pkt) << ": " << line->text << std::endl;
+    }
+}
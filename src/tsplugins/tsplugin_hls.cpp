@@ -0,0 +1,488 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+//
+//  Transport stream processor shared library:
+//  Segment the transport stream for HTTP Live Streaming (HLS).
+//
+//----------------------------------------------------------------------------
+
+#include "tsPlugin.h"
+#include "tsPluginRepository.h"
+#include "tsPESDemux.h"
+#include "tsTSFileOutput.h"
+#include "tsMessageQueue.h"
+#include "tsThread.h"
+#include "tsSysUtils.h"
+TSDUCK_SOURCE;
+
+#define DEF_DURATION      10   // Default target segment duration in seconds
+#define DEF_MAX_QUEUED     4   // Default number of segments waiting for the writer thread
+#define PTS_PER_MS        90   // PTS units per millisecond
+
+
+//----------------------------------------------------------------------------
+// Plugin definition
+//----------------------------------------------------------------------------
+
+namespace ts {
+    class HLSOutput: public OutputPlugin, private PESHandlerInterface, private Thread
+    {
+    public:
+        // Implementation of plugin API
+        HLSOutput(TSP*);
+        virtual ~HLSOutput();
+        virtual bool start() override;
+        virtual bool stop() override;
+        virtual bool send(const TSPacket*, size_t) override;
+
+    private:
+        // A complete segment, passed to the writer thread.
+        struct Segment
+        {
+            TSPacketVector packets;
+            MilliSecond    duration;
+            bool           last;
+            Segment() : packets(), duration(0), last(false) {}
+        };
+        typedef MessageQueue<Segment, Mutex> SegmentQueue;
+
+        // An entry in the playlist.
+        struct PlaylistEntry
+        {
+            UString     name;
+            MilliSecond duration;
+        };
+
+        // Command line options.
+        UString       _seg_prefix;     // Segment file name, before sequence number.
+        UString       _seg_suffix;     // Segment file name, after sequence number.
+        UString       _playlist;       // Playlist file name, empty if none.
+        MilliSecond   _duration;       // Target segment duration.
+        size_t        _live_segments;  // Number of segments in a live playlist, zero for a complete playlist.
+        PID           _video_pid;      // Video PID where RAP's are searched, PID_NULL until found.
+
+        // Working data in the output thread.
+        PESDemux       _demux;         // Locate RAP's in the video PID.
+        TSPacketVector _packets;       // Packets of the current segment.
+        PacketCounter  _first_index;   // Index of _packets[0] in the demux.
+        PacketCounter  _last_rap;      // Index of last RAP which was found.
+        bool           _has_start;     // _start_pts is valid.
+        uint64_t       _start_pts;     // PTS of the RAP at start of current segment.
+        uint64_t       _last_pts;      // Last PTS in video PID.
+        SegmentQueue   _queue;         // Segments waiting for the writer thread.
+        bool           _started;       // The writer thread is started.
+        volatile bool  _write_error;   // Error in the writer thread.
+
+        // Working data in the writer thread.
+        TSFileOutput   _file;          // Next segment file, preallocated in advance.
+        size_t         _seg_number;    // Sequence number of the next segment file.
+        uint64_t       _max_seg_size;  // Largest segment size so far.
+        MilliSecond    _max_seg_duration;  // Largest segment duration so far.
+        size_t         _media_sequence;    // Sequence number of first segment in the playlist.
+        std::list<PlaylistEntry> _entries; // Segments in the playlist.
+
+        // Name of a segment file.
+        UString segmentName(size_t number) const;
+
+        // A random access point was found in a video PES packet.
+        void randomAccessPoint(const PESPacket& pes);
+
+        // Pass the first packets of the current segment to the writer thread.
+        bool cutSegment(size_t count, MilliSecond duration, bool last);
+
+        // Create a segment file, in the writer thread.
+        bool openSegment(uint64_t preallocation);
+
+        // Write the playlist and replace the previous one, in the writer thread.
+        bool writePlaylist(bool end_list);
+
+        // Writer thread.
+        virtual void main() override;
+
+        // Implementation of PESHandlerInterface.
+        virtual void handleVideoStartCode(PESDemux&, const PESPacket&, uint8_t start_code, size_t offset, size_t size) override;
+        virtual void handleAVCAccessUnit(PESDemux&, const PESPacket&, uint8_t nal_unit_type, size_t offset, size_t size) override;
+
+        // Inaccessible operations
+        HLSOutput() = delete;
+        HLSOutput(const HLSOutput&) = delete;
+        HLSOutput& operator=(const HLSOutput&) = delete;
+    };
+}
+
+TSPLUGIN_DECLARE_VERSION
+TSPLUGIN_DECLARE_OUTPUT(hls, ts::HLSOutput)
+
+
+//----------------------------------------------------------------------------
+// Constructor and destructor.
+//----------------------------------------------------------------------------
+
+ts::HLSOutput::HLSOutput(TSP* tsp_) :
+    OutputPlugin(tsp_, u"Generate HTTP Live Streaming (HLS) segments and playlist.", u"[options] segment-file"),
+    Thread(),
+    _seg_prefix(),
+    _seg_suffix(),
+    _playlist(),
+    _duration(0),
+    _live_segments(0),
+    _video_pid(PID_NULL),
+    _demux(this),
+    _packets(),
+    _first_index(0),
+    _last_rap(0),
+    _has_start(false),
+    _start_pts(0),
+    _last_pts(0),
+    _queue(),
+    _started(false),
+    _write_error(false),
+    _file(),
+    _seg_number(0),
+    _max_seg_size(0),
+    _max_seg_duration(0),
+    _media_sequence(0),
+    _entries()
+{
+    option(u"",              0,  STRING, 1, 1);
+    option(u"duration",     'd', POSITIVE);
+    option(u"live",         'l', POSITIVE);
+    option(u"max-queued",   'm', POSITIVE);
+    option(u"playlist",     'p', STRING);
+    option(u"video-pid",    'v', PIDVAL);
+
+    setHelp(u"Parameter:\n"
+            u"  Template name of the segment files. A sequence number is inserted before\n"
+            u"  the suffix. For instance, with \"/var/www/seg.ts\", the segments are named\n"
+            u"  /var/www/seg-000000.ts, /var/www/seg-000001.ts, etc.\n"
+            u"\n"
+            u"  The transport stream is cut at random access points of the video PID\n"
+            u"  (AVC IDR pictures or MPEG-2 sequence headers), so that each segment starts\n"
+            u"  with a decodable picture. The segments are written by a separate thread.\n"
+            u"  The next segment file is created and its disk space is reserved in advance,\n"
+            u"  so that the output is not delayed by file system operations.\n"
+            u"\n"
+            u"Options:\n"
+            u"\n"
+            u"  -d value\n"
+            u"  --duration value\n"
+            u"      Target duration in seconds of each segment. A segment is cut at the first\n"
+            u"      random access point after this duration. The default is " TS_USTRINGIFY(DEF_DURATION) u" seconds.\n"
+            u"\n"
+            u"  --help\n"
+            u"      Display this help text.\n"
+            u"\n"
+            u"  -l value\n"
+            u"  --live value\n"
+            u"      Generate a live playlist containing the specified number of segments.\n"
+            u"      Older segment files are deleted when they leave the playlist. By default,\n"
+            u"      the playlist contains all segments and no file is deleted.\n"
+            u"\n"
+            u"  -m value\n"
+            u"  --max-queued value\n"
+            u"      Maximum number of segments waiting for the writer thread. When the file\n"
+            u"      system is too slow, tsp waits. The default is " TS_USTRINGIFY(DEF_MAX_QUEUED) u" segments.\n"
+            u"\n"
+            u"  -p filename\n"
+            u"  --playlist filename\n"
+            u"      Name of the .m3u8 playlist file to generate. The playlist is written in\n"
+            u"      a temporary file which replaces the previous playlist after each segment.\n"
+            u"      By default, no playlist is generated.\n"
+            u"\n"
+            u"  -v value\n"
+            u"  --video-pid value\n"
+            u"      PID of the video stream where random access points are searched. By\n"
+            u"      default, use the first PID where a random access point is found.\n"
+            u"\n"
+            u"  --version\n"
+            u"      Display the version number.\n");
+}
+
+ts::HLSOutput::~HLSOutput()
+{
+    // Make sure the thread is terminated, even if stop() was not called.
+    if (_started) {
+        _queue.forceEnqueue(SegmentQueue::MessagePtr());
+        waitForTermination();
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Output plugin methods
+//----------------------------------------------------------------------------
+
+bool ts::HLSOutput::start()
+{
+    const UString name(value(u""));
+    _seg_suffix = PathSuffix(name);
+    _seg_prefix = PathPrefix(name) + u"-";
+    _playlist = value(u"playlist");
+    _duration = MilliSecPerSec * intValue<MilliSecond>(u"duration", DEF_DURATION);
+    _live_segments = intValue<size_t>(u"live", 0);
+    _video_pid = intValue<PID>(u"video-pid", PID_NULL);
+    _queue.setMaxMessages(intValue<size_t>(u"max-queued", DEF_MAX_QUEUED));
+
+    _demux.reset();
+    _demux.setPIDFilter(_video_pid == PID_NULL ? AllPIDs : PIDSet().set(_video_pid));
+    _packets.clear();
+    _first_index = _last_rap = 0;
+    _has_start = false;
+    _start_pts = _last_pts = 0;
+    _write_error = false;
+    _seg_number = 0;
+    _max_seg_size = 0;
+    _max_seg_duration = 0;
+    _media_sequence = 0;
+    _entries.clear();
+
+    // Create the first segment file now, the following ones are created by the writer thread.
+    // When the bitrate is already known, reserve the space for one segment.
+    const BitRate bitrate = tsp->bitrate();
+    if (!openSegment((uint64_t(bitrate) * _duration) / (8 * MilliSecPerSec))) {
+        return false;
+    }
+    if (!Thread::start()) {
+        _file.close(*tsp);
+        return false;
+    }
+    return _started = true;
+}
+
+bool ts::HLSOutput::stop()
+{
+    if (_started) {
+        // Flush the last segment, up to the end of the stream, and terminate the writer thread.
+        if (!_write_error) {
+            cutSegment(_packets.size(), _has_start ? MilliSecond(((_last_pts - _start_pts) & PTS_DTS_MASK) / PTS_PER_MS) : 0, true);
+        }
+        _queue.forceEnqueue(SegmentQueue::MessagePtr());
+        waitForTermination();
+        _started = false;
+        tsp->verbose(u"%d segments written, max duration: %'d ms, max size: %'d bytes", {_seg_number, _max_seg_duration, _max_seg_size});
+    }
+    return !_write_error;
+}
+
+bool ts::HLSOutput::send(const TSPacket* buffer, size_t packet_count)
+{
+    for (size_t i = 0; i < packet_count && !_write_error; ++i) {
+        const TSPacket& pkt(buffer[i]);
+        if (pkt.getPID() == _video_pid && pkt.hasPTS()) {
+            _last_pts = pkt.getPTS();
+        }
+        // Keep the packet before demuxing: a RAP which is found cuts the segment at a previous packet.
+        _packets.push_back(pkt);
+        _demux.feedPacket(pkt);
+    }
+    return !_write_error;
+}
+
+
+//----------------------------------------------------------------------------
+// Locate random access points in the video PID.
+//----------------------------------------------------------------------------
+
+void ts::HLSOutput::handleVideoStartCode(PESDemux& demux, const PESPacket& pes, uint8_t start_code, size_t offset, size_t size)
+{
+    if (start_code == PST_SEQUENCE_HEADER) {
+        randomAccessPoint(pes);
+    }
+}
+
+void ts::HLSOutput::handleAVCAccessUnit(PESDemux& demux, const PESPacket& pes, uint8_t nal_unit_type, size_t offset, size_t size)
+{
+    if (nal_unit_type == AVC_AUT_IDR) {
+        randomAccessPoint(pes);
+    }
+}
+
+void ts::HLSOutput::randomAccessPoint(const PESPacket& pes)
+{
+    // Lock on the first video PID with a random access point.
+    if (_video_pid == PID_NULL) {
+        _video_pid = pes.getSourcePID();
+        _demux.setPIDFilter(PIDSet().set(_video_pid));
+        tsp->verbose(u"using video PID 0x%X (%d) for segmentation", {_video_pid, _video_pid});
+    }
+
+    // The PES packet is reported when the next one starts. All its TS packets are still in _packets.
+    // Report the PES packet once, even when it contains several IDR slices.
+    const PacketCounter index = pes.getFirstTSPacketIndex();
+    if (pes.getSourcePID() != _video_pid || index < _first_index || (_has_start && index <= _last_rap)) {
+        return;
+    }
+    const TSPacket& pkt(_packets[size_t(index - _first_index)]);
+    if (!pkt.hasPTS()) {
+        return;
+    }
+    _last_rap = index;
+
+    // The first RAP starts the first segment. The packets before it are kept in the first segment.
+    const uint64_t pts = pkt.getPTS();
+    if (!_has_start) {
+        _has_start = true;
+        _start_pts = pts;
+        return;
+    }
+
+    // Cut the segment when its duration is reached, in PTS modulo 2^33.
+    const MilliSecond duration = MilliSecond(((pts - _start_pts) & PTS_DTS_MASK) / PTS_PER_MS);
+    if (duration >= _duration) {
+        cutSegment(size_t(index - _first_index), duration, false);
+        _start_pts = pts;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Pass the first packets of the current segment to the writer thread.
+//----------------------------------------------------------------------------
+
+bool ts::HLSOutput::cutSegment(size_t count, MilliSecond duration, bool last)
+{
+    SegmentQueue::MessagePtr seg(new Segment);
+    seg->packets.assign(_packets.begin(), _packets.begin() + count);
+    seg->duration = duration;
+    seg->last = last;
+    _packets.erase(_packets.begin(), _packets.begin() + count);
+    _first_index += count;
+    return _queue.enqueue(seg);
+}
+
+
+//----------------------------------------------------------------------------
+// Segment and playlist files.
+//----------------------------------------------------------------------------
+
+ts::UString ts::HLSOutput::segmentName(size_t number) const
+{
+    return UString::Format(u"%s%06d%s", {_seg_prefix, number, _seg_suffix});
+}
+
+bool ts::HLSOutput::openSegment(uint64_t preallocation)
+{
+    // The file system metadata are updated and the space is reserved before the packets are available.
+    _file.setPreallocation(preallocation);
+    return _file.open(segmentName(_seg_number), false, false, *tsp);
+}
+
+bool ts::HLSOutput::writePlaylist(bool end_list)
+{
+    if (_playlist.empty()) {
+        return true;
+    }
+
+    // The segments are referenced relatively to the playlist when they are in the same directory.
+    const bool relative = DirectoryName(_seg_prefix) == DirectoryName(_playlist);
+    const MilliSecond target = std::max(_duration, _max_seg_duration);
+
+    // Write a temporary file, then rename it, so that clients never see a partial playlist.
+    const UString tmp_name(_playlist + u".tmp");
+    std::ofstream file(tmp_name.toUTF8().c_str(), std::ios::out | std::ios::trunc);
+    file << "#EXTM3U" << std::endl
+         << "#EXT-X-VERSION:3" << std::endl
+         << "#EXT-X-TARGETDURATION:" << ((target + MilliSecPerSec - 1) / MilliSecPerSec) << std::endl
+         << "#EXT-X-MEDIA-SEQUENCE:" << _media_sequence << std::endl;
+    if (_live_segments == 0) {
+        file << "#EXT-X-PLAYLIST-TYPE:" << (end_list ? "VOD" : "EVENT") << std::endl;
+    }
+    for (std::list<PlaylistEntry>::const_iterator it = _entries.begin(); it != _entries.end(); ++it) {
+        file << UString::Format(u"#EXTINF:%d.%03d,", {it->duration / MilliSecPerSec, it->duration % MilliSecPerSec}) << std::endl
+             << (relative ? BaseName(it->name) : it->name) << std::endl;
+    }
+    if (end_list) {
+        file << "#EXT-X-ENDLIST" << std::endl;
+    }
+    file.close();
+    if (!file) {
+        tsp->error(u"error writing %s", {tmp_name});
+        return false;
+    }
+
+    // On Windows, a file cannot be renamed over an existing one.
+    if (RenameFile(tmp_name, _playlist) != SYS_SUCCESS && (DeleteFile(_playlist) != SYS_SUCCESS || RenameFile(tmp_name, _playlist) != SYS_SUCCESS)) {
+        tsp->error(u"cannot replace %s: %s", {_playlist, ErrorCodeMessage()});
+        return false;
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Writer thread.
+//----------------------------------------------------------------------------
+
+void ts::HLSOutput::main()
+{
+    SegmentQueue::MessagePtr seg;
+
+    while (_queue.dequeue(seg) && !seg.isNull()) {
+        if (_write_error) {
+            continue;  // drain the queue after an error
+        }
+
+        // The segment file was created when the previous segment was complete.
+        const UString name(segmentName(_seg_number));
+        if (!_file.write(seg->packets.data(), seg->packets.size(), *tsp) || !_file.close(*tsp)) {
+            _write_error = true;
+            continue;
+        }
+        _seg_number++;
+        _max_seg_size = std::max<uint64_t>(_max_seg_size, seg->packets.size() * PKT_SIZE);
+        _max_seg_duration = std::max(_max_seg_duration, seg->duration);
+
+        // Update the playlist, drop the oldest segment of a live playlist.
+        PlaylistEntry entry;
+        entry.name = name;
+        entry.duration = seg->duration;
+        _entries.push_back(entry);
+        if (_live_segments > 0 && _entries.size() > _live_segments) {
+            DeleteFile(_entries.front().name);
+            _entries.pop_front();
+            _media_sequence++;
+        }
+        if (!writePlaylist(seg->last)) {
+            _write_error = true;
+            continue;
+        }
+
+        // Prepare the next segment file, with some margin on the largest segment size.
+        if (!seg->last && !openSegment(_max_seg_size + _max_seg_size / 4)) {
+            _write_error = true;
+        }
+    }
+
+    // Remove the segment file which was prepared in advance and never used.
+    if (_file.isOpen()) {
+        _file.close(*tsp);
+        DeleteFile(segmentName(_seg_number));
+    }
+}
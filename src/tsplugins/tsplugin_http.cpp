@@ -0,0 +1,456 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  Transport stream processor shared library:
+//  Receive a transport stream from an HTTP, HTTPS or FTP server.
+//
+//----------------------------------------------------------------------------
+
+#include "tsPlugin.h"
+#include "tsPluginRepository.h"
+#include "tsWebRequest.h"
+#include "tsThread.h"
+#include "tsGuardCondition.h"
+TSDUCK_SOURCE;
+
+#define DEF_MAX_QUEUED   16384   // Default number of queued TS packets (about 3 MB)
+#define DEF_RECONNECT     5000   // Default reconnection delay in milliseconds
+#define POLL_TIMEOUT       100   // Wait timeout in milliseconds, to check abort requests
+
+
+//----------------------------------------------------------------------------
+// Plugin definition
+//----------------------------------------------------------------------------
+
+namespace ts {
+    class HTTPInput: public InputPlugin, private WebRequestHandlerInterface, private Thread
+    {
+    public:
+        // Implementation of plugin API
+        HTTPInput(TSP*);
+        virtual ~HTTPInput();
+        virtual bool start() override;
+        virtual bool stop() override;
+        virtual size_t receive(TSPacket*, size_t) override;
+
+    private:
+        // Command line options.
+        size_t         _max_retry;       // Max number of consecutive reconnections after errors
+        bool           _infinite;        // Reconnect forever, even after end of content
+        MilliSecond    _reconnect_delay; // Delay before reconnection
+        WebRequest     _request;         // Web request, used by the reception thread only
+
+        // Reception state, used by the reception thread only.
+        TSPacket       _partial;         // Partially received TS packet
+        size_t         _partial_size;    // Number of bytes in _partial
+        bool           _in_sync;         // Synchronized on TS packets
+        bool           _got_data;        // Some TS packets were received from the current connection
+        bool           _http_error;      // The server returned an HTTP error
+        uint64_t       _lost_bytes;      // Bytes which were dropped to resynchronize
+
+        // Packet queue, filled by the reception thread.
+        Mutex          _mutex;           // Protect the following fields
+        Condition      _got_packets;     // Signaled when packets are added in the queue
+        Condition      _got_space;       // Signaled when packets are removed from the queue
+        TSPacketVector _queue;           // Queued TS packets
+        size_t         _queue_first;     // Index of first queued packet
+        size_t         _queue_count;     // Number of queued packets
+        bool           _started;         // The reception thread is started
+        bool           _completed;       // The reception thread has completed
+        bool           _terminate;       // Request termination of the reception thread
+
+        // Add TS packets in the queue, from the reception thread. Return false on termination.
+        bool pushPackets(const uint8_t* data, size_t count);
+
+        // Request termination of the reception thread and wait for it.
+        void terminateThread();
+
+        // Implementation of Thread.
+        virtual void main() override;
+
+        // Implementation of WebRequestHandlerInterface.
+        virtual bool handleWebStart(const WebRequest& request, size_t size) override;
+        virtual bool handleWebData(const WebRequest& request, const void* data, size_t size) override;
+
+        // Inaccessible operations
+        HTTPInput() = delete;
+        HTTPInput(const HTTPInput&) = delete;
+        HTTPInput& operator=(const HTTPInput&) = delete;
+    };
+}
+
+TSPLUGIN_DECLARE_VERSION
+TSPLUGIN_DECLARE_INPUT(http, ts::HTTPInput)
+
+
+//----------------------------------------------------------------------------
+// Constructor
+//----------------------------------------------------------------------------
+
+ts::HTTPInput::HTTPInput(TSP* tsp_) :
+    InputPlugin(tsp_, u"Receive a transport stream from an HTTP, HTTPS or FTP server.", u"[options] url"),
+    Thread(),
+    _max_retry(0),
+    _infinite(false),
+    _reconnect_delay(0),
+    _request(*tsp),
+    _partial(),
+    _partial_size(0),
+    _in_sync(false),
+    _got_data(false),
+    _http_error(false),
+    _lost_bytes(0),
+    _mutex(),
+    _got_packets(),
+    _got_space(),
+    _queue(),
+    _queue_first(0),
+    _queue_count(0),
+    _started(false),
+    _completed(false),
+    _terminate(false)
+{
+    option(u"",                    0,  STRING, 1, 1);
+    option(u"connection-timeout",  0,  POSITIVE);
+    option(u"infinite",           'i');
+    option(u"max-queued",         'm', POSITIVE);
+    option(u"max-retry",           0,  UNSIGNED);
+    option(u"proxy-host",          0,  STRING);
+    option(u"proxy-password",      0,  STRING);
+    option(u"proxy-port",          0,  UINT16);
+    option(u"proxy-user",          0,  STRING);
+    option(u"receive-timeout",     0,  POSITIVE);
+    option(u"reconnect-delay",     0,  UNSIGNED);
+    option(u"user-agent",          0,  STRING);
+
+    setHelp(u"Parameter:\n"
+            u"\n"
+            u"  Specify the URL from which to read the transport stream. The TS packets are\n"
+            u"  passed to the next plugins as they are received, the content is never\n"
+            u"  entirely buffered. This is suitable for live streams over HTTP.\n"
+            u"\n"
+            u"Options:\n"
+            u"\n"
+            u"  --connection-timeout milliseconds\n"
+            u"      Maximum time to establish the connection to the server.\n"
+            u"      By default, use the system default timeout.\n"
+            u"\n"
+            u"  --help\n"
+            u"      Display this help text.\n"
+            u"\n"
+            u"  -i\n"
+            u"  --infinite\n"
+            u"      Reconnect to the server forever, after errors and after the end of the\n"
+            u"      content. This is typically used with live streams.\n"
+            u"\n"
+            u"  -m value\n"
+            u"  --max-queued value\n"
+            u"      Maximum number of TS packets which are buffered between the reception\n"
+            u"      thread and the rest of the chain. When the buffer is full, the reception\n"
+            u"      is paused. The default is " TS_USTRINGIFY(DEF_MAX_QUEUED) u" packets.\n"
+            u"\n"
+            u"  --max-retry value\n"
+            u"      Maximum number of consecutive reconnections after transfer errors.\n"
+            u"      The counter is reset each time TS packets are received. By default,\n"
+            u"      there is no reconnection.\n"
+            u"\n"
+            u"  --proxy-host name\n"
+            u"      Optional proxy host name for Internet access.\n"
+            u"\n"
+            u"  --proxy-password string\n"
+            u"      Optional proxy password for Internet access (for use with --proxy-user).\n"
+            u"\n"
+            u"  --proxy-port value\n"
+            u"      Optional proxy port for Internet access (for use with --proxy-host).\n"
+            u"\n"
+            u"  --proxy-user name\n"
+            u"      Optional proxy user name for Internet access.\n"
+            u"\n"
+            u"  --receive-timeout milliseconds\n"
+            u"      Maximum time without receiving any data. After this time, the transfer\n"
+            u"      fails and is possibly reconnected. By default, wait forever.\n"
+            u"\n"
+            u"  --reconnect-delay milliseconds\n"
+            u"      Delay before reconnecting to the server. The default is " TS_USTRINGIFY(DEF_RECONNECT) u" ms.\n"
+            u"\n"
+            u"  --user-agent string\n"
+            u"      Specify the user agent string to send in HTTP requests.\n"
+            u"\n"
+            u"  --version\n"
+            u"      Display the version number.\n");
+}
+
+ts::HTTPInput::~HTTPInput()
+{
+    // Make sure the thread is terminated, even if stop() was not called.
+    terminateThread();
+}
+
+
+//----------------------------------------------------------------------------
+// Input plugin methods
+//----------------------------------------------------------------------------
+
+bool ts::HTTPInput::start()
+{
+    _max_retry = intValue<size_t>(u"max-retry", 0);
+    _infinite = present(u"infinite");
+    _reconnect_delay = intValue<MilliSecond>(u"reconnect-delay", DEF_RECONNECT);
+
+    _request.setURL(value(u""));
+    _request.setConnectionTimeout(intValue<MilliSecond>(u"connection-timeout", 0));
+    _request.setReceiveTimeout(intValue<MilliSecond>(u"receive-timeout", 0));
+    if (present(u"proxy-host")) {
+        _request.setProxyHost(value(u"proxy-host"), intValue<uint16_t>(u"proxy-port", 0));
+    }
+    if (present(u"proxy-user")) {
+        _request.setProxyUser(value(u"proxy-user"), value(u"proxy-password"));
+    }
+    if (present(u"user-agent")) {
+        _request.setUserAgent(value(u"user-agent"));
+    }
+
+    _partial_size = 0;
+    _lost_bytes = 0;
+    _queue.resize(intValue<size_t>(u"max-queued", DEF_MAX_QUEUED));
+    _queue_first = _queue_count = 0;
+    _completed = _terminate = false;
+
+    return _started = Thread::start();
+}
+
+bool ts::HTTPInput::stop()
+{
+    terminateThread();
+    if (_lost_bytes > 0) {
+        tsp->verbose(u"%'d bytes dropped to resynchronize on TS packets", {_lost_bytes});
+    }
+    return true;
+}
+
+size_t ts::HTTPInput::receive(TSPacket* buffer, size_t max_packets)
+{
+    GuardCondition lock(_mutex, _got_packets);
+
+    // Wait for packets, with a timeout to check abort requests.
+    while (_queue_count == 0) {
+        if (_completed || tsp->aborting()) {
+            return 0;
+        }
+        lock.waitCondition(POLL_TIMEOUT);
+    }
+
+    // Copy the packets, in two parts when the queue wraps around.
+    size_t pkt_cnt = 0;
+    while (pkt_cnt < max_packets && _queue_count > 0) {
+        const size_t n = std::min(max_packets - pkt_cnt, std::min(_queue_count, _queue.size() - _queue_first));
+        ::memcpy(buffer[pkt_cnt].b, _queue[_queue_first].b, n * PKT_SIZE);
+        pkt_cnt += n;
+        _queue_first = (_queue_first + n) % _queue.size();
+        _queue_count -= n;
+    }
+    _got_space.signal();
+    return pkt_cnt;
+}
+
+
+//----------------------------------------------------------------------------
+// Request termination of the reception thread and wait for it.
+//----------------------------------------------------------------------------
+
+void ts::HTTPInput::terminateThread()
+{
+    if (_started) {
+        {
+            GuardCondition lock(_mutex, _got_space);
+            _terminate = true;
+            lock.signal();
+        }
+        waitForTermination();
+        _started = false;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Add TS packets in the queue, from the reception thread.
+//----------------------------------------------------------------------------
+
+bool ts::HTTPInput::pushPackets(const uint8_t* data, size_t count)
+{
+    GuardCondition lock(_mutex, _got_space);
+    while (count > 0) {
+        // Wait for free space in the queue.
+        while (!_terminate && _queue_count >= _queue.size()) {
+            lock.waitCondition();
+        }
+        if (_terminate) {
+            return false;
+        }
+        // Copy as many packets as possible in the free contiguous area.
+        const size_t next = (_queue_first + _queue_count) % _queue.size();
+        const size_t n = std::min(count, std::min(_queue.size() - _queue_count, _queue.size() - next));
+        ::memcpy(_queue[next].b, data, n * PKT_SIZE);
+        _queue_count += n;
+        data += n * PKT_SIZE;
+        count -= n;
+        _got_packets.signal();
+    }
+    _got_data = true;
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Reception thread.
+//----------------------------------------------------------------------------
+
+void ts::HTTPInput::main()
+{
+    size_t retry = 0;
+
+    for (;;) {
+        // Perform one complete transfer. Each connection restarts on a packet boundary.
+        _partial_size = 0;
+        _in_sync = false;
+        _got_data = false;
+        _http_error = false;
+        const bool success = _request.downloadToApplication(this) && !_http_error;
+
+        // Check if we need to reconnect.
+        GuardCondition lock(_mutex, _got_space);
+        if (_got_data) {
+            retry = 0;
+        }
+        if (_terminate || (!_infinite && (success || retry >= _max_retry))) {
+            break;
+        }
+        retry++;
+        tsp->verbose(u"reconnecting to %s in %'d ms", {_request.originalURL(), _reconnect_delay});
+
+        // Wait for the reconnection delay, unless termination is requested.
+        if (_reconnect_delay > 0) {
+            lock.waitCondition(_reconnect_delay);
+        }
+        if (_terminate) {
+            break;
+        }
+    }
+
+    // Notify the end of reception to the receive() method.
+    GuardCondition lock(_mutex, _got_packets);
+    _completed = true;
+    lock.signal();
+}
+
+
+//----------------------------------------------------------------------------
+// Invoked by the Web request before receiving the first data.
+//----------------------------------------------------------------------------
+
+bool ts::HTTPInput::handleWebStart(const WebRequest& request, size_t size)
+{
+    // With HTTP, any error response is rejected. With other protocols, the status is zero.
+    const int status = request.httpStatus();
+    if (status != 0 && status / 100 != 2) {
+        tsp->error(u"HTTP status %d from %s", {status, request.finalURL()});
+        _http_error = true;
+        return false;
+    }
+    if (size > 0) {
+        tsp->verbose(u"downloading %'d bytes from %s", {size, request.finalURL()});
+    }
+    else {
+        tsp->verbose(u"downloading from %s", {request.finalURL()});
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Invoked by the Web request when some data are received.
+//----------------------------------------------------------------------------
+
+bool ts::HTTPInput::handleWebData(const WebRequest& request, const void* addr, size_t size)
+{
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(addr);
+
+    while (size > 0) {
+        if (_partial_size > 0) {
+            // Complete the partial packet from the previous chunk of data.
+            const size_t n = std::min(size, PKT_SIZE - _partial_size);
+            ::memcpy(_partial.b + _partial_size, data, n);
+            _partial_size += n;
+            data += n;
+            size -= n;
+            if (_partial_size == PKT_SIZE) {
+                _partial_size = 0;
+                if (!pushPackets(_partial.b, 1)) {
+                    return false;
+                }
+            }
+        }
+        else if (*data != SYNC_BYTE) {
+            // Lost synchronization, drop everything up to the next sync byte.
+            const uint8_t* sync = reinterpret_cast<const uint8_t*>(::memchr(data, SYNC_BYTE, size));
+            const size_t n = sync == 0 ? size : size_t(sync - data);
+            tsp->debug(u"dropping %d bytes to resynchronize", {n});
+            _lost_bytes += n;
+            data += n;
+            size -= n;
+            _in_sync = false;
+        }
+        else if (!_in_sync && size > PKT_SIZE && data[PKT_SIZE] != SYNC_BYTE) {
+            // After a loss of synchronization, a sync byte must be confirmed by the next packet.
+            _lost_bytes++;
+            data++;
+            size--;
+        }
+        else {
+            // Push all consecutive complete packets directly from the received data.
+            _in_sync = true;
+            size_t count = 1;
+            while ((count + 1) * PKT_SIZE <= size && data[count * PKT_SIZE] == SYNC_BYTE) {
+                count++;
+            }
+            if (count * PKT_SIZE > size) {
+                // Incomplete packet at end of data, keep it for next time.
+                ::memcpy(_partial.b, data, size);
+                _partial_size = size;
+                break;
+            }
+            if (!pushPackets(data, count)) {
+                return false;
+            }
+            data += count * PKT_SIZE;
+            size -= count * PKT_SIZE;
+        }
+    }
+    return true;
+}
@@ -36,6 +36,7 @@
 #include "tsPluginRepository.h"
 #include "tsCyclingPacketizer.h"
 #include "tsFileNameRate.h"
+#include "tsInjectionScheduler.h"
 #include "tsSectionFile.h"
 #include "tsSysUtils.h"
 TSDUCK_SOURCE;
@@ -66,6 +67,7 @@ namespace ts {
         CRC32::Validation     _crc_op;            // Validate/recompute CRC32
         bool                  _replace;           // Replace existing PID content
         bool                  _poll_files;        // Poll the presence of input files at regular intervals
+        bool                  _delta_update;      // With --poll-files, only replace modified sections
         MilliSecond           _poll_files_ms;     // Interval in milliseconds between two file polling
         Time                  _poll_file_next;    // Next UTC time of poll file
         bool                  _terminate;         // Terminate processing when insertion is complete
@@ -78,12 +80,16 @@ namespace ts {
         PacketCounter         _pid_packet_count;  // Packet counter in -PID to replace
         PacketCounter         _eval_interval;     // PID bitrate re-evaluation interval
         PacketCounter         _cycle_count;       // Number of insertion cycles
+        bool                  _pcr_based;         // Schedule new PID packets from PCR's
+        InjectionScheduler    _scheduler;         // Time-based scheduler with --pcr-based
         CyclingPacketizer     _pzer;              // Packetizer for table
         CyclingPacketizer::StuffingPolicy _stuffing_policy;
+        std::map<UString, SectionPtrVector> _file_sections;  // Last loaded sections, by file name
 
-        // Reload files, reset packetizer.
+        // Reload files, reset packetizer. When update is true, only modified files are
+        // reloaded and only modified sections are replaced in the packetizer.
         // Return true on success, false on error.
-        bool reloadFiles();
+        bool reloadFiles(bool update);
 
         // Replace current packet with one from the packetizer.
         void replacePacket(TSPacket& pkt);
@@ -112,6 +118,7 @@ ts::InjectPlugin::InjectPlugin (TSP* tsp_) :
     _crc_op(CRC32::CHECK),
     _replace(false),
     _poll_files(false),
+    _delta_update(false),
     _poll_files_ms(DEF_POLL_FILE_MS),
     _poll_file_next(),
     _terminate(false),
@@ -124,22 +131,29 @@ ts::InjectPlugin::InjectPlugin (TSP* tsp_) :
     _pid_packet_count(0),
     _eval_interval(0),
     _cycle_count(0),
+    _pcr_based(false),
+    _scheduler(),
     _pzer(),
     _stuffing_policy(CyclingPacketizer::NEVER)
 {
     option(u"",                   0,  STRING, 1, UNLIMITED_COUNT);
     option(u"binary",             0);
     option(u"bitrate",           'b', UINT32);
+    option(u"delta-update",       0);
     option(u"evaluate-interval", 'e', POSITIVE);
     option(u"force-crc",         'f');
     option(u"inter-packet",      'i', UINT32);
     option(u"joint-termination", 'j');
+    option(u"max-burst",          0,  POSITIVE);
+    option(u"pcr-based",          0);
+    option(u"pcr-pid",            0,  PIDVAL);
     option(u"pid",               'p', PIDVAL, 1, 1);
     option(u"poll-files",         0);
     option(u"repeat",             0,  POSITIVE);
     option(u"replace",           'r');
     option(u"stuffing",          's');
     option(u"terminate",         't');
+    option(u"tight-packing",      0);
     option(u"xml",                0);
 
     setHelp(u"Input files:\n"
@@ -161,6 +175,14 @@ ts::InjectPlugin::InjectPlugin (TSP* tsp_) :
             u"  --bitrate value\n"
             u"      Specifies the bitrate for the new PID, in bits/second.\n"
             u"\n"
+            u"  --delta-update\n"
+            u"      With --poll-files, when some input files are modified, only reload the\n"
+            u"      modified files and only replace the modified sections in the current\n"
+            u"      cycle. The repetition schedule of the unmodified sections is preserved.\n"
+            u"      If a modified file cannot be loaded, its previous sections are kept.\n"
+            u"      By default, when some files are modified, all files are reloaded and a\n"
+            u"      new cycle starts with all sections.\n"
+            u"\n"
             u"  -e value\n"
             u"  --evaluate-interval value\n"
             u"      When used with --replace and when specific repetition rates are\n"
@@ -190,6 +212,22 @@ ts::InjectPlugin::InjectPlugin (TSP* tsp_) :
             u"      Meaningful only when --repeat is specified.\n"
             u"      See \"tsp --help\" for more details on \"joint termination\".\n"
             u"\n"
+            u"  --max-burst value\n"
+            u"      With --pcr-based, specifies the maximum number of consecutive packets\n"
+            u"      which can be inserted in the new PID, after a lack of stuffing in the\n"
+            u"      transport stream. The default is 2.\n"
+            u"\n"
+            u"  --pcr-based\n"
+            u"      With --bitrate, schedule the packets of the new PID according to the\n"
+            u"      time of the transport stream, as computed from its PCR's. By default,\n"
+            u"      the packets of the new PID are spaced by a fixed number of packets,\n"
+            u"      computed from the transport stream bitrate at start. This is accurate\n"
+            u"      only when the transport stream has a constant bitrate.\n"
+            u"\n"
+            u"  --pcr-pid value\n"
+            u"      With --pcr-based, specifies the reference PID for PCR's. By default,\n"
+            u"      use the first PID containing PCR's.\n"
+            u"\n"
             u"  -p value\n"
             u"  --pid value\n"
             u"      PID of the output TS packets. This is a required parameter, there is\n"
@@ -218,7 +256,8 @@ ts::InjectPlugin::InjectPlugin (TSP* tsp_) :
             u"      Insert stuffing at end of each section, up to the next TS packet\n"
             u"      boundary. By default, sections are packed and start in the middle\n"
             u"      of a TS packet, after the previous section. Note, however, that\n"
-            u"      section headers are never scattered over a packet boundary.\n"
+            u"      section headers are never scattered over a packet boundary, see also\n"
+            u"      --tight-packing.\n"
             u"\n"
             u"  -t\n"
             u"  --terminate\n"
@@ -228,6 +267,12 @@ ts::InjectPlugin::InjectPlugin (TSP* tsp_) :
             u"      no longer modified (if --replace is specified, the PID is then replaced\n"
             u"      by stuffing).\n"
             u"\n"
+            u"  --tight-packing\n"
+            u"      When sections are packed, start a section in the middle of a TS packet\n"
+            u"      as long as at least one byte remains after the pointer_field, even if\n"
+            u"      the section header is split over two TS packets. This reduces the\n"
+            u"      stuffing in the PID. Some old receivers may not support it.\n"
+            u"\n"
             u"  --version\n"
             u"      Display the version number.\n"
             u"\n"
@@ -249,10 +294,15 @@ bool ts::InjectPlugin::start()
     tsp->useJointTermination(present(u"joint-termination"));
     _replace = present(u"replace");
     _poll_files = present(u"poll-files");
+    _delta_update = present(u"delta-update");
     _crc_op = present(u"force-crc") ? CRC32::COMPUTE : CRC32::CHECK;
     _pid_bitrate = intValue<BitRate>(u"bitrate", 0);
     _pid_inter_pkt = intValue<PacketCounter>(u"inter-packet", 0);
     _eval_interval = intValue<PacketCounter>(u"evaluate-interval", DEF_EVALUATE_INTERVAL);
+    _pcr_based = present(u"pcr-based");
+    _scheduler.reset();
+    _scheduler.setPCRPID(intValue<PID>(u"pcr-pid", PID_NULL));
+    _scheduler.addComponent(_pid_bitrate, intValue<size_t>(u"max-burst", InjectionScheduler::DEFAULT_MAX_BURST));
 
     if (present(u"xml")) {
         _inType = SectionFile::XML;
@@ -289,8 +339,13 @@ bool ts::InjectPlugin::start()
         tsp->error(u"specify exactly one of --replace, --bitrate, --inter-packet");
     }
 
+    if (_pcr_based && _pid_bitrate == 0) {
+        tsp->error(u"--pcr-based requires --bitrate");
+        return false;
+    }
+
     // Load sections from input files.
-    if (!reloadFiles()) {
+    if (!reloadFiles(false)) {
         return false;
     }
 
@@ -309,26 +364,37 @@ bool ts::InjectPlugin::start()
 
 
 //----------------------------------------------------------------------------
-// Reload files, reset packetizer.
+// Reload files, reset packetizer or replace modified sections.
 //----------------------------------------------------------------------------
 
-bool ts::InjectPlugin::reloadFiles()
+bool ts::InjectPlugin::reloadFiles(bool update)
 {
     // Reinitialize packetizer
-    _pzer.reset();
-    _pzer.setPID(_inject_pid);
-    _pzer.setStuffingPolicy(_stuffing_policy);
-    _pzer.setBitRate(_pid_bitrate);  // non-zero only if --bitrate is specified
+    if (!update) {
+        _pzer.reset();
+        _pzer.setPID(_inject_pid);
+        _pzer.setStuffingPolicy(_stuffing_policy);
+        _pzer.setTightPacking(present(u"tight-packing"));
+        _pzer.setBitRate(_pid_bitrate);  // non-zero only if --bitrate is specified
+        _file_sections.clear();
+    }
 
     // Load sections from input files
     bool success = true;
     _specific_rates = false;
     SectionFile file;
+    SectionPtrVector sections;
+    std::vector<MilliSecond> rates;
 
     for (FileNameRateList::iterator it = _infiles.begin(); it != _infiles.end(); ++it) {
+        SectionPtrVector& fileSections(_file_sections[it->file_name]);
         if (_poll_files && !FileExists(it->file_name)) {
             // With --poll-files, we ignore non-existent files.
             it->retry_count = 0;  // no longer needed to retry
+            fileSections.clear();
+        }
+        else if (update && it->retry_count == 0) {
+            // File not modified, reuse the same sections.
         }
         else if (!file.load(it->file_name, *tsp, _inType, _crc_op)) {
             success = false;
@@ -339,13 +405,19 @@ bool ts::InjectPlugin::reloadFiles()
         else {
             // File successfully loaded.
             it->retry_count = 0;  // no longer needed to retry
-            _pzer.addSections(file.sections(), it->repetition);
-            _specific_rates = _specific_rates || it->repetition != 0;
+            fileSections = file.sections();
             tsp->verbose(u"loaded %d sections from %s, repetition rate: %s",
-                         {file.sections().size(), it->file_name, it->repetition > 0 ? UString::Decimal(it->repetition) + u" ms" : u"unspecified"});
+                         {fileSections.size(), it->file_name, it->repetition > 0 ? UString::Decimal(it->repetition) + u" ms" : u"unspecified"});
+        }
+        if (!fileSections.empty()) {
+            sections.insert(sections.end(), fileSections.begin(), fileSections.end());
+            rates.insert(rates.end(), fileSections.size(), it->repetition);
+            _specific_rates = _specific_rates || it->repetition != 0;
         }
     }
 
+    // Reset the packetizer content or replace only modified sections.
+    _pzer.replaceSections(sections, rates);
     return success;
 }
 
@@ -382,7 +454,7 @@ ts::ProcessorPlugin::Status ts::InjectPlugin::processPacket(TSPacket& pkt, bool&
     //      specified, we compute the PID bitrate based on the TS bitrate.
 
     if (_packet_count == 0) {
-        if (_pid_bitrate != 0) {
+        if (_pid_bitrate != 0 && !_pcr_based) {
             // Case (1): compute the inter-packet interval based on the TS bitrate
             BitRate ts_bitrate = tsp->bitrate();
             if (ts_bitrate < _pid_bitrate) {
@@ -429,8 +501,8 @@ ts::ProcessorPlugin::Status ts::InjectPlugin::processPacket(TSPacket& pkt, bool&
     // Do that only at section boundary in the output PID to avoid truncated sections.
     if (_poll_files && _pzer.atSectionBoundary() && Time::CurrentUTC() >= _poll_file_next) {
         if (_infiles.scanFiles(FILE_RETRY, *tsp) > 0) {
-            // Some files have changed. Reset packetizer and reload files.
-            reloadFiles();
+            // Some files have changed. Reset packetizer and reload files or replace modified sections.
+            reloadFiles(_delta_update);
         }
         // Plan next file polling.
         _poll_file_next = Time::CurrentUTC() + _poll_files_ms;
@@ -439,6 +511,12 @@ ts::ProcessorPlugin::Status ts::InjectPlugin::processPacket(TSPacket& pkt, bool&
     // Now really process the current packet.
     _packet_count++;
 
+    // Compute the time of the packet from the PCR's.
+    if (_pcr_based) {
+        _scheduler.setTSBitRate(tsp->bitrate());
+        _scheduler.feedPacket(pkt);
+    }
+
     // If last packet was the end of repetition count, process insertion completion.
     if (!_completed && _repeat_count > 0 && _cycle_count >= _repeat_count) {
         _completed = true;
@@ -473,7 +551,13 @@ ts::ProcessorPlugin::Status ts::InjectPlugin::processPacket(TSPacket& pkt, bool&
     }
 
     // In non-replace mode (new PID insertion), replace stuffing packets when needed.
-    if (!_replace && !_completed && pid == PID_NULL && _packet_count >= _pid_next_pkt) {
+    if (_pcr_based) {
+        if (!_completed && pid == PID_NULL && _scheduler.nextComponent() != InjectionScheduler::NPOS) {
+            replacePacket(pkt);
+            _scheduler.consume(0);
+        }
+    }
+    else if (!_replace && !_completed && pid == PID_NULL && _packet_count >= _pid_next_pkt) {
         replacePacket(pkt);
         _pid_next_pkt += _pid_inter_pkt;
     }
@@ -38,6 +38,8 @@
 #include "tsUDPSocket.h"
 #include "tsSysUtils.h"
 #include "tsTime.h"
+#include "tsMonotonic.h"
+#include "tsNullReport.h"
 TSDUCK_SOURCE;
 
 // Grouping TS packets in UDP packets
@@ -46,6 +48,28 @@ TSDUCK_SOURCE;
 #define MAX_PACKET_BURST   128  // ~ 48 kB
 #define MAX_IP_SIZE      65536
 
+// Paced output
+
+#define DEF_SPIN_TIME_US       100                       // Spin before the transmit time of a datagram
+#define PACE_MAX_LATE         (100 * NanoSecPerMilliSec) // Do not try to catch up longer delays
+#define PACE_REBASE_PACKETS  1000000                     // Avoid overflows in the transmit time computation
+
+// Number of UDP messages which are received at a time
+
+#define DEF_RECEIVE_BATCH   32
+#define MAX_RECEIVE_BATCH 1024
+
+// RTP encapsulation (RFC 3550, RFC 2250)
+
+#define RTP_HEADER_SIZE          12  // Fixed part of the RTP header
+#define RTP_CLOCK_RATE        90000  // RTP time stamp frequency for MPEG-2 TS
+#define MAX_REORDER_DATAGRAMS  4096  // Maximum number of out-of-order RTP datagrams to hold
+
+// Reception from several UDP streams
+
+#define MAX_SOURCES           1024  // Maximum number of input UDP streams
+#define SOURCES_POLL_TIMEOUT   100  // Poll timeout in milliseconds, to check abort requests
+
 
 //----------------------------------------------------------------------------
 // Plugin definition
@@ -64,10 +88,48 @@ namespace ts {
         virtual bool stop() override;
         virtual BitRate getBitrate() override;
         virtual size_t receive(TSPacket*, size_t) override;
+        virtual size_t receiveWithMetadata(TSPacket*, TSPacketMetadata*, size_t) override;
+        virtual size_t receivev(TSPacket*, TSPacketMetadata*, size_t, TSPacket*, TSPacketMetadata*, size_t) override;
 
     private:
-        UDPSocket     _sock;               // Incoming socket
-        SocketAddress _dest_addr;          // Expected destination of packets
+        // An RTP datagram which is held until the previous ones are received.
+        struct RTPDatagram
+        {
+            ByteBlock  data;         // TS packets in the RTP payload
+            Time       timestamp;    // Local reception time
+            NanoSecond kernel_time;  // Kernel reception time, negative if unknown
+            RTPDatagram() : data(), timestamp(), kernel_time(-1) {}
+        };
+        typedef std::map<uint64_t, RTPDatagram> RTPDatagramMap;  // Indexed by extended sequence number
+
+        // Description of one input UDP stream.
+        struct Source
+        {
+            UString        name;            // Parameter [address:]port, for messages
+            SocketAddress  dest_addr;       // Expected destination of packets
+            UDPSocket      sock;            // Incoming socket
+            bool           ready;           // Messages are available on the socket
+            RTPDatagramMap rtp_held;        // RTP datagrams which are received ahead of sequence
+            bool           rtp_started;     // At least one RTP datagram was received
+            uint64_t       rtp_next_seq;    // Extended sequence number of the next RTP datagram to return
+            uint64_t       rtp_max_seq;     // Highest extended sequence number which was received
+            Time           rtp_last_arrival;// Local reception time of the last RTP datagram
+            uint32_t       rtp_prev_stamp;  // RTP time stamp of the previous datagram
+            NanoSecond     rtp_prev_kernel; // Kernel reception time of the previous datagram, negative if unknown
+            int64_t        rtp_jitter;      // Interarrival jitter in 1/16 of RTP time units (RFC 3550)
+            PacketCounter  rtp_datagrams;   // Number of received RTP datagrams
+            PacketCounter  rtp_reordered;   // Number of RTP datagrams received after higher sequence numbers
+            PacketCounter  rtp_duplicates;  // Number of duplicate or late RTP datagrams
+            PacketCounter  rtp_lost;        // Number of missing RTP datagrams
+
+            // Constructor.
+            Source(const UString& name_, Report& report);
+        };
+        typedef SafePtr<Source, NullMutex> SourcePtr;
+        typedef std::vector<SourcePtr> SourceVector;
+
+        SourceVector  _sources;            // All input UDP streams
+        size_t        _poll_next;          // Index of the next source to check for available messages
         MilliSecond   _eval_time;          // Bitrate evaluation interval in milli-seconds
         MilliSecond   _display_time;       // Bitrate display interval in milli-seconds
         Time          _next_display;       // Next bitrate display time
@@ -77,9 +139,51 @@ namespace ts {
         PacketCounter _packets_0;          // Number of received packets since _start_0
         Time          _start_1;            // Start of previous bitrate evaluation period
         PacketCounter _packets_1;          // Number of received packets since _start_1
-        size_t        _inbuf_count;        // Remaining TS packets in inbuf
-        size_t        _inbuf_next;         // Index in inbuf of next TS packet to return
-        uint8_t       _inbuf[MAX_IP_SIZE]; // Input buffer
+        ByteBlock     _inbuf;              // Input buffer for all messages of a batch
+        UDPSocket::ReceiveSlotVector _slots;  // Description of messages in the input buffer
+        size_t        _slot_count;         // Number of received messages in the last batch
+        size_t        _slot_next;          // Index of the next message to analyze in the last batch
+        size_t        _slot_source;        // Index of the source of the last batch
+        size_t        _inbuf_count;        // Remaining TS packets in current message
+        const uint8_t* _inbuf_next;        // Address of next TS packet to return in current message
+        NanoSecond    _inbuf_time;         // Kernel reception time of current message, negative if unknown
+        uint16_t      _inbuf_source;       // Index of the source of current message
+        bool          _rtp;                // Analyze RTP headers
+        MilliSecond   _reorder_delay;      // Maximum time to hold out-of-order RTP datagrams
+        ByteBlock     _rtp_current;        // Payload of the held RTP datagram which is currently returned
+
+        // Open and initialize the socket of a source.
+        bool openSource(Source& src, const IPAddress& local_ip, size_t recv_bufsize, bool reuse_port);
+
+        // Return packets from the received messages. When wait is false, return only
+        // the packets which are already received, do not wait for new messages.
+        size_t receivePackets(TSPacket* buffer, TSPacketMetadata* mdata, size_t max_packets, bool wait);
+
+        // Receive the next batch of messages from a source with available messages.
+        // Return false if no source is known to have available messages.
+        // Set error to true if the reception failed on the ready source.
+        bool receiveReady(bool& error);
+
+        // Wait for messages on any source, return false on error or abort.
+        bool waitSources();
+
+        // Check if a message is sent to the expected destination of a source.
+        bool checkDestination(const Source& src, const UDPSocket::ReceiveSlot& slot) const;
+
+        // Locate the TS packets in a received message, return false if there is none.
+        bool locatePackets(const Source& src, const UDPSocket::ReceiveSlot& slot);
+
+        // Analyze a received RTP message, return true if TS packets are ready to return.
+        bool analyzeRTP(size_t index, const UDPSocket::ReceiveSlot& slot);
+
+        // Return the next held RTP datagram of a source if it is in sequence or if the missing ones are given up.
+        bool releaseRTP(size_t index);
+
+        // Return the next held RTP datagram of any source.
+        bool releaseRTP();
+
+        // Count newly received packets for the evaluation of the input bitrate.
+        void countPackets(size_t count, const Time& now);
 
         // Inaccessible operations
         IPInput() = delete;
@@ -97,10 +201,36 @@ namespace ts {
         virtual bool start() override;
         virtual bool stop() override;
         virtual bool send(const TSPacket*, size_t) override;
+        virtual bool sendWithMetadata(const TSPacket*, const TSPacketMetadata*, size_t) override;
+        virtual bool sendv(const TSPacketRunVector&) override;
 
     private:
-        UDPSocket _sock;        // Outgoing socket
-        size_t    _pkt_burst;   // Number of TS packets per UDP message
+        UDPSocket     _sock;          // Outgoing socket
+        size_t        _pkt_burst;     // Number of TS packets per UDP message
+        bool          _pace;          // Send each datagram at its transmit time
+        BitRate       _pace_bitrate;  // Fixed pacing bitrate, zero if unspecified
+        NanoSecond    _relay_delay;   // Transmit time after the input time stamp, negative if unspecified
+        NanoSecond    _spin_time;     // Busy-wait duration before the transmit time of a datagram
+        BitRate       _cur_bitrate;   // Current pacing bitrate, zero if unknown
+        PID           _pcr_pid;       // PID of reference PCR's, PID_NULL if none found
+        uint64_t      _last_pcr;      // Last reference PCR value
+        PacketCounter _pcr_packets;   // Number of packets since last reference PCR
+        Monotonic     _pcr_time;      // Transmit time of last reference PCR
+        Monotonic     _base_time;     // Transmit time of the base packet
+        PacketCounter _base_packets;  // Number of packets since the base packet
+        Monotonic     _due;           // Transmit time of the last paced packet
+        Monotonic     _send_time;     // Transmit time of the next datagram
+        Monotonic     _sleep_time;    // Transmit time computed from the last reference PCR
+        bool          _slack_set;     // The timer slack of the output thread was reduced
+        Monotonic     _now;           // Current time, kept as member since an instance may hold system resources
+        TSPacketVector _gather_pkts;  // Packets from several runs, gathered to build full datagrams
+        std::vector<TSPacketMetadata> _gather_mdata; // Metadata of the gathered packets
+
+        // Compute the transmit time of the next packet in _due.
+        void pacePacket(const TSPacket& pkt);
+
+        // Wait until the transmit time in _send_time.
+        void waitSendTime();
 
         // Inaccessible operations
         IPOutput() = delete;
@@ -119,9 +249,9 @@ TSPLUGIN_DECLARE_OUTPUT(ip, ts::IPOutput)
 //----------------------------------------------------------------------------
 
 ts::IPInput::IPInput(TSP* tsp_) :
-    InputPlugin(tsp_, u"Receive TS packets from UDP/IP, multicast or unicast.", u"[options] [address:]port"),
-    _sock(false, *tsp_),
-    _dest_addr(),
+    InputPlugin(tsp_, u"Receive TS packets from UDP/IP, multicast or unicast.", u"[options] [address:]port ..."),
+    _sources(),
+    _poll_next(0),
     _eval_time(0),
     _display_time(0),
     _next_display(Time::Epoch),
@@ -131,24 +261,42 @@ ts::IPInput::IPInput(TSP* tsp_) :
     _packets_0(0),
     _start_1(Time::Epoch),
     _packets_1(0),
+    _inbuf(),
+    _slots(),
+    _slot_count(0),
+    _slot_next(0),
+    _slot_source(0),
     _inbuf_count(0),
     _inbuf_next(0),
-    _inbuf()
+    _inbuf_time(-1),
+    _inbuf_source(0),
+    _rtp(false),
+    _reorder_delay(0),
+    _rtp_current()
 {
-    option(u"",                     0,  STRING, 1, 1);
+    option(u"",                     0,  STRING, 1, MAX_SOURCES);
     option(u"buffer-size",         'b', UNSIGNED);
     option(u"display-interval",    'd', POSITIVE);
     option(u"evaluation-interval", 'e', POSITIVE);
     option(u"local-address",       'l', STRING);
+    option(u"receive-batch",        0,  INTEGER, 0, 1, 1, MAX_RECEIVE_BATCH);
+    option(u"reorder-delay",        0,  UNSIGNED);
     option(u"reuse-port",          'r');
+    option(u"rtp",                  0);
 
-    setHelp(u"Parameter:\n"
+    setHelp(u"Parameters:\n"
             u"  The parameter [address:]port describes the destination of UDP packets.\n"
             u"  The 'port' part is mandatory and specifies the UDP port to listen on.\n"
             u"  The 'address' part is optional. It specifies an IP multicast address\n"
             u"  to listen on. It can be also a host name that translates to a multicast\n"
             u"  address.\n"
             u"\n"
+            u"  Several parameters can be specified, up to " TS_USTRINGIFY(MAX_SOURCES) u". The UDP streams are\n"
+            u"  received concurrently and merged into one single transport stream. Each\n"
+            u"  packet is tagged in its metadata with the index of its stream, starting\n"
+            u"  at zero in the order of the parameters. Distinct streams with identical\n"
+            u"  ports implicitly set --reuse-port.\n"
+            u"\n"
             u"Options:\n"
             u"\n"
             u"  -b value\n"
@@ -177,10 +325,30 @@ ts::IPInput::IPInput(TSP* tsp_) :
             u"      It can be also a host name that translates to a local address.\n"
             u"      By default, listen on all local interfaces.\n"
             u"\n"
+            u"  --receive-batch value\n"
+            u"      Specify the maximum number of UDP messages which are received at a time.\n"
+            u"      On Linux, all available messages, up to this number, are received using\n"
+            u"      one single system call. On other systems, this option is ignored.\n"
+            u"      The default is " TS_USTRINGIFY(DEF_RECEIVE_BATCH) u", the maximum is " TS_USTRINGIFY(MAX_RECEIVE_BATCH) u".\n"
+            u"\n"
+            u"  --reorder-delay milliseconds\n"
+            u"      With --rtp, specify the maximum time in milliseconds to hold datagrams\n"
+            u"      which are received out of sequence, waiting for the missing ones. When\n"
+            u"      this delay expires, the missing datagrams are considered as lost. At most\n"
+            u"      " TS_USTRINGIFY(MAX_REORDER_DATAGRAMS) u" datagrams are held. The default is zero: datagrams are never\n"
+            u"      reordered, late datagrams are dropped. This option implies --rtp.\n"
+            u"\n"
             u"  -r\n"
             u"  --reuse-port\n"
             u"      Set the reuse port socket option.\n"
             u"\n"
+            u"  --rtp\n"
+            u"      Specify that the UDP messages are RTP datagrams containing TS packets\n"
+            u"      (RFC 2250). The RTP sequence numbers are used to drop duplicate datagrams\n"
+            u"      and to count the lost ones, independently in each UDP stream. See also\n"
+            u"      option --reorder-delay. By default, a possible RTP header is skipped\n"
+            u"      without analysis.\n"
+            u"\n"
             u"  --version\n"
             u"      Display the version number.\n");
 }
@@ -193,11 +361,34 @@ ts::IPInput::IPInput(TSP* tsp_) :
 ts::IPOutput::IPOutput(TSP* tsp_) :
     OutputPlugin(tsp_, u"Send TS packets using UDP/IP, multicast or unicast.", u"[options] address:port"),
     _sock(false, *tsp_),
-    _pkt_burst(DEF_PACKET_BURST)
+    _pkt_burst(DEF_PACKET_BURST),
+    _pace(false),
+    _pace_bitrate(0),
+    _relay_delay(-1),
+    _spin_time(0),
+    _cur_bitrate(0),
+    _pcr_pid(PID_NULL),
+    _last_pcr(INVALID_PCR),
+    _pcr_packets(0),
+    _pcr_time(),
+    _base_time(),
+    _base_packets(0),
+    _due(),
+    _send_time(),
+    _sleep_time(),
+    _slack_set(false),
+    _now(),
+    _gather_pkts(),
+    _gather_mdata()
 {
     option(u"",               0,  STRING, 1, 1);
+    option(u"bitrate",        0,  POSITIVE);
     option(u"local-address", 'l', STRING);
+    option(u"pace",           0);
     option(u"packet-burst",  'p', INTEGER, 0, 1, 1, MAX_PACKET_BURST);
+    option(u"relay-delay",    0,  UNSIGNED);
+    option(u"segmentation-offload", 0);
+    option(u"spin-time-us",   0,  UNSIGNED);
     option(u"ttl",           't', POSITIVE);
 
     setHelp(u"Parameter:\n"
@@ -208,6 +399,12 @@ ts::IPOutput::IPOutput(TSP* tsp_) :
             u"\n"
             u"Options:\n"
             u"\n"
+            u"  --bitrate value\n"
+            u"      With --pace, specify the bitrate in bits/second at which the datagrams\n"
+            u"      are sent. By default, the bitrate is computed from the PCR's of the first\n"
+            u"      PID which contains PCR's. When there is no PCR, the bitrate is the input\n"
+            u"      bitrate of the stream, as computed by tsp. This option implies --pace.\n"
+            u"\n"
             u"  --help\n"
             u"      Display this help text.\n"
             u"\n"
@@ -223,6 +420,36 @@ ts::IPOutput::IPOutput(TSP* tsp_) :
             u"      The default is " TS_STRINGIFY(DEF_PACKET_BURST) u", the maximum is "
             TS_STRINGIFY(MAX_PACKET_BURST) u".\n"
             u"\n"
+            u"  --pace\n"
+            u"      Send each datagram at its transmit time, as computed from the PCR's or\n"
+            u"      the bitrate (see option --bitrate), using a monotonic clock with a\n"
+            u"      microsecond resolution. This makes the regulate plugin unnecessary and\n"
+            u"      avoids bursts of datagrams. Late datagrams are sent immediately, using\n"
+            u"      as few system calls as possible.\n"
+            u"\n"
+            u"  --relay-delay milliseconds\n"
+            u"      Send each datagram at a constant delay after the reception of its first\n"
+            u"      packet by the input plugin, using the input time stamps of the packets.\n"
+            u"      The end-to-end delay of the packets through tsp becomes constant and the\n"
+            u"      timing of the input stream is reproduced, when the input plugin provides\n"
+            u"      precise time stamps (kernel time stamps with the ip input plugin for\n"
+            u"      instance). The delay shall be larger than the processing time in tsp.\n"
+            u"      Datagrams which are already late are sent immediately. This option\n"
+            u"      implies --pace. Packets without input time stamp are paced as usual.\n"
+            u"\n"
+            u"  --segmentation-offload\n"
+            u"      Use the UDP generic segmentation offload (GSO). Several UDP messages are\n"
+            u"      passed at once to the kernel which splits them into individual datagrams,\n"
+            u"      possibly in the network interface hardware. The datagrams on the network\n"
+            u"      are unchanged. This option is supported on Linux only, with kernels 4.18\n"
+            u"      and higher.\n"
+            u"\n"
+            u"  --spin-time-us value\n"
+            u"      With --pace, specify the duration in microseconds of the busy-wait before\n"
+            u"      the transmit time of a datagram. The thread sleeps until this duration\n"
+            u"      before the transmit time and then spins on the clock to send the datagram\n"
+            u"      at the exact time. The default is " TS_USTRINGIFY(DEF_SPIN_TIME_US) u" microseconds.\n"
+            u"\n"
             u"  -t value\n"
             u"  --ttl value\n"
             u"      Specifies the TTL (Time-To-Live) socket option. The actual option\n"
@@ -235,6 +462,31 @@ ts::IPOutput::IPOutput(TSP* tsp_) :
 }
 
 
+//----------------------------------------------------------------------------
+// Input source constructor
+//----------------------------------------------------------------------------
+
+ts::IPInput::Source::Source(const UString& name_, Report& report) :
+    name(name_),
+    dest_addr(),
+    sock(false, report),
+    ready(false),
+    rtp_held(),
+    rtp_started(false),
+    rtp_next_seq(0),
+    rtp_max_seq(0),
+    rtp_last_arrival(),
+    rtp_prev_stamp(0),
+    rtp_prev_kernel(-1),
+    rtp_jitter(0),
+    rtp_datagrams(0),
+    rtp_reordered(0),
+    rtp_duplicates(0),
+    rtp_lost(0)
+{
+}
+
+
 //----------------------------------------------------------------------------
 // Input start method
 //----------------------------------------------------------------------------
@@ -244,61 +496,120 @@ bool ts::IPInput::start()
     // Get command line arguments
     _eval_time = MilliSecPerSec * intValue<MilliSecond>(u"evaluation-interval", 0);
     _display_time = MilliSecPerSec * intValue<MilliSecond>(u"display-interval", 0);
-    UString destination(value(u""));
+    UStringVector destinations;
+    getValues(destinations, u"");
     UString local(value(u"local-address"));
     size_t recv_bufsize = intValue<size_t>(u"buffer-size", 0);
     bool reuse_port = present(u"reuse-port");
+    _reorder_delay = intValue<MilliSecond>(u"reorder-delay", 0);
+    _rtp = present(u"rtp") || _reorder_delay > 0;
+#if defined(TS_LINUX)
+    const size_t batch = intValue<size_t>(u"receive-batch", DEF_RECEIVE_BATCH);
+#else
+    const size_t batch = 1;
+#endif
+
+    // Resolve all specified destinations address:port
+    _sources.clear();
+    std::set<uint16_t> ports;
+    for (size_t i = 0; i < destinations.size(); ++i) {
+
+        const SourcePtr src(new Source(destinations[i], *tsp));
+        _sources.push_back(src);
+
+        if (!src->dest_addr.resolve(destinations[i], *tsp)) {
+            _sources.clear();
+            return false;
+        }
 
-    // Resolve specified destination address:port
-    if (!_dest_addr.resolve(destination, *tsp)) {
-        return false;
-    }
+        // If a destination address is specified, it must be a multicast address
+        if (src->dest_addr.hasAddress() && !src->dest_addr.isMulticast()) {
+            tsp->error(u"address %s is not multicast", {src->dest_addr.toString()});
+            _sources.clear();
+            return false;
+        }
 
-    // If a destination address is specified, it must be a multicast address
-    if (_dest_addr.hasAddress() && !_dest_addr.isMulticast()) {
-        tsp->error(u"address %s is not multicast", {_dest_addr.toString()});
-        return false;
-    }
+        // The destination port is mandatory
+        if (!src->dest_addr.hasPort()) {
+            tsp->error(u"no UDP port specified in %s", {destinations[i]});
+            _sources.clear();
+            return false;
+        }
 
-    // The destination port is mandatory
-    if (!_dest_addr.hasPort()) {
-        tsp->error(u"no UDP port specified in %s", {destination});
-        return false;
+        // Several sockets bound to the same port need the reuse port option.
+        if (!ports.insert(src->dest_addr.port()).second) {
+            reuse_port = true;
+        }
     }
 
     // Translate optional local address
     IPAddress local_ip;
     if (!local.empty() && !local_ip.resolve(local, *tsp)) {
+        _sources.clear();
         return false;
     }
 
+    // Open all sockets.
+    for (size_t i = 0; i < _sources.size(); ++i) {
+        if (!openSource(*_sources[i], local_ip, recv_bufsize, reuse_port)) {
+            _sources.clear();
+            return false;
+        }
+    }
+
+    // Sockets now ready.
+    // Initialize working data.
+    _inbuf.resize(batch * MAX_IP_SIZE);
+    _slots.clear();
+    for (size_t i = 0; i < batch; ++i) {
+        _slots.push_back(UDPSocket::ReceiveSlot(&_inbuf[i * MAX_IP_SIZE], MAX_IP_SIZE));
+    }
+    _poll_next = 0;
+    _slot_count = _slot_next = _slot_source = 0;
+    _inbuf_count = 0;
+    _inbuf_next = 0;
+    _inbuf_time = -1;
+    _inbuf_source = 0;
+    _start = _start_0 = _start_1 = _next_display = Time::Epoch;
+    _packets = _packets_0 = _packets_1 = 0;
+    _rtp_current.clear();
+
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Open and initialize the socket of a source.
+//----------------------------------------------------------------------------
+
+bool ts::IPInput::openSource(Source& src, const IPAddress& local_ip, size_t recv_bufsize, bool reuse_port)
+{
     // The local socket address to bind is the optional local IP address and the destination port
-    SocketAddress local_addr(local_ip, _dest_addr.port());
+    SocketAddress local_addr(local_ip, src.dest_addr.port());
 
     // Create UDP socket
-    if (!_sock.open(*tsp)) {
+    if (!src.sock.open(*tsp)) {
         return false;
     }
 
     // Initialize socket.
     // Note: On Windows, bind must be done *before* joining multicast groups.
     bool ok =
-        (!reuse_port || _sock.reusePort(true, *tsp)) &&
-        (recv_bufsize <= 0 ||_sock.setReceiveBufferSize(recv_bufsize, *tsp)) &&
-        _sock.bind(local_addr, *tsp) &&
-        (!_dest_addr.hasAddress() || _sock.addMembership(_dest_addr, local_ip, *tsp));
+        (!reuse_port || src.sock.reusePort(true, *tsp)) &&
+        (recv_bufsize <= 0 || src.sock.setReceiveBufferSize(recv_bufsize, *tsp)) &&
+        src.sock.bind(local_addr, *tsp) &&
+        (!src.dest_addr.hasAddress() || src.sock.addMembership(src.dest_addr, local_ip, *tsp));
 
     if (!ok) {
-        _sock.close();
+        src.sock.close();
         return false;
     }
 
-    // Socket now ready.
-    // Initialize working data.
-    _inbuf_count = _inbuf_next = 0;
-    _start = _start_0 = _start_1 = _next_display = Time::Epoch;
-    _packets = _packets_0 = _packets_1 = 0;
-
+    // Request kernel reception time stamps, when supported by the system.
+    // They are used to evaluate the input bitrate and as input time stamps.
+    if (!src.sock.setReceiveTimestamps(true, NULLREP)) {
+        tsp->debug(u"kernel reception time stamps are not available");
+    }
     return true;
 }
 
@@ -309,7 +620,16 @@ bool ts::IPInput::start()
 
 bool ts::IPInput::stop()
 {
-    _sock.close();
+    for (size_t i = 0; i < _sources.size(); ++i) {
+        const Source& src(*_sources[i]);
+        if (_rtp) {
+            tsp->verbose(u"%sRTP: %'d datagrams, %'d reordered, %'d duplicated or late, %'d lost, jitter: %'d us", {
+                _sources.size() > 1 ? src.name + u": " : UString(),
+                src.rtp_datagrams, src.rtp_reordered, src.rtp_duplicates, src.rtp_lost,
+                (src.rtp_jitter / 16) * MicroSecPerSec / RTP_CLOCK_RATE});
+        }
+    }
+    _sources.clear();
     return true;
 }
 
@@ -320,7 +640,8 @@ bool ts::IPInput::stop()
 
 ts::IPInput::~IPInput()
 {
-    _sock.close();
+    // The sockets are closed by the destructors of the sources.
+    _sources.clear();
 }
 
 
@@ -349,144 +670,442 @@ ts::BitRate ts::IPInput::getBitrate()
 
 size_t ts::IPInput::receive(TSPacket* buffer, size_t max_packets)
 {
-    // Check if we receive new packets or process remain of previous buffer.
-    bool new_packets = false;
-
-    // If there is no remaining packet in the input buffer, wait for a UDP
-    // message. Loop until we get some TS packets.
-    while (_inbuf_count <= 0) {
-
-        // Wait for a UDP message
-        SocketAddress sender;
-        SocketAddress destination;
-        size_t insize;
-        if (!_sock.receive(_inbuf, sizeof(_inbuf), insize, sender, destination, tsp, *tsp)) {
-            return 0;
-        }
+    return receiveWithMetadata(buffer, 0, max_packets);
+}
 
-        // Check the destination address to exclude packets from other streams.
-        // When several multicast streams use the same destination port and several
-        // applications on the same system listen to these distinct streams,
-        // the multicast MAC address management is such that any socket which
-        // is bound to the common port will receive the traffic for all streams.
-        // This is why we need to check the destination address and exclude
-        // packets which are not from the intended stream.
-        //
-        // We accept a packet in any of:
-        // 1) Actual packet destination is unknown. Probably, the system cannot
-        //    report the destination address.
-        // 2) We listen to a multicast address and the actual destination is the same.
-        // 3) If we listen to unicast traffic and the actual destination is unicast.
-        //    In that case, unicast is by definition sent to us.
-
-        if (destination.hasAddress() && ((_dest_addr.hasAddress() && destination != _dest_addr) || (!_dest_addr.hasAddress() && destination.isMulticast()))) {
-            // This is a spurious packet.
-            continue;
-        }
+size_t ts::IPInput::receiveWithMetadata(TSPacket* buffer, TSPacketMetadata* mdata, size_t max_packets)
+{
+    return receivePackets(buffer, mdata, max_packets, true);
+}
 
 
-        // Locate the TS packets inside the UDP message. Basically, we
-        // expect the message to contain only TS packets. However, we
-        // will face the following situations:
-        // - Presence of a header preceeding the first TS packet (typically
-        //   when the TS packets are encapsulated in RTP).
-        // - Presence of a truncated packet at the end of message.
+//----------------------------------------------------------------------------
+// Two-segment input method. The second segment gets the rest of the current
+// batch of messages, without waiting, instead of keeping it for the next call.
+//----------------------------------------------------------------------------
 
-        // To face the first situation, we look backward from the end of
-        // the message, looking for a 0x47 sync byte every 188 bytes, going
-        // backward.
+size_t ts::IPInput::receivev(TSPacket* buffer1, TSPacketMetadata* mdata1, size_t max_packets1,
+                             TSPacket* buffer2, TSPacketMetadata* mdata2, size_t max_packets2)
+{
+    size_t count = receivePackets(buffer1, mdata1, max_packets1, true);
+    if (count == max_packets1 && max_packets2 > 0) {
+        count += receivePackets(buffer2, mdata2, max_packets2, false);
+    }
+    return count;
+}
 
-        const uint8_t* p;
-        for (p = _inbuf + insize; p >= _inbuf + PKT_SIZE && p[-int(PKT_SIZE)] == SYNC_BYTE; p -= PKT_SIZE) {}
 
-        if (p < _inbuf + insize) {
-            // Some packets were found
-            _inbuf_next = p - _inbuf;
-            _inbuf_count = (_inbuf + insize - p) / PKT_SIZE;
-            new_packets = true;
-            break; // exit receive loop
-        }
+//----------------------------------------------------------------------------
+// Return packets from the received messages.
+//----------------------------------------------------------------------------
 
-        // If no TS packet is found using the first method, we restart from
-        // the beginning of the message, looking for a 0x47 sync byte every
-        // 188 bytes, going forward. If we find this pattern, followed by
-        // less than 188 bytes, then we have found a sequence of TS packets.
-
-        const uint8_t* max = _inbuf + insize - PKT_SIZE; // max address for a TS packet
-        _inbuf_count = 0;
-
-        for (p = _inbuf; p <= max; p++) {
-            if (*p == SYNC_BYTE) {
-                // Verify that we get a 0x47 sync byte every 188 bytes up
-                // to the end of message (not leaving more than one truncated
-                // TS packet at the end of the message).
-                const uint8_t* end;
-                for (end = p; end <= max && *end == SYNC_BYTE; end += PKT_SIZE) {}
-                if (end > max) {
-                    // Less than 188 bytes after last packet. Consider we are OK
-                    _inbuf_next = p - _inbuf;
-                    _inbuf_count = (end - p) / PKT_SIZE;
-                    new_packets = true;
-                    break; // exit packet search loop
+size_t ts::IPInput::receivePackets(TSPacket* buffer, TSPacketMetadata* mdata, size_t max_packets, bool wait)
+{
+    size_t pkt_cnt = 0;
+    bool error = false;
+
+    // Return packets from the messages of the last batch. Wait for a new
+    // batch of UDP messages only when there is nothing left to return.
+    while (pkt_cnt < max_packets) {
+
+        if (_inbuf_count > 0) {
+            // Return packets from the current message.
+            const size_t count = std::min(_inbuf_count, max_packets - pkt_cnt);
+            ::memcpy(buffer[pkt_cnt].b, _inbuf_next, count * PKT_SIZE);
+            if (mdata != 0) {
+                // Use the kernel reception time as input time stamp.
+                for (size_t i = 0; i < count; ++i) {
+                    if (_inbuf_time >= 0) {
+                        mdata[pkt_cnt + i].setInputTimeStamp(_inbuf_time);
+                    }
+                    mdata[pkt_cnt + i].setInputSource(_inbuf_source);
                 }
             }
+            pkt_cnt += count;
+            _inbuf_count -= count;
+            _inbuf_next += count * PKT_SIZE;
         }
-
-        if (new_packets) {
-            break; // exit receive loop
+        else if (_rtp && releaseRTP()) {
+            // A held RTP datagram is ready to return.
+        }
+        else if (_slot_next < _slot_count) {
+            // Analyze the next message of the batch.
+            const UDPSocket::ReceiveSlot& slot(_slots[_slot_next++]);
+            if (_rtp) {
+                analyzeRTP(_slot_source, slot);
+            }
+            else if (locatePackets(*_sources[_slot_source], slot)) {
+                _inbuf_time = slot.kernel_time;
+                _inbuf_source = uint16_t(_slot_source);
+                countPackets(_inbuf_count, slot.timestamp);
+            }
+        }
+        else if (receiveReady(error)) {
+            // A new batch of messages was received from a source, unless the reception
+            // failed. A failed source would remain ready in poll(): end of input, as with
+            // one single source, after returning the packets which were already received.
+            if (error) {
+                return pkt_cnt;
+            }
         }
+        else if (pkt_cnt > 0 || !wait) {
+            // All received messages were processed, do not wait for more.
+            break;
+        }
+        else if (tsp->aborting()) {
+            // Do not wait for more messages, RTP datagrams may have been received but held.
+            return 0;
+        }
+        else if (_sources.size() == 1) {
+            // Wait for at least one UDP message.
+            _slot_next = _slot_source = 0;
+            if (!_sources[0]->sock.receive(_slots, _slot_count, tsp, *tsp)) {
+                _slot_count = 0;
+                return 0;
+            }
+        }
+        else if (!waitSources()) {
+            // Error or abort while waiting for messages on several sources.
+            return 0;
+        }
+    }
+
+    return pkt_cnt;
+}
+
 
-        // No TS packet found in UDP message, wait for another one.
-        tsp->debug(u"no TS packet in message from %s, %s bytes", {sender.toString(), insize});
+//----------------------------------------------------------------------------
+// Receive the next batch of messages from a source with available messages.
+//----------------------------------------------------------------------------
+
+bool ts::IPInput::receiveReady(bool& error)
+{
+    error = false;
+
+    // Check all sources in turn, starting after the last one we received from,
+    // so that a high bitrate stream does not starve the others.
+    for (size_t n = 0; n < _sources.size(); ++n) {
+        const size_t index = (_poll_next + n) % _sources.size();
+        Source& src(*_sources[index]);
+        if (src.ready) {
+            // Messages are available, the receive operation does not block.
+            src.ready = false;
+            _poll_next = (index + 1) % _sources.size();
+            _slot_next = 0;
+            _slot_source = index;
+            if (!src.sock.receive(_slots, _slot_count, tsp, *tsp)) {
+                _slot_count = 0;
+                error = true;
+            }
+            return true;
+        }
     }
+    return false;
+}
+
 
-    // If new packets were received, we may need to re-evaluate the real-time input bitrate.
-    if (new_packets && _eval_time > 0) {
+//----------------------------------------------------------------------------
+// Wait for messages on any source.
+//----------------------------------------------------------------------------
 
-        const Time now(Time::CurrentUTC());
+bool ts::IPInput::waitSources()
+{
+#if defined(TS_WINDOWS)
+    typedef ::WSAPOLLFD PollFD;
+#else
+    typedef ::pollfd PollFD;
+#endif
+
+    std::vector<PollFD> fds(_sources.size());
+    for (size_t i = 0; i < _sources.size(); ++i) {
+        TS_ZERO(fds[i]);
+        fds[i].fd = _sources[i]->sock.getSocket();
+        fds[i].events = POLLIN;
+    }
 
-        // Detect start time
-        if (_packets == 0) {
-            _start = _start_0 = _start_1 = now;
-            if (_display_time > 0) {
-                _next_display = now + _display_time;
+    // Poll with a timeout to check abort requests.
+    for (;;) {
+#if defined(TS_WINDOWS)
+        const int count = ::WSAPoll(&fds[0], ULONG(fds.size()), SOURCES_POLL_TIMEOUT);
+#else
+        const int count = ::poll(&fds[0], ::nfds_t(fds.size()), SOURCES_POLL_TIMEOUT);
+#endif
+        const SocketErrorCode err = count < 0 ? LastSocketErrorCode() : SYS_SUCCESS;
+        if (tsp->aborting()) {
+            // User-interrupt, end of processing but no error message
+            return false;
+        }
+        else if (count > 0) {
+            for (size_t i = 0; i < _sources.size(); ++i) {
+                _sources[i]->ready = fds[i].revents != 0;
             }
+            return true;
+        }
+#if !defined(TS_WINDOWS)
+        else if (count < 0 && err == EINTR) {
+            // Got a signal, not a user interrupt, will ignore it
+        }
+#endif
+        else if (count < 0) {
+            tsp->error(u"error waiting for UDP messages: %s", {SocketErrorCodeMessage(err)});
+            return false;
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Check if a message is sent to the expected destination of a source.
+//----------------------------------------------------------------------------
+
+bool ts::IPInput::checkDestination(const Source& src, const UDPSocket::ReceiveSlot& slot) const
+{
+    // Check the destination address to exclude packets from other streams.
+    // When several multicast streams use the same destination port and several
+    // applications on the same system listen to these distinct streams,
+    // the multicast MAC address management is such that any socket which
+    // is bound to the common port will receive the traffic for all streams.
+    // This is why we need to check the destination address and exclude
+    // packets which are not from the intended stream.
+    //
+    // We accept a packet in any of:
+    // 1) Actual packet destination is unknown. Probably, the system cannot
+    //    report the destination address.
+    // 2) We listen to a multicast address and the actual destination is the same.
+    // 3) If we listen to unicast traffic and the actual destination is unicast.
+    //    In that case, unicast is by definition sent to us.
+
+    const SocketAddress& destination(slot.destination);
+    return !destination.hasAddress() || (src.dest_addr.hasAddress() ? destination == src.dest_addr : !destination.isMulticast());
+}
+
+
+//----------------------------------------------------------------------------
+// Locate the TS packets in a received message, return false if there is none.
+//----------------------------------------------------------------------------
+
+bool ts::IPInput::locatePackets(const Source& src, const UDPSocket::ReceiveSlot& slot)
+{
+    const uint8_t* const data = reinterpret_cast<const uint8_t*>(slot.data);
+    const size_t insize = slot.ret_size;
+
+    _inbuf_count = 0;
+    _inbuf_next = data;
+
+    if (!checkDestination(src, slot)) {
+        // This is a spurious packet.
+        return false;
+    }
+
+    // Locate the TS packets inside the UDP message.
+    size_t start = 0;
+    if (TSPacket::Locate(data, insize, start, _inbuf_count)) {
+        _inbuf_next = data + start;
+        return true;
+    }
+
+    // No TS packet found in UDP message.
+    tsp->debug(u"no TS packet in message from %s, %s bytes", {slot.sender.toString(), insize});
+    return false;
+}
+
+
+//----------------------------------------------------------------------------
+// Analyze a received RTP message, return true if TS packets are ready to return.
+//----------------------------------------------------------------------------
+
+bool ts::IPInput::analyzeRTP(size_t index, const UDPSocket::ReceiveSlot& slot)
+{
+    Source& src(*_sources[index]);
+    const uint8_t* const data = reinterpret_cast<const uint8_t*>(slot.data);
+    size_t size = slot.ret_size;
+
+    _inbuf_count = 0;
+    _inbuf_next = data;
+
+    if (!checkDestination(src, slot)) {
+        // This is a spurious packet.
+        return false;
+    }
+
+    // Analyze the RTP header: version 2, followed by optional CSRC list and header extension.
+    if (size < RTP_HEADER_SIZE || (data[0] >> 6) != 2) {
+        tsp->debug(u"invalid RTP header in message from %s, %s bytes", {slot.sender.toString(), size});
+        return false;
+    }
+    size_t header_size = RTP_HEADER_SIZE + 4 * (data[0] & 0x0F);
+    if ((data[0] & 0x10) != 0 && size >= header_size + 4) {
+        header_size += 4 + 4 * size_t(GetUInt16(data + header_size + 2));
+    }
+    if ((data[0] & 0x20) != 0 && size > header_size) {
+        // Remove padding, the last byte is the padding size.
+        size -= std::min<size_t>(data[size - 1], size - header_size);
+    }
+    if (size < header_size + PKT_SIZE || data[header_size] != SYNC_BYTE) {
+        tsp->debug(u"no TS packet in RTP message from %s, %s bytes", {slot.sender.toString(), slot.ret_size});
+        return false;
+    }
+
+    const uint16_t seq = GetUInt16(data + 2);
+    const uint32_t stamp = GetUInt32(data + 4);
+    const size_t count = (size - header_size) / PKT_SIZE;
+
+    // Compute the extended sequence number, relative to the next expected one.
+    // The initial value is offset by 2^16 to allow late datagrams at start.
+    if (!src.rtp_started) {
+        src.rtp_started = true;
+        src.rtp_next_seq = src.rtp_max_seq = 0x10000 + seq;
+    }
+    else if (src.rtp_prev_kernel >= 0 && slot.kernel_time >= 0) {
+        // Update the interarrival jitter, as defined in RFC 3550.
+        const int64_t transit = ((slot.kernel_time - src.rtp_prev_kernel) * RTP_CLOCK_RATE) / NanoSecPerSec - int32_t(stamp - src.rtp_prev_stamp);
+        src.rtp_jitter += (transit < 0 ? -transit : transit) - (src.rtp_jitter + 8) / 16;
+    }
+    src.rtp_prev_stamp = stamp;
+    src.rtp_prev_kernel = slot.kernel_time;
+    src.rtp_last_arrival = slot.timestamp;
+    src.rtp_datagrams++;
+
+    const int diff = int16_t(uint16_t(seq - uint16_t(src.rtp_next_seq)));
+    uint64_t ext_seq = src.rtp_next_seq + diff;
+    if (diff < -MAX_REORDER_DATAGRAMS) {
+        // Too far in the past, this is a restart of the stream, forget the held datagrams.
+        tsp->verbose(u"RTP sequence discontinuity, from %d to %d", {uint16_t(src.rtp_next_seq), seq});
+        src.rtp_held.clear();
+        ext_seq = src.rtp_next_seq = src.rtp_max_seq = src.rtp_next_seq + 0x10000 + diff;
+    }
+
+    if (ext_seq < src.rtp_next_seq || src.rtp_held.find(ext_seq) != src.rtp_held.end()) {
+        // Already returned, already held or given up before.
+        tsp->debug(u"dropping duplicate or late RTP datagram, sequence %d", {seq});
+        src.rtp_duplicates++;
+        return false;
+    }
+    if (ext_seq < src.rtp_max_seq) {
+        src.rtp_reordered++;
+    }
+    else {
+        src.rtp_max_seq = ext_seq;
+    }
+
+    if (src.rtp_held.empty() && (ext_seq == src.rtp_next_seq || _reorder_delay <= 0)) {
+        // In sequence or no reordering, return the TS packets directly from the receive buffer.
+        if (ext_seq > src.rtp_next_seq) {
+            tsp->debug(u"%d RTP datagrams missing before sequence %d", {ext_seq - src.rtp_next_seq, seq});
+            src.rtp_lost += ext_seq - src.rtp_next_seq;
         }
+        src.rtp_next_seq = ext_seq + 1;
+        _inbuf_next = data + header_size;
+        _inbuf_count = count;
+        _inbuf_time = slot.kernel_time;
+        _inbuf_source = uint16_t(index);
+        countPackets(count, slot.timestamp);
+        return true;
+    }
 
-        // Count packets
-        _packets += _inbuf_count;
-        _packets_0 += _inbuf_count;
-        _packets_1 += _inbuf_count;
+    // Hold a copy of the TS packets until the missing datagrams are received or given up.
+    RTPDatagram& dg(src.rtp_held[ext_seq]);
+    dg.data.copy(data + header_size, count * PKT_SIZE);
+    dg.timestamp = slot.timestamp;
+    dg.kernel_time = slot.kernel_time;
+    return releaseRTP(index);
+}
 
-        // Detect new evaluation period
-        if (now >= _start_1 + _eval_time) {
-            _start_0 = _start_1;
-            _packets_0 = _packets_1;
-            _start_1 = now;
-            _packets_1 = 0;
 
+//----------------------------------------------------------------------------
+// Return the next held RTP datagram of any source.
+//----------------------------------------------------------------------------
+
+bool ts::IPInput::releaseRTP()
+{
+    for (size_t index = 0; index < _sources.size(); ++index) {
+        if (releaseRTP(index)) {
+            return true;
         }
+    }
+    return false;
+}
+
+
+//----------------------------------------------------------------------------
+// Return the next held RTP datagram of a source if it is in sequence or if
+// the missing ones are given up.
+//----------------------------------------------------------------------------
 
-        // Check if evaluated bitrate should be displayed
-        if (_display_time > 0 && now >= _next_display) {
-            _next_display += _display_time;
-            const MilliSecond ms_current = Time::CurrentUTC() - _start_0;
-            const MilliSecond ms_total = Time::CurrentUTC() - _start;
-            const BitRate br_current = ms_current == 0 ? 0 : BitRate((_packets_0 * PKT_SIZE * 8 * MilliSecPerSec) / ms_current);
-            const BitRate br_average = ms_total == 0 ? 0 : BitRate((_packets * PKT_SIZE * 8 * MilliSecPerSec) / ms_total);
-            tsp->info(u"IP input bitrate: %s, average: %s", {
-                br_current == 0 ? u"undefined" : UString::Decimal(br_current) + u" b/s",
-                br_average == 0 ? u"undefined" : UString::Decimal(br_average) + u" b/s"});
+bool ts::IPInput::releaseRTP(size_t index)
+{
+    Source& src(*_sources[index]);
+    if (src.rtp_held.empty()) {
+        return false;
+    }
+
+    const RTPDatagramMap::iterator it(src.rtp_held.begin());
+    if (it->first > src.rtp_next_seq) {
+        // Some datagrams are missing before the first held one. Wait for them
+        // while the reorder delay is not expired and the buffer is not full.
+        if (src.rtp_held.size() <= MAX_REORDER_DATAGRAMS && src.rtp_last_arrival - it->second.timestamp < _reorder_delay) {
+            return false;
         }
+        tsp->debug(u"%d RTP datagrams missing before sequence %d", {it->first - src.rtp_next_seq, uint16_t(it->first)});
+        src.rtp_lost += it->first - src.rtp_next_seq;
     }
 
-    // Return packets from the input buffer
-    size_t pkt_cnt = std::min(_inbuf_count, max_packets);
-    ::memcpy(buffer, _inbuf + _inbuf_next, pkt_cnt * PKT_SIZE);
-    _inbuf_count -= pkt_cnt;
-    _inbuf_next += pkt_cnt * PKT_SIZE;
+    // Return the TS packets of this datagram.
+    src.rtp_next_seq = it->first + 1;
+    _rtp_current.swap(it->second.data);
+    _inbuf_next = _rtp_current.data();
+    _inbuf_count = _rtp_current.size() / PKT_SIZE;
+    _inbuf_time = it->second.kernel_time;
+    _inbuf_source = uint16_t(index);
+    countPackets(_inbuf_count, it->second.timestamp);
+    src.rtp_held.erase(it);
+    return true;
+}
 
-    return pkt_cnt;
+
+//----------------------------------------------------------------------------
+// Count newly received packets for the evaluation of the input bitrate.
+//----------------------------------------------------------------------------
+
+void ts::IPInput::countPackets(size_t count, const Time& now)
+{
+    // We may need to re-evaluate the real-time input bitrate.
+    if (_eval_time <= 0) {
+        return;
+    }
+
+    // Detect start time
+    if (_packets == 0) {
+        _start = _start_0 = _start_1 = now;
+        if (_display_time > 0) {
+            _next_display = now + _display_time;
+        }
+    }
+
+    // Count packets
+    _packets += count;
+    _packets_0 += count;
+    _packets_1 += count;
+
+    // Detect new evaluation period
+    if (now >= _start_1 + _eval_time) {
+        _start_0 = _start_1;
+        _packets_0 = _packets_1;
+        _start_1 = now;
+        _packets_1 = 0;
+    }
+
+    // Check if evaluated bitrate should be displayed
+    if (_display_time > 0 && now >= _next_display) {
+        _next_display += _display_time;
+        const MilliSecond ms_current = Time::CurrentUTC() - _start_0;
+        const MilliSecond ms_total = Time::CurrentUTC() - _start;
+        const BitRate br_current = ms_current == 0 ? 0 : BitRate((_packets_0 * PKT_SIZE * 8 * MilliSecPerSec) / ms_current);
+        const BitRate br_average = ms_total == 0 ? 0 : BitRate((_packets * PKT_SIZE * 8 * MilliSecPerSec) / ms_total);
+        tsp->info(u"IP input bitrate: %s, average: %s", {
+            br_current == 0 ? u"undefined" : UString::Decimal(br_current) + u" b/s",
+            br_average == 0 ? u"undefined" : UString::Decimal(br_average) + u" b/s"});
+    }
 }
 
 
@@ -501,6 +1120,21 @@ bool ts::IPOutput::start()
     UString loc_name(value(u"local-address"));
     int ttl = intValue(u"ttl", 0);
     _pkt_burst = intValue(u"packet-burst", DEF_PACKET_BURST);
+    const bool gso = present(u"segmentation-offload");
+    _pace_bitrate = intValue<BitRate>(u"bitrate", 0);
+    _relay_delay = present(u"relay-delay") ? NanoSecPerMilliSec * intValue<NanoSecond>(u"relay-delay") : -1;
+    _pace = present(u"pace") || _pace_bitrate > 0 || _relay_delay >= 0;
+    _spin_time = NanoSecPerMicroSec * intValue<NanoSecond>(u"spin-time-us", DEF_SPIN_TIME_US);
+
+    // Reset pacing state. Request a precise timer resolution (only necessary on Windows).
+    _cur_bitrate = _pace_bitrate;
+    _pcr_pid = PID_NULL;
+    _last_pcr = INVALID_PCR;
+    _pcr_packets = _base_packets = 0;
+    _slack_set = false;
+    if (_pace) {
+        Monotonic::SetPrecision(NanoSecPerMilliSec);
+    }
 
     // Create UDP socket
     bool ok = _sock.open(*tsp);
@@ -508,7 +1142,8 @@ bool ts::IPOutput::start()
     if (ok) {
         ok = _sock.setDefaultDestination(dest_name, *tsp) &&
             (loc_name.empty() || _sock.setOutgoingMulticast(loc_name, *tsp)) &&
-            (ttl <= 0 || _sock.setTTL(ttl, _sock.setTTL(ttl, *tsp)));
+            (ttl <= 0 || _sock.setTTL(ttl, _sock.setTTL(ttl, *tsp))) &&
+            (!gso || _sock.setSegmentationOffload(true, *tsp));
         if (!ok) {
             _sock.close();
         }
@@ -544,17 +1179,161 @@ ts::IPOutput::~IPOutput()
 //----------------------------------------------------------------------------
 
 bool ts::IPOutput::send(const TSPacket* pkt, size_t packet_count)
+{
+    return sendWithMetadata(pkt, 0, packet_count);
+}
+
+bool ts::IPOutput::sendv(const TSPacketRunVector& runs)
+{
+    // With one single run, the packets are already contiguous.
+    if (runs.size() == 1) {
+        return sendWithMetadata(runs[0].packets, runs[0].metadata, runs[0].count);
+    }
+
+    // Gather the packets of all runs so that all datagrams, except the last one, contain
+    // exactly _pkt_burst packets. Otherwise, each run would end with a short datagram.
+    // Copying a few packets is cheaper than sending additional datagrams.
+    bool has_mdata = true;
+    size_t total = 0;
+    for (size_t i = 0; i < runs.size(); ++i) {
+        total += runs[i].count;
+        has_mdata = has_mdata && runs[i].metadata != 0;
+    }
+    _gather_pkts.resize(total);
+    _gather_mdata.resize(has_mdata ? total : 0);
+
+    size_t index = 0;
+    for (size_t i = 0; i < runs.size(); ++i) {
+        std::copy(runs[i].packets, runs[i].packets + runs[i].count, _gather_pkts.begin() + index);
+        if (has_mdata) {
+            std::copy(runs[i].metadata, runs[i].metadata + runs[i].count, _gather_mdata.begin() + index);
+        }
+        index += runs[i].count;
+    }
+
+    return total == 0 || sendWithMetadata(_gather_pkts.data(), has_mdata ? _gather_mdata.data() : 0, total);
+}
+
+bool ts::IPOutput::sendWithMetadata(const TSPacket* pkt, const TSPacketMetadata* mdata, size_t packet_count)
 {
     // Send TS packets in UDP messages, grouped according to burst size.
+    // All messages are sent in as few system calls as possible.
 
-    while (packet_count > 0) {
-        size_t count = std::min(packet_count, _pkt_burst);
-        if (!_sock.send(pkt, count * PKT_SIZE, *tsp)) {
-            return false;
+    if (!_pace) {
+        return _sock.sendSegments(pkt, packet_count * PKT_SIZE, _pkt_burst * PKT_SIZE, *tsp);
+    }
+
+    // With a relay delay, the transmit time of a datagram is computed from the
+    // input time stamp of its first packet. Get the origin of the time stamps.
+    const bool relay = _relay_delay >= 0 && mdata != 0;
+    Monotonic origin;
+    if (relay) {
+        origin.getSystemTime();
+        origin -= tsp->currentTimeStamp();
+    }
+
+    // With pacing, the consecutive datagrams which are already due are sent together.
+    // Then, wait for the transmit time of the next datagram.
+    size_t ready = 0;
+    for (size_t index = 0; index < packet_count; index += _pkt_burst) {
+
+        // The transmit time of a datagram is the transmit time of its first packet.
+        const size_t count = std::min(_pkt_burst, packet_count - index);
+        _now.getSystemTime();
+        for (size_t i = 0; i < count; ++i) {
+            pacePacket(pkt[index + i]);
+            if (i == 0) {
+                _send_time = _due;
+            }
+        }
+        if (relay && mdata[index].hasInputTimeStamp()) {
+            _send_time = origin;
+            _send_time += mdata[index].getInputTimeStamp() + _relay_delay;
         }
-        pkt += count;
-        packet_count -= count;
+
+        if (_send_time > _now) {
+            // Send the previous datagrams, then wait for this one.
+            if (ready > 0 && !_sock.sendSegments(pkt + index - ready, ready * PKT_SIZE, _pkt_burst * PKT_SIZE, *tsp)) {
+                return false;
+            }
+            ready = 0;
+            waitSendTime();
+        }
+        ready += count;
     }
 
-    return true;
+    return ready == 0 || _sock.sendSegments(pkt + packet_count - ready, ready * PKT_SIZE, _pkt_burst * PKT_SIZE, *tsp);
+}
+
+
+//----------------------------------------------------------------------------
+// Compute the transmit time of the next packet in _due.
+//----------------------------------------------------------------------------
+
+void ts::IPOutput::pacePacket(const TSPacket& pkt)
+{
+    // Extrapolate the transmit time from the base packet, at the current bitrate.
+    // When the bitrate is unknown or when we are too late, restart from now.
+    _due = _base_time;
+    if (_cur_bitrate > 0) {
+        _due += NanoSecond((_base_packets * PKT_SIZE * 8 * NanoSecPerSec) / _cur_bitrate);
+    }
+    if (_cur_bitrate == 0 || _now - _due > PACE_MAX_LATE) {
+        _due = _base_time = _now;
+        _base_packets = 0;
+    }
+
+    if (_pace_bitrate == 0 && pkt.hasPCR() && (_pcr_pid == PID_NULL || pkt.getPID() == _pcr_pid)) {
+        // A reference PCR gives the transmit time of this packet and the bitrate since the previous one.
+        const uint64_t pcr = pkt.getPCR();
+        if (_pcr_pid == PID_NULL) {
+            _pcr_pid = pkt.getPID();
+            tsp->verbose(u"pacing datagrams using PCR's from PID 0x%X (%d)", {_pcr_pid, _pcr_pid});
+        }
+        else if (_last_pcr != INVALID_PCR && _pcr_packets > 0 && !pkt.getDiscontinuityIndicator()) {
+            const uint64_t delta = pcr >= _last_pcr ? pcr - _last_pcr : pcr + PCR_SCALE - _last_pcr;
+            if (delta > 0 && delta < SYSTEM_CLOCK_FREQ) {
+                _cur_bitrate = BitRate((_pcr_packets * PKT_SIZE * 8 * SYSTEM_CLOCK_FREQ) / delta);
+                _sleep_time = _pcr_time;
+                _sleep_time += NanoSecond((delta * NanoSecPerSec) / SYSTEM_CLOCK_FREQ);
+                // Keep the extrapolated time when the PCR's drift too much from it.
+                if (_sleep_time - _due < PACE_MAX_LATE && _due - _sleep_time < PACE_MAX_LATE) {
+                    _due = _sleep_time;
+                }
+            }
+        }
+        _last_pcr = pcr;
+        _pcr_packets = 0;
+        _pcr_time = _base_time = _due;
+        _base_packets = 0;
+    }
+    else {
+        // Without reference PCR PID, use the specified bitrate or the tsp bitrate.
+        const BitRate bitrate = _pcr_pid != PID_NULL ? _cur_bitrate : (_pace_bitrate != 0 ? _pace_bitrate : tsp->bitrate());
+        if (bitrate != _cur_bitrate || _base_packets >= PACE_REBASE_PACKETS) {
+            _cur_bitrate = bitrate;
+            _base_time = _due;
+            _base_packets = 0;
+        }
+    }
+
+    _base_packets++;
+    _pcr_packets++;
+}
+
+
+//----------------------------------------------------------------------------
+// Wait until the transmit time in _send_time.
+//----------------------------------------------------------------------------
+
+void ts::IPOutput::waitSendTime()
+{
+    // The timer slack applies to the calling thread, the output thread of tsp.
+    if (!_slack_set) {
+        _slack_set = true;
+        Monotonic::SetMinimumTimerSlack();
+    }
+
+    // Sleep until shortly before the transmit time, then spin on the clock.
+    _now.waitUntil(_send_time, _spin_time);
 }
@@ -35,6 +35,8 @@
 #include "tsPlugin.h"
 #include "tsPluginRepository.h"
 #include "tsTSFileInput.h"
+#include "tsInjectionScheduler.h"
+#include "tsPCRAnalyzer.h"
 #include "tsMemoryUtils.h"
 TSDUCK_SOURCE;
 
@@ -54,18 +56,60 @@ namespace ts {
         virtual Status processPacket(TSPacket&, bool&, bool&) override;
 
     private:
-        TSFileInput   _file;               // Input file
-        bool          _terminate;          // Terminate processing after last new packet.
-        bool          _update_cc;          // Ignore continuity counters.
-        bool          _check_pid_conflict; // Check new PIDs in TS
-        PIDSet        _ts_pids;            // PID's on original TS
-        uint8_t       _cc[PID_MAX];        // Continuity counters in new PID's
-        bool          _force_pid;          // PID value to force
-        PID           _force_pid_value;    // PID value to force
-        BitRate       _bitrate;            // Target bitrate for inserted packets
-        PacketCounter _inter_pkt;          // # TS packets between 2 new PID packets
-        PacketCounter _pid_next_pkt;       // Next time to insert a packet
-        PacketCounter _packet_count;       // TS packet counter
+        // Number of packets which are read at a time in an input file.
+        static const size_t READ_PACKETS = 512;
+
+        // Description of one input file.
+        struct InputContext
+        {
+            TSFileInput   file;            // Input file
+            bool          completed;       // All packets from this file are inserted
+            bool          force_pid;       // PID value to force
+            PID           force_pid_value; // PID value to force
+            PID           remap[PID_MAX];  // PID remapping of inserted packets
+            BitRate       bitrate;         // Target bitrate for inserted packets
+            PacketCounter inter_pkt;       // # TS packets between 2 new PID packets
+            PacketCounter next_pkt;        // Next time to insert a packet
+            TSPacketVector buffer;         // Read-ahead buffer, READ_PACKETS packets
+            size_t        buf_next;        // Index of next packet in buffer
+            size_t        buf_count;       // Number of read packets in buffer
+            bool          eof;             // End of file reached
+            InjectionScheduler clock;      // Time of packets in the file, with --timestamps
+            bool          head_ready;      // The time of the next packet is computed
+            bool          origin_set;      // The time origins are set
+            uint64_t      head_time;       // Time of the next packet in the file
+            uint64_t      file_origin;     // Time of the first packet in the file
+            uint64_t      main_origin;     // Time of the main stream when the first packet was inserted
+
+            // Constructor.
+            InputContext();
+        };
+        typedef SafePtr<InputContext, NullMutex> InputContextPtr;
+        typedef std::vector<InputContextPtr> InputContextVector;
+
+        InputContextVector _inputs;             // Input files
+        bool               _terminate;          // Terminate processing after last new packet.
+        bool               _update_cc;          // Ignore continuity counters.
+        bool               _check_pid_conflict; // Check new PIDs in TS
+        bool               _pcr_based;          // Schedule inserted packets from PCR's
+        bool               _timestamps;         // Schedule inserted packets from their own timestamps
+        size_t             _completed_count;    // Number of completed input files
+        PIDSet             _ts_pids;            // PID's on original TS
+        uint8_t            _cc[PID_MAX];        // Continuity counters in new PID's
+        PacketCounter      _packet_count;       // TS packet counter
+        InjectionScheduler _scheduler;          // Time-based scheduler with --pcr-based, clock with --timestamps
+
+        // Get the index of the value of an option for an input file: one per file, the last one applies to remaining files.
+        size_t optionIndex(const UChar* name, size_t file_index) const;
+
+        // Decode --remap options.
+        bool getRemap();
+
+        // Get the next packet of an input file, without removing it. Return zero at end of file.
+        TSPacket* nextPacket(InputContext&);
+
+        // Select the input file for the current stuffing packet, NPOS if none.
+        size_t selectInput();
 
         // Inaccessible operations
         MuxPlugin() = delete;
@@ -83,35 +127,41 @@ TSPLUGIN_DECLARE_PROCESSOR(mux, ts::MuxPlugin)
 //----------------------------------------------------------------------------
 
 ts::MuxPlugin::MuxPlugin(TSP* tsp_) :
-    ProcessorPlugin(tsp_, u"Insert TS packets in a TS.", u"[options] input-file"),
-    _file(),
+    ProcessorPlugin(tsp_, u"Insert TS packets in a TS.", u"[options] input-file ..."),
+    _inputs(),
     _terminate(false),
     _update_cc(false),
     _check_pid_conflict(false),
+    _pcr_based(false),
+    _timestamps(false),
+    _completed_count(0),
     _ts_pids(),
     _cc(),
-    _force_pid(false),
-    _force_pid_value(PID_NULL),
-    _bitrate(0),
-    _inter_pkt(0),
-    _pid_next_pkt(0),
-    _packet_count(0)
+    _packet_count(0),
+    _scheduler()
 {
-    option(u"",                       0,  STRING, 1, 1);
-    option(u"bitrate",               'b', UINT32);
+    option(u"",                       0,  STRING, 1, UNLIMITED_COUNT);
+    option(u"bitrate",               'b', UINT32, 0, UNLIMITED_COUNT);
     option(u"byte-offset",            0,  UNSIGNED);
-    option(u"inter-packet",          'i', UINT32);
+    option(u"inter-packet",          'i', UINT32, 0, UNLIMITED_COUNT);
     option(u"joint-termination",     'j');
+    option(u"max-burst",              0,  POSITIVE);
     option(u"no-continuity-update",   0);
     option(u"no-pid-conflict-check",  0);
     option(u"packet-offset",          0,  UNSIGNED);
-    option(u"pid",                   'p', PIDVAL);
+    option(u"pcr-based",              0);
+    option(u"pcr-pid",                0,  PIDVAL);
+    option(u"pid",                   'p', PIDVAL, 0, UNLIMITED_COUNT);
+    option(u"remap",                  0,  STRING, 0, UNLIMITED_COUNT);
     option(u"repeat",                'r', POSITIVE);
     option(u"terminate",             't');
+    option(u"timestamps",             0);
 
-    setHelp(u"Input file:\n"
+    setHelp(u"Input files:\n"
             u"\n"
-            u"  Binary file containing 188-byte transport packets.\n"
+            u"  Binary files containing 188-byte transport packets. When several files\n"
+            u"  are specified, they are inserted simultaneously, sharing the stuffing\n"
+            u"  packets of the transport stream.\n"
             u"\n"
             u"Options:\n"
             u"\n"
@@ -119,7 +169,9 @@ ts::MuxPlugin::MuxPlugin(TSP* tsp_) :
             u"  --bitrate value\n"
             u"      Specifies the bitrate for the inserted packets, in bits/second.\n"
             u"      By default, all stuffing packets are replaced which means that\n"
-            u"      the bitrate is neither constant nor guaranteed.\n"
+            u"      the bitrate is neither constant nor guaranteed. With several input\n"
+            u"      files, several --bitrate options can be specified, one per input file.\n"
+            u"      The last one applies to all remaining files.\n"
             u"\n"
             u"  --byte-offset value\n"
             u"      Start reading the file at the specified byte offset (default: 0).\n"
@@ -133,13 +185,20 @@ ts::MuxPlugin::MuxPlugin(TSP* tsp_) :
             u"      Specifies the packet interval for the inserted packets, that is to say\n"
             u"      the number of TS packets in the transport between two new packets.\n"
             u"      Use instead of --bitrate if the global bitrate of the TS cannot be\n"
-            u"      determined.\n"
+            u"      determined. With several input files, several --inter-packet options\n"
+            u"      can be specified, one per input file. The last one applies to all\n"
+            u"      remaining files.\n"
             u"\n"
             u"  -j\n"
             u"  --joint-termination\n"
             u"      Perform a \"joint termination\" when file insersion is complete.\n"
             u"      See \"tsp --help\" for more details on \"joint termination\".\n"
             u"\n"
+            u"  --max-burst value\n"
+            u"      With --pcr-based, specifies the maximum number of consecutive packets\n"
+            u"      which can be inserted from the same file, after a lack of stuffing in\n"
+            u"      the transport stream. The default is 2.\n"
+            u"\n"
             u"  --no-continuity-update\n"
             u"      Do not update continuity counters in the inserted packets. By default,\n"
             u"      the continuity counters are updated in each inserted PID to preserve the\n"
@@ -154,9 +213,29 @@ ts::MuxPlugin::MuxPlugin(TSP* tsp_) :
             u"      Start reading the file at the specified TS packet (default: 0).\n"
             u"      This option is allowed only if the input file is a regular file.\n"
             u"\n"
+            u"  --pcr-based\n"
+            u"      With --bitrate, schedule the inserted packets according to the time of\n"
+            u"      the transport stream, as computed from its PCR's. By default, the\n"
+            u"      inserted packets are spaced by a fixed number of packets, computed from\n"
+            u"      the transport stream bitrate at start. This is accurate only when the\n"
+            u"      transport stream has a constant bitrate.\n"
+            u"\n"
+            u"  --pcr-pid value\n"
+            u"      With --pcr-based, specifies the reference PID for PCR's. By default,\n"
+            u"      use the first PID containing PCR's.\n"
+            u"\n"
             u"  -p value\n"
             u"  --pid value\n"
-            u"      Force the PID value of all inserted packets.\n"
+            u"      Force the PID value of all inserted packets. With several input files,\n"
+            u"      several --pid options can be specified, one per input file. The last\n"
+            u"      one applies to all remaining files.\n"
+            u"\n"
+            u"  --remap [index:]pid=newpid\n"
+            u"      Change the PID of the inserted packets with the specified PID. Several\n"
+            u"      --remap options may be specified. With several input files, the optional\n"
+            u"      index, starting at 1, specifies the input file to which the remapping\n"
+            u"      applies. Without index, the remapping applies to all input files.\n"
+            u"      Example: --remap 2:0x100=0x200 changes PID 0x100 of the second file.\n"
             u"\n"
             u"  -r count\n"
             u"  --repeat count\n"
@@ -170,11 +249,58 @@ ts::MuxPlugin::MuxPlugin(TSP* tsp_) :
             u"      when packet insertion is complete, the transmission continues and the\n"
             u"      stuffing is no longer modified.\n"
             u"\n"
+            u"  --timestamps\n"
+            u"      Insert the packets of each input file according to its own time line,\n"
+            u"      as computed from its PCR's or, when there is no PCR, from the DTS or\n"
+            u"      PTS of its first PES PID. The time of the transport stream is computed\n"
+            u"      from its PCR's. Each file starts when its first packet is inserted.\n"
+            u"      Mutually exclusive with --bitrate and --inter-packet.\n"
+            u"\n"
             u"  --version\n"
             u"      Display the version number.\n");
 }
 
 
+//----------------------------------------------------------------------------
+// Input file context.
+//----------------------------------------------------------------------------
+
+ts::MuxPlugin::InputContext::InputContext() :
+    file(),
+    completed(false),
+    force_pid(false),
+    force_pid_value(PID_NULL),
+    bitrate(0),
+    inter_pkt(0),
+    next_pkt(0),
+    buffer(READ_PACKETS),
+    buf_next(0),
+    buf_count(0),
+    eof(false),
+    clock(),
+    head_ready(false),
+    origin_set(false),
+    head_time(0),
+    file_origin(0),
+    main_origin(0)
+{
+    for (PID pid = 0; pid < PID_MAX; ++pid) {
+        remap[pid] = pid;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Get the index of the value of an option for an input file.
+//----------------------------------------------------------------------------
+
+size_t ts::MuxPlugin::optionIndex(const UChar* name, size_t file_index) const
+{
+    const size_t count = this->count(name);
+    return count == 0 || file_index < count ? file_index : count - 1;
+}
+
+
 //----------------------------------------------------------------------------
 // Start method
 //----------------------------------------------------------------------------
@@ -185,29 +311,89 @@ bool ts::MuxPlugin::start()
     _terminate = present(u"terminate");
     _update_cc = !present(u"no-continuity-update");
     _check_pid_conflict = !present(u"no-pid-conflict-check");
-    _force_pid = present(u"pid");
-    _force_pid_value = intValue<PID>(u"pid");
-    _bitrate = intValue<BitRate>(u"bitrate", 0);
-    _inter_pkt = intValue<PacketCounter>(u"inter-packet", 0);
+    _pcr_based = present(u"pcr-based");
+    _timestamps = present(u"timestamps");
+    _completed_count = 0;
     _packet_count = 0;
-    _pid_next_pkt = 0;
     _ts_pids.reset();
     TS_ZERO (_cc);
+    _scheduler.reset();
+    _scheduler.setPCRPID(intValue<PID>(u"pcr-pid", PID_NULL));
+    _inputs.clear();
 
-    if (_bitrate != 0 && _inter_pkt != 0) {
+    if (present(u"bitrate") && present(u"inter-packet")) {
         tsp->error(u"--bitrate and --inter-packet are mutually exclusive");
         return false;
     }
 
+    if (_pcr_based && !present(u"bitrate")) {
+        tsp->error(u"--pcr-based requires --bitrate");
+        return false;
+    }
+
+    if (_timestamps && (present(u"bitrate") || present(u"inter-packet"))) {
+        tsp->error(u"--timestamps is incompatible with --bitrate and --inter-packet");
+        return false;
+    }
+
     if (_terminate && tsp->useJointTermination()) {
         tsp->error(u"--terminate and --joint-termination are mutually exclusive");
         return false;
     }
 
-    return _file.open (value(u""),
-                       intValue<size_t>(u"repeat", 0),
-                       intValue<uint64_t>(u"byte-offset", intValue<uint64_t>(u"packet-offset", 0) * PKT_SIZE),
-                       *tsp);
+    const size_t repeat = intValue<size_t>(u"repeat", 0);
+    const uint64_t offset = intValue<uint64_t>(u"byte-offset", intValue<uint64_t>(u"packet-offset", 0) * PKT_SIZE);
+    const size_t max_burst = intValue<size_t>(u"max-burst", InjectionScheduler::DEFAULT_MAX_BURST);
+
+    for (size_t i = 0; i < count(u""); ++i) {
+        InputContextPtr ctx(new InputContext);
+        CheckNonNull(ctx.pointer());
+        ctx->force_pid = present(u"pid");
+        ctx->force_pid_value = intValue<PID>(u"pid", PID_NULL, optionIndex(u"pid", i));
+        ctx->bitrate = intValue<BitRate>(u"bitrate", 0, optionIndex(u"bitrate", i));
+        ctx->inter_pkt = intValue<PacketCounter>(u"inter-packet", 0, optionIndex(u"inter-packet", i));
+        if (!ctx->file.open(value(u"", u"", i), repeat, offset, *tsp)) {
+            stop();
+            return false;
+        }
+        if (_pcr_based) {
+            _scheduler.addComponent(ctx->bitrate, max_burst);
+        }
+        _inputs.push_back(ctx);
+    }
+    return getRemap();
+}
+
+
+//----------------------------------------------------------------------------
+// Decode --remap options.
+//----------------------------------------------------------------------------
+
+bool ts::MuxPlugin::getRemap()
+{
+    for (size_t n = 0; n < count(u"remap"); ++n) {
+        const UString opt(value(u"remap", u"", n));
+        const size_t colon = opt.find(u':');
+        const size_t equal = opt.find(u'=', colon == UString::NPOS ? 0 : colon);
+        size_t index = 0;
+        PID from = PID_NULL;
+        PID to = PID_NULL;
+        if (equal == UString::NPOS ||
+            (colon != UString::NPOS && (!opt.substr(0, colon).toInteger(index) || index < 1 || index > _inputs.size())) ||
+            !opt.substr(colon == UString::NPOS ? 0 : colon + 1, equal - (colon == UString::NPOS ? 0 : colon + 1)).toInteger(from) ||
+            !opt.substr(equal + 1).toInteger(to) ||
+            from >= PID_MAX || to >= PID_MAX)
+        {
+            tsp->error(u"invalid remapping specification \"%s\"", {opt});
+            return false;
+        }
+        for (size_t i = 0; i < _inputs.size(); ++i) {
+            if (colon == UString::NPOS || i + 1 == index) {
+                _inputs[i]->remap[from] = to;
+            }
+        }
+    }
+    return true;
 }
 
 
@@ -217,7 +403,105 @@ bool ts::MuxPlugin::start()
 
 bool ts::MuxPlugin::stop()
 {
-    return _file.close (*tsp);
+    bool ok = true;
+    for (InputContextVector::iterator it = _inputs.begin(); it != _inputs.end(); ++it) {
+        ok = (*it)->file.close(*tsp) && ok;
+    }
+    _inputs.clear();
+    return ok;
+}
+
+
+//----------------------------------------------------------------------------
+// Get the next packet of an input file, without removing it.
+//----------------------------------------------------------------------------
+
+ts::TSPacket* ts::MuxPlugin::nextPacket(InputContext& ctx)
+{
+    // Read a new chunk of packets when the buffer is empty.
+    if (ctx.buf_next >= ctx.buf_count) {
+        ctx.buf_next = ctx.buf_count = 0;
+        if (!ctx.eof) {
+            ctx.buf_count = ctx.file.read(&ctx.buffer[0], ctx.buffer.size(), *tsp);
+            ctx.eof = ctx.buf_count == 0;
+        }
+        if (ctx.eof) {
+            return 0;
+        }
+
+        // With --timestamps, the first chunk defines the initial bitrate of the file.
+        if (_timestamps && !ctx.origin_set) {
+            PCRAnalyzer analyzer(1, 2);
+            analyzer.feedPackets(&ctx.buffer[0], ctx.buf_count);
+            if (!analyzer.bitrateIsValid()) {
+                analyzer.resetAndUseDTS(1, 2);
+                analyzer.feedPackets(&ctx.buffer[0], ctx.buf_count);
+                ctx.clock.setUseDTS(true);
+            }
+            if (!analyzer.bitrateIsValid()) {
+                tsp->error(u"no PCR or DTS at beginning of %s, cannot insert it with --timestamps", {ctx.file.getFileName()});
+                ctx.eof = true;
+                return 0;
+            }
+            ctx.clock.setTSBitRate(analyzer.bitrate188());
+        }
+    }
+
+    // With --timestamps, compute the time of the packet once.
+    TSPacket* pkt = &ctx.buffer[ctx.buf_next];
+    if (_timestamps && !ctx.head_ready) {
+        ctx.clock.feedPacket(*pkt);
+        ctx.head_time = ctx.clock.currentTime();
+        ctx.head_ready = true;
+        if (!ctx.origin_set) {
+            ctx.origin_set = true;
+            ctx.file_origin = ctx.head_time;
+            ctx.main_origin = _scheduler.currentTime();
+        }
+    }
+    return pkt;
+}
+
+
+//----------------------------------------------------------------------------
+// Select the input file for the current stuffing packet.
+//----------------------------------------------------------------------------
+
+size_t ts::MuxPlugin::selectInput()
+{
+    // With --pcr-based, the scheduler decides.
+    if (_pcr_based) {
+        return _scheduler.nextComponent();
+    }
+
+    // With --timestamps, select the file which is the most late on its own time line.
+    if (_timestamps) {
+        const uint64_t now = _scheduler.currentTime();
+        size_t index = InjectionScheduler::NPOS;
+        uint64_t late = 0;
+        for (size_t i = 0; i < _inputs.size(); ++i) {
+            InputContext& ctx(*_inputs[i]);
+            if (!ctx.completed && (nextPacket(ctx) == 0 || ctx.head_time - ctx.file_origin <= now - ctx.main_origin)) {
+                // Ready or end of file.
+                const uint64_t ctx_late = ctx.eof ? 0 : (now - ctx.main_origin) - (ctx.head_time - ctx.file_origin);
+                if (index == InjectionScheduler::NPOS || ctx_late > late) {
+                    index = i;
+                    late = ctx_late;
+                }
+            }
+        }
+        return index;
+    }
+
+    // Otherwise, select the file which waits the longest for its insertion point.
+    size_t index = InjectionScheduler::NPOS;
+    for (size_t i = 0; i < _inputs.size(); ++i) {
+        const InputContext& ctx(*_inputs[i]);
+        if (!ctx.completed && _packet_count >= ctx.next_pkt && (index == InjectionScheduler::NPOS || ctx.next_pkt < _inputs[index]->next_pkt)) {
+            index = i;
+        }
+    }
+    return index;
 }
 
 
@@ -228,21 +512,32 @@ bool ts::MuxPlugin::stop()
 ts::ProcessorPlugin::Status ts::MuxPlugin::processPacket (TSPacket& pkt, bool& flush, bool& bitrate_changed)
 {
     // Initialization sequences (executed only once).
-    if (_packet_count == 0 && _bitrate != 0) {
+    if (_packet_count == 0 && !_pcr_based && !_timestamps) {
         // Compute the inter-packet interval based on the TS bitrate
-        BitRate ts_bitrate = tsp->bitrate();
-        if (ts_bitrate < _bitrate) {
-            tsp->error(u"input bitrate unknown or too low, specify --inter-packet instead of --bitrate");
-            return TSP_END;
+        const BitRate ts_bitrate = tsp->bitrate();
+        for (InputContextVector::iterator it = _inputs.begin(); it != _inputs.end(); ++it) {
+            InputContext& ctx(**it);
+            if (ctx.bitrate != 0) {
+                if (ts_bitrate < ctx.bitrate) {
+                    tsp->error(u"input bitrate unknown or too low, specify --inter-packet instead of --bitrate");
+                    return TSP_END;
+                }
+                ctx.inter_pkt = ts_bitrate / ctx.bitrate;
+                tsp->verbose(u"transport bitrate: %'d b/s, packet interval: %'d", {ts_bitrate, ctx.inter_pkt});
+            }
         }
-        _inter_pkt = ts_bitrate / _bitrate;
-        tsp->verbose(u"transport bitrate: %'d b/s, packet interval: %'d", {ts_bitrate, _inter_pkt});
     }
 
     // Count TS
     _packet_count++;
     PID pid = pkt.getPID();
 
+    // Compute the time of the packet from the PCR's.
+    if (_pcr_based || _timestamps) {
+        _scheduler.setTSBitRate(tsp->bitrate());
+        _scheduler.feedPacket(pkt);
+    }
+
     // Non-stuffing is transparently passed
     if (pid != PID_NULL) {
         _ts_pids.set(pid);
@@ -250,15 +545,25 @@ ts::ProcessorPlugin::Status ts::MuxPlugin::processPacket (TSPacket& pkt, bool& f
     }
 
     // If not yet time to insert a packet, transmit stuffing
-    if (_packet_count < _pid_next_pkt) {
+    const size_t index = selectInput();
+    if (index == InjectionScheduler::NPOS) {
         return TSP_OK;
     }
+    InputContext& ctx(*_inputs[index]);
 
     // Now, it is time to insert a new packet, read it
-    if (_file.read (&pkt, 1, *tsp) == 0) {
+    const TSPacket* next = nextPacket(ctx);
+    if (next == 0) {
         // File read error, error message already reported
         // If processing terminated, either exit or transparently pass packets
-        if (tsp->useJointTermination()) {
+        ctx.completed = true;
+        if (_pcr_based) {
+            _scheduler.setBitRate(index, 0);
+        }
+        if (++_completed_count < _inputs.size()) {
+            return TSP_OK;
+        }
+        else if (tsp->useJointTermination()) {
             tsp->jointTerminate();
             return TSP_OK;
         }
@@ -270,9 +575,16 @@ ts::ProcessorPlugin::Status ts::MuxPlugin::processPacket (TSPacket& pkt, bool& f
         }
     }
 
+    pkt = *next;
+    ctx.buf_next++;
+    ctx.head_ready = false;
+
     // Get PID of new packet. Perform checks.
-    if (_force_pid) {
-        pkt.setPID(_force_pid_value);
+    if (ctx.force_pid) {
+        pkt.setPID(ctx.force_pid_value);
+    }
+    else if (ctx.remap[pkt.getPID()] != pkt.getPID()) {
+        pkt.setPID(ctx.remap[pkt.getPID()]);
     }
     pid = pkt.getPID();
     if (_check_pid_conflict && _ts_pids.test(pid)) {
@@ -285,7 +597,16 @@ ts::ProcessorPlugin::Status ts::MuxPlugin::processPacket (TSPacket& pkt, bool& f
     }
 
     // Next insertion point
-    _pid_next_pkt += _inter_pkt;
+    if (_pcr_based) {
+        _scheduler.consume(index);
+    }
+    else if (ctx.inter_pkt != 0) {
+        ctx.next_pkt += ctx.inter_pkt;
+    }
+    else {
+        // No interval, share all stuffing packets between all files.
+        ctx.next_pkt = _packet_count;
+    }
 
     return TSP_OK;
 }
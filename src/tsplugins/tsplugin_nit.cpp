@@ -32,10 +32,8 @@
 //
 //----------------------------------------------------------------------------
 
-#include "tsPlugin.h"
+#include "tsAbstractTablePlugin.h"
 #include "tsPluginRepository.h"
-#include "tsSectionDemux.h"
-#include "tsCyclingPacketizer.h"
 #include "tsPAT.h"
 #include "tsNIT.h"
 TSDUCK_SOURCE;
@@ -46,7 +44,7 @@ TSDUCK_SOURCE;
 //----------------------------------------------------------------------------
 
 namespace ts {
-    class NITPlugin: public ProcessorPlugin, private TableHandlerInterface
+    class NITPlugin: public AbstractTablePlugin
     {
     public:
         // Implementation of plugin API
@@ -55,18 +53,11 @@ namespace ts {
         virtual Status processPacket(TSPacket&, bool&, bool&) override;
 
     private:
-        bool               _abort;             // Error (service not found, etc)
-        PID                _nit_pid;           // PID for the NIT (default: read PAT)
-        bool               _incr_version;      // Increment table version
-        bool               _set_version;       // Set a new table version
-        uint8_t            _new_version;       // New table version
         int                _lcn_oper;          // Operation on LCN descriptors
         int                _sld_oper;          // Operation on service_list_descriptors
         std::set<uint16_t> _remove_serv;       // Set of services to remove
         std::set<uint16_t> _remove_ts;         // Set of transport streams to remove
         std::vector<DID>   _removed_desc;      // Set of descriptor tags to remove
-        SectionDemux       _demux;             // Section demux
-        CyclingPacketizer  _pzer;              // Packetizer for modified NIT
         PDS                _pds;               // Private data specifier for removed descriptors
         bool               _cleanup_priv_desc; // Remove private desc without preceding PDS desc
         bool               _update_mpe_fec;    // In terrestrial delivery
@@ -82,8 +73,9 @@ namespace ts {
             LCN_DUPLICATE_ODD = 3  // LCN only
         };
 
-        // Invoked by the demux when a complete table is available.
-        virtual void handleTable(SectionDemux&, const BinaryTable&) override;
+        // Implementation of AbstractTablePlugin.
+        virtual void modifyTable(BinaryTable&, bool&, bool&) override;
+        virtual void handleOtherTable(const BinaryTable&) override;
         void processNIT(NIT&);
         void processDescriptorList(DescriptorList&);
 
@@ -103,19 +95,12 @@ TSPLUGIN_DECLARE_PROCESSOR(nit, ts::NITPlugin)
 //----------------------------------------------------------------------------
 
 ts::NITPlugin::NITPlugin(TSP* tsp_) :
-    ProcessorPlugin(tsp_, u"Perform various transformations on the NIT Actual.", u"[options]"),
-    _abort(false),
-    _nit_pid(PID_NIT),
-    _incr_version(false),
-    _set_version(false),
-    _new_version(0),
+    AbstractTablePlugin(tsp_, u"Perform various transformations on the NIT Actual.", u"[options]", u"NIT"),
     _lcn_oper(0),
     _sld_oper(0),
     _remove_serv(),
     _remove_ts(),
     _removed_desc(),
-    _demux(this),
-    _pzer(),
     _pds(0),
     _cleanup_priv_desc(false),
     _update_mpe_fec(false),
@@ -124,10 +109,8 @@ ts::NITPlugin::NITPlugin(TSP* tsp_) :
     _time_slicing(0)
 {
     option(u"cleanup-private-descriptors", 0);
-    option(u"increment-version", 'i');
     option(u"lcn",               'l', INTEGER, 0, 1, 1, 3);
     option(u"mpe-fec",            0,  INTEGER, 0, 1, 0, 1);
-    option(u"new-version",       'v', INTEGER, 0, 1, 0, 31);
     option(u"pds",                0,  UINT32);
     option(u"pid",               'p', PIDVAL);
     option(u"remove-descriptor",  0,  UINT8,   0, UNLIMITED_COUNT);
@@ -214,7 +197,7 @@ ts::NITPlugin::NITPlugin(TSP* tsp_) :
 bool ts::NITPlugin::start()
 {
     // Get option values
-    _nit_pid = intValue<PID>(u"pid", PID_NULL);
+    const PID nit_pid = intValue<PID>(u"pid", PID_NULL);
     _lcn_oper = intValue<int>(u"lcn", LCN_NONE);
     _sld_oper = intValue<int>(u"sld", LCN_NONE);
     getIntValues(_remove_serv, u"remove-service");
@@ -226,9 +209,6 @@ bool ts::NITPlugin::start()
     _mpe_fec = intValue<uint8_t>(u"mpe-fec") & 0x01;
     _update_time_slicing = present(u"time-slicing");
     _time_slicing = intValue<uint8_t>(u"time-slicing") & 0x01;
-    _incr_version = present(u"increment-version");
-    _set_version = present(u"new-version");
-    _new_version = intValue<uint8_t>(u"new-version", 0);
 
     if (_lcn_oper != LCN_NONE && !_remove_serv.empty()) {
         tsp->error(u"--lcn and --remove-service are mutually exclusive");
@@ -239,78 +219,70 @@ bool ts::NITPlugin::start()
         return false;
     }
 
-    // Initialize the demux and packetizer
-    _demux.reset();
-    _pzer.reset();
-    _pzer.setPID (_nit_pid);
-    if (_nit_pid != PID_NULL) {
+    // Initialize the table processing.
+    PIDSet pids;
+    if (nit_pid != PID_NULL) {
         // NIT PID is specified on the command line
-        _demux.addPID (_nit_pid);
+        pids.set(nit_pid);
     }
     else {
         // Get the PAT to determine NIT PID
-        _demux.addPID (PID_PAT);
+        pids.set(PID_PAT);
     }
-
-    _abort = false;
+    startTables(nit_pid, pids, false);
     return true;
 }
 
 
 //----------------------------------------------------------------------------
-// Invoked by the demux when a complete table is available.
+// Invoked when a table is available in another PID than the NIT PID.
 //----------------------------------------------------------------------------
 
-void ts::NITPlugin::handleTable (SectionDemux& demux, const BinaryTable& table)
+void ts::NITPlugin::handleOtherTable(const BinaryTable& table)
 {
-    switch (table.tableId()) {
-
-        case TID_PAT: {
-            if (table.sourcePID() == PID_PAT) {
-                PAT pat (table);
-                if (pat.isValid()) {
-                    if ((_nit_pid = pat.nit_pid) == PID_NULL) {
-                        _nit_pid = PID_NIT;
-                        tsp->warning(u"NIT PID unspecified in PAT, using DVB default: %d (0x%X)", {_nit_pid, _nit_pid});
-                    }
-                    else {
-                        tsp->verbose(u"NIT PID is %d (0x%X) in PAT", {_nit_pid, _nit_pid});
-                    }
-                    // No longer filter the PAT
-                    _demux.removePID(PID_PAT);
-                    // Now filter the NIT
-                    _demux.addPID(_nit_pid);
-                    _pzer.setPID(_nit_pid);
-                }
+    if (table.tableId() == TID_PAT && table.sourcePID() == PID_PAT && tablePID() == PID_NULL) {
+        PAT pat(table);
+        if (pat.isValid()) {
+            PID nit_pid = pat.nit_pid;
+            if (nit_pid == PID_NULL) {
+                nit_pid = PID_NIT;
+                tsp->warning(u"NIT PID unspecified in PAT, using DVB default: %d (0x%X)", {nit_pid, nit_pid});
             }
-            break;
-        }
-
-        case TID_NIT_OTH: {
-            if (table.sourcePID() == _nit_pid) {
-                // NIT Other are passed unmodified
-                _pzer.removeSections(TID_NIT_OTH, table.tableIdExtension());
-                _pzer.addTable(table);
+            else {
+                tsp->verbose(u"NIT PID is %d (0x%X) in PAT", {nit_pid, nit_pid});
             }
-            break;
+            // No longer filter the PAT, now filter the NIT
+            removeDemuxPID(PID_PAT);
+            setTablePID(nit_pid);
         }
+    }
+}
 
-        case TID_NIT_ACT: {
-            if (table.sourcePID() == _nit_pid) {
-                // Modify NIT Actual
-                NIT nit(table);
-                if (nit.isValid()) {
-                    // Transform NIT Actual
-                    _pzer.removeSections(TID_NIT_ACT, nit.network_id);
-                    processNIT(nit);
-                    _pzer.addTable(nit);
-                }
-            }
-            break;
-        }
 
-        default: {
-            break;
+//----------------------------------------------------------------------------
+// Modify a table from the NIT PID.
+//----------------------------------------------------------------------------
+
+void ts::NITPlugin::modifyTable(BinaryTable& table, bool& is_target, bool& reinsert)
+{
+    if (table.tableId() == TID_NIT_OTH) {
+        // NIT Other are passed unmodified
+        is_target = false;
+    }
+    else if (table.tableId() != TID_NIT_ACT) {
+        reinsert = false;
+    }
+    else if (_lcn_oper != LCN_NONE || _sld_oper != LCN_NONE || !_remove_serv.empty() || !_remove_ts.empty() ||
+             !_removed_desc.empty() || _cleanup_priv_desc || _update_mpe_fec || _update_time_slicing)
+    {
+        // Transform NIT Actual
+        NIT nit(table);
+        if (nit.isValid()) {
+            processNIT(nit);
+            nit.serialize(table);
+        }
+        else {
+            reinsert = false;
         }
     }
 }
@@ -324,14 +296,6 @@ void ts::NITPlugin::processNIT (NIT& nit)
 {
     tsp->debug(u"got a NIT, version %d, network Id: %d (0x%X)", {nit.version, nit.network_id, nit.network_id});
 
-    // Update NIT version
-    if (_incr_version) {
-        nit.version = (nit.version + 1) & 0x1F;
-    }
-    else if (_set_version) {
-        nit.version = _new_version;
-    }
-
     // Remove the specified transport streams
     bool found;
     do {
@@ -524,25 +488,10 @@ void ts::NITPlugin::processDescriptorList (DescriptorList& dlist)
 // Packet processing method
 //----------------------------------------------------------------------------
 
-ts::ProcessorPlugin::Status ts::NITPlugin::processPacket (TSPacket& pkt, bool& flush, bool& bitrate_changed)
+ts::ProcessorPlugin::Status ts::NITPlugin::processPacket(TSPacket& pkt, bool& flush, bool& bitrate_changed)
 {
-    // Filter interesting sections
-    _demux.feedPacket (pkt);
-
-    // If a fatal error occured during section analysis, give up.
-    if (_abort) {
-        return TSP_END;
-    }
+    const Status status = AbstractTablePlugin::processPacket(pkt, flush, bitrate_changed);
 
     // As long as NIT PID is unknown, nullify packets to avoid transmission of the unmodified NIT
-    if (_nit_pid == PID_NULL) {
-        return TSP_NULL;
-    }
-
-    // Replace packets using packetizer
-    if (pkt.getPID() == _nit_pid) {
-        _pzer.getNextPacket (pkt);
-    }
-
-    return TSP_OK;
+    return status == TSP_OK && tablePID() == PID_NULL ? TSP_NULL : status;
 }
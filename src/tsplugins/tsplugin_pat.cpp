@@ -32,10 +32,8 @@
 //
 //----------------------------------------------------------------------------
 
-#include "tsPlugin.h"
+#include "tsAbstractTablePlugin.h"
 #include "tsPluginRepository.h"
-#include "tsSectionDemux.h"
-#include "tsCyclingPacketizer.h"
 #include "tsService.h"
 #include "tsPAT.h"
 TSDUCK_SOURCE;
@@ -46,30 +44,23 @@ TSDUCK_SOURCE;
 //----------------------------------------------------------------------------
 
 namespace ts {
-    class PATPlugin: public ProcessorPlugin, private TableHandlerInterface
+    class PATPlugin: public AbstractTablePlugin
     {
     public:
         // Implementation of plugin API
         PATPlugin(TSP*);
         virtual bool start() override;
-        virtual Status processPacket(TSPacket&, bool&, bool&) override;
 
     private:
-        bool                  _abort;        // Error (service not found, etc)
         std::vector<uint16_t> _remove_serv;  // Set of services to remove
         ServiceVector         _add_serv;     // Set of services to add
         PID                   _new_nit_pid;  // New PID for NIT
         bool                  _remove_nit;   // Remove NIT from PAT
         bool                  _set_tsid;     // Set a new TS id
         uint16_t              _new_tsid;     // New TS id
-        bool                  _incr_version; // Increment table version
-        bool                  _set_version;  // Set a new table version
-        uint8_t               _new_version;  // New table version
-        SectionDemux          _demux;        // Section demux
-        CyclingPacketizer     _pzer;         // Packetizer for modified PAT
 
-        // Invoked by the demux when a complete table is available.
-        virtual void handleTable (SectionDemux&, const BinaryTable&) override;
+        // Implementation of AbstractTablePlugin.
+        virtual void modifyTable(BinaryTable&, bool&, bool&) override;
 
         // Inaccessible operations
         PATPlugin() = delete;
@@ -87,27 +78,19 @@ TSPLUGIN_DECLARE_PROCESSOR(pat, ts::PATPlugin)
 //----------------------------------------------------------------------------
 
 ts::PATPlugin::PATPlugin(TSP* tsp_) :
-    ProcessorPlugin(tsp_, u"Perform various transformations on the PAT", u"[options]"),
-    _abort(false),
+    AbstractTablePlugin(tsp_, u"Perform various transformations on the PAT", u"[options]", u"PAT"),
     _remove_serv(),
     _add_serv(),
     _new_nit_pid(PID_NIT),
     _remove_nit(false),
     _set_tsid(false),
-    _new_tsid(0),
-    _incr_version(false),
-    _set_version(false),
-    _new_version(0),
-    _demux(this),
-    _pzer()
+    _new_tsid(0)
 {
     option(u"add-service",       'a', STRING, 0, UNLIMITED_COUNT);
-    option(u"increment-version", 'i');
     option(u"nit",               'n', PIDVAL);
     option(u"remove-service",    'r', UINT16, 0, UNLIMITED_COUNT);
     option(u"remove-nit",        'u');
     option(u"tsid",              't', UINT16);
-    option(u"new-version",       'v', INTEGER, 0, 1, 0, 31);
 
     setHelp(u"Options:\n"
             u"\n"
@@ -160,9 +143,6 @@ bool ts::PATPlugin::start()
     _remove_nit = present(u"remove-nit");
     _set_tsid = present(u"tsid");
     _new_tsid = intValue<uint16_t>(u"tsid", 0);
-    _incr_version = present(u"increment-version");
-    _set_version = present(u"new-version");
-    _new_version = intValue<uint8_t>(u"new-version", 0);
     getIntValues(_remove_serv, u"remove-service");
 
     // Get list of services to add
@@ -183,41 +163,39 @@ bool ts::PATPlugin::start()
         _add_serv.push_back (serv);
     }
 
-    // Initialize the demux and packetizer
-    _demux.reset();
-    _demux.addPID(PID_PAT);
-    _pzer.reset();
-    _pzer.setPID(PID_PAT);
-
-    _abort = false;
+    // Initialize the table processing.
+    // Use the shared signalization of tsp when available.
+    PIDSet pids;
+    pids.set(PID_PAT);
+    startTables(PID_PAT, pids, true);
     return true;
 }
 
 
 //----------------------------------------------------------------------------
-// Invoked by the demux when a complete table is available.
+// Modify a PAT.
 //----------------------------------------------------------------------------
 
-void ts::PATPlugin::handleTable (SectionDemux& demux, const BinaryTable& table)
+void ts::PATPlugin::modifyTable(BinaryTable& table, bool& is_target, bool& reinsert)
 {
-    if (table.tableId() != TID_PAT || table.sourcePID() != PID_PAT) {
-        return;
-    }
-
-    PAT pat(table);
-    if (!pat.isValid()) {
+    if (table.tableId() != TID_PAT) {
+        reinsert = false;
         return;
     }
 
-    // Modify the PAT
+    // A new TS id is directly set in the binary sections (table id extension).
     if (_set_tsid) {
-        pat.ts_id = _new_tsid;
+        table.setTableIdExtension(_new_tsid);
     }
-    if (_incr_version) {
-        pat.version = (pat.version + 1) & 0x1F;
+
+    // Other modifications need to deserialize the PAT.
+    if (!_remove_nit && _new_nit_pid == PID_NULL && _remove_serv.empty() && _add_serv.empty()) {
+        return;
     }
-    else if (_set_version) {
-        pat.version = _new_version;
+    PAT pat(table);
+    if (!pat.isValid()) {
+        reinsert = false;
+        return;
     }
     if (_remove_nit) {
         pat.nit_pid = PID_NULL;
@@ -233,32 +211,5 @@ void ts::PATPlugin::handleTable (SectionDemux& demux, const BinaryTable& table)
         assert(it->hasPMTPID());
         pat.pmts[it->getId()] = it->getPMTPID();
     }
-
-    // Place modified PAT in the packetizer
-    tsp->verbose(u"PAT version %d modified", {pat.version});
-    _pzer.removeSections(TID_PAT);
-    _pzer.addTable(pat);
-}
-
-
-//----------------------------------------------------------------------------
-// Packet processing method
-//----------------------------------------------------------------------------
-
-ts::ProcessorPlugin::Status ts::PATPlugin::processPacket (TSPacket& pkt, bool& flush, bool& bitrate_changed)
-{
-    // Filter interesting sections
-    _demux.feedPacket (pkt);
-
-    // If a fatal error occured during section analysis, give up.
-    if (_abort) {
-        return TSP_END;
-    }
-
-    // Replace packets using packetizer
-    if (pkt.getPID() == PID_PAT) {
-        _pzer.getNextPacket (pkt);
-    }
-
-    return TSP_OK;
+    pat.serialize(table);
 }
@@ -50,12 +50,18 @@ namespace ts {
         PatternPlugin(TSP*);
         virtual bool start() override;
         virtual Status processPacket(TSPacket&, bool&, bool&) override;
+        virtual size_t processPacketBatch(const TSPacketView&, TSPacketMetadata*, size_t, Status*, bool&, bool&) override;
+        virtual bool isPacketParallel() const override {return true;}
 
     private:
         uint8_t   _offset_pusi;      // Start offset in packets with PUSI
         uint8_t   _offset_non_pusi;  // Start offset in packets without PUSI
         ByteBlock _pattern;          // Binary pattern to apply
         PIDSet    _pid_list;         // Array of pid values to filter
+        uint8_t   _fill[PKT_SIZE];   // Pattern repeated over a full packet size
+
+        // Replace the payload of one packet.
+        void fillPayload(TSPacket&) const;
 
         // Inaccessible operations
         PatternPlugin() = delete;
@@ -77,7 +83,8 @@ ts::PatternPlugin::PatternPlugin(TSP* tsp_) :
     _offset_pusi(0),
     _offset_non_pusi(0),
     _pattern(),
-    _pid_list()
+    _pid_list(),
+    _fill()
 {
     option(u"",                 0, STRING, 1, 1);
     option(u"negate",          'n');
@@ -142,6 +149,12 @@ bool ts::PatternPlugin::start()
         return false;
     }
 
+    // Precompute the pattern, repeated over the largest possible payload.
+    // Each payload is then replaced using one single memcpy().
+    for (size_t i = 0; i < PKT_SIZE; i += _pattern.size()) {
+        ::memcpy(_fill + i, _pattern.data(), std::min(_pattern.size(), PKT_SIZE - i));  // Flawfinder: ignore: memcpy()
+    }
+
     return true;
 }
 
@@ -152,24 +165,48 @@ bool ts::PatternPlugin::start()
 
 ts::ProcessorPlugin::Status ts::PatternPlugin::processPacket(TSPacket& pkt, bool& flush, bool& bitrate_changed)
 {
-    // If the packet has no payload, or not in a selected PID, leave it unmodified
-    if (!pkt.hasPayload() || !_pid_list[pkt.getPID()]) {
-        return TSP_OK;
+    // If the packet is not in a selected PID, leave it unmodified
+    if (_pid_list[pkt.getPID()]) {
+        fillPayload(pkt);
     }
+    return TSP_OK;
+}
 
-    // Compute start of payload area to replace
-    uint8_t* pl = pkt.b + pkt.getHeaderSize() + (pkt.getPUSI() ? _offset_pusi : _offset_non_pusi);
 
-    // Compute remaining size to replace (maybe negative if starting offset is beyond the end of the packet).
-    int remain = int(pkt.b + PKT_SIZE - pl);
+//----------------------------------------------------------------------------
+// Batch packet processing method
+//----------------------------------------------------------------------------
 
-    // Replace the payload with the pattern
-    while (remain > 0) {
-        int cursize = std::min(remain, int(_pattern.size()));
-        ::memcpy(pl, _pattern.data(), cursize);  // Flawfinder: ignore: memcpy()
-        pl += cursize;
-        remain -= cursize;
+size_t ts::PatternPlugin::processPacketBatch(const TSPacketView& pkts, TSPacketMetadata* mdata, size_t count, Status* status, bool& flush, bool& bitrate_changed)
+{
+    for (size_t i = 0; i < count; ++i) {
+        // Skip dropped packets and packets which are not in a selected PID.
+        if (pkts[i].b[0] != 0 && _pid_list[pkts[i].getPID()]) {
+            fillPayload(pkts[i]);
+        }
+        status[i] = TSP_OK;
     }
+    return count;
+}
 
-    return TSP_OK;
+
+//----------------------------------------------------------------------------
+// Replace the payload of one packet.
+//----------------------------------------------------------------------------
+
+void ts::PatternPlugin::fillPayload(TSPacket& pkt) const
+{
+    // If the packet has no payload, leave it unmodified
+    if (!pkt.hasPayload()) {
+        return;
+    }
+
+    // Compute start of payload area to replace
+    const size_t start = pkt.getHeaderSize() + (pkt.getPUSI() ? _offset_pusi : _offset_non_pusi);
+
+    // Replace the payload with the pattern. Since the pattern restarts at the
+    // beginning of each payload area, the precomputed fill buffer is aligned.
+    if (start < PKT_SIZE) {
+        ::memcpy(pkt.b + start, _fill, PKT_SIZE - start);  // Flawfinder: ignore: memcpy()
+    }
 }
@@ -0,0 +1,333 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  Transport stream processor shared library:
+//  Read TS packets from UDP datagrams in a pcap or pcapng capture file.
+//
+//----------------------------------------------------------------------------
+
+#include "tsPlugin.h"
+#include "tsPluginRepository.h"
+#include "tsPcapFile.h"
+#include "tsMonotonic.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// Plugin definition
+//----------------------------------------------------------------------------
+
+namespace ts {
+    class PcapInput: public InputPlugin
+    {
+    public:
+        // Implementation of plugin API
+        PcapInput(TSP*);
+        virtual bool start() override;
+        virtual bool stop() override;
+        virtual size_t receive(TSPacket*, size_t) override;
+        virtual size_t receiveWithMetadata(TSPacket*, TSPacketMetadata*, size_t) override;
+
+    private:
+        // Command line options.
+        UString        _file_name;     // Capture file name
+        SocketAddress  _destination;   // Selected destination, address and port are optional
+        SocketAddress  _source;        // Selected source, address and port are optional
+        bool           _timed;         // Replay with the capture time stamps
+        size_t         _repeat;        // Number of times to read the file, zero means infinite
+
+        // Working data.
+        PcapFile       _file;          // Capture file
+        bool           _flow_set;      // The destination of the flow is known
+        size_t         _passes;        // Number of completed passes over the file
+        PacketCounter  _datagrams;     // Datagrams of the selected flow
+        PacketCounter  _spurious;      // Datagrams of the selected flow without TS packets
+        NanoSecond     _first_time;    // Capture time of first datagram of current pass, negative if unknown
+        Monotonic      _start_time;    // System time of first datagram of current pass
+
+        // Current datagram.
+        const uint8_t* _inbuf_next;    // Address of next TS packet to return
+        size_t         _inbuf_count;   // Remaining TS packets in current datagram
+        NanoSecond     _inbuf_time;    // Capture time of current datagram
+
+        // Check if a datagram belongs to the selected flow.
+        bool selected(const SocketAddress& source, const SocketAddress& destination) const;
+
+        // Get the TS packets of the next datagram of the selected flow. Return false at end of input.
+        bool nextDatagram();
+
+        // Inaccessible operations
+        PcapInput() = delete;
+        PcapInput(const PcapInput&) = delete;
+        PcapInput& operator=(const PcapInput&) = delete;
+    };
+}
+
+TSPLUGIN_DECLARE_VERSION
+TSPLUGIN_DECLARE_INPUT(pcap, ts::PcapInput)
+
+
+//----------------------------------------------------------------------------
+// Constructor
+//----------------------------------------------------------------------------
+
+ts::PcapInput::PcapInput(TSP* tsp_) :
+    InputPlugin(tsp_, u"Read TS packets from UDP datagrams in a pcap or pcapng capture file.", u"[options] file-name"),
+    _file_name(),
+    _destination(),
+    _source(),
+    _timed(false),
+    _repeat(1),
+    _file(),
+    _flow_set(false),
+    _passes(0),
+    _datagrams(0),
+    _spurious(0),
+    _first_time(-1),
+    _start_time(),
+    _inbuf_next(0),
+    _inbuf_count(0),
+    _inbuf_time(-1)
+{
+    option(u"",             0,  STRING, 1, 1);
+    option(u"destination", 'd', STRING);
+    option(u"infinite",    'i');
+    option(u"repeat",      'r', POSITIVE);
+    option(u"source",      's', STRING);
+    option(u"timed",       't');
+
+    setHelp(u"Parameter:\n"
+            u"  Name of a capture file in pcap or pcapng format, as produced by tcpdump or\n"
+            u"  wireshark. The file is mapped in memory. The TS packets are extracted from\n"
+            u"  the IPv4 UDP datagrams of one flow, with or without RTP header, the same way\n"
+            u"  as the ip plugin. Other packets, including IP fragments, are ignored.\n"
+            u"\n"
+            u"  By default, the TS packets are read at maximum speed, for analysis. Each\n"
+            u"  packet is tagged in its metadata with the capture time of its datagram.\n"
+            u"\n"
+            u"Options:\n"
+            u"\n"
+            u"  -d [address:]port\n"
+            u"  --destination [address:]port\n"
+            u"      Select the UDP flow to read by destination. By default, the destination\n"
+            u"      of the first datagram which contains TS packets is used and all other\n"
+            u"      destinations are ignored.\n"
+            u"\n"
+            u"  --help\n"
+            u"      Display this help text.\n"
+            u"\n"
+            u"  -i\n"
+            u"  --infinite\n"
+            u"      Repeat the playout of the file infinitely (default: only once).\n"
+            u"\n"
+            u"  -r count\n"
+            u"  --repeat count\n"
+            u"      Repeat the playout of the file the specified number of times\n"
+            u"      (default: only once).\n"
+            u"\n"
+            u"  -s address[:port]\n"
+            u"  --source address[:port]\n"
+            u"      Select the UDP flow to read by source. By default, all sources are\n"
+            u"      accepted.\n"
+            u"\n"
+            u"  -t\n"
+            u"  --timed\n"
+            u"      Replay the datagrams according to their capture time stamps, relative\n"
+            u"      to the first datagram of the flow. By default, the datagrams are read\n"
+            u"      at maximum speed. Ignored when tsp runs in offline mode.\n"
+            u"\n"
+            u"  --version\n"
+            u"      Display the version number.\n");
+}
+
+
+//----------------------------------------------------------------------------
+// Start method
+//----------------------------------------------------------------------------
+
+bool ts::PcapInput::start()
+{
+    getValue(_file_name, u"");
+    _timed = present(u"timed");
+    if (_timed && tsp->offline()) {
+        tsp->verbose(u"offline mode, --timed ignored");
+        _timed = false;
+    }
+    _repeat = present(u"infinite") ? 0 : intValue<size_t>(u"repeat", 1);
+
+    _destination.clear();
+    _source.clear();
+    const UString dest(value(u"destination"));
+    const UString src(value(u"source"));
+    if ((!dest.empty() && !_destination.resolve(dest, *tsp)) || (!src.empty() && !_source.resolve(src, *tsp))) {
+        return false;
+    }
+    if (!dest.empty() && !_destination.hasPort()) {
+        tsp->error(u"no UDP port specified in %s", {dest});
+        return false;
+    }
+
+    if (!_file.open(_file_name, *tsp)) {
+        return false;
+    }
+    tsp->verbose(u"reading %s file %s", {_file.isPcapNG() ? u"pcapng" : u"pcap", _file_name});
+
+    _flow_set = !dest.empty();
+    _passes = 0;
+    _datagrams = _spurious = 0;
+    _first_time = -1;
+    _inbuf_next = 0;
+    _inbuf_count = 0;
+    _inbuf_time = -1;
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Stop method
+//----------------------------------------------------------------------------
+
+bool ts::PcapInput::stop()
+{
+    tsp->verbose(u"read %'d captured packets, %'d datagrams in flow %s, %'d without TS packets, %'d IP fragments ignored",
+                 {_file.packetCount(), _datagrams, _flow_set ? _destination.toString() : u"none", _spurious, _file.fragmentCount()});
+    _file.close();
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Check if a datagram belongs to the selected flow.
+//----------------------------------------------------------------------------
+
+bool ts::PcapInput::selected(const SocketAddress& source, const SocketAddress& destination) const
+{
+    return (!_source.hasAddress() || _source.address() == source.address()) &&
+           (!_source.hasPort() || _source.port() == source.port()) &&
+           (!_destination.hasAddress() || _destination.address() == destination.address()) &&
+           (!_destination.hasPort() || _destination.port() == destination.port());
+}
+
+
+//----------------------------------------------------------------------------
+// Get the TS packets of the next datagram of the selected flow.
+//----------------------------------------------------------------------------
+
+bool ts::PcapInput::nextDatagram()
+{
+    SocketAddress source;
+    SocketAddress destination;
+    const uint8_t* data = 0;
+    size_t size = 0;
+    size_t start = 0;
+
+    for (;;) {
+        if (!_file.readUDP(source, destination, data, size, _inbuf_time, *tsp)) {
+            // End of file, restart if repeat is required.
+            if ((_repeat != 0 && ++_passes >= _repeat) || _file.packetCount() == 0) {
+                return false;
+            }
+            _file.rewind();
+            _first_time = -1;
+            continue;
+        }
+        if (!selected(source, destination)) {
+            continue;
+        }
+        if (!TSPacket::Locate(data, size, start, _inbuf_count)) {
+            // Ignore datagrams without TS packets, they can't be used to select the flow.
+            if (_flow_set) {
+                _spurious++;
+            }
+            continue;
+        }
+        if (!_flow_set) {
+            // The first datagram with TS packets selects the flow.
+            _flow_set = true;
+            _destination = destination;
+            tsp->verbose(u"using UDP flow %s from %s", {destination.toString(), source.toString()});
+        }
+        _datagrams++;
+        _inbuf_next = data + start;
+        break;
+    }
+
+    // In timed mode, wait until the capture time of the datagram, relative to the first one.
+    if (_timed && _inbuf_time >= 0) {
+        if (_first_time < 0) {
+            _first_time = _inbuf_time;
+            _start_time.getSystemTime();
+        }
+        else if (_inbuf_time > _first_time) {
+            Monotonic due(_start_time);
+            due += _inbuf_time - _first_time;
+            due.wait();
+        }
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Input methods
+//----------------------------------------------------------------------------
+
+size_t ts::PcapInput::receive(TSPacket* buffer, size_t max_packets)
+{
+    return receiveWithMetadata(buffer, 0, max_packets);
+}
+
+size_t ts::PcapInput::receiveWithMetadata(TSPacket* buffer, TSPacketMetadata* mdata, size_t max_packets)
+{
+    size_t pkt_cnt = 0;
+    while (pkt_cnt < max_packets && !tsp->aborting()) {
+        if (_inbuf_count > 0) {
+            // Return packets from the current datagram.
+            const size_t count = std::min(_inbuf_count, max_packets - pkt_cnt);
+            ::memcpy(buffer[pkt_cnt].b, _inbuf_next, count * PKT_SIZE);
+            if (mdata != 0 && _inbuf_time >= 0) {
+                for (size_t i = 0; i < count; ++i) {
+                    mdata[pkt_cnt + i].setInputTimeStamp(_inbuf_time);
+                }
+            }
+            pkt_cnt += count;
+            _inbuf_count -= count;
+            _inbuf_next += count * PKT_SIZE;
+        }
+        else if (_timed && pkt_cnt > 0) {
+            // In timed mode, return the packets before waiting for the next datagram.
+            break;
+        }
+        else if (!nextDatagram()) {
+            // End of input.
+            break;
+        }
+    }
+    return pkt_cnt;
+}
@@ -0,0 +1,306 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+//
+//  Transport stream processor shared library:
+//  Restamp PCR's according to the packet position at the output bitrate
+//
+//----------------------------------------------------------------------------
+
+#include "tsPlugin.h"
+#include "tsPluginRepository.h"
+#include "tsPCRAnalyzer.h"
+TSDUCK_SOURCE;
+
+#define DEF_MAX_SHIFT_MS 100
+
+
+//----------------------------------------------------------------------------
+// Plugin definition
+//----------------------------------------------------------------------------
+
+namespace ts {
+    class PCRAdjustPlugin: public ProcessorPlugin
+    {
+    public:
+        // Implementation of plugin API
+        PCRAdjustPlugin(TSP*);
+        virtual bool start() override;
+        virtual bool stop() override;
+        virtual Status processPacket(TSPacket&, bool&, bool&) override;
+
+    private:
+        // Clock values are kept in fixed-point PCR units, with FRAC_BITS fractional bits.
+        // PCR values wrap at 2**33 * 300, the fixed-point values wrap at CLOCK_WRAP.
+        static const size_t   FRAC_BITS = 16;
+        static const uint64_t PCR_WRAP = PTS_DTS_SCALE * SYSTEM_CLOCK_SUBFACTOR;
+        static const uint64_t CLOCK_WRAP = PCR_WRAP << FRAC_BITS;
+
+        // Restamping state of one clock (PCR or OPCR) in one PID.
+        struct ClockContext
+        {
+            bool          valid;   // The clock has a reference value.
+            uint64_t      value;   // Last restamped value, fixed-point.
+            PacketCounter packet;  // Packet index of last restamped value.
+
+            // Constructor
+            ClockContext() : valid(false), value(0), packet(0) {}
+        };
+
+        // Description of one PID.
+        struct PIDContext
+        {
+            ClockContext pcr;
+            ClockContext opcr;
+        };
+
+        // PCRAdjustPlugin private members
+        BitRate       _user_bitrate;   // Bitrate from command line (0 if unspecified)
+        BitRate       _pcr_bitrate;    // Last bitrate evaluated from PCR's
+        BitRate       _bitrate;        // Current bitrate used for restamping
+        uint64_t      _pkt_duration;   // Duration of one packet at _bitrate, fixed-point PCR units
+        int64_t       _max_shift;      // Max difference with original clock in PCR units
+        bool          _opcr;           // Also restamp OPCR's
+        PIDSet        _pids;           // PID's to restamp
+        PacketCounter _packet_count;   // Packet index in the output stream
+        PacketCounter _restamped;      // Number of restamped clock values
+        PacketCounter _resync;         // Number of resynchronizations on original clock
+        PCRAnalyzer   _pcr_analyzer;   // Bitrate evaluation when not known by tsp
+        PIDContext    _ctx[PID_MAX];   // Per-PID state
+
+        // Get the current restamping bitrate, update packet duration.
+        void updateBitrate();
+
+        // Compute the new value of a clock. Return the new value.
+        uint64_t restamp(ClockContext& ctx, uint64_t original, bool discontinuity, PID pid, const UChar* name);
+
+        // Inaccessible operations
+        PCRAdjustPlugin() = delete;
+        PCRAdjustPlugin(const PCRAdjustPlugin&) = delete;
+        PCRAdjustPlugin& operator=(const PCRAdjustPlugin&) = delete;
+    };
+}
+
+TSPLUGIN_DECLARE_VERSION
+TSPLUGIN_DECLARE_PROCESSOR(pcradjust, ts::PCRAdjustPlugin)
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::PCRAdjustPlugin::FRAC_BITS;
+const uint64_t ts::PCRAdjustPlugin::PCR_WRAP;
+const uint64_t ts::PCRAdjustPlugin::CLOCK_WRAP;
+#endif
+
+
+//----------------------------------------------------------------------------
+// Constructor
+//----------------------------------------------------------------------------
+
+ts::PCRAdjustPlugin::PCRAdjustPlugin(TSP* tsp_) :
+    ProcessorPlugin(tsp_, u"Restamp PCR's according to the packet position at the output bitrate.", u"[options]"),
+    _user_bitrate(0),
+    _pcr_bitrate(0),
+    _bitrate(0),
+    _pkt_duration(0),
+    _max_shift(0),
+    _opcr(false),
+    _pids(),
+    _packet_count(0),
+    _restamped(0),
+    _resync(0),
+    _pcr_analyzer(),
+    _ctx()
+{
+    option(u"bitrate",   'b', POSITIVE);
+    option(u"max-shift", 'm', POSITIVE);
+    option(u"opcr",      'o');
+    option(u"pid",       'p', PIDVAL, 0, UNLIMITED_COUNT);
+
+    setHelp(u"Restamp the PCR's so that they exactly match the position of their packets\n"
+            u"in the transport stream at the output bitrate. This removes the PCR jitter\n"
+            u"which is introduced when packets are removed or inserted upstream in the\n"
+            u"chain (zap, filter, null packets removal, mux, etc.) This plugin should be\n"
+            u"the last packet processor in the chain, since any subsequent change in the\n"
+            u"packet sequence would reintroduce jitter.\n"
+            u"\n"
+            u"Options:\n"
+            u"\n"
+            u"  -b value\n"
+            u"  --bitrate value\n"
+            u"      Output bitrate in bits/second which is used to restamp the PCR's.\n"
+            u"      By default, use the bitrate as reported by the previous plugins in the\n"
+            u"      chain. If this bitrate is unknown, it is evaluated from the PCR's.\n"
+            u"\n"
+            u"  --help\n"
+            u"      Display this help text.\n"
+            u"\n"
+            u"  -m value\n"
+            u"  --max-shift value\n"
+            u"      Maximum difference in milliseconds between a restamped PCR and the\n"
+            u"      original one. When the difference is larger, typically because the\n"
+            u"      bitrate is inaccurate, the PCR's of the PID are resynchronized on the\n"
+            u"      original value. The default is " TS_STRINGIFY(DEF_MAX_SHIFT_MS) u" ms.\n"
+            u"\n"
+            u"  -o\n"
+            u"  --opcr\n"
+            u"      Also restamp the OPCR's. By default, OPCR's are left unchanged.\n"
+            u"\n"
+            u"  -p value\n"
+            u"  --pid value\n"
+            u"      Restamp the PCR's of this PID. Several -p or --pid options may be\n"
+            u"      specified. By default, the PCR's of all PID's are restamped.\n"
+            u"\n"
+            u"  --version\n"
+            u"      Display the version number.\n");
+}
+
+
+//----------------------------------------------------------------------------
+// Start method
+//----------------------------------------------------------------------------
+
+bool ts::PCRAdjustPlugin::start()
+{
+    _user_bitrate = intValue<BitRate>(u"bitrate", 0);
+    _max_shift = intValue<int64_t>(u"max-shift", DEF_MAX_SHIFT_MS) * (SYSTEM_CLOCK_FREQ / MilliSecPerSec);
+    _opcr = present(u"opcr");
+    getPIDSet(_pids, u"pid", true);
+
+    _pcr_bitrate = 0;
+    _bitrate = 0;
+    _pkt_duration = 0;
+    _packet_count = 0;
+    _restamped = 0;
+    _resync = 0;
+    _pcr_analyzer.reset();
+    for (size_t i = 0; i < PID_MAX; ++i) {
+        _ctx[i] = PIDContext();
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Stop method
+//----------------------------------------------------------------------------
+
+bool ts::PCRAdjustPlugin::stop()
+{
+    tsp->verbose(u"%'d clock values restamped, %'d resynchronizations", {_restamped, _resync});
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Get the current restamping bitrate, update packet duration.
+//----------------------------------------------------------------------------
+
+void ts::PCRAdjustPlugin::updateBitrate()
+{
+    BitRate bitrate = _user_bitrate;
+    if (bitrate == 0) {
+        bitrate = tsp->bitrate();
+    }
+    if (bitrate == 0) {
+        bitrate = _pcr_bitrate;
+    }
+    if (bitrate != _bitrate) {
+        tsp->log(_bitrate == 0 ? Severity::Verbose : Severity::Debug, u"restamping PCR's at %'d b/s", {bitrate});
+        _bitrate = bitrate;
+        // Fixed-point duration of one packet: (188 * 8 * 27,000,000 << 16) / bitrate.
+        _pkt_duration = bitrate == 0 ? 0 : ((uint64_t(PKT_SIZE) * 8 * SYSTEM_CLOCK_FREQ) << FRAC_BITS) / bitrate;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Compute the new value of a clock.
+//----------------------------------------------------------------------------
+
+uint64_t ts::PCRAdjustPlugin::restamp(ClockContext& ctx, uint64_t original, bool discontinuity, PID pid, const UChar* name)
+{
+    if (ctx.valid && !discontinuity) {
+        // Move forward by the duration of the packets since the last clock value.
+        ctx.value += (_packet_count - ctx.packet) * _pkt_duration;
+        if (ctx.value >= CLOCK_WRAP) {
+            ctx.value %= CLOCK_WRAP;
+        }
+
+        // Difference with the original clock, taking wrap-up into account.
+        int64_t shift = int64_t(ctx.value >> FRAC_BITS) - int64_t(original);
+        if (shift > int64_t(PCR_WRAP / 2)) {
+            shift -= PCR_WRAP;
+        }
+        else if (shift < -int64_t(PCR_WRAP / 2)) {
+            shift += PCR_WRAP;
+        }
+        if (shift > _max_shift || shift < -_max_shift) {
+            tsp->verbose(u"%s PID 0x%X (%d) drifted by %'d ms, resynchronizing", {name, pid, pid, shift / int64_t(SYSTEM_CLOCK_FREQ / MilliSecPerSec)});
+            ctx.value = original << FRAC_BITS;
+            _resync++;
+        }
+    }
+    else {
+        // First clock value or explicit discontinuity: start from the original value.
+        ctx.valid = true;
+        ctx.value = original << FRAC_BITS;
+    }
+    ctx.packet = _packet_count;
+    _restamped++;
+    return ctx.value >> FRAC_BITS;
+}
+
+
+//----------------------------------------------------------------------------
+// Packet processing method
+//----------------------------------------------------------------------------
+
+ts::ProcessorPlugin::Status ts::PCRAdjustPlugin::processPacket(TSPacket& pkt, bool& flush, bool& bitrate_changed)
+{
+    // Without bitrate from the command line or the chain, evaluate it from the PCR's.
+    if (_user_bitrate == 0 && tsp->bitrate() == 0 && _pcr_analyzer.feedPacket(pkt)) {
+        _pcr_bitrate = _pcr_analyzer.bitrate188();
+        _pcr_analyzer.reset();
+    }
+
+    const PID pid = pkt.getPID();
+    if (_pids[pid] && pkt.hasPCR()) {
+        updateBitrate();
+        if (_pkt_duration != 0) {
+            const bool discontinuity = pkt.getDiscontinuityIndicator();
+            PIDContext& pc(_ctx[pid]);
+            pkt.setPCR(restamp(pc.pcr, pkt.getPCR(), discontinuity, pid, u"PCR"));
+            if (_opcr && pkt.hasOPCR()) {
+                pkt.setOPCR(restamp(pc.opcr, pkt.getOPCR(), discontinuity, pid, u"OPCR"));
+            }
+        }
+    }
+
+    _packet_count++;
+    return TSP_OK;
+}
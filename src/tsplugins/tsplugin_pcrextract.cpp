@@ -34,6 +34,7 @@
 
 #include "tsPlugin.h"
 #include "tsPluginRepository.h"
+#include "tsBlockOutputStream.h"
 TSDUCK_SOURCE;
 
 #define DEFAULT_SEPARATOR u";"
@@ -59,18 +60,17 @@ namespace ts {
         typedef std::map<PID,PIDContext> PIDContextMap;
 
         // PCRExtractPlugin private members
-        UString       _separator;      // Field separator
-        bool          _noheader;       // Suppress header
-        bool          _good_pts_only;  // Keep "good" PTS only
-        bool          _get_pcr;        // Get PCR
-        bool          _get_opcr;       // Get OPCR
-        bool          _get_pts;        // Get PTS
-        bool          _get_dts;        // Get DTS
-        UString       _output_name;    // Output file name (NULL means stderr)
-        std::ofstream _output_stream;  // Output stream file
-        std::ostream* _output;         // Reference to actual output stream file
-        PacketCounter _packet_count;   // Global packets count
-        PIDContextMap _stats;          // Per-PID statistics
+        std::string       _separator;      // Field separator, in UTF-8
+        bool              _noheader;       // Suppress header
+        bool              _good_pts_only;  // Keep "good" PTS only
+        bool              _get_pcr;        // Get PCR
+        bool              _get_opcr;       // Get OPCR
+        bool              _get_pts;        // Get PTS
+        bool              _get_dts;        // Get DTS
+        UString           _output_name;    // Output file name (empty means stderr)
+        BlockOutputStream _output;         // Output in large blocks
+        PacketCounter     _packet_count;   // Global packets count
+        PIDContextMap     _stats;          // Per-PID statistics
 
         // Description of one PID
         struct PIDContext
@@ -102,6 +102,9 @@ namespace ts {
             }
         };
 
+        // Output the beginning of a line, up to the value offset in PID.
+        void startLine(PID pid, const PIDContext& pc, const char* type, PacketCounter count, uint64_t value, uint64_t first);
+
         // Inaccessible operations
         PCRExtractPlugin() = delete;
         PCRExtractPlugin(const PCRExtractPlugin&) = delete;
@@ -127,8 +130,7 @@ ts::PCRExtractPlugin::PCRExtractPlugin(TSP* tsp_) :
     _get_pts(false),
     _get_dts(false),
     _output_name(),
-    _output_stream(),
-    _output(0),
+    _output(BlockOutputStream::DEFAULT_BLOCK_SIZE, *tsp),
     _packet_count(0),
     _stats()
 {
@@ -192,7 +194,7 @@ ts::PCRExtractPlugin::PCRExtractPlugin(TSP* tsp_) :
 
 bool ts::PCRExtractPlugin::start()
 {
-    _separator = value(u"separator", DEFAULT_SEPARATOR);
+    _separator = value(u"separator", DEFAULT_SEPARATOR).toUTF8();
     _noheader = present(u"noheader");
     _output_name = value(u"output-file");
     _good_pts_only = present(u"good-pts-only");
@@ -205,15 +207,15 @@ bool ts::PCRExtractPlugin::start()
         _get_pts = _get_dts = _get_pcr = _get_opcr = true;
     }
 
-    // Create the output file if there is one
+    // Create the output file if there is one. The lines are written in large blocks
+    // in the file. On standard error, they are written immediately, line by line.
     if (_output_name.empty()) {
-        _output = &std::cerr;
+        _output.setStream(std::cerr);
+        _output.setBlockSize(0);
     }
     else {
-        _output = &_output_stream;
-        _output_stream.open(_output_name.toUTF8().c_str());
-        if (!_output_stream) {
-            tsp->error(u"cannot create file %s", {_output_name});
+        _output.setBlockSize(BlockOutputStream::DEFAULT_BLOCK_SIZE);
+        if (!_output.setFile(_output_name)) {
             return false;
         }
     }
@@ -224,7 +226,7 @@ bool ts::PCRExtractPlugin::start()
 
     // Output header
     if (!_noheader) {
-        *_output << "PID" << _separator
+        _output << "PID" << _separator
                  << "Packet index in TS" << _separator
                  << "Packet index in PID" << _separator
                  << "Type" << _separator
@@ -243,13 +245,26 @@ bool ts::PCRExtractPlugin::start()
 
 bool ts::PCRExtractPlugin::stop()
 {
-    if (!_output_name.empty()) {
-        _output_stream.close();
-    }
+    _output.close();
     return true;
 }
 
 
+//----------------------------------------------------------------------------
+// Output the beginning of a line, up to the value offset in PID.
+//----------------------------------------------------------------------------
+
+void ts::PCRExtractPlugin::startLine(PID pid, const PIDContext& pc, const char* type, PacketCounter count, uint64_t value, uint64_t first)
+{
+    _output.putDecimal(pid) << _separator;
+    _output.putDecimal(_packet_count) << _separator;
+    _output.putDecimal(pc.packet_count) << _separator << type << _separator;
+    _output.putDecimal(count) << _separator;
+    _output.putDecimal(value) << _separator;
+    _output.putDecimal(value - first) << _separator;
+}
+
+
 //----------------------------------------------------------------------------
 // Packet processing method
 //----------------------------------------------------------------------------
@@ -269,14 +284,8 @@ ts::ProcessorPlugin::Status ts::PCRExtractPlugin::processPacket (TSPacket& pkt,
             pc.first_pcr = pcr;
         }
         if (_get_pcr) {
-            *_output << pid << _separator
-                     << _packet_count << _separator
-                     << pc.packet_count << _separator
-                     << "PCR" << _separator
-                     << pc.pcr_count << _separator
-                     << pcr << _separator
-                     << (pcr - pc.first_pcr) << _separator
-                     << std::endl;
+            startLine(pid, pc, "PCR", pc.pcr_count, pcr, pc.first_pcr);
+            _output << std::endl;
         }
     }
 
@@ -286,17 +295,11 @@ ts::ProcessorPlugin::Status ts::PCRExtractPlugin::processPacket (TSPacket& pkt,
             pc.first_opcr = opcr;
         }
         if (_get_opcr) {
-            *_output << pid << _separator
-                     << _packet_count << _separator
-                     << pc.packet_count << _separator
-                     << "OPCR" << _separator
-                     << pc.opcr_count << _separator
-                     << opcr << _separator
-                     << (opcr - pc.first_opcr) << _separator;
+            startLine(pid, pc, "OPCR", pc.opcr_count, opcr, pc.first_opcr);
             if (has_pcr) {
-                *_output << (int64_t (opcr) - int64_t (pcr));
+                _output.putDecimal(int64_t (opcr) - int64_t (pcr));
             }
-            *_output << std::endl;
+            _output << std::endl;
         }
     }
 
@@ -312,17 +315,11 @@ ts::ProcessorPlugin::Status ts::PCRExtractPlugin::processPacket (TSPacket& pkt,
             pc.last_good_pts = pts;
         }
         if (_get_pts && (good_pts || !_good_pts_only)) {
-            *_output << pid << _separator
-                     << _packet_count << _separator
-                     << pc.packet_count << _separator
-                     << "PTS" << _separator
-                     << pc.pts_count << _separator
-                     << pts << _separator
-                     << (pts - pc.first_pts) << _separator;
+            startLine(pid, pc, "PTS", pc.pts_count, pts, pc.first_pts);
             if (has_pcr) {
-                *_output << (int64_t (pts) - int64_t (pcr / SYSTEM_CLOCK_SUBFACTOR));
+                _output.putDecimal(int64_t (pts) - int64_t (pcr / SYSTEM_CLOCK_SUBFACTOR));
             }
-            *_output << std::endl;
+            _output << std::endl;
         }
     }
 
@@ -332,17 +329,11 @@ ts::ProcessorPlugin::Status ts::PCRExtractPlugin::processPacket (TSPacket& pkt,
             pc.first_dts = dts;
         }
         if (_get_dts) {
-            *_output << pid << _separator
-                     << _packet_count << _separator
-                     << pc.packet_count << _separator
-                     << "DTS" << _separator
-                     << pc.dts_count << _separator
-                     << dts << _separator
-                     << (dts - pc.first_dts) << _separator;
+            startLine(pid, pc, "DTS", pc.dts_count, dts, pc.first_dts);
             if (has_pcr) {
-                *_output << (int64_t (dts) - int64_t (pcr / SYSTEM_CLOCK_SUBFACTOR));
+                _output.putDecimal(int64_t (dts) - int64_t (pcr / SYSTEM_CLOCK_SUBFACTOR));
             }
-            *_output << std::endl;
+            _output << std::endl;
         }
     }
 
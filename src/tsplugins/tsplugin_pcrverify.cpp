@@ -34,6 +34,7 @@
 
 #include "tsPlugin.h"
 #include "tsPluginRepository.h"
+#include "tsLogLimiter.h"
 #include "tsTime.h"
 TSDUCK_SOURCE;
 
@@ -78,6 +79,7 @@ namespace ts {
         PacketCounter _nb_pcr_nok;       // Number of PCR with jitter
         PacketCounter _nb_pcr_unchecked; // Number of unchecked PCR (no previous ref)
         PIDContext    _stats[PID_MAX];   // Per-PID statistics
+        LogLimiter    _log;              // Rate-limited reporting of PCR jitter
 
         // PCR units per micro-second
         static const int64_t PCR_PER_MICRO_SEC = int64_t (SYSTEM_CLOCK_FREQ) / MicroSecPerSec;
@@ -116,7 +118,8 @@ ts::PCRVerifyPlugin::PCRVerifyPlugin(TSP* tsp_) :
     _nb_pcr_ok(0),
     _nb_pcr_nok(0),
     _nb_pcr_unchecked(0),
-    _stats()
+    _stats(),
+    _log(*tsp_, u"PID")
 {
     option(u"absolute",   'a');
     option(u"bitrate",    'b', POSITIVE);
@@ -141,9 +144,9 @@ ts::PCRVerifyPlugin::PCRVerifyPlugin(TSP* tsp_) :
             u"\n"
             u"  -j value\n"
             u"  --jitter-max value\n"
-            u"      Maximum allowed jitter. PCR's with a higher jitter are reported, others\n"
-            u"      are ignored. If --absolute, the specified value is in PCR units,\n"
-            u"      otherwise it is in micro-seconds. The default is " + UString::Decimal(DEFAULT_JITTER_MAX) + u" PCR units\n"
+            u"      Maximum allowed jitter. PCR's with a higher jitter are reported, up to\n"
+            u"      10 messages per second and per PID, others are ignored. If --absolute,\n"
+            u"      the specified value is in PCR units, otherwise it is in micro-seconds. The default is " + UString::Decimal(DEFAULT_JITTER_MAX) + u" PCR units\n"
             u"      or " + UString::Decimal(DEFAULT_JITTER_MAX_US) + u" micro-seconds.\n"
             u"\n"
             u"  -p value\n"
@@ -200,6 +203,7 @@ bool ts::PCRVerifyPlugin::start()
 bool ts::PCRVerifyPlugin::stop()
 {
     // Display PCR summary
+    _log.flush();
     tsp->info(u"%'d PCR OK, %'d with jitter > %'d (%'d micro-seconds), %'d unchecked",
               {_nb_pcr_ok, _nb_pcr_nok, _jitter_max,  _jitter_max / PCR_PER_MICRO_SEC, _nb_pcr_unchecked});
 
@@ -280,9 +284,12 @@ ts::ProcessorPlugin::Status ts::PCRVerifyPlugin::processPacket(TSPacket& pkt, bo
                 _nb_pcr_nok++;
                 // Jitter in bits at current bitrate
                 int64_t bit_jit = (ajit * bitrate) / SYSTEM_CLOCK_FREQ;
-                tsp->info(u"%sPID %d (0x%X), PCR jitter: %'d = %'d micro-seconds = %'d packets + %'d bytes + %'d bits",
-                          {_time_stamp ? (Time::CurrentLocalTime().format(Time::DATE | Time::TIME) + u", ") : u"",
-                           pid, pid, jit, ajit / PCR_PER_MICRO_SEC, bit_jit / (PKT_SIZE * 8), (bit_jit / 8) % PKT_SIZE, bit_jit % 8});
+                // Build the time stamp only when the message is not suppressed.
+                if (_log.allow(uint32_t(pid), Severity::Info)) {
+                    tsp->info(u"%sPID %d (0x%X), PCR jitter: %'d = %'d micro-seconds = %'d packets + %'d bytes + %'d bits",
+                              {_time_stamp ? (Time::CurrentLocalTime().format(Time::DATE | Time::TIME) + u", ") : u"",
+                               pid, pid, jit, ajit / PCR_PER_MICRO_SEC, bit_jit / (PKT_SIZE * 8), (bit_jit / 8) % PKT_SIZE, bit_jit % 8});
+                }
             }
         }
 
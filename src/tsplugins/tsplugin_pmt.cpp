@@ -32,10 +32,8 @@
 //
 //----------------------------------------------------------------------------
 
-#include "tsPlugin.h"
+#include "tsAbstractTablePlugin.h"
 #include "tsPluginRepository.h"
-#include "tsSectionDemux.h"
-#include "tsCyclingPacketizer.h"
 #include "tsService.h"
 #include "tsTables.h"
 #include "tsAudioLanguageOptions.h"
@@ -47,7 +45,7 @@ TSDUCK_SOURCE;
 //----------------------------------------------------------------------------
 
 namespace ts {
-    class PMTPlugin: public ProcessorPlugin, private TableHandlerInterface
+    class PMTPlugin: public AbstractTablePlugin
     {
     public:
         // Implementation of plugin API
@@ -70,8 +68,6 @@ namespace ts {
         };
 
         // PMTPlugin instance fields
-        bool                _abort;             // Error (service not found, etc)
-        bool                _ready;             // Ready to perform transformation
         Service             _service;           // Service of PMT to modify
         std::vector<PID>    _removed_pid;       // Set of PIDs to remove from PMT
         std::vector<DID>    _removed_desc;      // Set of descriptor tags to remove
@@ -81,9 +77,6 @@ namespace ts {
         uint16_t            _new_servid;        // New service id
         bool                _set_pcrpid;        // Set a new PCR PID
         PID                 _new_pcrpid;        // New PCR PID
-        bool                _incr_version;      // Increment table version
-        bool                _set_version;       // Set a new table version
-        uint8_t             _new_version;       // New table version
         PDS                 _pds;               // Private data specifier for removed descriptors
         bool                _add_stream_id;     // Add stream_identifier_descriptor on all components
         bool                _ac3_atsc2dvb;      // Modify AC-3 signaling from ATSC to DVB method
@@ -91,11 +84,11 @@ namespace ts {
         bool                _cleanup_priv_desc; // Remove private desc without preceding PDS desc
         DescriptorList      _add_descs;         // List of descriptors to add
         AudioLanguageOptionsVector _languages;  // Audio languages to set
-        SectionDemux        _demux;             // Section demux
-        CyclingPacketizer   _pzer;              // Packetizer for modified PMT
 
-        // Invoked by the demux when a complete table is available.
-        virtual void handleTable (SectionDemux&, const BinaryTable&) override;
+        // Implementation of AbstractTablePlugin.
+        virtual void modifyTable(BinaryTable&, bool&, bool&) override;
+        virtual void handleOtherTable(const BinaryTable&) override;
+        void processPMT(PMT&);
 
         // Inaccessible operations
         PMTPlugin() = delete;
@@ -113,9 +106,7 @@ TSPLUGIN_DECLARE_PROCESSOR(pmt, ts::PMTPlugin)
 //----------------------------------------------------------------------------
 
 ts::PMTPlugin::PMTPlugin(TSP* tsp_) :
-    ProcessorPlugin(tsp_, u"Perform various transformations on the PMT", u"[options]"),
-    _abort(false),
-    _ready(false),
+    AbstractTablePlugin(tsp_, u"Perform various transformations on the PMT", u"[options]", u"PMT"),
     _service(),
     _removed_pid(),
     _removed_desc(),
@@ -125,18 +116,13 @@ ts::PMTPlugin::PMTPlugin(TSP* tsp_) :
     _new_servid(0),
     _set_pcrpid(false),
     _new_pcrpid(PID_NULL),
-    _incr_version(false),
-    _set_version(false),
-    _new_version(0),
     _pds(0),
     _add_stream_id(false),
     _ac3_atsc2dvb(false),
     _eac3_atsc2dvb(false),
     _cleanup_priv_desc(false),
     _add_descs(),
-    _languages(),
-    _demux(this),
-    _pzer()
+    _languages()
 {
     option(u"ac3-atsc2dvb",                0);
     option(u"add-ca-descriptor",           0,  STRING, 0, UNLIMITED_COUNT);
@@ -145,7 +131,6 @@ ts::PMTPlugin::PMTPlugin(TSP* tsp_) :
     option(u"audio-language",              0,  STRING, 0, UNLIMITED_COUNT);
     option(u"cleanup-private-descriptors", 0);
     option(u"eac3-atsc2dvb",               0);
-    option(u"increment-version",           0);
     option(u"new-service-id",             'i', UINT16);
     option(u"move-pid",                   'm', STRING, 0, UNLIMITED_COUNT);
     option(u"pds",                         0,  UINT32);
@@ -154,7 +139,6 @@ ts::PMTPlugin::PMTPlugin(TSP* tsp_) :
     option(u"remove-descriptor",           0,  UINT8,  0, UNLIMITED_COUNT);
     option(u"remove-pid",                 'r', PIDVAL, 0, UNLIMITED_COUNT);
     option(u"service",                    's', STRING);
-    option(u"new-version",                'v', INTEGER, 0, 1, 0, 31);
 
     setHelp(u"Options:\n"
             u"\n"
@@ -258,22 +242,15 @@ ts::PMTPlugin::PMTPlugin(TSP* tsp_) :
 
 bool ts::PMTPlugin::start()
 {
-    _abort = false;
-    _ready = false;
     _service.clear();
     _added_pid.clear();
     _moved_pid.clear();
-    _demux.reset();
-    _pzer.reset();
 
     // Get option values
     _set_servid = present(u"new-service-id");
     _new_servid = intValue<uint16_t>(u"new-service-id");
     _set_pcrpid = present(u"pcr-pid");
     _new_pcrpid = intValue<PID>(u"pcr-pid");
-    _incr_version = present(u"increment-version");
-    _set_version = present(u"new-version");
-    _new_version = intValue<uint8_t>(u"new-version");
     _pds = intValue<PDS>(u"pds");
     _ac3_atsc2dvb = present(u"ac3-atsc2dvb");
     _eac3_atsc2dvb = present(u"eac3-atsc2dvb");
@@ -335,30 +312,29 @@ bool ts::PMTPlugin::start()
     }
 
     // Determine which PID we need to process
+    PIDSet pids;
     if (_service.hasPMTPID()) {
         // PMT PID directly known
-        _demux.addPID(_service.getPMTPID());
-        _pzer.setPID(_service.getPMTPID());
-        _ready = true;
+        pids.set(_service.getPMTPID());
     }
     else if (_service.hasName()) {
         // Need to filter the SDT to get the service id
-        _demux.addPID(PID_SDT);
+        pids.set(PID_SDT);
     }
     else {
         // Need to filter the PAT to get the PMT PID
-        _demux.addPID(PID_PAT);
+        pids.set(PID_PAT);
     }
-
+    startTables(_service.getPMTPID(), pids, false);
     return true;
 }
 
 
 //----------------------------------------------------------------------------
-// Invoked by the demux when a complete table is available.
+// Invoked when a table is available in another PID than the PMT PID.
 //----------------------------------------------------------------------------
 
-void ts::PMTPlugin::handleTable (SectionDemux& demux, const BinaryTable& table)
+void ts::PMTPlugin::handleOtherTable(const BinaryTable& table)
 {
     switch (table.tableId()) {
 
@@ -372,14 +348,14 @@ void ts::PMTPlugin::handleTable (SectionDemux& demux, const BinaryTable& table)
                 // Look for the service by name
                 if (!sdt.findService (_service)) {
                     tsp->error(u"service \"%s\" not found in SDT", {_service.getName()});
-                    _abort = true;
+                    abortTables();
                     return;
                 }
                 tsp->verbose(u"found service \"%s\", service id is 0x%04X", {_service.getName(), _service.getId()});
                 // No longer need to filter the SDT
-                _demux.removePID (PID_SDT);
+                removeDemuxPID(PID_SDT);
                 // Now filter the PAT to get the PMT PID
-                _demux.addPID (PID_PAT);
+                addDemuxPID(PID_PAT);
             }
             break;
         }
@@ -397,7 +373,7 @@ void ts::PMTPlugin::handleTable (SectionDemux& demux, const BinaryTable& table)
                     if (it == pat.pmts.end()) {
                         // Service not found, error
                         tsp->error(u"service id %d (0x%X) not found in PAT", {_service.getId(), _service.getId()});
-                        _abort = true;
+                        abortTables();
                         return;
                     }
                     _service.setPMTPID(it->second);
@@ -412,149 +388,157 @@ void ts::PMTPlugin::handleTable (SectionDemux& demux, const BinaryTable& table)
                 else {
                     // No service specified, no service in PAT, error
                     tsp->error(u"no service in PAT");
-                    _abort = true;
+                    abortTables();
                     return;
                 }
-                // Found PMT PID, now ready to process PMT
-                _demux.addPID(_service.getPMTPID());
-                _pzer.setPID(_service.getPMTPID());
-                _ready = true;
                 // No longer need to filter the PAT
-                _demux.removePID(PID_PAT);
+                removeDemuxPID(PID_PAT);
+                // Found PMT PID, now ready to process PMT
+                setTablePID(_service.getPMTPID());
             }
             break;
         }
 
-        case TID_PMT: {
-            // If not yet ready, skip it
-            if (!_ready) {
-                return;
-            }
-            // If a service id is specified, filter it
-            if (_service.hasId() && !_service.hasId(table.tableIdExtension())) {
-                return;
-            }
-            // Decode the PMT
-            PMT pmt(table);
-            if (!pmt.isValid()) {
-                return;
-            }
-            // Modify service id
-            if (_set_servid) {
-                pmt.service_id = _new_servid;
-            }
-            // Modify table version
-            if (_incr_version) {
-                pmt.version = (pmt.version + 1) & SVERSION_MASK;
-            }
-            else if (_set_version) {
-                pmt.version = _new_version;
-            }
-            // Modify PCR PID
-            if (_set_pcrpid) {
-                pmt.pcr_pid = _new_pcrpid;
-            }
-            // Modify audio languages
-            _languages.apply(pmt, *tsp);
-            // Add CA descriptors
-            pmt.descs.add(_add_descs);
-            // Remove components
-            for (std::vector<PID>::const_iterator it = _removed_pid.begin(); it != _removed_pid.end(); ++it) {
-                pmt.streams.erase(*it);
-            }
-            // Add new components
-            for (std::list<NewPID>::const_iterator it = _added_pid.begin(); it != _added_pid.end(); ++it) {
-                PMT::Stream& ps(pmt.streams[it->pid]);
-                ps.stream_type = it->stream_type;
-            }
-            // Change the PID of components
-            for (std::map<PID, PID>::const_iterator it = _moved_pid.begin(); it != _moved_pid.end(); ++it) {
-                // Check if component exists
-                if (it->first != it->second && pmt.streams.find(it->first) != pmt.streams.end()) {
-                    pmt.streams[it->second] = pmt.streams[it->first];
-                    pmt.streams.erase(it->first);
-                }
-            }
-            // Remove descriptors
-            for (std::vector<DID>::const_iterator it = _removed_desc.begin(); it != _removed_desc.end(); ++it) {
-                pmt.descs.removeByTag(*it, _pds);
-                for (PMT::StreamMap::iterator smi = pmt.streams.begin(); smi != pmt.streams.end(); ++smi) {
-                    smi->second.descs.removeByTag (*it, _pds);
+        default: {
+            break;
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Modify a table from the PMT PID.
+//----------------------------------------------------------------------------
+
+void ts::PMTPlugin::modifyTable(BinaryTable& table, bool& is_target, bool& reinsert)
+{
+    // If a service id is specified, filter it
+    if (table.tableId() != TID_PMT || (_service.hasId() && !_service.hasId(table.tableIdExtension()))) {
+        reinsert = false;
+        return;
+    }
+
+    // A new service id is directly set in the binary sections (table id extension).
+    if (_set_servid) {
+        table.setTableIdExtension(_new_servid);
+    }
+
+    // Other modifications need to deserialize the PMT.
+    if (_set_pcrpid || !_languages.empty() || _add_descs.count() > 0 || !_removed_pid.empty() || !_added_pid.empty() ||
+        !_moved_pid.empty() || !_removed_desc.empty() || _ac3_atsc2dvb || _eac3_atsc2dvb || _cleanup_priv_desc || _add_stream_id)
+    {
+        PMT pmt(table);
+        if (pmt.isValid()) {
+            processPMT(pmt);
+            pmt.serialize(table);
+        }
+        else {
+            reinsert = false;
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Apply the structural modifications on a PMT.
+//----------------------------------------------------------------------------
+
+void ts::PMTPlugin::processPMT(PMT& pmt)
+{
+    // Modify PCR PID
+    if (_set_pcrpid) {
+        pmt.pcr_pid = _new_pcrpid;
+    }
+    // Modify audio languages
+    _languages.apply(pmt, *tsp);
+    // Add CA descriptors
+    pmt.descs.add(_add_descs);
+    // Remove components
+    for (std::vector<PID>::const_iterator it = _removed_pid.begin(); it != _removed_pid.end(); ++it) {
+        pmt.streams.erase(*it);
+    }
+    // Add new components
+    for (std::list<NewPID>::const_iterator it = _added_pid.begin(); it != _added_pid.end(); ++it) {
+        PMT::Stream& ps(pmt.streams[it->pid]);
+        ps.stream_type = it->stream_type;
+    }
+    // Change the PID of components
+    for (std::map<PID, PID>::const_iterator it = _moved_pid.begin(); it != _moved_pid.end(); ++it) {
+        // Check if component exists
+        if (it->first != it->second && pmt.streams.find(it->first) != pmt.streams.end()) {
+            pmt.streams[it->second] = pmt.streams[it->first];
+            pmt.streams.erase(it->first);
+        }
+    }
+    // Remove descriptors
+    for (std::vector<DID>::const_iterator it = _removed_desc.begin(); it != _removed_desc.end(); ++it) {
+        pmt.descs.removeByTag(*it, _pds);
+        for (PMT::StreamMap::iterator smi = pmt.streams.begin(); smi != pmt.streams.end(); ++smi) {
+            smi->second.descs.removeByTag (*it, _pds);
+        }
+    }
+    // Modify AC-3 signaling from ATSC to DVB method
+    if (_ac3_atsc2dvb) {
+        for (PMT::StreamMap::iterator smi = pmt.streams.begin(); smi != pmt.streams.end(); ++smi) {
+            if (smi->second.stream_type == ST_AC3_AUDIO) {
+                smi->second.stream_type = ST_PES_PRIV;
+                if (smi->second.descs.search(DID_AC3) == smi->second.descs.count()) {
+                    // No AC-3_descriptor present in this component, add one.
+                    smi->second.descs.add(AC3Descriptor());
                 }
             }
-            // Modify AC-3 signaling from ATSC to DVB method
-            if (_ac3_atsc2dvb) {
-                for (PMT::StreamMap::iterator smi = pmt.streams.begin(); smi != pmt.streams.end(); ++smi) {
-                    if (smi->second.stream_type == ST_AC3_AUDIO) {
-                        smi->second.stream_type = ST_PES_PRIV;
-                        if (smi->second.descs.search(DID_AC3) == smi->second.descs.count()) {
-                            // No AC-3_descriptor present in this component, add one.
-                            smi->second.descs.add(AC3Descriptor());
-                        }
-                    }
+        }
+    }
+    // Modify Enhanced-AC-3 signaling from ATSC to DVB method
+    if (_eac3_atsc2dvb) {
+        for (PMT::StreamMap::iterator smi = pmt.streams.begin(); smi != pmt.streams.end(); ++smi) {
+            if (smi->second.stream_type == ST_EAC3_AUDIO) {
+                smi->second.stream_type = ST_PES_PRIV;
+                if (smi->second.descs.search (DID_ENHANCED_AC3) == smi->second.descs.count()) {
+                    // No enhanced_AC-3_descriptor present in this component, add one.
+                    smi->second.descs.add(EnhancedAC3Descriptor());
                 }
             }
-            // Modify Enhanced-AC-3 signaling from ATSC to DVB method
-            if (_eac3_atsc2dvb) {
-                for (PMT::StreamMap::iterator smi = pmt.streams.begin(); smi != pmt.streams.end(); ++smi) {
-                    if (smi->second.stream_type == ST_EAC3_AUDIO) {
-                        smi->second.stream_type = ST_PES_PRIV;
-                        if (smi->second.descs.search (DID_ENHANCED_AC3) == smi->second.descs.count()) {
-                            // No enhanced_AC-3_descriptor present in this component, add one.
-                            smi->second.descs.add(EnhancedAC3Descriptor());
-                        }
-                    }
+        }
+    }
+    // Remove private descriptors without preceding PDS descriptor
+    if (_cleanup_priv_desc) {
+        pmt.descs.removeInvalidPrivateDescriptors();
+        for (PMT::StreamMap::iterator smi = pmt.streams.begin(); smi != pmt.streams.end(); ++smi) {
+            smi->second.descs.removeInvalidPrivateDescriptors();
+        }
+    }
+    // Add stream_identifier_descriptor on all components.
+    if (_add_stream_id) {
+        // First, look for existing descriptors, collect component tags.
+        std::bitset<256> ctags;
+        for (PMT::StreamMap::iterator smi = pmt.streams.begin(); smi != pmt.streams.end(); ++smi) {
+            const DescriptorList& dlist(smi->second.descs);
+            for (size_t i = dlist.search(DID_STREAM_ID); i < dlist.count(); i = dlist.search(DID_STREAM_ID, i + 1)) {
+                const StreamIdentifierDescriptor sid(*dlist[i]);
+                if (sid.isValid()) {
+                    ctags.set(sid.component_tag);
                 }
             }
-            // Remove private descriptors without preceding PDS descriptor
-            if (_cleanup_priv_desc) {
-                pmt.descs.removeInvalidPrivateDescriptors();
-                for (PMT::StreamMap::iterator smi = pmt.streams.begin(); smi != pmt.streams.end(); ++smi) {
-                    smi->second.descs.removeInvalidPrivateDescriptors();
-                }
+        }
+        // Then, add a stream_identifier_descriptor on all components
+        for (PMT::StreamMap::iterator smi = pmt.streams.begin(); smi != pmt.streams.end(); ++smi) {
+            DescriptorList& dlist(smi->second.descs);
+            // Skip components already containing a stream_identifier_descriptor
+            if (dlist.search(DID_STREAM_ID) < dlist.count()) {
+                continue;
             }
-            // Add stream_identifier_descriptor on all components.
-            if (_add_stream_id) {
-                // First, look for existing descriptors, collect component tags.
-                std::bitset<256> ctags;
-                for (PMT::StreamMap::iterator smi = pmt.streams.begin(); smi != pmt.streams.end(); ++smi) {
-                    const DescriptorList& dlist(smi->second.descs);
-                    for (size_t i = dlist.search(DID_STREAM_ID); i < dlist.count(); i = dlist.search(DID_STREAM_ID, i + 1)) {
-                        const StreamIdentifierDescriptor sid(*dlist[i]);
-                        if (sid.isValid()) {
-                            ctags.set(sid.component_tag);
-                        }
-                    }
-                }
-                // Then, add a stream_identifier_descriptor on all components
-                for (PMT::StreamMap::iterator smi = pmt.streams.begin(); smi != pmt.streams.end(); ++smi) {
-                    DescriptorList& dlist(smi->second.descs);
-                    // Skip components already containing a stream_identifier_descriptor
-                    if (dlist.search(DID_STREAM_ID) < dlist.count()) {
-                        continue;
-                    }
-                    // Allocate a new component tag
-                    StreamIdentifierDescriptor sid;
-                    for (size_t i = 0; i < ctags.size(); i++) {
-                        if (!ctags.test(i)) {
-                            sid.component_tag = uint8_t(i);
-                            ctags.set(i);
-                            break;
-                        }
-                    }
-                    // Add the stream_identifier_descriptor in the component
-                    dlist.add(sid);
+            // Allocate a new component tag
+            StreamIdentifierDescriptor sid;
+            for (size_t i = 0; i < ctags.size(); i++) {
+                if (!ctags.test(i)) {
+                    sid.component_tag = uint8_t(i);
+                    ctags.set(i);
+                    break;
                 }
             }
-            // Place modified PMT in the packetizer
-            tsp->verbose(u"PMT version %d modified", {pmt.version});
-            _pzer.removeSections(TID_PMT, pmt.service_id);
-            _pzer.addTable(pmt);
-            break;
-        }
-
-        default: {
-            break;
+            // Add the stream_identifier_descriptor in the component
+            dlist.add(sid);
         }
     }
 }
@@ -566,23 +550,9 @@ void ts::PMTPlugin::handleTable (SectionDemux& demux, const BinaryTable& table)
 
 ts::ProcessorPlugin::Status ts::PMTPlugin::processPacket(TSPacket& pkt, bool& flush, bool& bitrate_changed)
 {
-    // Filter interesting sections
-    _demux.feedPacket(pkt);
-
-    // If a fatal error occured during section analysis, give up.
-    if (_abort) {
-        return TSP_END;
-    }
+    const Status status = AbstractTablePlugin::processPacket(pkt, flush, bitrate_changed);
 
     // While not ready (ie. don't know which PID to modify), drop all packets
     // to avoid transmitting partial unmodified table.
-    if (!_ready) {
-        return TSP_DROP;
-    }
-
-    // Replace packets in PMT PID using packetizer
-    if (_service.hasPMTPID(pkt.getPID())) {
-        _pzer.getNextPacket(pkt);
-    }
-    return TSP_OK;
+    return status == TSP_OK && tablePID() == PID_NULL ? TSP_DROP : status;
 }
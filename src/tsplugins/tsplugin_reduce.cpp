@@ -28,14 +28,22 @@
 //----------------------------------------------------------------------------
 //
 //  Transport stream processor shared library:
-//  Reduce the bitrate of the TS by dropping null packets.
+//  Reduce the bitrate of the TS by dropping null packets or thinning
+//  lower-priority PID's.
 //
 //----------------------------------------------------------------------------
 
 #include "tsPlugin.h"
 #include "tsPluginRepository.h"
+#include "tsInjectionScheduler.h"
+#include "tsMemoryUtils.h"
 TSDUCK_SOURCE;
 
+namespace {
+    // Credit of one packet, in bits x SYSTEM_CLOCK_FREQ.
+    const int64_t PACKET_CREDIT = int64_t(ts::PKT_SIZE) * 8 * ts::SYSTEM_CLOCK_FREQ;
+}
+
 
 //----------------------------------------------------------------------------
 // Plugin definition
@@ -48,13 +56,40 @@ namespace ts {
         // Implementation of plugin API
         ReducePlugin(TSP*);
         virtual bool start() override;
+        virtual bool stop() override;
+        virtual BitRate getBitrate() override;
         virtual Status processPacket(TSPacket&, bool&, bool&) override;
 
     private:
-        int _opt_rempkt;  // rempkt parameter
-        int _opt_inpkt;   // inpkt parameter
-        int _in_count;    // Input packet count (0 to inpkt)
-        int _rem_count;   // Current number of packets to remove
+        // Drop priorities, in the order of packets to drop first.
+        enum {
+            LEVEL_NULL,      // Null packets.
+            LEVEL_EIT,       // EIT schedule sections.
+            LEVEL_DATA,      // Lower-priority PID's.
+            LEVEL_COUNT,
+            LEVEL_NONE = LEVEL_COUNT
+        };
+
+        int           _opt_rempkt;       // rempkt parameter
+        int           _opt_inpkt;        // inpkt parameter
+        int           _in_count;         // Input packet count (0 to inpkt)
+        int           _rem_count;        // Current number of packets to remove
+        BitRate       _target;           // Target bitrate, zero in fixed proportion mode
+        bool          _eit_schedule;     // Thin EIT schedule sections
+        PIDSet        _thin_pids;        // Lower-priority PID's which can be thinned
+        int64_t       _tolerance;        // Tolerance in packets before thinning
+        InjectionScheduler _clock;       // Time of input packets, from PCR's or input bitrate
+        int64_t       _credit;           // Output credit, in bits x SYSTEM_CLOCK_FREQ
+        bool          _unknown_time;     // Time of packets is currently unknown
+        PacketCounter _dropped[LEVEL_COUNT];  // Number of dropped packets per level
+        bool          _thinning[PID_MAX];     // Currently dropping a unit on this PID
+        uint8_t       _cc_shift[PID_MAX];     // Continuity counter adjustment per PID
+
+        // Target bitrate mode.
+        Status processTarget(TSPacket&);
+
+        // Get the drop level of the unit which starts in a packet.
+        int unitLevel(const TSPacket&) const;
 
         // Inaccessible operations
         ReducePlugin() = delete;
@@ -72,13 +107,27 @@ TSPLUGIN_DECLARE_PROCESSOR(reduce, ts::ReducePlugin)
 //----------------------------------------------------------------------------
 
 ts::ReducePlugin::ReducePlugin(TSP* tsp_) :
-    ProcessorPlugin(tsp_, u"Reduce the TS bitrate by removing stuffing packets.", u"[options] rempkt inpkt"),
+    ProcessorPlugin(tsp_, u"Reduce the TS bitrate by removing stuffing packets or lower-priority packets.", u"[options] [rempkt inpkt]"),
     _opt_rempkt(0),
     _opt_inpkt(0),
     _in_count(0),
-    _rem_count(0)
+    _rem_count(0),
+    _target(0),
+    _eit_schedule(false),
+    _thin_pids(),
+    _tolerance(0),
+    _clock(),
+    _credit(0),
+    _unknown_time(false),
+    _dropped(),
+    _thinning(),
+    _cc_shift()
 {
-    option(u"", 0, POSITIVE, 2, 2);
+    option(u"",               0,  POSITIVE, 0, 2);
+    option(u"eit-schedule",  'e');
+    option(u"pid",           'p', PIDVAL, 0, UNLIMITED_COUNT);
+    option(u"target-bitrate", 't', POSITIVE);
+    option(u"tolerance",      0,  POSITIVE);
 
     setHelp(u"Parameters:\n"
             u"\n"
@@ -86,12 +135,41 @@ ts::ReducePlugin::ReducePlugin(TSP* tsp_) :
             u"  removed after every <inpkt> input TS packets in the transport stream.\n"
             u"  Only stuffing packets can be removed.\n"
             u"  Both <rempkt> and <inpkt> must be non-zero integer values.\n"
+            u"  The parameters are required, unless --target-bitrate is specified.\n"
             u"\n"
             u"Options:\n"
             u"\n"
+            u"  -e\n"
+            u"  --eit-schedule\n"
+            u"      With --target-bitrate, when removing stuffing packets is not sufficient,\n"
+            u"      remove complete EIT schedule sections.\n"
+            u"\n"
             u"  --help\n"
             u"      Display this help text.\n"
             u"\n"
+            u"  -p value\n"
+            u"  --pid value\n"
+            u"      With --target-bitrate, specify a lower-priority PID which can be thinned\n"
+            u"      when removing stuffing packets and EIT schedule sections is not\n"
+            u"      sufficient. Complete PES packets or sections are removed, starting at\n"
+            u"      a packet with the payload unit start indicator. Several --pid options\n"
+            u"      may be specified.\n"
+            u"\n"
+            u"  -t value\n"
+            u"  --target-bitrate value\n"
+            u"      Reduce the transport stream to the specified bitrate in bits/second,\n"
+            u"      based on a running estimate of the input bitrate from the PCR's of the\n"
+            u"      first PCR PID, or the tsp input bitrate when no PCR is found. Stuffing\n"
+            u"      packets are removed first. Then, EIT schedule sections (see\n"
+            u"      --eit-schedule) and lower-priority PID's (see --pid) are thinned when\n"
+            u"      the output is late by more than the tolerance and twice the tolerance\n"
+            u"      respectively. The continuity counters of the thinned PID's are adjusted.\n"
+            u"\n"
+            u"  --tolerance value\n"
+            u"      With --target-bitrate, specify the number of packets in excess of the\n"
+            u"      target bitrate which are tolerated before thinning lower-priority\n"
+            u"      packets. The default is 200 packets.\n"
+            u"\n"
             u"  --version\n"
             u"      Display the version number.\n");
 }
@@ -105,19 +183,67 @@ bool ts::ReducePlugin::start()
 {
     _opt_rempkt = intValue(u"", 0, 0);
     _opt_inpkt = intValue(u"", 0, 1);
+    _target = intValue<BitRate>(u"target-bitrate", 0);
+    _eit_schedule = present(u"eit-schedule");
+    getPIDSet(_thin_pids, u"pid");
+    _tolerance = intValue<int64_t>(u"tolerance", 200);
+
+    if (_target == 0 && count(u"") != 2) {
+        tsp->error(u"specify either <rempkt> and <inpkt> or --target-bitrate");
+        return false;
+    }
+    if (_target != 0 && count(u"") != 0) {
+        tsp->error(u"<rempkt> and <inpkt> cannot be used with --target-bitrate");
+        return false;
+    }
+
     _in_count = 0;
     _rem_count = 0;
-    tsp->debug(u"rempkt = %d, inpkt = %d", {_opt_rempkt, _opt_inpkt});
+    _clock.reset();
+    _credit = 0;
+    _unknown_time = false;
+    TS_ZERO(_dropped);
+    TS_ZERO(_thinning);
+    TS_ZERO(_cc_shift);
+    tsp->debug(u"rempkt = %d, inpkt = %d, target = %'d b/s", {_opt_rempkt, _opt_inpkt, _target});
     return true;
 }
 
 
+//----------------------------------------------------------------------------
+// Stop method
+//----------------------------------------------------------------------------
+
+bool ts::ReducePlugin::stop()
+{
+    if (_target != 0) {
+        tsp->verbose(u"removed %'d null packets, %'d EIT packets, %'d packets on lower-priority PID's",
+                     {_dropped[LEVEL_NULL], _dropped[LEVEL_EIT], _dropped[LEVEL_DATA]});
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Get the output bitrate.
+//----------------------------------------------------------------------------
+
+ts::BitRate ts::ReducePlugin::getBitrate()
+{
+    return _target;
+}
+
+
 //----------------------------------------------------------------------------
 // Packet processing method
 //----------------------------------------------------------------------------
 
 ts::ProcessorPlugin::Status ts::ReducePlugin::processPacket (TSPacket& pkt, bool& flush, bool& bitrate_changed)
 {
+    if (_target != 0) {
+        return processTarget(pkt);
+    }
+
     assert (_rem_count >= 0);
     assert (_in_count >= 0);
     assert (_in_count <= _opt_inpkt);
@@ -142,3 +268,90 @@ ts::ProcessorPlugin::Status ts::ReducePlugin::processPacket (TSPacket& pkt, bool
         return TSP_OK;
     }
 }
+
+
+//----------------------------------------------------------------------------
+// Get the drop level of the unit which starts in a packet.
+//----------------------------------------------------------------------------
+
+int ts::ReducePlugin::unitLevel(const TSPacket& pkt) const
+{
+    const PID pid = pkt.getPID();
+    if (pid == PID_NULL) {
+        return LEVEL_NULL;
+    }
+    else if (!pkt.getPUSI() || !pkt.hasPayload()) {
+        return LEVEL_NONE;
+    }
+    else if (_eit_schedule && pid == PID_EIT) {
+        // A section must start at the beginning of the payload (pointer field is zero),
+        // otherwise the end of the previous section would be removed.
+        const size_t hsize = pkt.getHeaderSize();
+        if (hsize + 1 < PKT_SIZE && pkt.b[hsize] == 0 && pkt.b[hsize + 1] >= TID_EIT_S_ACT_MIN && pkt.b[hsize + 1] <= TID_EIT_S_OTH_MAX) {
+            return LEVEL_EIT;
+        }
+    }
+    return _thin_pids.test(pid) ? int(LEVEL_DATA) : int(LEVEL_NONE);
+}
+
+
+//----------------------------------------------------------------------------
+// Target bitrate mode.
+//----------------------------------------------------------------------------
+
+ts::ProcessorPlugin::Status ts::ReducePlugin::processTarget(TSPacket& pkt)
+{
+    // Running estimate of the packet time, from the PCR's or, until two PCR's are found, the input bitrate.
+    const uint64_t previous = _clock.currentTime();
+    _clock.setTSBitRate(tsp->bitrate());
+    _clock.feedPacket(pkt);
+    if (!_clock.timeKnown()) {
+        if (!_unknown_time) {
+            tsp->warning(u"unknown input bitrate, packets are not removed");
+            _unknown_time = true;
+        }
+        return TSP_OK;
+    }
+    _unknown_time = false;
+
+    // The output credit grows with the time at the target bitrate, each output packet consumes one packet credit.
+    // When the credit is negative, the output is late by -credit/PACKET_CREDIT packets.
+    _credit += int64_t(_clock.currentTime() - previous) * int64_t(_target);
+    const PID pid = pkt.getPID();
+    int level = LEVEL_NONE;
+
+    if (_thinning[pid]) {
+        // Continue to drop the current unit on this PID, until the next unit start.
+        if (pkt.getPUSI()) {
+            _thinning[pid] = false;
+        }
+        else {
+            level = pid == PID_EIT ? LEVEL_EIT : LEVEL_DATA;
+        }
+    }
+    if (level == LEVEL_NONE) {
+        // Drop the unit if the output is late enough for its level.
+        const int unit = unitLevel(pkt);
+        if (unit != LEVEL_NONE && _credit < -PACKET_CREDIT * _tolerance * unit) {
+            level = unit;
+            _thinning[pid] = level != LEVEL_NULL;
+        }
+    }
+
+    if (level != LEVEL_NONE) {
+        _dropped[level]++;
+        if (level != LEVEL_NULL && pkt.hasPayload()) {
+            _cc_shift[pid] = (_cc_shift[pid] + 1) & CC_MASK;
+        }
+        return TSP_DROP;
+    }
+
+    // Packet is kept. Adjust the continuity counter after removed packets.
+    if (_cc_shift[pid] != 0) {
+        pkt.setCC((pkt.getCC() - _cc_shift[pid]) & CC_MASK);
+    }
+
+    // Limit the accumulated credit when the input is below the target bitrate.
+    _credit = std::min(_credit - PACKET_CREDIT, PACKET_CREDIT * _tolerance);
+    return TSP_OK;
+}
@@ -34,7 +34,7 @@
 
 #include "tsPlugin.h"
 #include "tsPluginRepository.h"
-#include "tsMonotonic.h"
+#include "tsPacketRegulator.h"
 TSDUCK_SOURCE;
 
 #define DEF_PACKET_BURST 16
@@ -51,31 +51,16 @@ namespace ts {
         // Implementation of plugin API
         RegulatePlugin(TSP*);
         virtual bool start() override;
+        virtual bool stop() override;
         virtual Status processPacket(TSPacket&, bool&, bool&) override;
 
     private:
-        // Regulation state
-        enum State {INITIAL, REGULATED, UNREGULATED};
-
-        // Private members
-        State         _state;           // Current regulation state
-        BitRate       _opt_bitrate;     // Bitrate option, zero means use input
-        BitRate       _cur_bitrate;     // Current bitrate
-        PacketCounter _opt_burst;       // Number of packets to burst at a time
-        PacketCounter _burst_pkt_max;   // Total packets in current burst
-        PacketCounter _burst_pkt_cnt;   // Countdown of packets in current burst
-        NanoSecond    _burst_min;       // Minimum delay between two bursts (ns)
-        NanoSecond    _burst_duration;  // Delay between two bursts (nano-seconds)
-        Monotonic     _burst_end;       // End of current burst
-        Monotonic     _bitrate_start;   // Time of last bitrate change
-        PacketCounter _bitrate_pkt_cnt; // Passed packets since last bitrate change
-
-        // Compute burst duration (_burst_duration and _burst_pkt_max), based on
-        // required packets/burst (command line option) and current bitrate.
-        void handleNewBitrate();
-
-        // Process one packet in a regulated burst. Wait at end of burst.
-        Status regulatePacket(bool& flush, bool smoothen);
+        bool            _pcr_sync;    // Regulate on PCR's.
+        bool            _offline;     // tsp runs in offline mode, do not regulate.
+        bool            _initial;     // Before first packet.
+        bool            _regulated;   // Last packet was regulated.
+        BitRate         _cur_bitrate; // Current bitrate.
+        PacketRegulator _regulator;   // Regulation engine.
 
         // Inaccessible operations
         RegulatePlugin() = delete;
@@ -94,25 +79,30 @@ TSPLUGIN_DECLARE_PROCESSOR(regulate, ts::RegulatePlugin)
 
 ts::RegulatePlugin::RegulatePlugin(TSP* tsp_) :
     ProcessorPlugin(tsp_, u"Regulate the TS packets flow to a specified bitrate.", u"[options]"),
-    _state(INITIAL),
-    _opt_bitrate(0),
+    _pcr_sync(false),
+    _offline(false),
+    _initial(true),
+    _regulated(false),
     _cur_bitrate(0),
-    _opt_burst(0),
-    _burst_pkt_max(0),
-    _burst_pkt_cnt(0),
-    _burst_min(0),
-    _burst_duration(0),
-    _burst_end(),
-    _bitrate_start(),
-    _bitrate_pkt_cnt(0)
+    _regulator()
 {
-    option(u"bitrate",      'b', POSITIVE);
-    option(u"packet-burst", 'p', POSITIVE);
+    option(u"bitrate",         'b', POSITIVE);
+    option(u"packet-burst",    'p', POSITIVE);
+    option(u"pcr-synchronous",  0);
+    option(u"pid-pcr",          0,  PIDVAL);
+    option(u"spin",             0,  UNSIGNED);
 
     setHelp(u"Regulate (slow down only) the TS packets flow according to a specified\n"
             u"bitrate. Useful to play a non-regulated input (such as a TS file) to a\n"
             u"non-regulated output device such as IP multicast.\n"
             u"\n"
+            u"Each burst of packets is released at its absolute due time, using the\n"
+            u"monotonic clock of the system. In verbose mode, the measured output jitter\n"
+            u"(lateness of the bursts) is reported at the end.\n"
+            u"\n"
+            u"When tsp runs in offline mode (option --offline), the packets are passed\n"
+            u"without regulation.\n"
+            u"\n"
             u"Options:\n"
             u"\n"
             u"  -b value\n"
@@ -126,8 +116,23 @@ ts::RegulatePlugin::RegulatePlugin(TSP* tsp_) :
             u"  -p value\n"
             u"  --packet-burst value\n"
             u"      Number of packets to burst at a time. Does not modify the average\n"
-            u"      output bitrate but influence smoothing and CPU load. The default\n"
-            u"      is " TS_STRINGIFY(DEF_PACKET_BURST) u" packets.\n"
+            u"      output bitrate but influence smoothing and CPU load. Use 1 for a\n"
+            u"      packet-by-packet regulation. The default is " TS_STRINGIFY(DEF_PACKET_BURST) u" packets.\n"
+            u"\n"
+            u"  --pcr-synchronous\n"
+            u"      Regulate the flow according to the PCR's of the stream instead of a\n"
+            u"      constant bitrate. This preserves the instantaneous bitrate of a variable\n"
+            u"      bitrate stream. The bitrate is used until two PCR's are found.\n"
+            u"\n"
+            u"  --pid-pcr value\n"
+            u"      With --pcr-synchronous, specify the reference PID for PCR's. By default,\n"
+            u"      use the first PID containing PCR's.\n"
+            u"\n"
+            u"  --spin value\n"
+            u"      Spin on the system clock during the last microseconds before the due\n"
+            u"      time of each burst instead of sleeping. This reduces the output jitter\n"
+            u"      which results from the wake-up latency of the system but uses more CPU.\n"
+            u"      The value is in microseconds. The default is zero (always sleep).\n"
             u"\n"
             u"  --version\n"
             u"      Display the version number.\n");
@@ -141,95 +146,40 @@ ts::RegulatePlugin::RegulatePlugin(TSP* tsp_) :
 bool ts::RegulatePlugin::start()
 {
     // Get command line arguments
-    _opt_bitrate = intValue<BitRate>(u"bitrate", 0);
-    _opt_burst = intValue<PacketCounter>(u"packet-burst", DEF_PACKET_BURST);
-
-    // Compute the minimum delay between two bursts, in nano-seconds.
-    // This is a limitation of the operating system. If we try to use
-    // wait on durations lower than the minimum, this will introduce
-    // latencies which mess up the regulation. We try to request 2
-    // milliseconds as time precision and we keep what the operating
-    // system gives.
-
-    _burst_min = Monotonic::SetPrecision(2000000); // 2 milliseconds in nanoseconds
+    _pcr_sync = present(u"pcr-synchronous");
+    _offline = tsp->offline();
+    if (_offline) {
+        tsp->verbose(u"offline mode, no regulation");
+    }
+    _regulator.setBitRate(intValue<BitRate>(u"bitrate", 0));
+    _regulator.setBurst(intValue<PacketCounter>(u"packet-burst", DEF_PACKET_BURST));
+    _regulator.setPCRSynchronous(_pcr_sync, intValue<PID>(u"pid-pcr", PID_NULL));
+    _regulator.setSpinThreshold(intValue<NanoSecond>(u"spin", 0) * NanoSecPerMicroSec);
 
-    tsp->verbose(u"minimum packet burst duration is %'d nano-seconds", {_burst_min});
+    // Request the best timer precision from the operating system (effective on Windows only).
+    Monotonic::SetPrecision(NanoSecPerMilliSec);
 
     // Reset state
-    _state = INITIAL;
+    _regulator.reset();
+    _initial = true;
+    _regulated = false;
     _cur_bitrate = 0;
-    _burst_pkt_max = 0;
-    _burst_pkt_cnt = 0;
-    _burst_duration = 0;
 
     return true;
 }
 
 
 //----------------------------------------------------------------------------
-// Handle bitrate change, compute burst duration.
-//----------------------------------------------------------------------------
-
-void ts::RegulatePlugin::handleNewBitrate()
-{
-    // Assume that the packets/burst is the one specified on the command line.
-    _burst_pkt_max = _opt_burst;
-
-    // Compute corresponding duration (in nano-seconds) between two bursts.
-    assert(_cur_bitrate > 0);
-    _burst_duration = (NanoSecPerSec * PKT_SIZE * 8 * _burst_pkt_max) / _cur_bitrate;
-
-    // If the result is too small for the time precision of the operating
-    // system, recompute a larger burst duration
-    if (_burst_duration < _burst_min) {
-        _burst_duration = _burst_min;
-        _burst_pkt_max = (_burst_duration * _cur_bitrate) / (NanoSecPerSec * PKT_SIZE * 8);
-    }
-
-    tsp->debug(u"new regulation, burst: %'d nano-seconds, %'d packets", {_burst_duration, _burst_pkt_max});
-    
-    // Register start of bitrate sequence.
-    _bitrate_pkt_cnt = 0;
-    _bitrate_start.getSystemTime();
-}
-
-
-//----------------------------------------------------------------------------
-// Process one packet in a regulated burst. Wait at end of burst.
+// Stop method
 //----------------------------------------------------------------------------
 
-ts::ProcessorPlugin::Status ts::RegulatePlugin::regulatePacket(bool& flush, bool smoothen)
+bool ts::RegulatePlugin::stop()
 {
-    // Check if end of current burst. Take care, _burst_pkt_cnt may be already zero.
-    if ((_burst_pkt_cnt == 0 || --_burst_pkt_cnt == 0) && smoothen && _bitrate_pkt_cnt > 0) {
-        // In the middle of a sequence with same bitrate, we try to smoothen the regulation.
-        // Because of rounding, we tend to pass slightly less packets than requested.
-        // See if we need to add some packets from time to time.
-        Monotonic now;
-        now.getSystemTime();
-        // Number of packets we should have passed since beginning of sequence of this bitrate:
-        const PacketCounter expected = PacketDistance(_cur_bitrate, (now - _bitrate_start) / NanoSecPerMilliSec);
-        if (expected > _bitrate_pkt_cnt) {
-            // We should have passed more than we did, increase this burst size.
-            _burst_pkt_cnt = expected - _bitrate_pkt_cnt;
-        }
-    }
-
-    // Recheck end of burst, just in case we added some more packets to smoothen.
-    if (_burst_pkt_cnt == 0) {
-        // Wait until scheduled end of burst.
-        _burst_end.wait();
-        // Restart a new burst, use monotonic time
-        _burst_pkt_cnt = _burst_pkt_max;
-        _burst_end += _burst_duration;
-        // Flush current burst
-        flush = true;
+    if (!_offline) {
+        tsp->verbose(u"output jitter: mean %'d ns, max %'d ns, %'d bursts, %'d resynchronizations",
+                     {_regulator.meanJitter(), _regulator.maxJitter(), _regulator.burstCount(), _regulator.resyncCount()});
     }
-
-    // One more regulated packet at this bitrate.
-    _bitrate_pkt_cnt++;
-
-    return TSP_OK;
+    return true;
 }
 
 
@@ -239,114 +189,30 @@ ts::ProcessorPlugin::Status ts::RegulatePlugin::regulatePacket(bool& flush, bool
 
 ts::ProcessorPlugin::Status ts::RegulatePlugin::processPacket(TSPacket& pkt, bool& flush, bool& bitrate_changed)
 {
-    // Compute old and new bitrate (most often the same)
-    BitRate old_bitrate = _cur_bitrate;
-    _cur_bitrate = _opt_bitrate != 0 ? _opt_bitrate : tsp->bitrate();
-
-    if (tsp->verbose() && (_cur_bitrate != old_bitrate || _state == INITIAL)) {
-        // Initial state or new bitrate
-        if (_cur_bitrate == 0) {
-            tsp->verbose(u"unknown bitrate, cannot regulate.");
-        }
-        else {
-            tsp->verbose(u"regulated at bitrate %'d b/s", {_cur_bitrate});
-        }
+    if (_offline) {
+        return TSP_OK;
     }
 
-    // Process with state machine
-    switch (_state) {
+    const bool was_regulated = _regulated;
+    _regulated = _regulator.regulate(pkt, tsp->bitrate(), flush);
 
-        case INITIAL: {
-            // Initial state, will become either regulated or unregulated
-            if (_cur_bitrate == 0) {
-                // No bitrate -> unregulated
-                _state = UNREGULATED;
-                return TSP_OK; // transmit without regulation
-            }
-            else {
-                // Got a non-zero bitrate -> start regulation
-                _state = REGULATED;
-                // Compute initial burst duration: first, compute burst time
-                handleNewBitrate();
-                // Get initial clock
-                _burst_end.getSystemTime();
-                // Compute end time of next burst
-                _burst_end += _burst_duration;
-                // We are at the start of the burst, initialize countdown
-                _burst_pkt_cnt = _burst_pkt_max;
-                // Transmit first packet of burst
-                bitrate_changed = true;
-                return regulatePacket(flush, false);
-            }
-            break;
-        }
+    // Report regulation start and bitrate changes.
+    const BitRate old_bitrate = _cur_bitrate;
+    _cur_bitrate = _regulator.currentBitRate();
 
-        case UNREGULATED: {
-            // We had no bitrate, we did not regulate
-            if (_cur_bitrate == 0) {
-                // Still no bitrate, transmit without regulation, remain unregulated
-                return TSP_OK;
-            }
-            else {
-                // Finally got a bitrate.
-                // Transmit this one without regulation and flush.
-                // Will regulate next time, starting with empty (flushed) buffer.
-                _state = INITIAL;
-                bitrate_changed = true;
-                flush = true;
-                return TSP_OK;
-            }
-            break;
+    if (_regulated != was_regulated || (!_pcr_sync && _cur_bitrate != old_bitrate) || _initial) {
+        if (!_regulated) {
+            tsp->verbose(u"unknown bitrate, cannot regulate.");
         }
-
-        case REGULATED: {
-            // We previously had a bitrate and we regulated the flow.
-            if (_cur_bitrate == 0) {
-                // No more bitrate, become unregulated
-                _state = UNREGULATED;
-                return TSP_OK;
-            }
-            else if (_cur_bitrate == old_bitrate) {
-                // Still the same bitrate, continue to burst
-                return regulatePacket(flush, true);
-            }
-            else {
-                // Got a new non-zero bitrate. Compute new burst.
-                // Revert to start time of current burst, based on previous burst duration.
-                _burst_end -= _burst_duration;
-                // Compute the estimated due elapsed time in current burst, based on
-                // previous burst duration and proportion of passed packets.
-                const NanoSecond elapsed = _burst_duration - (_burst_duration * _burst_pkt_max) / _burst_pkt_cnt;
-                // Compute new burst duration, based on new bitrate
-                handleNewBitrate();
-                // Adjust end time of current burst. We want to close the current burst
-                // as soon as possible to restart based on new bitrate.
-                if (elapsed >= _burst_min) {
-                    // We already passed more packets that required for minimum delay.
-                    // Close current burst now.
-                    _burst_end += elapsed;
-                    _burst_pkt_cnt = 0;
-                }
-                else {
-                    // We have to wait a bit more to respect the minimum delay.
-                    // Compute haw many packets we should pass for the remaining time,
-                    // based on the new bitrate.
-                    _burst_end += _burst_min;
-                    _burst_pkt_cnt = ((_burst_min - elapsed) * _cur_bitrate) / (NanoSecPerSec * PKT_SIZE * 8);
-                }
-                // Report that the bitrate has changed
-                bitrate_changed = true;
-                return regulatePacket(flush, false);
-            }
-            break;
+        else if (_pcr_sync) {
+            tsp->verbose(u"regulated on PCR's");
         }
-
-        default: {
-            assert(false);
+        else {
+            tsp->verbose(u"regulated at bitrate %'d b/s", {_cur_bitrate});
         }
+        bitrate_changed = _regulated || was_regulated;
     }
 
-    // Should never get there...
-    tsp->error(u"internal error, invalid regulator state");
-    return TSP_END;
+    _initial = false;
+    return TSP_OK;
 }
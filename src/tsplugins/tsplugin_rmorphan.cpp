@@ -52,6 +52,7 @@ namespace ts {
         RMOrphanPlugin(TSP*);
         virtual bool start() override;
         virtual Status processPacket(TSPacket&, bool&, bool&) override;
+        virtual size_t processPacketBatch(const TSPacketView&, TSPacketMetadata*, size_t, Status*, bool&, bool&) override;
 
     private:
         Status        _drop_status; // Status for dropped packets
@@ -243,3 +244,28 @@ ts::ProcessorPlugin::Status ts::RMOrphanPlugin::processPacket (TSPacket& pkt, bo
     _demux.feedPacket (pkt);
     return _pass_pids [pkt.getPID()] ? TSP_OK : _drop_status;
 }
+
+
+//----------------------------------------------------------------------------
+// Batch packet processing method
+//----------------------------------------------------------------------------
+
+size_t ts::RMOrphanPlugin::processPacketBatch(const TSPacketView& pkts, TSPacketMetadata* mdata, size_t count, Status* status, bool& flush, bool& bitrate_changed)
+{
+    // Only the packets of the PSI PID's are passed to the demux, the demux packet counter is not used.
+    // The referenced PID's may be updated by the demux handler inside the loop.
+    for (size_t i = 0; i < count; ++i) {
+        if (pkts[i].b[0] == 0) {
+            // Packet already dropped by a previous processor.
+            status[i] = TSP_DROP;
+        }
+        else {
+            const PID pid = pkts[i].getPID();
+            if (_demux.hasPID(pid)) {
+                _demux.feedPacket(pkts[i]);
+            }
+            status[i] = _pass_pids.test(pid) ? TSP_OK : _drop_status;
+        }
+    }
+    return count;
+}
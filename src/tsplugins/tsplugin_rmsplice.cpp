@@ -49,6 +49,7 @@ namespace ts {
     class RMSplicePlugin:
             public ProcessorPlugin,
             private SectionHandlerInterface,
+            private SectionViewHandlerInterface,
             private PMTHandlerInterface
     {
     public:
@@ -129,8 +130,12 @@ namespace ts {
 
         // Implementation of interfaces.
         virtual void handleSection(SectionDemux& demux, const Section& section) override;
+        virtual void handleSectionView(SectionDemux& demux, const SectionView& section) override;
         virtual void handlePMT(const PMT& table) override;
 
+        // Process a splice insert command.
+        void processSpliceInsert(const SpliceInsert& cmd);
+
         // Inaccessible operations
         RMSplicePlugin() = delete;
         RMSplicePlugin(const RMSplicePlugin&) = delete;
@@ -158,6 +163,9 @@ ts::RMSplicePlugin::RMSplicePlugin(TSP* tsp_) :
     _tagsByPID(),
     _states()
 {
+    // Splice information sections which fit in one packet are decoded without building a Section object.
+    _demux.setSectionViewHandler(this);
+
     option(u"", 0, STRING, 0, 1);
     option(u"adjust-time", 'a');
     option(u"continue",    'c');
@@ -278,13 +286,39 @@ void ts::RMSplicePlugin::handlePMT(const PMT& pmt)
 
 void ts::RMSplicePlugin::handleSection(SectionDemux& demux, const Section& section)
 {
+    // Sections which are contained in one TS packet were already processed in handleSectionView().
+    if (section.getFirstTSPacketIndex() == section.getLastTSPacketIndex()) {
+        return;
+    }
+
     // Try to extract a SpliceInsert command from the section.
     SpliceInsert cmd;
-    if (!SpliceInfoTable::ExtractSpliceInsert(cmd, section)) {
-        // Not the right table or command, just ignore it.
-        return;
+    if (SpliceInfoTable::ExtractSpliceInsert(cmd, section)) {
+        processSpliceInsert(cmd);
     }
+}
+
+
+//----------------------------------------------------------------------------
+// Invoked by the demux when a splice information section is entirely
+// contained in one TS packet. Fast path, directly decode the section data.
+//----------------------------------------------------------------------------
 
+void ts::RMSplicePlugin::handleSectionView(SectionDemux& demux, const SectionView& section)
+{
+    SpliceInsert cmd;
+    if (SpliceInfoTable::ExtractSpliceInsert(cmd, section.content(), section.size())) {
+        processSpliceInsert(cmd);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Process a splice insert command.
+//----------------------------------------------------------------------------
+
+void ts::RMSplicePlugin::processSpliceInsert(const SpliceInsert& cmd)
+{
     // Either cancel or add the event.
     if (cmd.canceled) {
         // Cancel an identified splice event. Search and remove from all PID's.
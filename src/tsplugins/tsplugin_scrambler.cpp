@@ -35,7 +35,10 @@
 #include "tsPlugin.h"
 #include "tsPluginRepository.h"
 #include "tsScrambling.h"
+#include "tsScramblingBatch.h"
 #include "tsByteBlock.h"
+#include "tsMemoryUtils.h"
+#include "tsSafePtr.h"
 #include "tsService.h"
 #include "tsSectionDemux.h"
 #include "tsCyclingPacketizer.h"
@@ -103,10 +106,13 @@ namespace ts {
         virtual bool start() override;
         virtual bool stop() override;
         virtual Status processPacket(TSPacket&, bool&, bool&) override;
+        virtual size_t processPacketBatch(const TSPacketView&, TSPacketMetadata*, size_t, Status*, bool&, bool&) override;
 
     private:
+        class ServiceContext;
+
         // Description of a crypto-period.
-        // Each CryptoPeriod object points to its ScramblerPlugin parent object.
+        // Each CryptoPeriod object points to its ServiceContext parent object.
         // In case of error in a CryptoPeriod object, the _abort volatile flag
         // is set in ScramblerPlugin.
         class CryptoPeriod: private ECMGClientHandlerInterface
@@ -118,7 +124,7 @@ namespace ts {
             // Initialize first crypto period.
             // Generate two randow CW and corresponding ECM.
             // ECM generation may complete asynchronously.
-            void initCycle(ScramblerPlugin*, uint16_t cp_number);
+            void initCycle(ServiceContext*, uint16_t cp_number);
 
             // Initialize crypto period following specified one.
             // ECM generation may complete asynchronously.
@@ -137,7 +143,7 @@ namespace ts {
             uint8_t getScramblingControlValue() const { return uint8_t((_cp_number & 0x01) ? SC_ODD_KEY : SC_EVEN_KEY); }
 
         private:
-            ScramblerPlugin* _scrambler;      // Reference to scrambler plugin
+            ServiceContext*  _context;        // Reference to scrambled service
             uint16_t         _cp_number;      // Crypto-period number
             volatile bool    _ecm_ok;         // _ecm field is valid
             TSPacketVector   _ecm;            // Packetized ECM
@@ -158,8 +164,60 @@ namespace ts {
             CryptoPeriod& operator=(const CryptoPeriod&) = delete;
         };
 
+        // Description of a scrambled service.
+        // All services share the same demux, ECMG connection and packet pass.
+        // Each service has its own ECM stream, crypto-periods and control words.
+        class ServiceContext
+        {
+        public:
+            // Constructor.
+            ServiceContext(ScramblerPlugin* plugin, const UString& service, PID ecm_pid, uint16_t ecm_stream_id, uint16_t ecm_id);
+
+            ScramblerPlugin*  plugin;              // Parent plugin
+            Service           service;             // Service description
+            uint16_t          ecm_stream_id;       // ECM_stream_id for the ECMG
+            uint16_t          ecm_id;              // ECM_id for the ECMG
+            PID               ecm_pid;             // PID for ECM
+            uint8_t           ecm_cc;              // Continuity counter in ECM PID
+            bool              ready;               // PMT found, ready to scramble packets
+            bool              degraded_mode;       // In degraded mode (see comments above)
+            PacketCounter     partial_clear;       // How many clear packets to keep clear
+            PacketCounter     pkt_insert_ecm;      // Insertion point for next ECM packet
+            PacketCounter     pkt_change_cw;       // Transition point for next CW change
+            PacketCounter     pkt_change_ecm;      // Transition point for next ECM change
+            CyclingPacketizer pzer_pmt;            // Packetizer for modified PMT
+            CryptoPeriod      cp[2];               // Previous/current or current/next crypto-periods
+            size_t            current_cw;          // Index to current CW (current crypto period)
+            size_t            current_ecm;         // Index to current ECM (ECM being broadcast)
+            Scrambling        current_key;         // Preprocessed current control word
+
+            // Return current/next CryptoPeriod for CW or ECM
+            CryptoPeriod& currentCW()  {return cp[current_cw];}
+            CryptoPeriod& nextCW()     {return cp[(current_cw + 1) & 0x01];}
+            CryptoPeriod& currentECM() {return cp[current_ecm];}
+            CryptoPeriod& nextECM()    {return cp[(current_ecm + 1) & 0x01];}
+
+            // Perform CW and ECM transition
+            void changeCW();
+            void changeECM();
+
+            // Check if we are in degraded mode or if we enter degraded mode
+            bool inDegradedMode();
+
+            // Try to exit from degraded mode
+            void tryExitDegradedMode();
+
+        private:
+            // Inaccessible operations
+            ServiceContext() = delete;
+            ServiceContext(const ServiceContext&) = delete;
+            ServiceContext& operator=(const ServiceContext&) = delete;
+        };
+
+        typedef SafePtr<ServiceContext, NullMutex> ServiceContextPtr;
+        typedef std::vector<ServiceContextPtr> ServiceContextVector;
+
         // ScramblerPlugin parameters, remain constant after start()
-        Service           _service;            // Service description
         bool              _component_level;    // Insert CA_descriptors at component level
         bool              _use_fixed_key;      // Use a fixed control word
         bool              _scramble_audio;     // Scramble all audio components
@@ -174,58 +232,35 @@ namespace ts {
         MilliSecond       _cp_duration;        // Crypto-period duration
         MilliSecond       _delay_start;        // Delay between CP start and ECM start (can be negative)
         BitRate           _ecm_bitrate;        // ECM PID's bitrate
-        PID               _ecm_pid;            // PID for ECM
         PacketCounter     _partial_scrambling; // Do not scramble all packets if > 1
         Scrambling::EntropyMode _cw_mode;      // Entropy reduction
         ecmgscs::ChannelStatus  _channel_status; // Initial response to ECMG channel_setup
-        ecmgscs::StreamStatus   _stream_status;  // Initial response to ECMG stream_setup
 
         // ScramblerPlugin state
         volatile bool     _abort;              // Error (service not found, etc)
-        bool              _ready;              // Ready to transmit packets
-        bool              _degraded_mode;      // In degraded mode (see comments above)
+        bool              _ready;              // Ready to transmit packets (all services ready)
         PacketCounter     _packet_count;       // Complete TS packet counter
         PacketCounter     _scrambled_count;    // Summary of scrambled packets
-        PacketCounter     _partial_clear;      // How many clear packets to keep clear
-        PacketCounter     _pkt_insert_ecm;     // Insertion point for next ECM packet.
-        PacketCounter     _pkt_change_cw;      // Transition point for next CW change
-        PacketCounter     _pkt_change_ecm;     // Transition point for next ECM change
         BitRate           _ts_bitrate;         // Saved TS bitrate
+        ServiceContextVector _services;        // Scrambled services
         ECMGClient        _ecmg;               // Connection with the ECMG
-        uint8_t           _ecm_cc;             // Continuity counter in ECM PID.
         PIDSet            _scrambled_pids;     // List of pids to scramble
         PIDSet            _conflict_pids;      // List of pids to scramble with scrambled input packets
         PIDSet            _input_pids;         // List of input pids
-        CryptoPeriod      _cp[2];              // Previous/current or current/next crypto-periods
-        size_t            _current_cw;         // Index to current CW (current crypto period)
-        size_t            _current_ecm;        // Index to current ECM (ECM being broadcast)
-        Scrambling        _current_key;        // Preprocessed current control word
+        PIDSet            _ecm_pids;           // List of allocated ECM pids
+        ServiceContext*   _pid_context[PID_MAX]; // Per-PID service context of scrambled PID's
+        ServiceContext*   _pmt_context[PID_MAX]; // Per-PID service context of modified PMT PID's
+        bool              _batching;           // Inside processPacketBatch(), payloads are batched
+        ScramblingBatch   _batch;              // Pending payloads to scramble
         SectionDemux      _demux;              // Section demux
-        CyclingPacketizer _pzer_pmt;           // Packetizer for modified PMT
         SystemRandomGenerator _cw_gen;         // Control word generator
 
-        // Return current/next CryptoPeriod for CW or ECM
-        CryptoPeriod& currentCW()  {return _cp[_current_cw];}
-        CryptoPeriod& nextCW()     {return _cp[(_current_cw + 1) & 0x01];}
-        CryptoPeriod& currentECM() {return _cp[_current_ecm];}
-        CryptoPeriod& nextECM()    {return _cp[(_current_ecm + 1) & 0x01];}
-
-        // Perform CW and ECM transition
-        void changeCW();
-        void changeECM();
-
-        // Check if we are in degraded mode or if we enter degraded mode
-        bool inDegradedMode();
-
-        // Try to exit from degraded mode
-        void tryExitDegradedMode();
-
         // Invoked by the demux when a complete table is available.
         virtual void handleTable(SectionDemux&, const BinaryTable&) override;
 
         // Process specific tables
         void processPAT(PAT&);
-        void processPMT(PMT&);
+        void processPMT(ServiceContext&, PMT&);
         void processSDT(SDT&);
 
         // Inaccessible operations
@@ -244,8 +279,7 @@ TSPLUGIN_DECLARE_PROCESSOR(scrambler, ts::ScramblerPlugin)
 //----------------------------------------------------------------------------
 
 ts::ScramblerPlugin::ScramblerPlugin(TSP* tsp_) :
-    ProcessorPlugin(tsp_, u"DVB scrambler.", u"[options] service"),
-    _service(),
+    ProcessorPlugin(tsp_, u"DVB scrambler.", u"[options] service ..."),
     _component_level(false),
     _use_fixed_key(false),
     _scramble_audio(false),
@@ -260,35 +294,28 @@ ts::ScramblerPlugin::ScramblerPlugin(TSP* tsp_) :
     _cp_duration(0),
     _delay_start(0),
     _ecm_bitrate(0),
-    _ecm_pid(PID_NULL),
     _partial_scrambling(0),
     _cw_mode(Scrambling::REDUCE_ENTROPY),
     _channel_status(),
-    _stream_status(),
     _abort(false),
     _ready(false),
-    _degraded_mode(false),
     _packet_count(0),
     _scrambled_count(0),
-    _partial_clear(0),
-    _pkt_insert_ecm(0),
-    _pkt_change_cw(0),
-    _pkt_change_ecm(0),
     _ts_bitrate(0),
+    _services(),
     _ecmg(ASYNC_HANDLER_EXTRA_STACK_SIZE),
-    _ecm_cc(0),
     _scrambled_pids(),
     _conflict_pids(),
     _input_pids(),
-    _cp(),
-    _current_cw(0),
-    _current_ecm(0),
-    _current_key(),
+    _ecm_pids(),
+    _pid_context(),
+    _pmt_context(),
+    _batching(false),
+    _batch(true),
     _demux(this),
-    _pzer_pmt(),
     _cw_gen()
 {
-    option(u"",                      0,  STRING, 1, 1);
+    option(u"",                      0,  STRING, 1, UNLIMITED_COUNT);
     option(u"access-criteria",      'a', STRING);
     option(u"bitrate-ecm",          'b', POSITIVE);
     option(u"channel-id",            0,  UINT16);
@@ -303,20 +330,24 @@ ts::ScramblerPlugin::ScramblerPlugin(TSP* tsp_) :
     option(u"no-entropy-reduction", 'n');
     option(u"no-video",              0);
     option(u"partial-scrambling",    0,  POSITIVE);
-    option(u"pid-ecm",               0,  PIDVAL);
+    option(u"pid-ecm",               0,  PIDVAL, 0, UNLIMITED_COUNT);
     option(u"private-data",         'p', STRING);
     option(u"stream-id",             0,  UINT16);
     option(u"subtitles",             0);
     option(u"super-cas-id",         's', UINT32);
     option(u"synchronous",           0);
 
-    setHelp(u"Service:\n"
-            u"  Specifies the service to scramble.\n"
-            u"  If the argument is an integer value (either decimal or hexadecimal), it is\n"
+    setHelp(u"Services:\n"
+            u"  Specifies the services to scramble.\n"
+            u"  If an argument is an integer value (either decimal or hexadecimal), it is\n"
             u"  interpreted as a service id. Otherwise, it is interpreted as a service name,\n"
             u"  as specified in the SDT. The name is not case sensitive and blanks are\n"
             u"  ignored. If the input TS does not contain an SDT, use service ids only.\n"
             u"\n"
+            u"  Several services can be scrambled in one single pass. They share the same\n"
+            u"  ECMG connection and channel. Each service uses its own ECM stream, crypto-\n"
+            u"  periods and control words.\n"
+            u"\n"
             u"Options:\n"
             u"\n"
             u"  -a value\n"
@@ -348,7 +379,8 @@ ts::ScramblerPlugin::ScramblerPlugin(TSP* tsp_) :
             u"\n"
             u"  -i value\n"
             u"  --ecm-id value\n"
-            u"      Specifies the DVB SimulCrypt ECM_id for the ECMG (default: 1).\n"
+            u"      Specifies the DVB SimulCrypt ECM_id for the ECMG (default: 1). With\n"
+            u"      several services, consecutive values are used for the next services.\n"
             u"\n"
             u"  -e host:port\n"
             u"  --ecmg host:port\n"
@@ -390,7 +422,9 @@ ts::ScramblerPlugin::ScramblerPlugin(TSP* tsp_) :
             u"      Specifies the new ECM PID for the service. By defaut, use the first\n"
             u"      unused PID immediately following the PMT PID. Using the default, there\n"
             u"      is a risk to later discover that this PID is already used. In that case,\n"
-            u"      specify --pid-ecm with a notoriously unused PID value.\n"
+            u"      specify --pid-ecm with a notoriously unused PID value. With several\n"
+            u"      services, the option can be repeated, once per service, in the same\n"
+            u"      order as the services.\n"
             u"\n"
             u"  -p value\n"
             u"  --private-data value\n"
@@ -399,6 +433,7 @@ ts::ScramblerPlugin::ScramblerPlugin(TSP* tsp_) :
             u"\n"
             u"  --stream-id value\n"
             u"      Specifies the DVB SimulCrypt ECM_stream_id for the ECMG (default: 1).\n"
+            u"      With several services, consecutive values are used for the next services.\n"
             u"\n"
             u"  --subtitles\n"
             u"      Scramble subtitles components in the selected service. By default, the\n"
@@ -420,6 +455,33 @@ ts::ScramblerPlugin::ScramblerPlugin(TSP* tsp_) :
 }
 
 
+//----------------------------------------------------------------------------
+// Service context constructor
+//----------------------------------------------------------------------------
+
+ts::ScramblerPlugin::ServiceContext::ServiceContext(ScramblerPlugin* plugin_, const UString& service_, PID ecm_pid_, uint16_t ecm_stream_id_, uint16_t ecm_id_) :
+    plugin(plugin_),
+    service(service_),
+    ecm_stream_id(ecm_stream_id_),
+    ecm_id(ecm_id_),
+    ecm_pid(ecm_pid_),
+    ecm_cc(0),
+    ready(false),
+    degraded_mode(false),
+    partial_clear(0),
+    pkt_insert_ecm(0),
+    pkt_change_cw(0),
+    pkt_change_ecm(0),
+    pzer_pmt(),
+    cp(),
+    current_cw(0),
+    current_ecm(0),
+    current_key()
+{
+    pzer_pmt.setStuffingPolicy(CyclingPacketizer::ALWAYS);
+}
+
+
 //----------------------------------------------------------------------------
 // Start method
 //----------------------------------------------------------------------------
@@ -429,20 +491,16 @@ bool ts::ScramblerPlugin::start()
     // Reset states
     _scrambled_pids.reset();
     _conflict_pids.reset();
+    _ecm_pids.reset();
     _packet_count = 0;
     _scrambled_count = 0;
-    _ecm_cc = 0;
     _abort = false;
     _ready = false;
-    _degraded_mode = false;
     _ts_bitrate = 0;
-    _pkt_insert_ecm = 0;
-    _pkt_change_cw = 0;
-    _pkt_change_ecm = 0;
-    _partial_clear = 0;
+    TS_ZERO(_pid_context);
+    TS_ZERO(_pmt_context);
 
     // Parameters
-    _service.set (value(u""));
     _use_fixed_key = present(u"control-word");
     _synchronous_ecmg = present(u"synchronous");
     _cw_mode = present(u"no-entropy-reduction") ? Scrambling::FULL_CW : Scrambling::REDUCE_ENTROPY;
@@ -452,7 +510,6 @@ bool ts::ScramblerPlugin::start()
     _scramble_subtitles = present(u"subtitles");
     _partial_scrambling = intValue<PacketCounter>(u"partial-scrambling", 1);
     _ignore_scrambled = present(u"ignore-scrambled");
-    _ecm_pid = intValue<PID>(u"pid-ecm", PID_NULL);
     _ecm_bitrate = intValue<BitRate>(u"bitrate-ecm", DEFAULT_ECM_BITRATE);
     _cp_duration = 1000 * intValue<MilliSecond>(u"cp-duration", 10);
     _delay_start = 0;
@@ -461,6 +518,21 @@ bool ts::ScramblerPlugin::start()
     const uint16_t ecm_stream_id = intValue<uint16_t>(u"stream-id", 1);
     const uint16_t ecm_id = intValue<uint16_t>(u"ecm-id", 1);
 
+    // Create one context per service. Consecutive ECM stream ids and ECM ids are used.
+    UStringVector names;
+    getValues(names, u"");
+    if (count(u"pid-ecm") > names.size()) {
+        tsp->error(u"more --pid-ecm than services");
+        return false;
+    }
+    _services.clear();
+    for (size_t i = 0; i < names.size(); ++i) {
+        _services.push_back(ServiceContextPtr(new ServiceContext(this, names[i], intValue<PID>(u"pid-ecm", PID_NULL, i), uint16_t(ecm_stream_id + i), uint16_t(ecm_id + i))));
+        if (_services.back()->ecm_pid != PID_NULL) {
+            _ecm_pids.set(_services.back()->ecm_pid);
+        }
+    }
+
     if (!value(u"access-criteria").hexaDecode(_access_criteria)) {
         tsp->error(u"invalid access criteria, specify an even number of hexa digits");
         return false;
@@ -475,6 +547,10 @@ bool ts::ScramblerPlugin::start()
     ecmgscs::Protocol::Instance()->setVersion(intValue<tlv::VERSION>(u"ecmg-scs-version", 2));
 
     // Get control word generation mechanism
+    ecmgscs::StreamStatus stream_status;
+    assert(!_services.empty());
+    const ServiceContextPtr& first(_services.front());
+
     if (_use_fixed_key) {
 
         // Use a fixed control word
@@ -484,8 +560,10 @@ bool ts::ScramblerPlugin::start()
             return false;
         }
 
-        // Initialize current scrambling key
-        _current_key.init(cw.data(), _cw_mode);
+        // Initialize current scrambling key in all services
+        for (ServiceContextVector::const_iterator it = _services.begin(); it != _services.end(); ++it) {
+            (*it)->current_key.init(cw.data(), _cw_mode);
+        }
         tsp->verbose(u"using fixed control word: " + UString::Dump(cw, UString::SINGLE_LINE));
     }
     else if (!present(u"ecmg")) {
@@ -501,14 +579,22 @@ bool ts::ScramblerPlugin::start()
         tsp->error(u"--super-cas-id is required with --ecmg");
         return false;
     }
-    else if (!_ecmg.connect(_ecmg_addr, _super_cas_id, ecm_channel_id, ecm_stream_id, ecm_id,
-                            uint16_t(_cp_duration / 100), _channel_status, _stream_status, tsp, tsp))
+    else if (!_ecmg.connect(_ecmg_addr, _super_cas_id, ecm_channel_id, first->ecm_stream_id, first->ecm_id,
+                            uint16_t(_cp_duration / 100), _channel_status, stream_status, tsp, tsp))
     {
         // Error connecting to ECMG, error message already reported
         return false;
     }
     else {
         // Now correctly connected to ECMG.
+        // Open one additional ECM stream per additional service.
+        for (size_t i = 1; i < _services.size(); ++i) {
+            if (!_ecmg.addStream(_services[i]->ecm_stream_id, _services[i]->ecm_id, uint16_t(_cp_duration / 100), stream_status)) {
+                _ecmg.disconnect();
+                return false;
+            }
+        }
+
         // Validate delay start.
         _delay_start = MilliSecond(_channel_status.delay_start);
         if (_delay_start > _cp_duration / 2) {
@@ -519,22 +605,23 @@ bool ts::ScramblerPlugin::start()
         }
         tsp->debug(u"crypto-period duration: %'d ms, delay start: %'d ms", {_cp_duration, _delay_start});
 
-        // The PMT will be modified, initialize the PMT packetizer
-        _pzer_pmt.reset();
-        _pzer_pmt.setStuffingPolicy(CyclingPacketizer::ALWAYS);
-
-        // Create first and second crypto-periods
-        _current_cw = 0;
-        _current_ecm = 0;
-        _cp[0].initCycle(this, 0);
-        _cp[0].initScramblerKey();
-        _cp[1].initNext(_cp[0]);
+        // Create first and second crypto-periods of all services.
+        for (ServiceContextVector::const_iterator it = _services.begin(); it != _services.end(); ++it) {
+            ServiceContext& ctx(**it);
+            ctx.cp[0].initCycle(&ctx, 0);
+            ctx.cp[0].initScramblerKey();
+            ctx.cp[1].initNext(ctx.cp[0]);
+        }
     }
 
     // Initialize the demux.
-    // If the service is known by name, filter the SDT, otherwise filter the PAT.
+    // If any service is known by name, filter the SDT, otherwise filter the PAT.
+    bool need_sdt = false;
+    for (ServiceContextVector::const_iterator it = _services.begin(); it != _services.end(); ++it) {
+        need_sdt = need_sdt || (*it)->service.hasName();
+    }
     _demux.reset();
-    _demux.addPID(PID(_service.hasName() ? PID_SDT : PID_PAT));
+    _demux.addPID(PID(need_sdt ? PID_SDT : PID_PAT));
 
     // Initialize the list of used pids. Preset reserved PIDs.
     _input_pids.reset();
@@ -593,8 +680,13 @@ void ts::ScramblerPlugin::handleTable(SectionDemux& demux, const BinaryTable& ta
 
         case TID_PMT: {
             PMT pmt (table);
-            if (pmt.isValid() && _service.hasId(pmt.service_id)) {
-                processPMT (pmt);
+            if (pmt.isValid()) {
+                for (ServiceContextVector::const_iterator it = _services.begin(); it != _services.end(); ++it) {
+                    if ((*it)->service.hasId(pmt.service_id)) {
+                        processPMT(**it, pmt);
+                        break;
+                    }
+                }
             }
             break;
         }
@@ -612,19 +704,22 @@ void ts::ScramblerPlugin::handleTable(SectionDemux& demux, const BinaryTable& ta
 
 void ts::ScramblerPlugin::processSDT(SDT& sdt)
 {
-    // Look for the service by name
-    uint16_t service_id;
-    assert(_service.hasName());
-    if (!sdt.findService(_service.getName(), service_id)) {
-        tsp->error(u"service \"%s\" not found in SDT", {_service.getName()});
-        _abort = true;
-        return;
+    // Look for all services by name
+    for (ServiceContextVector::const_iterator it = _services.begin(); it != _services.end(); ++it) {
+        Service& service((*it)->service);
+        uint16_t service_id;
+        if (service.hasName() && !service.hasId()) {
+            if (!sdt.findService(service.getName(), service_id)) {
+                tsp->error(u"service \"%s\" not found in SDT", {service.getName()});
+                _abort = true;
+                return;
+            }
+            // Remember service id
+            service.setId(service_id);
+            tsp->verbose(u"service \"%s\", service id is 0x%X", {service.getName(), service_id});
+        }
     }
 
-    // Remember service id
-    _service.setId (service_id);
-    tsp->verbose(u"service id is 0x%X", {service_id});
-
     // No longer need to filter the SDT
     _demux.removePID(PID_SDT);
 
@@ -644,27 +739,34 @@ void ts::ScramblerPlugin::processPAT (PAT& pat)
         _input_pids.set(it->second);
     }
 
-    // Search service in the PAT
-    assert (_service.hasId());
-    PAT::ServiceMap::const_iterator patit = pat.pmts.find (_service.getId());
-    if (patit == pat.pmts.end()) {
-        // Service not found, error
-        tsp->error(u"service id %d (0x%X) not found in PAT", {_service.getId(), _service.getId()});
-        _abort = true;
-        return;
-    }
+    // Search all services in the PAT
+    for (ServiceContextVector::const_iterator it = _services.begin(); it != _services.end(); ++it) {
+        ServiceContext& ctx(**it);
+        assert (ctx.service.hasId());
+        PAT::ServiceMap::const_iterator patit = pat.pmts.find (ctx.service.getId());
+        if (patit == pat.pmts.end()) {
+            // Service not found, error
+            tsp->error(u"service id %d (0x%X) not found in PAT", {ctx.service.getId(), ctx.service.getId()});
+            _abort = true;
+            return;
+        }
 
-    // If a previous PMT PID was known, no long filter it
-    if (_service.hasPMTPID()) {
-        _demux.removePID(_service.getPMTPID());
-    }
+        // If a previous PMT PID was known, no long filter it
+        if (ctx.service.hasPMTPID()) {
+            _demux.removePID(ctx.service.getPMTPID());
+            _pmt_context[ctx.service.getPMTPID()] = 0;
+        }
 
-    // Filter PMT PID
-    _service.setPMTPID(patit->second);
-    _demux.addPID(patit->second);
+        // Filter PMT PID
+        ctx.service.setPMTPID(patit->second);
+        _demux.addPID(patit->second);
 
-    // Set PID to PMT packetizer
-    _pzer_pmt.setPID(patit->second);
+        // Set PID to PMT packetizer
+        ctx.pzer_pmt.setPID(patit->second);
+        if (!_use_fixed_key) {
+            _pmt_context[patit->second] = &ctx;
+        }
+    }
 }
 
 
@@ -672,34 +774,40 @@ void ts::ScramblerPlugin::processPAT (PAT& pat)
 //  This method processes a Program Map Table (PMT).
 //----------------------------------------------------------------------------
 
-void ts::ScramblerPlugin::processPMT(PMT& pmt)
+void ts::ScramblerPlugin::processPMT(ServiceContext& ctx, PMT& pmt)
 {
-    // Make sure this is the right service
-    if (!_service.hasId(pmt.service_id)) {
-        return;
-    }
-
     // Collect all PIDS to scramble
     for (PMT::StreamMap::const_iterator it = pmt.streams.begin(); it != pmt.streams.end(); ++it) {
         const PID pid = it->first;
         const PMT::Stream& stream(it->second);
         _input_pids.set(pid);
         if ((_scramble_audio && stream.isAudio()) || (_scramble_video && stream.isVideo()) || (_scramble_subtitles && stream.isSubtitles())) {
-            _scrambled_pids.set(pid);
-            tsp->verbose(u"starting scrambling PID 0x%X", {pid});
+            if (_pid_context[pid] != 0 && _pid_context[pid] != &ctx) {
+                tsp->warning(u"PID 0x%X is shared by several services, scrambled with the first one", {pid});
+            }
+            else if (_pid_context[pid] == 0) {
+                _scrambled_pids.set(pid);
+                _pid_context[pid] = &ctx;
+                tsp->verbose(u"starting scrambling PID 0x%X", {pid});
+            }
         }
     }
 
     // Allocate a PID value for ECM if necessary
-    if (!_use_fixed_key && _ecm_pid == PID_NULL) {
+    if (!_use_fixed_key && ctx.ecm_pid == PID_NULL) {
         // Start at service PMT PID, then look for an unused one.
-        for (_ecm_pid = _service.getPMTPID() + 1; _ecm_pid < PID_NULL && _input_pids.test (_ecm_pid); _ecm_pid++) {}
-        if (_ecm_pid >= PID_NULL) {
+        PID ecm_pid = ctx.service.getPMTPID() + 1;
+        while (ecm_pid < PID_NULL && (_input_pids.test(ecm_pid) || _ecm_pids.test(ecm_pid))) {
+            ecm_pid++;
+        }
+        if (ecm_pid >= PID_NULL) {
             tsp->error(u"cannot find an unused PID for ECM, try --pid-ecm");
             _abort = true;
         }
         else {
-            tsp->verbose(u"using PID %d (0x%X) for ECM", {_ecm_pid, _ecm_pid});
+            ctx.ecm_pid = ecm_pid;
+            _ecm_pids.set(ecm_pid);
+            tsp->verbose(u"using PID %d (0x%X) for ECM", {ecm_pid, ecm_pid});
         }
     }
 
@@ -707,14 +815,14 @@ void ts::ScramblerPlugin::processPMT(PMT& pmt)
     if (!_use_fixed_key) {
 
         // Create a CA_descriptor
-        CADescriptor ca_desc ((_super_cas_id >> 16) & 0xFFFF, _ecm_pid);
+        CADescriptor ca_desc ((_super_cas_id >> 16) & 0xFFFF, ctx.ecm_pid);
         ca_desc.private_data = _ca_desc_private;
 
         // Add the CA_descriptor at program level or component level
         if (_component_level) {
             // Add a CA_descriptor in each scrambled component
             for (PMT::StreamMap::iterator it = pmt.streams.begin(); it != pmt.streams.end(); ++it) {
-                if (_scrambled_pids.test(it->first)) {
+                if (_pid_context[it->first] == &ctx) {
                     it->second.descs.add(ca_desc);
                 }
             }
@@ -725,15 +833,21 @@ void ts::ScramblerPlugin::processPMT(PMT& pmt)
         }
 
         // Packetize the modified PMT
-        _pzer_pmt.removeSections(TID_PMT, pmt.service_id);
-        _pzer_pmt.addTable(pmt);
+        ctx.pzer_pmt.removeSections(TID_PMT, pmt.service_id);
+        ctx.pzer_pmt.addTable(pmt);
     }
 
-    // We are now ready to scramble packets
+    // This service is now ready to scramble packets.
+    // The plugin is ready when all services are ready.
+    const bool first_pmt = !ctx.ready;
+    ctx.ready = true;
     _ready = true;
+    for (ServiceContextVector::const_iterator it = _services.begin(); _ready && it != _services.end(); ++it) {
+        _ready = (*it)->ready;
+    }
 
     // Initialize crypto-period management
-    if (!_use_fixed_key) {
+    if (!_use_fixed_key && first_pmt) {
 
         // We need to know the bitrate in order to schedule crypto-periods
         if (_ts_bitrate == 0) {
@@ -743,15 +857,15 @@ void ts::ScramblerPlugin::processPMT(PMT& pmt)
         }
 
         // Insert current ECM packets as soon as possible.
-        _pkt_insert_ecm = _packet_count;
+        ctx.pkt_insert_ecm = _packet_count;
 
         // Next crypto-period
-        _pkt_change_cw = _packet_count + PacketDistance (_ts_bitrate, _cp_duration);
+        ctx.pkt_change_cw = _packet_count + PacketDistance (_ts_bitrate, _cp_duration);
 
         // Next ECM may start before or after next crypto-period
-        _pkt_change_ecm = _delay_start > 0 ?
-            _pkt_change_cw + PacketDistance (_ts_bitrate, _delay_start) :
-            _pkt_change_cw - PacketDistance (_ts_bitrate, _delay_start);
+        ctx.pkt_change_ecm = _delay_start > 0 ?
+            ctx.pkt_change_cw + PacketDistance (_ts_bitrate, _delay_start) :
+            ctx.pkt_change_cw - PacketDistance (_ts_bitrate, _delay_start);
     }
 }
 
@@ -760,9 +874,9 @@ void ts::ScramblerPlugin::processPMT(PMT& pmt)
 // Check if we are in degraded mode or if we enter degraded mode
 //----------------------------------------------------------------------------
 
-bool ts::ScramblerPlugin::inDegradedMode()
+bool ts::ScramblerPlugin::ServiceContext::inDegradedMode()
 {
-    if (_degraded_mode) {
+    if (degraded_mode) {
         // Already in degraded mode, do not try to exit from it now.
         return true;
     }
@@ -772,8 +886,8 @@ bool ts::ScramblerPlugin::inDegradedMode()
     }
     else {
         // Entering degraded mode
-        tsp->warning(u"Next ECM not ready, entering degraded mode");
-        return _degraded_mode = true;
+        plugin->tsp->warning(u"service 0x%X: next ECM not ready, entering degraded mode", {service.getId()});
+        return degraded_mode = true;
     }
 }
 
@@ -782,10 +896,10 @@ bool ts::ScramblerPlugin::inDegradedMode()
 // Try to exit from degraded mode
 //----------------------------------------------------------------------------
 
-void ts::ScramblerPlugin::tryExitDegradedMode()
+void ts::ScramblerPlugin::ServiceContext::tryExitDegradedMode()
 {
     // If not in degraded mode, nothing to do
-    if (!_degraded_mode) {
+    if (!degraded_mode) {
         return;
     }
 
@@ -795,21 +909,21 @@ void ts::ScramblerPlugin::tryExitDegradedMode()
     }
 
     // Next ECM is ready, at last. Exit degraded mode.
-    tsp->info(u"Next ECM ready, exiting from degraded mode");
-    _degraded_mode = false;
+    plugin->tsp->info(u"service 0x%X: next ECM ready, exiting from degraded mode", {service.getId()});
+    degraded_mode = false;
 
     // Compute next CW and ECM change.
-    if (_delay_start < 0) {
+    if (plugin->_delay_start < 0) {
         // Start broadcasting ECM before beginning of crypto-period, ie. now
         changeECM();
         // Postpone CW change
-        _pkt_change_cw = _packet_count + PacketDistance (_ts_bitrate, _delay_start);
+        pkt_change_cw = plugin->_packet_count + PacketDistance (plugin->_ts_bitrate, plugin->_delay_start);
     }
     else {
         // Change CW now.
         changeCW();
         // Start broadcasting ECM after beginning of crypto-period
-        _pkt_change_ecm = _packet_count + PacketDistance(_ts_bitrate, _delay_start);
+        pkt_change_ecm = plugin->_packet_count + PacketDistance(plugin->_ts_bitrate, plugin->_delay_start);
     }
 }
 
@@ -818,33 +932,33 @@ void ts::ScramblerPlugin::tryExitDegradedMode()
 // Perform crypto-period transition, for CW or ECM
 //----------------------------------------------------------------------------
 
-void ts::ScramblerPlugin::changeCW()
+void ts::ScramblerPlugin::ServiceContext::changeCW()
 {
     // Allowed to change CW only if not in degraded mode
     if (!inDegradedMode()) {
         // Point to next crypto-period
-        _current_cw = (_current_cw + 1) & 0x01;
+        current_cw = (current_cw + 1) & 0x01;
         // Use new control word
         currentCW().initScramblerKey();
         // Determine new transition point
-        _pkt_change_cw = _packet_count + PacketDistance (_ts_bitrate, _cp_duration);
+        pkt_change_cw = plugin->_packet_count + PacketDistance (plugin->_ts_bitrate, plugin->_cp_duration);
         // Generate (or start generating) next ECM when using ECM(N) in cp(N)
-        if (_current_ecm == _current_cw) {
+        if (current_ecm == current_cw) {
             nextCW().initNext (currentCW());
         }
     }
 }
 
-void ts::ScramblerPlugin::changeECM()
+void ts::ScramblerPlugin::ServiceContext::changeECM()
 {
     // Allowed to change CW only if not in degraded mode
     if (!inDegradedMode()) {
         // Point to next crypto-period
-        _current_ecm = (_current_ecm + 1) & 0x01;
+        current_ecm = (current_ecm + 1) & 0x01;
         // Determine new transition point
-        _pkt_change_ecm = _packet_count + PacketDistance (_ts_bitrate, _cp_duration);
+        pkt_change_ecm = plugin->_packet_count + PacketDistance (plugin->_ts_bitrate, plugin->_cp_duration);
         // Generate (or start generating) next ECM when using ECM(N) in cp(N)
-        if (_current_ecm == _current_cw) {
+        if (current_ecm == current_cw) {
             nextCW().initNext (currentCW());
         }
     }
@@ -881,7 +995,7 @@ ts::ProcessorPlugin::Status ts::ScramblerPlugin::processPacket (TSPacket& pkt, b
     }
 
     // Abort if allocated PID for ECM is already present in TS
-    if (_ecm_pid != PID_NULL && pid == _ecm_pid) {
+    if (_ecm_pids.test(pid)) {
         tsp->error(u"ECM PID allocation conflict, used 0x%X, now found as input PID, try another --pid-ecm", {pid});
         return TSP_END;
     }
@@ -895,39 +1009,51 @@ ts::ProcessorPlugin::Status ts::ScramblerPlugin::processPacket (TSPacket& pkt, b
     if (!_use_fixed_key) {
 
         // Packetize modified PMT when ECM generation is used
-        if (pid == _pzer_pmt.getPID()) {
-            _pzer_pmt.getNextPacket(pkt);
+        ServiceContext* const pmt_ctx = _pmt_context[pid];
+        if (pmt_ctx != 0) {
+            pmt_ctx->pzer_pmt.getNextPacket(pkt);
             return TSP_OK;
         }
 
-        // Is it time to apply the next control word ?
-        if (_packet_count >= _pkt_change_cw) {
-            changeCW();
-        }
+        for (ServiceContextVector::const_iterator it = _services.begin(); it != _services.end(); ++it) {
+            ServiceContext& ctx(**it);
+
+            // Is it time to apply the next control word ?
+            if (_packet_count >= ctx.pkt_change_cw) {
+                ctx.changeCW();
+            }
 
-        // Is it time to start broadcasting the next ECM ?
-        if (_packet_count >= _pkt_change_ecm) {
-            changeECM();
+            // Is it time to start broadcasting the next ECM ?
+            if (_packet_count >= ctx.pkt_change_ecm) {
+                ctx.changeECM();
+            }
         }
 
-        // Insert an ECM packet (replace a null packet) when time to do so
-        if (pid == PID_NULL && _packet_count >= _pkt_insert_ecm) {
+        // Insert an ECM packet (replace a null packet) when time to do so.
+        // A null packet is used by the first service which needs one.
+        if (pid == PID_NULL) {
+            for (ServiceContextVector::const_iterator it = _services.begin(); it != _services.end(); ++it) {
+                ServiceContext& ctx(**it);
+                if (_packet_count >= ctx.pkt_insert_ecm) {
 
-            // Compute next insertion point (approximate)
-            assert(_ecm_bitrate != 0);
-            _pkt_insert_ecm += BitRate(_ts_bitrate / _ecm_bitrate);
+                    // Compute next insertion point (approximate)
+                    assert(_ecm_bitrate != 0);
+                    ctx.pkt_insert_ecm += BitRate(_ts_bitrate / _ecm_bitrate);
 
-            // Exit degraded mode ?
-            tryExitDegradedMode();
+                    // Exit degraded mode ?
+                    ctx.tryExitDegradedMode();
 
-            // Replace current null packet with an ECM packet
-            currentECM().getNextECMPacket (pkt);
-            return TSP_OK;
+                    // Replace current null packet with an ECM packet
+                    ctx.currentECM().getNextECMPacket (pkt);
+                    return TSP_OK;
+                }
+            }
         }
     }
 
     // If the packet has no payload or its PID is not to be scrambled, there is nothing to do.
-    if (!pkt.hasPayload() || !_scrambled_pids.test (pid)) {
+    ServiceContext* const ctx = _pid_context[pid];
+    if (!pkt.hasPayload() || ctx == 0) {
         return TSP_OK;
     }
 
@@ -947,18 +1073,23 @@ ts::ProcessorPlugin::Status ts::ScramblerPlugin::processPacket (TSPacket& pkt, b
     }
 
     // Manage partial scrambling
-    if (_partial_clear > 0) {
+    if (ctx->partial_clear > 0) {
         // Do not scramble this packet
-        _partial_clear--;
+        ctx->partial_clear--;
         return TSP_OK;
     }
     else {
         // Scramble this packet and reinit subsequent number of packets to keep clear
-        _partial_clear = _partial_scrambling - 1;
+        ctx->partial_clear = _partial_scrambling - 1;
     }
 
     // Scramble the packet payload.
-    _current_key.encrypt(pkt.getPayload(), pkt.getPayloadSize());
+    if (_batching) {
+        _batch.add(ctx->current_key, pkt.getPayload(), pkt.getPayloadSize());
+    }
+    else {
+        ctx->current_key.encrypt(pkt.getPayload(), pkt.getPayloadSize());
+    }
     _scrambled_count++;
 
     // Set scrambling_control_value in TS header.
@@ -967,19 +1098,34 @@ ts::ProcessorPlugin::Status ts::ScramblerPlugin::processPacket (TSPacket& pkt, b
         pkt.setScrambling(SC_EVEN_KEY);
     }
     else {
-        pkt.setScrambling(currentCW().getScramblingControlValue());
+        pkt.setScrambling(ctx->currentCW().getScramblingControlValue());
     }
 
     return TSP_OK;
 }
 
 
+//----------------------------------------------------------------------------
+// Batch packet processing method: payloads are scrambled in parallel,
+// using the bitsliced implementation of the stream cipher.
+//----------------------------------------------------------------------------
+
+size_t ts::ScramblerPlugin::processPacketBatch(const TSPacketView& pkts, TSPacketMetadata* mdata, size_t count, Status* status, bool& flush, bool& bitrate_changed)
+{
+    _batching = true;
+    const size_t result = ProcessorPlugin::processPacketBatch(pkts, mdata, count, status, flush, bitrate_changed);
+    _batch.flush();
+    _batching = false;
+    return result;
+}
+
+
 //----------------------------------------------------------------------------
 // CryptoPeriod default constructor.
 //----------------------------------------------------------------------------
 
 ts::ScramblerPlugin::CryptoPeriod::CryptoPeriod() :
-    _scrambler(0),
+    _context(0),
     _cp_number(0),
     _ecm_ok(false),
     _ecm(),
@@ -994,12 +1140,12 @@ ts::ScramblerPlugin::CryptoPeriod::CryptoPeriod() :
 // Initialize first crypto period.
 //----------------------------------------------------------------------------
 
-void ts::ScramblerPlugin::CryptoPeriod::initCycle (ScramblerPlugin* scrambler, uint16_t cp_number)
+void ts::ScramblerPlugin::CryptoPeriod::initCycle (ServiceContext* context, uint16_t cp_number)
 {
-    _scrambler = scrambler;
+    _context = context;
     _cp_number = cp_number;
-    _scrambler->_cw_gen.read(_cw_current, sizeof(_cw_current));
-    _scrambler->_cw_gen.read(_cw_next, sizeof(_cw_next));
+    _context->plugin->_cw_gen.read(_cw_current, sizeof(_cw_current));
+    _context->plugin->_cw_gen.read(_cw_next, sizeof(_cw_next));
     generateECM();
 }
 
@@ -1010,10 +1156,10 @@ void ts::ScramblerPlugin::CryptoPeriod::initCycle (ScramblerPlugin* scrambler, u
 
 void ts::ScramblerPlugin::CryptoPeriod::initNext (const CryptoPeriod& previous)
 {
-    _scrambler = previous._scrambler;
+    _context = previous._context;
     _cp_number = previous._cp_number + 1;
     ::memcpy(_cw_current, previous._cw_next, sizeof(_cw_current));  // Flawfinder: ignore: memcpy()
-    _scrambler->_cw_gen.read(_cw_next, sizeof(_cw_next));
+    _context->plugin->_cw_gen.read(_cw_next, sizeof(_cw_next));
     generateECM();
 }
 
@@ -1024,36 +1170,40 @@ void ts::ScramblerPlugin::CryptoPeriod::initNext (const CryptoPeriod& previous)
 
 void ts::ScramblerPlugin::CryptoPeriod::generateECM()
 {
+    ScramblerPlugin* const scrambler = _context->plugin;
     _ecm_ok = false;
 
-    if (_scrambler->_synchronous_ecmg) {
+    if (scrambler->_synchronous_ecmg) {
         // Synchronous ECM generation
         ecmgscs::ECMResponse response;
-        if (!_scrambler->_ecmg.generateECM(_cp_number,
-                                           _cw_current,
-                                           _cw_next,
-                                           _scrambler->_access_criteria.data(),
-                                           _scrambler->_access_criteria.size(),
-                                           uint16_t(_scrambler->_cp_duration / 100),
-                                           response)) {
+        if (!scrambler->_ecmg.generateECM(_context->ecm_stream_id,
+                                          _cp_number,
+                                          _cw_current,
+                                          _cw_next,
+                                          scrambler->_access_criteria.data(),
+                                          scrambler->_access_criteria.size(),
+                                          uint16_t(scrambler->_cp_duration / 100),
+                                          response)) {
             // Error, message already reported
-            _scrambler->_abort = true;
+            scrambler->_abort = true;
         }
         else {
             handleECM(response);
         }
     }
     else {
-        // Asynchronous ECM generation
-        if (!_scrambler->_ecmg.submitECM(_cp_number,
-                                         _cw_current,
-                                         _cw_next,
-                                         _scrambler->_access_criteria.data(),
-                                         _scrambler->_access_criteria.size(),
-                                         uint16_t(_scrambler->_cp_duration / 100),
-                                         this)) {
+        // Asynchronous ECM generation. The ECM requests of all services
+        // are pipelined on the same ECMG connection.
+        if (!scrambler->_ecmg.submitECM(_context->ecm_stream_id,
+                                        _cp_number,
+                                        _cw_current,
+                                        _cw_next,
+                                        scrambler->_access_criteria.data(),
+                                        scrambler->_access_criteria.size(),
+                                        uint16_t(scrambler->_cp_duration / 100),
+                                        this)) {
             // Error, message already reported
-            _scrambler->_abort = true;
+            scrambler->_abort = true;
         }
     }
 }
@@ -1065,24 +1215,26 @@ void ts::ScramblerPlugin::CryptoPeriod::generateECM()
 
 void ts::ScramblerPlugin::CryptoPeriod::handleECM(const ecmgscs::ECMResponse& response)
 {
-    if (_scrambler->_channel_status.section_TSpkt_flag == 0) {
+    ScramblerPlugin* const scrambler = _context->plugin;
+
+    if (scrambler->_channel_status.section_TSpkt_flag == 0) {
         // ECMG returns ECM in section format
         SectionPtr sp(new Section(response.ECM_datagram));
         if (!sp->isValid()) {
-            _scrambler->tsp->error(u"ECMG returned an invalid ECM section (%d bytes)", {response.ECM_datagram.size()});
-            _scrambler->_abort = true;
+            scrambler->tsp->error(u"ECMG returned an invalid ECM section (%d bytes)", {response.ECM_datagram.size()});
+            scrambler->_abort = true;
             return;
         }
         // Packetize the section
-        OneShotPacketizer pzer(_scrambler->_ecm_pid, true);
+        OneShotPacketizer pzer(_context->ecm_pid, true);
         pzer.addSection(sp);
         pzer.getPackets(_ecm);
 
     }
     else if (response.ECM_datagram.size() % PKT_SIZE != 0) {
         // ECMG returns ECM in packet format, but not an integral number of packets
-        _scrambler->tsp->error(u"invalid ECM size (%d bytes), not a multiple of %d", {response.ECM_datagram.size(), PKT_SIZE});
-        _scrambler->_abort = true;
+        scrambler->tsp->error(u"invalid ECM size (%d bytes), not a multiple of %d", {response.ECM_datagram.size(), PKT_SIZE});
+        scrambler->_abort = true;
         return;
     }
     else {
@@ -1091,7 +1243,7 @@ void ts::ScramblerPlugin::CryptoPeriod::handleECM(const ecmgscs::ECMResponse& re
         ::memcpy(&_ecm[0].b, response.ECM_datagram.data(), response.ECM_datagram.size());  // Flawfinder: ignore: memcpy()
     }
 
-    _scrambler->tsp->debug(u"got ECM for crypto-period %d, %d packets", {_cp_number, _ecm.size()});
+    scrambler->tsp->debug(u"got ECM for crypto-period %d, ECM stream %d, %d packets", {_cp_number, _context->ecm_stream_id, _ecm.size()});
 
     _ecm_pkt_index = 0;
 
@@ -1119,9 +1271,9 @@ void ts::ScramblerPlugin::CryptoPeriod::getNextECMPacket (TSPacket& pkt)
             _ecm_pkt_index = 0;
         }
         // Adjust PID and continuity counter in TS packet
-        pkt.setPID(_scrambler->_ecm_pid);
-        pkt.setCC(_scrambler->_ecm_cc);
-        _scrambler->_ecm_cc = (_scrambler->_ecm_cc + 1) & 0x0F;
+        pkt.setPID(_context->ecm_pid);
+        pkt.setCC(_context->ecm_cc);
+        _context->ecm_cc = (_context->ecm_cc + 1) & 0x0F;
     }
 }
 
@@ -1132,6 +1284,8 @@ void ts::ScramblerPlugin::CryptoPeriod::getNextECMPacket (TSPacket& pkt)
 
 void ts::ScramblerPlugin::CryptoPeriod::initScramblerKey() const
 {
-    _scrambler->tsp->debug(u"using new control word: " + UString::Dump(_cw_current, sizeof(_cw_current), UString::SINGLE_LINE));
-    _scrambler->_current_key.init(_cw_current, _scrambler->_cw_mode);
+    _context->plugin->tsp->debug(u"service 0x%X, using new control word: %s", {_context->service.getId(), UString::Dump(_cw_current, sizeof(_cw_current), UString::SINGLE_LINE)});
+    // Pending payloads use the previous control word.
+    _context->plugin->_batch.flush();
+    _context->current_key.init(_cw_current, _context->plugin->_cw_mode);
 }
@@ -32,10 +32,8 @@
 //
 //----------------------------------------------------------------------------
 
-#include "tsPlugin.h"
+#include "tsAbstractTablePlugin.h"
 #include "tsPluginRepository.h"
-#include "tsSectionDemux.h"
-#include "tsCyclingPacketizer.h"
 #include "tsServiceDescriptor.h"
 #include "tsService.h"
 #include "tsPAT.h"
@@ -48,27 +46,20 @@ TSDUCK_SOURCE;
 //----------------------------------------------------------------------------
 
 namespace ts {
-    class SDTPlugin: public ProcessorPlugin, private TableHandlerInterface
+    class SDTPlugin: public AbstractTablePlugin
     {
     public:
         // Implementation of plugin API
         SDTPlugin(TSP*);
         virtual bool start() override;
-        virtual Status processPacket(TSPacket&, bool&, bool&) override;
 
     private:
-        bool                  _abort;             // Error (service not found, etc)
         Service               _service;           // New or modified service
         std::vector<uint16_t> _remove_serv;       // Set of services to remove
-        bool                  _incr_version;      // Increment table version
-        bool                  _set_version;       // Set a new table version
-        uint8_t               _new_version;       // New table version
         bool                  _cleanup_priv_desc; // Remove private desc without preceding PDS desc
-        SectionDemux          _demux;             // Section demux
-        CyclingPacketizer     _pzer;              // Packetizer for modified SDT/BAT
 
-        // Invoked by the demux when a complete table is available.
-        virtual void handleTable(SectionDemux&, const BinaryTable&) override;
+        // Implementation of AbstractTablePlugin.
+        virtual void modifyTable(BinaryTable&, bool&, bool&) override;
         void processSDT(SDT&);
 
         // Inaccessible operations
@@ -87,24 +78,16 @@ TSPLUGIN_DECLARE_PROCESSOR(sdt, ts::SDTPlugin)
 //----------------------------------------------------------------------------
 
 ts::SDTPlugin::SDTPlugin(TSP* tsp_) :
-    ProcessorPlugin(tsp_, u"Perform various transformations on the SDT Actual.", u"[options]"),
-    _abort(false),
+    AbstractTablePlugin(tsp_, u"Perform various transformations on the SDT Actual.", u"[options]", u"SDT"),
     _service(),
     _remove_serv(),
-    _incr_version(false),
-    _set_version(false),
-    _new_version(0),
-    _cleanup_priv_desc(false),
-    _demux(this),
-    _pzer()
+    _cleanup_priv_desc(false)
 {
     option(u"cleanup-private-descriptors", 0);
     option(u"eit-pf",                      0,  INTEGER, 0, 1, 0, 1);
     option(u"eit-schedule",                0,  INTEGER, 0, 1, 0, 1);
     option(u"free-ca-mode",               'f', INTEGER, 0, 1, 0, 1);
-    option(u"increment-version",          'i');
     option(u"name",                       'n', STRING);
-    option(u"new-version",                'v', INTEGER, 0, 1, 0, 31);
     option(u"provider",                   'p', STRING);
     option(u"remove-service",              0,  UINT16, 0, UNLIMITED_COUNT);
     option(u"running-status",             'r', INTEGER, 0, 1, 0, 7);
@@ -182,9 +165,6 @@ ts::SDTPlugin::SDTPlugin(TSP* tsp_) :
 bool ts::SDTPlugin::start()
 {
     // Get option values
-    _incr_version = present(u"increment-version");
-    _set_version = present(u"new-version");
-    _new_version = intValue<uint8_t>(u"new-version", 0);
     _cleanup_priv_desc = present(u"cleanup-private-descriptors");
     getIntValues(_remove_serv, u"remove-service");
     _service.clear();
@@ -213,57 +193,35 @@ bool ts::SDTPlugin::start()
         _service.setType(intValue<uint8_t>(u"type"));
     }
 
-    // Initialize the demux and packetizer
-    _demux.reset();
-    _demux.addPID(PID_SDT);
-    _pzer.reset();
-    _pzer.setPID(PID_SDT);
-
-    _abort = false;
+    // Initialize the table processing.
+    // Use the shared signalization of tsp when available.
+    PIDSet pids;
+    pids.set(PID_SDT);
+    startTables(PID_SDT, pids, true);
     return true;
 }
 
 
 //----------------------------------------------------------------------------
-// Invoked by the demux when a complete table is available.
+// Modify a table from the SDT/BAT PID.
 //----------------------------------------------------------------------------
 
-void ts::SDTPlugin::handleTable(SectionDemux& demux, const BinaryTable& table)
+void ts::SDTPlugin::modifyTable(BinaryTable& table, bool& is_target, bool& reinsert)
 {
-    switch (table.tableId()) {
-
-        case TID_SDT_ACT: {
-            if (table.sourcePID() == PID_SDT) {
-                SDT sdt(table);
-                if (sdt.isValid()) {
-                    // Modify SDT Actual
-                    _pzer.removeSections(TID_SDT_ACT, table.tableIdExtension());
-                    processSDT(sdt);
-                    _pzer.addTable(sdt);
-                }
-            }
-            break;
-        }
-
-        case TID_SDT_OTH: {
-            if (table.sourcePID() == PID_SDT) {
-                // SDT Other are passed unmodified
-                _pzer.removeSections(TID_SDT_OTH, table.tableIdExtension());
-                _pzer.addTable(table);
-            }
-            break;
-        }
-
-        case TID_BAT: {
-            if (table.sourcePID() == PID_BAT) {
-                // Do not modify BAT
-                _pzer.removeSections(TID_BAT, table.tableIdExtension());
-                _pzer.addTable(table);
-            }
+    if (table.tableId() != TID_SDT_ACT) {
+        // SDT Other and BAT are passed unmodified
+        is_target = false;
+        reinsert = table.tableId() == TID_SDT_OTH || table.tableId() == TID_BAT;
+    }
+    else if (_service.hasId() || !_remove_serv.empty() || _cleanup_priv_desc) {
+        // Modify SDT Actual
+        SDT sdt(table);
+        if (sdt.isValid()) {
+            processSDT(sdt);
+            sdt.serialize(table);
         }
-
-        default: {
-            break;
+        else {
+            reinsert = false;
         }
     }
 }
@@ -275,14 +233,6 @@ void ts::SDTPlugin::handleTable(SectionDemux& demux, const BinaryTable& table)
 
 void ts::SDTPlugin::processSDT(SDT& sdt)
 {
-    // Update SDT version
-    if (_incr_version) {
-        sdt.version = (sdt.version + 1) & 0x1F;
-    }
-    else if (_set_version) {
-        sdt.version = _new_version;
-    }
-
     // Add / modify a service
     if (_service.hasId()) {
 
@@ -337,26 +287,3 @@ void ts::SDTPlugin::processSDT(SDT& sdt)
         }
     }
 }
-
-
-//----------------------------------------------------------------------------
-// Packet processing method
-//----------------------------------------------------------------------------
-
-ts::ProcessorPlugin::Status ts::SDTPlugin::processPacket (TSPacket& pkt, bool& flush, bool& bitrate_changed)
-{
-    // Filter interesting sections
-    _demux.feedPacket(pkt);
-
-    // If a fatal error occured during section analysis, give up.
-    if (_abort) {
-        return TSP_END;
-    }
-
-    // Replace packets using packetizer
-    if (pkt.getPID() == PID_SDT) {
-        _pzer.getNextPacket(pkt);
-    }
-
-    return TSP_OK;
-}
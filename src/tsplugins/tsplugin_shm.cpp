@@ -0,0 +1,783 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  Transport stream processor shared library:
+//  Exchange TS packets between tsp processes through shared memory (Linux only).
+//
+//----------------------------------------------------------------------------
+
+#include "tsPlugin.h"
+#include "tsPluginRepository.h"
+#include "tsSysUtils.h"
+#include "tsSysInfo.h"
+#if defined(TS_LINUX)
+#include <atomic>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+TSDUCK_SOURCE;
+
+#define DEF_RING_PACKETS  65536   // Default number of TS packets in the ring
+#define MAX_READERS          16   // Maximum number of concurrent readers
+#define WAIT_TIMEOUT        100   // Wait timeout in milliseconds, to check abort requests and dead processes
+#define SHM_PREFIX   "/tsduck-"   // Prefix of shared memory object names
+#define SHM_MAGIC    "TSDKSHM1"   // Magic string at start of shared memory, 8 characters
+
+
+//----------------------------------------------------------------------------
+// Plugin definition
+//----------------------------------------------------------------------------
+
+namespace ts {
+
+#if defined(TS_LINUX)
+    // Layout of the shared memory object. The header is followed by the
+    // ring of TS packets, contiguous as in the tsp packet buffer.
+    class ShmHeader
+    {
+    public:
+        // State of one reader.
+        class Reader
+        {
+        public:
+            std::atomic<uint32_t> pid;         // Reader process id, zero if the slot is free.
+            std::atomic<uint64_t> read_count;  // Total number of packets read.
+        };
+
+        char                  magic[8];        // SHM_MAGIC, set last when initialized.
+        uint32_t              header_size;     // Offset of the packet ring.
+        uint32_t              reliable;        // Non-zero if the producer never overwrites unread packets.
+        uint64_t              ring_packets;    // Number of packets in the ring.
+        std::atomic<uint32_t> producer;        // Producer process id.
+        std::atomic<uint32_t> ended;           // Non-zero at end of stream.
+        std::atomic<uint64_t> write_count;     // Total number of packets written, readable.
+        std::atomic<uint64_t> write_reserved;  // Total number of packets being written, may be overwritten.
+        std::atomic<uint64_t> bitrate;         // Bitrate of the stream, zero if unknown.
+        std::atomic<uint32_t> data_seq;        // Futex, incremented when packets are written or at end of stream.
+        std::atomic<uint32_t> data_waiters;    // Number of readers waiting on data_seq.
+        std::atomic<uint32_t> space_seq;       // Futex, incremented when a reader progresses.
+        std::atomic<uint32_t> space_waiters;   // Number of producers waiting on space_seq.
+        Reader                readers[MAX_READERS];
+    };
+
+    // Mapping of a shared memory object, common to input and output.
+    class ShmMapping
+    {
+    public:
+        ShmMapping();
+        ~ShmMapping();
+
+        // Create a new shared memory object (producer). Return false on error.
+        bool create(const std::string& name, size_t ring_packets, bool reliable, Report& report);
+
+        // Open an existing shared memory object (reader). Set found to false if it does not exist yet.
+        bool open(const std::string& name, bool& found, Report& report);
+
+        // Unmap the shared memory, unlink it if it was created.
+        void close();
+
+        // Access to the shared memory.
+        ShmHeader* header() const { return _header; }
+        TSPacket* ring() const { return _ring; }
+        size_t ringPackets() const { return _ring_packets; }
+
+        // Wait on a futex while its value is seq, at most WAIT_TIMEOUT milliseconds.
+        static void Wait(std::atomic<uint32_t>& futex, uint32_t seq);
+
+        // Increment a futex and wake up all waiters, if any.
+        static void Wake(std::atomic<uint32_t>& futex, std::atomic<uint32_t>& waiters);
+
+        // Check if a process still exists.
+        static bool ProcessExists(uint32_t pid);
+
+    private:
+        std::string _name;          // Name of the shared memory object.
+        bool        _created;       // The shared memory object was created by us.
+        void*       _base;          // Base address of the mapping.
+        size_t      _size;          // Size of the mapping.
+        ShmHeader*  _header;
+        TSPacket*   _ring;
+        size_t      _ring_packets;
+
+        // Inaccessible operations
+        ShmMapping(const ShmMapping&) = delete;
+        ShmMapping& operator=(const ShmMapping&) = delete;
+    };
+#endif
+
+    // Input plugin
+    class ShmInput: public InputPlugin
+    {
+    public:
+        // Implementation of plugin API
+        ShmInput(TSP*);
+        virtual bool start() override;
+        virtual bool stop() override;
+        virtual size_t receive(TSPacket*, size_t) override;
+        virtual BitRate getBitrate() override;
+    private:
+#if defined(TS_LINUX)
+        std::string   _name;        // Name of the shared memory object.
+        bool          _wait;        // Wait for the producer to create the shared memory.
+        ShmMapping    _shm;
+        ShmHeader::Reader* _slot;   // Our reader slot in the shared memory.
+        uint64_t      _read_count;  // Total number of packets read, including lost ones.
+        PacketCounter _lost;        // Total number of lost packets.
+
+        // Register in a free reader slot.
+        bool registerReader();
+#endif
+
+        // Inaccessible operations
+        ShmInput() = delete;
+        ShmInput(const ShmInput&) = delete;
+        ShmInput& operator=(const ShmInput&) = delete;
+    };
+
+    // Output plugin
+    class ShmOutput: public OutputPlugin
+    {
+    public:
+        // Implementation of plugin API
+        ShmOutput(TSP*);
+        virtual bool start() override;
+        virtual bool stop() override;
+        virtual bool send(const TSPacket*, size_t) override;
+    private:
+#if defined(TS_LINUX)
+        ShmMapping _shm;
+        size_t     _min_readers;  // Wait for this number of readers before the first packet.
+        uint64_t   _write_count;  // Total number of packets written.
+
+        // Get the number of active readers.
+        size_t activeReaders();
+
+        // Get the number of free packets in the ring, in reliable mode.
+        size_t freePackets();
+#endif
+
+        // Inaccessible operations
+        ShmOutput() = delete;
+        ShmOutput(const ShmOutput&) = delete;
+        ShmOutput& operator=(const ShmOutput&) = delete;
+    };
+}
+
+TSPLUGIN_DECLARE_VERSION
+TSPLUGIN_DECLARE_INPUT(shm, ts::ShmInput)
+TSPLUGIN_DECLARE_OUTPUT(shm, ts::ShmOutput)
+
+
+//----------------------------------------------------------------------------
+// Input plugin constructor
+//----------------------------------------------------------------------------
+
+ts::ShmInput::ShmInput(TSP* tsp_) :
+    InputPlugin(tsp_, u"Receive TS packets from another tsp process through shared memory (Linux only).", u"[options] name")
+#if defined(TS_LINUX)
+    ,
+    _name(),
+    _wait(false),
+    _shm(),
+    _slot(0),
+    _read_count(0),
+    _lost(0)
+#endif
+{
+    option(u"",     0,  STRING, 1, 1);
+    option(u"wait", 'w');
+
+    setHelp(u"Parameter:\n"
+            u"  Name of the shared memory object, as specified in the shm output plugin of\n"
+            u"  the producer tsp process. Several tsp processes can receive the same stream\n"
+            u"  from the same producer, up to " TS_USTRINGIFY(MAX_READERS) u" at a time.\n"
+            u"\n"
+            u"  The reception starts at the current position of the producer. When the\n"
+            u"  producer is not in --reliable mode, a too slow reader loses packets.\n"
+            u"\n"
+            u"Options:\n"
+            u"\n"
+            u"  --help\n"
+            u"      Display this help text.\n"
+            u"\n"
+            u"  --version\n"
+            u"      Display the version number.\n"
+            u"\n"
+            u"  -w\n"
+            u"  --wait\n"
+            u"      Wait for the producer when the shared memory object does not exist yet.\n"
+            u"      By default, this is an error.\n");
+}
+
+
+//----------------------------------------------------------------------------
+// Output plugin constructor
+//----------------------------------------------------------------------------
+
+ts::ShmOutput::ShmOutput(TSP* tsp_) :
+    OutputPlugin(tsp_, u"Send TS packets to other tsp processes through shared memory (Linux only).", u"[options] name")
+#if defined(TS_LINUX)
+    ,
+    _shm(),
+    _min_readers(0),
+    _write_count(0)
+#endif
+{
+    option(u"",         0,  STRING, 1, 1);
+    option(u"packets", 'p', INTEGER, 0, 1, 1024, 16 * 1024 * 1024);
+    option(u"readers", 'r', INTEGER, 0, 1, 1, MAX_READERS);
+    option(u"reliable", 0);
+
+    setHelp(u"Parameter:\n"
+            u"  Name of the shared memory object. Other tsp processes receive the stream\n"
+            u"  using the shm input plugin with the same name. The TS packets are stored in\n"
+            u"  a ring in shared memory, contiguous as in the tsp packet buffer. The readers\n"
+            u"  copy them directly from the ring into their own packet buffer, there is no\n"
+            u"  system call per packet. The shared memory object is " SHM_PREFIX u"name and it\n"
+            u"  is removed when the plugin stops. A previous object with the same name is\n"
+            u"  replaced.\n"
+            u"\n"
+            u"Options:\n"
+            u"\n"
+            u"  --help\n"
+            u"      Display this help text.\n"
+            u"\n"
+            u"  -p value\n"
+            u"  --packets value\n"
+            u"      Number of TS packets in the ring. The default is " TS_USTRINGIFY(DEF_RING_PACKETS) u" packets.\n"
+            u"\n"
+            u"  -r value\n"
+            u"  --readers value\n"
+            u"      Wait until this number of readers are receiving before sending the first\n"
+            u"      packet. Since the readers start at the current position of the producer,\n"
+            u"      this is the way to make sure that they receive the complete stream.\n"
+            u"\n"
+            u"  --reliable\n"
+            u"      Wait for the slowest reader instead of overwriting the packets which were\n"
+            u"      not yet read by all readers. By default, the output never waits and a\n"
+            u"      too slow reader loses packets. Use this option when the producer is not\n"
+            u"      a real-time source, typically a file.\n"
+            u"\n"
+            u"  --version\n"
+            u"      Display the version number.\n");
+}
+
+
+#if !defined(TS_LINUX)
+
+//----------------------------------------------------------------------------
+// Stubs on unsupported platforms.
+//----------------------------------------------------------------------------
+
+bool ts::ShmInput::start()
+{
+    tsp->error(u"the shm plugin is available on Linux only");
+    return false;
+}
+
+bool ts::ShmInput::stop()
+{
+    return true;
+}
+
+size_t ts::ShmInput::receive(TSPacket* buffer, size_t max_packets)
+{
+    return 0;
+}
+
+ts::BitRate ts::ShmInput::getBitrate()
+{
+    return 0;
+}
+
+bool ts::ShmOutput::start()
+{
+    tsp->error(u"the shm plugin is available on Linux only");
+    return false;
+}
+
+bool ts::ShmOutput::stop()
+{
+    return true;
+}
+
+bool ts::ShmOutput::send(const TSPacket* buffer, size_t packet_count)
+{
+    return false;
+}
+
+#else
+
+//----------------------------------------------------------------------------
+// Shared memory mapping.
+//----------------------------------------------------------------------------
+
+ts::ShmMapping::ShmMapping() :
+    _name(),
+    _created(false),
+    _base(MAP_FAILED),
+    _size(0),
+    _header(0),
+    _ring(0),
+    _ring_packets(0)
+{
+}
+
+ts::ShmMapping::~ShmMapping()
+{
+    close();
+}
+
+bool ts::ShmMapping::create(const std::string& name, size_t ring_packets, bool reliable, Report& report)
+{
+    close();
+
+    // The packet ring starts on a page boundary.
+    const size_t page = SysInfo::Instance()->memoryPageSize();
+    const size_t header_size = page * ((sizeof(ShmHeader) + page - 1) / page);
+    const size_t size = header_size + ring_packets * PKT_SIZE;
+
+    // Always create a new object. Readers of a previous producer keep their mapping until they see its end.
+    ::shm_unlink(name.c_str());
+    const int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0666);
+    if (fd < 0) {
+        report.error(u"error creating shared memory %s: %s", {name, ErrorCodeMessage()});
+        return false;
+    }
+    if (::ftruncate(fd, ::off_t(size)) < 0) {
+        report.error(u"error resizing shared memory %s: %s", {name, ErrorCodeMessage()});
+        ::close(fd);
+        ::shm_unlink(name.c_str());
+        return false;
+    }
+    _base = ::mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (_base == MAP_FAILED) {
+        report.error(u"error mapping shared memory %s: %s", {name, ErrorCodeMessage()});
+        ::shm_unlink(name.c_str());
+        return false;
+    }
+
+    _name = name;
+    _created = true;
+    _size = size;
+    _header = reinterpret_cast<ShmHeader*>(_base);
+    _ring = reinterpret_cast<TSPacket*>(reinterpret_cast<uint8_t*>(_base) + header_size);
+    _ring_packets = ring_packets;
+
+    // The new object is filled with zeroes, all readers slots are free.
+    _header->header_size = uint32_t(header_size);
+    _header->reliable = reliable;
+    _header->ring_packets = ring_packets;
+    _header->producer = uint32_t(::getpid());
+
+    // The magic string is set last, the readers ignore the object before.
+    std::atomic_thread_fence(std::memory_order_release);
+    ::memcpy(_header->magic, SHM_MAGIC, sizeof(_header->magic));
+    return true;
+}
+
+bool ts::ShmMapping::open(const std::string& name, bool& found, Report& report)
+{
+    close();
+    found = false;
+
+    const int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        if (errno == ENOENT) {
+            return true;
+        }
+        report.error(u"error opening shared memory %s: %s", {name, ErrorCodeMessage()});
+        return false;
+    }
+
+    // The producer may not have completed the initialization, do not complain yet.
+    struct ::stat st;
+    if (::fstat(fd, &st) < 0 || size_t(st.st_size) < sizeof(ShmHeader)) {
+        ::close(fd);
+        return true;
+    }
+    _base = ::mmap(0, size_t(st.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (_base == MAP_FAILED) {
+        report.error(u"error mapping shared memory %s: %s", {name, ErrorCodeMessage()});
+        return false;
+    }
+    _size = size_t(st.st_size);
+    _header = reinterpret_cast<ShmHeader*>(_base);
+    if (::memcmp(_header->magic, SHM_MAGIC, sizeof(_header->magic)) != 0) {
+        close();
+        return true;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (_header->header_size < sizeof(ShmHeader) || _header->header_size + _header->ring_packets * PKT_SIZE > _size) {
+        report.error(u"invalid shared memory %s", {name});
+        close();
+        return false;
+    }
+
+    _name = name;
+    _ring = reinterpret_cast<TSPacket*>(reinterpret_cast<uint8_t*>(_base) + _header->header_size);
+    _ring_packets = size_t(_header->ring_packets);
+    found = true;
+    return true;
+}
+
+void ts::ShmMapping::close()
+{
+    if (_base != MAP_FAILED) {
+        ::munmap(_base, _size);
+    }
+    if (_created) {
+        ::shm_unlink(_name.c_str());
+    }
+    _name.clear();
+    _created = false;
+    _base = MAP_FAILED;
+    _size = 0;
+    _header = 0;
+    _ring = 0;
+    _ring_packets = 0;
+}
+
+void ts::ShmMapping::Wait(std::atomic<uint32_t>& futex, uint32_t seq)
+{
+    // The futex is shared between processes, do not use FUTEX_PRIVATE_FLAG.
+    ::timespec timeout;
+    timeout.tv_sec = WAIT_TIMEOUT / 1000;
+    timeout.tv_nsec = (WAIT_TIMEOUT % 1000) * 1000000;
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&futex), FUTEX_WAIT, seq, &timeout, 0, 0);
+}
+
+void ts::ShmMapping::Wake(std::atomic<uint32_t>& futex, std::atomic<uint32_t>& waiters)
+{
+    futex++;
+    if (waiters.load() > 0) {
+        ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&futex), FUTEX_WAKE, INT_MAX, 0, 0, 0);
+    }
+}
+
+bool ts::ShmMapping::ProcessExists(uint32_t pid)
+{
+    return ::kill(::pid_t(pid), 0) == 0 || errno != ESRCH;
+}
+
+
+//----------------------------------------------------------------------------
+// Input plugin start / stop.
+//----------------------------------------------------------------------------
+
+bool ts::ShmInput::start()
+{
+    _name = SHM_PREFIX + value(u"").toUTF8();
+    _wait = present(u"wait");
+    _read_count = 0;
+    _lost = 0;
+
+    // Wait for the producer to create the shared memory.
+    bool found = false;
+    bool first = true;
+    while (_shm.open(_name, found, *tsp) && !found) {
+        if (!_wait) {
+            tsp->error(u"shared memory %s not found, no producer", {_name});
+            return false;
+        }
+        if (first) {
+            tsp->verbose(u"waiting for producer on shared memory %s", {_name});
+            first = false;
+        }
+        if (tsp->aborting()) {
+            return false;
+        }
+        SleepThread(WAIT_TIMEOUT);
+    }
+    return found && registerReader();
+}
+
+bool ts::ShmInput::stop()
+{
+    if (_slot != 0) {
+        _slot->pid = 0;
+        _slot = 0;
+    }
+    _shm.close();
+    if (_lost > 0) {
+        tsp->warning(u"lost %'d packets, reader too slow", {_lost});
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Register the input plugin in a free reader slot.
+//----------------------------------------------------------------------------
+
+bool ts::ShmInput::registerReader()
+{
+    ShmHeader* hdr = _shm.header();
+    const uint32_t self = uint32_t(::getpid());
+
+    for (size_t i = 0; _slot == 0 && i < MAX_READERS; ++i) {
+        ShmHeader::Reader& rd(hdr->readers[i]);
+        uint32_t pid = rd.pid.load();
+        // Reuse the slots of dead readers.
+        if ((pid == 0 || !ShmMapping::ProcessExists(pid)) && rd.pid.compare_exchange_strong(pid, self)) {
+            _slot = &rd;
+        }
+    }
+    if (_slot == 0) {
+        tsp->error(u"too many readers on shared memory %s, max: %d", {_name, MAX_READERS});
+        _shm.close();
+        return false;
+    }
+
+    // Start at the current position of the producer.
+    _read_count = hdr->write_count.load();
+    _slot->read_count = _read_count;
+    ShmMapping::Wake(hdr->space_seq, hdr->space_waiters);
+    tsp->verbose(u"receiving from shared memory %s, %'d packets, producer process %d", {_name, _shm.ringPackets(), hdr->producer.load()});
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Input plugin methods.
+//----------------------------------------------------------------------------
+
+ts::BitRate ts::ShmInput::getBitrate()
+{
+    return _shm.header() == 0 ? 0 : BitRate(_shm.header()->bitrate.load());
+}
+
+size_t ts::ShmInput::receive(TSPacket* buffer, size_t max_packets)
+{
+    ShmHeader* hdr = _shm.header();
+    const size_t ring_packets = _shm.ringPackets();
+
+    for (;;) {
+        const uint64_t available = hdr->write_count.load(std::memory_order_acquire);
+
+        if (available > _read_count) {
+            // Skip packets which were overwritten by the producer.
+            if (available - _read_count > ring_packets) {
+                _lost += available - ring_packets - _read_count;
+                _read_count = available - ring_packets;
+            }
+
+            // Copy contiguous packets from the ring.
+            const size_t index = size_t(_read_count % ring_packets);
+            const size_t count = size_t(std::min<uint64_t>(available - _read_count, std::min(max_packets, ring_packets - index)));
+            ::memcpy(buffer->b, _shm.ring()[index].b, count * PKT_SIZE);
+
+            // Check that the producer did not overwrite the packets during the copy.
+            std::atomic_thread_fence(std::memory_order_acquire);
+            const uint64_t reserved = hdr->write_reserved.load(std::memory_order_relaxed);
+            if (reserved - _read_count > ring_packets) {
+                continue;
+            }
+
+            _read_count += count;
+            _slot->read_count.store(_read_count, std::memory_order_release);
+            if (hdr->reliable) {
+                ShmMapping::Wake(hdr->space_seq, hdr->space_waiters);
+            }
+            return count;
+        }
+
+        // End of stream when the producer has terminated and all packets are read.
+        if (hdr->ended.load() != 0) {
+            return 0;
+        }
+        if (!ShmMapping::ProcessExists(hdr->producer.load())) {
+            tsp->error(u"producer process %d terminated without end of stream", {hdr->producer.load()});
+            return 0;
+        }
+        if (tsp->aborting()) {
+            return 0;
+        }
+
+        // Wait for the producer. The futex is read before checking the
+        // state again, any subsequent update is seen in Wait().
+        hdr->data_waiters++;
+        const uint32_t seq = hdr->data_seq.load();
+        if (hdr->write_count.load() == _read_count && hdr->ended.load() == 0) {
+            ShmMapping::Wait(hdr->data_seq, seq);
+        }
+        hdr->data_waiters--;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Output plugin start / stop.
+//----------------------------------------------------------------------------
+
+bool ts::ShmOutput::start()
+{
+    const std::string name(SHM_PREFIX + value(u"").toUTF8());
+    const size_t ring_packets = intValue<size_t>(u"packets", DEF_RING_PACKETS);
+    _min_readers = intValue<size_t>(u"readers", 0);
+    _write_count = 0;
+
+    if (!_shm.create(name, ring_packets, present(u"reliable"), *tsp)) {
+        return false;
+    }
+    tsp->verbose(u"sending to shared memory %s, %'d packets", {name, ring_packets});
+    return true;
+}
+
+bool ts::ShmOutput::stop()
+{
+    ShmHeader* hdr = _shm.header();
+    if (hdr != 0) {
+        // Signal the end of stream to the readers. They keep their mapping after the object is removed.
+        hdr->ended = 1;
+        ShmMapping::Wake(hdr->data_seq, hdr->data_waiters);
+        tsp->verbose(u"%'d packets sent, %d active readers", {_write_count, activeReaders()});
+    }
+    _shm.close();
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Get the number of active readers.
+//----------------------------------------------------------------------------
+
+size_t ts::ShmOutput::activeReaders()
+{
+    ShmHeader* hdr = _shm.header();
+    size_t count = 0;
+    for (size_t i = 0; i < MAX_READERS; ++i) {
+        if (hdr->readers[i].pid.load() != 0) {
+            count++;
+        }
+    }
+    return count;
+}
+
+
+//----------------------------------------------------------------------------
+// Get the number of free packets in the ring, in reliable mode.
+//----------------------------------------------------------------------------
+
+size_t ts::ShmOutput::freePackets()
+{
+    ShmHeader* hdr = _shm.header();
+    uint64_t oldest = _write_count;
+
+    for (size_t i = 0; i < MAX_READERS; ++i) {
+        ShmHeader::Reader& rd(hdr->readers[i]);
+        uint32_t pid = rd.pid.load();
+        if (pid != 0) {
+            if (!ShmMapping::ProcessExists(pid)) {
+                // Release the slot of a dead reader, it would block the stream forever.
+                rd.pid.compare_exchange_strong(pid, 0);
+            }
+            else {
+                oldest = std::min(oldest, rd.read_count.load(std::memory_order_acquire));
+            }
+        }
+    }
+    return _shm.ringPackets() - size_t(_write_count - oldest);
+}
+
+
+//----------------------------------------------------------------------------
+// Output plugin send method.
+//----------------------------------------------------------------------------
+
+bool ts::ShmOutput::send(const TSPacket* buffer, size_t packet_count)
+{
+    ShmHeader* hdr = _shm.header();
+    const size_t ring_packets = _shm.ringPackets();
+    hdr->bitrate = uint64_t(tsp->bitrate());
+
+    // Wait for the expected readers before the first packet.
+    if (_min_readers > 0) {
+        tsp->verbose(u"waiting for %d readers", {_min_readers});
+        for (;;) {
+            hdr->space_waiters++;
+            const uint32_t seq = hdr->space_seq.load();
+            const bool wait = activeReaders() < _min_readers && !tsp->aborting();
+            if (wait) {
+                ShmMapping::Wait(hdr->space_seq, seq);
+            }
+            hdr->space_waiters--;
+            if (!wait) {
+                break;
+            }
+        }
+        if (tsp->aborting()) {
+            return false;
+        }
+        _min_readers = 0;
+    }
+
+    while (packet_count > 0) {
+
+        // Number of packets we can write without overwriting unread ones.
+        size_t count = packet_count;
+        if (hdr->reliable) {
+            hdr->space_waiters++;
+            const uint32_t seq = hdr->space_seq.load();
+            count = std::min(count, freePackets());
+            if (count == 0 && !tsp->aborting()) {
+                ShmMapping::Wait(hdr->space_seq, seq);
+            }
+            hdr->space_waiters--;
+            if (tsp->aborting()) {
+                return false;
+            }
+            if (count == 0) {
+                continue;
+            }
+        }
+
+        // Copy contiguous packets into the ring.
+        const size_t index = size_t(_write_count % ring_packets);
+        count = std::min(count, ring_packets - index);
+
+        // Readers which copy the same area see the reservation after the copy.
+        hdr->write_reserved.store(_write_count + count, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        ::memcpy(_shm.ring()[index].b, buffer->b, count * PKT_SIZE);
+
+        // Publish the new packets.
+        _write_count += count;
+        hdr->write_count.store(_write_count, std::memory_order_release);
+        ShmMapping::Wake(hdr->data_seq, hdr->data_waiters);
+
+        buffer += count;
+        packet_count -= count;
+    }
+    return true;
+}
+
+#endif // TS_LINUX
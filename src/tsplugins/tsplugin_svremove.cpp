@@ -28,7 +28,7 @@
 //----------------------------------------------------------------------------
 //
 //  Transport stream processor shared library:
-//  Remove a service
+//  Remove services
 //
 //----------------------------------------------------------------------------
 
@@ -56,16 +56,23 @@ namespace ts {
         virtual Status processPacket(TSPacket&, bool&, bool&) override;
 
     private:
+        typedef std::set<uint16_t> ServiceIdSet;
+
         bool              _abort;          // Error (service not found, etc)
         bool              _ready;          // Ready to pass packets
         bool              _transparent;    // Transparent mode, pass all packets
-        Service           _service;        // Service name & id
+        bool              _pat_found;      // A PAT was processed
+        std::vector<Service> _services;    // Services to remove (name & id)
+        ServiceIdSet      _service_ids;    // Ids of all services to remove
+        ServiceIdSet      _pending_pmts;   // Ids of removed services with PMT not yet analyzed
+        size_t            _unknown_ids;    // Number of services with unknown id (name only)
         bool              _ignore_absent;  // Ignore service if absent
         bool              _ignore_bat;     // Do not modify the BAT
         bool              _ignore_nit;     // Do not modify the NIT
         Status            _drop_status;    // Status for dropped packets
-        PIDSet            _drop_pids;      // List of PIDs to drop
+        PIDSet            _drop_pids;      // List of PIDs in removed services
         PIDSet            _ref_pids;       // List of other referenced PIDs
+        PIDSet            _removed_pids;   // PIDs to remove: in _drop_pids and not in _ref_pids
         SectionDemux      _demux;          // Section demux
         CyclingPacketizer _pzer_pat;       // Packetizer for modified PAT
         CyclingPacketizer _pzer_sdt_bat;   // Packetizer for modified SDT/BAT
@@ -74,12 +81,27 @@ namespace ts {
         // Invoked by the demux when a complete table is available.
         virtual void handleTable(SectionDemux&, const BinaryTable&) override;
 
-        // Process specific tables and descriptors
-        void processPAT(PAT&);
-        void processSDT(SDT&);
-        void processPMT(PMT&);
-        void processNITBAT(AbstractTransportListTable&);
-        void processNITBATDescriptorList (DescriptorList&);
+        // Process specific tables
+        void processPAT(const BinaryTable&);
+        void processSDT(const BinaryTable&);
+        void processPMT(const PMT&);
+
+        // Check if a service id is removed.
+        bool isRemoved(uint16_t id) const { return _service_ids.find(id) != _service_ids.end(); }
+
+        // Start filtering the PAT and NIT once all service ids are known.
+        void startPAT();
+
+        // Build a copy of a PAT or SDT without the entries of removed services.
+        // Each section payload starts with a header of header_size bytes, followed by service entries.
+        // The service id is in the first two bytes of each entry. The last two bytes of an entry
+        // contain a descriptor loop length when has_descs is true.
+        void removeServiceEntries(const BinaryTable& table, BinaryTable& result, size_t header_size, size_t entry_size, bool has_descs, ServiceIdSet* found);
+
+        // Build a copy of a NIT or BAT without the removed services in service_list_descriptors
+        // and logical_channel_number_descriptors.
+        void removeNITBATServices(const BinaryTable& table, BinaryTable& result);
+        void removeDescriptorLoopServices(const uint8_t* data, size_t size, ByteBlock& out);
 
         // Mark all ECM PIDs from the specified descriptor list in the specified PID set
         void addECMPID(const DescriptorList&, PIDSet&);
@@ -100,33 +122,39 @@ TSPLUGIN_DECLARE_PROCESSOR(svremove, ts::SVRemovePlugin)
 //----------------------------------------------------------------------------
 
 ts::SVRemovePlugin::SVRemovePlugin (TSP* tsp_) :
-    ProcessorPlugin(tsp_, u"Remove a service.", u"[options] service"),
+    ProcessorPlugin(tsp_, u"Remove services.", u"[options] service ..."),
     _abort(false),
     _ready(false),
     _transparent(false),
-    _service(),
+    _pat_found(false),
+    _services(),
+    _service_ids(),
+    _pending_pmts(),
+    _unknown_ids(0),
     _ignore_absent(false),
     _ignore_bat(false),
     _ignore_nit(false),
     _drop_status(TSP_DROP),
     _drop_pids(),
     _ref_pids(),
+    _removed_pids(),
     _demux(this),
     _pzer_pat(PID_PAT, CyclingPacketizer::ALWAYS),
     _pzer_sdt_bat(PID_SDT, CyclingPacketizer::ALWAYS),
     _pzer_nit(PID_NIT, CyclingPacketizer::ALWAYS)
 {
-    option(u"",               0,  STRING, 1, 1);
+    option(u"",               0,  STRING, 1, UNLIMITED_COUNT);
     option(u"ignore-absent", 'a');
     option(u"ignore-bat",    'b');
     option(u"ignore-nit",    'n');
     option(u"stuffing",      's');
 
-    setHelp(u"Service:\n"
-            u"  Specifies the service to remove. If the argument is an integer value\n"
-            u"  (either decimal or hexadecimal), it is interpreted as a service id.\n"
-            u"  Otherwise, it is interpreted as a service name, as specified in the SDT.\n"
-            u"  The name is not case sensitive and blanks are ignored.\n"
+    setHelp(u"Services:\n"
+            u"  Specifies the services to remove. Several services can be removed in\n"
+            u"  one single pass. If an argument is an integer value (either decimal or\n"
+            u"  hexadecimal), it is interpreted as a service id. Otherwise, it is\n"
+            u"  interpreted as a service name, as specified in the SDT. The name is not\n"
+            u"  case sensitive and blanks are ignored.\n"
             u"\n"
             u"Options:\n"
             u"\n"
@@ -135,8 +163,8 @@ ts::SVRemovePlugin::SVRemovePlugin (TSP* tsp_) :
             u"\n"
             u"  -a\n"
             u"  --ignore-absent\n"
-            u"      Ignore service if not present in the transport stream. By default, tsp\n"
-            u"      fails if the service is not found.\n"
+            u"      Ignore services which are not present in the transport stream. By\n"
+            u"      default, tsp fails if a service is not found.\n"
             u"\n"
             u"  -b\n"
             u"  --ignore-bat\n"
@@ -163,7 +191,20 @@ ts::SVRemovePlugin::SVRemovePlugin (TSP* tsp_) :
 bool ts::SVRemovePlugin::start()
 {
     // Get option values
-    _service.set (value(u""));
+    _services.clear();
+    _service_ids.clear();
+    _unknown_ids = 0;
+    const size_t count = this->count(u"");
+    for (size_t i = 0; i < count; ++i) {
+        const Service srv(value(u"", u"", i));
+        _services.push_back(srv);
+        if (srv.hasId()) {
+            _service_ids.insert(srv.getId());
+        }
+        else {
+            _unknown_ids++;
+        }
+    }
     _ignore_absent = present(u"ignore-absent");
     _ignore_bat = present(u"ignore-bat");
     _ignore_nit = present(u"ignore-nit");
@@ -171,21 +212,19 @@ bool ts::SVRemovePlugin::start()
 
     // Initialize the demux
     _demux.reset();
-    _demux.addPID (PID_SDT);
+    _demux.setPIDFilter(NoPID);
+    _demux.addPID(PID_SDT);
 
-    // When the service id is known, we wait for the PAT. If it is not yet
+    // When all service ids are known, we wait for the PAT. If some are not yet
     // known (only the service name is known), we do not know how to modify
     // the PAT. We will wait for it after receiving the SDT.
     // Packets from PAT PID are analyzed but not passed. When a complete
     // PAT is read, a modified PAT will be transmitted.
-    if (_service.hasId()) {
-        _demux.addPID (PID_PAT);
-        if (!_ignore_nit) {
-            _demux.addPID(PID_NIT);
-        }
+    if (_unknown_ids == 0) {
+        startPAT();
     }
 
-    // Build a list of referenced PID's (except those in the removed service).
+    // Build a list of referenced PID's (except those in the removed services).
     // Prevent predefined PID's from being removed.
     _ref_pids.reset();
     _ref_pids.set(PID_PAT);
@@ -208,7 +247,10 @@ bool ts::SVRemovePlugin::start()
     _abort = false;
     _ready = false;
     _transparent = false;
+    _pat_found = false;
+    _pending_pmts.clear();
     _drop_pids.reset();
+    _removed_pids.reset();
     _pzer_pat.reset();
     _pzer_sdt_bat.reset();
     _pzer_nit.reset();
@@ -217,11 +259,24 @@ bool ts::SVRemovePlugin::start()
 }
 
 
+//----------------------------------------------------------------------------
+// Start filtering the PAT and NIT once all service ids are known.
+//----------------------------------------------------------------------------
+
+void ts::SVRemovePlugin::startPAT()
+{
+    _demux.addPID(PID_PAT);
+    if (!_ignore_nit) {
+        _demux.addPID(PID_NIT);
+    }
+}
+
+
 //----------------------------------------------------------------------------
 // Invoked by the demux when a complete table is available.
 //----------------------------------------------------------------------------
 
-void ts::SVRemovePlugin::handleTable (SectionDemux& demux, const BinaryTable& table)
+void ts::SVRemovePlugin::handleTable(SectionDemux& demux, const BinaryTable& table)
 {
     if (tsp->debug()) {
         tsp->debug(u"Got %s v%d, PID %d (0x%X), TIDext %d (0x%X)",
@@ -234,10 +289,7 @@ void ts::SVRemovePlugin::handleTable (SectionDemux& demux, const BinaryTable& ta
 
         case TID_PAT: {
             if (table.sourcePID() == PID_PAT) {
-                PAT pat(table);
-                if (pat.isValid()) {
-                    processPAT(pat);
-                }
+                processPAT(table);
             }
             break;
         }
@@ -252,10 +304,7 @@ void ts::SVRemovePlugin::handleTable (SectionDemux& demux, const BinaryTable& ta
 
         case TID_SDT_ACT: {
             if (table.sourcePID() == PID_SDT) {
-                SDT sdt(table);
-                if (sdt.isValid()) {
-                    processSDT(sdt);
-                }
+                processSDT(table);
             }
             break;
         }
@@ -271,12 +320,12 @@ void ts::SVRemovePlugin::handleTable (SectionDemux& demux, const BinaryTable& ta
 
         case TID_BAT:
             if (table.sourcePID() == PID_BAT) {
-                if (!_service.hasId()) {
+                if (_unknown_ids > 0) {
                     // The BAT and SDT are on the same PID. Here, we are in the case
-                    // were the service was designated by name and the first BAT arrives
-                    // before the first SDT. We do not know yet how to modify the BAT.
-                    // Reset the demux on this PID, so that this BAT will be submitted
-                    // again the next time.
+                    // were some services were designated by name and the first BAT
+                    // arrives before the first SDT. We do not know yet how to modify
+                    // the BAT. Reset the demux on this PID, so that this BAT will be
+                    // submitted again the next time.
                     _demux.resetPID(table.sourcePID());
                 }
                 else if (_ignore_bat) {
@@ -286,12 +335,10 @@ void ts::SVRemovePlugin::handleTable (SectionDemux& demux, const BinaryTable& ta
                 }
                 else {
                     // Modify BAT
-                    BAT bat(table);
-                    if (bat.isValid()) {
-                        processNITBAT(bat);
-                        _pzer_sdt_bat.removeSections(TID_BAT, bat.bouquet_id);
-                        _pzer_sdt_bat.addTable(bat);
-                    }
+                    BinaryTable bat;
+                    removeNITBATServices(table, bat);
+                    _pzer_sdt_bat.removeSections(TID_BAT, table.tableIdExtension());
+                    _pzer_sdt_bat.addTable(bat);
                 }
             }
             break;
@@ -305,12 +352,10 @@ void ts::SVRemovePlugin::handleTable (SectionDemux& demux, const BinaryTable& ta
                 }
                 else {
                     // Modify NIT Actual
-                    NIT nit(table);
-                    if (nit.isValid()) {
-                        processNITBAT(nit);
-                        _pzer_nit.removeSections(TID_NIT_ACT, nit.network_id);
-                        _pzer_nit.addTable(nit);
-                    }
+                    BinaryTable nit;
+                    removeNITBATServices(table, nit);
+                    _pzer_nit.removeSections(TID_NIT_ACT, table.tableIdExtension());
+                    _pzer_nit.addTable(nit);
                 }
             }
             break;
@@ -336,49 +381,61 @@ void ts::SVRemovePlugin::handleTable (SectionDemux& demux, const BinaryTable& ta
 //  This method processes a Service Description Table (SDT).
 //----------------------------------------------------------------------------
 
-void ts::SVRemovePlugin::processSDT (SDT& sdt)
+void ts::SVRemovePlugin::processSDT(const BinaryTable& table)
 {
-    bool found = false;
-
-    // Look for the service by name or by id
-    if (_service.hasId()) {
-        // Search service by id
-        found = sdt.services.find(_service.getId()) != sdt.services.end();
-        if (!found) {
-            // Informational only, SDT entry is not mandatory.
-            tsp->info(u"service %d (0x%X) not found in SDT, ignoring it", {_service.getId(), _service.getId()});
+    // Services which are designated by name are searched in the SDT.
+    if (_unknown_ids > 0) {
+        const SDT sdt(table);
+        if (!sdt.isValid()) {
+            return;
         }
-    }
-    else {
-        // Service id is currently unknown, search service by name
-        found = sdt.findService(_service);
-        if (!found) {
-            // Here, this is an error. A service can be searched by name only in current TS
-            if (_ignore_absent) {
-                tsp->warning(u"service \"%s\" not found in SDT, ignoring it", {_service.getName()});
-                _transparent = true;
+        for (std::vector<Service>::iterator it = _services.begin(); it != _services.end(); ) {
+            if (it->hasId()) {
+                ++it;
+            }
+            else if (sdt.findService(*it)) {
+                tsp->verbose(u"found service \"%s\", service id is 0x%X", {it->getName(), it->getId()});
+                _service_ids.insert(it->getId());
+                _unknown_ids--;
+                ++it;
+            }
+            else if (_ignore_absent) {
+                // A service can be searched by name only in current TS.
+                tsp->warning(u"service \"%s\" not found in SDT, ignoring it", {it->getName()});
+                it = _services.erase(it);
+                _unknown_ids--;
             }
             else {
-                tsp->error(u"service \"%s\" not found in SDT", {_service.getName()});
+                tsp->error(u"service \"%s\" not found in SDT", {it->getName()});
                 _abort = true;
+                return;
             }
-            return;
         }
-        // The service id was previously unknown, now wait for the PAT
-        _demux.addPID (PID_PAT);
-        if (!_ignore_nit) {
-            _demux.addPID(PID_NIT);
+        if (_services.empty()) {
+            // All services were ignored, nothing to remove.
+            _transparent = true;
+            return;
         }
-        tsp->verbose(u"found service \"%s\", service id is 0x%X", {_service.getName(), _service.getId()});
+        // All service ids are now known, now wait for the PAT.
+        startPAT();
     }
 
-    // Remove service description in the SDT
-    if (_service.hasId()) {
-        sdt.services.erase(_service.getId());
+    // Remove the descriptions of the services in the SDT, directly in the binary sections.
+    // The SDT header is 3 bytes (original_network_id + reserved). Each service entry
+    // is 5 bytes, including the descriptor loop length, followed by the descriptors.
+    ServiceIdSet found;
+    BinaryTable sdt;
+    removeServiceEntries(table, sdt, 3, 5, true, &found);
+
+    for (ServiceIdSet::const_iterator it = _service_ids.begin(); it != _service_ids.end(); ++it) {
+        if (found.find(*it) == found.end()) {
+            // Informational only, SDT entry is not mandatory.
+            tsp->info(u"service %d (0x%X) not found in SDT, ignoring it", {*it, *it});
+        }
     }
 
     // Replace the SDT in the PID
-    _pzer_sdt_bat.removeSections(TID_SDT_ACT, sdt.ts_id);
+    _pzer_sdt_bat.removeSections(TID_SDT_ACT, table.tableIdExtension());
     _pzer_sdt_bat.addTable(sdt);
 }
 
@@ -387,55 +444,69 @@ void ts::SVRemovePlugin::processSDT (SDT& sdt)
 //  This method processes a Program Association Table (PAT).
 //----------------------------------------------------------------------------
 
-void ts::SVRemovePlugin::processPAT(PAT& pat)
+void ts::SVRemovePlugin::processPAT(const BinaryTable& table)
 {
-    // PAT not normally fetched until service id is known
-    assert(_service.hasId());
+    // PAT not normally fetched until all service ids are known
+    assert(_unknown_ids == 0);
+
+    const PAT pat(table);
+    if (!pat.isValid()) {
+        return;
+    }
 
     // Save the NIT PID
     _pzer_nit.setPID(pat.nit_pid);
     _demux.addPID(pat.nit_pid);
 
     // Loop on all services in the PAT. We need to scan all PMT's to know which
-    // PID to remove and which to keep (if shared between the removed service
+    // PID to remove and which to keep (if shared between the removed services
     // and other services).
-    bool found = false;
+    ServiceIdSet found;
     for (PAT::ServiceMap::const_iterator it = pat.pmts.begin(); it != pat.pmts.end(); ++it) {
         // Scan all PMT's
-        _demux.addPID (it->second);
-
-        // Check if service to remove is here
-        if (it->first == _service.getId()) {
-            found = true;
-            _service.setPMTPID (it->second);
-            tsp->verbose(u"found service id 0x%X, PMT PID is 0x%X", {_service.getId(), _service.getPMTPID()});
-            // Drop PMT of the service
-            _drop_pids.set (it->second);
+        _demux.addPID(it->second);
+
+        // Check if a service to remove is here
+        if (isRemoved(it->first)) {
+            found.insert(it->first);
+            tsp->verbose(u"found service id 0x%X, PMT PID is 0x%X", {it->first, it->second});
+            // Drop PMT of the service, wait for its analysis before filtering PIDs.
+            _drop_pids.set(it->second);
+            if (!_pat_found) {
+                _pending_pmts.insert(it->first);
+            }
         }
         else {
             // Mark other PMT's as referenced
-            _ref_pids.set (it->second);
+            _ref_pids.set(it->second);
         }
     }
+    _removed_pids = _drop_pids & ~_ref_pids;
 
-    if (found) {
-        // Remove the service from the PAT
-        pat.pmts.erase (_service.getId());
-    }
-    else if (_ignore_absent || !_ignore_nit || !_ignore_bat) {
-        // Service is not present in current TS, but continue
-        tsp->info(u"service id 0x%X not found in PAT, ignoring it", {_service.getId()});
-        _ready = true;
-    }
-    else {
-        // If service is not found and no need to modify to NIT or BAT, abort
-        tsp->error(u"service id 0x%X not found in PAT", {_service.getId()});
-        _abort = true;
+    for (ServiceIdSet::const_iterator it = _service_ids.begin(); it != _service_ids.end(); ++it) {
+        if (found.find(*it) != found.end()) {
+            // Service found, nothing to report
+        }
+        else if (_ignore_absent || !_ignore_nit || !_ignore_bat) {
+            // Service is not present in current TS, but continue
+            tsp->info(u"service id 0x%X not found in PAT, ignoring it", {*it});
+        }
+        else {
+            // If service is not found and no need to modify to NIT or BAT, abort
+            tsp->error(u"service id 0x%X not found in PAT", {*it});
+            _abort = true;
+        }
     }
 
-    // Replace the PAT.in the PID
+    // We are ready to filter PIDs when the PMT's of all removed services are analyzed.
+    _pat_found = true;
+    _ready = _ready || _pending_pmts.empty();
+
+    // Remove the services from the PAT, directly in the binary sections. Each PAT entry is 4 bytes.
+    BinaryTable new_pat;
+    removeServiceEntries(table, new_pat, 0, 4, false, nullptr);
     _pzer_pat.removeSections(TID_PAT);
-    _pzer_pat.addTable(pat);
+    _pzer_pat.addTable(new_pat);
 }
 
 
@@ -443,10 +514,10 @@ void ts::SVRemovePlugin::processPAT(PAT& pat)
 //  This method processes a Program Map Table (PMT).
 //----------------------------------------------------------------------------
 
-void ts::SVRemovePlugin::processPMT(PMT& pmt)
+void ts::SVRemovePlugin::processPMT(const PMT& pmt)
 {
-    // Is this the PMT of the service to remove?
-    const bool removed_service = pmt.service_id == _service.getId();
+    // Is this the PMT of a service to remove?
+    const bool removed_service = isRemoved(pmt.service_id);
 
     // Mark PIDs as dropped or referenced.
     PIDSet& pid_set(removed_service ? _drop_pids : _ref_pids);
@@ -465,8 +536,14 @@ void ts::SVRemovePlugin::processPMT(PMT& pmt)
         addECMPID(it->second.descs, pid_set);
     }
 
-    // When the service to remove has been analyzed, we are ready to filter PIDs
-    _ready = _ready || removed_service;
+    // The per-packet filter is one single PID set, recomputed only here.
+    _removed_pids = _drop_pids & ~_ref_pids;
+
+    // When all services to remove have been analyzed, we are ready to filter PIDs
+    if (removed_service) {
+        _pending_pmts.erase(pmt.service_id);
+        _ready = _ready || _pending_pmts.empty();
+    }
 }
 
 
@@ -491,72 +568,139 @@ void ts::SVRemovePlugin::addECMPID (const DescriptorList& dlist, PIDSet& pid_set
 
 
 //----------------------------------------------------------------------------
-//  This method processes a NIT or a BAT
+// Build a copy of a PAT or SDT without the entries of removed services.
 //----------------------------------------------------------------------------
 
-void ts::SVRemovePlugin::processNITBAT(AbstractTransportListTable& table)
+void ts::SVRemovePlugin::removeServiceEntries(const BinaryTable& table, BinaryTable& result, size_t header_size, size_t entry_size, bool has_descs, ServiceIdSet* found)
 {
-    // Process the global descriptor list
-    processNITBATDescriptorList(table.descs);
+    result.clear();
+
+    for (size_t si = 0; si < table.sectionCount(); ++si) {
+        const SectionPtr& sect(table.sectionAt(si));
+        const uint8_t* data = sect->payload();
+        size_t size = sect->payloadSize();
+
+        // Copy the section header, then only the entries of the services to keep.
+        ByteBlock payload(data, std::min(header_size, size));
+        data += payload.size();
+        size -= payload.size();
+
+        while (size >= entry_size) {
+            const uint16_t id = GetUInt16(data);
+            const size_t len = std::min(size, entry_size + (has_descs ? (GetUInt16(data + entry_size - 2) & 0x0FFF) : 0));
+            if (!isRemoved(id)) {
+                payload.append(data, len);
+            }
+            else if (found != nullptr) {
+                found->insert(id);
+            }
+            data += len;
+            size -= len;
+        }
 
-    // Process each TS descriptor list
-    for (AbstractTransportListTable::TransportMap::iterator it = table.transports.begin(); it != table.transports.end(); ++it) {
-        processNITBATDescriptorList(it->second);
+        result.addSection(new Section(sect->tableId(), sect->isPrivateSection(), sect->tableIdExtension(), sect->version(), sect->isCurrent(),
+                                      sect->sectionNumber(), sect->lastSectionNumber(), payload.data(), payload.size(), sect->sourcePID()));
     }
 }
 
 
 //----------------------------------------------------------------------------
-//  This method processes a NIT or a BAT descriptor list
+// Build a copy of a NIT or BAT without the removed services.
 //----------------------------------------------------------------------------
 
-void ts::SVRemovePlugin::processNITBATDescriptorList (DescriptorList& dlist)
+void ts::SVRemovePlugin::removeNITBATServices(const BinaryTable& table, BinaryTable& result)
 {
-    // Process all service_list_descriptors
-    for (size_t i = dlist.search (DID_SERVICE_LIST); i < dlist.count(); i = dlist.search (DID_SERVICE_LIST, i + 1)) {
-
-        uint8_t* base = dlist[i]->payload();
-        size_t size = dlist[i]->payloadSize();
-        uint8_t* data = base;
-        uint8_t* new_data = base;
-
-        while (size >= 3) {
-            if (GetUInt16 (data) != _service.getId()) {
-                // Not the removed service, keep this entry
-                new_data[0] = data[0];
-                new_data[1] = data[1];
-                new_data[2] = data[2];
-                new_data += 3;
+    result.clear();
+
+    for (size_t si = 0; si < table.sectionCount(); ++si) {
+        const SectionPtr& sect(table.sectionAt(si));
+        const uint8_t* data = sect->payload();
+        size_t size = sect->payloadSize();
+        ByteBlock payload;
+
+        // Global descriptor loop, with a 12-bit length.
+        if (size >= 2) {
+            const uint16_t header = GetUInt16(data);
+            const size_t len = std::min<size_t>(header & 0x0FFF, size - 2);
+            payload.appendUInt16(0);
+            removeDescriptorLoopServices(data + 2, len, payload);
+            PutUInt16(payload.data(), uint16_t((header & 0xF000) | (payload.size() - 2)));
+            data += 2 + len;
+            size -= 2 + len;
+        }
+
+        // Transport stream loop, each TS entry has a descriptor loop.
+        if (size >= 2) {
+            const uint16_t header = GetUInt16(data);
+            size_t loop_size = std::min<size_t>(header & 0x0FFF, size - 2);
+            const size_t loop_start = payload.size();
+            payload.appendUInt16(0);
+            data += 2;
+            while (loop_size >= 6) {
+                const uint16_t ts_header = GetUInt16(data + 4);
+                const size_t len = std::min<size_t>(ts_header & 0x0FFF, loop_size - 6);
+                payload.append(data, 4);
+                const size_t desc_start = payload.size();
+                payload.appendUInt16(0);
+                removeDescriptorLoopServices(data + 6, len, payload);
+                PutUInt16(payload.data() + desc_start, uint16_t((ts_header & 0xF000) | (payload.size() - desc_start - 2)));
+                data += 6 + len;
+                loop_size -= 6 + len;
             }
-            data += 3;
-            size -= 3;
+            PutUInt16(payload.data() + loop_start, uint16_t((header & 0xF000) | (payload.size() - loop_start - 2)));
         }
-        dlist[i]->resizePayload (new_data - base);
+
+        result.addSection(new Section(sect->tableId(), sect->isPrivateSection(), sect->tableIdExtension(), sect->version(), sect->isCurrent(),
+                                      sect->sectionNumber(), sect->lastSectionNumber(), payload.data(), payload.size(), sect->sourcePID()));
     }
+}
+
+
+//----------------------------------------------------------------------------
+// Copy a NIT or BAT descriptor loop without the removed services in the
+// service_list_descriptors and EICTA logical_channel_number_descriptors.
+//----------------------------------------------------------------------------
 
-    // Process all logical_channel_number_descriptors
-    for (size_t i = dlist.search (DID_LOGICAL_CHANNEL_NUM, 0, PDS_EICTA);
-         i < dlist.count();
-         i = dlist.search (DID_LOGICAL_CHANNEL_NUM, i + 1, PDS_EICTA)) {
-
-        uint8_t* base = dlist[i]->payload();
-        size_t size = dlist[i]->payloadSize();
-        uint8_t* data = base;
-        uint8_t* new_data = base;
-
-        while (size >= 4) {
-            if (GetUInt16 (data) != _service.getId()) {
-                // Not the removed service, keep this entry
-                new_data[0] = data[0];
-                new_data[1] = data[1];
-                new_data[2] = data[2];
-                new_data[3] = data[3];
-                new_data += 4;
+void ts::SVRemovePlugin::removeDescriptorLoopServices(const uint8_t* data, size_t size, ByteBlock& out)
+{
+    PDS pds = 0;
+
+    while (size >= 2) {
+        const DID tag = data[0];
+        const uint8_t* const desc_payload = data + 2;
+        const size_t len = std::min<size_t>(data[1], size - 2);
+
+        // Track the private data specifier, as in DescriptorList.
+        if (tag == DID_PRIV_DATA_SPECIF) {
+            pds = len < 4 ? 0 : GetUInt32(desc_payload);
+        }
+
+        // Size of service entries in the descriptor, zero if the descriptor is copied unmodified.
+        size_t entry_size = 0;
+        if (tag == DID_SERVICE_LIST) {
+            entry_size = 3;
+        }
+        else if (tag == DID_LOGICAL_CHANNEL_NUM && pds == PDS_EICTA) {
+            entry_size = 4;
+        }
+
+        const size_t start = out.size();
+        out.appendUInt8(tag);
+        out.appendUInt8(0);
+        if (entry_size == 0) {
+            out.append(desc_payload, len);
+        }
+        else {
+            for (size_t i = 0; i + entry_size <= len; i += entry_size) {
+                if (!isRemoved(GetUInt16(desc_payload + i))) {
+                    out.append(desc_payload + i, entry_size);
+                }
             }
-            data += 4;
-            size -= 4;
         }
-        dlist[i]->resizePayload(new_data - base);
+        out[start + 1] = uint8_t(out.size() - start - 2);
+
+        data += 2 + len;
+        size -= 2 + len;
     }
 }
 
@@ -588,13 +732,13 @@ ts::ProcessorPlugin::Status ts::SVRemovePlugin::processPacket (TSPacket& pkt, bo
     }
 
     // Packets from removed PIDs are either dropped or nullified
-    if (_drop_pids[pid] && !_ref_pids[pid]) {
+    if (_removed_pids[pid]) {
         return _drop_status;
     }
 
     // Replace packets using packetizers
     if (pid == _pzer_pat.getPID()) {
-        _pzer_pat.getNextPacket (pkt);
+        _pzer_pat.getNextPacket(pkt);
     }
     else if (pid == _pzer_sdt_bat.getPID()) {
         _pzer_sdt_bat.getNextPacket(pkt);
@@ -0,0 +1,551 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+//
+//  Transport stream processor shared library:
+//  Synthetic multiplex generator, for load testing
+//
+//----------------------------------------------------------------------------
+
+#include "tsPlugin.h"
+#include "tsPluginRepository.h"
+#include "tsCyclingPacketizer.h"
+#include "tsMonotonic.h"
+#include "tsPCR.h"
+#include "tsPAT.h"
+#include "tsPMT.h"
+#include "tsSDT.h"
+TSDUCK_SOURCE;
+
+#define DEFAULT_BITRATE     50000000  // Default multiplex bitrate in b/s.
+#define DEFAULT_SERVICES    10        // Default number of services.
+#define DEFAULT_NULL_RATIO  10        // Default percentage of null packets.
+#define DEFAULT_PCR_MS      30        // Default PCR interval in milliseconds.
+#define MAX_SERVICES        400       // Keep all PID's below 0x1A00.
+#define PAT_PMT_REP_MS      100       // Repetition rate of PAT and PMT's.
+#define SDT_REP_MS          500       // Repetition rate of SDT.
+#define VIDEO_FRAME_MS      40        // Interval between video PES packets.
+#define AUDIO_FRAME_MS      24        // Interval between audio PES packets.
+#define PTS_DELAY_MS        500       // Delay between PCR and PTS.
+#define CRYPTO_PERIOD_S     10        // Scrambling control alternates between even and odd keys.
+#define REGULATE_MS         10        // Max generation in advance in real-time mode.
+
+
+//----------------------------------------------------------------------------
+// Plugin definition
+//----------------------------------------------------------------------------
+
+namespace ts {
+    class SynthInput: public InputPlugin
+    {
+    public:
+        // Implementation of plugin API
+        SynthInput(TSP*);
+        virtual bool start() override;
+        virtual bool stop() override;
+        virtual BitRate getBitrate() override;
+        virtual size_t receive(TSPacket*, size_t) override;
+
+    private:
+        // Pre-rendered variants of the packets of an elementary stream (bit mask).
+        enum {PLAIN = 0x00, WITH_PCR = 0x01, WITH_PES = 0x02, VARIANT_COUNT = 4};
+
+        // Description of an elementary stream. Clock values are in PCR units, not wrapped.
+        struct ESContext
+        {
+            bool     scrambled;        // The packets are marked as scrambled
+            bool     has_pcr;          // The PID carries the PCR of the service
+            uint8_t  cc;               // Next continuity counter
+            uint64_t frame_duration;   // Interval between PES packets
+            uint64_t next_frame;       // Clock of next PES packet
+            uint64_t next_pcr;         // Clock of next PCR
+            TSPacket pkt[VARIANT_COUNT];  // Pre-rendered packets, indexed by variant
+        };
+        typedef std::vector<ESContext> ESContextVector;
+        typedef SafePtr<CyclingPacketizer, NullMutex> PacketizerPtr;
+        typedef std::vector<PacketizerPtr> PacketizerVector;
+
+        // Value of a schedule slot for a null packet. Other values are PSI streams, then ES.
+        static const uint16_t NULL_SLOT = 0xFFFF;
+
+        // Command line options.
+        PacketCounter _max_count;        // Number of packets to generate
+        size_t        _service_count;    // Number of services
+        BitRate       _req_bitrate;      // Requested multiplex bitrate
+        size_t        _null_ratio;       // Percentage of null packets
+        size_t        _scrambled_ratio;  // Percentage of scrambled services
+        MilliSecond   _pcr_interval;     // PCR interval in milliseconds
+        uint16_t      _ts_id;            // Transport stream id
+        uint16_t      _onet_id;          // Original network id
+        bool          _realtime;         // Regulate the generation at the multiplex bitrate
+
+        // Working data.
+        PacketCounter    _count;         // Number of generated packets
+        PacketizerVector _psi;           // Packetizers of PSI/SI PID's
+        ESContextVector  _es;            // Elementary streams
+        std::vector<uint16_t> _schedule; // One second of packets, each slot is a PSI, ES or null index
+        size_t           _slot;          // Next slot in schedule
+        uint64_t         _cycle_count;   // Number of completed schedules (seconds)
+        Monotonic        _start_time;    // Start of generation in real-time mode
+
+        // Add a PSI/SI table in its own packetizer, return the number of packets per second.
+        size_t addPSI(PID pid, const AbstractTable& table, MilliSecond rep_rate);
+
+        // Initialize an elementary stream and its pre-rendered packets.
+        void addES(PID pid, uint8_t stream_id, MilliSecond frame_ms, bool scrambled, bool has_pcr, const uint8_t* payload);
+
+        // Build the schedule of one second of packets.
+        void buildSchedule(const std::vector<size_t>& counts);
+
+        // Generate the next packet.
+        void generate(TSPacket& pkt);
+
+        // Inaccessible operations
+        SynthInput() = delete;
+        SynthInput(const SynthInput&) = delete;
+        SynthInput& operator=(const SynthInput&) = delete;
+    };
+}
+
+TSPLUGIN_DECLARE_VERSION
+TSPLUGIN_DECLARE_INPUT(synth, ts::SynthInput)
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const uint16_t ts::SynthInput::NULL_SLOT;
+#endif
+
+
+//----------------------------------------------------------------------------
+// Constructor
+//----------------------------------------------------------------------------
+
+ts::SynthInput::SynthInput(TSP* tsp_) :
+    InputPlugin(tsp_, u"Generate a synthetic multiplex for load testing.", u"[options] [count]"),
+    _max_count(0),
+    _service_count(0),
+    _req_bitrate(0),
+    _null_ratio(0),
+    _scrambled_ratio(0),
+    _pcr_interval(0),
+    _ts_id(0),
+    _onet_id(0),
+    _realtime(false),
+    _count(0),
+    _psi(),
+    _es(),
+    _schedule(),
+    _slot(0),
+    _cycle_count(0),
+    _start_time()
+{
+    option(u"",                   0,  UNSIGNED, 0, 1);
+    option(u"bitrate",           'b', POSITIVE);
+    option(u"joint-termination", 'j');
+    option(u"null-ratio",         0,  INTEGER, 0, 1, 0, 90);
+    option(u"original-network-id", 0, UINT16);
+    option(u"pcr-interval",       0,  INTEGER, 0, 1, 1, 100);
+    option(u"realtime",          'r');
+    option(u"scrambled-ratio",    0,  INTEGER, 0, 1, 0, 100);
+    option(u"services",          's', INTEGER, 0, 1, 1, MAX_SERVICES);
+    option(u"ts-id",              0,  UINT16);
+
+    setHelp(u"Count:\n"
+            u"  Specify the number of packets to generate. After the last packet,\n"
+            u"  an end-of-file condition is generated. By default, if count is not\n"
+            u"  specified, packets are generated endlessly.\n"
+            u"\n"
+            u"The generated multiplex contains a PAT, an SDT Actual and, for each service,\n"
+            u"a PMT, an AVC video PID with PCR's and an AAC audio PID. Service n (from 1)\n"
+            u"uses PID's 0x100+16*(n-1) (PMT), +1 (video) and +2 (audio). All packets are\n"
+            u"pre-rendered, only the continuity counters, PCR and PTS are updated in each\n"
+            u"packet. The payload of the audio and video packets is random.\n"
+            u"\n"
+            u"Options:\n"
+            u"\n"
+            u"  -b value\n"
+            u"  --bitrate value\n"
+            u"      Bitrate of the generated multiplex in bits/second. The actual bitrate\n"
+            u"      is rounded to an integral number of packets per second. The PCR values\n"
+            u"      are consistent with this bitrate. The default is 50,000,000 b/s.\n"
+            u"\n"
+            u"  --help\n"
+            u"      Display this help text.\n"
+            u"\n"
+            u"  -j\n"
+            u"  --joint-termination\n"
+            u"      When the number of packets is specified, perform a \"joint termination\"\n"
+            u"      when completed instead of unconditional termination.\n"
+            u"      See \"tsp --help\" for more details on \"joint termination\".\n"
+            u"\n"
+            u"  --null-ratio value\n"
+            u"      Percentage of null packets in the multiplex. The default is 10%.\n"
+            u"\n"
+            u"  --original-network-id value\n"
+            u"      Original network id in the SDT. The default is 1.\n"
+            u"\n"
+            u"  --pcr-interval value\n"
+            u"      Interval in milliseconds between PCR's in each service.\n"
+            u"      The default is 30 ms.\n"
+            u"\n"
+            u"  -r\n"
+            u"  --realtime\n"
+            u"      Regulate the generation of packets at the multiplex bitrate. By default,\n"
+            u"      packets are generated as fast as possible. Ignored when tsp runs in\n"
+            u"      offline mode.\n"
+            u"\n"
+            u"  --scrambled-ratio value\n"
+            u"      Percentage of services which are marked as scrambled. The audio and\n"
+            u"      video packets of these services have their scrambling control set,\n"
+            u"      alternating between even and odd keys every 10 seconds. The default\n"
+            u"      is 0%.\n"
+            u"\n"
+            u"  -s value\n"
+            u"  --services value\n"
+            u"      Number of services in the multiplex, from 1 to 400. The default is 10.\n"
+            u"\n"
+            u"  --ts-id value\n"
+            u"      Transport stream id. The default is 1.\n"
+            u"\n"
+            u"  --version\n"
+            u"      Display the version number.\n");
+}
+
+
+//----------------------------------------------------------------------------
+// Start method
+//----------------------------------------------------------------------------
+
+bool ts::SynthInput::start()
+{
+    tsp->useJointTermination(present(u"joint-termination"));
+    _max_count = intValue<PacketCounter>(u"", std::numeric_limits<PacketCounter>::max());
+    _service_count = intValue<size_t>(u"services", DEFAULT_SERVICES);
+    _req_bitrate = intValue<BitRate>(u"bitrate", DEFAULT_BITRATE);
+    _null_ratio = intValue<size_t>(u"null-ratio", DEFAULT_NULL_RATIO);
+    _scrambled_ratio = intValue<size_t>(u"scrambled-ratio", 0);
+    _pcr_interval = intValue<MilliSecond>(u"pcr-interval", DEFAULT_PCR_MS);
+    _ts_id = intValue<uint16_t>(u"ts-id", 1);
+    _onet_id = intValue<uint16_t>(u"original-network-id", 1);
+    _realtime = present(u"realtime");
+    if (_realtime && tsp->offline()) {
+        tsp->verbose(u"offline mode, --realtime ignored");
+        _realtime = false;
+    }
+
+    // The schedule is one second of packets.
+    const size_t pkt_per_sec = size_t(_req_bitrate / (PKT_SIZE * 8));
+    if (pkt_per_sec < 100) {
+        tsp->error(u"bitrate too low");
+        return false;
+    }
+
+    // Build the PSI/SI. Count the number of packets per second for each stream.
+    std::vector<size_t> counts;
+    _psi.clear();
+    _es.clear();
+
+    PAT pat(0, true, _ts_id, PID_NULL);
+    SDT sdt(true, 0, true, _ts_id, _onet_id);
+    std::vector<bool> scrambled(_service_count, false);
+    for (size_t i = 0; i < _service_count; ++i) {
+        const uint16_t srv_id = uint16_t(i + 1);
+        pat.pmts[srv_id] = PID(0x100 + 16 * i);
+        // Spread the scrambled services among the multiplex.
+        scrambled[i] = ((i + 1) * _scrambled_ratio) / 100 > (i * _scrambled_ratio) / 100;
+        SDT::Service& srv(sdt.services[srv_id]);
+        srv.running_status = 4; // running
+        srv.CA_controlled = scrambled[i];
+        srv.setName(UString::Format(u"Service %d", {srv_id}));
+        srv.setProvider(u"TSDuck");
+    }
+    counts.push_back(addPSI(PID_PAT, pat, PAT_PMT_REP_MS));
+    counts.push_back(addPSI(PID_SDT, sdt, SDT_REP_MS));
+    for (size_t i = 0; i < _service_count; ++i) {
+        const PID pid = PID(0x100 + 16 * i);
+        PMT pmt(0, true, uint16_t(i + 1), pid + 1);
+        pmt.streams[pid + 1].stream_type = ST_AVC_VIDEO;
+        pmt.streams[pid + 2].stream_type = ST_AAC_AUDIO;
+        counts.push_back(addPSI(pid, pmt, PAT_PMT_REP_MS));
+    }
+
+    // Share the rest of the bandwidth between the services, 90% video, 10% audio.
+    size_t used = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        used += counts[i];
+    }
+    const size_t nulls = (pkt_per_sec * _null_ratio) / 100;
+    const size_t per_service = pkt_per_sec > used + nulls ? (pkt_per_sec - used - nulls) / _service_count : 0;
+    if (per_service < 2) {
+        tsp->error(u"bitrate too low for %d services", {_service_count});
+        return false;
+    }
+    const size_t video = std::max<size_t>(1, (per_service * 9) / 10);
+
+    // Random payload, shared by all elementary streams.
+    uint8_t payload[PKT_SIZE];
+    uint32_t rnd = 0x12345678;
+    for (size_t i = 0; i < sizeof(payload); ++i) {
+        rnd = rnd * 1103515245 + 12345;
+        payload[i] = uint8_t(rnd >> 16);
+    }
+
+    _es.reserve(2 * _service_count);
+    for (size_t i = 0; i < _service_count; ++i) {
+        const PID pid = PID(0x100 + 16 * i);
+        addES(pid + 1, 0xE0, VIDEO_FRAME_MS, scrambled[i], true, payload);
+        addES(pid + 2, 0xC0, AUDIO_FRAME_MS, scrambled[i], false, payload);
+        counts.push_back(video);
+        counts.push_back(per_service - video);
+    }
+
+    _schedule.resize(pkt_per_sec);
+    buildSchedule(counts);
+
+    tsp->verbose(u"generating %d services at %'d b/s", {_service_count, getBitrate()});
+
+    _count = 0;
+    _slot = 0;
+    _cycle_count = 0;
+    _start_time.getSystemTime();
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Stop method
+//----------------------------------------------------------------------------
+
+bool ts::SynthInput::stop()
+{
+    _psi.clear();
+    _es.clear();
+    _schedule.clear();
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Get the multiplex bitrate.
+//----------------------------------------------------------------------------
+
+ts::BitRate ts::SynthInput::getBitrate()
+{
+    return BitRate(_schedule.size() * (PKT_SIZE * 8));
+}
+
+
+//----------------------------------------------------------------------------
+// Add a PSI/SI table in its own packetizer.
+//----------------------------------------------------------------------------
+
+size_t ts::SynthInput::addPSI(PID pid, const AbstractTable& table, MilliSecond rep_rate)
+{
+    BinaryTable bin;
+    table.serialize(bin);
+
+    // Each section starts in a new packet, with a pointer field.
+    size_t packets = 0;
+    for (size_t i = 0; i < bin.sectionCount(); ++i) {
+        packets += (bin.sectionAt(i)->size() + 1 + PKT_SIZE - 5) / (PKT_SIZE - 4);
+    }
+
+    PacketizerPtr pzer(new CyclingPacketizer(pid, CyclingPacketizer::ALWAYS));
+    pzer->addTable(bin);
+    _psi.push_back(pzer);
+    return packets * size_t(MilliSecPerSec / rep_rate);
+}
+
+
+//----------------------------------------------------------------------------
+// Initialize an elementary stream and its pre-rendered packets.
+//----------------------------------------------------------------------------
+
+void ts::SynthInput::addES(PID pid, uint8_t stream_id, MilliSecond frame_ms, bool scrambled, bool has_pcr, const uint8_t* payload)
+{
+    _es.resize(_es.size() + 1);
+    ESContext& es(_es.back());
+    es.scrambled = scrambled;
+    es.has_pcr = has_pcr;
+    es.cc = 0;
+    es.frame_duration = uint64_t(frame_ms) * (SYSTEM_CLOCK_FREQ / MilliSecPerSec);
+    es.next_frame = 0;
+    es.next_pcr = 0;
+
+    for (int variant = 0; variant < VARIANT_COUNT; ++variant) {
+        uint8_t* b = es.pkt[variant].b;
+        b[0] = SYNC_BYTE;
+        PutUInt16(b + 1, uint16_t(pid | ((variant & WITH_PES) != 0 ? 0x4000 : 0x0000)));
+        size_t offset = 4;
+        if ((variant & WITH_PCR) != 0) {
+            // Adaptation field with PCR only. The PCR is updated in each packet.
+            b[3] = 0x30;
+            b[4] = 7;
+            b[5] = 0x10;
+            ::memset(b + 6, 0, 6);
+            offset = 12;
+        }
+        else {
+            b[3] = 0x10;
+        }
+        if ((variant & WITH_PES) != 0 && !scrambled) {
+            // PES header with PTS only, unbounded size. The PTS is updated in each packet.
+            static const uint8_t header[] = {0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x80, 0x80, 0x05, 0x21, 0x00, 0x01, 0x00, 0x01};
+            ::memcpy(b + offset, header, sizeof(header));
+            b[offset + 3] = stream_id;
+            offset += sizeof(header);
+        }
+        ::memcpy(b + offset, payload, PKT_SIZE - offset);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Build the schedule of one second of packets. The packets of each stream
+// are evenly spread. The streams are shifted from each other to avoid bursts.
+//----------------------------------------------------------------------------
+
+void ts::SynthInput::buildSchedule(const std::vector<size_t>& counts)
+{
+    const size_t size = _schedule.size();
+
+    // Ideal position of all packets, with the corresponding stream index.
+    std::vector<std::pair<double, uint16_t>> ideal;
+    for (size_t stream = 0; stream < counts.size(); ++stream) {
+        const double interval = double(size) / double(counts[stream]);
+        const double phase = double((stream * 618) % 1000) / 1000.0;
+        for (size_t i = 0; i < counts[stream]; ++i) {
+            ideal.push_back(std::make_pair((double(i) + phase) * interval, uint16_t(stream)));
+        }
+    }
+    std::sort(ideal.begin(), ideal.end());
+
+    // Assign slots in order of ideal position. Remaining slots are null packets.
+    std::fill(_schedule.begin(), _schedule.end(), NULL_SLOT);
+    size_t next = 0;
+    for (size_t i = 0; i < ideal.size(); ++i) {
+        const size_t slot = std::min(std::max(next, size_t(ideal[i].first)), size - (ideal.size() - i));
+        _schedule[slot] = ideal[i].second;
+        next = slot + 1;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Generate the next packet.
+//----------------------------------------------------------------------------
+
+void ts::SynthInput::generate(TSPacket& pkt)
+{
+    const size_t stream = _schedule[_slot];
+
+    if (stream == NULL_SLOT) {
+        pkt = NullPacket;
+    }
+    else if (stream < _psi.size()) {
+        _psi[stream]->getNextPacket(pkt);
+    }
+    else {
+        ESContext& es(_es[stream - _psi.size()]);
+
+        // Current clock, not wrapped, in PCR units.
+        const uint64_t clock = _cycle_count * SYSTEM_CLOCK_FREQ + (uint64_t(_slot) * SYSTEM_CLOCK_FREQ) / _schedule.size();
+
+        // Select the pre-rendered variant.
+        int variant = PLAIN;
+        if (es.has_pcr && clock >= es.next_pcr) {
+            variant |= WITH_PCR;
+            es.next_pcr = clock + uint64_t(_pcr_interval) * (SYSTEM_CLOCK_FREQ / MilliSecPerSec);
+        }
+        if (clock >= es.next_frame) {
+            variant |= WITH_PES;
+            es.next_frame += es.frame_duration;
+            if (es.next_frame <= clock) {
+                es.next_frame = clock + es.frame_duration;
+            }
+        }
+        pkt = es.pkt[variant];
+
+        // Patch the continuity counter, scrambling control, PCR and PTS.
+        pkt.b[3] |= es.cc;
+        es.cc = (es.cc + 1) & CC_MASK;
+        if (es.scrambled) {
+            pkt.b[3] |= (_cycle_count / CRYPTO_PERIOD_S) % 2 == 0 ? SC_EVEN_KEY << 6 : SC_ODD_KEY << 6;
+        }
+        if ((variant & WITH_PCR) != 0) {
+            PutPCR(pkt.b + 6, clock % (PTS_DTS_SCALE * SYSTEM_CLOCK_SUBFACTOR));
+        }
+        if ((variant & WITH_PES) != 0 && !es.scrambled) {
+            const uint64_t pts = (clock / SYSTEM_CLOCK_SUBFACTOR + PTS_DELAY_MS * (SYSTEM_CLOCK_SUBFREQ / MilliSecPerSec)) & PTS_DTS_MASK;
+            uint8_t* b = pkt.b + ((variant & WITH_PCR) != 0 ? 12 : 4) + 9;
+            b[0] = 0x21 | (uint8_t(pts >> 29) & 0x0E);
+            PutUInt16(b + 1, uint16_t(pts >> 14) | 0x0001);
+            PutUInt16(b + 3, uint16_t(pts << 1) | 0x0001);
+        }
+    }
+
+    if (++_slot >= _schedule.size()) {
+        _slot = 0;
+        _cycle_count++;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Input method
+//----------------------------------------------------------------------------
+
+size_t ts::SynthInput::receive(TSPacket* buffer, size_t max_packets)
+{
+    // If "joint termination" reached for this plugin
+    if (_count >= _max_count && tsp->useJointTermination()) {
+        // Declare terminated
+        tsp->jointTerminate();
+        // Continue generating packets until completion of tsp (suppress max packet count)
+        _max_count = std::numeric_limits<PacketCounter>::max();
+    }
+
+    // In real-time mode, do not generate too much in advance.
+    const size_t pkt_per_sec = _schedule.size();
+    if (_realtime) {
+        max_packets = std::min(max_packets, std::max<size_t>(1, (pkt_per_sec * REGULATE_MS) / MilliSecPerSec));
+    }
+
+    size_t n = 0;
+    for (; n < max_packets && _count < _max_count; ++n, ++_count) {
+        generate(buffer[n]);
+    }
+
+    // In real-time mode, wait until the theoretical time of the last packet.
+    if (_realtime && n > 0) {
+        Monotonic deadline(_start_time);
+        deadline += NanoSecond(_count / pkt_per_sec) * NanoSecPerSec + (NanoSecond(_count % pkt_per_sec) * NanoSecPerSec) / NanoSecond(pkt_per_sec);
+        deadline.wait();
+    }
+    return n;
+}
@@ -38,6 +38,7 @@
 #include "tsT2MIDescriptor.h"
 #include "tsT2MIPacket.h"
 #include "tsTSFileOutput.h"
+#include "tsSysUtils.h"
 #include "tsNames.h"
 TSDUCK_SOURCE;
 
@@ -57,23 +58,45 @@ namespace ts {
         virtual Status processPacket(TSPacket&, bool&, bool&) override;
 
     private:
+        // Number of extracted TS packets which are written at a time in an output file.
+        static const size_t WRITE_PACKETS = 512;
+
+        // Extraction context for one PLP.
+        struct PLPContext
+        {
+            TSFileOutput  outfile;     // Output file for extracted stream.
+            TSPacketVector buffer;     // Extracted packets, not yet written in outfile.
+            PacketCounter t2mi_count;  // Number of input T2-MI packets.
+            PacketCounter ts_count;    // Number of extracted TS packets.
+
+            // Constructor.
+            PLPContext();
+        };
+        typedef SafePtr<PLPContext, NullMutex> PLPContextPtr;
+        typedef std::map<uint8_t, PLPContextPtr> PLPContextMap;
+
         // Plugin private fields.
         bool          _abort;           // Error, abort asap.
         bool          _extract;         // Extract encapsulated TS.
         bool          _replace_ts;      // Replace transferred TS.
         bool          _log;             // Log T2-MI packets.
         PID           _pid;             // PID carrying the T2-MI encapsulation.
-        uint8_t       _plp;             // The PLP to extract in _pid.
-        bool          _plp_valid;       // False if PLP not yet known.
+        std::set<uint8_t> _plps;        // The PLP's to extract in _pid (empty: first one which is found).
+        bool          _all_plps;        // Extract all PLP's.
+        bool          _multi_plps;      // Extract several PLP's in separate files.
         bool          _outfile_append;  // Append file.
         bool          _outfile_keep;    // Keep existing output file, do not overwrite.
         UString       _outfile_name;    // Output file name.
-        TSFileOutput  _outfile;         // Output file for extracted stream.
-        PacketCounter _t2mi_count;      // Number of input T2-MI packets.
-        PacketCounter _ts_count;        // Number of extracted TS packets.
+        PLPContextMap _plp_contexts;    // Extraction contexts of the extracted PLP's.
         T2MIDemux     _demux;           // Demux for PSI parsing.
         std::deque<TSPacket> _ts_queue; // Queue of demuxed TS packets.
 
+        // Start the extraction of a PLP.
+        PLPContextMap::iterator startPLP(uint8_t plp);
+
+        // Write the buffered packets of a PLP in its output file.
+        bool flushPLP(PLPContext& ctx);
+
         // Inherited methods.
         virtual void handleT2MINewPID(T2MIDemux& demux, const PMT& pmt, PID pid, const T2MIDescriptor& desc) override;
         virtual void handleT2MIPacket(T2MIDemux& demux, const T2MIPacket& pkt) override;
@@ -102,26 +125,30 @@ ts::T2MIPlugin::T2MIPlugin(TSP* tsp_) :
     _replace_ts(false),
     _log(false),
     _pid(PID_NULL),
-    _plp(0),
-    _plp_valid(false),
+    _plps(),
+    _all_plps(false),
+    _multi_plps(false),
     _outfile_append(false),
     _outfile_keep(false),
     _outfile_name(),
-    _outfile(),
-    _t2mi_count(0),
-    _ts_count(0),
+    _plp_contexts(),
     _demux(this),
     _ts_queue()
 {
+    option(u"all-plps",     0);
     option(u"append",      'a');
     option(u"extract",     'e');
     option(u"keep",        'k');
     option(u"log",         'l');
     option(u"output-file", 'o', STRING);
     option(u"pid",         'p', PIDVAL);
-    option(u"plp",          0,  UINT8);
+    option(u"plp",          0,  UINT8, 0, UNLIMITED_COUNT);
 
     setHelp(u"Options:\n"
+            u"\n"
+            u"  --all-plps\n"
+            u"      Extract all PLP's which are found in the T2-MI encapsulation. Each PLP is\n"
+            u"      saved in a separate file. Option --output-file is required.\n"
             u"\n"
             u"  -a\n"
             u"  --append\n"
@@ -151,6 +178,9 @@ ts::T2MIPlugin::T2MIPlugin(TSP* tsp_) :
             u"  --output-file filename\n"
             u"      Specify that the extracted stream is saved in this file. In that case,\n"
             u"      the main transport stream is passed unchanged to the next plugin.\n"
+            u"      When several PLP's are extracted, each PLP is saved in a separate file.\n"
+            u"      The PLP number is inserted before the file extension. Example: with\n"
+            u"      --output-file out.ts, PLP 2 is saved in out-plp2.ts.\n"
             u"\n"
             u"  -p value\n"
             u"  --pid value\n"
@@ -160,6 +190,8 @@ ts::T2MIPlugin::T2MIPlugin(TSP* tsp_) :
             u"  --plp value\n"
             u"      Specify the PLP (Physical Layer Pipe) to extract from the T2-MI\n"
             u"      encapsulation. By default, use the first PLP which is found.\n"
+            u"      Several --plp options may be specified to extract several PLP's at\n"
+            u"      once, in separate files. In that case, --output-file is required.\n"
             u"      Ignored if --extract is not used.\n"
             u"\n"
             u"  --version\n"
@@ -167,6 +199,19 @@ ts::T2MIPlugin::T2MIPlugin(TSP* tsp_) :
 }
 
 
+//----------------------------------------------------------------------------
+// PLP extraction context.
+//----------------------------------------------------------------------------
+
+ts::T2MIPlugin::PLPContext::PLPContext() :
+    outfile(),
+    buffer(),
+    t2mi_count(0),
+    ts_count(0)
+{
+}
+
+
 //----------------------------------------------------------------------------
 // Start method
 //----------------------------------------------------------------------------
@@ -177,8 +222,9 @@ bool ts::T2MIPlugin::start()
     _extract = present(u"extract");
     _log = present(u"log");
     getIntValue<PID>(_pid, u"pid", PID_NULL);
-    getIntValue<uint8_t>(_plp, u"plp");
-    _plp_valid = present(u"plp");
+    getIntValues(_plps, u"plp");
+    _all_plps = present(u"all-plps");
+    _multi_plps = _all_plps || _plps.size() > 1;
     _outfile_append = present(u"append");
     _outfile_keep = present(u"keep");
     getValue(_outfile_name, u"output-file");
@@ -188,6 +234,10 @@ bool ts::T2MIPlugin::start()
     if (!_extract && !_log) {
         _extract = true;
     }
+    if (_extract && _multi_plps && _replace_ts) {
+        tsp->error(u"--output-file is required to extract several PLP's");
+        return false;
+    }
 
     // Initialize the demux.
     _demux.reset();
@@ -197,12 +247,16 @@ bool ts::T2MIPlugin::start()
 
     // Reset the packet output.
     _ts_queue.clear();
-    _t2mi_count = 0;
-    _ts_count = 0;
+    _plp_contexts.clear();
     _abort = false;
 
-    // Open output file if present.
-    return _replace_ts || _outfile.open(_outfile_name, _outfile_append, _outfile_keep, *tsp);
+    // Open output files of explicitly specified PLP's.
+    if (_extract) {
+        for (std::set<uint8_t>::const_iterator it = _plps.begin(); !_abort && it != _plps.end(); ++it) {
+            startPLP(*it);
+        }
+    }
+    return !_abort;
 }
 
 
@@ -212,10 +266,53 @@ bool ts::T2MIPlugin::start()
 
 bool ts::T2MIPlugin::stop()
 {
-    if (_extract) {
-        tsp->verbose(u"extracted %'d TS packets from %'d T2-MI packets", {_ts_count, _t2mi_count});
+    bool ok = true;
+    for (PLPContextMap::iterator it = _plp_contexts.begin(); it != _plp_contexts.end(); ++it) {
+        PLPContext& ctx(*it->second);
+        tsp->verbose(u"PLP 0x%X (%d): extracted %'d TS packets from %'d T2-MI packets", {it->first, it->first, ctx.ts_count, ctx.t2mi_count});
+        if (!_replace_ts) {
+            ok = flushPLP(ctx) && ok;
+            ok = ctx.outfile.close(*tsp) && ok;
+        }
     }
-    return _replace_ts || _outfile.close(*tsp);
+    _plp_contexts.clear();
+    return ok;
+}
+
+
+//----------------------------------------------------------------------------
+// Start the extraction of a PLP.
+//----------------------------------------------------------------------------
+
+ts::T2MIPlugin::PLPContextMap::iterator ts::T2MIPlugin::startPLP(uint8_t plp)
+{
+    PLPContextPtr ctx(new PLPContext);
+    CheckNonNull(ctx.pointer());
+
+    if (!_replace_ts) {
+        // With several PLP's, insert the PLP number before the file extension.
+        const UString name(_multi_plps ? PathPrefix(_outfile_name) + UString::Format(u"-plp%d", {plp}) + PathSuffix(_outfile_name) : _outfile_name);
+        if (!ctx->outfile.open(name, _outfile_append, _outfile_keep, *tsp)) {
+            _abort = true;
+            return _plp_contexts.end();
+        }
+        ctx->buffer.reserve(WRITE_PACKETS);
+    }
+
+    tsp->verbose(u"extracting PLP 0x%X (%d)", {plp, plp});
+    return _plp_contexts.insert(std::make_pair(plp, ctx)).first;
+}
+
+
+//----------------------------------------------------------------------------
+// Write the buffered packets of a PLP in its output file.
+//----------------------------------------------------------------------------
+
+bool ts::T2MIPlugin::flushPLP(PLPContext& ctx)
+{
+    const bool ok = ctx.buffer.empty() || ctx.outfile.write(&ctx.buffer[0], ctx.buffer.size(), *tsp);
+    ctx.buffer.clear();
+    return ok;
 }
 
 
@@ -252,17 +349,16 @@ void ts::T2MIPlugin::handleT2MIPacket(T2MIDemux& demux, const T2MIPacket& pkt)
                    pkt.size(), pkt.packetCount(), pkt.superframeIndex(), pkt.frameIndex(), plpInfo});
     }
 
-    // Select PLP when extraction is requested.
+    // Select PLP's when extraction is requested.
     if (_extract && pkt.plpValid()) {
-        if (!_plp_valid) {
-            // The PLP was not yet specified, use this one by default.
-            _plp = pkt.plp();
-            _plp_valid = true;
-            tsp->verbose(u"extracting PLP 0x%X (%d)", {_plp, _plp});
+        PLPContextMap::iterator it = _plp_contexts.find(pkt.plp());
+        if (it == _plp_contexts.end() && !_abort && (_all_plps || (_plps.empty() && _plp_contexts.empty()))) {
+            // The PLP's were not specified, use this one.
+            it = startPLP(pkt.plp());
         }
-        if (pkt.plp() == _plp) {
+        if (it != _plp_contexts.end()) {
             // Count input T2-MI packets.
-            _t2mi_count++;
+            it->second->t2mi_count++;
         }
     }
 }
@@ -279,11 +375,12 @@ void ts::T2MIPlugin::handleTSPacket(T2MIDemux& demux, const T2MIPacket& t2mi, co
         return;
     }
 
-    // PLP must be known since handleT2MIPacket() is always called before handleTSPacket().
-    assert(_plp_valid);
-
-    // Keep packet from the filtered PLP only.
-    if (t2mi.plp() == _plp) {
+    // Keep packets from the extracted PLP's only.
+    // The PLP contexts are created in handleT2MIPacket() which is always called before handleTSPacket().
+    const PLPContextMap::iterator it = _plp_contexts.find(t2mi.plp());
+    if (it != _plp_contexts.end()) {
+        PLPContext& ctx(*it->second);
+        ctx.ts_count++;
 
         if (_replace_ts) {
             // Enqueue the TS packet for replacement later.
@@ -294,8 +391,11 @@ void ts::T2MIPlugin::handleTSPacket(T2MIDemux& demux, const T2MIPacket& t2mi, co
             _ts_queue.push_back(ts);
         }
         else {
-            // Write the packet to output file.
-            _abort = _abort || !_outfile.write(&ts, 1, *tsp);
+            // Write the packets to the output file by groups.
+            ctx.buffer.push_back(ts);
+            if (ctx.buffer.size() >= WRITE_PACKETS) {
+                _abort = !flushPLP(ctx) || _abort;
+            }
         }
     }
 }
@@ -325,7 +425,6 @@ ts::ProcessorPlugin::Status ts::T2MIPlugin::processPacket(TSPacket& pkt, bool& f
         // Replace the current packet with the next demux'ed TS packet.
         pkt = _ts_queue.front();
         _ts_queue.pop_front();
-        _ts_count++;
         return TSP_OK;
     }
 }
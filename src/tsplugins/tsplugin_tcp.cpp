@@ -0,0 +1,457 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  Transport stream processor shared library:
+//  TCP input / output
+//
+//----------------------------------------------------------------------------
+
+#include "tsPlugin.h"
+#include "tsPluginRepository.h"
+#include "tsTCPConnection.h"
+#include "tsTCPServer.h"
+#include "tsSysUtils.h"
+#include "tsByteBlock.h"
+#include "tsNullReport.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// Plugin definition
+//----------------------------------------------------------------------------
+
+namespace ts {
+
+    // Connection setup and options, common to input and output.
+    class TCPPluginConnection
+    {
+    public:
+        // Constructor: define the common options in the plugin.
+        TCPPluginConnection(Args& args);
+
+        // Load the common options.
+        bool loadArgs(Args& args);
+
+        // Establish the connection: connect to server or wait for a client.
+        bool open(Report& report);
+
+        // Close the connection.
+        void close(Report& report);
+
+        TCPConnection client;  // The TCP session
+
+    private:
+        SocketAddress _addr;        // Remote server or local address to listen to
+        bool          _server;      // Wait for a client, do not connect
+        bool          _reuse_port;  // Reuse port option
+        bool          _no_delay;    // Set TCP_NODELAY
+        size_t        _buffer_size; // Socket buffer size, zero means system default
+
+        // Set the socket buffer sizes, if specified.
+        bool setBufferSize(TCPSocket& sock, Report& report);
+
+        // Inaccessible operations
+        TCPPluginConnection() = delete;
+        TCPPluginConnection(const TCPPluginConnection&) = delete;
+        TCPPluginConnection& operator=(const TCPPluginConnection&) = delete;
+    };
+
+    // Input plugin
+    class TCPInput: public InputPlugin
+    {
+    public:
+        // Implementation of plugin API
+        TCPInput(TSP*);
+        virtual bool start() override;
+        virtual bool stop() override;
+        virtual size_t receive(TSPacket*, size_t) override;
+
+    private:
+        TCPPluginConnection _conn;       // TCP connection
+        ByteBlock           _partial;    // Received bytes which are not yet returned
+        uint64_t            _lost_bytes; // Number of bytes which were skipped to resynchronize
+        PacketCounter       _resyncs;    // Number of resynchronizations
+
+        // Inaccessible operations
+        TCPInput() = delete;
+        TCPInput(const TCPInput&) = delete;
+        TCPInput& operator=(const TCPInput&) = delete;
+    };
+
+    // Output plugin
+    class TCPOutput: public OutputPlugin
+    {
+    public:
+        // Implementation of plugin API
+        TCPOutput(TSP*);
+        virtual bool start() override;
+        virtual bool stop() override;
+        virtual bool send(const TSPacket*, size_t) override;
+
+    private:
+        TCPPluginConnection _conn;  // TCP connection
+
+        // Inaccessible operations
+        TCPOutput() = delete;
+        TCPOutput(const TCPOutput&) = delete;
+        TCPOutput& operator=(const TCPOutput&) = delete;
+    };
+}
+
+TSPLUGIN_DECLARE_VERSION
+TSPLUGIN_DECLARE_INPUT(tcp, ts::TCPInput)
+TSPLUGIN_DECLARE_OUTPUT(tcp, ts::TCPOutput)
+
+
+//----------------------------------------------------------------------------
+// Common connection: constructor, define options.
+//----------------------------------------------------------------------------
+
+ts::TCPPluginConnection::TCPPluginConnection(Args& args) :
+    client(),
+    _addr(),
+    _server(false),
+    _reuse_port(false),
+    _no_delay(false),
+    _buffer_size(0)
+{
+    args.option(u"",            0,  Args::STRING, 1, 1);
+    args.option(u"buffer-size", 'b', Args::POSITIVE);
+    args.option(u"no-delay",    'n');
+    args.option(u"reuse-port",  'r');
+    args.option(u"server",      's');
+}
+
+
+//----------------------------------------------------------------------------
+// Common connection: load command line arguments.
+//----------------------------------------------------------------------------
+
+bool ts::TCPPluginConnection::loadArgs(Args& args)
+{
+    _server = args.present(u"server");
+    _reuse_port = args.present(u"reuse-port");
+    _no_delay = args.present(u"no-delay");
+    _buffer_size = args.intValue<size_t>(u"buffer-size", 0);
+
+    // Resolve the address. A client needs a server address, a server only needs a port.
+    if (!_addr.resolve(args.value(u""), args)) {
+        return false;
+    }
+    if (!_addr.hasPort()) {
+        args.error(u"missing port number in %s", {args.value(u"")});
+        return false;
+    }
+    if (!_server && !_addr.hasAddress()) {
+        args.error(u"missing server address in %s", {args.value(u"")});
+        return false;
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Common connection: establish the connection.
+//----------------------------------------------------------------------------
+
+bool ts::TCPPluginConnection::open(Report& report)
+{
+    SocketAddress peer(_addr);
+
+    // The socket buffer sizes are set before connecting or listening, so that
+    // large TCP windows can be negotiated. Accepted sockets inherit them.
+    if (_server) {
+        // Wait for exactly one client on the local address.
+        TCPServer server;
+        if (!server.open(report)) {
+            return false;
+        }
+        if (!setBufferSize(server, report) || !server.reusePort(_reuse_port, report) || !server.bind(_addr, report) || !server.listen(1, report)) {
+            server.close(report);
+            return false;
+        }
+        report.verbose(u"waiting for a TCP connection on %s", {_addr.toString()});
+        const bool ok = server.accept(client, peer, report);
+        server.close(report);
+        if (!ok) {
+            return false;
+        }
+    }
+    else if (!client.open(report) || !setBufferSize(client, report) || !client.connect(_addr, report)) {
+        client.close(NULLREP);
+        return false;
+    }
+
+    if (_no_delay && !client.setNoDelay(true, report)) {
+        close(report);
+        return false;
+    }
+
+    report.verbose(u"connected to %s", {peer.toString()});
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Common connection: set the socket buffer sizes.
+//----------------------------------------------------------------------------
+
+bool ts::TCPPluginConnection::setBufferSize(TCPSocket& sock, Report& report)
+{
+    return _buffer_size == 0 || (sock.setSendBufferSize(_buffer_size, report) && sock.setReceiveBufferSize(_buffer_size, report));
+}
+
+
+//----------------------------------------------------------------------------
+// Common connection: close the connection.
+//----------------------------------------------------------------------------
+
+void ts::TCPPluginConnection::close(Report& report)
+{
+    if (client.isOpen()) {
+        client.disconnect(NULLREP);
+        client.close(report);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Input constructor
+//----------------------------------------------------------------------------
+
+ts::TCPInput::TCPInput(TSP* tsp_) :
+    InputPlugin(tsp_, u"Receive TS packets from a TCP connection.", u"[options] [address:]port"),
+    _conn(*this),
+    _partial(),
+    _lost_bytes(0),
+    _resyncs(0)
+{
+    setHelp(u"Parameter:\n"
+            u"  Without --server, the parameter specifies the address and port of the\n"
+            u"  remote TCP server to connect to. With --server, the parameter specifies\n"
+            u"  the local port and optional local address which is used to wait for an\n"
+            u"  incoming connection.\n"
+            u"\n"
+            u"  The TCP stream is a raw sequence of 188-byte TS packets. The reception\n"
+            u"  is resynchronized on the sync byte when necessary.\n"
+            u"\n"
+            u"Options:\n"
+            u"\n"
+            u"  -b value\n"
+            u"  --buffer-size value\n"
+            u"      Specify the socket receive buffer size in bytes.\n"
+            u"\n"
+            u"  --help\n"
+            u"      Display this help text.\n"
+            u"\n"
+            u"  -n\n"
+            u"  --no-delay\n"
+            u"      Set the TCP_NODELAY option on the socket.\n"
+            u"\n"
+            u"  -r\n"
+            u"  --reuse-port\n"
+            u"      With --server, set the 'reuse port' socket option.\n"
+            u"\n"
+            u"  -s\n"
+            u"  --server\n"
+            u"      Wait for one incoming connection from a client. By default, connect\n"
+            u"      to the specified server.\n"
+            u"\n"
+            u"  --version\n"
+            u"      Display the version number.\n");
+}
+
+
+//----------------------------------------------------------------------------
+// Input start / stop methods
+//----------------------------------------------------------------------------
+
+bool ts::TCPInput::start()
+{
+    _partial.clear();
+    _lost_bytes = 0;
+    _resyncs = 0;
+    return _conn.loadArgs(*this) && _conn.open(*tsp);
+}
+
+bool ts::TCPInput::stop()
+{
+    if (_resyncs > 0) {
+        tsp->verbose(u"%'d resynchronizations, %'d bytes skipped", {_resyncs, _lost_bytes});
+    }
+    _conn.close(*tsp);
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Input method
+//----------------------------------------------------------------------------
+
+size_t ts::TCPInput::receive(TSPacket* buffer, size_t max_packets)
+{
+    uint8_t* const data = buffer->b;
+    const size_t max_size = max_packets * PKT_SIZE;
+
+    // Restore the bytes which were received but not returned by the previous call.
+    size_t size = std::min(_partial.size(), max_size);
+    ::memcpy(data, _partial.data(), size);
+    _partial.erase(0, size);
+
+    // Receive directly into the packet buffer, as much as possible.
+    bool eof = false;
+    for (;;) {
+
+        // Get enough bytes to check the synchronization on two packets when possible,
+        // first from previously received bytes. At end of connection, accept one packet.
+        const size_t needed = std::min(2 * PKT_SIZE, max_size);
+        while (!eof && size < needed) {
+            size_t ret = std::min(_partial.size(), max_size - size);
+            if (ret > 0) {
+                ::memcpy(data + size, _partial.data(), ret);
+                _partial.erase(0, ret);
+            }
+            else if (!_conn.client.receive(data + size, max_size - size, ret, tsp, *tsp)) {
+                eof = true;
+            }
+            size += ret;
+        }
+        if (size < PKT_SIZE) {
+            return 0;
+        }
+
+        // Check synchronization on the first packet, using the next one when available.
+        if (data[0] == SYNC_BYTE && (size < 2 * PKT_SIZE || data[PKT_SIZE] == SYNC_BYTE)) {
+            break;
+        }
+
+        // Synchronization lost: skip bytes up to a sync byte which is followed by another
+        // one, one packet later. When there are not enough bytes to check it, the candidate
+        // is checked again after receiving more data.
+        size_t start = 1;
+        while (start < size && (data[start] != SYNC_BYTE || (start + PKT_SIZE < size && data[start + PKT_SIZE] != SYNC_BYTE))) {
+            start++;
+        }
+        if (_resyncs++ == 0) {
+            tsp->verbose(u"TS synchronization lost, resynchronizing");
+        }
+        _lost_bytes += start;
+        size -= start;
+        ::memmove(data, data + start, size);
+    }
+
+    // Return complete packets, up to the next loss of synchronization, if any.
+    // When a packet is not followed by a sync byte, its size is wrong and it is
+    // checked again at the beginning of the next call. The first packet was
+    // already checked with the second one.
+    size_t count = size / PKT_SIZE;
+    for (size_t i = 2; i < count; ++i) {
+        if (data[i * PKT_SIZE] != SYNC_BYTE) {
+            count = i - 1;
+            break;
+        }
+    }
+
+    // Keep the rest for next time.
+    _partial.insert(_partial.begin(), data + count * PKT_SIZE, data + size);
+    return count;
+}
+
+
+//----------------------------------------------------------------------------
+// Output constructor
+//----------------------------------------------------------------------------
+
+ts::TCPOutput::TCPOutput(TSP* tsp_) :
+    OutputPlugin(tsp_, u"Send TS packets over a TCP connection.", u"[options] [address:]port"),
+    _conn(*this)
+{
+    setHelp(u"Parameter:\n"
+            u"  Without --server, the parameter specifies the address and port of the\n"
+            u"  remote TCP server to connect to. With --server, the parameter specifies\n"
+            u"  the local port and optional local address which is used to wait for an\n"
+            u"  incoming connection.\n"
+            u"\n"
+            u"  The TCP stream is a raw sequence of 188-byte TS packets.\n"
+            u"\n"
+            u"Options:\n"
+            u"\n"
+            u"  -b value\n"
+            u"  --buffer-size value\n"
+            u"      Specify the socket send buffer size in bytes.\n"
+            u"\n"
+            u"  --help\n"
+            u"      Display this help text.\n"
+            u"\n"
+            u"  -n\n"
+            u"  --no-delay\n"
+            u"      Set the TCP_NODELAY option on the socket: the packets are sent as soon\n"
+            u"      as possible, without waiting for enough data to fill a TCP segment.\n"
+            u"\n"
+            u"  -r\n"
+            u"  --reuse-port\n"
+            u"      With --server, set the 'reuse port' socket option.\n"
+            u"\n"
+            u"  -s\n"
+            u"  --server\n"
+            u"      Wait for one incoming connection from a client before starting the\n"
+            u"      transmission. By default, connect to the specified server.\n"
+            u"\n"
+            u"  --version\n"
+            u"      Display the version number.\n");
+}
+
+
+//----------------------------------------------------------------------------
+// Output start / stop methods
+//----------------------------------------------------------------------------
+
+bool ts::TCPOutput::start()
+{
+    // We will handle broken connections, don't kill us for that.
+    IgnorePipeSignal();
+    return _conn.loadArgs(*this) && _conn.open(*tsp);
+}
+
+bool ts::TCPOutput::stop()
+{
+    _conn.close(*tsp);
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Output method
+//----------------------------------------------------------------------------
+
+bool ts::TCPOutput::send(const TSPacket* buffer, size_t packet_count)
+{
+    // Send all packets at once, directly from the packet buffer.
+    return _conn.client.send(buffer, packet_count * PKT_SIZE, *tsp);
+}
@@ -35,10 +35,13 @@
 #include "tsPlugin.h"
 #include "tsPluginRepository.h"
 #include "tsServiceDiscovery.h"
+#include "tsSectionDemux.h"
 #include "tsSubRipGenerator.h"
 #include "tsTeletextDemux.h"
 #include "tsTeletextFrame.h"
 #include "tsTeletextDescriptor.h"
+#include "tsSysUtils.h"
+#include "tsPAT.h"
 TSDUCK_SOURCE;
 
 
@@ -50,6 +53,7 @@ namespace ts {
     class TeletextPlugin:
         public ProcessorPlugin,
         private PMTHandlerInterface,
+        private TableHandlerInterface,
         private TeletextHandlerInterface
     {
     public:
@@ -60,19 +64,35 @@ namespace ts {
         virtual Status processPacket(TSPacket&, bool&, bool&) override;
 
     private:
+        // With --all, one SRT output per Teletext PID and page.
+        typedef SafePtr<SubRipGenerator, NullMutex> SubRipGeneratorPtr;
+        typedef std::pair<PID, int> PIDPage;
+        typedef std::map<PIDPage, SubRipGeneratorPtr> OutputMap;
+
         bool             _abort;      // Error (service not found, etc).
+        bool             _all;        // Extract all pages of all Teletext PIDs.
+        bool             _allPMT;     // With --all, look for Teletext PID's in all PMT's.
         PID              _pid;        // Teletext PID.
         int              _page;       // Teletext page.
         int              _maxFrames;  // Max number of Teletext frames to generate.
         UString          _language;   // Language to select.
         UString          _outFile;    // Output file name.
         ServiceDiscovery _service;    // Service name & id.
+        SectionDemux     _psiDemux;   // PSI demux to find all PMT's with --all.
         TeletextDemux    _demux;      // Teletext demux to extract subtitle frames.
         SubRipGenerator  _srtOutput;  // Generate SRT output file.
+        OutputMap        _outputs;    // SRT output files with --all.
         std::set<int>    _pages;      // Set of all Teletext pages in the PID (for information only).
 
+        // Add all Teletext PID's of a PMT in the Teletext demux (with --all).
+        void addAllTeletextPIDs(const PMT& pmt);
+
+        // Get or create the SRT output for a PID and page (with --all).
+        SubRipGenerator* getOutput(PID pid, int page);
+
         // Implementation of interfaces.
         virtual void handlePMT(const PMT& table) override;
+        virtual void handleTable(SectionDemux& demux, const BinaryTable& table) override;
         virtual void handleTeletextMessage(TeletextDemux& demux, const TeletextFrame& frame) override;
 
         // Inaccessible operations
@@ -93,25 +113,42 @@ TSPLUGIN_DECLARE_PROCESSOR(teletext, ts::TeletextPlugin)
 ts::TeletextPlugin::TeletextPlugin(TSP* tsp_) :
     ProcessorPlugin(tsp_, u"Extract Teletext subtitles in SRT format.", u"[options]"),
     _abort(false),
+    _all(false),
+    _allPMT(false),
     _pid(PID_NULL),
     _page(-1),
     _maxFrames(0),
     _language(),
     _outFile(),
     _service(this, *tsp),
+    _psiDemux(this),
     _demux(this, NoPID),
     _srtOutput(),
+    _outputs(),
     _pages()
 {
+    option(u"all",         'a');
     option(u"colors",      'c');
     option(u"language",    'l', STRING);
     option(u"max-frames",  'm', POSITIVE);
     option(u"output-file", 'o', STRING);
     option(u"page",         0,  POSITIVE);
-    option(u"pid",         'p', PIDVAL);
+    option(u"pid",         'p', PIDVAL, 0, UNLIMITED_COUNT);
     option(u"service",     's', STRING);
 
     setHelp(u"Options:\n"
+            u"\n"
+            u"  -a\n"
+            u"  --all\n"
+            u"      Extract all Teletext pages of all Teletext PID's in one pass. Each page\n"
+            u"      of each PID is written in a separate SRT file. The option --output-file\n"
+            u"      is then required and is used as a template: the PID and page numbers are\n"
+            u"      inserted before the file suffix. For instance, with '-o subs.srt', page\n"
+            u"      888 of PID 0x0100 is written in file subs-256-888.srt. The Teletext\n"
+            u"      PID's are specified with --pid (several PID's are allowed with --all),\n"
+            u"      or taken from the PMT of the service specified by --service. By default,\n"
+            u"      all Teletext PID's of all services in the PAT are extracted. The options\n"
+            u"      --language and --page are not allowed with --all.\n"
             u"\n"
             u"  -c\n"
             u"  --colors\n"
@@ -129,7 +166,8 @@ ts::TeletextPlugin::TeletextPlugin(TSP* tsp_) :
             u"  -m value\n"
             u"  --max-frames value\n"
             u"      Specifies the maximum number of Teletext frames to extract. The processing\n"
-            u"      is then stopped. By default, all frames are extracted.\n"
+            u"      is then stopped. By default, all frames are extracted. With --all, the\n"
+            u"      maximum applies to each page and the processing is not stopped.\n"
             u"\n"
             u"  -o filename\n"
             u"  --output-file filename\n"
@@ -169,6 +207,7 @@ ts::TeletextPlugin::TeletextPlugin(TSP* tsp_) :
 bool ts::TeletextPlugin::start()
 {
     // Get command line arguments.
+    _all = present(u"all");
     _service.set(value(u"service"));
     _pid = intValue<PID>(u"pid", PID_NULL);
     _page = intValue<int>(u"page", -1);
@@ -177,8 +216,25 @@ bool ts::TeletextPlugin::start()
     getValue(_outFile, u"output-file");
     _demux.setAddColors(present(u"colors"));
 
-    // Create the output file.
-    if (_outFile.empty()) {
+    // Check option consistency.
+    if (_all && _outFile.empty()) {
+        tsp->error(u"--output-file is required with --all");
+        return false;
+    }
+    if (_all && (_page >= 0 || !_language.empty())) {
+        tsp->error(u"--page and --language are not allowed with --all");
+        return false;
+    }
+    if (!_all && count(u"pid") > 1) {
+        tsp->error(u"only one --pid is allowed without --all");
+        return false;
+    }
+
+    // Create the output file. With --all, output files are created on demand.
+    if (_all) {
+        _outputs.clear();
+    }
+    else if (_outFile.empty()) {
         // No output file specified, use standard output.
         _srtOutput.setStream(&std::cout);
     }
@@ -190,11 +246,19 @@ bool ts::TeletextPlugin::start()
     // Reinitialize the plugin state.
     _abort = false;
     _demux.reset();
+    _psiDemux.reset();
     _pages.clear();
 
-    // If the Teletext page is already known, filter it immediately.
-    if (_pid != PID_NULL) {
-        _demux.addPID(_pid);
+    // If the Teletext PID's are already known, filter them immediately.
+    const size_t pidCount = count(u"pid");
+    for (size_t i = 0; i < pidCount; ++i) {
+        _demux.addPID(intValue<PID>(u"pid", PID_NULL, i));
+    }
+
+    // With --all and neither --pid nor --service, collect Teletext PID's from all PMT's.
+    _allPMT = _all && _pid == PID_NULL && !_service.hasName() && !_service.hasId();
+    if (_allPMT) {
+        _psiDemux.addPID(PID_PAT);
     }
 
     return true;
@@ -209,16 +273,45 @@ bool ts::TeletextPlugin::stop()
 {
     _demux.flushTeletext();
     _srtOutput.close();
+    for (OutputMap::iterator it = _outputs.begin(); it != _outputs.end(); ++it) {
+        it->second->close();
+    }
+    _outputs.clear();
     return true;
 }
 
 
+//----------------------------------------------------------------------------
+// Add all Teletext PID's of a PMT in the Teletext demux (with --all).
+//----------------------------------------------------------------------------
+
+void ts::TeletextPlugin::addAllTeletextPIDs(const PMT& pmt)
+{
+    for (PMT::StreamMap::const_iterator it = pmt.streams.begin(); it != pmt.streams.end(); ++it) {
+        if (it->second.descs.search(DID_TELETEXT) < it->second.descs.count() && !_demux.hasPID(it->first)) {
+            _demux.addPID(it->first);
+            tsp->verbose(u"using Teletext PID 0x%X (%d) in service 0x%X (%d)", {it->first, it->first, pmt.service_id, pmt.service_id});
+        }
+    }
+}
+
+
 //----------------------------------------------------------------------------
 // Invoked by the service discovery when the PMT of the service is available.
 //----------------------------------------------------------------------------
 
 void ts::TeletextPlugin::handlePMT(const PMT& pmt)
 {
+    // With --all, use all Teletext PID's of the service.
+    if (_all) {
+        addAllTeletextPIDs(pmt);
+        if (_demux.pidCount() == 0) {
+            tsp->error(u"no Teletext subtitles found for service 0x%X (%d)", {pmt.service_id, pmt.service_id});
+            _abort = true;
+        }
+        return;
+    }
+
     bool languageOK = _language.empty();
     bool pageOK = _page < 0;
 
@@ -272,12 +365,81 @@ void ts::TeletextPlugin::handlePMT(const PMT& pmt)
 }
 
 
+//----------------------------------------------------------------------------
+// Invoked by the PSI demux with --all when no service is specified.
+//----------------------------------------------------------------------------
+
+void ts::TeletextPlugin::handleTable(SectionDemux& demux, const BinaryTable& table)
+{
+    switch (table.tableId()) {
+
+        case TID_PAT: {
+            const PAT pat(table);
+            if (pat.isValid()) {
+                for (PAT::ServiceMap::const_iterator it = pat.pmts.begin(); it != pat.pmts.end(); ++it) {
+                    _psiDemux.addPID(it->second);
+                }
+            }
+            break;
+        }
+
+        case TID_PMT: {
+            const PMT pmt(table);
+            if (pmt.isValid()) {
+                addAllTeletextPIDs(pmt);
+            }
+            break;
+        }
+
+        default: {
+            break;
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Get or create the SRT output for a PID and page (with --all).
+//----------------------------------------------------------------------------
+
+ts::SubRipGenerator* ts::TeletextPlugin::getOutput(PID pid, int page)
+{
+    const PIDPage key(pid, page);
+    OutputMap::const_iterator it = _outputs.find(key);
+    if (it != _outputs.end()) {
+        return it->second.pointer();
+    }
+
+    // First frame for this PID and page, create the output file.
+    const UString fileName(PathPrefix(_outFile) + UString::Format(u"-%d-%d", {pid, page}) + PathSuffix(_outFile));
+    SubRipGeneratorPtr srt(new SubRipGenerator);
+    if (!srt->open(fileName, *tsp)) {
+        _abort = true;
+        return 0;
+    }
+    tsp->verbose(u"Teletext page %d in PID 0x%X (%d) extracted to %s", {page, pid, pid, fileName});
+    _outputs[key] = srt;
+    return srt.pointer();
+}
+
+
 //----------------------------------------------------------------------------
 // Invoked when a complete Teletext message is available.
 //----------------------------------------------------------------------------
 
 void ts::TeletextPlugin::handleTeletextMessage(TeletextDemux& demux, const TeletextFrame& frame)
 {
+    // With --all, each page of each PID goes into its own output file.
+    if (_all) {
+        if (_maxFrames <= 0 || frame.frameCount() <= _maxFrames) {
+            SubRipGenerator* srt = getOutput(frame.pid(), frame.page());
+            if (srt != 0) {
+                srt->addFrame(frame.showTimestamp(), frame.hideTimestamp(), frame.lines());
+            }
+        }
+        return;
+    }
+
     // If the Teletext page was not specified, use the first one.
     if (_page < 0) {
         _page = frame.page();
@@ -310,8 +472,12 @@ void ts::TeletextPlugin::handleTeletextMessage(TeletextDemux& demux, const Telet
 
 ts::ProcessorPlugin::Status ts::TeletextPlugin::processPacket(TSPacket& pkt, bool& flush, bool& bitrate_changed)
 {
+    // With --all and no service, look for Teletext PID's in all PMT's.
+    if (_allPMT) {
+        _psiDemux.feedPacket(pkt);
+    }
     // As long as the Teletext PID is not found, we look for the service.
-    if (_pid == PID_NULL) {
+    else if (_pid == PID_NULL && (!_all || _demux.pidCount() == 0)) {
         _service.feedPacket(pkt);
     }
 
@@ -37,6 +37,7 @@
 #include "tsSectionDemux.h"
 #include "tsEnumeration.h"
 #include "tsTime.h"
+#include "tsCoarseClock.h"
 #include "tsTDT.h"
 TSDUCK_SOURCE;
 
@@ -76,6 +77,7 @@ namespace ts {
         bool              _use_utc;      // Use UTC time
         bool              _use_tdt;      // Use TDT as time reference
         Time              _last_time;    // Last measured time
+        CoarseClock       _clock;        // Cheap system clock, read for each packet
         const Enumeration _status_names; // Names of packet status
         SectionDemux      _demux;        // Section filter
         TimeEventVector   _events;       // Sorted list of time events to apply
@@ -109,6 +111,7 @@ ts::TimePlugin::TimePlugin (TSP* tsp_) :
     _use_utc(false),
     _use_tdt(false),
     _last_time(Time::Epoch),
+    _clock(),
     _status_names({{u"pass", TSP_OK}, {u"stop", TSP_END}, {u"drop", TSP_DROP}, {u"null", TSP_NULL}}),
     _demux(this),
     _events(),
@@ -221,6 +224,7 @@ bool ts::TimePlugin::start()
 
     _last_time = Time::Epoch;
     _next_index = 0;
+    _clock.reset();
 
     return true;
 }
@@ -292,9 +296,10 @@ ts::ProcessorPlugin::Status ts::TimePlugin::processPacket(TSPacket& pkt, bool& f
     // Filter sections
     _demux.feedPacket(pkt);
 
-    // Get current system time (unless TDT is used as reference)
-    if (!_use_tdt) {
-        _last_time = _use_utc ? Time::CurrentUTC() : Time::CurrentLocalTime();
+    // Get current system time (unless TDT is used as reference or no more event to apply).
+    // The system time is read from a coarse clock, without system call and local time conversion.
+    if (!_use_tdt && _next_index < _events.size()) {
+        _last_time = _use_utc ? _clock.utc() : _clock.localTime();
     }
 
     // Is it time to change the action?
@@ -37,6 +37,7 @@
 #include "tsTime.h"
 #include "tsMJD.h"
 #include "tsCRC32.h"
+#include "tsByteBlock.h"
 TSDUCK_SOURCE;
 
 
@@ -61,6 +62,11 @@ namespace ts {
         PacketCounter _current_pkt;       // Current packet in TS
         bool          _update_tdt;        // Update the TDT
         bool          _update_tot;        // Update the TOT
+        ByteBlock     _last_tot;          // Last updated TOT section, with a valid CRC32
+        CRC32Delta    _tot_crc_delta;     // Incremental CRC32 update of the UTC time in _last_tot
+
+        // Check if a TOT section is identical to the last one, except the UTC time and CRC32.
+        bool sameAsLastTOT(const uint8_t* section, size_t section_size) const;
 
         // Inaccessible operations
         TimeRefPlugin() = delete;
@@ -85,7 +91,9 @@ ts::TimeRefPlugin::TimeRefPlugin(TSP* tsp_) :
     _timeref_pkt(0),
     _current_pkt(0),
     _update_tdt(false),
-    _update_tot(false)
+    _update_tot(false),
+    _last_tot(),
+    _tot_crc_delta()
 {
     option(u"add",   'a', INTEGER, 0, 1, std::numeric_limits<int>::min(), std::numeric_limits<int>::max());
     option(u"notdt",  0);
@@ -131,6 +139,7 @@ bool ts::TimeRefPlugin::start()
     _add_milliseconds = MilliSecPerSec * intValue<int>(u"add", 0);
     _current_pkt = 0;
     _timeref_pkt = 1;
+    _last_tot.clear();
 
     _use_timeref = present(u"start");
     if (_use_timeref) {
@@ -146,6 +155,19 @@ bool ts::TimeRefPlugin::start()
 }
 
 
+//----------------------------------------------------------------------------
+// Check if a TOT section is identical to the last one, except the UTC time.
+//----------------------------------------------------------------------------
+
+bool ts::TimeRefPlugin::sameAsLastTOT(const uint8_t* section, size_t section_size) const
+{
+    const size_t utc_end = SHORT_SECTION_HEADER_SIZE + MJD_SIZE;
+    return _last_tot.size() == section_size &&
+        ::memcmp(_last_tot.data(), section, SHORT_SECTION_HEADER_SIZE) == 0 &&
+        ::memcmp(_last_tot.data() + utc_end, section + utc_end, section_size - utc_end - 4) == 0;
+}
+
+
 //----------------------------------------------------------------------------
 // Packet processing method
 //----------------------------------------------------------------------------
@@ -198,9 +220,17 @@ ts::ProcessorPlugin::Status ts::TimeRefPlugin::processPacket(TSPacket& pkt, bool
         return TSP_OK;
     }
 
+    // When the TOT is unchanged since the last one, except the UTC time, the CRC32 is
+    // incrementally updated from the last one, based on the modified UTC time only.
+    const bool same_tot = tid == TID_TOT && sameAsLastTOT(section, section_size);
+    uint8_t* const last_crc = same_tot ? _last_tot.data() + section_size - 4 : 0;
+
     // Check TOT CRC if needs to be updated
     if (tid == TID_TOT && !_use_timeref) {
-        if (CRC32(section, section_size - 4) != GetUInt32(section + section_size - 4)) {
+        const uint32_t crc = same_tot ?
+            _tot_crc_delta.update(GetUInt32(last_crc), _last_tot.data() + SHORT_SECTION_HEADER_SIZE, payload) :
+            CRC32(section, section_size - 4).value();
+        if (crc != GetUInt32(section + section_size - 4)) {
             tsp->warning(u"incorrect CRC in TOT, cannot reliably update");
             return TSP_OK;
         }
@@ -233,9 +263,19 @@ ts::ProcessorPlugin::Status ts::TimeRefPlugin::processPacket(TSPacket& pkt, bool
         return TSP_OK;
     }
 
-    // Recompute CRC in TOT
+    // Recompute CRC in TOT and keep it as reference for the next one.
     if (tid == TID_TOT) {
-        PutUInt32(section + section_size - 4, CRC32(section, section_size - 4));
+        if (same_tot) {
+            const uint32_t crc = _tot_crc_delta.update(GetUInt32(last_crc), _last_tot.data() + SHORT_SECTION_HEADER_SIZE, payload);
+            PutUInt32(section + section_size - 4, crc);
+            PutUInt32(last_crc, crc);
+            ::memcpy(_last_tot.data() + SHORT_SECTION_HEADER_SIZE, payload, MJD_SIZE);
+        }
+        else {
+            PutUInt32(section + section_size - 4, CRC32(section, section_size - 4));
+            _last_tot.copy(section, section_size);
+            _tot_crc_delta.setLayout(MJD_SIZE, section_size - SHORT_SECTION_HEADER_SIZE - MJD_SIZE - 4);
+        }
     }
 
     return TSP_OK;
@@ -0,0 +1,309 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+//
+//  Transport stream processor shared library:
+//  Delay the transport stream by a constant time, using a ring file on disk.
+//
+//----------------------------------------------------------------------------
+
+#include "tsPlugin.h"
+#include "tsPluginRepository.h"
+#include "tsMemoryMappedFile.h"
+#include "tsSysUtils.h"
+TSDUCK_SOURCE;
+
+#define DEF_MEMORY_PACKETS  65536   // Default max delay in packets which is kept in memory only
+#define READ_AHEAD_PACKETS   8192   // Granularity of read-ahead in the ring file
+
+
+//----------------------------------------------------------------------------
+// Plugin definition
+//----------------------------------------------------------------------------
+
+namespace ts {
+    class TimeShiftPlugin: public ProcessorPlugin
+    {
+    public:
+        // Implementation of plugin API
+        TimeShiftPlugin(TSP*);
+        virtual bool start() override;
+        virtual bool stop() override;
+        virtual Status processPacket(TSPacket&, bool&, bool&) override;
+        virtual size_t processPacketBatch(const TSPacketView&, TSPacketMetadata*, size_t, Status*, bool&, bool&) override;
+
+    private:
+        // Command line options.
+        PacketCounter    _delay_packets;   // Delay in packets, zero if specified in time.
+        MilliSecond      _delay_ms;        // Delay in milliseconds, zero if specified in packets.
+        size_t           _memory_packets;  // Max delay in packets in memory.
+        UString          _file_name;       // Ring file name, empty for a temporary file.
+        bool             _drop_initial;    // Drop packets while the ring is filling.
+
+        // Working data. The ring contains the packets, followed by their input time stamps.
+        bool             _temp_file;       // The ring file is a temporary file.
+        MemoryMappedFile _file;            // Ring file, when the delay does not fit in memory.
+        ByteBlock        _memory;          // Ring in memory.
+        TSPacket*        _packets;         // Ring of packets.
+        NanoSecond*      _stamps;          // Ring of input time stamps.
+        size_t           _size;            // Number of packets in the ring, zero until allocated.
+        size_t           _next;            // Index of next packet to swap.
+        size_t           _filled;          // Number of valid packets in the ring.
+
+        // Allocate the ring on first packet. Return false on error.
+        bool allocate();
+
+        // Inaccessible operations
+        TimeShiftPlugin() = delete;
+        TimeShiftPlugin(const TimeShiftPlugin&) = delete;
+        TimeShiftPlugin& operator=(const TimeShiftPlugin&) = delete;
+    };
+}
+
+TSPLUGIN_DECLARE_VERSION
+TSPLUGIN_DECLARE_PROCESSOR(timeshift, ts::TimeShiftPlugin)
+
+
+//----------------------------------------------------------------------------
+// Constructor
+//----------------------------------------------------------------------------
+
+ts::TimeShiftPlugin::TimeShiftPlugin(TSP* tsp_) :
+    ProcessorPlugin(tsp_, u"Delay the transport stream by a constant time, using a ring file on disk.", u"[options]"),
+    _delay_packets(0),
+    _delay_ms(0),
+    _memory_packets(0),
+    _file_name(),
+    _drop_initial(false),
+    _temp_file(false),
+    _file(),
+    _memory(),
+    _packets(0),
+    _stamps(0),
+    _size(0),
+    _next(0),
+    _filled(0)
+{
+    option(u"drop-initial",   'd');
+    option(u"file",           'f', STRING);
+    option(u"memory-packets", 'm', UNSIGNED);
+    option(u"packets",        'p', POSITIVE);
+    option(u"time",           't', POSITIVE);
+
+    setHelp(u"Delay the transport stream by a constant time. Each packet is output after\n"
+            u"a constant number of packets, as computed from the delay and the bitrate.\n"
+            u"\n"
+            u"Long delays are stored in a ring file on disk which is mapped in memory. The\n"
+            u"most recent packets and the next packets to output stay in the page cache of\n"
+            u"the system, the rest is paged out. Nothing is locked in memory, unlike a large\n"
+            u"tsp buffer. The delayed packets keep their input time stamps. To reproduce the\n"
+            u"input timing, use -O ip --relay-delay with the same delay.\n"
+            u"\n"
+            u"Options:\n"
+            u"\n"
+            u"  -d\n"
+            u"  --drop-initial\n"
+            u"      Drop output packets while the buffer is initially filling. By default,\n"
+            u"      null packets are output during that time.\n"
+            u"\n"
+            u"  -f name\n"
+            u"  --file name\n"
+            u"      Name of the ring file. It is created or overwritten and its size is\n"
+            u"      preallocated. By default, a temporary file is used and deleted at the end.\n"
+            u"\n"
+            u"  --help\n"
+            u"      Display this help text.\n"
+            u"\n"
+            u"  -m value\n"
+            u"  --memory-packets value\n"
+            u"      Delays up to this number of packets are kept in memory only, without\n"
+            u"      file. The default is " TS_USTRINGIFY(DEF_MEMORY_PACKETS) u" packets.\n"
+            u"\n"
+            u"  -p value\n"
+            u"  --packets value\n"
+            u"      Delay in number of packets.\n"
+            u"\n"
+            u"  -t value\n"
+            u"  --time value\n"
+            u"      Delay in milliseconds. The size of the buffer is computed from the\n"
+            u"      bitrate at the first packet. The bitrate must be known at that time.\n"
+            u"\n"
+            u"  --version\n"
+            u"      Display the version number.\n"
+            u"\n"
+            u"Exactly one of --packets and --time must be specified.\n");
+}
+
+
+//----------------------------------------------------------------------------
+// Start method
+//----------------------------------------------------------------------------
+
+bool ts::TimeShiftPlugin::start()
+{
+    _delay_packets = intValue<PacketCounter>(u"packets", 0);
+    _delay_ms = intValue<MilliSecond>(u"time", 0);
+    _memory_packets = intValue<size_t>(u"memory-packets", DEF_MEMORY_PACKETS);
+    _file_name = value(u"file");
+    _drop_initial = present(u"drop-initial");
+
+    if ((_delay_packets == 0) == (_delay_ms == 0)) {
+        tsp->error(u"specify exactly one of --packets and --time");
+        return false;
+    }
+
+    _size = _next = _filled = 0;
+    _packets = 0;
+    _stamps = 0;
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Stop method
+//----------------------------------------------------------------------------
+
+bool ts::TimeShiftPlugin::stop()
+{
+    if (_file.isOpen()) {
+        _file.close();
+        if (_temp_file) {
+            DeleteFile(_file_name);
+        }
+    }
+    _memory.clear();
+    _packets = 0;
+    _stamps = 0;
+    _size = 0;
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Allocate the ring on first packet.
+//----------------------------------------------------------------------------
+
+bool ts::TimeShiftPlugin::allocate()
+{
+    PacketCounter count = _delay_packets;
+    if (count == 0) {
+        const BitRate bitrate = tsp->bitrate();
+        if (bitrate == 0) {
+            tsp->error(u"unknown bitrate, cannot compute the delay in packets, use --packets");
+            return false;
+        }
+        count = PacketCounter((uint64_t(bitrate) * _delay_ms) / (MilliSecPerSec * PKT_SIZE * 8));
+        if (count == 0) {
+            count = 1;
+        }
+    }
+    const uint64_t bytes = count * (PKT_SIZE + sizeof(NanoSecond));
+    if (bytes > uint64_t(std::numeric_limits<size_t>::max())) {
+        tsp->error(u"delay too large: %'d packets", {count});
+        return false;
+    }
+    _size = size_t(count);
+
+    uint8_t* base = 0;
+    if (_size <= _memory_packets) {
+        _memory.resize(size_t(bytes));
+        base = _memory.data();
+        tsp->verbose(u"delay of %'d packets in memory", {_size});
+    }
+    else {
+        _temp_file = _file_name.empty();
+        if (_temp_file) {
+            _file_name = TempFile(u".tsring");
+        }
+        if (!_file.create(_file_name, size_t(bytes), *tsp)) {
+            return false;
+        }
+        base = _file.writableData();
+        tsp->verbose(u"delay of %'d packets in %s, %'d bytes", {_size, _file_name, bytes});
+    }
+    _packets = reinterpret_cast<TSPacket*>(base);
+    _stamps = reinterpret_cast<NanoSecond*>(base + _size * PKT_SIZE);
+    _next = _filled = 0;
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Packet processing methods
+//----------------------------------------------------------------------------
+
+ts::ProcessorPlugin::Status ts::TimeShiftPlugin::processPacket(TSPacket& pkt, bool& flush, bool& bitrate_changed)
+{
+    TSPacketMetadata mdata;
+    Status status = TSP_OK;
+    processPacketBatch(&pkt, &mdata, 1, &status, flush, bitrate_changed);
+    return status;
+}
+
+size_t ts::TimeShiftPlugin::processPacketBatch(const TSPacketView& pkts, TSPacketMetadata* mdata, size_t count, Status* status, bool& flush, bool& bitrate_changed)
+{
+    if (_size == 0 && !allocate()) {
+        status[0] = TSP_END;
+        return 1;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        // Packets which were dropped by previous plugins are not delayed.
+        if (pkts[i].b[0] == 0) {
+            continue;
+        }
+
+        // Read ahead the next area of the ring file to output.
+        if (_file.isOpen() && _next % READ_AHEAD_PACKETS == 0) {
+            const size_t ahead = (_next + READ_AHEAD_PACKETS) % _size;
+            _file.prefetch(ahead * PKT_SIZE, READ_AHEAD_PACKETS * PKT_SIZE);
+            _file.prefetch(_size * PKT_SIZE + ahead * sizeof(NanoSecond), READ_AHEAD_PACKETS * sizeof(NanoSecond));
+        }
+
+        // Swap the new packet with the oldest one in the ring.
+        const NanoSecond stamp = mdata[i].getInputTimeStamp();
+        if (_filled < _size) {
+            // Buffer is filling, nothing to output yet.
+            _packets[_next] = pkts[i];
+            _stamps[_next] = stamp;
+            _filled++;
+            status[i] = _drop_initial ? TSP_DROP : TSP_NULL;
+        }
+        else {
+            std::swap(pkts[i], _packets[_next]);
+            mdata[i].setInputTimeStamp(_stamps[_next]);
+            _stamps[_next] = stamp;
+            status[i] = TSP_OK;
+        }
+        if (++_next >= _size) {
+            _next = 0;
+        }
+    }
+    return count;
+}
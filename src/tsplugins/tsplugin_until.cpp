@@ -34,7 +34,7 @@
 
 #include "tsPlugin.h"
 #include "tsPluginRepository.h"
-#include "tsTime.h"
+#include "tsCoarseClock.h"
 TSDUCK_SOURCE;
 
 
@@ -60,7 +60,7 @@ namespace ts {
         PacketCounter  _null_seq_max;     // Stop at Nth sequence of null packets
         PacketCounter  _null_seq_cnt;     // Sequence of null packets counter
         MilliSecond    _msec_max;         // Stop after N milli-seconds
-        Time           _start_time;       // Time of first packet reception
+        NanoSecond     _start_time;       // Time of first packet reception (coarse clock)
         PID            _previous_pid;     // PID of previous packet
         bool           _started;          // First packet was received
         bool           _terminated;       // Final condition is met
@@ -91,7 +91,7 @@ ts::UntilPlugin::UntilPlugin (TSP* tsp_) :
     _null_seq_max(0),
     _null_seq_cnt(0),
     _msec_max(0),
-    _start_time(Time::Epoch),
+    _start_time(0),
     _previous_pid(PID_NULL),
     _started(false),
     _terminated(false),
@@ -204,7 +204,7 @@ ts::ProcessorPlugin::Status ts::UntilPlugin::processPacket (TSPacket& pkt, bool&
     // Record time of first packet
     if (!_started) {
         _started = true;
-        _start_time = Time::CurrentUTC();
+        _start_time = CoarseClock::CoarseNanoSeconds();
     }
 
     // Update context information
@@ -223,7 +223,7 @@ ts::ProcessorPlugin::Status ts::UntilPlugin::processPacket (TSPacket& pkt, bool&
         (_pack_max > 0 && _pack_cnt >= _pack_max) ||
         (_null_seq_max > 0 && _null_seq_cnt >= _null_seq_max) ||
         (_unit_start_max > 0 && _unit_start_cnt >= _unit_start_max) ||
-        (_msec_max && Time::CurrentUTC() - _start_time >= _msec_max);
+        (_msec_max && CoarseClock::CoarseNanoSeconds() - _start_time >= _msec_max * NanoSecPerMilliSec);
 
     // Update context information for next packet
     _previous_pid = pkt.getPID();
@@ -37,7 +37,9 @@
 #include "tsPluginRepository.h"
 #include "tsService.h"
 #include "tsSectionDemux.h"
-#include "tsCyclingPacketizer.h"
+#include "tsOneShotPacketizer.h"
+#include "tsTSFileOutput.h"
+#include "tsSysUtils.h"
 #include "tsPAT.h"
 #include "tsPMT.h"
 #include "tsCAT.h"
@@ -56,9 +58,13 @@ namespace ts {
         // Implementation of plugin API
         ZapPlugin(TSP*);
         virtual bool start() override;
+        virtual bool stop() override;
         virtual Status processPacket(TSPacket&, bool&, bool&) override;
 
     private:
+        // Number of extracted TS packets which are written at a time in an output file.
+        static const size_t WRITE_PACKETS = 512;
+
         // Each PID is described by one byte
         enum {
             TSPID_DROP,   // Remove all packets from this PID
@@ -71,9 +77,44 @@ namespace ts {
             TSPID_EMM,    // EMM's, unmodified
         };
 
+        // A modified table, packetized once and replayed cyclically in place of
+        // all packets of its PID. This is equivalent to a CyclingPacketizer with
+        // stuffing policy ALWAYS but no section is serialized on the packet path.
+        class PSICycle
+        {
+        public:
+            PSICycle();
+            void clear();
+            void setTable(const AbstractTable& table, PID pid);
+            void getNextPacket(TSPacket& pkt);
+        private:
+            TSPacketVector _packets;  // One cycle of packets.
+            TSPacketVector _pending;  // Next cycle, used at the end of the current section.
+            bool           _has_pending;
+            size_t         _next;     // Index of next packet in _packets.
+            uint8_t        _cc;       // Next continuity counter.
+        };
+
+        // Extraction context for one service.
+        struct ServiceContext
+        {
+            Service        service;            // Service name & id
+            UString        name;               // Service as specified on the command line
+            uint8_t        pid_state[PID_MAX]; // Status of each PID.
+            PSICycle       pat;                // Packets of modified PAT
+            PSICycle       pmt;                // Packets of modified PMT
+            PSICycle       sdt;                // Packets of modified SDT
+            TSFileOutput   outfile;            // Output file for extracted stream.
+            TSPacketVector buffer;             // Extracted packets, not yet written in outfile.
+
+            // Constructor.
+            ServiceContext(const UString& service_name);
+        };
+        typedef SafePtr<ServiceContext, NullMutex> ServiceContextPtr;
+        typedef std::vector<ServiceContextPtr> ServiceContextVector;
+
         // Private data
         bool              _abort;              // Error (service not found, etc)
-        Service           _service;            // Service name & id
         UString           _audio;              // Audio language code to keep
         UString           _subtitles;          // Subtitles language code to keep
         bool              _no_subtitles;       // Remove all subtitles
@@ -81,24 +122,31 @@ namespace ts {
         bool              _include_cas;        // Include CAS info (CAT & EMM)
         bool              _pes_only;           // Keep PES streams only
         Status            _drop_status;        // Status for dropped packets
-        uint8_t           _pid_state[PID_MAX]; // Status of each PID.
+        UString           _outfile_name;       // Output file name (empty: replace TS)
+        ServiceContextVector _services;        // Extraction contexts of all services.
         SectionDemux      _demux;              // Section demux
-        CyclingPacketizer _pzer_sdt;           // Packetizer for modified SDT
-        CyclingPacketizer _pzer_pat;           // Packetizer for modified PAT
-        CyclingPacketizer _pzer_pmt;           // Packetizer for modified PMT
 
         // Invoked by the demux when a complete table is available.
         virtual void handleTable(SectionDemux&, const BinaryTable&) override;
 
         // Process specific tables
-        void processPAT(PAT&);
-        void processCAT(CAT&);
-        void processPMT(PMT&);
-        void processSDT(SDT&);
+        void processPAT(ServiceContext&, PAT&);
+        void processCAT(ServiceContext&, CAT&);
+        void processPMT(ServiceContext&, PMT&);
+        void processSDT(ServiceContext&, SDT&);
+
+        // Forget all PID's of the service, when its service id or PMT PID has changed.
+        void resetServicePIDs(ServiceContext&);
+
+        // Process a packet for one service, same semantics as processPacket().
+        Status zapPacket(ServiceContext&, TSPacket&);
+
+        // Write the buffered packets of a service in its output file.
+        bool flushService(ServiceContext&);
 
         // Analyze a list of descriptors, looking for CA descriptors.
         // All PIDs which are referenced in CA descriptors are set with the specified state.
-        void analyzeCADescriptors(const DescriptorList& dlist, uint8_t pid_state);
+        void analyzeCADescriptors(ServiceContext&, const DescriptorList& dlist, uint8_t pid_state);
 
         // Inaccessible operations
         ZapPlugin() = delete;
@@ -116,9 +164,8 @@ TSPLUGIN_DECLARE_PROCESSOR(zap, ts::ZapPlugin)
 //----------------------------------------------------------------------------
 
 ts::ZapPlugin::ZapPlugin(TSP* tsp_) :
-    ProcessorPlugin(tsp_, u"Zap on one service: Produce an SPTS containing only the specified service.", u"[options] service"),
+    ProcessorPlugin(tsp_, u"Zap on one service: Produce an SPTS containing only the specified service.", u"[options] service ..."),
     _abort(false),
-    _service(),
     _audio(),
     _subtitles(),
     _no_subtitles(false),
@@ -126,16 +173,16 @@ ts::ZapPlugin::ZapPlugin(TSP* tsp_) :
     _include_cas (false),
     _pes_only(false),
     _drop_status(TSP_DROP),
-    _demux(this),
-    _pzer_sdt(PID_SDT, CyclingPacketizer::ALWAYS),
-    _pzer_pat(PID_PAT, CyclingPacketizer::ALWAYS),
-    _pzer_pmt(PID_NULL, CyclingPacketizer::ALWAYS)
+    _outfile_name(),
+    _services(),
+    _demux(this)
 {
-    option(u"",              0,  STRING, 1, 1);
+    option(u"",              0,  STRING, 1, UNLIMITED_COUNT);
     option(u"audio",        'a', STRING);
     option(u"cas",          'c');
     option(u"no-ecm",       'e');
     option(u"no-subtitles", 'n');
+    option(u"output-file",  'o', STRING);
     option(u"pes-only",     'p');
     option(u"stuffing",     's');
     option(u"subtitles",    't', STRING);
@@ -147,6 +194,9 @@ ts::ZapPlugin::ZapPlugin(TSP* tsp_) :
             u"  case sensitive and blanks are ignored. If the input TS does not contain an\n"
             u"  SDT, use a service id.\n"
             u"\n"
+            u"  Several services may be specified to extract them all in one pass. In that\n"
+            u"  case, --output-file is required and each service is saved in a separate file.\n"
+            u"\n"
             u"Options:\n"
             u"\n"
             u"  -a name\n"
@@ -171,6 +221,15 @@ ts::ZapPlugin::ZapPlugin(TSP* tsp_) :
             u"  --no-subtitles\n"
             u"      Remove all subtitles. By default, keep all subtitles.\n"
             u"\n"
+            u"  -o filename\n"
+            u"  --output-file filename\n"
+            u"      Specify that the extracted SPTS is saved in this file. In that case,\n"
+            u"      the main transport stream is passed unchanged to the next plugin.\n"
+            u"      When several services are extracted, each service is saved in a\n"
+            u"      separate file. The service, as specified on the command line, is\n"
+            u"      inserted before the file extension. Example: with --output-file out.ts,\n"
+            u"      service 0x0203 is saved in out-0x0203.ts.\n"
+            u"\n"
             u"  -p\n"
             u"  --pes-only\n"
             u"      Keep only the PES elementary streams (audio, video, subtitles).\n"
@@ -191,6 +250,87 @@ ts::ZapPlugin::ZapPlugin(TSP* tsp_) :
 }
 
 
+//----------------------------------------------------------------------------
+// Pre-packetized cycle of a modified table.
+//----------------------------------------------------------------------------
+
+ts::ZapPlugin::PSICycle::PSICycle() :
+    _packets(),
+    _pending(),
+    _has_pending(false),
+    _next(0),
+    _cc(0)
+{
+}
+
+void ts::ZapPlugin::PSICycle::clear()
+{
+    _packets.clear();
+    _pending.clear();
+    _has_pending = false;
+    _next = 0;
+}
+
+void ts::ZapPlugin::PSICycle::setTable(const AbstractTable& table, PID pid)
+{
+    // Packetize the complete table once.
+    OneShotPacketizer pzer(pid, true);
+    pzer.addTable(table);
+    pzer.getPackets(_pending);
+    _has_pending = true;
+
+    // If not in the middle of a section, switch to the new cycle immediately.
+    if (_next == 0 || _next >= _packets.size() || _packets[_next].getPUSI()) {
+        _packets.swap(_pending);
+        _has_pending = false;
+        _next = 0;
+    }
+}
+
+void ts::ZapPlugin::PSICycle::getNextPacket(TSPacket& pkt)
+{
+    // Loop at end of cycle. A new cycle starts at a section boundary.
+    if (_next >= _packets.size() || (_has_pending && _packets[_next].getPUSI())) {
+        if (_has_pending) {
+            _packets.swap(_pending);
+            _has_pending = false;
+        }
+        _next = 0;
+    }
+    if (_packets.empty()) {
+        pkt = NullPacket;
+    }
+    else {
+        pkt = _packets[_next++];
+        pkt.setCC(_cc);
+        _cc = (_cc + 1) & CC_MASK;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Service extraction context.
+//----------------------------------------------------------------------------
+
+ts::ZapPlugin::ServiceContext::ServiceContext(const UString& service_name) :
+    service(service_name),
+    name(service_name),
+    pat(),
+    pmt(),
+    sdt(),
+    outfile(),
+    buffer()
+{
+    // All PIDs are dropped by default.
+    // Selected PIDs will be added when discovered.
+    ::memset(pid_state, TSPID_DROP, sizeof(pid_state));
+
+    // The TOT and TDT are always passed.
+    assert(PID_TOT == PID_TDT);
+    pid_state[PID_TOT] = TSPID_PASS;
+}
+
+
 //----------------------------------------------------------------------------
 // Start method
 //----------------------------------------------------------------------------
@@ -198,7 +338,6 @@ ts::ZapPlugin::ZapPlugin(TSP* tsp_) :
 bool ts::ZapPlugin::start()
 {
     // Get option values
-    _service.set (value(u""));
     _audio = value(u"audio");
     _subtitles = value(u"subtitles");
     _no_subtitles = present(u"no-subtitles");
@@ -206,46 +345,91 @@ bool ts::ZapPlugin::start()
     _include_cas = present(u"cas");
     _pes_only = present(u"pes-only");
     _drop_status = present(u"stuffing") ? TSP_NULL : TSP_DROP;
+    getValue(_outfile_name, u"output-file");
 
-    // All PIDs are dropped by default.
-    // Selected PIDs will be added when discovered.
-    ::memset(_pid_state, TSPID_DROP, sizeof(_pid_state));
+    const size_t count = this->count(u"");
+    if (count > 1 && _outfile_name.empty()) {
+        tsp->error(u"--output-file is required to extract several services");
+        return false;
+    }
 
-    // The TOT and TDT are always passed.
-    assert(PID_TOT == PID_TDT);
-    _pid_state[PID_TOT] = TSPID_PASS;
+    // Reset other states
+    _abort = false;
+    _services.clear();
 
     // Initialize the demux
     _demux.reset();
     _demux.addPID(PID_SDT);
 
-    // When the service id is known, we wait for the PAT. If it is not yet
-    // known (only the service name is known), we do not know how to modify
-    // the PAT. We will wait for it after receiving the SDT.
-    // Packets from PAT PID are analyzed but not passed. When a complete
-    // PAT is read, a modified PAT will be transmitted.
-    if (_service.hasId()) {
-        _demux.addPID(PID_PAT);
+    for (size_t i = 0; i < count; ++i) {
+        ServiceContextPtr ctx(new ServiceContext(value(u"", u"", i)));
+        CheckNonNull(ctx.pointer());
+
+        // When the service id is known, we wait for the PAT. If it is not yet
+        // known (only the service name is known), we do not know how to modify
+        // the PAT. We will wait for it after receiving the SDT.
+        // Packets from PAT PID are analyzed but not passed. When a complete
+        // PAT is read, a modified PAT will be transmitted.
+        if (ctx->service.hasId()) {
+            _demux.addPID(PID_PAT);
+        }
+
+        // Include CAT and EMM if required
+        if (_include_cas) {
+            _demux.addPID(PID_CAT);
+            ctx->pid_state[PID_CAT] = TSPID_PASS;
+        }
+
+        // With several services, insert the service before the file extension.
+        if (!_outfile_name.empty()) {
+            const UString name(count > 1 ? PathPrefix(_outfile_name) + u"-" + ctx->name + PathSuffix(_outfile_name) : _outfile_name);
+            if (!ctx->outfile.open(name, false, false, *tsp)) {
+                _services.clear();
+                return false;
+            }
+            ctx->buffer.reserve(WRITE_PACKETS);
+        }
+
+        _services.push_back(ctx);
     }
 
-    // Include CAT and EMM if required
-    if (_include_cas) {
-        _demux.addPID(PID_CAT);
-        _pid_state[PID_CAT] = TSPID_PASS;
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Stop method
+//----------------------------------------------------------------------------
+
+bool ts::ZapPlugin::stop()
+{
+    bool ok = true;
+    if (!_outfile_name.empty()) {
+        for (ServiceContextVector::iterator it = _services.begin(); it != _services.end(); ++it) {
+            ok = flushService(**it) && ok;
+            ok = (*it)->outfile.close(*tsp) && ok;
+        }
     }
+    _services.clear();
+    return ok;
+}
 
-    // Reset other states
-    _abort = false;
-    _pzer_pat.reset();
-    _pzer_pmt.reset();
-    _pzer_sdt.reset();
 
-    return true;
+//----------------------------------------------------------------------------
+// Write the buffered packets of a service in its output file.
+//----------------------------------------------------------------------------
+
+bool ts::ZapPlugin::flushService(ServiceContext& ctx)
+{
+    const bool ok = ctx.buffer.empty() || ctx.outfile.write(&ctx.buffer[0], ctx.buffer.size(), *tsp);
+    ctx.buffer.clear();
+    return ok;
 }
 
 
 //----------------------------------------------------------------------------
 // Invoked by the demux when a complete table is available.
+// Each service gets its own copy of the table since it is modified.
 //----------------------------------------------------------------------------
 
 void ts::ZapPlugin::handleTable (SectionDemux& demux, const BinaryTable& table)
@@ -254,9 +438,11 @@ void ts::ZapPlugin::handleTable (SectionDemux& demux, const BinaryTable& table)
 
         case TID_PAT: {
             if (table.sourcePID() == PID_PAT) {
-                PAT pat(table);
-                if (pat.isValid()) {
-                    processPAT(pat);
+                for (size_t i = 0; !_abort && i < _services.size(); ++i) {
+                    PAT pat(table);
+                    if (pat.isValid() && _services[i]->service.hasId()) {
+                        processPAT(*_services[i], pat);
+                    }
                 }
             }
             break;
@@ -264,9 +450,11 @@ void ts::ZapPlugin::handleTable (SectionDemux& demux, const BinaryTable& table)
 
         case TID_CAT: {
             if (table.sourcePID() == PID_CAT) {
-                CAT cat(table);
-                if (cat.isValid()) {
-                    processCAT(cat);
+                for (size_t i = 0; i < _services.size(); ++i) {
+                    CAT cat(table);
+                    if (cat.isValid()) {
+                        processCAT(*_services[i], cat);
+                    }
                 }
             }
             break;
@@ -274,18 +462,25 @@ void ts::ZapPlugin::handleTable (SectionDemux& demux, const BinaryTable& table)
 
         case TID_SDT_ACT: {
             if (table.sourcePID() == PID_SDT) {
-                SDT sdt(table);
-                if (sdt.isValid()) {
-                    processSDT(sdt);
+                for (size_t i = 0; !_abort && i < _services.size(); ++i) {
+                    SDT sdt(table);
+                    if (sdt.isValid()) {
+                        processSDT(*_services[i], sdt);
+                    }
                 }
             }
             break;
         }
 
         case TID_PMT: {
-            PMT pmt(table);
-            if (pmt.isValid() && _service.hasId(pmt.service_id)) {
-                processPMT(pmt);
+            for (size_t i = 0; !_abort && i < _services.size(); ++i) {
+                ServiceContext& ctx(*_services[i]);
+                if (ctx.service.hasPMTPID(table.sourcePID())) {
+                    PMT pmt(table);
+                    if (pmt.isValid() && ctx.service.hasId(pmt.service_id)) {
+                        processPMT(ctx, pmt);
+                    }
+                }
             }
             break;
         }
@@ -297,6 +492,33 @@ void ts::ZapPlugin::handleTable (SectionDemux& demux, const BinaryTable& table)
 }
 
 
+//----------------------------------------------------------------------------
+// Forget all PID's of the service, when its service id or PMT PID has changed.
+//----------------------------------------------------------------------------
+
+void ts::ZapPlugin::resetServicePIDs(ServiceContext& ctx)
+{
+    for (PID pid = 0; pid < PID_MAX; pid++) {
+        uint8_t pstate = ctx.pid_state[pid];
+        if (pstate == TSPID_PMT) {
+            // Stop demuxing this PMT PID, unless another service uses it.
+            bool used = false;
+            for (size_t i = 0; !used && i < _services.size(); ++i) {
+                used = _services[i].pointer() != &ctx && _services[i]->service.hasPMTPID(pid);
+            }
+            if (!used) {
+                _demux.removePID(pid);
+            }
+            ctx.pmt.clear();
+            ctx.pid_state[pid] = TSPID_DROP;
+        }
+        else if (pstate == TSPID_PES || pstate == TSPID_DATA) {
+            ctx.pid_state[pid] = TSPID_DROP;
+        }
+    }
+}
+
+
 //----------------------------------------------------------------------------
 //  This method processes a Service Description Table (SDT).
 //  We search the service in the SDT. Once we get the service, we rebuild a
@@ -304,25 +526,25 @@ void ts::ZapPlugin::handleTable (SectionDemux& demux, const BinaryTable& table)
 //  all descriptors for the service).
 //----------------------------------------------------------------------------
 
-void ts::ZapPlugin::processSDT (SDT& sdt)
+void ts::ZapPlugin::processSDT (ServiceContext& ctx, SDT& sdt)
 {
     // Look for the service by name or by service
 
     bool found;
     uint16_t service_id;
 
-    if (_service.hasName()) {
-        found = sdt.findService(_service.getName(), service_id);
+    if (ctx.service.hasName()) {
+        found = sdt.findService(ctx.service.getName(), service_id);
     }
     else {
-        service_id = _service.getId();
+        service_id = ctx.service.getId();
         found = sdt.services.find(service_id) != sdt.services.end();
     }
 
     // If service not found in SDT and not already found in PAT, error
 
-    if (!found && !_service.hasId (service_id)) {
-        tsp->error(u"service \"%s\" not found in SDT", {_service.getName()});
+    if (!found && !ctx.service.hasId (service_id)) {
+        tsp->error(u"service \"%s\" not found in SDT", {ctx.service.getName()});
         _abort = true;
         return;
     }
@@ -330,40 +552,30 @@ void ts::ZapPlugin::processSDT (SDT& sdt)
     // If the service id was previously unknown wait for the PAT.
     // If a service id was known but was different, we need to rescan the PAT.
 
-    if (!_service.hasId (service_id)) {
+    if (!ctx.service.hasId (service_id)) {
 
-        if (_service.hasId()) {
+        if (ctx.service.hasId()) {
             // The service was previously known but has changed its service id.
             // We need to rescan the service map. The PMT is reset.
             // All PIDs related to the service are erased.
-            for (PID pid = 0; pid < PID_MAX; pid++) {
-                uint8_t pstate = _pid_state[pid];
-                if (pstate == TSPID_PMT) {
-                    _demux.removePID (pid);
-                    _pzer_pmt.reset();
-                    _pid_state[pid] = TSPID_DROP;
-                }
-                else if (pstate == TSPID_PES || pstate == TSPID_DATA) {
-                    _pid_state[pid] = TSPID_DROP;
-                }
-            }
+            resetServicePIDs(ctx);
         }
 
-        _service.setId (service_id);
-        _service.clearPMTPID();
+        ctx.service.setId (service_id);
+        ctx.service.clearPMTPID();
 
         // Packets from PAT PID are analyzed but not passed. When a complete
         // PAT is read, a modified PAT will be transmitted.
 
         _demux.addPID (PID_PAT);
-        _pid_state[PID_PAT] = TSPID_DROP;
+        ctx.pid_state[PID_PAT] = TSPID_DROP;
 
-        tsp->verbose(u"found service \"%s\", service id is 0x%X", {_service.getName(), _service.getId()});
+        tsp->verbose(u"found service \"%s\", service id is 0x%X", {ctx.service.getName(), ctx.service.getId()});
     }
 
     // Remove all other services from the SDT
 
-    SDT::ServiceMap::iterator it(sdt.services.find(_service.getId()));
+    SDT::ServiceMap::iterator it(sdt.services.find(ctx.service.getId()));
     if (it == sdt.services.end()) {
         // Service not present in SDT
         sdt.services.clear();
@@ -374,7 +586,7 @@ void ts::ZapPlugin::processSDT (SDT& sdt)
         // Remove other services after zap service
         it = sdt.services.begin();
         assert(it != sdt.services.end());
-        assert(it->first == _service.getId());
+        assert(it->first == ctx.service.getId());
         sdt.services.erase(++it, sdt.services.end());
         assert (sdt.services.size() == 1);
     }
@@ -382,12 +594,11 @@ void ts::ZapPlugin::processSDT (SDT& sdt)
     // Build the list of TS packets containing the new SDT.
     // These packets will replace everything on the SDT/BAT PID.
 
-    _pzer_sdt.removeAll();
-    _pzer_sdt.addTable(sdt);
+    ctx.sdt.setTable(sdt, PID_SDT);
 
     // Now allow transmission of (modified) packets from SDT PID
 
-    _pid_state[PID_SDT] = TSPID_SDT;
+    ctx.pid_state[PID_SDT] = TSPID_SDT;
 }
 
 
@@ -395,17 +606,17 @@ void ts::ZapPlugin::processSDT (SDT& sdt)
 //  This method processes a Program Association Table (PAT).
 //----------------------------------------------------------------------------
 
-void ts::ZapPlugin::processPAT (PAT& pat)
+void ts::ZapPlugin::processPAT (ServiceContext& ctx, PAT& pat)
 {
     // Locate the service in the PAT
 
-    assert (_service.hasId());
-    PAT::ServiceMap::iterator it = pat.pmts.find (_service.getId());
+    assert (ctx.service.hasId());
+    PAT::ServiceMap::iterator it = pat.pmts.find (ctx.service.getId());
 
     // If service not found, error
 
     if (it == pat.pmts.end()) {
-        tsp->error(u"service id 0x%X not found in PAT", {_service.getId()});
+        tsp->error(u"service id 0x%X not found in PAT", {ctx.service.getId()});
         _abort = true;
         return;
     }
@@ -413,28 +624,18 @@ void ts::ZapPlugin::processPAT (PAT& pat)
     // If the PMT PID was previously unknown wait for the PMT.
     // If the PMT PID was known but was different, we need to rescan the PMT.
 
-    if (!_service.hasPMTPID (it->second)) {
+    if (!ctx.service.hasPMTPID (it->second)) {
 
-        if (_service.hasPMTPID()) {
+        if (ctx.service.hasPMTPID()) {
             // The PMT PID was previously known but has changed.
             // We need to rescan the PMT. All PIDs related to the service are erased.
-            for (PID pid = 0; pid < PID_MAX; pid++) {
-                uint8_t pstate = _pid_state[pid];
-                if (pstate == TSPID_PMT) {
-                    _demux.removePID (pid);
-                    _pzer_pmt.reset();
-                    _pid_state[pid] = TSPID_DROP;
-                }
-                else if (pstate == TSPID_PES || pstate == TSPID_DATA) {
-                    _pid_state[pid] = TSPID_DROP;
-                }
-            }
+            resetServicePIDs(ctx);
         }
 
-        _service.setPMTPID(it->second);
+        ctx.service.setPMTPID(it->second);
         _demux.addPID(it->second);
 
-        tsp->verbose(u"found service id 0x%X, PMT PID is 0x%X", {_service.getId(), _service.getPMTPID()});
+        tsp->verbose(u"found service id 0x%X, PMT PID is 0x%X", {ctx.service.getId(), ctx.service.getPMTPID()});
     }
 
     // Remove all other services from the PAT
@@ -442,7 +643,7 @@ void ts::ZapPlugin::processPAT (PAT& pat)
     pat.pmts.erase (pat.pmts.begin(), it);
     it = pat.pmts.begin();
     assert (it != pat.pmts.end());
-    assert (it->first == _service.getId());
+    assert (it->first == ctx.service.getId());
     pat.pmts.erase (++it, pat.pmts.end());
     assert (pat.pmts.size() == 1);
     pat.nit_pid = PID_NULL;
@@ -450,12 +651,11 @@ void ts::ZapPlugin::processPAT (PAT& pat)
     // Build the list of TS packets containing the new PAT.
     // These packets will replace everything on the PAT PID.
 
-    _pzer_pat.removeAll();
-    _pzer_pat.addTable (pat);
+    ctx.pat.setTable(pat, PID_PAT);
 
     // Now allow transmission of (modified) packets from PAT PID
 
-    _pid_state [PID_PAT] = TSPID_PAT;
+    ctx.pid_state [PID_PAT] = TSPID_PAT;
 }
 
 
@@ -463,12 +663,12 @@ void ts::ZapPlugin::processPAT (PAT& pat)
 //  This method processes a Program Map Table (PMT).
 //----------------------------------------------------------------------------
 
-void ts::ZapPlugin::processPMT (PMT& pmt)
+void ts::ZapPlugin::processPMT (ServiceContext& ctx, PMT& pmt)
 {
     // Record the PCR PID as a PES component of the service
 
     if (pmt.pcr_pid != PID_NULL) {
-        _pid_state[pmt.pcr_pid] = TSPID_PES;
+        ctx.pid_state[pmt.pcr_pid] = TSPID_PES;
     }
 
     // Record or remove ECMs PIDs from the descriptor loop
@@ -479,7 +679,7 @@ void ts::ZapPlugin::processPMT (PMT& pmt)
     }
     else {
         // Locate all ECM PID's and record them
-        analyzeCADescriptors (pmt.descs, TSPID_DATA);
+        analyzeCADescriptors (ctx, pmt.descs, TSPID_DATA);
     }
 
     // Loop on all elementary streams of the PMT and remove streams we do not
@@ -526,7 +726,7 @@ void ts::ZapPlugin::processPMT (PMT& pmt)
         }
 
         // We keep this component, record component PID
-        _pid_state[pid] = uint8_t(IsPES(stream.stream_type) ? TSPID_PES : TSPID_DATA);
+        ctx.pid_state[pid] = uint8_t(IsPES(stream.stream_type) ? TSPID_PES : TSPID_DATA);
 
         // Record or remove ECMs PIDs from the descriptor loop
         if (_no_ecm) {
@@ -535,7 +735,7 @@ void ts::ZapPlugin::processPMT (PMT& pmt)
         }
         else {
             // Locate all ECM PID's and record them
-            analyzeCADescriptors (stream.descs, TSPID_DATA);
+            analyzeCADescriptors (ctx, stream.descs, TSPID_DATA);
         }
     }
 
@@ -550,14 +750,12 @@ void ts::ZapPlugin::processPMT (PMT& pmt)
     // Build the list of TS packets containing the new PMT.
     // These packets will replace everything on the PMT PID.
 
-    assert (_service.hasPMTPID());
-    _pzer_pmt.removeAll();
-    _pzer_pmt.setPID (_service.getPMTPID());
-    _pzer_pmt.addTable (pmt);
+    assert (ctx.service.hasPMTPID());
+    ctx.pmt.setTable(pmt, ctx.service.getPMTPID());
 
     // Now allow transmission of (modified) packets from PMT PID
 
-    _pid_state [_service.getPMTPID()] = TSPID_PMT;
+    ctx.pid_state [ctx.service.getPMTPID()] = TSPID_PMT;
 }
 
 
@@ -565,17 +763,17 @@ void ts::ZapPlugin::processPMT (PMT& pmt)
 //  This method processes a Conditional Access Table (CAT).
 //----------------------------------------------------------------------------
 
-void ts::ZapPlugin::processCAT (CAT& cat)
+void ts::ZapPlugin::processCAT (ServiceContext& ctx, CAT& cat)
 {
     // Erase all previously known EMM PIDs
     for (size_t pid = 0; pid < PID_MAX; pid++) {
-        if (_pid_state[pid] == TSPID_EMM) {
-            _pid_state[pid] = TSPID_DROP;
+        if (ctx.pid_state[pid] == TSPID_EMM) {
+            ctx.pid_state[pid] = TSPID_DROP;
         }
     }
 
     // Register all new EMM PIDs
-    analyzeCADescriptors (cat.descs, TSPID_EMM);
+    analyzeCADescriptors (ctx, cat.descs, TSPID_EMM);
 }
 
 
@@ -584,7 +782,7 @@ void ts::ZapPlugin::processCAT (CAT& cat)
 // are referenced in CA descriptors are set with the specified state.
 //----------------------------------------------------------------------------
 
-void ts::ZapPlugin::analyzeCADescriptors (const DescriptorList& dlist, uint8_t pid_state)
+void ts::ZapPlugin::analyzeCADescriptors (ServiceContext& ctx, const DescriptorList& dlist, uint8_t pid_state)
 {
     // Loop on all CA descriptors
 
@@ -606,7 +804,7 @@ void ts::ZapPlugin::analyzeCADescriptors (const DescriptorList& dlist, uint8_t p
         CASFamily cas = CASFamilyOf (sysid);
 
         // Record state of main CA pid for this descriptor
-        _pid_state[pid] = pid_state;
+        ctx.pid_state[pid] = pid_state;
 
         // Normally, no PID should be referenced in the private part of
         // a CA descriptor. However, this rule is not followed by the
@@ -621,7 +819,7 @@ void ts::ZapPlugin::analyzeCADescriptors (const DescriptorList& dlist, uint8_t p
                 pid = GetUInt16 (desc) & 0x1FFF;
                 desc += 4; size -= 4; nb_opi--;
                 // Record state of secondary pid
-                _pid_state[pid] = pid_state;
+                ctx.pid_state[pid] = pid_state;
             }
         }
         else if (cas == CAS_MEDIAGUARD && pid_state == TSPID_DATA && size >= 13) {
@@ -631,7 +829,7 @@ void ts::ZapPlugin::analyzeCADescriptors (const DescriptorList& dlist, uint8_t p
                 pid = GetUInt16 (desc) & 0x1FFF;
                 desc += 15; size -= 15;
                 // Record state of secondary pid
-                _pid_state[pid] = pid_state;
+                ctx.pid_state[pid] = pid_state;
             }
         }
     }
@@ -644,8 +842,6 @@ void ts::ZapPlugin::analyzeCADescriptors (const DescriptorList& dlist, uint8_t p
 
 ts::ProcessorPlugin::Status ts::ZapPlugin::processPacket (TSPacket& pkt, bool& flush, bool& bitrate_changed)
 {
-    const PID pid = pkt.getPID();
-
     // Filter interesting sections
     _demux.feedPacket (pkt);
 
@@ -654,13 +850,49 @@ ts::ProcessorPlugin::Status ts::ZapPlugin::processPacket (TSPacket& pkt, bool& f
         return TSP_END;
     }
 
+    // Without output file, the transport stream is replaced by the only service.
+    if (_outfile_name.empty()) {
+        assert(_services.size() == 1);
+        return zapPacket(*_services[0], pkt);
+    }
+
+    // Extract all services in their output files, pass the TS unchanged.
+    for (ServiceContextVector::iterator it = _services.begin(); it != _services.end(); ++it) {
+        ServiceContext& ctx(**it);
+        ctx.buffer.push_back(pkt);
+        const Status status = zapPacket(ctx, ctx.buffer.back());
+        if (status == TSP_DROP) {
+            ctx.buffer.pop_back();
+        }
+        else if (status == TSP_NULL) {
+            ctx.buffer.back() = NullPacket;
+        }
+        else if (status != TSP_OK) {
+            return status;
+        }
+        if (ctx.buffer.size() >= WRITE_PACKETS && !flushService(ctx)) {
+            return TSP_END;
+        }
+    }
+    return TSP_OK;
+}
+
+
+//----------------------------------------------------------------------------
+// Process a packet for one service.
+//----------------------------------------------------------------------------
+
+ts::ProcessorPlugin::Status ts::ZapPlugin::zapPacket (ServiceContext& ctx, TSPacket& pkt)
+{
+    const uint8_t state = ctx.pid_state[pkt.getPID()];
+
     // Remove all non-PES packets if option --pes-only
-    if (_pes_only && _pid_state[pid] != TSPID_PES) {
+    if (_pes_only && state != TSPID_PES) {
         return _drop_status;
     }
 
     // Pass, modify or drop the packets
-    switch (_pid_state[pid]) {
+    switch (state) {
 
         case TSPID_DROP:
             // Packet must be dropped or replaced by a null packet
@@ -675,22 +907,22 @@ ts::ProcessorPlugin::Status ts::ZapPlugin::processPacket (TSPacket& pkt, bool& f
 
         case TSPID_PMT:
             // Replace all PMT packets with modified PMT
-            _pzer_pmt.getNextPacket (pkt);
+            ctx.pmt.getNextPacket (pkt);
             return TSP_OK;
 
         case TSPID_PAT:
             // Replace all PAT packets with modified PAT
-            _pzer_pat.getNextPacket (pkt);
+            ctx.pat.getNextPacket (pkt);
             return TSP_OK;
 
         case TSPID_SDT:
             // Replace all SDT/BAT packets with modified SDT
-            _pzer_sdt.getNextPacket (pkt);
+            ctx.sdt.getNextPacket (pkt);
             return TSP_OK;
 
         default:
             // Should never get there...
-            tsp->error(u"internal error, invalid PID state %d", {_pid_state[pid]});
+            tsp->error(u"internal error, invalid PID state %d", {state});
             return TSP_END;
     }
 }
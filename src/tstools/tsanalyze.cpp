@@ -34,9 +34,19 @@
 #include "tsTSAnalyzerReport.h"
 #include "tsTSAnalyzerOptions.h"
 #include "tsInputRedirector.h"
+#include "tsSysUtils.h"
+#include "tsThread.h"
+#include "tsSafePtr.h"
 #include "tsVersionInfo.h"
 TSDUCK_SOURCE;
 
+// Number of packets before each part of a file which are analyzed in parallel
+// and which are read to get the PSI/SI and sections overlapping the two parts.
+#define LEAD_IN_PACKETS 100000
+
+// Number of packets per read operation in parallel mode.
+#define READ_PACKETS 1024
+
 
 //----------------------------------------------------------------------------
 //  Command line options
@@ -48,15 +58,18 @@ struct Options: public ts::TSAnalyzerOptions
 
     ts::BitRate bitrate;  // Expected bitrate (188-byte packets)
     ts::UString infile;   // Input file name
+    size_t      threads;  // Number of analysis threads for a file
 };
 
 Options::Options(int argc, char *argv[]) :
     ts::TSAnalyzerOptions(u"MPEG Transport Stream Analysis Utility.", u"[options] [filename]"),
     bitrate(0),
-    infile()
+    infile(),
+    threads(0)
 {
     option(u"",         0,  Args::STRING, 0, 1);
     option(u"bitrate", 'b', Args::UNSIGNED);
+    option(u"threads",  0,  Args::POSITIVE);
 
     setHelp(u"Input file:\n"
             u"\n"
@@ -73,6 +86,12 @@ Options::Options(int argc, char *argv[]) :
             u"  --help\n"
             u"      Display this help text.\n"
             u"\n"
+            u"  --threads value\n"
+            u"      Analyze the input file using the specified number of threads. The\n"
+            u"      file is split into as many contiguous parts which are analyzed in\n"
+            u"      parallel and the analyses are merged. Ignored when the input is the\n"
+            u"      standard input. By default, the file is analyzed sequentially.\n"
+            u"\n"
             u"  -v\n"
             u"  --verbose\n"
             u"      Produce verbose output.\n"
@@ -84,11 +103,145 @@ Options::Options(int argc, char *argv[]) :
 
     infile = value(u"");
     bitrate = intValue<ts::BitRate>(u"bitrate");
+    threads = intValue<size_t>(u"threads", 1);
 
     exitOnError();
 }
 
 
+//----------------------------------------------------------------------------
+//  A thread which analyzes one part of the input file.
+//----------------------------------------------------------------------------
+
+class PartAnalyzer: public ts::Thread
+{
+public:
+    // Constructor.
+    PartAnalyzer(const Options& opt, ts::PacketCounter first, ts::PacketCounter count);
+
+    // Destructor.
+    virtual ~PartAnalyzer() override;
+
+    // Public fields, valid after termination of the thread.
+    ts::TSAnalyzerReport analyzer;  // Analysis of this part.
+    ts::UString          error;     // Error message, empty if the part was completely analyzed.
+
+private:
+    const Options&          _opt;
+    const ts::PacketCounter _first;
+    const ts::PacketCounter _count;
+
+    // Implementation of Thread.
+    virtual void main() override;
+
+    // Inaccessible operations.
+    PartAnalyzer() = delete;
+    PartAnalyzer(const PartAnalyzer&) = delete;
+    PartAnalyzer& operator=(const PartAnalyzer&) = delete;
+};
+
+typedef ts::SafePtr<PartAnalyzer> PartAnalyzerPtr;
+
+PartAnalyzer::PartAnalyzer(const Options& opt, ts::PacketCounter first, ts::PacketCounter count) :
+    Thread(),
+    analyzer(opt.bitrate),
+    error(),
+    _opt(opt),
+    _first(first),
+    _count(count)
+{
+    analyzer.setAnalysisOptions(opt);
+}
+
+PartAnalyzer::~PartAnalyzer()
+{
+    waitForTermination();
+}
+
+void PartAnalyzer::main()
+{
+    std::ifstream file(_opt.infile.toUTF8().c_str(), std::ios::binary);
+    if (!file) {
+        error = ts::UString::Format(u"cannot open file %s", {_opt.infile});
+        return;
+    }
+
+    // Start reading a few packets before the part, they belong to the previous part.
+    ts::PacketCounter index = _first - std::min<ts::PacketCounter>(_first, LEAD_IN_PACKETS);
+    const ts::PacketCounter end = _first + _count;
+    ts::TSPacketVector buffer(READ_PACKETS);
+    file.seekg(std::streamoff(index * ts::PKT_SIZE));
+
+    while (index < end) {
+        const size_t count = size_t(std::min<ts::PacketCounter>(READ_PACKETS, end - index));
+        file.read(reinterpret_cast<char*>(&buffer[0]), std::streamsize(count * ts::PKT_SIZE));
+        if (size_t(file.gcount()) != count * ts::PKT_SIZE) {
+            error = ts::UString::Format(u"I/O error while reading TS packet after %'d TS packets", {index});
+            return;
+        }
+        for (size_t i = 0; i < count; ++i, ++index) {
+            if (buffer[i].b[0] != ts::SYNC_BYTE) {
+                // Same error as in sequential analysis. In the lead-in, the error belongs to the previous part.
+                if (index >= _first) {
+                    error = ts::UString::Format(u"synchronization lost after %'d TS packets, got 0x%X instead of 0x%X at start of TS packet", {index, buffer[i].b[0], ts::SYNC_BYTE});
+                }
+                return;
+            }
+            if (index < _first) {
+                analyzer.feedPrecedingPacket(buffer[i]);
+            }
+            else {
+                analyzer.feedPacket(buffer[i]);
+            }
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+//  Analyze a file in parallel. Return false if the file cannot be used.
+//----------------------------------------------------------------------------
+
+bool ParallelAnalysis(Options& opt)
+{
+    const int64_t file_size = ts::GetFileSize(opt.infile);
+    if (file_size < 0) {
+        return false;
+    }
+
+    // Split the file in packet-aligned contiguous parts.
+    const ts::PacketCounter total = ts::PacketCounter(file_size) / ts::PKT_SIZE;
+    const size_t count = size_t(std::max<ts::PacketCounter>(1, std::min<ts::PacketCounter>(opt.threads, total)));
+    std::vector<PartAnalyzerPtr> parts;
+    parts.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        const ts::PacketCounter first = (total * i) / count;
+        const ts::PacketCounter next = (total * (i + 1)) / count;
+        parts.push_back(new PartAnalyzer(opt, first, next - first));
+        parts.back()->start();
+    }
+
+    // Merge all analyses in order. Stop at the first error, same as the sequential analysis.
+    bool success = true;
+    for (size_t i = 0; success && i < count; ++i) {
+        parts[i]->waitForTermination();
+        if (i > 0) {
+            parts[0]->analyzer.merge(parts[i]->analyzer);
+        }
+        if (!parts[i]->error.empty()) {
+            opt.error(parts[i]->error);
+            success = false;
+        }
+    }
+    if (success && file_size % ts::PKT_SIZE != 0) {
+        opt.error(u"truncated TS packet (%d bytes) after %'d TS packets", {file_size % ts::PKT_SIZE, total});
+    }
+
+    parts[0]->analyzer.report(std::cout, opt);
+    return true;
+}
+
+
 //----------------------------------------------------------------------------
 //  Program entry point
 //----------------------------------------------------------------------------
@@ -97,6 +250,12 @@ int main(int argc, char *argv[])
 {
     TSDuckLibCheckVersion();
     Options opt(argc, argv);
+
+    // Parallel analysis of a file, when requested.
+    if (opt.threads > 1 && !opt.infile.empty() && ParallelAnalysis(opt)) {
+        return EXIT_SUCCESS;
+    }
+
     ts::TSAnalyzerReport analyzer(opt.bitrate);
     ts::InputRedirector input(opt.infile, opt);
     ts::TSPacket pkt;
@@ -34,6 +34,7 @@
 #include "tsArgs.h"
 #include "tsInputRedirector.h"
 #include "tsPCRAnalyzer.h"
+#include "tsMemoryMappedFile.h"
 #include "tsVersionInfo.h"
 TSDUCK_SOURCE;
 
@@ -52,6 +53,8 @@ struct Options: public ts::Args
     bool        use_dts;     // Use DTS instead of PCR
     bool        all;         // All packets analysis
     bool        full;        // Full analysis
+    bool        fast;        // Analyze a memory-mapped file in place
+    size_t      regions;     // Number of sampled regions in the file
     bool        value_only;  // Output value only
     ts::UString infile;      // Input file name
 };
@@ -64,15 +67,19 @@ Options::Options(int argc, char *argv[]) :
     use_dts(false),
     all(false),
     full(false),
+    fast(false),
+    regions(0),
     value_only(false),
     infile()
 {
     option(u"",            0, Args::STRING, 0, 1);
     option(u"all",        'a');
     option(u"dts",        'd');
+    option(u"fast",        0);
     option(u"full",       'f');
     option(u"min-pcr",     0, Args::POSITIVE);
     option(u"min-pid",     0, Args::INTEGER, 0, 1, 1, ts::PID_MAX);
+    option(u"regions",     0, Args::POSITIVE);
     option(u"value-only", 'v');
 
     setHelp(u"Input file:\n"
@@ -91,6 +98,11 @@ Options::Options(int argc, char *argv[]) :
             u"      Use DTS (Decoding Time Stamps) from video PID's instead of PCR\n"
             u"      (Program Clock Reference) from the transport layer.\n"
             u"\n"
+            u"  --fast\n"
+            u"      Map the input file in memory and analyze the packets in place. Only the\n"
+            u"      packet headers are accessed. Much faster on large files. The input file\n"
+            u"      must be a regular file, not the standard input.\n"
+            u"\n"
             u"  -f\n"
             u"  --full\n"
             u"      Full analysis. The file is entirely analyzed (as with --all) and the\n"
@@ -106,6 +118,11 @@ Options::Options(int argc, char *argv[]) :
             u"  --min-pid value\n"
             u"      Minimum number of PID to get PCR from (default: 1).\n"
             u"\n"
+            u"  --regions value\n"
+            u"      Evaluate the bitrate by sampling the specified number of evenly spaced\n"
+            u"      regions in the file, in almost constant time whatever the file size.\n"
+            u"      Implies --fast. Incompatible with --all and --full.\n"
+            u"\n"
             u"  -v\n"
             u"  --value-only\n"
             u"      Display only the bitrate value, in bits/seconds, based on\n"
@@ -126,8 +143,17 @@ Options::Options(int argc, char *argv[]) :
     min_pcr = intValue<uint32_t>(u"min-pcr", 64);
     min_pid = intValue<uint16_t>(u"min-pid", 1);
     use_dts = present(u"dts");
+    regions = intValue<size_t>(u"regions", 0);
+    fast = regions > 0 || present(u"fast");
     pcr_name = use_dts ? u"DTS" : u"PCR";
 
+    if (fast && infile.empty()) {
+        error(u"an input file name is required with --fast and --regions");
+    }
+    if (regions > 0 && all) {
+        error(u"--regions is incompatible with --all and --full");
+    }
+
     exitOnError();
 }
 
@@ -141,16 +167,33 @@ int main(int argc, char *argv[])
     TSDuckLibCheckVersion();
     Options opt(argc, argv);
     ts::PCRAnalyzer zer(opt.min_pid, opt.min_pcr);
-    ts::InputRedirector input(opt.infile, opt);
-    ts::TSPacket pkt;
 
     // Reset analyzer for DTS with --dts
     if (opt.use_dts) {
         zer.resetAndUseDTS (opt.min_pid, opt.min_pcr);
     }
 
-    // Read all packets in the file and pass them to the PCR analyzer.
-    while (pkt.read(std::cin, true, opt) && (!zer.feedPacket(pkt) || opt.all)) {}
+    if (opt.fast) {
+        // Analyze the packets in place in the memory-mapped file.
+        ts::MemoryMappedFile file;
+        if (!file.open(opt.infile, opt)) {
+            return EXIT_FAILURE;
+        }
+        const ts::TSPacket* const pkt = reinterpret_cast<const ts::TSPacket*>(file.data());
+        const size_t count = file.size() / ts::PKT_SIZE;
+        if (opt.regions > 0) {
+            zer.feedRegions(pkt, count, opt.regions);
+        }
+        else {
+            zer.feedPackets(pkt, count, !opt.all);
+        }
+    }
+    else {
+        // Read all packets in the file and pass them to the PCR analyzer.
+        ts::InputRedirector input(opt.infile, opt);
+        ts::TSPacket pkt;
+        while (pkt.read(std::cin, true, opt) && (!zer.feedPacket(pkt) || opt.all)) {}
+    }
 
     // Display results.
     ts::PCRAnalyzer::Status status;
@@ -0,0 +1,936 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  DVB SimulCrypt head-end load generator.
+//  Acts as an SCS towards ECMG's or as an EMMG/PDG towards a MUX.
+//
+//----------------------------------------------------------------------------
+
+#include "tsArgs.h"
+#include "tsECMGClient.h"
+#include "tsEMMGMUX.h"
+#include "tstlvConnection.h"
+#include "tsMessageQueue.h"
+#include "tsMonotonic.h"
+#include "tsThread.h"
+#include "tsMutex.h"
+#include "tsGuard.h"
+#include "tsSafePtr.h"
+#include "tsUserInterrupt.h"
+#include "tsInterruptHandler.h"
+#include "tsMPEG.h"
+#include "tsSysUtils.h"
+#include "tsVersionInfo.h"
+TSDUCK_SOURCE;
+
+namespace {
+    // Default duration of the test in seconds.
+    const ts::Second DEFAULT_DURATION = 10;
+    // Default crypto-period in seconds.
+    const ts::Second DEFAULT_CP_DURATION = 10;
+    // Default EMM bitrate per stream in bits/second.
+    const ts::BitRate DEFAULT_EMM_BITRATE = 100000;
+    // Default maximum number of ECM requests in flight per ECMG channel.
+    const size_t DEFAULT_MAX_PENDING = 256;
+    // Default timeout for the last responses at end of test.
+    const ts::MilliSecond DEFAULT_TIMEOUT = 5000;
+    // Timeout for responses from the MUX during setup.
+    const ts::MilliSecond EMMG_RESPONSE_TIMEOUT = 5000;
+}
+
+
+//----------------------------------------------------------------------------
+//  Command line options
+//----------------------------------------------------------------------------
+
+struct Options: public ts::Args
+{
+    Options(int argc, char *argv[]);
+
+    bool              emmg;           // EMMG/PDG mode instead of SCS mode
+    ts::SocketAddress server;         // ECMG or MUX address
+    size_t            channels;       // number of channels
+    size_t            streams;        // number of streams per channel
+    uint16_t          channel_id;     // first channel id
+    uint16_t          stream_id;      // first stream id in each channel
+    uint32_t          super_cas_id;   // Super_CAS_id (ECMG) or client_id (EMMG)
+    uint16_t          first_id;       // first ECM_id (ECMG) or data_id (EMMG)
+    ts::Second        cp_duration;    // nominal crypto-period
+    ts::BitRate       emm_bitrate;    // EMM bitrate per stream
+    size_t            emm_packets;    // TS packets per data_provision
+    ts::NanoSecond    step;           // interval between two requests, all streams
+    ts::Second        duration;       // test duration
+    size_t            max_pending;    // max ECM requests in flight per channel
+    ts::MilliSecond   timeout;        // final response timeout
+};
+
+Options::Options(int argc, char *argv[]) :
+    Args(u"DVB SimulCrypt ECMG or EMMG/PDG load generator.", u"[options]"),
+    emmg(false),
+    server(),
+    channels(0),
+    streams(0),
+    channel_id(0),
+    stream_id(0),
+    super_cas_id(0),
+    first_id(0),
+    cp_duration(0),
+    emm_bitrate(0),
+    emm_packets(0),
+    step(0),
+    duration(0),
+    max_pending(0),
+    timeout(0)
+{
+    option(u"bitrate",          'b', POSITIVE);
+    option(u"channels",         'c', POSITIVE);
+    option(u"channel-id",        0,  UINT16);
+    option(u"client-id",         0,  UINT32);
+    option(u"cp-duration",      'p', POSITIVE);
+    option(u"data-id",           0,  UINT16);
+    option(u"duration",         'd', POSITIVE);
+    option(u"ecm-id",            0,  UINT16);
+    option(u"ecmg",             'e', STRING);
+    option(u"ecmg-scs-version",  0,  INTEGER, 0, 1, 2, 3);
+    option(u"emmg-mux-version",  0,  INTEGER, 0, 1, 1, 5);
+    option(u"max-pending",       0,  POSITIVE);
+    option(u"mux",              'm', STRING);
+    option(u"packets",           0,  POSITIVE);
+    option(u"rate",             'r', POSITIVE);
+    option(u"streams",          's', POSITIVE);
+    option(u"stream-id",         0,  UINT16);
+    option(u"super-cas-id",      0,  UINT32);
+    option(u"timeout",          't', POSITIVE);
+
+    setHelp(u"Either --ecmg or --mux must be specified. With --ecmg, the application acts\n"
+            u"as an SCS and requests ECM's from an ECMG on several channels and streams.\n"
+            u"With --mux, the application acts as an EMMG/PDG and sends data_provision\n"
+            u"messages to a MUX on several channels and streams. At the end of the test,\n"
+            u"the throughput and the distribution of the latency are reported. With an\n"
+            u"ECMG, the latency is the delay between a CW_provision and the corresponding\n"
+            u"ECM_response. With a MUX, which does not acknowledge data_provision messages,\n"
+            u"the latency is the time to send a data_provision, reflecting the TCP flow\n"
+            u"control from the MUX.\n"
+            u"\n"
+            u"Options:\n"
+            u"\n"
+            u"  -b value\n"
+            u"  --bitrate value\n"
+            u"      With --mux, specifies the EMM bitrate of each stream in bits/second.\n"
+            u"      The bandwidth is requested to the MUX using a stream_BW_request.\n"
+            u"      The default is " + ts::UString::Decimal(DEFAULT_EMM_BITRATE) + u" b/s.\n"
+            u"\n"
+            u"  -c value\n"
+            u"  --channels value\n"
+            u"      Number of channels to open with the ECMG or MUX. Each channel uses its\n"
+            u"      own TCP connection. The default is 1.\n"
+            u"\n"
+            u"  --channel-id value\n"
+            u"      First channel id. The channels use consecutive ids. The default is 1.\n"
+            u"\n"
+            u"  --client-id value\n"
+            u"      With --mux, specifies the client_id. This option is required with --mux.\n"
+            u"\n"
+            u"  -p seconds\n"
+            u"  --cp-duration seconds\n"
+            u"      With --ecmg, specifies the crypto-period duration in seconds. Unless\n"
+            u"      --rate is specified, one CW_provision is sent per crypto-period on\n"
+            u"      each stream. The default is " + ts::UString::Decimal(DEFAULT_CP_DURATION) + u" seconds.\n"
+            u"\n"
+            u"  --data-id value\n"
+            u"      With --mux, first data_id. All streams use consecutive ids.\n"
+            u"      The default is 1.\n"
+            u"\n"
+            u"  -d seconds\n"
+            u"  --duration seconds\n"
+            u"      Duration of the test in seconds. The default is " + ts::UString::Decimal(DEFAULT_DURATION) + u" seconds.\n"
+            u"\n"
+            u"  --ecm-id value\n"
+            u"      With --ecmg, first ECM_id. All streams use consecutive ids.\n"
+            u"      The default is 1.\n"
+            u"\n"
+            u"  -e host:port\n"
+            u"  --ecmg host:port\n"
+            u"      Specify the ECM Generator to load.\n"
+            u"\n"
+            u"  --ecmg-scs-version value\n"
+            u"      Specifies the version of the ECMG <=> SCS DVB SimulCrypt protocol.\n"
+            u"      Valid values are 2 and 3. The default is 2.\n"
+            u"\n"
+            u"  --emmg-mux-version value\n"
+            u"      Specifies the version of the EMMG/PDG <=> MUX DVB SimulCrypt protocol.\n"
+            u"      Valid values are 1 to 5. The default is 2.\n"
+            u"\n"
+            u"  --help\n"
+            u"      Display this help text.\n"
+            u"\n"
+            u"  --max-pending value\n"
+            u"      With --ecmg, maximum number of CW_provision without response on each\n"
+            u"      channel. When the ECMG cannot sustain the load, the requests above\n"
+            u"      this limit are skipped and counted. The default is " + ts::UString::Decimal(DEFAULT_MAX_PENDING) + u".\n"
+            u"\n"
+            u"  -m host:port\n"
+            u"  --mux host:port\n"
+            u"      Specify the MUX to load, acting as an EMMG/PDG.\n"
+            u"\n"
+            u"  --packets value\n"
+            u"      With --mux, number of TS packets in each data_provision.\n"
+            u"      The default is 1.\n"
+            u"\n"
+            u"  -r value\n"
+            u"  --rate value\n"
+            u"      Total number of requests per second, CW_provision or data_provision,\n"
+            u"      over all channels and streams. The requests are evenly distributed over\n"
+            u"      time and streams. By default, the rate is computed from --cp-duration\n"
+            u"      with --ecmg and from --bitrate and --packets with --mux.\n"
+            u"\n"
+            u"  -s value\n"
+            u"  --streams value\n"
+            u"      Number of streams to open in each channel. The default is 1.\n"
+            u"\n"
+            u"  --stream-id value\n"
+            u"      First stream id in each channel. The streams of a channel use\n"
+            u"      consecutive ids. The default is 1.\n"
+            u"\n"
+            u"  --super-cas-id value\n"
+            u"      With --ecmg, specifies the DVB SimulCrypt Super_CAS_Id. This option is\n"
+            u"      required with --ecmg.\n"
+            u"\n"
+            u"  -t milliseconds\n"
+            u"  --timeout milliseconds\n"
+            u"      With --ecmg, maximum time to wait for the last responses at the end of\n"
+            u"      the test. The default is " + ts::UString::Decimal(DEFAULT_TIMEOUT) + u" ms.\n"
+            u"\n"
+            u"  -v\n"
+            u"  --verbose\n"
+            u"      Produce verbose messages.\n"
+            u"\n"
+            u"  --version\n"
+            u"      Display the version number.\n");
+
+    analyze(argc, argv);
+
+    emmg = present(u"mux");
+    channels = intValue<size_t>(u"channels", 1);
+    streams = intValue<size_t>(u"streams", 1);
+    channel_id = intValue<uint16_t>(u"channel-id", 1);
+    stream_id = intValue<uint16_t>(u"stream-id", 1);
+    cp_duration = intValue<ts::Second>(u"cp-duration", DEFAULT_CP_DURATION);
+    emm_bitrate = intValue<ts::BitRate>(u"bitrate", DEFAULT_EMM_BITRATE);
+    emm_packets = intValue<size_t>(u"packets", 1);
+    duration = intValue<ts::Second>(u"duration", DEFAULT_DURATION);
+    max_pending = intValue<size_t>(u"max-pending", DEFAULT_MAX_PENDING);
+    timeout = intValue<ts::MilliSecond>(u"timeout", DEFAULT_TIMEOUT);
+
+    const size_t total = channels * streams;
+
+    if (present(u"ecmg") == emmg) {
+        error(u"specify exactly one of --ecmg and --mux");
+    }
+    else if (emmg) {
+        if (!present(u"client-id")) {
+            error(u"--client-id is required with --mux");
+        }
+        super_cas_id = intValue<uint32_t>(u"client-id");
+        first_id = intValue<uint16_t>(u"data-id", 1);
+        server.resolve(value(u"mux"), *this);
+        ts::emmgmux::Protocol::Instance()->setVersion(intValue<ts::tlv::VERSION>(u"emmg-mux-version", 2));
+        // Default: each stream sends its data_provision at its bitrate.
+        step = ts::NanoSecond(emm_packets * ts::PKT_SIZE * 8) * ts::NanoSecPerSec / ts::NanoSecond(emm_bitrate) / ts::NanoSecond(total);
+    }
+    else {
+        if (!present(u"super-cas-id")) {
+            error(u"--super-cas-id is required with --ecmg");
+        }
+        super_cas_id = intValue<uint32_t>(u"super-cas-id");
+        first_id = intValue<uint16_t>(u"ecm-id", 1);
+        server.resolve(value(u"ecmg"), *this);
+        ts::ecmgscs::Protocol::Instance()->setVersion(intValue<ts::tlv::VERSION>(u"ecmg-scs-version", 2));
+        // Default: each stream sends one CW_provision per crypto-period.
+        step = cp_duration * ts::NanoSecPerSec / ts::NanoSecond(total);
+        if (cp_duration * 10 > 0xFFFF) {
+            error(u"crypto-period too long");
+        }
+    }
+    if (present(u"rate")) {
+        step = ts::NanoSecPerSec / intValue<ts::NanoSecond>(u"rate");
+    }
+    if (channel_id + channels - 1 > 0xFFFF || stream_id + streams - 1 > 0xFFFF || first_id + total - 1 > 0xFFFF) {
+        error(u"too many channels or streams for the specified ids");
+    }
+    if (valid() && step <= 0) {
+        error(u"request rate too high");
+    }
+
+    exitOnError();
+}
+
+
+//----------------------------------------------------------------------------
+//  Load statistics, shared by all channels.
+//----------------------------------------------------------------------------
+
+class LoadStatistics
+{
+public:
+    LoadStatistics();
+
+    // Count events. Thread-safe.
+    void addRequest();
+    void addSkipped();
+    void addError();
+    void addResponse(ts::NanoSecond latency, size_t bytes);
+
+    // Display the final report.
+    void display(std::ostream& strm, ts::NanoSecond elapsed) const;
+
+private:
+    mutable ts::Mutex           _mutex;
+    uint64_t                    _requests;
+    uint64_t                    _skipped;
+    uint64_t                    _errors;
+    uint64_t                    _responses;
+    uint64_t                    _bytes;
+    std::vector<ts::NanoSecond> _latencies;
+
+    // Format a duration in milliseconds with microsecond precision.
+    static ts::UString Milli(ts::NanoSecond ns);
+
+    // Nearest-rank percentile (in 1/1000) of a sorted non-empty vector.
+    static ts::NanoSecond Percentile(const std::vector<ts::NanoSecond>& sorted, size_t permille);
+};
+
+LoadStatistics::LoadStatistics() :
+    _mutex(),
+    _requests(0),
+    _skipped(0),
+    _errors(0),
+    _responses(0),
+    _bytes(0),
+    _latencies()
+{
+}
+
+void LoadStatistics::addRequest()
+{
+    ts::Guard lock(_mutex);
+    _requests++;
+}
+
+void LoadStatistics::addSkipped()
+{
+    ts::Guard lock(_mutex);
+    _skipped++;
+}
+
+void LoadStatistics::addError()
+{
+    ts::Guard lock(_mutex);
+    _errors++;
+}
+
+void LoadStatistics::addResponse(ts::NanoSecond latency, size_t bytes)
+{
+    ts::Guard lock(_mutex);
+    _responses++;
+    _bytes += bytes;
+    _latencies.push_back(latency);
+}
+
+ts::UString LoadStatistics::Milli(ts::NanoSecond ns)
+{
+    const ts::NanoSecond us = ns / ts::NanoSecPerMicroSec;
+    return ts::UString::Format(u"%'d.%03d ms", {us / 1000, us % 1000});
+}
+
+ts::NanoSecond LoadStatistics::Percentile(const std::vector<ts::NanoSecond>& sorted, size_t permille)
+{
+    const size_t rank = (sorted.size() * permille + 999) / 1000;
+    return sorted[rank == 0 ? 0 : std::min(rank, sorted.size()) - 1];
+}
+
+void LoadStatistics::display(std::ostream& strm, ts::NanoSecond elapsed) const
+{
+    ts::Guard lock(_mutex);
+
+    // Sort a copy of the latencies to get the percentiles.
+    std::vector<ts::NanoSecond> lat(_latencies);
+    std::sort(lat.begin(), lat.end());
+
+    const ts::MilliSecond ms = std::max<ts::MilliSecond>(1, elapsed / ts::NanoSecPerMilliSec);
+    strm << ts::UString::Format(u"Elapsed: %'d ms", {ms}) << std::endl
+         << ts::UString::Format(u"Requests: %'d, skipped: %'d, completed: %'d, errors: %'d, lost: %'d",
+                                {_requests, _skipped, _responses, _errors, _requests - std::min(_requests, _responses + _errors)}) << std::endl
+         << ts::UString::Format(u"Throughput: %'d requests/s, %'d completed/s, %'d bytes/s",
+                                {(_requests * 1000) / ms, (_responses * 1000) / ms, (_bytes * 1000) / ms}) << std::endl;
+
+    if (!lat.empty()) {
+        ts::NanoSecond sum = 0;
+        for (size_t i = 0; i < lat.size(); ++i) {
+            sum += lat[i];
+        }
+        strm << "Latency: min " << Milli(lat.front())
+             << ", avg " << Milli(sum / ts::NanoSecond(lat.size()))
+             << ", max " << Milli(lat.back()) << std::endl
+             << "Percentiles: 50% " << Milli(Percentile(lat, 500))
+             << ", 90% " << Milli(Percentile(lat, 900))
+             << ", 99% " << Milli(Percentile(lat, 990))
+             << ", 99.9% " << Milli(Percentile(lat, 999)) << std::endl;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+//  Abstract interface of one loaded channel.
+//----------------------------------------------------------------------------
+
+class LoadChannel
+{
+public:
+    // Open the channel and all its streams. Index of the channel, from 0.
+    virtual bool open(size_t index) = 0;
+
+    // Check if the channel is still connected.
+    virtual bool isConnected() const = 0;
+
+    // Send one request on a stream, index of the stream in the channel, from 0.
+    virtual void request(size_t stream) = 0;
+
+    // Number of requests in flight.
+    virtual size_t pending() const = 0;
+
+    // Close all streams and the channel.
+    virtual void close() = 0;
+
+    // Virtual destructor.
+    virtual ~LoadChannel() {}
+};
+
+typedef ts::SafePtr<LoadChannel> LoadChannelPtr;
+
+
+//----------------------------------------------------------------------------
+//  ECMG channel: the asynchronous requests are pipelined by ECMGClient.
+//----------------------------------------------------------------------------
+
+class ECMGLoadChannel: public LoadChannel, private ts::ECMGClientHandlerInterface
+{
+public:
+    ECMGLoadChannel(Options& opt, LoadStatistics& stats);
+
+    // Implementation of LoadChannel.
+    virtual bool open(size_t index) override;
+    virtual bool isConnected() const override;
+    virtual void request(size_t stream) override;
+    virtual size_t pending() const override;
+    virtual void close() override;
+
+private:
+    // Submission time of requests in flight, key: stream_id << 16 | CP_number.
+    typedef std::map<uint32_t, ts::Monotonic> SubmitMap;
+
+    Options&              _opt;
+    LoadStatistics&       _stats;
+    ts::ECMGClient        _client;
+    std::vector<uint16_t> _cp_numbers;  // next CP_number, per stream
+    ts::Mutex             _mutex;       // protect _submitted
+    SubmitMap             _submitted;
+
+    // Invoked in the receiver thread of the ECMGClient.
+    virtual void handleECM(const ts::ecmgscs::ECMResponse& response) override;
+
+    // Inaccessible operations.
+    ECMGLoadChannel(const ECMGLoadChannel&) = delete;
+    ECMGLoadChannel& operator=(const ECMGLoadChannel&) = delete;
+};
+
+ECMGLoadChannel::ECMGLoadChannel(Options& opt, LoadStatistics& stats) :
+    _opt(opt),
+    _stats(stats),
+    _client(),
+    _cp_numbers(),
+    _mutex(),
+    _submitted()
+{
+}
+
+bool ECMGLoadChannel::open(size_t index)
+{
+    const uint16_t channel_id = uint16_t(_opt.channel_id + index);
+    const uint16_t ecm_id = uint16_t(_opt.first_id + index * _opt.streams);
+    const uint16_t nominal_cp = uint16_t(_opt.cp_duration * 10);
+    ts::ecmgscs::ChannelStatus channel_status;
+    ts::ecmgscs::StreamStatus stream_status;
+
+    if (!_client.connect(_opt.server, _opt.super_cas_id, channel_id, _opt.stream_id, ecm_id, nominal_cp, channel_status, stream_status, 0, &_opt)) {
+        return false;
+    }
+    for (size_t i = 1; i < _opt.streams; ++i) {
+        if (!_client.addStream(uint16_t(_opt.stream_id + i), uint16_t(ecm_id + i), nominal_cp, stream_status)) {
+            _client.disconnect();
+            return false;
+        }
+    }
+    _cp_numbers.assign(_opt.streams, 0);
+    return true;
+}
+
+bool ECMGLoadChannel::isConnected() const
+{
+    return _client.isConnected();
+}
+
+size_t ECMGLoadChannel::pending() const
+{
+    return _client.pendingECMCount();
+}
+
+void ECMGLoadChannel::request(size_t stream)
+{
+    // Do not overload the ECMG beyond the pipeline limit.
+    if (_client.pendingECMCount() >= _opt.max_pending) {
+        _stats.addSkipped();
+        return;
+    }
+
+    const uint16_t stream_id = uint16_t(_opt.stream_id + stream);
+    const uint16_t cp_number = _cp_numbers[stream]++;
+    const uint32_t key = (uint32_t(stream_id) << 16) | cp_number;
+
+    // Dummy control words, the ECMG does not care.
+    uint8_t cw[2 * ts::CW_BYTES];
+    for (size_t i = 0; i < sizeof(cw); ++i) {
+        cw[i] = uint8_t(cp_number + i);
+    }
+
+    // Register the submission time before the response can arrive.
+    ts::Monotonic now;
+    now.getSystemTime();
+    {
+        ts::Guard lock(_mutex);
+        _submitted[key] = now;
+    }
+
+    _stats.addRequest();
+    if (!_client.submitECM(stream_id, cp_number, cw, cw + ts::CW_BYTES, 0, 0, 0, this)) {
+        ts::Guard lock(_mutex);
+        _submitted.erase(key);
+        _stats.addError();
+    }
+}
+
+void ECMGLoadChannel::handleECM(const ts::ecmgscs::ECMResponse& response)
+{
+    ts::Monotonic now;
+    now.getSystemTime();
+
+    ts::Guard lock(_mutex);
+    SubmitMap::iterator it = _submitted.find((uint32_t(response.stream_id) << 16) | response.CP_number);
+    if (it != _submitted.end()) {
+        _stats.addResponse(now - it->second, response.ECM_datagram.size());
+        _submitted.erase(it);
+    }
+}
+
+void ECMGLoadChannel::close()
+{
+    if (_client.isConnected()) {
+        _client.disconnect();
+    }
+}
+
+
+//----------------------------------------------------------------------------
+//  EMMG channel: data_provision messages are sent on a TCP connection.
+//  A receiver thread answers the channel_test and stream_test from the MUX.
+//----------------------------------------------------------------------------
+
+class EMMGLoadChannel: public LoadChannel, private ts::Thread
+{
+public:
+    EMMGLoadChannel(Options& opt, LoadStatistics& stats);
+    virtual ~EMMGLoadChannel() override;
+
+    // Implementation of LoadChannel.
+    virtual bool open(size_t index) override;
+    virtual bool isConnected() const override;
+    virtual void request(size_t stream) override;
+    virtual size_t pending() const override;
+    virtual void close() override;
+
+private:
+    typedef std::vector<ts::emmgmux::StreamStatus> StreamStatusVector;
+
+    Options&                         _opt;
+    LoadStatistics&                  _stats;
+    ts::tlv::Connection<ts::Mutex>   _connection;
+    volatile bool                    _started;    // receiver thread started
+    volatile bool                    _connected;  // TCP connection is up
+    volatile bool                    _closing;    // disconnection in progress
+    mutable ts::Mutex                _mutex;      // protect status for the receiver thread
+    ts::emmgmux::ChannelStatus       _channel_status;
+    StreamStatusVector               _stream_status;
+    ts::ByteBlockPtr                 _datagram;   // same EMM packets in all data_provision
+    ts::MessageQueue<ts::tlv::Message, ts::NullMutex> _responses;
+
+    // Receiver thread main code.
+    virtual void main() override;
+
+    // Wait for a response from the MUX.
+    bool waitResponse(ts::tlv::TAG tag, ts::tlv::MessagePtr& msg);
+
+    // Break the TCP connection and wait for the receiver thread.
+    bool abortConnection();
+
+    // Inaccessible operations.
+    EMMGLoadChannel(const EMMGLoadChannel&) = delete;
+    EMMGLoadChannel& operator=(const EMMGLoadChannel&) = delete;
+};
+
+EMMGLoadChannel::EMMGLoadChannel(Options& opt, LoadStatistics& stats) :
+    Thread(),
+    _opt(opt),
+    _stats(stats),
+    _connection(ts::emmgmux::Protocol::Instance(), true, 3),
+    _started(false),
+    _connected(false),
+    _closing(false),
+    _mutex(),
+    _channel_status(),
+    _stream_status(),
+    _datagram(),
+    _responses(16)
+{
+}
+
+EMMGLoadChannel::~EMMGLoadChannel()
+{
+    abortConnection();
+}
+
+bool EMMGLoadChannel::isConnected() const
+{
+    return _connected;
+}
+
+size_t EMMGLoadChannel::pending() const
+{
+    // The MUX does not acknowledge data_provision messages.
+    return 0;
+}
+
+bool EMMGLoadChannel::abortConnection()
+{
+    _closing = true;
+    _connected = false;
+    _connection.disconnect(NULLREP);
+    _connection.close(NULLREP);
+    if (_started) {
+        waitForTermination();
+        _started = false;
+    }
+    return false;
+}
+
+bool EMMGLoadChannel::waitResponse(ts::tlv::TAG tag, ts::tlv::MessagePtr& msg)
+{
+    for (;;) {
+        if (!_responses.dequeue(msg, EMMG_RESPONSE_TIMEOUT)) {
+            _opt.error(u"MUX response timeout (expected tag 0x%X)", {tag});
+            return false;
+        }
+        if (msg->tag() == tag) {
+            return true;
+        }
+        if (msg->tag() == ts::emmgmux::Tags::channel_error || msg->tag() == ts::emmgmux::Tags::stream_error) {
+            // Already reported by the receiver thread.
+            return false;
+        }
+        _opt.verbose(u"ignored unexpected response from MUX:\n%s", {msg->dump(4)});
+    }
+}
+
+bool EMMGLoadChannel::open(size_t index)
+{
+    const uint16_t channel_id = uint16_t(_opt.channel_id + index);
+    const uint16_t data_id = uint16_t(_opt.first_id + index * _opt.streams);
+    const uint16_t bandwidth = uint16_t(std::min<ts::BitRate>(0xFFFF, (_opt.emm_bitrate + 999) / 1000));
+    ts::tlv::MessagePtr msg;
+
+    // Perform TCP connection to the MUX and start the receiver thread.
+    // Flawfinder: ignore: this is our open(), not ::open().
+    if (!_connection.open(_opt)) {
+        return false;
+    }
+    if (!_connection.connect(_opt.server, _opt)) {
+        _connection.close(_opt);
+        return false;
+    }
+    _connected = true;
+    _started = Thread::start();
+
+    // Channel setup, sending TS packets.
+    ts::emmgmux::ChannelSetup channel_setup;
+    channel_setup.channel_id = channel_id;
+    channel_setup.client_id = _opt.super_cas_id;
+    channel_setup.section_TSpkt_flag = true;
+    if (!_connection.send(channel_setup, _opt) || !waitResponse(ts::emmgmux::Tags::channel_status, msg)) {
+        return abortConnection();
+    }
+    {
+        ts::Guard lock(_mutex);
+        _channel_status = *dynamic_cast<ts::emmgmux::ChannelStatus*>(msg.pointer());
+    }
+
+    // Stream setup and bandwidth request for each stream.
+    for (size_t i = 0; i < _opt.streams; ++i) {
+        ts::emmgmux::StreamSetup stream_setup;
+        stream_setup.channel_id = channel_id;
+        stream_setup.stream_id = uint16_t(_opt.stream_id + i);
+        stream_setup.client_id = _opt.super_cas_id;
+        stream_setup.data_id = uint16_t(data_id + i);
+        stream_setup.data_type = ts::emmgmux::DataTypes::EMM;
+        if (!_connection.send(stream_setup, _opt) || !waitResponse(ts::emmgmux::Tags::stream_status, msg)) {
+            return abortConnection();
+        }
+        {
+            ts::Guard lock(_mutex);
+            _stream_status.push_back(*dynamic_cast<ts::emmgmux::StreamStatus*>(msg.pointer()));
+        }
+
+        ts::emmgmux::StreamBWRequest bw_request;
+        bw_request.channel_id = channel_id;
+        bw_request.stream_id = stream_setup.stream_id;
+        bw_request.client_id = _opt.super_cas_id;
+        bw_request.has_bandwidth = true;
+        bw_request.bandwidth = bandwidth;
+        if (!_connection.send(bw_request, _opt) || !waitResponse(ts::emmgmux::Tags::stream_BW_allocation, msg)) {
+            return abortConnection();
+        }
+        const ts::emmgmux::StreamBWAllocation* const alloc = dynamic_cast<ts::emmgmux::StreamBWAllocation*>(msg.pointer());
+        if (alloc != 0 && alloc->has_bandwidth && alloc->bandwidth < bandwidth) {
+            _opt.warning(u"channel %d, stream %d: %d kb/s allocated, %d kb/s requested", {channel_id, bw_request.stream_id, alloc->bandwidth, bandwidth});
+        }
+    }
+
+    // Build the EMM packets: one short private section per packet, zero payload.
+    _datagram = new ts::ByteBlock(_opt.emm_packets * ts::PKT_SIZE, 0);
+    for (size_t i = 0; i < _opt.emm_packets; ++i) {
+        uint8_t* const pkt = _datagram->data() + i * ts::PKT_SIZE;
+        const size_t section_length = ts::PKT_SIZE - 8;
+        pkt[0] = ts::SYNC_BYTE;
+        pkt[1] = 0x40 | uint8_t(ts::PID_NULL >> 8);   // PUSI, PID is set by the MUX
+        pkt[2] = uint8_t(ts::PID_NULL & 0xFF);
+        pkt[3] = 0x10 | uint8_t(i & 0x0F);             // payload only
+        pkt[4] = 0x00;                                  // pointer field
+        pkt[5] = 0x82;                                  // EMM table id
+        pkt[6] = 0x70 | uint8_t(section_length >> 8);
+        pkt[7] = uint8_t(section_length & 0xFF);
+    }
+    return true;
+}
+
+void EMMGLoadChannel::request(size_t stream)
+{
+    ts::emmgmux::DataProvision data;
+    data.channel_id = _channel_status.channel_id;
+    data.stream_id = uint16_t(_opt.stream_id + stream);
+    data.client_id = _opt.super_cas_id;
+    data.data_id = uint16_t(_opt.first_id + (_channel_status.channel_id - _opt.channel_id) * _opt.streams + stream);
+    data.datagram.push_back(_datagram);
+
+    // The latency is the time to send the message, including the TCP flow control.
+    ts::Monotonic start;
+    start.getSystemTime();
+    _stats.addRequest();
+    if (_connection.send(data, _opt)) {
+        ts::Monotonic now;
+        now.getSystemTime();
+        _stats.addResponse(now - start, _datagram->size());
+    }
+    else {
+        _stats.addError();
+    }
+}
+
+void EMMGLoadChannel::close()
+{
+    if (_connected) {
+        // Politely close all streams and the channel.
+        bool ok = true;
+        for (StreamStatusVector::const_iterator it = _stream_status.begin(); ok && it != _stream_status.end(); ++it) {
+            ts::emmgmux::StreamCloseRequest req;
+            ts::tlv::MessagePtr resp;
+            req.channel_id = it->channel_id;
+            req.stream_id = it->stream_id;
+            req.client_id = _opt.super_cas_id;
+            ok = _connection.send(req, _opt) && waitResponse(ts::emmgmux::Tags::stream_close_response, resp);
+        }
+        if (ok) {
+            ts::emmgmux::ChannelClose cc;
+            cc.channel_id = _channel_status.channel_id;
+            cc.client_id = _opt.super_cas_id;
+            _connection.send(cc, _opt);
+        }
+    }
+    abortConnection();
+}
+
+void EMMGLoadChannel::main()
+{
+    ts::tlv::MessagePtr msg;
+    while (_connection.receive(msg, 0, NULLREP)) {
+        switch (msg->tag()) {
+            case ts::emmgmux::Tags::channel_test: {
+                // Automatic reply to channel_test.
+                ts::emmgmux::ChannelStatus status;
+                {
+                    ts::Guard lock(_mutex);
+                    status = _channel_status;
+                }
+                _connection.send(status, NULLREP);
+                break;
+            }
+            case ts::emmgmux::Tags::stream_test: {
+                // Automatic reply to stream_test, using the status of the tested stream.
+                const ts::tlv::StreamMessage* const test = dynamic_cast<const ts::tlv::StreamMessage*>(msg.pointer());
+                ts::Guard lock(_mutex);
+                for (StreamStatusVector::const_iterator it = _stream_status.begin(); test != 0 && it != _stream_status.end(); ++it) {
+                    if (it->stream_id == test->stream_id) {
+                        _connection.send(*it, NULLREP);
+                        break;
+                    }
+                }
+                break;
+            }
+            case ts::emmgmux::Tags::channel_error:
+            case ts::emmgmux::Tags::stream_error: {
+                _opt.error(u"error from MUX:\n%s", {msg->dump(4)});
+                _stats.addError();
+                _responses.enqueue(msg, 0);
+                break;
+            }
+            default: {
+                // Response to a command from the application thread, drop it if nobody waits.
+                _responses.enqueue(msg, 0);
+                break;
+            }
+        }
+    }
+    if (!_closing) {
+        _opt.error(u"connection lost with MUX on channel %d", {_channel_status.channel_id});
+    }
+    _connected = false;
+}
+
+
+//----------------------------------------------------------------------------
+//  Interrupt handler: stop the test on Ctrl+C.
+//----------------------------------------------------------------------------
+
+class LoadInterruptHandler: public ts::InterruptHandler
+{
+public:
+    LoadInterruptHandler() : interrupted(false) {}
+    volatile bool interrupted;
+    virtual void handleInterrupt() override {interrupted = true;}
+};
+
+
+//----------------------------------------------------------------------------
+//  Program entry point
+//----------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+    TSDuckLibCheckVersion();
+    Options opt(argc, argv);
+    LoadInterruptHandler interrupt_handler;
+    ts::UserInterrupt interrupt_manager(&interrupt_handler, true, true);
+    LoadStatistics stats;
+    std::vector<LoadChannelPtr> channels;
+    bool ok = true;
+
+    // Open all channels and streams.
+    for (size_t i = 0; ok && i < opt.channels; ++i) {
+        channels.push_back(LoadChannelPtr(opt.emmg ? static_cast<LoadChannel*>(new EMMGLoadChannel(opt, stats)) : new ECMGLoadChannel(opt, stats)));
+        ok = channels.back()->open(i);
+    }
+
+    if (ok) {
+        const size_t total = opt.channels * opt.streams;
+        opt.verbose(u"%d channels, %d streams open, one request every %'d ns", {opt.channels, total, opt.step});
+
+        // Send the requests in round robin over all channels and streams.
+        ts::Monotonic::SetPrecision(ts::NanoSecPerMilliSec);
+        ts::Monotonic start;
+        start.getSystemTime();
+        ts::Monotonic end(start);
+        end += opt.duration * ts::NanoSecPerSec;
+        ts::Monotonic deadline(start);
+        for (size_t index = 0; ok && !interrupt_handler.interrupted && deadline < end; index = (index + 1) % total) {
+            deadline.wait();
+            const LoadChannelPtr& chan(channels[index % opt.channels]);
+            if (!chan->isConnected()) {
+                opt.error(u"channel %d disconnected, test aborted", {opt.channel_id + index % opt.channels});
+                ok = false;
+            }
+            else {
+                chan->request(index / opt.channels);
+                deadline += opt.step;
+            }
+        }
+        if (ok && !interrupt_handler.interrupted) {
+            end.wait();
+        }
+        ts::Monotonic stop;
+        stop.getSystemTime();
+
+        // Wait for the last responses.
+        ts::Monotonic now(stop);
+        ts::Monotonic limit(stop);
+        limit += opt.timeout * ts::NanoSecPerMilliSec;
+        for (size_t i = 0; i < channels.size() && now < limit; now.getSystemTime()) {
+            if (channels[i]->pending() == 0 || !channels[i]->isConnected()) {
+                ++i;
+            }
+            else {
+                ts::SleepThread(10);
+            }
+        }
+
+        stats.display(std::cout, stop - start);
+    }
+
+    // Close all channels.
+    for (size_t i = 0; i < channels.size(); ++i) {
+        channels[i]->close();
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -33,16 +33,24 @@
 
 #include "tsArgs.h"
 #include "tsMemoryUtils.h"
-#include "tsTSFileInputBuffered.h"
+#include "tsTSFileBlockReader.h"
+#include "tsSysUtils.h"
+#include "tsThread.h"
+#include "tsSafePtr.h"
+#include "tsNullReport.h"
 #include "tsBinaryTable.h"
 #include "tsSection.h"
 #include "tsPMT.h"
 #include "tsStreamIdentifierDescriptor.h"
 #include "tsVersionInfo.h"
+#include <atomic>
 TSDUCK_SOURCE;
 
 #define DEFAULT_BUFFERED_PACKETS 10000
 
+// Number of packets which are compared at a time in fast comparison.
+#define CHUNK_PACKETS 8192
+
 
 //----------------------------------------------------------------------------
 //  Command line options
@@ -67,6 +75,7 @@ struct Options: public ts::Args
     bool        pid_ignore;
     bool        cc_ignore;
     bool        continue_all;
+    size_t      threads;
 };
 
 Options::Options(int argc, char *argv[]) :
@@ -85,7 +94,8 @@ Options::Options(int argc, char *argv[]) :
     pcr_ignore(false),
     pid_ignore(false),
     cc_ignore(false),
-    continue_all(false)
+    continue_all(false),
+    threads(0)
 {
     option(u"",                 0,  Args::STRING, 2, 2);
     option(u"buffered-packets", 0,  UNSIGNED);
@@ -99,6 +109,7 @@ Options::Options(int argc, char *argv[]) :
     option(u"pcr-ignore",       0);
     option(u"pid-ignore",       0);
     option(u"subset",          's');
+    option(u"threads",          0,  POSITIVE);
     option(u"threshold-diff",  't', INTEGER, 0, 1, 0, ts::PKT_SIZE);
     option(u"quiet",           'q');
 
@@ -165,6 +176,11 @@ Options::Options(int argc, char *argv[]) :
             u"      file is read ahead until a matching packet is found.\n"
             u"      See also --threshold-diff.\n"
             u"\n"
+            u"  --threads value\n"
+            u"      Compare the files using the specified number of threads. The files are\n"
+            u"      split in contiguous parts which are compared in parallel. The default is\n"
+            u"      one thread. Ignored with --subset or when the files are not regular files.\n"
+            u"\n"
             u"  -t value\n"
             u"  --threshold-diff value\n"
             u"      When used with --subset, this value specifies the maximum number of\n"
@@ -194,6 +210,7 @@ Options::Options(int argc, char *argv[]) :
     pid_ignore = present(u"pid-ignore");
     cc_ignore = present(u"cc-ignore");
     continue_all = present(u"continue");
+    threads = intValue<size_t>(u"threads", 1);
     quiet = present(u"quiet");
     normalized = !quiet && present(u"normalized");
     dump = !quiet && present(u"dump");
@@ -327,96 +344,218 @@ bool Comparator::compare(const ts::TSPacket& pkt1, const ts::TSPacket& pkt2, Opt
 
 
 //----------------------------------------------------------------------------
-//  Program entry point
+//  Comparison context: results and reporting.
 //----------------------------------------------------------------------------
 
-int main (int argc, char *argv[])
+class Comparison
 {
-    TSDuckLibCheckVersion();
-    Options opt (argc, argv);
-    ts::TSFileInputBuffered file1(opt.buffered_packets);
-    ts::TSFileInputBuffered file2(opt.buffered_packets);
+public:
+    // Constructor.
+    Comparison(Options& opt);
 
-    // Open files
-    file1.open(opt.filename1, 1, opt.byte_offset, opt);
-    file2.open(opt.filename2, 1, opt.byte_offset, opt);
-    opt.exitOnError();
+    // Public fields.
+    ts::PacketCounter count1[ts::PID_MAX];    // Count packets in PIDs in file 1
+    ts::PacketCounter count2[ts::PID_MAX];    // Count packets in PIDs in file 2
+    ts::PacketCounter packets;                // Number of read packets in file 1
+    ts::PacketCounter diff_count;             // Number of differences in file
+    ts::PacketCounter total_subset_skipped;   // Skipped packets in file1 when --subset
+    ts::PacketCounter subset_skipped_chunks;  // Number of holes when --subset
 
-    // Display headers
-    if (opt.normalized) {
-        std::cout << "file:file=1:filename=" << file1.getFileName() << ":" << std::endl
-                  << "file:file=2:filename=" << file2.getFileName() << ":" << std::endl;
+    // Compare two packets and report a difference.
+    // Return false if the comparison must stop.
+    bool comparePackets(const ts::TSPacket& pkt1, const ts::TSPacket& pkt2, ts::PacketCounter index);
+
+    // Report a difference between two packets.
+    void reportDifference(const Comparator& comp, const ts::TSPacket& pkt1, const ts::TSPacket& pkt2, ts::PacketCounter index);
+
+    // Report a truncated file (file_number is 1 or 2).
+    void reportTruncated(int file_number, ts::PacketCounter packet);
+
+    // Final report.
+    void reportTotal();
+
+private:
+    Options& _opt;
+
+    // Inaccessible operations.
+    Comparison() = delete;
+    Comparison(const Comparison&) = delete;
+    Comparison& operator=(const Comparison&) = delete;
+};
+
+Comparison::Comparison(Options& opt) :
+    packets(0),
+    diff_count(0),
+    total_subset_skipped(0),
+    subset_skipped_chunks(0),
+    _opt(opt)
+{
+    TS_ZERO(count1);
+    TS_ZERO(count2);
+}
+
+bool Comparison::comparePackets(const ts::TSPacket& pkt1, const ts::TSPacket& pkt2, ts::PacketCounter index)
+{
+    count1[pkt1.getPID()]++;
+    count2[pkt2.getPID()]++;
 
+    const Comparator comp(pkt1, pkt2, _opt);
+    if (comp.equal) {
+        return true;
     }
-    else if (opt.verbose()) {
-        std::cout << "* Comparing " << file1.getFileName() << " and " << file2.getFileName() << std::endl;
+    else {
+        diff_count++;
+        reportDifference(comp, pkt1, pkt2, index);
+        return !_opt.quiet && _opt.continue_all;
     }
+}
 
-    // Count packets in PIDs in each file
-    ts::PacketCounter count1[ts::PID_MAX];
-    ts::PacketCounter count2[ts::PID_MAX];
-    TS_ZERO(count1);
-    TS_ZERO (count2);
+void Comparison::reportDifference(const Comparator& comp, const ts::TSPacket& pkt1, const ts::TSPacket& pkt2, ts::PacketCounter index)
+{
+    const ts::PID pid1 = pkt1.getPID();
+    const ts::PID pid2 = pkt2.getPID();
+
+    if (_opt.normalized) {
+        std::cout << "diff:packet=" << index
+                  << (_opt.payload_only ? ":payload" : "")
+                  << ":offset=" << comp.first_diff
+                  << ":endoffset=" << comp.end_diff
+                  << ":diffbytes= " << comp.diff_count
+                  << ":compsize=" << comp.compared_size
+                  << ":pid1=" << pid1
+                  << ":pid2=" << pid2
+                  << (pid1 == pid2 ? ":samepid" : "")
+                  << ":pid1index=" << (count1[pid1] - 1)
+                  << ":pid2index=" << (count2[pid2] - 1)
+                  << (count2[pid2] == count1[pid1] ? ":sameindex" : "")
+                  << ":" << std::endl;
+    }
+    else if (!_opt.quiet) {
+        std::cout << "* Packet " << ts::UString::Decimal(index) << " differ at offset " << comp.first_diff;
+        if (_opt.payload_only) {
+            std::cout << " in payload";
+        }
+        std::cout << ", " << comp.diff_count;
+        if (comp.diff_count != comp.end_diff - comp.first_diff) {
+            std::cout << "/" << (comp.end_diff - comp.first_diff);
+        }
+        std::cout << " bytes differ, PID " << pid1;
+        if (pid2 != pid1) {
+            std::cout << "/" << pid2;
+        }
+        std::cout << ", packet " << ts::UString::Decimal(count1[pid1] - 1);
+        if (pid2 != pid1 || count2[pid2] != count1[pid1]) {
+            std::cout << "/" << ts::UString::Decimal(count2[pid2] - 1);
+        }
+        std::cout << " in PID" << std::endl;
+        if (_opt.dump) {
+            std::cout << "  Packet from " << _opt.filename1 << ":" << std::endl;
+            pkt1.display (std::cout, _opt.dump_flags, 6);
+            std::cout << "  Packet from " << _opt.filename2 << ":" << std::endl;
+            pkt2.display (std::cout, _opt.dump_flags, 6);
+            std::cout << "  Differing area from " << _opt.filename1 << ":" << std::endl
+                      << ts::UString::Dump(pkt1.b + (_opt.payload_only ? pkt1.getHeaderSize() : 0) + comp.first_diff,
+                                           comp.end_diff - comp.first_diff, _opt.dump_flags, 6)
+                      << "  Differing area from " << _opt.filename2 << ":" << std::endl
+                      << ts::UString::Dump(pkt2.b + (_opt.payload_only ? pkt2.getHeaderSize() : 0) + comp.first_diff,
+                                           comp.end_diff - comp.first_diff, _opt.dump_flags, 6);
+        }
+    }
+}
+
+void Comparison::reportTruncated(int file_number, ts::PacketCounter packet)
+{
+    const ts::UString& filename(file_number == 1 ? _opt.filename1 : _opt.filename2);
+    if (_opt.normalized) {
+        std::cout << "truncated:file=" << file_number << ":packet=" << packet
+                  << ":filename=" << filename << ":" << std::endl;
+    }
+    else if (!_opt.quiet) {
+        std::cout << "* Packet " << ts::UString::Decimal(packet)
+                  << ": file " << filename << " is truncated" << std::endl;
+    }
+}
+
+void Comparison::reportTotal()
+{
+    if (_opt.normalized) {
+        std::cout << "total:packets=" << packets
+                  << ":diff=" << diff_count
+                  << ":missing=" << total_subset_skipped
+                  << ":holes=" << subset_skipped_chunks
+                  << ":" << std::endl;
+    }
+    else if (_opt.verbose()) {
+        std::cout << "* Read " << ts::UString::Decimal(packets)
+                  << " packets, found " << ts::UString::Decimal(diff_count) << " differences";
+        if (subset_skipped_chunks > 0) {
+            std::cout << ", missing " << ts::UString::Decimal(total_subset_skipped)
+                      << " packets in " << ts::UString::Decimal(subset_skipped_chunks) << " holes";
+        }
+        std::cout << std::endl;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+//  Packet by packet comparison of the two files, with --subset or
+//  when the files are not regular files.
+//----------------------------------------------------------------------------
+
+void SequentialCompare(Options& opt, Comparison& cmp)
+{
+    ts::TSFileInput file1;
+    ts::TSFileInput file2;
+    ts::TSFileBlockReader reader1(file1, opt.buffered_packets);
+    ts::TSFileBlockReader reader2(file2, opt.buffered_packets);
+
+    // Open files
+    file1.open(opt.filename1, 1, opt.byte_offset, opt);
+    file2.open(opt.filename2, 1, opt.byte_offset, opt);
+    opt.exitOnError();
 
     // Currently skipped packets in file1 when --subset
     ts::PacketCounter subset_skipped = 0;
-    ts::PacketCounter total_subset_skipped = 0;
-    ts::PacketCounter subset_skipped_chunks = 0;
-
-    // Number of differences in file
-    ts::PacketCounter diff_count = 0;
 
     // Read and compare all packets in the files
-    ts::TSPacket pkt1, pkt2;
-    size_t read2 = 0;
-    ts::PID pid2 = ts::PID_NULL;
+    // The packets are directly accessed in the read buffers.
+    const ts::TSPacket* pkt1 = 0;
+    const ts::TSPacket* pkt2 = 0;
 
     for (;;) {
 
         // Read one packet in file1
-        size_t read1 = file1.read (&pkt1, 1, opt);
-        ts::PID pid1 = pkt1.getPID();
-        count1[pid1]++;
+        pkt1 = reader1.next(opt);
+        if (pkt1 != 0) {
+            cmp.count1[pkt1->getPID()]++;
+        }
 
         // If currently not skipping packets, read one packet in file2
         if (subset_skipped == 0) {
-            read2 = file2.read (&pkt2, 1, opt);
-            pid2 = pkt2.getPID();
-            count2[pid2]++;
+            pkt2 = reader2.next(opt);
+            if (pkt2 != 0) {
+                cmp.count2[pkt2->getPID()]++;
+            }
         }
 
         // Exit if at least one file is terminated
-        if (read1 == 0 || read2 == 0) {
-            if (read1 != 0 || read2 != 0) {
-                diff_count++;
+        if (pkt1 == 0 || pkt2 == 0) {
+            if (pkt1 != 0 || pkt2 != 0) {
+                cmp.diff_count++;
             }
-            if (read1 != 0) {
+            if (pkt1 != 0) {
                 // File 2 is truncated
-                if (opt.normalized) {
-                    std::cout << "truncated:file=2:packet=" << file2.getPacketCount()
-                              << ":filename=" << file2.getFileName() << ":" << std::endl;
-                }
-                else if (!opt.quiet) {
-                    std::cout << "* Packet " << ts::UString::Decimal(file2.getPacketCount())
-                              << ": file " << file2.getFileName() << " is truncated" << std::endl;
-                }
+                cmp.reportTruncated(2, reader2.getPacketCount());
             }
-            if (read2 != 0) {
+            if (pkt2 != 0) {
                 // File 1 is truncated
-                if (opt.normalized) {
-                    std::cout << "truncated:file=1:packet=" << file1.getPacketCount()
-                              << ":filename=" << file1.getFileName() << ":" << std::endl;
-                }
-                else if (!opt.quiet) {
-                    std::cout << "* Packet " << ts::UString::Decimal(file1.getPacketCount())
-                              << ": file " << file1.getFileName() << " is truncated" << std::endl;
-                }
+                cmp.reportTruncated(1, reader1.getPacketCount());
             }
             break;
         }
 
         // Compare one packet
-        const Comparator comp (pkt1, pkt2, opt);
+        const Comparator comp(*pkt1, *pkt2, opt);
 
         // If file2 is a subset of file1 and an inacceptable difference has been found, read ahead file1.
         if (opt.subset && !comp.equal && comp.diff_count > opt.threshold_diff) {
@@ -427,95 +566,311 @@ int main (int argc, char *argv[])
         // Report resynchronization after missing packets
         if (subset_skipped > 0) {
             if (opt.normalized) {
-                std::cout << "skip:packet=" << (file1.getPacketCount() - 1 - subset_skipped)
+                std::cout << "skip:packet=" << (reader1.getPacketCount() - 1 - subset_skipped)
                           << ":skipped=" << ts::UString::Decimal(subset_skipped)
                           << ":" << std::endl;
             }
             else {
-                std::cout << "* Packet " << ts::UString::Decimal(file1.getPacketCount() - 1 - subset_skipped)
+                std::cout << "* Packet " << ts::UString::Decimal(reader1.getPacketCount() - 1 - subset_skipped)
                           << ", missing " << ts::UString::Decimal(subset_skipped)
                           << " packets in " << file2.getFileName() << std::endl;
             }
-            total_subset_skipped += subset_skipped;
-            subset_skipped_chunks++;
+            cmp.total_subset_skipped += subset_skipped;
+            cmp.subset_skipped_chunks++;
             subset_skipped = 0;
         }
 
         // Report a difference
         if (!comp.equal) {
-            diff_count++;
-            if (opt.normalized) {
-                std::cout << "diff:packet=" << (file1.getPacketCount() - 1)
-                          << (opt.payload_only ? ":payload" : "")
-                          << ":offset=" << comp.first_diff
-                          << ":endoffset=" << comp.end_diff
-                          << ":diffbytes= " << comp.diff_count
-                          << ":compsize=" << comp.compared_size
-                          << ":pid1=" << pid1
-                          << ":pid2=" << pid2
-                          << (pid1 == pid2 ? ":samepid" : "")
-                          << ":pid1index=" << (count1[pid1] - 1)
-                          << ":pid2index=" << (count2[pid2] - 1)
-                          << (count2[pid2] == count1[pid1] ? ":sameindex" : "")
-                          << ":" << std::endl;
+            cmp.diff_count++;
+            cmp.reportDifference(comp, *pkt1, *pkt2, reader1.getPacketCount() - 1);
+            if (opt.quiet || !opt.continue_all) {
+                break;
             }
-            else if (!opt.quiet) {
-                std::cout << "* Packet " << ts::UString::Decimal(file1.getPacketCount() - 1) << " differ at offset " << comp.first_diff;
-                if (opt.payload_only) {
-                    std::cout << " in payload";
-                }
-                std::cout << ", " << comp.diff_count;
-                if (comp.diff_count != comp.end_diff - comp.first_diff) {
-                    std::cout << "/" << (comp.end_diff - comp.first_diff);
-                }
-                std::cout << " bytes differ, PID " << pid1;
-                if (pid2 != pid1) {
-                    std::cout << "/" << pid2;
-                }
-                std::cout << ", packet " << ts::UString::Decimal(count1[pid1] - 1);
-                if (pid2 != pid1 || count2[pid2] != count1[pid1]) {
-                    std::cout << "/" << ts::UString::Decimal(count2[pid2] - 1);
-                }
-                std::cout << " in PID" << std::endl;
-                if (opt.dump) {
-                    std::cout << "  Packet from " << file1.getFileName() << ":" << std::endl;
-                    pkt1.display (std::cout, opt.dump_flags, 6);
-                    std::cout << "  Packet from " << file2.getFileName() << ":" << std::endl;
-                    pkt2.display (std::cout, opt.dump_flags, 6);
-                    std::cout << "  Differing area from " << file1.getFileName() << ":" << std::endl
-                              << ts::UString::Dump(pkt1.b + (opt.payload_only ? pkt1.getHeaderSize() : 0) + comp.first_diff,
-                                                   comp.end_diff - comp.first_diff, opt.dump_flags, 6)
-                              << "  Differing area from " << file2.getFileName() << ":" << std::endl
-                              << ts::UString::Dump(pkt2.b + (opt.payload_only ? pkt2.getHeaderSize() : 0) + comp.first_diff,
-                                                   comp.end_diff - comp.first_diff, opt.dump_flags, 6);
+        }
+    }
+
+    // End of processing, close file
+    cmp.packets = reader1.getPacketCount();
+    file1.close (opt);
+    file2.close (opt);
+}
+
+
+//----------------------------------------------------------------------------
+//  Fast comparison of a range of packets in two files.
+//  Identical chunks are compared using memcmp() and only their PID's are
+//  counted. Differing chunks are compared packet by packet.
+//----------------------------------------------------------------------------
+
+class RangeComparator
+{
+public:
+    // Constructor.
+    RangeComparator(const Options& opt, ts::PacketCounter first, ts::PacketCounter end);
+
+    // Open the files at the next packet to compare. Reopen them if already open.
+    bool open(ts::Report& report);
+
+    // Compare identical chunks only, stop at the first differing chunk or when abort is set.
+    // Return false on error. The PID's of identical chunks are counted in counts.
+    bool skipIdentical(ts::PacketCounter counts[ts::PID_MAX], const std::atomic<bool>& abort, ts::Report& report);
+
+    // Compare all packets, up to the end of range or until the comparison must stop.
+    // Return false on error or when the comparison must stop.
+    bool compareAll(Comparison& cmp, ts::Report& report);
+
+    // Get the index of next chunk to compare.
+    ts::PacketCounter next() const {return _next;}
+
+private:
+    const Options&    _opt;
+    ts::PacketCounter _next;   // Next chunk to compare.
+    ts::PacketCounter _end;    // End of range.
+    ts::TSFileInput   _file1;
+    ts::TSFileInput   _file2;
+    ts::TSPacketVector _chunk1;
+    ts::TSPacketVector _chunk2;
+    size_t            _count;  // Number of packets in loaded chunks.
+
+    // Load the next chunk if not already loaded.
+    bool loadChunk(ts::Report& report);
+};
+
+RangeComparator::RangeComparator(const Options& opt, ts::PacketCounter first, ts::PacketCounter end) :
+    _opt(opt),
+    _next(first),
+    _end(end),
+    _file1(),
+    _file2(),
+    _chunk1(CHUNK_PACKETS),
+    _chunk2(CHUNK_PACKETS),
+    _count(0)
+{
+    _file1.setReadMode(ts::TSFileInput::READ_MMAP);
+    _file2.setReadMode(ts::TSFileInput::READ_MMAP);
+}
+
+bool RangeComparator::open(ts::Report& report)
+{
+    if (_file1.isOpen()) {
+        _file1.close(NULLREP);
+    }
+    if (_file2.isOpen()) {
+        _file2.close(NULLREP);
+    }
+    _count = 0;
+    const uint64_t offset = _opt.byte_offset + _next * ts::PKT_SIZE;
+    return _file1.open(_opt.filename1, 1, offset, report) && _file2.open(_opt.filename2, 1, offset, report);
+}
+
+bool RangeComparator::loadChunk(ts::Report& report)
+{
+    if (_count == 0) {
+        const size_t count = size_t(std::min<ts::PacketCounter>(CHUNK_PACKETS, _end - _next));
+        if (_file1.read(&_chunk1[0], count, report) != count || _file2.read(&_chunk2[0], count, report) != count) {
+            report.error(u"error reading files at packet %'d", {_next});
+            return false;
+        }
+        _count = count;
+    }
+    return true;
+}
+
+bool RangeComparator::skipIdentical(ts::PacketCounter counts[ts::PID_MAX], const std::atomic<bool>& abort, ts::Report& report)
+{
+    while (_next < _end && !abort) {
+        if (!loadChunk(report)) {
+            return false;
+        }
+        if (::memcmp(&_chunk1[0], &_chunk2[0], _count * ts::PKT_SIZE) != 0) {
+            break;
+        }
+        for (size_t i = 0; i < _count; ++i) {
+            counts[_chunk1[i].getPID()]++;
+        }
+        _next += _count;
+        _count = 0;
+    }
+    return true;
+}
+
+bool RangeComparator::compareAll(Comparison& cmp, ts::Report& report)
+{
+    while (_next < _end) {
+        if (!loadChunk(report)) {
+            return false;
+        }
+        if (::memcmp(&_chunk1[0], &_chunk2[0], _count * ts::PKT_SIZE) == 0) {
+            // Identical packets are always equal, whatever the comparison options.
+            for (size_t i = 0; i < _count; ++i) {
+                const ts::PID pid = _chunk1[i].getPID();
+                cmp.count1[pid]++;
+                cmp.count2[pid]++;
+            }
+        }
+        else {
+            for (size_t i = 0; i < _count; ++i) {
+                if (!cmp.comparePackets(_chunk1[i], _chunk2[i], _next + i)) {
+                    cmp.packets = _next + i + 1;
+                    return false;
                 }
             }
-            if (opt.quiet || !opt.continue_all) {
-                break;
+        }
+        _next += _count;
+        _count = 0;
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+//  A thread which skips the identical beginning of a part of the files.
+//----------------------------------------------------------------------------
+
+class PartComparator: public ts::Thread
+{
+public:
+    // Constructor.
+    PartComparator(const Options& opt, ts::PacketCounter first, ts::PacketCounter end, const std::atomic<bool>& abort);
+
+    // Destructor.
+    virtual ~PartComparator() override;
+
+    // Public fields, valid after termination of the thread.
+    RangeComparator   range;                  // Comparator of the part.
+    ts::PacketCounter counts[ts::PID_MAX];    // PID counts of identical packets.
+    bool              success;                // No error.
+
+private:
+    const std::atomic<bool>& _abort;
+
+    // Implementation of Thread.
+    virtual void main() override;
+
+    // Inaccessible operations.
+    PartComparator() = delete;
+    PartComparator(const PartComparator&) = delete;
+    PartComparator& operator=(const PartComparator&) = delete;
+};
+
+typedef ts::SafePtr<PartComparator> PartComparatorPtr;
+
+PartComparator::PartComparator(const Options& opt, ts::PacketCounter first, ts::PacketCounter end, const std::atomic<bool>& abort) :
+    Thread(),
+    range(opt, first, end),
+    success(false),
+    _abort(abort)
+{
+    TS_ZERO(counts);
+}
+
+PartComparator::~PartComparator()
+{
+    waitForTermination();
+}
+
+void PartComparator::main()
+{
+    // Errors are reported later by the main thread.
+    success = range.open(NULLREP) && range.skipIdentical(counts, _abort, NULLREP);
+}
+
+
+//----------------------------------------------------------------------------
+//  Fast comparison of two regular files, possibly in parallel.
+//  Return false if the files cannot be compared this way.
+//----------------------------------------------------------------------------
+
+bool FastCompare(Options& opt, Comparison& cmp)
+{
+    const int64_t size1 = ts::GetFileSize(opt.filename1);
+    const int64_t size2 = ts::GetFileSize(opt.filename2);
+    // Pipes and other special files report a null size, use the sequential comparison.
+    if (size1 <= 0 || size2 <= 0) {
+        return false;
+    }
+
+    // Number of packets to compare in each file.
+    const ts::PacketCounter total1 = uint64_t(size1) < opt.byte_offset ? 0 : (uint64_t(size1) - opt.byte_offset) / ts::PKT_SIZE;
+    const ts::PacketCounter total2 = uint64_t(size2) < opt.byte_offset ? 0 : (uint64_t(size2) - opt.byte_offset) / ts::PKT_SIZE;
+    const ts::PacketCounter total = std::min(total1, total2);
+
+    // Split the common part of the files in contiguous parts. The identical beginning
+    // of each part is skipped in parallel. The rest of the parts are compared in sequence.
+    const size_t count = size_t(std::max<ts::PacketCounter>(1, std::min<ts::PacketCounter>(opt.threads, total / CHUNK_PACKETS)));
+    std::atomic<bool> abort(false);
+    std::vector<PartComparatorPtr> parts;
+    parts.reserve(count);
+    for (size_t i = 1; i < count; ++i) {
+        parts.push_back(new PartComparator(opt, (total * i) / count, (total * (i + 1)) / count, abort));
+        parts.back()->start();
+    }
+
+    // The first part is processed by the main thread.
+    RangeComparator first(opt, 0, total / count);
+    bool more = first.open(opt) && first.compareAll(cmp, opt);
+
+    for (size_t i = 0; more && i < parts.size(); ++i) {
+        PartComparator& part(*parts[i]);
+        part.waitForTermination();
+        // The beginning of the part is identical in the two files.
+        for (ts::PID pid = 0; pid < ts::PID_MAX; ++pid) {
+            cmp.count1[pid] += part.counts[pid];
+            cmp.count2[pid] += part.counts[pid];
+        }
+        // Continue the comparison of the part from the first differing chunk.
+        // In case of error in the thread, reopen the files to report the error.
+        more = (part.success || part.range.open(opt)) && part.range.compareAll(cmp, opt);
+    }
+
+    // Stop remaining threads when the comparison stopped early.
+    abort = true;
+    parts.clear();
+
+    // Report files with different sizes.
+    if (more) {
+        cmp.packets = total1 > total2 ? total2 + 1 : total1;
+        if (total1 != total2) {
+            cmp.diff_count++;
+            if (total1 > total2) {
+                cmp.reportTruncated(2, total2);
+            }
+            else {
+                cmp.reportTruncated(1, total1);
             }
         }
     }
+    return true;
+}
 
-    // Final report
+
+//----------------------------------------------------------------------------
+//  Program entry point
+//----------------------------------------------------------------------------
+
+int main (int argc, char *argv[])
+{
+    TSDuckLibCheckVersion();
+    Options opt (argc, argv);
+    Comparison cmp(opt);
+
+    // Display headers
     if (opt.normalized) {
-        std::cout << "total:packets=" << file1.getPacketCount()
-                  << ":diff=" << diff_count
-                  << ":missing=" << total_subset_skipped
-                  << ":holes=" << subset_skipped_chunks
-                  << ":" << std::endl;
+        std::cout << "file:file=1:filename=" << opt.filename1 << ":" << std::endl
+                  << "file:file=2:filename=" << opt.filename2 << ":" << std::endl;
+
     }
     else if (opt.verbose()) {
-        std::cout << "* Read " << ts::UString::Decimal(file1.getPacketCount())
-                  << " packets, found " << ts::UString::Decimal(diff_count) << " differences";
-        if (subset_skipped_chunks > 0) {
-            std::cout << ", missing " << ts::UString::Decimal(total_subset_skipped)
-                      << " packets in " << ts::UString::Decimal(subset_skipped_chunks) << " holes";
-        }
-        std::cout << std::endl;
+        std::cout << "* Comparing " << opt.filename1 << " and " << opt.filename2 << std::endl;
     }
 
-    // End of processing, close file
-    file1.close (opt);
-    file2.close (opt);
-    return diff_count == 0 && opt.valid() ? EXIT_SUCCESS : EXIT_FAILURE;
+    // Compare the files. With --subset, the two files are not aligned, use the packet by packet comparison.
+    if (opt.subset || !FastCompare(opt, cmp)) {
+        SequentialCompare(opt, cmp);
+    }
+
+    // Final report
+    cmp.reportTotal();
+    return cmp.diff_count == 0 && opt.valid() ? EXIT_SUCCESS : EXIT_FAILURE;
 }
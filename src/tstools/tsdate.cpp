@@ -161,7 +161,7 @@ void TableHandler::handleTable(ts::SectionDemux&, const ts::BinaryTable& table)
             if (!tdt.isValid()) {
                 break;
             }
-            std::cout << "* TDT UTC time: " << tdt.utc_time << std::endl;
+            _display.out() << "* TDT UTC time: " << tdt.utc_time << std::endl;
             break;
         }
 
@@ -178,19 +178,19 @@ void TableHandler::handleTable(ts::SectionDemux&, const ts::BinaryTable& table)
             if (!tot.isValid()) {
                 break;
             }
-            std::cout << "* TOT UTC time: " << tot.utc_time << std::endl;
+            _display.out() << "* TOT UTC time: " << tot.utc_time << std::endl;
             for (ts::TOT::RegionVector::const_iterator it = tot.regions.begin(); it != tot.regions.end(); ++it) {
-                std::cout << "  Country: " << it->country
-                          << ", region: " << it->region_id
-                          << std::endl
-                          << "  Local time:   " << tot.localTime(*it)
-                          << ", local time offset: "
-                          << ts::TOT::timeOffsetFormat(it->time_offset)
-                          << std::endl
-                          << "  Next change:  " << it->next_change
-                          << ", next time offset:  "
-                          << ts::TOT::timeOffsetFormat(it->next_time_offset)
-                          << std::endl;
+                _display.out() << "  Country: " << it->country
+                               << ", region: " << it->region_id
+                               << std::endl
+                               << "  Local time:   " << tot.localTime(*it)
+                               << ", local time offset: "
+                               << ts::TOT::timeOffsetFormat(it->time_offset)
+                               << std::endl
+                               << "  Next change:  " << it->next_change
+                               << ", next time offset:  "
+                               << ts::TOT::timeOffsetFormat(it->next_time_offset)
+                               << std::endl;
             }
             break;
         }
@@ -199,7 +199,7 @@ void TableHandler::handleTable(ts::SectionDemux&, const ts::BinaryTable& table)
             if (_opt.verbose()) {
                 const ts::TID tid = table.tableId();
                 const ts::PID pid = table.sourcePID();
-                std::cout << ts::UString::Format(u"* Got unexpected %s, TID %d (0x%X) on PID %d (0x%X)", {ts::names::TID(tid), tid, tid, pid, pid}) << std::endl;
+                _display.out() << ts::UString::Format(u"* Got unexpected %s, TID %d (0x%X) on PID %d (0x%X)", {ts::names::TID(tid), tid, tid, pid, pid}) << std::endl;
             }
         }
     }
@@ -34,7 +34,8 @@
 
 #include "tsArgs.h"
 #include "tsInputRedirector.h"
-#include "tsTSPacket.h"
+#include "tsTSFileBlockReader.h"
+#include "tsBlockOutputStream.h"
 #include "tsVersionInfo.h"
 TSDUCK_SOURCE;
 
@@ -164,35 +165,45 @@ int main(int argc, char *argv[])
 {
     TSDuckLibCheckVersion();
     Options opt(argc, argv);
-    ts::InputRedirector input(opt.infile, opt);
+
+    // Text output is written to stdout in large blocks.
+    ts::BlockOutputStream out;
 
     // Dump the file
 
     if (opt.raw_file) {
         // Raw dump of file
+        ts::InputRedirector input(opt.infile, opt);
         opt.dump_flags = (opt.dump_flags & 0x0000FFFF) | ts::UString::BPL | ts::UString::WIDE_OFFSET;
-        const size_t MAX_RAW_BPL = 16;
         const size_t raw_bpl = (opt.dump_flags & ts::UString::BINARY) ? 8 : 16;  // Bytes per line in raw mode
         size_t offset = 0;
+        // Read large chunks, a multiple of the number of bytes per line.
+        std::vector<char> buffer(4096 * raw_bpl);
         while (std::cin) {
-            int c;
-            size_t size;
-            uint8_t buffer[MAX_RAW_BPL];
-            for (size = 0; size < raw_bpl && (c = std::cin.get()) != EOF; size++) {
-                buffer[size] = uint8_t(c);
-            }
-            std::cout << ts::UString::Dump(buffer, size, opt.dump_flags, 0, raw_bpl, offset);
+            std::cin.read(&buffer[0], std::streamsize(buffer.size()));
+            const size_t size = size_t(std::cin.gcount());
+            out.putDump(&buffer[0], size, opt.dump_flags, 0, raw_bpl, offset);
             offset += size;
         }
     }
     else {
-        // Read all packets in the file
-        ts::TSPacket pkt;
-        for (ts::PacketCounter packet_index = 0; pkt.read(std::cin, true, opt); packet_index++) {
-            std::cout << std::endl << "* Packet " << ts::UString::Decimal(packet_index) << std::endl;
-            pkt.display (std::cout, opt.dump_flags, 2);
+        // Read all packets in the file, in large blocks.
+        ts::TSFileInput file;
+        ts::TSFileBlockReader reader(file);
+        if (!file.open(opt.infile, 1, 0, opt)) {
+            return EXIT_FAILURE;
+        }
+        const ts::TSPacket* pkt = 0;
+        for (ts::PacketCounter packet_index = 0; (pkt = reader.next(opt)) != 0; packet_index++) {
+            if (!pkt->hasValidSync()) {
+                opt.error(u"synchronization lost after %'d TS packets, got 0x%X instead of 0x%X at start of TS packet", {packet_index, pkt->b[0], ts::SYNC_BYTE});
+                break;
+            }
+            out << "\n* Packet " << ts::UString::Decimal(packet_index) << "\n";
+            pkt->display(out, opt.dump_flags, 2);
         }
-        std::cout << std::endl;
+        out << "\n";
+        file.close(opt);
     }
 
     return EXIT_SUCCESS;
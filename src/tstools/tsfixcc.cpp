@@ -33,6 +33,7 @@
 
 #include "tsArgs.h"
 #include "tsTSPacket.h"
+#include "tsMemoryMappedFile.h"
 #include "tsVersionInfo.h"
 TSDUCK_SOURCE;
 
@@ -48,6 +49,7 @@ public:
 
     bool         test;      // Test mode
     bool         circular;  // Add empty packets to enforce circular continuity
+    bool         mmap;      // Fix the file in place through a memory mapping
     ts::UString  filename;  // File name
     std::fstream file;      // File buffer
 
@@ -60,12 +62,14 @@ Options::Options(int argc, char *argv[]) :
     Args(u"MPEG Transport Stream Fix Continuity Counters Utility.", u"[options] filename"),
     test(false),
     circular(false),
+    mmap(false),
     filename(),
     file()
 {
     option(u"",          0,  Args::STRING, 1, 1);
-    option(u"circular", 'c');
-    option(u"noaction", 'n');
+    option(u"circular",   'c');
+    option(u"memory-map", 'm');
+    option(u"noaction",   'n');
 
     setHelp(u"File:\n"
             u"\n"
@@ -82,6 +86,13 @@ Options::Options(int argc, char *argv[]) :
             u"  --help\n"
             u"      Display this help text.\n"
             u"\n"
+            u"  -m\n"
+            u"  --memory-map\n"
+            u"      Map the file in memory and fix the continuity counters in place. Only\n"
+            u"      the modified packets are written back to the file. This is much faster\n"
+            u"      on large files with many discontinuities. The file must fit in the\n"
+            u"      virtual address space of the process.\n"
+            u"\n"
             u"  -n\n"
             u"  --noaction\n"
             u"      Display what should be performed but do not modify the file.\n"
@@ -97,6 +108,7 @@ Options::Options(int argc, char *argv[]) :
 
     filename = value(u"");
     circular = present(u"circular");
+    mmap = present(u"memory-map");
     test = present(u"noaction");
 
     if (test) {
@@ -151,99 +163,153 @@ public:
 
 
 //----------------------------------------------------------------------------
-//  Program entry point
+//  Analyze the continuity counter of a packet. Return true if the packet
+//  must be updated with the returned good continuity counter.
 //----------------------------------------------------------------------------
 
-int main(int argc, char *argv[])
+inline bool CheckPacket(Options& opt, PIDState* pids, const ts::TSPacket& pkt, ts::PacketCounter packet_count, ts::PacketCounter& error_count, uint8_t& good_cc)
 {
-    TSDuckLibCheckVersion();
-    Options opt(argc, argv);
-
-    // Open file in read/write mode (CC are overwritten)
-
-    std::ios::openmode mode = std::ios::in | std::ios::binary;
-    if (!opt.test) {
-        mode |= std::ios::out;
+    const ts::PID pid = pkt.getPID();
+    const uint8_t cc = pkt.getCC();
+    good_cc = cc;
+
+    if (pids[pid].first_cc > 0x0F) {
+        // First packet on this PID
+        pids[pid].first_cc = cc;
+        pids[pid].sync = true;
+    }
+    else {
+        // Compute expected CC for this packet
+        good_cc = pkt.hasPayload() ? ((pids[pid].last_cc + 1) & 0x0F) : pids[pid].last_cc;
+        if (pids[pid].sync && cc != good_cc) {
+            // PID was correctly synchronized, but the current CC is wrong.
+            // We now loose the synchronization on this PID.
+            pids[pid].sync = false;
+            error_count++;
+            opt.verbose(u"TS packet: %'d, PID: 0x%04X, missing: %2d packets", {packet_count, pid, MissingPackets(pids[pid].last_cc, cc)});
+        }
     }
 
-    opt.file.open(opt.filename.toUTF8().c_str(), mode);
+    // The packet needs to be rewritten if the PID is no longer synchronized and the CC is different.
+    pids[pid].last_cc = good_cc;
+    return !pids[pid].sync && cc != good_cc;
+}
 
-    if (!opt.file) {
-        opt.error(u"cannot open file %s", {opt.filename});
-        return EXIT_FAILURE;
-    }
 
-    // Process all packets in the file
+//----------------------------------------------------------------------------
+//  Program entry point
+//----------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+    TSDuckLibCheckVersion();
+    Options opt(argc, argv);
 
     PIDState pids[ts::PID_MAX];
     ts::PacketCounter packet_count = 0;
     ts::PacketCounter error_count = 0;
     ts::PacketCounter rewrite_count = 0;
     ts::TSPacket pkt;
+    uint8_t good_cc = 0;
 
-    for (;;) {
-
-        // Save position of current packet
+    if (opt.mmap) {
 
-        const std::ios::pos_type pos = opt.file.tellg();
-        if (opt.fileError(u"error getting file position")) {
-            break;
+        // Map the file in memory, in read-write mode when CC are overwritten.
+        ts::MemoryMappedFile file;
+        if (!file.open(opt.filename, opt, !opt.test)) {
+            return EXIT_FAILURE;
         }
+        file.adviseSequential();
 
-        // Read a TS packet
+        // Process all packets in place. Only the modified pages are written back to the file.
+        const uint8_t* const data = file.data();
+        uint8_t* const wdata = file.writableData();
+        const size_t count = file.size() / ts::PKT_SIZE;
 
-        if (!pkt.read(opt.file, true, opt)) {
-            break; // end of file
+        for (size_t index = 0; index < count; ++index) {
+            const ts::TSPacket* const p = reinterpret_cast<const ts::TSPacket*>(data + index * ts::PKT_SIZE);
+            if (p->b[0] != ts::SYNC_BYTE) {
+                opt.error(u"synchronization lost after %'d TS packets, got 0x%X instead of 0x%X at start of TS packet", {index, p->b[0], ts::SYNC_BYTE});
+                break;
+            }
+            if (CheckPacket(opt, pids, *p, packet_count, error_count, good_cc) && wdata != 0) {
+                reinterpret_cast<ts::TSPacket*>(wdata + index * ts::PKT_SIZE)->setCC(good_cc);
+                rewrite_count++;
+            }
+            packet_count++;
         }
+        if (packet_count == count && file.size() % ts::PKT_SIZE != 0) {
+            opt.error(u"truncated TS packet (%d bytes) after %'d TS packets", {file.size() % ts::PKT_SIZE, count});
+        }
+        file.close();
+
+        // Reopen the file to append packets, if necessary.
+        if (opt.circular && opt.valid() && !opt.test) {
+            opt.file.open(opt.filename.toUTF8().c_str(), std::ios::in | std::ios::out | std::ios::binary);
+            if (!opt.file) {
+                opt.error(u"cannot open file %s", {opt.filename});
+                return EXIT_FAILURE;
+            }
+        }
+    }
+    else {
 
-        // Process packet
-
-        const ts::PID pid = pkt.getPID();
-        const uint8_t cc = pkt.getCC();
-        uint8_t good_cc = cc;
+        // Open file in read/write mode (CC are overwritten)
 
-        if (pids[pid].first_cc > 0x0F) {
-            // First packet on this PID
-            pids[pid].first_cc = cc;
-            pids[pid].sync = true;
+        std::ios::openmode mode = std::ios::in | std::ios::binary;
+        if (!opt.test) {
+            mode |= std::ios::out;
         }
-        else {
-            // Compute expected CC for this packet
-            good_cc = pkt.hasPayload() ? ((pids[pid].last_cc + 1) & 0x0F) : pids[pid].last_cc;
-            if (pids[pid].sync && cc != good_cc) {
-                // PID was correctly synchronized, but the current CC is wrong.
-                // We now loose the synchronization on this PID.
-                pids[pid].sync = false;
-                error_count++;
-                opt.verbose(u"TS packet: %'d, PID: 0x%04X, missing: %2d packets", {packet_count, pid, MissingPackets(pids[pid].last_cc, cc)});
-            }
+
+        opt.file.open(opt.filename.toUTF8().c_str(), mode);
+
+        if (!opt.file) {
+            opt.error(u"cannot open file %s", {opt.filename});
+            return EXIT_FAILURE;
         }
 
-        // Rewrite packet if no longer synchronized
+        // Process all packets in the file
+
+        for (;;) {
+
+            // Save position of current packet
 
-        if (!pids[pid].sync && !opt.test) {
-            // Update CC in packet with expected value
-            pkt.setCC(good_cc);
-            // Rewind to beginning of current packet
-            opt.file.seekp(pos);
-            if (opt.fileError(u"error setting file position")) {
+            const std::ios::pos_type pos = opt.file.tellg();
+            if (opt.fileError(u"error getting file position")) {
                 break;
             }
-            // Rewrite the packet
-            pkt.write(opt.file, opt);
-            if (opt.fileError(u"error rewriting packet")) {
-                break;
+
+            // Read a TS packet
+
+            if (!pkt.read(opt.file, true, opt)) {
+                break; // end of file
             }
-            // Make sure the get position is ok
-            opt.file.seekg(opt.file.tellp());
-            if (opt.fileError(u"error setting file position")) {
-                break;
+
+            // Rewrite packet if no longer synchronized
+
+            if (CheckPacket(opt, pids, pkt, packet_count, error_count, good_cc) && !opt.test) {
+                // Update CC in packet with expected value
+                pkt.setCC(good_cc);
+                // Rewind to beginning of current packet
+                opt.file.seekp(pos);
+                if (opt.fileError(u"error setting file position")) {
+                    break;
+                }
+                // Rewrite the packet
+                pkt.write(opt.file, opt);
+                if (opt.fileError(u"error rewriting packet")) {
+                    break;
+                }
+                // Make sure the get position is ok
+                opt.file.seekg(opt.file.tellp());
+                if (opt.fileError(u"error setting file position")) {
+                    break;
+                }
+                rewrite_count++;
             }
-            rewrite_count++;
-        }
 
-        pids[pid].last_cc = good_cc;
-        packet_count++;
+            packet_count++;
+        }
     }
 
     opt.verbose(u"%'d packets read, %'d discontinuities, %'d packets updated", {packet_count, error_count, rewrite_count});
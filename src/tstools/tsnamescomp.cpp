@@ -0,0 +1,130 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  Compile TSDuck names files
+//
+//----------------------------------------------------------------------------
+
+#include "tsArgs.h"
+#include "tsNames.h"
+#include "tsSysUtils.h"
+#include "tsVersionInfo.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+//  Command line options
+//----------------------------------------------------------------------------
+
+struct Options: public ts::Args
+{
+    Options(int argc, char *argv[]);
+
+    ts::UStringVector files;    // Names files to compile.
+    ts::UString       out_dir;  // Output directory, same as input file if empty.
+};
+
+Options::Options(int argc, char *argv[]) :
+    Args(u"Compile TSDuck names files in binary form.", u"[options] filename ..."),
+    files(),
+    out_dir()
+{
+    option(u"",                 0,  Args::STRING, 1, Args::UNLIMITED_COUNT);
+    option(u"output-directory", 'o', Args::STRING);
+
+    setHelp(u"Files:\n"
+            u"\n"
+            u"  Names files to compile, typically tsduck.dvb.names and tsduck.oui.names.\n"
+            u"  Each compiled file is created with the same name as the input file and\n"
+            u"  an additional suffix '.bin'. Compiled files are memory-mapped by all TSDuck\n"
+            u"  applications, avoiding the parsing of the text files at startup.\n"
+            u"\n"
+            u"Options:\n"
+            u"\n"
+            u"  --help\n"
+            u"      Display this help text.\n"
+            u"\n"
+            u"  -o path\n"
+            u"  --output-directory path\n"
+            u"      Directory where the compiled files are created. By default, each\n"
+            u"      compiled file is created in the same directory as the input file.\n"
+            u"\n"
+            u"  -v\n"
+            u"  --verbose\n"
+            u"      Produce verbose output.\n"
+            u"\n"
+            u"  --version\n"
+            u"      Display the version number.\n");
+
+    analyze(argc, argv);
+
+    getValues(files, u"");
+    out_dir = value(u"output-directory");
+
+    exitOnError();
+}
+
+
+//----------------------------------------------------------------------------
+//  Program entry point
+//----------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+    TSDuckLibCheckVersion();
+    Options opt(argc, argv);
+    bool success = true;
+
+    for (ts::UStringVector::const_iterator file = opt.files.begin(); file != opt.files.end(); ++file) {
+
+        // Always load the text file, never a previously compiled file.
+        if (!ts::FileExists(*file)) {
+            opt.error(u"file %s not found", {*file});
+            success = false;
+            continue;
+        }
+        const ts::Names names(*file, false);
+        if (names.errorCount() > 0) {
+            opt.error(u"%d errors in %s", {names.errorCount(), *file});
+            success = false;
+            continue;
+        }
+
+        // Build the output file name.
+        ts::UString out(ts::Names::CompiledFileName(*file));
+        if (!opt.out_dir.empty()) {
+            out = opt.out_dir + ts::PathSeparator + ts::BaseName(out);
+        }
+
+        opt.verbose(u"compiling %s into %s", {*file, out});
+        success = names.saveCompiled(out, opt) && success;
+    }
+
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -32,16 +32,18 @@
 //----------------------------------------------------------------------------
 
 #include "tspOptions.h"
-#include "tspInputExecutor.h"
-#include "tspOutputExecutor.h"
-#include "tspProcessorExecutor.h"
+#include "tspPipeline.h"
+#include "tspControlServer.h"
 #include "tsPluginRepository.h"
 #include "tsAsyncReport.h"
+#include "tsReportWithPrefix.h"
 #include "tsSystemMonitor.h"
-#include "tsMonotonic.h"
-#include "tsResidentBuffer.h"
+#include "tsMetricsExporter.h"
+#include "tsThreadPool.h"
 #include "tsOutputPager.h"
 #include "tsIPUtils.h"
+#include "tsPooledByteBlock.h"
+#include "tsSysUtils.h"
 #include "tsVersionInfo.h"
 TSDUCK_SOURCE;
 
@@ -61,11 +63,11 @@ namespace ts {
         class TSPInterruptHandler: public InterruptHandler
         {
         public:
-            TSPInterruptHandler(AsyncReport* report = 0, PluginExecutor* first_plugin = 0);
+            TSPInterruptHandler(AsyncReport* report, const std::vector<Pipeline*>* pipelines);
             virtual void handleInterrupt() override;
         private:
-            AsyncReport*    _report;
-            PluginExecutor* _first_plugin;
+            AsyncReport* _report;
+            const std::vector<Pipeline*>* _pipelines;
 
             // Inaccessible operations
             TSPInterruptHandler(const TSPInterruptHandler&) = delete;
@@ -74,23 +76,94 @@ namespace ts {
     }
 }
 
-ts::tsp::TSPInterruptHandler::TSPInterruptHandler(AsyncReport* report, PluginExecutor* first_plugin) :
+ts::tsp::TSPInterruptHandler::TSPInterruptHandler(AsyncReport* report, const std::vector<Pipeline*>* pipelines) :
     _report(report),
-    _first_plugin(first_plugin)
+    _pipelines(pipelines)
 {
 }
 
 void ts::tsp::TSPInterruptHandler::handleInterrupt()
 {
     _report->info(u"tsp: user interrupt, terminating...");
+    for (size_t i = 0; i < _pipelines->size(); ++i) {
+        (*_pipelines)[i]->abort();
+    }
+}
+
+
+//----------------------------------------------------------------------------
+//  Load the configuration file of the host mode.
+//  Each pipeline is described by its name, followed by its tsp arguments.
+//----------------------------------------------------------------------------
+
+namespace {
+    struct HostPipeline
+    {
+        HostPipeline() : name(), args() {}
+        ts::UString name;
+        std::vector<std::string> args;  // UTF-8, as on a command line.
+    };
+
+    bool LoadHostConfig(const ts::UString& file_name, std::vector<HostPipeline>& pipelines, ts::Report& report)
+    {
+        ts::UStringVector lines;
+        if (!ts::UString::Load(lines, file_name)) {
+            report.error(u"cannot read %s", {file_name});
+            return false;
+        }
+
+        // Join continuation lines.
+        ts::UStringVector joined;
+        bool continued = false;
+        for (ts::UStringVector::iterator it = lines.begin(); it != lines.end(); ++it) {
+            it->trim();
+            const bool next_continued = it->endWith(u"\\");
+            if (next_continued) {
+                it->pop_back();
+            }
+            if (continued) {
+                joined.back().append(u' ');
+                joined.back().append(*it);
+            }
+            else {
+                joined.push_back(*it);
+            }
+            continued = next_continued;
+        }
 
-    // Place all threads in "aborted" state so that each thread will see its
-    // successor as aborted. Notify all threads that something happened.
+        // Split each line in arguments, with single or double quotes.
+        for (ts::UStringVector::const_iterator it = joined.begin(); it != joined.end(); ++it) {
+            if (it->empty() || it->front() == u'#') {
+                continue;
+            }
+            ts::UStringVector args;
+            if (!ts::tsp::Options::SplitArguments(args, *it)) {
+                report.error(u"%s: unterminated quote in \"%s\"", {file_name, *it});
+                return false;
+            }
+            if (args.empty()) {
+                continue;
+            }
+            HostPipeline pl;
+            pl.name = args[0];
+            for (size_t i = 1; i < args.size(); ++i) {
+                pl.args.push_back(args[i].toUTF8());
+            }
+            for (size_t i = 0; i < pipelines.size(); ++i) {
+                if (pipelines[i].name == pl.name) {
+                    report.error(u"%s: duplicate processing chain name %s", {file_name, pl.name});
+                    return false;
+                }
+            }
+            pipelines.push_back(pl);
+        }
 
-    PluginExecutor* proc = _first_plugin;
-    do {
-        proc->setAbort();
-    } while ((proc = proc->ringNext<PluginExecutor>()) != _first_plugin);
+        if (pipelines.empty()) {
+            report.error(u"no processing chain in %s", {file_name});
+            return false;
+        }
+        return true;
+    }
 }
 
 
@@ -119,7 +192,7 @@ int main(int argc, char *argv[])
     // Process the --list-processors option
     if (opt.list_proc) {
         // Build the list of plugins.
-        const ts::UString text(plugins->listPlugins(true, opt));
+        const ts::UString text(opt.list_names ? plugins->listPluginNames(opt) : plugins->listPlugins(true, opt));
         // Try to page, raw output otherwise.
         ts::OutputPager pager;
         if (pager.canPage() && pager.open(true, 0, opt)) {
@@ -141,100 +214,128 @@ int main(int argc, char *argv[])
     // Prevent from being killed when writing on broken pipes.
     ts::IgnorePipeSignal();
 
-    // There is one global mutex for protected operations.
-    // The resulting bottleneck of this single mutex is acceptable as long
-    // as all protected operations are fast (pointer update, simple arithmetic).
-    ts::Mutex global_mutex;
-
-    // Load all plugins and analyze their command line arguments.
-    // The first plugin is always the input and the last one is the output.
-    // The input thread has the highest priority to be always ready to load
-    // incoming packets in the buffer (avoid missing packets). The output
-    // plugin has a hight priority to make room in the buffer, but not as
-    // high as the input which must remain the top-most priority?
+    // In host mode, load the description of all processing chains.
+    std::vector<HostPipeline> host;
+    if (!opt.host_file.empty() && !LoadHostConfig(opt.host_file, host, opt)) {
+        return EXIT_FAILURE;
+    }
 
-    ts::tsp::InputExecutor* input = new ts::tsp::InputExecutor(&opt, &opt.input, ts::ThreadAttributes().setPriority(ts::ThreadAttributes::GetMaximumPriority()), global_mutex);
-    ts::tsp::OutputExecutor* output = new ts::tsp::OutputExecutor(&opt, &opt.output, ts::ThreadAttributes().setPriority(ts::ThreadAttributes::GetHighPriority()), global_mutex);
-    output->ringInsertAfter(input);
+    // In host mode, the packet-parallel plugins of all processing chains share a pool of threads.
+    ts::ThreadPool* pool = host.empty() ? 0 : new ts::ThreadPool(opt.host_threads);
 
-    for (ts::tsp::Options::PluginOptionsVector::const_iterator it = opt.plugins.begin(); it != opt.plugins.end(); ++it) {
-        ts::tsp::PluginExecutor* p = new ts::tsp::ProcessorExecutor(&opt, &*it, ts::ThreadAttributes(), global_mutex);
-        p->ringInsertBefore(output);
+    // Load all plugins and analyze their command line arguments.
+    std::vector<ts::tsp::Options*> pl_options;
+    std::vector<ts::tsp::Pipeline*> pipelines;
+    if (host.empty()) {
+        pipelines.push_back(new ts::tsp::Pipeline(&opt));
+        opt.exitOnError();
+    }
+    for (size_t i = 0; i < host.size(); ++i) {
+        // Build a command line for the processing chain.
+        std::vector<char*> pl_argv;
+        pl_argv.push_back(argv[0]);
+        for (size_t n = 0; n < host[i].args.size(); ++n) {
+            pl_argv.push_back(const_cast<char*>(host[i].args[n].c_str()));
+        }
+        pl_argv.push_back(0);
+        opt.debug(u"loading processing chain %s", {host[i].name});
+        ts::tsp::Options* o = new ts::tsp::Options(int(pl_argv.size() - 1), &pl_argv[0]);
+        pl_options.push_back(o);
+        if (!o->host_file.empty()) {
+            o->error(u"%s: --host is not allowed in a processing chain", {host[i].name});
+        }
+        if (o->control_address.hasPort()) {
+            o->error(u"%s: --control-port is not allowed in a processing chain", {host[i].name});
+        }
+        o->pipeline_name = host[i].name;
+        o->monitor = o->monitor || opt.monitor;
+        o->metrics = opt.metrics;
+        // By default, all packet processors of a chain run in the same thread.
+        if (!o->present(u"fuse-processors")) {
+            for (size_t n = 1; n < o->plugins.size(); ++n) {
+                o->plugins[n].fused = true;
+            }
+        }
+        pipelines.push_back(new ts::tsp::Pipeline(o, pool));
+        o->exitOnError();
     }
-
-    // Exit on error when initializing the plugins
-    opt.exitOnError();
 
     // Create an asynchronous error logger. Can be used in multi-threaded context.
     ts::AsyncReport report(opt.maxSeverity(), opt.timed_log, opt.log_msg_count, opt.sync_log);
 
-    // Set this logger as report method for all executors.
-    ts::tsp::PluginExecutor* proc = input;
-    do {
-        proc->setReport(&report);
-        proc->setMaxSeverity(report.maxSeverity());
-    } while ((proc = proc->ringNext<ts::tsp::PluginExecutor>()) != input);
-
-    // Allocate a memory-resident buffer of TS packets
-    ts::ResidentBuffer<ts::TSPacket> packet_buffer(opt.bufsize / ts::PKT_SIZE);
-    if (!packet_buffer.isLocked()) {
-        report.verbose(u"tsp: buffer failed to lock into physical memory (%d: %s), risk of real-time issue",
-                       {packet_buffer.lockErrorCode(), ts::ErrorCodeMessage(packet_buffer.lockErrorCode())});
-    }
-    report.debug(u"tsp: buffer size: %'d TS packets, %'d bytes", {packet_buffer.count(), packet_buffer.count() * ts::PKT_SIZE});
-
-    // Start all processors, except output, in reverse order (input last).
-    // Exit application in case of error.
-    for (proc = output->ringPrevious<ts::tsp::PluginExecutor>(); proc != output; proc = proc->ringPrevious<ts::tsp::PluginExecutor>()) {
-        if (!proc->plugin()->start()) {
-            return EXIT_FAILURE;
-        }
+    // In host mode, the messages are prefixed by the name of the processing chain.
+    std::vector<ts::ReportWithPrefix*> pl_reports;
+    for (size_t i = 0; i < host.size(); ++i) {
+        pl_reports.push_back(new ts::ReportWithPrefix(report, host[i].name + u": "));
+        pl_reports.back()->setMaxSeverity(report.maxSeverity());
     }
 
-    // Initialize packet buffer in the ring of executors.
-    // Exit application in case of error.
-    if (!input->initAllBuffers(&packet_buffer)) {
+    // Export the performance counters if required.
+    ts::MetricsExporter http_exporter(&report);
+    ts::MetricsExporter statsd_exporter(&report);
+    if (opt.metrics_http.hasPort() && !http_exporter.startHTTP(opt.metrics_http)) {
         return EXIT_FAILURE;
     }
-
-    // Start the output device (we now have an idea of the bitrate).
-    // Exit application in case of error.
-    if (!output->plugin()->start()) {
+    if (opt.metrics_statsd.hasPort() && !statsd_exporter.startStatsD(opt.metrics_statsd, opt.metrics_interval)) {
         return EXIT_FAILURE;
     }
 
+    // Prepare the memory to avoid page faults and allocations after startup.
+    // The plugin threads prefault their own stacks when they start.
+    if (opt.prefault) {
+        const ts::ErrorCode err = ts::LockProcessMemory();
+        if (err != ts::SYS_SUCCESS) {
+            report.warning(u"cannot lock process memory: %s", {ts::ErrorCodeMessage(err)});
+        }
+        ts::PooledByteBlock::Reserve(ts::PooledByteBlock::MAX_FREE);
+    }
+
+    // Start all plugins and plugin executors threads.
+    // On error, the processing chains which are already started are aborted.
+    bool success = true;
+    size_t started = 0;
+    while (success && started < pipelines.size()) {
+        ts::Report& pl_report(host.empty() ? static_cast<ts::Report&>(report) : *pl_reports[started]);
+        success = pipelines[started]->start(pl_report);
+        if (success) {
+            started++;
+        }
+    }
+
+    // Accept control commands if required. On error, all processing chains are aborted.
+    ts::tsp::ControlServer control(pipelines, report);
+    if (success && opt.control_address.hasPort() && !control.open(opt.control_address)) {
+        success = false;
+    }
+
     // Use a Ctrl+C interrupt handler
-    ts::tsp::TSPInterruptHandler interrupt_handler(&report, input);
+    ts::tsp::TSPInterruptHandler interrupt_handler(&report, &pipelines);
     ts::UserInterrupt interrupt_manager(&interrupt_handler, true, true);
 
     // Create a monitoring thread if required.
-    ts::SystemMonitor monitor(&report);
-    if (opt.monitor) {
+    ts::SystemMonitor monitor(&report, opt.monitor_cpu_threshold);
+    if (opt.monitor && success) {
         monitor.start();
     }
 
-    // Create all plugin executors threads.
-    proc = input;
-    do {
-        proc->start();
-    } while ((proc = proc->ringNext<ts::tsp::PluginExecutor>()) != input);
-
-    // Wait for threads to terminate
-    proc = input;
-    do {
-        proc->waitForTermination();
-    } while ((proc = proc->ringNext<ts::tsp::PluginExecutor>()) != input);
-
-    // Deallocate all plugins and plugin executor
-    bool last;
-    proc = input;
-    do {
-        last = proc->ringAlone();
-        ts::tsp::PluginExecutor* next = proc->ringNext<ts::tsp::PluginExecutor>();
-        proc->ringRemove();
-        delete proc;
-        proc = next;
-    } while (!last);
-
-    return EXIT_SUCCESS;
+    // Wait for threads to terminate and deallocate all plugins and plugin executors.
+    for (size_t i = 0; i < started; ++i) {
+        if (!success) {
+            pipelines[i]->abort();
+        }
+        pipelines[i]->waitForTermination();
+    }
+    control.close();
+    for (size_t i = 0; i < pipelines.size(); ++i) {
+        delete pipelines[i];
+    }
+    for (size_t i = 0; i < pl_reports.size(); ++i) {
+        delete pl_reports[i];
+    }
+    for (size_t i = 0; i < pl_options.size(); ++i) {
+        delete pl_options[i];
+    }
+    delete pool;
+
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
 }
@@ -0,0 +1,182 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  Transport stream processor: Execution context of a branch output plugin
+//
+//----------------------------------------------------------------------------
+
+#include "tspBranchExecutor.h"
+#include "tsGuardCondition.h"
+#include "tsGuard.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// Constructor
+//----------------------------------------------------------------------------
+
+ts::tsp::BranchExecutor::BranchExecutor(Options* options,
+                                        const Options::PluginOptions* pl_options,
+                                        const ThreadAttributes& attributes,
+                                        Mutex& global_mutex) :
+
+    PluginExecutor(options, pl_options, attributes, global_mutex),
+    _output(dynamic_cast<OutputPlugin*>(_shlib)),
+    _policy(pl_options->policy),
+    _max_slice(std::max<size_t>(1, options->max_flush_pkt)),
+    _mutex(),
+    _cond(),
+    _first(0),
+    _count(0),
+    _sending(0),
+    _bitrate(0),
+    _end(false),
+    _skipped(0),
+    _runs(),
+    _dense_packets()
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Publish packets to send (invoked by the main output executor).
+//----------------------------------------------------------------------------
+
+void ts::tsp::BranchExecutor::publish(size_t pkt_first, size_t pkt_cnt, BitRate bitrate)
+{
+    GuardCondition lock(_mutex, _cond);
+    assert(_count == 0 && _sending == 0);
+    _first = pkt_first;
+    _count = pkt_cnt;
+    _bitrate = bitrate;
+    lock.signal();
+}
+
+
+//----------------------------------------------------------------------------
+// Wait until the published packets are no longer used by the branch.
+//----------------------------------------------------------------------------
+
+void ts::tsp::BranchExecutor::release()
+{
+    GuardCondition lock(_mutex, _cond);
+    if (_policy == Options::BRANCH_DROP && _count > 0) {
+        // Skip the packets which are not yet sent, only wait for the current slice.
+        _skipped += _count - TSPacketMetadata::CountDropped(_metadata->base() + _first, _count);
+        _first += _count;
+        _count = 0;
+    }
+    while (_count > 0 || _sending > 0) {
+        lock.waitCondition();
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Signal that no more packet will be published.
+//----------------------------------------------------------------------------
+
+void ts::tsp::BranchExecutor::terminate()
+{
+    GuardCondition lock(_mutex, _cond);
+    _end = true;
+    lock.signal();
+}
+
+
+//----------------------------------------------------------------------------
+// Branch output plugin thread
+//----------------------------------------------------------------------------
+
+void ts::tsp::BranchExecutor::main()
+{
+    debug(u"branch thread started");
+
+    PacketCounter output_packets = 0;
+    bool failed = false;
+
+    for (;;) {
+
+        // Wait for packets to output and take the next slice.
+        size_t pkt_first = 0;
+        size_t pkt_cnt = 0;
+        {
+            GuardCondition lock(_mutex, _cond);
+            while (_count == 0 && !_end) {
+                lock.waitCondition();
+            }
+            if (_count == 0) {
+                break;
+            }
+            pkt_first = _first;
+            pkt_cnt = std::min(_count, _max_slice);
+            _first += pkt_cnt;
+            _count -= pkt_cnt;
+            _sending = pkt_cnt;
+            _tsp_bitrate = _bitrate;
+        }
+
+        // Output the non-dropped packets, in one scatter/gather call. The packets are not modified.
+        size_t out_total = 0;
+        if (failed) {
+            _runs.clear();
+        }
+        else {
+            out_total = getOutputRuns(_runs, _dense_packets, pkt_first, pkt_cnt);
+        }
+
+        if (!_runs.empty()) {
+            startPluginCall();
+            if (!_output->sendv(_runs)) {
+                error(u"branch failed, no longer receives packets");
+                failed = true;
+            }
+            else {
+                endPluginCall(out_total);
+                output_packets += out_total;
+            }
+        }
+        addTotalPackets(pkt_cnt);
+
+        // Release the slice to the main output executor.
+        {
+            GuardCondition lock(_mutex, _cond);
+            _sending = 0;
+            lock.signal();
+        }
+    }
+
+    // Close the output processor
+    _output->stop();
+
+    if (_skipped > 0) {
+        verbose(u"branch skipped %'d packets", {_skipped});
+    }
+    debug(u"branch thread terminated after %'d packets (%'d output, %'d skipped)", {totalPackets(), output_packets, _skipped});
+}
@@ -0,0 +1,126 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Transport stream processor: Execution context of a branch output plugin
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tspPluginExecutor.h"
+
+namespace ts {
+    namespace tsp {
+        //!
+        //! Execution context of a tsp branch output plugin.
+        //!
+        //! A branch is an additional output plugin which receives the same packets
+        //! as the main output plugin. It is not part of the ring of executors.
+        //! The packets are directly read in the global packet buffer, without copy.
+        //!
+        //! The main output executor drives its branches. Each time it gets packets
+        //! to send, it publishes them to all branches (publish()) and sends them.
+        //! Then, before passing the free buffers to the input executor, it waits for
+        //! all branches to release them (release()). Each branch sends the published
+        //! packets by slices of at most -\-max-flushed-packets packets.
+        //!
+        //! With the policy BRANCH_BLOCK, release() waits until the branch has sent all
+        //! packets. With the policy BRANCH_DROP, the packets which the branch did not
+        //! start to send are skipped and release() waits only for the current slice.
+        //!
+        //! A branch which fails to send packets no longer receives packets. The rest
+        //! of the processing chain continues.
+        //!
+        class BranchExecutor: public PluginExecutor
+        {
+        public:
+            //!
+            //! Constructor.
+            //! @param [in,out] options Command line options for tsp.
+            //! @param [in] pl_options Command line options for this plugin.
+            //! @param [in] attributes Creation attributes for the thread executing this plugin.
+            //! @param [in,out] global_mutex Global mutex to synchronize access to the packet buffer.
+            //!
+            BranchExecutor(Options* options,
+                           const Options::PluginOptions* pl_options,
+                           const ThreadAttributes& attributes,
+                           Mutex& global_mutex);
+
+            //!
+            //! Access the shared library API.
+            //! Override ts::tsp::PluginExecutor::plugin() with a specialized returned class.
+            //! @return Address of the plugin interface.
+            //!
+            OutputPlugin* plugin() {return _output;}
+
+            //!
+            //! Publish packets to send. Invoked by the main output executor.
+            //! The previous packets must have been released.
+            //! @param [in] pkt_first Index of first packet to send in the buffer.
+            //! @param [in] pkt_cnt Number of packets to send.
+            //! @param [in] bitrate Current bitrate.
+            //!
+            void publish(size_t pkt_first, size_t pkt_cnt, BitRate bitrate);
+
+            //!
+            //! Wait until the published packets are no longer used by the branch.
+            //! Invoked by the main output executor, before reusing the packets.
+            //!
+            void release();
+
+            //!
+            //! Signal that no more packet will be published. Invoked by the main output executor.
+            //!
+            void terminate();
+
+        private:
+            OutputPlugin* _output;
+            const Options::BranchPolicy _policy;
+            const size_t  _max_slice;  // Maximum number of packets to send at a time.
+            Mutex         _mutex;      // Protect the following fields.
+            Condition     _cond;       // Signaled when any of the following fields is modified.
+            size_t        _first;      // Index of first published packet, not yet sent.
+            size_t        _count;      // Number of published packets, not yet sent.
+            size_t        _sending;    // Number of packets in the slice being sent.
+            BitRate       _bitrate;    // Bitrate of the published packets.
+            bool          _end;        // No more packet will be published.
+            PacketCounter _skipped;    // Number of skipped packets (BRANCH_DROP).
+            TSPacketRunVector _runs;   // Runs of non-dropped packets in the current slice.
+            std::vector<TSPacket> _dense_packets;  // Dense output area when the packet buffer has a padded stride.
+
+            // Inherited from Thread
+            virtual void main() override;
+
+            // Inaccessible operations
+            BranchExecutor() = delete;
+            BranchExecutor(const BranchExecutor&) = delete;
+            BranchExecutor& operator=(const BranchExecutor&) = delete;
+        };
+    }
+}
@@ -0,0 +1,281 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  Transport stream processor: Control server
+//
+//----------------------------------------------------------------------------
+
+#include "tspControlServer.h"
+#include "tsReportBuffer.h"
+#include "tsGuard.h"
+#include "tsSysUtils.h"
+TSDUCK_SOURCE;
+
+// Stack size for the control thread
+#define CONTROL_STACK_SIZE (128 * 1024)
+
+// Maximum size of a command line.
+#define MAX_COMMAND_SIZE 8192
+
+
+//----------------------------------------------------------------------------
+// Format the error messages of a report buffer on one line.
+//----------------------------------------------------------------------------
+
+namespace {
+    ts::UString ErrorMessages(const ts::ReportBuffer<>& errors)
+    {
+        ts::UString message(errors.getMessages());
+        message.substitute(u"Error: ", u"");
+        message.substitute(u"\n", u"; ");
+        return message;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Constructor and destructor.
+//----------------------------------------------------------------------------
+
+ts::tsp::ControlServer::ControlServer(const std::vector<Pipeline*>& pipelines, Report& report) :
+    Thread(ThreadAttributes().setPriority(ThreadAttributes::GetMinimumPriority()).setStackSize(CONTROL_STACK_SIZE).setName(u"control")),
+    _pipelines(pipelines),
+    _report(report),
+    _server(),
+    _mutex(),
+    _client(),
+    _terminate(false)
+{
+}
+
+ts::tsp::ControlServer::~ControlServer()
+{
+    close();
+}
+
+
+//----------------------------------------------------------------------------
+// Open the TCP server and start the thread.
+//----------------------------------------------------------------------------
+
+bool ts::tsp::ControlServer::open(const SocketAddress& address)
+{
+    // Writing to a disconnected client shall not kill the application.
+    IgnorePipeSignal();
+
+    if (!_server.open(_report)) {
+        return false;
+    }
+    if (!_server.reusePort(true, _report) || !_server.bind(address, _report) || !_server.listen(1, _report)) {
+        _server.close(NULLREP);
+        return false;
+    }
+
+    _report.verbose(u"tsp: control commands accepted on %s", {address.toString()});
+    return start();
+}
+
+
+//----------------------------------------------------------------------------
+// Close the server and wait for the termination of the thread.
+//----------------------------------------------------------------------------
+
+void ts::tsp::ControlServer::close()
+{
+    {
+        Guard lock(_mutex);
+        _terminate = true;
+        // Closing the server unblocks the thread in accept().
+        if (_server.isOpen()) {
+            _server.close(NULLREP);
+        }
+        // Disconnecting the client unblocks the thread in receive().
+        if (_client.isConnected()) {
+            _client.disconnect(NULLREP);
+        }
+    }
+    waitForTermination();
+}
+
+
+//----------------------------------------------------------------------------
+// Thread main code. Inherited from Thread
+//----------------------------------------------------------------------------
+
+void ts::tsp::ControlServer::main()
+{
+    for (;;) {
+        SocketAddress client_address;
+        ReportBuffer<> errors;
+        if (!_server.accept(_client, client_address, errors)) {
+            // Errors are expected when the server is closed by close().
+            Guard lock(_mutex);
+            if (!_terminate) {
+                _report.error(u"tsp: control server stopped: %s", {ErrorMessages(errors)});
+            }
+            break;
+        }
+        bool terminate = false;
+        {
+            Guard lock(_mutex);
+            terminate = _terminate;
+        }
+        if (!terminate) {
+            _report.debug(u"tsp: control connection from %s", {client_address.toString()});
+            serve();
+        }
+        Guard lock(_mutex);
+        _client.close(NULLREP);
+        if (_terminate) {
+            break;
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Serve one client connection, one command per line.
+//----------------------------------------------------------------------------
+
+void ts::tsp::ControlServer::serve()
+{
+    std::string input;
+    char buffer[1024];
+    size_t size = 0;
+
+    while (_client.receive(buffer, sizeof(buffer), size, 0, NULLREP)) {
+        input.append(buffer, size);
+        size_t eol = 0;
+        while ((eol = input.find('\n')) != std::string::npos) {
+            UString line(UString::FromUTF8(input.data(), eol));
+            input.erase(0, eol + 1);
+            line.trim();
+            if (line.empty()) {
+                continue;
+            }
+            if (line == u"exit" || line == u"quit") {
+                return;
+            }
+
+            // Execute the command and build the response.
+            ReportBuffer<> errors;
+            UStringVector output;
+            if (execute(line, output, errors)) {
+                output.push_back(u"ok");
+            }
+            else {
+                output.push_back(u"error: " + ErrorMessages(errors));
+            }
+            std::string response;
+            for (size_t i = 0; i < output.size(); ++i) {
+                response.append(output[i].toUTF8());
+                response.append(1, '\n');
+            }
+            if (!_client.send(response.data(), response.size(), NULLREP)) {
+                return;
+            }
+        }
+        if (input.size() > MAX_COMMAND_SIZE) {
+            _report.error(u"tsp: control command too long, disconnecting");
+            return;
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Execute one command.
+//----------------------------------------------------------------------------
+
+bool ts::tsp::ControlServer::execute(const UString& line, UStringVector& output, Report& report)
+{
+    UStringVector args;
+    if (!Options::SplitArguments(args, line)) {
+        report.error(u"unterminated quote");
+        return false;
+    }
+    assert(!args.empty());
+    const UString command(args[0]);
+    size_t index = 0;
+    Pipeline* pipeline = 0;
+
+    if (command == u"list" && args.size() == 1) {
+        for (size_t i = 0; i < _pipelines.size(); ++i) {
+            UStringVector lines;
+            _pipelines[i]->listPlugins(lines);
+            for (size_t n = 0; n < lines.size(); ++n) {
+                output.push_back(_pipelines[i]->name().empty() ? lines[n] : _pipelines[i]->name() + u":" + lines[n]);
+            }
+        }
+        return true;
+    }
+    else if ((command == u"set" && args.size() >= 2) || (command == u"insert" && args.size() >= 3) || (command == u"remove" && args.size() == 2)) {
+        if ((pipeline = getPlugin(args[1], index, report)) == 0) {
+            return false;
+        }
+        _report.info(u"tsp: control: %s", {line});
+        if (command == u"set") {
+            return pipeline->reconfigurePlugin(index, UStringVector(args.begin() + 2, args.end()), report);
+        }
+        else if (command == u"insert") {
+            return pipeline->insertPlugin(index, args[2], UStringVector(args.begin() + 3, args.end()), report);
+        }
+        else {
+            return pipeline->removePlugin(index, report);
+        }
+    }
+    else {
+        report.error(u"invalid command: %s", {line});
+        return false;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Get the pipeline and the index of a plugin from "[name:]index".
+//----------------------------------------------------------------------------
+
+ts::tsp::Pipeline* ts::tsp::ControlServer::getPlugin(const UString& target, size_t& index, Report& report) const
+{
+    const size_t colon = target.rfind(u':');
+    const UString name(colon == UString::NPOS ? UString() : target.substr(0, colon));
+    const UString number(colon == UString::NPOS ? target : target.substr(colon + 1));
+
+    if (!number.toInteger(index)) {
+        report.error(u"invalid plugin index \"%s\"", {number});
+        return 0;
+    }
+    for (size_t i = 0; i < _pipelines.size(); ++i) {
+        if (_pipelines[i]->name() == name) {
+            return _pipelines[i];
+        }
+    }
+    report.error(u"unknown processing chain \"%s\"", {name});
+    return 0;
+}
@@ -0,0 +1,107 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Transport stream processor: Control server
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tspPipeline.h"
+#include "tsTCPServer.h"
+#include "tsThread.h"
+#include "tsMutex.h"
+
+namespace ts {
+    namespace tsp {
+        //!
+        //! Control server of tsp (tsp option -\-control-port).
+        //!
+        //! The server accepts TCP connections, one at a time, and executes text
+        //! commands which modify the running pipelines: reconfiguration of plugins,
+        //! insertion and removal of packet processors. Each command is a line of
+        //! text. Its response is terminated by a line "ok" or "error: message".
+        //!
+        class ControlServer: public Thread
+        {
+        public:
+            //!
+            //! Constructor.
+            //! @param [in] pipelines The running pipelines. In tsp host mode, they
+            //! are designated by their name in the commands.
+            //! @param [in,out] report Where to report messages. Must be thread-safe.
+            //!
+            ControlServer(const std::vector<Pipeline*>& pipelines, Report& report);
+
+            //!
+            //! Destructor.
+            //! Close the server and wait for the termination of the thread.
+            //!
+            virtual ~ControlServer() override;
+
+            //!
+            //! Open the TCP server and start the thread.
+            //! @param [in] address Local address and port of the server.
+            //! @return True on success, false on error.
+            //!
+            bool open(const SocketAddress& address);
+
+            //!
+            //! Close the server and wait for the termination of the thread.
+            //! Must be invoked before deleting the pipelines.
+            //!
+            void close();
+
+        private:
+            const std::vector<Pipeline*> _pipelines;
+            Report&       _report;
+            TCPServer     _server;
+            Mutex         _mutex;      // Protect _client and _terminate.
+            TCPConnection _client;     // Current client connection.
+            bool          _terminate;  // The thread must terminate.
+
+            // Inherited from Thread
+            virtual void main() override;
+
+            // Serve one client connection.
+            void serve();
+
+            // Execute one command. Return false on error.
+            bool execute(const UString& line, UStringVector& output, Report& report);
+
+            // Get the pipeline and the index of a plugin from "[name:]index".
+            Pipeline* getPlugin(const UString& target, size_t& index, Report& report) const;
+
+            // Inaccessible operations
+            ControlServer() = delete;
+            ControlServer(const ControlServer&) = delete;
+            ControlServer& operator=(const ControlServer&) = delete;
+        };
+    }
+}
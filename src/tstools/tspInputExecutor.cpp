@@ -32,10 +32,13 @@
 //----------------------------------------------------------------------------
 
 #include "tspInputExecutor.h"
-#include "tsPCRAnalyzer.h"
 #include "tsTime.h"
 TSDUCK_SOURCE;
 
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::tsp::InputExecutor::FAST_START_PACKETS;
+#endif
+
 
 //----------------------------------------------------------------------------
 // Constructor
@@ -56,8 +59,40 @@ ts::tsp::InputExecutor::InputExecutor(Options* options,
     _total_in_packets(0),
     _in_sync_lost(false),
     _instuff_nullpkt_remain(0),
-    _instuff_inpkt_remain(0)
+    _instuff_inpkt_remain(0),
+    _current_time(),
+    _input_timeout(options->input_timeout),
+    _input_cc_errors(options->input_cc_errors),
+    _standby(),
+    _switch(0),
+    _fast_start(options->fast_start),
+    _estimating(false),
+    _estimate_packets(0),
+    _estimate_limit(0),
+    _pcr_analyzer(),
+    _dts_analyzer(),
+    _dense_packets(),
+    _benchmark(options->benchmark),
+    _bench_max(options->benchmark_packets),
+    _bench_duration(options->benchmark_duration),
+    _bench_packets(),
+    _bench_next(0),
+    _bench_replayed(0),
+    _bench_start(),
+    _bench_end()
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Destructor
+//----------------------------------------------------------------------------
+
+ts::tsp::InputExecutor::~InputExecutor()
 {
+    // Stop the receivers of the input switch if the thread was never started.
+    delete _switch;
+    _switch = 0;
 }
 
 
@@ -70,21 +105,51 @@ ts::tsp::InputExecutor::InputExecutor(Options* options,
 // Return true on success, false on error.
 //----------------------------------------------------------------------------
 
-bool ts::tsp::InputExecutor::initAllBuffers(PacketBuffer* buffer)
+bool ts::tsp::InputExecutor::initAllBuffers(PacketBuffer* buffer, PacketMetadataBuffer* metadata)
 {
+    // With hot standby inputs, all input plugins start receiving now.
+    if (!_standby.empty() && _switch == 0) {
+        std::vector<InputExecutor*> inputs(1, this);
+        inputs.insert(inputs.end(), _standby.begin(), _standby.end());
+        _switch = new InputSwitch(inputs, _input_timeout, _input_cc_errors);
+        if (!_switch->start()) {
+            return false;
+        }
+    }
+
+    // In benchmark mode, all packets are preloaded in memory first.
+    // Then, the buffer is loaded from the preloaded packets.
+    if (_benchmark && !preloadBenchmark()) {
+        return false;
+    }
+
     // Pre-load half of the buffer with packets from the input device.
-    const size_t pkt_read = receiveAndStuff(buffer->base(), buffer->count() / 2);
+    // In fast-start mode, only a small initial chunk is loaded.
+    const size_t pkt_init = _fast_start ? std::min(buffer->count() / 2, FAST_START_PACKETS) : buffer->count() / 2;
+    const size_t pkt_read = receiveAndStuff(buffer->base(), metadata->base(), pkt_init);
 
     if (pkt_read == 0) {
         return false; // receive error
     }
+    initMetadata(metadata->base(), pkt_read);
 
     debug(u"initial buffer load: %'d packets, %'d bytes", {pkt_read, pkt_read * PKT_SIZE});
 
     // Try to evaluate the initial input bitrate.
     // First, ask the plugin to evaluate its bitrate.
     BitRate init_bitrate = getBitrate();
-    if (init_bitrate == 0) {
+    if (init_bitrate == 0 && _fast_start) {
+        // The input device cannot evaluate a bitrate. In fast-start mode, the bitrate is
+        // evaluated incrementally, starting with the initial load, while the packets flow.
+        // Analyze at most the same number of packets as a complete initial load.
+        _estimating = true;
+        _estimate_packets = 0;
+        _estimate_limit = buffer->count() / 2;
+        _pcr_analyzer.reset(1, 32);           // 1 PID, 32 PCR's
+        _dts_analyzer.resetAndUseDTS(1, 32);  // 1 PID, 32 DTS
+        init_bitrate = estimateBitrate(buffer->base(), pkt_read);
+    }
+    else if (init_bitrate == 0) {
         // The input device cannot evaluate a bitrate.
         // Try to determine the original bitrate from PCR analysis.
         // Say we need at least 32 PCR's per PID, on at least 1 PID.
@@ -107,7 +172,10 @@ bool ts::tsp::InputExecutor::initAllBuffers(PacketBuffer* buffer)
             init_bitrate = zer.bitrate188();
         }
     }
-    if (init_bitrate == 0) {
+    if (init_bitrate == 0 && _estimating) {
+        verbose(u"input bitrate not yet known, evaluated while packets flow");
+    }
+    else if (init_bitrate == 0) {
         verbose(u"unknown input bitrate");
     }
     else {
@@ -116,16 +184,16 @@ bool ts::tsp::InputExecutor::initAllBuffers(PacketBuffer* buffer)
 
     // Indicate that the loaded packets are now available to the next packet processor.
     PluginExecutor* next = ringNext<PluginExecutor>();
-    next->initBuffer(buffer, 0, pkt_read, pkt_read == 0, pkt_read == 0, init_bitrate);
+    next->initBuffer(buffer, metadata, 0, pkt_read, pkt_read == 0, pkt_read == 0, init_bitrate);
 
     // The rest of the buffer belongs to this input processor for reading
     // additional packets. All other processors have an implicit empty buffer
     // (_pkt_first and _pkt_cnt are zero).
-    initBuffer(buffer, pkt_read % buffer->count(), buffer->count() - pkt_read, pkt_read == 0, pkt_read == 0, init_bitrate);
+    initBuffer(buffer, metadata, pkt_read % buffer->count(), buffer->count() - pkt_read, pkt_read == 0, pkt_read == 0, init_bitrate);
 
     // Propagate initial input bitrate to all processors
     while ((next = next->ringNext<PluginExecutor>()) != this) {
-        next->initBuffer(buffer, 0, 0, pkt_read == 0, pkt_read == 0, init_bitrate);
+        next->initBuffer(buffer, metadata, 0, 0, pkt_read == 0, pkt_read == 0, init_bitrate);
     }
 
     return true;
@@ -140,7 +208,7 @@ bool ts::tsp::InputExecutor::initAllBuffers(PacketBuffer* buffer)
 ts::BitRate ts::tsp::InputExecutor::getBitrate()
 {
     // Get bitrate from plugin
-    BitRate bitrate = _input_bitrate > 0 ? _input_bitrate : _input->getBitrate();
+    BitRate bitrate = _input_bitrate > 0 ? _input_bitrate : (_switch != 0 ? _switch->getBitrate() : _input->getBitrate());
 
     // Adjust to input stuffing
     if (bitrate == 0 || _instuff_inpkt == 0) {
@@ -152,22 +220,75 @@ ts::BitRate ts::tsp::InputExecutor::getBitrate()
 }
 
 
+//----------------------------------------------------------------------------
+// Incremental evaluation of the input bitrate in fast-start mode.
+// Same principle as the evaluation of the initial load: use PCR's first,
+// then DTS's when there is no PCR in the analyzed packets.
+//----------------------------------------------------------------------------
+
+ts::BitRate ts::tsp::InputExecutor::estimateBitrate(const TSPacketView& buffer, size_t count)
+{
+    // Since DTS are less accurate than PCR, do not stop on DTS before the limit.
+    bool pcr_valid = false;
+    for (size_t p = 0; !pcr_valid && p < count && _estimate_packets < _estimate_limit; ++p) {
+        pcr_valid = _pcr_analyzer.feedPacket(buffer[p]);
+        _dts_analyzer.feedPacket(buffer[p]);
+        _estimate_packets++;
+    }
+
+    BitRate bitrate = 0;
+    if (pcr_valid) {
+        bitrate = _pcr_analyzer.bitrate188();
+    }
+    else if (_estimate_packets >= _estimate_limit && _dts_analyzer.bitrateIsValid()) {
+        bitrate = _dts_analyzer.bitrate188();
+    }
+
+    // Stop the evaluation when the bitrate is known or when the limit is reached.
+    _estimating = bitrate == 0 && _estimate_packets < _estimate_limit;
+    return bitrate;
+}
+
+
 //----------------------------------------------------------------------------
 // Encapsulation of the plugin's receive() method,
 // checking the validity of the input.
 //----------------------------------------------------------------------------
 
-size_t ts::tsp::InputExecutor::receiveAndValidate(TSPacket* buffer, size_t max_packets)
+size_t ts::tsp::InputExecutor::receiveAndValidate(TSPacket* buffer, TSPacketMetadata* mdata, size_t max_packets,
+                                                  TSPacket* buffer2, TSPacketMetadata* mdata2, size_t max_packets2)
 {
     // If synchronization lost, report an error
     if (_in_sync_lost) {
         return 0;
     }
 
-    // Invoke the plugin receive method
-    size_t count = _input->receive(buffer, max_packets);
+    // Invoke the plugin receive method. Use the two-segment interface only when the
+    // free space wraps over the end of the buffer.
+    startPluginCall();
+    size_t count = max_packets2 == 0 ?
+        _input->receiveWithMetadata(buffer, mdata, max_packets) :
+        _input->receivev(buffer, mdata, max_packets, buffer2, mdata2, max_packets2);
+    endPluginCall(count);
+
+    // Validate sync byte (0x47) at beginning of each packet, in each segment.
+    if (count <= max_packets) {
+        count = validatePackets(buffer, count);
+    }
+    else {
+        const size_t count1 = validatePackets(buffer, max_packets);
+        count = count1 < max_packets ? count1 : max_packets + validatePackets(buffer2, count - max_packets);
+    }
+    return count;
+}
+
 
-    // Validate sync byte (0x47) at beginning of each packet
+//----------------------------------------------------------------------------
+// Check the sync byte of received packets.
+//----------------------------------------------------------------------------
+
+size_t ts::tsp::InputExecutor::validatePackets(const TSPacket* buffer, size_t count)
+{
     for (size_t n = 0; n < count; ++n) {
         if (buffer[n].hasValidSync()) {
             // Count good packets from plugin
@@ -188,30 +309,139 @@ size_t ts::tsp::InputExecutor::receiveAndValidate(TSPacket* buffer, size_t max_p
                       UString::Dump(buffer[n].b, dump_count * PKT_SIZE, UString::HEXA | UString::OFFSET | UString::BPL, 4, 16));
             }
             // Ignore subsequent packets
-            count = n;
             _in_sync_lost = true;
+            return n;
+        }
+    }
+    return count;
+}
+
+
+//----------------------------------------------------------------------------
+// Receive packets from the input plugin or, with hot standby inputs,
+// from the active input of the input switch.
+//----------------------------------------------------------------------------
+
+size_t ts::tsp::InputExecutor::receiveInput(TSPacketView buffer, TSPacketMetadata* mdata, size_t max_packets,
+                                            TSPacketView buffer2, TSPacketMetadata* mdata2, size_t max_packets2)
+{
+    // The input plugins use dense arrays of packets. With a padded stride in the
+    // packet buffer, receive the two segments in a dense area and copy them.
+    TSPacket* pkts = buffer.get();
+    TSPacket* pkts2 = buffer2.get();
+    if (!buffer.isDense()) {
+        if (_dense_packets.size() < max_packets + max_packets2) {
+            _dense_packets.resize(max_packets + max_packets2);
+        }
+        pkts = &_dense_packets[0];
+        pkts2 = pkts + max_packets;
+    }
+
+    // The input switch delivers packets from its FIFO's, the second segment is not used.
+    const size_t count = _switch != 0 ?
+        _switch->receive(pkts, mdata, max_packets) :
+        receiveAndValidate(pkts, mdata, max_packets, pkts2, mdata2, max_packets2);
+
+    if (!buffer.isDense()) {
+        const size_t count1 = std::min(count, max_packets);
+        buffer.copyFrom(pkts, count1);
+        buffer2.copyFrom(pkts2, count - count1);
+    }
+    return count;
+}
+
+
+//----------------------------------------------------------------------------
+// In benchmark mode, load packets from the input plugin in memory.
+// The input plugin is invoked as usual, its statistics are its own cost.
+//----------------------------------------------------------------------------
+
+bool ts::tsp::InputExecutor::preloadBenchmark()
+{
+    std::vector<TSPacket> packets(_bench_max);
+    std::vector<TSPacketMetadata> mdata(_bench_max);
+    size_t count = 0;
+
+    while (count < _bench_max) {
+        const size_t max = _max_input_pkt > 0 ? std::min(_max_input_pkt, _bench_max - count) : _bench_max - count;
+        const size_t pkt_read = receiveAndStuff(&packets[count], &mdata[count], max);
+        if (pkt_read == 0) {
+            break;
         }
+        count += pkt_read;
+    }
+    if (count == 0) {
+        error(u"no input packet to benchmark");
+        return false;
+    }
+
+    packets.resize(count);
+    _bench_packets.swap(packets);
+    _bench_next = 0;
+    _bench_start.getSystemTime();
+    _bench_end = _bench_start;
+    _bench_end += _bench_duration * NanoSecPerMilliSec;
+    verbose(u"benchmark: %'d packets loaded, replaying during %'d ms", {count, _bench_duration});
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// In benchmark mode, replay the preloaded packets in a loop. The metadata
+// of the packets are reset by the output executor in the free area of the
+// buffer, they are not replayed. Return zero at the end of the benchmark.
+//----------------------------------------------------------------------------
+
+size_t ts::tsp::InputExecutor::replayBenchmark(TSPacketView buffer, size_t max_packets, TSPacketView buffer2, size_t max_packets2)
+{
+    Monotonic now;
+    now.getSystemTime();
+    if (now >= _bench_end) {
+        return 0;
     }
 
+    size_t count = 0;
+    for (int seg = 0; seg < 2; ++seg) {
+        TSPacketView dest(seg == 0 ? buffer : buffer2);
+        size_t remain = seg == 0 ? max_packets : max_packets2;
+        while (remain > 0) {
+            const size_t n = std::min(remain, _bench_packets.size() - _bench_next);
+            dest.copyFrom(&_bench_packets[_bench_next], n);
+            dest += n;
+            remain -= n;
+            count += n;
+            _bench_next = (_bench_next + n) % _bench_packets.size();
+        }
+    }
+    _bench_replayed += count;
     return count;
 }
 
 
 //----------------------------------------------------------------------------
-// Encapsulation of receiveAndValidate() method,
+// Encapsulation of receiveInput() method,
 // taking into account the tsp input stuffing options.
 //----------------------------------------------------------------------------
 
-size_t ts::tsp::InputExecutor::receiveAndStuff(TSPacket* buffer, size_t max_packets)
+size_t ts::tsp::InputExecutor::receiveAndStuff(TSPacketView buffer, TSPacketMetadata* mdata, size_t max_packets,
+                                               TSPacketView buffer2, TSPacketMetadata* mdata2, size_t max_packets2)
 {
+    // In benchmark mode, after the preload, replay the packets from memory.
+    if (!_bench_packets.empty()) {
+        const size_t count = replayBenchmark(buffer, max_packets, buffer2, max_packets2);
+        addTotalPackets(count);
+        return count;
+    }
+
     // If there is no --add-input-stuffing option, simply call the plugin
     if (_instuff_inpkt == 0) {
-        const size_t count = receiveAndValidate(buffer, max_packets);
+        const size_t count = receiveInput(buffer, mdata, max_packets, buffer2, mdata2, max_packets2);
         addTotalPackets(count);
         return count;
     }
 
     // Otherwise, we have to alternate input packets and null packets.
+    // The second segment is not used with input stuffing.
     size_t pkt_done = 0;              // Number of packets in buffer
     size_t pkt_from_input = 0;        // Number of packets actually read from plugin
     size_t pkt_remain = max_packets;  // Remaining number of packets
@@ -220,7 +450,9 @@ size_t ts::tsp::InputExecutor::receiveAndStuff(TSPacket* buffer, size_t max_pack
 
         // Stuff null packets.
         while (_instuff_nullpkt_remain > 0 && pkt_remain > 0) {
-            *buffer++ = NullPacket;
+            *buffer = NullPacket;
+            buffer += 1;
+            mdata++;
             _instuff_nullpkt_remain--;
             pkt_remain--;
             pkt_done++;
@@ -237,13 +469,14 @@ size_t ts::tsp::InputExecutor::receiveAndStuff(TSPacket* buffer, size_t max_pack
         // Read input packets from the plugin
         max_packets = pkt_remain < _instuff_inpkt_remain ? pkt_remain : _instuff_inpkt_remain;
 
-        size_t pkt_in = receiveAndValidate(buffer, max_packets);
+        size_t pkt_in = receiveInput(buffer, mdata, max_packets);
 
         assert(pkt_in <= pkt_remain);
         assert(pkt_in <= _instuff_inpkt_remain);
         assert(pkt_in <= max_packets);
 
         buffer += pkt_in;
+        mdata += pkt_in;
         pkt_remain -= pkt_in;
         pkt_done += pkt_in;
         pkt_from_input += pkt_in;
@@ -267,6 +500,39 @@ size_t ts::tsp::InputExecutor::receiveAndStuff(TSPacket* buffer, size_t max_pack
 }
 
 
+//----------------------------------------------------------------------------
+// Initialize the metadata of received packets. The metadata of the free
+// area of the buffer are always reset by the output executor. All packets
+// from the same receive operation get the same input time stamp, unless
+// the plugin has set its own time stamps, on the real-time clock.
+//----------------------------------------------------------------------------
+
+void ts::tsp::InputExecutor::initMetadata(TSPacketMetadata* mdata, size_t count)
+{
+    if (count > 0) {
+        _current_time.getSystemTime();
+        const NanoSecond timestamp = _current_time - _time_origin;
+        NanoSecond real_time = -1;
+        for (size_t n = 0; n < count; ++n) {
+            if (!mdata[n].hasInputTimeStamp()) {
+                mdata[n].setInputTimeStamp(timestamp);
+            }
+            else {
+#if defined(TS_UNIX)
+                // Time stamp from the plugin. Convert it into a delay before the current time.
+                if (real_time < 0) {
+                    real_time = Time::UnixClockNanoSeconds(CLOCK_REALTIME);
+                }
+                mdata[n].setInputTimeStamp(timestamp - std::max<NanoSecond>(0, real_time - mdata[n].getInputTimeStamp()));
+#else
+                mdata[n].setInputTimeStamp(timestamp);
+#endif
+            }
+        }
+    }
+}
+
+
 //----------------------------------------------------------------------------
 // Input plugin thread
 //----------------------------------------------------------------------------
@@ -283,10 +549,10 @@ void ts::tsp::InputExecutor::main()
         // Wait for space in the input buffer.
         // Ignore input_end and bitrate from previous, we are the input processor.
 
-        size_t pkt_first, pkt_max;
+        size_t pkt_first, pkt_max, pkt_wrap;
         BitRate bitrate;
 
-        waitWork(pkt_first, pkt_max, bitrate, input_end, aborted);
+        waitWork(pkt_first, pkt_max, pkt_wrap, bitrate, input_end, aborted);
 
         // If the next thread has given up, give up too since our packets are now useless.
 
@@ -294,30 +560,74 @@ void ts::tsp::InputExecutor::main()
             break;
         }
 
+        // Apply a new configuration, if any, between two invocations of the plugin.
+        // We may have been woken up for this only, without free space in the buffer.
+
+        if (!applyReconfiguration()) {
+            passPackets(0, _tsp_bitrate, true, false);
+            break;
+        }
+        if (pkt_max == 0) {
+            continue;
+        }
+
+        // The free space may wrap over the end of the buffer. The second part, at the
+        // beginning of the buffer, is offered to the plugin in the same receive operation.
+
+        size_t pkt_total = pkt_max + pkt_wrap;
+
         // Do not read more packets than request by --max-input-packets
 
-        if (_max_input_pkt > 0 && pkt_max > _max_input_pkt) {
-            pkt_max = _max_input_pkt;
+        if (_max_input_pkt > 0 && pkt_total > _max_input_pkt) {
+            pkt_total = _max_input_pkt;
         }
 
+        // With a latency target, do not wait for more packets than the latency budget.
+
+        pkt_total = latencyFlushCount(pkt_total, _tsp_bitrate);
+        pkt_max = std::min(pkt_max, pkt_total);
+        pkt_wrap = pkt_total - pkt_max;
+
         // Now read at most the specified number of packets
 
-        size_t pkt_read = receiveAndStuff(_buffer->base() + pkt_first, pkt_max);
+        const size_t pkt_read = receiveAndStuff(_buffer->base() + pkt_first, _metadata->base() + pkt_first, pkt_max, _buffer->base(), _metadata->base(), pkt_wrap);
+        const size_t pkt_read1 = std::min(pkt_read, pkt_max);  // in first segment
+        const size_t pkt_read2 = pkt_read - pkt_read1;         // in second segment, after wrap-over
 
         if (pkt_read == 0) {
             input_end = true;
         }
+        initMetadata(_metadata->base() + pkt_first, pkt_read1);
+        initMetadata(_metadata->base(), pkt_read2);
+
+        // In fast-start mode, evaluate the bitrate from the received packets until it is known.
+        // The new bitrate is propagated to all plugins with the packets.
+        if (_estimating && pkt_read > 0) {
+            bitrate = estimateBitrate(_buffer->base() + pkt_first, pkt_read1);
+            if (bitrate == 0 && _estimating && pkt_read2 > 0) {
+                bitrate = estimateBitrate(_buffer->base(), pkt_read2);
+            }
+            if (bitrate > 0) {
+                _tsp_bitrate = bitrate;
+                verbose(u"input bitrate is %'d b/s, evaluated after %'d packets", {bitrate, _estimate_packets});
+            }
+            else if (!_estimating) {
+                verbose(u"unknown input bitrate");
+            }
+        }
 
         // Process periodic bitrate adjustment: get current input bitrate.
-        if (_input_bitrate == 0 && (current_time = Time::CurrentUTC()) > bitrate_due_time) {
+        // In offline mode, the bitrate comes from the initial evaluation or from the packets only.
+        if (_input_bitrate == 0 && !_tsp_offline && (current_time = Time::CurrentUTC()) > bitrate_due_time) {
             // Compute time for next bitrate adjustment. Note that we do not
             // use a monotonic time (we use current time and not due time as
             // base for next calculation).
             bitrate_due_time = current_time + _bitrate_adj;
             // Call shared library to get input bitrate
             if ((bitrate = getBitrate()) > 0) {
-                // Keep this bitrate
+                // Keep this bitrate, no need to evaluate it from the packets
                 _tsp_bitrate = bitrate;
+                _estimating = false;
                 if (debug()) {
                     debug(u"input: got bitrate %'d b/s, next try in %'d ms", {bitrate, _bitrate_adj});
                 }
@@ -329,8 +639,13 @@ void ts::tsp::InputExecutor::main()
 
     } while (!input_end);
 
-    // Close the input processor
-    _input->stop();
+    // Close the input processor, or all input processors with hot standby inputs.
+    if (_switch != 0) {
+        _switch->stop();
+    }
+    else {
+        _input->stop();
+    }
 
     debug(u"input thread %s after %'d packets", {aborted ? u"aborted" : u"terminated", totalPackets()});
 }
@@ -34,6 +34,9 @@
 
 #pragma once
 #include "tspPluginExecutor.h"
+#include "tspInputSwitch.h"
+#include "tsMonotonic.h"
+#include "tsPCRAnalyzer.h"
 
 namespace ts {
     namespace tsp {
@@ -55,6 +58,20 @@ namespace ts {
                           const ThreadAttributes& attributes,
                           Mutex& global_mutex);
 
+            //!
+            //! Destructor.
+            //!
+            virtual ~InputExecutor() override;
+
+            //!
+            //! Add a hot standby input plugin. Must be invoked on the input executor of the ring,
+            //! before initAllBuffers(). The standby input executor is not part of the ring of
+            //! executors, its thread is never started. It is only the execution context of its
+            //! plugin. See ts::tsp::InputSwitch.
+            //! @param [in] standby Execution context of the standby input plugin.
+            //!
+            void addStandby(InputExecutor* standby) {_standby.push_back(standby);}
+
             //!
             //! Initializes the packet buffer for all plugin executors, starting at this input executor.
             //!
@@ -65,11 +82,27 @@ namespace ts {
             //! Must be executed in synchronous environment, before starting all executor threads.
             //!
             //! @param [out] buffer Packet buffer address.
+            //! @param [out] metadata Packet metadata buffer address.
             //! @return True on success, false on error.
             //!
-            bool initAllBuffers(PacketBuffer* buffer);
+            bool initAllBuffers(PacketBuffer* buffer, PacketMetadataBuffer* metadata);
+
+            //!
+            //! Get the start time of the replay of the preloaded packets in benchmark mode.
+            //! @return The time when the replay started, after the packets were preloaded.
+            //!
+            const Monotonic& benchmarkStart() const {return _bench_start;}
+
+            //!
+            //! Get the number of replayed packets in benchmark mode.
+            //! @return The number of preloaded packets which were passed to the processing chain.
+            //!
+            PacketCounter benchmarkPackets() const {return _bench_replayed;}
 
         private:
+            // Size of the initial load in fast-start mode.
+            static const size_t FAST_START_PACKETS = 1000;
+
             InputPlugin*      _input;             // Plugin API
             const size_t      _instuff_nullpkt;   // Add input stuffing: add nullpkt null...
             const size_t      _instuff_inpkt;     // ... packets every inpkt input packets
@@ -80,22 +113,66 @@ namespace ts {
             bool              _in_sync_lost;      // Input synchronization lost (no 0x47 at start of packet)
             size_t            _instuff_nullpkt_remain;
             size_t            _instuff_inpkt_remain;
+            Monotonic         _current_time;      // Last input time
+            const MilliSecond _input_timeout;     // Switch to a standby input after this time without packet
+            const size_t      _input_cc_errors;   // Switch to a standby input above this number of CC errors per second
+            std::vector<InputExecutor*> _standby; // Hot standby inputs
+            InputSwitch*      _switch;            // Switch between the input plugins, when there are standby inputs
+            const bool        _fast_start;        // Start after a small initial load, evaluate bitrate while packets flow
+            bool              _estimating;        // The input bitrate is being evaluated from the packets
+            PacketCounter     _estimate_packets;  // Number of analyzed packets for the bitrate evaluation
+            PacketCounter     _estimate_limit;    // Maximum number of packets to analyze
+            PCRAnalyzer       _pcr_analyzer;      // Incremental bitrate evaluation from PCR's
+            PCRAnalyzer       _dts_analyzer;      // Incremental bitrate evaluation from DTS's
+            std::vector<TSPacket> _dense_packets; // Dense input area when the packet buffer has a padded stride
+            const bool        _benchmark;         // Benchmark mode: replay preloaded packets
+            const size_t      _bench_max;         // Max number of packets to preload in benchmark mode
+            const MilliSecond _bench_duration;    // Duration of the replay in benchmark mode
+            std::vector<TSPacket> _bench_packets; // Preloaded packets in benchmark mode
+            size_t            _bench_next;        // Index of next packet to replay in _bench_packets
+            PacketCounter     _bench_replayed;    // Number of replayed packets
+            Monotonic         _bench_start;       // Start time of the replay
+            Monotonic         _bench_end;         // End time of the replay
+
+            // The input switch invokes the input plugins.
+            friend class InputSwitch;
+
+            // Initialize the metadata of received packets.
+            void initMetadata(TSPacketMetadata* mdata, size_t count);
 
             // Inherited from Thread
             virtual void main() override;
 
-            // Encapsulation of the plugin's receive() method,
-            // checking the validity of the input.
-            size_t receiveAndValidate (TSPacket* buffer, size_t max_packets);
+            // Encapsulation of the plugin's receive() method, checking the validity of the input.
+            // The optional second segment is used when the free space wraps over the end of the buffer.
+            size_t receiveAndValidate(TSPacket* buffer, TSPacketMetadata* mdata, size_t max_packets,
+                                      TSPacket* buffer2 = 0, TSPacketMetadata* mdata2 = 0, size_t max_packets2 = 0);
+
+            // Check the sync byte of received packets, return the number of valid packets.
+            size_t validatePackets(const TSPacket* buffer, size_t count);
 
-            // Encapsulation of receiveAndValidate() method,
+            // Receive packets from the input plugin or from the active input of the input switch.
+            // With a padded stride in the packet buffer, the packets are received in a dense area first.
+            size_t receiveInput(TSPacketView buffer, TSPacketMetadata* mdata, size_t max_packets,
+                                TSPacketView buffer2 = TSPacketView(), TSPacketMetadata* mdata2 = 0, size_t max_packets2 = 0);
+
+            // In benchmark mode, load packets from the input plugin in memory before the replay.
+            bool preloadBenchmark();
+            // In benchmark mode, replay the preloaded packets until the end of the benchmark.
+            size_t replayBenchmark(TSPacketView buffer, size_t max_packets, TSPacketView buffer2, size_t max_packets2);
+            // Encapsulation of receiveInput() method,
             // taking into account the tsp input stuffing options.
-            size_t receiveAndStuff (TSPacket* buffer, size_t max_packets);
+            size_t receiveAndStuff(TSPacketView buffer, TSPacketMetadata* mdata, size_t max_packets,
+                                   TSPacketView buffer2 = TSPacketView(), TSPacketMetadata* mdata2 = 0, size_t max_packets2 = 0);
 
             // Encapsulation of the plugin's getBitrate() method,
             // taking into account the tsp input stuffing options.
             BitRate getBitrate();
 
+            // Incremental evaluation of the input bitrate in fast-start mode.
+            // Return the bitrate when it becomes known, zero otherwise.
+            BitRate estimateBitrate(const TSPacketView& buffer, size_t count);
+
             // Inaccessible operations
             InputExecutor() = delete;
             InputExecutor(const InputExecutor&) = delete;
@@ -0,0 +1,508 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  Transport stream processor: Switch between redundant input plugins
+//
+//----------------------------------------------------------------------------
+
+#include "tspInputSwitch.h"
+#include "tspInputExecutor.h"
+#include "tsGuard.h"
+#include "tsGuardCondition.h"
+#include "tsSysUtils.h"
+TSDUCK_SOURCE;
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::tsp::InputSwitch::FIFO_PACKETS;
+const size_t ts::tsp::InputSwitch::RECEIVE_PACKETS;
+const size_t ts::tsp::InputSwitch::HISTORY_PACKETS;
+#endif
+
+
+//----------------------------------------------------------------------------
+// Constructors and destructors.
+//----------------------------------------------------------------------------
+
+ts::tsp::InputSwitch::Input::Input(InputExecutor* exec) :
+    executor(exec),
+    receiver(0),
+    packets(FIFO_PACKETS),
+    mdata(FIFO_PACKETS),
+    first(0),
+    count(0),
+    ended(false),
+    receiving(false),
+    stopped(false),
+    last_time(),
+    cc_window(),
+    cc_errors(0),
+    bitrate(0),
+    bitrate_due()
+{
+    ::memset(cc, 0xFF, sizeof(cc));
+}
+
+ts::tsp::InputSwitch::Receiver::Receiver(InputSwitch* sw, size_t index) :
+    Thread(ThreadAttributes().setPriority(ThreadAttributes::GetMaximumPriority())),
+    _switch(sw),
+    _index(index)
+{
+}
+
+ts::tsp::InputSwitch::Receiver::~Receiver()
+{
+    waitForTermination();
+}
+
+ts::tsp::InputSwitch::InputSwitch(const std::vector<InputExecutor*>& inputs, MilliSecond timeout, size_t max_cc_errors) :
+    _timeout(timeout * NanoSecPerMilliSec),
+    _max_cc_errors(max_cc_errors),
+    _inputs(),
+    _mutex(),
+    _got_packets(),
+    _got_space(),
+    _started(false),
+    _terminate(false),
+    _active(0),
+    _history(),
+    _history_count(0),
+    _aligning(false),
+    _align_end(),
+    _fix(false),
+    _resync(),
+    _pcr_disc(),
+    _cc_known(),
+    _cc_out(),
+    _cc_offset()
+{
+    ::memset(_cc_out, 0xFF, sizeof(_cc_out));
+    _inputs.reserve(inputs.size());
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        _inputs.push_back(Input(inputs[i]));
+    }
+}
+
+ts::tsp::InputSwitch::~InputSwitch()
+{
+    stop();
+}
+
+
+//----------------------------------------------------------------------------
+// Start receiving packets on all inputs.
+//----------------------------------------------------------------------------
+
+bool ts::tsp::InputSwitch::start()
+{
+    Monotonic now;
+    now.getSystemTime();
+
+    for (size_t i = 0; i < _inputs.size(); ++i) {
+        _inputs[i].last_time = now;
+        _inputs[i].cc_window = now;
+        _inputs[i].bitrate_due = now;
+        _inputs[i].receiver = new Receiver(this, i);
+    }
+    _started = true;
+    for (size_t i = 0; i < _inputs.size(); ++i) {
+        if (!_inputs[i].receiver->start()) {
+            _inputs[0].executor->error(u"cannot start receiver thread for input %d (%s)", {i, _inputs[i].executor->pluginName()});
+            stop();
+            return false;
+        }
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Stop receiving packets and stop all input plugins.
+//----------------------------------------------------------------------------
+
+void ts::tsp::InputSwitch::stop()
+{
+    if (!_started) {
+        return;
+    }
+    {
+        GuardCondition lock(_mutex, _got_space);
+        _terminate = true;
+        lock.signal();
+    }
+
+    // Give the receivers a chance to complete their current receive operation.
+    bool receiving = true;
+    for (int i = 0; receiving && i < 20; ++i) {
+        receiving = false;
+        {
+            Guard lock(_mutex);
+            for (size_t n = 0; !receiving && n < _inputs.size(); ++n) {
+                receiving = _inputs[n].receiving;
+            }
+        }
+        if (receiving) {
+            SleepThread(10);
+        }
+    }
+
+    // Stopping the plugin of a receiver which is still blocked in the plugin
+    // (typically a lost input) is the only way to unblock it.
+    for (size_t n = 0; n < _inputs.size(); ++n) {
+        Input& in(_inputs[n]);
+        {
+            Guard lock(_mutex);
+            receiving = in.receiving;
+        }
+        if (receiving) {
+            in.executor->plugin()->stop();
+            in.stopped = true;
+        }
+    }
+
+    // Wait for all receivers to terminate and stop the other plugins.
+    for (size_t n = 0; n < _inputs.size(); ++n) {
+        Input& in(_inputs[n]);
+        delete in.receiver;
+        in.receiver = 0;
+        if (!in.stopped) {
+            in.executor->plugin()->stop();
+            in.stopped = true;
+        }
+    }
+    _started = false;
+}
+
+
+//----------------------------------------------------------------------------
+// Receive packets in the FIFO of an input. Executed in the receiver thread.
+//----------------------------------------------------------------------------
+
+void ts::tsp::InputSwitch::Receiver::main()
+{
+    _switch->receiverMain(_index);
+}
+
+void ts::tsp::InputSwitch::receiverMain(size_t index)
+{
+    Input& in(_inputs[index]);
+    std::vector<TSPacket> pkt(RECEIVE_PACKETS);
+    std::vector<TSPacketMetadata> mdata(RECEIVE_PACKETS);
+
+    for (;;) {
+        {
+            GuardCondition lock(_mutex, _got_space);
+            // The active input does not lose packets, wait for free space in its FIFO.
+            while (!_terminate && index == _active && !_aligning && in.count + RECEIVE_PACKETS > FIFO_PACKETS) {
+                lock.waitCondition();
+            }
+            if (_terminate) {
+                break;
+            }
+            in.receiving = true;
+        }
+
+        for (size_t n = 0; n < RECEIVE_PACKETS; ++n) {
+            mdata[n].reset();
+        }
+        const size_t count = in.executor->receiveAndValidate(&pkt[0], &mdata[0], RECEIVE_PACKETS);
+
+        // Get the plugin bitrate in the receiver thread, where the plugin is invoked.
+        Monotonic now;
+        now.getSystemTime();
+        BitRate bitrate = 0;
+        const bool get_bitrate = count > 0 && now >= in.bitrate_due;
+        if (get_bitrate) {
+            bitrate = in.executor->_input->getBitrate();
+        }
+
+        GuardCondition lock(_mutex, _got_packets);
+        in.receiving = false;
+        if (count == 0) {
+            // End of input or receive error. The active input is replaced.
+            in.ended = true;
+            lock.signal();
+            break;
+        }
+        if (get_bitrate) {
+            in.bitrate = bitrate;
+            in.bitrate_due = now;
+            in.bitrate_due += NanoSecPerSec;
+        }
+        in.last_time = now;
+
+        // Count continuity errors on one-second windows.
+        if (now - in.cc_window >= NanoSecPerSec) {
+            in.cc_window = now;
+            in.cc_errors = 0;
+        }
+        for (size_t n = 0; n < count; ++n) {
+            const PID pid = pkt[n].getPID();
+            const uint8_t cc = pkt[n].getCC();
+            const uint8_t prev = in.cc[pid];
+            if (pid != PID_NULL && prev < 16 && cc != prev && cc != ((prev + 1) & 0x0F)) {
+                in.cc_errors++;
+            }
+            in.cc[pid] = cc;
+        }
+
+        // Store the packets in the FIFO, dropping the oldest ones on overflow.
+        // The FIFO of a standby input always contains the most recent packets.
+        for (size_t n = 0; n < count; ++n) {
+            if (in.count == FIFO_PACKETS) {
+                in.first = (in.first + 1) % FIFO_PACKETS;
+                in.count--;
+            }
+            const size_t i = (in.first + in.count) % FIFO_PACKETS;
+            in.packets[i] = pkt[n];
+            in.mdata[i] = mdata[n];
+            in.count++;
+        }
+        lock.signal();
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Check the status of an input. Must be called with mutex held.
+//----------------------------------------------------------------------------
+
+bool ts::tsp::InputSwitch::ccAlarm(const Input& in, const Monotonic& now) const
+{
+    return in.cc_errors > _max_cc_errors && now - in.cc_window < NanoSecPerSec;
+}
+
+bool ts::tsp::InputSwitch::isValid(const Input& in, const Monotonic& now) const
+{
+    return !in.ended && now - in.last_time < _timeout && !ccAlarm(in, now);
+}
+
+
+//----------------------------------------------------------------------------
+// Get the bitrate of the active input plugin.
+//----------------------------------------------------------------------------
+
+ts::BitRate ts::tsp::InputSwitch::getBitrate()
+{
+    Guard lock(_mutex);
+    return _inputs[_active].bitrate;
+}
+
+
+//----------------------------------------------------------------------------
+// Receive packets from the active input.
+//----------------------------------------------------------------------------
+
+size_t ts::tsp::InputSwitch::receive(TSPacket* buffer, TSPacketMetadata* mdata, size_t max_packets)
+{
+    GuardCondition lock(_mutex, _got_packets);
+
+    for (;;) {
+        // On user interrupt, return an end of input.
+        if (_inputs[0].executor->aborting()) {
+            return 0;
+        }
+
+        Monotonic now;
+        now.getSystemTime();
+        Input& active(_inputs[_active]);
+
+        // After a switch, wait until the new input is aligned on the previous one.
+        if (_aligning && !align(now)) {
+            lock.waitCondition(std::max<MilliSecond>(1, _timeout / NanoSecPerMilliSec / 4));
+            continue;
+        }
+
+        const bool cc_alarm = ccAlarm(active, now);
+
+        // Normal case, deliver the packets of the active input.
+        if (active.count > 0 && !cc_alarm) {
+            break;
+        }
+
+        // Look for a replacement when the active input failed.
+        const bool lost = active.count == 0 && now - active.last_time >= _timeout;
+        if (cc_alarm || lost || (active.ended && active.count == 0)) {
+            size_t next = 0;
+            while (next < _inputs.size() && (next == _active || !isValid(_inputs[next], now))) {
+                ++next;
+            }
+            if (next < _inputs.size()) {
+                switchTo(next, cc_alarm ? u"continuity errors" : (active.ended ? u"end of input" : u"no packet"), now);
+                continue;
+            }
+        }
+
+        // Without replacement, keep the packets of a failing input.
+        if (active.count > 0) {
+            break;
+        }
+
+        // End of input when all inputs are terminated. The remaining packets
+        // of the standby inputs are never delivered, no switch is possible.
+        bool ended = true;
+        for (size_t i = 0; ended && i < _inputs.size(); ++i) {
+            ended = _inputs[i].ended;
+        }
+        if (ended) {
+            return 0;
+        }
+
+        // Wait for packets, periodically check the timeout.
+        lock.waitCondition(std::max<MilliSecond>(1, _timeout / NanoSecPerMilliSec / 4));
+    }
+
+    // Copy packets from the FIFO of the active input.
+    Input& active(_inputs[_active]);
+    const size_t count = std::min(max_packets, active.count);
+    for (size_t n = 0; n < count; ++n) {
+        const size_t i = (active.first + n) % FIFO_PACKETS;
+        TSPacket& pkt(buffer[n]);
+        pkt = active.packets[i];
+        mdata[n] = active.mdata[i];
+
+        // Keep the last delivered packets, as received, to align the next input.
+        _history[_history_count++ % HISTORY_PACKETS] = pkt;
+
+        // Fix the stream after a switch without alignment.
+        if (_fix) {
+            fixPacket(pkt);
+        }
+        const PID pid = pkt.getPID();
+        if (pid != PID_NULL) {
+            _cc_out[pid] = pkt.getCC();
+        }
+    }
+    active.first = (active.first + count) % FIFO_PACKETS;
+    active.count -= count;
+
+    // Signal the free space to the receiver.
+    _got_space.signal();
+    return count;
+}
+
+
+//----------------------------------------------------------------------------
+// Switch to another input. Must be called with mutex held.
+//----------------------------------------------------------------------------
+
+void ts::tsp::InputSwitch::switchTo(size_t index, const UChar* reason, const Monotonic& now)
+{
+    _inputs[0].executor->info(u"switching from input %d (%s) to input %d (%s) on %s",
+                              {_active, _inputs[_active].executor->pluginName(), index, _inputs[index].executor->pluginName(), reason});
+    _active = index;
+    _aligning = true;
+    _align_end = now;
+    _align_end += _timeout;
+}
+
+
+//----------------------------------------------------------------------------
+// Try to align the active input on the last delivered packets.
+// Must be called with mutex held.
+//----------------------------------------------------------------------------
+
+bool ts::tsp::InputSwitch::align(const Monotonic& now)
+{
+    Input& in(_inputs[_active]);
+
+    // Search the last delivered packets in the FIFO of the new input, most recent first.
+    const size_t hcount = std::min(_history_count, HISTORY_PACKETS);
+    bool aligned = hcount == 0;
+    for (size_t end = in.count; !aligned && end >= hcount; --end) {
+        aligned = true;
+        for (size_t k = 0; aligned && k < hcount; ++k) {
+            aligned = _history[(_history_count - 1 - k) % HISTORY_PACKETS] == in.packets[(in.first + end - 1 - k) % FIFO_PACKETS];
+        }
+        if (aligned) {
+            // Continue immediately after the last delivered packet.
+            in.first = (in.first + end) % FIFO_PACKETS;
+            in.count -= end;
+        }
+    }
+
+    if (aligned) {
+        if (hcount > 0) {
+            _inputs[0].executor->verbose(u"input %d (%s) aligned on previous input, seamless switch", {_active, in.executor->pluginName()});
+        }
+    }
+    else if (in.ended || now >= _align_end) {
+        // Without alignment, fix the continuity of all PID's from the first packet of the FIFO.
+        _fix = true;
+        _resync.set();
+        _resync.reset(PID_NULL);
+        _pcr_disc.set();
+        _cc_known.reset();
+        _inputs[0].executor->warning(u"input %d (%s) not aligned on previous input, fixing output stream", {_active, in.executor->pluginName()});
+    }
+    else {
+        // The new input may be late, wait for more packets.
+        return false;
+    }
+
+    // The FIFO of the new active input is no longer allowed to drop packets.
+    _aligning = false;
+    _got_space.signal();
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Fix the continuity of a delivered packet after a non-aligned switch.
+//----------------------------------------------------------------------------
+
+void ts::tsp::InputSwitch::fixPacket(TSPacket& pkt)
+{
+    const PID pid = pkt.getPID();
+    if (pid == PID_NULL) {
+        return;
+    }
+
+    // Do not splice partial PES packets or sections: drop packets until the next unit start.
+    if (_resync.test(pid) && pkt.hasPayload()) {
+        if (!pkt.getPUSI()) {
+            pkt = NullPacket;
+            return;
+        }
+        _resync.reset(pid);
+    }
+
+    // Signal the PCR discontinuity in the first PCR from the new input.
+    if (_pcr_disc.test(pid) && pkt.hasPCR()) {
+        pkt.b[5] |= 0x80;
+        _pcr_disc.reset(pid);
+    }
+
+    // Renumber continuity counters, starting after the last output one.
+    const uint8_t cc = pkt.getCC();
+    if (!_cc_known.test(pid)) {
+        _cc_offset[pid] = _cc_out[pid] < 16 ? uint8_t((_cc_out[pid] + (pkt.hasPayload() ? 1 : 0) - cc) & 0x0F) : 0;
+        _cc_known.set(pid);
+    }
+    pkt.setCC((cc + _cc_offset[pid]) & 0x0F);
+}
@@ -0,0 +1,209 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Transport stream processor: Switch between redundant input plugins
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsThread.h"
+#include "tsMutex.h"
+#include "tsCondition.h"
+#include "tsMonotonic.h"
+#include "tsTSPacket.h"
+#include "tsTSPacketMetadata.h"
+
+namespace ts {
+    namespace tsp {
+
+        class InputExecutor;
+
+        //!
+        //! Switch between redundant input plugins (hot standby).
+        //!
+        //! When several input plugins are specified, all of them receive packets
+        //! concurrently, each one in its own thread, in a private FIFO. Each input
+        //! plugin has its own InputExecutor as execution context. The first one
+        //! is the input executor in the ring of executors. It pulls the packets
+        //! from the active input through this object.
+        //!
+        //! The active input is replaced by the first valid standby input when it
+        //! receives no packet during -\-input-timeout milliseconds, when it reaches
+        //! its end of input or when it has more than -\-input-cc-errors continuity
+        //! errors in one second. The switch is not revertive: the new input remains
+        //! active until it fails.
+        //!
+        //! The FIFO of a standby input keeps the last received packets. On
+        //! switchover, the last packets which were delivered from the previous input
+        //! are searched in the FIFO of the new input. When found, the new input
+        //! continues exactly after them and the switch is seamless. When the new
+        //! input is late, the search continues on its incoming packets during at
+        //! most -\-input-timeout milliseconds. Otherwise, the output stream is
+        //! fixed: on each PID, the packets are replaced with null packets until the
+        //! next start of a PES packet or section (no partial PES packet or section
+        //! is spliced between inputs), the continuity counters are renumbered to
+        //! remain continuous and the discontinuity indicator is set in the next
+        //! packet containing a PCR.
+        //!
+        class InputSwitch
+        {
+        public:
+            //!
+            //! Constructor.
+            //! @param [in] inputs Execution contexts of all input plugins. The first one is
+            //! the primary input (the initially active input). The plugins must be started.
+            //! @param [in] timeout Switch to another input after this time without packets.
+            //! @param [in] max_cc_errors Switch to another input above this number of
+            //! continuity errors per second.
+            //!
+            InputSwitch(const std::vector<InputExecutor*>& inputs, MilliSecond timeout, size_t max_cc_errors);
+
+            //!
+            //! Destructor. Stop all input plugins if not already done.
+            //!
+            ~InputSwitch();
+
+            //!
+            //! Start receiving packets on all inputs.
+            //! @return True on success, false on error.
+            //!
+            bool start();
+
+            //!
+            //! Stop receiving packets and stop all input plugins.
+            //!
+            void stop();
+
+            //!
+            //! Receive packets from the active input.
+            //! Wait until packets are available or the active input is replaced.
+            //! @param [out] buffer Address of the buffer for incoming packets.
+            //! @param [out] mdata Address of the buffer for the metadata of incoming packets.
+            //! @param [in] max_packets Size of @a buffer in number of packets.
+            //! @return The number of actually received packets. Zero means end of input on all inputs.
+            //!
+            size_t receive(TSPacket* buffer, TSPacketMetadata* mdata, size_t max_packets);
+
+            //!
+            //! Get the bitrate of the active input plugin.
+            //! @return The bitrate of the active input or zero if unknown.
+            //!
+            BitRate getBitrate();
+
+        private:
+            // Number of packets in the FIFO of each input.
+            static const size_t FIFO_PACKETS = 10000;
+            // Maximum number of packets per receive operation.
+            static const size_t RECEIVE_PACKETS = 128;
+            // Number of last delivered packets which are used to align a standby input.
+            static const size_t HISTORY_PACKETS = 8;
+
+            // Thread receiving packets from one input plugin.
+            class Receiver: public Thread
+            {
+            public:
+                Receiver(InputSwitch* sw, size_t index);
+                virtual ~Receiver() override;
+            private:
+                InputSwitch* _switch;
+                size_t       _index;
+                virtual void main() override;
+                Receiver() = delete;
+                Receiver(const Receiver&) = delete;
+                Receiver& operator=(const Receiver&) = delete;
+            };
+
+            // State of one input.
+            class Input
+            {
+            public:
+                Input(InputExecutor* exec);
+                InputExecutor*   executor;      // Execution context of the input plugin.
+                Receiver*        receiver;      // Receiving thread.
+                std::vector<TSPacket> packets;  // Circular FIFO of received packets.
+                std::vector<TSPacketMetadata> mdata;
+                size_t           first;         // Index of first packet in FIFO.
+                size_t           count;         // Number of packets in FIFO.
+                bool             ended;         // End of input or receive error.
+                bool             receiving;     // The receiver thread is in the plugin.
+                bool             stopped;       // The plugin has been stopped.
+                Monotonic        last_time;     // Time of last received packets.
+                uint8_t          cc[PID_MAX];   // Last continuity counter per PID.
+                Monotonic        cc_window;     // Start of current one-second window.
+                size_t           cc_errors;     // Number of CC errors in current window.
+                BitRate          bitrate;       // Last bitrate from the plugin.
+                Monotonic        bitrate_due;   // Next time to get the bitrate from the plugin.
+            };
+
+            const NanoSecond   _timeout;        // Switch after this time without packets.
+            const size_t       _max_cc_errors;  // Switch above this number of CC errors per second.
+            std::vector<Input> _inputs;
+            Mutex              _mutex;          // Protect all fields below and the inputs.
+            Condition          _got_packets;    // Signaled when packets are received or an input ends.
+            Condition          _got_space;      // Signaled when packets are removed or the active input changes.
+            bool               _started;
+            bool               _terminate;      // Receivers must terminate.
+            size_t             _active;         // Index of active input.
+            TSPacket           _history[HISTORY_PACKETS];  // Last delivered input packets, circular.
+            size_t             _history_count;  // Total number of delivered packets in _history.
+            bool               _aligning;       // Searching the history in the new active input.
+            Monotonic          _align_end;      // Give up the alignment after this time.
+            bool               _fix;            // Fix the output stream since the last switch.
+            PIDSet             _resync;         // PID's waiting for a new PES or section.
+            PIDSet             _pcr_disc;       // PID's waiting for a discontinuity indicator.
+            PIDSet             _cc_known;       // PID's with a known continuity counter offset.
+            uint8_t            _cc_out[PID_MAX];     // Last output continuity counter per PID.
+            uint8_t            _cc_offset[PID_MAX];  // Continuity counter offset per PID.
+
+            // Receive packets in the FIFO of an input. Executed in the receiver thread.
+            void receiverMain(size_t index);
+
+            // Check if an input has too many continuity errors. Must be called with mutex held.
+            bool ccAlarm(const Input& in, const Monotonic& now) const;
+
+            // Check if an input is currently valid. Must be called with mutex held.
+            bool isValid(const Input& in, const Monotonic& now) const;
+
+            // Switch to another input. Must be called with mutex held.
+            void switchTo(size_t index, const UChar* reason, const Monotonic& now);
+
+            // Try to align the active input on the last delivered packets. Must be called with mutex held.
+            bool align(const Monotonic& now);
+
+            // Fix the continuity of a delivered packet after a non-aligned switch.
+            void fixPacket(TSPacket& pkt);
+
+            // Inaccessible operations
+            InputSwitch() = delete;
+            InputSwitch(const InputSwitch&) = delete;
+            InputSwitch& operator=(const InputSwitch&) = delete;
+        };
+    }
+}
@@ -34,17 +34,59 @@
 #include "tspOptions.h"
 #include "tsSysUtils.h"
 #include "tsAsyncReport.h"
+#include "tsTSPacketView.h"
 TSDUCK_SOURCE;
 
 #define DEF_BUFSIZE_MB           16  // mega-bytes
 #define DEF_BITRATE_INTERVAL      5  // seconds
 #define DEF_MAX_FLUSH_PKT     10000  // packets
+#define OFFLINE_FLUSH_DIVIDER     4  // in offline mode, flush a quarter of the buffer at a time
+#define DEF_MONITOR_INTERVAL     10  // seconds
+#define DEF_MONITOR_CPU_PERCENT  90  // percent of one CPU
+#define DEF_BENCH_PACKETS    100000  // preloaded input packets in benchmark mode
+#define DEF_BENCH_DURATION       10  // seconds
+#define DEF_METRICS_INTERVAL     10  // seconds
+#define DEF_SPIN_TIME_US         50  // microseconds
+#define DEF_INPUT_TIMEOUT       200  // milliseconds
 
 // Displayable names of plugin types.
 const ts::Enumeration ts::tsp::Options::PluginTypeNames({
     {u"input", ts::tsp::Options::INPUT},
     {u"output", ts::tsp::Options::OUTPUT},
     {u"packet processor", ts::tsp::Options::PROCESSOR},
+    {u"branch output", ts::tsp::Options::BRANCH},
+});
+
+// Names of huge page sizes, values in mega-bytes.
+const ts::Enumeration ts::tsp::Options::HugePageSizeNames({
+    {u"2mb", 2},
+    {u"1gb", 1024},
+});
+
+const ts::Enumeration ts::tsp::Options::ListProcessorsNames({
+    {u"all",   0},
+    {u"names", 1},
+});
+
+// Names of branch policies.
+const ts::Enumeration ts::tsp::Options::BranchPolicyNames({
+    {u"block", ts::tsp::Options::BRANCH_BLOCK},
+    {u"drop", ts::tsp::Options::BRANCH_DROP},
+});
+
+// Names of thread scheduling policies.
+const ts::Enumeration ts::tsp::Options::SchedulingPolicyNames({
+    {u"default", ts::ThreadAttributes::SCHEDULING_DEFAULT},
+    {u"other", ts::ThreadAttributes::SCHEDULING_OTHER},
+    {u"fifo", ts::ThreadAttributes::SCHEDULING_FIFO},
+    {u"rr", ts::ThreadAttributes::SCHEDULING_RR},
+});
+
+// Names of wait strategies.
+const ts::Enumeration ts::tsp::Options::WaitStrategyNames({
+    {u"block", ts::tsp::Options::WAIT_BLOCK},
+    {u"spin", ts::tsp::Options::WAIT_SPIN},
+    {u"poll", ts::tsp::Options::WAIT_POLL},
 });
 
 
@@ -55,34 +97,95 @@ const ts::Enumeration ts::tsp::Options::PluginTypeNames({
 ts::tsp::Options::Options(int argc, char *argv[]) :
     timed_log(false),
     list_proc(false),
+    list_names(false),
     monitor(false),
     ignore_jt(false),
     sync_log(false),
+    lock_free(false),
+    prefault(false),
     bufsize(0),
+    packet_stride(PKT_SIZE),
+    huge_page_size(0),
     log_msg_count(AsyncReport::MAX_LOG_MESSAGES),
     max_flush_pkt(0),
     max_input_pkt(0),
+    fast_start(false),
+    offline(false),
     instuff_nullpkt(0),
     instuff_inpkt(0),
+    worker_threads(1),
+    cpus(),
     bitrate(0),
     bitrate_adj(0),
+    monitor_interval(0),
+    monitor_json(false),
+    monitor_cpu_threshold(DEF_MONITOR_CPU_PERCENT),
+    benchmark(false),
+    benchmark_packets(0),
+    benchmark_duration(0),
+    benchmark_json(false),
+    metrics(false),
+    metrics_http(),
+    metrics_statsd(),
+    metrics_interval(0),
+    control_address(),
+    max_latency(0),
+    wait_strategy(WAIT_BLOCK),
+    spin_time(0),
+    input_timeout(0),
+    input_cc_errors(0),
     input(),
+    standby_inputs(),
     output(),
-    plugins()
+    plugins(),
+    branches(),
+    host_file(),
+    host_threads(0),
+    pipeline_name()
 {
     option(u"add-input-stuffing",       'a', Args::STRING);
+    option(u"benchmark",                 0);
+    option(u"benchmark-duration",        0,  Args::POSITIVE);
+    option(u"benchmark-json",            0);
+    option(u"benchmark-packets",         0,  Args::POSITIVE);
     option(u"bitrate",                  'b', Args::POSITIVE);
     option(u"bitrate-adjust-interval",   0,  Args::POSITIVE);
+    option(u"branch-policy",             0,  Args::STRING, 0, Args::UNLIMITED_COUNT);
     option(u"buffer-size-mb",            0,  Args::POSITIVE);
+    option(u"control-port",              0,  Args::STRING);
+    option(u"cpu-affinity",              0,  Args::STRING);
+    option(u"fast-start",                0);
+    option(u"fuse-processors",           0,  Args::STRING, 0, Args::UNLIMITED_COUNT);
+    option(u"host",                      0,  Args::STRING);
+    option(u"host-threads",              0,  Args::POSITIVE);
+    option(u"huge-pages",                0,  HugePageSizeNames, 0, 1, true);
     option(u"ignore-joint-termination", 'i');
-    option(u"list-processors",          'l');
+    option(u"input-cc-errors",           0,  Args::UNSIGNED);
+    option(u"input-timeout",             0,  Args::POSITIVE);
+    option(u"list-processors",          'l', ListProcessorsNames, 0, 1, true);
+    option(u"lock-free",                 0);
     option(u"log-message-count",         0,  Args::POSITIVE);
     option(u"max-flushed-packets",       0,  Args::POSITIVE);
     option(u"max-input-packets",         0,  Args::POSITIVE);
+    option(u"max-latency-ms",            0,  Args::POSITIVE);
     option(u"no-realtime-clock",         0); // was a temporary workaround, now ignored
+    option(u"offline",                   0);
+    option(u"packet-stride",             0,  Args::INTEGER, 0, 1, PKT_SIZE, 1024);
+    option(u"plugin-cpu-affinity",       0,  Args::STRING, 0, Args::UNLIMITED_COUNT);
+    option(u"plugin-scheduling",         0,  Args::STRING, 0, Args::UNLIMITED_COUNT);
+    option(u"prefault",                  0);
+    option(u"metrics-http",              0,  Args::STRING);
+    option(u"metrics-interval",          0,  Args::POSITIVE);
+    option(u"metrics-statsd",            0,  Args::STRING);
     option(u"monitor",                  'm');
+    option(u"monitor-cpu-threshold",     0,  Args::INTEGER, 0, 1, 1, 100);
+    option(u"monitor-interval",          0,  Args::POSITIVE);
+    option(u"monitor-json",              0);
+    option(u"spin-time-us",              0,  Args::POSITIVE);
     option(u"synchronous-log",          's');
     option(u"timed-log",                't');
+    option(u"wait-strategy",             0,  WaitStrategyNames);
+    option(u"worker-threads",            0,  Args::POSITIVE);
 
 #if defined(TS_WINDOWS)
 #define HELP_SHLIB    u"DLL"
@@ -106,7 +209,8 @@ ts::tsp::Options::Options(int argc, char *argv[]) :
     setSyntax(u" [tsp-options] \\\n"
               u"    [-I input-name [input-options]] \\\n"
               u"    [-P processor-name [processor-options]] ... \\\n"
-              u"    [-O output-name [output-options]]");
+              u"    [-O output-name [output-options]] \\\n"
+              u"    [-B branch-name [branch-options]] ...");
 
     setHelp(u"All tsp-options must be placed on the command line before the input,\n"
             u"processors and output specifications. The tsp-options are:\n"
@@ -134,18 +238,122 @@ ts::tsp::Options::Options(int argc, char *argv[]) :
             u"      or modulator devices use it, while file devices ignore it.\n"
             u"      This option is ignored if --bitrate is specified.\n"
             u"\n"
+            u"  --benchmark\n"
+            u"      Benchmark mode, measure the cost of each plugin in the processing chain.\n"
+            u"      The input plugin is first used to load packets in memory (see\n"
+            u"      --benchmark-packets). These packets are then replayed in a loop through\n"
+            u"      all packet processors and the output plugin, as fast as possible, during\n"
+            u"      a fixed time (see --benchmark-duration). Use the synth input plugin to\n"
+            u"      benchmark a chain on synthetic packets. At the end, the average time per\n"
+            u"      packet, the throughput and the number of memory allocations per packet\n"
+            u"      are reported for each plugin, as well as the overall throughput of the\n"
+            u"      chain. Implies --offline.\n"
+            u"\n"
+            u"  --benchmark-duration seconds\n"
+            u"      Duration of the replay of the preloaded packets in benchmark mode.\n"
+            u"      The default is " TS_USTRINGIFY(DEF_BENCH_DURATION) u" seconds. Implies --benchmark.\n"
+            u"\n"
+            u"  --benchmark-json\n"
+            u"      Report the benchmark results as one line in JSON format. Implies\n"
+            u"      --benchmark.\n"
+            u"\n"
+            u"  --benchmark-packets count\n"
+            u"      Number of input packets to load in memory before the replay in benchmark\n"
+            u"      mode. The input plugin may provide less packets if its input is shorter.\n"
+            u"      The default is " TS_USTRINGIFY(DEF_BENCH_PACKETS) u" packets. Implies --benchmark.\n"
+            u"\n"
+            u"  --branch-policy index=block|drop\n"
+            u"      Specify how the main output waits for a branch output plugin (see -B).\n"
+            u"      The index designates the branch, 1 for the first one. With \"block\"\n"
+            u"      (the default), the packets remain in the buffer until the branch has\n"
+            u"      sent them: a slow branch slows down the whole processing chain and no\n"
+            u"      packet is lost. With \"drop\", the packets which the branch did not\n"
+            u"      start to send when the main output has sent them are skipped by the\n"
+            u"      branch. Several --branch-policy options may be specified.\n"
+            u"\n"
             u"  --buffer-size-mb value\n"
             u"      Specify the buffer size in mega-bytes. This is the size of\n"
             u"      the buffer between the input and output devices. The default\n"
             u"      is " TS_USTRINGIFY(DEF_BUFSIZE_MB) u" MB.\n"
             u"\n"
+            u"  --control-port [address:]port\n"
+            u"      Accept control commands on the specified TCP port, to modify the\n"
+            u"      processing chain while it is running. When the address is not specified,\n"
+            u"      the server listens on the loopback address only. Each command is a line\n"
+            u"      of text. Its response is terminated by a line \"ok\" or \"error: message\".\n"
+            u"      The plugins are identified by their index in the processing chain,\n"
+            u"      starting at 0 for the input plugin. The commands are:\n"
+            u"        list: list the plugins with their index and options.\n"
+            u"        set index options: restart the plugin with new options, between two\n"
+            u"          packets. On error, the plugin is restarted with its previous options.\n"
+            u"        insert index name options: insert a new packet processor before the\n"
+            u"          plugin at the specified index.\n"
+            u"        remove index: remove a packet processor. The packets which were not\n"
+            u"          yet processed by the plugin are passed unmodified.\n"
+            u"        exit: close the connection.\n"
+            u"      With --host, the index is prefixed by the name of the processing chain,\n"
+            u"      as in \"name:index\". Packet processors cannot be inserted or removed\n"
+            u"      with --lock-free or with fused processors (see --fuse-processors).\n"
+            u"\n"
+            u"  --cpu-affinity cpu[-cpu][,...]\n"
+            u"      Restrict the execution of all plugin threads to the specified CPU's.\n"
+            u"      CPU's are identified by their index, starting at zero. Example:\n"
+            u"      --cpu-affinity 0,2-5. The packet buffer is allocated on the NUMA node\n"
+            u"      of the CPU's of the input plugin. This option is supported on Linux\n"
+            u"      and Windows only.\n"
+            u"\n"
             u"  -d[N]\n"
             u"  --debug[=N]\n"
             u"      Produce debug output. Specify an optional debug level N.\n"
             u"\n"
+            u"  --fast-start\n"
+            u"      Start the processing chain as soon as a small initial chunk of packets is\n"
+            u"      received. By default, tsp first loads half of the packet buffer and\n"
+            u"      evaluates the input bitrate from this initial load, which can take\n"
+            u"      seconds with a large buffer and a low input bitrate. With --fast-start,\n"
+            u"      when the input plugin cannot report its bitrate, the bitrate is evaluated\n"
+            u"      from the PCR's (or the DTS's) while the packets flow and is notified to\n"
+            u"      all plugins as soon as it is known.\n"
+            u"\n"
+            u"  --fuse-processors first-last\n"
+            u"      Execute the specified consecutive packet processors in one single thread.\n"
+            u"      Packet processors are identified by their index, starting at 1 for the\n"
+            u"      first one. The first thread processes a short slice of packets through\n"
+            u"      all plugins of the group, while the packets are still in the CPU cache,\n"
+            u"      and then processes the next slice. This avoids the synchronization and\n"
+            u"      context switches between plugins which individually use little CPU.\n"
+            u"      The CPU affinity of the group is the one of its first plugin. Several\n"
+            u"      --fuse-processors options may be specified. Example: --fuse-processors 1-4.\n"
+            u"\n"
             u"  --help\n"
             u"      Display this help text.\n"
             u"\n"
+            u"  --host file-name\n"
+            u"      Run many independent processing chains in this process. Each line of the\n"
+            u"      specified file describes one processing chain: a name, followed by the\n"
+            u"      tsp-options and plugins of this chain, as on a tsp command line. Empty\n"
+            u"      lines and lines starting with '#' are ignored. A line ending with '\\'\n"
+            u"      continues on the next line. Arguments containing spaces are enclosed in\n"
+            u"      single or double quotes. The processing chains share the log, the\n"
+            u"      plugins, the monitoring threads and a pool of threads for packet-parallel\n"
+            u"      plugins (see --worker-threads). The logging, --monitor and --metrics-*\n"
+            u"      options apply to all processing chains and must be specified on the tsp\n"
+            u"      command line, before --host. Unless --fuse-processors is specified in a\n"
+            u"      processing chain, all its packet processors run in one single thread.\n"
+            u"      Plugins cannot be specified on the command line with --host.\n"
+            u"\n"
+            u"  --host-threads value\n"
+            u"      With --host, specify the number of threads in the shared pool. By default,\n"
+            u"      use the number of CPU's in the system.\n"
+            u"\n"
+            u"  --huge-pages[=2mb|1gb]\n"
+            u"      Allocate the packet buffer using huge memory pages of the specified size.\n"
+            u"      The default size is 2mb. Explicit huge pages from the system pool are used\n"
+            u"      first. When none is available, transparent huge pages are requested. When\n"
+            u"      neither is available, tsp falls back to normal memory pages. The type of\n"
+            u"      pages which is actually used is reported in verbose mode. Huge pages reduce\n"
+            u"      the TLB pressure with large buffers. This option is supported on Linux only.\n"
+            u"\n"
             u"  -i\n"
             u"  --ignore-joint-termination\n"
             u"      Ignore all --joint-termination options in plugins.\n"
@@ -157,18 +365,41 @@ ts::tsp::Options::Options(int argc, char *argv[]) :
             u"      --ignore-joint-termination disables the termination of tsp when all\n"
             u"      plugins have reached their joint termination condition.\n"
             u"\n"
+            u"  --input-cc-errors value\n"
+            u"      With hot standby input plugins (several -I options), switch to a standby\n"
+            u"      input when the active input has more than the specified number of\n"
+            u"      continuity errors within one second. By default, continuity errors do\n"
+            u"      not trigger a switch.\n"
+            u"\n"
+            u"  --input-timeout value\n"
+            u"      With hot standby input plugins (several -I options), switch to a standby\n"
+            u"      input when the active input receives no packet during the specified\n"
+            u"      number of milliseconds. The default is " TS_USTRINGIFY(DEF_INPUT_TIMEOUT) u" ms.\n"
+            u"\n"
             u"  -l\n"
-            u"  --list-processors\n"
-            u"      List all available processors.\n"
+            u"  --list-processors[=all|names]\n"
+            u"      List all available processors. By default or with 'all', all plugin\n"
+            u"      shared libraries are loaded to display the capabilities and description\n"
+            u"      of each plugin. With 'names', only the names of the plugins are listed,\n"
+            u"      without loading any shared library.\n"
+            u"\n"
+            u"  --lock-free\n"
+            u"      Use a lock-free synchronization between plugins. By default, the\n"
+            u"      transfers of packets between plugins are protected by one single global\n"
+            u"      mutex. With this option, each boundary between two consecutive plugins\n"
+            u"      in the packet buffer is managed as an atomic cursor. The mutex is used\n"
+            u"      only when a plugin has nothing to do and must sleep. This option may\n"
+            u"      reduce the contention on long chains of plugins at high bitrates.\n"
             u"\n"
             u"  --log-message-count value\n"
             u"      Specify the maximum number of buffered log messages. Log messages are\n"
             u"      displayed asynchronously in a low priority thread. This value specifies\n"
             u"      the maximum number of buffered log messages in memory, before being\n"
             u"      displayed. When too many messages are logged in a short period of time,\n"
-            u"      while plugins use all CPU power, extra messages are dropped. Increase\n"
-            u"      this value if you think that too many messages are dropped. The default\n"
-            u"      is " + UString::Decimal(AsyncReport::MAX_LOG_MESSAGES) + u" messages.\n"
+            u"      while plugins use all CPU power, extra messages are dropped and the\n"
+            u"      number of dropped messages is reported. Increase this value if you\n"
+            u"      think that too many messages are dropped. See also --synchronous-log.\n"
+            u"      The default is " + UString::Decimal(AsyncReport::MAX_LOG_MESSAGES) + u" messages.\n"
             u"\n"
             u"  --max-flushed-packets value\n"
             u"      Specify the maximum number of packets to be processed before flushing\n"
@@ -181,11 +412,110 @@ ts::tsp::Options::Options(int argc, char *argv[]) :
             u"      the input plug-in. By default, tsp reads as many packets as it can,\n"
             u"      depending on the free space in the buffer.\n"
             u"\n"
+            u"  --max-latency-ms value\n"
+            u"      Specify a target latency in milliseconds for the transfer of packets\n"
+            u"      between plugins. The number of packets which are received, processed\n"
+            u"      or flushed at a time is adapted to the number of packets which fit in\n"
+            u"      the specified latency at the current bitrate, minus the packets which\n"
+            u"      already wait in the next plugin. The upper limit is still given by\n"
+            u"      --max-flushed-packets and --max-input-packets. When the bitrate is\n"
+            u"      unknown, this option is ignored. By default, there is no latency target.\n"
+            u"\n"
+            u"  --metrics-http [address:]port\n"
+            u"      Export the performance counters of tsp and its plugins (packets, passed,\n"
+            u"      dropped and nullified packets per plugin) using an HTTP server on the\n"
+            u"      specified local port. The counters are returned by a request on the URL\n"
+            u"      /metrics in the Prometheus text format. When the address is specified,\n"
+            u"      the server listens on this local address only.\n"
+            u"\n"
+            u"  --metrics-interval value\n"
+            u"      With --metrics-statsd, specify the interval in seconds between two\n"
+            u"      transmissions of the counters. The default is " TS_USTRINGIFY(DEF_METRICS_INTERVAL) u" seconds.\n"
+            u"\n"
+            u"  --metrics-statsd address:port\n"
+            u"      Periodically send the performance counters of tsp and its plugins to a\n"
+            u"      StatsD server over UDP. The labels of the counters are sent as tags\n"
+            u"      in the DogStatsD format.\n"
+            u"\n"
             u"  -m\n"
             u"  --monitor\n"
             u"      Continuously monitor the system resources which are used by tsp.\n"
             u"      This includes CPU load, virtual memory usage. Useful to verify the\n"
-            u"      stability of the application.\n"
+            u"      stability of the application. Execution statistics of all plugins are\n"
+            u"      also periodically reported: number of packets and invocations, ratio\n"
+            u"      of time spent in the plugin, average number of packets in the plugin's\n"
+            u"      part of the buffer, number of times the plugin waited for packets and\n"
+            u"      latency percentiles of the packets from input to output.\n"
+            u"\n"
+            u"  --monitor-cpu-threshold percent\n"
+            u"      On Linux, the CPU usage of each thread is also reported, using the\n"
+            u"      plugin names as thread names. Specify the percentage of one CPU above\n"
+            u"      which a warning is reported for a thread. The default is " TS_USTRINGIFY(DEF_MONITOR_CPU_PERCENT) u"%.\n"
+            u"      Implies --monitor.\n"
+            u"\n"
+            u"  --monitor-interval value\n"
+            u"      Specify the interval in seconds between two reports of the execution\n"
+            u"      statistics of the plugins. The default is " TS_USTRINGIFY(DEF_MONITOR_INTERVAL) u" seconds.\n"
+            u"      Implies --monitor.\n"
+            u"\n"
+            u"  --monitor-json\n"
+            u"      Report the execution statistics of the plugins as one line in JSON\n"
+            u"      format per interval. Implies --monitor.\n"
+            u"\n"
+            u"  --offline\n"
+            u"      Offline processing mode, typically from and to files. The packets are\n"
+            u"      processed as fast as possible, without relation to the wall clock. The\n"
+            u"      processing chain starts immediately (see --fast-start), the packets are\n"
+            u"      passed between plugins in large batches (a quarter of the buffer, unless\n"
+            u"      --max-flushed-packets is specified) and the input bitrate is not\n"
+            u"      periodically queried on a time basis. The plugins are notified of the\n"
+            u"      offline mode and disable their real-time pacing (regulate plugin, --timed\n"
+            u"      option in the pcap plugin, --realtime option in the synth plugin).\n"
+            u"\n"
+            u"  --packet-stride value\n"
+            u"      Specify the distance in bytes between two TS packets in the global buffer.\n"
+            u"      The default is 188, the packets are adjacent. With a larger stride, a\n"
+            u"      multiple of 64 such as 192 or 256, all packets are aligned on cache lines,\n"
+            u"      which is more efficient for the packet processors which use vector\n"
+            u"      instructions. The packets are then copied from and to adjacent packets\n"
+            u"      in the input and output plugins. The number of packets in the buffer is\n"
+            u"      unchanged (see --buffer-size-mb) but more memory is used.\n"
+            u"\n"
+            u"  --plugin-cpu-affinity index=cpu[-cpu][,...]\n"
+            u"      Restrict the execution of one plugin thread to the specified CPU's.\n"
+            u"      The index designates the plugin in the processing chain: 0 is the\n"
+            u"      input plugin, 1 is the first packet processor, etc. The last index\n"
+            u"      is the output plugin. This option overrides --cpu-affinity for the\n"
+            u"      specified plugin. Several --plugin-cpu-affinity options may be\n"
+            u"      specified. Example: --plugin-cpu-affinity 0=2,3 --plugin-cpu-affinity\n"
+            u"      2=4-6.\n"
+            u"\n"
+            u"  --plugin-scheduling index=policy[:priority]\n"
+            u"      Set the scheduling policy of one plugin thread. The index designates the\n"
+            u"      plugin in the processing chain, as in --plugin-cpu-affinity. The policy\n"
+            u"      is one of \"default\" (same as the process), \"other\" (time-sharing),\n"
+            u"      \"fifo\" or \"rr\" (real-time). The optional priority is in the range of\n"
+            u"      the policy, 1 to 99 for real-time policies on Linux. By default, the\n"
+            u"      middle of the range is used. With real-time policies, the input and\n"
+            u"      output threads are no longer preempted by the other activities of the\n"
+            u"      system. Real-time policies require privileges (root or CAP_SYS_NICE on\n"
+            u"      Linux). Without them, a warning is reported and the plugin keeps the\n"
+            u"      default scheduling. On Windows, real-time policies use the time-critical\n"
+            u"      thread priority. Several --plugin-scheduling options may be specified.\n"
+            u"      Example: --plugin-scheduling 0=fifo:80 --plugin-scheduling 3=rr.\n"
+            u"\n"
+            u"  --prefault\n"
+            u"      Prepare the process memory before starting the plugins to avoid page\n"
+            u"      faults and allocations in the first seconds of processing. The memory\n"
+            u"      of the process is locked (current and future pages, this requires\n"
+            u"      privileges or a sufficient memlock limit on UNIX systems), the stacks\n"
+            u"      of the plugin threads are touched and the pool of section buffers is\n"
+            u"      filled. Useful with real-time scheduling policies (see option\n"
+            u"      --plugin-scheduling).\n"
+            u"\n"
+            u"  --spin-time-us value\n"
+            u"      With --wait-strategy spin, specify how long a plugin thread busy-polls\n"
+            u"      for packets before blocking, in microseconds. The default is " TS_USTRINGIFY(DEF_SPIN_TIME_US) u".\n"
             u"\n"
             u"  -s\n"
             u"  --synchronous-log\n"
@@ -208,18 +538,51 @@ ts::tsp::Options::Options(int argc, char *argv[]) :
             u"  --version\n"
             u"      Display the version number.\n"
             u"\n"
+            u"  --wait-strategy block|spin|poll\n"
+            u"      Specify how a plugin thread waits for packets when it has nothing to do.\n"
+            u"      With \"block\" (the default), the thread immediately sleeps until the\n"
+            u"      previous plugin passes packets. With \"spin\", the thread first busy-polls\n"
+            u"      during --spin-time-us microseconds, then sleeps. With \"poll\", the thread\n"
+            u"      busy-polls and never sleeps: this removes the wake-up latency of each\n"
+            u"      plugin but each plugin thread uses a full CPU core. Use this only on\n"
+            u"      systems with enough CPU cores reserved for tsp, see --cpu-affinity.\n"
+            u"\n"
+            u"  --worker-threads value\n"
+            u"      Specify the number of threads which process packets in parallel in each\n"
+            u"      \"packet-parallel\" packet processor plugin. Such plugins process each packet\n"
+            u"      independently. The slices of packets are split into chunks which are\n"
+            u"      processed concurrently. The packets are always passed to the next plugin\n"
+            u"      in their original order. This option is ignored by other plugins. The\n"
+            u"      default is 1 (no parallel processing).\n"
+            u"\n"
             u"The following options activate the user-specified plug-in's.\n"
             u"\n"
             u"  -I name\n"
             u"  --input name\n"
             u"      Designate the " HELP_SHLIB u" plug-in for packet input.\n"
             u"      By default, read packets from standard input.\n"
+            u"      Several inputs may be specified for redundancy. The first one is the\n"
+            u"      primary input, the next ones are hot standby inputs. All inputs receive\n"
+            u"      packets concurrently, each one in its own thread. Only the packets from\n"
+            u"      the active input are processed. When the active input fails, tsp switches\n"
+            u"      to the first valid standby input. When the standby input carries the same\n"
+            u"      stream, the switch is seamless. Otherwise, the continuity counters, PCR\n"
+            u"      discontinuities, PES packets and sections are fixed in the output stream.\n"
+            u"      See also --input-timeout and --input-cc-errors.\n"
             u"\n"
             u"  -O name\n"
             u"  --output name\n"
             u"      Designate the " HELP_SHLIB u" plug-in for packet output.\n"
             u"      By default, write packets to standard output.\n"
             u"\n"
+            u"  -B name\n"
+            u"  --branch name\n"
+            u"      Designate an additional output " HELP_SHLIB u" plug-in which receives the\n"
+            u"      same packets as the output plug-in. Several branches are allowed. Each\n"
+            u"      branch runs in its own thread and reads the packets in the buffer, without\n"
+            u"      copy and without another tsp process. This replaces \"-P fork\" to send\n"
+            u"      the same stream to several destinations. See also --branch-policy.\n"
+            u"\n"
             u"  -P name\n"
             u"  --processor name\n"
             u"      Designate a " HELP_SHLIB u" plug-in for packet processing. Several\n"
@@ -253,15 +616,75 @@ ts::tsp::Options::Options(int argc, char *argv[]) :
 
     timed_log = present(u"timed-log");
     list_proc = present(u"list-processors");
-    monitor = present(u"monitor");
+    list_names = intValue<int>(u"list-processors", 0) != 0;
+    monitor = present(u"monitor") || present(u"monitor-interval") || present(u"monitor-json") || present(u"monitor-cpu-threshold");
+    monitor_cpu_threshold = intValue<int>(u"monitor-cpu-threshold", DEF_MONITOR_CPU_PERCENT);
+    monitor_interval = MilliSecPerSec * intValue<MilliSecond>(u"monitor-interval", DEF_MONITOR_INTERVAL);
+    monitor_json = present(u"monitor-json");
+    metrics_interval = MilliSecPerSec * intValue<MilliSecond>(u"metrics-interval", DEF_METRICS_INTERVAL);
+    metrics_http.clear();
+    metrics_statsd.clear();
+    if (present(u"metrics-http") && metrics_http.resolve(value(u"metrics-http"), *this) && !metrics_http.hasPort()) {
+        error(u"missing port number in --metrics-http");
+    }
+    if (present(u"metrics-statsd") && metrics_statsd.resolve(value(u"metrics-statsd"), *this) && (!metrics_statsd.hasAddress() || !metrics_statsd.hasPort())) {
+        error(u"missing address or port number in --metrics-statsd");
+    }
+    metrics = present(u"metrics-http") || present(u"metrics-statsd");
+    control_address.clear();
+    if (present(u"control-port") && control_address.resolve(value(u"control-port"), *this)) {
+        if (!control_address.hasPort()) {
+            error(u"missing port number in --control-port");
+        }
+        else if (!control_address.hasAddress()) {
+            control_address = SocketAddress(IPAddress::LocalHost, control_address.port());
+        }
+    }
     sync_log = present(u"synchronous-log");
+    lock_free = present(u"lock-free");
+    prefault = present(u"prefault");
     bufsize = 1024 * 1024 * intValue<size_t>(u"buffer-size-mb", DEF_BUFSIZE_MB);
+    packet_stride = intValue<size_t>(u"packet-stride", PKT_SIZE);
+    if (packet_stride != PKT_SIZE && packet_stride % TSPacketView::ALIGNMENT != 0) {
+        error(u"--packet-stride must be %d or a multiple of %d", {PKT_SIZE, TSPacketView::ALIGNMENT});
+    }
+    huge_page_size = present(u"huge-pages") ? 1024 * 1024 * intValue<size_t>(u"huge-pages", 2) : 0;
     bitrate = intValue<BitRate>(u"bitrate", 0);
     bitrate_adj = MilliSecPerSec * intValue(u"bitrate-adjust-interval", DEF_BITRATE_INTERVAL);
     max_flush_pkt = intValue<size_t>(u"max-flushed-packets", DEF_MAX_FLUSH_PKT);
     max_input_pkt = intValue<size_t>(u"max-input-packets", 0);
+    fast_start = present(u"fast-start");
+    max_latency = intValue<MilliSecond>(u"max-latency-ms", 0);
+    benchmark = present(u"benchmark") || present(u"benchmark-duration") || present(u"benchmark-json") || present(u"benchmark-packets");
+    benchmark_packets = intValue<size_t>(u"benchmark-packets", DEF_BENCH_PACKETS);
+    benchmark_duration = MilliSecPerSec * intValue<MilliSecond>(u"benchmark-duration", DEF_BENCH_DURATION);
+    benchmark_json = present(u"benchmark-json");
+    offline = benchmark || present(u"offline");
+    if (offline) {
+        // No wait for an initial bitrate evaluation, large batches between plugins.
+        fast_start = true;
+        if (!present(u"max-flushed-packets")) {
+            max_flush_pkt = std::max<size_t>(DEF_MAX_FLUSH_PKT, bufsize / packet_stride / OFFLINE_FLUSH_DIVIDER);
+        }
+        if (max_latency > 0) {
+            error(u"--max-latency-ms and --offline or --benchmark are mutually exclusive");
+        }
+    }
+    worker_threads = intValue<size_t>(u"worker-threads", 1);
+    wait_strategy = enumValue<WaitStrategy>(u"wait-strategy", WAIT_BLOCK);
+    spin_time = intValue<MicroSecond>(u"spin-time-us", DEF_SPIN_TIME_US);
+    input_timeout = intValue<MilliSecond>(u"input-timeout", DEF_INPUT_TIMEOUT);
+    input_cc_errors = intValue<size_t>(u"input-cc-errors", std::numeric_limits<size_t>::max());
     log_msg_count = intValue<size_t>(u"log-message-count", AsyncReport::MAX_LOG_MESSAGES);
     ignore_jt = present(u"ignore-joint-termination");
+    host_file = value(u"host");
+    host_threads = intValue<size_t>(u"host-threads", 0);
+    if (!host_file.empty() && plugin_index < argc) {
+        error(u"plugins cannot be specified with --host");
+    }
+    if (present(u"cpu-affinity") && !DecodeCPUList(cpus, value(u"cpu-affinity"))) {
+        error(u"invalid --cpu-affinity specification \"%s\"", {value(u"cpu-affinity")});
+    }
 
     if (present(u"add-input-stuffing")) {
         UString stuff(value(u"add-input-stuffing"));
@@ -280,6 +703,7 @@ ts::tsp::Options::Options(int argc, char *argv[]) :
     input.type = INPUT;
     input.name = u"file";
     input.args.clear();
+    standby_inputs.clear();
 
     // The default output is the standard output file.
 
@@ -313,11 +737,15 @@ ts::tsp::Options::Options(int argc, char *argv[]) :
                 opt = &plugins[plugins.size() - 1];
                 break;
             case INPUT:
+                // The next input plugins are hot standby inputs.
                 if (got_input) {
-                    error(u"do not specify more than one input plugin");
+                    standby_inputs.resize(standby_inputs.size() + 1);
+                    opt = &standby_inputs[standby_inputs.size() - 1];
+                }
+                else {
+                    opt = &input;
                 }
                 got_input = true;
-                opt = &input;
                 break;
             case OUTPUT:
                 if (got_output) {
@@ -326,6 +754,10 @@ ts::tsp::Options::Options(int argc, char *argv[]) :
                 got_output = true;
                 opt = &output;
                 break;
+            case BRANCH:
+                branches.resize(branches.size() + 1);
+                opt = &branches[branches.size() - 1];
+                break;
             default:
                 // Should not get there
                 assert(false);
@@ -336,6 +768,12 @@ ts::tsp::Options::Options(int argc, char *argv[]) :
         UString::Assign(opt->args, plugin_index - start - 2, argv + start + 2);
     }
 
+    // Get CPU affinity of individual plugins, now that all plugins are known.
+    getPluginCPUAffinity();
+    getFusedProcessors();
+    getBranchPolicies();
+    getPluginScheduling();
+
     // Debug display
     if (maxSeverity() >= 2) {
         display(std::cerr);
@@ -366,11 +804,199 @@ int ts::tsp::Options::nextProcOpt(int argc, char *argv[], int index, PluginType&
             type = PROCESSOR;
             return index;
         }
+        if (arg == "-B" || arg == "--branch") {
+            type = BRANCH;
+            return index;
+        }
     }
     return std::min(argc, index);
 }
 
 
+//----------------------------------------------------------------------------
+// Decode the per-plugin CPU affinity options.
+//----------------------------------------------------------------------------
+
+void ts::tsp::Options::getPluginCPUAffinity()
+{
+    // All plugins use the global CPU affinity by default.
+    input.cpus = cpus;
+    output.cpus = cpus;
+    for (size_t i = 0; i < plugins.size(); ++i) {
+        plugins[i].cpus = cpus;
+    }
+    for (size_t i = 0; i < branches.size(); ++i) {
+        branches[i].cpus = cpus;
+    }
+    for (size_t i = 0; i < standby_inputs.size(); ++i) {
+        standby_inputs[i].cpus = cpus;
+    }
+
+    // Then apply individual options.
+    const size_t max_index = plugins.size() + 1;
+    for (size_t n = 0; n < count(u"plugin-cpu-affinity"); ++n) {
+        const UString spec(value(u"plugin-cpu-affinity", u"", n));
+        const size_t equal = spec.find(u'=');
+        size_t index = 0;
+        CPUSet plcpus;
+        if (equal == UString::NPOS || !spec.substr(0, equal).toInteger(index) || index > max_index || !DecodeCPUList(plcpus, spec.substr(equal + 1))) {
+            error(u"invalid --plugin-cpu-affinity specification \"%s\"", {spec});
+        }
+        else if (index == 0) {
+            input.cpus = plcpus;
+        }
+        else if (index == max_index) {
+            output.cpus = plcpus;
+        }
+        else {
+            plugins[index - 1].cpus = plcpus;
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Decode the groups of fused packet processors, in the form "first-last".
+//----------------------------------------------------------------------------
+
+void ts::tsp::Options::getFusedProcessors()
+{
+    for (size_t n = 0; n < count(u"fuse-processors"); ++n) {
+        const UString spec(value(u"fuse-processors", u"", n));
+        const size_t dash = spec.find(u'-');
+        size_t first = 0;
+        size_t last = 0;
+        if (dash == UString::NPOS || !spec.substr(0, dash).toInteger(first) || !spec.substr(dash + 1).toInteger(last) || first == 0 || first > last || last > plugins.size()) {
+            error(u"invalid --fuse-processors specification \"%s\"", {spec});
+        }
+        else {
+            // All processors of the group, except the first one, are fused with their previous one.
+            for (size_t index = first + 1; index <= last; ++index) {
+                plugins[index - 1].fused = true;
+            }
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Decode the policies of the branch output plugins, in the form "index=policy".
+//----------------------------------------------------------------------------
+
+void ts::tsp::Options::getBranchPolicies()
+{
+    for (size_t n = 0; n < count(u"branch-policy"); ++n) {
+        const UString spec(value(u"branch-policy", u"", n));
+        const size_t equal = spec.find(u'=');
+        size_t index = 0;
+        const int policy = equal == UString::NPOS ? Enumeration::UNKNOWN : BranchPolicyNames.value(spec.substr(equal + 1), false);
+        if (policy == Enumeration::UNKNOWN || !spec.substr(0, equal).toInteger(index) || index == 0 || index > branches.size()) {
+            error(u"invalid --branch-policy specification \"%s\"", {spec});
+        }
+        else {
+            branches[index - 1].policy = BranchPolicy(policy);
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Decode the per-plugin scheduling policies, in the form "index=policy[:priority]".
+//----------------------------------------------------------------------------
+
+void ts::tsp::Options::getPluginScheduling()
+{
+    const size_t max_index = plugins.size() + 1;
+    for (size_t n = 0; n < count(u"plugin-scheduling"); ++n) {
+        const UString spec(value(u"plugin-scheduling", u"", n));
+        const size_t equal = spec.find(u'=');
+        const size_t colon = spec.find(u':');
+        size_t index = 0;
+        int priority = 0;
+        const int policy = equal == UString::NPOS ? Enumeration::UNKNOWN : SchedulingPolicyNames.value(spec.substr(equal + 1, colon == UString::NPOS ? UString::NPOS : colon - equal - 1), false);
+        if (policy == Enumeration::UNKNOWN || !spec.substr(0, equal).toInteger(index) || index > max_index ||
+            (colon != UString::NPOS && (colon < equal || !spec.substr(colon + 1).toInteger(priority) || priority < 0)))
+        {
+            error(u"invalid --plugin-scheduling specification \"%s\"", {spec});
+        }
+        else {
+            PluginOptions& opt(index == 0 ? input : (index == max_index ? output : plugins[index - 1]));
+            opt.sched_policy = ThreadAttributes::SchedulingPolicy(policy);
+            opt.sched_priority = priority;
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Decode a list of CPU's, in the form "cpu[-cpu][,...]".
+//----------------------------------------------------------------------------
+
+bool ts::tsp::Options::DecodeCPUList(CPUSet& cpus, const UString& list)
+{
+    cpus.clear();
+    UStringVector ranges;
+    list.split(ranges, u',');
+    for (UStringVector::const_iterator it = ranges.begin(); it != ranges.end(); ++it) {
+        const size_t dash = it->find(u'-');
+        size_t first = 0;
+        size_t last = 0;
+        if (dash == UString::NPOS) {
+            if (!it->toInteger(first)) {
+                return false;
+            }
+            last = first;
+        }
+        else if (!it->substr(0, dash).toInteger(first) || !it->substr(dash + 1).toInteger(last) || first > last) {
+            return false;
+        }
+        for (size_t cpu = first; cpu <= last; ++cpu) {
+            cpus.insert(cpu);
+        }
+    }
+    return !cpus.empty();
+}
+
+
+//----------------------------------------------------------------------------
+// Split a line of text into command line arguments.
+//----------------------------------------------------------------------------
+
+bool ts::tsp::Options::SplitArguments(UStringVector& args, const UString& line)
+{
+    args.clear();
+    UString arg;
+    bool in_arg = false;
+    UChar quote = 0;
+
+    for (size_t i = 0; i < line.size(); ++i) {
+        const UChar c = line[i];
+        if (quote != 0 && c == quote) {
+            quote = 0;
+        }
+        else if (quote == 0 && (c == u'"' || c == u'\'')) {
+            quote = c;
+            in_arg = true;
+        }
+        else if (quote == 0 && IsSpace(c)) {
+            if (in_arg) {
+                args.push_back(arg);
+                arg.clear();
+                in_arg = false;
+            }
+        }
+        else {
+            arg.push_back(c);
+            in_arg = true;
+        }
+    }
+    if (in_arg) {
+        args.push_back(arg);
+    }
+    return quote == 0;
+}
+
+
 //----------------------------------------------------------------------------
 // Display the content of the object to a stream
 //----------------------------------------------------------------------------
@@ -381,24 +1007,60 @@ std::ostream& ts::tsp::Options::display(std::ostream& strm, int indent) const
     strm << margin << "* tsp options:" << std::endl
          << margin << "  --add-input-stuffing: " << UString::Decimal(instuff_nullpkt)
          << "/" << UString::Decimal(instuff_inpkt) << std::endl
+         << margin << "  --benchmark: " << benchmark << std::endl
+         << margin << "  --benchmark-duration: " << UString::Decimal(benchmark_duration) << " milliseconds" << std::endl
+         << margin << "  --benchmark-json: " << benchmark_json << std::endl
+         << margin << "  --benchmark-packets: " << UString::Decimal(benchmark_packets) << std::endl
          << margin << "  --bitrate: " << UString::Decimal(bitrate) << " b/s" << std::endl
          << margin << "  --bitrate-adjust-interval: " << UString::Decimal(bitrate_adj) << " milliseconds" << std::endl
          << margin << "  --buffer-size-mb: " << UString::Decimal(bufsize) << " bytes" << std::endl
+         << margin << "  --control-port: " << control_address.toString() << std::endl
+         << margin << "  --cpu-affinity: " << cpus.size() << " CPU's" << std::endl
          << margin << "  --debug: " << maxSeverity() << std::endl
+         << margin << "  --fast-start: " << fast_start << std::endl
+         << margin << "  --host: " << host_file << std::endl
+         << margin << "  --host-threads: " << UString::Decimal(host_threads) << std::endl
+         << margin << "  --huge-pages: " << UString::Decimal(huge_page_size) << " bytes" << std::endl
+         << margin << "  --input-cc-errors: " << UString::Decimal(input_cc_errors) << std::endl
+         << margin << "  --input-timeout: " << UString::Decimal(input_timeout) << " milliseconds" << std::endl
          << margin << "  --list-processors: " << list_proc << std::endl
+         << margin << "  --list-processors=names: " << list_names << std::endl
+         << margin << "  --lock-free: " << lock_free << std::endl
          << margin << "  --max-flushed-packets: " << UString::Decimal(max_flush_pkt) << std::endl
          << margin << "  --max-input-packets: " << UString::Decimal(max_input_pkt) << std::endl
+         << margin << "  --max-latency-ms: " << UString::Decimal(max_latency) << " milliseconds" << std::endl
+         << margin << "  --offline: " << offline << std::endl
+         << margin << "  --packet-stride: " << UString::Decimal(packet_stride) << " bytes" << std::endl
          << margin << "  --monitor: " << monitor << std::endl
+         << margin << "  --prefault: " << prefault << std::endl
+         << margin << "  --monitor-interval: " << UString::Decimal(monitor_interval) << " milliseconds" << std::endl
+         << margin << "  --monitor-json: " << monitor_json << std::endl
+         << margin << "  --monitor-cpu-threshold: " << monitor_cpu_threshold << "%" << std::endl
+         << margin << "  --metrics-http: " << metrics_http.toString() << std::endl
+         << margin << "  --metrics-statsd: " << metrics_statsd.toString() << std::endl
+         << margin << "  --metrics-interval: " << UString::Decimal(metrics_interval) << " milliseconds" << std::endl
+         << margin << "  --spin-time-us: " << UString::Decimal(spin_time) << " microseconds" << std::endl
          << margin << "  --verbose: " << verbose() << std::endl
+         << margin << "  --wait-strategy: " << WaitStrategyNames.name(wait_strategy) << std::endl
+         << margin << "  --worker-threads: " << UString::Decimal(worker_threads) << std::endl
          << margin << "  Number of packet processors: " << plugins.size() << std::endl
+         << margin << "  Number of branch output plugins: " << branches.size() << std::endl
          << margin << "  Input plugin:" << std::endl;
     input.display(strm, indent + 4);
+    for (size_t i = 0; i < standby_inputs.size(); ++i) {
+        strm << margin << "  Standby input plugin " << (i+1) << ":" << std::endl;
+        standby_inputs[i].display(strm, indent + 4);
+    }
     for (size_t i = 0; i < plugins.size(); ++i) {
         strm << margin << "  Packet processor plugin " << (i+1) << ":" << std::endl;
         plugins[i].display(strm, indent + 4);
     }
     strm << margin << "  Output plugin:" << std::endl;
     output.display(strm, indent + 4);
+    for (size_t i = 0; i < branches.size(); ++i) {
+        strm << margin << "  Branch output plugin " << (i+1) << ":" << std::endl;
+        branches[i].display(strm, indent + 4);
+    }
     return strm;
 }
 
@@ -410,7 +1072,12 @@ std::ostream& ts::tsp::Options::display(std::ostream& strm, int indent) const
 ts::tsp::Options::PluginOptions::PluginOptions() :
     type(PROCESSOR),
     name(),
-    args()
+    args(),
+    cpus(),
+    fused(false),
+    policy(BRANCH_BLOCK),
+    sched_policy(ThreadAttributes::SCHEDULING_DEFAULT),
+    sched_priority(0)
 {
 }
 
@@ -427,5 +1094,17 @@ std::ostream& ts::tsp::Options::PluginOptions::display(std::ostream& strm, int i
     for (size_t i = 0; i < args.size(); ++i) {
         strm << margin << "Arg[" << i << "]: \"" << args[i] << "\"" << std::endl;
     }
+    for (CPUSet::const_iterator it = cpus.begin(); it != cpus.end(); ++it) {
+        strm << margin << "CPU: " << *it << std::endl;
+    }
+    if (fused) {
+        strm << margin << "Fused with previous processor" << std::endl;
+    }
+    if (type == BRANCH) {
+        strm << margin << "Branch policy: " << BranchPolicyNames.name(policy) << std::endl;
+    }
+    if (sched_policy != ThreadAttributes::SCHEDULING_DEFAULT) {
+        strm << margin << "Scheduling: " << SchedulingPolicyNames.name(sched_policy) << ", priority " << sched_priority << std::endl;
+    }
     return strm;
 }
@@ -34,6 +34,8 @@
 
 #pragma once
 #include "tsArgs.h"
+#include "tsThreadAttributes.h"
+#include "tsSocketAddress.h"
 
 namespace ts {
     //!
@@ -59,7 +61,8 @@ namespace ts {
             enum PluginType {
                 INPUT,     //!< Input plugin.
                 OUTPUT,    //!< Output plugin.
-                PROCESSOR  //!< Packet processor plugin.
+                PROCESSOR, //!< Packet processor plugin.
+                BRANCH     //!< Branch output plugin, receives the same packets as the output plugin.
             };
 
             //!
@@ -67,6 +70,48 @@ namespace ts {
             //!
             static const Enumeration PluginTypeNames;
 
+            //!
+            //! Names of huge memory page sizes (values in mega-bytes).
+            //!
+            static const Enumeration HugePageSizeNames;
+
+            //!
+            //! Names of the --list-processors modes.
+            //!
+            static const Enumeration ListProcessorsNames;
+
+            //!
+            //! Strategies of a plugin thread which waits for packets.
+            //!
+            enum WaitStrategy {
+                WAIT_BLOCK,  //!< Immediately block on a condition variable.
+                WAIT_SPIN,   //!< Busy-poll during a short time, then block.
+                WAIT_POLL    //!< Always busy-poll, never block.
+            };
+
+            //!
+            //! Names of wait strategies.
+            //!
+            static const Enumeration WaitStrategyNames;
+
+            //!
+            //! Policies of a branch output plugin which is slower than the main output.
+            //!
+            enum BranchPolicy {
+                BRANCH_BLOCK,  //!< The main output waits for the branch, no packet is lost.
+                BRANCH_DROP    //!< The branch skips the packets it had no time to send.
+            };
+
+            //!
+            //! Names of branch policies.
+            //!
+            static const Enumeration BranchPolicyNames;
+
+            //!
+            //! Names of thread scheduling policies.
+            //!
+            static const Enumeration SchedulingPolicyNames;
+
             //!
             //! Class containing the options for one plugin.
             //!
@@ -75,6 +120,11 @@ namespace ts {
                 PluginType    type;  //!< Plugin type.
                 UString       name;  //!< Plugin name.
                 UStringVector args;  //!< Plugin options.
+                CPUSet        cpus;  //!< CPU affinity of the plugin thread (empty means any CPU).
+                bool          fused; //!< Packet processor executed in the thread of the previous packet processor.
+                BranchPolicy  policy; //!< Branch output plugin policy when it is slower than the main output.
+                ThreadAttributes::SchedulingPolicy sched_policy; //!< Scheduling policy of the plugin thread.
+                int           sched_priority; //!< Priority in the scheduling policy, zero for the middle of the range.
 
                 //!
                 //! Default constructor.
@@ -98,20 +148,51 @@ namespace ts {
             // Option values
             bool          timed_log;       //!< Add time stamps in log messages.
             bool          list_proc;       //!< List processors.
+            bool          list_names;      //!< List plugin names only, without loading them.
             bool          monitor;         //!< Run a resource monitoring thread.
             bool          ignore_jt;       //!< Ignore "joint termination" options in plugins.
             bool          sync_log;        //!< Synchronous log.
+            bool          lock_free;       //!< Use lock-free synchronization of the packet buffer.
+            bool          prefault;        //!< Lock and prefault the memory before starting, avoid jitter at startup.
             size_t        bufsize;         //!< Buffer size.
+            size_t        packet_stride;   //!< Distance in bytes between two packets in the buffer.
+            size_t        huge_page_size;  //!< Size of huge memory pages for the buffer (zero means normal pages).
             size_t        log_msg_count;   //!< Maximum buffered log messages.
             size_t        max_flush_pkt;   //!< Max processed packets before flush.
             size_t        max_input_pkt;   //!< Max packets per input operation.
+            bool          fast_start;      //!< Start after a small initial input, evaluate the bitrate later.
+            bool          offline;         //!< Offline processing, no real-time constraint.
             size_t        instuff_nullpkt; //!< Add input stuffing: add @a nullpkt null packets every @a inpkt input packets.
             size_t        instuff_inpkt;   //!< Add input stuffing: add @a nullpkt null packets every @a inpkt input packets.
+            size_t        worker_threads;  //!< Number of threads in packet-parallel processor plugins.
+            CPUSet        cpus;            //!< Default CPU affinity of all plugin threads.
             BitRate       bitrate;         //!< Fixed input bitrate.
             MilliSecond   bitrate_adj;     //!< Bitrate adjust interval.
+            MilliSecond   monitor_interval; //!< Interval between two reports of plugin statistics.
+            bool          monitor_json;    //!< Report plugin statistics in JSON format.
+            int           monitor_cpu_threshold; //!< Warn when a thread uses more than this percentage of one CPU.
+            bool          benchmark;       //!< Benchmark mode: replay preloaded input packets at maximum speed.
+            size_t        benchmark_packets; //!< Number of input packets to preload in benchmark mode.
+            MilliSecond   benchmark_duration; //!< Duration of the replay in benchmark mode.
+            bool          benchmark_json;  //!< Report benchmark results in JSON format.
+            bool          metrics;         //!< Export performance counters.
+            SocketAddress metrics_http;    //!< Local address of the HTTP server for Prometheus metrics.
+            SocketAddress metrics_statsd;  //!< Address of the StatsD server.
+            MilliSecond   metrics_interval; //!< Interval between two transmissions to the StatsD server.
+            SocketAddress control_address; //!< Local address of the control server, no port if none.
+            MilliSecond   max_latency;     //!< Target latency between plugins, zero if none.
+            WaitStrategy  wait_strategy;   //!< How a plugin thread waits for packets.
+            MicroSecond   spin_time;       //!< Busy-poll duration before blocking with WAIT_SPIN.
+            MilliSecond   input_timeout;   //!< Switch to a standby input after this time without packet.
+            size_t        input_cc_errors; //!< Switch to a standby input above this number of continuity errors per second.
             PluginOptions input;           //!< Input plugin.
+            PluginOptionsVector standby_inputs; //!< List of hot standby input plugins.
             PluginOptions output;          //!< Output plugin.
             PluginOptionsVector plugins;   //!< List of packet processor plugins.
+            PluginOptionsVector branches;  //!< List of branch output plugins.
+            UString       host_file;       //!< Configuration file of the pipelines in host mode (empty otherwise).
+            size_t        host_threads;    //!< Number of threads in the shared thread pool in host mode.
+            UString       pipeline_name;   //!< Name of this pipeline in host mode (empty otherwise).
 
             //!
             //! Display the content of this object to a stream.
@@ -121,6 +202,16 @@ namespace ts {
             //!
             std::ostream& display(std::ostream& strm, int indent = 0) const;
 
+            //!
+            //! Split a line of text into command line arguments.
+            //! The arguments are separated by spaces. Single or double quotes
+            //! group characters, including spaces, into one argument.
+            //! @param [out] args Decoded arguments.
+            //! @param [in] line Line of text.
+            //! @return True on success, false if a quote is not terminated.
+            //!
+            static bool SplitArguments(UStringVector& args, const UString& line);
+
         private:
             Options() = delete;
             Options(const Options&) = delete;
@@ -135,6 +226,38 @@ namespace ts {
             //! @return Index of plugin option or @a argc if not found.
             //!
             static int nextProcOpt(int argc, char *argv[], int index, PluginType& type);
+
+            //!
+            //! Decode the per-plugin CPU affinity options.
+            //! Must be called after locating all plugins.
+            //!
+            void getPluginCPUAffinity();
+
+            //!
+            //! Decode the groups of fused packet processors.
+            //! Must be called after locating all plugins.
+            //!
+            void getFusedProcessors();
+
+            //!
+            //! Decode the policies of the branch output plugins.
+            //! Must be called after locating all plugins.
+            //!
+            void getBranchPolicies();
+
+            //!
+            //! Decode the per-plugin scheduling policies.
+            //! Must be called after locating all plugins.
+            //!
+            void getPluginScheduling();
+
+            //!
+            //! Decode a list of CPU's.
+            //! @param [out] cpus Decoded set of CPU indexes.
+            //! @param [in] list List of CPU's, in the form "cpu[-cpu][,...]".
+            //! @return True on success, false on error.
+            //!
+            static bool DecodeCPUList(CPUSet& cpus, const UString& list);
         };
     }
 }
@@ -45,11 +45,48 @@ ts::tsp::OutputExecutor::OutputExecutor(Options* options,
                                         Mutex& global_mutex) :
 
     PluginExecutor(options, pl_options, attributes, global_mutex),
-    _output(dynamic_cast<OutputPlugin*>(_shlib))
+    _output(dynamic_cast<OutputPlugin*>(_shlib)),
+    _branches(),
+    _runs(),
+    _dense_packets()
 {
 }
 
 
+//----------------------------------------------------------------------------
+// Record the input to output latency of sent packets. Packets from the same
+// receive operation have the same input time stamp and are counted at once.
+//----------------------------------------------------------------------------
+
+void ts::tsp::OutputExecutor::recordLatency(const TSPacketMetadata* mdata, size_t count, const Monotonic& origin)
+{
+    const NanoSecond now = _call_end - origin;
+    size_t n = 0;
+
+    while (n < count) {
+
+        // Locate a sequence of packets with the same input time stamp.
+        const NanoSecond stamp = mdata[n].getInputTimeStamp();
+        size_t end = n + 1;
+        while (end < count && mdata[end].getInputTimeStamp() == stamp) {
+            end++;
+        }
+
+        // Latency bucket i is [2^i, 2^(i+1)[ microseconds.
+        if (mdata[n].hasInputTimeStamp()) {
+            uint64_t us = uint64_t(std::max<NanoSecond>(0, now - stamp) / NanoSecPerMicroSec);
+            size_t bucket = 0;
+            while (us > 1 && bucket < LATENCY_BUCKETS - 1) {
+                us >>= 1;
+                bucket++;
+            }
+            _stats.latency[bucket] += end - n;
+        }
+        n = end;
+    }
+}
+
+
 //----------------------------------------------------------------------------
 // Output plugin thread
 //----------------------------------------------------------------------------
@@ -61,6 +98,9 @@ void ts::tsp::OutputExecutor::main()
     PacketCounter output_packets = 0;
     bool aborted;
 
+    // The input time stamps of the packets are relative to the time origin of the input executor.
+    const Monotonic& origin(_time_origin);
+
     do {
         // Wait for packets to output
         size_t pkt_first, pkt_cnt;
@@ -77,6 +117,13 @@ void ts::tsp::OutputExecutor::main()
             break;
         }
 
+        // Apply a new configuration, if any, between two invocations of the plugin.
+        if (!applyReconfiguration()) {
+            passPackets(0, 0, false, true);
+            aborted = true;
+            break;
+        }
+
         // Check if "joint termination" agreed on a last packet to output
         const PacketCounter jt_limit = totalPacketsBeforeJointTermination();
         if (totalPackets() + pkt_cnt > jt_limit) {
@@ -84,38 +131,47 @@ void ts::tsp::OutputExecutor::main()
             aborted = true;
         }
 
-        // Output the packets. Output may be segmented if dropped packets
-        // (ie. starting with a zero byte) are in the middle of the buffer.
-
-        TSPacket* pkt = _buffer->base() + pkt_first;
-        size_t pkt_remain = pkt_cnt;
-
-        while (pkt_remain > 0) {
-
-            // Skip dropped packets
-            size_t drop_cnt;
-            for (drop_cnt = 0; drop_cnt < pkt_remain && pkt[drop_cnt].b[0] == 0; drop_cnt++) {}
-
-            pkt += drop_cnt;
-            pkt_remain -= drop_cnt;
-            addTotalPackets (drop_cnt);
+        // The branches send the same packets in parallel.
+        for (size_t i = 0; i < _branches.size(); ++i) {
+            _branches[i]->publish(pkt_first, pkt_cnt, _tsp_bitrate);
+        }
 
-            // Find last non-dropped packet
-            size_t out_cnt;
-            for (out_cnt = 0; out_cnt < pkt_remain && pkt[out_cnt].b[0] != 0; out_cnt++) {}
+        // Output the packets. Dropped packets may be in the middle of the buffer.
+        // All runs of non-dropped packets are passed to the output plugin at once,
+        // in one scatter/gather call.
+        const size_t out_total = getOutputRuns(_runs, _dense_packets, pkt_first, pkt_cnt);
 
-            // Output a contiguous range of non-dropped packets.
-            if (out_cnt > 0) {
-                if (!_output->send (pkt, out_cnt)) {
-                    aborted = true;
-                    break;
+        // Output all runs of non-dropped packets.
+        if (!_runs.empty()) {
+            startPluginCall();
+            if (!_output->sendv(_runs)) {
+                aborted = true;
+            }
+            else {
+                endPluginCall(out_total);
+                if (_instrument) {
+                    for (size_t i = 0; i < _runs.size(); ++i) {
+                        recordLatency(_runs[i].metadata, _runs[i].count, origin);
+                    }
                 }
-                pkt += out_cnt;
-                pkt_remain -= out_cnt;
-                output_packets += out_cnt;
-                addTotalPackets (out_cnt);
+                output_packets += out_total;
             }
         }
+        if (!aborted) {
+            addTotalPackets(pkt_cnt);
+        }
+
+        // Wait until the branches no longer use the packets.
+        for (size_t i = 0; i < _branches.size(); ++i) {
+            _branches[i]->release();
+        }
+
+        // The metadata of the free area of the buffer are always reset.
+        // So, the input processor receives new packets with reset metadata.
+        TSPacketMetadata* free_mdata = _metadata->base() + pkt_first;
+        for (size_t n = 0; n < pkt_cnt; ++n) {
+            free_mdata[n].reset();
+        }
 
         // Pass free buffers to input processor.
         // Do not transmit bitrate to next (since next is input processor).
@@ -123,8 +179,11 @@ void ts::tsp::OutputExecutor::main()
 
     } while (!aborted);
 
-    // Close the output processor
+    // Close the output processor and let the branches terminate.
     _output->stop();
+    for (size_t i = 0; i < _branches.size(); ++i) {
+        _branches[i]->terminate();
+    }
 
     debug(u"output thread %s after %'d packets (%'d output)", {aborted ? u"aborted" : u"terminated", totalPackets(), output_packets});
 }
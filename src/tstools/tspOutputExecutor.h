@@ -34,6 +34,7 @@
 
 #pragma once
 #include "tspPluginExecutor.h"
+#include "tspBranchExecutor.h"
 
 namespace ts {
     namespace tsp {
@@ -62,8 +63,21 @@ namespace ts {
             //!
             OutputPlugin* plugin() {return _output;}
 
+            //!
+            //! Add a branch output plugin which receives the same packets as this output plugin.
+            //! Must be invoked before starting the executor threads.
+            //! @param [in] branch The branch executor. It is not owned by this object.
+            //!
+            void addBranch(BranchExecutor* branch) {_branches.push_back(branch);}
+
         private:
             OutputPlugin* _output;
+            std::vector<BranchExecutor*> _branches;
+            TSPacketRunVector _runs;  // Runs of non-dropped packets in the current window.
+            std::vector<TSPacket> _dense_packets;  // Dense output area when the packet buffer has a padded stride.
+
+            // Record the input to output latency of sent packets (instrumentation).
+            void recordLatency(const TSPacketMetadata* mdata, size_t count, const Monotonic& origin);
 
             // Inherited from Thread
             virtual void main() override;
@@ -0,0 +1,138 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Transport stream processor: Global buffer of TS packets
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsResidentBuffer.h"
+#include "tsTSPacketView.h"
+
+namespace ts {
+    namespace tsp {
+        //!
+        //! Global memory-resident buffer of TS packets, shared by all plugin executors.
+        //!
+        //! The packets are stored with a fixed stride. With the default stride of 188 bytes,
+        //! the buffer has the layout of an array of ts::TSPacket and the packets can be
+        //! directly passed to input and output plugins. With a padded stride, multiple of
+        //! the size of a cache line, all packets are aligned on cache lines and the packets
+        //! are copied from and to dense arrays in input and output operations.
+        //!
+        //! In all cases, the packets are accessed through views (ts::TSPacketView).
+        //!
+        class PacketBuffer
+        {
+        public:
+            //!
+            //! Constructor.
+            //! @param [in] count Number of packets in the buffer.
+            //! @param [in] stride Distance in bytes between two packets in the buffer.
+            //! @param [in] huge_page_size If non-zero, try to back the buffer with huge pages of this size.
+            //! @see ResidentBuffer
+            //!
+            PacketBuffer(size_t count, size_t stride = PKT_SIZE, size_t huge_page_size = 0);
+
+            //!
+            //! Get a view on the first packet of the buffer.
+            //! @return A view on the first packet of the buffer.
+            //!
+            TSPacketView base() const
+            {
+                return TSPacketView(_buffer.base(), _stride);
+            }
+
+            //!
+            //! Get the number of packets in the buffer.
+            //! @return The number of packets in the buffer.
+            //!
+            size_t count() const
+            {
+                return _count;
+            }
+
+            //!
+            //! Get the distance in bytes between two packets in the buffer.
+            //! @return The distance in bytes between two packets in the buffer.
+            //!
+            size_t stride() const
+            {
+                return _stride;
+            }
+
+            //!
+            //! Check if the packets are adjacent in the buffer, as in an array of ts::TSPacket.
+            //! @return True if the stride is PKT_SIZE.
+            //!
+            bool isDense() const
+            {
+                return _stride == PKT_SIZE;
+            }
+
+            //!
+            //! Check if the buffer is actually locked in physical memory.
+            //! @return True if the buffer is actually locked, false if locking failed.
+            //!
+            bool isLocked() const
+            {
+                return _buffer.isLocked();
+            }
+
+            //!
+            //! Get error code when not locked
+            //! @return The system error code when locking failed.
+            //!
+            ErrorCode lockErrorCode() const
+            {
+                return _buffer.lockErrorCode();
+            }
+
+            //!
+            //! Get the type of memory pages which are used by the buffer.
+            //! @return The type of memory pages.
+            //!
+            ResidentBuffer<>::PageMode pageMode() const
+            {
+                return _buffer.pageMode();
+            }
+
+        private:
+            const size_t     _count;  // Number of packets.
+            const size_t     _stride; // Distance between two packets.
+            ResidentBuffer<> _buffer; // Resident memory.
+
+            // Inaccessible operations.
+            PacketBuffer() = delete;
+            PacketBuffer(const PacketBuffer&) = delete;
+            PacketBuffer& operator=(const PacketBuffer&) = delete;
+        };
+    }
+}
@@ -0,0 +1,562 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  Transport stream processor: A complete chain of plugin executors
+//
+//----------------------------------------------------------------------------
+
+#include "tspPipeline.h"
+#include "tspProcessorExecutor.h"
+#include "tsGuard.h"
+#include "tsSysUtils.h"
+TSDUCK_SOURCE;
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const ts::MilliSecond ts::tsp::Pipeline::RECONFIGURE_TIMEOUT;
+#endif
+
+
+//----------------------------------------------------------------------------
+// Constructor: load all plugins and analyze their command line arguments.
+//----------------------------------------------------------------------------
+
+ts::tsp::Pipeline::Pipeline(Options* options, ThreadPool* pool) :
+    _options(options),
+    _pool(pool),
+    _report(0),
+    _global_mutex(),
+    _executors(),
+    _inserted(),
+    _ended(false),
+    _input(0),
+    _standby(),
+    _output(0),
+    _branches(),
+    _signalization(0),
+    _monitor(0),
+    _packet_buffer(0),
+    _metadata_buffer(0)
+{
+    // The first plugin is always the input and the last one is the output.
+    // The input thread has the highest priority to be always ready to load
+    // incoming packets in the buffer (avoid missing packets). The output
+    // plugin has a hight priority to make room in the buffer, but not as
+    // high as the input which must remain the top-most priority?
+
+    _input = new InputExecutor(options, &options->input, ThreadAttributes().setPriority(ThreadAttributes::GetMaximumPriority()), _global_mutex);
+    _output = new OutputExecutor(options, &options->output, ThreadAttributes().setPriority(ThreadAttributes::GetHighPriority()), _global_mutex);
+    _output->ringInsertAfter(_input);
+    _executors.push_back(_input);
+    _executors.push_back(_output);
+
+    for (Options::PluginOptionsVector::const_iterator it = options->plugins.begin(); it != options->plugins.end(); ++it) {
+        PluginExecutor* p = new ProcessorExecutor(options, &*it, ThreadAttributes(), _global_mutex, pool);
+        p->ringInsertBefore(_output);
+        _executors.push_back(p);
+    }
+
+    // The hot standby input plugins are not in the ring, they are driven by the input executor.
+    for (Options::PluginOptionsVector::const_iterator it = options->standby_inputs.begin(); it != options->standby_inputs.end(); ++it) {
+        InputExecutor* in = new InputExecutor(options, &*it, ThreadAttributes().setPriority(ThreadAttributes::GetMaximumPriority()), _global_mutex);
+        _standby.push_back(in);
+        _input->addStandby(in);
+    }
+
+    // The branch output plugins are not in the ring, they are driven by the output executor.
+    for (Options::PluginOptionsVector::const_iterator it = options->branches.begin(); it != options->branches.end(); ++it) {
+        BranchExecutor* b = new BranchExecutor(options, &*it, ThreadAttributes().setPriority(ThreadAttributes::GetHighPriority()), _global_mutex);
+        _branches.push_back(b);
+        _output->addBranch(b);
+    }
+
+    // All executors use the time origin of the input executor for the input time stamps.
+    for (size_t i = 0; i < _executors.size(); ++i) {
+        _executors[i]->setTimeOrigin(_input->timeOrigin());
+    }
+    for (size_t i = 0; i < _standby.size(); ++i) {
+        _standby[i]->setTimeOrigin(_input->timeOrigin());
+    }
+    for (size_t i = 0; i < _branches.size(); ++i) {
+        _branches[i]->setTimeOrigin(_input->timeOrigin());
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Destructor: deallocate all plugins and plugin executors.
+//----------------------------------------------------------------------------
+
+ts::tsp::Pipeline::~Pipeline()
+{
+    // Some executors may have been removed from the ring at run time.
+    for (size_t i = 0; i < _executors.size(); ++i) {
+        _executors[i]->ringRemove();
+        delete _executors[i];
+    }
+
+    // Deleted after the input executor which uses them.
+    for (size_t i = 0; i < _standby.size(); ++i) {
+        delete _standby[i];
+    }
+
+    for (size_t i = 0; i < _branches.size(); ++i) {
+        delete _branches[i];
+    }
+
+    delete _monitor;
+    delete _signalization;
+    delete _metadata_buffer;
+    delete _packet_buffer;
+}
+
+
+//----------------------------------------------------------------------------
+// Start the plugins and the executor threads.
+//----------------------------------------------------------------------------
+
+bool ts::tsp::Pipeline::start(Report& report)
+{
+    _report = &report;
+
+    // The shared signalization service of all packet processors.
+    _signalization = new SignalizationService(report);
+
+    // Set the logger as report method for all executors.
+    PluginExecutor* proc = _input;
+    size_t position = 0;
+    do {
+        proc->setReport(&report);
+        proc->setMaxSeverity(report.maxSeverity());
+        proc->setSignalization(_signalization, position++);
+        if (_options->metrics) {
+            proc->registerMetrics();
+        }
+    } while ((proc = proc->ringNext<PluginExecutor>()) != _input);
+    for (size_t i = 0; i < _standby.size(); ++i) {
+        _standby[i]->setReport(&report);
+        _standby[i]->setMaxSeverity(report.maxSeverity());
+    }
+    for (size_t i = 0; i < _branches.size(); ++i) {
+        _branches[i]->setReport(&report);
+        _branches[i]->setMaxSeverity(report.maxSeverity());
+    }
+
+    // When the input thread is bound to some CPU's, allocate the packet buffers
+    // on the NUMA node of these CPU's. The memory pages are physically allocated
+    // when the buffers are locked by the current thread ("first touch" policy).
+    // The previous affinity is restored after the allocation since all threads
+    // which are created later by the current thread would inherit it.
+    CPUSet main_cpus;
+    if (!_options->input.cpus.empty() && !Thread::SetCurrentThreadAffinity(_options->input.cpus, &main_cpus)) {
+        report.verbose(u"tsp: cannot set the CPU affinity of the main thread, the buffer may not be on the NUMA node of the input thread");
+    }
+
+    // Allocate a memory-resident buffer of TS packets
+    _packet_buffer = new PacketBuffer(_options->bufsize / PKT_SIZE, _options->packet_stride, _options->huge_page_size);
+    if (_options->huge_page_size > 0) {
+        switch (_packet_buffer->pageMode()) {
+            case ResidentBuffer<>::HUGETLB_PAGES:
+                report.verbose(u"tsp: buffer allocated using explicit huge pages (%'d bytes)", {_options->huge_page_size});
+                break;
+            case ResidentBuffer<>::TRANSPARENT_HUGE_PAGES:
+                report.verbose(u"tsp: buffer allocated using transparent huge pages (%'d bytes)", {_options->huge_page_size});
+                break;
+            case ResidentBuffer<>::NORMAL_PAGES:
+            default:
+                report.verbose(u"tsp: huge pages not available, buffer allocated using normal pages");
+                break;
+        }
+    }
+    if (!_packet_buffer->isLocked()) {
+        report.verbose(u"tsp: buffer failed to lock into physical memory (%d: %s), risk of real-time issue",
+                       {_packet_buffer->lockErrorCode(), ErrorCodeMessage(_packet_buffer->lockErrorCode())});
+    }
+    report.debug(u"tsp: buffer size: %'d TS packets, %'d bytes", {_packet_buffer->count(), _packet_buffer->count() * _packet_buffer->stride()});
+
+    // Allocate a memory-resident buffer of packet metadata, parallel to the packet buffer.
+    _metadata_buffer = new ResidentBuffer<TSPacketMetadata>(_packet_buffer->count());
+
+    // Restore the CPU affinity of the main thread.
+    if (!main_cpus.empty() && !Thread::SetCurrentThreadAffinity(main_cpus)) {
+        report.warning(u"tsp: cannot restore the CPU affinity of the main thread");
+    }
+
+    // Start all processors, except output, in reverse order (input last).
+    for (proc = _output->ringPrevious<PluginExecutor>(); proc != _output; proc = proc->ringPrevious<PluginExecutor>()) {
+        if (!proc->plugin()->start()) {
+            return false;
+        }
+    }
+
+    // Start the hot standby inputs. They receive packets when the input executor starts its input switch.
+    for (size_t i = 0; i < _standby.size(); ++i) {
+        if (!_standby[i]->plugin()->start()) {
+            return false;
+        }
+    }
+
+    // All subscribers to the shared signalization are now known.
+    _signalization->prepare();
+
+    // Initialize packet buffer in the ring of executors.
+    if (!_input->initAllBuffers(_packet_buffer, _metadata_buffer)) {
+        return false;
+    }
+
+    // Start the output device (we now have an idea of the bitrate).
+    if (!_output->plugin()->start()) {
+        return false;
+    }
+    for (size_t i = 0; i < _branches.size(); ++i) {
+        _branches[i]->initBuffer(_packet_buffer, _metadata_buffer, 0, 0, false, false, _output->bitrate());
+        if (!_branches[i]->plugin()->start()) {
+            return false;
+        }
+    }
+
+    // Create a monitoring thread for the plugin executors if required.
+    if (_options->monitor) {
+        _monitor = new PluginMonitor(_options, &report, _input);
+        _monitor->start();
+    }
+
+    // Create all plugin executors threads.
+    // Fused packet processors run in the thread of the first processor of their group.
+    proc = _input;
+    do {
+        if (!proc->isFused()) {
+            proc->startThread();
+        }
+    } while ((proc = proc->ringNext<PluginExecutor>()) != _input);
+    for (size_t i = 0; i < _branches.size(); ++i) {
+        _branches[i]->startThread();
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Wait for the termination of all executor threads.
+//----------------------------------------------------------------------------
+
+void ts::tsp::Pipeline::waitForTermination()
+{
+    // Packet processors may be inserted until all executors are terminated.
+    for (size_t i = 0; ; ++i) {
+        PluginExecutor* proc = 0;
+        {
+            Guard lock(_global_mutex);
+            if (i >= _executors.size()) {
+                _ended = true;
+                break;
+            }
+            proc = _executors[i];
+        }
+        proc->waitForTermination();
+    }
+    for (size_t i = 0; i < _branches.size(); ++i) {
+        _branches[i]->waitForTermination();
+    }
+
+    // Produce the last plugin statistics before deallocating the executors.
+    if (_monitor != 0) {
+        _monitor->stop();
+    }
+    if (_options->benchmark && _report != 0) {
+        Monotonic end;
+        end.getSystemTime();
+        reportBenchmark(end);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Format the ratio of two integers with two decimals.
+//----------------------------------------------------------------------------
+
+ts::UString ts::tsp::Pipeline::Hundredths(uint64_t value, uint64_t total)
+{
+    const uint64_t hundredths = total == 0 ? 0 : (100 * value + total / 2) / total;
+    return UString::Format(u"%d.%02d", {hundredths / 100, hundredths % 100});
+}
+
+
+//----------------------------------------------------------------------------
+// Report the cost of each plugin at the end of a benchmark. The statistics
+// of the input plugin cover the preload of the packets, the statistics of
+// the other plugins cover the replay. The overall throughput is the number
+// of replayed packets, until the termination of all plugins.
+//----------------------------------------------------------------------------
+
+void ts::tsp::Pipeline::reportBenchmark(const Monotonic& end)
+{
+    const NanoSecond duration = std::max<NanoSecond>(1, end - _input->benchmarkStart());
+    const PacketCounter total = _input->benchmarkPackets();
+    const uint64_t total_rate = (total * NanoSecPerSec) / duration;
+    const uint64_t total_bitrate = total_rate * PKT_SIZE * 8;
+    UString json(UString::Format(u"{\"benchmark\": {\"duration-ns\": %d, \"packets\": %d, \"packets-per-second\": %d, \"bitrate\": %d}, \"plugins\": [",
+                                 {duration, total, total_rate, total_bitrate}));
+
+    size_t index = 0;
+    PluginExecutor* proc = _input;
+    do {
+        const PluginExecutor::Statistics& stats(proc->statistics());
+        const PacketCounter packets = stats.packets;
+        const NanoSecond plugin_time = stats.plugin_time;
+        const uint64_t allocations = stats.allocations;
+        const UString ns_per_packet(Hundredths(uint64_t(plugin_time), packets));
+        const uint64_t rate = plugin_time <= 0 ? 0 : (packets * NanoSecPerSec) / uint64_t(plugin_time);
+        const UString allocs_per_packet(Hundredths(allocations, packets));
+        const UString type(proc == _input ? u"input" : (proc == _output ? u"output" : u"processor"));
+
+        if (_options->benchmark_json) {
+            json += UString::Format(u"%s{\"index\": %d, \"name\": \"%s\", \"type\": \"%s\", \"packets\": %d, \"calls\": %d, \"plugin-time-ns\": %d, \"ns-per-packet\": %s, \"packets-per-second\": %d, \"allocations\": %d, \"allocations-per-packet\": %s}",
+                                    {index == 0 ? u"" : u", ", index, proc->pluginName().toJSON(), type, packets, uint64_t(stats.calls), plugin_time, ns_per_packet, rate, allocations, allocs_per_packet});
+        }
+        else {
+            _report->info(u"benchmark: %d: %s (%s): %'d packets, %s ns/packet, %'d packets/s, %s allocations/packet",
+                          {index, proc->pluginName(), type, packets, ns_per_packet, rate, allocs_per_packet});
+        }
+        index++;
+    } while ((proc = proc->ringNext<PluginExecutor>()) != _input);
+
+    if (_options->benchmark_json) {
+        json += u"]}";
+        _report->info(json);
+    }
+    else {
+        _report->info(u"benchmark: total: %'d packets in %'d ms, %'d packets/s, %'d b/s",
+                      {total, duration / NanoSecPerMilliSec, total_rate, total_bitrate});
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Abort the processing.
+//----------------------------------------------------------------------------
+
+void ts::tsp::Pipeline::abort()
+{
+    // Place all threads in "aborted" state so that each thread will see its
+    // successor as aborted. Notify all threads that something happened.
+    // The global mutex is recursive, the ring cannot change while we walk it.
+
+    Guard lock(_global_mutex);
+    PluginExecutor* proc = _input;
+    do {
+        proc->setAbort();
+    } while ((proc = proc->ringNext<PluginExecutor>()) != _input);
+
+    // The plugins of the hot standby inputs check their own abort state.
+    for (size_t i = 0; i < _standby.size(); ++i) {
+        _standby[i]->setAbort();
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Get the executor at some index in the ring, under the global mutex.
+//----------------------------------------------------------------------------
+
+ts::tsp::PluginExecutor* ts::tsp::Pipeline::executorAt(size_t index) const
+{
+    PluginExecutor* proc = _input;
+    for (size_t i = 0; i < index; ++i) {
+        proc = proc->ringNext<PluginExecutor>();
+        if (proc == _input) {
+            return 0;
+        }
+    }
+    return proc;
+}
+
+
+//----------------------------------------------------------------------------
+// List the plugins of the running pipeline.
+//----------------------------------------------------------------------------
+
+void ts::tsp::Pipeline::listPlugins(UStringVector& lines)
+{
+    lines.clear();
+    Guard lock(_global_mutex);
+    PluginExecutor* proc = _input;
+    do {
+        const UChar* const type = proc == _input ? u"-I" : (proc == _output ? u"-O" : u"-P");
+        UString line(UString::Format(u"%d: %s %s", {lines.size(), type, proc->pluginName()}));
+        const UStringVector& args(proc->pluginArgs());
+        for (size_t i = 0; i < args.size(); ++i) {
+            line.append(u' ');
+            line.append(args[i]);
+        }
+        lines.push_back(line);
+    } while ((proc = proc->ringNext<PluginExecutor>()) != _input);
+}
+
+
+//----------------------------------------------------------------------------
+// Reconfigure a plugin of the running pipeline.
+//----------------------------------------------------------------------------
+
+bool ts::tsp::Pipeline::reconfigurePlugin(size_t index, const UStringVector& args, Report& report)
+{
+    PluginExecutor* proc = 0;
+    {
+        Guard lock(_global_mutex);
+        proc = _ended ? 0 : executorAt(index);
+    }
+    if (proc == 0) {
+        report.error(u"no plugin at index %d", {index});
+        return false;
+    }
+    if (proc == _input && !_standby.empty()) {
+        // The input plugins are invoked by the threads of the input switch.
+        report.error(u"the input plugin cannot be reconfigured with hot standby inputs");
+        return false;
+    }
+    return proc->reconfigure(args, RECONFIGURE_TIMEOUT, report);
+}
+
+
+//----------------------------------------------------------------------------
+// Check if packet processors can be inserted or removed.
+//----------------------------------------------------------------------------
+
+bool ts::tsp::Pipeline::checkRingChange(Report& report)
+{
+    if (_options->lock_free) {
+        report.error(u"packet processors cannot be inserted or removed with --lock-free");
+        return false;
+    }
+    Guard lock(_global_mutex);
+    PluginExecutor* proc = _input;
+    do {
+        if (proc->isFused()) {
+            report.error(u"packet processors cannot be inserted or removed with fused processors");
+            return false;
+        }
+    } while ((proc = proc->ringNext<PluginExecutor>()) != _input);
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Insert a packet processor in the running pipeline.
+//----------------------------------------------------------------------------
+
+bool ts::tsp::Pipeline::insertPlugin(size_t index, const UString& name, const UStringVector& args, Report& report)
+{
+    if (_report == 0 || !checkRingChange(report)) {
+        return false;
+    }
+
+    // Load the plugin and analyze its arguments. Errors are reported to the caller.
+    _inserted.push_back(Options::PluginOptions());
+    Options::PluginOptions& pl_options(_inserted.back());
+    pl_options.type = Options::PROCESSOR;
+    pl_options.name = name;
+    pl_options.args = args;
+    pl_options.cpus = _options->cpus;
+
+    ProcessorExecutor* proc = new ProcessorExecutor(_options, &pl_options, ThreadAttributes(), _global_mutex, _pool, &report);
+    if (proc->plugin() == 0 || !proc->plugin()->valid()) {
+        delete proc;
+        return false;
+    }
+
+    // The new plugin does not use the shared signalization: its packet slots
+    // are not synchronized with the other plugins.
+    proc->setReport(_report);
+    proc->setMaxSeverity(_report->maxSeverity());
+    proc->setSignalization(0, index);
+    proc->setTimeOrigin(_input->timeOrigin());
+    if (_options->metrics) {
+        proc->registerMetrics();
+    }
+    if (!proc->plugin()->start()) {
+        report.error(u"cannot start plugin %s", {name});
+        delete proc;
+        return false;
+    }
+
+    Guard lock(_global_mutex);
+    PluginExecutor* next = _ended ? 0 : executorAt(index);
+    if (next == 0 || next == _input || !proc->insertInRing(next)) {
+        report.error(u"cannot insert a packet processor at index %d", {index});
+        proc->plugin()->stop();
+        delete proc;
+        return false;
+    }
+    _executors.push_back(proc);
+    proc->start();
+    _report->verbose(u"tsp: packet processor %s inserted at index %d", {name, index});
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Remove a packet processor from the running pipeline.
+//----------------------------------------------------------------------------
+
+bool ts::tsp::Pipeline::removePlugin(size_t index, Report& report)
+{
+    if (_report == 0 || !checkRingChange(report)) {
+        return false;
+    }
+
+    PluginExecutor* proc = 0;
+    {
+        Guard lock(_global_mutex);
+        proc = _ended ? 0 : executorAt(index);
+        if (proc == 0 || proc == _input || proc == _output) {
+            report.error(u"no packet processor at index %d", {index});
+            return false;
+        }
+        proc->requestRemove();
+    }
+
+    // The executor thread leaves the ring and terminates. When the main thread
+    // already waits for its termination, only wait for its removal.
+    if (!proc->waitForTermination()) {
+        for (MilliSecond waited = 0; waited < RECONFIGURE_TIMEOUT && !isRemoved(proc); waited += 10) {
+            SleepThread(10);
+        }
+    }
+    if (!isRemoved(proc)) {
+        report.error(u"packet processor %s already terminated", {proc->pluginName()});
+        return false;
+    }
+    _report->verbose(u"tsp: packet processor %s removed from index %d", {proc->pluginName(), index});
+    return true;
+}
+
+bool ts::tsp::Pipeline::isRemoved(PluginExecutor* proc)
+{
+    Guard lock(_global_mutex);
+    return proc->ringAlone();
+}
@@ -0,0 +1,183 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Transport stream processor: A complete chain of plugin executors
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tspOptions.h"
+#include "tspInputExecutor.h"
+#include "tspOutputExecutor.h"
+#include "tspBranchExecutor.h"
+#include "tspPluginMonitor.h"
+#include "tspSignalizationService.h"
+#include "tsResidentBuffer.h"
+#include "tsThreadPool.h"
+#include "tsMutex.h"
+#include <list>
+
+namespace ts {
+    namespace tsp {
+        //!
+        //! A complete processing chain of tsp: input, packet processors, output and branches.
+        //!
+        //! The pipeline owns the plugin executors, the packet buffer and the monitoring
+        //! thread of its plugins. The process-wide services (interrupt handler, system
+        //! monitoring, export of metrics) remain in the application. Several independent
+        //! pipelines can run in the same process (tsp option -\-host).
+        //!
+        //! While the pipeline is running, its plugins can be reconfigured and packet
+        //! processors can be inserted or removed (tsp option -\-control-port). The
+        //! plugins are identified by their index in the processing chain, starting
+        //! at zero for the input plugin.
+        //!
+        class Pipeline
+        {
+        public:
+            //!
+            //! Constructor.
+            //! Load all plugins and analyze their command line arguments. Errors are
+            //! reported in @a options, the application should call @a options->exitOnError().
+            //! @param [in,out] options Command line options of the pipeline.
+            //! @param [in] pool Optional thread pool for packet-parallel processor plugins.
+            //! When zero, each packet-parallel plugin creates its own worker threads.
+            //!
+            Pipeline(Options* options, ThreadPool* pool = 0);
+
+            //!
+            //! Destructor. Must be called after waitForTermination().
+            //!
+            ~Pipeline();
+
+            //!
+            //! Start the plugins and the executor threads.
+            //! @param [in,out] report Where to report the messages of the plugins. Must be thread-safe.
+            //! @return True on success, false on error.
+            //!
+            bool start(Report& report);
+
+            //!
+            //! Wait for the termination of all executor threads.
+            //!
+            void waitForTermination();
+
+            //!
+            //! Abort the processing, typically on user interrupt.
+            //! Can be called from any thread.
+            //!
+            void abort();
+
+            //!
+            //! Get the name of the pipeline.
+            //! @return The name of the processing chain in tsp host mode, empty otherwise.
+            //!
+            const UString& name() const
+            {
+                return _options->pipeline_name;
+            }
+
+            //!
+            //! List the plugins of the running pipeline.
+            //! @param [out] lines One line per plugin, with its index, name and options.
+            //!
+            void listPlugins(UStringVector& lines);
+
+            //!
+            //! Reconfigure a plugin of the running pipeline with new command line arguments.
+            //! @param [in] index Index of the plugin in the processing chain.
+            //! @param [in] args New command line arguments of the plugin.
+            //! @param [in,out] report Where to report errors.
+            //! @return True on success, false on error.
+            //!
+            bool reconfigurePlugin(size_t index, const UStringVector& args, Report& report);
+
+            //!
+            //! Insert a packet processor in the running pipeline.
+            //! @param [in] index Index of the plugin before which the new one is inserted.
+            //! @param [in] name Name of the packet processor plugin.
+            //! @param [in] args Command line arguments of the plugin.
+            //! @param [in,out] report Where to report errors.
+            //! @return True on success, false on error.
+            //!
+            bool insertPlugin(size_t index, const UString& name, const UStringVector& args, Report& report);
+
+            //!
+            //! Remove a packet processor from the running pipeline.
+            //! @param [in] index Index of the plugin to remove.
+            //! @param [in,out] report Where to report errors.
+            //! @return True on success, false on error.
+            //!
+            bool removePlugin(size_t index, Report& report);
+
+            //!
+            //! Maximum time to wait for a plugin to apply a reconfiguration.
+            //!
+            static const MilliSecond RECONFIGURE_TIMEOUT = 5000;
+
+        private:
+            typedef std::vector<PluginExecutor*> ExecutorVector;
+
+            Options*             _options;
+            ThreadPool*          _pool;
+            Report*              _report;        // Report of the plugins, once started.
+            Mutex                _global_mutex;  // Global mutex for protected operations of the executors.
+            ExecutorVector       _executors;     // All executors of the ring, including removed ones (under global mutex).
+            std::list<Options::PluginOptions> _inserted;  // Options of the inserted packet processors.
+            bool                 _ended;         // All executor threads are terminated (under global mutex).
+            InputExecutor*       _input;
+            std::vector<InputExecutor*> _standby;  // Hot standby inputs, not in the ring.
+            OutputExecutor*      _output;
+            std::vector<BranchExecutor*> _branches;
+            SignalizationService* _signalization;
+            PluginMonitor*       _monitor;
+            PacketBuffer*                     _packet_buffer;
+            ResidentBuffer<TSPacketMetadata>* _metadata_buffer;
+
+            // Get the executor at some index in the ring, zero if out of range. Must be called under the global mutex.
+            PluginExecutor* executorAt(size_t index) const;
+
+            // Check if packet processors can be inserted or removed.
+            bool checkRingChange(Report& report);
+
+            // Check if an executor was removed from the ring.
+            bool isRemoved(PluginExecutor* proc);
+            // Report the cost of each plugin at the end of a benchmark (tsp option --benchmark).
+            void reportBenchmark(const Monotonic& end);
+            // Format the ratio of two integers with two decimals.
+            static UString Hundredths(uint64_t value, uint64_t total);
+
+            // Inaccessible operations
+            Pipeline() = delete;
+            Pipeline(const Pipeline&) = delete;
+            Pipeline& operator=(const Pipeline&) = delete;
+        };
+    }
+}
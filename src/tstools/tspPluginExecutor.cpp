@@ -37,6 +37,81 @@
 #include "tsGuard.h"
 TSDUCK_SOURCE;
 
+#if defined(TS_I386) || defined(TS_X86_64)
+    #include <immintrin.h>
+    #define CPU_PAUSE() _mm_pause()
+#elif defined(TS_ARM) && defined(TS_GCC)
+    #define CPU_PAUSE() __asm__ __volatile__("yield")
+#else
+    #define CPU_PAUSE()
+#endif
+
+// Number of busy-poll iterations between two reads of the clock.
+#define SPIN_CLOCK_ITERATIONS 64
+
+//----------------------------------------------------------------------------
+// Count the memory allocations of each thread, for the instrumentation of
+// the plugin invocations. The allocations in the TSDuck library and the
+// plugins are seen when the platform resolves their operator new to this
+// executable (ELF platforms). On Windows, they are not seen.
+//----------------------------------------------------------------------------
+
+namespace {
+    thread_local uint64_t thread_allocations = 0;
+}
+
+void* operator new(size_t size)
+{
+    thread_allocations++;
+    void* ptr = std::malloc(size == 0 ? 1 : size);
+    if (ptr == 0) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+uint64_t ts::tsp::PluginExecutor::ThreadAllocations()
+{
+    return thread_allocations;
+}
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::tsp::PluginExecutor::LATENCY_BUCKETS;
+const size_t ts::tsp::PluginExecutor::MIN_LATENCY_FLUSH_PKT;
+#endif
+
+
+//----------------------------------------------------------------------------
+// Execution statistics constructor.
+//----------------------------------------------------------------------------
+
+ts::tsp::PluginExecutor::Statistics::Statistics() :
+    packets(0),
+    calls(0),
+    plugin_time(0),
+    sleeps(0),
+    allocations(0)
+{
+    for (size_t i = 0; i < LATENCY_BUCKETS; ++i) {
+        latency[i] = 0;
+    }
+}
+
 
 //----------------------------------------------------------------------------
 // Constructor
@@ -45,26 +120,58 @@ TSDUCK_SOURCE;
 ts::tsp::PluginExecutor::PluginExecutor(Options* options,
                                         const Options::PluginOptions* pl_options,
                                         const ThreadAttributes& attributes,
-                                        Mutex& global_mutex) :
+                                        Mutex& global_mutex,
+                                        Report* report) :
     RingNode(),
     JointTermination(options, global_mutex),
     Thread(attributes),
     _name(pl_options->name),
     _shlib(0),
     _buffer(0),
-    _report(options),
+    _metadata(0),
+    _instrument(options->monitor || options->benchmark),
+    _stats(),
+    _call_start(),
+    _call_end(),
+    _call_allocs(0),
+    _time_origin(),
+    _max_latency(options->max_latency),
+    _signalization(0),
+    _position(0),
+    _pipeline(options->pipeline_name),
+    _metric_packets(0),
+    _lookahead(0),
+    _report(report != 0 ? report : options),
     _to_do(),
+    _lock_free(options->lock_free),
+    _fused(pl_options->fused),
+    _wait_strategy(options->wait_strategy),
+    _spin_time(options->spin_time * NanoSecPerMicroSec),
+    _spin_end(),
+    _spin_now(),
     _pkt_first(0),
     _pkt_cnt(0),
     _input_end(false),
-    _bitrate(0)
+    _bitrate(0),
+    _sleeping(false),
+    _remove_request(false),
+    _args(pl_options->args),
+    _reconf_mutex(),
+    _reconf_done(),
+    _reconf_args(),
+    _reconf_pending(false),
+    _reconf_success(false)
 {
     const UChar* shell = 0;
+    _time_origin.getSystemTime();
+
+    // The plugins check the offline mode from their start() method.
+    _tsp_offline = options->offline;
 
     // Create the plugin instance object
     switch (pl_options->type) {
         case Options::INPUT: {
-            NewInputProfile allocator = PluginRepository::Instance()->getInput(_name, *options);
+            NewInputProfile allocator = PluginRepository::Instance()->getInput(_name, *_report);
             if (allocator != 0) {
                 _shlib = allocator(this);
                 shell = u"tsp -I";
@@ -72,15 +179,23 @@ ts::tsp::PluginExecutor::PluginExecutor(Options* options,
             break;
         }
         case Options::OUTPUT: {
-            NewOutputProfile allocator = PluginRepository::Instance()->getOutput(_name, *options);
+            NewOutputProfile allocator = PluginRepository::Instance()->getOutput(_name, *_report);
             if (allocator != 0) {
                 _shlib = allocator(this);
                 shell = u"tsp -O";
             }
             break;
         }
+        case Options::BRANCH: {
+            NewOutputProfile allocator = PluginRepository::Instance()->getOutput(_name, *_report);
+            if (allocator != 0) {
+                _shlib = allocator(this);
+                shell = u"tsp -B";
+            }
+            break;
+        }
         case Options::PROCESSOR: {
-            NewProcessorProfile allocator = PluginRepository::Instance()->getProcessor(_name, *options);
+            NewProcessorProfile allocator = PluginRepository::Instance()->getProcessor(_name, *_report);
             if (allocator != 0) {
                 _shlib = allocator(this);
                shell = u"tsp -P";
@@ -99,15 +214,25 @@ ts::tsp::PluginExecutor::PluginExecutor(Options* options,
         _shlib->setShell(shell);
     }
 
-    // Submit the plugin arguments for analysis.
-    // The process should terminate on argument error.
+    // Submit the plugin arguments for analysis. Argument errors are reported
+    // through the executor. At startup, the report is the tsp options and the
+    // process terminates after all plugins are analyzed. At run time, or later
+    // reconfigurations, the process must not terminate.
+    _shlib->setFlags(_shlib->getFlags() | Args::NO_EXIT_ON_ERROR);
+    if (report != 0) {
+        _shlib->setFlags(_shlib->getFlags() | Args::NO_EXIT_ON_HELP | Args::NO_EXIT_ON_VERSION);
+    }
     _shlib->analyze(pl_options->name, pl_options->args);
-    assert(_shlib->valid());
+    _shlib->setFlags(_shlib->getFlags() | Args::NO_EXIT_ON_HELP | Args::NO_EXIT_ON_VERSION);
 
-    // Define thread stack size
+    // Define thread name, stack size, CPU affinity and scheduling
     ThreadAttributes attr;
     Thread::getAttributes(attr);
+    attr.setName(_name);
     attr.setStackSize(STACK_SIZE_OVERHEAD + _shlib->stackUsage());
+    attr.setCPUAffinity(pl_options->cpus);
+    attr.setSchedulingPolicy(pl_options->sched_policy, pl_options->sched_priority);
+    attr.setPrefaultStack(options->prefault);
     Thread::setAttributes(attr);
 }
 
@@ -126,19 +251,46 @@ ts::tsp::PluginExecutor::~PluginExecutor()
 }
 
 
+//----------------------------------------------------------------------------
+// Start the thread of the executor.
+//----------------------------------------------------------------------------
+
+bool ts::tsp::PluginExecutor::startThread()
+{
+    ThreadAttributes requested;
+    Thread::getAttributes(requested);
+    if (!Thread::start()) {
+        return false;
+    }
+
+    // The thread falls back to the default scheduling when the policy is not allowed.
+    ThreadAttributes actual;
+    Thread::getAttributes(actual);
+    if (actual.getSchedulingPolicy() != requested.getSchedulingPolicy()) {
+        warning(u"cannot use %s scheduling policy (insufficient privileges), using default scheduling", {Options::SchedulingPolicyNames.name(requested.getSchedulingPolicy())});
+    }
+    else if (requested.getSchedulingPolicy() != ThreadAttributes::SCHEDULING_DEFAULT) {
+        verbose(u"using %s scheduling policy", {Options::SchedulingPolicyNames.name(requested.getSchedulingPolicy())});
+    }
+    return true;
+}
+
+
 //----------------------------------------------------------------------------
 // Set the initial state of the buffer. Must be executed in
 // synchronous environment, before starting all executor threads.
 //----------------------------------------------------------------------------
 
-void ts::tsp::PluginExecutor::initBuffer(PacketBuffer* buffer,
-                                         size_t        pkt_first,
-                                         size_t        pkt_cnt,
-                                         bool          input_end,
-                                         bool          aborted,
-                                         BitRate       bitrate)
+void ts::tsp::PluginExecutor::initBuffer(PacketBuffer*         buffer,
+                                         PacketMetadataBuffer* metadata,
+                                         size_t                pkt_first,
+                                         size_t                pkt_cnt,
+                                         bool                  input_end,
+                                         bool                  aborted,
+                                         BitRate               bitrate)
 {
     _buffer = buffer;
+    _metadata = metadata;
     _pkt_first = pkt_first;
     _pkt_cnt = pkt_cnt;
     _input_end = input_end;
@@ -148,6 +300,65 @@ void ts::tsp::PluginExecutor::initBuffer(PacketBuffer* buffer,
 }
 
 
+//----------------------------------------------------------------------------
+// Exported performance counters.
+//----------------------------------------------------------------------------
+
+ts::Metric::Labels ts::tsp::PluginExecutor::metricLabels() const
+{
+    Metric::Labels labels;
+    labels[u"index"] = UString::Decimal(_position, 0, true, UString());
+    labels[u"plugin"] = _name;
+    if (!_pipeline.empty()) {
+        labels[u"pipeline"] = _pipeline;
+    }
+    return labels;
+}
+
+void ts::tsp::PluginExecutor::registerMetrics()
+{
+    _metric_packets = MetricsRegistry::Instance()->counter(u"tsp_plugin_packets_total", u"Number of packets which were passed to the plugin", metricLabels());
+}
+
+
+//----------------------------------------------------------------------------
+// Subscribe to the shared signalization (inherited from TSP).
+// Input and output plugins cannot subscribe.
+//----------------------------------------------------------------------------
+
+bool ts::tsp::PluginExecutor::subscribeSignalization(TableHandlerInterface* handler, const PIDSet& pids)
+{
+    return false;
+}
+
+
+//----------------------------------------------------------------------------
+// Current time in the time base of the input time stamps (inherited from TSP).
+//----------------------------------------------------------------------------
+
+ts::NanoSecond ts::tsp::PluginExecutor::currentTimeStamp() const
+{
+    Monotonic now;
+    now.getSystemTime();
+    return now - _time_origin;
+}
+
+
+//----------------------------------------------------------------------------
+// Packet lookahead (inherited from TSP).
+// Input and output plugins cannot use a lookahead.
+//----------------------------------------------------------------------------
+
+void ts::tsp::PluginExecutor::setLookahead(size_t count)
+{
+}
+
+const ts::TSPacket* ts::tsp::PluginExecutor::lookaheadPacket(size_t index, const TSPacketMetadata** mdata) const
+{
+    return 0;
+}
+
+
 //----------------------------------------------------------------------------
 // Invoked by shared library to log messages
 // Inherited from Report (via TSP)
@@ -180,13 +391,40 @@ void ts::tsp::PluginExecutor::passPackets(size_t count,     // of packets to pas
 
 {
     assert(count <= _pkt_cnt);
-    assert(_pkt_first + count <= _buffer->count());
 
     log(10, u"passPackets (count = %'d, bitrate = %'d, input_end = %'d, aborted = %'d)", {count, bitrate, input_end, aborted});
 
+    // In lock-free mode, we are the only writer of our _pkt_first and the
+    // only producer of the next processor's _pkt_cnt. The next processor's
+    // _input_end is set after its _pkt_cnt so that a processor which sees
+    // its _input_end also sees all its packets.
+
+    if (_lock_free) {
+        PluginExecutor* next = ringNext<PluginExecutor>();
+        _pkt_first = (_pkt_first + count) % _buffer->count();
+        _pkt_cnt -= count;
+        next->_bitrate = bitrate;
+        next->_pkt_cnt += count;
+        if (input_end) {
+            next->_input_end = true;
+        }
+        if (count > 0 || input_end) {
+            next->wakeUp();
+        }
+        if (aborted) {
+            // Rare event, always signal the previous processor under the mutex.
+            Guard lock(_global_mutex);
+            _tsp_aborting = true; // volatile bool in TSP superclass
+            ringPrevious<PluginExecutor>()->threadOwner()->_to_do.signal();
+        }
+        return;
+    }
+
     // We access data under the protection of the global mutex.
+    // The next processor may change when processors are inserted or removed.
 
     Guard lock(_global_mutex);
+    PluginExecutor* next = ringNext<PluginExecutor>();
 
     // Update our buffer
 
@@ -195,7 +433,6 @@ void ts::tsp::PluginExecutor::passPackets(size_t count,     // of packets to pas
 
     // Update next processor's buffer.
 
-    PluginExecutor* next = ringNext<PluginExecutor>();
     next->_pkt_cnt += count;
     next->_input_end = next->_input_end || input_end;
     next->_bitrate = bitrate;
@@ -210,8 +447,163 @@ void ts::tsp::PluginExecutor::passPackets(size_t count,     // of packets to pas
 
     if (aborted) {
         _tsp_aborting = true; // volatile bool in TSP superclass
-        ringPrevious<PluginExecutor>()->_to_do.signal();
+        ringPrevious<PluginExecutor>()->threadOwner()->_to_do.signal();
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Compute the number of packets to process before passing them to the next
+// plugin, according to the latency target.
+//----------------------------------------------------------------------------
+
+size_t ts::tsp::PluginExecutor::latencyFlushCount(size_t max_count, BitRate bitrate) const
+{
+    if (_max_latency <= 0 || bitrate == 0) {
+        return max_count;
+    }
+
+    // Number of packets in the latency budget at the current bitrate.
+    const uint64_t budget = (uint64_t(bitrate) * uint64_t(_max_latency)) / (uint64_t(MilliSecPerSec) * PKT_SIZE * 8);
+
+    // Packets which already wait in the next plugin delay ours as well.
+    const uint64_t downstream = ringNext<PluginExecutor>()->windowSize();
+    if (downstream >= budget) {
+        return max_count;
     }
+    return size_t(std::min<uint64_t>(max_count, std::max<uint64_t>(MIN_LATENCY_FLUSH_PKT, budget - downstream)));
+}
+
+
+//----------------------------------------------------------------------------
+// Build the runs of non-dropped packets in an area of the packet buffer.
+// The contiguous runs of non-dropped packets are located using the dense
+// metadata buffer instead of the packets themselves.
+//----------------------------------------------------------------------------
+
+size_t ts::tsp::PluginExecutor::getOutputRuns(TSPacketRunVector& runs, std::vector<TSPacket>& dense, size_t pkt_first, size_t pkt_cnt) const
+{
+    TSPacketView pkt(_buffer->base() + pkt_first);
+    const TSPacketMetadata* mdata = _metadata->base() + pkt_first;
+    size_t pkt_remain = pkt_cnt;
+    size_t out_total = 0;
+    runs.clear();
+
+    // With a padded stride, the non-dropped packets are copied at the beginning of the dense area.
+    if (!pkt.isDense() && dense.size() < pkt_cnt) {
+        dense.resize(pkt_cnt);
+    }
+
+    while (pkt_remain > 0) {
+
+        // Skip dropped packets
+        const size_t drop_cnt = TSPacketMetadata::CountDropped(mdata, pkt_remain);
+        pkt += drop_cnt;
+        mdata += drop_cnt;
+        pkt_remain -= drop_cnt;
+
+        // Find last non-dropped packet
+        const size_t out_cnt = TSPacketMetadata::CountNotDropped(mdata, pkt_remain);
+        if (out_cnt > 0) {
+            if (pkt.isDense()) {
+                runs.push_back(TSPacketRun(pkt.get(), mdata, out_cnt));
+            }
+            else {
+                pkt.copyTo(&dense[out_total], out_cnt);
+                runs.push_back(TSPacketRun(&dense[out_total], mdata, out_cnt));
+            }
+            pkt += out_cnt;
+            mdata += out_cnt;
+            pkt_remain -= out_cnt;
+            out_total += out_cnt;
+        }
+    }
+    return out_total;
+}
+
+
+//----------------------------------------------------------------------------
+// Lock-free mode: wake up a processor if it sleeps on its condition.
+// The processor sets _sleeping under the global mutex before checking
+// its wait condition and waiting. Since _sleeping is checked after
+// updating the cursors, the notification cannot be lost.
+//----------------------------------------------------------------------------
+
+void ts::tsp::PluginExecutor::wakeUp()
+{
+    if (_sleeping) {
+        Guard lock(_global_mutex);
+        _to_do.signal();
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Check if waitWork() must keep waiting. A packet processor with a lookahead
+// also waits until more packets than the lookahead are available.
+//----------------------------------------------------------------------------
+
+bool ts::tsp::PluginExecutor::mustWait() const
+{
+    return _pkt_cnt <= _lookahead && !_input_end && !_remove_request && !_reconf_pending && !nextAborted();
+}
+
+
+//----------------------------------------------------------------------------
+// Busy-poll the sliding window according to the wait strategy. Return when
+// there is something to do or when the thread must sleep. The reads of the
+// window are atomic and need no mutex.
+//----------------------------------------------------------------------------
+
+void ts::tsp::PluginExecutor::spinWait()
+{
+    if (_wait_strategy == Options::WAIT_POLL) {
+        while (mustWait()) {
+            CPU_PAUSE();
+        }
+    }
+    else if (_wait_strategy == Options::WAIT_SPIN && _spin_time > 0) {
+        _spin_end.getSystemTime();
+        _spin_end += _spin_time;
+        do {
+            for (int i = 0; i < SPIN_CLOCK_ITERATIONS && mustWait(); ++i) {
+                CPU_PAUSE();
+            }
+            _spin_now.getSystemTime();
+        } while (mustWait() && _spin_now < _spin_end);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Check if the next executor is aborting. The executors which are fused after
+// the next one run in the same thread and never wait: check them as well.
+//----------------------------------------------------------------------------
+
+bool ts::tsp::PluginExecutor::nextAborted() const
+{
+    const PluginExecutor* proc = ringNext<PluginExecutor>();
+    while (!proc->_tsp_aborting) {
+        if (!proc->_fused) {
+            return false;
+        }
+        proc = proc->ringNext<PluginExecutor>();
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Get the executor which owns the thread of this one.
+//----------------------------------------------------------------------------
+
+ts::tsp::PluginExecutor* ts::tsp::PluginExecutor::threadOwner()
+{
+    PluginExecutor* proc = this;
+    while (proc->_fused) {
+        proc = proc->ringPrevious<PluginExecutor>();
+    }
+    return proc;
 }
 
 
@@ -223,7 +615,7 @@ void ts::tsp::PluginExecutor::setAbort()
 {
     Guard lock(_global_mutex);
     _tsp_aborting = true;
-    ringPrevious<PluginExecutor>()->_to_do.signal();
+    ringPrevious<PluginExecutor>()->threadOwner()->_to_do.signal();
 }
 
 
@@ -232,7 +624,8 @@ void ts::tsp::PluginExecutor::setAbort()
 // to process or some error condition. Always return a contiguous array
 // of packets. If the circular buffer wrap-over occurs in the middle of
 // the caller's area, only return the first part, up the buffer's highest
-// address. The next call to waitWork will return the second part.
+// address. The next call to waitWork will return the second part. The
+// size of the second part is also returned in pkt_wrap when requested.
 //----------------------------------------------------------------------------
 
 void ts::tsp::PluginExecutor::waitWork(size_t& pkt_first,
@@ -240,28 +633,225 @@ void ts::tsp::PluginExecutor::waitWork(size_t& pkt_first,
                                        BitRate& bitrate,
                                        bool& input_end,
                                        bool& aborted)    // get from next processor
+{
+    size_t pkt_wrap = 0;
+    waitWork(pkt_first, pkt_cnt, pkt_wrap, bitrate, input_end, aborted);
+}
+
+void ts::tsp::PluginExecutor::waitWork(size_t& pkt_first,
+                                       size_t& pkt_cnt,
+                                       size_t& pkt_wrap,
+                                       BitRate& bitrate,
+                                       bool& input_end,
+                                       bool& aborted)    // get from next processor
 {
     log(10, u"waitWork(...)");
 
-    // We access data under the protection of the global mutex.
+    // Busy-poll first, when required, without the mutex.
+    if (_wait_strategy != Options::WAIT_BLOCK && mustWait()) {
+        spinWait();
+    }
 
-    GuardCondition lock(_global_mutex, _to_do);
+    if (_lock_free) {
+        // Lock-free mode: only use the mutex and condition when we need to sleep.
+        if (mustWait()) {
+            GuardCondition lock(_global_mutex, _to_do);
+            _stats.sleeps++;
+            _sleeping = true;
+            while (mustWait()) {
+                lock.waitCondition();
+            }
+            _sleeping = false;
+        }
+        getWork(pkt_first, pkt_cnt, pkt_wrap, bitrate, input_end, aborted);
+    }
+    else {
+        // We access data under the protection of the global mutex.
+        GuardCondition lock(_global_mutex, _to_do);
+        if (mustWait()) {
+            _stats.sleeps++;
+        }
+        while (mustWait()) {
+            // If packet area for this processor is empty, wait for some packet.
+            // The mutex is implicitely released, we wait for the condition
+            // '_to_do' and, once we get it, implicitely relock the mutex.
+            // We loop on this until packets are actually available.
+            lock.waitCondition();
+        }
+        getWork(pkt_first, pkt_cnt, pkt_wrap, bitrate, input_end, aborted);
+    }
 
-    while (_pkt_cnt == 0 && !_input_end && !ringNext<PluginExecutor>()->_tsp_aborting) {
+    log(10, u"waitWork (pkt_first = %'d, pkt_cnt = %'d, pkt_wrap = %'d, bitrate = %'d, input_end = %'d, aborted = %'d)", {pkt_first, pkt_cnt, pkt_wrap, bitrate, input_end, aborted});
+}
 
-        // If packet area for this processor is empty, wait for some packet.
-        // The mutex is implicitely released, we wait for the condition
-        // '_to_do' and, once we get it, implicitely relock the mutex.
-        // We loop on this until packets are actually available.
 
-        lock.waitCondition();
+//----------------------------------------------------------------------------
+// Get the current work area without waiting (fused executors).
+//----------------------------------------------------------------------------
+
+void ts::tsp::PluginExecutor::pollWork(size_t& pkt_first,
+                                       size_t& pkt_cnt,
+                                       BitRate& bitrate,
+                                       bool& input_end,
+                                       bool& aborted)
+{
+    size_t pkt_wrap = 0;
+    if (_lock_free) {
+        getWork(pkt_first, pkt_cnt, pkt_wrap, bitrate, input_end, aborted);
     }
+    else {
+        Guard lock(_global_mutex);
+        getWork(pkt_first, pkt_cnt, pkt_wrap, bitrate, input_end, aborted);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Get the description of the current work area, after waiting.
+// The end of input is read before the packet count (see passPackets()).
+//----------------------------------------------------------------------------
+
+void ts::tsp::PluginExecutor::getWork(size_t& pkt_first,
+                                      size_t& pkt_cnt,
+                                      size_t& pkt_wrap,
+                                      BitRate& bitrate,
+                                      bool& input_end,
+                                      bool& aborted)
+{
+    const bool end = _input_end;
+    const size_t cnt = _pkt_cnt;
 
     pkt_first = _pkt_first;
-    pkt_cnt = std::min(_pkt_cnt, _buffer->count() - _pkt_first);
+    pkt_cnt = std::min(cnt, _buffer->count() - pkt_first);
+    pkt_wrap = cnt - pkt_cnt;
     bitrate = _bitrate;
-    input_end = _input_end && pkt_cnt == _pkt_cnt;
-    aborted = ringNext<PluginExecutor>()->_tsp_aborting;
+    input_end = end && pkt_cnt == cnt;
+    aborted = nextAborted();
+}
+
+
+//----------------------------------------------------------------------------
+// Insert this executor in a running ring of executors.
+//----------------------------------------------------------------------------
+
+bool ts::tsp::PluginExecutor::insertInRing(PluginExecutor* next)
+{
+    assert(!_lock_free);
+    Guard lock(_global_mutex);
+
+    // Too late when the predecessor already declared the end of input.
+    if (next->_input_end) {
+        return false;
+    }
+
+    // The new sliding window is empty, between the ones of next and its predecessor.
+    PluginExecutor* previous = next->ringPrevious<PluginExecutor>();
+    _buffer = next->_buffer;
+    _metadata = next->_metadata;
+    _pkt_first = previous->_pkt_first.load();
+    _pkt_cnt = 0;
+    _input_end = false;
+    _bitrate = next->_bitrate.load();
+    _tsp_bitrate = _bitrate;
+    ringInsertBefore(next);
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Remove this executor from the ring.
+//----------------------------------------------------------------------------
+
+void ts::tsp::PluginExecutor::requestRemove()
+{
+    Guard lock(_global_mutex);
+    _remove_request = true;
+    _to_do.signal();
+}
+
+void ts::tsp::PluginExecutor::removeFromRing()
+{
+    assert(!_lock_free);
+    Guard lock(_global_mutex);
+
+    // Our sliding window immediately follows the one of the next executor.
+    PluginExecutor* next = ringNext<PluginExecutor>();
+    next->_pkt_cnt += _pkt_cnt;
+    next->_input_end = next->_input_end || _input_end;
+    next->_bitrate = _bitrate.load();
+    _pkt_cnt = 0;
+    ringRemove();
+    next->threadOwner()->_to_do.signal();
+}
+
+
+//----------------------------------------------------------------------------
+// Reconfigure the plugin with new command line arguments.
+//----------------------------------------------------------------------------
+
+bool ts::tsp::PluginExecutor::reconfigure(const UStringVector& args, MilliSecond timeout, Report& report)
+{
+    GuardCondition lock(_reconf_mutex, _reconf_done);
+    _reconf_args = args;
+    _reconf_pending = true;
+
+    // Wake up the plugin thread if it waits for packets.
+    {
+        Guard global_lock(_global_mutex);
+        threadOwner()->_to_do.signal();
+    }
+
+    // Wait for the plugin thread to apply the new arguments.
+    while (_reconf_pending) {
+        if (!lock.waitCondition(timeout)) {
+            report.error(u"%s: reconfiguration not yet applied, no packet boundary reached", {_name});
+            return false;
+        }
+    }
+    if (!_reconf_success) {
+        report.error(u"%s: reconfiguration failed, previous options restored", {_name});
+    }
+    return _reconf_success;
+}
+
+
+//----------------------------------------------------------------------------
+// Apply a pending reconfiguration, in the thread of the plugin.
+//----------------------------------------------------------------------------
+
+bool ts::tsp::PluginExecutor::doReconfiguration()
+{
+    UStringVector args;
+    {
+        Guard lock(_reconf_mutex);
+        args = _reconf_args;
+    }
+
+    bool success = _shlib->analyze(_name, args);
+    bool running = true;
+    if (success) {
+        verbose(u"reconfiguring with new options");
+        success = _shlib->reconfigure();
+        if (success) {
+            _args = args;
+        }
+        else {
+            // Restart the plugin with its previous arguments.
+            error(u"reconfiguration failed, restoring previous options");
+            running = _shlib->analyze(_name, _args) && _shlib->reconfigure();
+        }
+    }
+    else {
+        // The plugin was not restarted, only restore its arguments.
+        _shlib->analyze(_name, _args);
+    }
+    if (!running) {
+        error(u"cannot restart with previous options, aborting");
+    }
 
-    log(10, u"waitWork (pkt_first = %'d, pkt_cnt = %'d, bitrate = %'d, input_end = %'d, aborted = %'d)", {pkt_first, pkt_cnt, bitrate, input_end, aborted});
+    GuardCondition lock(_reconf_mutex, _reconf_done);
+    _reconf_success = success;
+    _reconf_pending = false;
+    lock.signal();
+    return running;
 }
@@ -35,6 +35,8 @@
 #pragma once
 #include "tspOptions.h"
 #include "tspJointTermination.h"
+#include "tspSignalizationService.h"
+#include "tspPacketBuffer.h"
 #include "tsPlugin.h"
 #include "tsResidentBuffer.h"
 #include "tsUserInterrupt.h"
@@ -42,6 +44,9 @@
 #include "tsCondition.h"
 #include "tsMutex.h"
 #include "tsThread.h"
+#include "tsMonotonic.h"
+#include "tsMetrics.h"
+#include <atomic>
 
 namespace ts {
     namespace tsp {
@@ -56,7 +61,10 @@ namespace ts {
         //!  packets here. All packet processors update them and the output thread
         //!  picks them for the same place.
         //!
-        //!  The buffer is an array of ts::TSPacket. It is managed in a circular way.
+        //!  The buffer is an array of TS packets (see ts::tsp::PacketBuffer). With the
+        //!  tsp option -\-packet-stride, the packets are padded and aligned on cache
+        //!  lines. They are then copied from and to dense arrays of ts::TSPacket in
+        //!  the input and output plugins. The buffer is managed in a circular way.
         //!  It is divided into logical areas, one per processor (including input
         //!  and output). These logical areas are sliding windows which move when
         //!  packets are processed.
@@ -95,10 +103,27 @@ namespace ts {
         //!  window of the next processor), it must notify the _to_do condition variable
         //!  of the next thread.
         //!
+        //!  Lock-free mode
+        //!  --------------
+        //!  With the tsp option -\-lock-free, the sliding window boundaries are
+        //!  not protected by the global mutex. Each boundary between two adjacent
+        //!  areas has exactly one producer (the previous processor, which increases
+        //!  _pkt_cnt) and one consumer (the processor itself, which moves _pkt_first
+        //!  and decreases _pkt_cnt). These fields are therefore atomic single-producer
+        //!  single-consumer cursors. The global mutex and the "_to_do" condition
+        //!  variable are used only when a processor must actually sleep. A processor
+        //!  which is about to sleep sets its "_sleeping" flag and the processor which
+        //!  passes packets to it signals the condition only when this flag is set.
+        //!
         //!  When a packet processor decides to drop a packet, the synchronization
         //!  byte (first byte of the packet, normally 0x47) is reset to zero. When
-        //!  a packet processor or the output processor encounters a packet starting
-        //!  with a zero byte, it ignores it.
+        //!  a packet processor encounters a packet starting with a zero byte, it
+        //!  ignores it.
+        //!
+        //!  There is a parallel buffer of ts::TSPacketMetadata, indexed like the
+        //!  packet buffer. It contains the drop and null flags, the input time stamp
+        //!  and the labels of each packet. The output processor uses the drop flags
+        //!  from the metadata buffer to skip dropped packets.
         //!
         //!  All PluginExecutors are chained in a ring. The first one is input and
         //!  the last one is output. The output points back to the input so that the
@@ -117,6 +142,53 @@ namespace ts {
         //!  condition. In case of error, all processors should also declare an
         //!  "_input_end" to their successor.
         //!
+        //!  Wait strategy
+        //!  -------------
+        //!  With the tsp option -\-wait-strategy, a processor which has nothing to do
+        //!  may busy-poll its sliding window before sleeping on its "_to_do" condition
+        //!  variable ("spin"), or never sleep at all ("poll"). Since the window fields
+        //!  are atomic, they are polled without the global mutex. The condition
+        //!  variable is still notified by the previous processor, as usual.
+        //!
+        //!  Fused packet processors
+        //!  -----------------------
+        //!  With the tsp option -\-fuse-processors, consecutive packet processors are
+        //!  executed in the thread of the first one of the group. The other executors
+        //!  of the group have no thread of their own. They keep their sliding window
+        //!  in the buffer and are driven by the first one, after each processed slice.
+        //!  Since they never sleep, the "aborted" condition of all the executors after
+        //!  a thread is checked by this thread and it is the one which is notified.
+        //!
+        //!  Branches
+        //!  --------
+        //!  With the tsp option -B, additional output plugins, the branches, receive
+        //!  the same packets as the output plugin. The branches are not in the ring.
+        //!  The output executor publishes its sliding window to all branches, which
+        //!  read the packets in the buffer, in parallel with the output plugin. The
+        //!  output executor passes the packets to the input executor only when all
+        //!  branches have released them (see ts::tsp::BranchExecutor).
+        //!
+        //!  Run-time changes
+        //!  ----------------
+        //!  With the tsp option -\-control-port, the plugins can be reconfigured and
+        //!  packet processors can be inserted or removed while the chain is running.
+        //!  A reconfiguration is applied by the thread of the plugin, between two
+        //!  invocations of the plugin. A removed packet processor passes its sliding
+        //!  window, unprocessed, to its successor and leaves the ring. An inserted packet
+        //!  processor starts with an empty sliding window, just before the one of its
+        //!  predecessor. These ring changes are performed under the protection of the
+        //!  global mutex. They are consequently not supported in lock-free mode, and
+        //!  not with fused packet processors, since their grouping is fixed.
+        //!
+        //!  Instrumentation
+        //!  ---------------
+        //!  Each executor maintains execution statistics (ts::tsp::PluginExecutor::Statistics)
+        //!  which are periodically reported by the monitoring thread (tsp option -\-monitor)
+        //!  or at the end of a benchmark (tsp option -\-benchmark). The counters are updated
+        //!  by the plugin thread only. The time spent in the plugin, its memory allocations
+        //!  and the latency of the packets are collected only when monitoring or benchmark
+        //!  is active.
+        //!
         class PluginExecutor:
             public RingNode,
             public JointTermination,
@@ -124,9 +196,10 @@ namespace ts {
         {
         public:
             //!
-            //! TS packet are accessed in a memory-resident buffer.
+            //! Metadata of TS packet are accessed in a memory-resident buffer.
+            //! This buffer is parallel to the packet buffer, with the same number of elements.
             //!
-            typedef ResidentBuffer<TSPacket> PacketBuffer;
+            typedef ResidentBuffer<TSPacketMetadata> PacketMetadataBuffer;
 
             //!
             //! Constructor.
@@ -134,11 +207,16 @@ namespace ts {
             //! @param [in] pl_options Command line options for this plugin.
             //! @param [in] attributes Creation attributes for the thread executing this plugin.
             //! @param [in,out] global_mutex Global mutex to synchronize access to the packet buffer.
+            //! @param [in,out] report Where to report errors while loading the plugin. When zero,
+            //! errors are reported in @a options and the application exits on invalid arguments.
+            //! Otherwise, when a plugin is loaded at run time, the caller must check plugin()
+            //! and its validity.
             //!
             PluginExecutor(Options* options,
                            const Options::PluginOptions* pl_options,
                            const ThreadAttributes& attributes,
-                           Mutex& global_mutex);
+                           Mutex& global_mutex,
+                           Report* report = 0);
 
             //!
             //! Destructor
@@ -149,18 +227,65 @@ namespace ts {
             //! Set the initial state of the buffer for this plugin.
             //! Must be executed in synchronous environment, before starting all executor threads.
             //! @param [in] buffer Address of the packet buffer.
+            //! @param [in] metadata Address of the packet metadata buffer.
             //! @param [in] pkt_first Starting index of packets area for this plugin.
             //! @param [in] pkt_cnt Size of packets area for this plugin.
             //! @param [in] input_end If true, there is no more packet after current ones.
             //! @param [in] aborted If true, there was a packet processor error, aborted.
             //! @param [in] bitrate Input bitrate (set by previous packet processor).
             //!
-            void initBuffer(PacketBuffer* buffer,
-                            size_t        pkt_first,
-                            size_t        pkt_cnt,
-                            bool          input_end,
-                            bool          aborted,
-                            BitRate       bitrate);
+            void initBuffer(PacketBuffer*         buffer,
+                            PacketMetadataBuffer* metadata,
+                            size_t                pkt_first,
+                            size_t                pkt_cnt,
+                            bool                  input_end,
+                            bool                  aborted,
+                            BitRate               bitrate);
+
+            //!
+            //! Start the thread of the executor.
+            //! When the scheduling policy of the plugin thread cannot be applied, typically
+            //! a real-time policy without privileges, a warning is reported and the thread
+            //! runs with the default scheduling.
+            //! @return True on success, false on error.
+            //!
+            bool startThread();
+
+            //!
+            //! Insert this executor in a running ring of executors.
+            //! The executor starts with an empty sliding window, just before the one
+            //! of its predecessor. Not supported in lock-free mode.
+            //! @param [in,out] next The executor before which this one is inserted.
+            //! @return True on success, false if the end of input was already passed to @a next.
+            //!
+            bool insertInRing(PluginExecutor* next);
+
+            //!
+            //! Request the removal of this executor from the ring.
+            //! The removal is performed later by the thread of the executor.
+            //!
+            void requestRemove();
+
+            //!
+            //! Reconfigure the plugin with new command line arguments.
+            //! The arguments are applied by the thread of the plugin, between two
+            //! invocations of the plugin. On error, the previous arguments are restored.
+            //! @param [in] args New command line arguments of the plugin.
+            //! @param [in] timeout Maximum time to wait for the reconfiguration.
+            //! @param [in,out] report Where to report errors.
+            //! @return True if the plugin was successfully reconfigured, false on
+            //! error or if the reconfiguration was not yet applied after @a timeout.
+            //!
+            bool reconfigure(const UStringVector& args, MilliSecond timeout, Report& report);
+
+            //!
+            //! Get the current command line arguments of the plugin.
+            //! @return A constant reference to the arguments of the plugin.
+            //!
+            const UStringVector& pluginArgs() const
+            {
+                return _args;
+            }
 
             //!
             //! Change the report method.
@@ -171,11 +296,62 @@ namespace ts {
                 _report = rep;
             }
 
+            //! Set the shared signalization service.
+            //! @param [in] service Address of the shared signalization service of tsp.
+            //! @param [in] position Position of this plugin in the chain, starting at zero for the input plugin.
+            void setSignalization(SignalizationService* service, size_t position)
+            {
+                _signalization = service;
+                _position = position;
+            }
+
+            //!
+            //! Register the performance counters of this executor in ts::MetricsRegistry.
+            //! Must be invoked after setSignalization() which sets the position of the plugin.
+            //!
+            virtual void registerMetrics();
+
+            // Inherited from TSP. Only packet processors can subscribe.
+            virtual bool subscribeSignalization(TableHandlerInterface* handler, const PIDSet& pids) override;
+
+            // Inherited from TSP.
+            virtual NanoSecond currentTimeStamp() const override;
+
+            // Inherited from TSP. Only packet processors can use a lookahead.
+            virtual void setLookahead(size_t count) override;
+            virtual const TSPacket* lookaheadPacket(size_t index, const TSPacketMetadata** mdata = 0) const override;
+
+            //!
+            //! Set the origin of the input time stamps in the packet metadata.
+            //! All executors of a processing chain use the origin of the input executor.
+            //! Must be executed in synchronous environment, before starting the executor thread.
+            //! @param [in] origin Origin of the input time stamps.
+            //!
+            void setTimeOrigin(const Monotonic& origin)
+            {
+                _time_origin = origin;
+            }
+
+            //!
+            //! Get the origin of the input time stamps in the packet metadata.
+            //! @return A constant reference to the origin of the input time stamps.
+            //!
+            const Monotonic& timeOrigin() const
+            {
+                return _time_origin;
+            }
+
             //!
             //! This method sets the current packet processor in an abort state.
             //!
             void setAbort();
 
+            //!
+            //! Minimum number of packets to process before passing them to the next
+            //! plugin when a maximum latency is specified (one IP datagram of TS packets).
+            //!
+            static const size_t MIN_LATENCY_FLUSH_PKT = 7;
+
             //!
             //! Plugin stack size overhead.
             //! Each plugin defines its own usage of the stack. The PluginExector
@@ -192,10 +368,199 @@ namespace ts {
                 return _shlib;
             }
 
+            //!
+            //! Get the plugin name.
+            //! @return A constant reference to the plugin name.
+            //!
+            const UString& pluginName() const
+            {
+                return _name;
+            }
+
+            //!
+            //! Number of buckets in the latency histogram.
+            //! Bucket @a i counts the latencies in the range [2^i, 2^(i+1)[ microseconds.
+            //! The first bucket also counts latencies under one microsecond.
+            //!
+            static const size_t LATENCY_BUCKETS = 32;
+
+            //!
+            //! Execution statistics of a plugin executor.
+            //! The counters are updated by the plugin thread and can be read at any time
+            //! by a monitoring thread. All counters are cumulative since the creation of
+            //! the executor.
+            //!
+            class Statistics
+            {
+            public:
+                //!
+                //! Constructor.
+                //!
+                Statistics();
+
+                std::atomic<PacketCounter> packets;      //!< Number of packets which were passed to the plugin.
+                std::atomic<uint64_t>      calls;        //!< Number of invocations of the plugin (receive, processPacketBatch, send).
+                std::atomic<NanoSecond>    plugin_time;  //!< Accumulated time in the plugin, in nanoseconds.
+                std::atomic<uint64_t>      sleeps;       //!< Number of times waitWork() had to sleep.
+                std::atomic<uint64_t>      allocations;  //!< Number of memory allocations in the thread of the plugin, during its invocations.
+                std::atomic<uint64_t>      latency[LATENCY_BUCKETS];  //!< Histogram of packet latencies from input to output (output plugin only).
+
+            private:
+                Statistics(const Statistics&) = delete;
+                Statistics& operator=(const Statistics&) = delete;
+            };
+
+            //!
+            //! Get the number of memory allocations in the current thread.
+            //! All allocations through the global operator new are counted, in tsp and,
+            //! on platforms where operator new is resolved in the executable (ELF platforms),
+            //! in the TSDuck library and the plugins. On Windows, the allocations inside the
+            //! TSDuck DLL and the plugins are not seen.
+            //! @return The cumulative number of memory allocations in the current thread.
+            //!
+            static uint64_t ThreadAllocations();
+
+            //!
+            //! Get the execution statistics of this executor.
+            //! @return A constant reference to the execution statistics.
+            //!
+            const Statistics& statistics() const
+            {
+                return _stats;
+            }
+
+            //!
+            //! Check if this executor is fused with the previous one.
+            //! @return True if the plugin is executed in the thread of the previous plugin.
+            //!
+            bool isFused() const
+            {
+                return _fused;
+            }
+
+            //!
+            //! Get the current size of the sliding window of this executor.
+            //! @return The number of packets which are waiting to be processed by this plugin.
+            //!
+            size_t windowSize() const
+            {
+                return _pkt_cnt;
+            }
+
+            //!
+            //! Check if the previous executor declared the end of input.
+            //! @return True when no more packet will be added to the sliding window of this executor.
+            //!
+            bool inputEnd() const
+            {
+                return _input_end;
+            }
+
         protected:
-            UString       _name;   //!< Plugin name.
-            Plugin*       _shlib;  //!< Shared library API.
-            PacketBuffer* _buffer; //!< Description of shared packet buffer.
+            UString               _name;        //!< Plugin name.
+            Plugin*               _shlib;       //!< Shared library API.
+            PacketBuffer*         _buffer;      //!< Description of shared packet buffer.
+            PacketMetadataBuffer* _metadata;    //!< Description of shared packet metadata buffer.
+            const bool            _instrument;  //!< Collect timing statistics (monitoring or benchmark is active).
+            Statistics            _stats;       //!< Execution statistics.
+            Monotonic             _call_start;  //!< Time before the last invocation of the plugin (instrumentation).
+            Monotonic             _call_end;    //!< Time after the last invocation of the plugin (instrumentation).
+            uint64_t              _call_allocs; //!< Thread allocations before the last invocation of the plugin (instrumentation).
+            Monotonic             _time_origin; //!< Origin of the input time stamps in the packet metadata.
+            const MilliSecond     _max_latency; //!< Maximum latency; zero means no latency target.
+            SignalizationService* _signalization; //!< Shared signalization service of tsp.
+            size_t                _position;    //!< Position of this plugin in the chain.
+            const UString         _pipeline;    //!< Name of the processing chain in tsp host mode, empty otherwise.
+            MetricCounter*        _metric_packets; //!< Exported counter of packets, zero when metrics are not exported.
+            size_t                _lookahead;   //!< Number of packets to keep in the window after the processed ones.
+
+            //!
+            //! Get the labels which identify this plugin in exported metrics.
+            //! @return The labels of this plugin.
+            //!
+            Metric::Labels metricLabels() const;
+
+            //!
+            //! Apply a pending reconfiguration, if any.
+            //! Must be invoked by the thread of the plugin, between two invocations of the plugin.
+            //! @return False if the plugin could be restarted neither with the new nor with
+            //! the previous arguments, the processing must be aborted.
+            //!
+            bool applyReconfiguration()
+            {
+                return !_reconf_pending || doReconfiguration();
+            }
+
+            //!
+            //! Check if the removal of this executor was requested.
+            //! @return True if the executor must leave the ring.
+            //!
+            bool removeRequested() const
+            {
+                return _remove_request;
+            }
+
+            //!
+            //! Remove this executor from the ring, by the thread of the executor.
+            //! The packets in its sliding window are passed, unprocessed, to the next executor.
+            //!
+            void removeFromRing();
+
+            //!
+            //! Compute the number of packets to process before passing them to the next plugin.
+            //!
+            //! Without latency target, this is @a max_count. With a latency target (tsp option
+            //! -\-max-latency-ms), this is the number of packets which fit in the latency budget
+            //! at the current bitrate, minus the packets which already wait in the next plugin.
+            //! When the next plugin already has a full latency budget of packets to process,
+            //! passing smaller batches would not reduce the latency and @a max_count is used.
+            //!
+            //! @param [in] max_count Maximum number of packets.
+            //! @param [in] bitrate Current bitrate. When zero, the latency budget is unknown and @a max_count is used.
+            //! @return The number of packets to process, between MIN_LATENCY_FLUSH_PKT and @a max_count.
+            //!
+            size_t latencyFlushCount(size_t max_count, BitRate bitrate) const;
+
+            //!
+            //! Build the runs of non-dropped packets in an area of the packet buffer, for output plugins.
+            //! Output plugins use dense arrays of packets. With a padded stride in the packet buffer,
+            //! the non-dropped packets are copied in a dense area and the runs point into this area.
+            //! @param [out] runs Returned runs of non-dropped packets.
+            //! @param [in,out] dense Dense area of packets, enlarged when necessary.
+            //! @param [in] pkt_first Index of the first packet of the area in the buffer.
+            //! @param [in] pkt_cnt Number of packets in the area, not wrapping over the end of the buffer.
+            //! @return The total number of non-dropped packets in @a runs.
+            //!
+            size_t getOutputRuns(TSPacketRunVector& runs, std::vector<TSPacket>& dense, size_t pkt_first, size_t pkt_cnt) const;
+
+            //!
+            //! Record the start of an invocation of the plugin, for instrumentation.
+            //!
+            void startPluginCall()
+            {
+                if (_instrument) {
+                    _call_allocs = ThreadAllocations();
+                    _call_start.getSystemTime();
+                }
+            }
+
+            //!
+            //! Record the end of an invocation of the plugin, for instrumentation.
+            //! @param [in] count Number of packets which were passed to the plugin.
+            //!
+            void endPluginCall(size_t count)
+            {
+                if (_instrument) {
+                    _call_end.getSystemTime();
+                    _stats.plugin_time += _call_end - _call_start;
+                    _stats.calls++;
+                    _stats.packets += count;
+                    _stats.allocations += ThreadAllocations() - _call_allocs;
+                }
+                if (_metric_packets != 0) {
+                    _metric_packets->add(count);
+                }
+            }
 
             //!
             //! Pass processed packets to the next packet processor.
@@ -233,19 +598,92 @@ namespace ts {
                           bool& input_end,
                           bool& aborted);
 
+            //!
+            //! Wait for something to do, including the area after the buffer wrap-over.
+            //! Same as the other waitWork() but, when the circular buffer wrap-over occurs
+            //! in the middle of the caller's area, also return the size of the second part,
+            //! at the beginning of the buffer. This is used by the input processor which
+            //! can receive packets in two segments at once.
+            //! @param [out] pkt_first Index of first packet to process in the buffer.
+            //! @param [out] pkt_cnt Number of packets to process in the buffer, starting at @a pkt_first.
+            //! @param [out] pkt_wrap Number of additional packets to process at the beginning of the buffer.
+            //! @param [out] bitrate Current bitrate, as computed from previous processors.
+            //! @param [out] input_end The previous processor indicates that no more packets will be produced.
+            //! @param [out] aborted The *next* processor indicates that it aborts and will no longer accept packets.
+            //!
+            void waitWork(size_t& pkt_first,
+                          size_t& pkt_cnt,
+                          size_t& pkt_wrap,
+                          BitRate& bitrate,
+                          bool& input_end,
+                          bool& aborted);
+
+            //!
+            //! Get the current work area without waiting.
+            //! This method is used by fused executors which have no thread of their own.
+            //! The parameters are the same as waitWork().
+            //! @param [out] pkt_first Index of first packet to process in the buffer.
+            //! @param [out] pkt_cnt Number of packets to process in the buffer.
+            //! @param [out] bitrate Current bitrate, as computed from previous processors.
+            //! @param [out] input_end The previous processor indicates that no more packets will be produced.
+            //! @param [out] aborted The *next* processor indicates that it aborts and will no longer accept packets.
+            //!
+            void pollWork(size_t& pkt_first,
+                          size_t& pkt_cnt,
+                          BitRate& bitrate,
+                          bool& input_end,
+                          bool& aborted);
+
             // Inherited from Report (via TSP)
             virtual void writeLog(int severity, const UString& msg) override;
 
         private:
-            Report*   _report;   // Common report interface for all plugins
-            Condition _to_do;    // Notify processor to do something
+            Report*    _report;     // Common report interface for all plugins
+            Condition  _to_do;      // Notify processor to do something
+            const bool _lock_free;  // Use atomic cursors instead of the global mutex
+            const bool _fused;      // Executed in the thread of the previous executor
+            const Options::WaitStrategy _wait_strategy;  // How to wait for packets
+            const NanoSecond _spin_time;                 // Busy-poll duration before sleeping
+            Monotonic        _spin_end;                  // End of busy-poll (WAIT_SPIN)
+            Monotonic        _spin_now;                  // Current time during busy-poll (WAIT_SPIN)
 
             // The following private data must be accessed exclusively under the
-            // protection of the global mutex.
-            size_t  _pkt_first;  // Starting index of packets area
-            size_t  _pkt_cnt;    // Size of packets area
-            bool    _input_end;  // No more packet after current ones
-            BitRate _bitrate;    // Input bitrate (set by previous plugin)
+            // protection of the global mutex, unless in lock-free mode.
+            std::atomic<size_t>  _pkt_first;  // Starting index of packets area
+            std::atomic<size_t>  _pkt_cnt;    // Size of packets area
+            std::atomic<bool>    _input_end;  // No more packet after current ones
+            std::atomic<BitRate> _bitrate;    // Input bitrate (set by previous plugin)
+            std::atomic<bool>    _sleeping;   // Lock-free mode: waiting on _to_do
+            std::atomic<bool>    _remove_request;  // The executor must leave the ring
+
+            // Run-time reconfiguration, the request is protected by _reconf_mutex.
+            UStringVector        _args;            // Current arguments of the plugin
+            Mutex                _reconf_mutex;
+            Condition            _reconf_done;     // Signaled when a reconfiguration is applied
+            UStringVector        _reconf_args;     // Requested arguments
+            std::atomic<bool>    _reconf_pending;  // A reconfiguration is requested
+            bool                 _reconf_success;  // Result of the last reconfiguration
+
+            // Apply a pending reconfiguration, see applyReconfiguration().
+            bool doReconfiguration();
+
+            // Check if waitWork() must keep waiting.
+            bool mustWait() const;
+
+            // Busy-poll the sliding window according to the wait strategy, before sleeping.
+            void spinWait();
+
+            // Check if the next executor, or any executor after this one and in the same thread, is aborting.
+            bool nextAborted() const;
+
+            // Get the executor which owns the thread of this one (itself or the first one of its fused group).
+            PluginExecutor* threadOwner();
+
+            // Lock-free mode: wake up a processor if it sleeps.
+            void wakeUp();
+
+            // Get the description of the current work area (common code for waitWork()).
+            void getWork(size_t& pkt_first, size_t& pkt_cnt, size_t& pkt_wrap, BitRate& bitrate, bool& input_end, bool& aborted);
 
             // Inaccessible operations.
             PluginExecutor() = delete;
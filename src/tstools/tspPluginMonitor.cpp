@@ -0,0 +1,248 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  Transport stream processor: Monitoring thread for plugin executors
+//
+//----------------------------------------------------------------------------
+
+#include "tspPluginMonitor.h"
+#include "tsGuardCondition.h"
+#include "tsTime.h"
+TSDUCK_SOURCE;
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const ts::MilliSecond ts::tsp::PluginMonitor::SAMPLING_INTERVAL;
+#endif
+
+// Stack usage for the monitoring thread.
+#define MONITOR_STACK_SIZE (64 * 1024)
+
+
+//----------------------------------------------------------------------------
+// Constructors and destructors.
+//----------------------------------------------------------------------------
+
+ts::tsp::PluginMonitor::Snapshot::Snapshot() :
+    packets(0),
+    calls(0),
+    plugin_time(0),
+    sleeps(0)
+{
+    for (size_t i = 0; i < PluginExecutor::LATENCY_BUCKETS; ++i) {
+        latency[i] = 0;
+    }
+}
+
+ts::tsp::PluginMonitor::PluginMonitor(const Options* options, Report* report, PluginExecutor* input) :
+    Thread(ThreadAttributes().setPriority(ThreadAttributes::GetMinimumPriority()).setStackSize(MONITOR_STACK_SIZE)),
+    _report(report),
+    _interval(options->monitor_interval),
+    _json(options->monitor_json),
+    _executors(),
+    _last(),
+    _window_sum(),
+    _samples(0),
+    _last_time(),
+    _mutex(),
+    _wake_up(),
+    _terminate(false)
+{
+    // Collect all plugin executors, from input to output.
+    PluginExecutor* proc = input;
+    do {
+        _executors.push_back(proc);
+    } while ((proc = proc->ringNext<PluginExecutor>()) != input);
+
+    _last.resize(_executors.size());
+    _window_sum.resize(_executors.size(), 0);
+}
+
+ts::tsp::PluginMonitor::~PluginMonitor()
+{
+    stop();
+}
+
+
+//----------------------------------------------------------------------------
+// Terminate the monitoring thread.
+//----------------------------------------------------------------------------
+
+void ts::tsp::PluginMonitor::stop()
+{
+    {
+        GuardCondition lock(_mutex, _wake_up);
+        _terminate = true;
+        lock.signal();
+    }
+    waitForTermination();
+}
+
+
+//----------------------------------------------------------------------------
+// Thread main code.
+//----------------------------------------------------------------------------
+
+void ts::tsp::PluginMonitor::main()
+{
+    Monotonic now;
+    _last_time.getSystemTime();
+
+    for (;;) {
+
+        // Wait until next sampling time or termination request.
+        bool terminate = false;
+        {
+            GuardCondition lock(_mutex, _wake_up);
+            if (!_terminate) {
+                lock.waitCondition(SAMPLING_INTERVAL);
+            }
+            terminate = _terminate;
+        }
+
+        // Sample the window sizes and report at the end of each interval.
+        // The last interval is always reported when the thread terminates.
+        sampleWindows();
+        now.getSystemTime();
+        if (terminate || now - _last_time >= _interval * NanoSecPerMilliSec) {
+            reportStatistics(now);
+        }
+        if (terminate) {
+            break;
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Sample the window sizes of all executors.
+//----------------------------------------------------------------------------
+
+void ts::tsp::PluginMonitor::sampleWindows()
+{
+    for (size_t i = 0; i < _executors.size(); ++i) {
+        _window_sum[i] += _executors[i]->windowSize();
+    }
+    _samples++;
+}
+
+
+//----------------------------------------------------------------------------
+// Compute a percentile of a latency histogram, in microseconds.
+// The value is interpolated inside the bucket where the percentile falls.
+//----------------------------------------------------------------------------
+
+uint64_t ts::tsp::PluginMonitor::Percentile(const uint64_t* histogram, uint64_t total, uint64_t percent)
+{
+    const uint64_t target = std::max<uint64_t>(1, (total * percent + 99) / 100);
+    uint64_t cumul = 0;
+
+    for (size_t i = 0; i < PluginExecutor::LATENCY_BUCKETS; ++i) {
+        if (histogram[i] > 0 && cumul + histogram[i] >= target) {
+            const uint64_t low = i == 0 ? 0 : uint64_t(1) << i;
+            const uint64_t high = uint64_t(1) << (i + 1);
+            return low + ((high - low) * (target - cumul)) / histogram[i];
+        }
+        cumul += histogram[i];
+    }
+    return 0;
+}
+
+
+//----------------------------------------------------------------------------
+// Report the statistics of the current interval and start a new interval.
+//----------------------------------------------------------------------------
+
+void ts::tsp::PluginMonitor::reportStatistics(const Monotonic& now)
+{
+    const NanoSecond duration = std::max<NanoSecond>(1, now - _last_time);
+    const UString date(Time::CurrentLocalTime().format(Time::DATE | Time::HOUR | Time::MINUTE | Time::SECOND));
+    const UString prefix(u"[MON] " + date + u", ");
+    UString json(UString::Format(u"{\"time\": \"%s\", \"interval-ns\": %d, \"plugins\": [", {date, duration}));
+
+    // Latency histogram of the interval, from the output executor.
+    uint64_t latency[PluginExecutor::LATENCY_BUCKETS];
+    uint64_t latency_total = 0;
+    for (size_t b = 0; b < PluginExecutor::LATENCY_BUCKETS; ++b) {
+        latency[b] = 0;
+    }
+
+    for (size_t i = 0; i < _executors.size(); ++i) {
+
+        // Get a snapshot of the current cumulative statistics.
+        const PluginExecutor::Statistics& stats(_executors[i]->statistics());
+        Snapshot current;
+        current.packets = stats.packets;
+        current.calls = stats.calls;
+        current.plugin_time = stats.plugin_time;
+        current.sleeps = stats.sleeps;
+        for (size_t b = 0; b < PluginExecutor::LATENCY_BUCKETS; ++b) {
+            current.latency[b] = stats.latency[b];
+            latency[b] += current.latency[b] - _last[i].latency[b];
+            latency_total += current.latency[b] - _last[i].latency[b];
+        }
+
+        // Statistics of the interval.
+        const PacketCounter packets = current.packets - _last[i].packets;
+        const uint64_t calls = current.calls - _last[i].calls;
+        const NanoSecond plugin_time = current.plugin_time - _last[i].plugin_time;
+        const uint64_t sleeps = current.sleeps - _last[i].sleeps;
+        const uint64_t window = _samples == 0 ? 0 : _window_sum[i] / _samples;
+        const UString type(i == 0 ? u"input" : (i == _executors.size() - 1 ? u"output" : u"processor"));
+
+        if (_json) {
+            json += UString::Format(u"%s{\"index\": %d, \"name\": \"%s\", \"type\": \"%s\", \"packets\": %d, \"calls\": %d, \"plugin-time-ns\": %d, \"window-average\": %d, \"sleeps\": %d}",
+                                    {i == 0 ? u"" : u", ", i, _executors[i]->pluginName().toJSON(), type, packets, calls, plugin_time, window, sleeps});
+        }
+        else {
+            _report->info(u"%s%d: %s (%s): %'d packets, %'d calls, busy %s, window %'d packets, %'d sleeps",
+                          {prefix, i, _executors[i]->pluginName(), type, packets, calls, UString::Percentage(std::min(plugin_time, duration), duration), window, sleeps});
+        }
+
+        _last[i] = current;
+        _window_sum[i] = 0;
+    }
+
+    // Report the latency from input to output.
+    const uint64_t p50 = Percentile(latency, latency_total, 50);
+    const uint64_t p90 = Percentile(latency, latency_total, 90);
+    const uint64_t p99 = Percentile(latency, latency_total, 99);
+    const uint64_t pmax = Percentile(latency, latency_total, 100);
+
+    if (_json) {
+        json += UString::Format(u"], \"latency-us\": {\"packets\": %d, \"p50\": %d, \"p90\": %d, \"p99\": %d, \"max\": %d}}", {latency_total, p50, p90, p99, pmax});
+        _report->info(json);
+    }
+    else if (latency_total > 0) {
+        _report->info(u"%slatency: p50 %'d us, p90 %'d us, p99 %'d us, max %'d us", {prefix, p50, p90, p99, pmax});
+    }
+
+    // Start a new interval.
+    _samples = 0;
+    _last_time = now;
+}
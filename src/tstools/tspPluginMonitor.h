@@ -0,0 +1,127 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Transport stream processor: Monitoring thread for plugin executors
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tspPluginExecutor.h"
+#include "tsMonotonic.h"
+
+namespace ts {
+    namespace tsp {
+        //!
+        //! Monitoring thread for all plugin executors (tsp option -\-monitor).
+        //!
+        //! The thread periodically samples the size of the sliding window of each
+        //! plugin executor and reports the execution statistics of all plugins:
+        //! number of packets and invocations, time spent in the plugin, time-averaged
+        //! window size, number of waitWork() sleeps and percentiles of the latency of
+        //! the packets from input to output. The report is either a set of text lines
+        //! or one single line in JSON format.
+        //!
+        class PluginMonitor: public Thread
+        {
+        public:
+            //!
+            //! Constructor.
+            //! @param [in] options Command line options for tsp.
+            //! @param [in,out] report Where to report the statistics.
+            //! @param [in] input Input plugin executor, first one in the ring of executors.
+            //!
+            PluginMonitor(const Options* options, Report* report, PluginExecutor* input);
+
+            //!
+            //! Destructor.
+            //! Terminate the monitoring thread.
+            //!
+            virtual ~PluginMonitor() override;
+
+            //!
+            //! Terminate the monitoring thread and wait for its termination.
+            //! A last report is produced when the thread was started.
+            //! Must be invoked before deleting the plugin executors.
+            //!
+            void stop();
+
+            //!
+            //! Interval between two samplings of the window sizes.
+            //!
+            static const MilliSecond SAMPLING_INTERVAL = 10;
+
+        private:
+            // Snapshot of the statistics of one plugin executor.
+            class Snapshot
+            {
+            public:
+                Snapshot();
+                PacketCounter packets;
+                uint64_t      calls;
+                NanoSecond    plugin_time;
+                uint64_t      sleeps;
+                uint64_t      latency[PluginExecutor::LATENCY_BUCKETS];
+            };
+
+            typedef std::vector<PluginExecutor*> ExecutorVector;
+            typedef std::vector<Snapshot> SnapshotVector;
+            typedef std::vector<uint64_t> CounterVector;
+
+            Report*           _report;      // Where to report the statistics.
+            const MilliSecond _interval;    // Reporting interval.
+            const bool        _json;        // Report in JSON format.
+            ExecutorVector    _executors;   // All plugin executors, in chain order.
+            SnapshotVector    _last;        // Statistics at start of the current interval.
+            CounterVector     _window_sum;  // Sum of sampled window sizes in the current interval.
+            uint64_t          _samples;     // Number of window samples in the current interval.
+            Monotonic         _last_time;   // Start time of the current interval.
+            Mutex             _mutex;
+            Condition         _wake_up;     // accessed under mutex
+            bool              _terminate;   // accessed under mutex
+
+            // Inherited from Thread
+            virtual void main() override;
+
+            // Sample the window sizes of all executors.
+            void sampleWindows();
+
+            // Report the statistics of the current interval and start a new interval.
+            void reportStatistics(const Monotonic& now);
+
+            // Compute a percentile of a latency histogram, in microseconds.
+            static uint64_t Percentile(const uint64_t* histogram, uint64_t total, uint64_t percent);
+
+            // Inaccessible operations.
+            PluginMonitor() = delete;
+            PluginMonitor(const PluginMonitor&) = delete;
+            PluginMonitor& operator=(const PluginMonitor&) = delete;
+        };
+    }
+}
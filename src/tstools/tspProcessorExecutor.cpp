@@ -32,8 +32,14 @@
 //----------------------------------------------------------------------------
 
 #include "tspProcessorExecutor.h"
+#include "tsGuardCondition.h"
 TSDUCK_SOURCE;
 
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::tsp::ProcessorExecutor::MIN_CHUNK_PACKETS;
+const size_t ts::tsp::ProcessorExecutor::FUSED_SLICE_PACKETS;
+#endif
+
 
 //----------------------------------------------------------------------------
 // Constructor
@@ -42,12 +48,245 @@ TSDUCK_SOURCE;
 ts::tsp::ProcessorExecutor::ProcessorExecutor(Options* options,
                                               const Options::PluginOptions* pl_options,
                                               const ThreadAttributes& attributes,
-                                              Mutex& global_mutex) :
+                                              Mutex& global_mutex,
+                                              ThreadPool* pool,
+                                              Report* report) :
 
-    PluginExecutor(options, pl_options, attributes, global_mutex),
+    PluginExecutor(options, pl_options, attributes, global_mutex, report),
     _processor(dynamic_cast<ProcessorPlugin*>(_shlib)),
-    _max_flush_pkt(options->max_flush_pkt)
+    _max_flush_pkt(options->max_flush_pkt),
+    _worker_threads(options->worker_threads),
+    _status(),
+    _workers(),
+    _pool(pool),
+    _chunks(),
+    _followers(),
+    _passed_packets(0),
+    _dropped_packets(0),
+    _nullified_packets(0),
+    _metric_passed(0),
+    _metric_dropped(0),
+    _metric_nullified(0),
+    _output_bitrate(0),
+    _bitrate_never_modified(true),
+    _terminated(false),
+    _subscriber(0),
+    _lookahead_first(0),
+    _lookahead_offset(0)
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Register the exported performance counters (inherited from PluginExecutor).
+//----------------------------------------------------------------------------
+
+void ts::tsp::ProcessorExecutor::registerMetrics()
+{
+    PluginExecutor::registerMetrics();
+    MetricsRegistry* const registry = MetricsRegistry::Instance();
+    const Metric::Labels labels(metricLabels());
+    _metric_passed = registry->counter(u"tsp_plugin_passed_packets_total", u"Number of packets which were passed to the next plugin", labels);
+    _metric_dropped = registry->counter(u"tsp_plugin_dropped_packets_total", u"Number of packets which were dropped by the plugin", labels);
+    _metric_nullified = registry->counter(u"tsp_plugin_nullified_packets_total", u"Number of packets which were replaced by null packets", labels);
+}
+
+
+//----------------------------------------------------------------------------
+// Subscribe to the shared signalization (inherited from TSP).
+//----------------------------------------------------------------------------
+
+bool ts::tsp::ProcessorExecutor::subscribeSignalization(TableHandlerInterface* handler, const PIDSet& pids)
+{
+    if (_signalization == 0 || handler == 0) {
+        return false;
+    }
+    else if (_subscriber == 0) {
+        _subscriber = _signalization->subscribe(pluginName(), _position, handler, pids);
+        return _subscriber != 0;
+    }
+    else if (_subscriber->covers(handler, pids)) {
+        // The plugin was restarted after a reconfiguration, keep the subscription.
+        return true;
+    }
+    else {
+        // New PID's after a reconfiguration, the plugin uses its private demux.
+        _signalization->unsubscribe(_subscriber);
+        _subscriber = 0;
+        return false;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Declare a packet lookahead (inherited from TSP).
+//----------------------------------------------------------------------------
+
+void ts::tsp::ProcessorExecutor::setLookahead(size_t count)
+{
+    // The buffer is not yet known when the plugin is started for the first time.
+    // The limit is then applied in startProcessing().
+    _lookahead = _buffer == 0 ? count : std::min(count, _buffer->count() / 2);
+}
+
+
+//----------------------------------------------------------------------------
+// Get a packet after the current slice (inherited from TSP).
+// The packets in our sliding window are never modified by other threads.
+// The window can only grow while the plugin processes the slice.
+//----------------------------------------------------------------------------
+
+const ts::TSPacket* ts::tsp::ProcessorExecutor::lookaheadPacket(size_t index, const TSPacketMetadata** mdata) const
+{
+    if (_lookahead_offset + index >= windowSize()) {
+        return 0;
+    }
+    const size_t i = (_lookahead_first + index) % _buffer->count();
+    if (mdata != 0) {
+        *mdata = _metadata->base() + i;
+    }
+    return &_buffer->base()[i];
+}
+
+
+//----------------------------------------------------------------------------
+// Create the worker threads for packet-parallel processing.
+//----------------------------------------------------------------------------
+
+void ts::tsp::ProcessorExecutor::startWorkers()
+{
+    if (_worker_threads > 1 && _processor->isPacketParallel() && _pool != 0) {
+        // No thread of our own, the chunks are processed by tasks of the shared pool.
+        verbose(u"packet-parallel processing using %d chunks in a pool of %d threads", {_worker_threads, _pool->threadCount()});
+    }
+    else if (_worker_threads > 1 && _processor->isPacketParallel()) {
+
+        // Worker threads use the same stack size and CPU affinity as the plugin thread.
+        ThreadAttributes attr;
+        Thread::getAttributes(attr);
+
+        // The plugin thread processes the first chunk of each slice, the workers process the others.
+        for (size_t i = 1; i < _worker_threads; ++i) {
+            Worker* worker = new Worker(_processor, attr);
+            if (!worker->start()) {
+                delete worker;
+                break;
+            }
+            _workers.push_back(worker);
+        }
+        verbose(u"packet-parallel processing using %d threads", {_workers.size() + 1});
+    }
+    else if (_worker_threads > 1) {
+        debug(u"plugin is not packet-parallel, using one single thread");
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Terminate the worker threads.
+//----------------------------------------------------------------------------
+
+void ts::tsp::ProcessorExecutor::stopWorkers()
+{
+    // The destructor of each worker waits for the termination of its thread.
+    for (WorkerVector::const_iterator it = _workers.begin(); it != _workers.end(); ++it) {
+        delete *it;
+    }
+    _workers.clear();
+}
+
+
+//----------------------------------------------------------------------------
+// Process a complete chunk of a slice which is split for concurrent processing.
+// The plugin may return before the end of the chunk on a flush request but the
+// following chunks are already processed: continue until the end of the chunk.
+// Return the number of processed packets, as processPacketBatch().
+//----------------------------------------------------------------------------
+
+size_t ts::tsp::ProcessorExecutor::ProcessChunk(ProcessorPlugin* processor, const TSPacketView& pkts, TSPacketMetadata* mdata, size_t count, ProcessorPlugin::Status* status, bool& flush, bool& bitrate_changed)
 {
+    size_t done = 0;
+    while (done < count) {
+        const size_t result = processor->processPacketBatch(pkts + done, mdata + done, count - done, status + done, flush, bitrate_changed);
+        if (result == 0) {
+            break;
+        }
+        done += std::min(result, count - done);
+        if (status[done - 1] == ProcessorPlugin::TSP_END && pkts[done - 1].b[0] != 0) {
+            break;
+        }
+    }
+    return done;
+}
+
+
+//----------------------------------------------------------------------------
+// Process a slice of packets, using the worker threads or the shared thread pool when available.
+// Return the number of processed packets, as processPacketBatch().
+//----------------------------------------------------------------------------
+
+size_t ts::tsp::ProcessorExecutor::processSlice(const TSPacketView& pkts, TSPacketMetadata* mdata, size_t count, bool& flush, bool& bitrate_changed)
+{
+    // Number of chunks which can be processed concurrently.
+    const size_t parallel = _pool != 0 && _processor->isPacketParallel() ? _worker_threads : _workers.size() + 1;
+
+    // Split the slice in chunks. Small slices are not split.
+    // The lookahead packets are relative to the complete slice, never split it.
+    const size_t chunk_count = std::min(parallel, count / MIN_CHUNK_PACKETS);
+    if (chunk_count <= 1 || _lookahead > 0) {
+        return _processor->processPacketBatch(pkts, mdata, count, &_status[0], flush, bitrate_changed);
+    }
+    const size_t chunk_size = (count + chunk_count - 1) / chunk_count;
+
+    // Submit all chunks but the first one to the worker threads or the shared pool.
+    size_t chunk_first = chunk_size;
+    size_t started = 0;
+    _chunks.clear();
+    while (chunk_first < count) {
+        const TSPacketView chunk_pkts(pkts + chunk_first);
+        TSPacketMetadata* const chunk_mdata = mdata + chunk_first;
+        ProcessorPlugin::Status* const chunk_status = &_status[chunk_first];
+        const size_t chunk_cnt = std::min(chunk_size, count - chunk_first);
+        if (_pool != 0) {
+            ProcessorPlugin* const processor = _processor;
+            _chunks.push_back(_pool->submit([processor, chunk_pkts, chunk_mdata, chunk_cnt, chunk_status]() {
+                ChunkResult res;
+                res.count = ProcessChunk(processor, chunk_pkts, chunk_mdata, chunk_cnt, chunk_status, res.flush, res.bitrate_changed);
+                return res;
+            }));
+        }
+        else {
+            _workers[started]->startJob(chunk_pkts, chunk_mdata, chunk_cnt, chunk_status);
+        }
+        started++;
+        chunk_first += chunk_size;
+    }
+
+    // Process the first chunk in the plugin thread.
+    size_t result = ProcessChunk(_processor, pkts, mdata, chunk_size, &_status[0], flush, bitrate_changed);
+    bool complete = result >= chunk_size;
+
+    // Wait for all chunks, in order. A chunk which was not completely processed
+    // (TSP_END) invalidates all subsequent chunks.
+    chunk_first = chunk_size;
+    for (size_t i = 0; i < started; ++i) {
+        const size_t chunk_cnt = std::min(chunk_size, count - chunk_first);
+        ChunkResult res;
+        if (_pool != 0) {
+            res = _chunks[i].get();
+        }
+        else {
+            res.count = _workers[i]->waitJob(res.flush, res.bitrate_changed);
+        }
+        if (complete) {
+            flush = flush || res.flush;
+            bitrate_changed = bitrate_changed || res.bitrate_changed;
+            result = chunk_first + std::min(res.count, chunk_cnt);
+            complete = res.count >= chunk_cnt;
+        }
+        chunk_first += chunk_size;
+    }
+    return result;
 }
 
 
@@ -59,122 +298,367 @@ void ts::tsp::ProcessorExecutor::main()
 {
     debug(u"packet processing thread started");
 
-    PacketCounter passed_packets = 0;
-    PacketCounter dropped_packets = 0;
-    PacketCounter nullified_packets = 0;
-    BitRate output_bitrate = _tsp_bitrate;
-    bool bitrate_never_modified = true;
-    bool input_end = false;
-    bool aborted = false;
+    startProcessing();
 
+    bool terminated = false;
     do {
         // Wait for packets to process
-
         size_t pkt_first, pkt_cnt;
-        waitWork (pkt_first, pkt_cnt, _tsp_bitrate, input_end, aborted);
+        bool input_end, aborted;
+        waitWork(pkt_first, pkt_cnt, _tsp_bitrate, input_end, aborted);
+
+        // When removed at run time, leave the ring without processing the pending packets.
+        if (removeRequested()) {
+            removeFromRing();
+            if (_subscriber != 0) {
+                _signalization->unsubscribe(_subscriber);
+                _subscriber = 0;
+            }
+            verbose(u"packet processor removed");
+            break;
+        }
 
-        // If bit rate was never modified by the plugin, always copy the
-        // input bitrate as output bitrate. Otherwise, keep previous
-        // output bitrate, as modified by the plugin.
+        terminated = processWindow(pkt_first, pkt_cnt, input_end, aborted);
+    } while (!terminated);
 
-        if (bitrate_never_modified) {
-            output_bitrate = _tsp_bitrate;
-        }
+    // The end of input or the abort was passed to the fused followers.
+    // Let them process their remaining packets until they terminate.
+    while (runFollowers()) {
+    }
 
-        // If next processor has aborted, abort as well.
-        // We call passPacket to inform our predecessor that we aborted.
+    endProcessing();
+}
 
-        if (aborted) {
-            passPackets (0, output_bitrate, true, true);
-            break;
+
+//----------------------------------------------------------------------------
+// Initialize the processing, in the thread which runs the plugin.
+//----------------------------------------------------------------------------
+
+void ts::tsp::ProcessorExecutor::startProcessing()
+{
+    // Allocate the array of packet statuses for one batch.
+    _status.resize(std::max<size_t>(1, std::min(_max_flush_pkt, _buffer->count())));
+    _output_bitrate = _tsp_bitrate;
+    _lookahead = std::min(_lookahead, _buffer->count() / 2);
+
+    // Create the worker threads for packet-parallel plugins.
+    startWorkers();
+
+    // The leader of a group of fused processors collects its followers.
+    if (!isFused()) {
+        for (PluginExecutor* next = ringNext<PluginExecutor>(); next->isFused(); next = next->ringNext<PluginExecutor>()) {
+            ProcessorExecutor* proc = dynamic_cast<ProcessorExecutor*>(next);
+            assert(proc != 0);
+            proc->startProcessing();
+            _followers.push_back(proc);
+        }
+        if (!_followers.empty()) {
+            debug(u"running %d fused packet processors in this thread", {_followers.size()});
         }
+    }
+}
 
-        // Exit thread if no more packet to process.
-        // We call passPackets to inform our successor of end of input.
 
-        if (pkt_cnt == 0 && input_end) {
-            passPackets (0, output_bitrate, true, false);
-            break;
+//----------------------------------------------------------------------------
+// Terminate the processing, in the thread which runs the plugin.
+//----------------------------------------------------------------------------
+
+void ts::tsp::ProcessorExecutor::endProcessing()
+{
+    // Terminate the worker threads and close the packet processor
+    stopWorkers();
+    _processor->stop();
+    _terminated = true;
+
+    debug(u"packet processing %s after %'d packets, %'d passed, %'d dropped, %'d nullified",
+          {_tsp_aborting ? u"aborted" : u"terminated", totalPackets(), _passed_packets, _dropped_packets, _nullified_packets});
+}
+
+
+//----------------------------------------------------------------------------
+// Process the available packets of all fused followers, in order.
+//----------------------------------------------------------------------------
+
+bool ts::tsp::ProcessorExecutor::runFollowers()
+{
+    bool active = false;
+    for (ExecutorVector::const_iterator it = _followers.begin(); it != _followers.end(); ++it) {
+        ProcessorExecutor* proc = *it;
+        if (!proc->_terminated) {
+            // A fused processor has no thread, never wait for packets.
+            size_t pkt_first, pkt_cnt;
+            bool input_end, aborted;
+            proc->pollWork(pkt_first, pkt_cnt, proc->_tsp_bitrate, input_end, aborted);
+            if ((pkt_cnt > 0 || input_end || aborted) && proc->processWindow(pkt_first, pkt_cnt, input_end, aborted)) {
+                proc->endProcessing();
+            }
+            active = active || !proc->_terminated;
         }
+    }
+    return active;
+}
 
-        // Now process the packets.
 
-        size_t pkt_done = 0;
-        size_t pkt_flush = 0;
+//----------------------------------------------------------------------------
+// Process a window of packets. Return true when the processing is terminated.
+//----------------------------------------------------------------------------
+
+bool ts::tsp::ProcessorExecutor::processWindow(size_t pkt_first, size_t pkt_cnt, bool input_end, bool aborted)
+{
+    // If bit rate was never modified by the plugin, always copy the
+    // input bitrate as output bitrate. Otherwise, keep previous
+    // output bitrate, as modified by the plugin.
+
+    if (_bitrate_never_modified) {
+        _output_bitrate = _tsp_bitrate;
+    }
 
-        while (pkt_done < pkt_cnt) {
+    // If next processor has aborted, abort as well.
+    // We call passPacket to inform our predecessor that we aborted.
+    // Same thing if the plugin cannot be restarted after a reconfiguration.
 
-            bool flush_request = false;
-            TSPacket* pkt = _buffer->base() + pkt_first + pkt_done;
+    if (aborted || !applyReconfiguration()) {
+        passPackets(0, _output_bitrate, true, true);
+        return true;
+    }
 
-            pkt_done++;
-            pkt_flush++;
+    // Exit thread if no more packet to process.
+    // We call passPackets to inform our successor of end of input.
 
-            // If the packet has not already been dropped by a previous
-            // packet processor, apply the processing routine to the packet
+    if (pkt_cnt == 0 && input_end) {
+        passPackets(0, _output_bitrate, true, false);
+        return true;
+    }
 
-            if (pkt->b[0] != 0) {
+    // Now process the packets by slices of at most _max_flush_pkt packets.
+    // Each slice is passed to the next processor after processing, this
+    // is a periodic flush to avoid waiting too long between two outputs.
+    // With a latency target, the slices are smaller at high bitrates.
+    // With fused followers, each slice is immediately processed by them.
 
-                bool bitrate_changed = false;
-                ProcessorPlugin::Status status = _processor->processPacket (*pkt, flush_request, bitrate_changed);
+    size_t pkt_done = 0;
+
+    while (pkt_done < pkt_cnt) {
+
+        // Apply a new configuration, if any, between two invocations of the plugin.
+        if (!applyReconfiguration()) {
+            passPackets(0, _output_bitrate, true, true);
+            return true;
+        }
+
+        const TSPacketView pkt(_buffer->base() + (pkt_first + pkt_done));
+        TSPacketMetadata* mdata = _metadata->base() + pkt_first + pkt_done;
+        size_t slice_cnt = std::min(pkt_cnt - pkt_done, latencyFlushCount(_status.size(), _tsp_bitrate));
+        if (!_followers.empty()) {
+            slice_cnt = std::min(slice_cnt, FUSED_SLICE_PACKETS);
+        }
 
-                // Use the returned status
-                switch (status) {
+        // With a lookahead, keep enough packets after the slice, unless at end of input.
+        // The end of input is read before the window size (see passPackets()).
+        if (_lookahead > 0 && !input_end) {
+            const bool end = inputEnd();
+            const size_t window = windowSize();
+            if (!end) {
+                if (window <= _lookahead) {
+                    // Wait for more packets.
+                    break;
+                }
+                slice_cnt = std::min(slice_cnt, window - _lookahead);
+            }
+        }
+
+        // Deliver the shared signalization tables which are due. The slice
+        // stops before the next packet which completes a table.
+        if (_subscriber != 0) {
+            slice_cnt = _subscriber->scan(totalPackets(), pkt, slice_cnt);
+        }
+        bool flush_request = false;
+        bool bitrate_changed = false;
+
+        // The lookahead packets start after the slice in the sliding window.
+        _lookahead_first = (pkt_first + pkt_done + slice_cnt) % _buffer->count();
+        _lookahead_offset = slice_cnt;
+
+        // Let the plugin process the slice. A flush request is implicitly
+        // honored since the slice is always passed right after processing.
+        startPluginCall();
+        size_t pkt_pass = std::min(slice_cnt, processSlice(pkt, mdata, slice_cnt, flush_request, bitrate_changed));
+        endPluginCall(slice_cnt);
+
+        // Use the returned statuses, except for packets which were
+        // already dropped by a previous packet processor.
+        const PacketCounter previous_passed = _passed_packets;
+        const PacketCounter previous_dropped = _dropped_packets;
+        const PacketCounter previous_nullified = _nullified_packets;
+        for (size_t i = 0; i < pkt_pass; ++i) {
+            if (pkt[i].b[0] != 0) {
+                switch (_status[i]) {
                     case ProcessorPlugin::TSP_OK:
                         // Normal case, pass packet
-                        passed_packets++;
+                        _passed_packets++;
                         break;
                     case ProcessorPlugin::TSP_NULL:
                         // Replace the packet with a complete null packet
-                        *pkt = NullPacket;
-                        nullified_packets++;
+                        pkt[i] = NullPacket;
+                        mdata[i].setNullified(true);
+                        _nullified_packets++;
                         break;
                     case ProcessorPlugin::TSP_DROP:
                         // Drop this packet.
-                        pkt->b[0] = 0;
-                        dropped_packets++;
+                        pkt[i].b[0] = 0;
+                        mdata[i].setDropped(true);
+                        _dropped_packets++;
                         break;
                     case ProcessorPlugin::TSP_END:
                         // Signal end of input to successors and abort
-                        // to predecessors
+                        // to predecessors. Do not pass this packet and
+                        // the following ones.
                         input_end = aborted = true;
-                        pkt_done--;
-                        pkt_flush--;
-                        pkt_cnt = pkt_done;
+                        pkt_pass = i;
+                        pkt_cnt = pkt_done + i;
                         break;
                     default:
                         // Invalid status, report error and accept packet.
-                        error(u"invalid packet processing status %d", {status});
+                        error(u"invalid packet processing status %d", {_status[i]});
                         break;
                 }
-
-                // If the packet processor has signaled a new bitrate, get it.
-                if (bitrate_changed) {
-                    BitRate new_bitrate = _processor->getBitrate();
-                    if (new_bitrate != 0) {
-                        bitrate_never_modified = false;
-                        output_bitrate = new_bitrate;
-                    }
-                }
             }
+        }
 
-            addTotalPackets (1);
-
-            // Do not wait to process pkt_cnt packets before notifying
-            // the next processor. Perform periodic flush to avoid waiting
-            // too long before two output operations.
+        // Update the exported counters once per slice.
+        if (_metric_passed != 0) {
+            _metric_passed->add(_passed_packets - previous_passed);
+            _metric_dropped->add(_dropped_packets - previous_dropped);
+            _metric_nullified->add(_nullified_packets - previous_nullified);
+        }
 
-            if (flush_request || pkt_done == pkt_cnt || pkt_flush % _max_flush_pkt == 0) {
-                passPackets (pkt_flush, output_bitrate, pkt_done == pkt_cnt && input_end, aborted);
-                pkt_flush = 0;
+        // If the packet processor has signaled a new bitrate, get it.
+        if (bitrate_changed) {
+            BitRate new_bitrate = _processor->getBitrate();
+            if (new_bitrate != 0) {
+                _bitrate_never_modified = false;
+                _output_bitrate = new_bitrate;
             }
         }
 
-    } while (!input_end);
+        pkt_done += pkt_pass;
+        addTotalPackets(pkt_pass);
+        passPackets(pkt_pass, _output_bitrate, pkt_done == pkt_cnt && input_end, aborted);
+
+        // Immediately process the slice in the fused followers.
+        runFollowers();
+    }
+
+    return input_end;
+}
+
+
+//----------------------------------------------------------------------------
+// Worker thread constructor and destructor.
+//----------------------------------------------------------------------------
+
+ts::tsp::ProcessorExecutor::Worker::Worker(ProcessorPlugin* processor, const ThreadAttributes& attributes) :
+    Thread(attributes),
+    _processor(processor),
+    _mutex(),
+    _condition(),
+    _pending(false),
+    _terminate(false),
+    _pkts(),
+    _mdata(0),
+    _count(0),
+    _status(0),
+    _result(0),
+    _flush(false),
+    _bitrate_changed(false)
+{
+}
+
+ts::tsp::ProcessorExecutor::Worker::~Worker()
+{
+    // Request the termination of the thread and wait for it.
+    {
+        GuardCondition lock(_mutex, _condition);
+        _terminate = true;
+        lock.signal();
+    }
+    waitForTermination();
+}
+
+
+//----------------------------------------------------------------------------
+// Start the processing of a chunk of packets in the worker thread.
+//----------------------------------------------------------------------------
+
+void ts::tsp::ProcessorExecutor::Worker::startJob(const TSPacketView& pkts, TSPacketMetadata* mdata, size_t count, ProcessorPlugin::Status* status)
+{
+    GuardCondition lock(_mutex, _condition);
+    assert(!_pending);
+    _pkts = pkts;
+    _mdata = mdata;
+    _count = count;
+    _status = status;
+    _pending = true;
+    lock.signal();
+}
+
+
+//----------------------------------------------------------------------------
+// Wait for the completion of the current job in the worker thread.
+//----------------------------------------------------------------------------
+
+size_t ts::tsp::ProcessorExecutor::Worker::waitJob(bool& flush, bool& bitrate_changed)
+{
+    GuardCondition lock(_mutex, _condition);
+    while (_pending) {
+        lock.waitCondition();
+    }
+    flush = _flush;
+    bitrate_changed = _bitrate_changed;
+    return _result;
+}
 
-    // Close the packet processor
-    _processor->stop();
 
-    debug(u"packet processing thread %s after %'d packets, %'d passed, %'d dropped, %'d nullified",
-          {aborted ? u"aborted" : u"terminated", totalPackets(), passed_packets, dropped_packets, nullified_packets});
+//----------------------------------------------------------------------------
+// Worker thread main code.
+//----------------------------------------------------------------------------
+
+void ts::tsp::ProcessorExecutor::Worker::main()
+{
+    for (;;) {
+        TSPacketView pkts;
+        TSPacketMetadata* mdata = 0;
+        ProcessorPlugin::Status* status = 0;
+        size_t count = 0;
+
+        // Wait for a job or a termination request.
+        {
+            GuardCondition lock(_mutex, _condition);
+            while (!_pending && !_terminate) {
+                lock.waitCondition();
+            }
+            if (_terminate) {
+                break;
+            }
+            pkts = _pkts;
+            mdata = _mdata;
+            status = _status;
+            count = _count;
+        }
+
+        // Process the chunk of packets outside the mutex.
+        bool flush = false;
+        bool bitrate_changed = false;
+        const size_t result = ProcessChunk(_processor, pkts, mdata, count, status, flush, bitrate_changed);
+
+        // Report completion.
+        {
+            GuardCondition lock(_mutex, _condition);
+            _result = result;
+            _flush = flush;
+            _bitrate_changed = bitrate_changed;
+            _pending = false;
+            lock.signal();
+        }
+    }
 }
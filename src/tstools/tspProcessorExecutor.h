@@ -34,6 +34,7 @@
 
 #pragma once
 #include "tspPluginExecutor.h"
+#include "tsThreadPool.h"
 
 namespace ts {
     namespace tsp {
@@ -49,11 +50,17 @@ namespace ts {
             //! @param [in] pl_options Command line options for this plugin.
             //! @param [in] attributes Creation attributes for the thread executing this plugin.
             //! @param [in,out] global_mutex Global mutex to synchronize access to the packet buffer.
+            //! @param [in] pool Optional thread pool for packet-parallel processing. When zero and
+            //! the plugin is packet-parallel, the executor creates its own worker threads.
+            //! @param [in,out] report Where to report errors while loading the plugin at run time.
+            //! See ts::tsp::PluginExecutor::PluginExecutor().
             //!
             ProcessorExecutor(Options* options,
                               const Options::PluginOptions* pl_options,
                               const ThreadAttributes& attributes,
-                              Mutex& global_mutex);
+                              Mutex& global_mutex,
+                              ThreadPool* pool = 0,
+                              Report* report = 0);
 
             //!
             //! Access the shared library API.
@@ -62,9 +69,113 @@ namespace ts {
             //!
             ProcessorPlugin* plugin() {return _processor;}
 
+            // Inherited from PluginExecutor.
+            virtual void registerMetrics() override;
+
+            // Inherited from TSP.
+            virtual bool subscribeSignalization(TableHandlerInterface* handler, const PIDSet& pids) override;
+            virtual void setLookahead(size_t count) override;
+            virtual const TSPacket* lookaheadPacket(size_t index, const TSPacketMetadata** mdata = 0) const override;
+
         private:
+            typedef std::vector<ProcessorPlugin::Status> StatusVector;
+
+            // Minimum number of packets per chunk in packet-parallel processing.
+            static const size_t MIN_CHUNK_PACKETS = 64;
+
+            // Maximum number of packets per slice when the plugin thread also runs fused processors.
+            // Small slices remain in the CPU cache from one fused plugin to the next one.
+            static const size_t FUSED_SLICE_PACKETS = 64;
+
+            // Worker thread, processing chunks of packets for packet-parallel plugins.
+            class Worker: public Thread
+            {
+            public:
+                // Constructor and destructor.
+                Worker(ProcessorPlugin* processor, const ThreadAttributes& attributes);
+                virtual ~Worker() override;
+
+                // Start the processing of a chunk of packets.
+                void startJob(const TSPacketView& pkts, TSPacketMetadata* mdata, size_t count, ProcessorPlugin::Status* status);
+
+                // Wait for the completion of the current job. Return the number of processed packets.
+                size_t waitJob(bool& flush, bool& bitrate_changed);
+
+            private:
+                ProcessorPlugin*         _processor;
+                Mutex                    _mutex;            // Protect the job description.
+                Condition                _condition;        // Signaled when a job is submitted or completed.
+                bool                     _pending;          // A job is submitted and not yet completed.
+                bool                     _terminate;        // The worker thread must terminate.
+                TSPacketView             _pkts;             // Job: first packet.
+                TSPacketMetadata*        _mdata;            // Job: first packet metadata.
+                size_t                   _count;            // Job: number of packets.
+                ProcessorPlugin::Status* _status;           // Job: first packet status.
+                size_t                   _result;           // Job result: number of processed packets.
+                bool                     _flush;            // Job result: flush request.
+                bool                     _bitrate_changed;  // Job result: bitrate changed.
+
+                // Inherited from Thread
+                virtual void main() override;
+
+                // Inaccessible operations
+                Worker() = delete;
+                Worker(const Worker&) = delete;
+                Worker& operator=(const Worker&) = delete;
+            };
+            typedef std::vector<Worker*> WorkerVector;
+            typedef std::vector<ProcessorExecutor*> ExecutorVector;
+
+            // Result of the processing of a chunk in a task of a shared thread pool.
+            struct ChunkResult
+            {
+                ChunkResult() : count(0), flush(false), bitrate_changed(false) {}
+                size_t count;
+                bool   flush;
+                bool   bitrate_changed;
+            };
+            typedef std::vector<std::future<ChunkResult>> ChunkFutureVector;
+
             ProcessorPlugin* _processor;
-            size_t const     _max_flush_pkt;   // Max processed packets before flush
+            size_t const     _max_flush_pkt;           // Max processed packets before flush
+            size_t const     _worker_threads;          // Number of threads for packet-parallel processing
+            StatusVector     _status;                  // Packet statuses of one batch
+            WorkerVector     _workers;                 // Worker threads for packet-parallel processing
+            ThreadPool*      _pool;                    // Shared thread pool for packet-parallel processing (instead of _workers)
+            ChunkFutureVector _chunks;                 // Pending chunks in the shared thread pool
+            ExecutorVector   _followers;               // Fused processors which run in this thread
+            PacketCounter    _passed_packets;          // Number of packets passed to next processor
+            PacketCounter    _dropped_packets;         // Number of dropped packets
+            PacketCounter    _nullified_packets;       // Number of packets replaced by null packets
+            MetricCounter*   _metric_passed;           // Exported counters, zero when metrics are not exported
+            MetricCounter*   _metric_dropped;
+            MetricCounter*   _metric_nullified;
+            BitRate          _output_bitrate;          // Bitrate which is passed to next processor
+            bool             _bitrate_never_modified;  // The plugin never modified the bitrate
+            bool             _terminated;              // Processing is terminated (fused processors)
+            SignalizationService::Subscriber* _subscriber; // Subscription to the shared signalization, if any
+            size_t           _lookahead_first;         // Buffer index of the first packet after the current slice
+            size_t           _lookahead_offset;        // Offset of the same packet in the sliding window
+
+            // Initialize and terminate the processing, in the thread which runs the plugin.
+            void startProcessing();
+            void endProcessing();
+
+            // Process a window of packets. Return true when the processing is terminated.
+            bool processWindow(size_t pkt_first, size_t pkt_cnt, bool input_end, bool aborted);
+
+            // Process the available packets of all fused followers. Return true if some are still active.
+            bool runFollowers();
+
+            // Process a slice of packets, using the worker threads or the shared thread pool when available.
+            size_t processSlice(const TSPacketView& pkts, TSPacketMetadata* mdata, size_t count, bool& flush, bool& bitrate_changed);
+
+            // Process a complete chunk of a split slice, even after a flush request.
+            static size_t ProcessChunk(ProcessorPlugin* processor, const TSPacketView& pkts, TSPacketMetadata* mdata, size_t count, ProcessorPlugin::Status* status, bool& flush, bool& bitrate_changed);
+
+            // Create and terminate the worker threads.
+            void startWorkers();
+            void stopWorkers();
 
             // Inherited from Thread
             virtual void main() override;
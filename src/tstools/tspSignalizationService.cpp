@@ -0,0 +1,350 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//
+//  Transport stream processor: Shared signalization demux for plugins
+//
+//----------------------------------------------------------------------------
+
+#include "tspSignalizationService.h"
+#include "tsGuard.h"
+TSDUCK_SOURCE;
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const ts::PacketCounter ts::tsp::SignalizationService::NO_SLOT;
+#endif
+
+
+//----------------------------------------------------------------------------
+// Constructors and destructors.
+//----------------------------------------------------------------------------
+
+ts::tsp::SignalizationService::SignalizationService(Report& report) :
+    _report(report),
+    _mutex(),
+    _demux(this),
+    _pids(),
+    _prepared(false),
+    _feeder(0),
+    _feed_slot(0),
+    _subscribers(),
+    _records(),
+    _first_index(0),
+    _end_index(0)
+{
+}
+
+ts::tsp::SignalizationService::~SignalizationService()
+{
+    for (size_t i = 0; i < _subscribers.size(); ++i) {
+        delete _subscribers[i];
+    }
+    _subscribers.clear();
+}
+
+ts::tsp::SignalizationService::Subscriber::Subscriber(SignalizationService* service, const UString& name, size_t position, TableHandlerInterface* handler, const PIDSet& pids) :
+    _service(service),
+    _name(name),
+    _position(position),
+    _handler(handler),
+    _pids(pids),
+    _private(false),
+    _cursor(0),
+    _next_slot(NO_SLOT),
+    _scan_slot(0),
+    _current_slot(0),
+    _demux(this),
+    _events()
+{
+}
+
+ts::tsp::SignalizationService::Subscriber::~Subscriber()
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Register a new subscriber.
+//----------------------------------------------------------------------------
+
+ts::tsp::SignalizationService::Subscriber* ts::tsp::SignalizationService::subscribe(const UString& name, size_t position, TableHandlerInterface* handler, const PIDSet& pids)
+{
+    // The feeder is selected in prepare(), late subscribers cannot be synchronized.
+    if (_prepared) {
+        return 0;
+    }
+    Subscriber* sub = new Subscriber(this, name, position, handler, pids);
+    _subscribers.push_back(sub);
+    return sub;
+}
+
+
+//----------------------------------------------------------------------------
+// Prepare the service when all subscribers are registered.
+//----------------------------------------------------------------------------
+
+void ts::tsp::SignalizationService::prepare()
+{
+    _prepared = true;
+
+    // A single subscriber does not share anything, it uses its private demux.
+    if (_subscribers.size() == 1) {
+        _subscribers[0]->_private = true;
+        _subscribers[0]->_demux.setPIDFilter(_subscribers[0]->_pids);
+        return;
+    }
+
+    // The feeder is the most upstream subscriber.
+    _pids.reset();
+    _feeder = 0;
+    for (size_t i = 0; i < _subscribers.size(); ++i) {
+        _pids |= _subscribers[i]->_pids;
+        if (_feeder == 0 || _subscribers[i]->_position < _feeder->_position) {
+            _feeder = _subscribers[i];
+        }
+    }
+    _demux.setPIDFilter(_pids);
+
+    if (_feeder != 0) {
+        _report.debug(u"shared signalization: %d subscribers, %d PID's, demux in plugin %s", {_subscribers.size(), _pids.count(), _feeder->_name});
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Feed a packet slot in the shared demux (feeder thread only).
+//----------------------------------------------------------------------------
+
+void ts::tsp::SignalizationService::feed(PacketCounter slot, const TSPacket& pkt)
+{
+    if (pkt.b[0] != 0 && _pids.test(pkt.getPID())) {
+        Guard lock(_mutex);
+        // Record the packet first, then the tables it completes.
+        _records.resize(_records.size() + 1);
+        _records.back().slot = slot;
+        _records.back().packet = pkt;
+        _feed_slot = slot;
+        _demux.feedPacket(pkt);
+        _end_index = _first_index + _records.size();
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Invoked by the shared demux: record the table.
+//----------------------------------------------------------------------------
+
+void ts::tsp::SignalizationService::handleTable(SectionDemux& demux, const BinaryTable& table)
+{
+    // Called in feed(), under the protection of the mutex. The table is copied since
+    // the sections of the demux and the reference counts are not thread-safe.
+    _records.resize(_records.size() + 1);
+    _records.back().slot = _feed_slot;
+    _records.back().table = new BinaryTable(table, COPY);
+}
+
+
+//----------------------------------------------------------------------------
+// Pull the records of a slot for a subscriber.
+//----------------------------------------------------------------------------
+
+bool ts::tsp::SignalizationService::pull(Subscriber* sub, PacketCounter slot, const TSPacket& pkt)
+{
+    // Check if the packet is expected in the records.
+    const bool mine = pkt.b[0] != 0 && sub->_pids.test(pkt.getPID());
+
+    // Fast path: no record for this slot. The records of a slot are all added
+    // by the feeder before the subscriber can see the slot.
+    if ((sub->_next_slot == NO_SLOT && sub->_cursor == _end_index) || (sub->_next_slot != NO_SLOT && sub->_next_slot > slot)) {
+        return !mine;
+    }
+
+    Guard lock(_mutex);
+    const uint64_t end = _first_index + _records.size();
+    bool found = false;
+    bool same = true;
+
+    while (sub->_cursor < end) {
+        const Record& rec(_records[size_t(sub->_cursor - _first_index)]);
+        if (rec.slot > slot) {
+            break;
+        }
+        if (rec.slot == slot) {
+            if (rec.table.isNull()) {
+                // A packet of the shared PID's, check it if it is one of ours.
+                if (sub->_pids.test(rec.packet.getPID())) {
+                    found = true;
+                    same = mine && rec.packet == pkt;
+                }
+            }
+            else if (same && sub->_pids.test(rec.table->sourcePID())) {
+                // Each subscriber gets its own copy, the table is used in its thread.
+                sub->_events.push_back(Subscriber::Event(slot, new BinaryTable(*rec.table, COPY)));
+            }
+        }
+        sub->_cursor++;
+    }
+
+    sub->_next_slot = sub->_cursor < end ? _records[size_t(sub->_cursor - _first_index)].slot : NO_SLOT;
+    cleanup();
+    return same && found == mine;
+}
+
+
+//----------------------------------------------------------------------------
+// Remove a subscriber from the shared demux.
+//----------------------------------------------------------------------------
+
+void ts::tsp::SignalizationService::release(Subscriber* sub)
+{
+    Guard lock(_mutex);
+    sub->_private = true;
+    cleanup();
+}
+
+
+//----------------------------------------------------------------------------
+// Cancel a subscription.
+//----------------------------------------------------------------------------
+
+void ts::tsp::SignalizationService::unsubscribe(Subscriber* sub)
+{
+    // The subscriber no longer pulls records. If it was the feeder, the other
+    // subscribers no longer find their packets in the records and switch to
+    // their private demux.
+    sub->_events.clear();
+    release(sub);
+}
+
+
+//----------------------------------------------------------------------------
+// Check if a subscription applies to a handler and a set of PID's.
+//----------------------------------------------------------------------------
+
+bool ts::tsp::SignalizationService::Subscriber::covers(const TableHandlerInterface* handler, const PIDSet& pids) const
+{
+    return handler == _handler && (pids & ~_pids).none();
+}
+
+
+//----------------------------------------------------------------------------
+// Remove the records which were pulled by all shared subscribers.
+//----------------------------------------------------------------------------
+
+void ts::tsp::SignalizationService::cleanup()
+{
+    uint64_t first = _first_index + _records.size();
+    for (size_t i = 0; i < _subscribers.size(); ++i) {
+        if (!_subscribers[i]->_private) {
+            first = std::min(first, _subscribers[i]->_cursor);
+        }
+    }
+    while (_first_index < first) {
+        _records.pop_front();
+        _first_index++;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Scan the next packets of a subscriber and deliver the tables which are due.
+//----------------------------------------------------------------------------
+
+size_t ts::tsp::SignalizationService::Subscriber::scan(PacketCounter first_slot, const TSPacketView& pkts, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        const PacketCounter slot = first_slot + i;
+
+        // Scan each slot only once.
+        if (slot >= _scan_slot) {
+            scanPacket(slot, pkts[i]);
+            _scan_slot = slot + 1;
+        }
+
+        // Deliver the tables which are completed by this packet, before passing it to the plugin.
+        if (!_events.empty() && _events.front().slot <= slot) {
+            if (i > 0) {
+                // Let the plugin process the previous packets first.
+                return i;
+            }
+            while (!_events.empty() && _events.front().slot <= slot) {
+                const BinaryTablePtr table(_events.front().table);
+                _events.pop_front();
+                _handler->handleTable(_demux, *table);
+            }
+        }
+    }
+    return count;
+}
+
+
+//----------------------------------------------------------------------------
+// Scan one packet slot.
+//----------------------------------------------------------------------------
+
+void ts::tsp::SignalizationService::Subscriber::scanPacket(PacketCounter slot, const TSPacket& pkt)
+{
+    if (_private) {
+        // Dropped packets are not passed to the plugin.
+        if (pkt.b[0] != 0) {
+            _current_slot = slot;
+            _demux.feedPacket(pkt);
+        }
+    }
+    else {
+        if (this == _service->_feeder) {
+            _service->feed(slot, pkt);
+        }
+        if (!_service->pull(this, slot, pkt)) {
+            usePrivateDemux(slot, pkt);
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Switch to the private demux, starting at the specified packet.
+//----------------------------------------------------------------------------
+
+void ts::tsp::SignalizationService::Subscriber::usePrivateDemux(PacketCounter slot, const TSPacket& pkt)
+{
+    _service->_report.verbose(u"%s: signalization modified by previous plugins, using private demux", {_name});
+    _service->release(this);
+    _demux.setPIDFilter(_pids);
+    _private = true;
+    scanPacket(slot, pkt);
+}
+
+
+//----------------------------------------------------------------------------
+// Invoked by the private demux.
+//----------------------------------------------------------------------------
+
+void ts::tsp::SignalizationService::Subscriber::handleTable(SectionDemux& demux, const BinaryTable& table)
+{
+    _events.push_back(Event(_current_slot, new BinaryTable(table, SHARE)));
+}
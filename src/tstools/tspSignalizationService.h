@@ -0,0 +1,226 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//!
+//!  @file
+//!  Transport stream processor: Shared signalization demux for plugins
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsSectionDemux.h"
+#include "tsTablesPtr.h"
+#include "tsTSPacketView.h"
+#include "tsMutex.h"
+#include "tsReport.h"
+#include <atomic>
+
+namespace ts {
+    namespace tsp {
+        //!
+        //! Shared signalization demux for the packet processor plugins of tsp.
+        //!
+        //! Several plugins in a chain typically demux the same PSI/SI tables.
+        //! Instead of using a private SectionDemux, a plugin can subscribe to
+        //! the signalization service with the set of PID's it needs. The tables
+        //! are demuxed once, by the "feeder", the most upstream subscriber, in its
+        //! own thread, on the union of all PID's of all subscribers.
+        //!
+        //! All executors see the same sequence of packet slots in the global buffer.
+        //! The feeder records each packet of the demuxed PID's and each completed
+        //! table, with the index of the slot. Each subscriber scans its own packets,
+        //! in its own thread and delivers each table just before the packet which
+        //! completes it is passed to the plugin. The ordering of the tables relative
+        //! to the packets is consequently the same as with a private demux.
+        //!
+        //! While scanning, a subscriber compares the packets of its PID's with the
+        //! packets which were recorded by the feeder. If a plugin in between modified,
+        //! dropped or inserted a packet in these PID's, the subscriber does not see
+        //! the same stream as the feeder. It then switches to a private demux.
+        //!
+        class SignalizationService : private TableHandlerInterface
+        {
+        public:
+            //!
+            //! Constructor.
+            //! @param [in,out] report Where to report messages.
+            //!
+            SignalizationService(Report& report);
+
+            //!
+            //! Destructor.
+            //!
+            virtual ~SignalizationService() override;
+
+            //!
+            //! Subscriber to the signalization service, one per subscribing plugin.
+            //!
+            class Subscriber : private TableHandlerInterface
+            {
+            public:
+                //!
+                //! Scan the next packets of the subscriber and deliver the tables which are due.
+                //! Must be invoked in the thread of the plugin, before passing packets to the plugin.
+                //! The packets can be scanned several times, only the new ones are actually scanned.
+                //! @param [in] first_slot Index of the first packet in the global sequence of packet slots.
+                //! @param [in] pkts View on the first packet.
+                //! @param [in] count Number of packets.
+                //! @return The number of packets, at least one when @a count is not zero, which can be
+                //! passed to the plugin before the next delivery of tables.
+                //!
+                size_t scan(PacketCounter first_slot, const TSPacketView& pkts, size_t count);
+
+                //!
+                //! Check if the subscription applies to a handler and a set of PID's.
+                //! Used when a plugin subscribes again, after a restart.
+                //! @param [in] handler The object to invoke for each new table.
+                //! @param [in] pids The set of PID's to demux.
+                //! @return True if @a handler is the handler of this subscriber and
+                //! all PID's in @a pids are demuxed for this subscriber.
+                //!
+                bool covers(const TableHandlerInterface* handler, const PIDSet& pids) const;
+
+                //!
+                //! Destructor.
+                //!
+                virtual ~Subscriber() override;
+
+            private:
+                friend class SignalizationService;
+
+                // A table to deliver before a packet slot.
+                struct Event
+                {
+                    PacketCounter slot;
+                    BinaryTablePtr table;
+                    Event(PacketCounter s, const BinaryTablePtr& t) : slot(s), table(t) {}
+                };
+
+                SignalizationService* const _service;
+                const UString           _name;         // Plugin name.
+                const size_t            _position;     // Position of the plugin in the chain.
+                TableHandlerInterface*  _handler;      // Plugin handler.
+                const PIDSet            _pids;         // PID's of the subscriber.
+                bool                    _private;      // Use the private demux.
+                uint64_t                _cursor;       // Absolute index of the next record to pull.
+                PacketCounter           _next_slot;    // Slot of the record at _cursor, NO_SLOT if not yet known.
+                PacketCounter           _scan_slot;    // Next slot to scan.
+                PacketCounter           _current_slot; // Slot which is fed in the private demux.
+                SectionDemux            _demux;        // Private demux.
+                std::deque<Event>       _events;       // Tables to deliver.
+
+                // Constructor, from the service only.
+                Subscriber(SignalizationService* service, const UString& name, size_t position, TableHandlerInterface* handler, const PIDSet& pids);
+
+                // Scan one packet slot.
+                void scanPacket(PacketCounter slot, const TSPacket& pkt);
+
+                // Switch to the private demux, starting at the specified packet.
+                void usePrivateDemux(PacketCounter slot, const TSPacket& pkt);
+
+                // Invoked by the private demux.
+                virtual void handleTable(SectionDemux&, const BinaryTable&) override;
+
+                // Inaccessible operations.
+                Subscriber() = delete;
+                Subscriber(const Subscriber&) = delete;
+                Subscriber& operator=(const Subscriber&) = delete;
+            };
+
+            //!
+            //! Register a new subscriber.
+            //! Must be invoked before prepare(), typically when the plugins are started.
+            //! @param [in] name Name of the subscribing plugin.
+            //! @param [in] position Position of the plugin in the chain.
+            //! @param [in] handler The object to invoke for each new table.
+            //! @param [in] pids The set of PID's to demux.
+            //! @return The new subscriber, owned by the service, or zero when
+            //! the service is already prepared.
+            //!
+            Subscriber* subscribe(const UString& name, size_t position, TableHandlerInterface* handler, const PIDSet& pids);
+
+            //!
+            //! Cancel a subscription, when the plugin is removed or no longer uses it.
+            //! The subscriber no longer delivers tables and must no longer be used.
+            //! Must be invoked in the thread of the plugin.
+            //! @param [in] sub The subscriber to cancel.
+            //!
+            void unsubscribe(Subscriber* sub);
+
+            //!
+            //! Prepare the service when all subscribers are registered.
+            //! Must be invoked before the processing of packets.
+            //!
+            void prepare();
+
+        private:
+            // Value of Subscriber::_next_slot when unknown.
+            static const PacketCounter NO_SLOT = ~PacketCounter(0);
+
+            // Recorded packet or table, in the order of the packet slots.
+            // A record with a null table is a packet record.
+            struct Record
+            {
+                PacketCounter      slot;
+                TSPacket           packet;
+                BinaryTablePtr     table;
+            };
+
+            Report&                  _report;
+            Mutex                    _mutex;        // Protect the records.
+            SectionDemux             _demux;        // Shared demux, used in the feeder thread.
+            PIDSet                   _pids;         // Union of the PID's of all shared subscribers.
+            bool                     _prepared;     // All subscribers are known.
+            Subscriber*              _feeder;       // Most upstream shared subscriber.
+            PacketCounter            _feed_slot;    // Slot which is fed in the shared demux.
+            std::vector<Subscriber*> _subscribers;  // All subscribers.
+            std::deque<Record>       _records;      // Recorded packets and tables, not yet pulled by all subscribers.
+            uint64_t                 _first_index;  // Absolute index of the first record.
+            std::atomic<uint64_t>    _end_index;    // Absolute index after the last record.
+
+            // Feed a packet slot in the shared demux (feeder thread only).
+            void feed(PacketCounter slot, const TSPacket& pkt);
+
+            // Pull the records of a slot for a subscriber. Return false if a packet on the PID's of the subscriber differs.
+            bool pull(Subscriber* sub, PacketCounter slot, const TSPacket& pkt);
+
+            // Remove a subscriber from the shared demux (it uses a private demux).
+            void release(Subscriber* sub);
+
+            // Remove the records which were pulled by all shared subscribers. Must be called under the protection of the mutex.
+            void cleanup();
+
+            // Invoked by the shared demux.
+            virtual void handleTable(SectionDemux&, const BinaryTable&) override;
+
+            // Inaccessible operations.
+            SignalizationService() = delete;
+            SignalizationService(const SignalizationService&) = delete;
+            SignalizationService& operator=(const SignalizationService&) = delete;
+        };
+    }
+}
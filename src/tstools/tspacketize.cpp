@@ -34,7 +34,7 @@
 #include "tsArgs.h"
 #include "tsSectionFile.h"
 #include "tsFileNameRate.h"
-#include "tsOutputRedirector.h"
+#include "tsTSFileBlockWriter.h"
 #include "tsCyclingPacketizer.h"
 #include "tsSysUtils.h"
 #include "tsVersionInfo.h"
@@ -50,6 +50,7 @@ struct Options: public ts::Args
     Options(int argc, char *argv[]);
 
     bool                      continuous; // Continuous packetization
+    bool                      tight;      // Tight packing of sections
     ts::CyclingPacketizer::StuffingPolicy stuffing_policy;
     ts::CRC32::Validation     crc_op;     // Validate/recompute CRC32
     ts::PID                   pid;        // Target PID
@@ -62,6 +63,7 @@ struct Options: public ts::Args
 Options::Options(int argc, char *argv[]) :
     ts::Args(u"Packetize PSI/SI sections in a transport stream PID.", u"[options] [input-file[=rate] ...]"),
     continuous(false),
+    tight(false),
     stuffing_policy(ts::CyclingPacketizer::NEVER),
     crc_op(ts::CRC32::COMPUTE),
     pid(ts::PID_NULL),
@@ -78,6 +80,7 @@ Options::Options(int argc, char *argv[]) :
     option(u"output",     'o', Args::STRING);
     option(u"pid",        'p', Args::PIDVAL, 1, 1);
     option(u"stuffing",   's');
+    option(u"tight-packing", 0);
     option(u"xml",         0);
 
     setHelp(u"Input files:\n"
@@ -131,7 +134,14 @@ Options::Options(int argc, char *argv[]) :
             u"      Insert stuffing at end of each section, up to the next TS packet\n"
             u"      boundary. By default, sections are packed and start in the middle\n"
             u"      of a TS packet, after the previous section. Note, however, that\n"
-            u"      section headers are never scattered over a packet boundary.\n"
+            u"      section headers are never scattered over a packet boundary, see also\n"
+            u"      --tight-packing.\n"
+            u"\n"
+            u"  --tight-packing\n"
+            u"      When sections are packed, start a section in the middle of a TS packet\n"
+            u"      as long as at least one byte remains after the pointer_field, even if\n"
+            u"      the section header is split over two TS packets. This reduces the\n"
+            u"      stuffing in the PID. Some old receivers may not support it.\n"
             u"\n"
             u"  -v\n"
             u"  --verbose\n"
@@ -146,6 +156,7 @@ Options::Options(int argc, char *argv[]) :
     analyze(argc, argv);
 
     continuous = present(u"continuous");
+    tight = present(u"tight-packing");
     if (present(u"stuffing")) {
         stuffing_policy = ts::CyclingPacketizer::ALWAYS;
     }
@@ -188,10 +199,18 @@ int main(int argc, char *argv[])
 {
     TSDuckLibCheckVersion();
     Options opt(argc, argv);
-    ts::OutputRedirector output(opt.outfile, opt);
+    ts::TSFileOutput outfile;
+    ts::TSFileBlockWriter output(outfile);
     ts::CyclingPacketizer pzer(opt.pid, opt.stuffing_policy, opt.bitrate);
+    pzer.setTightPacking(opt.tight);
     ts::SectionFile file;
 
+    // Create the output file before loading sections, the packets are written in large blocks.
+
+    if (!outfile.open(opt.outfile, false, false, opt)) {
+        return EXIT_FAILURE;
+    }
+
     // Load sections
 
     if (opt.infiles.size() == 0) {
@@ -230,20 +249,29 @@ int main(int argc, char *argv[])
         pzer.display(std::cerr);
     }
 
-    // Generate packets
+    // Generate packets directly in the output buffer, one block at a time.
+    // The packets of repeated sections come from the packetizer cache.
 
-    ts::TSPacket pkt;
-    ts::PacketCounter count = 0;
-
-    do {
-        pzer.getNextPacket(pkt);
-        pkt.write(std::cout, opt);
-        count++;
-    } while (opt.valid() && (opt.continuous || !pzer.atCycleBoundary()));
+    const size_t block_size = output.getBlockSize();
+    bool more = true;
 
+    while (more) {
+        ts::TSPacket* pkt = output.reserve(block_size, opt);
+        if (pkt == 0) {
+            break; // write error
+        }
+        size_t count = 0;
+        while (more && count < block_size) {
+            pzer.getNextPacket(pkt[count++]);
+            more = opt.continuous || !pzer.atCycleBoundary();
+        }
+        output.commit(count);
+    }
+    output.flush(opt);
+    outfile.close(opt);
 
     if (opt.verbose()) {
-        std::cerr << "* Generated " << ts::UString::Decimal(count) << " TS packets" << std::endl;
+        std::cerr << "* Generated " << ts::UString::Decimal(output.getPacketCount()) << " TS packets" << std::endl;
     }
     if (opt.debug()) {
         std::cerr << "* After packetization:" << std::endl;
@@ -34,6 +34,10 @@
 #include "tsArgs.h"
 #include "tsInputRedirector.h"
 #include "tsPSILogger.h"
+#include "tsReportWithPrefix.h"
+#include "tsSyncReport.h"
+#include "tsThreadPool.h"
+#include "tsSysUtils.h"
 #include "tsVersionInfo.h"
 TSDUCK_SOURCE;
 
@@ -52,59 +56,185 @@ struct Options: public ts::Args
 {
     Options(int argc, char *argv[]);
 
-    ts::UString           infile;   // Input file name
+    ts::UStringVector     infiles;  // Input file names.
+    ts::UString           outdir;   // Output directory in batch mode.
+    bool                  batch;    // Batch mode, one output file per input file.
+    size_t                jobs;     // Number of files to process in parallel.
     ts::PSILoggerArgs     logger;   // Table logging options
     ts::TablesDisplayArgs display;  // Table formatting options.
 };
 
 Options::Options(int argc, char *argv[]) :
-    ts::Args(u"MPEG Transport Stream PSI Extraction Utility.", u"[options] [filename]"),
-    infile(),
+    ts::Args(u"MPEG Transport Stream PSI Extraction Utility.", u"[options] [filename ...]"),
+    infiles(),
+    outdir(),
+    batch(false),
+    jobs(1),
     logger(),
     display()
 {
-    option(u"", 0, STRING, 0, 1);
+    option(u"",                 0,  STRING);
+    option(u"file-list",        0,  STRING);
+    option(u"jobs",            'j', UNSIGNED);
+    option(u"output-directory", 0,  STRING);
     logger.defineOptions(*this);
     display.defineOptions(*this);
 
-    setHelp(u"Input file:\n"
+    setHelp(u"Input files:\n"
             u"\n"
-            u"  MPEG capture file (standard input if omitted).\n");
+            u"  MPEG capture files (standard input if omitted). File names may contain\n"
+            u"  wildcards. When more than one input file is specified, the tool runs in\n"
+            u"  batch mode: the files are independently analyzed and the output of each\n"
+            u"  input file is written in a separate text file with the same name and\n"
+            u"  extension .txt.\n"
+            u"\n"
+            u"Batch mode options:\n"
+            u"\n"
+            u"  --file-list filename\n"
+            u"      A text file containing a list of input files, one file name per line.\n"
+            u"      This option implies batch mode.\n"
+            u"\n"
+            u"  -j count\n"
+            u"  --jobs count\n"
+            u"      Number of input files which are processed in parallel. The default is 1,\n"
+            u"      the files are processed one after the other. The value zero means the\n"
+            u"      number of CPU's in the system.\n"
+            u"\n"
+            u"  --output-directory path\n"
+            u"      Directory where the output files are created. By default, the output\n"
+            u"      file of each input file is created in the same directory as the input\n"
+            u"      file. This option implies batch mode.\n");
     logger.addHelp(*this);
     display.addHelp(*this);
 
     analyze(argc, argv);
 
-    infile = value(u"");
+    // Expand wildcards, the shell may not do it or the command line may be too long.
+    ts::UStringVector params;
+    getValues(params, u"");
+    for (ts::UStringVector::const_iterator it = params.begin(); it != params.end(); ++it) {
+        if (it->find_first_of(u"*?") == ts::UString::NPOS) {
+            infiles.push_back(*it);
+        }
+        else {
+            ts::ExpandWildcardAndAppend(infiles, *it);
+        }
+    }
+
+    // Load the list of input files.
+    const ts::UString list(value(u"file-list"));
+    if (!list.empty()) {
+        ts::UStringVector names;
+        if (!ts::UString::Load(names, list)) {
+            error(u"error reading file list %s", {list});
+        }
+        for (ts::UStringVector::iterator it = names.begin(); it != names.end(); ++it) {
+            it->trim();
+            if (!it->empty()) {
+                infiles.push_back(*it);
+            }
+        }
+    }
+
+    outdir = value(u"output-directory");
+    jobs = intValue<size_t>(u"jobs", 1);
+    batch = infiles.size() > 1 || !list.empty() || !outdir.empty();
     logger.load(*this);
     display.load(*this);
 
+    if (batch && !logger.output.empty()) {
+        error(u"--output-file cannot be used in batch mode, see --output-directory");
+    }
+    if (!outdir.empty() && !ts::IsDirectory(outdir)) {
+        error(u"directory %s not found", {outdir});
+    }
+    if (batch && std::find(infiles.begin(), infiles.end(), ts::UString()) != infiles.end()) {
+        error(u"standard input cannot be used in batch mode");
+    }
+
     exitOnError();
 }
 
 
 //----------------------------------------------------------------------------
-//  Program entry point
+//  Process one input file in batch mode. Return true on success.
+//  All messages go to the specified report, the files may be processed in parallel.
 //----------------------------------------------------------------------------
 
-int main (int argc, char *argv[])
+bool ProcessFile(Options& opt, ts::Report& log, const ts::UString& infile)
 {
-    TSDuckLibCheckVersion();
-    Options opt(argc, argv);
-    ts::InputRedirector input(opt.infile, opt);
-    ts::TablesDisplay display(opt.display, opt);
-    ts::PSILogger logger(opt.logger, display, opt);
+    // Each file has its own demux, display and output file.
+    ts::PSILoggerArgs args(opt.logger);
+    args.output = ts::PathPrefix(infile) + u".txt";
+    if (!opt.outdir.empty()) {
+        args.output = opt.outdir + ts::PathSeparator + ts::BaseName(args.output);
+    }
+
+    std::ifstream strm(infile.toUTF8().c_str(), std::ios::in | std::ios::binary);
+    if (!strm) {
+        log.error(u"cannot open file %s", {infile});
+        return false;
+    }
+
+    log.verbose(u"analyzing %s to %s", {infile, args.output});
+    ts::ReportWithPrefix report(log, ts::BaseName(infile) + u": ");
+    ts::TablesDisplay display(opt.display, report);
+    ts::PSILogger logger(args, display, report);
     ts::TSPacket pkt;
 
-    // Read all packets in the file and pass them to the logger
-    while (!logger.completed() && pkt.read(std::cin, true, opt)) {
+    while (!logger.completed() && pkt.read(strm, true, report)) {
         logger.feedPacket(pkt);
     }
-
-    // Report errors
     if (opt.verbose()) {
         logger.reportDemuxErrors();
     }
+    return !logger.hasErrors();
+}
+
+
+//----------------------------------------------------------------------------
+//  Program entry point
+//----------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+    TSDuckLibCheckVersion();
+    Options opt(argc, argv);
 
-    return EXIT_SUCCESS;
+    if (!opt.batch) {
+        ts::InputRedirector input(opt.infiles.empty() ? ts::UString() : opt.infiles.front(), opt);
+        ts::TablesDisplay display(opt.display, opt);
+        ts::PSILogger logger(opt.logger, display, opt);
+        ts::TSPacket pkt;
+
+        // Read all packets in the file and pass them to the logger
+        while (!logger.completed() && pkt.read(std::cin, true, opt)) {
+            logger.feedPacket(pkt);
+        }
+
+        // Report errors
+        if (opt.verbose()) {
+            logger.reportDemuxErrors();
+        }
+        return EXIT_SUCCESS;
+    }
+    else if (opt.jobs == 1 || opt.infiles.size() < 2) {
+        bool ok = true;
+        for (size_t i = 0; i < opt.infiles.size(); ++i) {
+            ok = ProcessFile(opt, opt, opt.infiles[i]) && ok;
+        }
+        return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    else {
+        // Process files in parallel. The names and tables factory are shared, read-only, between threads.
+        ts::SyncReport log(opt);
+        ts::ThreadPool pool(opt.jobs);
+        std::atomic<bool> allOk(true);
+        pool.parallelFor(0, opt.infiles.size(), [&opt, &log, &allOk](size_t i) {
+            if (!ProcessFile(opt, log, opt.infiles[i])) {
+                allOk = false;
+            }
+        }, 1);
+        return allOk ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
 }
@@ -35,6 +35,7 @@
 #include "tsInputRedirector.h"
 #include "tsOutputRedirector.h"
 #include "tsByteBlock.h"
+#include "tsMemoryUtils.h"
 #include "tsFatal.h"
 #include "tsMPEG.h"
 #include "tsVersionInfo.h"
@@ -180,9 +181,10 @@ public:
     }
 
     // Look for MPEG packets in a buffer, according to an assumed packet size.
-    // If the complete buffer matches the packet size, set input and output packet
-    // sizes and return true. Return false otherwise.
-    bool checkSync(const uint8_t* buf, size_t buf_size, size_t pkt_size, size_t header_size);
+    // Search the first slice of search_size bytes which contains only packets of that size,
+    // starting before start if start is not null. If found, update start, set input and
+    // output packet sizes and return true. Return false otherwise.
+    bool findSync(const uint8_t* buf, size_t buf_size, size_t search_size, size_t pkt_size, size_t header_size, const uint8_t*& start);
 
     // Get packet sizes, as determined by checkSync(). Size is zero if no valid packet size found.
     size_t inputPacketSize() const {return _in_pkt_size;}
@@ -201,8 +203,9 @@ public:
     // Read input data, return read size (zero on end of file or error)
     size_t readData(uint8_t* buf, size_t size);
 
-    // Write one output packet from input packet.
-    bool writePacket(const uint8_t* input_packet);
+    // Write all contiguous valid packets from the start of a buffer, in one single output
+    // operation. The buffer content is modified. Return the number of consumed input bytes.
+    size_t writePackets(uint8_t* buf, size_t size);
 
     // Constructor
     Resynchronizer(bool keep_packet_size) :
@@ -236,12 +239,12 @@ size_t Resynchronizer::readData(uint8_t* buf, size_t size)
     std::streamsize got = 0;
     std::streamsize remain = std::streamsize(size);
     while (remain > 0) {
-        if (std::cin.read(reinterpret_cast <char*> (buf + got), remain)) {
-            const std::streamsize count = std::cin.gcount();
-            got += count;
-            remain -= count;
-        }
-        else {
+        // Also count the last partial read on end of file.
+        const bool ok = bool(std::cin.read(reinterpret_cast<char*>(buf + got), remain));
+        const std::streamsize count = std::cin.gcount();
+        got += count;
+        remain -= count;
+        if (!ok) {
             if (got == 0) {
                 _status = RS_EOF;
             }
@@ -253,21 +256,36 @@ size_t Resynchronizer::readData(uint8_t* buf, size_t size)
 
 
 //----------------------------------------------------------------------------
-// Write one output packet from input packet.
+// Write all contiguous valid packets from the start of a buffer.
 //----------------------------------------------------------------------------
 
-bool Resynchronizer::writePacket(const uint8_t* input_packet)
+size_t Resynchronizer::writePackets(uint8_t* buf, size_t size)
 {
-    const char* out_pkt = reinterpret_cast<const char*>(input_packet + _in_header_size - _out_header_size);
-    if (std::cout.write(out_pkt, std::streamsize(_out_pkt_size))) {
-        _out_size += _out_pkt_size;
-        return true;
+    // Compact output packets at the beginning of the buffer, when necessary.
+    // The output packets are never larger than input packets.
+    uint8_t* out = buf;
+    size_t in_size = 0;
+    while (in_size + _in_pkt_size <= size && buf[in_size + _in_header_size] == ts::SYNC_BYTE) {
+        const uint8_t* const out_pkt = buf + in_size + _in_header_size - _out_header_size;
+        if (out != out_pkt) {
+            ::memmove(out, out_pkt, _out_pkt_size);
+        }
+        out += _out_pkt_size;
+        in_size += _in_pkt_size;
     }
-    else {
-        std::cerr << "* Error writing output file" << std::endl;
-        _status = RS_ERROR;
-        return false;
+
+    // Write all output packets at once.
+    const std::streamsize out_size = std::streamsize(out - buf);
+    if (out_size > 0) {
+        if (std::cout.write(reinterpret_cast<const char*>(buf), out_size)) {
+            _out_size += out_size;
+        }
+        else {
+            std::cerr << "* Error writing output file" << std::endl;
+            _status = RS_ERROR;
+        }
     }
+    return in_size;
 }
 
 
@@ -275,20 +293,30 @@ bool Resynchronizer::writePacket(const uint8_t* input_packet)
 //  Look for MPEG packets in a buffer, according to an assumed packet size.
 //----------------------------------------------------------------------------
 
-bool Resynchronizer::checkSync(const uint8_t* buf, size_t buf_size, size_t pkt_size, size_t header_size)
+bool Resynchronizer::findSync(const uint8_t* buf, size_t buf_size, size_t search_size, size_t pkt_size, size_t header_size, const uint8_t*& start)
 {
     assert(pkt_size >= header_size + ts::PKT_SIZE);
-    const uint8_t* end = buf + buf_size - pkt_size + 1;
-
-    // Check if the buffer contains packets with the appropriate size
-    while (buf < end) {
-        if (buf[header_size] != ts::SYNC_BYTE) {
-            return false; // not found
+    assert(search_size <= buf_size);
+
+    // A slice of search_size bytes contains search_size / pkt_size packets to check.
+    // The candidate slices start at all offsets up to buf_size - search_size.
+    // Don't search beyond an already found start with another packet size.
+    const size_t count = search_size / pkt_size;
+    size_t last = buf_size - search_size;
+    if (start != 0) {
+        if (start == buf) {
+            return false;
         }
-        buf += pkt_size;
+        last = std::min<size_t>(last, start - buf - 1);
+    }
+
+    const uint8_t* const found = reinterpret_cast<const uint8_t*>(ts::LocateSyncBytes(buf, last + count * pkt_size, pkt_size, header_size, count, ts::SYNC_BYTE));
+    if (found == 0) {
+        return false; // not found
     }
 
-    // Packets found all along the buffer
+    // Packets found all along the slice
+    start = found;
     _in_pkt_size = pkt_size;
     _in_header_size = header_size;
     _out_pkt_size = _keep_packet_size ? pkt_size : ts::PKT_SIZE;
@@ -335,31 +363,21 @@ int main(int argc, char *argv[])
 
         // Look for a range of packets for at least --min-contiguous bytes
         size_t const search_size = std::min(opt.contig_size, sync_size);
-        uint8_t* const end_search = sync_end - search_size + 1;
-
-        // Search a range of valid packets. Try all expected packet sizes.
-        const uint8_t* start;
-        for (start = sync_buf; start < end_search; start++) {
-            if (opt.packet_size > 0) {
-                if (resync.checkSync(start, search_size, opt.packet_size, opt.header_size)) {
-                    // Found user-specified encapsulation of TS packets
-                    break;
-                }
-            }
-            else {
-                if (resync.checkSync(start, search_size, ts::PKT_SIZE, 0)) {
-                    // Found standard TS packets
-                    break;
-                }
-                if (resync.checkSync(start, search_size, ts::PKT_RS_SIZE, 0)) {
-                    // Found TS packets with trailing Reed-Solomon outer FEC
-                    break;
-                }
-                if (resync.checkSync(start, search_size, ts::PKT_M2TS_SIZE, ts::M2TS_HEADER_SIZE)) {
-                    // Found TS packets with leading 4-byte timestamp (M2TS format, blu-ray discs)
-                    break;
-                }
-            }
+
+        // Search a range of valid packets. Try all expected packet sizes. The first range wins.
+        // With the same start, the first packet size is used.
+        const uint8_t* start = 0;
+        if (opt.packet_size > 0) {
+            // User-specified encapsulation of TS packets
+            resync.findSync(sync_buf, sync_size, search_size, opt.packet_size, opt.header_size, start);
+        }
+        else {
+            // Standard TS packets
+            resync.findSync(sync_buf, sync_size, search_size, ts::PKT_SIZE, 0, start);
+            // TS packets with trailing Reed-Solomon outer FEC
+            resync.findSync(sync_buf, sync_size, search_size, ts::PKT_RS_SIZE, 0, start);
+            // TS packets with leading 4-byte timestamp (M2TS format, blu-ray discs)
+            resync.findSync(sync_buf, sync_size, search_size, ts::PKT_M2TS_SIZE, ts::M2TS_HEADER_SIZE, start);
         }
         if (resync.inputPacketSize() == 0) {
             std::cerr << "* Cannot find MPEG TS packets after " << ts::UString::Decimal(search_size) << " bytes" << std::endl;
@@ -375,51 +393,58 @@ int main(int argc, char *argv[])
             std::cerr << std::endl;
         }
 
-        // Output initial sync buffer, starting at first valid packet, writing all valid packets
-        while (start <= sync_end - resync.inputPacketSize() && start[resync.inputHeaderSize()] == ts::SYNC_BYTE) {
-            if (!resync.writePacket(start)) {
-                break;
-            }
-            start += resync.inputPacketSize();
-        }
-        if (resync.status() != RS_OK) {
+        // Output all valid packets, starting at first valid packet in the sync buffer.
+        // Then read the rest of the input file by large blocks in the sync buffer.
+        size_t data_size = sync_end - start;
+        uint8_t* data = sync_buf + (start - sync_buf);
+        bool eof = read_size < sync_buf_size - sync_pre_size;
+        bool initial = true;
+
+        // Already at end of input file, output the remaining valid packets.
+        if (resync.status() == RS_EOF) {
+            resync.writePackets(data, data_size);
             break;
         }
 
-        // Compact sync buffer
-        if (start >= sync_end) {
-            sync_pre_size = 0;
-        }
-        else {
-            sync_pre_size = sync_end - start;
-            ::memmove(sync_buf, start, sync_pre_size);
-        }
+        while (resync.status() == RS_OK) {
 
-        // If more than one packet left, out of sync
-        if (sync_pre_size >= resync.inputPacketSize()) {
-            resync.setStatus(RS_SYNC_LOST);
-        }
+            // Write all valid packets at once.
+            const size_t size = resync.writePackets(data, data_size);
+            data += size;
+            data_size -= size;
 
-        // Read the rest of the input file
-        while (resync.status() == RS_OK) {
-            assert(sync_pre_size < resync.inputPacketSize());
-            // Read the next packet
-            const size_t remain_size = resync.inputPacketSize() - sync_pre_size;
-            if (resync.readData(sync_buf + sync_pre_size, remain_size) != remain_size) {
-                resync.setStatus(RS_EOF);
+            // If more than one packet left, out of sync.
+            if (resync.status() != RS_OK) {
+                break;
             }
-            else if (sync_buf[resync.inputHeaderSize()] != ts::SYNC_BYTE) {
-                std::cerr << ts::UString::Format(u"*** Synchronization lost after %'d TS packets", {resync.outputFilePackets()}) << std::endl
-                          << ts::UString::Format(u"*** Got 0x%X instead of 0x%X at start of TS packet", {sync_buf[resync.inputHeaderSize()], ts::SYNC_BYTE}) << std::endl;
-                resync.setStatus(RS_SYNC_LOST);
+            else if (data_size >= resync.inputPacketSize()) {
+                if (!initial) {
+                    std::cerr << ts::UString::Format(u"*** Synchronization lost after %'d TS packets", {resync.outputFilePackets()}) << std::endl
+                              << ts::UString::Format(u"*** Got 0x%X instead of 0x%X at start of TS packet", {data[resync.inputHeaderSize()], ts::SYNC_BYTE}) << std::endl;
+                }
                 // Will resynchronize with sync buffer pre-loaded
-                sync_pre_size = resync.inputPacketSize();
+                resync.setStatus(RS_SYNC_LOST);
+            }
+            else if (eof) {
+                resync.setStatus(RS_EOF);
+            }
+
+            // Compact sync buffer
+            if (data_size > 0 && data > sync_buf) {
+                ::memmove(sync_buf, data, data_size);
             }
-            else {
-                resync.writePacket(sync_buf);
-                sync_pre_size = 0;
+            data = sync_buf;
+            initial = false;
+
+            // Read the next block of input file
+            if (resync.status() == RS_OK) {
+                const size_t remain_size = sync_buf_size - data_size;
+                const size_t got = resync.readData(sync_buf + data_size, remain_size);
+                data_size += got;
+                eof = got < remain_size;
             }
         }
+        sync_pre_size = data_size;
 
     } while (resync.status() == RS_OK || (resync.status() == RS_SYNC_LOST && opt.cont_sync));
 
@@ -46,6 +46,11 @@
 #include "tsDescriptorList.h"
 #include "tsTime.h"
 #include "tsNullReport.h"
+#include "tsAsyncReport.h"
+#include "tsThread.h"
+#include "tsMutex.h"
+#include "tsCondition.h"
+#include "tsGuardCondition.h"
 #include "tsVersionInfo.h"
 TSDUCK_SOURCE;
 
@@ -81,6 +86,7 @@ struct Options: public ts::Args
     bool            list_services;
     bool            global_services;
     ts::MilliSecond psi_timeout;
+    ts::UStringVector parallel_devices;
 };
 
 Options::Options(int argc, char *argv[]) :
@@ -100,7 +106,8 @@ Options::Options(int argc, char *argv[]) :
     show_modulation(false),
     list_services(false),
     global_services(false),
-    psi_timeout(0)
+    psi_timeout(0),
+    parallel_devices()
 {
     // Warning, the following short options are already defined in TunerArgs:
     // 'a', 'c', 'd', 'f', 'm', 's', 'z'
@@ -114,6 +121,7 @@ Options::Options(int argc, char *argv[]) :
     option(u"min-quality",          0,  INTEGER, 0, 1, 0, 100);
     option(u"min-strength",         0,  INTEGER, 0, 1, 0, 100);
     option(u"no-offset",           'n');
+    option(u"parallel-adapter",     0,  UNSIGNED, 0, UNLIMITED_COUNT);
     option(u"psi-timeout",          0,  UNSIGNED);
     option(u"service-list",        'l');
     option(u"show-modulation",      0);
@@ -177,6 +185,14 @@ Options::Options(int argc, char *argv[]) :
             u"      For UHF-band scanning, scan only the central frequency of each channel.\n"
             u"      Do not scan frequencies with offsets.\n"
             u"\n"
+            u"  --parallel-adapter N\n"
+            u"      Use the DVB adapter N in addition to the one which is specified by\n"
+            u"      --adapter or --device-name. The UHF channels or the transponders of the\n"
+            u"      network are distributed over all adapters, which are scanned in parallel.\n"
+            u"      All adapters must have the same type. The results are displayed in the\n"
+            u"      same order as a sequential scan. Several --parallel-adapter options may\n"
+            u"      be specified.\n"
+            u"\n"
             u"  --psi-timeout milliseconds\n"
             u"      Specifies the timeout, in milli-seconds, for PSI/SI table collection.\n"
             u"      Useful only with --service-list. The default is " +
@@ -220,6 +236,10 @@ Options::Options(int argc, char *argv[]) :
     global_services   = present(u"global-service-list");
     psi_timeout       = intValue<ts::MilliSecond>(u"psi-timeout", DEFAULT_PSI_TIMEOUT);
 
+    for (size_t i = 0; i < count(u"parallel-adapter"); ++i) {
+        parallel_devices.push_back(ts::TunerArgs::AdapterDeviceName(intValue<int>(u"parallel-adapter", 0, i)));
+    }
+
     if (nit_scan && uhf_scan) {
         error(u"do not specify tuning parameters with --uhf-band");
     }
@@ -485,34 +505,189 @@ bool OffsetScanner::tryOffset(int offset)
 
 
 //----------------------------------------------------------------------------
-//  UHF-band scanning
+//  Scanning jobs. A job scans one UHF channel or one transponder of the
+//  network. The jobs are distributed over all tuners.
 //----------------------------------------------------------------------------
 
 namespace {
-    void UHFScan(Options& opt, ts::Tuner& tuner, ts::ServiceList& all_services)
+
+    typedef ts::SafePtr<ts::Tuner, ts::NullMutex> TunerPtr;
+    typedef std::vector<TunerPtr> TunerPtrVector;
+
+    struct ScanJob
     {
-        // UHF means DVB-T
-        if (tuner.tunerType() != ts::DVB_T) {
-            opt.error(u"UHF scanning needs DVB-T, tuner %s is %s", {tuner.deviceName(), ts::TunerTypeEnum.name(tuner.tunerType())});
-            return;
-        }
+        int                    channel;    // UHF channel (UHF-band scanning).
+        ts::TunerParametersPtr params;     // Transponder (NIT-based scanning).
+        bool                   completed;  // The job is completed.
+        std::string            output;     // Report of the job.
+        ts::ServiceList        services;   // Services which were found by the job.
 
-        // Loop on all selected UHF channels
-        for (int chan = opt.first_uhf_channel; chan <= opt.last_uhf_channel; ++chan) {
+        ScanJob(int chan = 0, const ts::TunerParametersPtr& tp = ts::TunerParametersPtr()) :
+            channel(chan), params(tp), completed(false), output(), services() {}
+    };
 
-            // Scan all offsets surrounding the channel
-            OffsetScanner offscan(opt, tuner, chan);
+    typedef std::vector<ScanJob> ScanJobVector;
+
+    // Execute one job on one tuner.
+    void ExecuteJob(Options& opt, ts::Tuner& tuner, ScanJob& job)
+    {
+        std::ostringstream strm;
+
+        if (job.params.isNull()) {
+            // Scan all offsets surrounding the UHF channel
+            OffsetScanner offscan(opt, tuner, job.channel);
             if (offscan.signalFound()) {
 
                 // Report channel characteristics
-                std::cout << "* UHF "
-                          << ts::UHF::Description(chan, offscan.bestOffset(), tuner.signalStrength(opt), tuner.signalQuality(opt))
-                          << std::endl;
+                strm << "* UHF "
+                     << ts::UHF::Description(job.channel, offscan.bestOffset(), tuner.signalStrength(opt), tuner.signalQuality(opt))
+                     << std::endl;
+
+                // Analyze PSI/SI if required
+                DisplayTS(strm, u"  ", opt, tuner, ts::TunerParametersPtr(), job.services);
+            }
+        }
+        else {
+            // Tune to the transponder.
+            opt.debug(u"* tuning to " + job.params->toPluginOptions(true));
+            if (tuner.tune(*job.params, opt)) {
+
+                // Report channel characteristics
+                strm << "* Frequency: " << job.params->shortDescription(tuner.signalStrength(opt), tuner.signalQuality(opt)) << std::endl;
 
                 // Analyze PSI/SI if required
-                DisplayTS(std::cout, u"  ", opt, tuner, ts::TunerParametersPtr(), all_services);
+                DisplayTS(strm, u"  ", opt, tuner, job.params, job.services);
+            }
+        }
+
+        job.output = strm.str();
+    }
+
+    // Distribution of jobs over several tuners.
+    class JobScheduler
+    {
+    public:
+        JobScheduler(ScanJobVector& jobs) : _mutex(), _condition(), _jobs(jobs), _next(0) {}
+
+        // Get the next job to execute, return false when all jobs are started.
+        bool nextJob(size_t& index)
+        {
+            ts::Guard lock(_mutex);
+            index = _next;
+            _next = std::min(_next + 1, _jobs.size());
+            return index < _jobs.size();
+        }
+
+        // Declare a job as completed.
+        void completeJob(size_t index)
+        {
+            ts::GuardCondition lock(_mutex, _condition);
+            _jobs[index].completed = true;
+            lock.signal();
+        }
+
+        // Wait for completion of a job.
+        void waitJob(size_t index)
+        {
+            ts::GuardCondition lock(_mutex, _condition);
+            while (!_jobs[index].completed) {
+                lock.waitCondition();
+            }
+        }
+
+    private:
+        ts::Mutex      _mutex;
+        ts::Condition  _condition;
+        ScanJobVector& _jobs;
+        size_t         _next;
+    };
+
+    // A thread executing jobs on one tuner.
+    class ScanThread: public ts::Thread
+    {
+    public:
+        ScanThread(Options& opt, ts::Tuner& tuner, JobScheduler& scheduler, ScanJobVector& jobs) :
+            ts::Thread(),
+            _opt(opt),
+            _tuner(tuner),
+            _scheduler(scheduler),
+            _jobs(jobs)
+        {
+        }
+
+        virtual ~ScanThread() override
+        {
+            waitForTermination();
+        }
+
+    private:
+        Options&       _opt;
+        ts::Tuner&     _tuner;
+        JobScheduler&  _scheduler;
+        ScanJobVector& _jobs;
+
+        virtual void main() override
+        {
+            size_t index = 0;
+            while (_scheduler.nextJob(index)) {
+                ExecuteJob(_opt, _tuner, _jobs[index]);
+                _scheduler.completeJob(index);
+            }
+        }
+    };
+
+    // Execute all jobs on all tuners and display the results in the order of the jobs.
+    void ExecuteJobs(Options& opt, TunerPtrVector& tuners, ScanJobVector& jobs, ts::ServiceList& all_services)
+    {
+        if (tuners.size() == 1) {
+            // Sequential scan, in the main thread.
+            for (size_t index = 0; index < jobs.size(); ++index) {
+                ExecuteJob(opt, *tuners[0], jobs[index]);
+                std::cout << jobs[index].output << std::flush;
+                all_services.insert(all_services.end(), jobs[index].services.begin(), jobs[index].services.end());
+            }
+            return;
+        }
+
+        // Parallel scan, one thread per tuner.
+        JobScheduler scheduler(jobs);
+        std::vector<ts::SafePtr<ScanThread, ts::NullMutex>> threads;
+        for (size_t i = 0; i < tuners.size(); ++i) {
+            threads.push_back(new ScanThread(opt, *tuners[i], scheduler, jobs));
+            threads.back()->start();
+        }
+
+        // Display the results in order, as soon as they are available.
+        for (size_t index = 0; index < jobs.size(); ++index) {
+            scheduler.waitJob(index);
+            std::cout << jobs[index].output << std::flush;
+            all_services.insert(all_services.end(), jobs[index].services.begin(), jobs[index].services.end());
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+//  UHF-band scanning
+//----------------------------------------------------------------------------
+
+namespace {
+    void UHFScan(Options& opt, TunerPtrVector& tuners, ts::ServiceList& all_services)
+    {
+        // UHF means DVB-T
+        for (size_t i = 0; i < tuners.size(); ++i) {
+            if (tuners[i]->tunerType() != ts::DVB_T) {
+                opt.error(u"UHF scanning needs DVB-T, tuner %s is %s", {tuners[i]->deviceName(), ts::TunerTypeEnum.name(tuners[i]->tunerType())});
+                return;
             }
         }
+
+        // One job per selected UHF channel
+        ScanJobVector jobs;
+        for (int chan = opt.first_uhf_channel; chan <= opt.last_uhf_channel; ++chan) {
+            jobs.push_back(ScanJob(chan));
+        }
+        ExecuteJobs(opt, tuners, jobs, all_services);
     }
 }
 
@@ -522,48 +697,48 @@ namespace {
 //----------------------------------------------------------------------------
 
 namespace {
-    void NITScan(Options& opt, ts::Tuner& tuner, ts::ServiceList& all_services)
+    void NITScan(Options& opt, TunerPtrVector& tuners, ts::ServiceList& all_services)
     {
+        // All tuners must be able to tune to the transponders of the network.
+        for (size_t i = 1; i < tuners.size(); ++i) {
+            if (tuners[i]->tunerType() != tuners[0]->tunerType()) {
+                opt.error(u"tuner %s is %s, tuner %s is %s",
+                          {tuners[0]->deviceName(), ts::TunerTypeEnum.name(tuners[0]->tunerType()),
+                           tuners[i]->deviceName(), ts::TunerTypeEnum.name(tuners[i]->tunerType())});
+                return;
+            }
+        }
+
         // Tune to the reference transponder.
+        ts::Tuner& tuner(*tuners[0]);
         ts::TunerParametersPtr params;
         if (!opt.tuner.tune(tuner, params, opt)) {
             return;
         }
 
         // Collect info on reference transponder.
-        ts::TSScanner info(tuner, opt.psi_timeout, false, opt);
-
-        // Get the collected NIT
         ts::SafePtr<ts::NIT> nit;
-        info.getNIT(nit);
+        {
+            ts::TSScanner info(tuner, opt.psi_timeout, false, opt);
+            info.getNIT(nit);
+        }
         if (nit.isNull()) {
             opt.error(u"cannot scan network, no NIT found on specified transponder");
             return;
         }
 
-        // Process each TS descriptor list in the NIT.
+        // One job per transponder, as described by a delivery system descriptor in the NIT.
+        ScanJobVector jobs;
         for (ts::NIT::TransportMap::const_iterator it = nit->transports.begin(); it != nit->transports.end(); ++it) {
             const ts::DescriptorList& dlist(it->second);
-
-            // Loop on all descriptors for the current TS.
             for (size_t i = 0; i < dlist.count(); ++i) {
-                // Try to get delivery system information from current descriptor
                 ts::TunerParametersPtr tp(ts::DecodeDeliveryDescriptor(*dlist[i]));
                 if (!tp.isNull()) {
-                    // Got a delivery descriptor, this is the description of one transponder.
-                    // Tune to this transponder.
-                    opt.debug(u"* tuning to " + tp->toPluginOptions(true));
-                    if (tuner.tune(*tp, opt)) {
-
-                        // Report channel characteristics
-                        std::cout << "* Frequency: " << tp->shortDescription(tuner.signalStrength(opt), tuner.signalQuality(opt)) << std::endl;
-
-                        // Analyze PSI/SI if required
-                        DisplayTS(std::cout, u"  ", opt, tuner, tp, all_services);
-                    }
+                    jobs.push_back(ScanJob(0, tp));
                 }
             }
         }
+        ExecuteJobs(opt, tuners, jobs, all_services);
     }
 }
 
@@ -578,18 +753,36 @@ namespace {
     {
         ts::ServiceList all_services;
 
-        // Initialize tuner.
-        ts::Tuner tuner;
-        tuner.setSignalTimeoutSilent(true);
-        if (!opt.tuner.configureTuner(tuner, opt)) {
-            return;
+        // With parallel scanning, messages are logged from several threads.
+        ts::SafePtr<ts::AsyncReport, ts::NullMutex> async_report;
+        if (!opt.parallel_devices.empty()) {
+            async_report = new ts::AsyncReport(opt.maxSeverity());
+            opt.redirectReport(async_report.pointer());
+        }
+
+        // Initialize tuners.
+        TunerPtrVector tuners;
+        for (size_t i = 0; i <= opt.parallel_devices.size(); ++i) {
+            ts::TunerArgs targs(opt.tuner);
+            if (i > 0) {
+                targs.device_name = opt.parallel_devices[i - 1];
+            }
+            TunerPtr tuner(new ts::Tuner);
+            tuner->setSignalTimeoutSilent(true);
+            if (!targs.configureTuner(*tuner, opt)) {
+                break;
+            }
+            tuners.push_back(tuner);
         }
 
-        if (opt.uhf_scan) {
-            UHFScan(opt, tuner, all_services);
+        if (tuners.size() <= opt.parallel_devices.size()) {
+            // At least one tuner could not be opened, error already reported.
+        }
+        else if (opt.uhf_scan) {
+            UHFScan(opt, tuners, all_services);
         }
         else if (opt.nit_scan) {
-            NITScan(opt, tuner, all_services);
+            NITScan(opt, tuners, all_services);
         }
         else {
             opt.fatal(u"inconsistent options, internal error");
@@ -601,6 +794,12 @@ namespace {
             std::cout << std::endl;
             ts::Service::Display(std::cout, u"", all_services);
         }
+
+        // Terminate asynchronous logging before returning.
+        if (!async_report.isNull()) {
+            opt.redirectReport(0);
+            async_report->terminate();
+        }
     }
 }
 
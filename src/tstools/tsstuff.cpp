@@ -32,8 +32,8 @@
 //----------------------------------------------------------------------------
 
 #include "tsArgs.h"
-#include "tsTSFileInputBuffered.h"
-#include "tsTSFileOutput.h"
+#include "tsTSFileBlockReader.h"
+#include "tsTSFileBlockWriter.h"
 #include "tsVariable.h"
 #include "tsVersionInfo.h"
 TSDUCK_SOURCE;
@@ -104,8 +104,9 @@ Options::Options(int argc, char *argv[]) :
             u"      there is no default.\n"
             u"\n"
             u"  --buffer-size value\n"
-            u"      Input buffer size, in bytes. Must be large enough to always contain two\n"
-            u"      time stamps in the reference PID. Default: " + ts::UString::Decimal(DEFAULT_TS_BUFFER_SIZE) + u" bytes.\n"
+            u"      Maximum size of the look-ahead input buffer, in bytes. Must be large\n"
+            u"      enough to always contain two time stamps in the reference PID. The input\n"
+            u"      file is read only once, without seek, and can be a pipe. Default: " + ts::UString::Decimal(DEFAULT_TS_BUFFER_SIZE) + u" bytes.\n"
             u"\n"
             u"  -d\n"
             u"  --dts-based\n"
@@ -210,8 +211,11 @@ public:
 private:
     // Private members
     Options&                _opt;
-    ts::TSFileInputBuffered _input;
+    ts::TSFileInput         _input;
     ts::TSFileOutput        _output;
+    ts::TSFileBlockReader   _reader;         // Look-ahead buffer: packets read but not yet written
+    ts::TSFileBlockWriter   _writer;         // Output buffer
+    ts::PacketCounter       _scan_position;  // Index in input file of next packet to scan for time stamps
     ts::PacketCounter       _current_inter_packet;
     ts::PacketCounter       _remaining_stuff_count;
     ts::PacketCounter       _additional_bits;
@@ -230,10 +234,17 @@ private:
     // Evaluate stuffing need in next segment, between two time stamps.
     void evaluateNextStuffing();
 
+    // Get a pointer to a packet in the look-ahead buffer, by index in input file.
+    // Read more input if necessary. Return zero on end of file.
+    const ts::TSPacket* getInputPacket(ts::PacketCounter position);
+
+    // Copy the next input packet to the output file.
+    bool copyPacket();
+
     // Write the specified number of stuffing packets
     void writeStuffing(ts::PacketCounter stuffing_packet_count);
 
-    // Read input up to end_packet and perform simple inter-packet stuffing.
+    // Copy input up to end_packet and perform simple inter-packet stuffing.
     void simpleInterPacketStuffing(ts::PacketCounter inter_packet, ts::PacketCounter end_packet);
 };
 
@@ -244,8 +255,11 @@ private:
 
 Stuffer::Stuffer(Options& opt) :
     _opt(opt),
-    _input(opt.buffer_size / ts::PKT_SIZE),
+    _input(),
     _output(),
+    _reader(_input, std::max<size_t>(opt.buffer_size / ts::PKT_SIZE, ts::TSFileBlockReader::DEFAULT_BLOCK_PACKETS)),
+    _writer(_output),
+    _scan_position(0),
     _current_inter_packet(0),
     _remaining_stuff_count(0),
     _additional_bits(0),
@@ -288,35 +302,57 @@ bool Stuffer::getTimeStamp(const ts::TSPacket& pkt, uint64_t& tstamp) const
 }
 
 
+//-----------------------------------------------------------------------------
+// Get a pointer to a packet in the look-ahead buffer.
+//-----------------------------------------------------------------------------
+
+const ts::TSPacket* Stuffer::getInputPacket(ts::PacketCounter position)
+{
+    assert(position >= _reader.getPacketCount());
+    const size_t index = size_t(position - _reader.getPacketCount());
+    return _reader.peek(index + 1, _opt) > index ? _reader.packets() + index : 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// Copy the next input packet to the output file.
+//-----------------------------------------------------------------------------
+
+bool Stuffer::copyPacket()
+{
+    const ts::TSPacket* pkt = _reader.next(_opt);
+    if (pkt == 0) {
+        return false;
+    }
+    if (!_writer.write(*pkt, _opt)) {
+        fatalError();
+    }
+    return true;
+}
+
+
 //-----------------------------------------------------------------------------
 // Write the specified number of stuffing packets
 //-----------------------------------------------------------------------------
 
 void Stuffer::writeStuffing(ts::PacketCounter count)
 {
-    while (count > 0) {
-        if (!_output.write(&ts::NullPacket, 1, _opt)) {
-            fatalError();
-        }
-        count--;
+    if (!_writer.fill(ts::NullPacket, count, _opt)) {
+        fatalError();
     }
 }
 
 
 //-----------------------------------------------------------------------------
-// Read input up to end_packet and perform simple inter-packet stuffing.
+// Copy input up to end_packet and perform simple inter-packet stuffing.
 //-----------------------------------------------------------------------------
 
 void Stuffer::simpleInterPacketStuffing(ts::PacketCounter inter_packet, ts::PacketCounter end_packet)
 {
-    assert (_input.getPacketCount() < end_packet);
+    assert(_reader.getPacketCount() < end_packet);
 
-    ts::TSPacket pkt;
-    while (_input.getPacketCount() < end_packet && _input.read (&pkt, 1, _opt) == 1) {
-        if (!_output.write (&pkt, 1, _opt)) {
-            fatalError();
-        }
-        writeStuffing (inter_packet);
+    while (_reader.getPacketCount() < end_packet && copyPacket()) {
+        writeStuffing(inter_packet);
     }
 }
 
@@ -327,29 +363,34 @@ void Stuffer::simpleInterPacketStuffing(ts::PacketCounter inter_packet, ts::Pack
 
 void Stuffer::evaluateNextStuffing()
 {
-    // Save initial position in the file
-    const ts::PacketCounter initial_position = _input.getPacketCount();
+    // Position of the next packet to write. The packets between this position and
+    // the current scan position are already in the look-ahead buffer.
+    const ts::PacketCounter initial_position = _reader.getPacketCount();
+    const ts::PacketCounter max_position = initial_position + std::max<size_t>(1, _opt.buffer_size / ts::PKT_SIZE);
+    bool buffer_full = false;
     _opt.debug(u"evaluateNextStuffing: initial_position = %'d", {initial_position});
 
     // Initialize new search. Note that _tstamp1 and _tstamp2 may be unset.
     _tstamp1 = _tstamp2;
     _tstamp2.reset();
 
-    // Read packets until both _tstamp1 and _tstamp2 are set (or end of file)
+    // Scan packets until both _tstamp1 and _tstamp2 are set (or end of file).
+    // Each input packet is scanned only once, the look-ahead packets are kept in memory.
     uint64_t tstamp;
-    ts::TSPacket pkt;
-    while (!_tstamp2.set() && _input.canSeek (initial_position) && _input.read (&pkt, 1, _opt) == 1) {
-        if (getTimeStamp (pkt, tstamp)) {
+    const ts::TSPacket* pkt = 0;
+    while (!_tstamp2.set() && !(buffer_full = _scan_position >= max_position) && (pkt = getInputPacket(_scan_position)) != 0) {
+        _scan_position++;
+        if (getTimeStamp(*pkt, tstamp)) {
             if (_opt.reference_pid == ts::PID_NULL) {
                 // Found the first time stamp, use this PID as reference
-                _opt.reference_pid = pkt.getPID();
+                _opt.reference_pid = pkt->getPID();
                 _opt.verbose(u"using PID %d (0x%X) as reference", {_opt.reference_pid, _opt.reference_pid});
             }
-            else if (_opt.reference_pid != pkt.getPID()) {
+            else if (_opt.reference_pid != pkt->getPID()) {
                 // Not the reference PID, skip;
                 continue;
             }
-            const TimeStamp time_stamp(tstamp, _input.getPacketCount());
+            const TimeStamp time_stamp(tstamp, _scan_position);
             if (!_tstamp1.set() || tstamp <= _tstamp1.value().tstamp) {
                 // 1) Found the first time stamp in the file.
                 // 2) Or found a time stamp lower than tstamp1, may be because of a
@@ -366,7 +407,7 @@ void Stuffer::evaluateNextStuffing()
     }
 
     // If _tstamp2 not set in first segment or after buffer full, we cannot perform bitrate evaluation
-    if (!_tstamp2.set() && (initial_position == 0 || !_input.canSeek (initial_position))) {
+    if (!_tstamp2.set() && (initial_position == 0 || buffer_full)) {
         ts::UString msg(u"no " + getTimeStampType() + u" found");
         if (initial_position > 0) {
             msg += ts::UString::Format(u" after packet %'d", {initial_position});
@@ -380,11 +421,6 @@ void Stuffer::evaluateNextStuffing()
         _opt.fatal(msg);
     }
 
-    // Restore initial position in the file
-    if (!_input.seekBackward(size_t(_input.getPacketCount() - initial_position), _opt)) {
-        fatalError();
-    }
-
     // If _tstamp2 is not set, we reached the end of file, keep previous settings.
     // Otherwise, compute new settings.
     if (_tstamp2.set()) {
@@ -429,8 +465,6 @@ void Stuffer::stuff()
         fatalError();
     }
 
-    _opt.debug(u"input file buffer size: %'d packets", {_input.getBufferSize()});
-
     // Remaining number of bits to stuff representing less than one packet
     _additional_bits = 0;
 
@@ -454,14 +488,10 @@ void Stuffer::stuff()
 
     // Perform stuffing, segment after segment
     while (_tstamp2.set()) {
-        assert(_input.getPacketCount() < _tstamp2.value().packet);
+        assert(_reader.getPacketCount() < _tstamp2.value().packet);
 
         // Perform stuffing on current segment.
-        ts::TSPacket pkt;
-        while (_input.getPacketCount() < _tstamp2.value().packet && _input.read(&pkt, 1, _opt) == 1) {
-            if (!_output.write(&pkt, 1, _opt)) {
-                fatalError();
-            }
+        while (_reader.getPacketCount() < _tstamp2.value().packet && copyPacket()) {
             const ts::PacketCounter count = std::min(_current_inter_packet, _remaining_stuff_count);
             writeStuffing(count);
             _remaining_stuff_count -= count;
@@ -477,7 +507,10 @@ void Stuffer::stuff()
     simpleInterPacketStuffing(_opt.dyn_final_inter_packet ? _current_inter_packet : _opt.final_inter_packet, std::numeric_limits<ts::PacketCounter>::max());
 
     // Write trailing stuffing packets
-    writeStuffing(_opt.leading_packets);
+    writeStuffing(_opt.trailing_packets);
+    if (!_writer.flush(_opt)) {
+        fatalError();
+    }
 
     _opt.verbose(u"stuffing completed, read %'d packets, written %'d packets", {_input.getPacketCount(), _output.getPacketCount()});
 
@@ -40,6 +40,8 @@
 #include "tsInputRedirector.h"
 #include "tsOutputRedirector.h"
 #include "tsVersionInfo.h"
+#include "tsThreadPool.h"
+#include "tsSyncReport.h"
 TSDUCK_SOURCE;
 
 // With static link, enforce a reference to MPEG/DVB structures.
@@ -63,6 +65,7 @@ struct Options: public ts::Args
     bool                  compile;         // Explicit compilation.
     bool                  decompile;       // Explicit decompilation.
     bool                  xmlModel;        // Display XML model instead of compilation.
+    size_t                jobs;            // Number of files to process in parallel.
     const ts::DVBCharset* defaultCharset;  // Default DVB character set to interpret strings.
 
 private:
@@ -79,12 +82,14 @@ Options::Options(int argc, char *argv[]) :
     compile(false),
     decompile(false),
     xmlModel(false),
+    jobs(1),
     defaultCharset(0)
 {
     option(u"",                0,  ts::Args::STRING);
     option(u"compile",        'c');
     option(u"decompile",      'd');
     option(u"default-charset", 0, Args::STRING);
+    option(u"jobs",           'j', Args::UNSIGNED);
     option(u"output",         'o', ts::Args::STRING);
     option(u"xml-model",      'x');
 
@@ -124,6 +129,12 @@ Options::Options(int argc, char *argv[]) :
             u"  --help\n"
             u"      Display this help text.\n"
             u"\n"
+            u"  -j count\n"
+            u"  --jobs count\n"
+            u"      Number of input files which are processed in parallel. The default is 1,\n"
+            u"      the files are processed one after the other. The value zero means the\n"
+            u"      number of CPU's in the system.\n"
+            u"\n"
             u"  -o filepath\n"
             u"  --output filepath\n"
             u"      Specify the output file name. By default, the output file has the same\n"
@@ -153,6 +164,7 @@ Options::Options(int argc, char *argv[]) :
     compile = present(u"compile");
     decompile = present(u"decompile");
     xmlModel = present(u"xml-model");
+    jobs = intValue<size_t>(u"jobs", 1);
     outdir = !outfile.empty() && ts::IsDirectory(outfile);
 
     if (!infiles.empty() && xmlModel) {
@@ -212,9 +224,10 @@ bool DisplayModel(Options& opt)
 
 //----------------------------------------------------------------------------
 //  Process one file. Return true on success, false on error.
+//  All messages go to the specified report, the files may be processed in parallel.
 //----------------------------------------------------------------------------
 
-bool ProcessFile(Options& opt, const ts::UString& infile)
+bool ProcessFile(Options& opt, ts::Report& log, const ts::UString& infile)
 {
     const ts::SectionFile::FileType inType = ts::SectionFile::GetFileType(infile);
     const bool compile = opt.compile || inType == ts::SectionFile::XML;
@@ -231,29 +244,29 @@ bool ProcessFile(Options& opt, const ts::UString& infile)
     }
 
     ts::SectionFile file;
-    ts::ReportWithPrefix report(opt, ts::BaseName(infile) + u": ");
+    ts::ReportWithPrefix report(log, ts::BaseName(infile) + u": ");
 
     // Process the input file, starting with error cases.
     if (!compile && !decompile) {
-        opt.error(u"don't know what to do with file %s, unknown file type, specify --compile or --decompile", {infile});
+        log.error(u"don't know what to do with file %s, unknown file type, specify --compile or --decompile", {infile});
         return false;
     }
     else if (compile && inType == ts::SectionFile::BINARY) {
-        opt.error(u"cannot compile binary file %s", {infile});
+        log.error(u"cannot compile binary file %s", {infile});
         return false;
     }
     else if (decompile && inType == ts::SectionFile::XML) {
-        opt.error(u"cannot decompile XML file %s", {infile});
+        log.error(u"cannot decompile XML file %s", {infile});
         return false;
     }
     else if (compile) {
         // Load XML file and save binary sections.
-        opt.verbose(u"Compiling %s to %s", {infile, outname});
+        log.verbose(u"Compiling %s to %s", {infile, outname});
         return file.loadXML(infile, report, opt.defaultCharset) && file.saveBinary(outname, report);
     }
     else {
         // Load binary sections and save XML file.
-        opt.verbose(u"Decompiling %s to %s", {infile, outname});
+        log.verbose(u"Decompiling %s to %s", {infile, outname});
         return file.loadBinary(infile, report, ts::CRC32::CHECK) && file.saveXML(outname, report, opt.defaultCharset);
     }
 }
@@ -271,12 +284,24 @@ int main(int argc, char *argv[])
     if (opt.xmlModel) {
         ok = DisplayModel(opt);
     }
-    else {
+    else if (opt.jobs == 1 || opt.infiles.size() < 2) {
         for (size_t i = 0; i < opt.infiles.size(); ++i) {
             if (!opt.infiles[i].empty()) {
-                ok = ProcessFile(opt, opt.infiles[i]) && ok;
+                ok = ProcessFile(opt, opt, opt.infiles[i]) && ok;
             }
         }
     }
+    else {
+        // Process files in parallel. Each file is independently loaded and saved.
+        ts::SyncReport log(opt);
+        ts::ThreadPool pool(opt.jobs);
+        std::atomic<bool> allOk(true);
+        pool.parallelFor(0, opt.infiles.size(), [&opt, &log, &allOk](size_t i) {
+            if (!opt.infiles[i].empty() && !ProcessFile(opt, log, opt.infiles[i])) {
+                allOk = false;
+            }
+        }, 1);
+        ok = allOk;
+    }
     return ok ? EXIT_SUCCESS : EXIT_FAILURE;
 }
@@ -57,16 +57,19 @@ struct Options: public ts::Args
 
     ts::UStringVector     infiles;   // Input file names
     ts::TablesDisplayArgs display;   // Options about displaying tables
+    ts::SectionFile::TableSelectorVector selectors;  // Selected tables, use the index file
 };
 
 Options::Options(int argc, char *argv[]) :
     ts::Args(u"Dump PSI/SI tables, as saved by tstables.", u"[options] [filename ...]"),
     infiles(),
-    display()
+    display(),
+    selectors()
 {
     // Warning, the following short options are already defined in TablesDisplayArgs:
     // 'c', 'r'
     option(u"", 0, ts::Args::STRING);
+    option(u"select", 0, ts::Args::STRING, 0, ts::Args::UNLIMITED_COUNT);
     display.defineOptions(*this);
 
     setHelp(u"Input file:\n"
@@ -78,6 +81,14 @@ Options::Options(int argc, char *argv[]) :
             u"  --help\n"
             u"      Display this help text.\n"
             u"\n"
+            u"  --select tid[/tid-ext[/version]]\n"
+            u"      Display only the sections of the specified tables. Values are decimal\n"
+            u"      or hexadecimal (0x prefix). Several --select options may be specified.\n"
+            u"      The input file is memory-mapped and only the selected sections are read,\n"
+            u"      using the index file 'filename.idx'. The index file is created when it\n"
+            u"      does not exist or when it does not match the input file. This option\n"
+            u"      cannot be used with the standard input.\n"
+            u"\n"
             u"  -v\n"
             u"  --verbose\n"
             u"      Produce verbose output.\n"
@@ -91,6 +102,21 @@ Options::Options(int argc, char *argv[]) :
     getValues(infiles, u"");
     display.load(*this);
 
+    ts::UStringVector select;
+    getValues(select, u"select");
+    for (ts::UStringVector::const_iterator it = select.begin(); it != select.end(); ++it) {
+        ts::SectionFile::TableSelector sel;
+        if (sel.decode(*it)) {
+            selectors.push_back(sel);
+        }
+        else {
+            error(u"invalid table selection \"%s\"", {*it});
+        }
+    }
+    if (!selectors.empty() && infiles.empty()) {
+        error(u"--select cannot be used with the standard input");
+    }
+
     exitOnError();
 }
 
@@ -115,6 +141,10 @@ bool DumpFile(Options& opt, const ts::UString& file_name)
         SetBinaryModeStdin(opt);
         ok = file.loadBinary(std::cin, opt, ts::CRC32::IGNORE);
     }
+    else if (!opt.selectors.empty()) {
+        // Selected tables only, using the index file.
+        ok = file.loadBinary(file_name, opt.selectors, opt, ts::CRC32::IGNORE);
+    }
     else {
         ok = file.loadBinary(file_name, opt, ts::CRC32::IGNORE);
     }
@@ -57,6 +57,7 @@ struct Options: public ts::Args
     bool        latest;    // Display the latest version of TSDuck.
     bool        check;     // Check if a new version of TSDuck is available.
     bool        all;       // List all available versions of TSDuck.
+    bool        cpu;       // Display the CPU features which are used by TSDuck.
     bool        download;  // Download the latest version.
     bool        force;     // Force downloads.
     bool        binary;    // With --download, fetch the binaries.
@@ -77,6 +78,7 @@ Options::Options(int argc, char *argv[]) :
     latest(false),
     check(false),
     all(false),
+    cpu(false),
     download(false),
     force(false),
     binary(false),
@@ -88,6 +90,7 @@ Options::Options(int argc, char *argv[]) :
     option(u"all",              'a');
     option(u"binary",           'b');
     option(u"check",            'c');
+    option(u"cpu-features",      0);
     option(u"download",         'd');
     option(u"force",            'f');
     option(u"latest",           'l');
@@ -117,6 +120,11 @@ Options::Options(int argc, char *argv[]) :
             u"  --check\n"
             u"      Check if a new version of TSDuck is available from GitHub.\n"
             u"\n"
+            u"  --cpu-features\n"
+            u"      Display the CPU features which are detected on this system and which can\n"
+            u"      be used by TSDuck. With --verbose, display the support status of all\n"
+            u"      features which are checked on this CPU architecture.\n"
+            u"\n"
             u"  -d\n"
             u"  --download\n"
             u"      Download the latest version (or the version specified by --name) from\n"
@@ -179,6 +187,7 @@ Options::Options(int argc, char *argv[]) :
     analyze(argc, argv);
 
     all = present(u"all");
+    cpu = present(u"cpu-features");
     current = present(u"this");
     latest = present(u"latest");
     check = present(u"check");
@@ -200,12 +209,12 @@ Options::Options(int argc, char *argv[]) :
     }
 
     // Filter invalid combinations of options.
-    if (all + current + latest + check + !name.empty() > 1) {
-        error(u"specify only one of --this --latest --name --check --all");
+    if (all + cpu + current + latest + check + !name.empty() > 1) {
+        error(u"specify only one of --this --latest --name --check --all --cpu-features");
     }
 
     // If nothing is specified, default to --this
-    if (!all && !latest && !check && !download && !upgrade && name.empty()) {
+    if (!all && !cpu && !latest && !check && !download && !upgrade && name.empty()) {
         current = true;
     }
 
@@ -287,6 +296,34 @@ bool ListAllVersions(Options& opt)
 }
 
 
+//----------------------------------------------------------------------------
+//  Display the CPU features.
+//----------------------------------------------------------------------------
+
+void DisplayCPUFeatures(Options& opt)
+{
+    const ts::SysInfo* sys = ts::SysInfo::Instance();
+
+    // In non-verbose mode, simply list the supported features.
+    if (!opt.verbose()) {
+        std::cout << sys->cpuFeatures() << std::endl;
+        return;
+    }
+
+    std::map<ts::UString, bool> features;
+    sys->getCPUFeatures(features);
+
+    size_t width = 0;
+    for (std::map<ts::UString, bool>::const_iterator it = features.begin(); it != features.end(); ++it) {
+        width = std::max(width, it->first.width());
+    }
+
+    for (std::map<ts::UString, bool>::const_iterator it = features.begin(); it != features.end(); ++it) {
+        std::cout << it->first.toJustifiedLeft(width + 1, u'.') << " " << (it->second ? "yes" : "no") << std::endl;
+    }
+}
+
+
 //----------------------------------------------------------------------------
 //  Display one release.
 //----------------------------------------------------------------------------
@@ -590,6 +627,9 @@ int main(int argc, char *argv[])
     else if (opt.all) {
         success = ListAllVersions(opt);
     }
+    else if (opt.cpu) {
+        DisplayCPUFeatures(opt);
+    }
     else {
         success = ProcessVersion(opt);
     }
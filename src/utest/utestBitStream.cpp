@@ -56,6 +56,8 @@ public:
     void testSkipToNextByte();
     void testReadBit();
     void testRead();
+    void testReadWindow();
+    void testExpGolomb();
 
     CPPUNIT_TEST_SUITE (BitStreamTest);
     CPPUNIT_TEST (testConstructors);
@@ -68,6 +70,8 @@ public:
     CPPUNIT_TEST (testSkipToNextByte);
     CPPUNIT_TEST (testReadBit);
     CPPUNIT_TEST (testRead);
+    CPPUNIT_TEST (testReadWindow);
+    CPPUNIT_TEST (testExpGolomb);
     CPPUNIT_TEST_SUITE_END ();
 };
 
@@ -471,3 +475,58 @@ void BitStreamTest::testRead()
     CPPUNIT_ASSERT(bs1.currentBitOffset() == 83);
     CPPUNIT_ASSERT(bs1.endOfStream());
 }
+
+void BitStreamTest::testReadWindow()
+{
+    // Compare multi-bit reads with bit-by-bit reads, at all offsets, close to the end of stream.
+    for (size_t offset = 0; offset < 8 * sizeof(_bytes); ++offset) {
+        for (size_t n = 1; n <= 64 && offset + n <= 8 * sizeof(_bytes); ++n) {
+            ts::BitStream bs1(_bytes, 8 * sizeof(_bytes) - offset, offset);
+            ts::BitStream bs2(bs1);
+            uint64_t expected = 0;
+            for (size_t i = 0; i < n; ++i) {
+                expected = (expected << 1) | bs2.readBit();
+            }
+            CPPUNIT_ASSERT_EQUAL(expected, bs1.read<uint64_t>(n, 0));
+            CPPUNIT_ASSERT_EQUAL(n, bs1.currentBitOffset());
+        }
+    }
+}
+
+void BitStreamTest::testExpGolomb()
+{
+    // Values 0, 1, 2, 6, 7, 254, 2^40 (115 bits), then zero padding.
+    const uint8_t data[] = {0xA6, 0x71, 0x00, 0x3F, 0xC0, 0x00, 0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00, 0x00, 0x20};
+    ts::BitStream bs(data, 8 * sizeof(data));
+
+    CPPUNIT_ASSERT_EQUAL(uint32_t(0), bs.readExpGolomb<uint32_t>());
+    CPPUNIT_ASSERT_EQUAL(size_t(1), bs.currentBitOffset());
+    CPPUNIT_ASSERT_EQUAL(uint32_t(1), bs.readExpGolomb<uint32_t>());
+    CPPUNIT_ASSERT_EQUAL(uint32_t(2), bs.readExpGolomb<uint32_t>());
+    CPPUNIT_ASSERT_EQUAL(uint32_t(6), bs.readExpGolomb<uint32_t>());
+    CPPUNIT_ASSERT_EQUAL(uint32_t(7), bs.readExpGolomb<uint32_t>());
+    CPPUNIT_ASSERT_EQUAL(uint32_t(254), bs.readExpGolomb<uint32_t>());
+    CPPUNIT_ASSERT_EQUAL(size_t(34), bs.currentBitOffset());
+    CPPUNIT_ASSERT_EQUAL(TS_UCONST64(0x10000000000), bs.readExpGolomb<uint64_t>(0));
+    CPPUNIT_ASSERT_EQUAL(size_t(115), bs.currentBitOffset());
+
+    // Only zeros until end of stream.
+    CPPUNIT_ASSERT_EQUAL(uint32_t(1000), bs.readExpGolomb<uint32_t>(1000));
+    CPPUNIT_ASSERT_EQUAL(size_t(115), bs.currentBitOffset());
+
+    // Signed values from codes 1, 2, 6, 7, 254.
+    bs.seek(1);
+    CPPUNIT_ASSERT_EQUAL(1, bs.readSignedExpGolomb<int>());
+    CPPUNIT_ASSERT_EQUAL(-1, bs.readSignedExpGolomb<int>());
+    CPPUNIT_ASSERT_EQUAL(-3, bs.readSignedExpGolomb<int>());
+    CPPUNIT_ASSERT_EQUAL(4, bs.readSignedExpGolomb<int>());
+    CPPUNIT_ASSERT_EQUAL(-127, bs.readSignedExpGolomb<int>());
+
+    // Truncated code word.
+    ts::BitStream bs2(data, 25, 7);
+    CPPUNIT_ASSERT_EQUAL(uint32_t(6), bs2.readExpGolomb<uint32_t>());
+    CPPUNIT_ASSERT_EQUAL(uint32_t(7), bs2.readExpGolomb<uint32_t>());
+    CPPUNIT_ASSERT_EQUAL(size_t(12), bs2.currentBitOffset());
+    CPPUNIT_ASSERT_EQUAL(uint32_t(1000), bs2.readExpGolomb<uint32_t>(1000));
+    CPPUNIT_ASSERT_EQUAL(size_t(12), bs2.currentBitOffset());
+}
@@ -32,6 +32,7 @@
 //----------------------------------------------------------------------------
 
 #include "tsByteBlock.h"
+#include "tsPooledByteBlock.h"
 #include "tsSysUtils.h"
 #include "utestCppUnitTest.h"
 TSDUCK_SOURCE;
@@ -51,10 +52,14 @@ public:
 
     void testAppend();
     void testFile();
+    void testPooled();
+    void testResize();
 
     CPPUNIT_TEST_SUITE(ByteBlockTest);
     CPPUNIT_TEST(testAppend);
     CPPUNIT_TEST(testFile);
+    CPPUNIT_TEST(testPooled);
+    CPPUNIT_TEST(testResize);
     CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -242,3 +247,62 @@ void ByteBlockTest::testFile()
     CPPUNIT_ASSERT_EQUAL(size_t(999), bb1.size());
     CPPUNIT_ASSERT(bb1 == bb);
 }
+
+void ByteBlockTest::testPooled()
+{
+    static const uint8_t data[] = {0x47, 0x11, 0x22, 0x33, 0x44};
+
+    ts::ByteBlockPtr bb1(new ts::PooledByteBlock(data, sizeof(data)));
+    CPPUNIT_ASSERT_EQUAL(sizeof(data), bb1->size());
+    CPPUNIT_ASSERT(bb1->capacity() >= ts::PooledByteBlock::MIN_CAPACITY);
+    CPPUNIT_ASSERT(::memcmp(bb1->data(), data, sizeof(data)) == 0);
+
+    // The storage goes back to the pool when the last reference disappears.
+    const uint8_t* const storage = bb1->data();
+    const size_t free_count = ts::PooledByteBlock::FreeCount();
+    bb1.clear();
+    CPPUNIT_ASSERT_EQUAL(free_count + 1, ts::PooledByteBlock::FreeCount());
+
+    // And it is reused by the next instance.
+    ts::ByteBlockPtr bb2(new ts::PooledByteBlock(data + 1, sizeof(data) - 1));
+    CPPUNIT_ASSERT_EQUAL(free_count, ts::PooledByteBlock::FreeCount());
+    CPPUNIT_ASSERT(bb2->data() == storage);
+    CPPUNIT_ASSERT_EQUAL(sizeof(data) - 1, bb2->size());
+    CPPUNIT_ASSERT(::memcmp(bb2->data(), data + 1, sizeof(data) - 1) == 0);
+
+    // Pre-allocation of the pool, never beyond the limit.
+    ts::PooledByteBlock::Reserve(free_count + 10);
+    CPPUNIT_ASSERT(ts::PooledByteBlock::FreeCount() >= free_count + 10);
+    ts::PooledByteBlock::Reserve(ts::PooledByteBlock::MAX_FREE + 10);
+    CPPUNIT_ASSERT_EQUAL(size_t(ts::PooledByteBlock::MAX_FREE), ts::PooledByteBlock::FreeCount());
+}
+
+void ByteBlockTest::testResize()
+{
+    ts::ByteBlock bb(4, 0xAA);
+    CPPUNIT_ASSERT(bb == ts::ByteBlock({0xAA, 0xAA, 0xAA, 0xAA}));
+
+    // Standard resize: the new bytes are zero, even in previously used memory.
+    bb.resize(2);
+    bb.resize(5);
+    CPPUNIT_ASSERT(bb == ts::ByteBlock({0xAA, 0xAA, 0x00, 0x00, 0x00}));
+    bb.resize(7, 0x55);
+    CPPUNIT_ASSERT(bb == ts::ByteBlock({0xAA, 0xAA, 0x00, 0x00, 0x00, 0x55, 0x55}));
+
+    // Uninitialized resize: the size changes, the previous content is preserved.
+    bb.resizeUninitialized(2);
+    CPPUNIT_ASSERT(bb == ts::ByteBlock({0xAA, 0xAA}));
+    bb.resizeUninitialized(300);
+    CPPUNIT_ASSERT_EQUAL(size_t(300), bb.size());
+    CPPUNIT_ASSERT_EQUAL(uint8_t(0xAA), bb[1]);
+
+    // Constructor with a size: zero-filled.
+    const ts::ByteBlock zero(8);
+    CPPUNIT_ASSERT(zero == ts::ByteBlock(8, 0x00));
+
+    // Appended data are fully written.
+    bb.clear();
+    bb.appendUInt16(0x1234);
+    bb.append(0x77, 3);
+    CPPUNIT_ASSERT(bb == ts::ByteBlock({0x12, 0x34, 0x77, 0x77, 0x77}));
+}
@@ -44,6 +44,7 @@
 #include "tsCTS2.h"
 #include "tsCTS3.h"
 #include "tsCTS4.h"
+#include "tsCTR.h"
 #include "tsDVS042.h"
 #include "tsSystemRandomGenerator.h"
 #include "utestCppUnitTest.h"
@@ -79,10 +80,13 @@ public:
     void testAES_CTS3();
     void testAES_CTS4();
     void testAES_DVS042();
+    void testAES_CTR();
     void testDES();
     void testTDES();
     void testTDES_CBC();
     void testDES_DVS042();
+    void testMultiBlocks();
+    void testMultiMessages();
     void testSHA1();
     void testSHA256();
     void testSHA512();
@@ -97,10 +101,13 @@ public:
     CPPUNIT_TEST(testAES_CTS3);
     CPPUNIT_TEST(testAES_CTS4);
     CPPUNIT_TEST(testAES_DVS042);
+    CPPUNIT_TEST(testAES_CTR);
     CPPUNIT_TEST(testDES);
     CPPUNIT_TEST(testTDES);
     CPPUNIT_TEST(testTDES_CBC);
     CPPUNIT_TEST(testDES_DVS042);
+    CPPUNIT_TEST(testMultiBlocks);
+    CPPUNIT_TEST(testMultiMessages);
     CPPUNIT_TEST(testSHA1);
     CPPUNIT_TEST(testSHA256);
     CPPUNIT_TEST(testSHA512);
@@ -132,6 +139,10 @@ private:
 
     void testChainingSizes(ts::CipherChaining& algo, int sizes, ...);
 
+    void testBlocks(ts::BlockCipher& algo, size_t count);
+
+    void testMessages(ts::CipherChaining& algo, const std::vector<size_t>& sizes);
+
     void testHash(ts::Hash& algo,
                   size_t tv_index,
                   size_t tv_count,
@@ -260,6 +271,65 @@ void CryptoTest::testChainingSizes(ts::CipherChaining& algo, int sizes, ...)
     va_end(ap);
 }
 
+void CryptoTest::testBlocks(ts::BlockCipher& algo, size_t count)
+{
+    ts::SystemRandomGenerator prng;
+    ts::ByteBlock key(algo.minKeySize());
+    const size_t bsize = algo.blockSize();
+    const size_t size = count * bsize;
+    ts::ByteBlock plain(size);
+    ts::ByteBlock cipher(size);
+    ts::ByteBlock inplace(size);
+
+    CPPUNIT_ASSERT(prng.read(key.data(), key.size()));
+    CPPUNIT_ASSERT(prng.read(plain.data(), plain.size()));
+    CPPUNIT_ASSERT(algo.setKey(key.data(), key.size()));
+
+    // Must be identical to one block at a time.
+    for (size_t i = 0; i < size; i += bsize) {
+        CPPUNIT_ASSERT(algo.encrypt(&plain[i], bsize, &cipher[i], bsize));
+    }
+    inplace = plain;
+    CPPUNIT_ASSERT(algo.encryptBlocks(inplace.data(), inplace.data(), count));
+    CPPUNIT_ASSERT(inplace == cipher);
+    CPPUNIT_ASSERT(algo.decryptBlocks(inplace.data(), inplace.data(), count));
+    CPPUNIT_ASSERT(inplace == plain);
+}
+
+void CryptoTest::testMessages(ts::CipherChaining& algo, const std::vector<size_t>& sizes)
+{
+    ts::SystemRandomGenerator prng;
+    ts::ByteBlock key(algo.minKeySize());
+    ts::ByteBlock iv(algo.minIVSize());
+    std::vector<ts::ByteBlock> plain(sizes.size());
+    std::vector<ts::ByteBlock> cipher(sizes.size());
+    std::vector<ts::ByteBlock> inplace(sizes.size());
+    std::vector<uint8_t*> data(sizes.size());
+
+    CPPUNIT_ASSERT(prng.read(key.data(), key.size()));
+    CPPUNIT_ASSERT(prng.read(iv.data(), iv.size()));
+    CPPUNIT_ASSERT(algo.setKey(key.data(), key.size()));
+    CPPUNIT_ASSERT(algo.setIV(iv.data(), iv.size()));
+
+    // Must be identical to one message at a time.
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        plain[i].resize(sizes[i]);
+        cipher[i].resize(sizes[i]);
+        CPPUNIT_ASSERT(prng.read(plain[i].data(), plain[i].size()));
+        CPPUNIT_ASSERT(algo.encrypt(plain[i].data(), plain[i].size(), cipher[i].data(), cipher[i].size()));
+        inplace[i] = plain[i];
+        data[i] = inplace[i].data();
+    }
+    CPPUNIT_ASSERT(algo.encryptMessages(data.data(), sizes.data(), sizes.size()));
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        CPPUNIT_ASSERT(inplace[i] == cipher[i]);
+    }
+    CPPUNIT_ASSERT(algo.decryptMessages(data.data(), sizes.data(), sizes.size()));
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        CPPUNIT_ASSERT(inplace[i] == plain[i]);
+    }
+}
+
 void CryptoTest::testHash(ts::Hash& algo,
                           size_t tv_index,
                           size_t tv_count,
@@ -363,6 +433,43 @@ void CryptoTest::testAES_DVS042()
     testChainingSizes(dvs042_aes, 16, 17, 23, 31, 32, 33, 45, 64, 67, 184, 12345, 0);
 }
 
+void CryptoTest::testAES_CTR()
+{
+    ts::CTR<ts::AES> ctr_aes;
+    CPPUNIT_ASSERT_EQUAL(size_t(128), ctr_aes.counterBits());
+    const size_t tv_count = sizeof(tv_ctr_aes) / sizeof(TV_AES_CHAIN);
+    for (size_t tvi = 0; tvi < tv_count; ++tvi) {
+        const TV_AES_CHAIN* tv = tv_ctr_aes + tvi;
+        testChaining(ctr_aes, tvi, tv_count, tv->key, tv->key_size, tv->iv, tv->iv_size, tv->plain, tv->plain_size, tv->cipher, tv->cipher_size);
+    }
+    testChainingSizes(ctr_aes, 1, 15, 16, 17, 31, 32, 33, 45, 64, 67, 184, 12345, 0);
+
+    // With a 32-bit counter, the increment does not propagate into the nonce.
+    ts::CTR<ts::AES> ctr32_aes(32);
+    ts::ECB<ts::AES> ecb_aes;
+    CPPUNIT_ASSERT_EQUAL(size_t(32), ctr32_aes.counterBits());
+    const uint8_t key[16] = {0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6, 0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C};
+    const uint8_t counters[32] = {
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0xFF, 0xFF, 0xFF, 0xFF,
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x00, 0x00, 0x00, 0x00,
+    };
+    const uint8_t zero[32] = {0};
+    uint8_t keystream[32];
+    uint8_t expected[32];
+    CPPUNIT_ASSERT(ctr32_aes.setKey(key, sizeof(key)));
+    CPPUNIT_ASSERT(ctr32_aes.setIV(counters, 16));
+    CPPUNIT_ASSERT(ctr32_aes.encrypt(zero, sizeof(zero), keystream, sizeof(keystream)));
+    CPPUNIT_ASSERT(ecb_aes.setKey(key, sizeof(key)));
+    CPPUNIT_ASSERT(ecb_aes.encrypt(counters, sizeof(counters), expected, sizeof(expected)));
+    CPPUNIT_ASSERT(::memcmp(keystream, expected, sizeof(expected)) == 0);
+
+    // With a counter offset, the keystream continues. The second block is the
+    // second half of the previous keystream, the counter wraps in its 32 bits.
+    ctr32_aes.setCounterOffset(1);
+    CPPUNIT_ASSERT(ctr32_aes.encrypt(zero, 16, keystream, 16));
+    CPPUNIT_ASSERT(::memcmp(keystream, expected + 16, 16) == 0);
+}
+
 void CryptoTest::testDES()
 {
     ts::DES des;
@@ -441,6 +548,107 @@ void CryptoTest::testDES_DVS042()
     }
 }
 
+void CryptoTest::testMultiBlocks()
+{
+    ts::AES aes;
+    ts::DES des;
+    ts::TDES tdes;
+    testBlocks(aes, 1);
+    testBlocks(aes, 4);
+    testBlocks(aes, 37);
+    testBlocks(des, 37);
+
+    // DES and TDES use a bitsliced implementation on complete or padded batches of blocks.
+    testBlocks(des, 64);
+    testBlocks(des, 128);
+    testBlocks(des, 200);
+    testBlocks(des, 1000);
+    testBlocks(tdes, 37);
+    testBlocks(tdes, 128);
+    testBlocks(tdes, 1000);
+
+    // CBC decryption is performed several blocks at a time, check in-place decryption.
+    ts::SystemRandomGenerator prng;
+    ts::CBC<ts::AES> cbc_aes;
+    ts::ByteBlock key(cbc_aes.minKeySize());
+    ts::ByteBlock iv(cbc_aes.minIVSize());
+    ts::ByteBlock plain(37 * cbc_aes.blockSize());
+    ts::ByteBlock cipher(plain.size());
+
+    CPPUNIT_ASSERT(prng.read(key.data(), key.size()));
+    CPPUNIT_ASSERT(prng.read(iv.data(), iv.size()));
+    CPPUNIT_ASSERT(prng.read(plain.data(), plain.size()));
+    CPPUNIT_ASSERT(cbc_aes.setKey(key.data(), key.size()));
+    CPPUNIT_ASSERT(cbc_aes.setIV(iv.data(), iv.size()));
+    CPPUNIT_ASSERT(cbc_aes.encrypt(plain.data(), plain.size(), cipher.data(), cipher.size()));
+    CPPUNIT_ASSERT(cbc_aes.decrypt(cipher.data(), cipher.size(), cipher.data(), cipher.size()));
+    CPPUNIT_ASSERT(cipher == plain);
+}
+
+void CryptoTest::testMultiMessages()
+{
+    // Typical TS packet payload sizes, including DVS 042 residues.
+    const std::vector<size_t> dvs042_sizes({184, 176, 16, 183, 17, 184, 31, 100, 184});
+    const std::vector<size_t> cbc_sizes({176, 16, 160, 176, 32, 176, 176});
+
+    ts::DVS042<ts::AES> dvs042_aes;
+    ts::DVS042<ts::DES> dvs042_des;
+    ts::CBC<ts::AES> cbc_aes;
+    ts::CBC<ts::TDES> cbc_tdes;
+    ts::CTS2<ts::AES> cts2_aes;
+    ts::CTR<ts::AES> ctr_aes;
+
+    testMessages(dvs042_aes, dvs042_sizes);
+    testMessages(dvs042_des, dvs042_sizes);
+    testMessages(cbc_aes, cbc_sizes);
+    testMessages(cbc_tdes, cbc_sizes);
+    testMessages(cts2_aes, dvs042_sizes);
+
+    // Only one message.
+    testMessages(dvs042_aes, std::vector<size_t>(1, 184));
+
+    // In CTR mode, the messages use consecutive counter blocks, as if each message
+    // was encrypted with a counter offset after the blocks of the previous ones.
+    ts::SystemRandomGenerator prng;
+    ts::ByteBlock key(ctr_aes.minKeySize());
+    ts::ByteBlock iv(ctr_aes.minIVSize());
+    CPPUNIT_ASSERT(prng.read(key.data(), key.size()));
+    CPPUNIT_ASSERT(prng.read(iv.data(), iv.size()));
+    CPPUNIT_ASSERT(ctr_aes.setKey(key.data(), key.size()));
+    CPPUNIT_ASSERT(ctr_aes.setIV(iv.data(), iv.size()));
+    std::vector<ts::ByteBlock> msg(dvs042_sizes.size());
+    std::vector<ts::ByteBlock> ref(dvs042_sizes.size());
+    std::vector<uint8_t*> ctr_data(dvs042_sizes.size());
+    uint64_t offset = 0;
+    for (size_t i = 0; i < dvs042_sizes.size(); ++i) {
+        msg[i].resize(dvs042_sizes[i]);
+        ref[i].resize(dvs042_sizes[i]);
+        CPPUNIT_ASSERT(prng.read(msg[i].data(), msg[i].size()));
+        if (i == 5) {
+            // Same size and content as the first message.
+            msg[i] = msg[0];
+        }
+        ctr_aes.setCounterOffset(offset);
+        CPPUNIT_ASSERT(ctr_aes.encrypt(msg[i].data(), msg[i].size(), ref[i].data(), ref[i].size()));
+        offset += ctr_aes.counterBlocks(msg[i].size());
+        ctr_data[i] = msg[i].data();
+    }
+    // Identical messages do not produce identical cipher texts.
+    CPPUNIT_ASSERT(ref[0] != ref[5]);
+    ctr_aes.setCounterOffset(0);
+    CPPUNIT_ASSERT(ctr_aes.encryptMessages(ctr_data.data(), dvs042_sizes.data(), dvs042_sizes.size()));
+    for (size_t i = 0; i < dvs042_sizes.size(); ++i) {
+        CPPUNIT_ASSERT(msg[i] == ref[i]);
+    }
+
+    // Invalid sizes.
+    std::vector<uint8_t> buf(16);
+    uint8_t* data[1] = {buf.data()};
+    const size_t size[1] = {buf.size() - 1};
+    CPPUNIT_ASSERT(!dvs042_aes.decryptMessages(data, size, 1));
+    CPPUNIT_ASSERT(!cbc_aes.decryptMessages(data, size, 1));
+}
+
 void CryptoTest::testSHA1()
 {
     ts::SHA1 sha1;
@@ -32,6 +32,8 @@
 //----------------------------------------------------------------------------
 
 #include "tsDVBCharset.h"
+#include "tsDVBCharsetSingleByte.h"
+#include "tsByteBlock.h"
 #include "utestCppUnitTest.h"
 TSDUCK_SOURCE;
 
@@ -46,9 +48,13 @@ public:
     virtual void tearDown() override;
 
     void testRepository();
+    void testLongLatin();
+    void testDecodeCache();
 
     CPPUNIT_TEST_SUITE(DVBCharsetTest);
     CPPUNIT_TEST(testRepository);
+    CPPUNIT_TEST(testLongLatin);
+    CPPUNIT_TEST(testDecodeCache);
     CPPUNIT_TEST_SUITE_END();
 };
 
@@ -79,3 +85,60 @@ void DVBCharsetTest::testRepository()
     utest::Out() << "DVBCharsetTest::testRepository: charsets: " << ts::UString::Join(ts::DVBCharset::GetAllNames()) << std::endl;
     CPPUNIT_ASSERT_EQUAL(size_t(17), ts::DVBCharset::GetAllNames().size());
 }
+
+void DVBCharsetTest::testLongLatin()
+{
+    // ISO 8859-1 is an identity mapping for 0x20-0x7E and 0xA0-0xFF.
+    // Build strings which cross the 16-byte boundaries of vectorized decoding in all possible ways.
+    for (size_t size = 0; size < 80; ++size) {
+        for (size_t special = 0; special <= size; ++special) {
+            ts::ByteBlock dvb;
+            ts::UString ref;
+            for (size_t i = 0; i < size; ++i) {
+                const uint8_t b = i == special ? 0xE9 : uint8_t(0x20 + (i * 7) % 0x5F);
+                dvb.push_back(b);
+                ref.push_back(ts::UChar(b));
+            }
+            ts::UString str;
+            CPPUNIT_ASSERT(ts::DVBCharsetSingleByte::ISO_8859_1.decode(str, dvb.data(), dvb.size()));
+            CPPUNIT_ASSERT_EQUAL(ref, str);
+        }
+    }
+
+    // Untranslatable characters are skipped, new lines are translated.
+    static const uint8_t dvb[] = {
+        'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P',
+        0x8A, 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p',
+        0x01, 'q', 'r', 's', 't', 'u', 'v', 'w', 'x', 'y', 'z', '0', '1', '2', '3', '4', '5', '6',
+    };
+    ts::UString str;
+    CPPUNIT_ASSERT(!ts::DVBCharsetSingleByte::ISO_8859_1.decode(str, dvb, sizeof(dvb)));
+    CPPUNIT_ASSERT_EQUAL(ts::UString(u"ABCDEFGHIJKLMNOP\nabcdefghijklmnopqrstuvwxyz0123456"), str);
+}
+
+void DVBCharsetTest::testDecodeCache()
+{
+    // ISO 6937 (default DVB charset), with non-spacing diacritical marks before the letters.
+    static const uint8_t dvb[] = {'C', 'a', 'f', 0xC2, 'e', ' ', 'T', 'h', 0xC2, 'e', 0xC3, 'a', 't', 'r', 'e'};
+    const ts::UString ref(u"Caf\u0301e Th\u0301e\u0302atre");
+
+    // Repeated decoding, the second time from the cache.
+    ts::DVBCharset::EnableDecodeCache(true);
+    for (int i = 0; i < 2; ++i) {
+        ts::UString str;
+        CPPUNIT_ASSERT(ts::DVBCharsetSingleByte::ISO_6937.decodeCached(str, dvb, sizeof(dvb)));
+        CPPUNIT_ASSERT_EQUAL(ref, str);
+        CPPUNIT_ASSERT_EQUAL(ref, ts::UString::FromDVB(dvb, sizeof(dvb)));
+    }
+
+    // Same content with another charset must not hit the cache.
+    ts::UString str;
+    ts::DVBCharsetSingleByte::ISO_8859_1.decodeCached(str, dvb, sizeof(dvb));
+    CPPUNIT_ASSERT(str != ref);
+    CPPUNIT_ASSERT_EQUAL(sizeof(dvb), str.size());
+
+    // Disabled cache.
+    ts::DVBCharset::EnableDecodeCache(false);
+    CPPUNIT_ASSERT(ts::DVBCharsetSingleByte::ISO_6937.decodeCached(str, dvb, sizeof(dvb)));
+    CPPUNIT_ASSERT_EQUAL(ref, str);
+}
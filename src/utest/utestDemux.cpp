@@ -32,6 +32,7 @@
 //----------------------------------------------------------------------------
 
 #include "tsSectionDemux.h"
+#include "tsCASMapper.h"
 #include "tsStandaloneTableDemux.h"
 #include "tsOneShotPacketizer.h"
 #include "tsPAT.h"
@@ -43,6 +44,7 @@
 #include "tsTOT.h"
 #include "tsTDT.h"
 #include "tsNames.h"
+#include "tsNullReport.h"
 #include "utestCppUnitTest.h"
 TSDUCK_SOURCE;
 
@@ -91,6 +93,11 @@ public:
     void testTDT();
     void testTOT();
     void testHEVC();
+    void testChangeOnly();
+    void testSectionView();
+    void testIgnoreCRC();
+    void testHeaderFilter();
+    void testCASMapper();
 
     CPPUNIT_TEST_SUITE(DemuxTest);
     CPPUNIT_TEST(testPAT);
@@ -104,6 +111,11 @@ public:
     CPPUNIT_TEST(testTDT);
     CPPUNIT_TEST(testTOT);
     CPPUNIT_TEST(testHEVC);
+    CPPUNIT_TEST(testChangeOnly);
+    CPPUNIT_TEST(testSectionView);
+    CPPUNIT_TEST(testIgnoreCRC);
+    CPPUNIT_TEST(testHeaderFilter);
+    CPPUNIT_TEST(testCASMapper);
     CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -486,3 +498,257 @@ void DemuxTest::testHEVC()
 {
     TEST_TABLE("PMT with HEVC descriptor", pmt_hevc);
 }
+
+namespace {
+    // Count all sections and tables which are delivered by a demux.
+    class DemuxCounter: public ts::TableHandlerInterface, public ts::SectionHandlerInterface
+    {
+    public:
+        size_t tables;
+        size_t sections;
+        DemuxCounter() : tables(0), sections(0) {}
+        virtual void handleTable(ts::SectionDemux&, const ts::BinaryTable&) override { tables++; }
+        virtual void handleSection(ts::SectionDemux&, const ts::Section&) override { sections++; }
+    };
+}
+
+void DemuxTest::testChangeOnly()
+{
+    // TDT and TOT are single-packet tables with short sections on the same PID.
+    CPPUNIT_ASSERT_EQUAL(ts::PKT_SIZE, sizeof(psi_tdt_tnt_packets));
+    CPPUNIT_ASSERT_EQUAL(ts::PKT_SIZE, sizeof(psi_tot_tnt_packets));
+    const ts::TSPacket& tdt(*reinterpret_cast<const ts::TSPacket*>(psi_tdt_tnt_packets));
+    const ts::TSPacket& tot(*reinterpret_cast<const ts::TSPacket*>(psi_tot_tnt_packets));
+
+    DemuxCounter all;
+    DemuxCounter changes;
+    ts::SectionDemux demux_all(&all, &all, ts::AllPIDs);
+    ts::SectionDemux demux_changes(&changes, &changes, ts::AllPIDs);
+    CPPUNIT_ASSERT(!demux_changes.getChangeOnly());
+    demux_changes.setChangeOnly(true);
+    CPPUNIT_ASSERT(demux_changes.getChangeOnly());
+
+    // Sequence: TOT, TOT, TDT, TOT, TDT, TDT.
+    const ts::TSPacket* const sequence[] = {&tot, &tot, &tdt, &tot, &tdt, &tdt};
+    uint8_t cc = 0;
+    for (size_t i = 0; i < sizeof(sequence) / sizeof(sequence[0]); ++i) {
+        ts::TSPacket pkt;
+        pkt = *sequence[i];
+        pkt.setCC(cc);
+        cc = (cc + 1) % ts::CC_MAX;
+        demux_all.feedPacket(pkt);
+        demux_changes.feedPacket(pkt);
+    }
+
+    CPPUNIT_ASSERT_EQUAL(size_t(6), all.sections);
+    CPPUNIT_ASSERT_EQUAL(size_t(6), all.tables);
+    CPPUNIT_ASSERT_EQUAL(size_t(2), changes.sections);
+    CPPUNIT_ASSERT_EQUAL(size_t(2), changes.tables);
+
+    // After a reset, the next occurrence is a change again.
+    demux_changes.reset();
+    ts::TSPacket pkt;
+    pkt = tot;
+    pkt.setCC(cc);
+    demux_changes.feedPacket(pkt);
+    CPPUNIT_ASSERT_EQUAL(size_t(3), changes.sections);
+    CPPUNIT_ASSERT_EQUAL(size_t(3), changes.tables);
+
+    // A TOT is a short section which ends with its own CRC32. Another UTC time is a change.
+    CPPUNIT_ASSERT_EQUAL(uint8_t(0), pkt.b[4]);
+    const size_t size = ts::SHORT_SECTION_HEADER_SIZE + (ts::GetUInt16(pkt.b + 6) & 0x0FFF);
+    pkt.b[5 + ts::SHORT_SECTION_HEADER_SIZE + 4] ^= 0x01;
+    ts::PutUInt32(pkt.b + 5 + size - 4, ts::CRC32(pkt.b + 5, size - 4).value());
+    pkt.setCC(++cc % ts::CC_MAX);
+    demux_changes.feedPacket(pkt);
+    CPPUNIT_ASSERT_EQUAL(size_t(4), changes.sections);
+    CPPUNIT_ASSERT_EQUAL(size_t(4), changes.tables);
+}
+
+namespace {
+    // Collect views on single-packet sections from a demux.
+    class ViewCollector: public ts::TableHandlerInterface, public ts::SectionViewHandlerInterface
+    {
+    public:
+        size_t tables;
+        size_t views;
+        ts::TID tid;
+        uint16_t tid_ext;
+        ts::PID pid;
+        ts::ByteBlock content;
+        ViewCollector() : tables(0), views(0), tid(ts::TID_NULL), tid_ext(0), pid(ts::PID_NULL), content() {}
+        virtual void handleTable(ts::SectionDemux&, const ts::BinaryTable&) override { tables++; }
+        virtual void handleSectionView(ts::SectionDemux&, const ts::SectionView& sect) override
+        {
+            views++;
+            tid = sect.tableId();
+            tid_ext = sect.tableIdExtension();
+            pid = sect.sourcePID();
+            content.copy(sect.content(), sect.size());
+        }
+    };
+}
+
+void DemuxTest::testSectionView()
+{
+    ViewCollector coll;
+    ts::SectionDemux demux(&coll, 0, ts::AllPIDs);
+    demux.setSectionViewHandler(&coll);
+
+    // The PMT is one section in one packet: one view.
+    const ts::TSPacket* pkt = reinterpret_cast<const ts::TSPacket*>(psi_pmt_planete_packets);
+    CPPUNIT_ASSERT_EQUAL(ts::PKT_SIZE, sizeof(psi_pmt_planete_packets));
+    demux.feedPacket(*pkt);
+    CPPUNIT_ASSERT_EQUAL(size_t(1), coll.tables);
+    CPPUNIT_ASSERT_EQUAL(size_t(1), coll.views);
+    CPPUNIT_ASSERT_EQUAL(ts::TID(ts::TID_PMT), coll.tid);
+    CPPUNIT_ASSERT_EQUAL(uint16_t(0x0304), coll.tid_ext);
+    CPPUNIT_ASSERT_EQUAL(pkt->getPID(), coll.pid);
+    CPPUNIT_ASSERT(coll.content == ts::ByteBlock(psi_pmt_planete_sections, sizeof(psi_pmt_planete_sections)));
+
+    // The NIT spans several packets: no view, only the table.
+    pkt = reinterpret_cast<const ts::TSPacket*>(psi_nit_tntv23_packets);
+    for (size_t pi = 0; pi < sizeof(psi_nit_tntv23_packets) / ts::PKT_SIZE; ++pi) {
+        demux.feedPacket(pkt[pi]);
+    }
+    CPPUNIT_ASSERT_EQUAL(size_t(2), coll.tables);
+    CPPUNIT_ASSERT_EQUAL(size_t(1), coll.views);
+}
+
+void DemuxTest::testIgnoreCRC()
+{
+    // Corrupt the CRC32 of the single-packet PMT.
+    CPPUNIT_ASSERT_EQUAL(ts::PKT_SIZE, sizeof(psi_pmt_planete_packets));
+    ts::TSPacket pkt;
+    ::memcpy(pkt.b, psi_pmt_planete_packets, ts::PKT_SIZE);
+    const size_t crc_offset = pkt.getHeaderSize() + 1 + sizeof(psi_pmt_planete_sections) - 4;
+    CPPUNIT_ASSERT(::memcmp(pkt.b + crc_offset, psi_pmt_planete_sections + sizeof(psi_pmt_planete_sections) - 4, 4) == 0);
+    pkt.b[crc_offset] ^= 0xFF;
+
+    DemuxCounter checked;
+    DemuxCounter ignored;
+    ts::SectionDemux demux_checked(&checked, &checked, ts::AllPIDs);
+    ts::SectionDemux demux_ignored(&ignored, &ignored, ts::AllPIDs);
+    CPPUNIT_ASSERT_EQUAL(ts::CRC32::CHECK, demux_checked.getCRCValidation());
+    demux_ignored.setCRCValidation(ts::CRC32::IGNORE);
+    CPPUNIT_ASSERT_EQUAL(ts::CRC32::IGNORE, demux_ignored.getCRCValidation());
+
+    demux_checked.feedPacket(pkt);
+    demux_ignored.feedPacket(pkt);
+
+    CPPUNIT_ASSERT_EQUAL(size_t(0), checked.sections);
+    CPPUNIT_ASSERT_EQUAL(size_t(0), checked.tables);
+    CPPUNIT_ASSERT_EQUAL(size_t(1), ignored.sections);
+    CPPUNIT_ASSERT_EQUAL(size_t(1), ignored.tables);
+
+    ts::SectionDemux::Status status_checked(demux_checked);
+    ts::SectionDemux::Status status_ignored(demux_ignored);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1), uint64_t(status_checked.wrong_crc));
+    CPPUNIT_ASSERT_EQUAL(uint64_t(0), uint64_t(status_ignored.wrong_crc));
+}
+
+namespace {
+    // Feed packets to a demux, with continuous CC across calls.
+    void FeedContinuous(ts::SectionDemux& demux, const uint8_t* packets, size_t size, uint8_t& cc)
+    {
+        for (size_t i = 0; i + ts::PKT_SIZE <= size; i += ts::PKT_SIZE) {
+            ts::TSPacket pkt;
+            ::memcpy(pkt.b, packets + i, ts::PKT_SIZE);
+            pkt.setCC(cc);
+            cc = (cc + 1) % ts::CC_MAX;
+            demux.feedPacket(pkt);
+        }
+    }
+}
+
+void DemuxTest::testHeaderFilter()
+{
+    DemuxCounter counter;
+    ts::SectionDemux demux(&counter, &counter, ts::AllPIDs);
+    CPPUNIT_ASSERT(demux.getHeaderFilter().tids.all());
+
+    // The multi-packet NIT is fed several times with continuous CC.
+    CPPUNIT_ASSERT(sizeof(psi_nit_tntv23_packets) > ts::PKT_SIZE);
+    uint8_t cc = 0;
+
+    // Rejected on table id: the NIT sections are skipped without any error.
+    ts::SectionDemux::HeaderFilter filter;
+    filter.tids.reset(ts::TID_NIT_ACT);
+    CPPUNIT_ASSERT(!filter.tids.all());
+    demux.setHeaderFilter(filter);
+    FeedContinuous(demux, psi_nit_tntv23_packets, sizeof(psi_nit_tntv23_packets), cc);
+    FeedContinuous(demux, psi_nit_tntv23_packets, sizeof(psi_nit_tntv23_packets), cc);
+    CPPUNIT_ASSERT_EQUAL(size_t(0), counter.sections);
+    CPPUNIT_ASSERT_EQUAL(size_t(0), counter.tables);
+    CPPUNIT_ASSERT(!demux.hasErrors());
+
+    // Rejected on table id extension.
+    const uint16_t network_id = ts::GetUInt16(psi_nit_tntv23_sections + 3);
+    filter.reset();
+    filter.tid_exts.insert(network_id);
+    filter.negate_tid_ext = true;
+    demux.setHeaderFilter(filter);
+    FeedContinuous(demux, psi_nit_tntv23_packets, sizeof(psi_nit_tntv23_packets), cc);
+    CPPUNIT_ASSERT_EQUAL(size_t(0), counter.tables);
+    CPPUNIT_ASSERT(!demux.hasErrors());
+
+    // Accepted on table id extension.
+    filter.negate_tid_ext = false;
+    demux.setHeaderFilter(filter);
+    FeedContinuous(demux, psi_nit_tntv23_packets, sizeof(psi_nit_tntv23_packets), cc);
+    CPPUNIT_ASSERT_EQUAL(size_t(1), counter.tables);
+    CPPUNIT_ASSERT(!demux.hasErrors());
+
+    // Rejected on version, then accepted again by default.
+    filter.reset();
+    filter.versions.reset((psi_nit_tntv23_sections[5] >> 1) & 0x1F);
+    demux.setHeaderFilter(filter);
+    demux.reset();
+    FeedContinuous(demux, psi_nit_tntv23_packets, sizeof(psi_nit_tntv23_packets), cc);
+    CPPUNIT_ASSERT_EQUAL(size_t(1), counter.tables);
+    demux.setHeaderFilter(ts::SectionDemux::HeaderFilter());
+    FeedContinuous(demux, psi_nit_tntv23_packets, sizeof(psi_nit_tntv23_packets), cc);
+    CPPUNIT_ASSERT_EQUAL(size_t(2), counter.tables);
+    CPPUNIT_ASSERT(!demux.hasErrors());
+}
+
+void DemuxTest::testCASMapper()
+{
+    // The CAT contains one MediaGuard CA_descriptor, EMM PID 0x00C1.
+    ts::CASMapper mapper(NULLREP);
+    CPPUNIT_ASSERT_EQUAL(uint32_t(0), mapper.generation());
+    CPPUNIT_ASSERT(!mapper.knownPID(0x00C1));
+    CPPUNIT_ASSERT(mapper.emmPIDs().none());
+
+    for (size_t i = 0; i < sizeof(psi_cat_r3_packets); i += ts::PKT_SIZE) {
+        ts::TSPacket pkt;
+        ::memcpy(pkt.b, psi_cat_r3_packets + i, ts::PKT_SIZE);
+        mapper.feedPacket(pkt);
+    }
+
+    CPPUNIT_ASSERT_EQUAL(uint32_t(1), mapper.generation());
+    CPPUNIT_ASSERT(mapper.knownPID(0x00C1));
+    CPPUNIT_ASSERT(mapper.isEMM(0x00C1));
+    CPPUNIT_ASSERT(!mapper.isECM(0x00C1));
+    CPPUNIT_ASSERT_EQUAL(uint16_t(0x0100), mapper.casId(0x00C1));
+    CPPUNIT_ASSERT_EQUAL(ts::CAS_MEDIAGUARD, mapper.casFamily(0x00C1));
+    CPPUNIT_ASSERT_EQUAL(size_t(1), mapper.emmPIDs().count());
+    CPPUNIT_ASSERT(mapper.emmPIDs(ts::CAS_MEDIAGUARD).test(0x00C1));
+    CPPUNIT_ASSERT(mapper.emmPIDs(ts::CAS_NAGRA).none());
+    CPPUNIT_ASSERT(mapper.ecmPIDs().none());
+    CPPUNIT_ASSERT(!mapper.knownPID(0x00C2));
+    CPPUNIT_ASSERT_EQUAL(uint16_t(0), mapper.casId(0x00C2));
+    CPPUNIT_ASSERT_EQUAL(ts::CAS_OTHER, mapper.casFamily(0x00C2));
+    CPPUNIT_ASSERT_EQUAL(ts::CAS_OTHER, mapper.casFamily(ts::PID_MAX));
+
+    ts::CADescriptorPtr desc;
+    CPPUNIT_ASSERT(mapper.getCADescriptor(0x00C1, desc));
+    CPPUNIT_ASSERT_EQUAL(uint16_t(0x0100), desc->cas_id);
+    CPPUNIT_ASSERT(!mapper.getCADescriptor(0x00C2, desc));
+
+    mapper.reset();
+    CPPUNIT_ASSERT_EQUAL(uint32_t(2), mapper.generation());
+    CPPUNIT_ASSERT(!mapper.knownPID(0x00C1));
+    CPPUNIT_ASSERT(mapper.emmPIDs().none());
+    CPPUNIT_ASSERT(mapper.emmPIDs(ts::CAS_MEDIAGUARD).none());
+}
@@ -0,0 +1,264 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+//
+//  CppUnit test suite for class ts::DescriptorList
+//
+//----------------------------------------------------------------------------
+
+#include "tsDescriptorList.h"
+#include "tsPrivateDataSpecifierDescriptor.h"
+#include "utestCppUnitTest.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// The test fixture
+//----------------------------------------------------------------------------
+
+class DescriptorListTest: public CppUnit::TestFixture
+{
+public:
+    virtual void setUp() override;
+    virtual void tearDown() override;
+
+    void testSearch();
+    void testSearchPDS();
+    void testModify();
+    void testStorage();
+
+    CPPUNIT_TEST_SUITE(DescriptorListTest);
+    CPPUNIT_TEST(testSearch);
+    CPPUNIT_TEST(testSearchPDS);
+    CPPUNIT_TEST(testModify);
+    CPPUNIT_TEST(testStorage);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    // Add a descriptor with the specified tag and a one-byte payload.
+    static void addDescriptor(ts::DescriptorList& dlist, ts::DID tag, uint8_t value);
+
+    // Reference sequential search.
+    static size_t linearSearch(const ts::DescriptorList& dlist, ts::DID tag, size_t start_index, ts::PDS pds);
+
+    // Check all searches in a list against the reference search.
+    static void checkAllSearches(const ts::DescriptorList& dlist, ts::PDS pds);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DescriptorListTest);
+
+
+//----------------------------------------------------------------------------
+// Initialization.
+//----------------------------------------------------------------------------
+
+// Test suite initialization method.
+void DescriptorListTest::setUp()
+{
+}
+
+// Test suite cleanup method.
+void DescriptorListTest::tearDown()
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Helpers.
+//----------------------------------------------------------------------------
+
+void DescriptorListTest::addDescriptor(ts::DescriptorList& dlist, ts::DID tag, uint8_t value)
+{
+    const uint8_t data[3] = {tag, 1, value};
+    dlist.add(data, sizeof(data));
+}
+
+size_t DescriptorListTest::linearSearch(const ts::DescriptorList& dlist, ts::DID tag, size_t start_index, ts::PDS pds)
+{
+    const bool check_pds = pds != 0 && tag >= 0x80;
+    size_t index = start_index;
+    while (index < dlist.count() && (dlist[index]->tag() != tag || (check_pds && dlist.privateDataSpecifier(index) != pds))) {
+        index++;
+    }
+    return index;
+}
+
+void DescriptorListTest::checkAllSearches(const ts::DescriptorList& dlist, ts::PDS pds)
+{
+    for (int tag = 0; tag < 256; ++tag) {
+        for (size_t start = 0; start <= dlist.count() + 1; ++start) {
+            CPPUNIT_ASSERT_EQUAL(linearSearch(dlist, ts::DID(tag), start, pds), dlist.search(ts::DID(tag), start, pds));
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Test cases
+//----------------------------------------------------------------------------
+
+void DescriptorListTest::testSearch()
+{
+    // Short list, sequential search.
+    ts::DescriptorList dlist;
+    addDescriptor(dlist, 0x48, 0);
+    addDescriptor(dlist, 0x09, 1);
+    addDescriptor(dlist, 0x09, 2);
+    CPPUNIT_ASSERT(dlist.count() < ts::DescriptorList::INDEX_THRESHOLD);
+    CPPUNIT_ASSERT_EQUAL(size_t(1), dlist.search(0x09));
+    CPPUNIT_ASSERT_EQUAL(size_t(2), dlist.search(0x09, 2));
+    CPPUNIT_ASSERT_EQUAL(size_t(3), dlist.search(0x09, 3));
+    CPPUNIT_ASSERT_EQUAL(size_t(3), dlist.search(0x4A));
+    checkAllSearches(dlist, 0);
+
+    // Long list, indexed search.
+    for (size_t i = 0; i < 100; ++i) {
+        addDescriptor(dlist, ts::DID(0x40 + (i * 7) % 11), uint8_t(i));
+    }
+    CPPUNIT_ASSERT(dlist.count() >= ts::DescriptorList::INDEX_THRESHOLD);
+    CPPUNIT_ASSERT_EQUAL(size_t(1), dlist.search(0x09));
+    CPPUNIT_ASSERT_EQUAL(size_t(2), dlist.search(0x09, 2));
+    CPPUNIT_ASSERT_EQUAL(dlist.count(), dlist.search(0x09, 3));
+    CPPUNIT_ASSERT_EQUAL(dlist.count() + 5, dlist.search(0x09, dlist.count() + 5));
+    checkAllSearches(dlist, 0);
+
+    // Usual iteration pattern.
+    size_t found = 0;
+    for (size_t index = dlist.search(0x40); index < dlist.count(); index = dlist.search(0x40, index + 1)) {
+        CPPUNIT_ASSERT_EQUAL(ts::DID(0x40), dlist[index]->tag());
+        found++;
+    }
+    CPPUNIT_ASSERT_EQUAL(size_t(10), found);
+}
+
+void DescriptorListTest::testSearchPDS()
+{
+    ts::DescriptorList dlist;
+    for (size_t i = 0; i < 60; ++i) {
+        if (i % 10 == 0) {
+            dlist.add(ts::PrivateDataSpecifierDescriptor(ts::PDS(0x1000 + i / 20)));
+        }
+        addDescriptor(dlist, ts::DID(i % 3 == 0 ? 0x83 : 0x50 + i % 4), uint8_t(i));
+    }
+    CPPUNIT_ASSERT(dlist.count() >= ts::DescriptorList::INDEX_THRESHOLD);
+    checkAllSearches(dlist, 0);
+    checkAllSearches(dlist, 0x1000);
+    checkAllSearches(dlist, 0x1001);
+    checkAllSearches(dlist, 0x1002);
+    checkAllSearches(dlist, 0x1003);
+}
+
+void DescriptorListTest::testModify()
+{
+    ts::DescriptorList dlist;
+    for (size_t i = 0; i < 50; ++i) {
+        addDescriptor(dlist, ts::DID(0x40 + i % 5), uint8_t(i));
+    }
+    checkAllSearches(dlist, 0);
+
+    // The index is rebuilt after each modification.
+    CPPUNIT_ASSERT(dlist.removeByIndex(0));
+    checkAllSearches(dlist, 0);
+    CPPUNIT_ASSERT_EQUAL(size_t(10), dlist.removeByTag(0x42));
+    CPPUNIT_ASSERT_EQUAL(dlist.count(), dlist.search(0x42));
+    checkAllSearches(dlist, 0);
+    addDescriptor(dlist, 0x42, 0);
+    CPPUNIT_ASSERT_EQUAL(dlist.count() - 1, dlist.search(0x42));
+    checkAllSearches(dlist, 0);
+
+    // A copy has its own index.
+    ts::DescriptorList other(dlist);
+    other.add(dlist);
+    CPPUNIT_ASSERT_EQUAL(2 * dlist.count(), other.count());
+    checkAllSearches(other, 0);
+    checkAllSearches(dlist, 0);
+
+    other = dlist;
+    checkAllSearches(other, 0);
+
+    other.clear();
+    CPPUNIT_ASSERT_EQUAL(size_t(0), other.search(0x42));
+}
+
+void DescriptorListTest::testStorage()
+{
+    uint8_t payload[255];
+    for (size_t i = 0; i < sizeof(payload); ++i) {
+        payload[i] = uint8_t(i);
+    }
+    const size_t short_size = ts::Descriptor::INLINE_MAX_SIZE - 2;
+    const size_t long_size = ts::Descriptor::INLINE_MAX_SIZE + 10;
+
+    // Short and long descriptors have the same behavior.
+    ts::Descriptor d1(0x48, payload, short_size);
+    ts::Descriptor d2(0x48, payload, long_size);
+    CPPUNIT_ASSERT(d1.isValid());
+    CPPUNIT_ASSERT(d2.isValid());
+    CPPUNIT_ASSERT_EQUAL(ts::DID(0x48), d1.tag());
+    CPPUNIT_ASSERT_EQUAL(short_size + 2, d1.size());
+    CPPUNIT_ASSERT_EQUAL(long_size, d2.payloadSize());
+    CPPUNIT_ASSERT(::memcmp(d1.payload(), payload, short_size) == 0);
+    CPPUNIT_ASSERT(::memcmp(d2.payload(), payload, long_size) == 0);
+    CPPUNIT_ASSERT(d1 != d2);
+
+    // Deserialization from the full binary content.
+    ts::Descriptor d3(d1.content(), d1.size());
+    CPPUNIT_ASSERT(d3 == d1);
+    ts::Descriptor d4(d2.content(), d2.size());
+    CPPUNIT_ASSERT(d4 == d2);
+    CPPUNIT_ASSERT(!ts::Descriptor(d1.content(), d1.size() - 1).isValid());
+
+    // A short descriptor grows into a long one, and the reverse.
+    d3.replacePayload(payload, long_size);
+    CPPUNIT_ASSERT(d3 == d2);
+    d4.resizePayload(short_size);
+    CPPUNIT_ASSERT(d4 == d1);
+    d1.resizePayload(short_size + 2);
+    CPPUNIT_ASSERT_EQUAL(uint8_t(short_size + 2), d1.content()[1]);
+    CPPUNIT_ASSERT_EQUAL(uint8_t(0), d1.payload()[short_size]);
+    CPPUNIT_ASSERT_EQUAL(uint8_t(0), d1.payload()[short_size + 1]);
+
+    // Long descriptors are shared, short ones are duplicated.
+    ts::Descriptor d5(0x48, payload, short_size);
+    ts::Descriptor share_long(d2, ts::SHARE);
+    ts::Descriptor share_short(d5, ts::SHARE);
+    d2.payload()[0] = 0xFF;
+    d5.payload()[0] = 0xFF;
+    CPPUNIT_ASSERT(share_long == d2);
+    CPPUNIT_ASSERT(share_short != d5);
+
+    // Duplication and invalidation.
+    ts::Descriptor copy_long(d2, ts::COPY);
+    d2.payload()[0] = 0x00;
+    CPPUNIT_ASSERT(copy_long != d2);
+    d2.invalidate();
+    CPPUNIT_ASSERT(!d2.isValid());
+    CPPUNIT_ASSERT_EQUAL(ts::DID(0), d2.tag());
+    CPPUNIT_ASSERT(d2 == ts::Descriptor());
+}
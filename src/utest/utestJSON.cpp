@@ -32,6 +32,7 @@
 //----------------------------------------------------------------------------
 
 #include "tsjson.h"
+#include "tsjsonWriter.h"
 #include "tsCerrReport.h"
 #include "tsNullReport.h"
 #include "utestCppUnitTest.h"
@@ -50,10 +51,12 @@ public:
 
     void testSimple();
     void testGitHub();
+    void testWriter();
 
     CPPUNIT_TEST_SUITE(JsonTest);
     CPPUNIT_TEST(testSimple);
     CPPUNIT_TEST(testGitHub);
+    CPPUNIT_TEST(testWriter);
     CPPUNIT_TEST_SUITE_END();
 };
 
@@ -595,3 +598,38 @@ void JsonTest::testGitHub()
         u"}",
         jv->printed());
 }
+
+void JsonTest::testWriter()
+{
+    static const uint8_t data[] = {0x00, 0x12, 0xAB, 0xFF};
+
+    ts::json::Writer writer;
+    writer.beginObject();
+    writer.field(u"pid", uint16_t(0x0012));
+    writer.field(u"neg", -1234567);
+    writer.field(u"name", u"a \"b\"\\\n\u00E9");
+    writer.field(u"current", true);
+    writer.name(u"sections").beginArray().hexa(data, sizeof(data)).hexa(data, 1).endArray();
+    writer.name(u"empty").beginObject().endObject();
+    writer.name(u"nothing").null();
+    writer.endObject();
+
+    const std::string expected("{\"pid\":18,\"neg\":-1234567,\"name\":\"a \\\"b\\\"\\\\\\n\\u00E9\",\"current\":true,"
+                               "\"sections\":[\"0012ABFF\",\"00\"],\"empty\":{},\"nothing\":null}");
+    CPPUNIT_ASSERT_EQUAL(expected, writer.text());
+
+    // The generated text is parsed back.
+    ts::json::ValuePtr jv;
+    CPPUNIT_ASSERT(ts::json::Parse(jv, ts::UString::FromUTF8(writer.text()), CERR));
+    CPPUNIT_ASSERT(!jv.isNull());
+    CPPUNIT_ASSERT_EQUAL(int64_t(18), jv->value(u"pid").toInteger());
+    CPPUNIT_ASSERT_EQUAL(int64_t(-1234567), jv->value(u"neg").toInteger());
+    CPPUNIT_ASSERT_USTRINGS_EQUAL(u"a \"b\"\\\n\u00E9", jv->value(u"name").toString());
+    CPPUNIT_ASSERT(jv->value(u"current").isTrue());
+    CPPUNIT_ASSERT_USTRINGS_EQUAL(u"0012ABFF", jv->value(u"sections").at(0).toString());
+
+    // The buffer is reusable.
+    writer.clear();
+    writer.beginArray().value(int64_t(0)).value(false).endArray();
+    CPPUNIT_ASSERT_EQUAL(std::string("[0,false]"), writer.text());
+}
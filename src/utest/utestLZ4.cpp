@@ -0,0 +1,180 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+//
+//  CppUnit test suite for class ts::LZ4
+//
+//----------------------------------------------------------------------------
+
+#include "tsLZ4.h"
+#include "tsTSPacket.h"
+#include "utestCppUnitTest.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// The test fixture
+//----------------------------------------------------------------------------
+
+class LZ4Test: public CppUnit::TestFixture
+{
+public:
+    virtual void setUp() override;
+    virtual void tearDown() override;
+
+    void testDecompressReference();
+    void testRoundTrip();
+    void testInvalid();
+
+    CPPUNIT_TEST_SUITE(LZ4Test);
+    CPPUNIT_TEST(testDecompressReference);
+    CPPUNIT_TEST(testRoundTrip);
+    CPPUNIT_TEST(testInvalid);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    void roundTrip(ts::LZ4& lz4, const ts::ByteBlock& data);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(LZ4Test);
+
+
+//----------------------------------------------------------------------------
+// Initialization.
+//----------------------------------------------------------------------------
+
+// Test suite initialization method.
+void LZ4Test::setUp()
+{
+}
+
+// Test suite cleanup method.
+void LZ4Test::tearDown()
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Unitary tests.
+//----------------------------------------------------------------------------
+
+// Blocks built by hand from the LZ4 block format specification.
+void LZ4Test::testDecompressReference()
+{
+    ts::ByteBlock out;
+
+    // Empty input is one token without literals.
+    static const uint8_t empty[] = {0x00};
+    CPPUNIT_ASSERT(ts::LZ4::Decompress(out, empty, sizeof(empty), 0));
+    CPPUNIT_ASSERT(out.empty());
+
+    // 1 literal 'a', match offset 1 length 5, then 5 literals.
+    static const uint8_t overlap[] = {0x11, 'a', 0x01, 0x00, 0x50, 'b', 'c', 'd', 'e', 'f'};
+    CPPUNIT_ASSERT(ts::LZ4::Decompress(out, overlap, sizeof(overlap), 11));
+    CPPUNIT_ASSERT(out == ts::ByteBlock("aaaaaabcdef", 11));
+
+    // 16 literals (length extension), match offset 16 length 4+15+1, then 5 literals.
+    static const uint8_t extended[] = {
+        0xFF, 0x01, '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F',
+        0x10, 0x00, 0x01, 0x50, 'v', 'w', 'x', 'y', 'z'};
+    CPPUNIT_ASSERT(ts::LZ4::Decompress(out, extended, sizeof(extended), 41));
+    CPPUNIT_ASSERT(out == ts::ByteBlock("0123456789ABCDEF0123456789ABCDEF0123vwxyz", 41));
+}
+
+void LZ4Test::roundTrip(ts::LZ4& lz4, const ts::ByteBlock& data)
+{
+    ts::ByteBlock comp;
+    ts::ByteBlock decomp;
+    lz4.compress(comp, data.data(), data.size());
+    CPPUNIT_ASSERT(comp.size() <= ts::LZ4::MaxCompressedSize(data.size()));
+    CPPUNIT_ASSERT(ts::LZ4::Decompress(decomp, comp.data(), comp.size(), data.size()));
+    CPPUNIT_ASSERT(decomp == data);
+}
+
+void LZ4Test::testRoundTrip()
+{
+    ts::LZ4 lz4;
+    ts::ByteBlock data;
+    uint32_t rnd = 1;
+
+    // Small sizes around the minimum block size with matches.
+    for (size_t size = 0; size < 40; ++size) {
+        data.assign(size, 'x');
+        roundTrip(lz4, data);
+    }
+
+    // Random data are incompressible.
+    data.resize(100000);
+    for (size_t i = 0; i < data.size(); ++i) {
+        rnd = rnd * 1103515245 + 12345;
+        data[i] = uint8_t(rnd >> 16);
+    }
+    roundTrip(lz4, data);
+
+    // Null packets compress well, with long match lengths.
+    data.clear();
+    for (size_t i = 0; i < 1000; ++i) {
+        data.append(ts::NullPacket.b, ts::PKT_SIZE);
+    }
+    ts::ByteBlock comp;
+    lz4.compress(comp, data.data(), data.size());
+    CPPUNIT_ASSERT(comp.size() < 1000);
+    roundTrip(lz4, data);
+
+    // Mixed data, with matches beyond the window and short repeated patterns.
+    data.clear();
+    for (size_t i = 0; i < 300000; ++i) {
+        rnd = rnd * 1103515245 + 12345;
+        const uint32_t r = rnd >> 16;
+        data.push_back(r % 4 == 0 ? uint8_t(r >> 8) : uint8_t(i % 7 + (i / 70000)));
+    }
+    roundTrip(lz4, data);
+}
+
+void LZ4Test::testInvalid()
+{
+    ts::ByteBlock out;
+
+    // Truncated literals.
+    static const uint8_t trunc[] = {0x50, 'a', 'b'};
+    CPPUNIT_ASSERT(!ts::LZ4::Decompress(out, trunc, sizeof(trunc), 5));
+
+    // Offset before start of output.
+    static const uint8_t offset[] = {0x10, 'a', 0x02, 0x00, 0x50, 'b', 'c', 'd', 'e', 'f'};
+    CPPUNIT_ASSERT(!ts::LZ4::Decompress(out, offset, sizeof(offset), 10));
+
+    // Zero offset.
+    static const uint8_t zero[] = {0x10, 'a', 0x00, 0x00, 0x50, 'b', 'c', 'd', 'e', 'f'};
+    CPPUNIT_ASSERT(!ts::LZ4::Decompress(out, zero, sizeof(zero), 10));
+
+    // Output larger or smaller than expected.
+    static const uint8_t overlap[] = {0x11, 'a', 0x01, 0x00, 0x50, 'b', 'c', 'd', 'e', 'f'};
+    CPPUNIT_ASSERT(!ts::LZ4::Decompress(out, overlap, sizeof(overlap), 10));
+    CPPUNIT_ASSERT(!ts::LZ4::Decompress(out, overlap, sizeof(overlap), 12));
+}
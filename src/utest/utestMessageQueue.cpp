@@ -32,6 +32,7 @@
 //----------------------------------------------------------------------------
 
 #include "tsMessageQueue.h"
+#include "tsLockFreeMessageQueue.h"
 #include "tsMonotonic.h"
 #include "tsSysUtils.h"
 #include "utestCppUnitTest.h"
@@ -53,10 +54,14 @@ public:
 
     void testConstructor();
     void testQueue();
+    void testLockFreeConstructor();
+    void testLockFreeQueue();
 
     CPPUNIT_TEST_SUITE(MessageQueueTest);
     CPPUNIT_TEST(testConstructor);
     CPPUNIT_TEST(testQueue);
+    CPPUNIT_TEST(testLockFreeConstructor);
+    CPPUNIT_TEST(testLockFreeQueue);
     CPPUNIT_TEST_SUITE_END();
 private:
     ts::NanoSecond  _nsPrecision;
@@ -194,3 +199,94 @@ void MessageQueueTest::testQueue()
 
     utest::Out() << "MessageQueueTest: main thread: end of test" << std::endl;
 }
+
+// Test case: lock-free queues constructors
+void MessageQueueTest::testLockFreeConstructor()
+{
+    ts::SPSCMessageQueue<int> queue1;
+    ts::MPSCMessageQueue<int> queue2(10);
+    ts::MPSCMessageQueue<int> queue3(16);
+
+    CPPUNIT_ASSERT(queue1.getMaxMessages() == ts::SPSCMessageQueue<int>::DEFAULT_MAX_MESSAGES);
+    CPPUNIT_ASSERT(queue2.getMaxMessages() == 16);
+    CPPUNIT_ASSERT(queue3.getMaxMessages() == 16);
+
+    // Fill the queue, without and with timeout.
+    int message = 0;
+    while (message < 16) {
+        CPPUNIT_ASSERT(queue2.enqueue(new int(message++), 0));
+    }
+    CPPUNIT_ASSERT(!queue2.enqueue(new int(message), 0));
+    CPPUNIT_ASSERT(!queue2.enqueue(new int(message), 50));
+
+    // Empty the queue, without and with timeout.
+    ts::MPSCMessageQueue<int>::MessagePtr ptr;
+    for (int expected = 0; expected < 16; ++expected) {
+        CPPUNIT_ASSERT(queue2.dequeue(ptr, 0));
+        CPPUNIT_ASSERT(!ptr.isNull());
+        CPPUNIT_ASSERT(*ptr == expected);
+    }
+    CPPUNIT_ASSERT(!queue2.dequeue(ptr, 0));
+    CPPUNIT_ASSERT(!queue2.dequeue(ptr, 50));
+}
+
+// Thread for testLockFreeQueue(): producer of a sequence of messages.
+namespace {
+    typedef ts::MPSCMessageQueue<int> TestLockFreeQueue;
+
+    class LockFreeQueueTestThread: public utest::CppUnitThread
+    {
+    private:
+        TestLockFreeQueue& _queue;
+        int _base;
+        int _count;
+    public:
+        LockFreeQueueTestThread(TestLockFreeQueue& queue, int base, int count) :
+            utest::CppUnitThread(),
+            _queue(queue),
+            _base(base),
+            _count(count)
+        {
+        }
+
+        virtual ~LockFreeQueueTestThread() override
+        {
+            waitForTermination();
+        }
+
+        virtual void test() override
+        {
+            for (int i = 0; i < _count; ++i) {
+                CPPUNIT_ASSERT(_queue.enqueue(new int(_base + i), 10000));
+            }
+        }
+    };
+}
+
+void MessageQueueTest::testLockFreeQueue()
+{
+    // Two producers on a small queue, the messages of each producer must be received in order.
+    const int count = 10000;
+    TestLockFreeQueue queue(8);
+    LockFreeQueueTestThread thread1(queue, 0, count);
+    LockFreeQueueTestThread thread2(queue, count, count);
+
+    CPPUNIT_ASSERT(thread1.start());
+    CPPUNIT_ASSERT(thread2.start());
+
+    int expected1 = 0;
+    int expected2 = count;
+    TestLockFreeQueue::MessagePtr message;
+    for (int i = 0; i < 2 * count; ++i) {
+        CPPUNIT_ASSERT(queue.dequeue(message, 10000));
+        CPPUNIT_ASSERT(!message.isNull());
+        if (*message < count) {
+            CPPUNIT_ASSERT(*message == expected1++);
+        }
+        else {
+            CPPUNIT_ASSERT(*message == expected2++);
+        }
+    }
+    CPPUNIT_ASSERT(!queue.dequeue(message, 0));
+    utest::Out() << "MessageQueueTest: lock-free queue: received " << (2 * count) << " messages" << std::endl;
+}
@@ -0,0 +1,177 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//
+//  CppUnit test suite for performance metrics.
+//
+//----------------------------------------------------------------------------
+
+#include "tsMetrics.h"
+#include "tsSignalMonitor.h"
+#include "tsThreadPool.h"
+#include "tsSysUtils.h"
+#include "utestCppUnitTest.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// The test fixture
+//----------------------------------------------------------------------------
+
+class MetricsTest: public CppUnit::TestFixture
+{
+public:
+    virtual void setUp() override;
+    virtual void tearDown() override;
+
+    void testCounter();
+    void testGauge();
+    void testPrometheus();
+    void testSignalMonitor();
+
+    CPPUNIT_TEST_SUITE (MetricsTest);
+    CPPUNIT_TEST (testCounter);
+    CPPUNIT_TEST (testGauge);
+    CPPUNIT_TEST (testPrometheus);
+    CPPUNIT_TEST (testSignalMonitor);
+    CPPUNIT_TEST_SUITE_END ();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (MetricsTest);
+
+
+//----------------------------------------------------------------------------
+// Initialization.
+//----------------------------------------------------------------------------
+
+// Test suite initialization method.
+void MetricsTest::setUp()
+{
+}
+
+// Test suite cleanup method.
+void MetricsTest::tearDown()
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Test cases
+//----------------------------------------------------------------------------
+
+void MetricsTest::testCounter()
+{
+    ts::MetricsRegistry* registry = ts::MetricsRegistry::Instance();
+    ts::Metric::Labels labels;
+    labels[u"test"] = u"counter";
+
+    ts::MetricCounter* counter = registry->counter(u"utest_counter_total", u"Test counter", labels);
+    CPPUNIT_ASSERT(counter != 0);
+    CPPUNIT_ASSERT(registry->counter(u"utest_counter_total", u"Test counter", labels) == counter);
+    CPPUNIT_ASSERT(registry->gauge(u"utest_counter_total", u"Test counter", labels) == 0);
+    CPPUNIT_ASSERT(registry->counter(u"utest_counter_total", u"Test counter") != counter);
+    CPPUNIT_ASSERT_EQUAL(ts::Metric::COUNTER, counter->type());
+    CPPUNIT_ASSERT_EQUAL(int64_t(0), counter->value());
+
+    // Concurrent increments from several threads, on several shards.
+    ts::ThreadPool pool(4);
+    pool.parallelFor(0, 100000, [counter](size_t i) { counter->add(i % 2 == 0 ? 1 : 2); });
+    CPPUNIT_ASSERT_EQUAL(int64_t(150000), counter->value());
+}
+
+void MetricsTest::testGauge()
+{
+    ts::MetricGauge* gauge = ts::MetricsRegistry::Instance()->gauge(u"utest_gauge", u"Test gauge");
+    CPPUNIT_ASSERT(gauge != 0);
+    CPPUNIT_ASSERT_EQUAL(ts::Metric::GAUGE, gauge->type());
+    gauge->set(100);
+    CPPUNIT_ASSERT_EQUAL(int64_t(100), gauge->value());
+    gauge->add(-150);
+    CPPUNIT_ASSERT_EQUAL(int64_t(-50), gauge->value());
+}
+
+void MetricsTest::testPrometheus()
+{
+    ts::Metric::Labels labels;
+    labels[u"plugin"] = u"a\"b";
+    labels[u"index"] = u"2";
+    ts::MetricsRegistry::Instance()->counter(u"utest_prom_total", u"Help\ntext", labels)->add(12);
+
+    const std::string text(ts::MetricsRegistry::Instance()->formatPrometheus());
+    utest::Out() << "MetricsTest::testPrometheus: " << std::endl << text;
+
+    CPPUNIT_ASSERT(text.find("# HELP utest_prom_total Help\\ntext\n# TYPE utest_prom_total counter\nutest_prom_total{index=\"2\",plugin=\"a\\\"b\"} 12\n") != std::string::npos);
+    CPPUNIT_ASSERT(text.find("# TYPE utest_gauge gauge\nutest_gauge -50\n") != std::string::npos);
+}
+
+namespace {
+    class TestMonitor: public ts::SignalMonitor
+    {
+    public:
+        std::atomic<int> polls;
+        TestMonitor() : ts::SignalMonitor(u"utest", 10), polls(0) {}
+        virtual ~TestMonitor() override { stop(); }
+    private:
+        virtual void pollDevice() override
+        {
+            const int count = ++polls;
+            setSignalLocked(true);
+            setSignalStrength(count < 3 ? 50 : 80);
+            setBitrate(1000000);
+        }
+    };
+}
+
+void MetricsTest::testSignalMonitor()
+{
+    TestMonitor mon;
+    CPPUNIT_ASSERT(!mon.signalLocked());
+    CPPUNIT_ASSERT_EQUAL(-1, mon.signalStrength());
+    CPPUNIT_ASSERT_EQUAL(ts::BitRate(0), mon.bitrate());
+
+    // The device is polled once in start().
+    CPPUNIT_ASSERT(mon.start());
+    CPPUNIT_ASSERT(mon.polls >= 1);
+    CPPUNIT_ASSERT(mon.signalLocked());
+    CPPUNIT_ASSERT_EQUAL(ts::BitRate(1000000), mon.bitrate());
+    CPPUNIT_ASSERT_EQUAL(-1, mon.signalQuality());
+    CPPUNIT_ASSERT_EQUAL(int64_t(-1), mon.fifoLoad());
+
+    // Then periodically in the background.
+    for (int i = 0; i < 100 && mon.polls < 3; ++i) {
+        ts::SleepThread(10);
+    }
+    mon.stop();
+    CPPUNIT_ASSERT(mon.polls >= 3);
+    CPPUNIT_ASSERT_EQUAL(80, mon.signalStrength());
+
+    // Known values are published as gauges, unknown ones are not.
+    const std::string text(ts::MetricsRegistry::Instance()->formatPrometheus());
+    CPPUNIT_ASSERT(text.find("tsp_input_signal_strength_percent{device=\"utest\"} 80\n") != std::string::npos);
+    CPPUNIT_ASSERT(text.find("tsp_input_signal_locked{device=\"utest\"} 1\n") != std::string::npos);
+    CPPUNIT_ASSERT(text.find("tsp_input_signal_quality_percent{device=\"utest\"}") == std::string::npos);
+}
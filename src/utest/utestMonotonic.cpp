@@ -53,11 +53,15 @@ public:
     void testArithmetic();
     void testSysWait();
     void testWait();
+    void testWaitUntil();
+    void testCPUTicks();
 
     CPPUNIT_TEST_SUITE(MonotonicTest);
     CPPUNIT_TEST(testArithmetic);
     CPPUNIT_TEST(testSysWait);
     CPPUNIT_TEST(testWait);
+    CPPUNIT_TEST(testWaitUntil);
+    CPPUNIT_TEST(testCPUTicks);
     CPPUNIT_TEST_SUITE_END();
 private:
     ts::NanoSecond  _nsPrecision;
@@ -153,3 +157,38 @@ void MonotonicTest::testWait()
     CPPUNIT_ASSERT(end >= start + 100 - _msPrecision);
     CPPUNIT_ASSERT(end < start + 150);
 }
+
+void MonotonicTest::testWaitUntil()
+{
+    ts::Monotonic::SetMinimumTimerSlack();
+
+    ts::Monotonic deadline;
+    deadline.getSystemTime();
+    deadline += 20 * ts::NanoSecPerMilliSec;
+
+    // The timer contains the current time on return, never before the deadline.
+    ts::Monotonic timer;
+    timer.waitUntil(deadline, 500 * ts::NanoSecPerMicroSec);
+    CPPUNIT_ASSERT(timer >= deadline);
+    utest::Out() << "MonotonicTest: waitUntil() late by " << ts::UString::Decimal(timer - deadline) << " ns" << std::endl;
+    CPPUNIT_ASSERT(timer - deadline < 10 * ts::NanoSecPerMilliSec);
+
+    // A deadline in the past returns immediately.
+    timer.waitUntil(deadline, 0);
+    CPPUNIT_ASSERT(timer >= deadline);
+}
+
+void MonotonicTest::testCPUTicks()
+{
+    const uint64_t freq = ts::Monotonic::CPUTicksPerSecond();
+    utest::Out() << "MonotonicTest: CPU ticks per second: " << ts::UString::Decimal(freq) << std::endl;
+    CPPUNIT_ASSERT(freq > 0);
+    CPPUNIT_ASSERT(ts::Monotonic::CPUTicksToNanoSeconds(freq) == ts::NanoSecPerSec);
+    CPPUNIT_ASSERT(ts::Monotonic::CPUTicksToNanoSeconds(3 * freq / 2) == 3 * ts::NanoSecPerSec / 2);
+
+    const uint64_t start = ts::Monotonic::CPUTicks();
+    ts::SleepThread(50);
+    const ts::NanoSecond duration = ts::Monotonic::CPUTicksToNanoSeconds(ts::Monotonic::CPUTicks() - start);
+    CPPUNIT_ASSERT(duration >= 45 * ts::NanoSecPerMilliSec);
+    CPPUNIT_ASSERT(duration < 150 * ts::NanoSecPerMilliSec);
+}
@@ -34,6 +34,7 @@
 #include "tsNames.h"
 #include "tsMPEG.h"
 #include "tsSysUtils.h"
+#include "tsCerrReport.h"
 #include "utestCppUnitTest.h"
 TSDUCK_SOURCE;
 
@@ -82,6 +83,7 @@ public:
     void testRunningStatus();
     void testAudioType();
     void testT2MIPacketType();
+    void testCompiled();
 
     CPPUNIT_TEST_SUITE(NamesTest);
     CPPUNIT_TEST(testConfigFile);
@@ -118,11 +120,24 @@ public:
     CPPUNIT_TEST(testRunningStatus);
     CPPUNIT_TEST(testAudioType);
     CPPUNIT_TEST(testT2MIPacketType);
+    CPPUNIT_TEST(testCompiled);
     CPPUNIT_TEST_SUITE_END();
+
+public:
+    NamesTest();
+
+private:
+    ts::UString _tempFileName;
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(NamesTest);
 
+// Constructor.
+NamesTest::NamesTest() :
+    _tempFileName(ts::TempFile(u".names"))
+{
+}
+
 
 //----------------------------------------------------------------------------
 // Initialization.
@@ -131,11 +146,15 @@ CPPUNIT_TEST_SUITE_REGISTRATION(NamesTest);
 // Test suite initialization method.
 void NamesTest::setUp()
 {
+    ts::DeleteFile(_tempFileName);
+    ts::DeleteFile(ts::Names::CompiledFileName(_tempFileName));
 }
 
 // Test suite cleanup method.
 void NamesTest::tearDown()
 {
+    ts::DeleteFile(_tempFileName);
+    ts::DeleteFile(ts::Names::CompiledFileName(_tempFileName));
 }
 
 
@@ -366,3 +385,42 @@ void NamesTest::testT2MIPacketType()
 {
     CPPUNIT_ASSERT_USTRINGS_EQUAL(u"Individual addressing", ts::names::T2MIPacketType(0x21));
 }
+
+void NamesTest::testCompiled()
+{
+    // Compile the DVB names in a temporary file, without text file next to it.
+    const ts::Names text(ts::NamesDVB::Instance().configurationFile(), false);
+    CPPUNIT_ASSERT(!text.isCompiled());
+    CPPUNIT_ASSERT_EQUAL(size_t(0), text.errorCount());
+    CPPUNIT_ASSERT(text.saveCompiled(ts::Names::CompiledFileName(_tempFileName), CERR));
+
+    const ts::Names compiled(_tempFileName);
+    CPPUNIT_ASSERT(compiled.isCompiled());
+    CPPUNIT_ASSERT_USTRINGS_EQUAL(ts::Names::CompiledFileName(_tempFileName), compiled.configurationFile());
+
+    // All names must be identical in the text and compiled forms.
+    static const ts::UChar* const sections[] = {
+        u"TableId", u"DescriptorId", u"StreamType", u"PrivateDataSpecifier", u"CASystemId",
+        u"ComponentType", u"NetworkId", u"ServiceType", u"T2MIPacketType", u"NoSuchSection",
+    };
+    for (size_t i = 0; i < sizeof(sections) / sizeof(sections[0]); ++i) {
+        for (ts::Names::Value value = 0; value < 0x2000; ++value) {
+            CPPUNIT_ASSERT_USTRINGS_EQUAL(text.nameFromSection(sections[i], value, ts::names::VALUE),
+                                          compiled.nameFromSection(sections[i], value, ts::names::VALUE));
+        }
+    }
+    const ts::Names::Value via = ts::Names::Value(ts::CAS_VIACCESS) << 8;
+    CPPUNIT_ASSERT_USTRINGS_EQUAL(u"Viaccess EMM-U", compiled.nameFromSectionWithFallback(u" tableid ", via | ts::TID_VIA_EMM_U, ts::TID_VIA_EMM_U));
+    CPPUNIT_ASSERT_USTRINGS_EQUAL(u"PMT", compiled.nameFromSectionWithFallback(u"TableId", via | ts::TID_PMT, ts::TID_PMT));
+
+    // A compiled file which does not match the text file next to it is ignored.
+    std::ofstream strm(_tempFileName.toUTF8().c_str());
+    strm << "[Foo]" << std::endl << "Bits = 8" << std::endl << "0x01 = Bar" << std::endl;
+    strm.close();
+
+    const ts::Names obsolete(_tempFileName);
+    CPPUNIT_ASSERT(!obsolete.isCompiled());
+    CPPUNIT_ASSERT_USTRINGS_EQUAL(_tempFileName, obsolete.configurationFile());
+    CPPUNIT_ASSERT_USTRINGS_EQUAL(u"Bar (0x01)", obsolete.nameFromSection(u"Foo", 1, ts::names::VALUE));
+    CPPUNIT_ASSERT_USTRINGS_EQUAL(u"unknown (0x00)", obsolete.nameFromSection(u"TableId", 0, ts::names::VALUE, 8));
+}
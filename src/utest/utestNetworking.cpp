@@ -36,6 +36,8 @@
 #include "tsTCPConnection.h"
 #include "tsTCPServer.h"
 #include "tsUDPSocket.h"
+#include "tsPcapFile.h"
+#include "tsByteBlock.h"
 #include "tsThread.h"
 #include "tsSysUtils.h"
 #include "tsIPUtils.h"
@@ -63,6 +65,9 @@ public:
     void testSocketAddress();
     void testTCPSocket();
     void testUDPSocket();
+    void testUDPSocketMultiple();
+    void testUDPSocketSegments();
+    void testPcapFile();
 
     CPPUNIT_TEST_SUITE(NetworkingTest);
     CPPUNIT_TEST(testIPAddressConstructors);
@@ -72,6 +77,9 @@ public:
     CPPUNIT_TEST(testSocketAddress);
     CPPUNIT_TEST(testTCPSocket);
     CPPUNIT_TEST(testUDPSocket);
+    CPPUNIT_TEST(testUDPSocketMultiple);
+    CPPUNIT_TEST(testUDPSocketSegments);
+    CPPUNIT_TEST(testPcapFile);
     CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -577,3 +585,180 @@ void NetworkingTest::testUDPSocket()
     CPPUNIT_ASSERT(sock.send(buffer, size, sender, CERR));
     CERR.debug(u"UDPSocketTest: main thread: reply sent");
 }
+
+void NetworkingTest::testUDPSocketMultiple()
+{
+    CPPUNIT_ASSERT(ts::IPInitialize());
+
+    const uint16_t portNumber = 12346;
+    const ts::SocketAddress address(ts::IPAddress::LocalHost, portNumber);
+
+    // The socket sends messages to itself.
+    ts::UDPSocket sock(true);
+    CPPUNIT_ASSERT(sock.isOpen());
+    CPPUNIT_ASSERT(sock.reusePort(true, CERR));
+    CPPUNIT_ASSERT(sock.bind(address, CERR));
+    CPPUNIT_ASSERT(sock.setDefaultDestination(address, CERR));
+#if defined(TS_UNIX)
+    CPPUNIT_ASSERT(sock.setReceiveTimestamps(true, CERR));
+#endif
+
+    const char* const messages[] = {"Message 1", "Msg 2", "Third message"};
+    for (size_t i = 0; i < 3; ++i) {
+        CPPUNIT_ASSERT(sock.send(messages[i], ::strlen(messages[i]), CERR));
+    }
+
+    // Receive the messages in as few operations as possible.
+    char buffers[4][1024];
+    ts::UDPSocket::ReceiveSlotVector slots;
+    for (size_t i = 0; i < 4; ++i) {
+        slots.push_back(ts::UDPSocket::ReceiveSlot(buffers[i], sizeof(buffers[i])));
+    }
+
+    size_t received = 0;
+    while (received < 3) {
+        ts::UDPSocket::ReceiveSlotVector batch(slots.begin() + received, slots.begin() + 3);
+        size_t count = 0;
+        CPPUNIT_ASSERT(sock.receive(batch, count, 0, CERR));
+        CPPUNIT_ASSERT(count > 0);
+        CPPUNIT_ASSERT(received + count <= 3);
+        for (size_t i = 0; i < count; ++i) {
+            const size_t index = received + i;
+            CERR.debug(u"UDPSocketTest: received message %d, %d bytes, sender: %s", {index, batch[i].ret_size, batch[i].sender.toString()});
+            CPPUNIT_ASSERT_EQUAL(::strlen(messages[index]), batch[i].ret_size);
+            CPPUNIT_ASSERT(::memcmp(messages[index], buffers[index], batch[i].ret_size) == 0);
+            CPPUNIT_ASSERT(ts::IPAddress(batch[i].sender) == ts::IPAddress::LocalHost);
+            CPPUNIT_ASSERT(batch[i].timestamp != ts::Time::Epoch);
+#if defined(TS_UNIX)
+            CPPUNIT_ASSERT(batch[i].kernel_time > 0);
+#endif
+        }
+        received += count;
+    }
+}
+
+void NetworkingTest::testUDPSocketSegments()
+{
+    CPPUNIT_ASSERT(ts::IPInitialize());
+
+    const uint16_t portNumber = 12347;
+    const ts::SocketAddress address(ts::IPAddress::LocalHost, portNumber);
+
+    // The socket sends messages to itself.
+    ts::UDPSocket sock(true);
+    CPPUNIT_ASSERT(sock.isOpen());
+    CPPUNIT_ASSERT(sock.setReceiveBufferSize(65536, CERR));
+    CPPUNIT_ASSERT(sock.reusePort(true, CERR));
+    CPPUNIT_ASSERT(sock.bind(address, CERR));
+    CPPUNIT_ASSERT(sock.setDefaultDestination(address, CERR));
+
+    // Send 10 messages of 100 bytes and one of 50 bytes.
+    uint8_t data[1050];
+    for (size_t i = 0; i < sizeof(data); ++i) {
+        data[i] = uint8_t(i / 100);
+    }
+    CPPUNIT_ASSERT(sock.sendSegments(data, sizeof(data), 100, CERR));
+
+    // Each segment is received as an individual message.
+    for (size_t index = 0; index < 11; ++index) {
+        uint8_t buffer[1024];
+        size_t size = 0;
+        ts::SocketAddress sender;
+        ts::SocketAddress destination;
+        CPPUNIT_ASSERT(sock.receive(buffer, sizeof(buffer), size, sender, destination, 0, CERR));
+        CPPUNIT_ASSERT_EQUAL(index < 10 ? size_t(100) : size_t(50), size);
+        CPPUNIT_ASSERT(::memcmp(data + 100 * index, buffer, size) == 0);
+    }
+}
+
+namespace {
+    // Append a pcap record containing an Ethernet frame with an IPv4 UDP datagram.
+    void AppendPcapUDP(ts::ByteBlock& bb, uint32_t seconds, uint32_t dest_addr, uint16_t dest_port, size_t payload_size, uint16_t fragment)
+    {
+        const size_t frame_size = 14 + 20 + 8 + payload_size;
+        bb.appendUInt32LE(seconds);
+        bb.appendUInt32LE(250000);  // microseconds
+        bb.appendUInt32LE(uint32_t(frame_size));
+        bb.appendUInt32LE(uint32_t(frame_size));
+        // Ethernet header.
+        bb.append(uint8_t(0x00), 12);
+        bb.appendUInt16BE(0x0800);
+        // IPv4 header.
+        bb.appendUInt8(0x45);
+        bb.appendUInt8(0x00);
+        bb.appendUInt16BE(uint16_t(20 + 8 + payload_size));
+        bb.appendUInt16BE(0x0000);
+        bb.appendUInt16BE(fragment);
+        bb.appendUInt8(64);
+        bb.appendUInt8(17);
+        bb.appendUInt16BE(0x0000);
+        bb.appendUInt32BE(0x0A000001);
+        bb.appendUInt32BE(dest_addr);
+        // UDP header and payload, a sequence of TS packets.
+        bb.appendUInt16BE(1000);
+        bb.appendUInt16BE(dest_port);
+        bb.appendUInt16BE(uint16_t(8 + payload_size));
+        bb.appendUInt16BE(0x0000);
+        for (size_t i = 0; i < payload_size; ++i) {
+            bb.appendUInt8(i % ts::PKT_SIZE == 0 ? ts::SYNC_BYTE : uint8_t(i));
+        }
+    }
+}
+
+void NetworkingTest::testPcapFile()
+{
+    // Build a little-endian pcap file with microsecond time stamps on Ethernet.
+    ts::ByteBlock bb;
+    bb.appendUInt32LE(0xA1B2C3D4);
+    bb.appendUInt16LE(2);
+    bb.appendUInt16LE(4);
+    bb.appendUInt32LE(0);
+    bb.appendUInt32LE(0);
+    bb.appendUInt32LE(65535);
+    bb.appendUInt32LE(1);
+    AppendPcapUDP(bb, 100, 0xEF010101, 1234, 7 * ts::PKT_SIZE, 0x0000);
+    AppendPcapUDP(bb, 101, 0xEF010101, 1234, 100, 0x2000);  // fragment, skipped
+    AppendPcapUDP(bb, 102, 0xEF010102, 5000, 2 * ts::PKT_SIZE, 0x4000);  // don't fragment flag
+
+    const ts::UString fileName(ts::TempFile(u".pcap"));
+    {
+        std::ofstream strm(fileName.toUTF8().c_str(), std::ios::binary);
+        strm.write(reinterpret_cast<const char*>(bb.data()), std::streamsize(bb.size()));
+    }
+
+    ts::PcapFile file;
+    CPPUNIT_ASSERT(file.open(fileName, CERR));
+    CPPUNIT_ASSERT(file.isOpen());
+    CPPUNIT_ASSERT(!file.isPcapNG());
+
+    ts::SocketAddress source;
+    ts::SocketAddress destination;
+    const uint8_t* data = 0;
+    size_t size = 0;
+    ts::NanoSecond timestamp = 0;
+
+    CPPUNIT_ASSERT(file.readUDP(source, destination, data, size, timestamp, CERR));
+    CPPUNIT_ASSERT_USTRINGS_EQUAL(u"10.0.0.1:1000", source.toString());
+    CPPUNIT_ASSERT_USTRINGS_EQUAL(u"239.1.1.1:1234", destination.toString());
+    CPPUNIT_ASSERT_EQUAL(7 * ts::PKT_SIZE, size);
+    CPPUNIT_ASSERT_EQUAL(ts::NanoSecond(100250000000), timestamp);
+    CPPUNIT_ASSERT_EQUAL(ts::SYNC_BYTE, data[0]);
+
+    CPPUNIT_ASSERT(file.readUDP(source, destination, data, size, timestamp, CERR));
+    CPPUNIT_ASSERT_USTRINGS_EQUAL(u"239.1.1.2:5000", destination.toString());
+    CPPUNIT_ASSERT_EQUAL(2 * ts::PKT_SIZE, size);
+    CPPUNIT_ASSERT_EQUAL(ts::NanoSecond(102250000000), timestamp);
+
+    CPPUNIT_ASSERT(!file.readUDP(source, destination, data, size, timestamp, CERR));
+    CPPUNIT_ASSERT_EQUAL(ts::PacketCounter(3), file.packetCount());
+    CPPUNIT_ASSERT_EQUAL(ts::PacketCounter(1), file.fragmentCount());
+
+    // Read again from the beginning.
+    file.rewind();
+    CPPUNIT_ASSERT(file.readUDP(source, destination, data, size, timestamp, CERR));
+    CPPUNIT_ASSERT_USTRINGS_EQUAL(u"239.1.1.1:1234", destination.toString());
+
+    file.close();
+    CPPUNIT_ASSERT(!file.isOpen());
+    ts::DeleteFile(fileName);
+}
@@ -33,7 +33,9 @@
 
 #include "tsPacketizer.h"
 #include "tsCyclingPacketizer.h"
+#include "tsEITGenerator.h"
 #include "tsStandaloneTableDemux.h"
+#include "tsSectionDemux.h"
 #include "tsPAT.h"
 #include "tsPMT.h"
 #include "tsSDT.h"
@@ -44,6 +46,8 @@ TSDUCK_SOURCE;
 #include "tables/psi_pat_r4_packets.h"
 #include "tables/psi_pmt_planete_packets.h"
 #include "tables/psi_sdt_r3_packets.h"
+#include "tables/psi_nit_tntv23_packets.h"
+#include "tables/psi_bat_cplus_packets.h"
 
 
 //----------------------------------------------------------------------------
@@ -57,9 +61,17 @@ public:
     virtual void tearDown() override;
 
     void testPacketizer();
+    void testCache();
+    void testReplaceSections();
+    void testTightPacking();
+    void testEITGenerator();
 
     CPPUNIT_TEST_SUITE(PacketizerTest);
     CPPUNIT_TEST(testPacketizer);
+    CPPUNIT_TEST(testCache);
+    CPPUNIT_TEST(testReplaceSections);
+    CPPUNIT_TEST(testTightPacking);
+    CPPUNIT_TEST(testEITGenerator);
     CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -174,3 +186,262 @@ void PacketizerTest::testPacketizer()
     CPPUNIT_ASSERT(pmt_count == 4);
     CPPUNIT_ASSERT(sdt_count >= 15 && sdt_count <= 17);
 }
+
+namespace {
+    // Count all sections which are delivered by a demux.
+    class CountingHandler: public ts::SectionHandlerInterface
+    {
+    public:
+        size_t count;
+        CountingHandler() : count(0) {}
+        virtual void handleSection(ts::SectionDemux&, const ts::Section&) override { count++; }
+    };
+}
+
+void PacketizerTest::testCache()
+{
+    // A NIT and a BAT with multi-packet sections, packed together in each cycle.
+    ts::BinaryTablePtr binnit;
+    ts::BinaryTablePtr binbat;
+    DemuxTable(binnit, "NIT", psi_nit_tntv23_packets, sizeof(psi_nit_tntv23_packets));
+    DemuxTable(binbat, "BAT", psi_bat_cplus_packets, sizeof(psi_bat_cplus_packets));
+
+    ts::CyclingPacketizer pzer(ts::PID_NIT, ts::CyclingPacketizer::AT_END);
+    pzer.addTable(*binnit);
+    pzer.addTable(*binbat);
+    const size_t sections_per_cycle = binnit->sectionCount() + binbat->sectionCount();
+
+    // Generate 5 cycles. The second and next cycles reuse cached packets.
+    const size_t cycle_count = 5;
+    std::vector<ts::TSPacketVector> cycles(cycle_count);
+    for (size_t ci = 0; ci < cycle_count; ++ci) {
+        do {
+            ts::TSPacket pkt;
+            pzer.getNextPacket(pkt);
+            cycles[ci].push_back(pkt);
+        } while (!pzer.atCycleBoundary());
+    }
+
+    // All cycles are identical, except continuity counters.
+    for (size_t ci = 1; ci < cycle_count; ++ci) {
+        CPPUNIT_ASSERT_EQUAL(cycles[0].size(), cycles[ci].size());
+        for (size_t pi = 0; pi < cycles[0].size(); ++pi) {
+            ts::TSPacket pkt;
+            pkt = cycles[ci][pi];
+            pkt.setCC(cycles[0][pi].getCC());
+            CPPUNIT_ASSERT(pkt == cycles[0][pi]);
+        }
+    }
+
+    // All sections are correctly demuxed, without discontinuity.
+    CountingHandler counter;
+    ts::SectionDemux demux(0, &counter, ts::AllPIDs);
+    for (size_t ci = 0; ci < cycle_count; ++ci) {
+        for (size_t pi = 0; pi < cycles[ci].size(); ++pi) {
+            demux.feedPacket(cycles[ci][pi]);
+        }
+    }
+    CPPUNIT_ASSERT(!demux.hasErrors());
+    CPPUNIT_ASSERT_EQUAL(cycle_count * sections_per_cycle, counter.count);
+}
+
+namespace {
+    class SectionCollector: public ts::SectionHandlerInterface
+    {
+    public:
+        ts::SectionPtrVector sections;
+        virtual void handleSection(ts::SectionDemux&, const ts::Section& section) override
+        {
+            sections.push_back(new ts::Section(section, ts::SHARE));
+        }
+    };
+}
+
+void PacketizerTest::testReplaceSections()
+{
+    ts::BinaryTablePtr binnit;
+    ts::BinaryTablePtr binbat;
+    DemuxTable(binnit, "NIT", psi_nit_tntv23_packets, sizeof(psi_nit_tntv23_packets));
+    DemuxTable(binbat, "BAT", psi_bat_cplus_packets, sizeof(psi_bat_cplus_packets));
+
+    // Initial set: NIT, BAT and another BAT.
+    ts::SectionPtr other(new ts::Section(*binbat->sectionAt(0), ts::COPY));
+    other->setTableIdExtension(other->tableIdExtension() + 1);
+    ts::CyclingPacketizer pzer(ts::PID_NIT, ts::CyclingPacketizer::AT_END);
+    pzer.addTable(*binnit);
+    pzer.addTable(*binbat);
+    pzer.addSection(other);
+    const size_t initial_count = binnit->sectionCount() + binbat->sectionCount() + 1;
+    CPPUNIT_ASSERT_EQUAL(ts::SectionCounter(initial_count), pzer.storedSectionCount());
+
+    // Generate one cycle and start the next one.
+    SectionCollector collector;
+    ts::SectionDemux demux(0, &collector, ts::AllPIDs);
+    ts::TSPacket pkt;
+    do {
+        pzer.getNextPacket(pkt);
+        demux.feedPacket(pkt);
+    } while (!pzer.atCycleBoundary());
+    pzer.getNextPacket(pkt);
+    demux.feedPacket(pkt);
+
+    // New set: same NIT, new version of the BAT, no other BAT, one new NIT.
+    ts::SectionPtrVector sections;
+    for (size_t i = 0; i < binnit->sectionCount(); ++i) {
+        sections.push_back(binnit->sectionAt(i));
+    }
+    for (size_t i = 0; i < binbat->sectionCount(); ++i) {
+        ts::SectionPtr modified(new ts::Section(*binbat->sectionAt(i), ts::COPY));
+        modified->setVersion((modified->version() + 1) & 0x1F);
+        sections.push_back(modified);
+    }
+    ts::SectionPtr added(new ts::Section(*binnit->sectionAt(0), ts::COPY));
+    added->setTableIdExtension(added->tableIdExtension() + 1);
+    sections.push_back(added);
+
+    pzer.replaceSections(sections);
+    CPPUNIT_ASSERT_EQUAL(ts::SectionCounter(sections.size()), pzer.storedSectionCount());
+
+    // Complete the current cycle and generate a full new one.
+    do {
+        pzer.getNextPacket(pkt);
+        demux.feedPacket(pkt);
+    } while (!pzer.atCycleBoundary());
+    collector.sections.clear();
+    do {
+        pzer.getNextPacket(pkt);
+        demux.feedPacket(pkt);
+    } while (!pzer.atCycleBoundary());
+    CPPUNIT_ASSERT(!demux.hasErrors());
+
+    // The new cycle contains exactly the new set of sections.
+    CPPUNIT_ASSERT_EQUAL(sections.size(), collector.sections.size());
+    for (size_t i = 0; i < sections.size(); ++i) {
+        size_t found = 0;
+        for (size_t j = 0; j < collector.sections.size(); ++j) {
+            if (*collector.sections[j] == *sections[i]) {
+                found++;
+            }
+        }
+        CPPUNIT_ASSERT_EQUAL(size_t(1), found);
+    }
+}
+
+void PacketizerTest::testTightPacking()
+{
+    // 180-byte sections: after one section, 3 bytes remain in the packet, not enough for a section header.
+    ts::SectionPtrVector sections;
+    for (uint16_t ts_id = 0; ts_id < 100; ++ts_id) {
+        ts::PAT pat(0, true, ts_id);
+        for (uint16_t srv = 1; srv <= 41; ++srv) {
+            pat.pmts[srv] = ts::PID(100 + srv);
+        }
+        ts::BinaryTable bin;
+        pat.serialize(bin);
+        CPPUNIT_ASSERT_EQUAL(size_t(1), bin.sectionCount());
+        CPPUNIT_ASSERT_EQUAL(size_t(180), bin.sectionAt(0)->size());
+        sections.push_back(bin.sectionAt(0));
+    }
+
+    size_t packets[2] = {0, 0};
+    for (size_t tight = 0; tight < 2; ++tight) {
+        ts::CyclingPacketizer pzer(ts::PID_PAT, ts::CyclingPacketizer::AT_END);
+        pzer.setTightPacking(tight != 0);
+        CPPUNIT_ASSERT_EQUAL(tight != 0, pzer.tightPacking());
+        pzer.addSections(sections);
+
+        // Generate 3 cycles, all sections are correctly demuxed.
+        CountingHandler counter;
+        ts::SectionDemux demux(0, &counter, ts::AllPIDs);
+        for (size_t ci = 0; ci < 3; ++ci) {
+            do {
+                ts::TSPacket pkt;
+                pzer.getNextPacket(pkt);
+                demux.feedPacket(pkt);
+                packets[tight]++;
+            } while (!pzer.atCycleBoundary());
+        }
+        CPPUNIT_ASSERT(!demux.hasErrors());
+        CPPUNIT_ASSERT_EQUAL(3 * sections.size(), counter.count);
+    }
+
+    // Without tight packing, each section uses one packet. With tight packing, headers are split.
+    CPPUNIT_ASSERT_EQUAL(3 * sections.size(), packets[0]);
+    CPPUNIT_ASSERT(packets[1] < packets[0]);
+}
+
+namespace {
+    class EITCollector: public ts::SectionHandlerInterface
+    {
+    public:
+        std::map<uint16_t, ts::SectionPtr> sections;  // key: (tid << 8) | section_number
+        virtual void handleSection(ts::SectionDemux&, const ts::Section& section) override
+        {
+            sections[uint16_t(section.tableId() << 8) | section.sectionNumber()] = new ts::Section(section, ts::SHARE);
+        }
+    };
+}
+
+void PacketizerTest::testEITGenerator()
+{
+    const ts::Time now(2018, 6, 15, 10, 30);
+
+    // One ended event, the present and following events, one event in two days.
+    ts::EIT eit(true, false, 0, 0, true, 0x0100, 0x0001, 0x0002);
+    eit.events[1].start_time = ts::Time(2018, 6, 15, 1, 0);
+    eit.events[1].duration = 3600;
+    eit.events[2].start_time = ts::Time(2018, 6, 15, 10, 0);
+    eit.events[2].duration = 3600;
+    eit.events[3].start_time = ts::Time(2018, 6, 15, 11, 0);
+    eit.events[3].duration = 3600;
+    eit.events[4].start_time = ts::Time(2018, 6, 17, 20, 0);
+    eit.events[4].duration = 7200;
+
+    ts::EITGenerator gen;
+    CPPUNIT_ASSERT_EQUAL(size_t(4), gen.loadEvents(eit));
+    CPPUNIT_ASSERT_EQUAL(size_t(0), gen.sectionCount());
+    gen.setCurrentTime(now);
+    CPPUNIT_ASSERT_EQUAL(size_t(1), gen.serviceCount());
+    CPPUNIT_ASSERT_EQUAL(size_t(3), gen.eventCount());
+
+    // 2 sections in EIT p/f, segments 3 (09:00-12:00) to 22 (day + 2, 18:00-21:00) in EIT schedule.
+    CPPUNIT_ASSERT_EQUAL(size_t(22), gen.sectionCount());
+
+    EITCollector collector;
+    ts::SectionDemux demux(0, &collector, ts::AllPIDs);
+    for (size_t i = 0; i < 100; ++i) {
+        ts::TSPacket pkt;
+        gen.getNextPacket(pkt);
+        demux.feedPacket(pkt);
+    }
+    CPPUNIT_ASSERT(!demux.hasErrors());
+    CPPUNIT_ASSERT_EQUAL(size_t(22), collector.sections.size());
+
+    const ts::SectionPtr present(collector.sections[uint16_t(ts::TID_EIT_PF_ACT << 8)]);
+    CPPUNIT_ASSERT(!present.isNull());
+    CPPUNIT_ASSERT_EQUAL(uint8_t(0), present->version());
+    CPPUNIT_ASSERT_EQUAL(uint16_t(2), ts::GetUInt16(present->payload() + 6));
+    CPPUNIT_ASSERT_EQUAL(uint8_t(4), uint8_t(present->payload()[16] >> 5));
+
+    const ts::SectionPtr first(collector.sections[uint16_t(ts::TID_EIT_S_ACT_MIN << 8) | 24]);
+    CPPUNIT_ASSERT(!first.isNull());
+    CPPUNIT_ASSERT_EQUAL(uint8_t(176), first->lastSectionNumber());
+    CPPUNIT_ASSERT_EQUAL(uint8_t(24), first->payload()[4]);
+    CPPUNIT_ASSERT_EQUAL(uint16_t(2), ts::GetUInt16(first->payload() + 6));
+    CPPUNIT_ASSERT(collector.sections[uint16_t(ts::TID_EIT_S_ACT_MIN << 8) | 176]->payloadSize() > 6);
+    CPPUNIT_ASSERT_EQUAL(size_t(6), collector.sections[uint16_t(ts::TID_EIT_S_ACT_MIN << 8) | 32]->payloadSize());
+
+    // One hour later, the following event becomes the present one.
+    gen.setCurrentTime(now + ts::MilliSecPerHour);
+    collector.sections.clear();
+    for (size_t i = 0; i < 100; ++i) {
+        ts::TSPacket pkt;
+        gen.getNextPacket(pkt);
+        demux.feedPacket(pkt);
+    }
+    const ts::SectionPtr next(collector.sections[uint16_t(ts::TID_EIT_PF_ACT << 8)]);
+    CPPUNIT_ASSERT(!next.isNull());
+    CPPUNIT_ASSERT_EQUAL(uint8_t(1), next->version());
+    CPPUNIT_ASSERT_EQUAL(uint16_t(3), ts::GetUInt16(next->payload() + 6));
+    CPPUNIT_ASSERT_EQUAL(size_t(22), gen.sectionCount());
+}
@@ -33,6 +33,7 @@
 
 #include "tsReportBuffer.h"
 #include "tsReportFile.h"
+#include "tsLogLimiter.h"
 #include "tsSysUtils.h"
 #include "utestCppUnitTest.h"
 TSDUCK_SOURCE;
@@ -55,6 +56,7 @@ public:
     void testPrintf();
     void testByName();
     void testByStream();
+    void testLimiter();
 
     CPPUNIT_TEST_SUITE(ReportTest);
     CPPUNIT_TEST(testSeverity);
@@ -62,6 +64,7 @@ public:
     CPPUNIT_TEST(testPrintf);
     CPPUNIT_TEST(testByName);
     CPPUNIT_TEST(testByStream);
+    CPPUNIT_TEST(testLimiter);
     CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -325,3 +328,35 @@ void ReportTest::testByStream()
     ts::UString::Load(value, _fileName);
     CPPUNIT_ASSERT(value == ref);
 }
+
+// Test case: rate-limited logging
+void ReportTest::testLimiter()
+{
+    ts::ReportBuffer<> log;
+    ts::LogLimiter limiter(log, u"PID", 2, 3600 * ts::MilliSecPerSec);
+
+    for (int i = 1; i <= 5; ++i) {
+        limiter.info(0x100, u"a%d", {i});
+        limiter.error(0x200, u"b%d", {i});
+        limiter.debug(0x300, u"c%d", {i});
+    }
+    CPPUNIT_ASSERT_EQUAL(uint64_t(6), limiter.suppressedCount());
+    CPPUNIT_ASSERT_USTRINGS_EQUAL(u"a1\n"
+                                  u"Error: b1\n"
+                                  u"a2\n"
+                                  u"Error: b2",
+                                  log.getMessages());
+
+    log.resetMessages();
+    limiter.flush();
+    ts::UStringVector lines;
+    log.getMessages().split(lines, u'\n', false);
+    CPPUNIT_ASSERT_EQUAL(size_t(2), lines.size());
+    CPPUNIT_ASSERT(lines[0].startWith(u"3 more similar messages for PID 0x0100 (256) in last "));
+    CPPUNIT_ASSERT(lines[1].startWith(u"Error: 3 more similar messages for PID 0x0200 (512) in last "));
+
+    // After flush, new windows are started.
+    log.resetMessages();
+    limiter.info(0x100, u"a%d", {6});
+    CPPUNIT_ASSERT_USTRINGS_EQUAL(u"a6", log.getMessages());
+}
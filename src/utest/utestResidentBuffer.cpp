@@ -47,9 +47,11 @@ public:
     virtual void tearDown() override;
 
     void testResidentBuffer();
+    void testHugePages();
 
     CPPUNIT_TEST_SUITE(ResidentBufferTest);
     CPPUNIT_TEST(testResidentBuffer);
+    CPPUNIT_TEST(testHugePages);
     CPPUNIT_TEST_SUITE_END();
 };
 
@@ -87,3 +89,25 @@ void ResidentBufferTest::testResidentBuffer()
     CPPUNIT_ASSERT(buf.isLocked());
     CPPUNIT_ASSERT(buf.count() >= buf_size);
 }
+
+void ResidentBufferTest::testHugePages()
+{
+    const size_t buf_size = 10000;
+
+    ts::ResidentBuffer<uint8_t> buf(buf_size, 2 * 1024 * 1024);
+
+    utest::Out() << "ResidentBufferTest: huge pages: pageMode() = " << int(buf.pageMode())
+                 << ", isLocked() = " << buf.isLocked() << ", count() = " << buf.count() << std::endl;
+
+    CPPUNIT_ASSERT(buf.count() >= buf_size);
+    CPPUNIT_ASSERT(buf.base() != 0);
+
+    // The buffer must be usable, whatever the type of pages.
+    ::memset(buf.base(), 0x5A, buf_size);
+    CPPUNIT_ASSERT_EQUAL(uint8_t(0x5A), buf.base()[0]);
+    CPPUNIT_ASSERT_EQUAL(uint8_t(0x5A), buf.base()[buf_size - 1]);
+
+#if !defined(TS_LINUX)
+    CPPUNIT_ASSERT_EQUAL(ts::ResidentBuffer<uint8_t>::NORMAL_PAGES, buf.pageMode());
+#endif
+}
@@ -51,12 +51,14 @@ public:
     void testDowncast();
     void testUpcast();
     void testChangeMutex();
+    void testMove();
 
     CPPUNIT_TEST_SUITE (SafePtrTest);
     CPPUNIT_TEST (testSafePtr);
     CPPUNIT_TEST (testDowncast);
     CPPUNIT_TEST (testUpcast);
     CPPUNIT_TEST (testChangeMutex);
+    CPPUNIT_TEST (testMove);
     CPPUNIT_TEST_SUITE_END ();
 };
 
@@ -387,3 +389,60 @@ void SafePtrTest::testChangeMutex()
     pt.clear();
     CPPUNIT_ASSERT(TestData::InstanceCount() == 0);
 }
+
+// Test case: check move construction and assignment
+void SafePtrTest::testMove()
+{
+    CPPUNIT_ASSERT(TestData::InstanceCount() == 0);
+    ts::SafePtr<TestData,ts::Mutex> p1 (new TestData (999));
+    ts::SafePtr<TestData,ts::Mutex> p2 (p1);
+    CPPUNIT_ASSERT(p1.count() == 2);
+
+    ts::SafePtr<TestData,ts::Mutex> p3 (std::move(p1));
+    CPPUNIT_ASSERT(p3.count() == 2);
+    CPPUNIT_ASSERT(p3->value() == 999);
+    CPPUNIT_ASSERT(TestData::InstanceCount() == 1);
+
+    // The moved-from instance is a null pointer.
+    CPPUNIT_ASSERT(p1.isNull());
+    CPPUNIT_ASSERT(p1.pointer() == 0);
+    CPPUNIT_ASSERT(p1.count() == 0);
+    ts::SafePtr<TestData,ts::Mutex> p4 (p1);
+    CPPUNIT_ASSERT(p4.isNull());
+
+    // Assign the moved-from instance.
+    p1 = new TestData (111);
+    CPPUNIT_ASSERT(p1.count() == 1);
+    CPPUNIT_ASSERT(p1->value() == 111);
+    CPPUNIT_ASSERT(TestData::InstanceCount() == 2);
+
+    // The previous reference of the target is released, not transfered to the source.
+    p2 = std::move(p1);
+    CPPUNIT_ASSERT(p1.isNull());
+    CPPUNIT_ASSERT(p2.count() == 1);
+    CPPUNIT_ASSERT(p2->value() == 111);
+    CPPUNIT_ASSERT(p3.count() == 1);
+    CPPUNIT_ASSERT(TestData::InstanceCount() == 2);
+
+    // The last reference is deleted when moving over it.
+    p4 = new TestData (222);
+    CPPUNIT_ASSERT(TestData::InstanceCount() == 3);
+    p4 = std::move(p2);
+    CPPUNIT_ASSERT(p2.isNull());
+    CPPUNIT_ASSERT(p4->value() == 111);
+    CPPUNIT_ASSERT(TestData::InstanceCount() == 2);
+
+    // A moved-from instance can be reset, cleared and used again.
+    p2.reset(new TestData (333));
+    CPPUNIT_ASSERT(p2.count() == 1);
+    CPPUNIT_ASSERT(TestData::InstanceCount() == 3);
+    p2.clear();
+    p1.clear();
+    CPPUNIT_ASSERT(p1.isNull());
+    CPPUNIT_ASSERT(TestData::InstanceCount() == 2);
+
+    p3.clear();
+    CPPUNIT_ASSERT(TestData::InstanceCount() == 1);
+    p4.clear();
+    CPPUNIT_ASSERT(TestData::InstanceCount() == 0);
+}
@@ -32,6 +32,7 @@
 //----------------------------------------------------------------------------
 
 #include "tsScrambling.h"
+#include "tsScramblingBatch.h"
 #include "tsTSPacket.h"
 #include "tsNames.h"
 #include "utestCppUnitTest.h"
@@ -49,9 +50,11 @@ public:
     virtual void tearDown() override;
 
     void testScrambling();
+    void testBatch();
 
     CPPUNIT_TEST_SUITE(ScramblingTest);
     CPPUNIT_TEST(testScrambling);
+    CPPUNIT_TEST(testBatch);
     CPPUNIT_TEST_SUITE_END();
 };
 
@@ -211,3 +214,71 @@ void ScramblingTest::testScrambling()
         CPPUNIT_ASSERT(::memcmp(pkt.b + header_size, vec->cipher.b + header_size, payload_size) == 0);
     }
 }
+
+void ScramblingTest::testBatch()
+{
+    const ScramblingTestVector* vec = scrambling_test_vectors;
+    size_t count = sizeof(scrambling_test_vectors) / sizeof(ScramblingTestVector);
+    ts::Scrambling scrambler;
+    ts::ScramblingBatch decrypt_batch(false);
+    ts::ScramblingBatch encrypt_batch(true);
+
+    // A bit more than one full batch, to test both the bitsliced and residual processing.
+    const size_t pkt_count = ts::Scrambling::BATCH_SIZE + ts::Scrambling::MIN_BATCH_SIZE + 1;
+    ts::TSPacket pkts[pkt_count];
+
+    for (size_t ti = 0; ti < count; ++ti, ++vec) {
+
+        const size_t header_size = vec->plain.getHeaderSize();
+        const size_t payload_size = vec->plain.getPayloadSize();
+        const uint8_t scv = vec->cipher.getScrambling();
+
+        scrambler.init(scv == ts::SC_EVEN_KEY ? vec->cw_even : vec->cw_odd, ts::Scrambling::REDUCE_ENTROPY);
+
+        // Descrambling test
+        for (size_t i = 0; i < pkt_count; ++i) {
+            pkts[i] = vec->cipher;
+            decrypt_batch.add(scrambler, pkts[i].b + header_size, payload_size);
+        }
+        decrypt_batch.flush();
+        CPPUNIT_ASSERT(decrypt_batch.empty());
+        for (size_t i = 0; i < pkt_count; ++i) {
+            CPPUNIT_ASSERT(::memcmp(pkts[i].b + header_size, vec->plain.b + header_size, payload_size) == 0);
+        }
+
+        // Scrambling test
+        for (size_t i = 0; i < pkt_count; ++i) {
+            pkts[i] = vec->plain;
+            encrypt_batch.add(scrambler, pkts[i].b + header_size, payload_size);
+        }
+        encrypt_batch.flush();
+        for (size_t i = 0; i < pkt_count; ++i) {
+            CPPUNIT_ASSERT(::memcmp(pkts[i].b + header_size, vec->cipher.b + header_size, payload_size) == 0);
+        }
+    }
+
+    // Batches of payloads with distinct sizes must give the same result as one by one.
+    uint8_t* data[ts::Scrambling::BATCH_SIZE];
+    size_t sizes[ts::Scrambling::BATCH_SIZE];
+    ts::TSPacket ref[ts::Scrambling::BATCH_SIZE];
+
+    scrambler.init(scrambling_test_vectors[0].cw_even, ts::Scrambling::REDUCE_ENTROPY);
+    for (size_t i = 0; i < ts::Scrambling::BATCH_SIZE; ++i) {
+        for (size_t j = 0; j < ts::PKT_SIZE; ++j) {
+            pkts[i].b[j] = uint8_t(i * 7 + j * 13);
+        }
+        ref[i] = pkts[i];
+        data[i] = pkts[i].b + 4;
+        sizes[i] = (i * 37) % (ts::PKT_SIZE - 4 + 1);
+        scrambler.encrypt(ref[i].b + 4, sizes[i]);
+    }
+    scrambler.encrypt(data, sizes, ts::Scrambling::BATCH_SIZE);
+    for (size_t i = 0; i < ts::Scrambling::BATCH_SIZE; ++i) {
+        CPPUNIT_ASSERT(pkts[i] == ref[i]);
+        scrambler.decrypt(ref[i].b + 4, sizes[i]);
+    }
+    scrambler.decrypt(data, sizes, ts::Scrambling::BATCH_SIZE);
+    for (size_t i = 0; i < ts::Scrambling::BATCH_SIZE; ++i) {
+        CPPUNIT_ASSERT(pkts[i] == ref[i]);
+    }
+}
@@ -33,6 +33,11 @@
 
 #include "tsSection.h"
 #include "tsNames.h"
+#include "tsCRC32.h"
+#include "tsNIT.h"
+#include "tsBinaryTable.h"
+#include "tsSpliceInfoTable.h"
+#include "tsServiceListDescriptor.h"
 #include "utestCppUnitTest.h"
 TSDUCK_SOURCE;
 
@@ -54,15 +59,23 @@ public:
     void testTOT();
     void testBAT();
     void testNIT();
+    void testLargeNIT();
     void testReload();
     void testAssign();
+    void testCRC32();
+    void testCRC32Delta();
+    void testSpliceInfo();
 
     CPPUNIT_TEST_SUITE(SectionTest);
     CPPUNIT_TEST(testTOT);
     CPPUNIT_TEST(testBAT);
     CPPUNIT_TEST(testNIT);
+    CPPUNIT_TEST(testLargeNIT);
     CPPUNIT_TEST(testReload);
     CPPUNIT_TEST(testReload);
+    CPPUNIT_TEST(testCRC32);
+    CPPUNIT_TEST(testCRC32Delta);
+    CPPUNIT_TEST(testSpliceInfo);
     CPPUNIT_TEST_SUITE_END();
 };
 
@@ -118,6 +131,47 @@ void SectionTest::testNIT()
     CPPUNIT_ASSERT(sec.isLongSection());
 }
 
+void SectionTest::testLargeNIT()
+{
+    // Thousands of transports, some of them with a section hint.
+    ts::NIT nit(true, 3, true, 1);
+    for (uint16_t i = 0; i < 3000; ++i) {
+        const ts::TransportStreamId id(i, 1 + i % 3);
+        ts::ServiceListDescriptor sld;
+        for (uint16_t k = 0; k < 5; ++k) {
+            sld.entries.push_back(ts::ServiceListDescriptor::Entry(i * 8 + k, 1));
+        }
+        nit.transports[id].add(sld);
+        if (i % 7 == 0) {
+            nit.section_hints[id] = i / 100;
+        }
+    }
+
+    ts::BinaryTable bin;
+    nit.serialize(bin);
+    CPPUNIT_ASSERT(bin.isValid());
+    CPPUNIT_ASSERT(bin.sectionCount() > 30);
+
+    // All transports are serialized once, the hinted ones in their section.
+    ts::NIT nit2(bin);
+    CPPUNIT_ASSERT(nit2.isValid());
+    CPPUNIT_ASSERT_EQUAL(nit.transports.size(), nit2.transports.size());
+    size_t count = 0;
+    for (size_t si = 0; si < bin.sectionCount(); ++si) {
+        // Walk through the transport loop of each section.
+        const uint8_t* data = bin.sectionAt(si)->payload();
+        data += 2 + (ts::GetUInt16(data) & 0x0FFF);
+        const uint8_t* const end = data + 2 + (ts::GetUInt16(data) & 0x0FFF);
+        for (data += 2; data < end; data += 6 + (ts::GetUInt16(data + 4) & 0x0FFF)) {
+            const ts::TransportStreamId id(ts::GetUInt16(data), ts::GetUInt16(data + 2));
+            const ts::NIT::SectionHintsMap::const_iterator hint(nit.section_hints.find(id));
+            CPPUNIT_ASSERT(hint == nit.section_hints.end() || hint->second == int(si));
+            count++;
+        }
+    }
+    CPPUNIT_ASSERT_EQUAL(nit.transports.size(), count);
+}
+
 void SectionTest::testReload()
 {
     ts::Section sec(psi_tot_tnt_sections, sizeof(psi_tot_tnt_sections), ts::PID_TOT, ts::CRC32::CHECK);
@@ -158,3 +212,107 @@ void SectionTest::testAssign()
     CPPUNIT_ASSERT_EQUAL(ts::PID(ts::PID_NIT), sec.sourcePID());
     CPPUNIT_ASSERT(sec.isLongSection());
 }
+
+void SectionTest::testCRC32()
+{
+    // Standard check value of CRC-32/MPEG-2.
+    CPPUNIT_ASSERT_EQUAL(uint32_t(0x0376E6E7), ts::CRC32("123456789", 9).value());
+
+    // Compare all sizes and alignments with a bitwise computation. Large areas
+    // may use accelerated implementations, small ones use tables.
+    uint8_t data[1024 + 16];
+    for (size_t i = 0; i < sizeof(data); ++i) {
+        data[i] = uint8_t(i * 7 + (i >> 3));
+    }
+    for (size_t offset = 0; offset < 16; ++offset) {
+        uint32_t expected = 0xFFFFFFFF;
+        for (size_t size = 0; size <= 1024; ++size) {
+            CPPUNIT_ASSERT_EQUAL(expected, ts::CRC32(data + offset, size).value());
+
+            // Same computation in two parts.
+            ts::CRC32 crc(data + offset, size / 3);
+            crc.add(data + offset + size / 3, size - size / 3);
+            CPPUNIT_ASSERT_EQUAL(expected, crc.value());
+
+            // Bitwise update with the next byte.
+            expected ^= uint32_t(data[offset + size]) << 24;
+            for (int bit = 0; bit < 8; ++bit) {
+                expected = (expected & 0x80000000) != 0 ? (expected << 1) ^ 0x04C11DB7 : expected << 1;
+            }
+        }
+    }
+}
+
+void SectionTest::testCRC32Delta()
+{
+    uint8_t data[300];
+    for (size_t i = 0; i < sizeof(data); ++i) {
+        data[i] = uint8_t(i * 13 + (i >> 2));
+    }
+
+    // Modify a 5-byte field at various positions, compare with a full computation.
+    ts::CRC32Delta delta;
+    for (size_t pos = 0; pos + 5 <= sizeof(data); pos += 37) {
+        delta.setLayout(5, sizeof(data) - pos - 5);
+        CPPUNIT_ASSERT_EQUAL(size_t(5), delta.fieldSize());
+        CPPUNIT_ASSERT_EQUAL(sizeof(data) - pos - 5, delta.trailingSize());
+        for (int iter = 0; iter < 4; ++iter) {
+            const uint32_t crc = ts::CRC32(data, sizeof(data)).value();
+            uint8_t old_field[5];
+            ::memcpy(old_field, data + pos, sizeof(old_field));
+            for (size_t i = 0; i < 5; ++i) {
+                data[pos + i] = uint8_t(data[pos + i] * 3 + iter + 1);
+            }
+            CPPUNIT_ASSERT_EQUAL(ts::CRC32(data, sizeof(data)).value(), delta.update(crc, old_field, data + pos));
+        }
+    }
+
+    // Unmodified field, same CRC32.
+    ts::CRC32Delta same(4, 10);
+    CPPUNIT_ASSERT_EQUAL(uint32_t(0x12345678), same.update(0x12345678, data, data));
+}
+
+void SectionTest::testSpliceInfo()
+{
+    // Splice information section with a time_signal command at PTS 1000, pts_adjustment = 100.
+    uint8_t signal[] = {
+        0xFC, 0x30, 0x16, 0x00, 0x00, 0x00, 0x00, 0x00, 0x64, 0x00, 0xFF, 0xF0, 0x05, 0x06,
+        0xFE, 0x00, 0x00, 0x03, 0xE8,
+        0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00,
+    };
+    ts::PutUInt32(signal + sizeof(signal) - 4, ts::CRC32(signal, sizeof(signal) - 4).value());
+
+    uint64_t pts = 0;
+    ts::SpliceInsert cmd;
+    CPPUNIT_ASSERT(ts::SpliceInfoTable::ExtractTimeSignal(pts, signal, sizeof(signal)));
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1100), pts);
+    CPPUNIT_ASSERT(!ts::SpliceInfoTable::ExtractSpliceInsert(cmd, signal, sizeof(signal)));
+    CPPUNIT_ASSERT(!ts::SpliceInfoTable::ExtractTimeSignal(pts, signal, sizeof(signal) - 1));
+
+    // Same section with a splice_insert command, splice out event 0x1234 at PTS 1000.
+    uint8_t insert[] = {
+        0xFC, 0x30, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x64, 0x00, 0xFF, 0xF0, 0x0F, 0x05,
+        0x00, 0x00, 0x12, 0x34, 0x7F, 0xCF, 0xFE, 0x00, 0x00, 0x03, 0xE8, 0x00, 0x01, 0x00, 0x00,
+        0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00,
+    };
+    ts::PutUInt32(insert + sizeof(insert) - 4, ts::CRC32(insert, sizeof(insert) - 4).value());
+
+    CPPUNIT_ASSERT(ts::SpliceInfoTable::ExtractSpliceInsert(cmd, insert, sizeof(insert)));
+    CPPUNIT_ASSERT_EQUAL(uint32_t(0x1234), cmd.event_id);
+    CPPUNIT_ASSERT(cmd.splice_out);
+    CPPUNIT_ASSERT(!cmd.immediate);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1100), cmd.program_pts);
+    CPPUNIT_ASSERT(!ts::SpliceInfoTable::ExtractTimeSignal(pts, insert, sizeof(insert)));
+
+    // The Section-based method gives the same result.
+    ts::SpliceInsert cmd2;
+    const ts::Section sec(insert, sizeof(insert), ts::PID_NULL, ts::CRC32::CHECK);
+    CPPUNIT_ASSERT(ts::SpliceInfoTable::ExtractSpliceInsert(cmd2, sec));
+    CPPUNIT_ASSERT_EQUAL(cmd.program_pts, cmd2.program_pts);
+
+    // Corrupted CRC32.
+    insert[20] ^= 0x01;
+    CPPUNIT_ASSERT(!ts::SpliceInfoTable::ExtractSpliceInsert(cmd, insert, sizeof(insert)));
+}
@@ -67,6 +67,7 @@ public:
     void testSCTE35();
     void testAllTables();
     void testBuildSections();
+    void testIndexedBinary();
 
     CPPUNIT_TEST_SUITE(SectionFileTest);
     CPPUNIT_TEST(testConfigurationFile);
@@ -77,6 +78,7 @@ public:
     CPPUNIT_TEST(testSCTE35);
     CPPUNIT_TEST(testAllTables);
     CPPUNIT_TEST(testBuildSections);
+    CPPUNIT_TEST(testIndexedBinary);
     CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -105,6 +107,7 @@ SectionFileTest::SectionFileTest() :
 void SectionFileTest::setUp()
 {
     ts::DeleteFile(_tempFileNameBin);
+    ts::DeleteFile(ts::SectionFile::IndexFileName(_tempFileNameBin));
     ts::DeleteFile(_tempFileNameXML);
 }
 
@@ -112,6 +115,7 @@ void SectionFileTest::setUp()
 void SectionFileTest::tearDown()
 {
     ts::DeleteFile(_tempFileNameBin);
+    ts::DeleteFile(ts::SectionFile::IndexFileName(_tempFileNameBin));
     ts::DeleteFile(_tempFileNameXML);
 }
 
@@ -159,6 +163,11 @@ void SectionFileTest::testTable(const char* name, const ts::UChar* ref_xml, cons
 
     // Convert binary tables to XML.
     CPPUNIT_ASSERT_USTRINGS_EQUAL(ref_xml, xml.toXML(CERR));
+
+    // The complete XML document gives the same text.
+    ts::xml::Document doc(CERR);
+    CPPUNIT_ASSERT(xml.generateDocument(doc));
+    CPPUNIT_ASSERT_USTRINGS_EQUAL(ref_xml, doc.toString());
 }
 
 
@@ -459,3 +468,84 @@ void SectionFileTest::testBuildSections()
     ts::TDT xmlTDT(*xmlFile.tables()[2]);
     CPPUNIT_ASSERT(tdtTime == xmlTDT.utc_time);
 }
+
+void SectionFileTest::testIndexedBinary()
+{
+    // Table selectors.
+    ts::SectionFile::TableSelector sel;
+    CPPUNIT_ASSERT(sel.decode(u"0x4E/0x1234/5"));
+    CPPUNIT_ASSERT_EQUAL(ts::TID(0x4E), sel.tid);
+    CPPUNIT_ASSERT(sel.has_tid_ext);
+    CPPUNIT_ASSERT_EQUAL(uint16_t(0x1234), sel.tid_ext);
+    CPPUNIT_ASSERT(sel.has_version);
+    CPPUNIT_ASSERT_EQUAL(uint8_t(5), sel.version);
+    CPPUNIT_ASSERT(sel.match(0x4E, true, 0x1234, 5));
+    CPPUNIT_ASSERT(!sel.match(0x4E, true, 0x1234, 6));
+    CPPUNIT_ASSERT(!sel.match(0x4E, false, 0, 0));
+    CPPUNIT_ASSERT(sel.decode(u"112"));
+    CPPUNIT_ASSERT_EQUAL(ts::TID(0x70), sel.tid);
+    CPPUNIT_ASSERT(!sel.has_tid_ext);
+    CPPUNIT_ASSERT(!sel.has_version);
+    CPPUNIT_ASSERT(sel.match(0x70, false, 0, 0));
+    CPPUNIT_ASSERT(!sel.decode(u""));
+    CPPUNIT_ASSERT(!sel.decode(u"0x100"));
+    CPPUNIT_ASSERT(!sel.decode(u"1/2/32"));
+    CPPUNIT_ASSERT(!sel.decode(u"1/2/3/4"));
+    CPPUNIT_ASSERT_EQUAL(ts::TID(0x70), sel.tid);
+
+    // Build a section file with two versions of a PAT and a TDT.
+    ts::PAT pat7(7, true, 0x1234);
+    for (uint16_t srv = 3; srv < ts::MAX_PSI_LONG_SECTION_PAYLOAD_SIZE / 4 + 16; ++srv) {
+        pat7.pmts[srv] = ts::PID(srv + 2);
+    }
+    ts::PAT pat8(8, true, 0x1234);
+    pat8.pmts[1] = 0x0100;
+    const ts::TDT tdt(ts::Time(ts::Time::Fields(2017, 12, 25, 14, 55, 27)));
+
+    ts::SectionFile file;
+    file.add(ts::AbstractTablePtr(new ts::PAT(pat7)));
+    file.add(ts::AbstractTablePtr(new ts::TDT(tdt)));
+    file.add(ts::AbstractTablePtr(new ts::PAT(pat8)));
+    CPPUNIT_ASSERT_EQUAL(size_t(3), file.tables().size());
+    CPPUNIT_ASSERT_EQUAL(size_t(4), file.sections().size());
+    CPPUNIT_ASSERT(file.saveBinary(_tempFileNameBin, report()));
+
+    // Load one version of the PAT. The index is created.
+    const ts::UString indexName(ts::SectionFile::IndexFileName(_tempFileNameBin));
+    CPPUNIT_ASSERT(!ts::FileExists(indexName));
+
+    ts::SectionFile::TableSelectorVector selectors;
+    selectors.push_back(ts::SectionFile::TableSelector(ts::TID_PAT, 0x1234, 8));
+
+    ts::SectionFile binFile;
+    CPPUNIT_ASSERT(binFile.loadBinary(_tempFileNameBin, selectors, report(), ts::CRC32::CHECK));
+    CPPUNIT_ASSERT(ts::FileExists(indexName));
+    CPPUNIT_ASSERT_EQUAL(size_t(1), binFile.tables().size());
+    CPPUNIT_ASSERT_EQUAL(size_t(1), binFile.sections().size());
+    CPPUNIT_ASSERT(*binFile.tables()[0] == *file.tables()[2]);
+
+    // Load all versions of the PAT and the TDT, using the index.
+    selectors.clear();
+    selectors.push_back(ts::SectionFile::TableSelector(ts::TID_PAT, 0x1234));
+    selectors.push_back(ts::SectionFile::TableSelector(ts::TID_TDT));
+    CPPUNIT_ASSERT(binFile.loadBinary(_tempFileNameBin, selectors, report(), ts::CRC32::CHECK));
+    CPPUNIT_ASSERT_EQUAL(size_t(3), binFile.tables().size());
+    CPPUNIT_ASSERT_EQUAL(size_t(4), binFile.sections().size());
+    CPPUNIT_ASSERT_EQUAL(size_t(0), binFile.orphanSections().size());
+    for (size_t i = 0; i < file.tables().size(); ++i) {
+        CPPUNIT_ASSERT(*file.tables()[i] == *binFile.tables()[i]);
+    }
+
+    // Rewrite the binary file with less sections, the obsolete index is rebuilt.
+    ts::SectionFile small;
+    small.add(ts::AbstractTablePtr(new ts::TDT(tdt)));
+    CPPUNIT_ASSERT(small.saveBinary(_tempFileNameBin, report()));
+    CPPUNIT_ASSERT(binFile.loadBinary(_tempFileNameBin, selectors, report(), ts::CRC32::CHECK));
+    CPPUNIT_ASSERT_EQUAL(size_t(1), binFile.tables().size());
+    CPPUNIT_ASSERT(*small.tables()[0] == *binFile.tables()[0]);
+
+    // Explicit index build.
+    CPPUNIT_ASSERT(ts::DeleteFile(indexName) == ts::SYS_SUCCESS);
+    CPPUNIT_ASSERT(ts::SectionFile::BuildIndex(_tempFileNameBin, report()));
+    CPPUNIT_ASSERT(ts::FileExists(indexName));
+}
@@ -0,0 +1,198 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  CppUnit test suite for class ts::ServiceDiscovery
+//
+//----------------------------------------------------------------------------
+
+#include "tsServiceDiscovery.h"
+#include "tsOneShotPacketizer.h"
+#include "tsISO639LanguageDescriptor.h"
+#include "utestCppUnitTest.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// The test fixture
+//----------------------------------------------------------------------------
+
+class ServiceDiscoveryTest: public CppUnit::TestFixture
+{
+public:
+    virtual void setUp() override;
+    virtual void tearDown() override;
+
+    void testChanges();
+
+    CPPUNIT_TEST_SUITE(ServiceDiscoveryTest);
+    CPPUNIT_TEST(testChanges);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ServiceDiscoveryTest);
+
+
+//----------------------------------------------------------------------------
+// Initialization.
+//----------------------------------------------------------------------------
+
+// Test suite initialization method.
+void ServiceDiscoveryTest::setUp()
+{
+}
+
+// Test suite cleanup method.
+void ServiceDiscoveryTest::tearDown()
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Test cases
+//----------------------------------------------------------------------------
+
+namespace {
+    // Log all changes from a service discovery, one string per change.
+    class ChangeLog: public ts::ServiceChangeHandlerInterface, public ts::PMTHandlerInterface
+    {
+    public:
+        ts::UStringList events;
+        ChangeLog() : events() {}
+
+        virtual void handleServiceAdded(ts::ServiceDiscovery& service) override
+        {
+            events.push_back(ts::UString::Format(u"added 0x%X", {service.getPMTPID()}));
+        }
+        virtual void handleServiceRemoved(ts::ServiceDiscovery& service) override
+        {
+            events.push_back(u"removed");
+        }
+        virtual void handleServiceNameChanged(ts::ServiceDiscovery& service, const ts::UString& old_name, const ts::UString& new_name) override
+        {
+            events.push_back(ts::UString::Format(u"name %s -> %s", {old_name, new_name}));
+        }
+        virtual void handleStreamAdded(ts::ServiceDiscovery& service, ts::PID pid, const ts::PMT::Stream& stream) override
+        {
+            events.push_back(ts::UString::Format(u"+0x%X", {pid}));
+        }
+        virtual void handleStreamRemoved(ts::ServiceDiscovery& service, ts::PID pid, const ts::PMT::Stream& stream) override
+        {
+            events.push_back(ts::UString::Format(u"-0x%X", {pid}));
+        }
+        virtual void handleStreamChanged(ts::ServiceDiscovery& service, ts::PID pid, const ts::PMT::Stream& old_stream, const ts::PMT::Stream& new_stream) override
+        {
+            events.push_back(ts::UString::Format(u"*0x%X", {pid}));
+        }
+        virtual void handlePMT(const ts::PMT& table) override
+        {
+            events.push_back(ts::UString::Format(u"pmt v%d", {table.version}));
+        }
+    };
+
+    // Packetize a table and feed a service discovery with it.
+    class Feeder
+    {
+    public:
+        Feeder(ts::ServiceDiscovery& service) : _service(service), _cc() {}
+        void feed(const ts::AbstractTable& table, ts::PID pid)
+        {
+            ts::OneShotPacketizer pzer(pid);
+            ts::TSPacketVector packets;
+            pzer.setNextContinuityCounter(_cc[pid]);
+            pzer.addTable(table);
+            pzer.getPackets(packets);
+            for (size_t i = 0; i < packets.size(); ++i) {
+                _service.feedPacket(packets[i]);
+            }
+            _cc[pid] = uint8_t((_cc[pid] + packets.size()) % ts::CC_MAX);
+        }
+    private:
+        ts::ServiceDiscovery& _service;
+        std::map<ts::PID, uint8_t> _cc;
+    };
+}
+
+void ServiceDiscoveryTest::testChanges()
+{
+    ChangeLog log;
+    ts::ServiceDiscovery service(u"0x0101", &log);
+    service.setServiceChangeHandler(&log);
+    Feeder feeder(service);
+
+    ts::PAT pat(0, true, 1);
+    pat.pmts[0x0100] = 0x0FFF;
+    pat.pmts[0x0101] = 0x1000;
+    feeder.feed(pat, ts::PID_PAT);
+
+    ts::SDT sdt(true, 0, true, 1, 1);
+    sdt.services[0x0101].setName(u"Svc A");
+    feeder.feed(sdt, ts::PID_SDT);
+    CPPUNIT_ASSERT_EQUAL(ts::UString(u"Svc A"), service.getName());
+
+    ts::PMT pmt(0, true, 0x0101, 0x0200);
+    pmt.streams[0x0200].stream_type = ts::ST_MPEG2_VIDEO;
+    pmt.streams[0x0201].stream_type = ts::ST_MPEG2_AUDIO;
+    feeder.feed(pmt, 0x1000);
+
+    pmt.version = 1;
+    pmt.streams.erase(0x0200);
+    pmt.streams[0x0201].descs.add(ts::ISO639LanguageDescriptor(u"fre", 0));
+    pmt.streams[0x0202].stream_type = ts::ST_AVC_VIDEO;
+    pmt.pcr_pid = 0x0202;
+    feeder.feed(pmt, 0x1000);
+
+    sdt.version = 1;
+    sdt.services[0x0101].setName(u"Svc B");
+    feeder.feed(sdt, ts::PID_SDT);
+    CPPUNIT_ASSERT_EQUAL(ts::UString(u"Svc B"), service.getName());
+
+    CPPUNIT_ASSERT(!service.nonExistentService());
+    pat.version = 1;
+    pat.pmts.erase(0x0101);
+    feeder.feed(pat, ts::PID_PAT);
+    CPPUNIT_ASSERT(service.nonExistentService());
+    CPPUNIT_ASSERT(!service.hasPMTPID());
+    CPPUNIT_ASSERT(!service.hasPMT());
+
+    const ts::UChar* const expected[] = {
+        u"added 0x1000",
+        u"+0x0200",
+        u"+0x0201",
+        u"pmt v0",
+        u"-0x0200",
+        u"*0x0201",
+        u"+0x0202",
+        u"pmt v1",
+        u"name Svc A -> Svc B",
+        u"removed",
+    };
+    const ts::UStringList ref(expected, expected + sizeof(expected) / sizeof(expected[0]));
+    utest::Out() << "ServiceDiscoveryTest::testChanges: " << ts::UString::Join(log.events) << std::endl;
+    CPPUNIT_ASSERT(ref == log.events);
+}
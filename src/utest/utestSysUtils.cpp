@@ -76,6 +76,7 @@ public:
     void testProcessMetrics();
     void testIsTerminal();
     void testSysInfo();
+    void testCPUDispatch();
 
     CPPUNIT_TEST_SUITE(SysUtilsTest);
     CPPUNIT_TEST(testCurrentProcessId);
@@ -97,6 +98,7 @@ public:
     CPPUNIT_TEST(testProcessMetrics);
     CPPUNIT_TEST(testIsTerminal);
     CPPUNIT_TEST(testSysInfo);
+    CPPUNIT_TEST(testCPUDispatch);
     CPPUNIT_TEST_SUITE_END();
 private:
     ts::NanoSecond  _nsPrecision;
@@ -673,7 +675,8 @@ void SysUtilsTest::testSysInfo()
                  << "    systemVersion = \"" << ts::SysInfo::Instance()->systemVersion() << '"' << std::endl
                  << "    systemName = \"" << ts::SysInfo::Instance()->systemName() << '"' << std::endl
                  << "    hostName = \"" << ts::SysInfo::Instance()->hostName() << '"' << std::endl
-                 << "    memoryPageSize = " << ts::SysInfo::Instance()->memoryPageSize() << std::endl;
+                 << "    memoryPageSize = " << ts::SysInfo::Instance()->memoryPageSize() << std::endl
+                 << "    cpuFeatures = \"" << ts::SysInfo::Instance()->cpuFeatures() << '"' << std::endl;
 
 #if defined(TS_WINDOWS)
     CPPUNIT_ASSERT(ts::SysInfo::Instance()->isWindows());
@@ -692,4 +695,55 @@ void SysUtilsTest::testSysInfo()
     // We can't predict the memory page size, except that it must be a multiple of 256.
     CPPUNIT_ASSERT(ts::SysInfo::Instance()->memoryPageSize() > 0);
     CPPUNIT_ASSERT(ts::SysInfo::Instance()->memoryPageSize() % 256 == 0);
+
+    // CPU features must be consistent with the architecture.
+    const ts::SysInfo* sys = ts::SysInfo::Instance();
+    CPPUNIT_ASSERT(!sys->cpuHasAVX512() || sys->cpuHasAVX2());
+    CPPUNIT_ASSERT(sys->cpuHasPMULL() == sys->cpuHasPCLMUL());
+#if defined(TS_I386) || defined(TS_X86_64)
+    CPPUNIT_ASSERT(!sys->cpuHasNEON());
+#else
+    CPPUNIT_ASSERT(!sys->cpuHasSSSE3());
+    CPPUNIT_ASSERT(!sys->cpuHasSSE42());
+    CPPUNIT_ASSERT(!sys->cpuHasAVX2());
+#endif
+
+    std::map<ts::UString, bool> features;
+    sys->getCPUFeatures(features);
+    ts::UStringList names;
+    for (std::map<ts::UString, bool>::const_iterator it = features.begin(); it != features.end(); ++it) {
+        if (it->second) {
+            names.push_back(it->first);
+        }
+    }
+    CPPUNIT_ASSERT_USTRINGS_EQUAL(ts::UString::Join(names, u" "), sys->cpuFeatures());
+}
+
+namespace {
+    int DispatchGeneric() { return 1; }
+    int DispatchFirst() { return 2; }
+    int DispatchSecond() { return 3; }
+    typedef int (*DispatchFunc)();
+}
+
+void SysUtilsTest::testCPUDispatch()
+{
+    // No variant supported: generic implementation.
+    const DispatchFunc f1 = ts::CPUDispatch<DispatchFunc>(DispatchGeneric);
+    CPPUNIT_ASSERT_EQUAL(1, f1());
+
+    // The first supported variant is selected.
+    const DispatchFunc f2 = ts::CPUDispatch<DispatchFunc>(DispatchGeneric)
+        .prefer(&ts::SysInfo::isLinux, DispatchFirst)
+        .prefer(&ts::SysInfo::isMacOS, DispatchSecond)
+        .prefer(&ts::SysInfo::isWindows, DispatchSecond);
+#if defined(TS_LINUX)
+    CPPUNIT_ASSERT_EQUAL(2, f2());
+#elif defined(TS_MAC) || defined(TS_WINDOWS)
+    CPPUNIT_ASSERT_EQUAL(3, f2());
+#endif
+
+    // Feature-based selection.
+    const DispatchFunc f3 = ts::CPUDispatch<DispatchFunc>(DispatchGeneric).prefer(&ts::SysInfo::cpuHasSSE42, DispatchFirst);
+    CPPUNIT_ASSERT_EQUAL(ts::SysInfo::Instance()->cpuHasSSE42() ? 2 : 1, f3());
 }
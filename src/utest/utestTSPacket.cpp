@@ -32,7 +32,15 @@
 //----------------------------------------------------------------------------
 
 #include "tsTSPacket.h"
+#include "tsTSPacketMetadata.h"
+#include "tsTSPacketView.h"
 #include "tsMemoryUtils.h"
+#include "tsTSFileInput.h"
+#include "tsTSFileOutput.h"
+#include "tsTSFileBlockReader.h"
+#include "tsTSFileBlockWriter.h"
+#include "tsNullReport.h"
+#include "tsSysUtils.h"
 #include "utestCppUnitTest.h"
 TSDUCK_SOURCE;
 
@@ -48,9 +56,23 @@ public:
     virtual void tearDown() override;
 
     void testPacket();
+    void testMetadata();
+    void testLocate();
+    void testLocateSyncBytes();
+    void testFileFormat();
+    void testFileBlocks();
+    void testBatch();
+    void testView();
 
     CPPUNIT_TEST_SUITE(TSPacketTest);
     CPPUNIT_TEST(testPacket);
+    CPPUNIT_TEST(testMetadata);
+    CPPUNIT_TEST(testLocate);
+    CPPUNIT_TEST(testLocateSyncBytes);
+    CPPUNIT_TEST(testFileFormat);
+    CPPUNIT_TEST(testFileBlocks);
+    CPPUNIT_TEST(testBatch);
+    CPPUNIT_TEST(testView);
     CPPUNIT_TEST_SUITE_END();
 };
 
@@ -88,3 +110,311 @@ void TSPacketTest::testPacket()
 
     CPPUNIT_ASSERT_EQUAL(size_t(7 * ts::PKT_SIZE), sizeof(packets));
 }
+
+void TSPacketTest::testMetadata()
+{
+    ts::TSPacketMetadata mdata[6];
+
+    CPPUNIT_ASSERT(!mdata[0].getDropped());
+    CPPUNIT_ASSERT(!mdata[0].getNullified());
+    CPPUNIT_ASSERT(!mdata[0].hasInputTimeStamp());
+    CPPUNIT_ASSERT(!mdata[0].hasInputSource());
+    CPPUNIT_ASSERT_EQUAL(uint32_t(0), mdata[0].labels());
+    CPPUNIT_ASSERT(!mdata[0].hasArrivalTimeStamp());
+    CPPUNIT_ASSERT(sizeof(ts::TSPacketMetadata) <= 24);
+
+    mdata[0].setInputTimeStamp(1234);
+    CPPUNIT_ASSERT(mdata[0].hasInputTimeStamp());
+    CPPUNIT_ASSERT_EQUAL(ts::NanoSecond(1234), mdata[0].getInputTimeStamp());
+
+    mdata[0].setInputSource(7);
+    CPPUNIT_ASSERT(mdata[0].hasInputSource());
+    CPPUNIT_ASSERT_EQUAL(uint16_t(7), mdata[0].getInputSource());
+
+    mdata[0].setLabel(3);
+    mdata[0].setLabel(31);
+    mdata[0].setLabel(32); // out of range, ignored
+    CPPUNIT_ASSERT(mdata[0].hasLabel(3));
+    CPPUNIT_ASSERT(mdata[0].hasLabel(31));
+    CPPUNIT_ASSERT(!mdata[0].hasLabel(4));
+    CPPUNIT_ASSERT(!mdata[0].hasLabel(32));
+    CPPUNIT_ASSERT_EQUAL(uint32_t(0x80000008), mdata[0].labels());
+    mdata[0].setLabel(3, false);
+    CPPUNIT_ASSERT(!mdata[0].hasLabel(3));
+
+    mdata[0].setNullified(true);
+    CPPUNIT_ASSERT(mdata[0].getNullified());
+    CPPUNIT_ASSERT(!mdata[0].getDropped());
+
+    mdata[0].setArrivalTimeStamp(0xC0000123);
+    CPPUNIT_ASSERT(mdata[0].hasArrivalTimeStamp());
+    CPPUNIT_ASSERT_EQUAL(uint32_t(0x00000123), mdata[0].getArrivalTimeStamp());
+    CPPUNIT_ASSERT(mdata[0].getNullified());
+
+    mdata[0].reset();
+    CPPUNIT_ASSERT(!mdata[0].hasArrivalTimeStamp());
+    CPPUNIT_ASSERT(!mdata[0].getNullified());
+    CPPUNIT_ASSERT(!mdata[0].hasInputTimeStamp());
+    CPPUNIT_ASSERT(!mdata[0].hasInputSource());
+    CPPUNIT_ASSERT_EQUAL(uint32_t(0), mdata[0].labels());
+
+    mdata[0].setDropped(true);
+    mdata[1].setDropped(true);
+    mdata[4].setDropped(true);
+    CPPUNIT_ASSERT_EQUAL(size_t(2), ts::TSPacketMetadata::CountDropped(mdata, 6));
+    CPPUNIT_ASSERT_EQUAL(size_t(0), ts::TSPacketMetadata::CountNotDropped(mdata, 6));
+    CPPUNIT_ASSERT_EQUAL(size_t(2), ts::TSPacketMetadata::CountNotDropped(mdata + 2, 4));
+    CPPUNIT_ASSERT_EQUAL(size_t(1), ts::TSPacketMetadata::CountNotDropped(mdata + 5, 1));
+
+    ts::TSPacketMetadata::Reset(mdata, 6);
+    CPPUNIT_ASSERT_EQUAL(size_t(6), ts::TSPacketMetadata::CountNotDropped(mdata, 6));
+}
+
+void TSPacketTest::testLocate()
+{
+    uint8_t buffer[12 + 3 * ts::PKT_SIZE + 10];
+    size_t start = 0;
+    size_t count = 0;
+
+    // No packet at all.
+    ::memset(buffer, 0, sizeof(buffer));
+    CPPUNIT_ASSERT(!ts::TSPacket::Locate(buffer, sizeof(buffer), start, count));
+    CPPUNIT_ASSERT_EQUAL(size_t(0), count);
+
+    // Header (RTP for instance) before 3 packets.
+    for (size_t i = 0; i < 3; ++i) {
+        buffer[12 + i * ts::PKT_SIZE] = ts::SYNC_BYTE;
+    }
+    CPPUNIT_ASSERT(ts::TSPacket::Locate(buffer, 12 + 3 * ts::PKT_SIZE, start, count));
+    CPPUNIT_ASSERT_EQUAL(size_t(12), start);
+    CPPUNIT_ASSERT_EQUAL(size_t(3), count);
+
+    // Same with a truncated packet at end.
+    CPPUNIT_ASSERT(ts::TSPacket::Locate(buffer, sizeof(buffer), start, count));
+    CPPUNIT_ASSERT_EQUAL(size_t(12), start);
+    CPPUNIT_ASSERT_EQUAL(size_t(3), count);
+
+    // Too short for one packet.
+    CPPUNIT_ASSERT(!ts::TSPacket::Locate(buffer + 12, ts::PKT_SIZE - 1, start, count));
+}
+
+void TSPacketTest::testLocateSyncBytes()
+{
+    // 10 M2TS-like packets of 192 bytes (sync byte at offset 4) after 1000 bytes of junk.
+    uint8_t buffer[1000 + 10 * 192];
+    for (size_t i = 0; i < sizeof(buffer); ++i) {
+        buffer[i] = uint8_t(i % 71);
+    }
+    for (size_t i = 0; i < 10; ++i) {
+        buffer[1000 + 4 + i * 192] = ts::SYNC_BYTE;
+    }
+
+    // Scattered sync bytes in the junk, some with the right periodicity but not enough packets.
+    buffer[3] = buffer[3 + 192] = buffer[3 + 2 * 192] = ts::SYNC_BYTE;
+    buffer[500] = ts::SYNC_BYTE;
+
+    CPPUNIT_ASSERT(ts::LocateSyncBytes(buffer, sizeof(buffer), 192, 4, 10) == buffer + 1000);
+    CPPUNIT_ASSERT(ts::LocateSyncBytes(buffer, sizeof(buffer), 192, 4, 4) == buffer + 1000);
+    CPPUNIT_ASSERT(ts::LocateSyncBytes(buffer, sizeof(buffer), 192, 0, 3) == buffer + 3);
+    CPPUNIT_ASSERT(ts::LocateSyncBytes(buffer, sizeof(buffer), 192, 4, 11) == 0);
+    CPPUNIT_ASSERT(ts::LocateSyncBytes(buffer, sizeof(buffer) - 1, 192, 4, 10) == 0);
+    CPPUNIT_ASSERT(ts::LocateSyncBytes(buffer, sizeof(buffer), 188, 0, 3) == 0);
+    CPPUNIT_ASSERT(ts::LocateSyncBytes(buffer + 1001, sizeof(buffer) - 1001, 192, 4, 9) == buffer + 1192);
+    CPPUNIT_ASSERT(ts::LocateSyncBytes(buffer, sizeof(buffer), 192, 4, 0) == buffer);
+}
+
+void TSPacketTest::testFileFormat()
+{
+    const ts::UString name(ts::TempFile(u".m2ts"));
+    ts::TSPacket pkt[3];
+    ts::TSPacketMetadata mdata[3];
+    for (size_t i = 0; i < 3; ++i) {
+        pkt[i] = ts::NullPacket;
+        pkt[i].setPID(ts::PID(100 + i));
+        mdata[i].setArrivalTimeStamp(uint32_t(1000 * i + 7));
+    }
+
+    // Write M2TS packets, the arrival time stamps come from the metadata.
+    ts::TSFileOutput out;
+    out.setPacketFormat(ts::TS_FORMAT_M2TS);
+    CPPUNIT_ASSERT(out.open(name, false, false, NULLREP));
+    CPPUNIT_ASSERT(out.write(pkt, 3, NULLREP, mdata));
+    CPPUNIT_ASSERT(out.close(NULLREP));
+    CPPUNIT_ASSERT_EQUAL(int64_t(3 * ts::PKT_M2TS_SIZE), ts::GetFileSize(name));
+
+    // Read them back, skipping the first packet.
+    ts::TSPacket in[3];
+    ts::TSPacketMetadata inmd[3];
+    ts::TSFileInput file;
+    file.setPacketFormat(ts::TS_FORMAT_M2TS);
+    CPPUNIT_ASSERT(file.open(name, 1, ts::PKT_M2TS_SIZE, NULLREP));
+    CPPUNIT_ASSERT_EQUAL(size_t(2), file.read(in, 3, NULLREP, inmd));
+    CPPUNIT_ASSERT(file.close(NULLREP));
+    CPPUNIT_ASSERT(in[0] == pkt[1]);
+    CPPUNIT_ASSERT(in[1] == pkt[2]);
+    CPPUNIT_ASSERT(inmd[0].hasArrivalTimeStamp());
+    CPPUNIT_ASSERT_EQUAL(uint32_t(1007), inmd[0].getArrivalTimeStamp());
+    CPPUNIT_ASSERT_EQUAL(uint32_t(2007), inmd[1].getArrivalTimeStamp());
+
+    // Read the same file as 204-byte packets: 576 bytes contain 2 complete packets.
+    // The second one does not start with a sync byte.
+    file.setPacketFormat(ts::TS_FORMAT_RS204);
+    CPPUNIT_ASSERT(file.open(name, 1, 0, NULLREP));
+    CPPUNIT_ASSERT_EQUAL(size_t(2), file.read(in, 3, NULLREP));
+    CPPUNIT_ASSERT(file.close(NULLREP));
+    CPPUNIT_ASSERT_EQUAL(uint8_t(0x00), in[0].b[0]);
+    CPPUNIT_ASSERT_EQUAL(ts::SYNC_BYTE, in[0].b[4]);
+
+    ts::DeleteFile(name);
+}
+
+void TSPacketTest::testFileBlocks()
+{
+    const ts::UString name(ts::TempFile(u".ts"));
+
+    // Write 100 packets through a writer with 16-packet blocks.
+    ts::TSFileOutput out;
+    ts::TSFileBlockWriter writer(out, 16);
+    CPPUNIT_ASSERT(out.open(name, false, false, NULLREP));
+    ts::TSPacket* area = writer.reserve(10, NULLREP);
+    CPPUNIT_ASSERT(area != 0);
+    for (size_t i = 0; i < 10; ++i) {
+        area[i] = ts::NullPacket;
+        area[i].setPID(ts::PID(i));
+    }
+    writer.commit(10);
+    CPPUNIT_ASSERT(writer.fill(ts::NullPacket, 50, NULLREP));
+    for (size_t i = 60; i < 100; ++i) {
+        ts::TSPacket pkt(ts::NullPacket);
+        pkt.setPID(ts::PID(i));
+        CPPUNIT_ASSERT(writer.write(pkt, NULLREP));
+    }
+    CPPUNIT_ASSERT_EQUAL(ts::PacketCounter(100), writer.getPacketCount());
+    CPPUNIT_ASSERT(writer.flush(NULLREP));
+    CPPUNIT_ASSERT(out.close(NULLREP));
+    CPPUNIT_ASSERT_EQUAL(int64_t(100 * ts::PKT_SIZE), ts::GetFileSize(name));
+
+    // Read them back through a reader with 16-packet blocks.
+    ts::TSFileInput file;
+    ts::TSFileBlockReader reader(file, 16);
+    CPPUNIT_ASSERT(file.open(name, 1, 0, NULLREP));
+    CPPUNIT_ASSERT_EQUAL(size_t(16), reader.peek(5, NULLREP));
+    CPPUNIT_ASSERT_EQUAL(ts::PID(3), reader.packets()[3].getPID());
+    reader.skip(10);
+    CPPUNIT_ASSERT_EQUAL(ts::PacketCounter(10), reader.getPacketCount());
+    CPPUNIT_ASSERT_EQUAL(size_t(6), reader.available());
+
+    // Requesting more than available moves the rest of the block and reads more.
+    CPPUNIT_ASSERT_EQUAL(size_t(16), reader.peek(12, NULLREP));
+    CPPUNIT_ASSERT_EQUAL(ts::PID_NULL, reader.packets()[0].getPID());
+
+    ts::TSPacket in[60];
+    CPPUNIT_ASSERT_EQUAL(size_t(50), reader.read(in, 50, NULLREP));
+    CPPUNIT_ASSERT_EQUAL(ts::PID_NULL, in[49].getPID());
+
+    size_t count = 0;
+    for (const ts::TSPacket* pkt = 0; (pkt = reader.next(NULLREP)) != 0; ++count) {
+        CPPUNIT_ASSERT_EQUAL(ts::PID(60 + count), pkt->getPID());
+    }
+    CPPUNIT_ASSERT_EQUAL(size_t(40), count);
+    CPPUNIT_ASSERT_EQUAL(ts::PacketCounter(100), reader.getPacketCount());
+    CPPUNIT_ASSERT_EQUAL(size_t(0), reader.peek(1, NULLREP));
+    CPPUNIT_ASSERT(file.close(NULLREP));
+
+    ts::DeleteFile(name);
+}
+
+void TSPacketTest::testBatch()
+{
+    // PID's 100, null, 100, 200, (dropped), 100, 100.
+    ts::TSPacket pkts[7];
+    const ts::PID pids[7] = {100, ts::PID_NULL, 100, 200, 300, 100, 100};
+    const uint8_t ccs[7] = {3, 0, 4, 9, 0, 6, 6};
+    for (size_t i = 0; i < 7; ++i) {
+        pkts[i] = ts::NullPacket;
+        pkts[i].setPID(pids[i]);
+        pkts[i].setCC(ccs[i]);
+    }
+    pkts[4].b[0] = 0;
+
+    ts::PID out[7];
+    ts::TSPacket::GetPIDs(pkts, 7, out);
+    for (size_t i = 0; i < 7; ++i) {
+        CPPUNIT_ASSERT_EQUAL(pids[i], out[i]);
+    }
+
+    ts::PacketCounter counters[ts::PID_MAX];
+    TS_ZERO(counters);
+    CPPUNIT_ASSERT_EQUAL(size_t(6), ts::TSPacket::CountPIDs(pkts, 7, counters));
+    CPPUNIT_ASSERT_EQUAL(ts::PacketCounter(4), counters[100]);
+    CPPUNIT_ASSERT_EQUAL(ts::PacketCounter(1), counters[200]);
+    CPPUNIT_ASSERT_EQUAL(ts::PacketCounter(0), counters[300]);
+    CPPUNIT_ASSERT_EQUAL(ts::PacketCounter(1), counters[ts::PID_NULL]);
+
+    CPPUNIT_ASSERT_EQUAL(size_t(6), ts::TSPacket::CountValidSync(pkts, 7));
+    CPPUNIT_ASSERT_EQUAL(size_t(4), ts::TSPacket::FindInvalidSync(pkts, 7));
+    CPPUNIT_ASSERT_EQUAL(size_t(1), ts::TSPacket::CountNullPackets(pkts, 7));
+    CPPUNIT_ASSERT_EQUAL(size_t(1), ts::TSPacket::FindNullPacket(pkts, 7));
+    CPPUNIT_ASSERT_EQUAL(size_t(5), ts::TSPacket::FindNullPacket(pkts + 2, 5));
+
+    // CC 4 -> 6 on PID 100 is an error, 6 -> 6 is a duplicate.
+    uint8_t cc[ts::PID_MAX];
+    ::memset(cc, 0xFF, sizeof(cc));
+    CPPUNIT_ASSERT_EQUAL(size_t(5), ts::TSPacket::CheckContinuity(pkts, 7, cc));
+    CPPUNIT_ASSERT_EQUAL(uint8_t(4), cc[100]);
+    CPPUNIT_ASSERT_EQUAL(uint8_t(9), cc[200]);
+    CPPUNIT_ASSERT_EQUAL(uint8_t(0xFF), cc[300]);
+    cc[100] = 6;
+    CPPUNIT_ASSERT_EQUAL(size_t(1), ts::TSPacket::CheckContinuity(pkts + 6, 1, cc));
+}
+
+void TSPacketTest::testView()
+{
+    // Same packets as testBatch(), with a padded stride of 256 bytes.
+    const size_t stride = 256;
+    ts::TSPacket dense[7];
+    const ts::PID pids[7] = {100, ts::PID_NULL, 100, 200, 300, 100, 100};
+    const uint8_t ccs[7] = {3, 0, 4, 9, 0, 6, 6};
+    for (size_t i = 0; i < 7; ++i) {
+        dense[i] = ts::NullPacket;
+        dense[i].setPID(pids[i]);
+        dense[i].setCC(ccs[i]);
+    }
+    dense[4].b[0] = 0;
+
+    ts::ByteBlock area(7 * stride, 0xFF);
+    const ts::TSPacketView pkts(area.data(), stride);
+    CPPUNIT_ASSERT(!pkts.isDense());
+    CPPUNIT_ASSERT(ts::TSPacketView(dense).isDense());
+    CPPUNIT_ASSERT_EQUAL(stride, pkts.stride());
+
+    pkts.copyFrom(dense, 7);
+    CPPUNIT_ASSERT(&pkts[3] == reinterpret_cast<ts::TSPacket*>(area.data() + 3 * stride));
+    CPPUNIT_ASSERT(&(pkts + 2)[1] == &pkts[3]);
+    CPPUNIT_ASSERT_EQUAL(ts::PID(200), pkts[3].getPID());
+    CPPUNIT_ASSERT_EQUAL(uint8_t(0xFF), area[ts::PKT_SIZE]);
+
+    ts::PID out[7];
+    ts::TSPacket::GetPIDs(pkts, 7, out);
+    for (size_t i = 0; i < 7; ++i) {
+        CPPUNIT_ASSERT_EQUAL(pids[i], out[i]);
+    }
+
+    ts::PacketCounter counters[ts::PID_MAX];
+    TS_ZERO(counters);
+    CPPUNIT_ASSERT_EQUAL(size_t(6), ts::TSPacket::CountPIDs(pkts, 7, counters));
+    CPPUNIT_ASSERT_EQUAL(ts::PacketCounter(4), counters[100]);
+    CPPUNIT_ASSERT_EQUAL(size_t(6), ts::TSPacket::CountValidSync(pkts, 7));
+    CPPUNIT_ASSERT_EQUAL(size_t(4), ts::TSPacket::FindInvalidSync(pkts, 7));
+    CPPUNIT_ASSERT_EQUAL(size_t(1), ts::TSPacket::CountNullPackets(pkts, 7));
+    CPPUNIT_ASSERT_EQUAL(size_t(5), ts::TSPacket::FindNullPacket(pkts + 2, 5));
+
+    uint8_t cc[ts::PID_MAX];
+    ::memset(cc, 0xFF, sizeof(cc));
+    CPPUNIT_ASSERT_EQUAL(size_t(5), ts::TSPacket::CheckContinuity(pkts, 7, cc));
+
+    // Back to a dense array.
+    ts::TSPacket copy[7];
+    pkts.copyTo(copy, 7);
+    CPPUNIT_ASSERT(::memcmp(copy, dense, sizeof(dense)) == 0);
+}
@@ -47,9 +47,11 @@ public:
     virtual void tearDown() override;
 
     void testRegistrations();
+    void testIds();
 
     CPPUNIT_TEST_SUITE(TablesFactoryTest);
     CPPUNIT_TEST(testRegistrations);
+    CPPUNIT_TEST(testIds);
     CPPUNIT_TEST_SUITE_END();
 };
 
@@ -92,3 +94,36 @@ void TablesFactoryTest::testRegistrations()
     CPPUNIT_ASSERT(!names.empty());
     CPPUNIT_ASSERT(ts::UString(u"ca_descriptor").containSimilar(names));
 }
+
+void TablesFactoryTest::testIds()
+{
+    const ts::TablesFactory* fact = ts::TablesFactory::Instance();
+
+    // Tables, directly indexed by table id.
+    CPPUNIT_ASSERT(fact->getTableFactory(ts::TID_PAT) != 0);
+    CPPUNIT_ASSERT(fact->getSectionDisplay(ts::TID_PAT) != 0);
+    CPPUNIT_ASSERT(fact->getTableFactory(ts::TID_NULL) == 0);
+
+    std::vector<ts::TID> tids;
+    fact->getRegisteredTableIds(tids);
+    CPPUNIT_ASSERT(!tids.empty());
+    for (size_t i = 0; i < tids.size(); ++i) {
+        CPPUNIT_ASSERT(i == 0 || tids[i - 1] < tids[i]);
+        CPPUNIT_ASSERT(fact->getTableFactory(tids[i]) != 0);
+    }
+
+    // Standard descriptors, directly indexed, and private descriptors, in a map.
+    CPPUNIT_ASSERT(fact->getDescriptorFactory(ts::EDID(ts::DID_CA)) != 0);
+    CPPUNIT_ASSERT(fact->getDescriptorFactory(ts::EDID(ts::DID_LOGICAL_CHANNEL_NUM, ts::PDS_EICTA)) != 0);
+    CPPUNIT_ASSERT(fact->getDescriptorDisplay(ts::EDID(ts::DID_LOGICAL_CHANNEL_NUM, ts::PDS_EICTA)) != 0);
+    CPPUNIT_ASSERT(fact->getDescriptorFactory(ts::EDID(ts::DID_LOGICAL_CHANNEL_NUM)) == 0);
+    CPPUNIT_ASSERT(fact->getDescriptorFactory(ts::EDID()) == 0);
+
+    std::vector<ts::EDID> edids;
+    fact->getRegisteredDescriptorIds(edids);
+    CPPUNIT_ASSERT(!edids.empty());
+    for (size_t i = 0; i < edids.size(); ++i) {
+        CPPUNIT_ASSERT(i == 0 || edids[i - 1] < edids[i]);
+        CPPUNIT_ASSERT(fact->getDescriptorFactory(edids[i]) != 0);
+    }
+}
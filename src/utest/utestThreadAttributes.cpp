@@ -44,6 +44,7 @@
 //----------------------------------------------------------------------------
 
 #include "tsThreadAttributes.h"
+#include "tsThread.h"
 #include "utestCppUnitTest.h"
 TSDUCK_SOURCE;
 
@@ -61,11 +62,15 @@ public:
     void testStackSize();
     void testDeleteWhenTerminated();
     void testPriority();
+    void testCPUAffinity();
+    void testSchedulingPolicy();
 
     CPPUNIT_TEST_SUITE (ThreadAttributesTest);
     CPPUNIT_TEST (testStackSize);
     CPPUNIT_TEST (testDeleteWhenTerminated);
     CPPUNIT_TEST (testPriority);
+    CPPUNIT_TEST (testCPUAffinity);
+    CPPUNIT_TEST (testSchedulingPolicy);
     CPPUNIT_TEST_SUITE_END ();
 };
 
@@ -134,3 +139,53 @@ void ThreadAttributesTest::testPriority()
     attr.setPriority (ts::ThreadAttributes::GetNormalPriority());
     CPPUNIT_ASSERT(attr.getPriority() == ts::ThreadAttributes::GetNormalPriority());
 }
+
+void ThreadAttributesTest::testCPUAffinity()
+{
+    ts::ThreadAttributes attr;
+    CPPUNIT_ASSERT(attr.getCPUAffinity().empty()); // default value
+
+    ts::CPUSet cpus;
+    cpus.insert(0);
+    cpus.insert(3);
+    CPPUNIT_ASSERT(attr.setCPUAffinity(cpus).getCPUAffinity() == cpus);
+    CPPUNIT_ASSERT(attr.setCPUAffinity(ts::CPUSet()).getCPUAffinity().empty());
+}
+
+namespace {
+    class SchedThread: public ts::Thread
+    {
+    public:
+        SchedThread(const ts::ThreadAttributes& attr) : ts::Thread(attr) {}
+        virtual ~SchedThread() override {waitForTermination();}
+        virtual void main() override {}
+    };
+}
+
+void ThreadAttributesTest::testSchedulingPolicy()
+{
+    ts::ThreadAttributes attr;
+    CPPUNIT_ASSERT(attr.getSchedulingPolicy() == ts::ThreadAttributes::SCHEDULING_DEFAULT); // default value
+    CPPUNIT_ASSERT(attr.getSchedulingPriority() == 0);
+
+    attr.setSchedulingPolicy(ts::ThreadAttributes::SCHEDULING_FIFO, 80);
+    CPPUNIT_ASSERT(attr.getSchedulingPolicy() == ts::ThreadAttributes::SCHEDULING_FIFO);
+    CPPUNIT_ASSERT(attr.getSchedulingPriority() == 80);
+
+    // The time-sharing policy is always allowed.
+    {
+        SchedThread thread(ts::ThreadAttributes().setSchedulingPolicy(ts::ThreadAttributes::SCHEDULING_OTHER));
+        CPPUNIT_ASSERT(thread.start());
+        thread.getAttributes(attr);
+        CPPUNIT_ASSERT(attr.getSchedulingPolicy() == ts::ThreadAttributes::SCHEDULING_OTHER);
+    }
+
+    // A real-time policy requires privileges. Without them, the thread is started anyway.
+    {
+        SchedThread thread(ts::ThreadAttributes().setSchedulingPolicy(ts::ThreadAttributes::SCHEDULING_RR, 10));
+        CPPUNIT_ASSERT(thread.start());
+        thread.getAttributes(attr);
+        utest::Out() << "ThreadAttributesTest: round robin policy " << (attr.getSchedulingPolicy() == ts::ThreadAttributes::SCHEDULING_RR ? "applied" : "not allowed") << std::endl;
+        CPPUNIT_ASSERT(attr.getSchedulingPolicy() == ts::ThreadAttributes::SCHEDULING_RR || attr.getSchedulingPolicy() == ts::ThreadAttributes::SCHEDULING_DEFAULT);
+    }
+}
@@ -0,0 +1,159 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  CppUnit test suite for class ts::ThreadPool
+//
+//----------------------------------------------------------------------------
+
+#include "tsThreadPool.h"
+#include "tsSysUtils.h"
+#include "utestCppUnitTest.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// The test fixture
+//----------------------------------------------------------------------------
+
+class ThreadPoolTest: public CppUnit::TestFixture
+{
+public:
+    virtual void setUp() override;
+    virtual void tearDown() override;
+
+    void testSubmit();
+    void testParallelFor();
+    void testNested();
+    void testException();
+    void testCancel();
+
+    CPPUNIT_TEST_SUITE (ThreadPoolTest);
+    CPPUNIT_TEST (testSubmit);
+    CPPUNIT_TEST (testParallelFor);
+    CPPUNIT_TEST (testNested);
+    CPPUNIT_TEST (testException);
+    CPPUNIT_TEST (testCancel);
+    CPPUNIT_TEST_SUITE_END ();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (ThreadPoolTest);
+
+
+//----------------------------------------------------------------------------
+// Initialization.
+//----------------------------------------------------------------------------
+
+// Test suite initialization method.
+void ThreadPoolTest::setUp()
+{
+}
+
+// Test suite cleanup method.
+void ThreadPoolTest::tearDown()
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Test cases
+//----------------------------------------------------------------------------
+
+void ThreadPoolTest::testSubmit()
+{
+    ts::ThreadPool pool(4);
+    CPPUNIT_ASSERT(pool.threadCount() == 4);
+    CPPUNIT_ASSERT(!pool.inWorkerThread());
+
+    std::vector<std::future<int>> results;
+    for (int i = 0; i < 1000; ++i) {
+        results.push_back(pool.submit([i]() { return 2 * i; }));
+    }
+    int sum = 0;
+    for (size_t i = 0; i < results.size(); ++i) {
+        sum += results[i].get();
+    }
+    CPPUNIT_ASSERT(sum == 999000);
+
+    std::future<bool> inside(pool.submit([&pool]() { return pool.inWorkerThread(); }));
+    CPPUNIT_ASSERT(inside.get());
+}
+
+void ThreadPoolTest::testParallelFor()
+{
+    ts::ThreadPool pool(3);
+    std::vector<int> values(10000, 0);
+    CPPUNIT_ASSERT(pool.parallelFor(0, values.size(), [&values](size_t i) { values[i] = int(i); }));
+    for (size_t i = 0; i < values.size(); ++i) {
+        CPPUNIT_ASSERT(values[i] == int(i));
+    }
+    CPPUNIT_ASSERT(pool.parallelFor(10, 10, [](size_t) {}));
+}
+
+void ThreadPoolTest::testNested()
+{
+    // Nested loops from worker threads must not deadlock.
+    ts::ThreadPool pool(2);
+    std::atomic<int> count(0);
+    CPPUNIT_ASSERT(pool.parallelFor(0, 20, [&pool, &count](size_t) {
+        pool.parallelFor(0, 100, [&count](size_t) { count++; }, 10);
+    }, 1));
+    CPPUNIT_ASSERT(count == 2000);
+}
+
+void ThreadPoolTest::testException()
+{
+    ts::ThreadPool pool(2);
+    CPPUNIT_ASSERT_THROW(pool.parallelFor(0, 100, [](size_t i) { if (i == 50) throw std::runtime_error("test"); }), std::runtime_error);
+
+    std::future<void> result(pool.submit([]() { throw std::runtime_error("test"); }));
+    CPPUNIT_ASSERT_THROW(result.get(), std::runtime_error);
+}
+
+void ThreadPoolTest::testCancel()
+{
+    ts::ThreadPool pool(1);
+    std::future<void> last;
+    for (int i = 0; i < 100; ++i) {
+        last = pool.submit([]() { ts::SleepThread(20); });
+    }
+    pool.cancel();
+    CPPUNIT_ASSERT(pool.pendingTasks() == 0);
+    CPPUNIT_ASSERT_THROW(last.get(), std::future_error);
+    CPPUNIT_ASSERT(!pool.parallelFor(0, 10, [](size_t) {}));
+    pool.terminate();
+
+    // Without cancellation, all pending tasks are executed on termination.
+    ts::ThreadPool pool2(2);
+    std::atomic<int> count(0);
+    for (int i = 0; i < 100; ++i) {
+        pool2.submit([&count]() { count++; });
+    }
+    pool2.terminate();
+    CPPUNIT_ASSERT(count == 100);
+}
@@ -32,6 +32,8 @@
 //----------------------------------------------------------------------------
 
 #include "tsTime.h"
+#include "tsCoarseClock.h"
+#include "tsSysUtils.h"
 #include "utestCppUnitTest.h"
 TSDUCK_SOURCE;
 
@@ -54,6 +56,7 @@ public:
     void testFields();
     void testFieldsValid();
     void testDecode();
+    void testCoarseClock();
 
     CPPUNIT_TEST_SUITE(TimeTest);
     CPPUNIT_TEST(testTime);
@@ -64,6 +67,7 @@ public:
     CPPUNIT_TEST(testFields);
     CPPUNIT_TEST(testFieldsValid);
     CPPUNIT_TEST(testDecode);
+    CPPUNIT_TEST(testCoarseClock);
     CPPUNIT_TEST_SUITE_END();
 };
 
@@ -250,3 +254,33 @@ void TimeTest::testDecode()
     CPPUNIT_ASSERT_EQUAL(0, f.second);
     CPPUNIT_ASSERT_EQUAL(2, f.millisecond);
 }
+
+void TimeTest::testCoarseClock()
+{
+    // Resynchronize every 50 ms to exercise both paths.
+    ts::CoarseClock clock(50);
+
+    for (int i = 0; i < 5; ++i) {
+        const ts::Time before(ts::Time::CurrentUTC());
+        const ts::Time coarse(clock.utc());
+        const ts::Time after(ts::Time::CurrentUTC());
+        utest::Out() << "TimeTest: coarse UTC: " << coarse << ", system UTC: " << after << std::endl;
+
+        // The coarse clock has a resolution of a few milliseconds (or tens of milliseconds on Windows).
+        CPPUNIT_ASSERT(coarse >= before - 100);
+        CPPUNIT_ASSERT(coarse <= after + 100);
+
+        const ts::Time local(clock.localTime());
+        const ts::Time sys_local(ts::Time::CurrentLocalTime());
+        CPPUNIT_ASSERT(local >= sys_local - 200);
+        CPPUNIT_ASSERT(local <= sys_local + 100);
+
+        ts::SleepThread(30);
+    }
+
+    // The coarse monotonic clock never goes backward.
+    const ts::NanoSecond n1 = ts::CoarseClock::CoarseNanoSeconds();
+    ts::SleepThread(20);
+    const ts::NanoSecond n2 = ts::CoarseClock::CoarseNanoSeconds();
+    CPPUNIT_ASSERT(n2 > n1);
+}
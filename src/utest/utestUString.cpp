@@ -91,7 +91,9 @@ public:
     void testArgMixIn();
     void testArgMixOut();
     void testFormat();
+    void testFormatBuffer();
     void testScan();
+    void testStreamOutput();
 
     CPPUNIT_TEST_SUITE(UStringTest);
     CPPUNIT_TEST(testIsSpace);
@@ -135,7 +137,9 @@ public:
     CPPUNIT_TEST(testArgMixIn);
     CPPUNIT_TEST(testArgMixOut);
     CPPUNIT_TEST(testFormat);
+    CPPUNIT_TEST(testFormatBuffer);
     CPPUNIT_TEST(testScan);
+    CPPUNIT_TEST(testStreamOutput);
     CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -298,6 +302,13 @@ void UStringTest::testUTF()
     CPPUNIT_ASSERT_USTRINGS_EQUAL(s1, s2);
     CPPUNIT_ASSERT_USTRINGS_EQUAL(s1, s3);
     CPPUNIT_ASSERT_USTRINGS_EQUAL(s1, s4);
+
+    // Round trip of strings with only 3-byte UTF-8 sequences and long runs of ASCII.
+    const ts::UString cjk(u"\u4E2D\u6587\u5B57\u5E55\u8282\u76EE\u4FE1\u606F");
+    CPPUNIT_ASSERT_EQUAL(size_t(24), cjk.toUTF8().size());
+    CPPUNIT_ASSERT_USTRINGS_EQUAL(cjk, ts::UString::FromUTF8(cjk.toUTF8()));
+    const ts::UString mixed(u"The quick brown fox \u00E9\u20AC jumps over the lazy dog \u4E2D, 0123456789");
+    CPPUNIT_ASSERT_USTRINGS_EQUAL(mixed, ts::UString::FromUTF8(mixed.toUTF8()));
 }
 
 void UStringTest::testDiacritical()
@@ -1586,6 +1597,29 @@ void UStringTest::testFormat()
     CPPUNIT_ASSERT_USTRINGS_EQUAL(u"|abcdefghijklmnop|", ts::UString::Format(u"|%-*s|", {8, u"abcdefghijklmnop"}));
 }
 
+void UStringTest::testFormatBuffer()
+{
+    ts::UString str;
+    str.format(u"abc %d", {12});
+    CPPUNIT_ASSERT_USTRINGS_EQUAL(u"abc 12", str);
+
+    // The previous content is replaced, the memory is reused.
+    str.reserve(100);
+    const ts::UChar* const data = str.data();
+    str.format(u"%'d|%+d|%-6d|%06d|%'d", {-1234567, 12, -5, -5, TS_CONST64(-9223372036854775807) - 1});
+    CPPUNIT_ASSERT_USTRINGS_EQUAL(u"-1,234,567|+12|-5    |0000-5|-9,223,372,036,854,775,808", str);
+    CPPUNIT_ASSERT(str.data() == data);
+
+    // Same results as the generic formatting.
+    str.format(u"%X|%010X|%x|%'X|%4X", {int32_t(-2), int32_t(-1), uint8_t(0xAB), TS_UCONST64(0x0123456789ABCDEF), int16_t(0x1234)});
+    CPPUNIT_ASSERT_USTRINGS_EQUAL(u"FFFFFFFE|00FFFFFFFF|ab|0123,4567,89AB,CDEF|1234", str);
+    CPPUNIT_ASSERT(str.data() == data);
+
+    const ts::UString ref({u'a', ts::LATIN_SMALL_LETTER_E_WITH_ACUTE, u'b', u'|', u'x', u'y'});
+    str.format(u"%s|%s", {"a\xC3\xA9b", std::string("xy")});
+    CPPUNIT_ASSERT_USTRINGS_EQUAL(ref, str);
+}
+
 void UStringTest::testArgMixOut()
 {
     enum E1 : uint16_t {E10 = 5, E11, E12, E13};
@@ -1810,3 +1844,29 @@ void UStringTest::testScan()
     CPPUNIT_ASSERT_EQUAL(uint8_t(73), u8);
     CPPUNIT_ASSERT_EQUAL(int16_t(-3457), i16);
 }
+
+void UStringTest::testStreamOutput()
+{
+    // Non-ASCII characters, 2 and 3 bytes in UTF-8, and a surrogate pair.
+    const ts::UString str(u"a\u00E9b\u20ACc\U0001F600d");
+    std::ostringstream out1;
+    out1 << str;
+    CPPUNIT_ASSERT(out1.str() == str.toUTF8());
+
+    std::ostringstream out2;
+    out2 << ts::UChar(0x00E9) << ts::UChar(0x20AC);
+    CPPUNIT_ASSERT(out2.str() == ts::UString(u"\u00E9\u20AC").toUTF8());
+
+    std::ostringstream out3;
+    out3 << str.c_str();
+    CPPUNIT_ASSERT(out3.str() == str.toUTF8());
+
+    // Longer than the internal conversion buffer.
+    ts::UString large;
+    for (size_t i = 0; i < 1000; ++i) {
+        large.append(str);
+    }
+    std::ostringstream out4;
+    out4 << large;
+    CPPUNIT_ASSERT(out4.str() == large.toUTF8());
+}
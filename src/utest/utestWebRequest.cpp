@@ -61,6 +61,7 @@ public:
     void testNoRedirection();
     void testNonExistentHost();
     void testInvalidURL();
+    void testApplication();
 
     CPPUNIT_TEST_SUITE(WebRequestTest);
     CPPUNIT_TEST(testGitHub);
@@ -69,6 +70,7 @@ public:
     CPPUNIT_TEST(testNoRedirection);
     CPPUNIT_TEST(testNonExistentHost);
     CPPUNIT_TEST(testInvalidURL);
+    CPPUNIT_TEST(testApplication);
     CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -273,3 +275,64 @@ void WebRequestTest::testInvalidURL()
 
     utest::Out() << "WebRequestTest::testInvalidURL: " << rep.getMessages() << std::endl;
 }
+
+namespace {
+    // A Web request handler which keeps the data, possibly interrupting the transfer.
+    class WebHandler: public ts::WebRequestHandlerInterface
+    {
+    public:
+        bool          started;
+        size_t        chunks;
+        size_t        maxChunks;
+        ts::ByteBlock data;
+
+        WebHandler(size_t max) : started(false), chunks(0), maxChunks(max), data() {}
+
+        virtual bool handleWebStart(const ts::WebRequest& request, size_t size) override
+        {
+            CPPUNIT_ASSERT(!started);
+            CPPUNIT_ASSERT_EQUAL(200, request.httpStatus());
+            started = true;
+            return true;
+        }
+
+        virtual bool handleWebData(const ts::WebRequest& request, const void* addr, size_t size) override
+        {
+            CPPUNIT_ASSERT(started);
+            data.append(addr, size);
+            return maxChunks == 0 || ++chunks < maxChunks;
+        }
+    };
+}
+
+void WebRequestTest::testApplication()
+{
+    const ts::UString url(u"https://raw.githubusercontent.com/tsduck/tsduck/master/README.md");
+    ts::WebRequest request(report());
+    request.setURL(url);
+
+    // Reference content.
+    ts::ByteBlock ref;
+    CPPUNIT_ASSERT(request.downloadBinaryContent(ref));
+    CPPUNIT_ASSERT(!ref.empty());
+
+    // Same content, passed to the application.
+    WebHandler all(0);
+    CPPUNIT_ASSERT(request.downloadToApplication(&all));
+    CPPUNIT_ASSERT(all.started);
+    CPPUNIT_ASSERT(all.data == ref);
+    CPPUNIT_ASSERT_EQUAL(ref.size(), request.contentSize());
+
+    // Interrupted after the first chunk, not an error.
+    ts::ReportBuffer<> rep;
+    ts::WebRequest request2(rep);
+    request2.setURL(url);
+    WebHandler first(1);
+    CPPUNIT_ASSERT(request2.downloadToApplication(&first));
+    CPPUNIT_ASSERT(first.started);
+    CPPUNIT_ASSERT(!first.data.empty());
+    CPPUNIT_ASSERT(first.data.size() <= ref.size());
+    CPPUNIT_ASSERT(rep.emptyMessages());
+
+    utest::Out() << "WebRequestTest::testApplication: " << ref.size() << " bytes, first chunk: " << first.data.size() << " bytes" << std::endl;
+}
@@ -33,6 +33,7 @@
 
 #include "tsxmlDocument.h"
 #include "tsxmlElement.h"
+#include "tsxmlElementHandlerInterface.h"
 #include "tsTextFormatter.h"
 #include "tsCerrReport.h"
 #include "tsReportBuffer.h"
@@ -59,6 +60,7 @@ public:
     void testValidation();
     void testCreation();
     void testKeepOpen();
+    void testElementHandler();
 
     CPPUNIT_TEST_SUITE(XMLTest);
     CPPUNIT_TEST(testDocument);
@@ -67,6 +69,7 @@ public:
     CPPUNIT_TEST(testValidation);
     CPPUNIT_TEST(testCreation);
     CPPUNIT_TEST(testKeepOpen);
+    CPPUNIT_TEST(testElementHandler);
     CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -371,3 +374,70 @@ void XMLTest::testKeepOpen()
         u"</node2>\n",
         out.toString());
 }
+
+namespace {
+    class ElementCollector: public ts::xml::ElementHandlerInterface
+    {
+    public:
+        ts::UStringVector names;
+        ts::UStringVector texts;
+        std::vector<size_t> lines;
+        virtual bool handleElement(const ts::xml::Element* element) override
+        {
+            names.push_back(element->name());
+            texts.push_back(element->text());
+            lines.push_back(element->lineNumber());
+            return element->name() != u"bad";
+        }
+    };
+}
+
+void XMLTest::testElementHandler()
+{
+    static const char document[] =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<root attr1=\"val1\">\n"
+        "  <node1 a1=\"v1\">Text in node1</node1>\n"
+        "  <!-- comment -->\n"
+        "  <node2>\n"
+        "    <sub>Text in sub</sub>\n"
+        "  </node2>\n"
+        "  <node3/>\n"
+        "</root>\n";
+
+    CPPUNIT_ASSERT(ts::ByteBlock(document, sizeof(document) - 1).saveToFile(_tempFileName, &report()));
+
+    // Progressive load from a file, the children of the root are passed to the handler.
+    ElementCollector collector;
+    ts::xml::Document doc(report());
+    doc.setElementHandler(&collector);
+    CPPUNIT_ASSERT(doc.elementHandler() == &collector);
+    CPPUNIT_ASSERT(doc.load(_tempFileName, false));
+
+    CPPUNIT_ASSERT_EQUAL(size_t(3), collector.names.size());
+    CPPUNIT_ASSERT_USTRINGS_EQUAL(u"node1", collector.names[0]);
+    CPPUNIT_ASSERT_USTRINGS_EQUAL(u"node2", collector.names[1]);
+    CPPUNIT_ASSERT_USTRINGS_EQUAL(u"node3", collector.names[2]);
+    CPPUNIT_ASSERT_USTRINGS_EQUAL(u"Text in node1", collector.texts[0]);
+    CPPUNIT_ASSERT_EQUAL(size_t(3), collector.lines[0]);
+    CPPUNIT_ASSERT_EQUAL(size_t(5), collector.lines[1]);
+    CPPUNIT_ASSERT_EQUAL(size_t(8), collector.lines[2]);
+
+    // The root remains, without children.
+    const ts::xml::Element* root = doc.rootElement();
+    CPPUNIT_ASSERT(root != 0);
+    CPPUNIT_ASSERT_USTRINGS_EQUAL(u"root", root->name());
+    CPPUNIT_ASSERT_USTRINGS_EQUAL(u"val1", root->attribute(u"attr1").value());
+    CPPUNIT_ASSERT(!root->hasChildren());
+
+    // Same thing from a stream, the handler reports an error.
+    std::istringstream strm(std::string(document).replace(std::string(document).find("node3"), 5, "bad"));
+    ElementCollector collector2;
+    ts::xml::Document doc2(report());
+    doc2.setElementHandler(&collector2);
+    CPPUNIT_ASSERT(!doc2.load(strm));
+    CPPUNIT_ASSERT_EQUAL(size_t(3), collector2.names.size());
+    CPPUNIT_ASSERT_USTRINGS_EQUAL(u"bad", collector2.names[2]);
+
+    CPPUNIT_ASSERT(ts::DeleteFile(_tempFileName) == ts::SYS_SUCCESS);
+}